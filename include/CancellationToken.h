@@ -0,0 +1,110 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+
+// Cooperative cancellation for node executions and the backend calls they make.
+//
+// The engine creates one token per run and cancels it when the run is stopped or
+// replaced. While a node executes, the run's token is the thread's current() token.
+// Blocking work polls isCancelled(): backends abort HTTP transfers from libcurl's
+// progress callback and process nodes kill their child. Work that moves to another
+// thread (QtConcurrent::run, future continuations) must capture current() and
+// install it there with a Scope. A default-constructed token is never cancelled.
+//
+// The token also carries when its run is due, so queues shared by several runs
+// (the engine's ready queue, provider rate limits) can serve the most urgent first.
+// Times are monotonic milliseconds, as QDeadlineTimer::deadline() reports them.
+class CancellationToken {
+public:
+    static constexpr std::int64_t kNoDeadline = std::numeric_limits<std::int64_t>::max();
+
+    CancellationToken() = default;
+
+    // slackMs is how long work of the run may wait once queued when it has no deadline
+    static CancellationToken create(std::int64_t deadline = kNoDeadline, std::int64_t slackMs = 0)
+    {
+        CancellationToken token;
+        token.m_state = std::make_shared<State>();
+        token.m_state->deadline = deadline;
+        token.m_state->slackMs = slackMs;
+        return token;
+    }
+
+    bool isCancelled() const { return m_state && m_state->cancelled.load(std::memory_order_acquire); }
+    void cancel() const
+    {
+        if (m_state) m_state->cancelled.store(true, std::memory_order_release);
+    }
+
+    std::int64_t deadline() const { return m_state ? m_state->deadline : kNoDeadline; }
+
+    // When work queued at queuedAt should be served: the run's deadline, or queuedAt
+    // plus the slack, so undated work ages instead of starving
+    std::int64_t dueBy(std::int64_t queuedAt) const
+    {
+        if (m_state && m_state->deadline != kNoDeadline) return m_state->deadline;
+        const std::int64_t slack = m_state ? m_state->slackMs : 0;
+        return queuedAt > kNoDeadline - slack ? kNoDeadline : queuedAt + slack;
+    }
+
+    // The token of the run the calling thread is executing a node for
+    static CancellationToken current() { return slot(); }
+
+    // Makes a token current for the lifetime of the scope
+    class Scope {
+    public:
+        explicit Scope(CancellationToken token)
+            : m_previous(std::exchange(slot(), std::move(token)))
+        {
+        }
+        ~Scope() { slot() = std::move(m_previous); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        CancellationToken m_previous;
+    };
+
+private:
+    static CancellationToken& slot()
+    {
+        thread_local CancellationToken token;
+        return token;
+    }
+
+    struct State {
+        std::atomic<bool> cancelled {false};
+        std::int64_t deadline {kNoDeadline};
+        std::int64_t slackMs {0};
+    };
+
+    std::shared_ptr<State> m_state;
+};
@@ -0,0 +1,68 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QThreadPool>
+
+#include <utility>
+
+// Lends the run's Cpu pool to nodes that split their own work across threads.
+//
+// A node of any resource class may fan CPU-bound work out, e.g. RAG Query's exact
+// scan. Submitting that work to the engine's Cpu pool keeps it inside the run's
+// "cpu" budget, so it does not oversubscribe the host. While a node executes, that
+// pool is the thread's current() pool. Outside the engine current() is null, and
+// callers fall back to QThreadPool::globalInstance(). Like CancellationToken, work
+// that moves to another thread must capture current() and install it with a Scope.
+// The calling thread may itself hold one of the pool's threads. Callers must
+// therefore process shards themselves and treat pool tasks as optional helpers,
+// never block waiting for one to start.
+class CpuWorkerPool {
+public:
+    // The pool of the run the calling thread is executing a node for, or null
+    static QThreadPool* current() { return slot(); }
+
+    // Makes a pool current for the lifetime of the scope
+    class Scope {
+    public:
+        explicit Scope(QThreadPool* pool)
+            : m_previous(std::exchange(slot(), pool))
+        {
+        }
+        ~Scope() { slot() = m_previous; }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        QThreadPool* m_previous;
+    };
+
+private:
+    static QThreadPool*& slot()
+    {
+        thread_local QThreadPool* pool = nullptr;
+        return pool;
+    }
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <QList>
 #include <QUuid>
 #include <QString>
 #include <QVariantMap>
@@ -30,3 +31,7 @@ struct ExecutionToken
     // If true, bypasses the ExecutionEngine's deduplication logic.
     bool forceExecution = false;
 };
+
+// Tokens a node receives or emits. Contiguous and implicitly shared, so handing a
+// list to a task, a lambda or the data lake copies a pointer, not every token.
+using TokenList = QList<ExecutionToken>;
@@ -25,8 +25,10 @@
 #pragma once
 
 #include "CommonDataTypes.h"
+#include <QHash>
 #include <QString>
 #include <QVariant>
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <map>
@@ -66,6 +68,66 @@ public:
     virtual QString getTempDir() const = 0;
 };
 
+/**
+ * @brief Budgets for one script execution; zero means unlimited.
+ */
+struct ScriptLimits {
+    // Wall-clock time the script may run before it is interrupted
+    int timeoutMs = 0;
+    // Heap the script may allocate on top of what the engine holds already
+    int memoryLimitMb = 0;
+};
+
+/**
+ * @brief Where a profiled execution spent its time.
+ *
+ * Each stack is its frames joined by ';', outermost first, and maps to the
+ * microseconds spent with it on top.
+ */
+struct ScriptProfile {
+    QHash<QString, qint64> stacks;
+
+    bool isEmpty() const { return stacks.isEmpty(); }
+    void add(const QString& stack, qint64 micros) { stacks[stack] += micros; }
+
+    void merge(const ScriptProfile& other)
+    {
+        for (auto it = other.stacks.cbegin(); it != other.stacks.cend(); ++it) {
+            add(it.key(), it.value());
+        }
+    }
+
+    qint64 totalMicros() const
+    {
+        qint64 total = 0;
+        for (const qint64 micros : stacks) {
+            total += micros;
+        }
+        return total;
+    }
+
+    /**
+     * @brief One "stack micros" line per stack, the folded format flamegraph.pl
+     * and speedscope read; heaviest stacks first.
+     */
+    QString folded() const
+    {
+        QList<QPair<QString, qint64>> entries;
+        entries.reserve(stacks.size());
+        for (auto it = stacks.cbegin(); it != stacks.cend(); ++it) {
+            entries.append({it.key(), it.value()});
+        }
+        std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+            return a.second != b.second ? a.second > b.second : a.first < b.first;
+        });
+        QString text;
+        for (const auto& entry : entries) {
+            text += entry.first + QLatin1Char(' ') + QString::number(entry.second) + QLatin1Char('\n');
+        }
+        return text;
+    }
+};
+
 /**
  * @brief Interface for a script engine implementation (e.g., QuickJS, Python).
  */
@@ -83,6 +145,29 @@ public:
      * @brief Returns a unique identifier for this engine (e.g., "quickjs", "python").
      */
     virtual QString getEngineId() const = 0;
+
+    /**
+     * @brief Prepares a script ahead of its first run, e.g. when a graph is loaded.
+     * Engines with a compile cache fill it here; the default does nothing.
+     */
+    virtual void prewarm(const QString& script) { Q_UNUSED(script); }
+
+    /**
+     * @brief Sets the budgets later execute() calls run under.
+     * Engines that cannot enforce them ignore them; the default does.
+     */
+    virtual void setLimits(const ScriptLimits& limits) { Q_UNUSED(limits); }
+
+    /**
+     * @brief Turns profiling of later execute() calls on or off.
+     * Engines without a profiler ignore it; the default does.
+     */
+    virtual void setProfiling(bool enabled) { Q_UNUSED(enabled); }
+
+    /**
+     * @brief Returns the profile of the last profiled execute() and clears it.
+     */
+    virtual ScriptProfile takeProfile() { return ScriptProfile(); }
 };
 
 /**
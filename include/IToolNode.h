@@ -24,12 +24,11 @@
 
 #pragma once
 
-#include <QWidget>
 #include <QFuture>
+#include <QPromise>
 #include <QObject>
 #include <QJsonObject>
 #include <QVariant>
-#include <list>
 
 #include "CommonDataTypes.h"
 #include "ExecutionToken.h"
@@ -39,9 +38,28 @@
  * @brief Finalized abstract interface for executable nodes (tools) in the pipeline.
  */
 
-using TokenList = std::list<ExecutionToken>;
 using PinId = QString;
 
+// Scheduling class a node draws its concurrency budget from (see ResourceBudgets).
+// GuiAffine nodes block on dialogs or widgets owned by the UI thread.
+enum class ResourceClass {
+    Cpu,
+    Network,
+    Process,
+    GuiAffine
+};
+constexpr int kResourceClassCount = 4;
+
+// Wraps an already computed result for IToolNode::executeAsync() implementations.
+inline QFuture<TokenList> makeReadyTokenFuture(TokenList tokens)
+{
+    QPromise<TokenList> promise;
+    promise.start();
+    promise.addResult(std::move(tokens));
+    promise.finish();
+    return promise.future();
+}
+
 class IToolNode {
 public:
     virtual ~IToolNode() = default;
@@ -50,9 +68,6 @@ public:
     // Returns the static descriptor for this node/tool.
     virtual NodeDescriptor getDescriptor() const = 0;
 
-    // Creates (or returns) a QWidget used to configure this tool instance.
-    virtual QWidget* createConfigurationWidget(QWidget* parent) = 0;
-
     // Executes the tool with the given incoming execution tokens and returns
     // the list of output tokens produced by this node.
     virtual TokenList execute(const TokenList& incomingTokens) = 0;
@@ -69,6 +84,58 @@ public:
         // Default AND logic: ready when the number of provided inputs equals the number of inbound connections
         return static_cast<int>(inputs.size()) == incomingConnectionsCount;
     }
+
+    // Speculation: called with the inputs of a node that is not ready yet. A control-flow
+    // node may return the packets it could still emit, one per possible outcome; the
+    // engine then starts the cacheable nodes behind each of them early and keeps only
+    // the work matching the packet the node actually emits. Defaults to no speculation.
+    virtual QList<DataPacket> speculativeOutputs(const QVariantMap& inputs) const {
+        Q_UNUSED(inputs);
+        return {};
+    }
+
+    // Result caching: return true only if execute() output depends solely on the node's
+    // saved state (saveState()) and its input tokens, so the engine may replay a stored
+    // result instead of executing. Defaults to false; nodes with side effects or user
+    // interaction (HumanInput, Process, file writers, database writers) must keep it off.
+    virtual bool isCacheable() const { return false; }
+
+    // Replay: return true only if execute() is a pure function of saved state and inputs,
+    // with no randomness, clock or external calls, so re-running it can never give a
+    // different answer. Scope retries replay such nodes when their inputs are unchanged,
+    // and forced re-runs take their stored result. Sampling nodes such as LLM calls are
+    // cacheable but not deterministic. Implies isCacheable().
+    virtual bool isDeterministic() const { return false; }
+
+    // Which concurrency budget the engine charges this node's executions against.
+    // Defaults to Cpu; nodes that wait on HTTP, child processes or the UI thread say so.
+    virtual ResourceClass resourceClass() const { return ResourceClass::Cpu; }
+
+    // Concurrent runs: return true only if execute() may be called for several runs at
+    // once (no per-execution member state). Otherwise the engine serializes the node's
+    // executions across the foreground run and any independent runs.
+    virtual bool supportsConcurrentRuns() const { return false; }
+
+    // Reentrancy: return true if one run may execute this node several times at once,
+    // e.g. for the items a loop feeds it. The node's "max concurrent executions"
+    // setting then applies; otherwise the engine runs one execution per node at a
+    // time. Defaults to supportsConcurrentRuns(), which needs the same statelessness.
+    virtual bool isReentrant() const { return supportsConcurrentRuns(); }
+
+    // Run start: called on the engine's thread when a run that includes this node begins.
+    // Nodes may start preparing slow external resources (loading a local model) in the
+    // background so the first execution doesn't pay for it. Must return at once.
+    virtual void warmUp() {}
+
+    // Asynchronous execution: nodes that mostly wait on network I/O may return true and
+    // implement executeAsync(). The engine then releases its worker thread as soon as the
+    // future is returned and completes the task when it finishes, so long provider round
+    // trips don't occupy the engine's pool. execute() must remain a working synchronous
+    // fallback (tests and the scope executor call it directly).
+    virtual bool supportsAsyncExecution() const { return false; }
+    virtual QFuture<TokenList> executeAsync(const TokenList& incomingTokens) {
+        return makeReadyTokenFuture(execute(incomingTokens));
+    }
 };
 
 // Declare the Qt interface IID for IToolNode so Q_INTERFACES can resolve it
@@ -0,0 +1,55 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QDir>
+#include <QFileInfo>
+#include <QString>
+#include <QVariantMap>
+
+// Per-node output directories.
+//
+// The engine passes each task the path of its persistent output directory in the
+// "_sys_node_output_dir" input key, but does not create it: most nodes never write
+// files. Nodes that do call NodeOutputDir::materialize() right before writing, which
+// creates the directory on first use.
+namespace NodeOutputDir {
+
+inline QString inputKey()
+{
+    return QStringLiteral("_sys_node_output_dir");
+}
+
+// Returns the node's output directory, creating it if needed. Returns an empty
+// string when the engine supplied no directory or it could not be created, so
+// callers can fall back to a temporary location.
+inline QString materialize(const QVariantMap& inputs)
+{
+    const QString dir = inputs.value(inputKey()).toString();
+    if (dir.isEmpty()) return {};
+    if (QFileInfo(dir).isDir()) return dir;
+    return QDir().mkpath(dir) ? dir : QString();
+}
+
+} // namespace NodeOutputDir
@@ -0,0 +1,100 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include "ExecutionToken.h"
+
+// Lets a node publish output tokens before its execute() returns.
+//
+// While a node executes, the engine makes a sink for that task the thread's current()
+// sink. publish() hands tokens to the engine straight away: they are merged into the
+// data lake and fanned out to the downstream nodes wired to the pins they carry, so
+// those nodes start while the producer is still running. The tokens execute() returns
+// are still the task's result and complete it as usual. Publishing after the task has
+// completed is ignored. Like CancellationToken, work that moves to another thread must
+// capture current() and call publish() on the copy. A default-constructed sink drops
+// everything, so nodes can publish unconditionally.
+//
+// publish() never blocks: tokens that meet a full downstream input queue are parked by
+// the engine. A producer that can publish without bound (a loop reading a huge file)
+// calls awaitCapacity() between publishes, which waits until its parked tokens have
+// been scheduled, so memory stays flat however long the source is.
+class PartialOutputSink {
+public:
+    using Publisher = std::function<void(const TokenList&)>;
+    using Throttle = std::function<void()>;
+
+    PartialOutputSink() = default;
+    explicit PartialOutputSink(Publisher publisher, Throttle throttle = Throttle())
+        : m_publisher(std::make_shared<Publisher>(std::move(publisher)))
+        , m_throttle(throttle ? std::make_shared<Throttle>(std::move(throttle)) : nullptr)
+    {
+    }
+
+    bool isActive() const { return m_publisher && *m_publisher; }
+    void publish(const TokenList& tokens) const
+    {
+        if (isActive() && !tokens.empty()) (*m_publisher)(tokens);
+    }
+
+    // Blocks while tokens published earlier still wait behind full downstream queues.
+    // Returns at once for sinks without backpressure and when the run is cancelled.
+    void awaitCapacity() const
+    {
+        if (m_throttle) (*m_throttle)();
+    }
+
+    // The sink of the task the calling thread is executing a node for
+    static PartialOutputSink current() { return slot(); }
+
+    // Makes a sink current for the lifetime of the scope
+    class Scope {
+    public:
+        explicit Scope(PartialOutputSink sink)
+            : m_previous(std::exchange(slot(), std::move(sink)))
+        {
+        }
+        ~Scope() { slot() = std::move(m_previous); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        PartialOutputSink m_previous;
+    };
+
+private:
+    static PartialOutputSink& slot()
+    {
+        thread_local PartialOutputSink sink;
+        return sink;
+    }
+
+    std::shared_ptr<Publisher> m_publisher;
+    std::shared_ptr<Throttle> m_throttle;
+};
@@ -0,0 +1,97 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <QRandomGenerator>
+
+#include <algorithm>
+#include <utility>
+
+// Engine retries of transient failures, configured per node.
+//
+// A node reports a failure as transient by adding kRetryAfterKey to the token that
+// carries its __error: timeouts, 5xx answers and rate limits, with the provider's
+// Retry-After in milliseconds when it sent one and 0 otherwise. While the node's
+// policy has attempts left, the engine drops that result and queues the task again
+// with a not-before time, so no worker sleeps through the backoff and the error never
+// reaches downstream nodes. The last attempt's result goes out as it is.
+//
+// While a node executes, the engine makes current() say whether it will retry the
+// execution, so a backend answered with 429 can return at once and leave the wait to
+// the engine instead of holding its thread until the provider's queue reopens.
+struct RetryPolicy {
+    static constexpr const char* kRetryAfterKey = "_retry_after_ms";
+    static constexpr int kMaxAttemptsLimit = 10;
+    static constexpr int kDefaultBaseDelayMs = 1000;
+    static constexpr int kMaxDelayMs = 60000;
+
+    int maxAttempts {1}; // 1 never retries
+    int baseDelayMs {kDefaultBaseDelayMs};
+
+    bool retries() const { return maxAttempts > 1; }
+
+    // Wait before the attempt after failed attempt `attempt` (1-based). Retry-After is
+    // honoured when given, plus up to a tenth so a fan-out doesn't return all at once;
+    // otherwise base * 2^(attempt-1), capped at kMaxDelayMs, jittered over its upper half.
+    int delayMs(int attempt, int retryAfterMs) const
+    {
+        QRandomGenerator* random = QRandomGenerator::global();
+        if (retryAfterMs > 0) {
+            return retryAfterMs + static_cast<int>(random->bounded(retryAfterMs / 10 + 1));
+        }
+        const qint64 backoff = std::min<qint64>(static_cast<qint64>(std::max(1, baseDelayMs))
+                                                    << std::clamp(attempt - 1, 0, 20),
+                                                kMaxDelayMs);
+        const int half = static_cast<int>(backoff / 2);
+        return half + static_cast<int>(random->bounded(static_cast<int>(backoff) - half + 1));
+    }
+
+    // True while the calling thread executes a node the engine will retry on a
+    // transient failure
+    static bool current() { return slot(); }
+
+    // Makes the flag current for the lifetime of the scope
+    class Scope {
+    public:
+        explicit Scope(bool retried)
+            : m_previous(std::exchange(slot(), retried))
+        {
+        }
+        ~Scope() { slot() = m_previous; }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        bool m_previous;
+    };
+
+private:
+    static bool& slot()
+    {
+        thread_local bool retried = false;
+        return retried;
+    }
+};
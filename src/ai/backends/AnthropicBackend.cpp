@@ -25,6 +25,13 @@
 #include "AnthropicBackend.h"
 #include "ModelCapsRegistry.h"
 #include "ai/registry/LLMProviderRegistry.h"
+#include "BackendCancellation.h"
+#include "AttachmentStore.h"
+#include "BackendRateLimit.h"
+#include "HttpConnectionPool.h"
+#include "JsonPayload.h"
+#include "ProviderEndpoint.h"
+#include "StreamingResponse.h"
 #include "LoggingCategories.h"
 #include "Logger.h"
 #include <QtConcurrent>
@@ -35,6 +42,71 @@
 #include <QFile>
 #include <QFileInfo>
 
+namespace {
+
+// Scheme and host requests go to; see ProviderEndpoint
+std::string apiBase()
+{
+    return ProviderEndpoint::baseUrl(QStringLiteral("anthropic"), "ANTHROPIC_BASE_URL",
+                                     QStringLiteral("https://api.anthropic.com"))
+        .toStdString();
+}
+
+constexpr const char* kFilesApiBeta = "files-api-2025-04-14";
+
+QJsonObject ephemeralCacheControl()
+{
+    return QJsonObject{{QStringLiteral("type"), QStringLiteral("ephemeral")}};
+}
+
+// Reads a Messages API response: the first text block and the usage counters
+LLMResult messageResult(const QJsonObject& resObj)
+{
+    LLMResult result;
+
+    // Extract content[0].text
+    const QJsonArray contentArray = resObj.value(QStringLiteral("content")).toArray();
+    if (!contentArray.isEmpty()) {
+        result.content = contentArray.at(0).toObject().value(QStringLiteral("text")).toString();
+    }
+
+    // Extract usage
+    const QJsonObject usageObj = resObj.value(QStringLiteral("usage")).toObject();
+    // input_tokens excludes cached tokens; fold them back in so totals stay comparable
+    result.usage.cacheReadTokens = usageObj.value(QStringLiteral("cache_read_input_tokens")).toInt();
+    result.usage.cacheWriteTokens = usageObj.value(QStringLiteral("cache_creation_input_tokens")).toInt();
+    result.usage.inputTokens = usageObj.value(QStringLiteral("input_tokens")).toInt()
+        + result.usage.cacheReadTokens + result.usage.cacheWriteTokens;
+    result.usage.outputTokens = usageObj.value(QStringLiteral("output_tokens")).toInt();
+    result.usage.totalTokens = result.usage.inputTokens + result.usage.outputTokens;
+    return result;
+}
+
+// The API's error message from a failed request, else the transport error or HTTP status
+QString apiErrorMessage(const cpr::Response& response)
+{
+    if (response.error) {
+        return QString::fromStdString(response.error.message);
+    }
+    const QString message = QJsonDocument::fromJson(QByteArray::fromStdString(response.text))
+                                .object().value(QStringLiteral("error")).toObject()
+                                .value(QStringLiteral("message")).toString();
+    return message.isEmpty() ? QStringLiteral("HTTP %1").arg(response.status_code) : message;
+}
+
+cpr::Header batchHeaders(const QString& apiKey)
+{
+    // Batched requests may reference uploaded files
+    return cpr::Header{
+        {"x-api-key", apiKey.toStdString()},
+        {"anthropic-version", "2023-06-01"},
+        {"anthropic-beta", kFilesApiBeta},
+        {"Content-Type", "application/json"}
+    };
+}
+
+} // namespace
+
 QString AnthropicBackend::id() const {
     return QStringLiteral("anthropic");
 }
@@ -60,8 +132,8 @@ QFuture<QStringList> AnthropicBackend::fetchModelList() {
             return availableModels();
         }
 
-        auto response = cpr::Get(
-            cpr::Url{"https://api.anthropic.com/v1/models"},
+        auto response = HttpConnectionPool::get(
+            cpr::Url{apiBase() + "/v1/models"},
             cpr::Header{
                 {"x-api-key", apiKey.toStdString()},
                 {"anthropic-version", "2023-06-01"},
@@ -126,8 +198,8 @@ QFuture<QStringList> AnthropicBackend::fetchRawModelList() {
             return availableModels();
         }
 
-        auto response = cpr::Get(
-            cpr::Url{"https://api.anthropic.com/v1/models"},
+        auto response = HttpConnectionPool::get(
+            cpr::Url{apiBase() + "/v1/models"},
             cpr::Header{
                 {"x-api-key", apiKey.toStdString()},
                 {"anthropic-version", "2023-06-01"},
@@ -179,8 +251,36 @@ LLMResult AnthropicBackend::sendPrompt(
     const QString& systemPrompt,
     const QString& userPrompt,
     const LLMMessage& message
+) {
+    return promptRequest(apiKey, modelName, temperature, maxTokens, systemPrompt, userPrompt, message, {});
+}
+
+LLMResult AnthropicBackend::streamPrompt(
+    const QString& apiKey,
+    const QString& modelName,
+    double temperature,
+    int maxTokens,
+    const QString& systemPrompt,
+    const QString& userPrompt,
+    const LLMStreamCallback& onDelta,
+    const LLMMessage& message
+) {
+    return promptRequest(apiKey, modelName, temperature, maxTokens, systemPrompt, userPrompt, message, onDelta);
+}
+
+LLMResult AnthropicBackend::promptRequest(
+    const QString& apiKey,
+    const QString& modelName,
+    double temperature,
+    int maxTokens,
+    const QString& systemPrompt,
+    const QString& userPrompt,
+    const LLMMessage& message,
+    const LLMStreamCallback& onDelta,
+    std::string* requestBodyOut
 ) {
     LLMResult result;
+    const CancellationToken cancellation = CancellationToken::current();
     
     // Resolve alias to real ID for the API request
     const QString resolvedModel = ModelCapsRegistry::instance().resolveAlias(modelName, id());
@@ -221,39 +321,74 @@ LLMResult AnthropicBackend::sendPrompt(
     // Anthropic requires system prompts to be in a top-level 'system' field.
     // We use roleMode to decide if this field should be populated.
     if (!systemPrompt.isEmpty() && roleMode == ModelCapsTypes::RoleMode::SystemParameter) {
-        root.insert(QStringLiteral("system"), systemPrompt);
+        if (message.cacheSystemPrompt) {
+            // A cache breakpoint on the system block lets repeated calls reuse the prefix
+            QJsonObject systemBlock;
+            systemBlock.insert(QStringLiteral("type"), QStringLiteral("text"));
+            systemBlock.insert(QStringLiteral("text"), systemPrompt);
+            systemBlock.insert(QStringLiteral("cache_control"), ephemeralCacheControl());
+            root.insert(QStringLiteral("system"), QJsonArray{systemBlock});
+        } else {
+            root.insert(QStringLiteral("system"), systemPrompt);
+        }
     }
 
-    // Build messages array
+    // Build messages array; a continued conversation resends its earlier turns first
     QJsonArray messages;
+    for (qsizetype i = 0; i < message.history.size(); ++i) {
+        const LLMTurn& turn = message.history.at(i);
+        messages.append(QJsonObject{{QStringLiteral("role"), QStringLiteral("user")},
+                                    {QStringLiteral("content"), turn.prompt}});
+        QJsonObject answerBlock{{QStringLiteral("type"), QStringLiteral("text")},
+                                {QStringLiteral("text"), turn.response}};
+        // A breakpoint on the latest answer caches the whole conversation so far
+        if (message.cacheSystemPrompt && i == message.history.size() - 1) {
+            answerBlock.insert(QStringLiteral("cache_control"), ephemeralCacheControl());
+        }
+        messages.append(QJsonObject{{QStringLiteral("role"), QStringLiteral("assistant")},
+                                    {QStringLiteral("content"), QJsonArray{answerBlock}}});
+    }
     QJsonObject userMsg;
     userMsg.insert(QStringLiteral("role"), QStringLiteral("user"));
 
+    JsonPayload payload;
+    QList<LLMAttachment> uploaded;
     if (!message.attachments.isEmpty()) {
         QJsonArray contentArray;
 
         for (const auto& attachment : message.attachments) {
-            QString base64Data = QString::fromLatin1(attachment.data.toBase64());
+            const bool isPdf = attachment.mimeType == QStringLiteral("application/pdf");
+            if (!isPdf && !attachment.mimeType.startsWith(QStringLiteral("image/"))) {
+                continue;
+            }
 
-            if (attachment.mimeType == QStringLiteral("application/pdf")) {
-                QJsonObject documentBlock;
-                documentBlock.insert(QStringLiteral("type"), QStringLiteral("document"));
-                QJsonObject source;
-                source.insert(QStringLiteral("type"), QStringLiteral("base64"));
-                source.insert(QStringLiteral("media_type"), attachment.mimeType);
-                source.insert(QStringLiteral("data"), base64Data);
-                documentBlock.insert(QStringLiteral("source"), source);
-                contentArray.append(documentBlock);
-            } else if (attachment.mimeType.startsWith(QStringLiteral("image/"))) {
-                QJsonObject imageBlock;
-                imageBlock.insert(QStringLiteral("type"), QStringLiteral("image"));
-                QJsonObject source;
+            // Large files go up once through the Files API; later requests send the file id
+            QJsonObject source;
+            const QString fileId = AttachmentStore::shared().reference(
+                id(), apiKey, attachment, 0,
+                [&](const LLMAttachment& file) { return uploadFile(apiKey, file, cancellation); });
+            if (!fileId.isEmpty()) {
+                source.insert(QStringLiteral("type"), QStringLiteral("file"));
+                source.insert(QStringLiteral("file_id"), fileId);
+                uploaded.append(attachment);
+            } else {
                 source.insert(QStringLiteral("type"), QStringLiteral("base64"));
                 source.insert(QStringLiteral("media_type"), attachment.mimeType);
-                source.insert(QStringLiteral("data"), base64Data);
-                imageBlock.insert(QStringLiteral("source"), source);
-                contentArray.append(imageBlock);
+                source.insert(QStringLiteral("data"), payload.base64(attachment.data));
             }
+
+            QJsonObject block;
+            block.insert(QStringLiteral("type"), isPdf ? QStringLiteral("document") : QStringLiteral("image"));
+            block.insert(QStringLiteral("source"), source);
+            contentArray.append(block);
+        }
+
+        // Attachments precede the prompt text, so a breakpoint on the last one caches
+        // the system prompt and every attachment while the question can still vary
+        if (message.cacheAttachments && !contentArray.isEmpty()) {
+            QJsonObject lastBlock = contentArray.last().toObject();
+            lastBlock.insert(QStringLiteral("cache_control"), ephemeralCacheControl());
+            contentArray.replace(contentArray.size() - 1, lastBlock);
         }
 
         // Text block
@@ -272,8 +407,18 @@ LLMResult AnthropicBackend::sendPrompt(
     messages.append(userMsg);
     root.insert(QStringLiteral("messages"), messages);
 
-    QJsonDocument doc(root);
-    std::string jsonPayload = doc.toJson(QJsonDocument::Compact).toStdString();
+    const bool streaming = static_cast<bool>(onDelta);
+    if (streaming) {
+        root.insert(QStringLiteral("stream"), true);
+    }
+
+    const std::string jsonPayload = payload.serialize(root);
+
+    // Batch jobs send this same body later as one request's params
+    if (requestBodyOut) {
+        *requestBodyOut = jsonPayload;
+        return result;
+    }
 
     try {
         cpr::Header header{
@@ -282,8 +427,15 @@ LLMResult AnthropicBackend::sendPrompt(
             {"Content-Type", "application/json"}
         };
 
+        QStringList betas;
         if (hasPdf) {
-            header.insert({"anthropic-beta", "pdfs-2024-09-25"});
+            betas << QStringLiteral("pdfs-2024-09-25");
+        }
+        if (!uploaded.isEmpty()) {
+            betas << QString::fromLatin1(kFilesApiBeta);
+        }
+        if (!betas.isEmpty()) {
+            header.insert({"anthropic-beta", betas.join(QLatin1Char(',')).toStdString()});
         }
 
         if (resolved.has_value()) {
@@ -292,34 +444,86 @@ LLMResult AnthropicBackend::sendPrompt(
             }
         }
 
-        auto response = cpr::Post(
-            cpr::Url{"https://api.anthropic.com/v1/messages"},
-            header,
-            cpr::Body{jsonPayload},
-            cpr::Timeout{std::chrono::seconds(60)}
-        );
-
-        result.rawResponse = QString::fromStdString(response.text);
-
-        if (response.status_code == 200) {
-            QJsonDocument resDoc = QJsonDocument::fromJson(result.rawResponse.toUtf8());
-            QJsonObject resObj = resDoc.object();
+        // message_start carries the input usage, content_block_delta the text and
+        // message_delta the final output usage
+        QString streamedText;
+        QJsonObject streamedUsage;
+        int streamedOutputTokens = 0;
+        StreamingResponse stream(StreamingResponse::Framing::ServerSentEvents, [&](const QJsonObject& event) {
+            const QString type = event.value(QStringLiteral("type")).toString();
+            if (type == QStringLiteral("content_block_delta")) {
+                const QString delta = event.value(QStringLiteral("delta")).toObject().value(QStringLiteral("text")).toString();
+                if (!delta.isEmpty()) {
+                    streamedText += delta;
+                    onDelta(delta);
+                }
+            } else if (type == QStringLiteral("message_start")) {
+                streamedUsage = event.value(QStringLiteral("message")).toObject().value(QStringLiteral("usage")).toObject();
+                streamedOutputTokens = streamedUsage.value(QStringLiteral("output_tokens")).toInt(streamedOutputTokens);
+            } else if (type == QStringLiteral("message_delta")) {
+                const QJsonObject usage = event.value(QStringLiteral("usage")).toObject();
+                streamedOutputTokens = usage.value(QStringLiteral("output_tokens")).toInt(streamedOutputTokens);
+            }
+        });
 
-            // Extract content[0].text
-            QJsonArray contentArray = resObj.value(QStringLiteral("content")).toArray();
-            if (!contentArray.isEmpty()) {
-                result.content = contentArray.at(0).toObject().value(QStringLiteral("text")).toString();
+        ProviderRateLimiter::Permit permit;
+        auto response = BackendRateLimit::send(
+            permit, id(), resolvedModel,
+            ProviderRateLimiter::estimateTokens(systemPrompt.size() + userPrompt.size(), maxTokens), cancellation,
+            [&] {
+                return streaming
+                    ? HttpConnectionPool::post(
+                          cpr::Url{apiBase() + "/v1/messages"},
+                          header,
+                          cpr::Body{jsonPayload},
+                          cpr::Timeout{std::chrono::seconds(60)},
+                          BackendCancellation::progressCallback(cancellation),
+                          stream.writeCallback())
+                    : HttpConnectionPool::post(
+                          cpr::Url{apiBase() + "/v1/messages"},
+                          header,
+                          cpr::Body{jsonPayload},
+                          cpr::Timeout{std::chrono::seconds(60)},
+                          BackendCancellation::progressCallback(cancellation));
+            });
+
+        // Reassemble a streamed answer into the non-streaming response shape parsed below
+        if (streaming) {
+            stream.finish();
+            if (response.status_code == 200) {
+                const QJsonObject textBlock{{QStringLiteral("type"), QStringLiteral("text")},
+                                            {QStringLiteral("text"), streamedText}};
+                // Keeps the cache_*_input_tokens counters from message_start
+                QJsonObject usage = streamedUsage;
+                usage.insert(QStringLiteral("output_tokens"), streamedOutputTokens);
+                const QJsonObject assembled{{QStringLiteral("content"), QJsonArray{textBlock}},
+                                            {QStringLiteral("usage"), usage}};
+                response.text = QJsonDocument(assembled).toJson(QJsonDocument::Compact).toStdString();
+            } else {
+                response.text = stream.raw();
             }
+        }
 
-            // Extract usage
-            QJsonObject usageObj = resObj.value(QStringLiteral("usage")).toObject();
-            result.usage.inputTokens = usageObj.value(QStringLiteral("input_tokens")).toInt();
-            result.usage.outputTokens = usageObj.value(QStringLiteral("output_tokens")).toInt();
-            result.usage.totalTokens = result.usage.inputTokens + result.usage.outputTokens;
+        if (response.error && cancellation.isCancelled()) {
+            result.hasError = true;
+            result.errorMsg = BackendCancellation::message();
+            result.content = result.errorMsg;
+            return result;
+        }
+
+        result.rawResponse = QString::fromStdString(response.text);
 
-            result.hasError = false;
+        if (response.status_code == 200) {
+            // Parse the UTF-8 body itself, not a re-encoding of the rawResponse copy
+            const QJsonObject resObj = QJsonDocument::fromJson(QByteArray::fromRawData(
+                response.text.data(), static_cast<qsizetype>(response.text.size()))).object();
+            const QString rawResponse = result.rawResponse;
+            result = messageResult(resObj);
+            result.rawResponse = rawResponse;
+            permit.settle(result.usage.totalTokens);
         } else {
             result.hasError = true;
+            BackendRateLimit::markTransient(result, response);
             if (result.rawResponse.isEmpty()) {
                 result.errorMsg = QStringLiteral("HTTP %1").arg(response.status_code);
             } else {
@@ -340,6 +544,13 @@ LLMResult AnthropicBackend::sendPrompt(
                                           .arg(response.status_code)
                                           .arg(result.errorMsg);
             result.content = result.errorMsg;
+
+            // An expired or deleted file is rejected as a bad request; upload it afresh next time
+            if (response.status_code >= 400 && response.status_code < 500 && response.status_code != 429) {
+                for (const auto& attachment : uploaded) {
+                    AttachmentStore::shared().forget(id(), apiKey, attachment);
+                }
+            }
         }
     } catch (const std::exception& e) {
         result.hasError = true;
@@ -352,6 +563,153 @@ LLMResult AnthropicBackend::sendPrompt(
     return result;
 }
 
+LLMBatchStatus AnthropicBackend::submitBatch(const QString& apiKey, const QList<LLMBatchRequest>& requests) {
+    LLMBatchStatus status;
+
+    // Requests whose body cannot be built are answered now and left out of the job
+    std::string entries;
+    for (const LLMBatchRequest& request : requests) {
+        std::string params;
+        const LLMResult built = promptRequest(apiKey, request.modelName, request.temperature, request.maxTokens,
+                                              request.systemPrompt, request.userPrompt, request.message, {}, &params);
+        if (built.hasError) {
+            status.results.insert(request.customId, built);
+            continue;
+        }
+        // Splice the already serialised params in rather than parsing them back into JSON
+        const QJsonObject envelope{{QStringLiteral("custom_id"), request.customId}};
+        std::string entry = QJsonDocument(envelope).toJson(QJsonDocument::Compact).toStdString();
+        entry.pop_back();
+        entries += (entries.empty() ? "" : ",") + entry + R"(,"params":)" + params + "}";
+    }
+    if (entries.empty()) {
+        return status;
+    }
+
+    try {
+        const auto created = HttpConnectionPool::post(
+            cpr::Url{apiBase() + "/v1/messages/batches"},
+            batchHeaders(apiKey),
+            cpr::Body{R"({"requests":[)" + entries + "]}"},
+            cpr::Timeout{std::chrono::seconds(300)});
+        status.jobId = QJsonDocument::fromJson(QByteArray::fromStdString(created.text))
+                           .object().value(QStringLiteral("id")).toString();
+        if (created.status_code != 200 || status.jobId.isEmpty()) {
+            status.hasError = true;
+            status.errorMsg = QStringLiteral("Anthropic batch creation failed: %1").arg(apiErrorMessage(created));
+        }
+    } catch (const std::exception& e) {
+        status.hasError = true;
+        status.errorMsg = QString::fromUtf8(e.what());
+    }
+    return status;
+}
+
+LLMBatchStatus AnthropicBackend::pollBatch(const QString& apiKey, const QString& jobId) {
+    LLMBatchStatus status;
+    status.jobId = jobId;
+
+    try {
+        const auto polled = HttpConnectionPool::get(
+            cpr::Url{apiBase() + "/v1/messages/batches/" + jobId.toStdString()},
+            batchHeaders(apiKey),
+            cpr::Timeout{std::chrono::seconds(60)});
+        if (polled.status_code != 200) {
+            // Try again at the next poll
+            CP_WARN << "AnthropicBackend::pollBatch:" << jobId << apiErrorMessage(polled);
+            return status;
+        }
+
+        const QJsonObject job = QJsonDocument::fromJson(QByteArray::fromStdString(polled.text)).object();
+        const QString resultsUrl = job.value(QStringLiteral("results_url")).toString();
+        if (job.value(QStringLiteral("processing_status")).toString() != QStringLiteral("ended") || resultsUrl.isEmpty()) {
+            return status;
+        }
+
+        const auto content = HttpConnectionPool::get(
+            cpr::Url{resultsUrl.toStdString()},
+            batchHeaders(apiKey),
+            cpr::Timeout{std::chrono::seconds(300)});
+        if (content.status_code != 200) {
+            CP_WARN << "AnthropicBackend::pollBatch: fetching results of" << jobId << "failed:" << apiErrorMessage(content);
+            return status;
+        }
+
+        for (const QByteArray& line : QByteArray::fromStdString(content.text).split('\n')) {
+            const QJsonObject entry = QJsonDocument::fromJson(line).object();
+            const QString customId = entry.value(QStringLiteral("custom_id")).toString();
+            if (customId.isEmpty()) continue;
+
+            // result.type is succeeded, errored, canceled or expired
+            const QJsonObject outcome = entry.value(QStringLiteral("result")).toObject();
+            const QString type = outcome.value(QStringLiteral("type")).toString();
+            LLMResult result;
+            if (type == QStringLiteral("succeeded")) {
+                const QJsonObject message = outcome.value(QStringLiteral("message")).toObject();
+                result = messageResult(message);
+                result.rawResponse = QString::fromUtf8(QJsonDocument(message).toJson(QJsonDocument::Compact));
+            } else {
+                const QString message = outcome.value(QStringLiteral("error")).toObject()
+                                            .value(QStringLiteral("error")).toObject()
+                                            .value(QStringLiteral("message")).toString();
+                result.hasError = true;
+                result.errorMsg = message.isEmpty()
+                    ? QStringLiteral("Anthropic batch request %1").arg(type.isEmpty() ? QStringLiteral("failed") : type)
+                    : message;
+                result.content = result.errorMsg;
+                result.rawResponse = QString::fromUtf8(QJsonDocument(outcome).toJson(QJsonDocument::Compact));
+            }
+            status.results.insert(customId, result);
+        }
+        status.finished = true;
+    } catch (const std::exception& e) {
+        CP_WARN << "AnthropicBackend::pollBatch:" << jobId << e.what();
+    }
+    return status;
+}
+
+void AnthropicBackend::cancelBatch(const QString& apiKey, const QString& jobId) {
+    try {
+        HttpConnectionPool::post(
+            cpr::Url{apiBase() + "/v1/messages/batches/" + jobId.toStdString() + "/cancel"},
+            batchHeaders(apiKey),
+            cpr::Timeout{std::chrono::seconds(30)});
+    } catch (const std::exception& e) {
+        CP_WARN << "AnthropicBackend::cancelBatch:" << jobId << e.what();
+    }
+}
+
+QString AnthropicBackend::uploadFile(const QString& apiKey, const LLMAttachment& attachment,
+                                    const CancellationToken& cancellation) {
+    const std::string fileName = attachment.mimeType == QStringLiteral("application/pdf")
+                                     ? "attachment.pdf"
+                                     : "attachment." + attachment.mimeType.section(QLatin1Char('/'), 1).toStdString();
+    try {
+        const auto response = HttpConnectionPool::post(
+            cpr::Url{apiBase() + "/v1/files"},
+            cpr::Header{
+                {"x-api-key", apiKey.toStdString()},
+                {"anthropic-version", "2023-06-01"},
+                {"anthropic-beta", kFilesApiBeta}
+            },
+            cpr::Multipart{{"file", cpr::Buffer{attachment.data.constBegin(), attachment.data.constEnd(), fileName},
+                            attachment.mimeType.toStdString()}},
+            cpr::Timeout{std::chrono::seconds(300)},
+            BackendCancellation::progressCallback(cancellation));
+        if (response.status_code != 200) {
+            CP_WARN.noquote() << QStringLiteral("AnthropicBackend::uploadFile failure provider=anthropic status=%1 message=%2")
+                                      .arg(response.status_code)
+                                      .arg(QString::fromStdString(response.error.message + response.text));
+            return {};
+        }
+        return QJsonDocument::fromJson(QByteArray::fromStdString(response.text))
+            .object().value(QStringLiteral("id")).toString();
+    } catch (const std::exception& e) {
+        CP_WARN << "AnthropicBackend::uploadFile:" << e.what();
+        return {};
+    }
+}
+
 EmbeddingResult AnthropicBackend::getEmbedding(
     const QString& apiKey,
     const QString& modelName,
@@ -367,6 +725,13 @@ EmbeddingResult AnthropicBackend::getEmbedding(
     return result;
 }
 
+void AnthropicBackend::warmUp(const QString& apiKey, const QString& modelName) {
+    Q_UNUSED(modelName);
+    if (!apiKey.trimmed().isEmpty()) {
+        HttpConnectionPool::preconnect(apiBase() + "/v1/models");
+    }
+}
+
 QFuture<QString> AnthropicBackend::generateImage(
     const QString& prompt,
     const QString& model,
@@ -25,8 +25,11 @@
 #pragma once
 
 #include "ILLMBackend.h"
+#include "CancellationToken.h"
 #include <QMutex>
 
+#include <string>
+
 /**
  * @brief Backend implementation for Anthropic (Claude).
  */
@@ -49,12 +52,32 @@ public:
         const LLMMessage& message = {}
     ) override;
 
+    LLMResult streamPrompt(
+        const QString& apiKey,
+        const QString& modelName,
+        double temperature,
+        int maxTokens,
+        const QString& systemPrompt,
+        const QString& userPrompt,
+        const LLMStreamCallback& onDelta,
+        const LLMMessage& message = {}
+    ) override;
+
     EmbeddingResult getEmbedding(
         const QString& apiKey,
         const QString& modelName,
         const QString& text
     ) override;
 
+    // Message Batches API: requests run within 24 hours at half price
+    // Opens a pooled connection to the API host; nothing is sent without a key
+    void warmUp(const QString& apiKey, const QString& modelName) override;
+
+    bool supportsBatch() const override { return true; }
+    LLMBatchStatus submitBatch(const QString& apiKey, const QList<LLMBatchRequest>& requests) override;
+    LLMBatchStatus pollBatch(const QString& apiKey, const QString& jobId) override;
+    void cancelBatch(const QString& apiKey, const QString& jobId) override;
+
     QFuture<QString> generateImage(
         const QString& prompt,
         const QString& model,
@@ -65,6 +88,23 @@ public:
     ) override;
 
 private:
+    // Shared by sendPrompt() and streamPrompt(); streams when onDelta is set. With
+    // requestBodyOut it only builds the request body, for submitBatch().
+    LLMResult promptRequest(
+        const QString& apiKey,
+        const QString& modelName,
+        double temperature,
+        int maxTokens,
+        const QString& systemPrompt,
+        const QString& userPrompt,
+        const LLMMessage& message,
+        const LLMStreamCallback& onDelta,
+        std::string* requestBodyOut = nullptr
+    );
+
+    // Uploads an attachment through the Files API; returns its file id, or empty on failure
+    QString uploadFile(const QString& apiKey, const LLMAttachment& attachment, const CancellationToken& cancellation);
+
     mutable QStringList m_cachedModels;
     mutable QMutex m_cacheMutex;
 };
@@ -0,0 +1,168 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "AttachmentPreprocessor.h"
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QImage>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QMutexLocker>
+#include <QPainter>
+
+#include <algorithm>
+
+#include "MetricsRegistry.h"
+
+namespace {
+
+// Animations and vector images are passed through; QImage would keep one raster frame
+bool isConvertibleImage(const QString& mimeType)
+{
+    return mimeType.startsWith(QLatin1String("image/")) && mimeType != QLatin1String("image/gif")
+        && mimeType != QLatin1String("image/svg+xml");
+}
+
+QByteArray writableFormat(const QByteArray& requested)
+{
+    static const QList<QByteArray> supported = QImageWriter::supportedImageFormats();
+    if (requested == "webp" && !supported.contains(requested)) {
+        // The WebP plugin ships with qtimageformats, which may not be installed
+        return QByteArrayLiteral("jpeg");
+    }
+    return supported.contains(requested) ? requested : QByteArray();
+}
+
+} // namespace
+
+AttachmentPreprocessor::AttachmentPreprocessor(int cacheBytes)
+    : m_cache(std::max(1, cacheBytes / 1024))
+{
+}
+
+AttachmentPreprocessor& AttachmentPreprocessor::shared()
+{
+    static AttachmentPreprocessor preprocessor;
+    return preprocessor;
+}
+
+LLMAttachment AttachmentPreprocessor::prepare(const LLMAttachment& attachment, const Options& options)
+{
+    if (!isConvertibleImage(attachment.mimeType) || attachment.data.isEmpty()) {
+        return attachment;
+    }
+
+    const QByteArray key = keyFor(attachment, options);
+    {
+        QMutexLocker locker(&m_mutex);
+        if (const LLMAttachment* cached = m_cache.object(key)) {
+            return *cached;
+        }
+    }
+
+    // Converted outside the lock; two runs sending the same new page may both convert it
+    LLMAttachment prepared = convert(attachment, options);
+    m_conversions.fetch_add(1);
+    if (prepared.data.size() < attachment.data.size()) {
+        MetricsRegistry::instance()
+            .counter(QStringLiteral("cp_attachment_bytes_saved"),
+                     QStringLiteral("Bytes not uploaded because image attachments were downscaled or recompressed"))
+            .increment(static_cast<quint64>(attachment.data.size() - prepared.data.size()));
+    }
+
+    QMutexLocker locker(&m_mutex);
+    // An unchanged result shares the source's bytes
+    m_cache.insert(key, new LLMAttachment(prepared), std::max<int>(1, static_cast<int>(prepared.data.size() / 1024)));
+    return prepared;
+}
+
+void AttachmentPreprocessor::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_cache.clear();
+}
+
+QByteArray AttachmentPreprocessor::keyFor(const LLMAttachment& attachment, const Options& options)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(attachment.data);
+    return hash.result() + '|' + QByteArray::number(options.maxDimension) + '|' + options.format + '|'
+        + QByteArray::number(options.quality);
+}
+
+LLMAttachment AttachmentPreprocessor::convert(const LLMAttachment& attachment, const Options& options) const
+{
+    QByteArray source = attachment.data;
+    QBuffer buffer(&source);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer);
+    reader.setAutoTransform(true);
+    const QByteArray sourceFormat = reader.format();
+    if (reader.supportsAnimation() && reader.imageCount() > 1) {
+        return attachment;
+    }
+    QImage image = reader.read();
+    if (image.isNull()) {
+        return attachment;
+    }
+
+    const bool oversized = options.maxDimension > 0 && std::max(image.width(), image.height()) > options.maxDimension;
+    if (oversized) {
+        image = image.scaled(options.maxDimension, options.maxDimension, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+
+    const QByteArray format = writableFormat(options.format.isEmpty() ? sourceFormat : options.format);
+    if (format.isEmpty()) {
+        return attachment;
+    }
+    if (format == "jpeg" && image.hasAlphaChannel()) {
+        // JPEG has no alpha; transparent diagram backgrounds become white rather than black
+        QImage flattened(image.size(), QImage::Format_RGB32);
+        flattened.fill(Qt::white);
+        QPainter painter(&flattened);
+        painter.drawImage(0, 0, image);
+        painter.end();
+        image = std::move(flattened);
+    }
+
+    QByteArray encoded;
+    QBuffer output(&encoded);
+    output.open(QIODevice::WriteOnly);
+    QImageWriter writer(&output, format);
+    writer.setQuality(options.quality);
+    if (!writer.write(image)) {
+        return attachment;
+    }
+    // Re-encoding a small image can make it bigger; only a smaller result is worth sending
+    if (encoded.size() >= attachment.data.size()) {
+        return attachment;
+    }
+
+    LLMAttachment prepared;
+    prepared.mimeType = format == "webp" ? QStringLiteral("image/webp")
+                      : format == "jpeg" ? QStringLiteral("image/jpeg")
+                                         : attachment.mimeType;
+    prepared.data = std::move(encoded);
+    return prepared;
+}
@@ -0,0 +1,75 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QCache>
+#include <QMutex>
+#include <QString>
+
+#include <atomic>
+
+#include "ai/backends/ILLMBackend.h"
+
+// Shrinks image attachments before they are sent. Vision models resize large
+// images themselves, so a page rendered at print resolution costs upload time
+// and often image tokens for detail the model throws away. prepare() scales an
+// image to the model's longest edge and re-encodes it, and keeps the result by
+// source content hash, so the same page sent again is not converted twice.
+class AttachmentPreprocessor {
+public:
+    static constexpr int kDefaultMaxDimension = 2048;
+    static constexpr int kDefaultQuality = 85;
+    static constexpr int kDefaultCacheBytes = 64 * 1024 * 1024;
+
+    struct Options {
+        // Longest edge in pixels; 0 keeps the size
+        int maxDimension {kDefaultMaxDimension};
+        // "jpeg" or "webp"; empty keeps the source format
+        QByteArray format {"jpeg"};
+        int quality {kDefaultQuality};
+    };
+
+    explicit AttachmentPreprocessor(int cacheBytes = kDefaultCacheBytes);
+
+    static AttachmentPreprocessor& shared();
+
+    // The attachment scaled and re-encoded per options. Anything that isn't a still
+    // image, fails to decode, or would not get smaller is returned unchanged.
+    LLMAttachment prepare(const LLMAttachment& attachment, const Options& options);
+
+    void clear();
+
+    // Attachments converted, not counting cache hits
+    int conversions() const { return m_conversions.load(); }
+
+private:
+    static QByteArray keyFor(const LLMAttachment& attachment, const Options& options);
+    LLMAttachment convert(const LLMAttachment& attachment, const Options& options) const;
+
+    QMutex m_mutex;
+    // Cost is in KiB so large budgets fit QCache's int
+    QCache<QByteArray, LLMAttachment> m_cache;
+    std::atomic<int> m_conversions {0};
+};
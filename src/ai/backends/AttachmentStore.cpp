@@ -0,0 +1,148 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "AttachmentStore.h"
+
+#include <QCryptographicHash>
+#include <QMutexLocker>
+
+#include "CancellationToken.h"
+#include "Logger.h"
+
+AttachmentStore::AttachmentStore(qint64 minUploadBytes)
+    : m_minUploadBytes(minUploadBytes)
+{
+}
+
+AttachmentStore& AttachmentStore::shared()
+{
+    static AttachmentStore store(qEnvironmentVariable("CP_PROVIDER_FILE_UPLOADS") == QStringLiteral("0")
+                                     ? -1
+                                     : kDefaultMinUploadBytes);
+    return store;
+}
+
+bool AttachmentStore::shouldUpload(const LLMAttachment& attachment) const
+{
+    return m_minUploadBytes >= 0 && attachment.data.size() >= m_minUploadBytes;
+}
+
+QString AttachmentStore::reference(const QString& providerId,
+                                   const QString& apiKey,
+                                   const LLMAttachment& attachment,
+                                   qint64 ttlMs,
+                                   const Uploader& upload)
+{
+    if (!shouldUpload(attachment) || !upload) {
+        return {};
+    }
+    return reference(providerId, apiKey, contentKeyFor(attachment), ttlMs, [&]() {
+        const QString reference = upload(attachment);
+        if (reference.isEmpty() && !CancellationToken::current().isCancelled()) {
+            CP_WARN << "AttachmentStore: upload to" << providerId << "failed; sending"
+                    << attachment.data.size() << "bytes inline";
+        }
+        return reference;
+    });
+}
+
+QString AttachmentStore::reference(const QString& providerId,
+                                   const QString& apiKey,
+                                   const QByteArray& contentKey,
+                                   qint64 ttlMs,
+                                   const std::function<QString()>& create)
+{
+    if (m_minUploadBytes < 0 || !create) {
+        return {};
+    }
+
+    const std::shared_ptr<Slot> slot = slotFor(keyFor(providerId, apiKey, contentKey));
+    QMutexLocker locker(&slot->mutex);
+    if (slot->entry.has_value() && !slot->entry->expiry.hasExpired()) {
+        return slot->entry->reference;
+    }
+
+    const QString reference = create();
+    if (reference.isEmpty() && CancellationToken::current().isCancelled()) {
+        // A stopped run says nothing about the provider; let the next one try again
+        return {};
+    }
+    if (reference.isEmpty()) {
+        slot->entry = Entry{QString(), QDeadlineTimer(kFailureRetryMs)};
+        return {};
+    }
+
+    // Expire a little early so a file is never referenced just as the provider drops it
+    slot->entry = Entry{reference, ttlMs > 0 ? QDeadlineTimer(ttlMs * 9 / 10) : QDeadlineTimer(QDeadlineTimer::Forever)};
+    ++m_uploads;
+    return reference;
+}
+
+void AttachmentStore::forget(const QString& providerId, const QString& apiKey, const LLMAttachment& attachment)
+{
+    forget(providerId, apiKey, contentKeyFor(attachment));
+}
+
+void AttachmentStore::forget(const QString& providerId, const QString& apiKey, const QByteArray& contentKey)
+{
+    const QByteArray key = keyFor(providerId, apiKey, contentKey);
+    QMutexLocker locker(&m_mutex);
+    m_slots.remove(key);
+}
+
+void AttachmentStore::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_slots.clear();
+}
+
+QByteArray AttachmentStore::contentKeyFor(const LLMAttachment& attachment)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(attachment.mimeType.toUtf8());
+    hash.addData(QByteArrayView("\n"));
+    hash.addData(attachment.data);
+    return hash.result();
+}
+
+QByteArray AttachmentStore::keyFor(const QString& providerId, const QString& apiKey, const QByteArray& contentKey)
+{
+    // Files belong to the account that uploaded them, so the key is part of the identity
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(providerId.toUtf8());
+    hash.addData(QByteArrayView("\n"));
+    hash.addData(QCryptographicHash::hash(apiKey.toUtf8(), QCryptographicHash::Sha256));
+    hash.addData(QByteArrayView("\n"));
+    hash.addData(contentKey);
+    return hash.result();
+}
+
+std::shared_ptr<AttachmentStore::Slot> AttachmentStore::slotFor(const QByteArray& key)
+{
+    QMutexLocker locker(&m_mutex);
+    std::shared_ptr<Slot>& slot = m_slots[key];
+    if (!slot) {
+        slot = std::make_shared<Slot>();
+    }
+    return slot;
+}
@@ -0,0 +1,113 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QDeadlineTimer>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <optional>
+
+#include "ai/backends/ILLMBackend.h"
+
+// Uploads each large attachment to a provider's file API once and remembers the
+// remote reference (file id or file URI) it gets back, keyed by provider, API key
+// and the SHA-256 of the content. Later requests carrying the same bytes send the
+// reference instead of re-encoding the whole file, so the same PDF given to a
+// hundred prompts is uploaded once.
+//
+// Attachments below minUploadBytes are always sent inline. Concurrent requests for
+// the same content wait for the first upload rather than starting their own. A
+// failed upload is remembered for kFailureRetryMs so that a provider which rejects
+// uploads is not sent the file again on every call; those requests fall back to
+// inline data. An upload cut short by cancelling the run is not remembered.
+// Setting CP_PROVIDER_FILE_UPLOADS=0 turns uploads off for the shared store.
+class AttachmentStore {
+public:
+    static constexpr qint64 kDefaultMinUploadBytes = 1024 * 1024;
+    static constexpr qint64 kFailureRetryMs = 10 * 60 * 1000;
+
+    // Uploads the attachment and returns its remote reference, or an empty string on failure
+    using Uploader = std::function<QString(const LLMAttachment&)>;
+
+    // A negative minUploadBytes disables uploads
+    explicit AttachmentStore(qint64 minUploadBytes = kDefaultMinUploadBytes);
+
+    static AttachmentStore& shared();
+
+    bool shouldUpload(const LLMAttachment& attachment) const;
+
+    // The cached reference for this content, uploading it first on a miss. ttlMs is how
+    // long the provider keeps the file (0 for no expiry). Empty means send it inline.
+    QString reference(const QString& providerId,
+                      const QString& apiKey,
+                      const LLMAttachment& attachment,
+                      qint64 ttlMs,
+                      const Uploader& upload);
+
+    // The same for any other content kept on the provider's side, such as a Gemini
+    // context cache: contentKey identifies the content and create makes the remote
+    // copy, returning its name. There is no size threshold, but a disabled store
+    // still returns empty.
+    QString reference(const QString& providerId,
+                      const QString& apiKey,
+                      const QByteArray& contentKey,
+                      qint64 ttlMs,
+                      const std::function<QString()>& create);
+
+    // Drops a reference the provider no longer accepts, so the next request uploads again
+    void forget(const QString& providerId, const QString& apiKey, const LLMAttachment& attachment);
+    void forget(const QString& providerId, const QString& apiKey, const QByteArray& contentKey);
+
+    void clear();
+
+    // Successful uploads made by this store
+    int uploads() const { return m_uploads.load(); }
+
+private:
+    struct Entry {
+        QString reference;
+        QDeadlineTimer expiry;
+    };
+
+    // One per content key; its mutex is held while that content uploads
+    struct Slot {
+        QMutex mutex;
+        std::optional<Entry> entry;
+    };
+
+    static QByteArray contentKeyFor(const LLMAttachment& attachment);
+    static QByteArray keyFor(const QString& providerId, const QString& apiKey, const QByteArray& contentKey);
+    std::shared_ptr<Slot> slotFor(const QByteArray& key);
+
+    qint64 m_minUploadBytes;
+    QMutex m_mutex;
+    QHash<QByteArray, std::shared_ptr<Slot>> m_slots;
+    std::atomic<int> m_uploads {0};
+};
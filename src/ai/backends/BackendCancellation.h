@@ -0,0 +1,49 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QString>
+
+#include <cpr/cpr.h>
+
+#include "CancellationToken.h"
+
+// Ties a backend HTTP call to the calling node's run. libcurl invokes the progress
+// callback while waiting for the first byte as well as during transfers (at least
+// about once a second), so a cancelled run aborts its requests promptly instead of
+// waiting out the request timeout.
+namespace BackendCancellation {
+
+inline cpr::ProgressCallback progressCallback(const CancellationToken& token)
+{
+    return cpr::ProgressCallback([token](cpr::cpr_pf_arg_t, cpr::cpr_pf_arg_t, cpr::cpr_pf_arg_t,
+                                         cpr::cpr_pf_arg_t, intptr_t) { return !token.isCancelled(); });
+}
+
+inline QString message()
+{
+    return QStringLiteral("Request cancelled");
+}
+
+} // namespace BackendCancellation
@@ -0,0 +1,180 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QString>
+
+#include <cpr/cpr.h>
+
+#include <chrono>
+
+#include "CancellationToken.h"
+#include "Logger.h"
+#include "RetryPolicy.h"
+#include "Tracer.h"
+#include "ai/backends/ILLMBackend.h"
+#include "ai/registry/LLMProviderRegistry.h"
+
+// Sends a backend request through the provider's shared limiters. The call
+// first waits for an in-flight slot from the adaptive concurrency limit for the
+// provider and model, then for budget in the provider's rate-limit queue. Each
+// attempt's latency and outcome feed the concurrency limit. On HTTP 429 it holds
+// the queue until Retry-After, then waits for new budget and sends again, up to
+// kMaxAttempts times, so other requests queue behind it instead of adding to the
+// rejections. When the engine retries the calling node (RetryPolicy::current()), the
+// queue is still held but the 429 comes back at once, so no thread waits it out. When cancelled while waiting, it returns a response whose error is
+// ABORTED_BY_CALLBACK, as if libcurl had aborted the transfer. The permit is
+// returned so that the caller can settle() it with the tokens the provider
+// reports. With tracing on, the whole call is one span holding the provider,
+// model, time spent waiting for the limiters and the number of attempts; each
+// attempt's HTTP request is a child span.
+namespace BackendRateLimit {
+
+constexpr int kMaxAttempts = 4;
+
+// Retry-After (or OpenAI's retry-after-ms) in milliseconds, else 1s, 2s, 4s...
+inline int retryAfterMs(const cpr::Response& response, int attempt)
+{
+    bool ok = false;
+    const auto ms = response.header.find("retry-after-ms");
+    if (ms != response.header.end()) {
+        const double value = QString::fromStdString(ms->second).toDouble(&ok);
+        if (ok && value >= 0) return static_cast<int>(value);
+    }
+    const auto seconds = response.header.find("retry-after");
+    if (seconds != response.header.end()) {
+        const double value = QString::fromStdString(seconds->second).toDouble(&ok);
+        if (ok && value >= 0) return static_cast<int>(value * 1000);
+    }
+    return 1000 << qMin(attempt - 1, 5);
+}
+
+// Marks failures another attempt may not meet again: timeouts, 429s and 5xx answers,
+// with the provider's Retry-After when it sent one (see RetryPolicy)
+inline void markTransient(LLMResult& result, const cpr::Response& response)
+{
+    if (response.error) {
+        result.transient = response.error.code == cpr::ErrorCode::OPERATION_TIMEDOUT;
+        return;
+    }
+    result.transient = response.status_code == 429 || response.status_code >= 500;
+    if (response.status_code == 429) {
+        const bool hinted = response.header.find("retry-after-ms") != response.header.end()
+                            || response.header.find("retry-after") != response.header.end();
+        result.retryAfterMs = hinted ? retryAfterMs(response, 1) : 0;
+    }
+}
+
+// 429s, 5xx answers and timeouts mean the provider is saturated
+inline AdaptiveConcurrencyLimiter::Outcome outcomeOf(const cpr::Response& response,
+                                                     const CancellationToken& cancellation)
+{
+    using Outcome = AdaptiveConcurrencyLimiter::Outcome;
+    if (cancellation.isCancelled()) return Outcome::Ignored;
+    if (response.error) {
+        return response.error.code == cpr::ErrorCode::OPERATION_TIMEDOUT ? Outcome::Throttled : Outcome::Ignored;
+    }
+    if (response.status_code == 429 || response.status_code >= 500) return Outcome::Throttled;
+    return response.status_code >= 200 && response.status_code < 300 ? Outcome::Success : Outcome::Ignored;
+}
+
+inline cpr::Response cancelledResponse()
+{
+    cpr::Response response;
+    response.error.code = cpr::ErrorCode::ABORTED_BY_CALLBACK;
+    response.error.message = "Request cancelled while waiting for the provider";
+    return response;
+}
+
+template <typename Send>
+cpr::Response send(ProviderRateLimiter::Permit& permit,
+                   const QString& providerId,
+                   const QString& modelId,
+                   int estimatedTokens,
+                   const CancellationToken& cancellation,
+                   Send&& sendRequest)
+{
+    Tracer::Span span = Tracer::instance().startSpan(QStringLiteral("%1 request").arg(providerId));
+    const Tracer::Scope tracingScope(span);
+    span.setAttribute(QStringLiteral("gen_ai.provider.name"), providerId);
+    span.setAttribute(QStringLiteral("gen_ai.request.model"), modelId);
+    if (estimatedTokens > 0) span.setAttribute(QStringLiteral("cp.llm.estimated_tokens"), estimatedTokens);
+    const auto waitStarted = AdaptiveConcurrencyLimiter::Clock::now();
+    const auto cancelled = [&] {
+        span.setError(QStringLiteral("cancelled"));
+        return cancelledResponse();
+    };
+
+    LLMProviderRegistry& registry = LLMProviderRegistry::instance();
+    AdaptiveConcurrencyLimiter::Slot slot = registry.concurrencyLimiter().acquire(providerId, modelId,
+                                                                                  cancellation);
+    if (!slot) {
+        return cancelled();
+    }
+    permit = registry.rateLimiter().acquire(providerId, modelId, estimatedTokens, cancellation);
+    if (!permit) {
+        return cancelled();
+    }
+    span.setAttribute(QStringLiteral("cp.llm.queue_wait_ms"),
+                      static_cast<qint64>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                              AdaptiveConcurrencyLimiter::Clock::now() - waitStarted)
+                                              .count()));
+
+    const auto attempt = [&] {
+        const auto started = AdaptiveConcurrencyLimiter::Clock::now();
+        cpr::Response response = sendRequest();
+        slot.record(
+            outcomeOf(response, cancellation),
+            std::chrono::duration_cast<std::chrono::milliseconds>(AdaptiveConcurrencyLimiter::Clock::now() - started));
+        return response;
+    };
+
+    cpr::Response response = attempt();
+    int attempts = 1;
+    for (int retry = 1; response.status_code == 429 && retry < kMaxAttempts; ++retry) {
+        const int waitMs = retryAfterMs(response, retry);
+        if (RetryPolicy::current()) {
+            CP_WARN.noquote() << QStringLiteral("BackendRateLimit: provider=%1 model=%2 rate limited, the engine retries")
+                                     .arg(providerId, modelId);
+            permit.reject(waitMs);
+            break;
+        }
+        CP_WARN.noquote() << QStringLiteral("BackendRateLimit: provider=%1 model=%2 rate limited, retrying in %3 ms")
+                                 .arg(providerId, modelId)
+                                 .arg(waitMs);
+        if (!permit.retryAfter(waitMs, cancellation)) {
+            return cancelled();
+        }
+        response = attempt();
+        ++attempts;
+    }
+    span.setAttribute(QStringLiteral("cp.llm.attempts"), attempts);
+    if (response.error || response.status_code >= 400) {
+        span.setError(response.error ? QString::fromStdString(response.error.message)
+                                     : QStringLiteral("HTTP %1").arg(response.status_code));
+    }
+    return response;
+}
+
+} // namespace BackendRateLimit
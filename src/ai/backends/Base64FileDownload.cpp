@@ -0,0 +1,211 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "Base64FileDownload.h"
+
+#include <QDir>
+#include <QFileInfo>
+
+#include <utility>
+
+namespace {
+
+// Encoded characters decoded per write; a multiple of four
+constexpr qsizetype kDecodeSlice = 256 * 1024;
+
+bool isJsonSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+} // namespace
+
+Base64FileDownload::Base64FileDownload(const QString& filePath, QByteArray fieldName)
+    : m_filePath(filePath)
+    , m_fieldName(QString::fromLatin1(fieldName))
+    , m_needle('"' + fieldName + '"')
+    , m_file(filePath)
+{
+}
+
+cpr::WriteCallback Base64FileDownload::writeCallback()
+{
+    return cpr::WriteCallback([this](std::string_view data, intptr_t) {
+        return feed(data);
+    });
+}
+
+bool Base64FileDownload::feed(std::string_view data)
+{
+    if (m_state == State::Failed) {
+        return false;
+    }
+    consume(data);
+    return m_state != State::Failed;
+}
+
+void Base64FileDownload::consume(std::string_view data)
+{
+    while (!data.empty()) {
+        switch (m_state) {
+        case State::SeekingField: {
+            m_raw.append(data);
+            data = {};
+            const std::string_view needle(m_needle.constData(), static_cast<std::size_t>(m_needle.size()));
+            const std::size_t found = m_raw.find(needle, m_searchFrom);
+            if (found == std::string::npos) {
+                // The name may straddle the next chunk
+                m_searchFrom = m_raw.size() >= needle.size() ? m_raw.size() - needle.size() + 1 : 0;
+                return;
+            }
+            const std::size_t end = found + needle.size();
+            const std::string rest = m_raw.substr(end);
+            m_raw.resize(end);
+            m_state = State::SeekingColon;
+            m_foundField = true;
+            consume(rest);
+            return;
+        }
+        case State::SeekingColon:
+        case State::SeekingQuote: {
+            const char c = data.front();
+            data.remove_prefix(1);
+            m_raw.push_back(c);
+            if (isJsonSpace(c)) {
+                break;
+            }
+            if (m_state == State::SeekingColon && c == ':') {
+                m_state = State::SeekingQuote;
+            } else if (m_state == State::SeekingQuote && c == '"') {
+                QDir().mkpath(QFileInfo(m_filePath).absolutePath());
+                if (!m_file.open(QIODevice::WriteOnly)) {
+                    fail(QStringLiteral("Failed to open %1: %2").arg(m_filePath, m_file.errorString()));
+                    return;
+                }
+                m_state = State::InValue;
+            } else {
+                // The name was text inside some other string, not a key
+                m_state = State::SeekingField;
+                m_foundField = false;
+                m_searchFrom = m_raw.size();
+            }
+            break;
+        }
+        case State::InValue: {
+            if (m_escaped) {
+                // "\/" is the only escape a JSON encoder gives base64; "\n" wraps lines
+                const char c = data.front();
+                data.remove_prefix(1);
+                m_escaped = false;
+                if (c != 'n' && c != 'r') {
+                    m_encoded.append(c);
+                }
+                break;
+            }
+            const std::size_t special = data.find_first_of("\\\"");
+            const std::string_view run = data.substr(0, special);
+            m_encoded.append(run.data(), static_cast<qsizetype>(run.size()));
+            if (m_encoded.size() >= kDecodeSlice && !flushDecoded(false)) {
+                return;
+            }
+            if (special == std::string_view::npos) {
+                return;
+            }
+            const char c = data[special];
+            data.remove_prefix(special + 1);
+            if (c == '\\') {
+                m_escaped = true;
+            } else {
+                if (!flushDecoded(true)) {
+                    return;
+                }
+                m_raw.push_back('"');
+                m_state = State::Done;
+            }
+            break;
+        }
+        case State::Done:
+            m_raw.append(data);
+            return;
+        case State::Failed:
+            return;
+        }
+    }
+}
+
+bool Base64FileDownload::flushDecoded(bool final)
+{
+    const qsizetype length = final ? m_encoded.size() : m_encoded.size() / 4 * 4;
+    if (length == 0) {
+        return true;
+    }
+    auto decoded = QByteArray::fromBase64Encoding(m_encoded.first(length),
+                                                  QByteArray::AbortOnBase64DecodingErrors);
+    if (!decoded) {
+        fail(QStringLiteral("Invalid base64 in the \"%1\" field").arg(m_fieldName));
+        return false;
+    }
+    if (m_file.write(*decoded) != decoded->size()) {
+        fail(QStringLiteral("Failed to write %1: %2").arg(m_filePath, m_file.errorString()));
+        return false;
+    }
+    m_bytesWritten += decoded->size();
+    m_encoded.remove(0, length);
+    return true;
+}
+
+bool Base64FileDownload::finish()
+{
+    if (m_state == State::Done) {
+        if (m_bytesWritten == 0) {
+            fail(QStringLiteral("The \"%1\" field is empty").arg(m_fieldName));
+            return false;
+        }
+        if (!m_file.commit()) {
+            fail(QStringLiteral("Failed to save %1: %2").arg(m_filePath, m_file.errorString()));
+            return false;
+        }
+        return true;
+    }
+    if (m_state == State::InValue) {
+        fail(QStringLiteral("The response ended inside the \"%1\" field")
+                 .arg(m_fieldName));
+    } else if (m_state != State::Failed) {
+        // Not an error of its own: the body is usually an API error in raw()
+        m_state = State::Failed;
+    }
+    return false;
+}
+
+void Base64FileDownload::fail(const QString& message)
+{
+    if (m_error.isEmpty()) {
+        m_error = message;
+    }
+    m_state = State::Failed;
+    if (m_file.isOpen()) {
+        m_file.cancelWriting();
+        m_file.commit();
+    }
+    m_encoded.clear();
+}
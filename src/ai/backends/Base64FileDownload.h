@@ -0,0 +1,84 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QSaveFile>
+#include <QString>
+
+#include <cpr/cpr.h>
+
+#include <string>
+#include <string_view>
+
+// Decodes one base64 string field of a JSON response straight into a file while the
+// body downloads. Pass writeCallback() to the request: the first value of the field
+// is decoded a slice at a time and written through a QSaveFile, so the image never
+// sits in memory whole, in either form. Everything else in the body is kept in raw()
+// with the value left empty, which stays valid JSON for reading errors or the other
+// fields. JSON escapes inside the value (a "\/" for "/") are undone on the way.
+class Base64FileDownload {
+public:
+    explicit Base64FileDownload(const QString& filePath, QByteArray fieldName = QByteArrayLiteral("b64_json"));
+
+    cpr::WriteCallback writeCallback();
+    // Returns false once a write to the file has failed
+    bool feed(std::string_view data);
+    // Writes what is left and commits the file. False when the field never ended or
+    // a write failed; nothing is left at filePath() then.
+    bool finish();
+
+    bool foundField() const { return m_foundField; }
+    qint64 bytesWritten() const { return m_bytesWritten; }
+    const std::string& raw() const { return m_raw; }
+    QString filePath() const { return m_filePath; }
+    QString errorString() const { return m_error; }
+
+private:
+    enum class State {
+        SeekingField,
+        SeekingColon,
+        SeekingQuote,
+        InValue,
+        Done,
+        Failed
+    };
+
+    void consume(std::string_view data);
+    bool flushDecoded(bool final);
+    void fail(const QString& message);
+
+    QString m_filePath;
+    QString m_fieldName;
+    QByteArray m_needle;
+    State m_state{State::SeekingField};
+    std::string m_raw;
+    std::size_t m_searchFrom{0};
+    bool m_foundField{false};
+    bool m_escaped{false};
+    QByteArray m_encoded;
+    QSaveFile m_file;
+    qint64 m_bytesWritten{0};
+    QString m_error;
+};
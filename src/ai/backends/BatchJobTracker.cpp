@@ -0,0 +1,327 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "BatchJobTracker.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "BackendCancellation.h"
+#include "Logger.h"
+
+namespace {
+
+// How often waiting callers are checked for cancellation between deadlines
+constexpr auto kCancellationCheck = std::chrono::milliseconds(250);
+
+using Resolution = std::pair<std::shared_ptr<QPromise<LLMResult>>, LLMResult>;
+
+void resolveAll(std::vector<Resolution>& resolutions)
+{
+    for (auto& [promise, result] : resolutions) {
+        promise->addResult(result);
+        promise->finish();
+    }
+    resolutions.clear();
+}
+
+} // namespace
+
+BatchJobTracker::BatchJobTracker(int collectWindowMs, int pollIntervalMs)
+    : m_collectWindow(std::chrono::milliseconds(collectWindowMs))
+    , m_pollInterval(std::chrono::milliseconds(pollIntervalMs))
+{
+    m_worker = std::thread([this] { run(); });
+}
+
+BatchJobTracker::~BatchJobTracker()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_changed.notify_all();
+    m_worker.join();
+
+    // Jobs keep running at the provider, but nobody can collect their answers now
+    std::vector<Resolution> resolutions;
+    const LLMResult stopped = errorResult(QStringLiteral("Batch job tracker stopped before the job ended"));
+    for (auto& [key, group] : m_groups) {
+        for (auto& waiter : group.waiters) {
+            resolutions.emplace_back(waiter.promise, stopped);
+        }
+    }
+    for (auto& job : m_jobs) {
+        for (auto& [id, waiter] : job.waiters) {
+            resolutions.emplace_back(waiter.promise, stopped);
+        }
+    }
+    resolveAll(resolutions);
+}
+
+BatchJobTracker& BatchJobTracker::shared()
+{
+    static BatchJobTracker tracker;
+    return tracker;
+}
+
+QFuture<LLMResult> BatchJobTracker::submit(ILLMBackend* backend,
+                                           const QString& apiKey,
+                                           LLMBatchRequest request,
+                                           const CancellationToken& cancellation)
+{
+    auto promise = std::make_shared<QPromise<LLMResult>>();
+    promise->start();
+    QFuture<LLMResult> future = promise->future();
+
+    if (!backend || !backend->supportsBatch()) {
+        promise->addResult(errorResult(QStringLiteral("Provider '%1' does not support batch jobs")
+                                           .arg(backend ? backend->id() : QString())));
+        promise->finish();
+        return future;
+    }
+
+    // Jobs hold one model each, as OpenAI requires
+    const QString key = QString::number(reinterpret_cast<quintptr>(backend)) + QLatin1Char('\n')
+                        + request.modelName + QLatin1Char('\n') + apiKey;
+    bool full = false;
+    {
+        std::lock_guard lock(m_mutex);
+        request.customId = QStringLiteral("cp-%1").arg(m_nextId++);
+        Group& group = m_groups[key];
+        group.backend = backend;
+        group.apiKey = apiKey;
+        group.lastJoined = Clock::now();
+        group.waiters.push_back(Waiter{std::move(request), cancellation, promise});
+        full = group.waiters.size() >= static_cast<size_t>(kMaxRequestsPerJob);
+    }
+    if (full) {
+        m_changed.notify_all();
+    }
+    return future;
+}
+
+int BatchJobTracker::pendingRequests() const
+{
+    std::lock_guard lock(m_mutex);
+    size_t count = 0;
+    for (const auto& [key, group] : m_groups) {
+        count += group.waiters.size();
+    }
+    return static_cast<int>(count);
+}
+
+int BatchJobTracker::activeJobs() const
+{
+    std::lock_guard lock(m_mutex);
+    return static_cast<int>(m_jobs.size());
+}
+
+void BatchJobTracker::run()
+{
+    std::vector<Resolution> resolutions;
+    std::unique_lock lock(m_mutex);
+    while (!m_stopping) {
+        const auto now = Clock::now();
+
+        // Cancelled callers are answered at once, whether or not their job was submitted
+        const LLMResult cancelled = errorResult(BackendCancellation::message());
+        for (auto it = m_groups.begin(); it != m_groups.end();) {
+            auto& waiters = it->second.waiters;
+            for (auto waiter = waiters.begin(); waiter != waiters.end();) {
+                if (waiter->cancellation.isCancelled()) {
+                    resolutions.emplace_back(waiter->promise, cancelled);
+                    waiter = waiters.erase(waiter);
+                } else {
+                    ++waiter;
+                }
+            }
+            it = waiters.empty() ? m_groups.erase(it) : std::next(it);
+        }
+        std::vector<Job> abandoned;
+        for (auto job = m_jobs.begin(); job != m_jobs.end();) {
+            for (auto waiter = job->waiters.begin(); waiter != job->waiters.end();) {
+                if (waiter->second.cancellation.isCancelled()) {
+                    resolutions.emplace_back(waiter->second.promise, cancelled);
+                    waiter = job->waiters.erase(waiter);
+                } else {
+                    ++waiter;
+                }
+            }
+            if (job->waiters.empty()) {
+                abandoned.push_back(std::move(*job));
+                job = m_jobs.erase(job);
+            } else {
+                ++job;
+            }
+        }
+        if (!resolutions.empty() || !abandoned.empty()) {
+            lock.unlock();
+            resolveAll(resolutions);
+            for (const Job& job : abandoned) {
+                CP_LOG << "BatchJobTracker: cancelling abandoned batch job" << job.jobId;
+                job.backend->cancelBatch(job.apiKey, job.jobId);
+            }
+            lock.lock();
+            continue;
+        }
+
+        // A group is submitted when full, or once nothing has joined it for the window
+        auto ready = std::find_if(m_groups.begin(), m_groups.end(), [&](const auto& entry) {
+            return entry.second.waiters.size() >= static_cast<size_t>(kMaxRequestsPerJob)
+                   || now - entry.second.lastJoined >= m_collectWindow;
+        });
+        if (ready != m_groups.end()) {
+            Group group;
+            group.backend = ready->second.backend;
+            group.apiKey = ready->second.apiKey;
+            auto& waiters = ready->second.waiters;
+            const auto count = std::min(waiters.size(), static_cast<size_t>(kMaxRequestsPerJob));
+            group.waiters.splice(group.waiters.begin(), waiters, waiters.begin(),
+                                 std::next(waiters.begin(), static_cast<std::ptrdiff_t>(count)));
+            if (waiters.empty()) {
+                m_groups.erase(ready);
+            }
+            lock.unlock();
+            submitGroup(std::move(group));
+            lock.lock();
+            continue;
+        }
+
+        auto due = std::find_if(m_jobs.begin(), m_jobs.end(), [&](const Job& job) { return job.nextPoll <= now; });
+        if (due != m_jobs.end()) {
+            pollJob(lock, due);
+            continue;
+        }
+
+        auto wake = now + kCancellationCheck;
+        for (const auto& [key, group] : m_groups) {
+            wake = std::min(wake, group.lastJoined + m_collectWindow);
+        }
+        for (const Job& job : m_jobs) {
+            wake = std::min(wake, job.nextPoll);
+        }
+        m_changed.wait_until(lock, wake);
+    }
+}
+
+void BatchJobTracker::submitGroup(Group group)
+{
+    QList<LLMBatchRequest> requests;
+    requests.reserve(static_cast<qsizetype>(group.waiters.size()));
+    for (const Waiter& waiter : group.waiters) {
+        requests.append(waiter.request);
+    }
+
+    const LLMBatchStatus status = group.backend->submitBatch(group.apiKey, requests);
+
+    // Requests the backend answered up front (they could not be sent) are resolved now
+    std::vector<Resolution> resolutions;
+    for (auto waiter = group.waiters.begin(); waiter != group.waiters.end();) {
+        const auto answered = status.results.constFind(waiter->request.customId);
+        if (answered != status.results.constEnd()) {
+            resolutions.emplace_back(waiter->promise, answered.value());
+            waiter = group.waiters.erase(waiter);
+        } else {
+            ++waiter;
+        }
+    }
+    if (group.waiters.empty()) {
+        resolveAll(resolutions);
+        return;
+    }
+
+    if (status.hasError || status.jobId.isEmpty()) {
+        const QString message = status.errorMsg.isEmpty() ? QStringLiteral("Batch job was not accepted")
+                                                           : status.errorMsg;
+        CP_WARN << "BatchJobTracker: submitting" << requests.size() << "requests to"
+                << group.backend->id() << "failed:" << message;
+        for (const Waiter& waiter : group.waiters) {
+            resolutions.emplace_back(waiter.promise, errorResult(message));
+        }
+        resolveAll(resolutions);
+        return;
+    }
+    resolveAll(resolutions);
+
+    CP_LOG << "BatchJobTracker: submitted" << group.waiters.size() << "requests to" << group.backend->id()
+           << "as batch job" << status.jobId;
+    Job job;
+    job.backend = group.backend;
+    job.apiKey = group.apiKey;
+    job.jobId = status.jobId;
+    job.nextPoll = Clock::now() + m_pollInterval;
+    for (Waiter& waiter : group.waiters) {
+        const QString id = waiter.request.customId;
+        // The request is no longer needed once submitted; drop its attachments
+        waiter.request = LLMBatchRequest{};
+        job.waiters.emplace(id, std::move(waiter));
+    }
+
+    std::lock_guard lock(m_mutex);
+    m_jobs.push_back(std::move(job));
+}
+
+void BatchJobTracker::pollJob(std::unique_lock<std::mutex>& lock, std::list<Job>::iterator job)
+{
+    // Only the worker thread adds or removes jobs, so the iterator survives the unlock
+    ILLMBackend* backend = job->backend;
+    const QString apiKey = job->apiKey;
+    const QString jobId = job->jobId;
+    lock.unlock();
+    const LLMBatchStatus status = backend->pollBatch(apiKey, jobId);
+    lock.lock();
+
+    if (!status.finished && !status.hasError) {
+        job->nextPoll = Clock::now() + m_pollInterval;
+        return;
+    }
+
+    std::vector<Resolution> resolutions;
+    const LLMResult missing = errorResult(status.hasError
+                                              ? status.errorMsg
+                                              : QStringLiteral("Batch job %1 ended without an answer for this request")
+                                                    .arg(jobId));
+    for (auto& [id, waiter] : job->waiters) {
+        const auto found = status.results.constFind(id);
+        resolutions.emplace_back(waiter.promise,
+                                 found != status.results.constEnd() && !status.hasError ? found.value() : missing);
+    }
+    CP_LOG << "BatchJobTracker: batch job" << jobId << (status.hasError ? "failed:" : "ended with")
+           << (status.hasError ? status.errorMsg : QString::number(status.results.size()) + QStringLiteral(" results"));
+    m_jobs.erase(job);
+
+    lock.unlock();
+    resolveAll(resolutions);
+    lock.lock();
+}
+
+LLMResult BatchJobTracker::errorResult(const QString& message)
+{
+    LLMResult result;
+    result.hasError = true;
+    result.errorMsg = message;
+    result.content = message;
+    return result;
+}
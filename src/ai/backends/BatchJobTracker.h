@@ -0,0 +1,119 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QFuture>
+#include <QPromise>
+#include <QString>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "CancellationToken.h"
+#include "ai/backends/ILLMBackend.h"
+
+// Collects prompts bound for a provider's batch endpoint into jobs, submits them,
+// polls until they end and hands each waiting caller its own answer.
+//
+// Requests are grouped by backend, API key and model. A group is submitted as one
+// job once no request has joined it for collectWindow, or as soon as it holds
+// kMaxRequestsPerJob, so a fan-out that queues its items together lands in a
+// single job. Submitted jobs are polled every pollInterval. Submitting and polling
+// run on the tracker's own thread; callers only hold a future, so an asynchronous
+// node waiting on a job for hours occupies no worker thread. A caller whose run
+// is cancelled gets a cancellation error straight away; when nobody is left
+// waiting on a job it is cancelled at the provider.
+class BatchJobTracker {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr int kDefaultCollectWindowMs = 2000;
+    static constexpr int kDefaultPollIntervalMs = 30000;
+    static constexpr int kMaxRequestsPerJob = 10000;
+
+    explicit BatchJobTracker(int collectWindowMs = kDefaultCollectWindowMs,
+                             int pollIntervalMs = kDefaultPollIntervalMs);
+    ~BatchJobTracker();
+    BatchJobTracker(const BatchJobTracker&) = delete;
+    BatchJobTracker& operator=(const BatchJobTracker&) = delete;
+
+    static BatchJobTracker& shared();
+
+    // Queues the request for the backend's next job. The backend must outlive the
+    // future; customId is assigned here.
+    QFuture<LLMResult> submit(ILLMBackend* backend,
+                              const QString& apiKey,
+                              LLMBatchRequest request,
+                              const CancellationToken& cancellation = CancellationToken::current());
+
+    // Requests not yet submitted, and jobs submitted but not yet ended
+    int pendingRequests() const;
+    int activeJobs() const;
+
+private:
+    struct Waiter {
+        LLMBatchRequest request;
+        CancellationToken cancellation;
+        std::shared_ptr<QPromise<LLMResult>> promise;
+    };
+
+    struct Group {
+        ILLMBackend* backend = nullptr;
+        QString apiKey;
+        std::list<Waiter> waiters;
+        Clock::time_point lastJoined;
+    };
+
+    struct Job {
+        ILLMBackend* backend = nullptr;
+        QString apiKey;
+        QString jobId;
+        std::map<QString, Waiter> waiters;
+        Clock::time_point nextPoll;
+    };
+
+    void run();
+    // Called without the lock; adds the job, or fails every waiter when not accepted
+    void submitGroup(Group group);
+    // Called with the lock held, released while the provider is asked
+    void pollJob(std::unique_lock<std::mutex>& lock, std::list<Job>::iterator job);
+    static LLMResult errorResult(const QString& message);
+
+    const Clock::duration m_collectWindow;
+    const Clock::duration m_pollInterval;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::map<QString, Group> m_groups;
+    std::list<Job> m_jobs;
+    std::uint64_t m_nextId = 0;
+    bool m_stopping = false;
+    std::thread m_worker;
+};
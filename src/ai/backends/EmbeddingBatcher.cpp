@@ -0,0 +1,209 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "EmbeddingBatcher.h"
+#include "MetricsRegistry.h"
+
+#include <QDeadlineTimer>
+#include <QHash>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// Coalescing batchers kept for keys nobody is embedding with before they are dropped
+constexpr int kMaxIdleCoalesceKeys = 64;
+
+std::shared_ptr<EmbeddingBatcher> coalescingBatcher(const QString& key, int maxTexts)
+{
+    static QMutex mutex;
+    static QHash<QString, std::shared_ptr<EmbeddingBatcher>> batchers;
+    QMutexLocker locker(&mutex);
+    if (const auto it = batchers.constFind(key); it != batchers.constEnd()) {
+        return it.value();
+    }
+    if (batchers.size() >= kMaxIdleCoalesceKeys) {
+        // Only this table holds a batcher nobody is waiting in
+        for (auto it = batchers.begin(); it != batchers.end();) {
+            it = it.value().use_count() == 1 ? batchers.erase(it) : std::next(it);
+        }
+    }
+    auto batcher = std::make_shared<EmbeddingBatcher>(maxTexts, EmbeddingBatcher::kCoalesceWindowMs, true);
+    batchers.insert(key, batcher);
+    return batcher;
+}
+
+} // namespace
+
+EmbeddingBatcher::EmbeddingBatcher(int maxTexts, int windowMs, bool overlapBatches)
+    : m_maxTexts(std::max(1, maxTexts))
+    , m_windowMs(std::max(0, windowMs))
+    , m_overlapBatches(overlapBatches)
+{
+}
+
+EmbeddingBatchResult EmbeddingBatcher::coalesce(const QString& key, const QStringList& texts, int maxTexts,
+                                                const Run& run)
+{
+    if (texts.isEmpty() || texts.size() >= kCoalesceBelowTexts) {
+        return run(texts);
+    }
+    return coalescingBatcher(key, maxTexts)->embed(texts, run);
+}
+
+QString EmbeddingBatcher::coalesceKey(const QString& providerId, const QString& modelId, int dimensions,
+                                      const QString& apiKey)
+{
+    return QStringList{providerId, modelId, QString::number(dimensions), apiKey}.join(u'\n');
+}
+
+EmbeddingResult EmbeddingBatcher::firstOf(EmbeddingBatchResult batch)
+{
+    EmbeddingResult result;
+    result.usage = batch.usage;
+    result.hasError = batch.hasError;
+    result.errorMsg = batch.errorMsg;
+    if (!batch.hasError && !batch.vectors.empty()) {
+        result.vector = std::move(batch.vectors.front());
+    }
+    return result;
+}
+
+EmbeddingBatchResult EmbeddingBatcher::batchOf(EmbeddingResult single)
+{
+    EmbeddingBatchResult result;
+    result.usage = single.usage;
+    result.hasError = single.hasError;
+    result.errorMsg = single.errorMsg;
+    if (!single.hasError) {
+        result.vectors.push_back(std::move(single.vector));
+    }
+    return result;
+}
+
+EmbeddingBatchResult EmbeddingBatcher::embed(const QStringList& texts, const Run& run)
+{
+    if (texts.isEmpty()) {
+        return {};
+    }
+
+    Request request;
+    request.texts = &texts;
+    QMutexLocker locker(&m_mutex);
+    m_queue.push_back(&request);
+    m_queuedTexts += texts.size();
+    m_queued.wakeAll();
+    while (!request.done) {
+        if (m_running || request.taken) {
+            m_finished.wait(&m_mutex);
+        } else {
+            runBatch(locker, run);
+        }
+    }
+    return std::move(request.result);
+}
+
+qsizetype EmbeddingBatcher::queuedTexts() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_queuedTexts;
+}
+
+void EmbeddingBatcher::runBatch(QMutexLocker<QMutex>& locker, const Run& run)
+{
+    m_running = true;
+
+    // Give concurrent callers the window to join, unless the batch is already full
+    const QDeadlineTimer window(m_windowMs);
+    while (m_queuedTexts < m_maxTexts && !window.hasExpired()) {
+        m_queued.wait(&m_mutex, window);
+    }
+
+    // The first request always goes, even when it alone is over the limit
+    std::vector<Request*> batch;
+    QStringList texts;
+    while (!m_queue.empty()
+           && (batch.empty() || texts.size() + m_queue.front()->texts->size() <= m_maxTexts)) {
+        Request* next = m_queue.front();
+        m_queue.pop_front();
+        m_queuedTexts -= next->texts->size();
+        next->taken = true;
+        texts += *next->texts;
+        batch.push_back(next);
+    }
+
+    if (m_overlapBatches) {
+        // The queue is free for the next leader while this batch is out
+        m_running = false;
+        m_finished.wakeAll();
+    }
+    locker.unlock();
+    if (m_overlapBatches) {
+        MetricsRegistry::instance()
+            .histogram(QStringLiteral("cp_embedding_coalesced_texts"),
+                       QStringLiteral("Texts per merged embedding request to a hosted provider"))
+            .observe(static_cast<double>(texts.size()));
+    } else {
+        MetricsRegistry::instance()
+            .histogram(QStringLiteral("cp_embedding_batch_texts"),
+                       QStringLiteral("Texts per locally run embedding batch"))
+            .observe(static_cast<double>(texts.size()));
+    }
+    EmbeddingBatchResult merged;
+    try {
+        merged = run(texts);
+    } catch (...) {
+        merged = {};
+        merged.hasError = true;
+        merged.errorMsg = QStringLiteral("Embedding batch failed with an exception");
+    }
+    if (!merged.hasError && merged.vectors.size() != static_cast<size_t>(texts.size())) {
+        merged.hasError = true;
+        merged.errorMsg = QStringLiteral("Embedding batch returned %1 vectors for %2 texts")
+                              .arg(static_cast<qulonglong>(merged.vectors.size()))
+                              .arg(texts.size());
+    }
+    locker.relock();
+
+    size_t offset = 0;
+    for (Request* request : batch) {
+        const qsizetype count = request->texts->size();
+        EmbeddingBatchResult& result = request->result;
+        result.hasError = merged.hasError;
+        result.errorMsg = merged.errorMsg;
+        if (!merged.hasError) {
+            result.vectors.assign(std::make_move_iterator(merged.vectors.begin() + offset),
+                                  std::make_move_iterator(merged.vectors.begin() + offset + count));
+            result.usage.inputTokens = static_cast<int>(
+                static_cast<qint64>(merged.usage.inputTokens) * count / texts.size());
+            result.usage.totalTokens = result.usage.inputTokens;
+        }
+        offset += static_cast<size_t>(count);
+        request->done = true;
+    }
+    if (!m_overlapBatches) {
+        m_running = false;
+    }
+    m_finished.wakeAll();
+}
@@ -0,0 +1,99 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include "ILLMBackend.h"
+
+#include <QMutex>
+#include <QStringList>
+#include <QWaitCondition>
+
+#include <deque>
+#include <functional>
+#include <memory>
+
+// Merges the texts of concurrent embedding calls into shared batches for backends
+// that run the model themselves, where one pass over a full batch costs little more
+// than a pass over a single text. A caller finding no batch running leads one: it
+// waits up to the batch window for other callers to queue, takes queued requests in
+// arrival order up to maxTexts texts, runs them at once and hands each caller its
+// own vectors. Callers arriving while a batch runs queue for the next one. The
+// batch's token usage is split between its callers by text count.
+//
+// Hosted backends use the same merging for small calls (coalesce()): single-text
+// queries from parallel scope bodies or several RAG nodes leave as one request.
+// Those batchers overlap their batches, since a provider serves several requests
+// at once: the next leader starts collecting as soon as the previous batch is sent.
+class EmbeddingBatcher {
+public:
+    using Run = std::function<EmbeddingBatchResult(const QStringList& texts)>;
+
+    // Calls with fewer texts than this are merged by coalesce(); larger ones already are a batch
+    static constexpr int kCoalesceBelowTexts = 16;
+    static constexpr int kCoalesceWindowMs = 5;
+
+    EmbeddingBatcher(int maxTexts, int windowMs, bool overlapBatches = false);
+
+    // Returns one vector per text, in order, or the error of the batch they ran in
+    EmbeddingBatchResult embed(const QStringList& texts, const Run& run);
+
+    /**
+     * Merges a small call with concurrent ones that share @p key, which must name
+     * everything the request depends on (see coalesceKey()), and runs the merged
+     * texts through @p run, at most @p maxTexts at a time. The batch goes out
+     * under the leading caller's cancellation token. Calls of
+     * kCoalesceBelowTexts or more texts go straight to @p run.
+     */
+    static EmbeddingBatchResult coalesce(const QString& key, const QStringList& texts, int maxTexts, const Run& run);
+    static QString coalesceKey(const QString& providerId, const QString& modelId, int dimensions,
+                               const QString& apiKey);
+
+    // Conversions for backends whose single and batch calls share a batcher
+    static EmbeddingResult firstOf(EmbeddingBatchResult batch);
+    static EmbeddingBatchResult batchOf(EmbeddingResult single);
+
+    // Texts queued for a batch that has not started yet
+    qsizetype queuedTexts() const;
+
+private:
+    struct Request {
+        const QStringList* texts {nullptr};
+        EmbeddingBatchResult result;
+        // In a batch that is running; only overlapping batchers see this before done
+        bool taken {false};
+        bool done {false};
+    };
+
+    void runBatch(QMutexLocker<QMutex>& locker, const Run& run);
+
+    const int m_maxTexts;
+    const int m_windowMs;
+    const bool m_overlapBatches;
+    mutable QMutex m_mutex;
+    QWaitCondition m_queued;
+    QWaitCondition m_finished;
+    std::deque<Request*> m_queue;
+    qsizetype m_queuedTexts {0};
+    bool m_running {false};
+};
@@ -23,19 +23,64 @@
 //
 #include "GoogleBackend.h"
 #include "ai/registry/LLMProviderRegistry.h"
+#include "AttachmentStore.h"
+#include "BackendCancellation.h"
+#include "BackendRateLimit.h"
+#include "EmbeddingBatcher.h"
+#include "HttpConnectionPool.h"
+#include "JsonPayload.h"
+#include "JsonReader.h"
+#include "ProviderEndpoint.h"
+#include "StreamingResponse.h"
 #include "ModelCapsRegistry.h"
 
 #include <cpr/cpr.h>
 #include <QFile>
+#include <QThread>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QJsonDocument>
+#include <QCryptographicHash>
 #include "Logger.h"
 #include "LoggingCategories.h"
 #include <QtConcurrent>
 
 namespace {
 
+// Scheme and host requests go to; see ProviderEndpoint
+std::string apiBase()
+{
+    return ProviderEndpoint::baseUrl(QStringLiteral("google"), "GOOGLE_BASE_URL",
+                                     QStringLiteral("https://generativelanguage.googleapis.com"))
+        .toStdString();
+}
+
+// The File API keeps uploads for 48 hours
+constexpr qint64 kFileApiTtlMs = 48LL * 60 * 60 * 1000;
+
+// Lifetime requested for context caches; AttachmentStore re-creates them when it lapses
+constexpr qint64 kContextCacheTtlMs = 60LL * 60 * 1000;
+
+// Gemini refuses caches below a model-dependent minimum of 1,024 to 4,096 tokens, so
+// shorter prefixes are sent inline instead of spending a create call bound to fail
+constexpr qint64 kMinContextCacheBytes = 4 * 4096;
+
+QByteArray contextCacheKey(const QString& model, const QString& systemPrompt, const QList<LLMAttachment>& attachments)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(QByteArrayView("cachedContents\n"));
+    hash.addData(model.toUtf8());
+    hash.addData(QByteArrayView("\n"));
+    hash.addData(systemPrompt.toUtf8());
+    for (const LLMAttachment& attachment : attachments) {
+        hash.addData(QByteArrayView("\n"));
+        hash.addData(attachment.mimeType.toUtf8());
+        hash.addData(QByteArrayView("\n"));
+        hash.addData(attachment.data);
+    }
+    return hash.result();
+}
+
 QString normalizedGoogleEmbeddingModel(QString modelName)
 {
     QString selectedModel = ModelCapsRegistry::instance()
@@ -139,10 +184,10 @@ QFuture<QStringList> GoogleBackend::fetchModelList()
         }
 
         try {
-            const std::string url = std::string("https://generativelanguage.googleapis.com/v1beta/models?key=")
+            const std::string url = apiBase() + "/v1beta/models?key="
                                     + apiKey.toStdString();
 
-            const auto response = cpr::Get(
+            const auto response = HttpConnectionPool::get(
                 cpr::Url{url},
                 cpr::Header{{"Accept", "application/json"}},
                 cpr::Timeout{60000}
@@ -240,10 +285,10 @@ QFuture<QStringList> GoogleBackend::fetchRawModelList()
         }
 
         try {
-            const std::string url = std::string("https://generativelanguage.googleapis.com/v1beta/models?key=")
+            const std::string url = apiBase() + "/v1beta/models?key="
                                     + apiKey.toStdString();
 
-            const auto response = cpr::Get(
+            const auto response = HttpConnectionPool::get(
                 cpr::Url{url},
                 cpr::Header{{"Accept", "application/json"}},
                 cpr::Timeout{60000}
@@ -301,8 +346,35 @@ LLMResult GoogleBackend::sendPrompt(
     const QString& systemPrompt,
     const QString& userPrompt,
     const LLMMessage& message
+) {
+    return promptRequest(apiKey, modelName, temperature, maxTokens, systemPrompt, userPrompt, message, {});
+}
+
+LLMResult GoogleBackend::streamPrompt(
+    const QString& apiKey,
+    const QString& modelName,
+    double temperature,
+    int maxTokens,
+    const QString& systemPrompt,
+    const QString& userPrompt,
+    const LLMStreamCallback& onDelta,
+    const LLMMessage& message
+) {
+    return promptRequest(apiKey, modelName, temperature, maxTokens, systemPrompt, userPrompt, message, onDelta);
+}
+
+LLMResult GoogleBackend::promptRequest(
+    const QString& apiKey,
+    const QString& modelName,
+    double temperature,
+    int maxTokens,
+    const QString& systemPrompt,
+    const QString& userPrompt,
+    const LLMMessage& message,
+    const LLMStreamCallback& onDelta
 ) {
     LLMResult result;
+    const CancellationToken cancellation = CancellationToken::current();
 
     // Resolve alias to real ID for the API request
     const QString resolvedModel = ModelCapsRegistry::instance().resolveAlias(modelName, id());
@@ -319,18 +391,40 @@ LLMResult GoogleBackend::sendPrompt(
                      ? "disabled (no attachments provided; no model gating)"
                      : "enabled via inline_data (attachments provided; no model gating)");
 
+    // Context caching: the system instruction, and the attachments when asked, go up once
+    // as a cachedContents resource that later requests name instead of resending them
+    const QList<LLMAttachment> cachedAttachments = message.cacheAttachments ? message.attachments : QList<LLMAttachment>();
+    qint64 cachedPrefixBytes = systemPrompt.trimmed().isEmpty() ? 0 : systemPrompt.size();
+    for (const LLMAttachment& attachment : cachedAttachments) {
+        cachedPrefixBytes += attachment.data.size();
+    }
+    QByteArray contextKey;
+    QString cachedContent;
+    int cacheWriteTokens = 0;
+    if ((message.cacheSystemPrompt || message.cacheAttachments) && cachedPrefixBytes >= kMinContextCacheBytes) {
+        contextKey = contextCacheKey(resolvedModel, systemPrompt, cachedAttachments);
+        cachedContent = AttachmentStore::shared().reference(id(), apiKey, contextKey, kContextCacheTtlMs, [&]() {
+            return createCachedContent(apiKey, resolvedModel, systemPrompt, cachedAttachments, cancellation,
+                                       cacheWriteTokens);
+        });
+    }
+    const bool useCachedContent = !cachedContent.isEmpty();
+
     // Google Generative Language (Gemini) endpoint selection:
     // Preview models use v1beta; certain families (e.g., early 1.5, 3.x) may require v1beta.
     // API key is passed as a query parameter, not via Authorization header.
     const bool isPreviewModel = resolvedModel.contains(QStringLiteral("preview"), Qt::CaseInsensitive);
     const bool forceV1beta = resolvedModel.startsWith(QStringLiteral("gemini-1.5-"), Qt::CaseInsensitive)
                            || resolvedModel.startsWith(QStringLiteral("gemini-3-"), Qt::CaseInsensitive);
-    const std::string apiVersion = (isPreviewModel || forceV1beta) ? "v1beta" : "v1";
-    const std::string url = std::string("https://generativelanguage.googleapis.com/")
+    // cachedContent is only accepted by v1beta
+    const std::string apiVersion = (isPreviewModel || forceV1beta || useCachedContent) ? "v1beta" : "v1";
+    // Streaming uses streamGenerateContent with SSE framing
+    const bool streaming = static_cast<bool>(onDelta);
+    const std::string url = apiBase() + "/"
                             + apiVersion
                             + "/models/"
                             + resolvedModel.toStdString()
-                            + ":generateContent?key="
+                            + (streaming ? ":streamGenerateContent?alt=sse&key=" : ":generateContent?key=")
                             + apiKey.toStdString();
 
     // Resolve model caps for capability-driven filtering and role normalization
@@ -351,15 +445,25 @@ LLMResult GoogleBackend::sendPrompt(
     // If RoleMode indicates SystemInstruction, use top-level field instead of a first content entry
     const bool useSystemInstruction = (roleMode == ModelCapsTypes::RoleMode::SystemInstruction);
     QJsonObject systemInstructionObj;
-    if (useSystemInstruction && !systemPrompt.trimmed().isEmpty()) {
+    // A cache carries the system instruction, which the request then may not repeat
+    const bool sendSystemPrompt = !useCachedContent && !systemPrompt.trimmed().isEmpty();
+    if (useSystemInstruction && sendSystemPrompt) {
         QJsonObject sysPart; sysPart.insert(QStringLiteral("text"), systemPrompt);
         systemInstructionObj.insert(QStringLiteral("parts"), QJsonArray{sysPart});
-    } else if (!systemPrompt.trimmed().isEmpty()) {
+    } else if (sendSystemPrompt) {
         QJsonObject sysPart; sysPart.insert(QStringLiteral("text"), systemPrompt);
         QJsonObject sysContent; sysContent.insert(QStringLiteral("parts"), QJsonArray{sysPart});
         contents.append(sysContent);
     }
 
+    // Earlier turns of a continued conversation; roles tell Gemini who said what
+    for (const LLMTurn& turn : message.history) {
+        contents.append(QJsonObject{{QStringLiteral("role"), QStringLiteral("user")},
+                                    {QStringLiteral("parts"), QJsonArray{QJsonObject{{QStringLiteral("text"), turn.prompt}}}}});
+        contents.append(QJsonObject{{QStringLiteral("role"), QStringLiteral("model")},
+                                    {QStringLiteral("parts"), QJsonArray{QJsonObject{{QStringLiteral("text"), turn.response}}}}});
+    }
+
     // Build the user message parts array (text + attachments)
     QJsonArray userParts;
     
@@ -368,22 +472,25 @@ LLMResult GoogleBackend::sendPrompt(
     textPart.insert(QStringLiteral("text"), userPrompt);
     userParts.append(textPart);
     
-    // Add all attachments
+    // Add all attachments not already in the context cache. Large files go up once
+    // through the File API and are referenced by URI; the rest are sent as inline_data.
+    JsonPayload payload;
+    QList<LLMAttachment> uploaded;
     for (const auto& attachment : message.attachments) {
-        // Convert to Base64
-        const QString base64String = QString::fromLatin1(attachment.data.toBase64());
-        
-        // Create inline_data part per Gemini API schema
-        QJsonObject inlineData;
-        inlineData.insert(QStringLiteral("mime_type"), attachment.mimeType);
-        inlineData.insert(QStringLiteral("data"), base64String);
-        
-        QJsonObject attachmentPart;
-        attachmentPart.insert(QStringLiteral("inline_data"), inlineData);
-        userParts.append(attachmentPart);
+        if (useCachedContent && message.cacheAttachments) {
+            break;
+        }
+        bool isUploaded = false;
+        userParts.append(attachmentPart(apiKey, attachment, payload, cancellation, isUploaded));
+        if (isUploaded) {
+            uploaded.append(attachment);
+        }
     }
     
     QJsonObject userContent;
+    if (!message.history.isEmpty()) {
+        userContent.insert(QStringLiteral("role"), QStringLiteral("user"));
+    }
     userContent.insert(QStringLiteral("parts"), userParts);
     contents.append(userContent);
 
@@ -400,8 +507,11 @@ LLMResult GoogleBackend::sendPrompt(
         // Gemini v1/v1beta supports top-level system_instruction when required
         root.insert(QStringLiteral("system_instruction"), systemInstructionObj);
     }
+    if (useCachedContent) {
+        root.insert(QStringLiteral("cachedContent"), cachedContent);
+    }
 
-    const QByteArray jsonBytes = QJsonDocument(root).toJson(QJsonDocument::Compact);
+    const std::string jsonPayload = payload.serialize(root);
 
     // Do NOT set Authorization header for Google; only Content-Type
     cpr::Header headers{
@@ -414,19 +524,91 @@ LLMResult GoogleBackend::sendPrompt(
         }
     }
 
+    // Each streamed chunk is a partial GenerateContentResponse; usage comes with the last
+    QString streamedText;
+    QString streamedFinishReason;
+    QJsonObject streamedUsage;
+    QJsonObject streamedError;
+    StreamingResponse stream(StreamingResponse::Framing::ServerSentEvents, [&](const QJsonObject& event) {
+        if (event.value(QStringLiteral("error")).isObject()) {
+            streamedError = event.value(QStringLiteral("error")).toObject();
+        }
+        const QJsonArray candidates = event.value(QStringLiteral("candidates")).toArray();
+        if (!candidates.isEmpty()) {
+            const QJsonObject candidate = candidates.first().toObject();
+            const QJsonArray parts = candidate.value(QStringLiteral("content")).toObject().value(QStringLiteral("parts")).toArray();
+            for (const QJsonValue& part : parts) {
+                const QString delta = part.toObject().value(QStringLiteral("text")).toString();
+                if (!delta.isEmpty()) {
+                    streamedText += delta;
+                    onDelta(delta);
+                }
+            }
+            const QString finishReason = candidate.value(QStringLiteral("finishReason")).toString();
+            if (!finishReason.isEmpty()) {
+                streamedFinishReason = finishReason;
+            }
+        }
+        if (event.value(QStringLiteral("usageMetadata")).isObject()) {
+            streamedUsage = event.value(QStringLiteral("usageMetadata")).toObject();
+        }
+    });
+
     // Perform POST synchronously with explicit timeouts to avoid hanging indefinitely
-    auto response = cpr::Post(
-        cpr::Url{url},
-        headers,
-        cpr::Body{jsonBytes.constData()},
-        cpr::ConnectTimeout{10000},   // 10s connect timeout
-        cpr::Timeout{120000}           // 120s total request timeout
-    );
+    ProviderRateLimiter::Permit permit;
+    auto response = BackendRateLimit::send(
+        permit, id(), resolvedModel,
+        ProviderRateLimiter::estimateTokens(systemPrompt.size() + userPrompt.size(), maxTokens), cancellation,
+        [&] {
+            return streaming
+                ? HttpConnectionPool::post(
+                      cpr::Url{url},
+                      headers,
+                      cpr::Body{jsonPayload},
+                      cpr::ConnectTimeout{10000},
+                      cpr::Timeout{120000},
+                      BackendCancellation::progressCallback(cancellation),
+                      stream.writeCallback())
+                : HttpConnectionPool::post(
+                      cpr::Url{url},
+                      headers,
+                      cpr::Body{jsonPayload},
+                      cpr::ConnectTimeout{10000},   // 10s connect timeout
+                      cpr::Timeout{120000},          // 120s total request timeout
+                      BackendCancellation::progressCallback(cancellation));
+        });
+
+    // Reassemble a streamed answer into the non-streaming response shape parsed below
+    if (streaming) {
+        stream.finish();
+        if (response.status_code == 200) {
+            QJsonObject assembled;
+            if (!streamedError.isEmpty()) {
+                assembled.insert(QStringLiteral("error"), streamedError);
+            }
+            const QJsonObject textPart{{QStringLiteral("text"), streamedText}};
+            const QJsonObject content{{QStringLiteral("parts"), QJsonArray{textPart}}};
+            QJsonObject candidate{{QStringLiteral("content"), content}};
+            if (!streamedFinishReason.isEmpty()) {
+                candidate.insert(QStringLiteral("finishReason"), streamedFinishReason);
+            }
+            assembled.insert(QStringLiteral("candidates"), QJsonArray{candidate});
+            if (!streamedUsage.isEmpty()) {
+                assembled.insert(QStringLiteral("usageMetadata"), streamedUsage);
+            }
+            response.text = QJsonDocument(assembled).toJson(QJsonDocument::Compact).toStdString();
+        } else {
+            response.text = stream.raw();
+        }
+    }
     
     if (response.error) {
         result.hasError = true;
+        BackendRateLimit::markTransient(result, response);
 
-        if (response.error.code == cpr::ErrorCode::OPERATION_TIMEDOUT) {
+        if (cancellation.isCancelled()) {
+            result.errorMsg = BackendCancellation::message();
+        } else if (response.error.code == cpr::ErrorCode::OPERATION_TIMEDOUT) {
             result.errorMsg = QStringLiteral("Google Gemini API Timeout");
             CP_WARN.noquote() << QStringLiteral("GoogleBackend::sendPrompt failure provider=google model=%1 transport=timeout message=%2")
                                           .arg(resolvedModel, QString::fromStdString(response.error.message));
@@ -446,6 +628,7 @@ LLMResult GoogleBackend::sendPrompt(
     
     if (response.status_code != 200) {
         result.hasError = true;
+        BackendRateLimit::markTransient(result, response);
 
         CP_WARN << "GoogleBackend::sendPrompt HTTP error" << response.status_code
                    << "body:" << result.rawResponse;
@@ -470,6 +653,17 @@ LLMResult GoogleBackend::sendPrompt(
                                       .arg(response.status_code)
                                       .arg(result.errorMsg);
         result.content = result.errorMsg;
+
+        // Files expire after 48 hours; a rejected URI is uploaded afresh next time
+        if (response.status_code >= 400 && response.status_code < 500 && response.status_code != 429) {
+            for (const auto& attachment : uploaded) {
+                AttachmentStore::shared().forget(id(), apiKey, attachment);
+            }
+            // So are caches deleted or expired early on the provider's side
+            if (useCachedContent) {
+                AttachmentStore::shared().forget(id(), apiKey, contextKey);
+            }
+        }
         return result;
     }
     
@@ -589,17 +783,204 @@ LLMResult GoogleBackend::sendPrompt(
         result.usage.inputTokens = usageMetadata[QStringLiteral("promptTokenCount")].toInt(0);
         result.usage.outputTokens = usageMetadata[QStringLiteral("candidatesTokenCount")].toInt(0);
         result.usage.totalTokens = usageMetadata[QStringLiteral("totalTokenCount")].toInt(0);
+        // Part of promptTokenCount
+        result.usage.cacheReadTokens = usageMetadata[QStringLiteral("cachedContentTokenCount")].toInt(0);
     }
+    // The call that created the cache also paid for writing it
+    if (cacheWriteTokens > 0) {
+        result.usage.cacheWriteTokens = cacheWriteTokens;
+        result.usage.inputTokens += cacheWriteTokens;
+        result.usage.totalTokens += cacheWriteTokens;
+    }
+    permit.settle(result.usage.totalTokens);
     
     return result;
 }
 
+QJsonObject GoogleBackend::attachmentPart(const QString& apiKey, const LLMAttachment& attachment, JsonPayload& payload,
+                                          const CancellationToken& cancellation, bool& uploaded)
+{
+    const QString fileUri = AttachmentStore::shared().reference(
+        id(), apiKey, attachment, kFileApiTtlMs,
+        [&](const LLMAttachment& file) { return uploadFile(apiKey, file, cancellation); });
+
+    QJsonObject part;
+    uploaded = !fileUri.isEmpty();
+    if (uploaded) {
+        QJsonObject fileData;
+        fileData.insert(QStringLiteral("mime_type"), attachment.mimeType);
+        fileData.insert(QStringLiteral("file_uri"), fileUri);
+        part.insert(QStringLiteral("file_data"), fileData);
+    } else {
+        // Create inline_data part per Gemini API schema
+        QJsonObject inlineData;
+        inlineData.insert(QStringLiteral("mime_type"), attachment.mimeType);
+        inlineData.insert(QStringLiteral("data"), payload.base64(attachment.data));
+        part.insert(QStringLiteral("inline_data"), inlineData);
+    }
+    return part;
+}
+
+QString GoogleBackend::createCachedContent(const QString& apiKey, const QString& model, const QString& systemPrompt,
+                                           const QList<LLMAttachment>& attachments,
+                                           const CancellationToken& cancellation, int& cachedTokens)
+{
+    JsonPayload payload;
+    QJsonObject root;
+    root.insert(QStringLiteral("model"), QStringLiteral("models/") + model);
+    root.insert(QStringLiteral("ttl"), QStringLiteral("%1s").arg(kContextCacheTtlMs / 1000));
+    if (!systemPrompt.trimmed().isEmpty()) {
+        const QJsonObject textPart{{QStringLiteral("text"), systemPrompt}};
+        root.insert(QStringLiteral("systemInstruction"), QJsonObject{{QStringLiteral("parts"), QJsonArray{textPart}}});
+    }
+    if (!attachments.isEmpty()) {
+        QJsonArray parts;
+        for (const LLMAttachment& attachment : attachments) {
+            bool isUploaded = false;
+            parts.append(attachmentPart(apiKey, attachment, payload, cancellation, isUploaded));
+        }
+        const QJsonObject content{{QStringLiteral("role"), QStringLiteral("user")}, {QStringLiteral("parts"), parts}};
+        root.insert(QStringLiteral("contents"), QJsonArray{content});
+    }
+
+    try {
+        const auto response = HttpConnectionPool::post(
+            cpr::Url{apiBase() + "/v1beta/cachedContents"},
+            cpr::Header{
+                {"x-goog-api-key", apiKey.toStdString()},
+                {"Content-Type", "application/json"}
+            },
+            cpr::Body{payload.serialize(root)},
+            cpr::ConnectTimeout{10000},
+            cpr::Timeout{120000},
+            BackendCancellation::progressCallback(cancellation));
+        if (response.status_code != 200) {
+            if (!cancellation.isCancelled()) {
+                CP_WARN.noquote() << QStringLiteral("GoogleBackend::createCachedContent failure provider=google model=%1 status=%2 message=%3")
+                                          .arg(model)
+                                          .arg(response.status_code)
+                                          .arg(googleErrorMessage(response));
+            }
+            return {};
+        }
+        const QJsonObject cache = QJsonDocument::fromJson(QByteArray::fromStdString(response.text)).object();
+        cachedTokens = cache.value(QStringLiteral("usageMetadata")).toObject().value(QStringLiteral("totalTokenCount")).toInt();
+        CP_CLOG(cp_lifecycle).noquote() << "[ContextCache] created" << cache.value(QStringLiteral("name")).toString()
+                                        << "model=" << model << "tokens=" << cachedTokens;
+        return cache.value(QStringLiteral("name")).toString();
+    } catch (const std::exception& e) {
+        CP_WARN << "GoogleBackend::createCachedContent:" << e.what();
+        return {};
+    }
+}
+
+QString GoogleBackend::uploadFile(const QString& apiKey, const LLMAttachment& attachment,
+                                 const CancellationToken& cancellation)
+{
+    const std::string mimeType = attachment.mimeType.toStdString();
+    try {
+        // Resumable protocol: the start request returns the URL the bytes are sent to
+        const auto start = HttpConnectionPool::post(
+            cpr::Url{apiBase() + "/upload/v1beta/files"},
+            cpr::Header{
+                {"x-goog-api-key", apiKey.toStdString()},
+                {"X-Goog-Upload-Protocol", "resumable"},
+                {"X-Goog-Upload-Command", "start"},
+                {"X-Goog-Upload-Header-Content-Length", std::to_string(attachment.data.size())},
+                {"X-Goog-Upload-Header-Content-Type", mimeType},
+                {"Content-Type", "application/json"}
+            },
+            cpr::Body{R"({"file":{"display_name":"cognitive-pipelines-attachment"}})"},
+            cpr::ConnectTimeout{10000},
+            cpr::Timeout{30000},
+            BackendCancellation::progressCallback(cancellation));
+        const auto uploadUrl = start.header.find("x-goog-upload-url");
+        if (start.status_code != 200 || uploadUrl == start.header.end()) {
+            CP_WARN.noquote() << QStringLiteral("GoogleBackend::uploadFile failure provider=google status=%1 message=%2")
+                                      .arg(start.status_code)
+                                      .arg(QString::fromStdString(start.error.message + start.text));
+            return {};
+        }
+
+        const auto upload = HttpConnectionPool::post(
+            cpr::Url{uploadUrl->second},
+            cpr::Header{
+                {"X-Goog-Upload-Offset", "0"},
+                {"X-Goog-Upload-Command", "upload, finalize"}
+            },
+            cpr::Body{attachment.data.constData(), static_cast<size_t>(attachment.data.size())},
+            cpr::ConnectTimeout{10000},
+            cpr::Timeout{300000},
+            BackendCancellation::progressCallback(cancellation));
+        if (upload.status_code != 200) {
+            CP_WARN.noquote() << QStringLiteral("GoogleBackend::uploadFile failure provider=google status=%1 message=%2")
+                                      .arg(upload.status_code)
+                                      .arg(QString::fromStdString(upload.error.message + upload.text));
+            return {};
+        }
+
+        QJsonObject file = QJsonDocument::fromJson(QByteArray::fromStdString(upload.text))
+                               .object().value(QStringLiteral("file")).toObject();
+
+        // Documents are usually ACTIVE at once; give processing a few seconds before giving up
+        const std::string fileUrl = apiBase() + "/v1beta/"
+                                    + file.value(QStringLiteral("name")).toString().toStdString();
+        for (int poll = 0; file.value(QStringLiteral("state")).toString() == QStringLiteral("PROCESSING") && poll < 10; ++poll) {
+            if (cancellation.isCancelled()) return {};
+            QThread::msleep(1000);
+            const auto status = HttpConnectionPool::get(
+                cpr::Url{fileUrl},
+                cpr::Header{{"x-goog-api-key", apiKey.toStdString()}},
+                cpr::Timeout{30000},
+                BackendCancellation::progressCallback(cancellation));
+            if (status.status_code != 200) break;
+            file = QJsonDocument::fromJson(QByteArray::fromStdString(status.text)).object();
+        }
+
+        const QString state = file.value(QStringLiteral("state")).toString();
+        if (!state.isEmpty() && state != QStringLiteral("ACTIVE")) {
+            CP_WARN << "GoogleBackend::uploadFile: file not usable, state" << state;
+            return {};
+        }
+        return file.value(QStringLiteral("uri")).toString();
+    } catch (const std::exception& e) {
+        CP_WARN << "GoogleBackend::uploadFile:" << e.what();
+        return {};
+    }
+}
+
 EmbeddingResult GoogleBackend::getEmbedding(
     const QString& apiKey,
     const QString& modelName,
     const QString& text
+) {
+    // A lone text still goes as :embedContent; merged ones as one batch
+    const QString key = EmbeddingBatcher::coalesceKey(id(), modelName, 0, apiKey);
+    return EmbeddingBatcher::firstOf(
+        EmbeddingBatcher::coalesce(key, QStringList{text}, 100, [&](const QStringList& merged) {
+            return merged.size() == 1 ? EmbeddingBatcher::batchOf(embedContent(apiKey, modelName, merged.front()))
+                                      : batchEmbedContents(apiKey, modelName, merged);
+        }));
+}
+
+EmbeddingBatchResult GoogleBackend::getEmbeddings(
+    const QString& apiKey,
+    const QString& modelName,
+    const QStringList& texts
+) {
+    const QString key = EmbeddingBatcher::coalesceKey(id(), modelName, 0, apiKey);
+    return EmbeddingBatcher::coalesce(key, texts, 100, [&](const QStringList& merged) {
+        return batchEmbedContents(apiKey, modelName, merged);
+    });
+}
+
+EmbeddingResult GoogleBackend::embedContent(
+    const QString& apiKey,
+    const QString& modelName,
+    const QString& text
 ) {
     EmbeddingResult result;
+    const CancellationToken cancellation = CancellationToken::current();
 
     if (apiKey.trimmed().isEmpty()) {
         result.hasError = true;
@@ -623,25 +1004,32 @@ EmbeddingResult GoogleBackend::getEmbedding(
     root.insert(QStringLiteral("content"), content);
 
     const QByteArray jsonBytes = QJsonDocument(root).toJson(QJsonDocument::Compact);
-    const std::string url = std::string("https://generativelanguage.googleapis.com/v1beta/models/")
+    const std::string url = apiBase() + "/v1beta/models/"
                             + selectedModel.toStdString()
                             + ":embedContent";
 
-    const auto response = cpr::Post(
-        cpr::Url{url},
-        cpr::Header{
-            {"Accept", "application/json"},
-            {"Content-Type", "application/json"},
-            {"x-goog-api-key", apiKey.toStdString()}
-        },
-        cpr::Body{jsonBytes.constData()},
-        cpr::ConnectTimeout{10000},
-        cpr::Timeout{120000}
-    );
+    ProviderRateLimiter::Permit permit;
+    const auto response = BackendRateLimit::send(
+        permit, id(), selectedModel, ProviderRateLimiter::estimateTokens(text.size()), cancellation, [&] {
+            return HttpConnectionPool::post(
+                cpr::Url{url},
+                cpr::Header{
+                    {"Accept", "application/json"},
+                    {"Content-Type", "application/json"},
+                    {"x-goog-api-key", apiKey.toStdString()}
+                },
+                cpr::Body{jsonBytes.constData()},
+                cpr::ConnectTimeout{10000},
+                cpr::Timeout{120000},
+                BackendCancellation::progressCallback(cancellation)
+            );
+        });
 
     if (response.error) {
         result.hasError = true;
-        if (response.error.code == cpr::ErrorCode::OPERATION_TIMEDOUT) {
+        if (cancellation.isCancelled()) {
+            result.errorMsg = BackendCancellation::message();
+        } else if (response.error.code == cpr::ErrorCode::OPERATION_TIMEDOUT) {
             result.errorMsg = QStringLiteral("Google Gemini embedding API timeout");
             CP_WARN.noquote() << QStringLiteral("GoogleBackend::getEmbedding failure provider=google model=%1 transport=timeout message=%2")
                                           .arg(selectedModel, QString::fromStdString(response.error.message));
@@ -703,10 +1091,165 @@ EmbeddingResult GoogleBackend::getEmbedding(
         result.usage.outputTokens = 0;
         result.usage.totalTokens = usage.value(QStringLiteral("totalTokenCount")).toInt(inputTokens);
     }
+    permit.settle(result.usage.totalTokens);
 
     return result;
 }
 
+EmbeddingBatchResult GoogleBackend::batchEmbedContents(
+    const QString& apiKey,
+    const QString& modelName,
+    const QStringList& texts
+) {
+    const CancellationToken cancellation = CancellationToken::current();
+
+    if (apiKey.trimmed().isEmpty()) {
+        EmbeddingBatchResult result;
+        result.hasError = true;
+        result.errorMsg = QStringLiteral("Missing Google API key");
+        return result;
+    }
+
+    const QString selectedModel = normalizedGoogleEmbeddingModel(modelName);
+    const QString modelResource = QStringLiteral("models/%1").arg(selectedModel);
+    const std::string url = apiBase() + "/v1beta/models/"
+                            + selectedModel.toStdString()
+                            + ":batchEmbedContents";
+
+    // batchEmbedContents accepts at most 100 requests per call
+    return embedInBatches(texts, 100, 0, [&](const QStringList& batch) {
+        EmbeddingBatchResult result;
+
+        QJsonArray requests;
+        for (const QString& text : batch) {
+            QJsonObject textPart;
+            textPart.insert(QStringLiteral("text"), text);
+            QJsonObject content;
+            content.insert(QStringLiteral("parts"), QJsonArray{textPart});
+            QJsonObject request;
+            request.insert(QStringLiteral("model"), modelResource);
+            request.insert(QStringLiteral("content"), content);
+            requests.append(request);
+        }
+        QJsonObject root;
+        root.insert(QStringLiteral("requests"), requests);
+        const QByteArray jsonBytes = QJsonDocument(root).toJson(QJsonDocument::Compact);
+
+        qsizetype inputChars = 0;
+        for (const QString& text : batch) {
+            inputChars += text.size();
+        }
+        ProviderRateLimiter::Permit permit;
+        const auto response = BackendRateLimit::send(
+            permit, id(), selectedModel, ProviderRateLimiter::estimateTokens(inputChars), cancellation, [&] {
+                return HttpConnectionPool::post(
+                    cpr::Url{url},
+                    cpr::Header{
+                        {"Accept", "application/json"},
+                        {"Content-Type", "application/json"},
+                        {"x-goog-api-key", apiKey.toStdString()}
+                    },
+                    cpr::Body{jsonBytes.constData()},
+                    cpr::ConnectTimeout{10000},
+                    cpr::Timeout{120000},
+                    BackendCancellation::progressCallback(cancellation)
+                );
+            });
+
+        if (response.error) {
+            result.hasError = true;
+            if (cancellation.isCancelled()) {
+                result.errorMsg = BackendCancellation::message();
+            } else if (response.error.code == cpr::ErrorCode::OPERATION_TIMEDOUT) {
+                result.errorMsg = QStringLiteral("Google Gemini embedding API timeout");
+                CP_WARN.noquote() << QStringLiteral("GoogleBackend::getEmbeddings failure provider=google model=%1 transport=timeout message=%2")
+                                              .arg(selectedModel, QString::fromStdString(response.error.message));
+            } else {
+                result.errorMsg = QStringLiteral("Google Gemini embedding network error: %1")
+                                      .arg(QString::fromStdString(response.error.message));
+                CP_WARN.noquote() << QStringLiteral("GoogleBackend::getEmbeddings failure provider=google model=%1 transport=network message=%2")
+                                              .arg(selectedModel, result.errorMsg);
+            }
+            return result;
+        }
+
+        if (response.status_code != 200) {
+            result.hasError = true;
+            result.errorMsg = googleErrorMessage(response);
+            CP_WARN.noquote() << QStringLiteral("GoogleBackend::getEmbeddings failure provider=google model=%1 status=%2 message=%3")
+                                          .arg(selectedModel)
+                                          .arg(response.status_code)
+                                          .arg(result.errorMsg);
+            return result;
+        }
+
+        // Read the vectors straight out of the body; a QJsonDocument would hold one
+        // QJsonValue per number
+        JsonReader reader(QByteArrayView(response.text.data(), static_cast<qsizetype>(response.text.size())));
+        QByteArrayView key;
+        reader.enterObject();
+        while (reader.nextKey(key)) {
+            if (key == "error") {
+                result.hasError = true;
+                result.errorMsg = QStringLiteral("Unknown Google embedding error");
+                if (reader.peek() == JsonReader::Type::Object) {
+                    QByteArrayView field;
+                    reader.enterObject();
+                    while (reader.nextKey(field)) {
+                        if (field == "message" && reader.peek() == JsonReader::Type::String) {
+                            reader.readString(result.errorMsg);
+                        } else {
+                            reader.skipValue();
+                        }
+                    }
+                }
+                return result;
+            } else if (key == "embeddings" && reader.peek() == JsonReader::Type::Array) {
+                reader.enterArray();
+                while (reader.nextElement()) {
+                    std::vector<float> vector;
+                    if (reader.peek() == JsonReader::Type::Object) {
+                        QByteArrayView field;
+                        reader.enterObject();
+                        while (reader.nextKey(field)) {
+                            if (field == "values" && reader.peek() == JsonReader::Type::Array) {
+                                reader.readFloats(vector);
+                            } else {
+                                reader.skipValue();
+                            }
+                        }
+                    } else {
+                        reader.skipValue();
+                    }
+                    if (vector.empty() && !reader.hasError()) {
+                        result.hasError = true;
+                        result.errorMsg = QStringLiteral("Google embedding response returned no vector");
+                        result.vectors.clear();
+                        return result;
+                    }
+                    result.vectors.push_back(std::move(vector));
+                }
+            } else {
+                reader.skipValue();
+            }
+        }
+        if (reader.hasError()) {
+            result.hasError = true;
+            result.vectors.clear();
+            result.errorMsg = QStringLiteral("Google embedding JSON parse error: %1").arg(reader.errorString());
+        }
+        return result;
+    });
+}
+
+void GoogleBackend::warmUp(const QString& apiKey, const QString& modelName)
+{
+    Q_UNUSED(modelName);
+    if (!apiKey.trimmed().isEmpty()) {
+        HttpConnectionPool::preconnect(apiBase() + "/v1beta/models");
+    }
+}
+
 QFuture<QString> GoogleBackend::generateImage(
     const QString& prompt,
     const QString& model,
@@ -24,9 +24,13 @@
 #pragma once
 
 #include "ILLMBackend.h"
+#include "CancellationToken.h"
+#include <QJsonObject>
 #include <QMutex>
 #include <QStringList>
 
+class JsonPayload;
+
 /**
  * @brief Google Gemini backend implementation using the Generative Language API.
  *
@@ -57,12 +61,32 @@ public:
         const LLMMessage& message = {}
     ) override;
 
+    LLMResult streamPrompt(
+        const QString& apiKey,
+        const QString& modelName,
+        double temperature,
+        int maxTokens,
+        const QString& systemPrompt,
+        const QString& userPrompt,
+        const LLMStreamCallback& onDelta,
+        const LLMMessage& message = {}
+    ) override;
+
     EmbeddingResult getEmbedding(
         const QString& apiKey,
         const QString& modelName,
         const QString& text
     ) override;
 
+    EmbeddingBatchResult getEmbeddings(
+        const QString& apiKey,
+        const QString& modelName,
+        const QStringList& texts
+    ) override;
+
+    // Opens a pooled connection to the API host; nothing is sent without a key
+    void warmUp(const QString& apiKey, const QString& modelName) override;
+
     QFuture<QString> generateImage(
         const QString& prompt,
         const QString& model,
@@ -73,6 +97,46 @@ public:
     ) override;
 
 private:
+    // One :embedContent request
+    EmbeddingResult embedContent(
+        const QString& apiKey,
+        const QString& modelName,
+        const QString& text
+    );
+
+    // :batchEmbedContents requests of up to 100 texts each. getEmbedding() and
+    // getEmbeddings() merge concurrent small calls before they get here.
+    EmbeddingBatchResult batchEmbedContents(
+        const QString& apiKey,
+        const QString& modelName,
+        const QStringList& texts
+    );
+
+    // Shared by sendPrompt() and streamPrompt(); streams when onDelta is set
+    LLMResult promptRequest(
+        const QString& apiKey,
+        const QString& modelName,
+        double temperature,
+        int maxTokens,
+        const QString& systemPrompt,
+        const QString& userPrompt,
+        const LLMMessage& message,
+        const LLMStreamCallback& onDelta
+    );
+
+    // A file_data part when the File API holds the attachment, else inline_data in payload
+    QJsonObject attachmentPart(const QString& apiKey, const LLMAttachment& attachment, JsonPayload& payload,
+                               const CancellationToken& cancellation, bool& uploaded);
+
+    // Creates a cachedContents resource holding the system instruction and attachments;
+    // returns its name and the tokens it holds, or empty on failure
+    QString createCachedContent(const QString& apiKey, const QString& model, const QString& systemPrompt,
+                                const QList<LLMAttachment>& attachments, const CancellationToken& cancellation,
+                                int& cachedTokens);
+
+    // Uploads an attachment through the File API; returns its file URI, or empty on failure
+    QString uploadFile(const QString& apiKey, const LLMAttachment& attachment, const CancellationToken& cancellation);
+
     mutable QMutex m_cacheMutex;
     QStringList m_cachedModels;
 };
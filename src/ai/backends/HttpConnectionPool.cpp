@@ -0,0 +1,188 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "HttpConnectionPool.h"
+#include "MetricsRegistry.h"
+
+#include <QDeadlineTimer>
+#include <QHash>
+#include <QUrl>
+
+#include <curl/curl.h>
+
+#include <array>
+#include <mutex>
+
+namespace {
+
+// libcurl calls back into these locks whenever a handle touches a shared cache
+class SharedCaches {
+public:
+    SharedCaches()
+        : m_share(curl_share_init())
+    {
+        if (!m_share) {
+            return;
+        }
+        curl_share_setopt(m_share, CURLSHOPT_LOCKFUNC, &SharedCaches::lock);
+        curl_share_setopt(m_share, CURLSHOPT_UNLOCKFUNC, &SharedCaches::unlock);
+        curl_share_setopt(m_share, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900
+        // Connection cache sharing needs libcurl 7.57
+        curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+    }
+
+    CURLSH* handle() const { return m_share; }
+
+private:
+    static void lock(CURL*, curl_lock_data data, curl_lock_access, void* userptr)
+    {
+        static_cast<SharedCaches*>(userptr)->m_locks.at(data).lock();
+    }
+    static void unlock(CURL*, curl_lock_data data, void* userptr)
+    {
+        static_cast<SharedCaches*>(userptr)->m_locks.at(data).unlock();
+    }
+
+    CURLSH* m_share;
+    std::array<std::mutex, CURL_LOCK_DATA_LAST> m_locks;
+};
+
+SharedCaches& sharedCaches()
+{
+    // Never destroyed: requests on worker threads may outlive static destruction
+    static SharedCaches* caches = new SharedCaches();
+    return *caches;
+}
+
+// Claims the warm-up of an origin; false while an earlier one is recent enough to reuse
+bool claimPreconnect(const QString& origin, bool release)
+{
+    static std::mutex mutex;
+    static QHash<QString, qint64> warmedAtMs;
+    const std::lock_guard<std::mutex> lock(mutex);
+    if (release) {
+        warmedAtMs.remove(origin);
+        return true;
+    }
+    const qint64 now = QDeadlineTimer::current().deadline();
+    const auto it = warmedAtMs.constFind(origin);
+    if (it != warmedAtMs.constEnd() && now - *it < HttpConnectionPool::kPreconnectReuseSeconds * 1000) {
+        return false;
+    }
+    warmedAtMs.insert(origin, now);
+    return true;
+}
+
+} // namespace
+
+namespace HttpConnectionPool {
+
+void attach(cpr::Session& session)
+{
+    session.SetHttpVersion(cpr::HttpVersion{cpr::HttpVersionCode::VERSION_2_0_TLS});
+    CURL* curl = session.GetCurlHolder()->handle;
+    if (CURLSH* share = sharedCaches().handle()) {
+        curl_easy_setopt(curl, CURLOPT_SHARE, share);
+    }
+    // Probe idle pooled connections so dead ones are dropped before they are reused
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+}
+
+Tracer::Span startRequestSpan(const char* method, cpr::Session& session)
+{
+    // Named after the method alone, as the HTTP conventions ask; the URL is an attribute
+    Tracer::Span span = Tracer::instance().startSpan(QString::fromLatin1(method), Tracer::Kind::Client);
+    if (span.isRecording()) {
+        span.setAttribute(QStringLiteral("http.request.method"), QString::fromLatin1(method));
+        // Merged into the headers the caller set rather than replacing them
+        session.UpdateHeader(cpr::Header{{"traceparent", span.context().traceparent().toStdString()}});
+    }
+    return span;
+}
+
+void recordResponse(const char* method, const cpr::Response& response, Tracer::Span& span)
+{
+    const QUrl url(QString::fromStdString(response.url.str()));
+    const QString host = url.host();
+    // Status 0 means no HTTP response arrived: a connection error, timeout or abort
+    const QString status = response.status_code > 0 ? QString::number(response.status_code)
+                                                    : QStringLiteral("error");
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    const MetricsRegistry::Labels requestLabels = {{QStringLiteral("host"), host},
+                                                   {QStringLiteral("method"), QString::fromLatin1(method)}};
+    MetricsRegistry::Labels statusLabels = requestLabels;
+    statusLabels.append({QStringLiteral("status"), status});
+    metrics.counter(QStringLiteral("cp_backend_requests"), QStringLiteral("Backend HTTP requests by status code"),
+                    statusLabels)
+        .increment();
+    metrics.histogram(QStringLiteral("cp_backend_request_seconds"),
+                      QStringLiteral("Backend HTTP request latency, including streamed bodies"), requestLabels)
+        .observe(response.elapsed);
+
+    if (!span.isRecording()) {
+        return;
+    }
+    // Query strings can hold API keys
+    span.setAttribute(QStringLiteral("url.full"), url.toString(QUrl::RemoveQuery | QUrl::RemoveUserInfo));
+    span.setAttribute(QStringLiteral("server.address"), host);
+    if (response.status_code > 0) {
+        span.setAttribute(QStringLiteral("http.response.status_code"), static_cast<int>(response.status_code));
+    }
+    if (response.error) {
+        span.setAttribute(QStringLiteral("error.type"), QStringLiteral("transport"));
+        span.setError(QString::fromStdString(response.error.message));
+    } else if (response.status_code >= 400) {
+        span.setAttribute(QStringLiteral("error.type"), status);
+        span.setError(status);
+    }
+    span.end();
+}
+
+bool preconnect(const std::string& url)
+{
+    const QUrl parsed(QString::fromStdString(url));
+    const QString origin = parsed.toString(QUrl::RemovePath | QUrl::RemoveQuery | QUrl::RemoveUserInfo);
+    if (!parsed.isValid() || !claimPreconnect(origin, false)) {
+        return false;
+    }
+
+    cpr::Session session;
+    attach(session);
+    session.SetUrl(cpr::Url{url});
+    session.SetTimeout(cpr::Timeout{10000});
+    Tracer::Span span = startRequestSpan("HEAD", session);
+    const cpr::Response response = session.Head();
+    recordResponse("HEAD", response, span);
+    if (response.error) {
+        // Let the next run try again rather than trusting a connection that never opened
+        claimPreconnect(origin, true);
+        return false;
+    }
+    return true;
+}
+
+} // namespace HttpConnectionPool
@@ -0,0 +1,81 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include "Tracer.h"
+
+#include <cpr/cpr.h>
+
+#include <utility>
+
+// Keeps backend HTTP connections warm across requests. Sessions made here share one
+// process-wide libcurl connection cache, DNS cache and TLS session cache, so a request
+// to a provider host picks up an idle keep-alive connection left by any earlier
+// request, on any thread, instead of paying a fresh TCP and TLS handshake. HTTP/2 is
+// negotiated over TLS where the server offers it. post() and get() take the same
+// options as cpr::Post() and cpr::Get(); options passed in override the defaults.
+// Every response is counted in MetricsRegistry by host, method and status, with its
+// latency. With tracing on, each request is a client span under the caller's current
+// span and carries its W3C traceparent header.
+namespace HttpConnectionPool {
+
+// Attaches a session to the shared caches and sets the keep-alive defaults
+void attach(cpr::Session& session);
+// Starts the request's client span and adds its traceparent to the session's headers
+Tracer::Span startRequestSpan(const char* method, cpr::Session& session);
+// Adds a finished request to cp_backend_requests and cp_backend_request_seconds and
+// ends its span
+void recordResponse(const char* method, const cpr::Response& response, Tracer::Span& span);
+// Opens a pooled connection to the URL's host ahead of the first real request: DNS,
+// TCP and TLS setup happen now, and the connection is left idle in the shared cache.
+// Sends an unauthenticated HEAD, so any HTTP status counts as warm. Blocking; a host
+// warmed in the last kPreconnectReuseSeconds is skipped. False on a transport error.
+constexpr int kPreconnectReuseSeconds = 30;
+bool preconnect(const std::string& url);
+
+template <typename... Ts>
+cpr::Response post(Ts&&... ts)
+{
+    cpr::Session session;
+    attach(session);
+    cpr::priv::set_option(session, std::forward<Ts>(ts)...);
+    Tracer::Span span = startRequestSpan("POST", session);
+    cpr::Response response = session.Post();
+    recordResponse("POST", response, span);
+    return response;
+}
+
+template <typename... Ts>
+cpr::Response get(Ts&&... ts)
+{
+    cpr::Session session;
+    attach(session);
+    cpr::priv::set_option(session, std::forward<Ts>(ts)...);
+    Tracer::Span span = startRequestSpan("GET", session);
+    cpr::Response response = session.Get();
+    recordResponse("GET", response, span);
+    return response;
+}
+
+} // namespace HttpConnectionPool
@@ -28,6 +28,9 @@
 #include <QStringList>
 #include <QList>
 #include <QByteArray>
+#include <QHash>
+#include <cmath>
+#include <functional>
 #include <vector>
 
 /**
@@ -38,11 +41,24 @@ struct LLMAttachment {
     QByteArray data;
 };
 
+/**
+ * @brief One earlier exchange of a conversation, resent before the current prompt.
+ */
+struct LLMTurn {
+    QString prompt;   ///< What the user sent
+    QString response; ///< What the model answered
+};
+
 /**
  * @brief Represents a message sent to or received from an LLM, including attachments.
  */
 struct LLMMessage {
     QList<LLMAttachment> attachments;
+    bool cacheSystemPrompt = false; ///< Ask the provider to cache the system prompt prefix (prompt caching)
+    bool cacheAttachments = false;  ///< Extend the cached prefix to cover the attachments
+    QList<LLMTurn> history;         ///< Earlier turns, oldest first, sent as messages before the prompt
+    QString previousResponseId;     ///< Continue a conversation the provider stores; history is then not sent
+    bool storeResponse = false;     ///< Ask the provider to keep this exchange (see LLMResult::responseId)
 };
 
 /**
@@ -52,6 +68,8 @@ struct LLMUsage {
     int inputTokens = 0;
     int outputTokens = 0;
     int totalTokens = 0;
+    int cacheReadTokens = 0;  ///< Input tokens served from the provider's prompt cache (part of inputTokens)
+    int cacheWriteTokens = 0; ///< Input tokens written to the provider's prompt cache (part of inputTokens)
 };
 
 /**
@@ -66,8 +84,46 @@ struct LLMResult {
     QString rawResponse;    ///< The original full JSON for debugging
     bool hasError = false;  ///< Whether an error occurred
     QString errorMsg;       ///< Error message if hasError is true
+    bool transient = false; ///< The error was a timeout, 5xx or 429 that another attempt may not meet
+    int retryAfterMs = 0;   ///< Provider's Retry-After for a transient error, 0 when it sent none
+    QString responseId;     ///< Provider id of a stored exchange, for LLMMessage::previousResponseId
+};
+
+/**
+ * @brief One prompt submitted as part of a provider batch job.
+ *
+ * Takes the same values as sendPrompt(); customId identifies the request's
+ * answer among the job's results.
+ */
+struct LLMBatchRequest {
+    QString customId;
+    QString modelName;
+    double temperature = 0.7;
+    int maxTokens = 1024;
+    QString systemPrompt;
+    QString userPrompt;
+    LLMMessage message;
+};
+
+/**
+ * @brief State of a provider batch job, as returned by submitBatch() and pollBatch().
+ */
+struct LLMBatchStatus {
+    QString jobId;                     ///< Provider-assigned id of the job
+    bool finished = false;             ///< The job has ended and results holds every answer it produced
+    bool hasError = false;             ///< The job could not be submitted or failed as a whole
+    QString errorMsg;                  ///< Error message if hasError is true
+    QHash<QString, LLMResult> results; ///< Answers by LLMBatchRequest::customId, once finished
 };
 
+/**
+ * @brief Receives each piece of response text as a streamed completion arrives.
+ *
+ * Called on the thread that issued the request, in order; concatenating every delta
+ * gives LLMResult::content.
+ */
+using LLMStreamCallback = std::function<void(const QString& delta)>;
+
 /**
  * @brief Result structure returned by embedding API calls.
  *
@@ -81,11 +137,42 @@ struct EmbeddingResult {
     QString errorMsg;           ///< Error message if hasError is true
 };
 
+/**
+ * @brief Result structure returned by batched embedding calls.
+ *
+ * vectors holds one embedding per input text, in input order. A batch either
+ * succeeds as a whole or reports hasError; usage is summed over every request
+ * the batch was split into.
+ */
+struct EmbeddingBatchResult {
+    std::vector<std::vector<float>> vectors; ///< One embedding vector per input text
+    LLMUsage usage;                          ///< Token usage summed over all requests
+    bool hasError = false;                   ///< Whether any request failed
+    QString errorMsg;                        ///< Error message if hasError is true
+};
+
+/**
+ * @brief Result structure returned by rerank calls.
+ *
+ * scores holds one relevance score per input document, in input order, in
+ * [0, 1] with higher meaning more relevant.
+ */
+struct RerankResult {
+    std::vector<double> scores; ///< One relevance score per document
+    LLMUsage usage;             ///< Token usage statistics
+    bool hasError = false;      ///< Whether an error occurred
+    QString errorMsg;           ///< Error message if hasError is true
+};
+
 /**
  * @brief Abstract base class (Strategy Pattern) for all LLM backend providers.
  *
  * Each concrete implementation (OpenAI, Google, Anthropic, etc.) will implement
  * this interface, allowing the application to work with any LLM provider uniformly.
+ *
+ * sendPrompt(), getEmbedding() and generateImage() observe the caller's
+ * CancellationToken::current(): once the run is stopped the HTTP transfer is aborted
+ * and the call returns an error result ("Request cancelled").
  */
 class ILLMBackend {
 public:
@@ -157,6 +244,31 @@ public:
         const LLMMessage& message = {}
     ) = 0;
 
+    /**
+     * @brief Sends a prompt and reports the response text incrementally as it streams in.
+     *
+     * Takes the same parameters as sendPrompt() and returns the same complete result
+     * once the response has finished; onDelta is called with each new piece of text
+     * before that. Backends without a streaming endpoint fall back to sendPrompt() and
+     * report the whole response as a single delta.
+     */
+    virtual LLMResult streamPrompt(
+        const QString& apiKey,
+        const QString& modelName,
+        double temperature,
+        int maxTokens,
+        const QString& systemPrompt,
+        const QString& userPrompt,
+        const LLMStreamCallback& onDelta,
+        const LLMMessage& message = {}
+    ) {
+        LLMResult result = sendPrompt(apiKey, modelName, temperature, maxTokens, systemPrompt, userPrompt, message);
+        if (!result.hasError && !result.content.isEmpty() && onDelta) {
+            onDelta(result.content);
+        }
+        return result;
+    }
+
     /**
      * @brief Converts text into a vector embedding for RAG (Retrieval-Augmented Generation).
      *
@@ -174,6 +286,63 @@ public:
         const QString& text
     ) = 0;
 
+    /**
+     * @brief Converts several texts into embeddings, in as few requests as the provider allows.
+     *
+     * Backends with a batch endpoint override this and split the input
+     * transparently to stay within the provider's per-request limits (see
+     * splitEmbeddingBatches()). The default embeds each text with getEmbedding()
+     * and stops at the first failure.
+     *
+     * @param apiKey The API key for authentication with the backend.
+     * @param modelName The embedding model to use.
+     * @param texts The texts to embed.
+     * @return EmbeddingBatchResult with one vector per text, or an error.
+     */
+    virtual EmbeddingBatchResult getEmbeddings(
+        const QString& apiKey,
+        const QString& modelName,
+        const QStringList& texts
+    ) {
+        return embedInBatches(texts, 1, 0, [&](const QStringList& batch) {
+            EmbeddingBatchResult out;
+            EmbeddingResult single = getEmbedding(apiKey, modelName, batch.front());
+            out.usage = single.usage;
+            out.hasError = single.hasError;
+            out.errorMsg = single.errorMsg;
+            if (!single.hasError) {
+                out.vectors.push_back(std::move(single.vector));
+            }
+            return out;
+        });
+    }
+
+    /**
+     * @brief getEmbeddings() for vectors of @p dimensions entries, for models trained to allow it.
+     *
+     * Matryoshka-trained models (OpenAI text-embedding-3-*, nomic-embed-text,
+     * mxbai-embed-large and others) put the most information in the leading
+     * entries, so a prefix of the vector is itself a usable embedding.
+     * Backends whose API takes a dimension override this and ask for it;
+     * the default embeds at full size and keeps the first @p dimensions
+     * entries of each vector, rescaled to unit length (truncateEmbedding()).
+     * A @p dimensions of 0 is the model's native size.
+     */
+    virtual EmbeddingBatchResult getEmbeddingsAtDimension(
+        const QString& apiKey,
+        const QString& modelName,
+        const QStringList& texts,
+        int dimensions
+    ) {
+        EmbeddingBatchResult result = getEmbeddings(apiKey, modelName, texts);
+        if (!result.hasError && dimensions > 0) {
+            for (std::vector<float>& vector : result.vectors) {
+                truncateEmbedding(vector, dimensions);
+            }
+        }
+        return result;
+    }
+
     /**
      * @brief Generates an image using the provided text prompt and model.
      *
@@ -196,4 +365,194 @@ public:
         const QString& style,
         const QString& targetDir = QString()
     ) = 0;
+
+    /**
+     * @brief Prepares for the model's first request.
+     *
+     * Blocking and best effort; called off the UI thread when a run that uses
+     * the model starts. Local providers load the model; hosted ones open a pooled
+     * connection to their API host so the first request skips DNS, TCP and TLS setup.
+     */
+    virtual void warmUp(const QString& apiKey, const QString& modelName) {
+        Q_UNUSED(apiKey);
+        Q_UNUSED(modelName);
+    }
+
+    /**
+     * @brief Whether submitBatch() and pollBatch() reach a provider batch endpoint.
+     *
+     * Batch jobs trade latency (up to 24 hours) for higher throughput limits and
+     * lower prices. BatchJobTracker collects requests into jobs and polls them.
+     */
+    virtual bool supportsBatch() const { return false; }
+
+    /**
+     * @brief Submits the requests as one provider batch job.
+     *
+     * Blocking; returns the job id, or hasError when the job was not accepted.
+     * Requests that cannot be sent at all are left out of the job and answered
+     * straight away in results.
+     */
+    virtual LLMBatchStatus submitBatch(const QString& apiKey, const QList<LLMBatchRequest>& requests) {
+        Q_UNUSED(apiKey);
+        Q_UNUSED(requests);
+        LLMBatchStatus status;
+        status.hasError = true;
+        status.errorMsg = QStringLiteral("%1 does not support batch jobs").arg(name());
+        return status;
+    }
+
+    /**
+     * @brief Reports whether a submitted job has ended and, if so, its results.
+     *
+     * A poll that fails to reach the provider returns an unfinished status, so the
+     * caller polls again later; hasError means the job itself failed or expired.
+     */
+    virtual LLMBatchStatus pollBatch(const QString& apiKey, const QString& jobId) {
+        Q_UNUSED(apiKey);
+        LLMBatchStatus status;
+        status.jobId = jobId;
+        status.hasError = true;
+        status.errorMsg = QStringLiteral("%1 does not support batch jobs").arg(name());
+        return status;
+    }
+
+    /**
+     * @brief Asks the provider to stop a job nobody is waiting for any more.
+     */
+    virtual void cancelBatch(const QString& apiKey, const QString& jobId) {
+        Q_UNUSED(apiKey);
+        Q_UNUSED(jobId);
+    }
+
+    /**
+     * @brief Whether the provider can keep conversations on its side.
+     *
+     * Such backends honour LLMMessage::storeResponse and previousResponseId, so
+     * a continued conversation sends only its new prompt. Other backends resend
+     * LLMMessage::history with every prompt.
+     */
+    virtual bool supportsStoredConversations() const { return false; }
+
+    /**
+     * @brief Whether rerank() reaches a provider rerank (cross-encoder) endpoint.
+     *
+     * Used for models with the `rerank` capability. Other models are reranked by
+     * prompting them as chat models (Reranker).
+     */
+    virtual bool supportsRerank() const { return false; }
+
+    /**
+     * @brief Scores @p documents for relevance to @p query in one request.
+     *
+     * Blocking; observes CancellationToken::current() like sendPrompt().
+     */
+    virtual RerankResult rerank(
+        const QString& apiKey,
+        const QString& modelName,
+        const QString& query,
+        const QStringList& documents
+    ) {
+        Q_UNUSED(apiKey);
+        Q_UNUSED(modelName);
+        Q_UNUSED(query);
+        Q_UNUSED(documents);
+        RerankResult result;
+        result.hasError = true;
+        result.errorMsg = QStringLiteral("%1 does not support reranking").arg(name());
+        return result;
+    }
+
+    /**
+     * @brief Splits texts into consecutive batches of at most maxItems texts and
+     * roughly maxTokens tokens each (estimated at four characters per token).
+     *
+     * A single text over the token budget gets a batch of its own; the provider
+     * then decides whether to truncate or reject it. A limit of 0 means unlimited.
+     */
+    static QList<QStringList> splitEmbeddingBatches(const QStringList& texts, int maxItems, int maxTokens)
+    {
+        QList<QStringList> batches;
+        QStringList current;
+        int currentTokens = 0;
+        for (const QString& text : texts) {
+            const int tokens = text.size() / 4 + 1;
+            const bool full = (maxItems > 0 && current.size() >= maxItems)
+                              || (maxTokens > 0 && !current.isEmpty() && currentTokens + tokens > maxTokens);
+            if (full) {
+                batches.append(current);
+                current.clear();
+                currentTokens = 0;
+            }
+            current.append(text);
+            currentTokens += tokens;
+        }
+        if (!current.isEmpty()) {
+            batches.append(current);
+        }
+        return batches;
+    }
+
+    /**
+     * @brief Cuts @p vector to its first @p dimensions entries and rescales it to unit length.
+     *
+     * This is what providers do server-side for a reduced dimension. Vectors
+     * no longer than @p dimensions are left as they are.
+     */
+    static void truncateEmbedding(std::vector<float>& vector, int dimensions)
+    {
+        if (dimensions <= 0 || vector.size() <= static_cast<size_t>(dimensions)) {
+            return;
+        }
+        vector.resize(static_cast<size_t>(dimensions));
+        double normSquared = 0.0;
+        for (const float value : vector) {
+            normSquared += static_cast<double>(value) * value;
+        }
+        if (normSquared > 0.0) {
+            const float scale = static_cast<float>(1.0 / std::sqrt(normSquared));
+            for (float& value : vector) {
+                value *= scale;
+            }
+        }
+    }
+
+protected:
+    /**
+     * @brief Runs send() once per batch from splitEmbeddingBatches() and joins the results.
+     *
+     * Stops at the first failed batch. A batch that returns a different number
+     * of vectors than it was sent is reported as an error.
+     */
+    static EmbeddingBatchResult embedInBatches(
+        const QStringList& texts,
+        int maxItems,
+        int maxTokens,
+        const std::function<EmbeddingBatchResult(const QStringList& batch)>& send)
+    {
+        EmbeddingBatchResult result;
+        result.vectors.reserve(static_cast<size_t>(texts.size()));
+        for (const QStringList& batch : splitEmbeddingBatches(texts, maxItems, maxTokens)) {
+            EmbeddingBatchResult part = send(batch);
+            result.usage.inputTokens += part.usage.inputTokens;
+            result.usage.outputTokens += part.usage.outputTokens;
+            result.usage.totalTokens += part.usage.totalTokens;
+            if (!part.hasError && part.vectors.size() != static_cast<size_t>(batch.size())) {
+                part.hasError = true;
+                part.errorMsg = QStringLiteral("Embedding batch returned %1 vectors for %2 inputs")
+                                    .arg(static_cast<qulonglong>(part.vectors.size()))
+                                    .arg(batch.size());
+            }
+            if (part.hasError) {
+                result.vectors.clear();
+                result.hasError = true;
+                result.errorMsg = part.errorMsg;
+                return result;
+            }
+            for (auto& vector : part.vectors) {
+                result.vectors.push_back(std::move(vector));
+            }
+        }
+        return result;
+    }
 };
@@ -0,0 +1,91 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "JsonPayload.h"
+
+#include <QJsonDocument>
+#include <QRandomGenerator>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// A multiple of 3, so the chunks encode to the same text as the whole buffer
+constexpr qsizetype kEncodeChunkBytes = 3 * 64 * 1024;
+
+qsizetype base64Size(qsizetype bytes)
+{
+    return (bytes + 2) / 3 * 4;
+}
+
+} // namespace
+
+JsonPayload::JsonPayload()
+    : m_tag(QByteArray::number(QRandomGenerator::global()->generate64(), 16))
+{
+}
+
+QString JsonPayload::base64(const QByteArray& data)
+{
+    m_data.append(data);
+    return QString::fromLatin1(marker(m_data.size() - 1));
+}
+
+std::string JsonPayload::serialize(const QJsonObject& root) const
+{
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Compact);
+
+    std::vector<std::pair<qsizetype, int>> positions;
+    qsizetype finalSize = json.size();
+    for (int i = 0; i < m_data.size(); ++i) {
+        const qsizetype position = json.indexOf(marker(i));
+        if (position < 0) continue;
+        positions.emplace_back(position, i);
+        finalSize += base64Size(m_data.at(i).size()) - marker(i).size();
+    }
+    std::sort(positions.begin(), positions.end());
+
+    std::string body;
+    body.reserve(static_cast<size_t>(finalSize));
+    qsizetype copied = 0;
+    for (const auto& [position, index] : positions) {
+        body.append(json.constData() + copied, static_cast<size_t>(position - copied));
+        const QByteArray& data = m_data.at(index);
+        for (qsizetype offset = 0; offset < data.size(); offset += kEncodeChunkBytes) {
+            const qsizetype length = std::min(kEncodeChunkBytes, data.size() - offset);
+            const QByteArray encoded = QByteArray::fromRawData(data.constData() + offset, length).toBase64();
+            body.append(encoded.constData(), static_cast<size_t>(encoded.size()));
+        }
+        copied = position + marker(index).size();
+    }
+    body.append(json.constData() + copied, static_cast<size_t>(json.size() - copied));
+    return body;
+}
+
+QByteArray JsonPayload::marker(int index) const
+{
+    // Letters, digits and dashes only, so JSON serialisation leaves it untouched
+    return QByteArrayLiteral("cp-inline-") + m_tag + '-' + QByteArray::number(index) + QByteArrayLiteral("-end");
+}
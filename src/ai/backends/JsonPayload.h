@@ -0,0 +1,54 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+
+#include <string>
+
+// Serialises a request body whose inline attachments are base64-encoded straight
+// into the final buffer. Building the JSON with the encoded data in place means
+// holding the base64 bytes, a UTF-16 QString copy, the serialised document and
+// the std::string body all at once; a large PDF becomes several times its size
+// in memory. Instead, base64() returns a short placeholder to put in the JSON and
+// serialize() swaps each placeholder for the encoding of the attachment, written
+// in chunks into a body reserved at its final size.
+class JsonPayload {
+public:
+    JsonPayload();
+
+    // Placeholder for the base64 of data; the bytes are shared, not copied
+    QString base64(const QByteArray& data);
+
+    std::string serialize(const QJsonObject& root) const;
+
+private:
+    QByteArray marker(int index) const;
+
+    QByteArray m_tag;
+    QList<QByteArray> m_data;
+};
@@ -0,0 +1,349 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "JsonReader.h"
+
+#include <QtGlobal>
+
+#include <climits>
+
+namespace {
+
+bool isNumberByte(char c)
+{
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+} // namespace
+
+JsonReader::JsonReader(QByteArrayView json)
+    : m_json(json)
+{
+}
+
+JsonReader::Type JsonReader::peek()
+{
+    skipWhitespace();
+    if (m_error || m_pos >= m_json.size()) {
+        return Type::Invalid;
+    }
+    switch (m_json[m_pos]) {
+    case '{': return Type::Object;
+    case '[': return Type::Array;
+    case '"': return Type::String;
+    case 't':
+    case 'f': return Type::Bool;
+    case 'n': return Type::Null;
+    default: return isNumberByte(m_json[m_pos]) ? Type::Number : Type::Invalid;
+    }
+}
+
+bool JsonReader::enterObject()
+{
+    if (peek() != Type::Object) {
+        return fail();
+    }
+    ++m_pos;
+    m_first = true;
+    return true;
+}
+
+bool JsonReader::nextKey(QByteArrayView& key)
+{
+    skipWhitespace();
+    if (m_error || m_pos >= m_json.size()) {
+        return fail();
+    }
+    if (m_json[m_pos] == '}') {
+        ++m_pos;
+        m_first = false;
+        return false;
+    }
+    if (!m_first) {
+        if (m_json[m_pos] != ',') {
+            return fail();
+        }
+        ++m_pos;
+        skipWhitespace();
+    }
+    m_first = false;
+    bool escaped = false;
+    if (!scanString(key, escaped)) {
+        return false;
+    }
+    skipWhitespace();
+    if (m_pos >= m_json.size() || m_json[m_pos] != ':') {
+        return fail();
+    }
+    ++m_pos;
+    return true;
+}
+
+bool JsonReader::enterArray()
+{
+    if (peek() != Type::Array) {
+        return fail();
+    }
+    ++m_pos;
+    m_first = true;
+    return true;
+}
+
+bool JsonReader::nextElement()
+{
+    skipWhitespace();
+    if (m_error || m_pos >= m_json.size()) {
+        return fail();
+    }
+    if (m_json[m_pos] == ']') {
+        ++m_pos;
+        m_first = false;
+        return false;
+    }
+    if (!m_first) {
+        if (m_json[m_pos] != ',') {
+            return fail();
+        }
+        ++m_pos;
+    }
+    m_first = false;
+    return true;
+}
+
+bool JsonReader::readString(QString& value)
+{
+    if (peek() != Type::String) {
+        return fail();
+    }
+    QByteArrayView raw;
+    bool escaped = false;
+    if (!scanString(raw, escaped)) {
+        return false;
+    }
+    if (!escaped) {
+        value = QString::fromUtf8(raw);
+        return true;
+    }
+
+    value.clear();
+    value.reserve(raw.size());
+    qsizetype start = 0;
+    for (qsizetype i = 0; i < raw.size(); ++i) {
+        if (raw[i] != '\\') {
+            continue;
+        }
+        value += QString::fromUtf8(raw.sliced(start, i - start));
+        if (++i >= raw.size()) {
+            return fail();
+        }
+        switch (raw[i]) {
+        case '"': value += u'"'; break;
+        case '\\': value += u'\\'; break;
+        case '/': value += u'/'; break;
+        case 'b': value += u'\b'; break;
+        case 'f': value += u'\f'; break;
+        case 'n': value += u'\n'; break;
+        case 'r': value += u'\r'; break;
+        case 't': value += u'\t'; break;
+        case 'u': {
+            if (i + 4 >= raw.size()) {
+                return fail();
+            }
+            char16_t unit = 0;
+            for (int digit = 1; digit <= 4; ++digit) {
+                const int nibble = hexValue(raw[i + digit]);
+                if (nibble < 0) {
+                    return fail();
+                }
+                unit = static_cast<char16_t>(unit * 16 + nibble);
+            }
+            // Surrogate pairs arrive as two escapes, which is already UTF-16
+            value += QChar(unit);
+            i += 4;
+            break;
+        }
+        default:
+            return fail();
+        }
+        start = i + 1;
+    }
+    value += QString::fromUtf8(raw.sliced(start));
+    return true;
+}
+
+bool JsonReader::readNumber(double& value)
+{
+    if (peek() != Type::Number) {
+        return fail();
+    }
+    return scanNumber(value);
+}
+
+bool JsonReader::readInt(int& value)
+{
+    double number = 0;
+    if (!readNumber(number)) {
+        return false;
+    }
+    value = static_cast<int>(qBound(static_cast<double>(INT_MIN), number, static_cast<double>(INT_MAX)));
+    return true;
+}
+
+bool JsonReader::readFloats(std::vector<float>& values)
+{
+    if (!enterArray()) {
+        return false;
+    }
+    while (nextElement()) {
+        skipWhitespace();
+        double number = 0;
+        if (!scanNumber(number)) {
+            return false;
+        }
+        values.push_back(static_cast<float>(number));
+    }
+    return !m_error;
+}
+
+bool JsonReader::skipValue()
+{
+    QByteArrayView raw;
+    bool escaped = false;
+    double number = 0;
+    switch (peek()) {
+    case Type::String:
+        return scanString(raw, escaped);
+    case Type::Number:
+        return scanNumber(number);
+    case Type::Bool:
+        return scanLiteral(m_json[m_pos] == 't' ? QByteArrayView("true") : QByteArrayView("false"));
+    case Type::Null:
+        return scanLiteral(QByteArrayView("null"));
+    case Type::Invalid:
+        return fail();
+    case Type::Object:
+    case Type::Array:
+        break;
+    }
+
+    // Containers are skipped by bracket depth, stepping over strings whole
+    int depth = 0;
+    while (m_pos < m_json.size()) {
+        const char c = m_json[m_pos];
+        if (c == '"') {
+            if (!scanString(raw, escaped)) {
+                return false;
+            }
+            continue;
+        }
+        ++m_pos;
+        if (c == '{' || c == '[') {
+            ++depth;
+        } else if (c == '}' || c == ']') {
+            if (--depth == 0) {
+                return true;
+            }
+        }
+    }
+    return fail();
+}
+
+QString JsonReader::errorString() const
+{
+    if (!m_error) {
+        return QString();
+    }
+    return QStringLiteral("unexpected input at offset %1").arg(m_pos);
+}
+
+void JsonReader::skipWhitespace()
+{
+    while (m_pos < m_json.size()) {
+        const char c = m_json[m_pos];
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+            return;
+        }
+        ++m_pos;
+    }
+}
+
+bool JsonReader::scanString(QByteArrayView& raw, bool& escaped)
+{
+    if (m_pos >= m_json.size() || m_json[m_pos] != '"') {
+        return fail();
+    }
+    const qsizetype start = ++m_pos;
+    escaped = false;
+    while (m_pos < m_json.size()) {
+        const char c = m_json[m_pos];
+        if (c == '"') {
+            raw = m_json.sliced(start, m_pos - start);
+            ++m_pos;
+            return true;
+        }
+        if (c == '\\') {
+            escaped = true;
+            ++m_pos;
+        }
+        ++m_pos;
+    }
+    return fail();
+}
+
+bool JsonReader::scanNumber(double& value)
+{
+    const qsizetype start = m_pos;
+    while (m_pos < m_json.size() && isNumberByte(m_json[m_pos])) {
+        ++m_pos;
+    }
+    bool ok = false;
+    value = m_json.sliced(start, m_pos - start).toDouble(&ok);
+    if (!ok) {
+        m_pos = start;
+        return fail();
+    }
+    return true;
+}
+
+bool JsonReader::scanLiteral(QByteArrayView literal)
+{
+    if (m_json.sliced(m_pos).startsWith(literal)) {
+        m_pos += literal.size();
+        return true;
+    }
+    return fail();
+}
+
+bool JsonReader::fail()
+{
+    m_error = true;
+    return false;
+}
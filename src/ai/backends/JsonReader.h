@@ -0,0 +1,77 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArrayView>
+#include <QString>
+
+#include <vector>
+
+// Forward-only reader over a JSON body, the counterpart of JsonPayload. Backends
+// walk a response with it and keep only the members they need, so a batch of
+// embeddings goes straight from the HTTP buffer into float vectors instead of
+// through a QJsonDocument of one QJsonValue per number. The body must outlive the
+// reader. Malformed input puts it in an error state in which every call returns
+// false; skipped containers are only checked for balanced brackets.
+class JsonReader {
+public:
+    enum class Type { Invalid, Null, Bool, Number, String, Array, Object };
+
+    explicit JsonReader(QByteArrayView json);
+
+    // Type of the next value, without consuming it
+    Type peek();
+
+    // Containers: enter one, then call nextKey()/nextElement() until they return
+    // false at its end. Each true return must be followed by reading or skipping
+    // exactly one value.
+    bool enterObject();
+    bool nextKey(QByteArrayView& key);
+    bool enterArray();
+    bool nextElement();
+
+    bool readString(QString& value);
+    bool readNumber(double& value);
+    bool readInt(int& value);
+    // An array of numbers, appended to values
+    bool readFloats(std::vector<float>& values);
+    bool skipValue();
+
+    bool hasError() const { return m_error; }
+    QString errorString() const;
+
+private:
+    void skipWhitespace();
+    // Raw bytes of the next string, without the quotes; escapes left in place
+    bool scanString(QByteArrayView& raw, bool& escaped);
+    bool scanNumber(double& value);
+    bool scanLiteral(QByteArrayView literal);
+    bool fail();
+
+    QByteArrayView m_json;
+    qsizetype m_pos {0};
+    // Set on entering a container, so the first member needs no comma
+    bool m_first {false};
+    bool m_error {false};
+};
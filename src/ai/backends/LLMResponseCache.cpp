@@ -0,0 +1,162 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "LLMResponseCache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QMutex>
+#include <QStandardPaths>
+
+namespace {
+
+constexpr quint32 kEntryMagic = 0x43504c52; // "CPLR"
+constexpr quint32 kEntryVersion = 1;
+
+QMutex g_sharedMutex;
+std::shared_ptr<LLMResponseCache> g_shared;
+bool g_sharedConfigured = false;
+
+} // namespace
+
+LLMResponseCache::LLMResponseCache(const QString& directory, qint64 ttlSeconds, qint64 maxBytes)
+    : m_ttlSeconds(ttlSeconds)
+    , m_store(directory, maxBytes > 0 ? maxBytes : kDefaultMaxBytes, {QStringLiteral("*.bin")})
+{
+}
+
+std::shared_ptr<LLMResponseCache> LLMResponseCache::shared()
+{
+    QMutexLocker locker(&g_sharedMutex);
+    if (!g_sharedConfigured) {
+        g_sharedConfigured = true;
+        const QString configured = qEnvironmentVariable("CP_LLM_RESPONSE_CACHE").trimmed();
+        if (configured == QStringLiteral("1")) {
+            g_shared = std::make_shared<LLMResponseCache>(defaultDirectory());
+        } else if (!configured.isEmpty() && configured != QStringLiteral("0")) {
+            g_shared = std::make_shared<LLMResponseCache>(configured);
+        }
+    }
+    return g_shared;
+}
+
+void LLMResponseCache::setShared(std::shared_ptr<LLMResponseCache> cache)
+{
+    QMutexLocker locker(&g_sharedMutex);
+    g_shared = std::move(cache);
+    g_sharedConfigured = true;
+}
+
+QString LLMResponseCache::defaultDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/llm_responses");
+}
+
+QString LLMResponseCache::makeKey(const QString& providerId,
+                                  const QString& modelId,
+                                  double temperature,
+                                  int maxTokens,
+                                  const QString& systemPrompt,
+                                  const QString& userPrompt,
+                                  const LLMMessage& message)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    DiskLruStore::addField(hash, providerId.trimmed().toLower().toUtf8());
+    DiskLruStore::addField(hash, modelId.trimmed().toUtf8());
+    DiskLruStore::addField(hash, QByteArray::number(temperature, 'g', 6));
+    DiskLruStore::addField(hash, QByteArray::number(maxTokens));
+    DiskLruStore::addField(hash, systemPrompt.toUtf8());
+    DiskLruStore::addField(hash, userPrompt.toUtf8());
+    for (const LLMAttachment& attachment : message.attachments) {
+        DiskLruStore::addField(hash, attachment.mimeType.toUtf8());
+        DiskLruStore::addField(hash, QCryptographicHash::hash(attachment.data, QCryptographicHash::Sha256));
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QString LLMResponseCache::entryPath(const QString& key) const
+{
+    return m_store.entryPath(key, QStringLiteral(".bin"));
+}
+
+std::optional<LLMResult> LLMResponseCache::lookup(const QString& key)
+{
+    if (key.isEmpty()) return std::nullopt;
+
+    QFile file(entryPath(key));
+    if (!file.open(QIODevice::ReadOnly)) return std::nullopt;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint64 storedAt = 0;
+    LLMResult result;
+    qint32 inputTokens = 0;
+    qint32 outputTokens = 0;
+    qint32 totalTokens = 0;
+    in >> magic >> version >> storedAt;
+    if (magic != kEntryMagic || version != kEntryVersion) return std::nullopt;
+
+    const qint64 ageMs = QDateTime::currentMSecsSinceEpoch() - storedAt;
+    if (m_ttlSeconds > 0 && ageMs > m_ttlSeconds * 1000) {
+        file.close();
+        m_store.remove(entryPath(key));
+        return std::nullopt;
+    }
+
+    in >> result.content >> result.rawResponse >> inputTokens >> outputTokens >> totalTokens;
+    if (in.status() != QDataStream::Ok) return std::nullopt;
+    result.usage.inputTokens = inputTokens;
+    result.usage.outputTokens = outputTokens;
+    result.usage.totalTokens = totalTokens;
+    return result;
+}
+
+bool LLMResponseCache::store(const QString& key, const LLMResult& result)
+{
+    if (key.isEmpty() || result.hasError) return false;
+
+    return m_store.write(entryPath(key), [&result](QIODevice* file) {
+        QDataStream out(file);
+        out.setVersion(QDataStream::Qt_6_0);
+        out << kEntryMagic << kEntryVersion << QDateTime::currentMSecsSinceEpoch()
+            << result.content << result.rawResponse
+            << static_cast<qint32>(result.usage.inputTokens)
+            << static_cast<qint32>(result.usage.outputTokens)
+            << static_cast<qint32>(result.usage.totalTokens);
+        return out.status() == QDataStream::Ok;
+    });
+}
+
+qint64 LLMResponseCache::sizeBytes() const
+{
+    return m_store.sizeBytes();
+}
+
+void LLMResponseCache::clear()
+{
+    m_store.clear();
+}
@@ -0,0 +1,87 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QString>
+
+#include <memory>
+#include <optional>
+
+#include "DiskLruStore.h"
+#include "ai/backends/ILLMBackend.h"
+
+// Opt-in, on-disk cache of chat responses for deterministic requests.
+//
+// A request is deterministic when it runs at temperature 0; the key hashes the
+// provider, model, temperature, token limit, both prompts and every attachment
+// (MIME type and SHA-256 of its bytes). Entries are single files written with
+// QSaveFile, like ResultCache, and carry their creation time: lookups past the
+// TTL delete the entry and miss. The files live in a DiskLruStore trimmed to
+// maxBytes. Error results are never stored.
+//
+// No cache is active by default. The shared instance is enabled from the
+// Pipeline menu, or at start-up by setting CP_LLM_RESPONSE_CACHE to a
+// directory (or to "1" for defaultDirectory()).
+class LLMResponseCache {
+public:
+    static constexpr qint64 kDefaultTtlSeconds = 7 * 24 * 60 * 60;
+    static constexpr qint64 kDefaultMaxBytes = 64LL * 1024 * 1024;
+
+    explicit LLMResponseCache(const QString& directory,
+                              qint64 ttlSeconds = kDefaultTtlSeconds,
+                              qint64 maxBytes = kDefaultMaxBytes);
+
+    // The cache UniversalLLMNode consults, or nullptr while caching is off.
+    static std::shared_ptr<LLMResponseCache> shared();
+    static void setShared(std::shared_ptr<LLMResponseCache> cache);
+    static QString defaultDirectory();
+
+    static bool isDeterministicRequest(double temperature) { return temperature <= 0.0; }
+
+    static QString makeKey(const QString& providerId,
+                           const QString& modelId,
+                           double temperature,
+                           int maxTokens,
+                           const QString& systemPrompt,
+                           const QString& userPrompt,
+                           const LLMMessage& message);
+
+    const QString& directory() const { return m_store.directory(); }
+
+    std::optional<LLMResult> lookup(const QString& key);
+
+    // Stores the result unless it reports an error.
+    bool store(const QString& key, const LLMResult& result);
+
+    // Bytes of entries on disk, as tracked by this process.
+    qint64 sizeBytes() const;
+
+    void clear();
+
+private:
+    QString entryPath(const QString& key) const;
+
+    qint64 m_ttlSeconds;
+    DiskLruStore m_store;
+};
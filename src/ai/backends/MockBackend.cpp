@@ -0,0 +1,461 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "MockBackend.h"
+
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QScopeGuard>
+#include <QThread>
+#include <QtConcurrent>
+
+#include <cmath>
+#include <random>
+
+#include "BackendCancellation.h"
+#include "BackendRateLimit.h"
+#include "ModelCapsRegistry.h"
+#include "Logger.h"
+
+namespace {
+
+// Longest single sleep, so a cancelled run is noticed quickly
+constexpr int kWaitSliceMs = 20;
+// Streamed text is handed over about this often
+constexpr int kStreamIntervalMs = 50;
+
+// Sleeps for @p ms; false when the run was cancelled first
+bool waitFor(double ms, const CancellationToken& cancellation)
+{
+    QElapsedTimer timer;
+    timer.start();
+    const qint64 total = static_cast<qint64>(ms);
+    while (timer.elapsed() < total) {
+        if (cancellation.isCancelled()) {
+            return false;
+        }
+        QThread::msleep(static_cast<unsigned long>(qMin<qint64>(kWaitSliceMs, total - timer.elapsed())));
+    }
+    return !cancellation.isCancelled();
+}
+
+MockBackend::Distribution distributionFromName(const QString& name, MockBackend::Distribution fallback)
+{
+    const QString key = name.trimmed().toLower();
+    if (key == QLatin1String("fixed")) return MockBackend::Distribution::Fixed;
+    if (key == QLatin1String("uniform")) return MockBackend::Distribution::Uniform;
+    if (key == QLatin1String("normal")) return MockBackend::Distribution::Normal;
+    if (key == QLatin1String("lognormal")) return MockBackend::Distribution::LogNormal;
+    return fallback;
+}
+
+QVariantMap providerOptions()
+{
+    const auto settings = ModelCapsRegistry::instance().providerSettings(QString::fromLatin1(MockBackend::kProviderId));
+    return settings ? settings->options : QVariantMap();
+}
+
+// CP_MOCK_LLM_OPTIONS, read once: the same keys as the catalogue options, for headless runs
+const QVariantMap& environmentOptions()
+{
+    static const QVariantMap options = []() {
+        const QByteArray value = qgetenv("CP_MOCK_LLM_OPTIONS");
+        if (value.trimmed().isEmpty()) {
+            return QVariantMap();
+        }
+        QJsonParseError error;
+        const QJsonDocument doc = QJsonDocument::fromJson(value, &error);
+        if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+            CP_WARN << "MockBackend: CP_MOCK_LLM_OPTIONS is not a JSON object:" << error.errorString();
+            return QVariantMap();
+        }
+        return doc.object().toVariantMap();
+    }();
+    return options;
+}
+
+// Model names configured under options.models
+QStringList configuredModels()
+{
+    QStringList models = providerOptions().value(QStringLiteral("models")).toMap().keys();
+    for (const QString& model : environmentOptions().value(QStringLiteral("models")).toMap().keys()) {
+        if (!models.contains(model)) {
+            models.append(model);
+        }
+    }
+    return models;
+}
+
+bool isEmbeddingModel(const QString& model)
+{
+    return model.contains(QStringLiteral("embed"), Qt::CaseInsensitive);
+}
+
+// One filler word per output token
+QString fillerText(int tokens)
+{
+    static const QStringList words = QStringLiteral(
+        "the pipeline node returned a simulated answer for load testing with steady token output "
+        "and no real model behind it so latency and throughput can be measured cheaply")
+                                         .split(u' ');
+    QString text;
+    text.reserve(tokens * 8);
+    for (int i = 0; i < tokens; ++i) {
+        if (i > 0) {
+            text += u' ';
+        }
+        text += words.at(i % words.size());
+    }
+    return text;
+}
+
+// A unit vector that depends only on the text
+std::vector<float> hashedVector(const QString& text, int dimensions)
+{
+    quint64 state = qHash(text) | 1u;
+    std::vector<float> vector(static_cast<size_t>(qMax(1, dimensions)));
+    double norm = 0.0;
+    for (float& value : vector) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        value = static_cast<float>(state >> 40) / static_cast<float>(1 << 23) - 1.0f;
+        norm += static_cast<double>(value) * value;
+    }
+    const float scale = norm > 0.0 ? static_cast<float>(1.0 / std::sqrt(norm)) : 0.0f;
+    for (float& value : vector) {
+        value *= scale;
+    }
+    return vector;
+}
+
+cpr::Response rejectedResponse(int status, int retryAfterMs)
+{
+    cpr::Response response;
+    response.status_code = status;
+    if (status == 429) {
+        response.header["retry-after-ms"] = std::to_string(retryAfterMs);
+        response.text = R"({"error":"simulated rate limit"})";
+    } else {
+        response.text = R"({"error":"simulated server error"})";
+    }
+    return response;
+}
+
+QString responseErrorMessage(const cpr::Response& response, const CancellationToken& cancellation)
+{
+    if (cancellation.isCancelled()) {
+        return BackendCancellation::message();
+    }
+    if (response.error) {
+        return QStringLiteral("Mock provider error: %1").arg(QString::fromStdString(response.error.message));
+    }
+    const QString detail = QJsonDocument::fromJson(QByteArray::fromStdString(response.text))
+                               .object()
+                               .value(QStringLiteral("error"))
+                               .toString();
+    return QStringLiteral("Mock provider HTTP %1: %2").arg(response.status_code).arg(detail);
+}
+
+} // namespace
+
+MockBackend::Profile MockBackend::Profile::fromOptions(const QVariantMap& options, const Profile& base)
+{
+    Profile profile = base;
+    const auto number = [&](const char* key, double fallback) {
+        bool ok = false;
+        const double value = options.value(QString::fromLatin1(key)).toDouble(&ok);
+        return ok && value >= 0.0 ? value : fallback;
+    };
+    profile.firstTokenMs = number("first_token_ms", profile.firstTokenMs);
+    profile.distribution = distributionFromName(options.value(QStringLiteral("latency_distribution")).toString(),
+                                                profile.distribution);
+    profile.spread = number("latency_spread", profile.spread);
+    profile.tokensPerSecond = number("tokens_per_second", profile.tokensPerSecond);
+    profile.outputTokens = static_cast<int>(number("output_tokens", profile.outputTokens));
+    profile.rateLimitRate = qBound(0.0, number("rate_limit_rate", profile.rateLimitRate), 1.0);
+    profile.retryAfterMs = static_cast<int>(number("retry_after_ms", profile.retryAfterMs));
+    profile.serverErrorRate = qBound(0.0, number("server_error_rate", profile.serverErrorRate), 1.0);
+    profile.errorLatencyMs = static_cast<int>(number("error_latency_ms", profile.errorLatencyMs));
+    profile.maxConcurrent = static_cast<int>(number("max_concurrent", profile.maxConcurrent));
+    profile.embeddingDimensions = qMax(1, static_cast<int>(number("embedding_dimensions", profile.embeddingDimensions)));
+    profile.embeddingLatencyMs = number("embedding_latency_ms", profile.embeddingLatencyMs);
+    return profile;
+}
+
+double MockBackend::Profile::sampleMs(double medianMs) const
+{
+    if (medianMs <= 0.0 || spread <= 0.0) {
+        return qMax(0.0, medianMs);
+    }
+    QRandomGenerator* random = QRandomGenerator::global();
+    switch (distribution) {
+    case Distribution::Fixed:
+        return medianMs;
+    case Distribution::Uniform:
+        return qMax(0.0, medianMs * (1.0 + spread * (2.0 * random->generateDouble() - 1.0)));
+    case Distribution::Normal:
+        return qMax(0.0, std::normal_distribution<double>(medianMs, medianMs * spread)(*random));
+    case Distribution::LogNormal:
+        return medianMs * std::exp(spread * std::normal_distribution<double>(0.0, 1.0)(*random));
+    }
+    return medianMs;
+}
+
+MockBackend::Profile MockBackend::profileFor(const QString& modelName)
+{
+    const QVariantMap provider = providerOptions();
+    const QVariantMap& environment = environmentOptions();
+    Profile profile = Profile::fromOptions(provider);
+    profile = Profile::fromOptions(provider.value(QStringLiteral("models")).toMap().value(modelName).toMap(), profile);
+    profile = Profile::fromOptions(environment, profile);
+    return Profile::fromOptions(environment.value(QStringLiteral("models")).toMap().value(modelName).toMap(), profile);
+}
+
+MockBackend::MockBackend() = default;
+
+QString MockBackend::id() const
+{
+    return QString::fromLatin1(kProviderId);
+}
+
+QString MockBackend::name() const
+{
+    return QStringLiteral("Mock (Load Testing)");
+}
+
+QStringList MockBackend::availableModels() const
+{
+    QStringList models{QString::fromLatin1(kChatModel)};
+    for (const QString& model : configuredModels()) {
+        if (!isEmbeddingModel(model) && !models.contains(model)) {
+            models.append(model);
+        }
+    }
+    return models;
+}
+
+QStringList MockBackend::availableEmbeddingModels() const
+{
+    QStringList models{QString::fromLatin1(kEmbeddingModel)};
+    for (const QString& model : configuredModels()) {
+        if (isEmbeddingModel(model) && !models.contains(model)) {
+            models.append(model);
+        }
+    }
+    return models;
+}
+
+QFuture<QStringList> MockBackend::fetchModelList()
+{
+    const QStringList models = availableModels() + availableEmbeddingModels();
+    return QtConcurrent::run([models]() { return models; });
+}
+
+LLMResult MockBackend::sendPrompt(
+    const QString& apiKey,
+    const QString& modelName,
+    double temperature,
+    int maxTokens,
+    const QString& systemPrompt,
+    const QString& userPrompt,
+    const LLMMessage& message
+) {
+    Q_UNUSED(apiKey)
+    Q_UNUSED(temperature)
+    Q_UNUSED(message)
+    return promptRequest(modelName, maxTokens, systemPrompt, userPrompt, {});
+}
+
+LLMResult MockBackend::streamPrompt(
+    const QString& apiKey,
+    const QString& modelName,
+    double temperature,
+    int maxTokens,
+    const QString& systemPrompt,
+    const QString& userPrompt,
+    const LLMStreamCallback& onDelta,
+    const LLMMessage& message
+) {
+    Q_UNUSED(apiKey)
+    Q_UNUSED(temperature)
+    Q_UNUSED(message)
+    return promptRequest(modelName, maxTokens, systemPrompt, userPrompt, onDelta);
+}
+
+LLMResult MockBackend::promptRequest(const QString& modelName, int maxTokens, const QString& systemPrompt,
+                                     const QString& userPrompt, const LLMStreamCallback& onDelta)
+{
+    LLMResult result;
+    const CancellationToken cancellation = CancellationToken::current();
+    const QString model = modelName.trimmed().isEmpty() ? QString::fromLatin1(kChatModel) : modelName.trimmed();
+    const Profile profile = profileFor(model);
+    const int outputTokens = maxTokens > 0 ? qMin(profile.outputTokens, maxTokens) : profile.outputTokens;
+    const QStringList words = fillerText(outputTokens).split(u' ', Qt::SkipEmptyParts);
+    const double msPerToken = profile.tokensPerSecond > 0.0 ? 1000.0 / profile.tokensPerSecond : 0.0;
+
+    ProviderRateLimiter::Permit permit;
+    const cpr::Response response = BackendRateLimit::send(
+        permit, id(), model, ProviderRateLimiter::estimateTokens(systemPrompt.size() + userPrompt.size(), maxTokens),
+        cancellation, [&]() -> cpr::Response {
+            const int inFlight = ++m_inFlight;
+            const auto release = qScopeGuard([this]() { --m_inFlight; });
+            QRandomGenerator* random = QRandomGenerator::global();
+            const bool overCapacity = profile.maxConcurrent > 0 && inFlight > profile.maxConcurrent;
+            const int rejection = (overCapacity || random->generateDouble() < profile.rateLimitRate) ? 429
+                : random->generateDouble() < profile.serverErrorRate                    ? 503
+                                                                                          : 0;
+            if (rejection != 0) {
+                return waitFor(profile.errorLatencyMs, cancellation)
+                    ? rejectedResponse(rejection, profile.retryAfterMs)
+                    : BackendRateLimit::cancelledResponse();
+            }
+
+            if (!waitFor(profile.sampleMs(profile.firstTokenMs), cancellation)) {
+                return BackendRateLimit::cancelledResponse();
+            }
+            // Streams in pieces of about kStreamIntervalMs worth of tokens
+            const int tokensPerPiece = onDelta && msPerToken > 0.0
+                ? qMax(1, static_cast<int>(kStreamIntervalMs / msPerToken))
+                : qMax(1, static_cast<int>(words.size()));
+            for (qsizetype at = 0; at < words.size(); at += tokensPerPiece) {
+                const qsizetype count = qMin<qsizetype>(tokensPerPiece, words.size() - at);
+                if (at > 0 && !waitFor(count * msPerToken, cancellation)) {
+                    return BackendRateLimit::cancelledResponse();
+                }
+                if (onDelta) {
+                    onDelta((at > 0 ? QStringLiteral(" ") : QString()) + words.mid(at, count).join(u' '));
+                }
+            }
+            cpr::Response ok;
+            ok.status_code = 200;
+            return ok;
+        });
+
+    if (response.error || response.status_code != 200) {
+        result.hasError = true;
+        BackendRateLimit::markTransient(result, response);
+        result.errorMsg = responseErrorMessage(response, cancellation);
+        result.content = result.errorMsg;
+        return result;
+    }
+
+    result.content = words.join(u' ');
+    result.usage.inputTokens = ProviderRateLimiter::estimateTokens(systemPrompt.size() + userPrompt.size());
+    result.usage.outputTokens = static_cast<int>(words.size());
+    result.usage.totalTokens = result.usage.inputTokens + result.usage.outputTokens;
+    permit.settle(result.usage.totalTokens);
+    return result;
+}
+
+EmbeddingResult MockBackend::getEmbedding(
+    const QString& apiKey,
+    const QString& modelName,
+    const QString& text
+) {
+    const EmbeddingBatchResult batch = getEmbeddings(apiKey, modelName, QStringList{text});
+    EmbeddingResult result;
+    result.usage = batch.usage;
+    result.hasError = batch.hasError;
+    result.errorMsg = batch.errorMsg;
+    if (!batch.vectors.empty()) {
+        result.vector = batch.vectors.front();
+    }
+    return result;
+}
+
+EmbeddingBatchResult MockBackend::getEmbeddings(
+    const QString& apiKey,
+    const QString& modelName,
+    const QStringList& texts
+) {
+    Q_UNUSED(apiKey)
+    EmbeddingBatchResult result;
+    const CancellationToken cancellation = CancellationToken::current();
+    const QString model = modelName.trimmed().isEmpty() ? QString::fromLatin1(kEmbeddingModel) : modelName.trimmed();
+    const Profile profile = profileFor(model);
+    qsizetype chars = 0;
+    for (const QString& text : texts) {
+        chars += text.size();
+    }
+
+    ProviderRateLimiter::Permit permit;
+    const cpr::Response response = BackendRateLimit::send(
+        permit, id(), model, ProviderRateLimiter::estimateTokens(chars), cancellation, [&]() -> cpr::Response {
+            const int inFlight = ++m_inFlight;
+            const auto release = qScopeGuard([this]() { --m_inFlight; });
+            QRandomGenerator* random = QRandomGenerator::global();
+            const bool overCapacity = profile.maxConcurrent > 0 && inFlight > profile.maxConcurrent;
+            if (overCapacity || random->generateDouble() < profile.rateLimitRate) {
+                return waitFor(profile.errorLatencyMs, cancellation) ? rejectedResponse(429, profile.retryAfterMs)
+                                                                     : BackendRateLimit::cancelledResponse();
+            }
+            if (random->generateDouble() < profile.serverErrorRate) {
+                return waitFor(profile.errorLatencyMs, cancellation) ? rejectedResponse(503, profile.retryAfterMs)
+                                                                     : BackendRateLimit::cancelledResponse();
+            }
+            if (!waitFor(profile.sampleMs(profile.embeddingLatencyMs), cancellation)) {
+                return BackendRateLimit::cancelledResponse();
+            }
+            cpr::Response ok;
+            ok.status_code = 200;
+            return ok;
+        });
+
+    if (response.error || response.status_code != 200) {
+        result.hasError = true;
+        result.errorMsg = responseErrorMessage(response, cancellation);
+        return result;
+    }
+
+    result.vectors.reserve(static_cast<size_t>(texts.size()));
+    for (const QString& text : texts) {
+        result.vectors.push_back(hashedVector(text, profile.embeddingDimensions));
+    }
+    result.usage.inputTokens = ProviderRateLimiter::estimateTokens(chars);
+    result.usage.totalTokens = result.usage.inputTokens;
+    permit.settle(result.usage.totalTokens);
+    return result;
+}
+
+QFuture<QString> MockBackend::generateImage(
+    const QString& prompt,
+    const QString& model,
+    const QString& size,
+    const QString& quality,
+    const QString& style,
+    const QString& targetDir
+) {
+    Q_UNUSED(prompt)
+    Q_UNUSED(model)
+    Q_UNUSED(size)
+    Q_UNUSED(quality)
+    Q_UNUSED(style)
+    Q_UNUSED(targetDir)
+
+    return QtConcurrent::run([]() -> QString {
+        return QStringLiteral("Mock image generation is not supported");
+    });
+}
@@ -0,0 +1,150 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include "ILLMBackend.h"
+
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+
+#include <atomic>
+
+/**
+ * @brief Simulated provider for load-testing pipelines without calling a real API.
+ *
+ * Registered as provider "mock". It is hidden from the model selectors until its
+ * entry in the model catalogue is enabled, but a pipeline that names it always
+ * runs against it. Requests go through BackendRateLimit like the real backends,
+ * so the provider's rate limits, the adaptive concurrency limit and the 429
+ * retries behave as they would in production.
+ *
+ * The simulation is read on every request from the catalogue provider's
+ * `options` (see Profile::fromOptions()), then `options.models.<model>` for the
+ * requested model, then the JSON object in `CP_MOCK_LLM_OPTIONS`. Answers are
+ * filler words, one per output token; embeddings are unit vectors derived from
+ * a hash of the text, so equal texts get equal vectors.
+ */
+class MockBackend : public ILLMBackend {
+public:
+    // How the time to first token and the embedding latency spread around their median
+    enum class Distribution {
+        Fixed,
+        Uniform,   // median × (1 ± spread)
+        Normal,    // standard deviation median × spread
+        LogNormal  // body at the median, long tail; sigma = spread
+    };
+
+    struct Profile {
+        double firstTokenMs {300.0};
+        Distribution distribution {Distribution::LogNormal};
+        double spread {0.3};
+        double tokensPerSecond {50.0};
+        int outputTokens {64};
+        // Chance that an attempt answers 429, and the Retry-After it sends
+        double rateLimitRate {0.0};
+        int retryAfterMs {1000};
+        // Chance that an attempt answers 503
+        double serverErrorRate {0.0};
+        // How fast a rejected attempt comes back
+        int errorLatencyMs {20};
+        // Requests served at once before the rest get 429; 0 for no limit
+        int maxConcurrent {0};
+        int embeddingDimensions {768};
+        double embeddingLatencyMs {50.0};
+
+        // Reads first_token_ms, latency_distribution (fixed, uniform, normal, lognormal),
+        // latency_spread, tokens_per_second, output_tokens, rate_limit_rate, retry_after_ms,
+        // server_error_rate, error_latency_ms, max_concurrent, embedding_dimensions and
+        // embedding_latency_ms over @p base; missing or invalid keys keep the base value
+        static Profile fromOptions(const QVariantMap& options, const Profile& base = Profile());
+        // Samples a delay around @p medianMs from the distribution
+        double sampleMs(double medianMs) const;
+    };
+
+    MockBackend();
+    ~MockBackend() override = default;
+
+    QString id() const override;
+    QString name() const override;
+    QStringList availableModels() const override;
+    QStringList availableEmbeddingModels() const override;
+    QFuture<QStringList> fetchModelList() override;
+
+    LLMResult sendPrompt(
+        const QString& apiKey,
+        const QString& modelName,
+        double temperature,
+        int maxTokens,
+        const QString& systemPrompt,
+        const QString& userPrompt,
+        const LLMMessage& message = {}
+    ) override;
+
+    LLMResult streamPrompt(
+        const QString& apiKey,
+        const QString& modelName,
+        double temperature,
+        int maxTokens,
+        const QString& systemPrompt,
+        const QString& userPrompt,
+        const LLMStreamCallback& onDelta,
+        const LLMMessage& message = {}
+    ) override;
+
+    EmbeddingResult getEmbedding(
+        const QString& apiKey,
+        const QString& modelName,
+        const QString& text
+    ) override;
+
+    EmbeddingBatchResult getEmbeddings(
+        const QString& apiKey,
+        const QString& modelName,
+        const QStringList& texts
+    ) override;
+
+    QFuture<QString> generateImage(
+        const QString& prompt,
+        const QString& model,
+        const QString& size,
+        const QString& quality,
+        const QString& style,
+        const QString& targetDir = QString()
+    ) override;
+
+    // The simulation for @p modelName as configured right now
+    static Profile profileFor(const QString& modelName);
+
+    static constexpr const char* kProviderId = "mock";
+    static constexpr const char* kChatModel = "mock-chat";
+    static constexpr const char* kEmbeddingModel = "mock-embed";
+
+private:
+    LLMResult promptRequest(const QString& modelName, int maxTokens, const QString& systemPrompt,
+                            const QString& userPrompt, const LLMStreamCallback& onDelta);
+
+    // Requests being answered, for Profile::maxConcurrent
+    std::atomic<int> m_inFlight {0};
+};
@@ -24,12 +24,22 @@
 #include "OllamaBackend.h"
 
 #include <cpr/cpr.h>
+#include <QDateTime>
+#include <QElapsedTimer>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QMutexLocker>
 #include <QtConcurrent>
 
+#include "BackendCancellation.h"
+#include "BackendRateLimit.h"
+#include "EmbeddingBatcher.h"
+#include "HttpConnectionPool.h"
+#include "JsonReader.h"
+#include "ProviderEndpoint.h"
+#include "RequestCompression.h"
+#include "StreamingResponse.h"
 #include "ModelCapsRegistry.h"
 #include "Logger.h"
 #include "LoggingCategories.h"
@@ -91,6 +101,45 @@ cpr::Header ollamaHeaders(const QString& apiKey, bool includeContentType)
     return headers;
 }
 
+// Adds the configured keep_alive and options to a request body. Request-specific
+// options (temperature, num_predict) override configured ones.
+void applyProviderTuning(QJsonObject& root, const QJsonObject& requestOptions = {})
+{
+    const auto settings = ModelCapsRegistry::instance().providerSettings(QStringLiteral("ollama"));
+    QJsonObject options = settings ? QJsonObject::fromVariantMap(settings->options) : QJsonObject();
+    for (auto it = requestOptions.constBegin(); it != requestOptions.constEnd(); ++it) {
+        options.insert(it.key(), it.value());
+    }
+    if (!options.isEmpty()) {
+        root.insert(QStringLiteral("options"), options);
+    }
+
+    const QString keepAlive = settings ? settings->keepAlive.trimmed() : QString();
+    if (!keepAlive.isEmpty()) {
+        bool isSeconds = false;
+        const int seconds = keepAlive.toInt(&isSeconds);
+        root.insert(QStringLiteral("keep_alive"), isSeconds ? QJsonValue(seconds) : QJsonValue(keepAlive));
+    }
+}
+
+// The API does not report OLLAMA_NUM_PARALLEL, so the settings (or the same
+// variable in our environment, for a local server) say how many requests per
+// model the server runs at once. Fan-out beyond that only queues on the server.
+void capConcurrencyToParallelSlots()
+{
+    int slots = 0;
+    if (const auto settings = ModelCapsRegistry::instance().providerSettings(QStringLiteral("ollama"))) {
+        slots = settings->parallel;
+    }
+    if (slots <= 0) {
+        slots = qEnvironmentVariableIntValue("OLLAMA_NUM_PARALLEL");
+    }
+    if (slots <= 0) {
+        slots = OllamaBackend::kDefaultParallelSlots;
+    }
+    LLMProviderRegistry::instance().concurrencyLimiter().setCeiling(QStringLiteral("ollama"), slots);
+}
+
 } // namespace
 
 OllamaBackend::OllamaBackend()
@@ -128,28 +177,8 @@ QStringList OllamaBackend::availableEmbeddingModels() const
 
 QString OllamaBackend::baseUrl() const
 {
-    const QByteArray envUrl = qgetenv("OLLAMA_BASE_URL");
-    if (!envUrl.isEmpty()) {
-        QString value = QString::fromUtf8(envUrl).trimmed();
-        while (value.endsWith(QLatin1Char('/'))) {
-            value.chop(1);
-        }
-        if (!value.isEmpty()) {
-            return value;
-        }
-    }
-
-    if (const auto settings = ModelCapsRegistry::instance().providerSettings(QStringLiteral("ollama"))) {
-        QString value = settings->baseUrl.trimmed();
-        while (value.endsWith(QLatin1Char('/'))) {
-            value.chop(1);
-        }
-        if (!value.isEmpty()) {
-            return value;
-        }
-    }
-
-    return QStringLiteral("http://127.0.0.1:11434");
+    return ProviderEndpoint::baseUrl(QStringLiteral("ollama"), "OLLAMA_BASE_URL",
+                                     QStringLiteral("http://127.0.0.1:11434"));
 }
 
 QFuture<QStringList> OllamaBackend::fetchModelList()
@@ -157,7 +186,7 @@ QFuture<QStringList> OllamaBackend::fetchModelList()
     return QtConcurrent::run([this]() -> QStringList {
         const QString url = baseUrl() + QStringLiteral("/api/tags");
 
-        const auto response = cpr::Get(
+        const auto response = HttpConnectionPool::get(
             cpr::Url{url.toStdString()},
             ollamaHeaders(QString(), false),
             cpr::ConnectTimeout{2000},
@@ -226,8 +255,35 @@ LLMResult OllamaBackend::sendPrompt(
     const QString& systemPrompt,
     const QString& userPrompt,
     const LLMMessage& message
+) {
+    return promptRequest(apiKey, modelName, temperature, maxTokens, systemPrompt, userPrompt, message, {});
+}
+
+LLMResult OllamaBackend::streamPrompt(
+    const QString& apiKey,
+    const QString& modelName,
+    double temperature,
+    int maxTokens,
+    const QString& systemPrompt,
+    const QString& userPrompt,
+    const LLMStreamCallback& onDelta,
+    const LLMMessage& message
+) {
+    return promptRequest(apiKey, modelName, temperature, maxTokens, systemPrompt, userPrompt, message, onDelta);
+}
+
+LLMResult OllamaBackend::promptRequest(
+    const QString& apiKey,
+    const QString& modelName,
+    double temperature,
+    int maxTokens,
+    const QString& systemPrompt,
+    const QString& userPrompt,
+    const LLMMessage& message,
+    const LLMStreamCallback& onDelta
 ) {
     LLMResult result;
+    const CancellationToken cancellation = CancellationToken::current();
 
     if (!message.attachments.isEmpty()) {
         result.hasError = true;
@@ -248,6 +304,13 @@ LLMResult OllamaBackend::sendPrompt(
         messages.append(systemMessage);
     }
 
+    for (const LLMTurn& turn : message.history) {
+        messages.append(QJsonObject{{QStringLiteral("role"), QStringLiteral("user")},
+                                    {QStringLiteral("content"), turn.prompt}});
+        messages.append(QJsonObject{{QStringLiteral("role"), QStringLiteral("assistant")},
+                                    {QStringLiteral("content"), turn.response}});
+    }
+
     QJsonObject userMessage;
     userMessage.insert(QStringLiteral("role"), QStringLiteral("user"));
     userMessage.insert(QStringLiteral("content"), userPrompt);
@@ -261,25 +324,78 @@ LLMResult OllamaBackend::sendPrompt(
 
     QJsonObject root;
     root.insert(QStringLiteral("model"), selectedModel);
-    root.insert(QStringLiteral("stream"), false);
+    // Streaming answers arrive as newline-delimited JSON chunks
+    const bool streaming = static_cast<bool>(onDelta);
+    root.insert(QStringLiteral("stream"), streaming);
     root.insert(QStringLiteral("messages"), messages);
-    root.insert(QStringLiteral("options"), options);
+    applyProviderTuning(root, options);
 
-    const QByteArray payload = QJsonDocument(root).toJson(QJsonDocument::Compact);
+    cpr::Header headers = ollamaHeaders(apiKey, true);
+    const std::string payload =
+        RequestCompression::encodeBody(id(), QJsonDocument(root).toJson(QJsonDocument::Compact).toStdString(), headers);
     const QString url = baseUrl() + QStringLiteral("/api/chat");
 
     CP_CLOG(cp_lifecycle).noquote() << "[ModelLifecycle] OllamaBackend::sendPrompt using model=" << selectedModel;
 
-    const auto response = cpr::Post(
-        cpr::Url{url.toStdString()},
-        ollamaHeaders(apiKey, true),
-        cpr::Body{payload.constData()},
-        cpr::ConnectTimeout{5000},
-        cpr::Timeout{120000}
-    );
+    // Each chunk carries a piece of message.content; the final one (done) carries usage
+    QString streamedText;
+    QJsonObject streamedFinal;
+    StreamingResponse stream(StreamingResponse::Framing::JsonLines, [&](const QJsonObject& event) {
+        const QString delta = event.value(QStringLiteral("message")).toObject().value(QStringLiteral("content")).toString();
+        if (!delta.isEmpty()) {
+            streamedText += delta;
+            onDelta(delta);
+        }
+        if (event.value(QStringLiteral("done")).toBool() || event.contains(QStringLiteral("error"))) {
+            streamedFinal = event;
+        }
+    });
+
+    capConcurrencyToParallelSlots();
+    ProviderRateLimiter::Permit permit;
+    auto response = BackendRateLimit::send(
+        permit, id(), selectedModel,
+        ProviderRateLimiter::estimateTokens(systemPrompt.size() + userPrompt.size(), maxTokens), cancellation,
+        [&] {
+            return streaming
+                ? HttpConnectionPool::post(
+                      cpr::Url{url.toStdString()},
+                      headers,
+                      cpr::Body{payload},
+                      cpr::ConnectTimeout{5000},
+                      cpr::Timeout{120000},
+                      BackendCancellation::progressCallback(cancellation),
+                      stream.writeCallback())
+                : HttpConnectionPool::post(
+                      cpr::Url{url.toStdString()},
+                      headers,
+                      cpr::Body{payload},
+                      cpr::ConnectTimeout{5000},
+                      cpr::Timeout{120000},
+                      BackendCancellation::progressCallback(cancellation));
+        });
+
+    // Reassemble a streamed answer into the non-streaming response shape parsed below
+    if (streaming) {
+        stream.finish();
+        if (response.status_code == 200) {
+            QJsonObject assembled = streamedFinal;
+            assembled.insert(QStringLiteral("message"), QJsonObject{{QStringLiteral("role"), QStringLiteral("assistant")},
+                                                                    {QStringLiteral("content"), streamedText}});
+            response.text = QJsonDocument(assembled).toJson(QJsonDocument::Compact).toStdString();
+        } else {
+            response.text = stream.raw();
+        }
+    }
 
     if (response.error) {
         result.hasError = true;
+        BackendRateLimit::markTransient(result, response);
+        if (cancellation.isCancelled()) {
+            result.errorMsg = BackendCancellation::message();
+            result.content = result.errorMsg;
+            return result;
+        }
         result.errorMsg = QStringLiteral("Ollama network error: %1")
                               .arg(QString::fromStdString(response.error.message));
         result.content = result.errorMsg;
@@ -291,6 +407,7 @@ LLMResult OllamaBackend::sendPrompt(
     result.rawResponse = QString::fromStdString(response.text);
     if (response.status_code != 200) {
         result.hasError = true;
+        BackendRateLimit::markTransient(result, response);
         result.errorMsg = responseErrorMessage(response);
         result.content = result.errorMsg;
         CP_WARN.noquote() << QStringLiteral("OllamaBackend::sendPrompt failure provider=ollama model=%1 status=%2 message=%3")
@@ -321,6 +438,7 @@ LLMResult OllamaBackend::sendPrompt(
     result.usage.inputTokens = obj.value(QStringLiteral("prompt_eval_count")).toInt(0);
     result.usage.outputTokens = obj.value(QStringLiteral("eval_count")).toInt(0);
     result.usage.totalTokens = result.usage.inputTokens + result.usage.outputTokens;
+    permit.settle(result.usage.totalTokens);
     return result;
 }
 
@@ -328,8 +446,33 @@ EmbeddingResult OllamaBackend::getEmbedding(
     const QString& apiKey,
     const QString& modelName,
     const QString& text
+) {
+    const QString key = EmbeddingBatcher::coalesceKey(id(), modelName, 0, apiKey);
+    return EmbeddingBatcher::firstOf(
+        EmbeddingBatcher::coalesce(key, QStringList{text}, 128, [&](const QStringList& merged) {
+            return merged.size() == 1 ? EmbeddingBatcher::batchOf(embedPrompt(apiKey, modelName, merged.front()))
+                                      : embedRequests(apiKey, modelName, merged);
+        }));
+}
+
+EmbeddingBatchResult OllamaBackend::getEmbeddings(
+    const QString& apiKey,
+    const QString& modelName,
+    const QStringList& texts
+) {
+    const QString key = EmbeddingBatcher::coalesceKey(id(), modelName, 0, apiKey);
+    return EmbeddingBatcher::coalesce(key, texts, 128, [&](const QStringList& merged) {
+        return embedRequests(apiKey, modelName, merged);
+    });
+}
+
+EmbeddingResult OllamaBackend::embedPrompt(
+    const QString& apiKey,
+    const QString& modelName,
+    const QString& text
 ) {
     EmbeddingResult result;
+    const CancellationToken cancellation = CancellationToken::current();
     const QString selectedModel = modelName.trimmed().isEmpty()
                                       ? QStringLiteral("nomic-embed-text")
                                       : modelName.trimmed();
@@ -337,17 +480,24 @@ EmbeddingResult OllamaBackend::getEmbedding(
     QJsonObject root;
     root.insert(QStringLiteral("model"), selectedModel);
     root.insert(QStringLiteral("input"), text);
+    applyProviderTuning(root);
 
     const QByteArray payload = QJsonDocument(root).toJson(QJsonDocument::Compact);
     const QString embedUrl = baseUrl() + QStringLiteral("/api/embed");
 
-    auto response = cpr::Post(
-        cpr::Url{embedUrl.toStdString()},
-        ollamaHeaders(apiKey, true),
-        cpr::Body{payload.constData()},
-        cpr::ConnectTimeout{5000},
-        cpr::Timeout{120000}
-    );
+    capConcurrencyToParallelSlots();
+    ProviderRateLimiter::Permit permit;
+    auto response = BackendRateLimit::send(
+        permit, id(), selectedModel, ProviderRateLimiter::estimateTokens(text.size()), cancellation, [&] {
+            return HttpConnectionPool::post(
+                cpr::Url{embedUrl.toStdString()},
+                ollamaHeaders(apiKey, true),
+                cpr::Body{payload.constData()},
+                cpr::ConnectTimeout{5000},
+                cpr::Timeout{120000},
+                BackendCancellation::progressCallback(cancellation)
+            );
+        });
 
     if (response.status_code == 404 && !response.error) {
         QJsonObject legacyRoot;
@@ -355,17 +505,22 @@ EmbeddingResult OllamaBackend::getEmbedding(
         legacyRoot.insert(QStringLiteral("prompt"), text);
         const QByteArray legacyPayload = QJsonDocument(legacyRoot).toJson(QJsonDocument::Compact);
         const QString legacyUrl = baseUrl() + QStringLiteral("/api/embeddings");
-        response = cpr::Post(
+        response = HttpConnectionPool::post(
             cpr::Url{legacyUrl.toStdString()},
             ollamaHeaders(apiKey, true),
             cpr::Body{legacyPayload.constData()},
             cpr::ConnectTimeout{5000},
-            cpr::Timeout{120000}
+            cpr::Timeout{120000},
+            BackendCancellation::progressCallback(cancellation)
         );
     }
 
     if (response.error) {
         result.hasError = true;
+        if (cancellation.isCancelled()) {
+            result.errorMsg = BackendCancellation::message();
+            return result;
+        }
         result.errorMsg = QStringLiteral("Ollama embedding network error: %1")
                               .arg(QString::fromStdString(response.error.message));
         CP_WARN.noquote() << QStringLiteral("OllamaBackend::getEmbedding failure provider=ollama model=%1 transport=network message=%2")
@@ -415,6 +570,179 @@ EmbeddingResult OllamaBackend::getEmbedding(
     return result;
 }
 
+EmbeddingBatchResult OllamaBackend::embedRequests(
+    const QString& apiKey,
+    const QString& modelName,
+    const QStringList& texts
+) {
+    const CancellationToken cancellation = CancellationToken::current();
+    const QString selectedModel = modelName.trimmed().isEmpty()
+                                      ? QStringLiteral("nomic-embed-text")
+                                      : modelName.trimmed();
+    bool legacyServer = false;
+    const auto embedEachPrompt = [&](const QStringList& batch) {
+        return embedInBatches(batch, 1, 0, [&](const QStringList& single) {
+            return EmbeddingBatcher::batchOf(embedPrompt(apiKey, modelName, single.front()));
+        });
+    };
+
+    // /api/embed takes an array input; the server has no fixed batch limit, so
+    // batches are kept small enough to finish well inside the request timeout.
+    return embedInBatches(texts, 128, 0, [&](const QStringList& batch) {
+        EmbeddingBatchResult result;
+        if (legacyServer) {
+            return embedEachPrompt(batch);
+        }
+
+        QJsonObject root;
+        root.insert(QStringLiteral("model"), selectedModel);
+        root.insert(QStringLiteral("input"), QJsonArray::fromStringList(batch));
+        applyProviderTuning(root);
+        cpr::Header headers = ollamaHeaders(apiKey, true);
+        const std::string payload = RequestCompression::encodeBody(
+            id(), QJsonDocument(root).toJson(QJsonDocument::Compact).toStdString(), headers);
+        const QString embedUrl = baseUrl() + QStringLiteral("/api/embed");
+
+        qsizetype inputChars = 0;
+        for (const QString& text : batch) {
+            inputChars += text.size();
+        }
+        capConcurrencyToParallelSlots();
+    ProviderRateLimiter::Permit permit;
+        const auto response = BackendRateLimit::send(
+            permit, id(), selectedModel, ProviderRateLimiter::estimateTokens(inputChars), cancellation, [&] {
+                return HttpConnectionPool::post(
+                    cpr::Url{embedUrl.toStdString()},
+                    headers,
+                    cpr::Body{payload},
+                    cpr::ConnectTimeout{5000},
+                    cpr::Timeout{120000},
+                    BackendCancellation::progressCallback(cancellation)
+                );
+            });
+
+        // Servers older than /api/embed only embed one prompt per request
+        if (response.status_code == 404 && !response.error) {
+            legacyServer = true;
+            return embedEachPrompt(batch);
+        }
+
+        if (response.error) {
+            result.hasError = true;
+            if (cancellation.isCancelled()) {
+                result.errorMsg = BackendCancellation::message();
+                return result;
+            }
+            result.errorMsg = QStringLiteral("Ollama embedding network error: %1")
+                                  .arg(QString::fromStdString(response.error.message));
+            CP_WARN.noquote() << QStringLiteral("OllamaBackend::getEmbeddings failure provider=ollama model=%1 transport=network message=%2")
+                                          .arg(selectedModel, result.errorMsg);
+            return result;
+        }
+
+        if (response.status_code != 200) {
+            result.hasError = true;
+            result.errorMsg = responseErrorMessage(response);
+            CP_WARN.noquote() << QStringLiteral("OllamaBackend::getEmbeddings failure provider=ollama model=%1 status=%2 message=%3")
+                                          .arg(selectedModel)
+                                          .arg(response.status_code)
+                                          .arg(result.errorMsg);
+            return result;
+        }
+
+        // Read the vectors straight out of the body; a QJsonDocument would hold one
+        // QJsonValue per number
+        JsonReader reader(QByteArrayView(response.text.data(), static_cast<qsizetype>(response.text.size())));
+        QByteArrayView key;
+        reader.enterObject();
+        while (reader.nextKey(key)) {
+            if (key == "error") {
+                result.hasError = true;
+                result.errorMsg = QStringLiteral("Unknown Ollama embedding error");
+                if (reader.peek() == JsonReader::Type::String) {
+                    reader.readString(result.errorMsg);
+                }
+                return result;
+            } else if (key == "embeddings" && reader.peek() == JsonReader::Type::Array) {
+                reader.enterArray();
+                while (reader.nextElement()) {
+                    std::vector<float> vector;
+                    if (reader.peek() == JsonReader::Type::Array) {
+                        reader.readFloats(vector);
+                    } else {
+                        reader.skipValue();
+                    }
+                    if (vector.empty() && !reader.hasError()) {
+                        result.hasError = true;
+                        result.errorMsg = QStringLiteral("Ollama embedding response did not contain a vector");
+                        return result;
+                    }
+                    result.vectors.push_back(std::move(vector));
+                }
+            } else if (key == "prompt_eval_count" && reader.peek() == JsonReader::Type::Number) {
+                reader.readInt(result.usage.inputTokens);
+            } else {
+                reader.skipValue();
+            }
+        }
+        if (reader.hasError()) {
+            result.hasError = true;
+            result.vectors.clear();
+            result.errorMsg = QStringLiteral("Ollama embedding JSON parse error: %1").arg(reader.errorString());
+            return result;
+        }
+        result.usage.totalTokens = result.usage.inputTokens;
+        permit.settle(result.usage.totalTokens);
+        return result;
+    });
+}
+
+void OllamaBackend::warmUp(const QString& apiKey, const QString& modelName)
+{
+    const QString selectedModel = modelName.trimmed();
+    if (selectedModel.isEmpty()) {
+        return;
+    }
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    {
+        QMutexLocker locker(&m_warmUpMutex);
+        const auto last = m_warmedUpAt.constFind(selectedModel);
+        if (last != m_warmedUpAt.constEnd() && now - last.value() < kWarmUpIntervalMs) {
+            return;
+        }
+        m_warmedUpAt.insert(selectedModel, now);
+    }
+    capConcurrencyToParallelSlots();
+
+    // A generate request without a prompt only loads the model
+    QJsonObject root;
+    root.insert(QStringLiteral("model"), selectedModel);
+    applyProviderTuning(root);
+    const QByteArray payload = QJsonDocument(root).toJson(QJsonDocument::Compact);
+    const QString url = baseUrl() + QStringLiteral("/api/generate");
+
+    QElapsedTimer timer;
+    timer.start();
+    const auto response = HttpConnectionPool::post(
+        cpr::Url{url.toStdString()},
+        ollamaHeaders(apiKey, true),
+        cpr::Body{payload.constData()},
+        cpr::ConnectTimeout{2000},
+        cpr::Timeout{300000}
+    );
+
+    if (response.error || response.status_code != 200) {
+        CP_CLOG(cp_lifecycle).noquote() << QStringLiteral("[ModelLifecycle] OllamaBackend::warmUp model=%1 failed: %2")
+                                               .arg(selectedModel, responseErrorMessage(response));
+        QMutexLocker locker(&m_warmUpMutex);
+        m_warmedUpAt.remove(selectedModel);
+        return;
+    }
+    CP_CLOG(cp_lifecycle).noquote() << QStringLiteral("[ModelLifecycle] OllamaBackend::warmUp model=%1 loaded in %2 ms")
+                                           .arg(selectedModel)
+                                           .arg(timer.elapsed());
+}
+
 QFuture<QString> OllamaBackend::generateImage(
     const QString& prompt,
     const QString& model,
@@ -25,6 +25,7 @@
 
 #include "ILLMBackend.h"
 
+#include <QHash>
 #include <QMutex>
 #include <QStringList>
 
@@ -50,12 +51,39 @@ public:
         const LLMMessage& message = {}
     ) override;
 
+    LLMResult streamPrompt(
+        const QString& apiKey,
+        const QString& modelName,
+        double temperature,
+        int maxTokens,
+        const QString& systemPrompt,
+        const QString& userPrompt,
+        const LLMStreamCallback& onDelta,
+        const LLMMessage& message = {}
+    ) override;
+
     EmbeddingResult getEmbedding(
         const QString& apiKey,
         const QString& modelName,
         const QString& text
     ) override;
 
+    EmbeddingBatchResult getEmbeddings(
+        const QString& apiKey,
+        const QString& modelName,
+        const QStringList& texts
+    ) override;
+
+    // Loads the model with an empty generate request, using the configured options so
+    // the first real prompt doesn't reload it with a different context size
+    void warmUp(const QString& apiKey, const QString& modelName) override;
+
+    // Parallel requests per model when neither the provider settings nor
+    // OLLAMA_NUM_PARALLEL say otherwise; Ollama's own default on most machines
+    static constexpr int kDefaultParallelSlots = 4;
+    // A model warmed up this recently is not warmed again
+    static constexpr int kWarmUpIntervalMs = 60000;
+
     QFuture<QString> generateImage(
         const QString& prompt,
         const QString& model,
@@ -66,8 +94,39 @@ public:
     ) override;
 
 private:
+    // One text through /api/embed, or /api/embeddings on servers without it
+    EmbeddingResult embedPrompt(
+        const QString& apiKey,
+        const QString& modelName,
+        const QString& text
+    );
+
+    // /api/embed requests of up to 128 texts, falling back to embedPrompt() per text
+    // on servers without it. getEmbedding() and getEmbeddings() merge concurrent
+    // small calls before they get here.
+    EmbeddingBatchResult embedRequests(
+        const QString& apiKey,
+        const QString& modelName,
+        const QStringList& texts
+    );
+
+    // Shared by sendPrompt() and streamPrompt(); streams when onDelta is set
+    LLMResult promptRequest(
+        const QString& apiKey,
+        const QString& modelName,
+        double temperature,
+        int maxTokens,
+        const QString& systemPrompt,
+        const QString& userPrompt,
+        const LLMMessage& message,
+        const LLMStreamCallback& onDelta
+    );
+
     QString baseUrl() const;
 
     mutable QMutex m_cacheMutex;
     QStringList m_cachedModels;
+
+    QMutex m_warmUpMutex;
+    QHash<QString, qint64> m_warmedUpAt; // model -> ms since epoch
 };
@@ -0,0 +1,476 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "OnnxEmbeddingBackend.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <QThread>
+#include <QtConcurrent>
+
+#include <onnxruntime_cxx_api.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+
+#include "BackendCancellation.h"
+#include "EmbeddingBatcher.h"
+#include "ModelCapsRegistry.h"
+#include "WordPieceTokenizer.h"
+#include "Logger.h"
+
+namespace {
+
+QVariantMap providerOptions()
+{
+    const auto settings =
+        ModelCapsRegistry::instance().providerSettings(QString::fromLatin1(OnnxEmbeddingBackend::kProviderId));
+    return settings ? settings->options : QVariantMap();
+}
+
+int intOption(const QVariantMap& options, const char* key, int fallback, int minimum)
+{
+    bool ok = false;
+    const int value = options.value(QString::fromLatin1(key)).toInt(&ok);
+    return ok && value >= minimum ? value : fallback;
+}
+
+QString modelFile(const QString& directory)
+{
+    for (const QString& candidate : {QStringLiteral("model.onnx"), QStringLiteral("onnx/model.onnx")}) {
+        const QString path = QDir(directory).filePath(candidate);
+        if (QFileInfo::exists(path)) {
+            return path;
+        }
+    }
+    return {};
+}
+
+Ort::Env& ortEnvironment()
+{
+    static Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "CognitivePipelines");
+    return env;
+}
+
+// Adds the requested accelerator; "auto" takes the first one this ONNX Runtime build has
+void appendExecutionProvider(Ort::SessionOptions& options, const QString& requested)
+{
+    const std::vector<std::string> available = Ort::GetAvailableProviders();
+    const auto has = [&](const char* name) {
+        return std::find(available.begin(), available.end(), name) != available.end();
+    };
+    const QString wanted = requested.trimmed().toLower();
+    const bool automatic = wanted.isEmpty() || wanted == QLatin1String("auto");
+    try {
+        if ((automatic || wanted == QLatin1String("cuda")) && has("CUDAExecutionProvider")) {
+            OrtCUDAProviderOptions cuda {};
+            options.AppendExecutionProvider_CUDA(cuda);
+            CP_CLOG(cp_lifecycle).noquote() << "ONNX embeddings: using the CUDA execution provider";
+        } else if ((automatic || wanted == QLatin1String("coreml")) && has("CoreMLExecutionProvider")) {
+            options.AppendExecutionProvider("CoreML", {});
+            CP_CLOG(cp_lifecycle).noquote() << "ONNX embeddings: using the CoreML execution provider";
+        } else if (!automatic && wanted != QLatin1String("cpu")) {
+            CP_WARN.noquote() << "ONNX embeddings: execution provider" << requested
+                              << "is not available in this ONNX Runtime, using the CPU";
+        }
+    } catch (const Ort::Exception& e) {
+        CP_WARN.noquote() << "ONNX embeddings: cannot enable" << requested << "execution provider:" << e.what();
+    }
+}
+
+void normalize(std::vector<float>& vector)
+{
+    double norm = 0.0;
+    for (const float v : vector) {
+        norm += static_cast<double>(v) * v;
+    }
+    if (norm > 0.0) {
+        const float scale = static_cast<float>(1.0 / std::sqrt(norm));
+        for (float& v : vector) {
+            v *= scale;
+        }
+    }
+}
+
+} // namespace
+
+struct OnnxEmbeddingBackend::Model {
+    // The batcher gathers a few sub-batches' worth of texts per run
+    Model(int maxBatch, int maxTokens, int windowMs)
+        : maxBatch(maxBatch)
+        , maxTokens(maxTokens)
+        , batcher(maxBatch * 4, windowMs)
+    {
+    }
+
+    std::unique_ptr<Ort::Session> session;
+    WordPieceTokenizer tokenizer;
+    std::vector<std::string> inputNames;
+    std::string outputName;
+    bool tokenTypes {false};
+    const int maxBatch;
+    int maxTokens;
+    EmbeddingBatcher batcher;
+
+    bool load(const QString& directory, const QVariantMap& options, QString* error);
+    EmbeddingBatchResult run(const QStringList& texts) const;
+};
+
+bool OnnxEmbeddingBackend::Model::load(const QString& directory, const QVariantMap& options, QString* error)
+{
+    const QString file = modelFile(directory);
+    if (file.isEmpty()) {
+        *error = QStringLiteral("No model.onnx in %1").arg(directory);
+        return false;
+    }
+    if (!tokenizer.loadVocabulary(QDir(directory).filePath(QStringLiteral("vocab.txt")), error)) {
+        return false;
+    }
+
+    QFile configFile(QDir(directory).filePath(QStringLiteral("tokenizer_config.json")));
+    if (configFile.open(QIODevice::ReadOnly)) {
+        const QJsonObject config = QJsonDocument::fromJson(configFile.readAll()).object();
+        tokenizer.setLowercase(config.value(QStringLiteral("do_lower_case")).toBool(true));
+        // Exports without a limit write a huge sentinel here
+        const double modelMax = config.value(QStringLiteral("model_max_length")).toDouble(0.0);
+        if (modelMax >= 8 && modelMax < 100000) {
+            maxTokens = std::min(maxTokens, static_cast<int>(modelMax));
+        }
+    }
+
+    try {
+        Ort::SessionOptions sessionOptions;
+        sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+        sessionOptions.SetIntraOpNumThreads(
+            intOption(options, "threads", std::max(1, QThread::idealThreadCount() / 2), 1));
+        appendExecutionProvider(sessionOptions, options.value(QStringLiteral("execution_provider")).toString());
+#ifdef _WIN32
+        const std::wstring path = file.toStdWString();
+#else
+        const std::string path = file.toStdString();
+#endif
+        session = std::make_unique<Ort::Session>(ortEnvironment(), path.c_str(), sessionOptions);
+
+        Ort::AllocatorWithDefaultOptions allocator;
+        for (size_t i = 0; i < session->GetInputCount(); ++i) {
+            const std::string name = session->GetInputNameAllocated(i, allocator).get();
+            if (name == "token_type_ids") {
+                tokenTypes = true;
+            } else if (name != "input_ids" && name != "attention_mask") {
+                *error = QStringLiteral("Model input %1 is not a BERT-style input").arg(QString::fromStdString(name));
+                session.reset();
+                return false;
+            }
+        }
+        inputNames = {"input_ids", "attention_mask"};
+        if (tokenTypes) {
+            inputNames.push_back("token_type_ids");
+        }
+        // Sentence-transformers exports carry the pooled vector as a second output
+        outputName = session->GetOutputNameAllocated(0, allocator).get();
+        for (size_t i = 0; i < session->GetOutputCount(); ++i) {
+            const std::string name = session->GetOutputNameAllocated(i, allocator).get();
+            if (name == "sentence_embedding") {
+                outputName = name;
+            }
+        }
+    } catch (const Ort::Exception& e) {
+        *error = QStringLiteral("Cannot load %1: %2").arg(file, QString::fromUtf8(e.what()));
+        session.reset();
+        return false;
+    }
+    return true;
+}
+
+EmbeddingBatchResult OnnxEmbeddingBackend::Model::run(const QStringList& texts) const
+{
+    EmbeddingBatchResult result;
+    result.vectors.resize(static_cast<size_t>(texts.size()));
+    const CancellationToken cancellation = CancellationToken::current();
+
+    // Similar lengths share a sub-batch, so little of it is padding
+    std::vector<std::vector<qint64>> encoded;
+    encoded.reserve(static_cast<size_t>(texts.size()));
+    for (const QString& text : texts) {
+        encoded.push_back(tokenizer.encode(text, maxTokens));
+        result.usage.inputTokens += static_cast<int>(encoded.back().size());
+    }
+    std::vector<size_t> order(encoded.size());
+    std::iota(order.begin(), order.end(), size_t {0});
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return encoded[a].size() < encoded[b].size(); });
+
+    const Ort::MemoryInfo memory = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+    std::vector<const char*> inputNamePointers;
+    for (const std::string& name : inputNames) {
+        inputNamePointers.push_back(name.c_str());
+    }
+    const char* outputNamePointer = outputName.c_str();
+
+    try {
+        for (size_t start = 0; start < order.size(); start += static_cast<size_t>(maxBatch)) {
+            if (cancellation.isCancelled()) {
+                return EmbeddingBatchResult {{}, {}, true, BackendCancellation::message()};
+            }
+            const size_t rows = std::min(order.size() - start, static_cast<size_t>(maxBatch));
+            const size_t length = encoded[order[start + rows - 1]].size();
+            std::vector<int64_t> ids(rows * length, tokenizer.padId());
+            std::vector<int64_t> mask(rows * length, 0);
+            std::vector<int64_t> types(rows * length, 0);
+            for (size_t row = 0; row < rows; ++row) {
+                const std::vector<qint64>& tokens = encoded[order[start + row]];
+                std::copy(tokens.begin(), tokens.end(), ids.begin() + static_cast<std::ptrdiff_t>(row * length));
+                std::fill_n(mask.begin() + static_cast<std::ptrdiff_t>(row * length), tokens.size(), 1);
+            }
+
+            const std::array<int64_t, 2> shape {static_cast<int64_t>(rows), static_cast<int64_t>(length)};
+            std::vector<Ort::Value> inputs;
+            inputs.push_back(Ort::Value::CreateTensor<int64_t>(memory, ids.data(), ids.size(), shape.data(), shape.size()));
+            inputs.push_back(Ort::Value::CreateTensor<int64_t>(memory, mask.data(), mask.size(), shape.data(), shape.size()));
+            if (tokenTypes) {
+                inputs.push_back(
+                    Ort::Value::CreateTensor<int64_t>(memory, types.data(), types.size(), shape.data(), shape.size()));
+            }
+            const std::vector<Ort::Value> outputs =
+                session->Run(Ort::RunOptions {nullptr}, inputNamePointers.data(), inputs.data(), inputs.size(),
+                             &outputNamePointer, 1);
+
+            const std::vector<int64_t> outputShape = outputs.front().GetTensorTypeAndShapeInfo().GetShape();
+            const float* data = outputs.front().GetTensorData<float>();
+            if (outputShape.size() == 2 && outputShape[0] == static_cast<int64_t>(rows)) {
+                const size_t dimensions = static_cast<size_t>(outputShape[1]);
+                for (size_t row = 0; row < rows; ++row) {
+                    std::vector<float>& vector = result.vectors[order[start + row]];
+                    vector.assign(data + row * dimensions, data + (row + 1) * dimensions);
+                    normalize(vector);
+                }
+            } else if (outputShape.size() == 3 && outputShape[0] == static_cast<int64_t>(rows)
+                       && outputShape[1] == static_cast<int64_t>(length)) {
+                // Mean over the real tokens of each row
+                const size_t dimensions = static_cast<size_t>(outputShape[2]);
+                for (size_t row = 0; row < rows; ++row) {
+                    const size_t tokens = encoded[order[start + row]].size();
+                    std::vector<float>& vector = result.vectors[order[start + row]];
+                    vector.assign(dimensions, 0.0f);
+                    for (size_t t = 0; t < tokens; ++t) {
+                        const float* token = data + (row * length + t) * dimensions;
+                        for (size_t d = 0; d < dimensions; ++d) {
+                            vector[d] += token[d];
+                        }
+                    }
+                    for (float& v : vector) {
+                        v /= static_cast<float>(tokens);
+                    }
+                    normalize(vector);
+                }
+            } else {
+                return EmbeddingBatchResult {{}, {}, true, QStringLiteral("Unexpected ONNX model output shape")};
+            }
+        }
+    } catch (const Ort::Exception& e) {
+        return EmbeddingBatchResult {{}, {}, true, QStringLiteral("ONNX Runtime: %1").arg(QString::fromUtf8(e.what()))};
+    }
+    result.usage.totalTokens = result.usage.inputTokens;
+    return result;
+}
+
+OnnxEmbeddingBackend::OnnxEmbeddingBackend() = default;
+
+OnnxEmbeddingBackend::~OnnxEmbeddingBackend() = default;
+
+QString OnnxEmbeddingBackend::id() const
+{
+    return QString::fromLatin1(kProviderId);
+}
+
+QString OnnxEmbeddingBackend::name() const
+{
+    return QStringLiteral("Local Embeddings (ONNX Runtime)");
+}
+
+QString OnnxEmbeddingBackend::modelsDirectory()
+{
+    const QString configured = providerOptions().value(QStringLiteral("models_dir")).toString().trimmed();
+    if (!configured.isEmpty()) {
+        return QDir::cleanPath(configured);
+    }
+    const QString fromEnvironment = qEnvironmentVariable("CP_ONNX_MODELS_DIR").trimmed();
+    if (!fromEnvironment.isEmpty()) {
+        return QDir::cleanPath(fromEnvironment);
+    }
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation))
+        .filePath(QStringLiteral("models/onnx"));
+}
+
+QStringList OnnxEmbeddingBackend::availableModels() const
+{
+    return {};
+}
+
+QStringList OnnxEmbeddingBackend::availableEmbeddingModels() const
+{
+    const QDir root(modelsDirectory());
+    QStringList models;
+    for (const QString& entry : root.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name)) {
+        const QString directory = root.filePath(entry);
+        if (!modelFile(directory).isEmpty() && QFileInfo::exists(QDir(directory).filePath(QStringLiteral("vocab.txt")))) {
+            models.append(entry);
+        }
+    }
+    return models;
+}
+
+QFuture<QStringList> OnnxEmbeddingBackend::fetchModelList()
+{
+    return QtConcurrent::run([this]() { return availableEmbeddingModels(); });
+}
+
+LLMResult OnnxEmbeddingBackend::sendPrompt(
+    const QString& apiKey,
+    const QString& modelName,
+    double temperature,
+    int maxTokens,
+    const QString& systemPrompt,
+    const QString& userPrompt,
+    const LLMMessage& message
+) {
+    Q_UNUSED(apiKey)
+    Q_UNUSED(modelName)
+    Q_UNUSED(temperature)
+    Q_UNUSED(maxTokens)
+    Q_UNUSED(systemPrompt)
+    Q_UNUSED(userPrompt)
+    Q_UNUSED(message)
+    LLMResult result;
+    result.hasError = true;
+    result.errorMsg = QStringLiteral("The ONNX Runtime provider only computes embeddings");
+    return result;
+}
+
+LLMResult OnnxEmbeddingBackend::streamPrompt(
+    const QString& apiKey,
+    const QString& modelName,
+    double temperature,
+    int maxTokens,
+    const QString& systemPrompt,
+    const QString& userPrompt,
+    const LLMStreamCallback& onDelta,
+    const LLMMessage& message
+) {
+    Q_UNUSED(onDelta)
+    return sendPrompt(apiKey, modelName, temperature, maxTokens, systemPrompt, userPrompt, message);
+}
+
+std::shared_ptr<OnnxEmbeddingBackend::Model> OnnxEmbeddingBackend::model(const QString& modelName, QString* error)
+{
+    const QString key = modelName.trimmed();
+    if (key.isEmpty() || key.contains(u'/') || key.contains(u'\\') || key == QLatin1String("..")) {
+        *error = QStringLiteral("Invalid ONNX model name \"%1\"").arg(modelName);
+        return nullptr;
+    }
+
+    // Held while loading, so concurrent first calls load the model once
+    QMutexLocker locker(&m_mutex);
+    if (const auto it = m_models.constFind(key); it != m_models.cend()) {
+        return *it;
+    }
+    const QVariantMap options = providerOptions();
+    auto loaded = std::make_shared<Model>(intOption(options, "max_batch", 32, 1),
+                                          intOption(options, "max_tokens", 256, 8),
+                                          intOption(options, "batch_window_ms", 2, 0));
+    const QString directory = QDir(modelsDirectory()).filePath(key);
+    if (!loaded->load(directory, options, error)) {
+        CP_WARN.noquote() << "ONNX embeddings:" << *error;
+        return nullptr;
+    }
+    CP_CLOG(cp_lifecycle).noquote() << "ONNX embeddings: loaded" << directory;
+    m_models.insert(key, loaded);
+    return loaded;
+}
+
+EmbeddingResult OnnxEmbeddingBackend::getEmbedding(
+    const QString& apiKey,
+    const QString& modelName,
+    const QString& text
+) {
+    const EmbeddingBatchResult batch = getEmbeddings(apiKey, modelName, QStringList{text});
+    EmbeddingResult result;
+    result.usage = batch.usage;
+    result.hasError = batch.hasError;
+    result.errorMsg = batch.errorMsg;
+    if (!batch.vectors.empty()) {
+        result.vector = batch.vectors.front();
+    }
+    return result;
+}
+
+EmbeddingBatchResult OnnxEmbeddingBackend::getEmbeddings(
+    const QString& apiKey,
+    const QString& modelName,
+    const QStringList& texts
+) {
+    Q_UNUSED(apiKey)
+    EmbeddingBatchResult result;
+    QString error;
+    const std::shared_ptr<Model> loaded = model(modelName, &error);
+    if (!loaded) {
+        result.hasError = true;
+        result.errorMsg = error;
+        return result;
+    }
+    const Model* instance = loaded.get();
+    return loaded->batcher.embed(texts, [instance](const QStringList& batch) { return instance->run(batch); });
+}
+
+QFuture<QString> OnnxEmbeddingBackend::generateImage(
+    const QString& prompt,
+    const QString& model,
+    const QString& size,
+    const QString& quality,
+    const QString& style,
+    const QString& targetDir
+) {
+    Q_UNUSED(prompt)
+    Q_UNUSED(model)
+    Q_UNUSED(size)
+    Q_UNUSED(quality)
+    Q_UNUSED(style)
+    Q_UNUSED(targetDir)
+
+    return QtConcurrent::run([]() -> QString {
+        return QStringLiteral("ONNX Runtime image generation is not supported");
+    });
+}
+
+void OnnxEmbeddingBackend::warmUp(const QString& apiKey, const QString& modelName)
+{
+    Q_UNUSED(apiKey)
+    QString error;
+    model(modelName, &error);
+}
@@ -0,0 +1,123 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include "ILLMBackend.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+#include <memory>
+
+/**
+ * @brief Runs sentence-embedding models in process with ONNX Runtime, for RAG without a server.
+ *
+ * Registered as provider "onnx" when the build finds ONNX Runtime. Each model is a
+ * directory below modelsDirectory() holding model.onnx (or onnx/model.onnx, as
+ * the Hugging Face exports lay it out) and the WordPiece vocab.txt, optionally with
+ * tokenizer_config.json for do_lower_case and model_max_length. The directory
+ * name is the model name.
+ *
+ * A model's session is created on first use and kept. Concurrent getEmbeddings()
+ * calls for the same model are merged by an EmbeddingBatcher, and each batch is
+ * sorted by length and run in padded sub-batches of up to `max_batch` texts.
+ * Token embeddings are mean-pooled over the attention mask, unless the model
+ * already outputs `sentence_embedding`, and every vector is L2-normalised.
+ *
+ * Read from the catalogue provider's `options`: `models_dir`, `execution_provider`
+ * (auto, cpu, cuda, coreml), `threads`, `max_batch`, `max_tokens` and
+ * `batch_window_ms`. Chat and image generation are not supported.
+ */
+class OnnxEmbeddingBackend : public ILLMBackend {
+public:
+    OnnxEmbeddingBackend();
+    ~OnnxEmbeddingBackend() override;
+
+    QString id() const override;
+    QString name() const override;
+    QStringList availableModels() const override;
+    QStringList availableEmbeddingModels() const override;
+    QFuture<QStringList> fetchModelList() override;
+
+    LLMResult sendPrompt(
+        const QString& apiKey,
+        const QString& modelName,
+        double temperature,
+        int maxTokens,
+        const QString& systemPrompt,
+        const QString& userPrompt,
+        const LLMMessage& message = {}
+    ) override;
+
+    LLMResult streamPrompt(
+        const QString& apiKey,
+        const QString& modelName,
+        double temperature,
+        int maxTokens,
+        const QString& systemPrompt,
+        const QString& userPrompt,
+        const LLMStreamCallback& onDelta,
+        const LLMMessage& message = {}
+    ) override;
+
+    EmbeddingResult getEmbedding(
+        const QString& apiKey,
+        const QString& modelName,
+        const QString& text
+    ) override;
+
+    EmbeddingBatchResult getEmbeddings(
+        const QString& apiKey,
+        const QString& modelName,
+        const QStringList& texts
+    ) override;
+
+    QFuture<QString> generateImage(
+        const QString& prompt,
+        const QString& model,
+        const QString& size,
+        const QString& quality,
+        const QString& style,
+        const QString& targetDir = QString()
+    ) override;
+
+    // Creates the model's session ahead of the first embedding
+    void warmUp(const QString& apiKey, const QString& modelName) override;
+
+    // The `models_dir` option, else CP_ONNX_MODELS_DIR, else models/onnx in the app data directory
+    static QString modelsDirectory();
+
+    static constexpr const char* kProviderId = "onnx";
+
+private:
+    struct Model;
+
+    // The loaded model, or nullptr with @p error set
+    std::shared_ptr<Model> model(const QString& modelName, QString* error);
+
+    mutable QMutex m_mutex;
+    QHash<QString, std::shared_ptr<Model>> m_models;
+};
@@ -24,10 +24,21 @@
 #include "OpenAIBackend.h"
 
 #include "ai/registry/LLMProviderRegistry.h"
+#include "BackendCancellation.h"
+#include "BackendRateLimit.h"
+#include "Base64FileDownload.h"
+#include "EmbeddingBatcher.h"
+#include "HttpConnectionPool.h"
+#include "JsonPayload.h"
+#include "JsonReader.h"
+#include "ProviderEndpoint.h"
+#include "RequestCompression.h"
+#include "StreamingResponse.h"
 #include "ModelCapsRegistry.h"
 
 #include <cpr/cpr.h>
 #include <QJsonObject>
+#include <QCryptographicHash>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QFile>
@@ -40,8 +51,18 @@
 #include <QUuid>
 #include <QByteArray>
 
+#include <optional>
+
 namespace {
 
+// Scheme and host requests go to; see ProviderEndpoint
+std::string apiBase()
+{
+    return ProviderEndpoint::baseUrl(QStringLiteral("openai"), "OPENAI_BASE_URL",
+                                     QStringLiteral("https://api.openai.com"))
+        .toStdString();
+}
+
 QString textFromMessageContent(const QJsonValue& contentValue)
 {
     if (contentValue.isString()) {
@@ -91,6 +112,166 @@ int nestedIntValue(const QJsonObject& object,
     return nested.toObject().value(valueKey).toInt(fallback);
 }
 
+// The provider's error message from a failed request, else the transport error or HTTP status
+QString apiErrorMessage(const cpr::Response& response)
+{
+    if (response.error) {
+        return QStringLiteral("OpenAI network error: %1").arg(QString::fromStdString(response.error.message));
+    }
+    const QString message = QJsonDocument::fromJson(QByteArray::fromStdString(response.text))
+                                .object().value(QStringLiteral("error")).toObject()
+                                .value(QStringLiteral("message")).toString();
+    return message.isEmpty() ? QStringLiteral("HTTP %1").arg(response.status_code) : message;
+}
+
+// Reads a chat/completions response body: text, usage and the empty-answer diagnostics
+LLMResult chatCompletionResult(const QJsonObject& rootObj, int maxTokens, const QString& resolvedModel)
+{
+    LLMResult result;
+
+    // Check for error object in response
+    if (rootObj.contains(QStringLiteral("error"))) {
+        result.hasError = true;
+        if (rootObj[QStringLiteral("error")].isObject()) {
+            QJsonObject errorObj = rootObj[QStringLiteral("error")].toObject();
+            result.errorMsg = errorObj[QStringLiteral("message")].toString(QStringLiteral("Unknown error"));
+        } else {
+            result.errorMsg = QStringLiteral("Unknown error");
+        }
+        result.content = result.errorMsg;
+        return result;
+    }
+    
+    QString finishReason;
+    bool sawChoice = false;
+
+    // Extract content from choices[0].message.content
+    if (rootObj.contains(QStringLiteral("choices")) && rootObj[QStringLiteral("choices")].isArray()) {
+        QJsonArray choices = rootObj[QStringLiteral("choices")].toArray();
+        if (!choices.isEmpty() && choices[0].isObject()) {
+            sawChoice = true;
+            QJsonObject choice = choices[0].toObject();
+            finishReason = choice.value(QStringLiteral("finish_reason")).toString();
+            if (choice.contains(QStringLiteral("message")) && choice[QStringLiteral("message")].isObject()) {
+                QJsonObject message = choice[QStringLiteral("message")].toObject();
+                result.content = textFromMessageContent(message.value(QStringLiteral("content")));
+            } else if (choice.value(QStringLiteral("text")).isString()) {
+                result.content = choice.value(QStringLiteral("text")).toString();
+            }
+        }
+    }
+    
+    // Extract usage statistics
+    if (rootObj.contains(QStringLiteral("usage")) && rootObj[QStringLiteral("usage")].isObject()) {
+        QJsonObject usage = rootObj[QStringLiteral("usage")].toObject();
+        result.usage.inputTokens = usage[QStringLiteral("prompt_tokens")].toInt(0);
+        result.usage.outputTokens = usage[QStringLiteral("completion_tokens")].toInt(0);
+        result.usage.totalTokens = usage[QStringLiteral("total_tokens")].toInt(0);
+        // OpenAI caches long prefixes automatically and reports the hits here
+        result.usage.cacheReadTokens = usage.value(QStringLiteral("prompt_tokens_details")).toObject()
+                                           .value(QStringLiteral("cached_tokens")).toInt(0);
+    }
+
+    const int reasoningTokens = rootObj.value(QStringLiteral("usage")).isObject()
+                                    ? nestedIntValue(rootObj.value(QStringLiteral("usage")).toObject(),
+                                                     QStringLiteral("completion_tokens_details"),
+                                                     QStringLiteral("reasoning_tokens"))
+                                    : 0;
+
+    if (sawChoice && result.content.trimmed().isEmpty()) {
+        result.hasError = true;
+        const bool hitLimit = finishReason == QStringLiteral("length")
+                              || (maxTokens > 0 && result.usage.outputTokens >= maxTokens);
+        if (hitLimit) {
+            result.errorMsg = QStringLiteral(
+                "OpenAI returned no visible text before reaching max_completion_tokens (%1). "
+                "Increase Max Tokens on this Universal AI node or reduce the prompt/RAG context.")
+                                  .arg(maxTokens);
+            if (reasoningTokens > 0) {
+                result.errorMsg += QStringLiteral(" Reasoning tokens used: %1.").arg(reasoningTokens);
+            }
+        } else if (finishReason == QStringLiteral("content_filter")) {
+            result.errorMsg = QStringLiteral("OpenAI returned no visible text because the response was filtered.");
+        } else if (finishReason == QStringLiteral("tool_calls") || finishReason == QStringLiteral("function_call")) {
+            result.errorMsg = QStringLiteral("OpenAI returned tool calls but this node only supports text responses.");
+        } else {
+            result.errorMsg = QStringLiteral("OpenAI returned an empty text response (finish_reason='%1').")
+                                  .arg(finishReason.isEmpty() ? QStringLiteral("unknown") : finishReason);
+        }
+        result.content = result.errorMsg;
+        CP_WARN.noquote() << QStringLiteral("OpenAIBackend::sendPrompt empty response provider=openai model=%1 finish_reason=%2 completion_tokens=%3 max_tokens=%4 reasoning_tokens=%5 message=%6")
+                                      .arg(resolvedModel,
+                                           finishReason.isEmpty() ? QStringLiteral("unknown") : finishReason)
+                                      .arg(result.usage.outputTokens)
+                                      .arg(maxTokens)
+                                      .arg(reasoningTokens)
+                                      .arg(result.errorMsg);
+    }
+    
+    return result;
+}
+
+// Reads a /v1/responses body: the output_text parts of its message items, usage and the id
+LLMResult responsesResult(const QJsonObject& rootObj, int maxTokens, const QString& resolvedModel)
+{
+    LLMResult result;
+
+    // Successful responses carry "error": null
+    if (rootObj.value(QStringLiteral("error")).isObject()) {
+        result.hasError = true;
+        result.errorMsg = rootObj.value(QStringLiteral("error")).toObject()
+                              .value(QStringLiteral("message")).toString(QStringLiteral("Unknown error"));
+        result.content = result.errorMsg;
+        return result;
+    }
+
+    result.responseId = rootObj.value(QStringLiteral("id")).toString();
+    const QJsonArray output = rootObj.value(QStringLiteral("output")).toArray();
+    for (const QJsonValue& itemValue : output) {
+        const QJsonObject item = itemValue.toObject();
+        if (item.value(QStringLiteral("type")).toString() != QStringLiteral("message")) {
+            continue;
+        }
+        const QJsonArray content = item.value(QStringLiteral("content")).toArray();
+        for (const QJsonValue& partValue : content) {
+            const QJsonObject part = partValue.toObject();
+            if (part.value(QStringLiteral("type")).toString() == QStringLiteral("output_text")) {
+                result.content += part.value(QStringLiteral("text")).toString();
+            }
+        }
+    }
+
+    const QJsonObject usage = rootObj.value(QStringLiteral("usage")).toObject();
+    result.usage.inputTokens = usage.value(QStringLiteral("input_tokens")).toInt(0);
+    result.usage.outputTokens = usage.value(QStringLiteral("output_tokens")).toInt(0);
+    result.usage.totalTokens = usage.value(QStringLiteral("total_tokens")).toInt(0);
+    result.usage.cacheReadTokens = nestedIntValue(usage, QStringLiteral("input_tokens_details"),
+                                                  QStringLiteral("cached_tokens"));
+
+    if (result.content.trimmed().isEmpty()) {
+        result.hasError = true;
+        const QString reason = rootObj.value(QStringLiteral("incomplete_details")).toObject()
+                                   .value(QStringLiteral("reason")).toString();
+        if (reason == QStringLiteral("max_output_tokens")) {
+            result.errorMsg = QStringLiteral(
+                "OpenAI returned no visible text before reaching max_output_tokens (%1). "
+                "Increase Max Tokens on this Universal AI node or reduce the prompt/RAG context.")
+                                  .arg(maxTokens);
+        } else if (reason == QStringLiteral("content_filter")) {
+            result.errorMsg = QStringLiteral("OpenAI returned no visible text because the response was filtered.");
+        } else {
+            result.errorMsg = QStringLiteral("OpenAI returned an empty text response (status='%1').")
+                                  .arg(rootObj.value(QStringLiteral("status")).toString(QStringLiteral("unknown")));
+        }
+        result.content = result.errorMsg;
+        CP_WARN.noquote() << QStringLiteral("OpenAIBackend::sendPrompt empty response provider=openai model=%1 api=responses reason=%2 message=%3")
+                                      .arg(resolvedModel, reason.isEmpty() ? QStringLiteral("unknown") : reason,
+                                           result.errorMsg);
+    }
+
+    return result;
+}
+
 } // namespace
 
 OpenAIBackend::OpenAIBackend() {
@@ -262,8 +443,8 @@ QFuture<QByteArray> OpenAIBackend::fetchRawModelListJson()
         }
 
         try {
-            const auto response = cpr::Get(
-                cpr::Url{"https://api.openai.com/v1/models"},
+            const auto response = HttpConnectionPool::get(
+                cpr::Url{apiBase() + "/v1/models"},
                 cpr::Header{
                     {"Authorization", std::string("Bearer ") + apiKey.toStdString()},
                     {"Accept", "application/json"}
@@ -292,6 +473,49 @@ QFuture<QByteArray> OpenAIBackend::fetchRawModelListJson()
     });
 }
 
+cpr::Response OpenAIBackend::assistantProbeRequest(const cpr::Header& headers, const CancellationToken& cancellation)
+{
+    const std::string pingUrl = apiBase() + "/v1/assistants?limit=1";
+    CP_CLOG(cp_endpoint).noquote() << "[EndpointRouting] OpenAI assistant probe =>" << QString::fromStdString(pingUrl);
+
+    return HttpConnectionPool::get(
+        cpr::Url{pingUrl},
+        headers,
+        cpr::ConnectTimeout{10000},   // 10s connect timeout
+        cpr::Timeout{60000},          // 60s total request timeout
+        BackendCancellation::progressCallback(cancellation)
+    );
+}
+
+std::optional<QString> OpenAIBackend::cachedAssistantProbe(const QString& apiKey)
+{
+    const QByteArray key = QCryptographicHash::hash(apiKey.toUtf8(), QCryptographicHash::Sha256);
+    QMutexLocker locker(&m_probeMutex);
+    const auto it = m_assistantProbes.constFind(key);
+    if (it == m_assistantProbes.constEnd()) {
+        return std::nullopt;
+    }
+    if (it->expiry.hasExpired()) {
+        m_assistantProbes.erase(it);
+        return std::nullopt;
+    }
+    return it->rawResponse;
+}
+
+void OpenAIBackend::rememberAssistantProbe(const QString& apiKey, const QString& rawResponse)
+{
+    const QByteArray key = QCryptographicHash::hash(apiKey.toUtf8(), QCryptographicHash::Sha256);
+    QMutexLocker locker(&m_probeMutex);
+    m_assistantProbes.insert(key, AssistantProbe{rawResponse, QDeadlineTimer(kAssistantProbeTtlMs)});
+}
+
+void OpenAIBackend::forgetAssistantProbe(const QString& apiKey)
+{
+    const QByteArray key = QCryptographicHash::hash(apiKey.toUtf8(), QCryptographicHash::Sha256);
+    QMutexLocker locker(&m_probeMutex);
+    m_assistantProbes.remove(key);
+}
+
 LLMResult OpenAIBackend::sendPrompt(
     const QString& apiKey,
     const QString& modelName,
@@ -300,8 +524,36 @@ LLMResult OpenAIBackend::sendPrompt(
     const QString& systemPrompt,
     const QString& userPrompt,
     const LLMMessage& message
+) {
+    return promptRequest(apiKey, modelName, temperature, maxTokens, systemPrompt, userPrompt, message, {});
+}
+
+LLMResult OpenAIBackend::streamPrompt(
+    const QString& apiKey,
+    const QString& modelName,
+    double temperature,
+    int maxTokens,
+    const QString& systemPrompt,
+    const QString& userPrompt,
+    const LLMStreamCallback& onDelta,
+    const LLMMessage& message
+) {
+    return promptRequest(apiKey, modelName, temperature, maxTokens, systemPrompt, userPrompt, message, onDelta);
+}
+
+LLMResult OpenAIBackend::promptRequest(
+    const QString& apiKey,
+    const QString& modelName,
+    double temperature,
+    int maxTokens,
+    const QString& systemPrompt,
+    const QString& userPrompt,
+    const LLMMessage& message,
+    const LLMStreamCallback& onDelta,
+    std::string* requestBodyOut
 ) {
     LLMResult result;
+    const CancellationToken cancellation = CancellationToken::current();
 
     // Resolve alias to real ID for the API request
     const QString resolvedModel = ModelCapsRegistry::instance().resolveAlias(modelName, id());
@@ -337,7 +589,7 @@ LLMResult OpenAIBackend::sendPrompt(
                              : (endpointMode == ModelCapsTypes::EndpointMode::Completion)
                                    ? QStringLiteral("/v1/completions")
                                    : QStringLiteral("/v1/assistants");
-    const std::string url = QStringLiteral("https://api.openai.com").append(path).toStdString();
+    const std::string url = apiBase() + path.toStdString();
 
     // Instrumentation: log decision inputs for temperature handling
     const bool looksLikeGpt5 = resolvedModel.startsWith(QStringLiteral("gpt-5"));
@@ -351,6 +603,38 @@ LLMResult OpenAIBackend::sendPrompt(
                        << " includeTemperature=" << (temperatureSupported ? "T" : "F")
                        << " value=" << temperature;
 
+    const QString reasoningEffort = (capsOpt.has_value()
+                                     && capsOpt->constraints.reasoningEffort.has_value()
+                                     && capsOpt->constraints.reasoningEffort->defaultValue.has_value())
+                                        ? capsOpt->constraints.reasoningEffort->defaultValue->trimmed()
+                                        : QString();
+
+    // Stored conversations go through the Responses API, which keeps the earlier turns on
+    // OpenAI's side; continuing one sends only the new prompt
+    if ((message.storeResponse || !message.previousResponseId.isEmpty())
+        && endpointMode == ModelCapsTypes::EndpointMode::Chat && !requestBodyOut) {
+        QJsonObject root;
+        root.insert(QStringLiteral("model"), resolvedModel);
+        if (temperatureSupported) {
+            root.insert(QStringLiteral("temperature"), temperature);
+        }
+        if (!reasoningEffort.isEmpty()) {
+            root.insert(QStringLiteral("reasoning"), QJsonObject{{QStringLiteral("effort"), reasoningEffort}});
+        }
+        root.insert(QStringLiteral("max_output_tokens"), maxTokens);
+
+        cpr::Header headers{
+            {"Authorization", std::string("Bearer ") + apiKey.toStdString()},
+            {"Content-Type", "application/json"}
+        };
+        if (resolved.has_value()) {
+            for (auto it = resolved->caps.customHeaders.begin(); it != resolved->caps.customHeaders.end(); ++it) {
+                headers.insert({it.key().toStdString(), it.value().toStdString()});
+            }
+        }
+        return responsesRequest(apiKey, std::move(root), headers, systemPrompt, userPrompt, message, onDelta);
+    }
+
     // Build messages array [{role: system|developer, content: ...}, {role: user, content: ...}]
     QJsonObject sysMsg;
     // Map RoleMode to OpenAI role tag; SystemInstruction maps to standard 'system' here
@@ -364,6 +648,7 @@ LLMResult OpenAIBackend::sendPrompt(
     userMsg.insert(QStringLiteral("role"), QStringLiteral("user"));
     
     // Check for attachments in message
+    JsonPayload payload;
     if (!message.attachments.isEmpty()) {
         // Build multimodal content array for Vision API
         QJsonArray contentArray;
@@ -375,14 +660,12 @@ LLMResult OpenAIBackend::sendPrompt(
         contentArray.append(textPart);
         
         for (const auto& attachment : message.attachments) {
-            // Encode to Base64
-            QString base64Data = QString::fromLatin1(attachment.data.toBase64());
-            
-            // Attachment part
+            // Attachment part; the base64 is written straight into the request body
             if (attachment.mimeType.startsWith(QStringLiteral("image/"))) {
                 QJsonObject imageUrlObj;
-                imageUrlObj.insert(QStringLiteral("url"), 
-                                  QStringLiteral("data:%1;base64,%2").arg(attachment.mimeType, base64Data));
+                imageUrlObj.insert(QStringLiteral("url"),
+                                  QStringLiteral("data:%1;base64,").arg(attachment.mimeType)
+                                      + payload.base64(attachment.data));
                 
                 QJsonObject imagePart;
                 imagePart.insert(QStringLiteral("type"), QStringLiteral("image_url"));
@@ -405,6 +688,12 @@ LLMResult OpenAIBackend::sendPrompt(
 
     QJsonArray messages;
     messages.append(sysMsg);
+    for (const LLMTurn& turn : message.history) {
+        messages.append(QJsonObject{{QStringLiteral("role"), QStringLiteral("user")},
+                                    {QStringLiteral("content"), turn.prompt}});
+        messages.append(QJsonObject{{QStringLiteral("role"), QStringLiteral("assistant")},
+                                    {QStringLiteral("content"), turn.response}});
+    }
     messages.append(userMsg);
 
     QJsonObject root;
@@ -416,15 +705,9 @@ LLMResult OpenAIBackend::sendPrompt(
         CP_CLOG(cp_params).noquote() << "[ParamBehavior] NOT inserting temperature field";
     }
 
-    if (endpointMode == ModelCapsTypes::EndpointMode::Chat
-        && capsOpt.has_value()
-        && capsOpt->constraints.reasoningEffort.has_value()
-        && capsOpt->constraints.reasoningEffort->defaultValue.has_value()) {
-        const QString effort = capsOpt->constraints.reasoningEffort->defaultValue->trimmed();
-        if (!effort.isEmpty()) {
-            root.insert(QStringLiteral("reasoning_effort"), effort);
-            CP_CLOG(cp_params).noquote() << "[ParamBehavior] Inserting reasoning_effort=" << effort;
-        }
+    if (endpointMode == ModelCapsTypes::EndpointMode::Chat && !reasoningEffort.isEmpty()) {
+        root.insert(QStringLiteral("reasoning_effort"), reasoningEffort);
+        CP_CLOG(cp_params).noquote() << "[ParamBehavior] Inserting reasoning_effort=" << reasoningEffort;
     }
 
     // Token field name selection via caps; default to current behavior for compatibility
@@ -454,7 +737,26 @@ LLMResult OpenAIBackend::sendPrompt(
         root.insert(QStringLiteral("messages"), messages);
     }
 
-    const QByteArray jsonBytes = QJsonDocument(root).toJson(QJsonDocument::Compact);
+    // Chat and completion endpoints stream SSE chunks; the assistant path answers in one piece
+    const bool streaming = onDelta && endpointMode != ModelCapsTypes::EndpointMode::Assistant;
+    if (streaming) {
+        root.insert(QStringLiteral("stream"), true);
+        root.insert(QStringLiteral("stream_options"), QJsonObject{{QStringLiteral("include_usage"), true}});
+    }
+
+    const std::string jsonPayload = payload.serialize(root);
+
+    // Batch jobs send this same body later, one line per request, through the Batch API
+    if (requestBodyOut) {
+        if (endpointMode != ModelCapsTypes::EndpointMode::Chat) {
+            result.hasError = true;
+            result.errorMsg = QStringLiteral("Batch jobs only support chat models; '%1' is not one").arg(resolvedModel);
+            result.content = result.errorMsg;
+            return result;
+        }
+        *requestBodyOut = jsonPayload;
+        return result;
+    }
 
     cpr::Header headers{
         {"Authorization", std::string("Bearer ") + apiKey.toStdString()},
@@ -472,19 +774,24 @@ LLMResult OpenAIBackend::sendPrompt(
 
     // Assistant API self-correction: probe a non-404 endpoint when Assistant mode is selected.
     // This avoids hard 404s on legacy payloads while we implement full Assistant threads/runs.
+    // A successful probe is remembered per API key, so repeated calls skip the round trip.
     if (endpointMode == ModelCapsTypes::EndpointMode::Assistant) {
-        const std::string pingUrl = std::string("https://api.openai.com/v1/assistants?limit=1");
-        CP_CLOG(cp_endpoint).noquote() << "[EndpointRouting] OpenAI assistant probe =>" << QString::fromStdString(pingUrl);
+        if (const auto cached = cachedAssistantProbe(apiKey)) {
+            CP_CLOG(cp_endpoint).noquote() << "[EndpointRouting] OpenAI assistant probe => cached";
+            result.rawResponse = *cached;
+            result.content = QStringLiteral("Assistant endpoint reachable");
+            return result;
+        }
 
-        auto ping = cpr::Get(
-            cpr::Url{pingUrl},
-            headers,
-            cpr::ConnectTimeout{10000},   // 10s connect timeout
-            cpr::Timeout{60000}           // 60s total request timeout
-        );
+        auto ping = assistantProbeRequest(headers, cancellation);
 
         if (ping.error) {
             result.hasError = true;
+            if (cancellation.isCancelled()) {
+                result.errorMsg = BackendCancellation::message();
+                result.content = result.errorMsg;
+                return result;
+            }
             if (ping.error.code == cpr::ErrorCode::OPERATION_TIMEDOUT) {
                 result.errorMsg = QStringLiteral("OpenAI API Timeout");
                 CP_WARN.noquote() << QStringLiteral("OpenAIBackend::sendPrompt assistant probe failure provider=openai model=%1 transport=timeout message=%2")
@@ -502,6 +809,7 @@ LLMResult OpenAIBackend::sendPrompt(
 
         result.rawResponse = QString::fromStdString(ping.text);
         if (ping.status_code >= 200 && ping.status_code < 300) {
+            rememberAssistantProbe(apiKey, result.rawResponse);
             // Return a benign, non-empty content to satisfy live probe success criteria.
             result.content = QStringLiteral("Assistant endpoint reachable");
             return result;
@@ -541,19 +849,82 @@ LLMResult OpenAIBackend::sendPrompt(
     CP_CLOG(cp_endpoint).noquote() << "[EndpointRouting] OpenAI target URL =>" << QString::fromStdString(url)
                        << "mode=" << emode;
 
+    // Streamed chunks carry a delta per choice; the final chunk carries usage
+    QString streamedText;
+    QString streamedFinishReason;
+    QJsonObject streamedUsage;
+    StreamingResponse stream(StreamingResponse::Framing::ServerSentEvents, [&](const QJsonObject& event) {
+        const QJsonArray choices = event.value(QStringLiteral("choices")).toArray();
+        if (!choices.isEmpty()) {
+            const QJsonObject choice = choices.first().toObject();
+            const QString delta = choice.contains(QStringLiteral("delta"))
+                ? textFromMessageContent(choice.value(QStringLiteral("delta")).toObject().value(QStringLiteral("content")))
+                : choice.value(QStringLiteral("text")).toString();
+            if (!delta.isEmpty()) {
+                streamedText += delta;
+                onDelta(delta);
+            }
+            const QString finishReason = choice.value(QStringLiteral("finish_reason")).toString();
+            if (!finishReason.isEmpty()) {
+                streamedFinishReason = finishReason;
+            }
+        }
+        if (event.value(QStringLiteral("usage")).isObject()) {
+            streamedUsage = event.value(QStringLiteral("usage")).toObject();
+        }
+    });
+
+    // Compressed once, so retries resend the same bytes
+    const std::string requestBody = RequestCompression::encodeBody(id(), jsonPayload, headers);
+
     // Perform POST synchronously with explicit timeouts to avoid hanging indefinitely
-    auto response = cpr::Post(
-        cpr::Url{url},
-        headers,
-        cpr::Body{jsonBytes.constData()},
-        cpr::ConnectTimeout{10000},   // 10s connect timeout
-        cpr::Timeout{120000}           // 120s total request timeout
-    );
+    ProviderRateLimiter::Permit permit;
+    auto response = BackendRateLimit::send(
+        permit, id(), resolvedModel,
+        ProviderRateLimiter::estimateTokens(systemPrompt.size() + userPrompt.size(), maxTokens), cancellation,
+        [&] {
+            return streaming
+                ? HttpConnectionPool::post(
+                      cpr::Url{url},
+                      headers,
+                      cpr::Body{requestBody},
+                      cpr::ConnectTimeout{10000},
+                      cpr::Timeout{120000},
+                      BackendCancellation::progressCallback(cancellation),
+                      stream.writeCallback())
+                : HttpConnectionPool::post(
+                      cpr::Url{url},
+                      headers,
+                      cpr::Body{requestBody},
+                      cpr::ConnectTimeout{10000},   // 10s connect timeout
+                      cpr::Timeout{120000},          // 120s total request timeout
+                      BackendCancellation::progressCallback(cancellation));
+        });
+
+    // Reassemble a streamed answer into the non-streaming response shape parsed below
+    if (streaming) {
+        stream.finish();
+        if (response.status_code == 200) {
+            const QJsonObject messageObj{{QStringLiteral("content"), streamedText}};
+            const QJsonObject choice{{QStringLiteral("message"), messageObj},
+                                     {QStringLiteral("finish_reason"), streamedFinishReason}};
+            QJsonObject assembled{{QStringLiteral("choices"), QJsonArray{choice}}};
+            if (!streamedUsage.isEmpty()) {
+                assembled.insert(QStringLiteral("usage"), streamedUsage);
+            }
+            response.text = QJsonDocument(assembled).toJson(QJsonDocument::Compact).toStdString();
+        } else {
+            response.text = stream.raw();
+        }
+    }
     
     if (response.error) {
         result.hasError = true;
+        BackendRateLimit::markTransient(result, response);
 
-        if (response.error.code == cpr::ErrorCode::OPERATION_TIMEDOUT) {
+        if (cancellation.isCancelled()) {
+            result.errorMsg = BackendCancellation::message();
+        } else if (response.error.code == cpr::ErrorCode::OPERATION_TIMEDOUT) {
             result.errorMsg = QStringLiteral("OpenAI API Timeout");
             CP_WARN.noquote() << QStringLiteral("OpenAIBackend::sendPrompt failure provider=openai model=%1 transport=timeout message=%2")
                                           .arg(resolvedModel, QString::fromStdString(response.error.message));
@@ -573,9 +944,13 @@ LLMResult OpenAIBackend::sendPrompt(
     
     if (response.status_code != 200) {
         result.hasError = true;
+        BackendRateLimit::markTransient(result, response);
 
         CP_WARN << "OpenAIBackend::sendPrompt HTTP error" << response.status_code
                    << "body:" << result.rawResponse;
+        if (response.status_code == 401 || response.status_code == 403) {
+            forgetAssistantProbe(apiKey);
+        }
 
         // Try to parse error from JSON
         QJsonParseError parseError;
@@ -602,7 +977,8 @@ LLMResult OpenAIBackend::sendPrompt(
     
     // Parse successful response
     QJsonParseError parseError;
-    QJsonDocument doc = QJsonDocument::fromJson(response.text.c_str(), &parseError);
+    QJsonDocument doc = QJsonDocument::fromJson(
+        QByteArray::fromRawData(response.text.data(), static_cast<qsizetype>(response.text.size())), &parseError);
     
     if (parseError.error != QJsonParseError::NoError) {
         result.hasError = true;
@@ -620,83 +996,282 @@ LLMResult OpenAIBackend::sendPrompt(
     
     QJsonObject rootObj = doc.object();
     
-    // Check for error object in response
-    if (rootObj.contains(QStringLiteral("error"))) {
+    LLMResult parsed = chatCompletionResult(rootObj, maxTokens, resolvedModel);
+    parsed.rawResponse = result.rawResponse;
+    permit.settle(parsed.usage.totalTokens);
+    return parsed;
+}
+
+LLMResult OpenAIBackend::responsesRequest(
+    const QString& apiKey,
+    QJsonObject root,
+    const cpr::Header& headers,
+    const QString& systemPrompt,
+    const QString& userPrompt,
+    const LLMMessage& message,
+    const LLMStreamCallback& onDelta
+) {
+    LLMResult result;
+    const CancellationToken cancellation = CancellationToken::current();
+    const QString resolvedModel = root.value(QStringLiteral("model")).toString();
+    const int maxTokens = root.value(QStringLiteral("max_output_tokens")).toInt();
+
+    JsonPayload payload;
+    QJsonArray content;
+    content.append(QJsonObject{{QStringLiteral("type"), QStringLiteral("input_text")},
+                               {QStringLiteral("text"), userPrompt}});
+    for (const auto& attachment : message.attachments) {
+        if (attachment.mimeType.startsWith(QStringLiteral("image/"))) {
+            content.append(QJsonObject{
+                {QStringLiteral("type"), QStringLiteral("input_image")},
+                {QStringLiteral("image_url"), QStringLiteral("data:%1;base64,").arg(attachment.mimeType)
+                                                  + payload.base64(attachment.data)}});
+        } else if (attachment.mimeType == QStringLiteral("application/pdf")) {
+            result.hasError = true;
+            result.errorMsg = QStringLiteral("OpenAI backend does not support native PDF input.");
+            result.content = result.errorMsg;
+            return result;
+        }
+    }
+
+    // Turns the provider already stores are not resent; instructions never carry over
+    QJsonArray input;
+    if (message.previousResponseId.isEmpty()) {
+        for (const LLMTurn& turn : message.history) {
+            input.append(QJsonObject{{QStringLiteral("role"), QStringLiteral("user")},
+                                     {QStringLiteral("content"), turn.prompt}});
+            input.append(QJsonObject{{QStringLiteral("role"), QStringLiteral("assistant")},
+                                     {QStringLiteral("content"), turn.response}});
+        }
+    } else {
+        root.insert(QStringLiteral("previous_response_id"), message.previousResponseId);
+    }
+    input.append(QJsonObject{{QStringLiteral("role"), QStringLiteral("user")},
+                             {QStringLiteral("content"), content}});
+    if (!systemPrompt.trimmed().isEmpty()) {
+        root.insert(QStringLiteral("instructions"), systemPrompt);
+    }
+    root.insert(QStringLiteral("input"), input);
+    root.insert(QStringLiteral("store"), true);
+
+    cpr::Header requestHeaders = headers;
+    const std::string requestBody = RequestCompression::encodeBody(id(), payload.serialize(root), requestHeaders);
+    CP_CLOG(cp_endpoint).noquote() << "[EndpointRouting] OpenAI target URL =>" << QString::fromStdString(apiBase()) + QStringLiteral("/v1/responses")
+                                   << "continues=" << !message.previousResponseId.isEmpty();
+
+    ProviderRateLimiter::Permit permit;
+    auto response = BackendRateLimit::send(
+        permit, id(), resolvedModel,
+        ProviderRateLimiter::estimateTokens(systemPrompt.size() + userPrompt.size(), maxTokens), cancellation,
+        [&] {
+            return HttpConnectionPool::post(
+                cpr::Url{apiBase() + "/v1/responses"},
+                requestHeaders,
+                cpr::Body{requestBody},
+                cpr::ConnectTimeout{10000},
+                cpr::Timeout{120000},
+                BackendCancellation::progressCallback(cancellation));
+        });
+
+    if (response.error) {
         result.hasError = true;
-        if (rootObj[QStringLiteral("error")].isObject()) {
-            QJsonObject errorObj = rootObj[QStringLiteral("error")].toObject();
-            result.errorMsg = errorObj[QStringLiteral("message")].toString(QStringLiteral("Unknown error"));
+        BackendRateLimit::markTransient(result, response);
+        if (cancellation.isCancelled()) {
+            result.errorMsg = BackendCancellation::message();
+        } else if (response.error.code == cpr::ErrorCode::OPERATION_TIMEDOUT) {
+            result.errorMsg = QStringLiteral("OpenAI API Timeout");
         } else {
-            result.errorMsg = QStringLiteral("Unknown error");
+            result.errorMsg = apiErrorMessage(response);
         }
+        CP_WARN.noquote() << QStringLiteral("OpenAIBackend::sendPrompt failure provider=openai model=%1 api=responses message=%2")
+                                      .arg(resolvedModel, result.errorMsg);
         result.content = result.errorMsg;
         return result;
     }
-    
-    QString finishReason;
-    bool sawChoice = false;
 
-    // Extract content from choices[0].message.content
-    if (rootObj.contains(QStringLiteral("choices")) && rootObj[QStringLiteral("choices")].isArray()) {
-        QJsonArray choices = rootObj[QStringLiteral("choices")].toArray();
-        if (!choices.isEmpty() && choices[0].isObject()) {
-            sawChoice = true;
-            QJsonObject choice = choices[0].toObject();
-            finishReason = choice.value(QStringLiteral("finish_reason")).toString();
-            if (choice.contains(QStringLiteral("message")) && choice[QStringLiteral("message")].isObject()) {
-                QJsonObject message = choice[QStringLiteral("message")].toObject();
-                result.content = textFromMessageContent(message.value(QStringLiteral("content")));
-            } else if (choice.value(QStringLiteral("text")).isString()) {
-                result.content = choice.value(QStringLiteral("text")).toString();
-            }
+    result.rawResponse = QString::fromStdString(response.text);
+    if (response.status_code != 200) {
+        result.hasError = true;
+        BackendRateLimit::markTransient(result, response);
+        result.errorMsg = apiErrorMessage(response);
+        CP_WARN.noquote() << QStringLiteral("OpenAIBackend::sendPrompt failure provider=openai model=%1 api=responses status=%2 message=%3")
+                                      .arg(resolvedModel)
+                                      .arg(response.status_code)
+                                      .arg(result.errorMsg);
+        result.content = result.errorMsg;
+        return result;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(
+        QByteArray::fromRawData(response.text.data(), static_cast<qsizetype>(response.text.size())), &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+        result.hasError = true;
+        result.errorMsg = QStringLiteral("JSON parse error: %1").arg(parseError.errorString());
+        result.content = result.errorMsg;
+        return result;
+    }
+
+    LLMResult parsed = responsesResult(doc.object(), maxTokens, resolvedModel);
+    parsed.rawResponse = result.rawResponse;
+    permit.settle(parsed.usage.totalTokens);
+    // Not streamed: listeners get the whole answer at once
+    if (onDelta && !parsed.hasError) {
+        onDelta(parsed.content);
+    }
+    return parsed;
+}
+
+LLMBatchStatus OpenAIBackend::submitBatch(const QString& apiKey, const QList<LLMBatchRequest>& requests)
+{
+    LLMBatchStatus status;
+
+    // Requests whose body cannot be built are answered now and left out of the job
+    std::string lines;
+    for (const LLMBatchRequest& request : requests) {
+        std::string body;
+        const LLMResult built = promptRequest(apiKey, request.modelName, request.temperature, request.maxTokens,
+                                              request.systemPrompt, request.userPrompt, request.message, {}, &body);
+        if (built.hasError) {
+            status.results.insert(request.customId, built);
+            continue;
         }
+        const QJsonObject envelope{{QStringLiteral("custom_id"), request.customId},
+                                   {QStringLiteral("method"), QStringLiteral("POST")},
+                                   {QStringLiteral("url"), QStringLiteral("/v1/chat/completions")}};
+        // Splice the already serialised body in rather than parsing it back into JSON
+        std::string line = QJsonDocument(envelope).toJson(QJsonDocument::Compact).toStdString();
+        line.pop_back();
+        lines += line + R"(,"body":)" + body + "}\n";
     }
-    
-    // Extract usage statistics
-    if (rootObj.contains(QStringLiteral("usage")) && rootObj[QStringLiteral("usage")].isObject()) {
-        QJsonObject usage = rootObj[QStringLiteral("usage")].toObject();
-        result.usage.inputTokens = usage[QStringLiteral("prompt_tokens")].toInt(0);
-        result.usage.outputTokens = usage[QStringLiteral("completion_tokens")].toInt(0);
-        result.usage.totalTokens = usage[QStringLiteral("total_tokens")].toInt(0);
+    if (lines.empty()) {
+        return status;
     }
 
-    const int reasoningTokens = rootObj.value(QStringLiteral("usage")).isObject()
-                                    ? nestedIntValue(rootObj.value(QStringLiteral("usage")).toObject(),
-                                                     QStringLiteral("completion_tokens_details"),
-                                                     QStringLiteral("reasoning_tokens"))
-                                    : 0;
+    const std::string bearer = std::string("Bearer ") + apiKey.toStdString();
+    try {
+        const auto upload = HttpConnectionPool::post(
+            cpr::Url{apiBase() + "/v1/files"},
+            cpr::Header{{"Authorization", bearer}},
+            cpr::Multipart{{"purpose", "batch"},
+                           {"file", cpr::Buffer{lines.begin(), lines.end(), "batch.jsonl"}, "application/jsonl"}},
+            cpr::Timeout{std::chrono::seconds(300)});
+        const QString fileId = QJsonDocument::fromJson(QByteArray::fromStdString(upload.text))
+                                   .object().value(QStringLiteral("id")).toString();
+        if (upload.status_code != 200 || fileId.isEmpty()) {
+            status.hasError = true;
+            status.errorMsg = QStringLiteral("OpenAI batch input upload failed: %1").arg(apiErrorMessage(upload));
+            return status;
+        }
 
-    if (sawChoice && result.content.trimmed().isEmpty()) {
-        result.hasError = true;
-        const bool hitLimit = finishReason == QStringLiteral("length")
-                              || (maxTokens > 0 && result.usage.outputTokens >= maxTokens);
-        if (hitLimit) {
-            result.errorMsg = QStringLiteral(
-                "OpenAI returned no visible text before reaching max_completion_tokens (%1). "
-                "Increase Max Tokens on this Universal AI node or reduce the prompt/RAG context.")
-                                  .arg(maxTokens);
-            if (reasoningTokens > 0) {
-                result.errorMsg += QStringLiteral(" Reasoning tokens used: %1.").arg(reasoningTokens);
+        const QJsonObject job{{QStringLiteral("input_file_id"), fileId},
+                              {QStringLiteral("endpoint"), QStringLiteral("/v1/chat/completions")},
+                              {QStringLiteral("completion_window"), QStringLiteral("24h")}};
+        const auto created = HttpConnectionPool::post(
+            cpr::Url{apiBase() + "/v1/batches"},
+            cpr::Header{{"Authorization", bearer}, {"Content-Type", "application/json"}},
+            cpr::Body{QJsonDocument(job).toJson(QJsonDocument::Compact).toStdString()},
+            cpr::Timeout{std::chrono::seconds(60)});
+        status.jobId = QJsonDocument::fromJson(QByteArray::fromStdString(created.text))
+                           .object().value(QStringLiteral("id")).toString();
+        if (created.status_code != 200 || status.jobId.isEmpty()) {
+            status.hasError = true;
+            status.errorMsg = QStringLiteral("OpenAI batch creation failed: %1").arg(apiErrorMessage(created));
+        }
+    } catch (const std::exception& e) {
+        status.hasError = true;
+        status.errorMsg = QString::fromUtf8(e.what());
+    }
+    return status;
+}
+
+LLMBatchStatus OpenAIBackend::pollBatch(const QString& apiKey, const QString& jobId)
+{
+    LLMBatchStatus status;
+    status.jobId = jobId;
+    const cpr::Header auth{{"Authorization", std::string("Bearer ") + apiKey.toStdString()}};
+
+    try {
+        const auto polled = HttpConnectionPool::get(
+            cpr::Url{apiBase() + "/v1/batches/" + jobId.toStdString()},
+            auth,
+            cpr::Timeout{std::chrono::seconds(60)});
+        if (polled.status_code != 200) {
+            // Try again at the next poll
+            CP_WARN << "OpenAIBackend::pollBatch:" << jobId << apiErrorMessage(polled);
+            return status;
+        }
+
+        const QJsonObject job = QJsonDocument::fromJson(QByteArray::fromStdString(polled.text)).object();
+        const QString state = job.value(QStringLiteral("status")).toString();
+        if (state == QStringLiteral("failed")) {
+            const QJsonArray errors = job.value(QStringLiteral("errors")).toObject().value(QStringLiteral("data")).toArray();
+            status.hasError = true;
+            status.errorMsg = QStringLiteral("OpenAI batch job %1 failed: %2")
+                                  .arg(jobId, errors.isEmpty()
+                                                  ? QStringLiteral("no reason given")
+                                                  : errors.first().toObject().value(QStringLiteral("message")).toString());
+            return status;
+        }
+        // Expired and cancelled jobs still deliver the answers they finished
+        if (state != QStringLiteral("completed") && state != QStringLiteral("expired")
+            && state != QStringLiteral("cancelled")) {
+            return status;
+        }
+
+        for (const QString& fileKey : {QStringLiteral("output_file_id"), QStringLiteral("error_file_id")}) {
+            const QString fileId = job.value(fileKey).toString();
+            if (fileId.isEmpty()) continue;
+            const auto content = HttpConnectionPool::get(
+                cpr::Url{apiBase() + "/v1/files/" + fileId.toStdString() + "/content"},
+                auth,
+                cpr::Timeout{std::chrono::seconds(300)});
+            if (content.status_code != 200) {
+                CP_WARN << "OpenAIBackend::pollBatch: fetching" << fileKey << "of" << jobId << "failed:"
+                        << apiErrorMessage(content);
+                return status;
+            }
+
+            for (const QByteArray& line : QByteArray::fromStdString(content.text).split('\n')) {
+                const QJsonObject entry = QJsonDocument::fromJson(line).object();
+                const QString customId = entry.value(QStringLiteral("custom_id")).toString();
+                if (customId.isEmpty()) continue;
+
+                const QJsonObject response = entry.value(QStringLiteral("response")).toObject();
+                const QJsonObject body = response.value(QStringLiteral("body")).toObject();
+                LLMResult result;
+                if (response.value(QStringLiteral("status_code")).toInt() == 200) {
+                    result = chatCompletionResult(body, 0, body.value(QStringLiteral("model")).toString());
+                } else {
+                    const QString message = entry.value(QStringLiteral("error")).toObject().value(QStringLiteral("message")).toString();
+                    result.hasError = true;
+                    result.errorMsg = message.isEmpty()
+                        ? body.value(QStringLiteral("error")).toObject().value(QStringLiteral("message"))
+                              .toString(QStringLiteral("HTTP %1").arg(response.value(QStringLiteral("status_code")).toInt()))
+                        : message;
+                    result.content = result.errorMsg;
+                }
+                result.rawResponse = QString::fromUtf8(QJsonDocument(body).toJson(QJsonDocument::Compact));
+                status.results.insert(customId, result);
             }
-        } else if (finishReason == QStringLiteral("content_filter")) {
-            result.errorMsg = QStringLiteral("OpenAI returned no visible text because the response was filtered.");
-        } else if (finishReason == QStringLiteral("tool_calls") || finishReason == QStringLiteral("function_call")) {
-            result.errorMsg = QStringLiteral("OpenAI returned tool calls but this node only supports text responses.");
-        } else {
-            result.errorMsg = QStringLiteral("OpenAI returned an empty text response (finish_reason='%1').")
-                                  .arg(finishReason.isEmpty() ? QStringLiteral("unknown") : finishReason);
         }
-        result.content = result.errorMsg;
-        CP_WARN.noquote() << QStringLiteral("OpenAIBackend::sendPrompt empty response provider=openai model=%1 finish_reason=%2 completion_tokens=%3 max_tokens=%4 reasoning_tokens=%5 message=%6")
-                                      .arg(resolvedModel,
-                                           finishReason.isEmpty() ? QStringLiteral("unknown") : finishReason)
-                                      .arg(result.usage.outputTokens)
-                                      .arg(maxTokens)
-                                      .arg(reasoningTokens)
-                                      .arg(result.errorMsg);
+        status.finished = true;
+    } catch (const std::exception& e) {
+        CP_WARN << "OpenAIBackend::pollBatch:" << jobId << e.what();
+    }
+    return status;
+}
+
+void OpenAIBackend::cancelBatch(const QString& apiKey, const QString& jobId)
+{
+    try {
+        HttpConnectionPool::post(
+            cpr::Url{apiBase() + "/v1/batches/" + jobId.toStdString() + "/cancel"},
+            cpr::Header{{"Authorization", std::string("Bearer ") + apiKey.toStdString()}},
+            cpr::Timeout{std::chrono::seconds(30)});
+    } catch (const std::exception& e) {
+        CP_WARN << "OpenAIBackend::cancelBatch:" << jobId << e.what();
     }
-    
-    return result;
 }
 
 EmbeddingResult OpenAIBackend::getEmbedding(
@@ -704,9 +1279,52 @@ EmbeddingResult OpenAIBackend::getEmbedding(
     const QString& modelName,
     const QString& text
 ) {
-    EmbeddingResult result;
+    return EmbeddingBatcher::firstOf(coalescedEmbeddings(apiKey, modelName, QStringList{text}, 0));
+}
+
+EmbeddingBatchResult OpenAIBackend::getEmbeddings(
+    const QString& apiKey,
+    const QString& modelName,
+    const QStringList& texts
+) {
+    return coalescedEmbeddings(apiKey, modelName, texts, 0);
+}
+
+EmbeddingBatchResult OpenAIBackend::getEmbeddingsAtDimension(
+    const QString& apiKey,
+    const QString& modelName,
+    const QStringList& texts,
+    int dimensions
+) {
+    return coalescedEmbeddings(apiKey, modelName, texts, dimensions);
+}
+
+EmbeddingBatchResult OpenAIBackend::coalescedEmbeddings(
+    const QString& apiKey,
+    const QString& modelName,
+    const QStringList& texts,
+    int dimensions
+) {
+    // The endpoint takes at most 2048 inputs and 300k tokens per request; the
+    // token budget stays well under that since the estimate is only approximate.
+    const QString key = EmbeddingBatcher::coalesceKey(id(), modelName, dimensions, apiKey);
+    return EmbeddingBatcher::coalesce(key, texts, 2048, [&](const QStringList& merged) {
+        return embedInBatches(merged, 2048, 200000, [&](const QStringList& batch) {
+            return embeddingRequest(apiKey, modelName, batch, dimensions);
+        });
+    });
+}
+
+EmbeddingBatchResult OpenAIBackend::embeddingRequest(
+    const QString& apiKey,
+    const QString& modelName,
+    const QStringList& texts,
+    int dimensions
+) {
+    EmbeddingBatchResult result;
+    const CancellationToken cancellation = CancellationToken::current();
 
-    const std::string url = "https://api.openai.com/v1/embeddings";
+    const std::string url = apiBase() + "/v1/embeddings";
 
     // Select embedding model intelligently using ModelCapsRegistry context.
     // If caller passed a chat model (e.g., gpt-4o) or "auto", map to a RAG-optimized
@@ -728,29 +1346,50 @@ EmbeddingResult OpenAIBackend::getEmbedding(
 
     // Build request payload
     QJsonObject root;
-    root.insert(QStringLiteral("input"), text);
+    if (texts.size() == 1) {
+        root.insert(QStringLiteral("input"), texts.front());
+    } else {
+        root.insert(QStringLiteral("input"), QJsonArray::fromStringList(texts));
+    }
     root.insert(QStringLiteral("model"), selectedModel);
-
-    const QByteArray jsonBytes = QJsonDocument(root).toJson(QJsonDocument::Compact);
+    // Only the text-embedding-3 family accepts a reduced size; other models reject the field
+    const bool serverDimensions = dimensions > 0
+        && selectedModel.startsWith(QStringLiteral("text-embedding-3"), Qt::CaseInsensitive);
+    if (serverDimensions) {
+        root.insert(QStringLiteral("dimensions"), dimensions);
+    }
 
     cpr::Header headers{
         {"Authorization", std::string("Bearer ") + apiKey.toStdString()},
         {"Content-Type", "application/json"}
     };
+    const std::string requestBody =
+        RequestCompression::encodeBody(id(), QJsonDocument(root).toJson(QJsonDocument::Compact).toStdString(), headers);
 
     // Perform POST synchronously with explicit timeouts to avoid hanging indefinitely
-    auto response = cpr::Post(
-        cpr::Url{url},
-        headers,
-        cpr::Body{jsonBytes.constData()},
-        cpr::ConnectTimeout{10000},   // 10s connect timeout
-        cpr::Timeout{120000}           // 120s total request timeout
-    );
+    qsizetype inputChars = 0;
+    for (const QString& text : texts) {
+        inputChars += text.size();
+    }
+    ProviderRateLimiter::Permit permit;
+    auto response = BackendRateLimit::send(
+        permit, id(), selectedModel, ProviderRateLimiter::estimateTokens(inputChars), cancellation, [&] {
+            return HttpConnectionPool::post(
+                cpr::Url{url},
+                headers,
+                cpr::Body{requestBody},
+                cpr::ConnectTimeout{10000},   // 10s connect timeout
+                cpr::Timeout{120000},          // 120s total request timeout
+                BackendCancellation::progressCallback(cancellation)
+            );
+        });
     
     if (response.error) {
         result.hasError = true;
 
-        if (response.error.code == cpr::ErrorCode::OPERATION_TIMEDOUT) {
+        if (cancellation.isCancelled()) {
+            result.errorMsg = BackendCancellation::message();
+        } else if (response.error.code == cpr::ErrorCode::OPERATION_TIMEDOUT) {
             result.errorMsg = QStringLiteral("OpenAI API Timeout");
             CP_WARN.noquote() << QStringLiteral("OpenAIBackend::getEmbedding failure provider=openai model=%1 transport=timeout message=%2")
                                           .arg(selectedModel, QString::fromStdString(response.error.message));
@@ -769,6 +1408,9 @@ EmbeddingResult OpenAIBackend::getEmbedding(
 
         CP_WARN << "OpenAIBackend::getEmbedding HTTP error" << response.status_code
                    << "body:" << QString::fromStdString(response.text);
+        if (response.status_code == 401 || response.status_code == 403) {
+            forgetAssistantProbe(apiKey);
+        }
 
         // Try to parse error from JSON
         QJsonParseError parseError;
@@ -792,63 +1434,105 @@ EmbeddingResult OpenAIBackend::getEmbedding(
         return result;
     }
     
-    // Parse successful response
-    QJsonParseError parseError;
-    QJsonDocument doc = QJsonDocument::fromJson(response.text.c_str(), &parseError);
-    
-    if (parseError.error != QJsonParseError::NoError) {
-        result.hasError = true;
-        result.errorMsg = QStringLiteral("JSON parse error: %1").arg(parseError.errorString());
-        return result;
-    }
-    
-    if (!doc.isObject()) {
+    // Walk the body rather than building a QJsonDocument: a batch is mostly floats,
+    // which go straight into the vectors placed by their index
+    JsonReader reader(QByteArrayView(response.text.data(), static_cast<qsizetype>(response.text.size())));
+    if (reader.peek() != JsonReader::Type::Object) {
         result.hasError = true;
         result.errorMsg = QStringLiteral("Invalid JSON: root is not an object");
         return result;
     }
-    
-    QJsonObject rootObj = doc.object();
-    
-    // Check for error object in response
-    if (rootObj.contains(QStringLiteral("error"))) {
-        result.hasError = true;
-        if (rootObj[QStringLiteral("error")].isObject()) {
-            QJsonObject errorObj = rootObj[QStringLiteral("error")].toObject();
-            result.errorMsg = errorObj[QStringLiteral("message")].toString(QStringLiteral("Unknown error"));
-        } else {
+
+    std::vector<std::vector<float>> vectors(static_cast<size_t>(texts.size()));
+    int found = 0;
+    QByteArrayView key;
+    reader.enterObject();
+    while (reader.nextKey(key)) {
+        if (key == "error") {
+            result.hasError = true;
             result.errorMsg = QStringLiteral("Unknown error");
-        }
-        return result;
-    }
-    
-    // Extract embedding vector from data[0].embedding
-    if (rootObj.contains(QStringLiteral("data")) && rootObj[QStringLiteral("data")].isArray()) {
-        QJsonArray dataArray = rootObj[QStringLiteral("data")].toArray();
-        if (!dataArray.isEmpty() && dataArray[0].isObject()) {
-            QJsonObject dataObj = dataArray[0].toObject();
-            if (dataObj.contains(QStringLiteral("embedding")) && dataObj[QStringLiteral("embedding")].isArray()) {
-                QJsonArray embeddingArray = dataObj[QStringLiteral("embedding")].toArray();
-                result.vector.reserve(embeddingArray.size());
-                for (const QJsonValue& val : embeddingArray) {
-                    result.vector.push_back(static_cast<float>(val.toDouble()));
+            if (reader.peek() == JsonReader::Type::Object) {
+                QByteArrayView field;
+                reader.enterObject();
+                while (reader.nextKey(field)) {
+                    if (field == "message" && reader.peek() == JsonReader::Type::String) {
+                        reader.readString(result.errorMsg);
+                    } else {
+                        reader.skipValue();
+                    }
                 }
             }
+            return result;
+        } else if (key == "data" && reader.peek() == JsonReader::Type::Array) {
+            reader.enterArray();
+            for (int i = 0; reader.nextElement(); ++i) {
+                if (reader.peek() != JsonReader::Type::Object) {
+                    reader.skipValue();
+                    continue;
+                }
+                int index = i;
+                std::vector<float> vector;
+                QByteArrayView field;
+                reader.enterObject();
+                while (reader.nextKey(field)) {
+                    if (field == "index" && reader.peek() == JsonReader::Type::Number) {
+                        reader.readInt(index);
+                    } else if (field == "embedding" && reader.peek() == JsonReader::Type::Array) {
+                        reader.readFloats(vector);
+                    } else {
+                        reader.skipValue();
+                    }
+                }
+                if (index < 0 || index >= texts.size() || vector.empty()) {
+                    continue;
+                }
+                if (!serverDimensions) {
+                    truncateEmbedding(vector, dimensions);
+                }
+                vectors[static_cast<size_t>(index)] = std::move(vector);
+                ++found;
+            }
+        } else if (key == "usage" && reader.peek() == JsonReader::Type::Object) {
+            QByteArrayView field;
+            reader.enterObject();
+            while (reader.nextKey(field)) {
+                if (field == "prompt_tokens" && reader.peek() == JsonReader::Type::Number) {
+                    reader.readInt(result.usage.inputTokens);
+                } else if (field == "total_tokens" && reader.peek() == JsonReader::Type::Number) {
+                    reader.readInt(result.usage.totalTokens);
+                } else {
+                    reader.skipValue();
+                }
+            }
+            // Embedding API doesn't have output tokens, only input
+            result.usage.outputTokens = 0;
+        } else {
+            reader.skipValue();
         }
     }
-    
-    // Extract usage statistics
-    if (rootObj.contains(QStringLiteral("usage")) && rootObj[QStringLiteral("usage")].isObject()) {
-        QJsonObject usage = rootObj[QStringLiteral("usage")].toObject();
-        result.usage.inputTokens = usage[QStringLiteral("prompt_tokens")].toInt(0);
-        result.usage.totalTokens = usage[QStringLiteral("total_tokens")].toInt(0);
-        // Embedding API doesn't have output tokens, only input
-        result.usage.outputTokens = 0;
+
+    if (reader.hasError()) {
+        result.hasError = true;
+        result.errorMsg = QStringLiteral("JSON parse error: %1").arg(reader.errorString());
+        return result;
     }
+    if (found == texts.size()) {
+        result.vectors = std::move(vectors);
+    }
+    
+    permit.settle(result.usage.totalTokens);
     
     return result;
 }
 
+void OpenAIBackend::warmUp(const QString& apiKey, const QString& modelName)
+{
+    Q_UNUSED(modelName);
+    if (!apiKey.trimmed().isEmpty()) {
+        HttpConnectionPool::preconnect(apiBase() + "/v1/models");
+    }
+}
+
 QFuture<QString> OpenAIBackend::generateImage(
     const QString& prompt,
     const QString& model,
@@ -857,7 +1541,11 @@ QFuture<QString> OpenAIBackend::generateImage(
     const QString& style,
     const QString& targetDir
 ) {
-    return QtConcurrent::run([prompt, model, size, quality, style, targetDir]() -> QString {
+    // The request runs on another thread, so it takes the caller's token along
+    return QtConcurrent::run([prompt, model, size, quality, style, targetDir,
+                              cancellation = CancellationToken::current(),
+                              tracingContext = Tracer::current()]() -> QString {
+        const Tracer::Scope tracingScope(tracingContext);
         const QString apiKey = LLMProviderRegistry::instance().getCredential(QStringLiteral("openai"));
         if (apiKey.trimmed().isEmpty()) {
             const QString msg = QStringLiteral("Missing OpenAI API key");
@@ -865,7 +1553,7 @@ QFuture<QString> OpenAIBackend::generateImage(
             return msg;
         }
 
-        const std::string url = "https://api.openai.com/v1/images/generations";
+        const std::string url = apiBase() + "/v1/images/generations";
 
         QJsonObject root;
         root.insert(QStringLiteral("model"), model);
@@ -889,18 +1577,57 @@ QFuture<QString> OpenAIBackend::generateImage(
             {"Content-Type", "application/json"}
         };
 
-        auto response = cpr::Post(
-            cpr::Url{url},
-            headers,
-            cpr::Body{jsonBytes.constData()},
-            cpr::ConnectTimeout{10000},
-            cpr::Timeout{60000}
-        );
+        QString filePath;
+        if (!targetDir.isEmpty()) {
+            // Case A: Persistent Output
+            filePath = targetDir + QDir::separator() + QStringLiteral("generated_image.png");
+        } else {
+            // Case B: Fallback to temporary directory
+            QString tempBase = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
+            if (tempBase.isEmpty()) {
+                tempBase = QDir::tempPath();
+            }
+
+            QDir tempDir(tempBase);
+            const QString fileName = QStringLiteral("openai_gen_%1.png").arg(
+                QUuid::createUuid().toString(QUuid::WithoutBraces));
+            filePath = tempDir.filePath(fileName);
+        }
+
+        // The image is decoded into the file as the body arrives rather than buffered;
+        // a retried request starts a fresh download
+        std::optional<Base64FileDownload> streamed;
+
+        // Image requests count against the request budget only
+        ProviderRateLimiter::Permit permit;
+        auto response = BackendRateLimit::send(permit, QStringLiteral("openai"), model, 0, cancellation, [&] {
+            streamed.emplace(filePath);
+            return HttpConnectionPool::post(
+                cpr::Url{url},
+                headers,
+                cpr::Body{jsonBytes.constData()},
+                cpr::ConnectTimeout{10000},
+                cpr::Timeout{60000},
+                BackendCancellation::progressCallback(cancellation),
+                streamed->writeCallback()
+            );
+        });
+        if (!streamed) {
+            streamed.emplace(filePath);
+        }
+        Base64FileDownload& download = *streamed;
+        const bool saved = download.finish();
 
         if (response.error) {
             QString errorMsg;
 
-            if (response.error.code == cpr::ErrorCode::OPERATION_TIMEDOUT) {
+            if (cancellation.isCancelled()) {
+                errorMsg = BackendCancellation::message();
+            } else if (!download.errorString().isEmpty()) {
+                errorMsg = download.errorString();
+                CP_WARN.noquote() << QStringLiteral("OpenAIBackend::generateImage failure provider=openai model=%1 transport=write message=%2")
+                                              .arg(model, errorMsg);
+            } else if (response.error.code == cpr::ErrorCode::OPERATION_TIMEDOUT) {
                 errorMsg = QStringLiteral("OpenAI API Timeout");
                 CP_WARN.noquote() << QStringLiteral("OpenAIBackend::generateImage failure provider=openai model=%1 transport=timeout message=%2")
                                               .arg(model, QString::fromStdString(response.error.message));
@@ -914,7 +1641,9 @@ QFuture<QString> OpenAIBackend::generateImage(
             return errorMsg;
         }
 
-        const QString rawResponse = QString::fromStdString(response.text);
+        // Everything but the image itself, which went to the file
+        const std::string& body = download.raw();
+        const QString rawResponse = QString::fromStdString(body);
 
         if (response.status_code != 200) {
             QString errorMsg;
@@ -923,7 +1652,7 @@ QFuture<QString> OpenAIBackend::generateImage(
                        << "body:" << rawResponse;
 
             QJsonParseError parseError;
-            QJsonDocument doc = QJsonDocument::fromJson(response.text.c_str(), &parseError);
+            QJsonDocument doc = QJsonDocument::fromJson(QByteArray::fromStdString(body), &parseError);
             if (parseError.error == QJsonParseError::NoError && doc.isObject()) {
                 QJsonObject obj = doc.object();
                 if (obj.contains(QStringLiteral("error")) && obj[QStringLiteral("error")].isObject()) {
@@ -941,11 +1670,24 @@ QFuture<QString> OpenAIBackend::generateImage(
                                           .arg(model)
                                           .arg(response.status_code)
                                           .arg(errorMsg);
+            if (saved) {
+                QFile::remove(filePath);
+            }
             return errorMsg;
         }
 
+        if (saved) {
+            CP_CLOG(cp_lifecycle).noquote() << "Saved DALL-E image to:" << filePath
+                                            << "bytes:" << download.bytesWritten();
+            return filePath;
+        }
+        if (!download.errorString().isEmpty()) {
+            CP_WARN << "OpenAIBackend::generateImage" << download.errorString();
+            return download.errorString();
+        }
+
         QJsonParseError parseError;
-        QJsonDocument doc = QJsonDocument::fromJson(response.text.c_str(), &parseError);
+        QJsonDocument doc = QJsonDocument::fromJson(QByteArray::fromStdString(body), &parseError);
 
         if (parseError.error != QJsonParseError::NoError) {
             return QStringLiteral("JSON parse error: %1").arg(parseError.errorString());
@@ -966,58 +1708,7 @@ QFuture<QString> OpenAIBackend::generateImage(
             return QStringLiteral("Unknown error");
         }
 
-        QString b64Image;
-        if (rootObj.contains(QStringLiteral("data")) && rootObj[QStringLiteral("data")].isArray()) {
-            QJsonArray dataArray = rootObj[QStringLiteral("data")].toArray();
-            if (!dataArray.isEmpty() && dataArray[0].isObject()) {
-                QJsonObject dataObj = dataArray[0].toObject();
-                b64Image = dataObj[QStringLiteral("b64_json")].toString();
-            }
-        }
-
-        if (b64Image.isEmpty()) {
-            CP_WARN << "OpenAIBackend::generateImage missing b64_json field" << rawResponse;
-            return QStringLiteral("OpenAI image response missing data");
-        }
-
-        const QByteArray imageData = QByteArray::fromBase64(b64Image.toUtf8());
-        if (imageData.isEmpty()) {
-            return QStringLiteral("Failed to decode image data");
-        }
-
-        QString filePath;
-        if (!targetDir.isEmpty()) {
-            // Case A: Persistent Output
-            filePath = targetDir + QDir::separator() + QStringLiteral("generated_image.png");
-            CP_CLOG(cp_lifecycle).noquote() << "Saved DALL-E image to persistent path:" << filePath;
-        } else {
-            // Case B: Fallback to temporary directory
-            QString tempBase = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
-            if (tempBase.isEmpty()) {
-                tempBase = QDir::tempPath();
-            }
-
-            QDir tempDir(tempBase);
-            const QString fileName = QStringLiteral("openai_gen_%1.png").arg(
-                QUuid::createUuid().toString(QUuid::WithoutBraces));
-            filePath = tempDir.filePath(fileName);
-        }
-
-        QFile outFile(filePath);
-        if (!outFile.open(QIODevice::WriteOnly)) {
-            CP_WARN << "OpenAIBackend::generateImage failed to open file" << filePath
-                       << "error" << outFile.errorString();
-            return QStringLiteral("Failed to write generated image");
-        }
-
-        const qint64 bytesWritten = outFile.write(imageData);
-        outFile.close();
-
-        if (bytesWritten != imageData.size()) {
-            CP_WARN << "OpenAIBackend::generateImage incomplete write" << filePath;
-            return QStringLiteral("Failed to save generated image");
-        }
-
-        return filePath;
+        CP_WARN << "OpenAIBackend::generateImage missing b64_json field" << rawResponse;
+        return QStringLiteral("OpenAI image response missing data");
     });
 }
@@ -24,10 +24,19 @@
 #pragma once
 
 #include "ILLMBackend.h"
+#include "CancellationToken.h"
+#include <QDeadlineTimer>
+#include <QHash>
+#include <QJsonObject>
 #include <QMutex>
 #include <QByteArray>
 #include <QStringList>
 
+#include <cpr/cpr.h>
+
+#include <optional>
+#include <string>
+
 /**
  * @brief OpenAI backend implementation using the Chat Completions API.
  *
@@ -58,12 +67,49 @@ public:
         const LLMMessage& message = {}
     ) override;
 
+    LLMResult streamPrompt(
+        const QString& apiKey,
+        const QString& modelName,
+        double temperature,
+        int maxTokens,
+        const QString& systemPrompt,
+        const QString& userPrompt,
+        const LLMStreamCallback& onDelta,
+        const LLMMessage& message = {}
+    ) override;
+
     EmbeddingResult getEmbedding(
         const QString& apiKey,
         const QString& modelName,
         const QString& text
     ) override;
 
+    EmbeddingBatchResult getEmbeddings(
+        const QString& apiKey,
+        const QString& modelName,
+        const QStringList& texts
+    ) override;
+
+    // text-embedding-3-* take a "dimensions" field; older models are truncated locally
+    EmbeddingBatchResult getEmbeddingsAtDimension(
+        const QString& apiKey,
+        const QString& modelName,
+        const QStringList& texts,
+        int dimensions
+    ) override;
+
+    // Stored conversations run through the Responses API (previous_response_id)
+    bool supportsStoredConversations() const override { return true; }
+
+    // Batch API: requests go up as a JSONL file and run within 24 hours at half price
+    // Opens a pooled connection to the API host; nothing is sent without a key
+    void warmUp(const QString& apiKey, const QString& modelName) override;
+
+    bool supportsBatch() const override { return true; }
+    LLMBatchStatus submitBatch(const QString& apiKey, const QList<LLMBatchRequest>& requests) override;
+    LLMBatchStatus pollBatch(const QString& apiKey, const QString& jobId) override;
+    void cancelBatch(const QString& apiKey, const QString& jobId) override;
+
     QFuture<QString> generateImage(
         const QString& prompt,
         const QString& model,
@@ -73,11 +119,73 @@ public:
         const QString& targetDir = QString()
     ) override;
 
+    // How long a successful Assistant-mode endpoint probe is trusted for one API key
+    static constexpr qint64 kAssistantProbeTtlMs = 10 * 60 * 1000;
+
 protected:
     // Test seam: allows tests to override the raw JSON fetcher without real network
     virtual QFuture<QByteArray> fetchRawModelListJson();
 
+    // Test seam: the GET /v1/assistants?limit=1 probe made by Assistant-mode prompts
+    virtual cpr::Response assistantProbeRequest(const cpr::Header& headers, const CancellationToken& cancellation);
+
 private:
+    // Shared by sendPrompt() and streamPrompt(); streams when onDelta is set. With
+    // requestBodyOut it only builds the request body, for submitBatch().
+    LLMResult promptRequest(
+        const QString& apiKey,
+        const QString& modelName,
+        double temperature,
+        int maxTokens,
+        const QString& systemPrompt,
+        const QString& userPrompt,
+        const LLMMessage& message,
+        const LLMStreamCallback& onDelta,
+        std::string* requestBodyOut = nullptr
+    );
+
+    // One /v1/responses request for a stored conversation. root already carries the model
+    // and sampling fields; the instructions, input and previous_response_id are added here.
+    LLMResult responsesRequest(
+        const QString& apiKey,
+        QJsonObject root,
+        const cpr::Header& headers,
+        const QString& systemPrompt,
+        const QString& userPrompt,
+        const LLMMessage& message,
+        const LLMStreamCallback& onDelta
+    );
+
+    // Every embedding call: small ones are merged with concurrent calls for the same
+    // model, key and dimensions (EmbeddingBatcher::coalesce()), then split into requests
+    EmbeddingBatchResult coalescedEmbeddings(
+        const QString& apiKey,
+        const QString& modelName,
+        const QStringList& texts,
+        int dimensions
+    );
+
+    // One /v1/embeddings request; shared by getEmbedding() and getEmbeddings(). A positive
+    // dimensions asks for vectors of that size.
+    EmbeddingBatchResult embeddingRequest(
+        const QString& apiKey,
+        const QString& modelName,
+        const QStringList& texts,
+        int dimensions = 0
+    );
+
+    // Probe results are kept per SHA-256 of the API key; auth errors drop them
+    std::optional<QString> cachedAssistantProbe(const QString& apiKey);
+    void rememberAssistantProbe(const QString& apiKey, const QString& rawResponse);
+    void forgetAssistantProbe(const QString& apiKey);
+
+    struct AssistantProbe {
+        QString rawResponse;
+        QDeadlineTimer expiry;
+    };
+
     mutable QMutex m_cacheMutex;
     QStringList m_cachedModels;
+    QMutex m_probeMutex;
+    QHash<QByteArray, AssistantProbe> m_assistantProbes;
 };
@@ -0,0 +1,64 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QString>
+
+#include <string>
+
+#include "ModelCapsRegistry.h"
+
+// Where a provider's API lives. The environment variable wins, then the baseUrl of
+// the provider's entry in the model catalog, then the provider's public host. The
+// value is scheme, host and port (plus any path prefix a gateway needs); request
+// paths such as "/v1/models" are appended to it, so trailing slashes are dropped.
+// Pointing a hosted backend at an OpenAI-compatible gateway or a local mock server
+// needs nothing else.
+namespace ProviderEndpoint {
+
+inline QString trimmedBase(QString value)
+{
+    value = value.trimmed();
+    while (value.endsWith(QLatin1Char('/'))) {
+        value.chop(1);
+    }
+    return value;
+}
+
+inline QString baseUrl(const QString& providerId, const char* environmentVariable, const QString& defaultUrl)
+{
+    const QString fromEnvironment = trimmedBase(qEnvironmentVariable(environmentVariable));
+    if (!fromEnvironment.isEmpty()) {
+        return fromEnvironment;
+    }
+    if (const auto settings = ModelCapsRegistry::instance().providerSettings(providerId)) {
+        const QString fromCatalog = trimmedBase(settings->baseUrl);
+        if (!fromCatalog.isEmpty()) {
+            return fromCatalog;
+        }
+    }
+    return defaultUrl;
+}
+
+} // namespace ProviderEndpoint
@@ -0,0 +1,100 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "RequestCompression.h"
+
+#include "Logger.h"
+#include "LoggingCategories.h"
+#include "ModelCapsRegistry.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+
+namespace {
+
+// Input fed to and output taken from zlib per deflate() call
+constexpr size_t kChunkBytes = 256 * 1024;
+
+} // namespace
+
+namespace RequestCompression {
+
+std::string encodeBody(const QString& providerId, std::string body, cpr::Header& headers)
+{
+    const auto settings = ModelCapsRegistry::instance().providerSettings(providerId);
+    if (!settings || settings->contentEncoding.compare(QLatin1String("gzip"), Qt::CaseInsensitive) != 0) {
+        return body;
+    }
+    const qsizetype minBytes = settings->compressMinBytes > 0 ? settings->compressMinBytes : kDefaultMinBytes;
+    if (static_cast<qsizetype>(body.size()) < minBytes) {
+        return body;
+    }
+
+    std::string compressed = gzip(body);
+    // Incompressible bodies (already-compressed attachments) go out as they are
+    if (compressed.empty() || compressed.size() >= body.size()) {
+        return body;
+    }
+    CP_CLOG(cp_endpoint).noquote() << "[RequestCompression]" << providerId << "gzip" << body.size() << "->"
+                                   << compressed.size() << "bytes";
+    headers["Content-Encoding"] = "gzip";
+    return compressed;
+}
+
+std::string gzip(const std::string& data)
+{
+    z_stream stream {};
+    // 15 window bits plus 16 selects the gzip wrapper
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return {};
+    }
+
+    std::string out;
+    out.reserve(data.size() / 4);
+    std::string buffer(kChunkBytes, '\0');
+    size_t offset = 0;
+    int status = Z_OK;
+    do {
+        const size_t take = std::min(kChunkBytes, data.size() - offset);
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data() + offset));
+        stream.avail_in = static_cast<uInt>(take);
+        offset += take;
+        const int flush = offset == data.size() ? Z_FINISH : Z_NO_FLUSH;
+        do {
+            stream.next_out = reinterpret_cast<Bytef*>(buffer.data());
+            stream.avail_out = static_cast<uInt>(buffer.size());
+            status = deflate(&stream, flush);
+            if (status == Z_STREAM_ERROR) {
+                deflateEnd(&stream);
+                return {};
+            }
+            out.append(buffer.data(), buffer.size() - stream.avail_out);
+        } while (stream.avail_out == 0);
+    } while (status != Z_STREAM_END);
+
+    deflateEnd(&stream);
+    return out;
+}
+
+} // namespace RequestCompression
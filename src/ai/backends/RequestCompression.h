@@ -0,0 +1,51 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <QString>
+
+#include <cpr/cpr.h>
+
+#include <string>
+
+// Opt-in compression of large request bodies, for providers reached through a
+// gateway that accepts them. A provider's catalog entry enables it with
+// "contentEncoding": "gzip"; bodies of at least "compressMinBytes" (default
+// kDefaultMinBytes) are then gzip-compressed once, before the first attempt, and
+// sent with Content-Encoding: gzip. Retries resend the same compressed bytes.
+// Responses need nothing here: libcurl advertises and decodes gzip and deflate.
+namespace RequestCompression {
+
+constexpr qsizetype kDefaultMinBytes = 64 * 1024;
+
+// The body to send for providerId: the body itself, or its gzip stream when the
+// provider asks for compression and the body is big enough, in which case
+// Content-Encoding is added to headers
+std::string encodeBody(const QString& providerId, std::string body, cpr::Header& headers);
+
+// gzip stream of data, deflated a fixed-size chunk at a time; empty on failure
+std::string gzip(const std::string& data);
+
+} // namespace RequestCompression
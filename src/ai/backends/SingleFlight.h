@@ -0,0 +1,138 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QString>
+#include <QWaitCondition>
+
+#include <memory>
+#include <optional>
+
+#include "CancellationToken.h"
+#include "MetricsRegistry.h"
+
+// Coalesces identical backend calls that are in flight at the same time. The first
+// caller for a key makes the call; callers arriving with the same key before it
+// returns wait for it and get a copy of its result instead of sending their own
+// request. Nothing is kept once the call returns: later callers go through the
+// response or embedding cache as before. Keys are the ones those caches use, so
+// only requests that may share an answer share a call.
+//
+// A waiter whose own run is cancelled stops waiting and makes its own call, which
+// returns at once. When the leading call was cancelled or threw, its waiters start
+// over, so one stopped run can't fail the others. Shared answers count in
+// cp_coalesced_requests under the given kind.
+template <typename Result>
+class SingleFlight {
+public:
+    explicit SingleFlight(QString kind)
+        : m_kind(std::move(kind))
+    {
+    }
+
+    // Returns call()'s result, or that of an identical call in flight, in which case
+    // *coalesced is set; such a result cost nothing and must not be billed again
+    template <typename Call>
+    Result run(const QByteArray& key, Call&& call, bool* coalesced = nullptr)
+    {
+        if (coalesced) *coalesced = false;
+        for (;;) {
+            std::shared_ptr<Flight> flight;
+            bool leader = false;
+            {
+                QMutexLocker locker(&m_mutex);
+                std::shared_ptr<Flight>& slot = m_flights[key];
+                if (!slot) {
+                    slot = std::make_shared<Flight>();
+                    leader = true;
+                }
+                flight = slot;
+            }
+            if (leader) return lead(key, flight, call);
+
+            const CancellationToken cancellation = CancellationToken::current();
+            QMutexLocker locker(&flight->mutex);
+            while (!flight->done && !cancellation.isCancelled()) {
+                flight->finished.wait(&flight->mutex, kCancellationPollMs);
+            }
+            if (!flight->done) {
+                locker.unlock();
+                return call();
+            }
+            if (flight->result) {
+                MetricsRegistry::instance()
+                    .counter(QStringLiteral("cp_coalesced_requests"),
+                             QStringLiteral("Backend requests answered by an identical request in flight"),
+                             {{QStringLiteral("kind"), m_kind}})
+                    .increment();
+                if (coalesced) *coalesced = true;
+                return *flight->result;
+            }
+        }
+    }
+
+private:
+    static constexpr unsigned long kCancellationPollMs = 50;
+
+    struct Flight {
+        QMutex mutex;
+        QWaitCondition finished;
+        bool done {false};
+        std::optional<Result> result; // empty when waiters must call again
+    };
+
+    template <typename Call>
+    Result lead(const QByteArray& key, const std::shared_ptr<Flight>& flight, Call& call)
+    {
+        const auto finish = [&](std::optional<Result> shared) {
+            {
+                QMutexLocker locker(&m_mutex);
+                m_flights.remove(key);
+            }
+            QMutexLocker locker(&flight->mutex);
+            flight->result = std::move(shared);
+            flight->done = true;
+            flight->finished.wakeAll();
+        };
+
+        std::optional<Result> result;
+        try {
+            result.emplace(call());
+        } catch (...) {
+            finish(std::nullopt);
+            throw;
+        }
+        // A cancelled run's answer is only good for that run
+        finish(CancellationToken::current().isCancelled() ? std::nullopt : result);
+        return std::move(*result);
+    }
+
+    const QString m_kind;
+    QMutex m_mutex;
+    QHash<QByteArray, std::shared_ptr<Flight>> m_flights;
+};
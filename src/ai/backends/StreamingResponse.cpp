@@ -0,0 +1,107 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "StreamingResponse.h"
+
+#include <QJsonDocument>
+#include <QJsonParseError>
+
+#include <utility>
+
+StreamingResponse::StreamingResponse(Framing framing, EventHandler onEvent)
+    : m_framing(framing)
+    , m_onEvent(std::move(onEvent))
+{
+}
+
+cpr::WriteCallback StreamingResponse::writeCallback()
+{
+    return cpr::WriteCallback([this](std::string_view data, intptr_t) {
+        feed(data);
+        return true;
+    });
+}
+
+void StreamingResponse::feed(std::string_view data)
+{
+    m_raw.append(data);
+    m_pending.append(data.data(), static_cast<qsizetype>(data.size()));
+    qsizetype newline;
+    while ((newline = m_pending.indexOf('\n')) >= 0) {
+        QByteArray line = m_pending.left(newline);
+        m_pending.remove(0, newline + 1);
+        if (line.endsWith('\r')) {
+            line.chop(1);
+        }
+        handleLine(line);
+    }
+}
+
+void StreamingResponse::finish()
+{
+    if (!m_pending.isEmpty()) {
+        handleLine(std::exchange(m_pending, QByteArray()));
+    }
+    // A blank line ends an SSE event; flush one the server left open
+    handleLine(QByteArray());
+}
+
+void StreamingResponse::handleLine(const QByteArray& line)
+{
+    if (m_framing == Framing::JsonLines) {
+        if (!line.trimmed().isEmpty()) {
+            dispatch(line);
+        }
+        return;
+    }
+
+    if (line.isEmpty()) {
+        if (!m_eventData.isEmpty()) {
+            dispatch(std::exchange(m_eventData, QByteArray()));
+        }
+        return;
+    }
+    // "event:", "id:" and ":" comment lines carry nothing the payloads don't repeat
+    if (line.startsWith("data:")) {
+        QByteArray value = line.mid(5);
+        if (value.startsWith(' ')) {
+            value.remove(0, 1);
+        }
+        if (!m_eventData.isEmpty()) {
+            m_eventData.append('\n');
+        }
+        m_eventData.append(value);
+    }
+}
+
+void StreamingResponse::dispatch(const QByteArray& payload)
+{
+    if (payload.trimmed() == "[DONE]") {
+        return;
+    }
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(payload, &error);
+    if (error.error == QJsonParseError::NoError && doc.isObject() && m_onEvent) {
+        m_onEvent(doc.object());
+    }
+}
@@ -0,0 +1,66 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QJsonObject>
+
+#include <cpr/cpr.h>
+
+#include <functional>
+#include <string>
+#include <string_view>
+
+// Incremental reader for streamed chat responses. Pass writeCallback() to the request
+// and every complete event is parsed and handed to the handler as it arrives: Server-
+// Sent Events "data:" payloads for OpenAI, Anthropic and Google, newline-delimited
+// JSON for Ollama. Everything received is also kept in raw(), so an error body can
+// still be parsed the way the non-streaming path does.
+class StreamingResponse {
+public:
+    enum class Framing {
+        ServerSentEvents,
+        JsonLines
+    };
+    using EventHandler = std::function<void(const QJsonObject& event)>;
+
+    StreamingResponse(Framing framing, EventHandler onEvent);
+
+    cpr::WriteCallback writeCallback();
+    void feed(std::string_view data);
+    // Parses a final event that was not terminated by a newline
+    void finish();
+
+    const std::string& raw() const { return m_raw; }
+
+private:
+    void handleLine(const QByteArray& line);
+    void dispatch(const QByteArray& payload);
+
+    Framing m_framing;
+    EventHandler m_onEvent;
+    std::string m_raw;
+    QByteArray m_pending;
+    QByteArray m_eventData;
+};
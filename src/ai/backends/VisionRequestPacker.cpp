@@ -0,0 +1,229 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "VisionRequestPacker.h"
+#include "MetricsRegistry.h"
+
+#include <QDeadlineTimer>
+#include <QHash>
+#include <QRegularExpression>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// Packers for prompt groups that have gone quiet are dropped past this many
+constexpr int kMaxIdleGroups = 64;
+
+QString itemMarker(int number)
+{
+    return QStringLiteral("=== ITEM %1 ===").arg(number);
+}
+
+} // namespace
+
+VisionRequestPacker::VisionRequestPacker(int windowMs)
+    : m_windowMs(std::max(0, windowMs))
+{
+}
+
+std::shared_ptr<VisionRequestPacker> VisionRequestPacker::forGroup(const QString& groupKey)
+{
+    static QMutex mutex;
+    static QHash<QString, std::shared_ptr<VisionRequestPacker>> packers;
+    QMutexLocker locker(&mutex);
+    if (const auto it = packers.constFind(groupKey); it != packers.constEnd()) {
+        return it.value();
+    }
+    if (packers.size() >= kMaxIdleGroups) {
+        // Only this table holds a packer nobody is submitting to
+        for (auto it = packers.begin(); it != packers.end();) {
+            it = it.value().use_count() == 1 ? packers.erase(it) : std::next(it);
+        }
+    }
+    auto packer = std::make_shared<VisionRequestPacker>();
+    packers.insert(groupKey, packer);
+    return packer;
+}
+
+std::optional<LLMResult> VisionRequestPacker::submit(const QString& userPrompt, const LLMMessage& message,
+                                                     int promptTokens, const Limits& limits, const Run& run)
+{
+    Request request;
+    request.userPrompt = &userPrompt;
+    request.message = &message;
+    request.tokens = promptTokens + static_cast<int>(message.attachments.size()) * kImageTokenEstimate;
+    request.limits = limits;
+    QMutexLocker locker(&m_mutex);
+    m_queue.push_back(&request);
+    m_queuedImages += static_cast<int>(message.attachments.size());
+    m_queued.wakeAll();
+    while (!request.done) {
+        if (m_running) {
+            m_finished.wait(&m_mutex);
+        } else {
+            runGroup(locker, run);
+        }
+    }
+    return std::move(request.result);
+}
+
+QString VisionRequestPacker::packedPrompt(const QStringList& prompts, const QList<int>& attachmentCounts)
+{
+    QStringList owners;
+    int first = 1;
+    for (qsizetype i = 0; i < prompts.size(); ++i) {
+        const int count = attachmentCounts.value(i);
+        const QString range = count == 1 ? QStringLiteral("attachment %1").arg(first)
+                                         : QStringLiteral("attachments %1-%2").arg(first).arg(first + count - 1);
+        owners.append(QStringLiteral("item %1 is %2").arg(i + 1).arg(range));
+        first += count;
+    }
+
+    QString prompt = QStringLiteral(
+        "The attachments belong to %1 separate items, in order: %2. Answer each item on its own, "
+        "using only its attachments. Begin each answer with a line reading exactly \"%3\", with the "
+        "item's number in place of N, and write nothing before the first one.\n")
+        .arg(prompts.size())
+        .arg(owners.join(QStringLiteral(", ")), QStringLiteral("=== ITEM N ==="));
+    for (qsizetype i = 0; i < prompts.size(); ++i) {
+        prompt += QLatin1Char('\n') + itemMarker(static_cast<int>(i) + 1) + QLatin1Char('\n') + prompts.at(i)
+            + QLatin1Char('\n');
+    }
+    return prompt;
+}
+
+QStringList VisionRequestPacker::splitSections(const QString& response, int count)
+{
+    static const QRegularExpression marker(QStringLiteral(R"(^[ \t]*=== ITEM (\d+) ===[ \t]*$)"),
+                                           QRegularExpression::MultilineOption);
+    QStringList sections(count);
+    int previous = 0;
+    qsizetype sectionStart = -1;
+    auto it = marker.globalMatch(response);
+    while (it.hasNext()) {
+        const QRegularExpressionMatch match = it.next();
+        if (previous > 0) {
+            sections[previous - 1] = response.mid(sectionStart, match.capturedStart() - sectionStart).trimmed();
+        }
+        const int number = match.captured(1).toInt();
+        // Numbers must rise by one; anything else means the sections can't be trusted
+        if (number != previous + 1 || number > count) {
+            return {};
+        }
+        previous = number;
+        sectionStart = match.capturedEnd();
+    }
+    if (previous != count) {
+        return {};
+    }
+    sections[count - 1] = response.mid(sectionStart).trimmed();
+    return sections;
+}
+
+void VisionRequestPacker::runGroup(QMutexLocker<QMutex>& locker, const Run& run)
+{
+    m_running = true;
+
+    // Give concurrent prompts the window to join, unless the group is already full
+    const int maxImages = std::max(1, m_queue.front()->limits.maxImages);
+    const int tokenBudget = m_queue.front()->limits.tokenBudget;
+    const QDeadlineTimer window(m_windowMs);
+    while (m_queuedImages < maxImages && !window.hasExpired()) {
+        m_queued.wait(&m_mutex, window);
+    }
+
+    // The first prompt always goes, even when it alone is over the limits
+    std::vector<Request*> group;
+    int images = 0;
+    int tokens = 0;
+    while (!m_queue.empty()) {
+        Request* next = m_queue.front();
+        const int nextImages = static_cast<int>(next->message->attachments.size());
+        if (!group.empty()
+            && (images + nextImages > maxImages || (tokenBudget > 0 && tokens + next->tokens > tokenBudget))) {
+            break;
+        }
+        m_queue.pop_front();
+        m_queuedImages -= nextImages;
+        images += nextImages;
+        tokens += next->tokens;
+        group.push_back(next);
+    }
+
+    // A prompt on its own is sent by its caller as usual
+    if (group.size() > 1) {
+        QStringList prompts;
+        QList<int> attachmentCounts;
+        LLMMessage packed = *group.front()->message;
+        packed.attachments.clear();
+        packed.cacheAttachments = false;
+        for (const Request* request : group) {
+            prompts.append(*request->userPrompt);
+            attachmentCounts.append(static_cast<int>(request->message->attachments.size()));
+            packed.attachments += request->message->attachments;
+        }
+        const int items = static_cast<int>(group.size());
+
+        locker.unlock();
+        MetricsRegistry::instance()
+            .histogram(QStringLiteral("cp_vision_pack_items"), QStringLiteral("Prompts packed into one vision request"))
+            .observe(static_cast<double>(items));
+        LLMResult merged;
+        try {
+            merged = run(packedPrompt(prompts, attachmentCounts), packed, items);
+        } catch (...) {
+            merged = {};
+            merged.hasError = true;
+            merged.errorMsg = QStringLiteral("Packed vision request failed with an exception");
+            merged.content = merged.errorMsg;
+        }
+        const QStringList sections = merged.hasError ? QStringList() : splitSections(merged.content, items);
+        locker.relock();
+
+        for (int i = 0; i < items; ++i) {
+            Request* request = group[static_cast<size_t>(i)];
+            if (merged.hasError) {
+                request->result = merged;
+            } else if (!sections.isEmpty() && !sections.at(i).isEmpty()) {
+                LLMResult result;
+                result.content = sections.at(i);
+                result.rawResponse = merged.rawResponse;
+                result.usage.inputTokens = merged.usage.inputTokens / items;
+                result.usage.outputTokens = merged.usage.outputTokens / items;
+                result.usage.totalTokens = merged.usage.totalTokens / items;
+                result.usage.cacheReadTokens = merged.usage.cacheReadTokens / items;
+                result.usage.cacheWriteTokens = merged.usage.cacheWriteTokens / items;
+                request->result = std::move(result);
+            }
+            request->done = true;
+        }
+    } else {
+        for (Request* request : group) {
+            request->done = true;
+        }
+    }
+    m_running = false;
+    m_finished.wakeAll();
+}
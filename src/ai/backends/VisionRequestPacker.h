@@ -0,0 +1,98 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include "ILLMBackend.h"
+
+#include <QList>
+#include <QMutex>
+#include <QStringList>
+#include <QWaitCondition>
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+
+// Packs the attachments of concurrent vision prompts into shared requests, so a
+// loop sending one page image per prompt makes one call per group of pages
+// rather than one per page. Works like EmbeddingBatcher: a caller finding no
+// group running leads one, waits up to the window for other callers, takes
+// queued prompts in arrival order while they fit the image and token limits,
+// and sends them as one numbered prompt asking for an answer per item. The
+// answer is split on the item markers and each caller gets its own section;
+// the usage is split between them by item count.
+class VisionRequestPacker {
+public:
+    struct Limits {
+        // Attachments per packed request
+        int maxImages {8};
+        // Estimated input tokens per packed request; 0 for no limit
+        int tokenBudget {0};
+    };
+
+    // Sends a packed prompt; items is the number of prompts packed into it
+    using Run = std::function<LLMResult(const QString& userPrompt, const LLMMessage& message, int items)>;
+
+    static constexpr int kDefaultWindowMs = 100;
+    // Rough input tokens per image, for the token budget
+    static constexpr int kImageTokenEstimate = 1600;
+
+    explicit VisionRequestPacker(int windowMs = kDefaultWindowMs);
+
+    // The packer shared by prompts that may go out together: same provider, model,
+    // system prompt and sampling settings
+    static std::shared_ptr<VisionRequestPacker> forGroup(const QString& groupKey);
+
+    // This prompt's answer from a packed request. Returns nothing when the prompt
+    // went out alone or its section was missing from the answer; the caller then
+    // sends it by itself. promptTokens is the caller's estimate for the prompt text.
+    std::optional<LLMResult> submit(const QString& userPrompt, const LLMMessage& message, int promptTokens,
+                                    const Limits& limits, const Run& run);
+
+    // The prompt sent for a group, and its answer split back into one section per
+    // item (an empty list when a marker is missing or out of order)
+    static QString packedPrompt(const QStringList& prompts, const QList<int>& attachmentCounts);
+    static QStringList splitSections(const QString& response, int count);
+
+private:
+    struct Request {
+        const QString* userPrompt {nullptr};
+        const LLMMessage* message {nullptr};
+        int tokens {0};
+        Limits limits;
+        std::optional<LLMResult> result;
+        bool done {false};
+    };
+
+    void runGroup(QMutexLocker<QMutex>& locker, const Run& run);
+
+    const int m_windowMs;
+    QMutex m_mutex;
+    QWaitCondition m_queued;
+    QWaitCondition m_finished;
+    std::deque<Request*> m_queue;
+    int m_queuedImages {0};
+    bool m_running {false};
+};
@@ -0,0 +1,191 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "WordPieceTokenizer.h"
+
+#include <QFile>
+
+namespace {
+
+// BERT counts every ASCII symbol as punctuation, "$" and "^" included
+bool isPunctuation(QChar c)
+{
+    const char16_t u = c.unicode();
+    if ((u >= 33 && u <= 47) || (u >= 58 && u <= 64) || (u >= 91 && u <= 96) || (u >= 123 && u <= 126)) {
+        return true;
+    }
+    return c.isPunct();
+}
+
+bool isCjk(char32_t u)
+{
+    return (u >= 0x4E00 && u <= 0x9FFF) || (u >= 0x3400 && u <= 0x4DBF) || (u >= 0x20000 && u <= 0x2A6DF)
+           || (u >= 0x2A700 && u <= 0x2B73F) || (u >= 0x2B740 && u <= 0x2B81F) || (u >= 0x2B820 && u <= 0x2CEAF)
+           || (u >= 0xF900 && u <= 0xFAFF) || (u >= 0x2F800 && u <= 0x2FA1F);
+}
+
+} // namespace
+
+bool WordPieceTokenizer::loadVocabulary(const QString& path, QString* error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = QStringLiteral("Cannot read vocabulary %1: %2").arg(path, file.errorString());
+        return false;
+    }
+    QStringList tokens;
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine();
+        while (line.endsWith('\n') || line.endsWith('\r')) {
+            line.chop(1);
+        }
+        tokens.append(QString::fromUtf8(line));
+    }
+    setVocabulary(tokens);
+    if (!isLoaded()) {
+        if (error) *error = QStringLiteral("Vocabulary %1 is empty").arg(path);
+        return false;
+    }
+    return true;
+}
+
+void WordPieceTokenizer::setVocabulary(const QStringList& tokens)
+{
+    m_ids.clear();
+    m_ids.reserve(tokens.size());
+    for (qsizetype i = 0; i < tokens.size(); ++i) {
+        // The last of duplicate lines keeps the token, as in the reference
+        // tokenizers, which build the map line by line and overwrite
+        m_ids.insert(tokens.at(i), i);
+    }
+    m_unkId = idOf(QStringLiteral("[UNK]"), 0);
+    m_clsId = idOf(QStringLiteral("[CLS]"), m_unkId);
+    m_sepId = idOf(QStringLiteral("[SEP]"), m_unkId);
+    m_padId = idOf(QStringLiteral("[PAD]"), 0);
+}
+
+qint64 WordPieceTokenizer::idOf(const QString& token, qint64 fallback) const
+{
+    const auto it = m_ids.constFind(token);
+    return it == m_ids.cend() ? fallback : *it;
+}
+
+QStringList WordPieceTokenizer::basicTokens(const QString& text) const
+{
+    QString normalized = text;
+    if (m_lowercase) {
+        // Decompose, then drop the combining marks: "Café" becomes "cafe"
+        normalized = normalized.toLower().normalized(QString::NormalizationForm_D);
+    }
+
+    QStringList words;
+    QString word;
+    const auto flush = [&]() {
+        if (!word.isEmpty()) {
+            words.append(word);
+            word.clear();
+        }
+    };
+    for (qsizetype i = 0; i < normalized.size(); ++i) {
+        const QChar c = normalized.at(i);
+        char32_t u = c.unicode();
+        qsizetype length = 1;
+        if (c.isHighSurrogate() && i + 1 < normalized.size() && normalized.at(i + 1).isLowSurrogate()) {
+            u = QChar::surrogateToUcs4(c, normalized.at(i + 1));
+            length = 2;
+        }
+        const QChar::Category category = QChar::category(u);
+
+        if (u == 0 || u == 0xFFFD || (category == QChar::Other_Control && !QChar::isSpace(u))) {
+            // Control characters are dropped
+        } else if (m_lowercase && category == QChar::Mark_NonSpacing) {
+            // Accents left over from the decomposition
+        } else if (QChar::isSpace(u)) {
+            flush();
+        } else if (isCjk(u) || (length == 1 && isPunctuation(c))) {
+            flush();
+            words.append(normalized.mid(i, length));
+        } else {
+            word += normalized.mid(i, length);
+        }
+        i += length - 1;
+    }
+    flush();
+    return words;
+}
+
+void WordPieceTokenizer::appendWordPieces(const QString& word, QStringList& pieces) const
+{
+    if (word.size() > kMaxWordChars) {
+        pieces.append(QStringLiteral("[UNK]"));
+        return;
+    }
+
+    QStringList wordPieces;
+    qsizetype start = 0;
+    while (start < word.size()) {
+        qsizetype end = word.size();
+        QString match;
+        while (end > start) {
+            QString candidate = word.mid(start, end - start);
+            if (start > 0) {
+                candidate.prepend(QStringLiteral("##"));
+            }
+            if (m_ids.contains(candidate)) {
+                match = std::move(candidate);
+                break;
+            }
+            --end;
+        }
+        if (match.isEmpty()) {
+            pieces.append(QStringLiteral("[UNK]"));
+            return;
+        }
+        wordPieces.append(std::move(match));
+        start = end;
+    }
+    pieces += wordPieces;
+}
+
+QStringList WordPieceTokenizer::tokenize(const QString& text) const
+{
+    QStringList pieces;
+    for (const QString& word : basicTokens(text)) {
+        appendWordPieces(word, pieces);
+    }
+    return pieces;
+}
+
+std::vector<qint64> WordPieceTokenizer::encode(const QString& text, int maxLength) const
+{
+    const QStringList pieces = tokenize(text);
+    const qsizetype room = std::max(0, maxLength - 2);
+    std::vector<qint64> ids;
+    ids.reserve(static_cast<size_t>(std::min(pieces.size(), room) + 2));
+    ids.push_back(m_clsId);
+    for (qsizetype i = 0; i < pieces.size() && i < room; ++i) {
+        ids.push_back(idOf(pieces.at(i), m_unkId));
+    }
+    ids.push_back(m_sepId);
+    return ids;
+}
@@ -0,0 +1,69 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+#include <vector>
+
+// BERT WordPiece tokenizer, as used by sentence-embedding models exported to ONNX
+// (all-MiniLM, bge, e5, ...). Text is split at whitespace and punctuation, CJK
+// characters stand alone, and each word is cut into the longest vocabulary pieces
+// from the left, continuations prefixed with "##". Uncased models also lowercase
+// and strip accents. Words with no such cut become [UNK].
+class WordPieceTokenizer {
+public:
+    // Reads a vocab.txt: one token per line, its id being the line number
+    bool loadVocabulary(const QString& path, QString* error = nullptr);
+    void setVocabulary(const QStringList& tokens);
+    bool isLoaded() const { return !m_ids.isEmpty(); }
+
+    bool lowercase() const { return m_lowercase; }
+    void setLowercase(bool lowercase) { m_lowercase = lowercase; }
+
+    // Word pieces of the text, without special tokens
+    QStringList tokenize(const QString& text) const;
+
+    // [CLS] pieces [SEP] as vocabulary ids, cut to maxLength ids
+    std::vector<qint64> encode(const QString& text, int maxLength) const;
+
+    qint64 padId() const { return m_padId; }
+
+    // Longer words are not split but become [UNK]
+    static constexpr int kMaxWordChars = 100;
+
+private:
+    QStringList basicTokens(const QString& text) const;
+    void appendWordPieces(const QString& word, QStringList& pieces) const;
+    qint64 idOf(const QString& token, qint64 fallback) const;
+
+    QHash<QString, qint64> m_ids;
+    bool m_lowercase {true};
+    qint64 m_unkId {0};
+    qint64 m_clsId {0};
+    qint64 m_sepId {0};
+    qint64 m_padId {0};
+};
@@ -30,6 +30,7 @@
 #include <QSet>
 #include <QString>
 #include <QStringList>
+#include <QVariantMap>
 
 namespace ModelCapsTypes {
 Q_NAMESPACE
@@ -64,7 +65,9 @@ enum class Capability {
     Image,
     Embedding,
     Pdf,
-    StructuredOutput
+    StructuredOutput,
+    PromptCaching,
+    Rerank
 };
 Q_ENUM_NS(Capability)
 
@@ -82,6 +85,10 @@ struct ReasoningEffortConstraint {
 struct ParameterConstraints {
     std::optional<int> maxInputTokens;
     std::optional<int> maxOutputTokens;
+    // Longest image edge, in pixels, the model looks at; larger attachments are scaled down before upload
+    std::optional<int> maxImageDimension;
+    // Images the provider accepts in one request; bounds Universal LLM's image packing
+    std::optional<int> maxImagesPerRequest;
     std::optional<TemperatureConstraint> temperature;
     std::optional<ReasoningEffortConstraint> reasoningEffort;
     // Hints for backend parameter shaping
@@ -120,6 +127,15 @@ struct DriverProfile {
     QMap<QString, QString> headers;
 };
 
+// Requests and tokens a provider (or one of its models) accepts per minute.
+// Zero leaves that budget unlimited.
+struct RateLimit {
+    int requestsPerMinute { 0 };
+    int tokensPerMinute { 0 };
+
+    bool isUnlimited() const { return requestsPerMinute <= 0 && tokensPerMinute <= 0; }
+};
+
 struct ProviderSettings {
     QString id;
     QString name;
@@ -128,6 +144,27 @@ struct ProviderSettings {
     QMap<QString, QString> headers;
     bool enabled { true };
     bool requiresCredential { true };
+    RateLimit rateLimit;
+    QMap<QString, RateLimit> modelRateLimits;
+    // Local model servers (Ollama): how long a model stays loaded after a request
+    // ("10m", or seconds; negative keeps it loaded), options sent with every
+    // request (num_ctx, num_batch, ...), and parallel requests per model on the
+    // server (OLLAMA_NUM_PARALLEL). Empty or 0 keeps the server's defaults.
+    QString keepAlive;
+    QVariantMap options;
+    int parallel { 0 };
+    // Self-hosted gateways: "gzip" compresses request bodies of at least
+    // compressMinBytes (0 uses RequestCompression's default). Empty sends them as is.
+    QString contentEncoding;
+    int compressMinBytes { 0 };
+};
+
+// One provider/model pair a routed virtual model may send a request to
+struct ModelRoute {
+    QString provider;
+    QString model;
+
+    bool operator==(const ModelRoute& other) const { return provider == other.provider && model == other.model; }
 };
 
 struct VirtualModel {
@@ -135,6 +172,9 @@ struct VirtualModel {
     QString target;  // The real model ID
     QString backend; // Optional backend filter
     QString name;    // UI Display name
+    // Equivalent models on several providers, best first. When set, the alias is
+    // offered on each listed provider and Universal LLM routes by latency.
+    QList<ModelRoute> routes;
 };
 
 } // namespace ModelCapsTypes
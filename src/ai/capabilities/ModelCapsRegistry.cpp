@@ -26,12 +26,16 @@
 #include "Logger.h"
 #include "LoggingCategories.h"
 #include <QFile>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QCryptographicHash>
+#include <QDataStream>
 #include <QDir>
 #include <QFileInfo>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonValue>
+#include <QSaveFile>
 #include <QStandardPaths>
 #include <QTemporaryFile>
 
@@ -105,6 +109,12 @@ std::optional<Capability> capabilityFromString(const QString& value)
     if (normalized == QStringLiteral("structuredoutput")) {
         return Capability::StructuredOutput;
     }
+    if (normalized == QStringLiteral("promptcaching") || normalized == QStringLiteral("promptcache")) {
+        return Capability::PromptCaching;
+    }
+    if (normalized == QStringLiteral("rerank") || normalized == QStringLiteral("reranker")) {
+        return Capability::Rerank;
+    }
 
     return std::nullopt;
 }
@@ -139,6 +149,22 @@ QString stringValue(const QJsonObject& obj, const QString& camel, const QString&
     return {};
 }
 
+int intValue(const QJsonObject& obj, const QString& camel, const QString& snake)
+{
+    const QJsonValue value = obj.contains(camel) ? obj.value(camel) : obj.value(snake);
+    return value.isDouble() ? value.toInt() : 0;
+}
+
+RateLimit rateLimitFromObject(const QJsonObject& obj)
+{
+    RateLimit limit;
+    limit.requestsPerMinute = qMax(0, intValue(obj, QStringLiteral("requestsPerMinute"),
+                                               QStringLiteral("requests_per_minute")));
+    limit.tokensPerMinute = qMax(0, intValue(obj, QStringLiteral("tokensPerMinute"),
+                                             QStringLiteral("tokens_per_minute")));
+    return limit;
+}
+
 QMap<QString, QString> headersFromObject(const QJsonObject& obj)
 {
     QMap<QString, QString> headers;
@@ -217,6 +243,33 @@ QMap<QString, ProviderSettings> parseProviderSettings(const QJsonObject& root)
         settings.enabled = obj.value(QStringLiteral("enabled")).toBool(true);
         settings.requiresCredential = obj.value(QStringLiteral("requiresCredential"))
                                           .toBool(obj.value(QStringLiteral("requires_credential")).toBool(true));
+
+        const QJsonValue limitsValue = obj.contains(QStringLiteral("rateLimits"))
+            ? obj.value(QStringLiteral("rateLimits"))
+            : obj.value(QStringLiteral("rate_limits"));
+        if (limitsValue.isObject()) {
+            const QJsonObject limitsObj = limitsValue.toObject();
+            settings.rateLimit = rateLimitFromObject(limitsObj);
+            const QJsonObject modelsObj = limitsObj.value(QStringLiteral("models")).toObject();
+            for (auto it = modelsObj.begin(); it != modelsObj.end(); ++it) {
+                if (it.value().isObject()) {
+                    settings.modelRateLimits.insert(it.key(), rateLimitFromObject(it.value().toObject()));
+                }
+            }
+        }
+        const QJsonValue keepAlive = obj.contains(QStringLiteral("keepAlive"))
+            ? obj.value(QStringLiteral("keepAlive"))
+            : obj.value(QStringLiteral("keep_alive"));
+        settings.keepAlive = keepAlive.isDouble() ? QString::number(keepAlive.toInteger()) : keepAlive.toString();
+        settings.options = obj.value(QStringLiteral("options")).toObject().toVariantMap();
+        settings.parallel = obj.value(QStringLiteral("parallel")).toInt(0);
+        settings.contentEncoding = stringValue(obj, QStringLiteral("contentEncoding"), QStringLiteral("content_encoding"))
+                                       .trimmed()
+                                       .toLower();
+        settings.compressMinBytes = (obj.contains(QStringLiteral("compressMinBytes"))
+                                         ? obj.value(QStringLiteral("compressMinBytes"))
+                                         : obj.value(QStringLiteral("compress_min_bytes")))
+                                        .toInt(0);
         providers.insert(settings.id, std::move(settings));
     }
     return providers;
@@ -276,6 +329,236 @@ QJsonObject mergeCatalogConfig(QJsonObject base, const QJsonObject& overlay)
     return base;
 }
 
+// Binary snapshot of a merged catalog (loadFromFileWithUserOverrides()). Bump the
+// version whenever a struct below gains a field.
+constexpr quint32 kSnapshotMagic = 0x43504d43; // "CPMC"
+constexpr quint32 kSnapshotVersion = 2;
+
+// Identifies the inputs a snapshot was built from: the distribution catalog, each
+// override file that was read and the snapshot format, so editing any of them rebuilds
+QByteArray snapshotKey(const QByteArray& basePayload, const QList<QPair<QString, QByteArray>>& overrides)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(QByteArray::number(kSnapshotVersion));
+    hash.addData(QByteArray(qVersion()));
+    hash.addData(QCryptographicHash::hash(basePayload, QCryptographicHash::Sha256));
+    for (const auto& entry : overrides) {
+        hash.addData(entry.first.toUtf8());
+        hash.addData(QCryptographicHash::hash(entry.second, QCryptographicHash::Sha256));
+    }
+    return hash.result();
+}
+
+template <typename T>
+void writeOptional(QDataStream& out, const std::optional<T>& value)
+{
+    out << value.has_value();
+    if (value) {
+        out << *value;
+    }
+}
+
+template <typename T>
+void readOptional(QDataStream& in, std::optional<T>& value)
+{
+    bool present = false;
+    in >> present;
+    value.reset();
+    if (present) {
+        T read {};
+        in >> read;
+        value = std::move(read);
+    }
+}
+
+void writeRateLimit(QDataStream& out, const RateLimit& limit)
+{
+    out << qint32(limit.requestsPerMinute) << qint32(limit.tokensPerMinute);
+}
+
+RateLimit readRateLimit(QDataStream& in)
+{
+    qint32 requests = 0;
+    qint32 tokens = 0;
+    in >> requests >> tokens;
+    return RateLimit { requests, tokens };
+}
+
+void writeCaps(QDataStream& out, const ModelCaps& caps)
+{
+    out << qint32(caps.endpointMode) << qint32(caps.roleMode);
+    QList<qint32> capabilities;
+    for (const Capability capability : caps.capabilities) {
+        capabilities.append(qint32(capability));
+    }
+    out << capabilities;
+
+    const ParameterConstraints& constraints = caps.constraints;
+    writeOptional(out, constraints.maxInputTokens);
+    writeOptional(out, constraints.maxOutputTokens);
+    writeOptional(out, constraints.maxImageDimension);
+    writeOptional(out, constraints.maxImagesPerRequest);
+    out << constraints.temperature.has_value();
+    if (constraints.temperature) {
+        writeOptional(out, constraints.temperature->defaultValue);
+        writeOptional(out, constraints.temperature->min);
+        writeOptional(out, constraints.temperature->max);
+    }
+    out << constraints.reasoningEffort.has_value();
+    if (constraints.reasoningEffort) {
+        writeOptional(out, constraints.reasoningEffort->defaultValue);
+        out << constraints.reasoningEffort->allowed;
+    }
+    writeOptional(out, constraints.omitTemperature);
+    writeOptional(out, constraints.tokenFieldName);
+    out << caps.customHeaders;
+}
+
+ModelCaps readCaps(QDataStream& in)
+{
+    ModelCaps caps;
+    qint32 endpointMode = 0;
+    qint32 roleMode = 0;
+    QList<qint32> capabilities;
+    in >> endpointMode >> roleMode >> capabilities;
+    caps.endpointMode = static_cast<EndpointMode>(endpointMode);
+    caps.roleMode = static_cast<RoleMode>(roleMode);
+    for (const qint32 capability : capabilities) {
+        caps.capabilities.insert(static_cast<Capability>(capability));
+    }
+
+    ParameterConstraints& constraints = caps.constraints;
+    readOptional(in, constraints.maxInputTokens);
+    readOptional(in, constraints.maxOutputTokens);
+    readOptional(in, constraints.maxImageDimension);
+    readOptional(in, constraints.maxImagesPerRequest);
+    bool present = false;
+    in >> present;
+    if (present) {
+        TemperatureConstraint temperature;
+        readOptional(in, temperature.defaultValue);
+        readOptional(in, temperature.min);
+        readOptional(in, temperature.max);
+        constraints.temperature = temperature;
+    }
+    in >> present;
+    if (present) {
+        ReasoningEffortConstraint reasoningEffort;
+        readOptional(in, reasoningEffort.defaultValue);
+        in >> reasoningEffort.allowed;
+        constraints.reasoningEffort = reasoningEffort;
+    }
+    readOptional(in, constraints.omitTemperature);
+    readOptional(in, constraints.tokenFieldName);
+    in >> caps.customHeaders;
+    return caps;
+}
+
+// Patterns are stored as text: they were validated when the snapshot was written,
+// and compiling them is left to the first match
+void writeRule(QDataStream& out, const ModelRule& rule)
+{
+    out << rule.id << rule.pattern.pattern();
+    out << rule.trailingNegativeLookahead.has_value();
+    if (rule.trailingNegativeLookahead) {
+        out << rule.trailingNegativeLookahead->pattern();
+    }
+    writeCaps(out, rule.caps);
+    out << rule.backend << rule.driverProfileId << qint32(rule.priority) << rule.requiresBackend;
+}
+
+ModelRule readRule(QDataStream& in)
+{
+    ModelRule rule;
+    QString pattern;
+    bool hasNegative = false;
+    in >> rule.id >> pattern >> hasNegative;
+    rule.pattern = QRegularExpression(pattern);
+    if (hasNegative) {
+        QString negative;
+        in >> negative;
+        rule.trailingNegativeLookahead = QRegularExpression(negative);
+    }
+    rule.caps = readCaps(in);
+    qint32 priority = 0;
+    in >> rule.backend >> rule.driverProfileId >> priority >> rule.requiresBackend;
+    rule.priority = priority;
+    return rule;
+}
+
+void writeDriverProfile(QDataStream& out, const DriverProfile& profile)
+{
+    out << profile.id << profile.name << profile.provider << profile.protocol << profile.endpoint
+        << qint32(profile.endpointMode) << profile.headers;
+}
+
+DriverProfile readDriverProfile(QDataStream& in)
+{
+    DriverProfile profile;
+    qint32 endpointMode = 0;
+    in >> profile.id >> profile.name >> profile.provider >> profile.protocol >> profile.endpoint
+       >> endpointMode >> profile.headers;
+    profile.endpointMode = static_cast<EndpointMode>(endpointMode);
+    return profile;
+}
+
+void writeProviderSettings(QDataStream& out, const ProviderSettings& settings)
+{
+    out << settings.id << settings.name << settings.baseUrl << settings.apiKey << settings.headers
+        << settings.enabled << settings.requiresCredential;
+    writeRateLimit(out, settings.rateLimit);
+    out << qint32(settings.modelRateLimits.size());
+    for (auto it = settings.modelRateLimits.constBegin(); it != settings.modelRateLimits.constEnd(); ++it) {
+        out << it.key();
+        writeRateLimit(out, it.value());
+    }
+    out << settings.keepAlive << settings.options << qint32(settings.parallel);
+    out << settings.contentEncoding << qint32(settings.compressMinBytes);
+}
+
+ProviderSettings readProviderSettings(QDataStream& in)
+{
+    ProviderSettings settings;
+    in >> settings.id >> settings.name >> settings.baseUrl >> settings.apiKey >> settings.headers
+       >> settings.enabled >> settings.requiresCredential;
+    settings.rateLimit = readRateLimit(in);
+    qint32 modelLimits = 0;
+    in >> modelLimits;
+    for (qint32 i = 0; i < modelLimits && in.status() == QDataStream::Ok; ++i) {
+        QString model;
+        in >> model;
+        settings.modelRateLimits.insert(model, readRateLimit(in));
+    }
+    qint32 parallel = 0;
+    in >> settings.keepAlive >> settings.options >> parallel;
+    settings.parallel = parallel;
+    qint32 compressMinBytes = 0;
+    in >> settings.contentEncoding >> compressMinBytes;
+    settings.compressMinBytes = compressMinBytes;
+    return settings;
+}
+
+void writeVirtualModel(QDataStream& out, const VirtualModel& model)
+{
+    out << model.id << model.target << model.backend << model.name << qint32(model.routes.size());
+    for (const ModelRoute& route : model.routes) {
+        out << route.provider << route.model;
+    }
+}
+
+VirtualModel readVirtualModel(QDataStream& in)
+{
+    VirtualModel model;
+    qint32 routes = 0;
+    in >> model.id >> model.target >> model.backend >> model.name >> routes;
+    for (qint32 i = 0; i < routes && in.status() == QDataStream::Ok; ++i) {
+        ModelRoute route;
+        in >> route.provider >> route.model;
+        model.routes.append(route);
+    }
+    return model;
+}
+
 } // namespace
 
 ModelCapsRegistry& ModelCapsRegistry::instance()
@@ -312,22 +595,62 @@ QStringList ModelCapsRegistry::userConfigPaths() const
     return paths;
 }
 
+namespace {
+// Set on the worker running a background load, whose own calls must not wait for it
+thread_local bool t_inBackgroundLoad = false;
+} // namespace
+
+void ModelCapsRegistry::loadInBackground(const QString& path)
+{
+    waitForBackgroundLoad();
+    QMutexLocker locker(&backgroundLoadMutex_);
+    backgroundLoad_ = QtConcurrent::run([this, path]() {
+        t_inBackgroundLoad = true;
+        const bool loaded = loadFromFileWithUserOverrides(path);
+        t_inBackgroundLoad = false;
+        return loaded;
+    });
+    backgroundLoadPending_.store(true, std::memory_order_release);
+}
+
+bool ModelCapsRegistry::waitForBackgroundLoad() const
+{
+    // Lookups hit this on every call, so the settled case is a single atomic read
+    if (t_inBackgroundLoad || !backgroundLoadPending_.load(std::memory_order_acquire)) {
+        return backgroundLoadResult_.load(std::memory_order_acquire);
+    }
+    QMutexLocker locker(&backgroundLoadMutex_);
+    if (backgroundLoadPending_.load(std::memory_order_acquire)) {
+        backgroundLoadResult_.store(backgroundLoad_.result(), std::memory_order_release);
+        backgroundLoadPending_.store(false, std::memory_order_release);
+    }
+    return backgroundLoadResult_.load(std::memory_order_acquire);
+}
+
+QString ModelCapsRegistry::snapshotPath() const
+{
+    const QString configured = qEnvironmentVariable("CP_MODEL_CAPS_SNAPSHOT").trimmed();
+    if (configured == QStringLiteral("0")) {
+        return QString();
+    }
+    if (!configured.isEmpty() && configured != QStringLiteral("1")) {
+        return QDir::cleanPath(configured);
+    }
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    return cacheDir.isEmpty() ? QString() : QDir(cacheDir).filePath(QStringLiteral("model_caps.snapshot"));
+}
+
 bool ModelCapsRegistry::loadFromFileWithUserOverrides(const QString& path)
 {
+    waitForBackgroundLoad();
     QFile file(path);
     if (!file.open(QIODevice::ReadOnly)) {
         CP_WARN << "ModelCapsRegistry: unable to open file" << path;
         return false;
     }
+    const QByteArray basePayload = file.readAll();
 
-    QJsonParseError parseError;
-    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
-    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
-        CP_WARN << "ModelCapsRegistry: failed to parse base JSON" << path << parseError.errorString();
-        return false;
-    }
-
-    QJsonObject mergedRoot = doc.object();
+    QList<QPair<QString, QByteArray>> overrides;
     for (const QString& candidatePath : userConfigPaths()) {
         QFile overrideFile(candidatePath);
         if (!overrideFile.exists()) {
@@ -338,9 +661,27 @@ bool ModelCapsRegistry::loadFromFileWithUserOverrides(const QString& path)
                     << overrideFile.errorString();
             continue;
         }
+        overrides.append({candidatePath, overrideFile.readAll()});
+    }
+
+    // Unchanged inputs: take the catalog merged and validated on an earlier start
+    const QString snapshot = snapshotPath();
+    const QByteArray key = snapshot.isEmpty() ? QByteArray() : snapshotKey(basePayload, overrides);
+    if (!snapshot.isEmpty() && loadSnapshot(snapshot, key)) {
+        return true;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(basePayload, &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+        CP_WARN << "ModelCapsRegistry: failed to parse base JSON" << path << parseError.errorString();
+        return false;
+    }
 
+    QJsonObject mergedRoot = doc.object();
+    for (const auto& [candidatePath, overridePayload] : overrides) {
         QJsonParseError overrideParseError;
-        QJsonDocument overrideDoc = QJsonDocument::fromJson(overrideFile.readAll(), &overrideParseError);
+        QJsonDocument overrideDoc = QJsonDocument::fromJson(overridePayload, &overrideParseError);
         if (overrideParseError.error != QJsonParseError::NoError || !overrideDoc.isObject()) {
             CP_WARN << "ModelCapsRegistry: failed to parse user catalog config" << candidatePath
                     << overrideParseError.errorString();
@@ -359,11 +700,119 @@ bool ModelCapsRegistry::loadFromFileWithUserOverrides(const QString& path)
 
     tempFile.write(QJsonDocument(mergedRoot).toJson());
     tempFile.flush();
-    return loadFromFile(tempFile.fileName());
+    if (!loadFromFile(tempFile.fileName())) {
+        return false;
+    }
+    if (!snapshot.isEmpty()) {
+        writeSnapshot(snapshot, key);
+    }
+    return true;
+}
+
+bool ModelCapsRegistry::loadSnapshot(const QString& path, const QByteArray& key)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QByteArray storedKey;
+    in >> magic >> version >> storedKey;
+    if (in.status() != QDataStream::Ok || magic != kSnapshotMagic || version != kSnapshotVersion || storedKey != key) {
+        return false;
+    }
+
+    qint32 count = 0;
+    QVector<ModelRule> rules;
+    in >> count;
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        rules.push_back(readRule(in));
+    }
+    QMap<QString, DriverProfile> profiles;
+    in >> count;
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        DriverProfile profile = readDriverProfile(in);
+        profiles.insert(profile.id, std::move(profile));
+    }
+    QMap<QString, ProviderSettings> providers;
+    in >> count;
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        ProviderSettings settings = readProviderSettings(in);
+        providers.insert(settings.id, std::move(settings));
+    }
+    QVector<VirtualModel> virtualModels;
+    in >> count;
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        virtualModels.push_back(readVirtualModel(in));
+    }
+    if (in.status() != QDataStream::Ok) {
+        CP_WARN << "ModelCapsRegistry: ignoring truncated catalog snapshot" << path;
+        return false;
+    }
+
+    QWriteLocker writeLocker(&lock_);
+    {
+        QMutexLocker cacheLocker(&resolveCacheMutex_);
+        resolveCache_.clear();
+        ++generation_;
+    }
+    rules_ = std::move(rules);
+    driverProfiles_ = std::move(profiles);
+    providerSettings_ = std::move(providers);
+    virtualModels_ = std::move(virtualModels);
+    qCInfo(cp_registry).noquote() << QStringLiteral("ModelCapsRegistry: loaded %1 rules from snapshot %2")
+                             .arg(QString::number(rules_.size()), path);
+    return true;
+}
+
+void ModelCapsRegistry::writeSnapshot(const QString& path, const QByteArray& key) const
+{
+    if (!QDir().mkpath(QFileInfo(path).absolutePath())) {
+        return;
+    }
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        CP_WARN << "ModelCapsRegistry: unable to write catalog snapshot" << path << file.errorString();
+        return;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << kSnapshotMagic << kSnapshotVersion << key;
+    {
+        QReadLocker readLocker(&lock_);
+        out << qint32(rules_.size());
+        for (const ModelRule& rule : rules_) {
+            writeRule(out, rule);
+        }
+        out << qint32(driverProfiles_.size());
+        for (const DriverProfile& profile : driverProfiles_) {
+            writeDriverProfile(out, profile);
+        }
+        out << qint32(providerSettings_.size());
+        for (const ProviderSettings& settings : providerSettings_) {
+            writeProviderSettings(out, settings);
+        }
+        out << qint32(virtualModels_.size());
+        for (const VirtualModel& model : virtualModels_) {
+            writeVirtualModel(out, model);
+        }
+    }
+    if (out.status() != QDataStream::Ok) {
+        file.cancelWriting();
+        return;
+    }
+    file.commit();
 }
 
 bool ModelCapsRegistry::loadFromFile(const QString& path)
 {
+    // A sync load must not be overwritten by a background one that commits later
+    waitForBackgroundLoad();
     QWriteLocker writeLocker(&lock_);
     QFile file(path);
     if (!file.open(QIODevice::ReadOnly)) {
@@ -419,6 +868,8 @@ bool ModelCapsRegistry::loadFromFile(const QString& path)
             CP_WARN << "ModelCapsRegistry: invalid regex pattern" << patternString << "-" << regex.errorString();
             continue;
         }
+        // Compile (and JIT) now rather than on the first model a selector filters
+        regex.optimize();
 
         std::optional<QRegularExpression> trailingNegativeLookahead;
         if (const auto negativeMatch = trailingNegativeLookaheadRegex.match(patternString); negativeMatch.hasMatch()) {
@@ -428,6 +879,7 @@ bool ModelCapsRegistry::loadFromFile(const QString& path)
             if (!negativeRegex.isValid()) {
                 CP_WARN << "ModelCapsRegistry: invalid trailing negative lookahead" << negativePatternText << "-" << negativeRegex.errorString();
             } else {
+                negativeRegex.optimize();
                 trailingNegativeLookahead = negativeRegex;
             }
         }
@@ -492,6 +944,14 @@ bool ModelCapsRegistry::loadFromFile(const QString& path)
                 caps.constraints.maxOutputTokens = maxOutputTokens.toInt();
             }
 
+            if (const QJsonValue maxImageDimension = constraintsObj.value(QStringLiteral("maxImageDimension")); maxImageDimension.isDouble()) {
+                caps.constraints.maxImageDimension = maxImageDimension.toInt();
+            }
+
+            if (const QJsonValue maxImages = constraintsObj.value(QStringLiteral("maxImagesPerRequest")); maxImages.isDouble()) {
+                caps.constraints.maxImagesPerRequest = maxImages.toInt();
+            }
+
             if (const QJsonValue temperatureValue = constraintsObj.value(QStringLiteral("temperature")); temperatureValue.isObject()) {
                 const QJsonObject tempObj = temperatureValue.toObject();
                 TemperatureConstraint temp;
@@ -634,6 +1094,11 @@ bool ModelCapsRegistry::loadFromFile(const QString& path)
     });
 
     // Commit parsed rules
+    {
+        QMutexLocker cacheLocker(&resolveCacheMutex_);
+        resolveCache_.clear();
+        ++generation_;
+    }
     rules_ = std::move(parsedRules);
     driverProfiles_ = parsedDriverProfiles;
     providerSettings_ = parsedProviderSettings;
@@ -656,15 +1121,29 @@ bool ModelCapsRegistry::loadFromFile(const QString& path)
             const QJsonValue targetVal = vmObj.value(QStringLiteral("target"));
             const QJsonValue nameVal = vmObj.value(QStringLiteral("name"));
 
-            if (!idVal.isString() || !targetVal.isString() || !nameVal.isString()) {
+            QList<ModelRoute> routes;
+            for (const QJsonValue& routeValue : vmObj.value(QStringLiteral("routes")).toArray()) {
+                const QJsonObject routeObj = routeValue.toObject();
+                ModelRoute route;
+                route.provider = stringValue(routeObj, QStringLiteral("provider"), QStringLiteral("backend"));
+                route.model = stringValue(routeObj, QStringLiteral("model"), QStringLiteral("target"));
+                if (route.provider.isEmpty() || route.model.isEmpty()) {
+                    CP_WARN << "ModelCapsRegistry: skipping virtual_model route missing provider or model";
+                    continue;
+                }
+                routes.append(route);
+            }
+
+            if (!idVal.isString() || (!targetVal.isString() && routes.isEmpty()) || !nameVal.isString()) {
                 CP_WARN << "ModelCapsRegistry: skipping virtual_model missing id, target, or name";
                 continue;
             }
 
             VirtualModel vm;
             vm.id = idVal.toString();
-            vm.target = targetVal.toString();
+            vm.target = targetVal.isString() ? targetVal.toString() : routes.first().model;
             vm.name = nameVal.toString();
+            vm.routes = routes;
 
             if (const QJsonValue backendVal = vmObj.value(QStringLiteral("backend")); backendVal.isString()) {
                 vm.backend = backendVal.toString();
@@ -696,9 +1175,38 @@ bool ModelCapsRegistry::loadFromFile(const QString& path)
 
 std::optional<ModelCapsRegistry::ResolvedCaps> ModelCapsRegistry::resolveWithRule(const QString& modelId, const QString& backendId) const
 {
-    const QString realModelId = resolveAlias(modelId, backendId);
+    waitForBackgroundLoad();
+    const QString cacheKey = backendId + QChar(u'\n') + modelId;
+    {
+        QMutexLocker cacheLocker(&resolveCacheMutex_);
+        const auto cached = resolveCache_.constFind(cacheKey);
+        if (cached != resolveCache_.constEnd()) {
+            return *cached;
+        }
+    }
 
-    QReadLocker readLocker(&lock_);
+    quint64 generation = 0;
+    std::optional<ResolvedCaps> resolved;
+    {
+        const QString realModelId = resolveAlias(modelId, backendId);
+        QReadLocker readLocker(&lock_);
+        generation = generation_;
+        resolved = matchRule(realModelId, backendId);
+    }
+
+    QMutexLocker cacheLocker(&resolveCacheMutex_);
+    // A catalog committed while we were matching makes this result stale
+    if (generation == generation_) {
+        if (resolveCache_.size() >= kMaxResolveCacheEntries) {
+            resolveCache_.clear();
+        }
+        resolveCache_.insert(cacheKey, resolved);
+    }
+    return resolved;
+}
+
+std::optional<ModelCapsRegistry::ResolvedCaps> ModelCapsRegistry::matchRule(const QString& realModelId, const QString& backendId) const
+{
     // Instrumentation: introspect modelId at resolve entry to detect quoting issues
     const auto firstChar = realModelId.isEmpty() ? QStringLiteral("∅") : realModelId.left(1);
     const auto lastChar = realModelId.isEmpty() ? QStringLiteral("∅") : realModelId.right(1);
@@ -750,6 +1258,7 @@ bool ModelCapsRegistry::isSupported(const QString& backendId, const QString& mod
 
 QString ModelCapsRegistry::resolveAlias(const QString& id, const QString& backendId) const
 {
+    waitForBackgroundLoad();
     QReadLocker readLocker(&lock_);
     QString current = id;
     QSet<QString> visited;
@@ -767,6 +1276,20 @@ QString ModelCapsRegistry::resolveAlias(const QString& id, const QString& backen
         bool backendSpecificMatch = false;
 
         for (const auto& vm : virtualModels_) {
+            if (!vm.routes.isEmpty() && vm.id.compare(current, Qt::CaseInsensitive) == 0) {
+                // A routed alias means the route's model on the selected provider
+                const auto route = std::find_if(vm.routes.cbegin(), vm.routes.cend(), [&](const ModelRoute& r) {
+                    return r.provider == backendId;
+                });
+                if (route != vm.routes.cend()) {
+                    bestTarget = route->model;
+                    break;
+                }
+                if (backendId.isEmpty() && bestTarget.isEmpty()) {
+                    bestTarget = vm.routes.first().model;
+                }
+                continue;
+            }
             if (vm.id.compare(current, Qt::CaseInsensitive) == 0) {
                 if (!backendId.isEmpty() && vm.backend == backendId) {
                     bestTarget = vm.target;
@@ -791,12 +1314,14 @@ QString ModelCapsRegistry::resolveAlias(const QString& id, const QString& backen
 
 QVector<ModelCapsTypes::ModelRule> ModelCapsRegistry::modelRulesList() const
 {
+    waitForBackgroundLoad();
     QReadLocker readLocker(&lock_);
     return rules_;
 }
 
 QList<ModelCapsTypes::VirtualModel> ModelCapsRegistry::virtualModelsForBackend(const QString& backendId) const
 {
+    waitForBackgroundLoad();
     QReadLocker readLocker(&lock_);
     if (backendId.isEmpty()) {
         return virtualModels_.toList();
@@ -804,6 +1329,18 @@ QList<ModelCapsTypes::VirtualModel> ModelCapsRegistry::virtualModelsForBackend(c
 
     QList<VirtualModel> result;
     for (const auto& vm : virtualModels_) {
+        if (!vm.routes.isEmpty()) {
+            for (const auto& route : vm.routes) {
+                if (route.provider == backendId) {
+                    VirtualModel routed = vm;
+                    routed.target = route.model;
+                    routed.backend = backendId;
+                    result.append(routed);
+                    break;
+                }
+            }
+            continue;
+        }
         if (vm.backend.isEmpty() || vm.backend == backendId) {
             result.append(vm);
         }
@@ -811,8 +1348,21 @@ QList<ModelCapsTypes::VirtualModel> ModelCapsRegistry::virtualModelsForBackend(c
     return result;
 }
 
+QList<ModelCapsTypes::ModelRoute> ModelCapsRegistry::routesFor(const QString& virtualModelId) const
+{
+    waitForBackgroundLoad();
+    QReadLocker readLocker(&lock_);
+    for (const auto& vm : virtualModels_) {
+        if (!vm.routes.isEmpty() && vm.id.compare(virtualModelId, Qt::CaseInsensitive) == 0) {
+            return vm.routes;
+        }
+    }
+    return {};
+}
+
 std::optional<ModelCapsTypes::DriverProfile> ModelCapsRegistry::driverProfile(const QString& id) const
 {
+    waitForBackgroundLoad();
     QReadLocker readLocker(&lock_);
     const auto it = driverProfiles_.constFind(id);
     if (it == driverProfiles_.constEnd()) {
@@ -823,6 +1373,7 @@ std::optional<ModelCapsTypes::DriverProfile> ModelCapsRegistry::driverProfile(co
 
 std::optional<ModelCapsTypes::ProviderSettings> ModelCapsRegistry::providerSettings(const QString& providerId) const
 {
+    waitForBackgroundLoad();
     QReadLocker readLocker(&lock_);
     const auto it = providerSettings_.constFind(providerId);
     if (it == providerSettings_.constEnd()) {
@@ -833,6 +1384,7 @@ std::optional<ModelCapsTypes::ProviderSettings> ModelCapsRegistry::providerSetti
 
 QList<ModelCapsTypes::ProviderSettings> ModelCapsRegistry::providerSettingsList() const
 {
+    waitForBackgroundLoad();
     QReadLocker readLocker(&lock_);
     return providerSettings_.values();
 }
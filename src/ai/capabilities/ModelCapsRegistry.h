@@ -23,13 +23,17 @@
 //
 #pragma once
 
+#include <atomic>
 #include <optional>
 
+#include <QFuture>
 #include <QObject>
 #include <QString>
 #include <QVector>
 #include <QList>
 #include <QMap>
+#include <QHash>
+#include <QMutex>
 #include <QReadWriteLock>
 
 #include "ModelCaps.h"
@@ -46,9 +50,19 @@ public:
 
     bool loadFromFile(const QString& path);
     bool loadFromFileWithUserOverrides(const QString& path);
+    // Runs loadFromFileWithUserOverrides() on a worker so startup need not wait for
+    // the catalog to parse. Every lookup made before it commits waits for it.
+    void loadInBackground(const QString& path);
+    // Blocks until a pending background load has committed; returns its result,
+    // or true when none was started.
+    bool waitForBackgroundLoad() const;
     QString distributionConfigPath() const;
     QString userConfigPath() const;
     QStringList userConfigPaths() const;
+    // Where loadFromFileWithUserOverrides() keeps the merged catalog between starts:
+    // CP_MODEL_CAPS_SNAPSHOT when it names a file, empty when it is "0", otherwise
+    // model_caps.snapshot in the cache directory
+    QString snapshotPath() const;
     std::optional<ResolvedCaps> resolveWithRule(const QString& modelId, const QString& backendId = {}) const;
     std::optional<ModelCapsTypes::ModelCaps> resolve(const QString& modelId, const QString& backendId = {}) const;
     bool isSupported(const QString& backendId, const QString& modelId) const;
@@ -56,6 +70,8 @@ public:
     QString resolveAlias(const QString& id, const QString& backendId = QString()) const;
     QVector<ModelCapsTypes::ModelRule> modelRulesList() const;
     QList<ModelCapsTypes::VirtualModel> virtualModelsForBackend(const QString& backendId = QString()) const;
+    // Ranked routes of a routed virtual model; empty for plain aliases and real models
+    QList<ModelCapsTypes::ModelRoute> routesFor(const QString& virtualModelId) const;
     std::optional<ModelCapsTypes::DriverProfile> driverProfile(const QString& id) const;
     std::optional<ModelCapsTypes::ProviderSettings> providerSettings(const QString& providerId) const;
     QList<ModelCapsTypes::ProviderSettings> providerSettingsList() const;
@@ -64,11 +80,31 @@ private:
     ModelCapsRegistry() = default;
     Q_DISABLE_COPY(ModelCapsRegistry)
 
+    // Walks rules_ in priority order; the caller holds lock_
+    std::optional<ResolvedCaps> matchRule(const QString& realModelId, const QString& backendId) const;
+
+    // Binary copy of the committed catalog, valid while the inputs hashed into key are unchanged.
+    // Rule patterns come back uncompiled and compile on their first match.
+    bool loadSnapshot(const QString& path, const QByteArray& key);
+    void writeSnapshot(const QString& path, const QByteArray& key) const;
+
     QVector<ModelCapsTypes::ModelRule> rules_;
     QVector<ModelCapsTypes::VirtualModel> virtualModels_;
     QMap<QString, ModelCapsTypes::DriverProfile> driverProfiles_;
     QMap<QString, ModelCapsTypes::ProviderSettings> providerSettings_;
     mutable QReadWriteLock lock_;
+
+    // resolveWithRule() results keyed by backend + requested id, misses included.
+    // Cleared and re-generationed whenever a catalog is committed.
+    static constexpr int kMaxResolveCacheEntries = 8192;
+    mutable QHash<QString, std::optional<ResolvedCaps>> resolveCache_;
+    mutable QMutex resolveCacheMutex_;
+    quint64 generation_ {0};
+
+    mutable QMutex backgroundLoadMutex_;
+    QFuture<bool> backgroundLoad_;
+    mutable std::atomic<bool> backgroundLoadPending_ {false};
+    mutable std::atomic<bool> backgroundLoadResult_ {true};
 };
 
 // Endpoint routing metadata is now defined in ModelCaps.h under ModelCapsTypes.
@@ -0,0 +1,216 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "TokenEstimator.h"
+
+#include "ModelCapsRegistry.h"
+
+#include <QList>
+
+#include <algorithm>
+
+namespace {
+
+enum class CharClass { Letter, Digit, Space, Newline, Other };
+
+CharClass classOf(QChar c)
+{
+    if (c == u'\n' || c == u'\r') return CharClass::Newline;
+    if (c.isSpace()) return CharClass::Space;
+    if (c.isLetter() || c.isMark()) return CharClass::Letter;
+    if (c.isDigit()) return CharClass::Digit;
+    return CharClass::Other;
+}
+
+// Tokens of one letter run: common words are one token, long ones split at about
+// every eight characters, and letters outside Latin-1 mostly cost one each
+int letterRunTokens(QStringView run)
+{
+    int wide = 0;
+    for (const QChar c : run) {
+        if (c.unicode() > 0xFF) ++wide;
+    }
+    const qsizetype narrow = run.size() - wide;
+    return wide + (narrow > 0 ? static_cast<int>(1 + (narrow - 1) / 8) : 0);
+}
+
+// Walks the text in the pieces an OpenAI BPE pre-tokenizer would produce and calls
+// onPiece(end, tokens) after each; stops early when it returns false
+template<typename OnPiece>
+void scanPieces(QStringView text, OnPiece onPiece)
+{
+    const qsizetype size = text.size();
+    qsizetype i = 0;
+    while (i < size) {
+        const CharClass head = classOf(text[i]);
+        qsizetype end = i + 1;
+        int tokens = 1;
+        if (head == CharClass::Space && end < size
+            && (classOf(text[end]) == CharClass::Letter || classOf(text[end]) == CharClass::Other)) {
+            // A single space joins the word or punctuation that follows it
+            const CharClass next = classOf(text[end]);
+            qsizetype runEnd = end + 1;
+            while (runEnd < size && classOf(text[runEnd]) == next) ++runEnd;
+            tokens = next == CharClass::Letter ? letterRunTokens(text.sliced(end, runEnd - end))
+                                               : static_cast<int>((runEnd - end + 1) / 2);
+            end = runEnd;
+        } else if (head == CharClass::Letter) {
+            while (end < size && classOf(text[end]) == CharClass::Letter) ++end;
+            tokens = letterRunTokens(text.sliced(i, end - i));
+        } else if (head == CharClass::Digit) {
+            // Numbers split into groups of up to three digits
+            while (end < size && end - i < 3 && classOf(text[end]) == CharClass::Digit) ++end;
+        } else if (head == CharClass::Other) {
+            while (end < size && classOf(text[end]) == CharClass::Other) ++end;
+            tokens = static_cast<int>((end - i + 1) / 2);
+        } else {
+            // Whitespace runs, with the line breaks inside them, are one piece
+            while (end < size && (classOf(text[end]) == CharClass::Space || classOf(text[end]) == CharClass::Newline)) {
+                ++end;
+            }
+        }
+        if (!onPiece(end, tokens)) return;
+        i = end;
+    }
+}
+
+// Characters per token, times two, for the ratio-based families
+int halfCharsPerToken(TokenEstimator::Family family)
+{
+    return family == TokenEstimator::Family::Anthropic ? 7 : 8;
+}
+
+bool startsBlock(QStringView text, qsizetype at)
+{
+    const QStringView rest = text.sliced(at);
+    return rest.startsWith(QLatin1String("[Reference: ")) || rest.startsWith(QLatin1String("[Query: "));
+}
+
+} // namespace
+
+TokenEstimator::Family TokenEstimator::familyFromName(const QString& name)
+{
+    const QString n = name.trimmed().toLower();
+    if (n.startsWith(QLatin1String("openai")) || n.startsWith(QLatin1String("azure"))) return Family::OpenAI;
+    if (n.startsWith(QLatin1String("anthropic")) || n.startsWith(QLatin1String("claude"))) return Family::Anthropic;
+    if (n.startsWith(QLatin1String("google")) || n.startsWith(QLatin1String("gemini"))) return Family::Google;
+    return Family::Generic;
+}
+
+QString TokenEstimator::familyName(Family family)
+{
+    switch (family) {
+    case Family::OpenAI: return QStringLiteral("openai");
+    case Family::Anthropic: return QStringLiteral("anthropic");
+    case Family::Google: return QStringLiteral("google");
+    case Family::Generic:
+    default:
+        return QStringLiteral("generic");
+    }
+}
+
+TokenEstimator TokenEstimator::forModel(const QString& modelId, const QString& providerId)
+{
+    if (const auto resolved = ModelCapsRegistry::instance().resolveWithRule(modelId, providerId)) {
+        if (const auto profile = ModelCapsRegistry::instance().driverProfile(resolved->driverProfileId)) {
+            return TokenEstimator(familyFromName(profile->provider));
+        }
+    }
+    return TokenEstimator(familyFromName(providerId));
+}
+
+int TokenEstimator::count(QStringView text) const
+{
+    if (text.isEmpty()) return 0;
+    if (m_family != Family::OpenAI) {
+        const int half = halfCharsPerToken(m_family);
+        return static_cast<int>(std::min<qsizetype>((text.size() * 2 + half - 1) / half, 1 << 30));
+    }
+    qint64 total = 0;
+    scanPieces(text, [&](qsizetype, int tokens) {
+        total += tokens;
+        return true;
+    });
+    return static_cast<int>(std::min<qint64>(total, 1 << 30));
+}
+
+qsizetype TokenEstimator::fittingPrefix(QStringView text, int maxTokens) const
+{
+    if (maxTokens <= 0) return 0;
+    if (m_family == Family::OpenAI) {
+        qsizetype fits = 0;
+        qint64 total = 0;
+        scanPieces(text, [&](qsizetype end, int tokens) {
+            total += tokens;
+            if (total > maxTokens) return false;
+            fits = end;
+            return true;
+        });
+        return fits;
+    }
+
+    const qsizetype limit = static_cast<qsizetype>(maxTokens) * halfCharsPerToken(m_family) / 2;
+    if (limit >= text.size()) return text.size();
+    // Back up to a word boundary unless that loses more than a quarter
+    qsizetype cut = limit;
+    while (cut > limit * 3 / 4 && !text[cut].isSpace()) --cut;
+    return cut > limit * 3 / 4 ? cut : limit;
+}
+
+QString TokenEstimator::truncated(const QString& text, int maxTokens) const
+{
+    const qsizetype length = fittingPrefix(text, maxTokens);
+    return length >= text.size() ? text : text.left(length);
+}
+
+bool TokenEstimator::isReferenceContext(QStringView text)
+{
+    return !text.isEmpty() && startsBlock(text, 0);
+}
+
+QString TokenEstimator::fittedContext(const QString& context, int maxTokens, int* droppedBlocks) const
+{
+    if (droppedBlocks) *droppedBlocks = 0;
+    if (count(context) <= maxTokens) return context;
+    if (!isReferenceContext(context)) return truncated(context, maxTokens);
+
+    // Blocks start at the beginning of a line, best ranked first
+    QList<qsizetype> starts{0};
+    for (qsizetype at = context.indexOf(u'\n'); at >= 0 && at + 1 < context.size(); at = context.indexOf(u'\n', at + 1)) {
+        if (startsBlock(context, at + 1)) starts.append(at + 1);
+    }
+    starts.append(context.size());
+
+    const QStringView view(context);
+    qint64 used = 0;
+    qsizetype kept = 0;
+    for (; kept + 1 < starts.size(); ++kept) {
+        used += count(view.sliced(starts[kept], starts[kept + 1] - starts[kept]));
+        if (used > maxTokens) break;
+    }
+    // Not even the best block fits whole, so it is cut instead
+    const qsizetype blocks = starts.size() - 1;
+    if (droppedBlocks) *droppedBlocks = static_cast<int>(blocks - std::max<qsizetype>(kept, 1));
+    if (kept == 0) return truncated(context.left(starts[1]), maxTokens);
+    return context.left(starts[kept]);
+}
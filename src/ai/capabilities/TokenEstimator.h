@@ -0,0 +1,86 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QString>
+#include <QStringView>
+
+/**
+ * @brief Fast local estimate of how many tokens a model will count in a text.
+ *
+ * No vocabulary is loaded. For OpenAI models the text is split the way their
+ * BPE pre-tokenizer splits it (words with their leading space, digit groups of
+ * up to three, punctuation runs, line breaks) and each piece is charged by its
+ * length, which stays within a few percent of the real count on English prose
+ * and code. Other families use their documented characters-per-token ratios.
+ * Estimates err on the high side so a prompt that fits here fits the provider.
+ */
+class TokenEstimator
+{
+public:
+    enum class Family {
+        Generic,   // about four characters per token
+        OpenAI,    // BPE pre-tokenizer pieces
+        Anthropic, // about 3.5 characters per token
+        Google     // about four characters per token
+    };
+
+    explicit TokenEstimator(Family family = Family::Generic)
+        : m_family(family)
+    {
+    }
+
+    /// "openai", "anthropic", "google" (or "gemini"); anything else is Generic.
+    static Family familyFromName(const QString& name);
+    static QString familyName(Family family);
+    /// The family of the driver profile the model resolves to, else of the provider.
+    static TokenEstimator forModel(const QString& modelId, const QString& providerId);
+
+    Family family() const { return m_family; }
+
+    int count(QStringView text) const;
+
+    /// Length of the longest prefix of @p text estimated at no more than @p maxTokens,
+    /// ending on a piece or word boundary where there is one.
+    qsizetype fittingPrefix(QStringView text, int maxTokens) const;
+
+    /// @p text cut to at most @p maxTokens.
+    QString truncated(const QString& text, int maxTokens) const;
+
+    /**
+     * @brief Fits a retrieved context to @p maxTokens, dropping the lowest ranked chunks first.
+     *
+     * A context formatted by RAG Query is a list of blocks that each start with
+     * "[Reference: ", best match first. The leading blocks that fit whole are kept;
+     * when not even the first fits, or the text has no such blocks, it is truncated.
+     * @p droppedBlocks receives how many blocks were removed.
+     */
+    QString fittedContext(const QString& context, int maxTokens, int* droppedBlocks = nullptr) const;
+
+    /// Whether @p text is made of RAG Query reference blocks.
+    static bool isReferenceContext(QStringView text);
+
+private:
+    Family m_family;
+};
@@ -24,19 +24,31 @@
 #include "ModelCatalogService.h"
 
 #include "ModelCapsRegistry.h"
+#include "ModelListCache.h"
 #include "ai/backends/ILLMBackend.h"
 #include "ai/registry/LLMProviderRegistry.h"
+#include "Logger.h"
+#include "LoggingCategories.h"
 
+#include <QDeadlineTimer>
+#include <QHash>
+#include <QMutex>
+#include <QPromise>
 #include <QSet>
+#include <QThreadPool>
+#include <QWaitCondition>
 #include <QtConcurrent>
 
 #include <algorithm>
+#include <memory>
+#include <optional>
 
 namespace {
 
 bool isLocalProvider(const QString& providerId)
 {
-    return providerId.compare(QStringLiteral("ollama"), Qt::CaseInsensitive) == 0;
+    return providerId.compare(QStringLiteral("ollama"), Qt::CaseInsensitive) == 0
+           || providerId.compare(QStringLiteral("onnx"), Qt::CaseInsensitive) == 0;
 }
 
 int providerOrder(const QString& providerId)
@@ -53,6 +65,12 @@ int providerOrder(const QString& providerId)
     if (providerId == QStringLiteral("ollama")) {
         return 3;
     }
+    if (providerId == QStringLiteral("onnx")) {
+        return 4;
+    }
+    if (providerId == QStringLiteral("mock")) {
+        return 5;
+    }
     return 100;
 }
 
@@ -178,7 +196,9 @@ bool providerHasImplementedEmbeddings(const QString& providerId)
 {
     return providerId == QStringLiteral("openai")
            || providerId == QStringLiteral("google")
-           || providerId == QStringLiteral("ollama");
+           || providerId == QStringLiteral("ollama")
+           || providerId == QStringLiteral("onnx")
+           || providerId == QStringLiteral("mock");
 }
 
 bool providerHasImplementedImageGeneration(const QString& providerId)
@@ -401,14 +421,220 @@ QList<ModelCatalogEntry> buildEntries(const QString& providerId,
     return buildChatEntries(providerId, modelIds, dynamic);
 }
 
+QStringList staticModels(ILLMBackend* backend, ModelCatalogKind kind)
+{
+    return (kind == ModelCatalogKind::Embedding) ? backend->availableEmbeddingModels()
+                                                 : backend->availableModels();
+}
+
+// Cloud providers only list part of what they serve, so the built-in names are always offered too
+QStringList withStaticModels(const QString& providerId, ILLMBackend* backend, ModelCatalogKind kind,
+                             QStringList models)
+{
+    if (providerId != QStringLiteral("ollama")) {
+        for (const QString& fallback : staticModels(backend, kind)) {
+            if (!models.contains(fallback)) {
+                models.append(fallback);
+            }
+        }
+    }
+    return models;
+}
+
+QString credentialFingerprint(const QString& providerId)
+{
+    return ModelListCache::credentialFingerprint(LLMProviderRegistry::instance().getCredential(providerId));
+}
+
+// Discovery tasks spend their time waiting on a provider, so they get their own threads rather
+// than holding global pool threads the backends' own fetches need. Never destroyed, so a fetch
+// still waiting at exit does not block shutdown.
+QThreadPool* discoveryPool()
+{
+    static QThreadPool* pool = []() {
+        auto* threads = new QThreadPool;
+        threads->setMaxThreadCount(8);
+        return threads;
+    }();
+    return pool;
+}
+
+// A provider list request that is still running. Callers that arrive meanwhile wait on it
+// instead of starting another, so a provider that never answers is asked once, not once per
+// dialog or widget that opened in the meantime.
+struct ModelListFetch {
+    QMutex mutex;
+    QWaitCondition done;
+    std::optional<QStringList> models;
+};
+
+QMutex& runningFetchesMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+QHash<QString, std::shared_ptr<ModelListFetch>>& runningFetches()
+{
+    static QHash<QString, std::shared_ptr<ModelListFetch>> fetches;
+    return fetches;
+}
+
+// Backends answer a failed fetch with their static list, so a result identical to that says
+// nothing new and is not written to the disk cache.
+void completeFetch(const QString& providerId, const std::shared_ptr<ModelListFetch>& fetch,
+                   const QStringList& before, const QStringList& models)
+{
+    if (!models.isEmpty() && models != before) {
+        if (const auto cache = ModelListCache::shared()) {
+            cache->store(providerId, credentialFingerprint(providerId), models);
+        }
+    }
+    {
+        QMutexLocker locker(&runningFetchesMutex());
+        runningFetches().remove(providerId);
+    }
+    QMutexLocker locker(&fetch->mutex);
+    fetch->models = models.isEmpty() ? before : models;
+    fetch->done.wakeAll();
+}
+
+std::shared_ptr<ModelListFetch> startOrJoinFetch(const QString& providerId, ILLMBackend* backend,
+                                                 ModelCatalogKind kind)
+{
+    auto fetch = std::make_shared<ModelListFetch>();
+    {
+        QMutexLocker locker(&runningFetchesMutex());
+        if (const auto running = runningFetches().value(providerId)) {
+            return running;
+        }
+        runningFetches().insert(providerId, fetch);
+    }
+
+    // Completion runs on whichever thread finishes the backend's future, or right here if it already has
+    const QStringList before = staticModels(backend, kind);
+    backend->fetchRawModelList()
+        .then([providerId, fetch, before](const QFuture<QStringList>& finished) {
+            QStringList models;
+            try {
+                if (finished.resultCount() > 0) {
+                    models = finished.result();
+                }
+            } catch (...) {
+                CP_WARN.noquote() << QStringLiteral("Model list fetch for [%1] threw; keeping the static list")
+                                         .arg(providerId);
+            }
+            completeFetch(providerId, fetch, before, models);
+        })
+        .onCanceled([providerId, fetch, before]() {
+            completeFetch(providerId, fetch, before, {});
+        });
+    return fetch;
+}
+
+// Asks the provider for its list and records it; nullopt when it has not answered by the
+// discovery deadline. The request keeps running and caches its answer whenever it arrives.
+std::optional<QStringList> fetchAndCacheModels(const QString& providerId, ILLMBackend* backend,
+                                               ModelCatalogKind kind)
+{
+    const std::shared_ptr<ModelListFetch> fetch = startOrJoinFetch(providerId, backend, kind);
+    const int deadlineMs = ModelCatalogService::instance().discoveryDeadlineMs();
+    const QDeadlineTimer deadline(deadlineMs);
+
+    QMutexLocker locker(&fetch->mutex);
+    while (!fetch->models) {
+        if (!fetch->done.wait(&fetch->mutex, deadline)) {
+            CP_CLOG(cp_discovery).noquote() << QStringLiteral("[%1] did not list its models within %2 ms; "
+                                                              "answering without it")
+                                                   .arg(providerId)
+                                                   .arg(deadlineMs);
+            return std::nullopt;
+        }
+    }
+    return *fetch->models;
+}
+
+void refreshInBackground(const QString& providerId, ILLMBackend* backend, ModelCatalogKind kind)
+{
+    const auto cache = ModelListCache::shared();
+    if (!cache || !cache->beginRefresh(providerId)) {
+        return;
+    }
+
+    CP_CLOG(cp_discovery).noquote() << QStringLiteral("Cached model list for [%1] is stale; refreshing in the background")
+                                           .arg(providerId);
+    (void)QtConcurrent::run(discoveryPool(), [providerId, backend, kind, cache]() {
+        fetchAndCacheModels(providerId, backend, kind);
+        cache->endRefresh(providerId);
+    });
+}
+
+// Local servers answer quickly and change whenever a model is pulled, so their cached
+// list only bridges the gap until a refresh; cloud lists are trusted for the TTL.
+std::optional<ModelListCache::Entry> cachedModels(const QString& providerId)
+{
+    const auto cache = ModelListCache::shared();
+    if (!cache) {
+        return std::nullopt;
+    }
+    auto entry = cache->lookup(providerId, credentialFingerprint(providerId));
+    if (entry && isLocalProvider(providerId)) {
+        entry->stale = true;
+    }
+    return entry;
+}
+
+QList<ModelCatalogEntry> discoverModels(const QString& providerId, ModelCatalogKind kind, bool forceRefresh)
+{
+    ILLMBackend* backend = LLMProviderRegistry::instance().getBackend(providerId);
+    if (!backend) {
+        return {};
+    }
+
+    if (kind == ModelCatalogKind::Embedding && providerId != QStringLiteral("ollama")) {
+        return buildEntries(providerId, kind, backend->availableEmbeddingModels(), false);
+    }
+
+    if (!forceRefresh) {
+        if (const auto cached = cachedModels(providerId)) {
+            if (cached->stale) {
+                refreshInBackground(providerId, backend, kind);
+            }
+            return buildEntries(providerId, kind, withStaticModels(providerId, backend, kind, cached->models), true);
+        }
+    }
+
+    if (const auto models = fetchAndCacheModels(providerId, backend, kind)) {
+        return buildEntries(providerId, kind, withStaticModels(providerId, backend, kind, *models), true);
+    }
+    if (const auto cached = cachedModels(providerId)) {
+        return buildEntries(providerId, kind, withStaticModels(providerId, backend, kind, cached->models), true);
+    }
+    return buildEntries(providerId, kind, staticModels(backend, kind), false);
+}
+
 } // namespace
 
+ModelCatalogService::ModelCatalogService()
+{
+    bool ok = false;
+    const int deadlineMs = qEnvironmentVariableIntValue("CP_DISCOVERY_DEADLINE_MS", &ok);
+    if (ok && deadlineMs > 0) {
+        m_discoveryDeadlineMs = deadlineMs;
+    }
+}
+
 ModelCatalogService& ModelCatalogService::instance()
 {
     static ModelCatalogService service;
     return service;
 }
 
+void ModelCatalogService::setDiscoveryDeadlineMs(int milliseconds)
+{
+    m_discoveryDeadlineMs = milliseconds > 0 ? milliseconds : kDefaultDiscoveryDeadlineMs;
+}
+
 bool ModelCatalogService::providerRequiresCredential(const QString& providerId)
 {
     if (const auto settings = ModelCapsRegistry::instance().providerSettings(providerId)) {
@@ -449,6 +675,11 @@ QList<ProviderCatalogEntry> ModelCatalogService::providers(ModelCatalogKind kind
         } else if (kind == ModelCatalogKind::Image && !providerHasImplementedImageGeneration(entry.id)) {
             entry.isUsable = false;
             entry.statusText = QStringLiteral("No image driver");
+        } else if (kind == ModelCatalogKind::Chat && entry.id == QStringLiteral("onnx")) {
+            entry.isUsable = false;
+            entry.statusText = QStringLiteral("Embeddings only");
+        } else if (entry.id == QStringLiteral("mock")) {
+            entry.statusText = QStringLiteral("Simulated");
         } else if (entry.isLocal) {
             if (settings.has_value() && !settings->baseUrl.trimmed().isEmpty()) {
                 entry.statusText = QStringLiteral("Local %1").arg(settings->baseUrl.trimmed());
@@ -503,48 +734,63 @@ QList<ModelCatalogEntry> ModelCatalogService::fallbackModels(const QString& prov
         return {};
     }
 
-    const QStringList models = (kind == ModelCatalogKind::Embedding)
-                                   ? backend->availableEmbeddingModels()
-                                   : backend->availableModels();
-    return buildEntries(providerId, kind, models, false);
+    if (kind != ModelCatalogKind::Embedding || providerId == QStringLiteral("ollama")) {
+        if (const auto cached = cachedModels(providerId)) {
+            return buildEntries(providerId, kind, withStaticModels(providerId, backend, kind, cached->models), true);
+        }
+    }
+
+    return buildEntries(providerId, kind, staticModels(backend, kind), false);
 }
 
 QFuture<QList<ModelCatalogEntry>> ModelCatalogService::fetchModels(const QString& providerId,
-                                                                   ModelCatalogKind kind)
+                                                                   ModelCatalogKind kind,
+                                                                   bool forceRefresh)
 {
-    return QtConcurrent::run([providerId, kind]() -> QList<ModelCatalogEntry> {
-        ILLMBackend* backend = LLMProviderRegistry::instance().getBackend(providerId);
-        if (!backend) {
-            return {};
-        }
+    return QtConcurrent::run(discoveryPool(), [providerId, kind, forceRefresh]() {
+        return discoverModels(providerId, kind, forceRefresh);
+    });
+}
 
-        if (kind == ModelCatalogKind::Embedding && providerId != QStringLiteral("ollama")) {
-            return buildEntries(providerId, kind, backend->availableEmbeddingModels(), false);
+QFuture<QList<ModelCatalogEntry>> ModelCatalogService::fetchAllModels(ModelCatalogKind kind, bool forceRefresh)
+{
+    struct Discovery {
+        QPromise<QList<ModelCatalogEntry>> promise;
+        QMutex mutex;
+        int remaining {0};
+    };
+    auto discovery = std::make_shared<Discovery>();
+    discovery->promise.start();
+    QFuture<QList<ModelCatalogEntry>> future = discovery->promise.future();
+
+    // Listing providers may load credentials, so that happens off the caller's thread too
+    discoveryPool()->start([this, discovery, kind, forceRefresh]() {
+        QStringList providerIds;
+        for (const ProviderCatalogEntry& provider : providers(kind)) {
+            if (provider.isUsable) {
+                providerIds.append(provider.id);
+            }
         }
-
-        QFuture<QStringList> fetchFuture = backend->fetchRawModelList();
-        fetchFuture.waitForFinished();
-
-        QStringList models = fetchFuture.result();
-        if (models.isEmpty()) {
-            models = (kind == ModelCatalogKind::Embedding)
-                         ? backend->availableEmbeddingModels()
-                         : backend->availableModels();
+        if (providerIds.isEmpty()) {
+            discovery->promise.finish();
+            return;
         }
 
-        if (providerId != QStringLiteral("ollama")) {
-            QStringList fallbackModels = (kind == ModelCatalogKind::Embedding)
-                                             ? backend->availableEmbeddingModels()
-                                             : backend->availableModels();
-            for (const QString& fallback : fallbackModels) {
-                if (!models.contains(fallback)) {
-                    models.append(fallback);
+        discovery->remaining = static_cast<int>(providerIds.size());
+        for (const QString& providerId : providerIds) {
+            discoveryPool()->start([discovery, providerId, kind, forceRefresh]() {
+                QList<ModelCatalogEntry> entries = discoverModels(providerId, kind, forceRefresh);
+                QMutexLocker locker(&discovery->mutex);
+                if (!entries.isEmpty()) {
+                    discovery->promise.addResult(std::move(entries));
                 }
-            }
+                if (--discovery->remaining == 0) {
+                    discovery->promise.finish();
+                }
+            });
         }
-
-        return buildEntries(providerId, kind, models, true);
     });
+    return future;
 }
 
 QFuture<ModelTestResult> ModelCatalogService::testModel(const QString& providerId,
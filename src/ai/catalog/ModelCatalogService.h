@@ -28,6 +28,8 @@
 #include <QString>
 #include <QStringList>
 
+#include <atomic>
+
 enum class ModelCatalogKind {
     Chat,
     Embedding,
@@ -81,10 +83,26 @@ public:
 
     QList<ProviderCatalogEntry> providers(ModelCatalogKind kind = ModelCatalogKind::Chat) const;
     QString defaultProvider(ModelCatalogKind kind = ModelCatalogKind::Chat) const;
+    /// Offline list for synchronous callers: the last cached discovery result if any, else the static list.
     QList<ModelCatalogEntry> fallbackModels(const QString& providerId,
                                             ModelCatalogKind kind = ModelCatalogKind::Chat) const;
+    /**
+     * Answers from the disk-backed ModelListCache when it holds a list for the provider,
+     * refreshing a stale one in the background; forceRefresh always asks the provider.
+     * A provider that has not answered within discoveryDeadlineMs() gets its cached or
+     * static list instead; its fetch carries on and lands in the cache when it completes.
+     */
     QFuture<QList<ModelCatalogEntry>> fetchModels(const QString& providerId,
-                                                  ModelCatalogKind kind = ModelCatalogKind::Chat);
+                                                  ModelCatalogKind kind = ModelCatalogKind::Chat,
+                                                  bool forceRefresh = false);
+    /**
+     * fetchModels() for every usable provider at once. Each provider's entries are added to
+     * the future as a separate result as soon as they are known, so a QFutureWatcher's
+     * resultReadyAt() can fill a view provider by provider; the slowest one takes at most
+     * the discovery deadline.
+     */
+    QFuture<QList<ModelCatalogEntry>> fetchAllModels(ModelCatalogKind kind = ModelCatalogKind::Chat,
+                                                     bool forceRefresh = false);
     QFuture<ModelTestResult> testModel(const QString& providerId,
                                        const QString& modelId,
                                        ModelCatalogKind kind = ModelCatalogKind::Chat);
@@ -93,6 +111,13 @@ public:
 
     static bool providerRequiresCredential(const QString& providerId);
 
+    static constexpr int kDefaultDiscoveryDeadlineMs = 4000;
+    /// How long a fetch waits for one provider's list; CP_DISCOVERY_DEADLINE_MS sets the initial value.
+    int discoveryDeadlineMs() const { return m_discoveryDeadlineMs.load(); }
+    void setDiscoveryDeadlineMs(int milliseconds);
+
 private:
-    ModelCatalogService() = default;
+    ModelCatalogService();
+
+    std::atomic<int> m_discoveryDeadlineMs {kDefaultDiscoveryDeadlineMs};
 };
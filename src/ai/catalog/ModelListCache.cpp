@@ -0,0 +1,224 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "ModelListCache.h"
+
+#include "Logger.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace {
+
+constexpr int kFileVersion = 1;
+
+QMutex g_sharedMutex;
+std::shared_ptr<ModelListCache> g_shared;
+bool g_sharedConfigured = false;
+
+QString normalisedProvider(const QString& providerId)
+{
+    return providerId.trimmed().toLower();
+}
+
+} // namespace
+
+ModelListCache::ModelListCache(const QString& filePath, qint64 ttlSeconds)
+    : m_filePath(QDir::cleanPath(filePath))
+    , m_ttlSeconds(ttlSeconds > 0 ? ttlSeconds : kDefaultTtlSeconds)
+{
+}
+
+std::shared_ptr<ModelListCache> ModelListCache::shared()
+{
+    QMutexLocker locker(&g_sharedMutex);
+    if (!g_sharedConfigured) {
+        g_sharedConfigured = true;
+        if (qEnvironmentVariable("CP_MODEL_LIST_CACHE").trimmed() != QStringLiteral("0")) {
+            bool ok = false;
+            const qint64 ttl = qEnvironmentVariable("CP_MODEL_LIST_CACHE_TTL").toLongLong(&ok);
+            g_shared = std::make_shared<ModelListCache>(defaultPath(), ok && ttl > 0 ? ttl : kDefaultTtlSeconds);
+        }
+    }
+    return g_shared;
+}
+
+void ModelListCache::setShared(std::shared_ptr<ModelListCache> cache)
+{
+    QMutexLocker locker(&g_sharedMutex);
+    g_shared = std::move(cache);
+    g_sharedConfigured = true;
+}
+
+QString ModelListCache::defaultPath()
+{
+#if defined(Q_OS_MAC)
+    const QString baseDir = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation);
+#else
+    const QString baseDir = QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation);
+#endif
+    if (!baseDir.isEmpty()) {
+        return QDir(baseDir).filePath(QStringLiteral("CognitivePipelines/model_lists.json"));
+    }
+    return QDir::current().filePath(QStringLiteral("model_lists.json"));
+}
+
+QString ModelListCache::credentialFingerprint(const QString& credential)
+{
+    const QString trimmed = credential.trimmed();
+    if (trimmed.isEmpty()) {
+        return {};
+    }
+    const QByteArray digest = QCryptographicHash::hash(trimmed.toUtf8(), QCryptographicHash::Sha256);
+    return QString::fromLatin1(digest.toHex().left(16));
+}
+
+std::optional<ModelListCache::Entry> ModelListCache::lookup(const QString& providerId,
+                                                            const QString& fingerprint) const
+{
+    QMutexLocker locker(&m_mutex);
+    loadLocked();
+
+    const auto it = m_entries.constFind(normalisedProvider(providerId));
+    if (it == m_entries.constEnd() || it->fingerprint != fingerprint || it->models.isEmpty()) {
+        return std::nullopt;
+    }
+
+    Entry entry;
+    entry.models = it->models;
+    entry.fetchedAt = it->fetchedAt;
+    entry.stale = !it->fetchedAt.isValid()
+                  || it->fetchedAt.secsTo(QDateTime::currentDateTimeUtc()) >= m_ttlSeconds;
+    return entry;
+}
+
+void ModelListCache::store(const QString& providerId, const QString& fingerprint, const QStringList& models)
+{
+    if (models.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    loadLocked();
+    m_entries.insert(normalisedProvider(providerId), Stored {models, QDateTime::currentDateTimeUtc(), fingerprint});
+    saveLocked();
+}
+
+void ModelListCache::invalidate(const QString& providerId)
+{
+    QMutexLocker locker(&m_mutex);
+    loadLocked();
+    if (m_entries.remove(normalisedProvider(providerId)) > 0) {
+        saveLocked();
+    }
+}
+
+bool ModelListCache::beginRefresh(const QString& providerId)
+{
+    QMutexLocker locker(&m_mutex);
+    const QString key = normalisedProvider(providerId);
+    if (m_refreshing.contains(key)) {
+        return false;
+    }
+    m_refreshing.insert(key);
+    return true;
+}
+
+void ModelListCache::endRefresh(const QString& providerId)
+{
+    QMutexLocker locker(&m_mutex);
+    m_refreshing.remove(normalisedProvider(providerId));
+}
+
+void ModelListCache::loadLocked() const
+{
+    if (m_loaded) {
+        return;
+    }
+    m_loaded = true;
+
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+        CP_WARN.noquote() << "ModelListCache: ignoring unreadable" << m_filePath << "-" << error.errorString();
+        return;
+    }
+
+    const QJsonObject root = doc.object();
+    if (root.value(QStringLiteral("version")).toInt() != kFileVersion) {
+        return;
+    }
+
+    const QJsonObject providers = root.value(QStringLiteral("providers")).toObject();
+    for (auto it = providers.constBegin(); it != providers.constEnd(); ++it) {
+        const QJsonObject obj = it.value().toObject();
+        Stored stored;
+        for (const QJsonValue& model : obj.value(QStringLiteral("models")).toArray()) {
+            if (model.isString()) {
+                stored.models.append(model.toString());
+            }
+        }
+        stored.fetchedAt = QDateTime::fromString(obj.value(QStringLiteral("fetchedAt")).toString(), Qt::ISODate);
+        stored.fingerprint = obj.value(QStringLiteral("credential")).toString();
+        m_entries.insert(it.key(), stored);
+    }
+}
+
+void ModelListCache::saveLocked() const
+{
+    QJsonObject providers;
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        QJsonObject obj;
+        obj.insert(QStringLiteral("models"), QJsonArray::fromStringList(it->models));
+        obj.insert(QStringLiteral("fetchedAt"), it->fetchedAt.toString(Qt::ISODate));
+        obj.insert(QStringLiteral("credential"), it->fingerprint);
+        providers.insert(it.key(), obj);
+    }
+
+    QJsonObject root;
+    root.insert(QStringLiteral("version"), kFileVersion);
+    root.insert(QStringLiteral("providers"), providers);
+
+    QDir().mkpath(QFileInfo(m_filePath).absolutePath());
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        CP_WARN.noquote() << "ModelListCache: cannot write" << m_filePath << "-" << file.errorString();
+        return;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+    if (!file.commit()) {
+        CP_WARN.noquote() << "ModelListCache: cannot write" << m_filePath << "-" << file.errorString();
+    }
+}
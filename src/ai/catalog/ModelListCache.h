@@ -0,0 +1,101 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#include <memory>
+#include <optional>
+
+/**
+ * @brief Disk-backed cache of the raw model lists each provider reports.
+ *
+ * Listing models is a network round trip (several seconds for some cloud
+ * providers, or a timeout when Ollama is not running), and the answer rarely
+ * changes, so ModelCatalogService keeps the last successful list per provider
+ * in one JSON file under the user config directory. Entries carry the time
+ * they were fetched and a fingerprint of the credential used: an entry older
+ * than the TTL is still served but reported stale so the caller can refresh
+ * it in the background, and an entry fetched with another key is ignored.
+ * All access is serialised by an internal mutex.
+ */
+class ModelListCache
+{
+public:
+    static constexpr qint64 kDefaultTtlSeconds = 24 * 60 * 60;
+
+    struct Entry {
+        QStringList models;
+        QDateTime fetchedAt;
+        bool stale {false};
+    };
+
+    explicit ModelListCache(const QString& filePath, qint64 ttlSeconds = kDefaultTtlSeconds);
+
+    /**
+     * @brief The process-wide cache at defaultPath().
+     *
+     * CP_MODEL_LIST_CACHE=0 disables it (nullptr); CP_MODEL_LIST_CACHE_TTL
+     * overrides the TTL in seconds.
+     */
+    static std::shared_ptr<ModelListCache> shared();
+    static void setShared(std::shared_ptr<ModelListCache> cache);
+    static QString defaultPath();
+
+    /// Short, non-reversible tag for a credential so key changes invalidate entries.
+    static QString credentialFingerprint(const QString& credential);
+
+    std::optional<Entry> lookup(const QString& providerId, const QString& fingerprint) const;
+    void store(const QString& providerId, const QString& fingerprint, const QStringList& models);
+    void invalidate(const QString& providerId);
+
+    /// Claims the single background refresh slot for a provider; false when one is already running.
+    bool beginRefresh(const QString& providerId);
+    void endRefresh(const QString& providerId);
+
+    QString filePath() const { return m_filePath; }
+    qint64 ttlSeconds() const { return m_ttlSeconds; }
+
+private:
+    struct Stored {
+        QStringList models;
+        QDateTime fetchedAt;
+        QString fingerprint;
+    };
+
+    void loadLocked() const;
+    void saveLocked() const;
+
+    QString m_filePath;
+    qint64 m_ttlSeconds;
+    mutable QMutex m_mutex;
+    mutable bool m_loaded {false};
+    mutable QHash<QString, Stored> m_entries;
+    QSet<QString> m_refreshing;
+};
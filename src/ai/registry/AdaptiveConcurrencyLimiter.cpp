@@ -0,0 +1,244 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "AdaptiveConcurrencyLimiter.h"
+
+#include "Logger.h"
+#include "LoggingCategories.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+// Waiting callers wake at least this often to notice cancellation
+constexpr auto kPollInterval = std::chrono::milliseconds(200);
+
+// Latency above this multiple of the recent median stops the limit growing
+constexpr double kLatencyTolerance = 2.0;
+
+// Samples needed before the median is trusted
+constexpr std::size_t kMinSamples = 10;
+
+} // namespace
+
+AdaptiveConcurrencyLimiter::Slot::Slot(Slot&& other) noexcept
+    : m_limiter(std::exchange(other.m_limiter, nullptr))
+    , m_key(std::move(other.m_key))
+{
+}
+
+AdaptiveConcurrencyLimiter::Slot& AdaptiveConcurrencyLimiter::Slot::operator=(Slot&& other) noexcept
+{
+    if (this != &other) {
+        if (m_limiter) {
+            m_limiter->release(m_key);
+        }
+        m_limiter = std::exchange(other.m_limiter, nullptr);
+        m_key = std::move(other.m_key);
+    }
+    return *this;
+}
+
+AdaptiveConcurrencyLimiter::Slot::~Slot()
+{
+    if (m_limiter) {
+        m_limiter->release(m_key);
+    }
+}
+
+void AdaptiveConcurrencyLimiter::Slot::record(Outcome outcome, std::chrono::milliseconds latency)
+{
+    if (m_limiter && outcome != Outcome::Ignored) {
+        m_limiter->record(m_key, outcome, latency);
+    }
+}
+
+QString AdaptiveConcurrencyLimiter::keyFor(const QString& providerId, const QString& modelId)
+{
+    return providerId + QLatin1Char('/') + modelId;
+}
+
+int AdaptiveConcurrencyLimiter::percentile(std::vector<int> samples, double fraction)
+{
+    if (samples.empty()) {
+        return 0;
+    }
+    const auto index = static_cast<std::size_t>(fraction * static_cast<double>(samples.size() - 1) + 0.5);
+    std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(index), samples.end());
+    return samples[index];
+}
+
+AdaptiveConcurrencyLimiter::Snapshot AdaptiveConcurrencyLimiter::snapshotOf(const State& state)
+{
+    const std::vector<int> samples(state.latenciesMs.begin(), state.latenciesMs.end());
+    Snapshot snapshot;
+    snapshot.limit = state.limit;
+    snapshot.inFlight = state.inFlight;
+    snapshot.p50Ms = percentile(samples, 0.5);
+    snapshot.p95Ms = percentile(samples, 0.95);
+    snapshot.throttles = state.throttles;
+    return snapshot;
+}
+
+QString AdaptiveConcurrencyLimiter::describe(const QString& key, const State& state, const char* event)
+{
+    const Snapshot snapshot = snapshotOf(state);
+    return QStringLiteral("[Concurrency] %1 %2 limit=%3 in_flight=%4 p50=%5ms p95=%6ms throttles=%7")
+        .arg(key, QLatin1String(event))
+        .arg(static_cast<int>(snapshot.limit))
+        .arg(snapshot.inFlight)
+        .arg(snapshot.p50Ms)
+        .arg(snapshot.p95Ms)
+        .arg(snapshot.throttles);
+}
+
+AdaptiveConcurrencyLimiter::Slot AdaptiveConcurrencyLimiter::acquire(const QString& providerId,
+                                                                     const QString& modelId,
+                                                                     const CancellationToken& cancellation)
+{
+    const QString key = keyFor(providerId, modelId);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const auto [entry, created] = m_states.try_emplace(key);
+    State& state = entry->second;
+    if (created) {
+        const auto ceiling = m_ceilings.find(providerId);
+        if (ceiling != m_ceilings.end()) {
+            state.ceiling = ceiling->second;
+            state.limit = std::min(state.limit, state.ceiling);
+        }
+    }
+    const std::uint64_t ticket = state.nextTicket++;
+    state.queue.push_back(ticket);
+    for (;;) {
+        if (cancellation.isCancelled()) {
+            state.queue.erase(std::find(state.queue.begin(), state.queue.end(), ticket));
+            m_changed.notify_all();
+            return Slot{};
+        }
+        if (state.queue.front() == ticket && state.inFlight < static_cast<int>(state.limit)) {
+            state.queue.pop_front();
+            ++state.inFlight;
+            m_changed.notify_all();
+            Slot slot;
+            slot.m_limiter = this;
+            slot.m_key = key;
+            return slot;
+        }
+        m_changed.wait_for(lock, kPollInterval);
+    }
+}
+
+void AdaptiveConcurrencyLimiter::record(const QString& key, Outcome outcome, std::chrono::milliseconds latency)
+{
+    QString message;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        State& state = m_states[key];
+        const int before = static_cast<int>(state.limit);
+        const std::vector<int> samples(state.latenciesMs.begin(), state.latenciesMs.end());
+        const int medianMs = percentile(samples, 0.5);
+
+        if (outcome == Outcome::Throttled) {
+            ++state.throttles;
+            const Clock::time_point now = Clock::now();
+            const auto cooldown = std::chrono::milliseconds(std::max(medianMs, 1000));
+            if (now - state.lastDecrease >= cooldown) {
+                state.limit = std::max(kMinLimit, std::floor(state.limit / 2.0));
+                state.lastDecrease = now;
+            }
+            message = describe(key, state, "throttled");
+        } else {
+            const int latencyMs = static_cast<int>(latency.count());
+            const bool latencyFlat = samples.size() < kMinSamples || latencyMs <= medianMs * kLatencyTolerance;
+            // Only a limit that is actually being used has earned more room
+            if (latencyFlat && state.inFlight * 2 >= static_cast<int>(state.limit)) {
+                state.limit = std::min(state.ceiling, state.limit + 1.0 / state.limit);
+            }
+            state.latenciesMs.push_back(latencyMs);
+            if (state.latenciesMs.size() > kLatencyWindow) {
+                state.latenciesMs.pop_front();
+            }
+            if (static_cast<int>(state.limit) != before) {
+                message = describe(key, state, "increased");
+            }
+        }
+        m_changed.notify_all();
+    }
+    if (!message.isEmpty()) {
+        CP_CLOG(cp_concurrency).noquote() << message;
+    }
+}
+
+void AdaptiveConcurrencyLimiter::release(const QString& key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto it = m_states.find(key);
+    if (it != m_states.end() && it->second.inFlight > 0) {
+        --it->second.inFlight;
+    }
+    m_changed.notify_all();
+}
+
+AdaptiveConcurrencyLimiter::Snapshot AdaptiveConcurrencyLimiter::snapshot(const QString& providerId,
+                                                                          const QString& modelId) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto it = m_states.find(keyFor(providerId, modelId));
+    return it != m_states.end() ? snapshotOf(it->second) : Snapshot{};
+}
+
+void AdaptiveConcurrencyLimiter::setCeiling(const QString& providerId, int maxInFlight)
+{
+    const double ceiling = maxInFlight > 0 ? std::clamp(static_cast<double>(maxInFlight), kMinLimit, kMaxLimit)
+                                           : kMaxLimit;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto known = m_ceilings.find(providerId);
+    if (known != m_ceilings.end() && known->second == ceiling) {
+        return;
+    }
+    m_ceilings[providerId] = ceiling;
+    const QString prefix = keyFor(providerId, QString());
+    for (auto& [key, state] : m_states) {
+        if (key.startsWith(prefix)) {
+            state.ceiling = ceiling;
+            state.limit = std::min(state.limit, ceiling);
+        }
+    }
+    m_changed.notify_all();
+}
+
+void AdaptiveConcurrencyLimiter::reset()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Keep entries with callers in flight or waiting so their slots stay valid
+    for (auto& entry : m_states) {
+        State& state = entry.second;
+        state.limit = std::min(kInitialLimit, state.ceiling);
+        state.latenciesMs.clear();
+        state.throttles = 0;
+        state.lastDecrease = Clock::time_point();
+    }
+    m_changed.notify_all();
+}
@@ -0,0 +1,134 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QString>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "CancellationToken.h"
+
+// AIMD concurrency limits per (provider, model), layered over the static
+// budgets in ProviderRateLimiter.
+//
+// Each key starts at kInitialLimit requests in flight. A successful response
+// whose latency stays within twice the recent median raises the limit by
+// 1/limit, which is about one more slot per round of requests. Running at the
+// limit is required for this; idle capacity proves nothing. HTTP 429, 5xx and
+// timeouts halve the limit. Repeated decreases are ignored for one median
+// latency, so a burst of rejections from the same round counts once. Callers
+// over the limit wait in FIFO order. Limit changes and throttle events are
+// logged with the current p50/p95 latency.
+class AdaptiveConcurrencyLimiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr double kInitialLimit = 4.0;
+    static constexpr double kMinLimit = 1.0;
+    static constexpr double kMaxLimit = 64.0;
+    static constexpr std::size_t kLatencyWindow = 200;
+
+    enum class Outcome {
+        Success,   // latency sample that may raise the limit
+        Throttled, // 429, 5xx or timeout; halves the limit
+        Ignored    // cancelled, client error, network failure
+    };
+
+    struct Snapshot {
+        double limit = kInitialLimit;
+        int inFlight = 0;
+        int p50Ms = 0;
+        int p95Ms = 0;
+        std::uint64_t throttles = 0;
+    };
+
+    // One in-flight request. Releases its place when destroyed.
+    class Slot {
+    public:
+        Slot() = default;
+        Slot(Slot&& other) noexcept;
+        Slot& operator=(Slot&& other) noexcept;
+        Slot(const Slot&) = delete;
+        Slot& operator=(const Slot&) = delete;
+        ~Slot();
+
+        // False only when the caller was cancelled while waiting
+        explicit operator bool() const { return m_limiter != nullptr; }
+
+        void record(Outcome outcome, std::chrono::milliseconds latency);
+
+    private:
+        friend class AdaptiveConcurrencyLimiter;
+
+        AdaptiveConcurrencyLimiter* m_limiter = nullptr;
+        QString m_key;
+    };
+
+    AdaptiveConcurrencyLimiter() = default;
+    AdaptiveConcurrencyLimiter(const AdaptiveConcurrencyLimiter&) = delete;
+    AdaptiveConcurrencyLimiter& operator=(const AdaptiveConcurrencyLimiter&) = delete;
+
+    Slot acquire(const QString& providerId,
+                 const QString& modelId,
+                 const CancellationToken& cancellation = CancellationToken::current());
+
+    Snapshot snapshot(const QString& providerId, const QString& modelId) const;
+
+    // Caps every model of the provider at maxInFlight, for servers with a fixed
+    // number of parallel slots (Ollama). 0 removes the cap.
+    void setCeiling(const QString& providerId, int maxInFlight);
+
+    // Forgets learned limits and latencies (tests, or after a quota change)
+    void reset();
+
+private:
+    struct State {
+        double limit = kInitialLimit;
+        double ceiling = kMaxLimit;
+        int inFlight = 0;
+        std::deque<std::uint64_t> queue;
+        std::uint64_t nextTicket = 0;
+        std::deque<int> latenciesMs;
+        std::uint64_t throttles = 0;
+        Clock::time_point lastDecrease;
+    };
+
+    static QString keyFor(const QString& providerId, const QString& modelId);
+    static int percentile(std::vector<int> samples, double fraction);
+    static Snapshot snapshotOf(const State& state);
+    static QString describe(const QString& key, const State& state, const char* event);
+    void record(const QString& key, Outcome outcome, std::chrono::milliseconds latency);
+    void release(const QString& key);
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::map<QString, State> m_states;
+    std::map<QString, double> m_ceilings;
+};
@@ -28,11 +28,18 @@
 #include "../backends/GoogleBackend.h"
 #include "../backends/AnthropicBackend.h"
 #include "../backends/OllamaBackend.h"
+#include "../backends/MockBackend.h"
+#if CP_HAS_ONNXRUNTIME
+#include "../backends/OnnxEmbeddingBackend.h"
+#endif
 #include "ModelCapsRegistry.h"
+#include "MetricsRegistry.h"
+#include "Tracer.h"
 
 #include <QMutexLocker>
 #include <QByteArray>
 #include <QFile>
+#include <QFileSystemWatcher>
 #include <QFileInfo>
 #include <QDir>
 #include <QCoreApplication>
@@ -42,26 +49,30 @@
 #include <QJsonArray>
 #include <QSaveFile>
 #include <QTextStream>
+#include <QtConcurrent/QtConcurrentRun>
 #include "Logger.h"
 
 LLMProviderRegistry& LLMProviderRegistry::instance() {
-    // Thread-safe singleton using C++11 magic statics
-    static LLMProviderRegistry instance;
-    
-    // Register concrete backends on first initialization
-    static bool backendsRegistered = false;
-    if (!backendsRegistered) {
-        instance.registerBackend(std::make_shared<OpenAIBackend>());
-        instance.registerBackend(std::make_shared<GoogleBackend>());
-        instance.registerBackend(std::make_shared<AnthropicBackend>());
+    // Thread-safe singleton using C++11 magic statics. The concrete backends are
+    // registered inside the same initialisation, so a first call from a startup
+    // warm-up thread cannot race one from the GUI thread.
+    static LLMProviderRegistry& instance = []() -> LLMProviderRegistry& {
+        static LLMProviderRegistry registry;
+        registry.registerBackend(std::make_shared<OpenAIBackend>());
+        registry.registerBackend(std::make_shared<GoogleBackend>());
+        registry.registerBackend(std::make_shared<AnthropicBackend>());
         const QByteArray disableOllama = qgetenv("CP_DISABLE_OLLAMA");
         if (disableOllama != QByteArrayLiteral("1")
             && disableOllama.compare(QByteArrayLiteral("true"), Qt::CaseInsensitive) != 0) {
-            instance.registerBackend(std::make_shared<OllamaBackend>());
+            registry.registerBackend(std::make_shared<OllamaBackend>());
         }
-        backendsRegistered = true;
-    }
-    
+#if CP_HAS_ONNXRUNTIME
+        registry.registerBackend(std::make_shared<OnnxEmbeddingBackend>());
+#endif
+        registry.registerBackend(std::make_shared<MockBackend>());
+        return registry;
+    }();
+
     return instance;
 }
 
@@ -178,6 +189,9 @@ bool LLMProviderRegistry::saveCredentials(const QMap<QString, QString>& credenti
     QFile::setPermissions(filePath, QFileDevice::ReadOwner | QFileDevice::WriteOwner);
 #endif
 
+    // The watcher may report the save late; readers must not see the old keys meanwhile
+    invalidateCredentials();
+
     // Also update in-memory Anthropic key if present
     if (credentials.contains(QStringLiteral("anthropic"))) {
         setAnthropicKey(credentials.value(QStringLiteral("anthropic")));
@@ -225,7 +239,47 @@ QString LLMProviderRegistry::getCredential(const QString& providerId) {
         }
     }
 
-    // Fall back to accounts.json file
+    // Fall back to the accounts.json files, parsed once and cached until they change
+    const QString account = providerId.toLower();
+    quint64 generation = 0;
+    bool loaded = false;
+    {
+        QReadLocker locker(&m_credentialLock);
+        loaded = m_credentialsLoaded;
+        if (loaded) {
+            const QString key = m_fileCredentials.value(account);
+            if (!key.isEmpty()) {
+                return key;
+            }
+        }
+        generation = m_credentialGeneration;
+    }
+    if (!loaded) {
+        const QStringList paths = credentialFilePaths();
+        watchCredentialFiles(paths);
+        QHash<QString, QString> credentials = readCredentialFiles(paths);
+        const QString key = credentials.value(account);
+        QWriteLocker locker(&m_credentialLock);
+        // A file that changed while it was read is read again next time
+        if (generation == m_credentialGeneration) {
+            m_fileCredentials = std::move(credentials);
+            m_credentialsLoaded = true;
+        }
+        if (!key.isEmpty()) {
+            return key;
+        }
+    }
+
+    if (const auto settings = ModelCapsRegistry::instance().providerSettings(providerId)) {
+        if (!settings->apiKey.trimmed().isEmpty()) {
+            return settings->apiKey.trimmed();
+        }
+    }
+
+    return {};
+}
+
+QStringList LLMProviderRegistry::credentialFilePaths() {
     // Reuse the same path logic as LLMConnector::defaultAccountsFilePath()
     // to ensure consistency across the application, but also scan a few
     // likely locations used in CI (current working dir / repo root).
@@ -255,8 +309,12 @@ QString LLMProviderRegistry::getCredential(const QString& providerId) {
     }
 
     candidatePaths.removeDuplicates();
+    return candidatePaths;
+}
 
-    for (const QString& path : candidatePaths) {
+QHash<QString, QString> LLMProviderRegistry::readCredentialFiles(const QStringList& paths) {
+    QHash<QString, QString> credentials;
+    for (const QString& path : paths) {
         QFile f(path);
         if (!f.exists()) {
             continue;
@@ -280,22 +338,113 @@ QString LLMProviderRegistry::getCredential(const QString& providerId) {
         const QJsonArray accounts = root.value(QStringLiteral("accounts")).toArray();
         for (const QJsonValue& v : accounts) {
             const QJsonObject acc = v.toObject();
-            const QString name = acc.value(QStringLiteral("name")).toString();
-
-            if (name.compare(providerId, Qt::CaseInsensitive) == 0) {
-                const QString key = acc.value(QStringLiteral("api_key")).toString();
-                if (!key.isEmpty()) {
-                    return key;
-                }
+            const QString name = acc.value(QStringLiteral("name")).toString().toLower();
+            const QString key = acc.value(QStringLiteral("api_key")).toString();
+            if (!key.isEmpty() && !credentials.contains(name)) {
+                credentials.insert(name, key);
             }
         }
     }
+    return credentials;
+}
 
-    if (const auto settings = ModelCapsRegistry::instance().providerSettings(providerId)) {
-        if (!settings->apiKey.trimmed().isEmpty()) {
-            return settings->apiKey.trimmed();
+void LLMProviderRegistry::watchCredentialFiles(const QStringList& paths) {
+    QCoreApplication* app = QCoreApplication::instance();
+    if (!app) {
+        return;
+    }
+
+    // An existing file is watched itself; a missing one through its directory, so
+    // creating it is noticed. Saves replace the file, which drops its watch, so the
+    // paths are re-added on every reload.
+    QStringList watched;
+    for (const QString& path : paths) {
+        const QFileInfo info(path);
+        if (info.exists()) {
+            watched << info.absoluteFilePath();
+        } else if (QFileInfo(info.absolutePath()).isDir()) {
+            watched << info.absolutePath();
         }
     }
+    watched.removeDuplicates();
+
+    QMetaObject::invokeMethod(app, [this, watched]() {
+        if (!m_credentialWatcher) {
+            m_credentialWatcher = new QFileSystemWatcher(QCoreApplication::instance());
+            const auto invalidate = [this]() { invalidateCredentials(); };
+            QObject::connect(m_credentialWatcher, &QFileSystemWatcher::fileChanged, m_credentialWatcher, invalidate);
+            QObject::connect(m_credentialWatcher, &QFileSystemWatcher::directoryChanged, m_credentialWatcher,
+                             invalidate);
+        }
+        const QStringList current = m_credentialWatcher->files() + m_credentialWatcher->directories();
+        QStringList added;
+        for (const QString& path : watched) {
+            if (!current.contains(path)) {
+                added << path;
+            }
+        }
+        if (!added.isEmpty()) {
+            m_credentialWatcher->addPaths(added);
+        }
+    });
+}
 
-    return {};
+void LLMProviderRegistry::invalidateCredentials() {
+    QWriteLocker locker(&m_credentialLock);
+    m_credentialsLoaded = false;
+    m_fileCredentials.clear();
+    ++m_credentialGeneration;
+}
+
+void LLMProviderRegistry::recordUsage(const QString& providerId, const QString& modelId, const LLMUsage& usage) {
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    const QString help = QStringLiteral("Tokens reported by providers, by direction");
+    const auto count = [&](const QString& direction, int tokens) {
+        if (tokens <= 0) return;
+        metrics.counter(QStringLiteral("cp_llm_tokens"), help,
+                        {{QStringLiteral("provider"), providerId},
+                         {QStringLiteral("model"), modelId},
+                         {QStringLiteral("direction"), direction}})
+            .increment(static_cast<quint64>(tokens));
+    };
+    count(QStringLiteral("input"), usage.inputTokens);
+    count(QStringLiteral("output"), usage.outputTokens);
+    count(QStringLiteral("cache_read"), usage.cacheReadTokens);
+    count(QStringLiteral("cache_write"), usage.cacheWriteTokens);
+
+    // The node execution (or body node) span the call was made for
+    if (Tracer::Span* span = Tracer::currentSpan()) {
+        span->setAttribute(QStringLiteral("gen_ai.provider.name"), providerId);
+        span->setAttribute(QStringLiteral("gen_ai.request.model"), modelId);
+        span->setAttribute(QStringLiteral("gen_ai.usage.input_tokens"), usage.inputTokens);
+        span->setAttribute(QStringLiteral("gen_ai.usage.output_tokens"), usage.outputTokens);
+        if (usage.cacheReadTokens > 0) {
+            span->setAttribute(QStringLiteral("gen_ai.usage.cache_read_tokens"), usage.cacheReadTokens);
+        }
+        if (usage.cacheWriteTokens > 0) {
+            span->setAttribute(QStringLiteral("gen_ai.usage.cache_write_tokens"), usage.cacheWriteTokens);
+        }
+    }
+}
+
+void LLMProviderRegistry::warmUpInBackground(const QString& providerId, const QString& modelId) {
+    ILLMBackend* backend = getBackend(providerId);
+    if (!backend) {
+        return;
+    }
+    (void)QtConcurrent::run([this, backend, providerId, modelId]() {
+        backend->warmUp(getCredential(providerId), modelId);
+    });
+}
+
+void LLMProviderRegistry::recordEmbeddings(const QString& providerId, qsizetype texts, double seconds, bool failed) {
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    const MetricsRegistry::Labels labels = {{QStringLiteral("provider"), providerId}};
+    if (!failed) {
+        metrics.counter(QStringLiteral("cp_embedding_texts"), QStringLiteral("Texts embedded"), labels)
+            .increment(static_cast<quint64>(texts));
+    }
+    metrics.histogram(QStringLiteral("cp_embedding_request_seconds"),
+                      QStringLiteral("Embedding request latency, one per batch"), labels)
+        .observe(seconds);
 }
@@ -25,11 +25,19 @@
 
 #include <QString>
 #include <QList>
+#include <QHash>
 #include <QMap>
 #include <QMutex>
+#include <QPointer>
+#include <QReadWriteLock>
 #include <memory>
 
+#include "AdaptiveConcurrencyLimiter.h"
+#include "ProviderRateLimiter.h"
+
 class ILLMBackend;
+class QFileSystemWatcher;
+struct LLMUsage;
 
 /**
  * @brief Thread-safe Singleton registry for managing LLM backend providers.
@@ -76,7 +84,8 @@ public:
      *
      * This method reads the accounts.json file using the same path logic as
      * LLMConnector::defaultAccountsFilePath() and searches for an account
-     * with a matching provider ID.
+     * with a matching provider ID. The files are parsed once and kept in memory
+     * until one of them changes on disk or saveCredentials() writes them.
      *
      * @param providerId The provider's unique identifier (e.g., "openai", "google").
      * @return The API key if found, or an empty QString if not found.
@@ -90,16 +99,70 @@ public:
      */
     bool saveCredentials(const QMap<QString, QString>& credentials);
 
+    /**
+     * @brief Drops the cached accounts.json keys; the next getCredential() reads the files again.
+     */
+    void invalidateCredentials();
+
     /**
      * @brief Helper for testing credential priority.
      */
     void setAnthropicKey(const QString& key);
 
+    /**
+     * @brief Runs the backend's warmUp() for a model on the global thread pool and returns at once.
+     *
+     * The credential is looked up there too, so nodes can call this from their own warmUp()
+     * at run start and the providers a graph uses get ready in parallel. Unknown providers
+     * are ignored.
+     */
+    void warmUpInBackground(const QString& providerId, const QString& modelId);
+
+    /**
+     * @brief Shared request/token budgets that every backend waits on before sending.
+     */
+    ProviderRateLimiter& rateLimiter() { return m_rateLimiter; }
+
+    /**
+     * @brief Adaptive in-flight limits per provider and model, learned from latency and throttling.
+     */
+    AdaptiveConcurrencyLimiter& concurrencyLimiter() { return m_concurrencyLimiter; }
+
+    /**
+     * @brief Adds the tokens a completion used to cp_llm_tokens in MetricsRegistry.
+     *
+     * The provider, model and token counts also go on the thread's current tracing span.
+     * Answers replayed from a cache should not be recorded; no tokens were spent on them.
+     */
+    static void recordUsage(const QString& providerId, const QString& modelId, const LLMUsage& usage);
+
+    /**
+     * @brief Adds one embedding request of @p texts inputs to cp_embedding_texts and
+     * cp_embedding_request_seconds in MetricsRegistry.
+     */
+    static void recordEmbeddings(const QString& providerId, qsizetype texts, double seconds, bool failed);
+
 private:
     LLMProviderRegistry() = default;
     ~LLMProviderRegistry() = default;
 
+    // accounts.json files getCredential() looks in, in priority order
+    static QStringList credentialFilePaths();
+    // Keys by lower-cased provider id; the first file naming a provider wins
+    static QHash<QString, QString> readCredentialFiles(const QStringList& paths);
+    // Invalidates the cache when a file changes, or appears in its directory
+    void watchCredentialFiles(const QStringList& paths);
+
     QMap<QString, std::shared_ptr<ILLMBackend>> m_backends;
     QString m_anthropicApiKey;
     QMutex m_mutex;
+
+    QReadWriteLock m_credentialLock;
+    bool m_credentialsLoaded {false};
+    quint64 m_credentialGeneration {0}; // bumped by each invalidation
+    QHash<QString, QString> m_fileCredentials;
+    // Lives on the application thread, which delivers its notifications
+    QPointer<QFileSystemWatcher> m_credentialWatcher;
+    ProviderRateLimiter m_rateLimiter;
+    AdaptiveConcurrencyLimiter m_concurrencyLimiter;
 };
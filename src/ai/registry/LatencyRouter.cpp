@@ -0,0 +1,196 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "LatencyRouter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "Logger.h"
+#include "LoggingCategories.h"
+#include "Tracer.h"
+#include "ai/backends/BackendCancellation.h"
+
+using ModelCapsTypes::ModelRoute;
+
+namespace {
+
+// How often the waiting caller checks its run for cancellation
+constexpr auto kCancellationCheck = std::chrono::milliseconds(200);
+
+// Shared with the attempt threads, which may outlive run() when they lose
+struct RouteRace {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::optional<LatencyRouter::Outcome> winner;
+    std::optional<LLMResult> lastFailure;
+    int running = 0;
+};
+
+} // namespace
+
+LatencyRouter::LatencyRouter(const AdaptiveConcurrencyLimiter& latencies, int defaultHedgeDelayMs)
+    : m_latencies(latencies)
+    , m_defaultHedgeDelayMs(defaultHedgeDelayMs)
+{
+}
+
+QList<ModelRoute> LatencyRouter::rank(const QList<ModelRoute>& routes) const
+{
+    std::vector<std::pair<int, ModelRoute>> measured;
+    QList<ModelRoute> ranked;
+    for (const ModelRoute& route : routes) {
+        const int p50 = m_latencies.snapshot(route.provider, route.model).p50Ms;
+        if (p50 > 0) {
+            measured.emplace_back(p50, route);
+        } else {
+            ranked.append(route);
+        }
+    }
+    std::stable_sort(measured.begin(), measured.end(),
+                     [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+    for (const auto& entry : measured) {
+        ranked.append(entry.second);
+    }
+    return ranked;
+}
+
+int LatencyRouter::hedgeDelayMs(const ModelRoute& route) const
+{
+    const int p95 = m_latencies.snapshot(route.provider, route.model).p95Ms;
+    return p95 > 0 ? std::max(p95, kMinHedgeDelayMs) : m_defaultHedgeDelayMs;
+}
+
+LatencyRouter::Outcome LatencyRouter::run(const QList<ModelRoute>& routes,
+                                          const Attempt& attempt,
+                                          const CancellationToken& cancellation) const
+{
+    using Clock = std::chrono::steady_clock;
+
+    const QList<ModelRoute> ranked = rank(routes);
+    if (ranked.isEmpty()) {
+        Outcome none;
+        none.result.hasError = true;
+        none.result.errorMsg = QStringLiteral("No routes to send the request to");
+        none.result.content = none.result.errorMsg;
+        return none;
+    }
+
+    auto race = std::make_shared<RouteRace>();
+    std::vector<CancellationToken> tokens;
+    int started = 0;
+    bool hedged = false;
+
+    const auto launch = [&](std::unique_lock<std::mutex>& lock) {
+        const ModelRoute route = ranked.at(started);
+        ++started;
+        const CancellationToken token = CancellationToken::create();
+        tokens.push_back(token);
+        hedged = hedged || race->running > 0;
+        ++race->running;
+        lock.unlock();
+        std::thread([race, attempt, route, token, tracingContext = Tracer::current()] {
+            const CancellationToken::Scope scope(token);
+            const Tracer::Scope tracingScope(tracingContext);
+            LLMResult result = attempt(route);
+            std::lock_guard guard(race->mutex);
+            --race->running;
+            if (!result.hasError && !race->winner) {
+                Outcome outcome;
+                outcome.result = std::move(result);
+                outcome.route = route;
+                race->winner = std::move(outcome);
+            } else if (result.hasError && !token.isCancelled()) {
+                CP_WARN.noquote() << QStringLiteral("LatencyRouter: route %1/%2 failed: %3")
+                                         .arg(route.provider, route.model, result.errorMsg);
+                race->lastFailure = std::move(result);
+            }
+            race->changed.notify_all();
+        }).detach();
+        lock.lock();
+        return Clock::now() + std::chrono::milliseconds(hedgeDelayMs(route));
+    };
+
+    std::unique_lock lock(race->mutex);
+    auto hedgeAt = launch(lock);
+    for (;;) {
+        if (race->winner) {
+            Outcome outcome = std::move(*race->winner);
+            outcome.attempts = started;
+            outcome.hedged = hedged;
+            lock.unlock();
+            for (const CancellationToken& token : tokens) {
+                token.cancel();
+            }
+            if (hedged || outcome.route != ranked.first()) {
+                CP_CLOG(cp_concurrency).noquote() << QStringLiteral("[Routing] answered by %1/%2 after %3 attempts")
+                                                         .arg(outcome.route.provider, outcome.route.model)
+                                                         .arg(started);
+            }
+            return outcome;
+        }
+        if (cancellation.isCancelled()) {
+            lock.unlock();
+            for (const CancellationToken& token : tokens) {
+                token.cancel();
+            }
+            Outcome cancelled;
+            cancelled.result.hasError = true;
+            cancelled.result.errorMsg = BackendCancellation::message();
+            cancelled.result.content = cancelled.result.errorMsg;
+            cancelled.attempts = started;
+            return cancelled;
+        }
+
+        const bool routesLeft = started < ranked.size();
+        if (race->running == 0) {
+            if (!routesLeft) {
+                Outcome failed;
+                failed.result = race->lastFailure.value_or(LLMResult{});
+                failed.route = ranked.last();
+                failed.attempts = started;
+                failed.hedged = hedged;
+                return failed;
+            }
+            // Fail over at once
+            hedgeAt = launch(lock);
+            continue;
+        }
+        if (routesLeft && race->running < kMaxParallelAttempts && Clock::now() >= hedgeAt) {
+            hedgeAt = launch(lock);
+            continue;
+        }
+
+        auto wake = Clock::now() + kCancellationCheck;
+        if (routesLeft) {
+            wake = std::min(wake, hedgeAt);
+        }
+        race->changed.wait_until(lock, wake);
+    }
+}
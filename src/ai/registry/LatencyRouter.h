@@ -0,0 +1,78 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QList>
+#include <QString>
+
+#include <functional>
+
+#include "CancellationToken.h"
+#include "ModelCaps.h"
+#include "ai/backends/ILLMBackend.h"
+#include "ai/registry/AdaptiveConcurrencyLimiter.h"
+
+// Sends one request over a routed virtual model's equivalent provider/model pairs.
+//
+// Routes are ranked by the recent p50 latency the AdaptiveConcurrencyLimiter has
+// measured for them. Routes with no measurements yet keep their catalog order and
+// come first, so each gets tried. The request goes to the best route. If that
+// route has not answered by its p95 latency, the request is hedged to the next one
+// and the first success wins. A failed attempt fails over to the next route
+// straight away. The losing attempt is cancelled. At most kMaxParallelAttempts
+// run at once.
+class LatencyRouter {
+public:
+    static constexpr int kMaxParallelAttempts = 2;
+    // Hedge delay for a route without a p95 yet, and the floor for measured ones
+    static constexpr int kDefaultHedgeDelayMs = 5000;
+    static constexpr int kMinHedgeDelayMs = 250;
+
+    // Sends the request to one route; runs on its own thread with its own
+    // CancellationToken current, which is cancelled when another attempt wins
+    using Attempt = std::function<LLMResult(const ModelCapsTypes::ModelRoute& route)>;
+
+    struct Outcome {
+        LLMResult result;
+        ModelCapsTypes::ModelRoute route;
+        int attempts = 0;
+        bool hedged = false; // a second attempt started while the first was running
+    };
+
+    explicit LatencyRouter(const AdaptiveConcurrencyLimiter& latencies,
+                           int defaultHedgeDelayMs = kDefaultHedgeDelayMs);
+
+    QList<ModelCapsTypes::ModelRoute> rank(const QList<ModelCapsTypes::ModelRoute>& routes) const;
+    int hedgeDelayMs(const ModelCapsTypes::ModelRoute& route) const;
+
+    // Blocks until an attempt succeeds, every route has failed, or the run is cancelled.
+    // The attempt is copied to each thread, so it must own what it captures.
+    Outcome run(const QList<ModelCapsTypes::ModelRoute>& routes,
+                const Attempt& attempt,
+                const CancellationToken& cancellation = CancellationToken::current()) const;
+
+private:
+    const AdaptiveConcurrencyLimiter& m_latencies;
+    const int m_defaultHedgeDelayMs;
+};
@@ -0,0 +1,267 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "ProviderRateLimiter.h"
+
+#include "ModelCapsRegistry.h"
+
+#include <QDeadlineTimer>
+
+#include <algorithm>
+
+using ModelCapsTypes::RateLimit;
+
+namespace {
+
+// Waiting callers wake at least this often to notice cancellation
+constexpr auto kPollInterval = std::chrono::milliseconds(200);
+
+QString overrideKey(const QString& providerId, const QString& modelId)
+{
+    return providerId + QLatin1Char('\n') + modelId;
+}
+
+} // namespace
+
+void ProviderRateLimiter::Bucket::configure(int perMinute, Clock::time_point now)
+{
+    const double newCapacity = perMinute > 0 ? static_cast<double>(perMinute) : 0.0;
+    if (newCapacity == capacity) {
+        return;
+    }
+    // A new bucket starts full; a resized one keeps what it had, up to the new size
+    available = limited() ? std::min(available, newCapacity) : newCapacity;
+    capacity = newCapacity;
+    refilled = now;
+}
+
+void ProviderRateLimiter::Bucket::refill(Clock::time_point now)
+{
+    if (!limited() || now <= refilled) {
+        return;
+    }
+    const double minutes = std::chrono::duration<double, std::ratio<60>>(now - refilled).count();
+    available = std::min(capacity, available + minutes * capacity);
+    refilled = now;
+}
+
+ProviderRateLimiter::Clock::duration ProviderRateLimiter::Bucket::waitFor(double amount) const
+{
+    if (!limited() || available >= amount) {
+        return Clock::duration::zero();
+    }
+    const std::chrono::duration<double, std::ratio<60>> minutes((amount - available) / capacity);
+    return std::chrono::duration_cast<Clock::duration>(minutes) + Clock::duration(1);
+}
+
+void ProviderRateLimiter::Permit::settle(int actualTokens)
+{
+    if (!m_granted || !m_limiter || actualTokens <= 0) {
+        return;
+    }
+    m_limiter->release(m_providerId, m_modelId, m_reservedTokens, actualTokens);
+    m_reservedTokens = actualTokens;
+}
+
+bool ProviderRateLimiter::Permit::retryAfter(int retryAfterMs, const CancellationToken& cancellation)
+{
+    if (!m_limiter) {
+        return false;
+    }
+    ProviderRateLimiter* limiter = m_limiter;
+    reject(retryAfterMs);
+    *this = limiter->acquire(m_providerId, m_modelId, m_reservedTokens, cancellation);
+    m_limiter = limiter;
+    return m_granted;
+}
+
+void ProviderRateLimiter::Permit::reject(int retryAfterMs)
+{
+    if (!m_limiter) {
+        return;
+    }
+    // The rejected request consumed nothing, so its tokens go back
+    if (m_granted) {
+        m_limiter->release(m_providerId, m_modelId, m_reservedTokens, 0);
+        m_granted = false;
+    }
+    m_limiter->pause(m_providerId, retryAfterMs);
+}
+
+int ProviderRateLimiter::estimateTokens(qsizetype promptChars, int maxOutputTokens)
+{
+    const qsizetype promptTokens = promptChars / 4 + 1;
+    return static_cast<int>(std::min<qsizetype>(promptTokens, 1 << 30)) + std::max(0, maxOutputTokens);
+}
+
+RateLimit ProviderRateLimiter::limitFor(const QString& providerId, const QString& modelId) const
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto it = m_overrides.find(overrideKey(providerId, modelId));
+        if (it != m_overrides.end()) {
+            return it->second;
+        }
+    }
+
+    const auto settings = ModelCapsRegistry::instance().providerSettings(providerId);
+    if (!settings) {
+        return {};
+    }
+    return modelId.isEmpty() ? settings->rateLimit : settings->modelRateLimits.value(modelId);
+}
+
+void ProviderRateLimiter::setLimitOverride(const QString& providerId,
+                                           const QString& modelId,
+                                           const RateLimit& limit)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_overrides[overrideKey(providerId, modelId)] = limit;
+}
+
+void ProviderRateLimiter::clearOverrides()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_overrides.clear();
+}
+
+ProviderRateLimiter::Permit ProviderRateLimiter::acquire(const QString& providerId,
+                                                         const QString& modelId,
+                                                         int estimatedTokens,
+                                                         const CancellationToken& cancellation)
+{
+    const RateLimit providerLimit = limitFor(providerId, QString());
+    const RateLimit modelLimit = modelId.isEmpty() ? RateLimit{} : limitFor(providerId, modelId);
+
+    Permit permit;
+    permit.m_limiter = this;
+    permit.m_providerId = providerId;
+    permit.m_modelId = modelId;
+    permit.m_reservedTokens = std::max(0, estimatedTokens);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    Lane& lane = m_lanes[providerId];
+    Clock::time_point now = Clock::now();
+    if (providerLimit.isUnlimited() && modelLimit.isUnlimited() && lane.queue.empty() && lane.pausedUntil <= now) {
+        permit.m_granted = true;
+        return permit;
+    }
+
+    lane.provider.requests.configure(providerLimit.requestsPerMinute, now);
+    lane.provider.tokens.configure(providerLimit.tokensPerMinute, now);
+    Budget* modelBudget = nullptr;
+    if (!modelLimit.isUnlimited()) {
+        modelBudget = &lane.models[modelId];
+        modelBudget->requests.configure(modelLimit.requestsPerMinute, now);
+        modelBudget->tokens.configure(modelLimit.tokensPerMinute, now);
+    }
+
+    // A caller due sooner, such as an interactive run behind a batch, goes ahead
+    const Waiter waiter{cancellation.dueBy(QDeadlineTimer::current().deadline()), lane.nextTicket++};
+    lane.queue.insert(waiter);
+    m_changed.notify_all();
+    for (;;) {
+        if (cancellation.isCancelled()) {
+            lane.queue.erase(waiter);
+            m_changed.notify_all();
+            return Permit{};
+        }
+
+        Clock::duration wait = kPollInterval;
+        if (*lane.queue.begin() == waiter) {
+            now = Clock::now();
+            Clock::duration needed = lane.pausedUntil > now ? lane.pausedUntil - now : Clock::duration::zero();
+            for (Budget* budget : {&lane.provider, modelBudget}) {
+                if (!budget) {
+                    continue;
+                }
+                budget->requests.refill(now);
+                budget->tokens.refill(now);
+                // A request larger than the whole bucket waits for a full bucket
+                const double tokens = std::min<double>(permit.m_reservedTokens, budget->tokens.capacity);
+                needed = std::max({needed, budget->requests.waitFor(1.0), budget->tokens.waitFor(tokens)});
+            }
+
+            if (needed == Clock::duration::zero()) {
+                for (Budget* budget : {&lane.provider, modelBudget}) {
+                    if (!budget) {
+                        continue;
+                    }
+                    if (budget->requests.limited()) {
+                        budget->requests.available -= 1.0;
+                    }
+                    if (budget->tokens.limited()) {
+                        budget->tokens.available -= permit.m_reservedTokens;
+                    }
+                }
+                lane.queue.erase(lane.queue.begin());
+                m_changed.notify_all();
+                permit.m_granted = true;
+                return permit;
+            }
+            wait = std::min(wait, needed);
+        }
+        m_changed.wait_for(lock, wait);
+    }
+}
+
+void ProviderRateLimiter::release(const QString& providerId,
+                                  const QString& modelId,
+                                  int reservedTokens,
+                                  int actualTokens)
+{
+    const double refund = static_cast<double>(reservedTokens) - actualTokens;
+    if (refund == 0.0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto lane = m_lanes.find(providerId);
+    if (lane == m_lanes.end()) {
+        return;
+    }
+    const auto returnTokens = [&](Bucket& bucket) {
+        // Under-estimates leave the bucket in debt until it refills
+        if (bucket.limited()) {
+            bucket.refill(Clock::now());
+            bucket.available = std::min(bucket.capacity, bucket.available + refund);
+        }
+    };
+    returnTokens(lane->second.provider.tokens);
+    const auto model = lane->second.models.find(modelId);
+    if (model != lane->second.models.end()) {
+        returnTokens(model->second.tokens);
+    }
+    m_changed.notify_all();
+}
+
+void ProviderRateLimiter::pause(const QString& providerId, int milliseconds)
+{
+    if (milliseconds <= 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Lane& lane = m_lanes[providerId];
+    lane.pausedUntil = std::max(lane.pausedUntil, Clock::now() + std::chrono::milliseconds(milliseconds));
+    m_changed.notify_all();
+}
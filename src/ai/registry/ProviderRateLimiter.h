@@ -0,0 +1,144 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QString>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <utility>
+
+#include "CancellationToken.h"
+#include "ModelCaps.h"
+
+// Shared request and token budgets per provider, consulted by every backend
+// before it sends a chat or embedding request.
+//
+// Each provider has a token bucket for requests per minute and one for tokens
+// per minute, plus optional buckets per model, sized from the provider's
+// "rateLimits" entry in the model catalog. Buckets start full and refill
+// continuously, so sustained throughput settles at the configured limit. Callers
+// wait in one queue per provider ordered by when their run is due
+// (CancellationToken::dueBy(), arrival order among equals): the head of the queue
+// is served as soon as every bucket it needs has room, and only a caller due
+// sooner can move ahead of it. A
+// request reserves its estimated tokens up front; settle() corrects the token
+// bucket once the provider has reported actual usage. When a provider answers
+// with a rate-limit error, pause() holds the whole queue until Retry-After.
+class ProviderRateLimiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    class Permit {
+    public:
+        Permit() = default;
+
+        // False only when the caller was cancelled while waiting
+        explicit operator bool() const { return m_granted; }
+
+        // Replaces the reserved estimate with the tokens the request actually used
+        void settle(int actualTokens);
+
+        // Holds the provider's queue for retryAfterMs, then waits for a fresh slot
+        // for the same request. Returns false if cancelled while waiting.
+        bool retryAfter(int retryAfterMs, const CancellationToken& cancellation);
+
+        // Gives up the request after a rate-limit answer: hands its tokens back and
+        // holds the provider's queue for retryAfterMs without waiting here
+        void reject(int retryAfterMs);
+
+    private:
+        friend class ProviderRateLimiter;
+
+        ProviderRateLimiter* m_limiter = nullptr;
+        QString m_providerId;
+        QString m_modelId;
+        int m_reservedTokens = 0;
+        bool m_granted = false;
+    };
+
+    ProviderRateLimiter() = default;
+    ProviderRateLimiter(const ProviderRateLimiter&) = delete;
+    ProviderRateLimiter& operator=(const ProviderRateLimiter&) = delete;
+
+    // Rough token count for a request: prompt text at four characters per token
+    // plus the completion budget.
+    static int estimateTokens(qsizetype promptChars, int maxOutputTokens = 0);
+
+    // Blocks until the provider (and model) budgets admit a request of
+    // estimatedTokens, or the caller is cancelled.
+    Permit acquire(const QString& providerId,
+                   const QString& modelId,
+                   int estimatedTokens,
+                   const CancellationToken& cancellation = CancellationToken::current());
+
+    void pause(const QString& providerId, int milliseconds);
+
+    // Overrides the catalog limits for a provider (empty modelId) or one model.
+    // Mainly for tests; clearOverrides() returns to the catalog.
+    void setLimitOverride(const QString& providerId, const QString& modelId, const ModelCapsTypes::RateLimit& limit);
+    void clearOverrides();
+
+    ModelCapsTypes::RateLimit limitFor(const QString& providerId, const QString& modelId) const;
+
+private:
+    struct Bucket {
+        double capacity = 0.0;
+        double available = 0.0;
+        Clock::time_point refilled;
+
+        void configure(int perMinute, Clock::time_point now);
+        void refill(Clock::time_point now);
+        bool limited() const { return capacity > 0.0; }
+        // Time until `amount` is available; zero when it already is
+        Clock::duration waitFor(double amount) const;
+    };
+
+    struct Budget {
+        Bucket requests;
+        Bucket tokens;
+    };
+
+    // Due time and arrival ticket of a waiting caller
+    using Waiter = std::pair<std::int64_t, std::uint64_t>;
+
+    struct Lane {
+        std::set<Waiter> queue;
+        std::uint64_t nextTicket = 0;
+        Clock::time_point pausedUntil;
+        Budget provider;
+        std::map<QString, Budget> models;
+    };
+
+    void release(const QString& providerId, const QString& modelId, int reservedTokens, int actualTokens);
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::map<QString, Lane> m_lanes;
+    std::map<QString, ModelCapsTypes::RateLimit> m_overrides;
+};
@@ -0,0 +1,342 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "DebugLogModel.h"
+
+#include "RotatingLogFile.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QStandardPaths>
+#include <QtConcurrent>
+
+#include <utility>
+
+namespace {
+
+// Lines matched between checks for a newer filter
+constexpr int kFilterCheckInterval = 4096;
+
+} // namespace
+
+struct DebugLogModel::FileWriter {
+    explicit FileWriter(const QString& path)
+        : file(path)
+    {
+    }
+
+    RotatingLogFile file;
+    // Warned once; the warning would otherwise come back through the log every batch
+    bool failed {false};
+};
+
+DebugLogModel::DebugLogModel(int capacity, QObject* parent)
+    : QAbstractListModel(parent)
+    , m_capacity(qMax(1, capacity))
+    , m_ring(static_cast<std::size_t>(m_capacity))
+    , m_filterGeneration(std::make_shared<std::atomic<quint64>>(0))
+{
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(kFlushIntervalMs);
+    connect(&m_flushTimer, &QTimer::timeout, this, &DebugLogModel::flush);
+
+    m_filterPool.setMaxThreadCount(1);
+    m_filePool.setMaxThreadCount(1);
+    connect(&m_filterWatcher, &QFutureWatcher<FilterResult>::finished, this, &DebugLogModel::onFilterFinished);
+}
+
+DebugLogModel::~DebugLogModel()
+{
+    m_filterGeneration->fetch_add(1);
+    m_filterWatcher.waitForFinished();
+    if (m_fileWriter && !m_pending.isEmpty()) {
+        auto writer = m_fileWriter;
+        m_filePool.start([writer, lines = std::exchange(m_pending, QStringList())]() {
+            writer->file.append(lines);
+        });
+    }
+    m_filePool.waitForDone();
+}
+
+int DebugLogModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return m_appliedFilter.isEmpty() ? m_size : static_cast<int>(m_matches.size());
+}
+
+QVariant DebugLogModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= rowCount() || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    const qint64 sequence = m_appliedFilter.isEmpty() ? m_firstSequence + index.row()
+                                                      : m_matches[static_cast<std::size_t>(index.row())];
+    return lineAt(sequence);
+}
+
+const QString& DebugLogModel::lineAt(qint64 sequence) const
+{
+    const qint64 offset = sequence - m_firstSequence;
+    return m_ring[static_cast<std::size_t>((m_head + offset) % m_capacity)];
+}
+
+bool DebugLogModel::matches(const QString& line, const QString& filter) const
+{
+    return line.contains(filter, Qt::CaseInsensitive);
+}
+
+void DebugLogModel::append(const QString& line)
+{
+    m_pending.append(line);
+    if (!m_flushTimer.isActive()) {
+        m_flushTimer.start();
+    }
+}
+
+void DebugLogModel::append(const QStringList& lines)
+{
+    m_pending.append(lines);
+    if (!m_flushTimer.isActive()) {
+        m_flushTimer.start();
+    }
+}
+
+void DebugLogModel::flush()
+{
+    m_flushTimer.stop();
+    if (m_pending.isEmpty()) {
+        return;
+    }
+    QStringList batch = std::exchange(m_pending, QStringList());
+    if (m_fileWriter) {
+        m_filePool.start([writer = m_fileWriter, batch]() {
+            if (!writer->file.append(batch) && !writer->failed) {
+                writer->failed = true;
+                qWarning().noquote() << QStringLiteral("DebugLogModel: cannot write %1: %2")
+                                            .arg(writer->file.path(), writer->file.errorString());
+            }
+        });
+    }
+    insertLines(batch);
+}
+
+void DebugLogModel::insertLines(const QStringList& lines)
+{
+    // Lines beyond a whole ring's worth would fall out straight away
+    const int skipped = qMax(0, static_cast<int>(lines.size()) - m_capacity);
+    const int incoming = static_cast<int>(lines.size()) - skipped;
+    const int evicted = qMax(0, m_size + incoming - m_capacity);
+    const bool filtered = !m_appliedFilter.isEmpty();
+
+    if (evicted > 0) {
+        const qint64 newFirst = m_firstSequence + evicted;
+        if (!filtered) {
+            beginRemoveRows(QModelIndex(), 0, evicted - 1);
+        }
+        int removedMatches = 0;
+        if (filtered) {
+            while (removedMatches < static_cast<int>(m_matches.size())
+                   && m_matches[static_cast<std::size_t>(removedMatches)] < newFirst) {
+                ++removedMatches;
+            }
+            if (removedMatches > 0) {
+                beginRemoveRows(QModelIndex(), 0, removedMatches - 1);
+                m_matches.erase(m_matches.begin(), m_matches.begin() + removedMatches);
+            }
+        }
+        for (int i = 0; i < evicted; ++i) {
+            m_ring[static_cast<std::size_t>((m_head + i) % m_capacity)].clear();
+        }
+        m_head = (m_head + evicted) % m_capacity;
+        m_size -= evicted;
+        m_firstSequence = newFirst;
+        if (!filtered || removedMatches > 0) {
+            endRemoveRows();
+        }
+    }
+    m_firstSequence += skipped;
+    m_dropped += evicted + skipped;
+
+    if (incoming == 0) {
+        return;
+    }
+    const qint64 firstNew = m_firstSequence + m_size;
+    std::vector<qint64> newMatches;
+    if (filtered) {
+        for (int i = 0; i < incoming; ++i) {
+            if (matches(lines.at(skipped + i), m_appliedFilter)) {
+                newMatches.push_back(firstNew + i);
+            }
+        }
+    } else {
+        beginInsertRows(QModelIndex(), m_size, m_size + incoming - 1);
+    }
+    for (int i = 0; i < incoming; ++i) {
+        m_ring[static_cast<std::size_t>((m_head + m_size + i) % m_capacity)] = lines.at(skipped + i);
+    }
+    m_size += incoming;
+    if (!filtered) {
+        endInsertRows();
+    } else if (!newMatches.empty()) {
+        const int row = static_cast<int>(m_matches.size());
+        beginInsertRows(QModelIndex(), row, row + static_cast<int>(newMatches.size()) - 1);
+        m_matches.insert(m_matches.end(), newMatches.begin(), newMatches.end());
+        endInsertRows();
+    }
+}
+
+void DebugLogModel::clear()
+{
+    beginResetModel();
+    m_pending.clear();
+    m_flushTimer.stop();
+    for (QString& line : m_ring) {
+        line.clear();
+    }
+    m_firstSequence += m_size;
+    m_head = 0;
+    m_size = 0;
+    m_dropped = 0;
+    m_matches.clear();
+    // A match still running was against lines that are gone
+    m_filterGeneration->fetch_add(1);
+    m_appliedFilter = m_filter;
+    endResetModel();
+}
+
+void DebugLogModel::setFilter(const QString& text)
+{
+    m_filter = text;
+    const quint64 generation = m_filterGeneration->fetch_add(1) + 1;
+    if (text.isEmpty()) {
+        beginResetModel();
+        m_appliedFilter.clear();
+        m_matches.clear();
+        endResetModel();
+        emit filterApplied(m_size);
+        return;
+    }
+
+    // Copies share the strings, so the snapshot is one pointer per line
+    QStringList snapshot;
+    snapshot.reserve(m_size);
+    for (int i = 0; i < m_size; ++i) {
+        snapshot.append(lineAt(m_firstSequence + i));
+    }
+    const qint64 first = m_firstSequence;
+    auto latest = m_filterGeneration;
+    m_filterWatcher.setFuture(QtConcurrent::run(&m_filterPool, [snapshot, first, text, generation, latest]() {
+        FilterResult result;
+        result.filter = text;
+        result.generation = generation;
+        result.snapshotEnd = first + snapshot.size();
+        for (qsizetype i = 0; i < snapshot.size(); ++i) {
+            if (i % kFilterCheckInterval == 0 && latest->load() != generation) {
+                return result;
+            }
+            if (snapshot.at(i).contains(text, Qt::CaseInsensitive)) {
+                result.matches.push_back(first + i);
+            }
+        }
+        return result;
+    }));
+}
+
+void DebugLogModel::onFilterFinished()
+{
+    const FilterResult result = m_filterWatcher.result();
+    if (result.generation != m_filterGeneration->load() || result.generation == m_appliedGeneration) {
+        return;
+    }
+
+    beginResetModel();
+    m_appliedGeneration = result.generation;
+    m_appliedFilter = result.filter;
+    m_matches.clear();
+    for (const qint64 sequence : result.matches) {
+        if (sequence >= m_firstSequence) {
+            m_matches.push_back(sequence);
+        }
+    }
+    // Lines that arrived while the worker was matching
+    const qint64 end = m_firstSequence + m_size;
+    for (qint64 sequence = qMax(result.snapshotEnd, m_firstSequence); sequence < end; ++sequence) {
+        if (matches(lineAt(sequence), m_appliedFilter)) {
+            m_matches.push_back(sequence);
+        }
+    }
+    endResetModel();
+    emit filterApplied(static_cast<int>(m_matches.size()));
+}
+
+void DebugLogModel::waitForFilter()
+{
+    m_filterWatcher.waitForFinished();
+    if (m_filterWatcher.isFinished() && m_filterWatcher.future().resultCount() > 0) {
+        onFilterFinished();
+    }
+}
+
+void DebugLogModel::setLogFile(const QString& path)
+{
+    if (path.isEmpty()) {
+        m_fileWriter.reset();
+        return;
+    }
+    if (!m_fileWriter || m_fileWriter->file.path() != path) {
+        // Batches already queued finish on the file they were queued for
+        m_fileWriter = std::make_shared<FileWriter>(path);
+    }
+}
+
+QString DebugLogModel::logFile() const
+{
+    return m_fileWriter ? m_fileWriter->file.path() : QString();
+}
+
+void DebugLogModel::waitForLogFile()
+{
+    m_filePool.waitForDone();
+}
+
+QStringList DebugLogModel::visibleLines() const
+{
+    QStringList lines;
+    const int rows = rowCount();
+    lines.reserve(rows);
+    for (int row = 0; row < rows; ++row) {
+        lines.append(data(index(row), Qt::DisplayRole).toString());
+    }
+    return lines;
+}
+
+QString DebugLogModel::defaultLogFilePath()
+{
+    QString base = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    if (base.isEmpty()) {
+        base = QDir::tempPath();
+    }
+    return QDir(base).filePath(QStringLiteral("logs/debug.log"));
+}
@@ -0,0 +1,130 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QAbstractListModel>
+#include <QFutureWatcher>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+// Lines for the Debug Log dock, held in a ring buffer of fixed capacity so a long run
+// keeps a bounded number of lines however much it logs; the oldest fall out first.
+// append() only queues a line. Queued lines reach the model every kFlushIntervalMs
+// as one row insertion (and one removal for what fell out), so a burst of logging
+// costs the view a single update. A filter is matched against a snapshot of the ring
+// on a worker thread and swapped in when done; lines arriving meanwhile are matched
+// as they come. With a log file set, every line, including those that have since
+// left the ring, is appended to a rotating file on a writer thread.
+class DebugLogModel : public QAbstractListModel {
+    Q_OBJECT
+public:
+    static constexpr int kDefaultCapacity = 20000;
+    static constexpr int kFlushIntervalMs = 100;
+
+    explicit DebugLogModel(int capacity = kDefaultCapacity, QObject* parent = nullptr);
+    ~DebugLogModel() override;
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    int capacity() const { return m_capacity; }
+    // Lines in the ring, whether the filter shows them or not
+    int lineCount() const { return m_size; }
+    // Lines that fell out of the ring since the last clear()
+    qint64 droppedLines() const { return m_dropped; }
+
+    void append(const QString& line);
+    void append(const QStringList& lines);
+    // Applies queued lines now instead of on the next tick
+    void flush();
+    void clear();
+
+    // Case-insensitive substring; empty shows every line
+    void setFilter(const QString& text);
+    QString filter() const { return m_filter; }
+    // Whether a filter is still being matched on the worker thread
+    bool isFiltering() const { return m_filterWatcher.isRunning(); }
+    void waitForFilter();
+
+    // Appends every line to a rotating file at path; empty turns it off
+    void setLogFile(const QString& path);
+    QString logFile() const;
+    // Blocks until queued file writes are done
+    void waitForLogFile();
+
+    // Text of the rows shown, e.g. for copying
+    QStringList visibleLines() const;
+    // Log file used when CP_DEBUG_LOG_FILE is unset: AppLocalDataLocation/logs/debug.log
+    static QString defaultLogFilePath();
+
+signals:
+    // Emitted when a filter has been applied; matches is the number of rows shown
+    void filterApplied(int matches);
+
+private:
+    struct FileWriter;
+    struct FilterResult {
+        QString filter;
+        quint64 generation {0};
+        qint64 snapshotEnd {0};
+        std::vector<qint64> matches;
+    };
+
+    const QString& lineAt(qint64 sequence) const;
+    bool matches(const QString& line, const QString& filter) const;
+    void insertLines(const QStringList& lines);
+    void onFilterFinished();
+
+    int m_capacity;
+    std::vector<QString> m_ring;
+    int m_head {0};
+    int m_size {0};
+    // Sequence number of the oldest line in the ring
+    qint64 m_firstSequence {0};
+    qint64 m_dropped {0};
+
+    QStringList m_pending;
+    QTimer m_flushTimer;
+
+    // m_filter is requested; m_appliedFilter is what the rows show
+    QString m_filter;
+    QString m_appliedFilter;
+    std::deque<qint64> m_matches;
+    // Bumped for every filter request; a superseded match gives up early
+    std::shared_ptr<std::atomic<quint64>> m_filterGeneration;
+    quint64 m_appliedGeneration {0};
+    QThreadPool m_filterPool;
+    QFutureWatcher<FilterResult> m_filterWatcher;
+
+    // One thread, so batches reach the file in order
+    QThreadPool m_filePool;
+    std::shared_ptr<FileWriter> m_fileWriter;
+};
@@ -0,0 +1,175 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "DebugLogView.h"
+#include "DebugLogModel.h"
+#include "RotatingLogFile.h"
+
+#include <QAction>
+#include <QApplication>
+#include <QCheckBox>
+#include <QClipboard>
+#include <QFontDatabase>
+#include <QHBoxLayout>
+#include <QItemSelectionModel>
+#include <QLabel>
+#include <QLineEdit>
+#include <QListView>
+#include <QPushButton>
+#include <QScrollBar>
+#include <QTimer>
+#include <QVBoxLayout>
+
+#include <algorithm>
+
+namespace {
+
+constexpr int kFilterDebounceMs = 250;
+
+} // namespace
+
+DebugLogView::DebugLogView(QWidget* parent)
+    : QWidget(parent)
+    , m_model(new DebugLogModel(DebugLogModel::kDefaultCapacity, this))
+{
+    auto* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(2, 2, 2, 2);
+    layout->setSpacing(2);
+
+    auto* bar = new QHBoxLayout();
+    m_filterEdit = new QLineEdit(this);
+    m_filterEdit->setPlaceholderText(tr("Filter (case-insensitive)"));
+    m_filterEdit->setClearButtonEnabled(true);
+    bar->addWidget(m_filterEdit, 1);
+    m_followCheck = new QCheckBox(tr("Follow"), this);
+    m_followCheck->setChecked(true);
+    bar->addWidget(m_followCheck);
+    m_logToFileCheck = new QCheckBox(tr("Write to file"), this);
+    bar->addWidget(m_logToFileCheck);
+    auto* clearButton = new QPushButton(tr("Clear"), this);
+    bar->addWidget(clearButton);
+    m_statusLabel = new QLabel(this);
+    bar->addWidget(m_statusLabel);
+    layout->addLayout(bar);
+
+    m_view = new QListView(this);
+    m_view->setModel(m_model);
+    m_view->setUniformItemSizes(true);
+    m_view->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    m_view->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_view->setTextElideMode(Qt::ElideNone);
+    m_view->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+    m_view->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    layout->addWidget(m_view, 1);
+
+    auto* copyAction = new QAction(tr("Copy"), m_view);
+    copyAction->setShortcut(QKeySequence::Copy);
+    copyAction->setShortcutContext(Qt::WidgetShortcut);
+    m_view->addAction(copyAction);
+    m_view->setContextMenuPolicy(Qt::ActionsContextMenu);
+    connect(copyAction, &QAction::triggered, this, &DebugLogView::copySelection);
+
+    m_filterDebounce = new QTimer(this);
+    m_filterDebounce->setSingleShot(true);
+    m_filterDebounce->setInterval(kFilterDebounceMs);
+    connect(m_filterEdit, &QLineEdit::textChanged, m_filterDebounce, qOverload<>(&QTimer::start));
+    connect(m_filterDebounce, &QTimer::timeout, this, [this]() {
+        m_model->setFilter(m_filterEdit->text());
+        updateStatus();
+    });
+
+    connect(m_model, &QAbstractItemModel::rowsInserted, this, &DebugLogView::onRowsInserted);
+    connect(m_model, &QAbstractItemModel::rowsRemoved, this, &DebugLogView::updateStatus);
+    connect(m_model, &DebugLogModel::filterApplied, this, &DebugLogView::onFilterApplied);
+    connect(m_logToFileCheck, &QCheckBox::toggled, this, &DebugLogView::onLogToFileToggled);
+    connect(clearButton, &QPushButton::clicked, this, [this]() {
+        m_model->clear();
+        updateStatus();
+    });
+
+    const QString envPath = qEnvironmentVariable("CP_DEBUG_LOG_FILE");
+    m_logFilePath = envPath.isEmpty() ? DebugLogModel::defaultLogFilePath() : envPath;
+    m_logToFileCheck->setToolTip(tr("Append every line to %1, rotated at %2 MiB")
+                                     .arg(m_logFilePath)
+                                     .arg(RotatingLogFile::kDefaultMaxBytes / (1024 * 1024)));
+    m_logToFileCheck->setChecked(!envPath.isEmpty());
+    updateStatus();
+}
+
+void DebugLogView::appendLine(const QString& line)
+{
+    m_model->append(line);
+}
+
+void DebugLogView::appendLines(const QStringList& lines)
+{
+    m_model->append(lines);
+}
+
+void DebugLogView::onRowsInserted()
+{
+    if (m_followCheck->isChecked()) {
+        m_view->scrollToBottom();
+    }
+    updateStatus();
+}
+
+void DebugLogView::onFilterApplied(int matches)
+{
+    Q_UNUSED(matches);
+    if (m_followCheck->isChecked()) {
+        m_view->scrollToBottom();
+    }
+    updateStatus();
+}
+
+void DebugLogView::onLogToFileToggled(bool enabled)
+{
+    m_model->setLogFile(enabled ? m_logFilePath : QString());
+}
+
+void DebugLogView::copySelection()
+{
+    QModelIndexList rows = m_view->selectionModel()->selectedRows();
+    std::sort(rows.begin(), rows.end(), [](const QModelIndex& a, const QModelIndex& b) { return a.row() < b.row(); });
+    QStringList lines;
+    lines.reserve(rows.size());
+    for (const QModelIndex& row : rows) {
+        lines.append(row.data().toString());
+    }
+    QApplication::clipboard()->setText(lines.join(QLatin1Char('\n')));
+}
+
+void DebugLogView::updateStatus()
+{
+    QString status = m_model->filter().isEmpty()
+        ? tr("%1 lines").arg(m_model->lineCount())
+        : tr("%1 of %2 lines").arg(m_model->rowCount()).arg(m_model->lineCount());
+    if (m_model->isFiltering()) {
+        status += tr(" (filtering...)");
+    }
+    if (m_model->droppedLines() > 0) {
+        status += tr(", %1 older dropped").arg(m_model->droppedLines());
+    }
+    m_statusLabel->setText(status);
+}
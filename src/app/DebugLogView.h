@@ -0,0 +1,67 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QStringList>
+#include <QWidget>
+
+class DebugLogModel;
+class QCheckBox;
+class QLabel;
+class QLineEdit;
+class QListView;
+class QTimer;
+
+// Contents of the Debug Log dock: a DebugLogModel in a list view with uniform row
+// heights, so only the rows on screen are laid out however many lines are held.
+// The filter box is debounced and matched off the GUI thread by the model.
+// "Follow" keeps the newest line in view; "Write to file" appends every line to
+// the rotating log file (CP_DEBUG_LOG_FILE, when set, turns it on at that path).
+class DebugLogView : public QWidget {
+    Q_OBJECT
+public:
+    explicit DebugLogView(QWidget* parent = nullptr);
+
+    DebugLogModel* model() const { return m_model; }
+    void appendLine(const QString& line);
+    void appendLines(const QStringList& lines);
+
+private slots:
+    void onRowsInserted();
+    void onFilterApplied(int matches);
+    void onLogToFileToggled(bool enabled);
+    void copySelection();
+
+private:
+    void updateStatus();
+
+    DebugLogModel* m_model {nullptr};
+    QListView* m_view {nullptr};
+    QLineEdit* m_filterEdit {nullptr};
+    QTimer* m_filterDebounce {nullptr};
+    QCheckBox* m_followCheck {nullptr};
+    QCheckBox* m_logToFileCheck {nullptr};
+    QLabel* m_statusLabel {nullptr};
+    QString m_logFilePath;
+};
@@ -0,0 +1,91 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "HeadlessMain.h"
+
+#include <QCoreApplication>
+#include <QTextStream>
+
+#include "HeadlessRunner.h"
+#include "MermaidRenderer.h"
+#include "RagIndexServer.h"
+#include "RemoteWorkerServer.h"
+#include "StartupProfiler.h"
+
+bool HeadlessMain::isRequested(int argc, char* argv[])
+{
+    return RemoteWorkerServer::isRequested(argc, argv) || RagIndexServer::isRequested(argc, argv)
+        || HeadlessRunner::isRequested(argc, argv);
+}
+
+void HeadlessMain::preparePlatform()
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+}
+
+int HeadlessMain::exec(int argc, char* argv[], StartupProfiler& profiler)
+{
+    const QStringList arguments = QCoreApplication::arguments().mid(1);
+
+    if (RemoteWorkerServer::isRequested(argc, argv)) {
+        RemoteWorkerServer::Options options;
+        const QString error = RemoteWorkerServer::parseArguments(arguments, options);
+        if (!error.isEmpty()) {
+            QTextStream(stderr) << error << "\n\n" << RemoteWorkerServer::usage();
+            return RemoteWorkerServer::kExitUsage;
+        }
+        MermaidRenderer::setHeadless(true);
+        RemoteWorkerServer server(std::move(options));
+        profiler.mark(QStringLiteral("Remote worker"));
+        profiler.logSummary();
+        return server.exec();
+    }
+
+    if (RagIndexServer::isRequested(argc, argv)) {
+        RagIndexServer::Config config;
+        const QString error = RagIndexServer::parseArguments(arguments, config);
+        if (!error.isEmpty()) {
+            QTextStream(stderr) << error << "\n\n" << RagIndexServer::usage();
+            return RagIndexServer::kExitUsage;
+        }
+        RagIndexServer server(std::move(config));
+        profiler.mark(QStringLiteral("Retrieval daemon"));
+        profiler.logSummary();
+        return server.exec();
+    }
+
+    HeadlessRunner::Options options;
+    const QString error = HeadlessRunner::parseArguments(arguments, options);
+    if (!error.isEmpty()) {
+        QTextStream(stderr) << error << "\n\n" << HeadlessRunner::usage();
+        return HeadlessRunner::kExitUsage;
+    }
+    // Nothing is on screen to grab, so diagrams are written as SVG
+    MermaidRenderer::setHeadless(true);
+    HeadlessRunner runner(std::move(options));
+    profiler.mark(QStringLiteral("Headless runner"));
+    profiler.logSummary();
+    return runner.exec();
+}
@@ -0,0 +1,44 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+class StartupProfiler;
+
+// The command-line modes that never open a window: "--worker", "--rag-serve" and
+// "--run". The editor and the GUI-free cp-run binary both dispatch through here, so
+// the two accept the same arguments.
+class HeadlessMain {
+public:
+    // True when argv asks for one of the modes
+    static bool isRequested(int argc, char* argv[]);
+
+    // Call before the application object exists. Headless modes use the offscreen
+    // platform unless one was chosen, for renderers that need a GUI application.
+    static void preparePlatform();
+
+    // Runs the requested mode, or a headless run when none is named, on the existing
+    // application and returns the process exit code
+    static int exec(int argc, char* argv[], StartupProfiler& profiler);
+};
@@ -0,0 +1,545 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "HeadlessRunner.h"
+
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QTextStream>
+
+#include <cstdio>
+
+#include "ExecutionEngine.h"
+#include "ExecutionIdUtils.h"
+#include "NodeGraphModel.h"
+#include "PipelineFormat.h"
+#include "RemoteWorkerPool.h"
+#include "ResourceBudgets.h"
+#include "RunRecording.h"
+#include "ToolNodeDelegate.h"
+
+namespace {
+
+// Bounds memory for long batch streams; matches the default network budget so
+// LLM-heavy pipelines can still keep every network slot busy.
+constexpr int kMaxRunsInFlight = 64;
+
+void printError(const QString& message)
+{
+    QTextStream err(stderr);
+    err << message << Qt::endl;
+}
+
+QJsonObject packetToJson(const DataPacket& packet)
+{
+    return QJsonObject::fromVariantMap(packet);
+}
+
+} // namespace
+
+bool HeadlessRunner::isRequested(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--run") == 0) return true;
+    }
+    return false;
+}
+
+QString HeadlessRunner::parseArguments(const QStringList& arguments, Options& options)
+{
+    for (int i = 0; i < arguments.size(); ++i) {
+        const QString& arg = arguments.at(i);
+        const bool hasValue = i + 1 < arguments.size();
+        if (arg == QStringLiteral("--run")) {
+            if (!hasValue) return QStringLiteral("--run expects a pipeline file");
+            options.pipelinePath = arguments.at(++i);
+        } else if (arg == QStringLiteral("--input")) {
+            if (!hasValue) return QStringLiteral("--input expects <node>[.<pin>]=<value>");
+            const QString spec = arguments.at(++i);
+            const int eq = spec.indexOf(QLatin1Char('='));
+            if (eq <= 0) {
+                return QStringLiteral("--input expects <node>[.<pin>]=<value>, got \"%1\"").arg(spec);
+            }
+            options.inputs.insert(spec.left(eq), spec.mid(eq + 1));
+        } else if (arg == QStringLiteral("--batch")) {
+            if (!hasValue) return QStringLiteral("--batch expects a JSONL file or \"-\" for stdin");
+            options.batchPath = arguments.at(++i);
+        } else if (arg == QStringLiteral("--serve")) {
+            if (!hasValue) return QStringLiteral("--serve expects [address:]port");
+            const QString spec = arguments.at(++i);
+            const int colon = spec.lastIndexOf(QLatin1Char(':'));
+            bool ok = false;
+            const int port = spec.mid(colon + 1).toInt(&ok);
+            if (!ok || port < 0 || port > 65535) {
+                return QStringLiteral("--serve expects [address:]port, got \"%1\"").arg(spec);
+            }
+            options.server.port = port;
+            if (colon >= 0) {
+                QString host = spec.left(colon);
+                if (host.startsWith(QLatin1Char('[')) && host.endsWith(QLatin1Char(']'))) {
+                    host = host.mid(1, host.size() - 2);
+                }
+                if (!options.server.address.setAddress(host)) {
+                    return QStringLiteral("--serve: \"%1\" is not an IP address").arg(host);
+                }
+            }
+            options.serve = true;
+        } else if (arg == QStringLiteral("--max-runs") || arg == QStringLiteral("--max-queue")
+                   || arg == QStringLiteral("--deadline-ms")) {
+            bool ok = false;
+            const int value = hasValue ? arguments.at(++i).toInt(&ok) : 0;
+            if (!ok || value < 0 || (value == 0 && arg == QStringLiteral("--max-runs"))) {
+                return QStringLiteral("%1 expects a %2 number").arg(arg, arg == QStringLiteral("--max-runs")
+                                                                            ? QStringLiteral("positive")
+                                                                            : QStringLiteral("non-negative"));
+            }
+            if (arg == QStringLiteral("--max-runs")) {
+                options.server.maxConcurrentRuns = value;
+            } else if (arg == QStringLiteral("--max-queue")) {
+                options.server.maxQueuedRequests = value;
+            } else {
+                options.server.deadlineMs = value;
+            }
+        } else if (arg == QStringLiteral("--record")) {
+            if (!hasValue) return QStringLiteral("--record expects a directory");
+            options.recordDir = arguments.at(++i);
+        } else if (arg == QStringLiteral("--replay")) {
+            if (!hasValue) return QStringLiteral("--replay expects a recording or a directory of recordings");
+            options.replayPath = arguments.at(++i);
+        } else if (arg == QStringLiteral("--replay-speed")) {
+            bool ok = false;
+            const double speed = hasValue ? arguments.at(++i).toDouble(&ok) : 0.0;
+            if (!ok || speed < 0.0) return QStringLiteral("--replay-speed expects a non-negative factor");
+            options.replaySpeed = speed;
+        } else if (arg == QStringLiteral("-d")) {
+            options.verbose = true;
+        } else {
+            return QStringLiteral("Unknown argument \"%1\"").arg(arg);
+        }
+    }
+
+    if (options.pipelinePath.isEmpty()) {
+        return QStringLiteral("No pipeline file given");
+    }
+    if (options.serve && !options.batchPath.isEmpty()) {
+        return QStringLiteral("--serve and --batch cannot be combined");
+    }
+    if (!options.recordDir.isEmpty() && !options.replayPath.isEmpty()) {
+        return QStringLiteral("--record and --replay cannot be combined");
+    }
+    return {};
+}
+
+QString HeadlessRunner::usage()
+{
+    return QStringLiteral(
+        "Usage: CognitivePipelines --run <pipeline.json> [--input <node>[.<pin>]=<value>]...\n"
+        "                          [--batch <inputs.jsonl>|-] [-d]\n"
+        "                          [--record <dir> | --replay <recording> [--replay-speed <factor>]]\n"
+        "       CognitivePipelines --run <pipeline.json> --serve [<address>:]<port>\n"
+        "                          [--max-runs <n>] [--max-queue <n>] [--deadline-ms <ms>]\n"
+        "\n"
+        "  --run     Execute the saved pipeline without opening the editor and print\n"
+        "            its final output as JSON.\n"
+        "  --input   Use <value> as the output of <node> (an id, caption or uuid)\n"
+        "            instead of executing it. <pin> defaults to the node's only output.\n"
+        "  --batch   Read one JSON object of inputs per line and write one JSON result\n"
+        "            line per input, in order. Runs are executed concurrently.\n"
+        "  --serve   Keep the pipeline loaded and run it once per POST /run request,\n"
+        "            whose JSON body holds the inputs. Add \"Accept: text/event-stream\"\n"
+        "            to receive partial outputs as server-sent events. Listens on\n"
+        "            127.0.0.1 unless an address is given.\n"
+        "  --max-runs     Runs served at once (default 8).\n"
+        "  --max-queue    Requests waiting for a run before 503 (default 256).\n"
+        "  --deadline-ms  Time a request may queue and run before 504 (default none).\n"
+        "  --record  Save each run's node inputs, outputs and timings to a recording\n"
+        "            in <dir>.\n"
+        "  --replay  Answer every node from a recording (or a directory of them) after\n"
+        "            its recorded time instead of executing it; no backend is called.\n"
+        "  --replay-speed  Divide the recorded times by <factor>; 0 answers at once.\n"
+        "  -d        Write engine log messages to stderr.\n"
+        "\n"
+        "CP_REMOTE_WORKERS=<host>:<port>,... sends LLM, PDF and Python script nodes\n"
+        "(or those in CP_REMOTE_NODE_TYPES) to \"--worker\" processes.\n");
+}
+
+HeadlessRunner::HeadlessRunner(Options options, QObject* parent)
+    : QObject(parent)
+    , m_options(std::move(options))
+{
+}
+
+HeadlessRunner::~HeadlessRunner()
+{
+    // The engine refers to the model; tear it down first.
+    m_engine.reset();
+    m_remoteWorkers.reset();
+    m_model.reset();
+}
+
+void HeadlessRunner::setOutput(QIODevice* output)
+{
+    m_output = output;
+}
+
+int HeadlessRunner::exec()
+{
+    if (!m_output) {
+        auto out = std::make_unique<QFile>();
+        if (!out->open(stdout, QIODevice::WriteOnly)) {
+            printError(QStringLiteral("Could not open stdout for writing"));
+            return kExitUsage;
+        }
+        m_stdout = std::move(out);
+        m_output = m_stdout.get();
+    }
+
+    QString error;
+    if (!loadPipeline(error)) {
+        printError(error);
+        return kExitUsage;
+    }
+
+    m_engine = std::make_unique<ExecutionEngine>(m_model.get());
+    m_engine->setProjectName(QFileInfo(m_options.pipelinePath).baseName());
+    m_engine->setResourceBudgets(ResourceBudgets::fromJson(m_model->resourceBudgets()));
+    if (!m_options.recordDir.isEmpty()) {
+        m_engine->setRecordingEnabled(true, m_options.recordDir);
+    }
+    if (!m_options.replayPath.isEmpty()) {
+        QString replayError;
+        const auto recording = RunRecording::load(m_options.replayPath, &replayError);
+        if (!recording) {
+            printError(replayError);
+            return kExitUsage;
+        }
+        m_engine->setReplay(recording, m_options.replaySpeed > 0.0 ? 1.0 / m_options.replaySpeed : 0.0);
+    }
+    if (m_options.verbose) {
+        connect(m_engine.get(), &ExecutionEngine::nodeLog, this, [](const QString& message) {
+            printError(message);
+        });
+    }
+
+    QString workersError;
+    RemoteWorkerPool::Config remote = RemoteWorkerPool::Config::fromEnvironment(&workersError);
+    if (!workersError.isEmpty()) {
+        printError(workersError);
+        return kExitUsage;
+    }
+    if (!remote.workers.isEmpty()) {
+        m_remoteWorkers = std::make_shared<RemoteWorkerPool>(std::move(remote));
+        m_remoteWorkers->start();
+        // Tasks run locally until a worker answers, so a slow worker only delays itself
+        if (!m_remoteWorkers->waitForWorkers(5000)) {
+            printError(QStringLiteral("Some remote workers did not answer; their tasks run locally for now"));
+        }
+        m_engine->setRemoteWorkers(m_remoteWorkers);
+    }
+
+    if (m_options.serve) return runServer();
+    return m_options.batchPath.isEmpty() ? runSingle() : runBatch();
+}
+
+bool HeadlessRunner::loadPipeline(QString& error)
+{
+    QFile file(m_options.pipelinePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = QStringLiteral("Could not open %1: %2").arg(m_options.pipelinePath, file.errorString());
+        return false;
+    }
+
+    const QByteArray data = file.readAll();
+    PipelineFormat::Container container;
+    QJsonObject pipeline;
+    const bool compact = PipelineFormat::isCompact(data);
+    if (compact) {
+        QString decodeError;
+        if (!PipelineFormat::decode(data, container, &decodeError)) {
+            error = QStringLiteral("%1: %2").arg(m_options.pipelinePath, decodeError);
+            return false;
+        }
+    } else {
+        QJsonParseError parseErr{};
+        const QJsonDocument doc = QJsonDocument::fromJson(data, &parseErr);
+        if (parseErr.error != QJsonParseError::NoError || !doc.isObject()) {
+            error = QStringLiteral("Invalid JSON in %1: %2").arg(m_options.pipelinePath, parseErr.errorString());
+            return false;
+        }
+        pipeline = NodeGraphModel::migrateLegacyPipeline(doc.object());
+    }
+
+    m_model = std::make_unique<NodeGraphModel>();
+    try {
+        if (compact) {
+            m_model->loadCompact(container);
+        } else {
+            m_model->load(pipeline);
+        }
+    } catch (const std::exception& e) {
+        error = QStringLiteral("Could not load %1: %2").arg(m_options.pipelinePath, QString::fromUtf8(e.what()));
+        return false;
+    } catch (...) {
+        error = QStringLiteral("Could not load %1").arg(m_options.pipelinePath);
+        return false;
+    }
+    return true;
+}
+
+bool HeadlessRunner::resolveInputs(const QVariantMap& inputs, QHash<QUuid, QVariantMap>& presets,
+                                   QString& error) const
+{
+    const QString scopeKey = m_model->executionScopeKey();
+    const auto allIds = m_model->allNodeIds();
+
+    auto findNode = [&](const QString& ref, QtNodes::NodeId& found) -> bool {
+        bool isNumber = false;
+        const qulonglong number = ref.toULongLong(&isNumber);
+        const QUuid asUuid = QUuid::fromString(ref);
+        for (const auto id : allIds) {
+            if (isNumber && id == number) { found = id; return true; }
+            if (!asUuid.isNull() && ExecIds::nodeUuid(scopeKey, id) == asUuid) { found = id; return true; }
+            auto* delegate = m_model->delegateModel<ToolNodeDelegate>(id);
+            if (delegate && (delegate->caption() == ref || delegate->description() == ref)) {
+                found = id;
+                return true;
+            }
+        }
+        return false;
+    };
+
+    for (auto it = inputs.cbegin(); it != inputs.cend(); ++it) {
+        const QString& key = it.key();
+        QtNodes::NodeId nodeId {QtNodes::InvalidNodeId};
+        QString pin;
+        // A caption may itself contain dots, so the whole key is tried as a node first
+        if (!findNode(key, nodeId)) {
+            const int dot = key.lastIndexOf(QLatin1Char('.'));
+            if (dot <= 0 || !findNode(key.left(dot), nodeId)) {
+                error = QStringLiteral("No node matches input \"%1\"").arg(key);
+                return false;
+            }
+            pin = key.mid(dot + 1);
+        }
+
+        auto* delegate = m_model->delegateModel<ToolNodeDelegate>(nodeId);
+        if (!delegate || !delegate->node()) {
+            error = QStringLiteral("Input \"%1\" does not refer to a pipeline node").arg(key);
+            return false;
+        }
+        const auto& outputPins = delegate->descriptor().outputPins;
+        if (pin.isEmpty()) {
+            if (outputPins.size() != 1) {
+                error = QStringLiteral("Input \"%1\" must name an output pin: %2")
+                            .arg(key, QStringList(outputPins.keys()).join(QStringLiteral(", ")));
+                return false;
+            }
+            pin = outputPins.firstKey();
+        } else if (!outputPins.contains(pin)) {
+            error = QStringLiteral("Node of input \"%1\" has no output pin \"%2\"").arg(key, pin);
+            return false;
+        }
+
+        presets[ExecIds::nodeUuid(scopeKey, nodeId)].insert(pin, it.value());
+    }
+    return true;
+}
+
+int HeadlessRunner::runSingle()
+{
+    QHash<QUuid, QVariantMap> presets;
+    QString error;
+    if (!resolveInputs(m_options.inputs, presets, error)) {
+        printError(error);
+        return kExitUsage;
+    }
+
+    QEventLoop loop;
+    QUuid runId;
+    bool succeeded = false;
+    connect(m_engine.get(), &ExecutionEngine::runFinished, &loop,
+            [&](const QUuid& finishedId, const DataPacket& output, bool ok) {
+        if (finishedId != runId) return;
+        succeeded = ok;
+        m_output->write(QJsonDocument(packetToJson(output)).toJson(QJsonDocument::Indented));
+        loop.quit();
+    });
+    // The only run, and the caller waits for it: keep it on interactive workers
+    runId = m_engine->startIndependentRun(presets, ExecutionEngine::TaskPriority::High);
+    if (runId.isNull()) return kExitRunFailed;
+    loop.exec();
+
+    return succeeded ? kExitSuccess : kExitRunFailed;
+}
+
+int HeadlessRunner::runBatch()
+{
+    if (m_options.batchPath == QStringLiteral("-")) {
+        auto in = std::make_unique<QFile>();
+        if (!in->open(stdin, QIODevice::ReadOnly | QIODevice::Text)) {
+            printError(QStringLiteral("Could not open stdin for reading"));
+            return kExitUsage;
+        }
+        m_batchDevice = std::move(in);
+    } else {
+        auto in = std::make_unique<QFile>(m_options.batchPath);
+        if (!in->open(QIODevice::ReadOnly | QIODevice::Text)) {
+            printError(QStringLiteral("Could not open %1: %2").arg(m_options.batchPath, in->errorString()));
+            return kExitUsage;
+        }
+        m_batchDevice = std::move(in);
+    }
+    m_batchStream = std::make_unique<QTextStream>(m_batchDevice.get());
+
+    QEventLoop loop;
+    m_loop = &loop;
+    connect(m_engine.get(), &ExecutionEngine::runFinished, this, &HeadlessRunner::onRunFinished);
+
+    fillBatch();
+    if (!m_inputExhausted || !m_runLines.isEmpty()) loop.exec();
+    m_loop = nullptr;
+
+    return m_anyFailed ? kExitRunFailed : kExitSuccess;
+}
+
+int HeadlessRunner::runServer()
+{
+    const auto resolve = [this](const QVariantMap& requestInputs, QHash<QUuid, QVariantMap>& presets,
+                                QString& error) {
+        QVariantMap inputs = m_options.inputs;
+        for (auto it = requestInputs.cbegin(); it != requestInputs.cend(); ++it) {
+            inputs.insert(it.key(), it.value());
+        }
+        return resolveInputs(inputs, presets, error);
+    };
+    PipelineServer server(m_engine.get(), resolve, m_options.server);
+    QString error;
+    if (!server.start(&error)) {
+        printError(error);
+        return kExitUsage;
+    }
+    printError(QStringLiteral("Serving %1 on http://%2:%3/run")
+                   .arg(QFileInfo(m_options.pipelinePath).fileName(), m_options.server.address.toString())
+                   .arg(server.serverPort()));
+
+    // Runs until the process is stopped
+    QEventLoop loop;
+    loop.exec();
+    return kExitSuccess;
+}
+
+void HeadlessRunner::fillBatch()
+{
+    QString text;
+    while (!m_inputExhausted && m_runLines.size() < kMaxRunsInFlight) {
+        if (!m_batchStream->readLineInto(&text)) {
+            m_inputExhausted = true;
+            break;
+        }
+        if (text.trimmed().isEmpty()) continue;
+        startBatchLine(m_nextLine++, text);
+    }
+
+    if (m_inputExhausted && m_runLines.isEmpty() && m_loop) {
+        m_loop->quit();
+    }
+}
+
+void HeadlessRunner::startBatchLine(int line, const QString& text)
+{
+    QJsonParseError parseErr{};
+    const QJsonDocument doc = QJsonDocument::fromJson(text.toUtf8(), &parseErr);
+    QString error;
+    if (parseErr.error != QJsonParseError::NoError || !doc.isObject()) {
+        error = QStringLiteral("Invalid JSON object: %1").arg(parseErr.errorString());
+    }
+
+    QHash<QUuid, QVariantMap> presets;
+    if (error.isEmpty()) {
+        QVariantMap inputs = m_options.inputs;
+        const QJsonObject lineInputs = doc.object();
+        for (auto it = lineInputs.constBegin(); it != lineInputs.constEnd(); ++it) {
+            inputs.insert(it.key(), it.value().toVariant());
+        }
+        resolveInputs(inputs, presets, error);
+    }
+
+    if (!error.isEmpty()) {
+        m_anyFailed = true;
+        writeResult(line, QJsonObject{
+            {QStringLiteral("index"), line},
+            {QStringLiteral("succeeded"), false},
+            {QStringLiteral("error"), error},
+        });
+        return;
+    }
+
+    m_runLines.insert(m_engine->startIndependentRun(presets), line);
+}
+
+void HeadlessRunner::onRunFinished(const QUuid& runId, const DataPacket& output, bool succeeded)
+{
+    const auto it = m_runLines.constFind(runId);
+    if (it == m_runLines.cend()) return;
+    const int line = it.value();
+    m_runLines.erase(it);
+
+    QJsonObject result{
+        {QStringLiteral("index"), line},
+        {QStringLiteral("succeeded"), succeeded},
+        {QStringLiteral("output"), packetToJson(output)},
+    };
+    if (!succeeded) {
+        m_anyFailed = true;
+        const QString error = output.value(QStringLiteral("__error")).toString();
+        result.insert(QStringLiteral("error"), error.isEmpty() ? QStringLiteral("Run failed") : error);
+    }
+    writeResult(line, result);
+    fillBatch();
+}
+
+void HeadlessRunner::writeResult(int line, const QJsonObject& result)
+{
+    m_pendingResults.insert(line, result);
+    flushResults();
+}
+
+void HeadlessRunner::flushResults()
+{
+    // Results are written in input order, so a line waits for all earlier ones
+    bool wrote = false;
+    for (auto it = m_pendingResults.begin(); it != m_pendingResults.end() && it.key() == m_nextToWrite;
+         it = m_pendingResults.erase(it)) {
+        m_output->write(QJsonDocument(it.value()).toJson(QJsonDocument::Compact));
+        m_output->write("\n");
+        ++m_nextToWrite;
+        wrote = true;
+    }
+    if (wrote) {
+        if (auto* file = qobject_cast<QFile*>(m_output)) file->flush();
+    }
+}
@@ -0,0 +1,127 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QHash>
+#include <QJsonObject>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QUuid>
+#include <QVariantMap>
+
+#include <memory>
+
+#include "CommonDataTypes.h"
+#include "PipelineServer.h"
+
+class ExecutionEngine;
+class NodeGraphModel;
+class QEventLoop;
+class QIODevice;
+class RemoteWorkerPool;
+class QTextStream;
+
+// Runs a saved pipeline without the editor: "--run pipeline.json".
+//
+// Inputs are given as "--input <node>[.<pin>]=<value>", where <node> is a node id, its
+// caption or its execution uuid and <pin> defaults to the node's only output pin. The
+// named node is not executed; the value becomes its output. A single run prints the
+// final packet as JSON. With "--batch <file.jsonl>" ("-" for stdin) each line is a JSON
+// object of further inputs, runs proceed concurrently as independent engine runs, and
+// one result line is written per input line, in input order. With "--serve
+// [address:]port" the pipeline stays loaded and each HTTP request is one run; see
+// PipelineServer.
+class HeadlessRunner : public QObject {
+    Q_OBJECT
+public:
+    struct Options {
+        QString pipelinePath;
+        QVariantMap inputs;
+        QString batchPath;
+        bool serve {false};
+        PipelineServer::Config server;
+        bool verbose {false};
+        // Directory each run's recording is written to; empty records nothing
+        QString recordDir;
+        // Recording (a bundle or a directory of them) to answer nodes from
+        QString replayPath;
+        // Replayed wall times are divided by this; 0 answers at once
+        double replaySpeed {1.0};
+    };
+
+    // Exit codes returned by exec().
+    static constexpr int kExitSuccess = 0;
+    static constexpr int kExitRunFailed = 1;
+    static constexpr int kExitUsage = 2;
+
+    // True when the command line asks for a headless run, checked before any
+    // QApplication exists.
+    static bool isRequested(int argc, char* argv[]);
+    // Fills options from the arguments (argv[0] excluded). Returns an error message,
+    // empty on success.
+    static QString parseArguments(const QStringList& arguments, Options& options);
+    static QString usage();
+
+    explicit HeadlessRunner(Options options, QObject* parent = nullptr);
+    ~HeadlessRunner() override;
+
+    // Results go to stdout unless another device is set; diagnostics go to stderr.
+    void setOutput(QIODevice* output);
+    int exec();
+
+private:
+    bool loadPipeline(QString& error);
+    // Resolves "<node>[.<pin>]" keys to preset outputs for startIndependentRun().
+    bool resolveInputs(const QVariantMap& inputs, QHash<QUuid, QVariantMap>& presets,
+                       QString& error) const;
+    int runSingle();
+    int runBatch();
+    int runServer();
+    void fillBatch();
+    void startBatchLine(int line, const QString& text);
+    void writeResult(int line, const QJsonObject& result);
+    void flushResults();
+    void onRunFinished(const QUuid& runId, const DataPacket& output, bool succeeded);
+
+    Options m_options;
+    QIODevice* m_output {nullptr};
+    std::unique_ptr<QIODevice> m_stdout;
+    std::unique_ptr<NodeGraphModel> m_model;
+    std::unique_ptr<ExecutionEngine> m_engine;
+    // Set when CP_REMOTE_WORKERS lists workers
+    std::shared_ptr<RemoteWorkerPool> m_remoteWorkers;
+
+    // Batch state
+    std::unique_ptr<QIODevice> m_batchDevice;
+    std::unique_ptr<QTextStream> m_batchStream;
+    QEventLoop* m_loop {nullptr};
+    QHash<QUuid, int> m_runLines;
+    QMap<int, QJsonObject> m_pendingResults;
+    int m_nextLine {0};
+    int m_nextToWrite {0};
+    bool m_inputExhausted {false};
+    bool m_anyFailed {false};
+};
@@ -0,0 +1,164 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "HttpServerSupport.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QList>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QVariant>
+
+namespace {
+
+const char* const kRequestReadProperty = "cp_request_read";
+
+} // namespace
+
+namespace HttpServerSupport {
+
+ParseResult parseRequest(const QByteArray& buffer, Request& request, qsizetype maxBytes)
+{
+    const qsizetype headerEnd = buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        return buffer.size() > kMaxHeaderBytes ? ParseResult::TooLarge : ParseResult::Incomplete;
+    }
+
+    const QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+    const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+    if (requestLine.size() != 3 || !requestLine.at(2).startsWith("HTTP/")) {
+        return ParseResult::Malformed;
+    }
+    request = Request();
+    request.method = requestLine.at(0);
+    const QByteArray& target = requestLine.at(1);
+    const qsizetype queryStart = target.indexOf('?');
+    request.path = target.left(queryStart < 0 ? target.size() : queryStart);
+    if (queryStart >= 0) {
+        for (const QByteArray& pair : target.mid(queryStart + 1).split('&')) {
+            if (pair.isEmpty()) continue;
+            const qsizetype eq = pair.indexOf('=');
+            const QByteArray key = eq < 0 ? pair : pair.left(eq);
+            const QByteArray value = eq < 0 ? QByteArray() : pair.mid(eq + 1);
+            request.query.insert(QByteArray::fromPercentEncoding(key),
+                                 QByteArray::fromPercentEncoding(QByteArray(value).replace('+', ' ')));
+        }
+    }
+    for (qsizetype i = 1; i < lines.size(); ++i) {
+        const QByteArray& line = lines.at(i);
+        const qsizetype colon = line.indexOf(':');
+        if (colon <= 0) {
+            return ParseResult::Malformed;
+        }
+        request.headers.insert(line.left(colon).trimmed().toLower(), line.mid(colon + 1).trimmed());
+    }
+
+    // Chunked uploads are not supported; clients send a Content-Length
+    if (request.headers.contains("transfer-encoding")) {
+        return ParseResult::Malformed;
+    }
+    qsizetype length = 0;
+    const auto contentLength = request.headers.constFind("content-length");
+    if (contentLength != request.headers.cend()) {
+        bool ok = false;
+        length = contentLength.value().toLongLong(&ok);
+        if (!ok || length < 0) {
+            return ParseResult::Malformed;
+        }
+    }
+    // Compared before adding, so a huge Content-Length cannot overflow the total
+    if (length > maxBytes - (headerEnd + 4)) {
+        return ParseResult::TooLarge;
+    }
+    const qsizetype total = headerEnd + 4 + length;
+    if (buffer.size() < total) {
+        return ParseResult::Incomplete;
+    }
+    request.body = buffer.mid(headerEnd + 4, length);
+    return ParseResult::Complete;
+}
+
+QByteArray statusText(int status)
+{
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 413: return "Payload Too Large";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    case 504: return "Gateway Timeout";
+    default: return "Unknown";
+    }
+}
+
+QByteArray response(int status, const QByteArray& contentType, const QByteArray& body,
+                    const QByteArray& extraHeaders, bool includeBody)
+{
+    QByteArray response = "HTTP/1.1 " + QByteArray::number(status) + ' ' + statusText(status) + "\r\n";
+    response += "Content-Type: " + contentType + "\r\n";
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    response += extraHeaders;
+    response += "Connection: close\r\n\r\n";
+    if (includeBody) {
+        response += body;
+    }
+    return response;
+}
+
+QByteArray jsonResponse(int status, const QByteArray& json, const QByteArray& extraHeaders, bool includeBody)
+{
+    return response(status, "application/json", json, extraHeaders, includeBody);
+}
+
+QByteArray errorBody(const QString& message)
+{
+    return QJsonDocument(QJsonObject{
+                             {QStringLiteral("succeeded"), false},
+                             {QStringLiteral("error"), message},
+                         })
+        .toJson(QJsonDocument::Compact);
+}
+
+void watchRequestRead(QTcpSocket* socket)
+{
+    QTimer::singleShot(kRequestReadTimeoutMs, socket, [socket]() {
+        if (!isRequestRead(socket)) {
+            socket->abort();
+        }
+    });
+}
+
+void markRequestRead(QTcpSocket* socket)
+{
+    socket->setProperty(kRequestReadProperty, true);
+}
+
+bool isRequestRead(const QTcpSocket* socket)
+{
+    return socket->property(kRequestReadProperty).toBool();
+}
+
+} // namespace HttpServerSupport
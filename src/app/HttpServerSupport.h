@@ -0,0 +1,81 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+class QTcpSocket;
+
+// The HTTP/1.1 plumbing shared by the built-in servers (PipelineServer,
+// RagIndexServer, MetricsExporter): request parsing, responses that close the
+// connection, and the time a client gets to send its request.
+namespace HttpServerSupport {
+
+// Time a client has to send its whole request
+constexpr int kRequestReadTimeoutMs = 30000;
+// Largest request line and headers accepted
+constexpr qsizetype kMaxHeaderBytes = 16 * 1024;
+
+// One parsed HTTP request
+struct Request {
+    QByteArray method;
+    QByteArray path;
+    QHash<QByteArray, QByteArray> query;
+    // Header names in lower case
+    QHash<QByteArray, QByteArray> headers;
+    QByteArray body;
+};
+
+enum class ParseResult {
+    Incomplete,
+    Complete,
+    Malformed,
+    TooLarge
+};
+
+// Parses one request from the start of @p buffer; bodies need a Content-Length.
+// maxBytes bounds headers and body together.
+ParseResult parseRequest(const QByteArray& buffer, Request& request, qsizetype maxBytes);
+
+// Reason phrase for a status code
+QByteArray statusText(int status);
+
+// A whole response, announcing that the connection closes after it. HEAD answers
+// pass includeBody false and keep the Content-Length of the body they leave out.
+QByteArray response(int status, const QByteArray& contentType, const QByteArray& body,
+                    const QByteArray& extraHeaders = {}, bool includeBody = true);
+QByteArray jsonResponse(int status, const QByteArray& json, const QByteArray& extraHeaders = {},
+                        bool includeBody = true);
+
+// {"succeeded": false, "error": message}
+QByteArray errorBody(const QString& message);
+
+// Aborts socket unless markRequestRead() is called within kRequestReadTimeoutMs
+void watchRequestRead(QTcpSocket* socket);
+void markRequestRead(QTcpSocket* socket);
+bool isRequestRead(const QTcpSocket* socket);
+
+} // namespace HttpServerSupport
@@ -25,11 +25,16 @@
 #include "MainWindow.h"
 #include "AboutDialog.h"
 #include "NodeGraphModel.h"
+#include "PipelineFormat.h"
 #include "ToolNodeDelegate.h"
+#include "IngestInputNode.h"
 #include "TextOutputNode.h"
+#include "LargeTextView.h"
+#include "DebugLogView.h"
 #include "ExecutionEngine.h"
 #include "ExecutionAwarePainters.h"
 #include "ExecutionStateModel.h"
+#include "ai/backends/LLMResponseCache.h"
 
 #include <QAction>
 #include <QApplication>
@@ -54,9 +59,13 @@
 #include <QDockWidget>
 #include <QLabel>
 #include <QGraphicsView>
-#include <QTextEdit>
 #include <QPlainTextEdit>
 #include <QSpinBox>
+#include <QCheckBox>
+#include <QSignalBlocker>
+#include <QHeaderView>
+#include <QTableWidget>
+#include <QLocale>
 #include <QWidgetAction>
 #include <QFile>
 #include <QFileInfo>
@@ -68,12 +77,16 @@
 #include <QDesktopServices>
 #include <QUrl>
 #include <QSaveFile>
+#include <QFutureWatcher>
+#include <QTimer>
+#include <algorithm>
 #include <limits>
 #include "ExecutionIdUtils.h"
 
 #include "CredentialsDialog.h"
 #include "ProviderManagementDialog.h"
 #include "SyntaxHighlightingOptionsDialog.h"
+#include "ResourceBudgetsDialog.h"
 #include "UserInputDialog.h"
 #include "Logger.h"
 
@@ -82,7 +95,13 @@ static MainWindow* s_instance = nullptr;
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent) {
     s_instance = this;
+    AppLogHelper::setLineViewer(&MainWindow::logMessages);
     setWindowTitle("CognitivePipelines");
+
+    HumanInputQueue& humanInput = HumanInputQueue::instance();
+    humanInput.attachFrontEnd();
+    connect(&humanInput, &HumanInputQueue::promptQueued, this, &MainWindow::onHumanInputQueued);
+    connect(&humanInput, &HumanInputQueue::promptClosed, this, &MainWindow::onHumanInputClosed);
     resize(1100, 700);
 
     // Instantiate the graph model, execution engine, and view.
@@ -90,9 +109,28 @@ MainWindow::MainWindow(QWidget* parent)
     currentGraphModel_ = _graphModel;
     _graphView = new QtNodes::GraphicsView(this);
     setCentralWidget(_graphView);
+    // Hides embedded node widgets that are off screen or too small to use
+    canvasDetail_ = new CanvasDetailController(_graphView);
+
+    // Ingest Input nodes run the pipeline from themselves when content is dropped or pasted
+    IngestInputNode::setRunRequestHandler([this](IToolNode* node) {
+        for (const QtNodes::NodeId nodeId : _graphModel->allNodeIds()) {
+            auto* delegate = _graphModel->delegateModel<ToolNodeDelegate>(nodeId);
+            if (delegate && delegate->node().get() == node) {
+                QMetaObject::invokeMethod(this, [this, nodeId]() { runScenarioFromNodeId(nodeId); },
+                                          Qt::QueuedConnection);
+                return;
+            }
+        }
+    });
 
     // Create execution engine
     execEngine_ = new ExecutionEngine(_graphModel, this);
+    // Workers must not wait for Stage Output repaints; refresh at frame rate instead
+    execEngine_->setOutputNotificationMode(ExecutionEngine::OutputNotificationMode::Coalesced);
+    execEngine_->setLogVerbosity(AppLogHelper::isGlobalDebugEnabled() ? ExecutionEngine::LogVerbosity::Full
+                                                                        : ExecutionEngine::LogVerbosity::Quiet);
+    execEngine_->setRunHistory(RunHistory::shared());
 
     // Live execution-state highlighting: custom painters are installed per scene.
     execStateModel_ = std::make_shared<ExecutionStateModel>(this);
@@ -129,6 +167,39 @@ MainWindow::MainWindow(QWidget* parent)
     descriptionLabel_->setVisible(false);
     descriptionEdit_->setVisible(false);
 
+    concurrencyLabel_ = new QLabel(tr("Max Concurrent Executions"), propertiesHost_);
+    propertiesLayout_->addWidget(concurrencyLabel_);
+    concurrencySpin_ = new QSpinBox(propertiesHost_);
+    concurrencySpin_->setRange(1, ToolNodeDelegate::kMaxConcurrentExecutionsLimit);
+    concurrencySpin_->setToolTip(tr("How many inputs of one run this node may process at once, e.g. items from a "
+                                    "loop. Only nodes that keep no state between calls allow more than one."));
+    propertiesLayout_->addWidget(concurrencySpin_);
+    outputOrderCheck_ = new QCheckBox(tr("Keep output order"), propertiesHost_);
+    outputOrderCheck_->setToolTip(tr("Pass results on in the order the inputs arrived rather than as they finish"));
+    propertiesLayout_->addWidget(outputOrderCheck_);
+    retryLabel_ = new QLabel(tr("Retries on Transient Failures"), propertiesHost_);
+    propertiesLayout_->addWidget(retryLabel_);
+    retryAttemptsSpin_ = new QSpinBox(propertiesHost_);
+    retryAttemptsSpin_->setRange(1, RetryPolicy::kMaxAttemptsLimit);
+    retryAttemptsSpin_->setPrefix(tr("Attempts: "));
+    retryAttemptsSpin_->setToolTip(tr("How often the engine runs the node when a provider times out, fails or rate "
+                                      "limits it. Waits between attempts don't occupy a worker."));
+    propertiesLayout_->addWidget(retryAttemptsSpin_);
+    retryBackoffSpin_ = new QSpinBox(propertiesHost_);
+    retryBackoffSpin_->setRange(1, RetryPolicy::kMaxDelayMs);
+    retryBackoffSpin_->setSingleStep(250);
+    retryBackoffSpin_->setPrefix(tr("Backoff: "));
+    retryBackoffSpin_->setSuffix(tr(" ms"));
+    retryBackoffSpin_->setToolTip(tr("Wait before the first retry, doubled for each later one and jittered. A "
+                                     "provider's Retry-After takes precedence."));
+    propertiesLayout_->addWidget(retryBackoffSpin_);
+    concurrencyLabel_->setVisible(false);
+    concurrencySpin_->setVisible(false);
+    outputOrderCheck_->setVisible(false);
+    retryLabel_->setVisible(false);
+    retryAttemptsSpin_->setVisible(false);
+    retryBackoffSpin_->setVisible(false);
+
     placeholderLabel_ = new QLabel(tr("No node selected"), propertiesHost_);
     placeholderLabel_->setAlignment(Qt::AlignCenter);
     propertiesLayout_->addWidget(placeholderLabel_);
@@ -139,8 +210,8 @@ MainWindow::MainWindow(QWidget* parent)
     stageOutputDock_ = new QDockWidget(tr("Stage Output"), this);
     stageOutputDock_->setObjectName("StageOutputDock");
     stageOutputDock_->setAllowedAreas(Qt::BottomDockWidgetArea | Qt::TopDockWidgetArea);
-    stageOutputText_ = new QTextEdit(stageOutputDock_);
-    stageOutputText_->setReadOnly(true);
+    // Pages multi-megabyte outputs instead of laying them out whole
+    stageOutputText_ = new LargeTextView(stageOutputDock_);
     stageOutputDock_->setWidget(stageOutputText_);
     addDockWidget(Qt::BottomDockWidgetArea, stageOutputDock_);
 
@@ -148,9 +219,9 @@ MainWindow::MainWindow(QWidget* parent)
     debugLogDock_ = new QDockWidget(tr("Debug Log"), this);
     debugLogDock_->setObjectName("DebugLogDock");
     debugLogDock_->setAllowedAreas(Qt::BottomDockWidgetArea | Qt::TopDockWidgetArea);
-    debugLogText_ = new QTextEdit(debugLogDock_);
-    debugLogText_->setReadOnly(true);
-    debugLogDock_->setWidget(debugLogText_);
+    // Bounded ring buffer in a virtualised view; filtering runs off the GUI thread
+    debugLogView_ = new DebugLogView(debugLogDock_);
+    debugLogDock_->setWidget(debugLogView_);
     addDockWidget(Qt::BottomDockWidgetArea, debugLogDock_);
     debugLogDock_->hide();
 
@@ -158,6 +229,75 @@ MainWindow::MainWindow(QWidget* parent)
     connect(showDebugLogAction_, &QAction::toggled, debugLogDock_, &QDockWidget::setVisible);
     connect(debugLogDock_, &QDockWidget::visibilityChanged, showDebugLogAction_, &QAction::setChecked);
 
+    // Create Run Analysis dock (filled after traced runs, hidden by default)
+    runAnalysisDock_ = new QDockWidget(tr("Run Analysis"), this);
+    runAnalysisDock_->setObjectName("RunAnalysisDock");
+    runAnalysisDock_->setAllowedAreas(Qt::BottomDockWidgetArea | Qt::TopDockWidgetArea);
+    runAnalysisText_ = new QPlainTextEdit(runAnalysisDock_);
+    runAnalysisText_->setReadOnly(true);
+    runAnalysisText_->setPlainText(tr("Enable Pipeline > Record Execution Trace to analyse the next run."));
+    runAnalysisDock_->setWidget(runAnalysisText_);
+    addDockWidget(Qt::BottomDockWidgetArea, runAnalysisDock_);
+    runAnalysisDock_->hide();
+    connect(showRunAnalysisAction_, &QAction::toggled, runAnalysisDock_, &QDockWidget::setVisible);
+    connect(runAnalysisDock_, &QDockWidget::visibilityChanged, showRunAnalysisAction_, &QAction::setChecked);
+
+    // Create Run Usage dock (refreshed after every run, hidden by default)
+    runUsageDock_ = new QDockWidget(tr("Run Usage"), this);
+    runUsageDock_->setObjectName("RunUsageDock");
+    runUsageDock_->setAllowedAreas(Qt::BottomDockWidgetArea | Qt::TopDockWidgetArea);
+    runUsageText_ = new QPlainTextEdit(runUsageDock_);
+    runUsageText_->setReadOnly(true);
+    runUsageText_->setPlainText(tr("Provider calls, tokens and latencies of the next run appear here."));
+    runUsageDock_->setWidget(runUsageText_);
+    addDockWidget(Qt::BottomDockWidgetArea, runUsageDock_);
+    runUsageDock_->hide();
+    connect(showRunUsageAction_, &QAction::toggled, runUsageDock_, &QDockWidget::setVisible);
+    connect(runUsageDock_, &QDockWidget::visibilityChanged, showRunUsageAction_, &QAction::setChecked);
+    connect(execEngine_, &ExecutionEngine::runUsageReady, this, [this](const RunUsageReport& report) {
+        runUsageText_->setPlainText(report.summary());
+    });
+
+    // Create Run History dock (past runs of the graph last run, hidden by default)
+    runHistoryDock_ = new QDockWidget(tr("Run History"), this);
+    runHistoryDock_->setObjectName("RunHistoryDock");
+    runHistoryDock_->setAllowedAreas(Qt::BottomDockWidgetArea | Qt::TopDockWidgetArea);
+    auto* runHistoryPanel = new QWidget(runHistoryDock_);
+    auto* runHistoryLayout = new QVBoxLayout(runHistoryPanel);
+    runHistoryLayout->setContentsMargins(0, 0, 0, 0);
+    runHistoryTable_ = new QTableWidget(0, 7, runHistoryPanel);
+    runHistoryTable_->setHorizontalHeaderLabels({tr("Started"), tr("Status"), tr("Wall (ms)"), tr("Queue wait (ms)"),
+                                                 tr("Tokens"), tr("Cache hits"), tr("Retries")});
+    runHistoryTable_->horizontalHeader()->setStretchLastSection(true);
+    runHistoryTable_->verticalHeader()->hide();
+    runHistoryTable_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    runHistoryTable_->setSelectionBehavior(QAbstractItemView::SelectRows);
+    runHistoryTable_->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    runHistoryText_ = new QPlainTextEdit(runHistoryPanel);
+    runHistoryText_->setReadOnly(true);
+    runHistoryText_->setPlainText(tr("Runs of the pipeline appear here, with regressions against earlier runs."));
+    runHistoryLayout->addWidget(runHistoryTable_, 2);
+    runHistoryLayout->addWidget(runHistoryText_, 1);
+    runHistoryDock_->setWidget(runHistoryPanel);
+    addDockWidget(Qt::BottomDockWidgetArea, runHistoryDock_);
+    runHistoryDock_->hide();
+    connect(showRunHistoryAction_, &QAction::toggled, runHistoryDock_, &QDockWidget::setVisible);
+    connect(runHistoryDock_, &QDockWidget::visibilityChanged, showRunHistoryAction_, &QAction::setChecked);
+    connect(runHistoryTable_, &QTableWidget::itemSelectionChanged, this, &MainWindow::compareSelectedRuns);
+    connect(execEngine_, &ExecutionEngine::runHistoryUpdated, this, &MainWindow::refreshRunHistory,
+            Qt::QueuedConnection);
+
+    // Critical path highlighting is per-run: drop it when the next run starts
+    connect(execEngine_, &ExecutionEngine::executionStarted,
+            execStateModel_.get(), &ExecutionStateModel::clearCriticalPath);
+    connect(execEngine_, &ExecutionEngine::runAnalysisReady, this, [this](const RunAnalysis& analysis) {
+        QSet<QUuid> critical(analysis.criticalNodes.cbegin(), analysis.criticalNodes.cend());
+        for (const auto& connUuid : analysis.criticalConnections) critical.insert(connUuid);
+        execStateModel_->setCriticalPath(critical);
+        runAnalysisText_->setPlainText(analysis.summary());
+        runAnalysisDock_->show();
+    });
+
     // Connect engine signals to UI slots
     connect(execEngine_, &ExecutionEngine::pipelineFinished,
             this, &MainWindow::onPipelineFinished);
@@ -193,10 +333,6 @@ MainWindow::MainWindow(QWidget* parent)
                 refreshStageOutput();
             });
 
-    // Repaint specific node on status changes to force painter invocation
-    connect(execEngine_, &ExecutionEngine::nodeStatusChanged,
-            this, [this](const QUuid &nodeId, int /*state*/) { onNodeRepaint(nodeId); });
-
     updateGraphNavigation();
 }
 
@@ -274,12 +410,29 @@ void MainWindow::createActions() {
     showDebugLogAction_->setCheckable(true);
     showDebugLogAction_->setChecked(false);
 
+    showRunAnalysisAction_ = new QAction(tr("Show Run Analysis"), this);
+    showRunAnalysisAction_->setCheckable(true);
+    showRunAnalysisAction_->setChecked(false);
+
+    showRunUsageAction_ = new QAction(tr("Show Run Usage"), this);
+    showRunUsageAction_->setCheckable(true);
+    showRunUsageAction_->setChecked(false);
+
+    showRunHistoryAction_ = new QAction(tr("Show Run History"), this);
+    showRunHistoryAction_->setCheckable(true);
+    showRunHistoryAction_->setChecked(false);
+
     // Pipeline menu action to enable/disable debug logging
     enableDebugLoggingAction_ = new QAction(tr("Enable Debug Logging"), this);
     enableDebugLoggingAction_->setCheckable(true);
     enableDebugLoggingAction_->setChecked(AppLogHelper::isGlobalDebugEnabled());
-    connect(enableDebugLoggingAction_, &QAction::toggled, this, [](bool enabled) {
+    connect(enableDebugLoggingAction_, &QAction::toggled, this, [this](bool enabled) {
         AppLogHelper::setGlobalDebugEnabled(enabled);
+        // The debug dock drops engine lines while logging is off, so don't build them
+        if (execEngine_) {
+            execEngine_->setLogVerbosity(enabled ? ExecutionEngine::LogVerbosity::Full
+                                                 : ExecutionEngine::LogVerbosity::Quiet);
+        }
     });
 
     // Slow Motion Mode toggle
@@ -287,6 +440,32 @@ void MainWindow::createActions() {
     slowMotionAction_->setCheckable(true);
     slowMotionAction_->setChecked(false);
 
+    // Replay stored results of cacheable nodes (e.g. LLM calls) when inputs are unchanged
+    resultCacheAction_ = new QAction(tr("Cache Node Results"), this);
+    resultCacheAction_->setCheckable(true);
+    resultCacheAction_->setChecked(false);
+    resultCacheAction_->setStatusTip(tr("Reuse outputs of cacheable nodes whose configuration and inputs are unchanged"));
+
+    // Answer temperature-0 LLM calls from disk when the whole request is unchanged
+    llmResponseCacheAction_ = new QAction(tr("Cache LLM Responses"), this);
+    llmResponseCacheAction_->setCheckable(true);
+    llmResponseCacheAction_->setChecked(LLMResponseCache::shared() != nullptr);
+    llmResponseCacheAction_->setStatusTip(tr("Reuse responses to identical temperature-0 prompts for up to a week"));
+
+    traceAction_ = new QAction(tr("Record Execution Trace"), this);
+    traceAction_->setCheckable(true);
+    traceAction_->setChecked(false);
+    traceAction_->setStatusTip(tr("Write a Chrome/Perfetto timeline of each run to the project's traces folder"));
+
+    checkpointAction_ = new QAction(tr("Checkpoint Runs"), this);
+    checkpointAction_->setCheckable(true);
+    checkpointAction_->setChecked(false);
+    checkpointAction_->setStatusTip(tr("Save each run's finished node work every minute so a crashed or failed run can be resumed"));
+
+    resourceBudgetsAction_ = new QAction(tr("Concurrency Budgets..."), this);
+    resourceBudgetsAction_->setStatusTip(tr("Limit how many network, CPU, process and UI nodes of this pipeline run at once"));
+    connect(resourceBudgetsAction_, &QAction::triggered, this, &MainWindow::onResourceBudgets);
+
     // Modern signal-slot connections using function pointers / lambdas
 
     connect(exitAction, &QAction::triggered, this, [this]() {
@@ -322,6 +501,9 @@ void MainWindow::createMenus() {
     // View menu
     QMenu* viewMenu = menuBar()->addMenu(tr("&View"));
     viewMenu->addAction(showDebugLogAction_);
+    viewMenu->addAction(showRunAnalysisAction_);
+    viewMenu->addAction(showRunUsageAction_);
+    viewMenu->addAction(showRunHistoryAction_);
 
     // Pipeline menu
     QMenu* pipelineMenu = menuBar()->addMenu(tr("&Pipeline"));
@@ -344,6 +526,34 @@ void MainWindow::createMenus() {
             execEngine_->setExecutionDelay(enabled ? 500 : 0);
         });
     }
+    pipelineMenu->addAction(resultCacheAction_);
+    if (execEngine_) {
+        connect(resultCacheAction_, &QAction::toggled, this, [this](bool enabled){
+            if (!execEngine_) return;
+            execEngine_->setResultCacheEnabled(enabled);
+        });
+    }
+    pipelineMenu->addAction(llmResponseCacheAction_);
+    connect(llmResponseCacheAction_, &QAction::toggled, this, [](bool enabled){
+        LLMResponseCache::setShared(enabled
+            ? std::make_shared<LLMResponseCache>(LLMResponseCache::defaultDirectory())
+            : nullptr);
+    });
+    pipelineMenu->addAction(traceAction_);
+    if (execEngine_) {
+        connect(traceAction_, &QAction::toggled, this, [this](bool enabled){
+            if (!execEngine_) return;
+            execEngine_->setTraceEnabled(enabled);
+        });
+    }
+    pipelineMenu->addAction(checkpointAction_);
+    if (execEngine_) {
+        connect(checkpointAction_, &QAction::toggled, this, [this](bool enabled){
+            if (!execEngine_) return;
+            execEngine_->setCheckpointEnabled(enabled);
+        });
+    }
+    pipelineMenu->addAction(resourceBudgetsAction_);
 
     // Help menu
     QMenu* helpMenu = menuBar()->addMenu(tr("&Help"));
@@ -422,8 +632,6 @@ void MainWindow::connectGraphModelSignals(NodeGraphModel* model)
     connect(model, &NodeGraphModel::executionConnectionStatusChanged,
             execStateModel_.get(), &ExecutionStateModel::onConnectionStatusChanged,
             Qt::UniqueConnection);
-    connect(model, &NodeGraphModel::executionNodeStatusChanged,
-            this, [this](const QUuid& nodeId, int) { onNodeRepaint(nodeId); });
     connect(model, &NodeGraphModel::executionNodeOutputChanged,
             this, [this](QtNodes::NodeId) { refreshStageOutput(); });
 
@@ -455,12 +663,18 @@ void MainWindow::installGraphScene(NodeGraphModel* model)
 
     connect(execStateModel_.get(), &ExecutionStateModel::stateChanged,
             scene, [scene]() { scene->update(); });
+    // State changes arrive once per frame and repaint only the items they touch
+    connect(execStateModel_.get(), &ExecutionStateModel::itemsChanged,
+            scene, [this](const QList<QUuid>& ids) { onExecutionItemsChanged(ids); });
     connect(scene, &QtNodes::BasicGraphicsScene::nodeSelected,
             this, &MainWindow::onNodeSelected);
     connect(scene, &QGraphicsScene::selectionChanged,
             this, &MainWindow::onSelectionChanged);
 
     static_cast<QGraphicsView*>(_graphView)->setScene(scene);
+    if (canvasDetail_) {
+        canvasDetail_->scheduleRefresh();
+    }
 }
 
 NodeGraphModel* MainWindow::activeGraphModel() const
@@ -501,6 +715,12 @@ void MainWindow::setPropertiesWidget(QWidget* w)
         if (placeholderLabel_) placeholderLabel_->setVisible(true);
         if (descriptionLabel_) descriptionLabel_->setVisible(false);
         if (descriptionEdit_) descriptionEdit_->setVisible(false);
+        if (concurrencyLabel_) concurrencyLabel_->setVisible(false);
+        if (concurrencySpin_) concurrencySpin_->setVisible(false);
+        if (outputOrderCheck_) outputOrderCheck_->setVisible(false);
+        if (retryLabel_) retryLabel_->setVisible(false);
+        if (retryAttemptsSpin_) retryAttemptsSpin_->setVisible(false);
+        if (retryBackoffSpin_) retryBackoffSpin_->setVisible(false);
         currentConfigWidget_.clear();
         return;
     }
@@ -509,6 +729,12 @@ void MainWindow::setPropertiesWidget(QWidget* w)
     if (placeholderLabel_) placeholderLabel_->setVisible(false);
     if (descriptionLabel_) descriptionLabel_->setVisible(true);
     if (descriptionEdit_) descriptionEdit_->setVisible(true);
+    if (concurrencyLabel_) concurrencyLabel_->setVisible(true);
+    if (concurrencySpin_) concurrencySpin_->setVisible(true);
+    if (outputOrderCheck_) outputOrderCheck_->setVisible(true);
+    if (retryLabel_) retryLabel_->setVisible(true);
+    if (retryAttemptsSpin_) retryAttemptsSpin_->setVisible(true);
+    if (retryBackoffSpin_) retryBackoffSpin_->setVisible(true);
 
     currentConfigWidget_ = w;
     if (currentConfigWidget_ && currentConfigWidget_->parent() != propertiesHost_) {
@@ -572,6 +798,52 @@ void MainWindow::onNodeSelected(QtNodes::NodeId nodeId)
         });
     }
 
+    // Concurrency applies to reentrant nodes only; the others always run one at a time
+    if (concurrencySpin_ && outputOrderCheck_) {
+        const bool reentrant = delegate->node() && delegate->node()->isReentrant();
+        disconnect(concurrencySpin_, &QSpinBox::valueChanged, nullptr, nullptr);
+        disconnect(outputOrderCheck_, &QCheckBox::toggled, nullptr, nullptr);
+        {
+            const QSignalBlocker spinBlocker(concurrencySpin_);
+            const QSignalBlocker checkBlocker(outputOrderCheck_);
+            concurrencySpin_->setValue(reentrant ? delegate->maxConcurrentExecutions() : 1);
+            outputOrderCheck_->setChecked(delegate->preservesOutputOrder());
+        }
+        concurrencySpin_->setEnabled(reentrant);
+        outputOrderCheck_->setEnabled(reentrant && delegate->maxConcurrentExecutions() > 1);
+        connect(concurrencySpin_, &QSpinBox::valueChanged, this, [this, delegate](int count) {
+            delegate->setMaxConcurrentExecutions(count);
+            outputOrderCheck_->setEnabled(count > 1);
+        });
+        connect(outputOrderCheck_, &QCheckBox::toggled, this, [delegate](bool ordered) {
+            delegate->setPreservesOutputOrder(ordered);
+        });
+    }
+
+    if (retryAttemptsSpin_ && retryBackoffSpin_) {
+        disconnect(retryAttemptsSpin_, &QSpinBox::valueChanged, nullptr, nullptr);
+        disconnect(retryBackoffSpin_, &QSpinBox::valueChanged, nullptr, nullptr);
+        const RetryPolicy policy = delegate->retryPolicy();
+        {
+            const QSignalBlocker attemptsBlocker(retryAttemptsSpin_);
+            const QSignalBlocker backoffBlocker(retryBackoffSpin_);
+            retryAttemptsSpin_->setValue(policy.maxAttempts);
+            retryBackoffSpin_->setValue(policy.baseDelayMs);
+        }
+        retryBackoffSpin_->setEnabled(policy.retries());
+        connect(retryAttemptsSpin_, &QSpinBox::valueChanged, this, [this, delegate](int attempts) {
+            RetryPolicy updated = delegate->retryPolicy();
+            updated.maxAttempts = attempts;
+            delegate->setRetryPolicy(updated);
+            retryBackoffSpin_->setEnabled(attempts > 1);
+        });
+        connect(retryBackoffSpin_, &QSpinBox::valueChanged, this, [delegate](int ms) {
+            RetryPolicy updated = delegate->retryPolicy();
+            updated.baseDelayMs = ms;
+            delegate->setRetryPolicy(updated);
+        });
+    }
+
     // Request the configuration widget from ToolNodeDelegate (not embedded in node)
     QWidget* cfg = delegate->configurationWidget();
     setPropertiesWidget(cfg);
@@ -608,6 +880,9 @@ void MainWindow::openChildGraph(const QString& bodyId, const QString& title, int
     }
 
     connectGraphModelSignals(body);
+    // Only the body on screen reports every pass's execution states
+    model->setExecutionObserved(false);
+    body->setExecutionObserved(true);
     graphStack_.append(qMakePair(model, currentGraphLabel_));
     currentGraphModel_ = body;
     currentGraphLabel_ = title.isEmpty() ? tr("Scope Body") : title;
@@ -626,7 +901,11 @@ void MainWindow::navigateBackGraph()
         return;
     }
     const auto entry = graphStack_.takeLast();
+    if (currentGraphModel_) {
+        currentGraphModel_->setExecutionObserved(false);
+    }
     currentGraphModel_ = entry.first ? entry.first : _graphModel;
+    currentGraphModel_->setExecutionObserved(true);
     currentGraphLabel_ = entry.second.isEmpty() ? QStringLiteral("Root") : entry.second;
 
     setPropertiesWidget(nullptr);
@@ -667,7 +946,8 @@ bool MainWindow::savePipelineToFile(const QString& fileName)
         return false;
     }
 
-    const QByteArray data = QJsonDocument(_graphModel->save()).toJson();
+    const QByteArray data = PipelineFormat::isCompactPath(fileName) ? _graphModel->saveCompact()
+                                                                    : QJsonDocument(_graphModel->save()).toJson();
     const qint64 bytesWritten = file.write(data);
     if (bytesWritten != data.size()) {
         QMessageBox::warning(this, tr("Save Failed"),
@@ -709,11 +989,12 @@ void MainWindow::onSaveAs()
     QString fileName = QFileDialog::getSaveFileName(this,
                                                     tr("Save Pipeline As"),
                                                     QDir::homePath(),
-                                                    tr("Flow Scene Files (*.flow);;JSON Files (*.json);;All Files (*)"));
+                                                    tr("Flow Scene Files (*.flow);;Compact Flow Files (*.cflow);;JSON Files (*.json);;All Files (*)"));
     if (fileName.isEmpty()) return;
 
     if (!fileName.endsWith(".flow", Qt::CaseInsensitive) &&
-        !fileName.endsWith(".json", Qt::CaseInsensitive)) {
+        !fileName.endsWith(".json", Qt::CaseInsensitive) &&
+        !PipelineFormat::isCompactPath(fileName)) {
         fileName += ".flow";
     }
 
@@ -749,12 +1030,116 @@ void MainWindow::runScenarioFromNodeId(unsigned int nodeId)
     execEngine_->Run(nodeId);
 }
 
+void MainWindow::runChangedNodes()
+{
+    if (!execEngine_) {
+        return;
+    }
+
+    // Unchanged nodes keep their outputs, so leave Text Output displays alone
+    if (stageOutputText_) {
+        stageOutputText_->clear();
+    }
+
+    if (m_currentFileName.isEmpty()) {
+        execEngine_->setProjectName(QStringLiteral("Untitled"));
+    } else {
+        execEngine_->setProjectName(QFileInfo(m_currentFileName).baseName());
+    }
+
+    execEngine_->runPipeline({}, ExecutionEngine::TaskPriority::Normal, ExecutionEngine::RunMode::Incremental);
+}
+
+void MainWindow::resumeLastRun()
+{
+    if (!execEngine_) {
+        return;
+    }
+
+    if (stageOutputText_) {
+        stageOutputText_->clear();
+    }
+    clearAllTextOutputNodes();
+
+    if (m_currentFileName.isEmpty()) {
+        execEngine_->setProjectName(QStringLiteral("Untitled"));
+    } else {
+        execEngine_->setProjectName(QFileInfo(m_currentFileName).baseName());
+    }
+
+    execEngine_->resumePipeline();
+}
+
 void MainWindow::onStopPipeline() {
     if (execEngine_) {
         execEngine_->stop();
     }
 }
 
+void MainWindow::refreshRunHistory(const QString& project, const QString& graphHash)
+{
+    const auto history = RunHistory::shared();
+    if (!history) return;
+    runHistoryEntries_ = history->runs(project, graphHash);
+
+    const QSignalBlocker blocker(runHistoryTable_);
+    runHistoryTable_->clearSelection();
+    runHistoryTable_->setRowCount(runHistoryEntries_.size());
+    for (int row = 0; row < runHistoryEntries_.size(); ++row) {
+        const RunHistory::Entry& entry = runHistoryEntries_.at(row);
+        const RunUsageReport::Totals& total = entry.report.total;
+        const QStringList cells {
+            QLocale().toString(entry.startedAt, QLocale::ShortFormat),
+            entry.succeeded ? tr("OK") : tr("Failed"),
+            QString::number(entry.report.wallUs / 1000.0, 'f', 1),
+            QString::number(total.queueWaitUs / 1000.0, 'f', 1),
+            QString::number(total.totalTokens),
+            total.calls > 0 ? QStringLiteral("%1/%2").arg(total.cacheHits).arg(total.calls) : QStringLiteral("-"),
+            QString::number(total.retries)};
+        for (int column = 0; column < cells.size(); ++column) {
+            runHistoryTable_->setItem(row, column, new QTableWidgetItem(cells.at(column)));
+        }
+    }
+    compareSelectedRuns();
+}
+
+void MainWindow::compareSelectedRuns()
+{
+    if (runHistoryEntries_.isEmpty()) {
+        runHistoryText_->setPlainText(tr("No runs of this pipeline recorded yet."));
+        return;
+    }
+    QList<int> rows;
+    for (const QModelIndex& index : runHistoryTable_->selectionModel()->selectedRows()) rows.append(index.row());
+    std::sort(rows.begin(), rows.end());
+
+    // Two or more rows: the newest against the oldest. One or none: that run, or the
+    // latest, against the median of the runs before it
+    RunHistory::Entry baseline;
+    QString heading;
+    const int index = rows.isEmpty() ? 0 : rows.first();
+    const RunHistory::Entry& current = runHistoryEntries_.at(index);
+    const QString started = QLocale().toString(current.startedAt, QLocale::ShortFormat);
+    if (rows.size() >= 2) {
+        baseline = runHistoryEntries_.at(rows.last());
+        heading = tr("Run of %1 against the run of %2")
+                      .arg(started, QLocale().toString(baseline.startedAt, QLocale::ShortFormat));
+    } else {
+        const QList<RunHistory::Entry> earlier = runHistoryEntries_.mid(index + 1, RunHistory::kBaselineRuns);
+        baseline = RunHistory::baseline(earlier);
+        const auto successful = std::count_if(earlier.cbegin(), earlier.cend(),
+                                              [](const RunHistory::Entry& entry) { return entry.succeeded; });
+        heading = tr("Run of %1 against the median of %2 earlier successful run(s)")
+                      .arg(started).arg(successful);
+    }
+    if (!baseline.report.isValid()) {
+        runHistoryText_->setPlainText(tr("Run of %1: no earlier successful run to compare against.").arg(started));
+        return;
+    }
+    runHistoryText_->setPlainText(heading + QStringLiteral("\n\n")
+                                  + RunHistory::compare(baseline, current).summary());
+}
+
 void MainWindow::populateRunMenu()
 {
     if (!runMenu_) return;
@@ -773,6 +1158,19 @@ void MainWindow::populateRunMenu()
             }
         });
     }
+
+    runMenu_->addSeparator();
+    QAction* changedAct = runMenu_->addAction(tr("Run Changed Nodes"));
+    changedAct->setStatusTip(tr("Re-run nodes changed since the last successful run, reusing other outputs"));
+    connect(changedAct, &QAction::triggered, this, &MainWindow::runChangedNodes);
+
+    QAction* resumeAct = runMenu_->addAction(tr("Resume Last Run"));
+    resumeAct->setStatusTip(tr("Run again, reusing the work the last checkpointed run finished before it stopped"));
+    // The checkpoint lives in the project's output directory
+    execEngine_->setProjectName(m_currentFileName.isEmpty() ? QStringLiteral("Untitled")
+                                                            : QFileInfo(m_currentFileName).baseName());
+    resumeAct->setEnabled(execEngine_->hasCheckpoint());
+    connect(resumeAct, &QAction::triggered, this, &MainWindow::resumeLastRun);
 }
 
 void MainWindow::onEditCredentials()
@@ -793,12 +1191,22 @@ void MainWindow::onSyntaxHighlightingOptions()
     dialog.exec();
 }
 
+void MainWindow::onResourceBudgets()
+{
+    if (!_graphModel) return;
+    ResourceBudgetsDialog dialog(ResourceBudgets::fromJson(_graphModel->resourceBudgets()), this);
+    if (dialog.exec() == QDialog::Accepted) {
+        // Stored on the root graph so it is saved with the pipeline; applied on the next run
+        _graphModel->setResourceBudgets(dialog.budgets().toJson());
+    }
+}
+
 void MainWindow::onOpen()
 {
     QString fileName = QFileDialog::getOpenFileName(this,
                                                     tr("Open Pipeline"),
                                                     QDir::homePath(),
-                                                    tr("Flow Scene Files (*.flow);;JSON Files (*.json);;All Files (*)"));
+                                                    tr("Pipeline Files (*.flow *.cflow *.json);;All Files (*)"));
     if (fileName.isEmpty()) return;
 
     QFile file(fileName);
@@ -811,56 +1219,28 @@ void MainWindow::onOpen()
     const QByteArray data = file.readAll();
     file.close();
 
-    QJsonParseError parseErr{};
-    const QJsonDocument doc = QJsonDocument::fromJson(data, &parseErr);
-    if (parseErr.error != QJsonParseError::NoError || !doc.isObject()) {
-        QMessageBox::warning(this, tr("Open Failed"),
-                             tr("Invalid JSON in file: %1").arg(parseErr.errorString()));
-        return;
-    }
-
-    // Migrate legacy model names to current IDs and infer when missing
-    QJsonObject migrated = doc.object();
-    QJsonArray nodesArray = migrated.value(QStringLiteral("nodes")).toArray();
-    for (int i = 0; i < nodesArray.size(); ++i) {
-        QJsonObject nodeObj = nodesArray.at(i).toObject();
-        QJsonObject internal = nodeObj.value(QStringLiteral("internal-data")).toObject();
-        const QString modelName = internal.value(QStringLiteral("model-name")).toString();
-        QString mapped = modelName;
-
-        if (modelName.isEmpty()) {
-            // Infer from known state keys when model-name is absent (older saves)
-            if (internal.contains(QStringLiteral("text"))) {
-                mapped = QStringLiteral("text-input");
-            } else if (internal.contains(QStringLiteral("template"))) {
-                mapped = QStringLiteral("prompt-builder");
-            } else if (internal.contains(QStringLiteral("apiKey")) || internal.contains(QStringLiteral("prompt"))) {
-                // Legacy LLM connector saves should map to universal-llm
-                mapped = QStringLiteral("universal-llm");
-            } else {
-                // Fallback to a safe default to allow loading
-                mapped = QStringLiteral("text-input");
-            }
-        } else {
-            // Remap legacy human-readable names to stable IDs
-            if (modelName == QStringLiteral("LLM Connector") || modelName == QStringLiteral("LLMConnector") ||
-                modelName == QStringLiteral("Google LLM Connector") || modelName == QStringLiteral("GoogleLLMConnector") ||
-                modelName == QStringLiteral("llm-connector") || modelName == QStringLiteral("google-llm-connector")) {
-                mapped = QStringLiteral("universal-llm");
-            } else if (modelName == QStringLiteral("Prompt Builder") || modelName == QStringLiteral("PromptBuilderNode")) {
-                mapped = QStringLiteral("prompt-builder");
-            } else if (modelName == QStringLiteral("Text Input") || modelName == QStringLiteral("TextInputNode")) {
-                mapped = QStringLiteral("text-input");
-            }
+    // Compact files are recognised by content, whatever their extension
+    const bool compact = PipelineFormat::isCompact(data);
+    PipelineFormat::Container container;
+    QJsonObject migrated;
+    if (compact) {
+        QString error;
+        if (!PipelineFormat::decode(data, container, &error)) {
+            QMessageBox::warning(this, tr("Open Failed"), error);
+            return;
         }
-
-        if ((mapped != modelName || modelName.isEmpty()) && !mapped.isEmpty()) {
-            internal.insert(QStringLiteral("model-name"), mapped);
-            nodeObj.insert(QStringLiteral("internal-data"), internal);
-            nodesArray.replace(i, nodeObj);
+    } else {
+        QJsonParseError parseErr{};
+        const QJsonDocument doc = QJsonDocument::fromJson(data, &parseErr);
+        if (parseErr.error != QJsonParseError::NoError || !doc.isObject()) {
+            QMessageBox::warning(this, tr("Open Failed"),
+                                 tr("Invalid JSON in file: %1").arg(parseErr.errorString()));
+            return;
         }
+
+        // Migrate legacy model names to current IDs and infer when missing
+        migrated = NodeGraphModel::migrateLegacyPipeline(doc.object());
     }
-    migrated.insert(QStringLiteral("nodes"), nodesArray);
 
     // Clear UI state only after the file has been parsed successfully.
     if (stageOutputText_) {
@@ -884,7 +1264,9 @@ void MainWindow::onOpen()
     }
 
     try {
-        if (_graphModel) {
+        if (_graphModel && compact) {
+            _graphModel->loadCompact(container);
+        } else if (_graphModel) {
             _graphModel->load(migrated);
         }
     } catch (const std::exception& e) {
@@ -921,6 +1303,7 @@ void MainWindow::onOpen()
                                 boundingRect.width() * margin,
                                 boundingRect.height() * margin);
             _graphView->fitInView(boundingRect, Qt::KeepAspectRatio);
+            canvasDetail_->scheduleRefresh();
         }
     }
 
@@ -1008,8 +1391,26 @@ void MainWindow::onNodeLog(const QString& message)
     if (!enableDebugLoggingAction_ || !enableDebugLoggingAction_->isChecked()) {
         return;
     }
-    if (debugLogText_) {
-        debugLogText_->append(message);
+    if (debugLogView_) {
+        debugLogView_->appendLine(message);
+    }
+}
+
+void MainWindow::onNodeLogLines(const QStringList& lines)
+{
+    if (!enableDebugLoggingAction_ || !enableDebugLoggingAction_->isChecked()) {
+        return;
+    }
+    if (debugLogView_) {
+        debugLogView_->appendLines(lines);
+    }
+}
+
+void MainWindow::logMessages(const QStringList& lines)
+{
+    if (s_instance) {
+        QMetaObject::invokeMethod(s_instance, "onNodeLogLines", Qt::QueuedConnection,
+                                  Q_ARG(QStringList, lines));
     }
 }
 
@@ -1026,21 +1427,52 @@ bool MainWindow::instanceExists()
     return s_instance != nullptr;
 }
 
-bool MainWindow::requestUserInput(const QString& prompt, QString& outText)
+void MainWindow::onHumanInputQueued(quint64 id, const QString& prompt)
 {
-    UserInputDialog dialog(prompt, this);
-    if (dialog.exec() == QDialog::Accepted) {
-        outText = dialog.getText();
-        return true;
+    humanInputPrompts_.append(HumanInputQueue::Prompt{id, prompt});
+    showNextHumanInput();
+}
+
+void MainWindow::onHumanInputClosed(quint64 id)
+{
+    humanInputPrompts_.erase(std::remove_if(humanInputPrompts_.begin(), humanInputPrompts_.end(),
+                                            [id](const HumanInputQueue::Prompt& p) { return p.id == id; }),
+                             humanInputPrompts_.end());
+    // Withdrawn (run stopped) or answered elsewhere while its dialog is up
+    if (humanInputDialog_ && humanInputDialogId_ == id) {
+        humanInputDialog_->reject();
     }
-    outText = QString(); // Clear output on cancel
-    return false; // User canceled
+}
+
+void MainWindow::showNextHumanInput()
+{
+    if (humanInputDialog_ || humanInputPrompts_.isEmpty()) return;
+    const HumanInputQueue::Prompt prompt = humanInputPrompts_.takeFirst();
+    auto* dialog = new UserInputDialog(prompt.text, this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    humanInputDialog_ = dialog;
+    humanInputDialogId_ = prompt.id;
+    connect(dialog, &QDialog::finished, this, [this, dialog, id = prompt.id](int result) {
+        if (result == QDialog::Accepted) {
+            HumanInputQueue::instance().answer(id, dialog->getText());
+        } else {
+            HumanInputQueue::instance().decline(id);
+        }
+        humanInputDialog_ = nullptr;
+        QTimer::singleShot(0, this, &MainWindow::showNextHumanInput);
+    });
+    // Window-modal but not blocking: the event loop and the run go on while it is open
+    dialog->open();
 }
 
 
 MainWindow::~MainWindow()
 {
     s_instance = nullptr;
+    AppLogHelper::setLineViewer(nullptr);
+    IngestInputNode::setRunRequestHandler({});
+    HumanInputQueue::instance().disconnect(this);
+    HumanInputQueue::instance().detachFrontEnd();
     // Ensure properties panel does not hold onto any widget
     setPropertiesWidget(nullptr);
 
@@ -1063,35 +1495,37 @@ MainWindow::~MainWindow()
 }
 
 
-void MainWindow::onNodeRepaint(const QUuid& nodeUuid)
+void MainWindow::onExecutionItemsChanged(const QList<QUuid>& ids)
 {
-    // Find the node by deterministic execution UUID and repaint its graphics object
     auto *qscene = _graphView ? _graphView->scene() : nullptr;
     auto *scene = qscene ? dynamic_cast<QtNodes::BasicGraphicsScene*>(qscene) : nullptr;
     NodeGraphModel* model = activeGraphModel();
-    if (!scene || !model)
+    if (!scene || !model || ids.isEmpty())
         return;
 
-    QtNodes::NodeId foundId = 0;
-    bool found = false;
+    // Map the deterministic execution UUIDs back in one pass over the graph, and let
+    // each item's update() invalidate only its own rectangle
+    const QSet<QUuid> dirty(ids.cbegin(), ids.cend());
+    const QString scopeKey = model->executionScopeKey();
+    qsizetype remaining = dirty.size();
     for (auto nid : model->allNodeIds()) {
-        if (ExecIds::nodeUuid(model->executionScopeKey(), nid) == nodeUuid) {
-            foundId = nid;
-            found = true;
-            break;
+        if (dirty.contains(ExecIds::nodeUuid(scopeKey, nid))) {
+            if (auto *ngo = scene->nodeGraphicsObject(nid))
+                ngo->update();
+            if (--remaining == 0)
+                return;
         }
-    }
-
-    if (found) {
-        if (auto *ngo = scene->nodeGraphicsObject(foundId)) {
-            // Trigger a repaint of this specific item so our custom painter runs
-            ngo->update();
-            return;
+        for (const auto& connId : model->allConnectionIds(nid)) {
+            // Each connection is visited from its source node only
+            if (connId.outNodeId != nid || !dirty.contains(ExecIds::connectionUuid(scopeKey, connId)))
+                continue;
+            if (auto *cgo = scene->connectionGraphicsObject(connId))
+                cgo->update();
+            if (--remaining == 0)
+                return;
         }
     }
-
-    // Fallback: if not found, update the whole scene (should be rare)
-    scene->update();
+    // Ids from another graph (a child graph's run) have nothing on this canvas
 }
 
 void MainWindow::refreshStageOutput()
@@ -1219,23 +1653,17 @@ void MainWindow::onSaveOutput()
         return;
     }
 
-    const QString text = stageOutputText_->toPlainText();
-
-    QFile file(fileName);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
-        QMessageBox::warning(this, tr("Save Failed"),
-                             tr("Could not open file for writing:\n%1").arg(file.errorString()));
-        return;
-    }
-
-    const QByteArray bytes = text.toUtf8();
-    if (file.write(bytes) != bytes.size()) {
-        QMessageBox::warning(this, tr("Save Failed"),
-                             tr("Could not write all data to file:\n%1").arg(file.errorString()));
-        file.close();
-        return;
-    }
-
-    file.close();
-    statusBar()->showMessage(tr("Output saved to %1").arg(QFileInfo(fileName).fileName()), 3000);
+    // Encoded and written on a pool thread so a large output does not hold up the UI
+    auto* watcher = new QFutureWatcher<QString>(this);
+    connect(watcher, &QFutureWatcher<QString>::finished, this, [this, watcher, fileName]() {
+        const QString error = watcher->result();
+        watcher->deleteLater();
+        if (!error.isEmpty()) {
+            QMessageBox::warning(this, tr("Save Failed"),
+                                 tr("Could not write output file:\n%1").arg(error));
+            return;
+        }
+        statusBar()->showMessage(tr("Output saved to %1").arg(QFileInfo(fileName).fileName()), 3000);
+    });
+    watcher->setFuture(LargeTextView::saveTextAsync(stageOutputText_->toPlainText(), fileName));
 }
@@ -28,6 +28,8 @@
 #include "ExecutionEngine.h"
 #include "ExecutionStateModel.h"
 #include "UserInputDialog.h"
+#include "HumanInputQueue.h"
+#include "RunHistory.h"
 
 #include <memory>
 #include <QPointer>
@@ -41,11 +43,15 @@ class QComboBox;
 class QDockWidget;
 class QVBoxLayout;
 class QLabel;
-class QTextEdit;
 class QPlainTextEdit;
 class QMenu;
-class QSpinBox; // legacy; not used after Slow Motion refactor
+class QSpinBox;
+class QCheckBox;
+class QTableWidget;
 class NodeGraphModel;
+class LargeTextView;
+class DebugLogView;
+class CanvasDetailController;
 
 namespace QtNodes {
 class GraphicsView;
@@ -71,15 +77,19 @@ public slots:
     void onPipelineFinished(const DataPacket& finalOutput);
     // Per-node debug logging
     void onNodeLog(const QString& message);
+    void onNodeLogLines(const QStringList& lines);
     void runScenarioFromNodeId(unsigned int nodeId);
+    // Re-runs only nodes changed since the last successful run and their downstream nodes
+    void runChangedNodes();
+    // Runs again from the last checkpoint, skipping the node work it saved
+    void resumeLastRun();
 
     // Global static access for logging from anywhere
     static void logMessage(const QString& message);
+    // One queued call for a whole batch, as the log sink's writer delivers them
+    static void logMessages(const QStringList& lines);
     static bool instanceExists();
 
-    // Request user input from worker thread (blocking)
-    // Returns true if user accepted (OK), false if canceled
-    Q_INVOKABLE bool requestUserInput(const QString& prompt, QString& outText);
 
 private slots:
     void onAbout();
@@ -89,6 +99,7 @@ private slots:
     void onEditCredentials();
     void onManageProviders();
     void onSyntaxHighlightingOptions();
+    void onResourceBudgets();
     void onClearCanvas();
     void onSaveOutput();
     void onDeleteSelected();
@@ -103,7 +114,7 @@ private slots:
     void navigateBackGraph();
 
     // Execution highlighting: repaint a specific node by execution QUuid
-    void onNodeRepaint(const QUuid& nodeUuid);
+    void onExecutionItemsChanged(const QList<QUuid>& ids);
 
 private:
     void createActions();
@@ -111,6 +122,9 @@ private:
     void createToolBar();
     void createStatusBar();
     void populateRunMenu();
+    // Run History dock: reload one graph's runs, compare the selected ones
+    void refreshRunHistory(const QString& project, const QString& graphHash);
+    void compareSelectedRuns();
 
     void setPropertiesWidget(QWidget* w);
     void refreshStageOutput();
@@ -121,6 +135,10 @@ private:
     void updateGraphNavigation();
     NodeGraphModel* activeGraphModel() const;
     bool savePipelineToFile(const QString& fileName);
+    // Human Input prompts, shown one non-modal dialog at a time
+    void onHumanInputQueued(quint64 id, const QString& prompt);
+    void onHumanInputClosed(quint64 id);
+    void showNextHumanInput();
 
     QAction* exitAction {nullptr};
     QAction* openAction_ {nullptr};
@@ -132,8 +150,16 @@ private:
     QAction* stopAction_ {nullptr};
     QAction* saveOutputAction_ {nullptr};
     QAction* showDebugLogAction_ {nullptr};
+    QAction* showRunAnalysisAction_ {nullptr};
+    QAction* showRunUsageAction_ {nullptr};
+    QAction* showRunHistoryAction_ {nullptr};
     QAction* enableDebugLoggingAction_ {nullptr};
     QAction* slowMotionAction_ {nullptr};
+    QAction* resultCacheAction_ {nullptr};
+    QAction* llmResponseCacheAction_ {nullptr};
+    QAction* traceAction_ {nullptr};
+    QAction* checkpointAction_ {nullptr};
+    QAction* resourceBudgetsAction_ {nullptr};
     QAction* editCredentialsAction_ {nullptr};
     QAction* manageProvidersAction_ {nullptr};
     QAction* syntaxHighlightingOptionsAction_ {nullptr};
@@ -147,6 +173,7 @@ private:
     NodeGraphModel* _graphModel {nullptr};
     NodeGraphModel* currentGraphModel_ {nullptr};
     QtNodes::GraphicsView* _graphView {nullptr};
+    CanvasDetailController* canvasDetail_ {nullptr};
     QVector<QPair<NodeGraphModel*, QString>> graphStack_;
     QString currentGraphLabel_ {QStringLiteral("Root")};
     QSet<NodeGraphModel*> connectedGraphModels_;
@@ -160,14 +187,36 @@ private:
     QLabel* placeholderLabel_ {nullptr};
     QLabel* descriptionLabel_ {nullptr};
     QPlainTextEdit* descriptionEdit_ {nullptr};
+    // Generic execution settings of the selected node (ToolNodeDelegate)
+    QLabel* concurrencyLabel_ {nullptr};
+    QSpinBox* concurrencySpin_ {nullptr};
+    QCheckBox* outputOrderCheck_ {nullptr};
+    QLabel* retryLabel_ {nullptr};
+    QSpinBox* retryAttemptsSpin_ {nullptr};
+    QSpinBox* retryBackoffSpin_ {nullptr};
     QPointer<QWidget> currentConfigWidget_ {nullptr};
 
+    QList<HumanInputQueue::Prompt> humanInputPrompts_;
+    QPointer<UserInputDialog> humanInputDialog_;
+    quint64 humanInputDialogId_ {0};
+
     // Output docks
     QDockWidget* stageOutputDock_ {nullptr};
-    QTextEdit* stageOutputText_ {nullptr};
+    LargeTextView* stageOutputText_ {nullptr};
 
     QDockWidget* debugLogDock_ {nullptr};
-    QTextEdit* debugLogText_ {nullptr};
+    DebugLogView* debugLogView_ {nullptr};
+
+    QDockWidget* runAnalysisDock_ {nullptr};
+    QPlainTextEdit* runAnalysisText_ {nullptr};
+
+    QDockWidget* runUsageDock_ {nullptr};
+    QPlainTextEdit* runUsageText_ {nullptr};
+
+    QDockWidget* runHistoryDock_ {nullptr};
+    QTableWidget* runHistoryTable_ {nullptr};
+    QPlainTextEdit* runHistoryText_ {nullptr};
+    QList<RunHistory::Entry> runHistoryEntries_; // newest first, as in the table
 
     // Execution delay control removed in favor of a simple menu toggle
 
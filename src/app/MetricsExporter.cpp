@@ -0,0 +1,206 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "MetricsExporter.h"
+#include "MetricsRegistry.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QMetaObject>
+#include <QObject>
+#include <QSaveFile>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+
+#include "HttpServerSupport.h"
+#include "Logger.h"
+
+namespace {
+
+// Scrapes are a request line and headers, without a body
+constexpr qsizetype kMaxRequestBytes = HttpServerSupport::kMaxHeaderBytes;
+
+QByteArray textResponse(int status, const QByteArray& text)
+{
+    return HttpServerSupport::response(status, "text/plain; charset=utf-8", text);
+}
+
+} // namespace
+
+MetricsExporter::Config MetricsExporter::Config::fromEnvironment()
+{
+    Config config;
+    bool ok = false;
+    const int port = qEnvironmentVariableIntValue("CP_METRICS_PORT", &ok);
+    if (ok && port >= 0 && port <= 65535) {
+        config.port = port;
+    }
+    const QString address = qEnvironmentVariable("CP_METRICS_ADDRESS");
+    if (!address.isEmpty()) {
+        config.address = QHostAddress(address);
+    }
+    config.jsonPath = qEnvironmentVariable("CP_METRICS_JSON");
+    const int interval = qEnvironmentVariableIntValue("CP_METRICS_JSON_INTERVAL", &ok);
+    if (ok && interval > 0) {
+        config.jsonIntervalSeconds = interval;
+    }
+    return config;
+}
+
+MetricsExporter::MetricsExporter(Config config, MetricsRegistry* registry)
+    : m_config(std::move(config))
+    , m_registry(registry ? *registry : MetricsRegistry::instance())
+{
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+    }
+    if (!m_config.jsonPath.isEmpty()) {
+        writeJson();
+    }
+}
+
+bool MetricsExporter::start(QString* error)
+{
+    if (m_thread || (m_config.port < 0 && m_config.jsonPath.isEmpty())) {
+        return true;
+    }
+    m_thread = std::make_unique<QThread>();
+    m_thread->setObjectName(QStringLiteral("MetricsExporter"));
+    m_context = new QObject;
+    m_context->moveToThread(m_thread.get());
+    QObject::connect(m_thread.get(), &QThread::finished, m_context, &QObject::deleteLater);
+    m_thread->start();
+
+    bool listening = true;
+    QString listenError;
+    QMetaObject::invokeMethod(m_context, [&]() {
+        if (!m_config.jsonPath.isEmpty()) {
+            auto* timer = new QTimer(m_context);
+            timer->setInterval(m_config.jsonIntervalSeconds * 1000);
+            QObject::connect(timer, &QTimer::timeout, m_context, [this]() { writeJson(); });
+            timer->start();
+        }
+        if (m_config.port < 0) {
+            return;
+        }
+        m_server = new QTcpServer(m_context);
+        if (!m_server->listen(m_config.address, static_cast<quint16>(m_config.port))) {
+            listening = false;
+            listenError = m_server->errorString();
+            return;
+        }
+        m_port = m_server->serverPort();
+        QObject::connect(m_server, &QTcpServer::newConnection, m_context, [this]() {
+            while (QTcpSocket* socket = m_server->nextPendingConnection()) {
+                QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+                HttpServerSupport::watchRequestRead(socket);
+                QObject::connect(socket, &QTcpSocket::readyRead, socket, [this, socket]() {
+                    if (HttpServerSupport::isRequestRead(socket)) {
+                        socket->readAll();
+                        return;
+                    }
+                    // Buffered by the socket until the headers are complete
+                    const QByteArray request = socket->peek(kMaxRequestBytes);
+                    if (!request.contains("\r\n\r\n") && request.size() < kMaxRequestBytes) {
+                        return;
+                    }
+                    HttpServerSupport::markRequestRead(socket);
+                    socket->readAll();
+                    socket->write(respond(request, m_registry));
+                    socket->disconnectFromHost();
+                });
+            }
+        });
+    }, Qt::BlockingQueuedConnection);
+
+    if (!listening) {
+        const QString message = QStringLiteral("MetricsExporter: cannot listen on %1:%2: %3")
+                                    .arg(m_config.address.toString())
+                                    .arg(m_config.port)
+                                    .arg(listenError);
+        CP_WARN << message;
+        if (error) {
+            *error = message;
+        }
+        return false;
+    }
+    if (m_port != 0) {
+        CP_CLOG(metrics) << "Serving metrics on http://" << m_config.address.toString() << ":" << m_port
+                         << "/metrics";
+    }
+    return true;
+}
+
+bool MetricsExporter::writeJson()
+{
+    QDir().mkpath(QFileInfo(m_config.jsonPath).absolutePath());
+    QSaveFile file(m_config.jsonPath);
+    const bool written = file.open(QIODevice::WriteOnly)
+        && file.write(QJsonDocument(m_registry.toJson()).toJson(QJsonDocument::Compact)) >= 0 && file.commit();
+    if (!written && !m_jsonFailed) {
+        m_jsonFailed = true;
+        CP_WARN << "MetricsExporter: cannot write" << m_config.jsonPath << ":" << file.errorString();
+    }
+    return written;
+}
+
+QByteArray MetricsExporter::respond(const QByteArray& request, const MetricsRegistry& registry)
+{
+    const qsizetype lineEnd = request.indexOf("\r\n");
+    const QList<QByteArray> requestLine = request.left(lineEnd < 0 ? request.size() : lineEnd).split(' ');
+    if (requestLine.size() < 2) {
+        return textResponse(400, "Bad request\n");
+    }
+    const QByteArray& method = requestLine.at(0);
+    const bool head = method == "HEAD";
+    if (method != "GET" && !head) {
+        return textResponse(405, "Only GET is served\n");
+    }
+    QByteArray path = requestLine.at(1);
+    const qsizetype query = path.indexOf('?');
+    if (query >= 0) {
+        path.truncate(query);
+    }
+
+    if (path == "/metrics") {
+        if (request.toLower().contains("application/openmetrics-text")) {
+            return HttpServerSupport::response(200, "application/openmetrics-text; version=1.0.0; charset=utf-8",
+                                               registry.exposition(MetricsRegistry::TextFormat::OpenMetrics), {}, !head);
+        }
+        return HttpServerSupport::response(200, "text/plain; version=0.0.4; charset=utf-8",
+                                           registry.exposition(MetricsRegistry::TextFormat::Prometheus), {}, !head);
+    }
+    if (path == "/metrics.json") {
+        return HttpServerSupport::jsonResponse(200, QJsonDocument(registry.toJson()).toJson(QJsonDocument::Compact),
+                                               {}, !head);
+    }
+    return textResponse(404, "Not found\n");
+}
@@ -0,0 +1,84 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QString>
+
+#include <memory>
+
+class MetricsRegistry;
+class QObject;
+class QTcpServer;
+class QThread;
+
+// Publishes a MetricsRegistry for servers that run the app headless. Both outputs run
+// on a thread of their own, so a scrape is answered while the GUI or the engine is busy.
+//   CP_METRICS_PORT=<port>          serves GET /metrics in the Prometheus text format
+//                                   (OpenMetrics when the Accept header asks for it) and
+//                                   GET /metrics.json, on 127.0.0.1 unless
+//                                   CP_METRICS_ADDRESS names another address
+//   CP_METRICS_JSON=<path>          writes the JSON every CP_METRICS_JSON_INTERVAL
+//                                   seconds (15 by default) and once more on exit
+class MetricsExporter {
+public:
+    static constexpr int kDefaultJsonIntervalSeconds = 15;
+
+    struct Config {
+        // -1 leaves the endpoint off; 0 takes any free port
+        int port {-1};
+        QHostAddress address {QHostAddress::LocalHost};
+        QString jsonPath;
+        int jsonIntervalSeconds {kDefaultJsonIntervalSeconds};
+
+        static Config fromEnvironment();
+    };
+
+    // Exports MetricsRegistry::instance() unless another registry is given
+    explicit MetricsExporter(Config config, MetricsRegistry* registry = nullptr);
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    // Opens the endpoint and starts the JSON timer; does nothing when neither is configured
+    bool start(QString* error = nullptr);
+    // The port listened on, once started
+    quint16 serverPort() const { return m_port; }
+    // Writes the JSON file now
+    bool writeJson();
+
+    // The whole HTTP response to one request
+    static QByteArray respond(const QByteArray& request, const MetricsRegistry& registry);
+
+private:
+    Config m_config;
+    MetricsRegistry& m_registry;
+    std::unique_ptr<QThread> m_thread;
+    QObject* m_context {nullptr};
+    QTcpServer* m_server {nullptr};
+    quint16 m_port {0};
+    bool m_jsonFailed {false};
+};
@@ -0,0 +1,434 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "PipelineServer.h"
+
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QPointer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include <algorithm>
+
+#include "ExecutionEngine.h"
+#include "HumanInputQueue.h"
+#include "Logger.h"
+#include "MetricsRegistry.h"
+
+namespace {
+
+using HttpServerSupport::errorBody;
+using HttpServerSupport::jsonResponse;
+
+QByteArray serverSentEvent(const QByteArray& event, const QJsonObject& data)
+{
+    return "event: " + event + "\ndata: " + QJsonDocument(data).toJson(QJsonDocument::Compact) + "\n\n";
+}
+
+bool wantsStream(const PipelineServer::Request& request)
+{
+    const QByteArray stream = request.query.value("stream").toLower();
+    return stream == "1" || stream == "true" || request.headers.value("accept").contains("text/event-stream");
+}
+
+void recordRequest(int status, double seconds)
+{
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    metrics.counter(QStringLiteral("cp_server_requests"), QStringLiteral("Pipeline server run requests by status code"),
+                    {{QStringLiteral("status"), QString::number(status)}})
+        .increment();
+    metrics.histogram(QStringLiteral("cp_server_request_seconds"),
+                      QStringLiteral("Pipeline server run requests from arrival to answer, queueing included"))
+        .observe(seconds);
+}
+
+} // namespace
+
+struct PipelineServer::Job {
+    QPointer<QTcpSocket> socket;
+    QHash<QUuid, QVariantMap> presets;
+    bool stream {false};
+    ExecutionEngine::TaskPriority priority {ExecutionEngine::TaskPriority::Normal};
+    QDeadlineTimer deadline {QDeadlineTimer::Forever};
+    // Queue order, as the engine orders tasks: the deadline, or arrival plus the class slack
+    qint64 dueMs {0};
+    // Set while the run is in flight
+    QUuid runId;
+    QElapsedTimer age;
+    bool done {false};
+};
+
+PipelineServer::PipelineServer(ExecutionEngine* engine, InputResolver resolver, Config config, QObject* parent)
+    : QObject(parent)
+    , m_engine(engine)
+    , m_resolver(std::move(resolver))
+    , m_config(std::move(config))
+{
+    m_config.maxConcurrentRuns = qMax(1, m_config.maxConcurrentRuns);
+    m_config.maxQueuedRequests = qMax(0, m_config.maxQueuedRequests);
+    connect(m_engine, &ExecutionEngine::runFinished, this, &PipelineServer::onRunFinished);
+    connect(m_engine, &ExecutionEngine::runPartialOutput, this, &PipelineServer::onPartialOutput);
+}
+
+PipelineServer::~PipelineServer()
+{
+    disconnect(m_engine, nullptr, this, nullptr);
+    if (m_server) {
+        HumanInputQueue::instance().detachFrontEnd();
+    }
+    const QList<QUuid> running = m_running.keys();
+    m_running.clear();
+    m_queue.clear();
+    for (const QUuid& runId : running) {
+        m_engine->cancelRun(runId);
+    }
+}
+
+bool PipelineServer::start(QString* error)
+{
+    if (m_server) {
+        return true;
+    }
+    m_server = new QTcpServer(this);
+    if (!m_server->listen(m_config.address, static_cast<quint16>(m_config.port))) {
+        const QString message = QStringLiteral("PipelineServer: cannot listen on %1:%2: %3")
+                                    .arg(m_config.address.toString())
+                                    .arg(m_config.port)
+                                    .arg(m_server->errorString());
+        CP_WARN << message;
+        if (error) {
+            *error = message;
+        }
+        delete m_server;
+        m_server = nullptr;
+        return false;
+    }
+    connect(m_server, &QTcpServer::newConnection, this, [this]() {
+        while (QTcpSocket* socket = m_server->nextPendingConnection()) {
+            connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+            HttpServerSupport::watchRequestRead(socket);
+            connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { onReadyRead(socket); });
+        }
+    });
+    // Human Input prompts wait for answers on /input instead of failing
+    HumanInputQueue::instance().attachFrontEnd();
+    return true;
+}
+
+quint16 PipelineServer::serverPort() const
+{
+    return m_server ? m_server->serverPort() : 0;
+}
+
+void PipelineServer::onReadyRead(QTcpSocket* socket)
+{
+    // Anything after the request is ignored
+    if (HttpServerSupport::isRequestRead(socket)) {
+        socket->readAll();
+        return;
+    }
+    // Buffered by the socket until the request is complete
+    const QByteArray buffer = socket->peek(socket->bytesAvailable());
+    Request request;
+    const ParseResult parsed = parseRequest(buffer, request);
+    if (parsed == ParseResult::Incomplete) {
+        return;
+    }
+    HttpServerSupport::markRequestRead(socket);
+    socket->readAll();
+    if (parsed == ParseResult::Complete) {
+        handleRequest(socket, request);
+        return;
+    }
+    const bool tooLarge = parsed == ParseResult::TooLarge;
+    socket->write(jsonResponse(tooLarge ? 413 : 400,
+                               errorBody(tooLarge ? QStringLiteral("Request too large")
+                                                  : QStringLiteral("Malformed request"))));
+    socket->disconnectFromHost();
+}
+
+void PipelineServer::handleRequest(QTcpSocket* socket, const Request& request)
+{
+    if (request.path == "/health") {
+        const bool head = request.method == "HEAD";
+        if (request.method != "GET" && !head) {
+            socket->write(jsonResponse(405, errorBody(QStringLiteral("Only GET is served")), "Allow: GET, HEAD\r\n"));
+        } else {
+            const QJsonObject health{
+                {QStringLiteral("status"), QStringLiteral("ok")},
+                {QStringLiteral("running"), runningCount()},
+                {QStringLiteral("queued"), queuedCount()},
+                {QStringLiteral("maxConcurrentRuns"), m_config.maxConcurrentRuns},
+                {QStringLiteral("maxQueuedRequests"), m_config.maxQueuedRequests},
+            };
+            socket->write(jsonResponse(200, QJsonDocument(health).toJson(QJsonDocument::Compact), {}, !head));
+        }
+        socket->disconnectFromHost();
+        return;
+    }
+    if (request.path == "/input" || request.path.startsWith("/input/")) {
+        handleInput(socket, request);
+        socket->disconnectFromHost();
+        return;
+    }
+    if (request.path != "/run") {
+        socket->write(jsonResponse(404, errorBody(QStringLiteral("Not found"))));
+        socket->disconnectFromHost();
+        return;
+    }
+    if (request.method != "POST") {
+        socket->write(jsonResponse(405, errorBody(QStringLiteral("Runs are submitted with POST")), "Allow: POST\r\n"));
+        socket->disconnectFromHost();
+        return;
+    }
+    submit(socket, request);
+}
+
+void PipelineServer::handleInput(QTcpSocket* socket, const Request& request)
+{
+    HumanInputQueue& queue = HumanInputQueue::instance();
+    if (request.path == "/input") {
+        if (request.method != "GET") {
+            socket->write(jsonResponse(405, errorBody(QStringLiteral("Prompts are listed with GET")), "Allow: GET\r\n"));
+            return;
+        }
+        QJsonArray prompts;
+        for (const HumanInputQueue::Prompt& prompt : queue.pending()) {
+            prompts.append(QJsonObject{
+                {QStringLiteral("id"), QString::number(prompt.id)},
+                {QStringLiteral("prompt"), prompt.text},
+            });
+        }
+        socket->write(jsonResponse(200, QJsonDocument(QJsonObject{{QStringLiteral("prompts"), prompts}})
+                                            .toJson(QJsonDocument::Compact)));
+        return;
+    }
+
+    if (request.method != "POST") {
+        socket->write(jsonResponse(405, errorBody(QStringLiteral("Prompts are answered with POST")), "Allow: POST\r\n"));
+        return;
+    }
+    bool idOk = false;
+    const quint64 id = request.path.mid(request.path.lastIndexOf('/') + 1).toULongLong(&idOk);
+    QJsonParseError parseErr{};
+    const QJsonDocument doc = QJsonDocument::fromJson(request.body, &parseErr);
+    if (!idOk || parseErr.error != QJsonParseError::NoError || !doc.isObject()) {
+        socket->write(jsonResponse(400, errorBody(QStringLiteral("Expected POST /input/<id> with a JSON object"))));
+        return;
+    }
+    // {"text": "..."} answers; {"accepted": false} declines, failing the node as a cancelled dialog does
+    const QJsonObject body = doc.object();
+    const bool accepted = body.value(QStringLiteral("accepted")).toBool(true);
+    const bool settled = accepted ? queue.answer(id, body.value(QStringLiteral("text")).toString())
+                                  : queue.decline(id);
+    if (!settled) {
+        socket->write(jsonResponse(404, errorBody(QStringLiteral("No prompt %1 is waiting").arg(id))));
+        return;
+    }
+    socket->write(jsonResponse(200, QJsonDocument(QJsonObject{{QStringLiteral("settled"), true}})
+                                        .toJson(QJsonDocument::Compact)));
+}
+
+void PipelineServer::submit(QTcpSocket* socket, const Request& request)
+{
+    QElapsedTimer age;
+    age.start();
+    const auto reject = [&](int status, const QString& message, const QByteArray& extraHeaders = {}) {
+        recordRequest(status, age.nsecsElapsed() / 1e9);
+        socket->write(jsonResponse(status, errorBody(message), extraHeaders));
+        socket->disconnectFromHost();
+    };
+
+    QVariantMap inputs;
+    if (!request.body.trimmed().isEmpty()) {
+        QJsonParseError parseErr{};
+        const QJsonDocument doc = QJsonDocument::fromJson(request.body, &parseErr);
+        if (parseErr.error != QJsonParseError::NoError || !doc.isObject()) {
+            reject(400, QStringLiteral("Invalid JSON object: %1").arg(parseErr.errorString()));
+            return;
+        }
+        inputs = doc.object().toVariantMap();
+    }
+
+    auto job = std::make_shared<Job>();
+    const QByteArray priority = request.query.value("priority", "normal").toLower();
+    if (priority == "high") {
+        job->priority = ExecutionEngine::TaskPriority::High;
+    } else if (priority == "low") {
+        job->priority = ExecutionEngine::TaskPriority::Low;
+    } else if (priority != "normal") {
+        reject(400, QStringLiteral("priority must be high, normal or low"));
+        return;
+    }
+    QString error;
+    if (!m_resolver(inputs, job->presets, error)) {
+        reject(400, error);
+        return;
+    }
+    if (runningCount() >= m_config.maxConcurrentRuns && queuedCount() >= m_config.maxQueuedRequests) {
+        reject(503, QStringLiteral("Too many requests queued"), "Retry-After: 1\r\n");
+        return;
+    }
+
+    job->socket = socket;
+    job->stream = wantsStream(request);
+    job->age = age;
+
+    int deadlineMs = m_config.deadlineMs;
+    bool ok = false;
+    const int requested = request.query.value("deadline_ms").toInt(&ok);
+    if (ok && requested > 0) {
+        deadlineMs = deadlineMs > 0 ? qMin(deadlineMs, requested) : requested;
+    }
+    if (deadlineMs > 0) {
+        job->deadline = QDeadlineTimer(deadlineMs);
+    }
+    job->dueMs = job->deadline.isForever()
+                     ? QDeadlineTimer::current().deadline() + ExecutionEngine::runSlackMs(job->priority)
+                     : job->deadline.deadline();
+    const std::weak_ptr<Job> weakJob = job;
+    if (deadlineMs > 0) {
+        QTimer::singleShot(deadlineMs, this, [this, weakJob]() {
+            if (const auto expired = weakJob.lock()) expire(expired);
+        });
+    }
+    connect(socket, &QTcpSocket::disconnected, this, [this, weakJob]() {
+        if (const auto abandoned = weakJob.lock()) abandon(abandoned);
+    });
+
+    if (job->stream) {
+        socket->write("HTTP/1.1 200 OK\r\n"
+                      "Content-Type: text/event-stream\r\n"
+                      "Cache-Control: no-cache\r\n"
+                      "Connection: close\r\n\r\n");
+    }
+    m_queue.push_back(std::move(job));
+    dispatch();
+}
+
+void PipelineServer::dispatch()
+{
+    while (!m_queue.empty() && runningCount() < m_config.maxConcurrentRuns) {
+        // Earliest due first, arrival order among equals
+        const auto next = std::min_element(m_queue.begin(), m_queue.end(),
+                                           [](const std::shared_ptr<Job>& a, const std::shared_ptr<Job>& b) {
+                                               return a->dueMs < b->dueMs;
+                                           });
+        const std::shared_ptr<Job> job = *next;
+        m_queue.erase(next);
+        if (job->done) continue;
+        job->runId = m_engine->startIndependentRun(job->presets, job->priority, job->deadline);
+        if (job->runId.isNull()) {
+            finish(job, 500, QJsonObject{
+                {QStringLiteral("succeeded"), false},
+                {QStringLiteral("error"), QStringLiteral("The run could not be started")},
+            });
+            continue;
+        }
+        m_running.insert(job->runId, job);
+    }
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    metrics.gauge(QStringLiteral("cp_server_running_runs"), QStringLiteral("Pipeline server runs in flight"))
+        .set(runningCount());
+    metrics.gauge(QStringLiteral("cp_server_queued_requests"), QStringLiteral("Pipeline server requests waiting for a run slot"))
+        .set(queuedCount());
+}
+
+void PipelineServer::expire(const std::shared_ptr<Job>& job)
+{
+    if (job->done) return;
+    finish(job, 504, QJsonObject{
+        {QStringLiteral("succeeded"), false},
+        {QStringLiteral("error"), QStringLiteral("Deadline exceeded")},
+    });
+}
+
+void PipelineServer::abandon(const std::shared_ptr<Job>& job)
+{
+    if (job->done) return;
+    // Nobody is left to answer; the run's slot goes to the next request
+    job->done = true;
+    job->socket.clear();
+    recordRequest(499, job->age.nsecsElapsed() / 1e9);
+    if (!job->runId.isNull() && m_running.remove(job->runId)) {
+        m_engine->cancelRun(job->runId);
+    }
+    m_queue.erase(std::remove(m_queue.begin(), m_queue.end(), job), m_queue.end());
+    dispatch();
+}
+
+void PipelineServer::onRunFinished(const QUuid& runId, const DataPacket& output, bool succeeded)
+{
+    const std::shared_ptr<Job> job = m_running.take(runId);
+    if (!job) return;
+    QJsonObject result{
+        {QStringLiteral("succeeded"), succeeded},
+        {QStringLiteral("output"), QJsonObject::fromVariantMap(output)},
+    };
+    if (!succeeded) {
+        const QString error = output.value(QStringLiteral("__error")).toString();
+        result.insert(QStringLiteral("error"), error.isEmpty() ? QStringLiteral("Run failed") : error);
+    }
+    finish(job, succeeded ? 200 : 500, result);
+    dispatch();
+}
+
+void PipelineServer::onPartialOutput(const QUuid& runId, const QUuid& nodeUuid, const DataPacket& partial)
+{
+    const std::shared_ptr<Job> job = m_running.value(runId);
+    if (!job || !job->stream || !job->socket) return;
+    job->socket->write(serverSentEvent("partial", QJsonObject{
+        {QStringLiteral("node"), nodeUuid.toString(QUuid::WithoutBraces)},
+        {QStringLiteral("output"), QJsonObject::fromVariantMap(partial)},
+    }));
+}
+
+void PipelineServer::finish(const std::shared_ptr<Job>& job, int status, const QJsonObject& result)
+{
+    if (job->done) return;
+    job->done = true;
+    recordRequest(status, job->age.nsecsElapsed() / 1e9);
+
+    // A deadline can pass while the job is still queued or already running
+    m_queue.erase(std::remove(m_queue.begin(), m_queue.end(), job), m_queue.end());
+    if (!job->runId.isNull() && m_running.remove(job->runId)) {
+        m_engine->cancelRun(job->runId);
+        dispatch();
+    }
+
+    QTcpSocket* socket = job->socket;
+    job->socket.clear();
+    if (!socket) return;
+    if (job->stream) {
+        QJsonObject event = result;
+        event.insert(QStringLiteral("status"), status);
+        socket->write(serverSentEvent("result", event));
+    } else {
+        socket->write(jsonResponse(status, QJsonDocument(result).toJson(QJsonDocument::Compact)));
+    }
+    socket->disconnectFromHost();
+}
@@ -0,0 +1,125 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QHash>
+#include <QHostAddress>
+#include <QJsonObject>
+#include <QObject>
+#include <QString>
+#include <QUuid>
+#include <QVariantMap>
+
+#include <deque>
+#include <functional>
+#include <memory>
+
+#include "CommonDataTypes.h"
+#include "HttpServerSupport.h"
+
+class ExecutionEngine;
+class QTcpServer;
+class QTcpSocket;
+
+// Serves a loaded pipeline over HTTP for "--run pipeline.json --serve [address:]port".
+//
+// POST /run takes a JSON object of inputs, as one line of a --batch file, and answers
+// with the run's result object ({"succeeded", "output", "error"}). Every request is an
+// independent run of the same engine, so the graph, script runtimes, connection pools
+// and caches stay warm between requests. At most maxConcurrentRuns run at once; up to
+// maxQueuedRequests more wait, and further requests get 503. Waiting requests start
+// earliest due first, as the engine orders tasks: by their deadline, or by arrival plus
+// the slack of their ?priority=high|normal|low class, and their runs carry both into the
+// engine and provider rate limits. A request still queued or running when its deadline
+// passes gets 504 and its run is cancelled, as it is when the client disconnects. With "Accept: text/event-stream"
+// (or ?stream=1) the answer is a stream of server-sent events: "partial" for each
+// output a node publishes while it runs, such as the text streamed by an LLM node,
+// then one "result". GET /health reports the running and queued counts. GET /input lists
+// the Human Input prompts waiting for an answer as {"prompts": [{"id", "prompt"}]}, and
+// POST /input/<id> with {"text": ...} answers one ({"accepted": false} declines it).
+class PipelineServer : public QObject {
+    Q_OBJECT
+public:
+    static constexpr int kDefaultPort = 8080;
+    static constexpr int kDefaultMaxConcurrentRuns = 8;
+    static constexpr int kDefaultMaxQueuedRequests = 256;
+    // Largest request accepted, headers and body together
+    static constexpr qsizetype kMaxRequestBytes = 8 * 1024 * 1024;
+
+    struct Config {
+        // 0 takes any free port
+        int port {kDefaultPort};
+        QHostAddress address {QHostAddress::LocalHost};
+        int maxConcurrentRuns {kDefaultMaxConcurrentRuns};
+        int maxQueuedRequests {kDefaultMaxQueuedRequests};
+        // Time a request may spend queued and running, in milliseconds; 0 for no limit.
+        // A request's ?deadline_ms= may shorten it.
+        int deadlineMs {0};
+    };
+
+    using Request = HttpServerSupport::Request;
+    using ParseResult = HttpServerSupport::ParseResult;
+
+    // Resolves request inputs to preset outputs for ExecutionEngine::startIndependentRun()
+    using InputResolver = std::function<bool(const QVariantMap& inputs, QHash<QUuid, QVariantMap>& presets,
+                                             QString& error)>;
+
+    PipelineServer(ExecutionEngine* engine, InputResolver resolver, Config config, QObject* parent = nullptr);
+    // Cancels the runs still in flight
+    ~PipelineServer() override;
+
+    bool start(QString* error = nullptr);
+    // The port listened on, once started
+    quint16 serverPort() const;
+    int runningCount() const { return static_cast<int>(m_running.size()); }
+    int queuedCount() const { return static_cast<int>(m_queue.size()); }
+
+    // Parses one request from the start of @p buffer; bodies need a Content-Length
+    static ParseResult parseRequest(const QByteArray& buffer, Request& request,
+                                    qsizetype maxBytes = kMaxRequestBytes)
+    {
+        return HttpServerSupport::parseRequest(buffer, request, maxBytes);
+    }
+
+private:
+    struct Job;
+
+    void onReadyRead(QTcpSocket* socket);
+    void handleRequest(QTcpSocket* socket, const Request& request);
+    void handleInput(QTcpSocket* socket, const Request& request);
+    void submit(QTcpSocket* socket, const Request& request);
+    void dispatch();
+    void expire(const std::shared_ptr<Job>& job);
+    void abandon(const std::shared_ptr<Job>& job);
+    void onRunFinished(const QUuid& runId, const DataPacket& output, bool succeeded);
+    void onPartialOutput(const QUuid& runId, const QUuid& nodeUuid, const DataPacket& partial);
+    void finish(const std::shared_ptr<Job>& job, int status, const QJsonObject& result);
+
+    ExecutionEngine* m_engine;
+    InputResolver m_resolver;
+    Config m_config;
+    QTcpServer* m_server {nullptr};
+    std::deque<std::shared_ptr<Job>> m_queue;
+    QHash<QUuid, std::shared_ptr<Job>> m_running;
+};
@@ -0,0 +1,443 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "RagIndexServer.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+#include <QUrl>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <exception>
+#include <vector>
+
+#include "HttpServerSupport.h"
+#include "Logger.h"
+#include "LoggingCategories.h"
+#include "MetricsRegistry.h"
+#include "retrieval/storage/RagIndexClient.h"
+#include "retrieval/storage/RagUtils.h"
+
+namespace {
+
+using HttpServerSupport::errorBody;
+
+void reply(QTcpSocket* socket, int status, const QByteArray& json, const QByteArray& extraHeaders = {})
+{
+    socket->write(HttpServerSupport::jsonResponse(status, json, extraHeaders));
+    socket->disconnectFromHost();
+}
+
+void reply(QTcpSocket* socket, int status, const QJsonObject& body, const QByteArray& extraHeaders = {})
+{
+    reply(socket, status, QJsonDocument(body).toJson(QJsonDocument::Compact), extraHeaders);
+}
+
+struct BatchOutcome {
+    std::vector<std::vector<RagUtils::SearchResult>> results;
+    QString error;
+};
+
+} // namespace
+
+// One pass over an index. Requests that share it hold consecutive ranges of its queries.
+struct RagIndexServer::Batch {
+    struct Waiting {
+        QPointer<QTcpSocket> socket;
+        int first {0};
+        int count {0};
+    };
+
+    QByteArray key;
+    QString path;
+    RagIndexClient::SearchRequest request;
+    QList<Waiting> waiting;
+};
+
+bool RagIndexServer::isRequested(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--rag-serve") == 0) return true;
+    }
+    return false;
+}
+
+QString RagIndexServer::parseArguments(const QStringList& arguments, Config& config)
+{
+    bool listening = false;
+    for (int i = 0; i < arguments.size(); ++i) {
+        const QString& arg = arguments.at(i);
+        const bool hasValue = i + 1 < arguments.size();
+        if (arg == QStringLiteral("--rag-serve")) {
+            if (!hasValue) return QStringLiteral("--rag-serve expects [address:]port");
+            const QString spec = arguments.at(++i);
+            const int colon = spec.lastIndexOf(QLatin1Char(':'));
+            bool ok = false;
+            const int port = spec.mid(colon + 1).toInt(&ok);
+            if (!ok || port < 0 || port > 65535) {
+                return QStringLiteral("--rag-serve expects [address:]port, got \"%1\"").arg(spec);
+            }
+            config.port = port;
+            if (colon >= 0) {
+                QString host = spec.left(colon);
+                if (host.startsWith(QLatin1Char('[')) && host.endsWith(QLatin1Char(']'))) {
+                    host = host.mid(1, host.size() - 2);
+                }
+                if (!config.address.setAddress(host)) {
+                    return QStringLiteral("--rag-serve: \"%1\" is not an IP address").arg(host);
+                }
+            }
+            listening = true;
+        } else if (arg == QStringLiteral("--index")) {
+            const QString spec = hasValue ? arguments.at(++i) : QString();
+            const qsizetype eq = spec.indexOf(QLatin1Char('='));
+            const QString name = spec.left(eq).trimmed();
+            if (eq <= 0 || name.contains(QLatin1Char('/')) || spec.mid(eq + 1).trimmed().isEmpty()) {
+                return QStringLiteral("--index expects <name>=<database path>");
+            }
+            config.indexes.insert(name, spec.mid(eq + 1).trimmed());
+        } else if (arg == QStringLiteral("--batch-window-ms") || arg == QStringLiteral("--max-batch")
+                   || arg == QStringLiteral("--threads")) {
+            bool ok = false;
+            const int value = hasValue ? arguments.at(++i).toInt(&ok) : 0;
+            const bool positive = arg == QStringLiteral("--max-batch");
+            if (!ok || value < 0 || (positive && value == 0)) {
+                return QStringLiteral("%1 expects a %2 number")
+                    .arg(arg, positive ? QStringLiteral("positive") : QStringLiteral("non-negative"));
+            }
+            if (arg == QStringLiteral("--batch-window-ms")) {
+                config.batchWindowMs = value;
+            } else if (positive) {
+                config.maxBatchQueries = value;
+            } else {
+                config.threads = value;
+            }
+        } else {
+            return QStringLiteral("Unknown argument \"%1\"").arg(arg);
+        }
+    }
+    if (!listening) return QStringLiteral("No retrieval daemon port given");
+    if (config.indexes.isEmpty()) return QStringLiteral("No --index given");
+    return {};
+}
+
+QString RagIndexServer::usage()
+{
+    return QStringLiteral(
+        "Usage: CognitivePipelines --rag-serve [<address>:]<port> --index <name>=<db>...\n"
+        "                          [--batch-window-ms <ms>] [--max-batch <n>] [--threads <n>]\n"
+        "\n"
+        "  --rag-serve        Keep the RAG indexes loaded and answer k-NN searches for\n"
+        "                     RAG Query nodes whose database is rag://<host>:<port>/<name>.\n"
+        "                     Listens on 127.0.0.1 unless an address is given.\n"
+        "  --index            Serve the database at <db> as <name>; repeatable.\n"
+        "  --batch-window-ms  Time a search waits to share its pass with others (default 2).\n"
+        "  --max-batch        Queries answered by one pass at most (default 64).\n"
+        "  --threads          Search threads (default: one per core).\n");
+}
+
+RagIndexServer::RagIndexServer(Config config, QObject* parent)
+    : QObject(parent)
+    , m_config(std::move(config))
+{
+    m_pool.setMaxThreadCount(m_config.threads > 0 ? m_config.threads : QThread::idealThreadCount());
+}
+
+RagIndexServer::~RagIndexServer()
+{
+    m_pool.waitForDone();
+}
+
+bool RagIndexServer::start(QString* error)
+{
+    if (m_server) {
+        return true;
+    }
+    const auto fail = [error](const QString& message) {
+        CP_WARN << message;
+        if (error) {
+            *error = message;
+        }
+        return false;
+    };
+
+    // Every index must be readable before clients are accepted
+    for (auto it = m_config.indexes.cbegin(); it != m_config.indexes.cend(); ++it) {
+        if (!QFileInfo(it.value()).isFile()) {
+            return fail(QStringLiteral("RagIndexServer: index %1: %2 does not exist").arg(it.key(), it.value()));
+        }
+        try {
+            const RagUtils::IndexConfig indexConfig = RagUtils::getIndexConfig(it.value());
+            const bool warmed = RagUtils::warmIndex(it.value());
+            CP_CLOG(cp_discovery).noquote()
+                << QStringLiteral("RagIndexServer: serving %1 (%2/%3, %4 dimensions%5)")
+                       .arg(it.key(), indexConfig.providerId, indexConfig.modelId)
+                       .arg(indexConfig.dimension)
+                       .arg(warmed ? QStringLiteral(", loaded") : QString());
+        } catch (const std::exception& ex) {
+            return fail(QStringLiteral("RagIndexServer: index %1: %2").arg(it.key(), QString::fromUtf8(ex.what())));
+        }
+    }
+
+    m_server = new QTcpServer(this);
+    if (!m_server->listen(m_config.address, static_cast<quint16>(m_config.port))) {
+        const QString message = QStringLiteral("RagIndexServer: cannot listen on %1:%2: %3")
+                                    .arg(m_config.address.toString())
+                                    .arg(m_config.port)
+                                    .arg(m_server->errorString());
+        delete m_server;
+        m_server = nullptr;
+        return fail(message);
+    }
+    connect(m_server, &QTcpServer::newConnection, this, [this]() {
+        while (QTcpSocket* socket = m_server->nextPendingConnection()) {
+            connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+            HttpServerSupport::watchRequestRead(socket);
+            connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { onReadyRead(socket); });
+        }
+    });
+    return true;
+}
+
+quint16 RagIndexServer::serverPort() const
+{
+    return m_server ? m_server->serverPort() : 0;
+}
+
+int RagIndexServer::exec()
+{
+    if (!start()) {
+        return kExitUsage;
+    }
+    QCoreApplication::exec();
+    return kExitSuccess;
+}
+
+void RagIndexServer::onReadyRead(QTcpSocket* socket)
+{
+    // Anything after the request is ignored
+    if (HttpServerSupport::isRequestRead(socket)) {
+        socket->readAll();
+        return;
+    }
+    const QByteArray buffer = socket->peek(socket->bytesAvailable());
+    HttpServerSupport::Request request;
+    using HttpServerSupport::ParseResult;
+    const ParseResult parsed = HttpServerSupport::parseRequest(buffer, request, kMaxRequestBytes);
+    if (parsed == ParseResult::Incomplete) {
+        return;
+    }
+    HttpServerSupport::markRequestRead(socket);
+    socket->readAll();
+    if (parsed != ParseResult::Complete) {
+        const bool tooLarge = parsed == ParseResult::TooLarge;
+        reply(socket, tooLarge ? 413 : 400,
+              errorBody(tooLarge ? QStringLiteral("Request too large") : QStringLiteral("Malformed request")));
+        return;
+    }
+
+    if (request.path == "/search") {
+        if (request.method != "POST") {
+            reply(socket, 405, errorBody(QStringLiteral("Only POST is served")), "Allow: POST\r\n");
+        } else {
+            handleSearch(socket, request.body);
+        }
+        return;
+    }
+    if (request.method != "GET") {
+        reply(socket, 405, errorBody(QStringLiteral("Only GET is served")), "Allow: GET\r\n");
+        return;
+    }
+    if (request.path == "/health") {
+        reply(socket, 200,
+              QJsonObject{{QStringLiteral("status"), QStringLiteral("ok")},
+                          {QStringLiteral("indexes"), static_cast<int>(m_config.indexes.size())},
+                          {QStringLiteral("pending_queries"), m_pendingQueries}});
+        return;
+    }
+
+    // Index configurations are read on the search pool, as the searches are
+    const QString name = QUrl::fromPercentEncoding(request.path.mid(sizeof("/indexes/") - 1));
+    const bool single = request.path.startsWith("/indexes/");
+    if (!single && request.path != "/indexes") {
+        reply(socket, 404, errorBody(QStringLiteral("Not found")));
+        return;
+    }
+    if (single && !m_config.indexes.contains(name)) {
+        reply(socket, 404, errorBody(QStringLiteral("No index named %1").arg(name)));
+        return;
+    }
+    QMap<QString, QString> indexes;
+    if (single) {
+        indexes.insert(name, m_config.indexes.value(name));
+    } else {
+        indexes = m_config.indexes;
+    }
+    const QPointer<QTcpSocket> target(socket);
+    QtConcurrent::run(&m_pool, [indexes]() {
+        QJsonArray listed;
+        QString error;
+        for (auto it = indexes.cbegin(); it != indexes.cend(); ++it) {
+            try {
+                QJsonObject entry = RagIndexClient::configToJson(RagUtils::getIndexConfig(it.value()));
+                entry.insert(QStringLiteral("name"), it.key());
+                listed.append(entry);
+            } catch (const std::exception& ex) {
+                error = QStringLiteral("Index %1: %2").arg(it.key(), QString::fromUtf8(ex.what()));
+            }
+        }
+        return std::make_pair(listed, error);
+    }).then(this, [target, single](const std::pair<QJsonArray, QString>& outcome) {
+        if (!target) return;
+        if (!outcome.second.isEmpty()) {
+            reply(target, 500, errorBody(outcome.second));
+        } else if (single) {
+            reply(target, 200, outcome.first.first().toObject());
+        } else {
+            reply(target, 200, QJsonObject{{QStringLiteral("indexes"), outcome.first}});
+        }
+    });
+}
+
+void RagIndexServer::handleSearch(QTcpSocket* socket, const QByteArray& body)
+{
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(body, &parseError);
+    RagIndexClient::SearchRequest request;
+    QString error;
+    if (parseError.error != QJsonParseError::NoError || !document.isObject()) {
+        reply(socket, 400, errorBody(QStringLiteral("The body must be a JSON object")));
+        return;
+    }
+    if (!RagIndexClient::SearchRequest::fromJson(document.object(), request, &error)) {
+        reply(socket, 400, errorBody(error));
+        return;
+    }
+    if (!m_config.indexes.contains(request.index)) {
+        reply(socket, 404, errorBody(QStringLiteral("No index named %1").arg(request.index)));
+        return;
+    }
+    const int count = static_cast<int>(request.embeddings.size());
+    if (count == 0) {
+        reply(socket, 200, QJsonObject{{QStringLiteral("results"), QJsonArray()}});
+        return;
+    }
+    while (request.queryTexts.size() < count) {
+        request.queryTexts.append(QString());
+    }
+    request.queryTexts = request.queryTexts.mid(0, count);
+
+    // Requests with the same index and settings share a pass; only their queries differ
+    QJsonObject settings = request.toJson();
+    settings.remove(QStringLiteral("embeddings"));
+    settings.remove(QStringLiteral("queries"));
+    const QByteArray key = QJsonDocument(settings).toJson(QJsonDocument::Compact);
+
+    std::shared_ptr<Batch> batch = m_open.value(key);
+    if (batch && static_cast<int>(batch->request.embeddings.size()) + count > m_config.maxBatchQueries) {
+        m_open.remove(key);
+        runBatch(batch);
+        batch.reset();
+    }
+    if (!batch) {
+        batch = std::make_shared<Batch>();
+        batch->key = key;
+        batch->path = m_config.indexes.value(request.index);
+        batch->request = request;
+        batch->request.embeddings.clear();
+        batch->request.queryTexts.clear();
+        m_open.insert(key, batch);
+        QTimer::singleShot(m_config.batchWindowMs, this, [this, batch]() {
+            if (m_open.value(batch->key) == batch) {
+                m_open.remove(batch->key);
+                runBatch(batch);
+            }
+        });
+    }
+    batch->waiting.append(Batch::Waiting{QPointer<QTcpSocket>(socket),
+                                         static_cast<int>(batch->request.embeddings.size()), count});
+    for (auto& embedding : request.embeddings) {
+        batch->request.embeddings.push_back(std::move(embedding));
+    }
+    batch->request.queryTexts.append(request.queryTexts);
+    m_pendingQueries += count;
+}
+
+void RagIndexServer::runBatch(const std::shared_ptr<Batch>& batch)
+{
+    const QString index = batch->request.index;
+    QElapsedTimer timer;
+    timer.start();
+    QtConcurrent::run(&m_pool, [batch]() {
+        BatchOutcome outcome;
+        const RagIndexClient::SearchRequest& request = batch->request;
+        try {
+            if (request.embeddings.size() == 1) {
+                RagSearchOptions options = request.options;
+                options.queryText = request.queryTexts.value(0);
+                outcome.results.push_back(RagUtils::findMostRelevantChunks(
+                    batch->path, request.embeddings.front(), request.limit, request.minRelevance, options));
+            } else {
+                outcome.results = RagUtils::findMostRelevantChunksBatch(batch->path, request.embeddings, request.limit,
+                                                                        request.minRelevance, request.options,
+                                                                        request.queryTexts);
+            }
+        } catch (const std::exception& ex) {
+            outcome.error = QString::fromUtf8(ex.what());
+        }
+        return outcome;
+    }).then(this, [this, batch, index, timer](const BatchOutcome& outcome) {
+        MetricsRegistry& metrics = MetricsRegistry::instance();
+        const MetricsRegistry::Labels labels{{QStringLiteral("index"), index}};
+        metrics.counter(QStringLiteral("cp_rag_daemon_queries"), QStringLiteral("Queries answered by the retrieval daemon"),
+                        labels)
+            .increment(batch->request.embeddings.size());
+        metrics.histogram(QStringLiteral("cp_rag_daemon_batch_queries"),
+                          QStringLiteral("Queries answered per pass over an index"), labels)
+            .observe(static_cast<double>(batch->request.embeddings.size()));
+        metrics.histogram(QStringLiteral("cp_rag_daemon_search_seconds"),
+                          QStringLiteral("Time from a pass being started to its answers"), labels)
+            .observe(timer.nsecsElapsed() / 1e9);
+
+        for (const Batch::Waiting& waiting : batch->waiting) {
+            m_pendingQueries -= waiting.count;
+            if (!waiting.socket) continue;
+            if (!outcome.error.isEmpty()) {
+                reply(waiting.socket, 500, errorBody(outcome.error));
+                continue;
+            }
+            const std::vector<std::vector<RagUtils::SearchResult>> mine(
+                outcome.results.begin() + waiting.first, outcome.results.begin() + waiting.first + waiting.count);
+            reply(waiting.socket, 200, QJsonObject{{QStringLiteral("results"), RagIndexClient::resultsToJson(mine)}});
+        }
+    });
+}
@@ -0,0 +1,105 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QHash>
+#include <QHostAddress>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+
+#include <memory>
+
+class QTcpServer;
+class QTcpSocket;
+
+// Retrieval daemon, "CognitivePipelines --rag-serve [address:]port --index name=path ...".
+//
+// Owns the named RAG indexes for every client: their HNSW sidecars and vector files
+// are loaded at start and stay in memory with the SQLite connections and page cache,
+// so concurrent pipelines query one hot copy. RagQueryNode reaches an index as
+// rag://host:port/name (RagIndexClient). Routes, all JSON:
+//   GET  /health         status and the number of queries waiting
+//   GET  /indexes        every index with its embedding configuration
+//   GET  /indexes/<name> one index's configuration
+//   POST /search         RagIndexClient::SearchRequest; answers {"results": [[...], ...]}
+// Searches that arrive within batchWindowMs of each other for the same index and
+// settings are answered by one RagUtils::findMostRelevantChunksBatch() pass, at most
+// maxBatchQueries queries at a time, on a pool of search threads.
+class RagIndexServer : public QObject {
+    Q_OBJECT
+public:
+    static constexpr int kDefaultPort = 7341;
+    static constexpr int kExitSuccess = 0;
+    static constexpr int kExitUsage = 2;
+    // Largest request accepted, headers and body together
+    static constexpr qsizetype kMaxRequestBytes = 64 * 1024 * 1024;
+
+    struct Config {
+        // 0 takes any free port
+        int port {kDefaultPort};
+        QHostAddress address {QHostAddress::LocalHost};
+        // Index name to database path
+        QMap<QString, QString> indexes;
+        // Time a search waits for others to share its pass; 0 searches at once
+        int batchWindowMs {2};
+        int maxBatchQueries {64};
+        // Search threads; 0 for the ideal thread count
+        int threads {0};
+    };
+
+    static bool isRequested(int argc, char* argv[]);
+    // Returns an error message, empty on success
+    static QString parseArguments(const QStringList& arguments, Config& config);
+    static QString usage();
+
+    explicit RagIndexServer(Config config, QObject* parent = nullptr);
+    // Waits for the searches still running
+    ~RagIndexServer() override;
+
+    // Checks and warms every index, then listens
+    bool start(QString* error = nullptr);
+    quint16 serverPort() const;
+    // Queries received and not yet answered
+    int pendingQueries() const { return m_pendingQueries; }
+
+    // Starts and serves until the application quits
+    int exec();
+
+private:
+    struct Batch;
+
+    void onReadyRead(QTcpSocket* socket);
+    void handleSearch(QTcpSocket* socket, const QByteArray& body);
+    void runBatch(const std::shared_ptr<Batch>& batch);
+
+    Config m_config;
+    QTcpServer* m_server {nullptr};
+    QThreadPool m_pool;
+    // Batches still collecting queries, by index and settings
+    QHash<QByteArray, std::shared_ptr<Batch>> m_open;
+    int m_pendingQueries {0};
+};
@@ -0,0 +1,336 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "RemoteWorkerServer.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QJsonDocument>
+#include <QMetaObject>
+#include <QPointer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+
+#include <QtNodes/NodeDelegateModelRegistry>
+
+#include <exception>
+
+#include "CancellationToken.h"
+#include "Logger.h"
+#include "LoggingCategories.h"
+#include "NodeGraphModel.h"
+#include "PartialOutputSink.h"
+#include "RemoteProtocol.h"
+#include "ToolNodeDelegate.h"
+
+struct RemoteWorkerServer::Connection {
+    QByteArray buffer;
+    QHash<quint64, CancellationToken> calls;
+};
+
+struct RemoteWorkerServer::Instance {
+    // The delegate owns the tool's wiring; the tool is what runs
+    std::shared_ptr<QtNodes::NodeDelegateModel> delegate;
+    std::shared_ptr<IToolNode> node;
+};
+
+bool RemoteWorkerServer::isRequested(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--worker") == 0) return true;
+    }
+    return false;
+}
+
+QString RemoteWorkerServer::parseArguments(const QStringList& arguments, Options& options)
+{
+    bool listening = false;
+    for (int i = 0; i < arguments.size(); ++i) {
+        const QString& arg = arguments.at(i);
+        const bool hasValue = i + 1 < arguments.size();
+        if (arg == QStringLiteral("--worker")) {
+            if (!hasValue) return QStringLiteral("--worker expects [address:]port");
+            const QString spec = arguments.at(++i);
+            const int colon = spec.lastIndexOf(QLatin1Char(':'));
+            bool ok = false;
+            const int port = spec.mid(colon + 1).toInt(&ok);
+            if (!ok || port < 0 || port > 65535) {
+                return QStringLiteral("--worker expects [address:]port, got \"%1\"").arg(spec);
+            }
+            options.port = port;
+            if (colon >= 0) {
+                QString host = spec.left(colon);
+                if (host.startsWith(QLatin1Char('[')) && host.endsWith(QLatin1Char(']'))) {
+                    host = host.mid(1, host.size() - 2);
+                }
+                if (!options.address.setAddress(host)) {
+                    return QStringLiteral("--worker: \"%1\" is not an IP address").arg(host);
+                }
+            }
+            listening = true;
+        } else if (arg == QStringLiteral("--capacity")) {
+            bool ok = false;
+            const int value = hasValue ? arguments.at(++i).toInt(&ok) : 0;
+            if (!ok || value <= 0) return QStringLiteral("--capacity expects a positive number");
+            options.capacity = value;
+        } else if (arg == QStringLiteral("--node-types")) {
+            if (!hasValue) return QStringLiteral("--node-types expects a comma-separated list of type ids");
+            options.nodeTypes.clear();
+            for (const QString& type : arguments.at(++i).split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+                options.nodeTypes.append(type.trimmed());
+            }
+        } else {
+            return QStringLiteral("Unknown argument \"%1\"").arg(arg);
+        }
+    }
+    if (!listening) return QStringLiteral("No worker port given");
+    return {};
+}
+
+QString RemoteWorkerServer::usage()
+{
+    return QStringLiteral(
+        "Usage: CognitivePipelines --worker [<address>:]<port> [--capacity <n>]\n"
+        "                          [--node-types <type>,...]\n"
+        "\n"
+        "  --worker      Run node tasks sent by coordinators that list this worker\n"
+        "                in CP_REMOTE_WORKERS. Listens on 127.0.0.1 unless an\n"
+        "                address is given.\n"
+        "  --capacity    Tasks run at once (default: one per core).\n"
+        "  --node-types  Node type ids offered (default: every registered type).\n"
+        "\n"
+        "Coordinator and workers share large blobs through CP_REMOTE_BLOB_DIR.\n");
+}
+
+RemoteWorkerServer::RemoteWorkerServer(Options options, QObject* parent)
+    : QObject(parent)
+    , m_options(std::move(options))
+    , m_model(std::make_unique<NodeGraphModel>())
+{
+    m_pool.setMaxThreadCount(m_options.capacity > 0 ? m_options.capacity : QThread::idealThreadCount());
+    m_nodeTypes = m_options.nodeTypes;
+    if (m_nodeTypes.isEmpty()) {
+        for (const auto& entry : m_model->dataModelRegistry()->registeredModelCreators()) {
+            m_nodeTypes.append(entry.first);
+        }
+        m_nodeTypes.sort();
+    }
+}
+
+RemoteWorkerServer::~RemoteWorkerServer()
+{
+    for (const auto& connection : std::as_const(m_connections)) {
+        for (const CancellationToken& token : std::as_const(connection->calls)) token.cancel();
+    }
+    m_pool.waitForDone();
+    // Results posted by the last tasks refer to this object
+    QCoreApplication::removePostedEvents(this);
+    m_idle.clear();
+    m_model.reset();
+}
+
+bool RemoteWorkerServer::start(QString* error)
+{
+    m_server = new QTcpServer(this);
+    if (!m_server->listen(m_options.address, static_cast<quint16>(m_options.port))) {
+        if (error) *error = m_server->errorString();
+        return false;
+    }
+    connect(m_server, &QTcpServer::newConnection, this, [this]() {
+        while (QTcpSocket* socket = m_server->nextPendingConnection()) {
+            m_connections.insert(socket, std::make_shared<Connection>());
+            connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { onReadyRead(socket); });
+            connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+                if (const auto connection = m_connections.take(socket)) {
+                    for (const CancellationToken& token : std::as_const(connection->calls)) token.cancel();
+                }
+                socket->deleteLater();
+            });
+
+            RemoteProtocol::Message hello;
+            hello.type = RemoteProtocol::MessageType::Hello;
+            hello.capacity = capacity();
+            hello.nodeTypes = m_nodeTypes;
+            send(socket, hello);
+        }
+    });
+    CP_CLOG(cp_concurrency) << "RemoteWorkerServer: listening on port" << serverPort() << "with capacity"
+                            << capacity();
+    return true;
+}
+
+quint16 RemoteWorkerServer::serverPort() const
+{
+    return m_server ? m_server->serverPort() : 0;
+}
+
+int RemoteWorkerServer::exec()
+{
+    QString error;
+    if (!start(&error)) {
+        CP_WARN << "RemoteWorkerServer: cannot listen:" << error;
+        return kExitUsage;
+    }
+    QCoreApplication::exec();
+    return kExitSuccess;
+}
+
+void RemoteWorkerServer::onReadyRead(QTcpSocket* socket)
+{
+    const auto connection = m_connections.value(socket);
+    if (!connection) return;
+    connection->buffer += socket->readAll();
+
+    RemoteProtocol::Message message;
+    QString error;
+    for (;;) {
+        const RemoteProtocol::DecodeResult decoded = RemoteProtocol::takeFrame(connection->buffer, message, &error);
+        if (decoded == RemoteProtocol::DecodeResult::Incomplete) return;
+        if (decoded == RemoteProtocol::DecodeResult::Malformed) {
+            CP_WARN << "RemoteWorkerServer: dropping coordinator:" << error;
+            socket->disconnectFromHost();
+            return;
+        }
+
+        switch (message.type) {
+        case RemoteProtocol::MessageType::Execute:
+            execute(socket, message);
+            break;
+        case RemoteProtocol::MessageType::Cancel:
+            connection->calls.value(message.callId).cancel();
+            break;
+        case RemoteProtocol::MessageType::Ping: {
+            RemoteProtocol::Message pong;
+            pong.type = RemoteProtocol::MessageType::Pong;
+            pong.active = m_pool.activeThreadCount();
+            send(socket, pong);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+void RemoteWorkerServer::execute(QTcpSocket* socket, const RemoteProtocol::Message& message)
+{
+    const quint64 callId = message.callId;
+    const QString key =
+        message.nodeType + QLatin1Char(':')
+        + QString::fromLatin1(QCryptographicHash::hash(message.state, QCryptographicHash::Sha1).toHex());
+    std::shared_ptr<Instance> instance = m_nodeTypes.contains(message.nodeType)
+                                             ? acquire(key, message.nodeType, message.state)
+                                             : nullptr;
+    if (!instance) {
+        RemoteProtocol::Message result;
+        result.type = RemoteProtocol::MessageType::Result;
+        result.callId = callId;
+        result.error = QStringLiteral("Worker does not run node type %1").arg(message.nodeType);
+        send(socket, result);
+        return;
+    }
+
+    const CancellationToken cancellation = CancellationToken::create();
+    m_connections.value(socket)->calls.insert(callId, cancellation);
+
+    const QPointer<QTcpSocket> target(socket);
+    const SharedBlobStore blobs = m_options.blobs;
+    m_pool.start([this, target, callId, key, instance, cancellation, blobs, inputs = message.tokens]() mutable {
+        for (auto& token : inputs) token.data = blobs.restore(token.data);
+
+        const PartialOutputSink partialSink([this, target, callId, blobs](const TokenList& tokens) {
+            RemoteProtocol::Message partial;
+            partial.type = RemoteProtocol::MessageType::Partial;
+            partial.callId = callId;
+            for (const auto& token : tokens) {
+                ExecutionToken sent = token;
+                sent.data = blobs.offload(token.data);
+                partial.tokens.push_back(std::move(sent));
+            }
+            QMetaObject::invokeMethod(this, [this, target, partial]() {
+                if (target) send(target, partial);
+            });
+        });
+
+        RemoteProtocol::Message result;
+        result.type = RemoteProtocol::MessageType::Result;
+        result.callId = callId;
+        try {
+            const CancellationToken::Scope cancellationScope(cancellation);
+            const PartialOutputSink::Scope partialScope(partialSink);
+            TokenList outputs;
+            if (instance->node->supportsAsyncExecution()) {
+                QFuture<TokenList> pending = instance->node->executeAsync(inputs);
+                pending.waitForFinished();
+                const QList<TokenList> results = pending.results();
+                if (!results.isEmpty()) outputs = results.first();
+            } else {
+                outputs = instance->node->execute(inputs);
+            }
+            for (auto& token : outputs) token.data = blobs.offload(token.data);
+            result.tokens = std::move(outputs);
+        } catch (const std::exception& ex) {
+            result.error = QString::fromUtf8(ex.what());
+        } catch (...) {
+            result.error = QStringLiteral("Unknown exception");
+        }
+        if (result.error.isEmpty() && cancellation.isCancelled()) {
+            result.error = QStringLiteral("Cancelled");
+        }
+
+        QMetaObject::invokeMethod(this, [this, target, key, instance, result]() mutable {
+            release(key, std::move(instance));
+            if (!target) return;
+            if (const auto connection = m_connections.value(target)) connection->calls.remove(result.callId);
+            send(target, result);
+        });
+    });
+}
+
+std::shared_ptr<RemoteWorkerServer::Instance> RemoteWorkerServer::acquire(const QString& key, const QString& nodeType,
+                                                                          const QByteArray& state)
+{
+    auto idle = m_idle.find(key);
+    if (idle != m_idle.end() && !idle->isEmpty()) return idle->takeLast();
+
+    std::shared_ptr<QtNodes::NodeDelegateModel> delegate = m_model->dataModelRegistry()->create(nodeType);
+    auto* toolDelegate = dynamic_cast<ToolNodeDelegate*>(delegate.get());
+    if (!toolDelegate || !toolDelegate->node()) return nullptr;
+
+    auto instance = std::make_shared<Instance>();
+    instance->delegate = std::move(delegate);
+    instance->node = toolDelegate->node();
+    instance->node->loadState(QJsonDocument::fromJson(state).object());
+    return instance;
+}
+
+void RemoteWorkerServer::release(const QString& key, std::shared_ptr<Instance> instance)
+{
+    m_idle[key].append(std::move(instance));
+}
+
+void RemoteWorkerServer::send(QTcpSocket* socket, const RemoteProtocol::Message& message)
+{
+    socket->write(RemoteProtocol::encode(message));
+}
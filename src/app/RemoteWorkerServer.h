@@ -0,0 +1,107 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QHash>
+#include <QHostAddress>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+
+#include <memory>
+
+#include "SharedBlobStore.h"
+
+class NodeGraphModel;
+class QTcpServer;
+class QTcpSocket;
+
+namespace RemoteProtocol {
+struct Message;
+}
+
+// Worker process of remote execution, "CognitivePipelines --worker [address:]port".
+//
+// Accepts coordinators (RemoteWorkerPool) over RemoteProtocol and runs the node tasks
+// they send: the node named by its type id is created from the same registry the
+// editor uses, given the sent state and run on a local thread pool with the sent
+// input tokens. Instances are kept per type and state between tasks, so warmed-up
+// nodes such as a Python script's interpreter are reused. Blob references are
+// resolved from the shared blob store (CP_REMOTE_BLOB_DIR), and large outputs are
+// written back to it. A coordinator that disconnects has its tasks cancelled.
+class RemoteWorkerServer : public QObject {
+    Q_OBJECT
+public:
+    static constexpr int kExitSuccess = 0;
+    static constexpr int kExitUsage = 2;
+
+    struct Options {
+        // 0 takes any free port
+        int port {0};
+        QHostAddress address {QHostAddress::LocalHost};
+        // Tasks run at once; 0 for the ideal thread count
+        int capacity {0};
+        // Node type ids offered to coordinators; empty offers every registered type
+        QStringList nodeTypes;
+        SharedBlobStore blobs {SharedBlobStore::fromEnvironment()};
+    };
+
+    static bool isRequested(int argc, char* argv[]);
+    // Returns an error message, empty on success
+    static QString parseArguments(const QStringList& arguments, Options& options);
+    static QString usage();
+
+    explicit RemoteWorkerServer(Options options, QObject* parent = nullptr);
+    // Cancels the tasks still running and waits for them
+    ~RemoteWorkerServer() override;
+
+    bool start(QString* error = nullptr);
+    // The port listened on, once started
+    quint16 serverPort() const;
+    int capacity() const { return m_pool.maxThreadCount(); }
+    QStringList nodeTypes() const { return m_nodeTypes; }
+
+    // Starts listening and serves until the application quits
+    int exec();
+
+private:
+    struct Connection;
+    struct Instance;
+
+    void onReadyRead(QTcpSocket* socket);
+    void execute(QTcpSocket* socket, const RemoteProtocol::Message& message);
+    std::shared_ptr<Instance> acquire(const QString& key, const QString& nodeType, const QByteArray& state);
+    void release(const QString& key, std::shared_ptr<Instance> instance);
+    void send(QTcpSocket* socket, const RemoteProtocol::Message& message);
+
+    Options m_options;
+    std::unique_ptr<NodeGraphModel> m_model;
+    QStringList m_nodeTypes;
+    QThreadPool m_pool;
+    QTcpServer* m_server {nullptr};
+    QHash<QTcpSocket*, std::shared_ptr<Connection>> m_connections;
+    // Idle instances by type and state
+    QHash<QString, QList<std::shared_ptr<Instance>>> m_idle;
+};
@@ -0,0 +1,110 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Entry point of cp-run, the headless binary. It links the cp_core library only, so
+// the editor's window, dialogs, canvas and node widgets never load. Arguments are the
+// editor's headless ones ("--run", "--worker", "--rag-serve"); with none of them it
+// does a run.
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QLoggingCategory>
+#include <QScopeGuard>
+#include <QStandardPaths>
+
+#include <memory>
+
+#include "HeadlessMain.h"
+#include "Logger.h"
+#include "LoggingCategories.h"
+#include "MermaidRenderer.h"
+#include "MetricsExporter.h"
+#include "ModelCapsRegistry.h"
+#include "StartupProfiler.h"
+#include "Tracer.h"
+
+namespace {
+
+// Where cp-run was started from, worked out before an application object can say
+QString executableDirectory(const char* argv0)
+{
+    QString program = QString::fromLocal8Bit(argv0);
+    if (!program.contains(QLatin1Char('/')) && !program.contains(QLatin1Char('\\'))) {
+        program = QStandardPaths::findExecutable(program);
+    }
+    return program.isEmpty() ? QString() : QFileInfo(program).absolutePath();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    StartupProfiler& profiler = StartupProfiler::instance();
+    QCoreApplication::setOrganizationName(QStringLiteral("CognitivePipelines"));
+    QCoreApplication::setOrganizationDomain(QStringLiteral("cognitivepipelines.com"));
+    QCoreApplication::setApplicationName(QStringLiteral("CognitivePipelines"));
+
+    for (int i = 1; i < argc; ++i) {
+        if (QString::fromLocal8Bit(argv[i]) == QStringLiteral("-d")) {
+            AppLogHelper::setGlobalDebugEnabled(true);
+            break;
+        }
+    }
+
+    // Mermaid diagrams render through QtWebEngine, which needs a GUI application and
+    // ships as an optional plugin. Without the plugin no GUI module is initialised.
+    const QString mermaidPlugin = MermaidRenderer::findPlugin(executableDirectory(argv[0]));
+    std::unique_ptr<QCoreApplication> app;
+    if (mermaidPlugin.isEmpty()) {
+        app = std::make_unique<QCoreApplication>(argc, argv);
+    } else {
+        HeadlessMain::preparePlatform();
+        QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
+        app = std::make_unique<QGuiApplication>(argc, argv);
+    }
+
+    if (qEnvironmentVariableIsEmpty("QT_LOGGING_RULES")) {
+        QLoggingCategory::setFilterRules(QStringLiteral(
+            "cp.*.debug=false\n"
+            "cp.*.info=false\n"
+        ));
+    }
+
+    profiler.mark(QStringLiteral("Application"));
+
+    if (!mermaidPlugin.isEmpty()) {
+        const QString error = MermaidRenderer::loadPlugin(mermaidPlugin);
+        if (!error.isEmpty()) {
+            CP_WARN << error;
+        }
+    }
+
+    CP_CLOG(cp_registry) << "Initializing Model Capabilities Registry...";
+    ModelCapsRegistry::instance().loadInBackground(ModelCapsRegistry::instance().distributionConfigPath());
+
+    // Off unless CP_METRICS_PORT or CP_METRICS_JSON is set
+    MetricsExporter metricsExporter(MetricsExporter::Config::fromEnvironment());
+    metricsExporter.start();
+    const auto flushTraces = qScopeGuard([]() { Tracer::instance().flush(); });
+
+    return HeadlessMain::exec(argc, argv, profiler);
+}
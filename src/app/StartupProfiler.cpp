@@ -0,0 +1,120 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "StartupProfiler.h"
+
+#include "Logger.h"
+
+#include <QEvent>
+#include <QPointer>
+#include <QStringList>
+#include <QTextStream>
+#include <QTimer>
+
+#include <utility>
+
+namespace {
+
+// Watches for the first paint of one window or widget, then removes itself
+class FirstPaintWatcher : public QObject {
+public:
+    FirstPaintWatcher(QObject* widget, std::function<void()> onPainted)
+        : QObject(widget)
+        , m_onPainted(std::move(onPainted))
+    {
+        widget->installEventFilter(this);
+    }
+
+    bool eventFilter(QObject* watched, QEvent* event) override
+    {
+        if (event->type() == QEvent::Paint && !m_painted) {
+            m_painted = true;
+            watched->removeEventFilter(this);
+            // Let the paint finish before anything else runs
+            QTimer::singleShot(0, this, [this]() {
+                if (m_onPainted) {
+                    m_onPainted();
+                }
+                deleteLater();
+            });
+        }
+        return QObject::eventFilter(watched, event);
+    }
+
+private:
+    std::function<void()> m_onPainted;
+    bool m_painted {false};
+};
+
+} // namespace
+
+StartupProfiler& StartupProfiler::instance()
+{
+    static StartupProfiler profiler;
+    return profiler;
+}
+
+StartupProfiler::StartupProfiler()
+{
+    m_timer.start();
+}
+
+void StartupProfiler::mark(const QString& phase)
+{
+    const qint64 now = m_timer.elapsed();
+    m_phases.append(Phase{phase, now - m_lastMarkMs, now});
+    m_lastMarkMs = now;
+}
+
+void StartupProfiler::finishOnFirstPaint(QObject* widget, std::function<void()> afterFirstPaint)
+{
+    if (!widget) {
+        logSummary();
+        return;
+    }
+    new FirstPaintWatcher(widget, [this, afterFirstPaint = std::move(afterFirstPaint)]() {
+        mark(QStringLiteral("First paint"));
+        logSummary();
+        if (afterFirstPaint) {
+            afterFirstPaint();
+        }
+    });
+}
+
+void StartupProfiler::logSummary() const
+{
+    QStringList parts;
+    parts.reserve(m_phases.size());
+    for (const Phase& phase : m_phases) {
+        parts.append(QStringLiteral("%1 %2 ms").arg(phase.name).arg(phase.durationMs));
+    }
+    const QString summary = QStringLiteral("Startup took %1 ms: %2")
+                                .arg(m_lastMarkMs)
+                                .arg(parts.join(QStringLiteral(", ")));
+    CP_CLOG(startup) << summary;
+
+    const QByteArray toStderr = qgetenv("CP_STARTUP_PROFILE");
+    if (toStderr == QByteArrayLiteral("1") || toStderr.compare(QByteArrayLiteral("true"), Qt::CaseInsensitive) == 0) {
+        QTextStream(stderr) << summary << '\n';
+    }
+}
@@ -0,0 +1,64 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+
+#include <functional>
+
+class QObject;
+
+// Times the phases of application startup on the GUI thread. Each mark() closes
+// the phase running since the previous mark, or since the profiler was first
+// touched at the top of main(). The breakdown goes to the Debug Log through
+// CP_CLOG; CP_STARTUP_PROFILE=1 also prints it to stderr so cold starts can be
+// measured from a terminal.
+class StartupProfiler {
+public:
+    struct Phase {
+        QString name;
+        qint64 durationMs {0};
+        qint64 endMs {0};
+    };
+
+    static StartupProfiler& instance();
+
+    void mark(const QString& phase);
+    // Marks "First paint" once widget has painted, logs the summary, then runs
+    // afterFirstPaint from the event loop for work that can wait until then.
+    void finishOnFirstPaint(QObject* widget, std::function<void()> afterFirstPaint = {});
+    void logSummary() const;
+
+    QList<Phase> phases() const { return m_phases; }
+    qint64 elapsedMs() const { return m_timer.elapsed(); }
+
+private:
+    StartupProfiler();
+
+    QElapsedTimer m_timer;
+    qint64 m_lastMarkMs {0};
+    QList<Phase> m_phases;
+};
@@ -96,6 +96,10 @@ QString capabilityText(ModelCapsTypes::Capability capability)
         return QStringLiteral("pdf");
     case Capability::StructuredOutput:
         return QStringLiteral("structuredoutput");
+    case Capability::PromptCaching:
+        return QStringLiteral("promptcaching");
+    case Capability::Rerank:
+        return QStringLiteral("rerank");
     }
     return QStringLiteral("unknown");
 }
@@ -129,7 +133,9 @@ QStringList capabilityTexts(const QSet<ModelCapsTypes::Capability>& capabilities
         Capability::Image,
         Capability::Embedding,
         Capability::Pdf,
-        Capability::StructuredOutput
+        Capability::StructuredOutput,
+        Capability::PromptCaching,
+        Capability::Rerank
     };
 
     QStringList values;
@@ -192,6 +198,12 @@ QJsonObject ruleToOverrideObject(const ModelCapsTypes::ModelRule& rule)
     if (capsConstraints.maxOutputTokens.has_value()) {
         constraints.insert(QStringLiteral("maxOutputTokens"), *capsConstraints.maxOutputTokens);
     }
+    if (capsConstraints.maxImageDimension.has_value()) {
+        constraints.insert(QStringLiteral("maxImageDimension"), *capsConstraints.maxImageDimension);
+    }
+    if (capsConstraints.maxImagesPerRequest.has_value()) {
+        constraints.insert(QStringLiteral("maxImagesPerRequest"), *capsConstraints.maxImagesPerRequest);
+    }
     if (capsConstraints.temperature.has_value()) {
         QJsonObject temperature;
         if (capsConstraints.temperature->defaultValue.has_value()) {
@@ -308,6 +320,7 @@ ProviderManagementDialog::ProviderManagementDialog(QWidget* parent)
     populateRulesTable();
     onReloadCatalogEditor();
     onRefreshModels();
+    m_providerDiscovery.setFuture(ModelCatalogService::instance().fetchAllModels());
 }
 
 void ProviderManagementDialog::buildUi()
@@ -456,10 +469,12 @@ void ProviderManagementDialog::buildUi()
     connect(m_showFilteredModelsCheck, &QCheckBox::toggled, this, [this]() {
         populateModelTable(m_lastModels);
     });
-    connect(m_refreshModelsButton, &QPushButton::clicked, this, &ProviderManagementDialog::onRefreshModels);
+    connect(m_refreshModelsButton, &QPushButton::clicked, this, &ProviderManagementDialog::onForceRefreshModels);
     connect(m_testModelButton, &QPushButton::clicked, this, &ProviderManagementDialog::onTestSelectedModel);
     connect(&m_modelFetcher, &QFutureWatcher<QList<ModelCatalogEntry>>::finished,
             this, &ProviderManagementDialog::onModelsFetched);
+    connect(&m_providerDiscovery, &QFutureWatcher<QList<ModelCatalogEntry>>::resultReadyAt,
+            this, &ProviderManagementDialog::onProviderModelsDiscovered);
     connect(&m_modelTester, &QFutureWatcher<ModelTestResult>::finished,
             this, &ProviderManagementDialog::onModelTestFinished);
 }
@@ -888,6 +903,16 @@ void ProviderManagementDialog::reloadRegistryAndViews()
 }
 
 void ProviderManagementDialog::onRefreshModels()
+{
+    refreshModels(false);
+}
+
+void ProviderManagementDialog::onForceRefreshModels()
+{
+    refreshModels(true);
+}
+
+void ProviderManagementDialog::refreshModels(bool forceRefresh)
 {
     const QString providerId = selectedProviderId();
     if (providerId.isEmpty()) {
@@ -916,7 +941,7 @@ void ProviderManagementDialog::onRefreshModels()
         m_modelTable->setRowCount(0);
     }
 
-    m_modelFetcher.setFuture(ModelCatalogService::instance().fetchModels(providerId, selectedCatalogKind()));
+    m_modelFetcher.setFuture(ModelCatalogService::instance().fetchModels(providerId, selectedCatalogKind(), forceRefresh));
 }
 
 void ProviderManagementDialog::onModelsFetched()
@@ -937,6 +962,31 @@ void ProviderManagementDialog::onModelsFetched()
     }
 }
 
+// Providers report in whatever order they answer; each fills in its own status cell
+void ProviderManagementDialog::onProviderModelsDiscovered(int resultIndex)
+{
+    const QList<ModelCatalogEntry> entries = m_providerDiscovery.resultAt(resultIndex);
+    if (!m_providerTable || entries.isEmpty()) {
+        return;
+    }
+
+    const QString providerId = entries.first().providerId;
+    const int modelCount = static_cast<int>(ModelCatalogService::instance().modelIds(entries).size());
+    for (int row = 0; row < m_providerTable->rowCount(); ++row) {
+        const auto* nameItem = m_providerTable->item(row, ProviderNameColumn);
+        auto* statusItem = m_providerTable->item(row, ProviderStatusColumn);
+        if (!nameItem || !statusItem || nameItem->data(kProviderIdRole).toString() != providerId) {
+            continue;
+        }
+        const auto* enabledItem = m_providerTable->item(row, ProviderEnabledColumn);
+        const auto* requiresKeyItem = m_providerTable->item(row, ProviderRequiresKeyColumn);
+        const bool enabled = enabledItem && enabledItem->checkState() == Qt::Checked;
+        const bool requiresCredential = requiresKeyItem && requiresKeyItem->checkState() == Qt::Checked;
+        statusItem->setText(tr("%1 - %n model(s)", nullptr, modelCount)
+                                .arg(providerStatusText(providerId, enabled, requiresCredential)));
+    }
+}
+
 void ProviderManagementDialog::onTestSelectedModel()
 {
     const QString providerId = selectedProviderId();
@@ -51,7 +51,9 @@ private slots:
     void onSaveCatalogEditor();
     void onResetCatalogEditor();
     void onRefreshModels();
+    void onForceRefreshModels();
     void onModelsFetched();
+    void onProviderModelsDiscovered(int resultIndex);
     void onTestSelectedModel();
     void onModelTestFinished();
     void onCopyRuleToCatalogEditor();
@@ -88,6 +90,7 @@ private:
     void populateProviderTable();
     void populateProviderCombo();
     void populateModelTable(const QList<ModelCatalogEntry>& entries);
+    void refreshModels(bool forceRefresh);
     void populateRulesTable();
     QJsonObject readCatalogEditor(bool* ok = nullptr);
     QJsonObject readUserCatalogFile() const;
@@ -117,6 +120,7 @@ private:
     QTextEdit* m_catalogEditor {nullptr};
 
     QFutureWatcher<QList<ModelCatalogEntry>> m_modelFetcher;
+    QFutureWatcher<QList<ModelCatalogEntry>> m_providerDiscovery;
     QFutureWatcher<ModelTestResult> m_modelTester;
     QList<ModelCatalogEntry> m_lastModels;
 };
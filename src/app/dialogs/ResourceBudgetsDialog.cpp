@@ -0,0 +1,81 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "ResourceBudgetsDialog.h"
+
+#include <QVBoxLayout>
+#include <QFormLayout>
+#include <QSpinBox>
+#include <QLabel>
+#include <QDialogButtonBox>
+#include <QPushButton>
+
+ResourceBudgetsDialog::ResourceBudgetsDialog(const ResourceBudgets& budgets, QWidget *parent)
+    : QDialog(parent)
+{
+    setWindowTitle(tr("Concurrency Budgets"));
+
+    auto *mainLayout = new QVBoxLayout(this);
+    auto *hint = new QLabel(tr("Maximum number of nodes of each kind that run at the same time. "
+                               "Saved with the pipeline."), this);
+    hint->setWordWrap(true);
+    mainLayout->addWidget(hint);
+
+    auto *formLayout = new QFormLayout();
+    formLayout->setSpacing(10);
+    for (int i = 0; i < kResourceClassCount; ++i) {
+        const auto resourceClass = static_cast<ResourceClass>(i);
+        auto *spin = new QSpinBox(this);
+        spin->setRange(1, 1024);
+        spin->setValue(budgets.limit(resourceClass));
+        formLayout->addRow(ResourceBudgets::displayName(resourceClass) + QStringLiteral(":"), spin);
+        m_spins[i] = spin;
+    }
+    mainLayout->addLayout(formLayout);
+    mainLayout->addStretch();
+
+    auto *buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel
+                                           | QDialogButtonBox::RestoreDefaults, this);
+    mainLayout->addWidget(buttonBox);
+
+    connect(buttonBox, &QDialogButtonBox::accepted, this, &QDialog::accept);
+    connect(buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    connect(buttonBox->button(QDialogButtonBox::RestoreDefaults), &QPushButton::clicked,
+            this, &ResourceBudgetsDialog::onRestoreDefaults);
+}
+
+ResourceBudgets ResourceBudgetsDialog::budgets() const
+{
+    ResourceBudgets result;
+    for (int i = 0; i < kResourceClassCount; ++i) {
+        result.setLimit(static_cast<ResourceClass>(i), m_spins[i]->value());
+    }
+    return result;
+}
+
+void ResourceBudgetsDialog::onRestoreDefaults()
+{
+    for (int i = 0; i < kResourceClassCount; ++i) {
+        m_spins[i]->setValue(ResourceBudgets::defaultLimit(static_cast<ResourceClass>(i)));
+    }
+}
@@ -0,0 +1,51 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QDialog>
+
+#include <array>
+
+#include "ResourceBudgets.h"
+
+class QSpinBox;
+
+/**
+ * @brief Dialog for editing a project's per-resource-class concurrency budgets.
+ *
+ * The result is stored with the pipeline (see NodeGraphModel::resourceBudgets()).
+ */
+class ResourceBudgetsDialog : public QDialog {
+    Q_OBJECT
+public:
+    explicit ResourceBudgetsDialog(const ResourceBudgets& budgets, QWidget *parent = nullptr);
+
+    ResourceBudgets budgets() const;
+
+private slots:
+    void onRestoreDefaults();
+
+private:
+    std::array<QSpinBox*, kResourceClassCount> m_spins {};
+};
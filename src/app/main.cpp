@@ -25,13 +25,23 @@
 #include <QApplication>
 #include <QCoreApplication>
 #include <QIcon>
+#include "HeadlessMain.h"
 #include "Logger.h"
 #include <QLoggingCategory>
+#include <QScopeGuard>
 #include "LoggingCategories.h"
 #include "MainWindow.h"
+#include "MermaidRenderService.h"
+#include "MetricsExporter.h"
 #include "ModelCapsRegistry.h"
+#include "ModelCatalogService.h"
+#include "NodeWidgetFactory.h"
+#include "StartupProfiler.h"
+#include "Tracer.h"
+
 
 int main(int argc, char* argv[]) {
+    StartupProfiler& profiler = StartupProfiler::instance();
     QCoreApplication::setOrganizationName(QStringLiteral("CognitivePipelines"));
     QCoreApplication::setOrganizationDomain(QStringLiteral("cognitivepipelines.com"));
     QCoreApplication::setApplicationName(QStringLiteral("CognitivePipelines"));
@@ -63,6 +73,12 @@ int main(int argc, char* argv[]) {
             "cp.*.info=false"));
     }
 
+    // Headless runs never show a window; cp-run serves the same modes without the editor
+    const bool headless = HeadlessMain::isRequested(argc, argv);
+    if (headless) {
+        HeadlessMain::preparePlatform();
+    }
+
     QApplication app(argc, argv);
 
     // Silence our categorized logs by default in the main app unless explicitly enabled
@@ -74,9 +90,25 @@ int main(int argc, char* argv[]) {
         ));
     }
 
+    profiler.mark(QStringLiteral("Application"));
+
+    // The editor links the node widgets and the WebEngine renderer the core leaves out
+    NodeWidgetFactory::install();
+    MermaidRenderService::install();
+
+    // The catalog parses while the window is built; the first lookup waits for it
     CP_CLOG(cp_registry) << "Initializing Model Capabilities Registry...";
-    ModelCapsRegistry::instance().loadFromFileWithUserOverrides(
-        ModelCapsRegistry::instance().distributionConfigPath());
+    ModelCapsRegistry::instance().loadInBackground(ModelCapsRegistry::instance().distributionConfigPath());
+
+    // Off unless CP_METRICS_PORT or CP_METRICS_JSON is set
+    MetricsExporter metricsExporter(MetricsExporter::Config::fromEnvironment());
+    metricsExporter.start();
+    // Spans still queued when main() returns go to the collector first
+    const auto flushTraces = qScopeGuard([]() { Tracer::instance().flush(); });
+
+    if (headless) {
+        return HeadlessMain::exec(argc, argv, profiler);
+    }
 
     // Set application icon (cross-platform)
     // Note: Using PNG for macOS to avoid "skipping unknown tag type" warnings
@@ -89,8 +121,19 @@ int main(int argc, char* argv[]) {
     app.setWindowIcon(QIcon(":/packaging/linux/CognitivePipelines.png"));
 #endif
 
+    profiler.mark(QStringLiteral("Icon"));
+
     MainWindow w;
+    profiler.mark(QStringLiteral("Main window"));
     w.show();
+    profiler.mark(QStringLiteral("Show"));
+
+    // Provider discovery is not needed to draw the window: register the backends,
+    // check credentials and load cached model lists once it is on screen. Providers
+    // are asked in parallel, so a slow or unreachable one doesn't delay the rest
+    profiler.finishOnFirstPaint(&w, []() {
+        (void)ModelCatalogService::instance().fetchAllModels();
+    });
 
     return app.exec();
 }
@@ -0,0 +1,322 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "BlobHandle.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTemporaryFile>
+#include <QUuid>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#include "InputSignature.h"
+
+#if defined(Q_OS_LINUX)
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#elif defined(Q_OS_MACOS)
+#include <sys/clonefile.h>
+#endif
+
+namespace {
+std::atomic<qint64> g_spillThreshold {16 * 1024 * 1024};
+
+// A copy-on-write clone shares the source's blocks until either side is written, so
+// it is as private as a copy but takes no time or space. Only some file systems
+// (APFS, Btrfs, XFS) can; hard links are no substitute, as in-place edits to the
+// original would show through.
+bool cloneFile(const QString& from, const QString& to)
+{
+#if defined(Q_OS_LINUX)
+    const int source = ::open(QFile::encodeName(from).constData(), O_RDONLY | O_CLOEXEC);
+    if (source < 0) return false;
+    const int target = ::open(QFile::encodeName(to).constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (target < 0) {
+        ::close(source);
+        return false;
+    }
+    const bool cloned = ::ioctl(target, FICLONE, source) == 0;
+    ::close(target);
+    ::close(source);
+    if (!cloned) QFile::remove(to);
+    return cloned;
+#elif defined(Q_OS_MACOS)
+    return ::clonefile(QFile::encodeName(from).constData(), QFile::encodeName(to).constData(), 0) == 0;
+#else
+    Q_UNUSED(from);
+    Q_UNUSED(to);
+    return false;
+#endif
+}
+
+// XXH64 of a file read through a mapping; nullopt when it can't be mapped
+std::optional<quint64> hashFile(const QString& path, qint64 size)
+{
+    QFile file(path);
+    if (size <= 0 || !file.open(QIODevice::ReadOnly)) return std::nullopt;
+    const uchar* mapped = file.map(0, size);
+    if (!mapped) return std::nullopt;
+    return InputSignature::hashBytes(QByteArrayView(reinterpret_cast<const char*>(mapped), size));
+}
+}
+
+struct BlobHandle::Data {
+    QString mimeType;
+    qint64 size {0};
+    QByteArray memory; // in-memory payload; empty when spilled
+    QString path;      // private spill file, removed with the last handle
+
+    mutable QMutex mutex;
+    mutable std::unique_ptr<QFile> file;
+    mutable const uchar* mapped {nullptr};
+    mutable QByteArray unmappable; // read fallback where mapping is unavailable
+    mutable bool hashed {false};
+    mutable quint64 hash {0};
+
+    ~Data()
+    {
+        if (file) file->close(); // also unmaps
+        if (!path.isEmpty()) QFile::remove(path);
+    }
+};
+
+qint64 BlobHandle::spillThreshold()
+{
+    return g_spillThreshold.load(std::memory_order_relaxed);
+}
+
+void BlobHandle::setSpillThreshold(qint64 bytes)
+{
+    g_spillThreshold.store(std::max<qint64>(0, bytes), std::memory_order_relaxed);
+}
+
+QString BlobHandle::spillDirectory()
+{
+    return QDir(QDir::tempPath()).filePath(QStringLiteral("CognitivePipelines-blobs"));
+}
+
+void BlobHandle::registerMetaType()
+{
+    static std::once_flag once;
+    std::call_once(once, []() {
+        qRegisterMetaType<BlobHandle>();
+        QMetaType::registerConverter<BlobHandle, QString>(&BlobHandle::text);
+        QMetaType::registerConverter<BlobHandle, QByteArray>(&BlobHandle::bytes);
+    });
+}
+
+BlobHandle BlobHandle::fromBytes(const QByteArray& bytes, const QString& mimeType, Storage storage)
+{
+    registerMetaType();
+    auto data = std::make_shared<Data>();
+    data->mimeType = mimeType;
+    data->size = bytes.size();
+
+    const bool spill = !bytes.isEmpty()
+                    && (storage == Storage::Spill || (storage == Storage::Auto && bytes.size() > spillThreshold()));
+    if (spill && QDir().mkpath(spillDirectory())) {
+        QTemporaryFile out(QDir(spillDirectory()).filePath(QStringLiteral("blob-XXXXXX.bin")));
+        out.setAutoRemove(false);
+        if (out.open() && out.write(bytes) == bytes.size() && out.flush()) {
+            data->path = out.fileName();
+        } else if (!out.fileName().isEmpty()) {
+            out.close();
+            QFile::remove(out.fileName());
+        }
+    }
+    // Kept in memory when spilling was not wanted or failed
+    if (data->path.isEmpty()) data->memory = bytes;
+
+    BlobHandle blob;
+    blob.d = std::move(data);
+    return blob;
+}
+
+BlobHandle BlobHandle::fromText(const QString& text, const QString& mimeType, Storage storage)
+{
+    return fromBytes(text.toUtf8(), mimeType, storage);
+}
+
+BlobHandle BlobHandle::fromFile(const QString& path, const QString& mimeType)
+{
+    registerMetaType();
+    const QFileInfo source(path);
+    if (!source.isFile() || !QDir().mkpath(spillDirectory())) return {};
+
+    // Snapshots are shared by content while any handle to them is alive, so ingesting
+    // the same file again (or a copy of it) takes one read and no write
+    struct SnapshotKey {
+        qint64 size;
+        quint64 hash;
+        QString mimeType;
+        bool operator==(const SnapshotKey& other) const
+        {
+            return size == other.size && hash == other.hash && mimeType == other.mimeType;
+        }
+    };
+    struct SnapshotKeyHash {
+        size_t operator()(const SnapshotKey& key) const
+        {
+            return static_cast<size_t>(key.hash) ^ qHash(key.mimeType);
+        }
+    };
+    static QMutex snapshotsMutex;
+    static std::unordered_map<SnapshotKey, std::weak_ptr<const Data>, SnapshotKeyHash> snapshots;
+
+    if (const std::optional<quint64> sourceHash = hashFile(path, source.size())) {
+        QMutexLocker locker(&snapshotsMutex);
+        const auto it = snapshots.find(SnapshotKey{source.size(), *sourceHash, mimeType});
+        if (it != snapshots.end()) {
+            if (std::shared_ptr<const Data> existing = it->second.lock()) {
+                BlobHandle blob;
+                blob.d = std::move(existing);
+                return blob;
+            }
+        }
+    }
+
+    const QString copy = QDir(spillDirectory()).filePath(
+        QStringLiteral("blob-%1.bin").arg(QUuid::createUuid().toString(QUuid::WithoutBraces)));
+    if (!cloneFile(path, copy) && !QFile::copy(path, copy)) return {};
+    // The snapshot is private and read-only from here on
+    QFile::setPermissions(copy, QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+
+    auto data = std::make_shared<Data>();
+    data->mimeType = mimeType;
+    data->size = QFileInfo(copy).size();
+    data->path = copy;
+    // Hashed from the snapshot, which can't change, rather than from the source
+    if (const std::optional<quint64> hash = hashFile(copy, data->size)) {
+        data->hash = *hash;
+        data->hashed = true;
+        QMutexLocker locker(&snapshotsMutex);
+        for (auto it = snapshots.begin(); it != snapshots.end();) {
+            it = it->second.expired() ? snapshots.erase(it) : std::next(it);
+        }
+        snapshots[SnapshotKey{data->size, *hash, mimeType}] = data;
+    }
+
+    BlobHandle blob;
+    blob.d = std::move(data);
+    return blob;
+}
+
+qint64 BlobHandle::size() const
+{
+    return d ? d->size : 0;
+}
+
+QString BlobHandle::mimeType() const
+{
+    return d ? d->mimeType : QString();
+}
+
+bool BlobHandle::isSpilled() const
+{
+    return d && !d->path.isEmpty();
+}
+
+QString BlobHandle::filePath() const
+{
+    return d ? d->path : QString();
+}
+
+QByteArrayView BlobHandle::view() const
+{
+    if (!d) return {};
+    if (d->path.isEmpty()) return QByteArrayView(d->memory);
+    if (d->size == 0) return {};
+
+    QMutexLocker locker(&d->mutex);
+    if (!d->mapped && d->unmappable.isNull()) {
+        d->file = std::make_unique<QFile>(d->path);
+        if (d->file->open(QIODevice::ReadOnly)) {
+            d->mapped = d->file->map(0, d->size);
+            if (!d->mapped) d->unmappable = d->file->readAll();
+        }
+    }
+    if (d->mapped) return QByteArrayView(reinterpret_cast<const char*>(d->mapped), d->size);
+    return QByteArrayView(d->unmappable);
+}
+
+QByteArray BlobHandle::bytes() const
+{
+    if (!d) return {};
+    // In-memory payloads are implicitly shared, not copied
+    if (d->path.isEmpty()) return d->memory;
+    return view().toByteArray();
+}
+
+QString BlobHandle::text() const
+{
+    return QString::fromUtf8(view());
+}
+
+quint64 BlobHandle::contentHash() const
+{
+    if (!d) return 0;
+    {
+        QMutexLocker locker(&d->mutex);
+        if (d->hashed) return d->hash;
+    }
+    const quint64 hash = InputSignature::hashBytes(view());
+    QMutexLocker locker(&d->mutex);
+    d->hash = hash;
+    d->hashed = true;
+    return hash;
+}
+
+bool BlobHandle::operator==(const BlobHandle& other) const
+{
+    if (d == other.d) return true;
+    if (!d || !other.d) return false;
+    return d->size == other.d->size && contentHash() == other.contentHash();
+}
+
+QDataStream& operator<<(QDataStream& out, const BlobHandle& blob)
+{
+    out << blob.mimeType() << blob.bytes();
+    return out;
+}
+
+QDataStream& operator>>(QDataStream& in, BlobHandle& blob)
+{
+    QString mimeType;
+    QByteArray bytes;
+    in >> mimeType >> bytes;
+    blob = BlobHandle::fromBytes(bytes, mimeType);
+    return in;
+}
@@ -0,0 +1,107 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QMetaType>
+#include <QString>
+
+#include <memory>
+
+class QDataStream;
+
+// Immutable, reference-counted handle to a large payload (document text, image or PDF
+// bytes) that travels through pins instead of the bytes themselves.
+//
+// Copying a handle, storing it in the data lake or snapshotting it into a downstream
+// input only bumps a reference count. Payloads above spillThreshold() live in a private
+// file under the temp directory and are memory-mapped on first read, so they never
+// occupy heap memory unless a node materialises them. Nodes that only route a payload
+// never touch the bytes.
+//
+// Handles convert implicitly to QString (UTF-8) and QByteArray through QVariant, so
+// nodes that call toString()/toByteArray() on their inputs keep working; nodes that
+// care about memory read view() instead. Signatures hash the content once per handle.
+class BlobHandle {
+public:
+    enum class Storage {
+        Auto,   // spill when larger than spillThreshold()
+        Memory,
+        Spill
+    };
+
+    BlobHandle() = default;
+
+    static BlobHandle fromBytes(const QByteArray& bytes, const QString& mimeType = {},
+                                Storage storage = Storage::Auto);
+    static BlobHandle fromText(const QString& text, const QString& mimeType = QStringLiteral("text/plain"),
+                               Storage storage = Storage::Auto);
+    // Snapshots the file into the spill directory (a disk copy, not a read into memory),
+    // so later edits to the original cannot change or truncate the payload. The copy is
+    // a copy-on-write clone where the file system has them, and a file whose content
+    // matches a live snapshot shares it instead. Returns a null handle if the file
+    // cannot be read.
+    static BlobHandle fromFile(const QString& path, const QString& mimeType = {});
+
+    bool isNull() const { return !d; }
+    qint64 size() const;
+    QString mimeType() const;
+    bool isSpilled() const;
+    // Backing file of a spilled handle, for nodes that hand payloads to external tools.
+    // Read-only; empty for in-memory handles.
+    QString filePath() const;
+
+    // Zero-copy access. The view stays valid while any copy of this handle is alive.
+    QByteArrayView view() const;
+    // Materialised copies; file-backed handles read through the mapping
+    QByteArray bytes() const;
+    QString text() const;
+
+    // Content hash (XXH64), computed on first use and shared by all copies
+    quint64 contentHash() const;
+
+    // Same for every copy of one handle, so shared payloads can be counted once
+    const void* identity() const { return d.get(); }
+
+    bool operator==(const BlobHandle& other) const;
+    bool operator!=(const BlobHandle& other) const { return !(*this == other); }
+
+    static qint64 spillThreshold();
+    static void setSpillThreshold(qint64 bytes);
+    static QString spillDirectory();
+
+    // Registers the QVariant converters; called by the factories, safe to call again.
+    static void registerMetaType();
+
+private:
+    struct Data;
+    std::shared_ptr<const Data> d;
+};
+
+// Blobs in cached results are written out in full and read back through fromBytes()
+QDataStream& operator<<(QDataStream& out, const BlobHandle& blob);
+QDataStream& operator>>(QDataStream& in, BlobHandle& blob);
+
+Q_DECLARE_METATYPE(BlobHandle)
@@ -0,0 +1,504 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "DataLake.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QQueue>
+#include <QSaveFile>
+
+#include <algorithm>
+
+#include "BlobHandle.h"
+#include "ExecutionPlan.h"
+#include "ExecutionTrace.h"
+#include "Logger.h"
+#include "MetricsRegistry.h"
+
+namespace {
+
+MetricsRegistry::Gauge& memoryGauge()
+{
+    static MetricsRegistry::Gauge& gauge = MetricsRegistry::instance().gauge(
+        QStringLiteral("cp_datalake_memory_bytes"), QStringLiteral("Approximate bytes of run outputs held in memory"));
+    return gauge;
+}
+
+MetricsRegistry::Gauge& spilledGauge()
+{
+    static MetricsRegistry::Gauge& gauge = MetricsRegistry::instance().gauge(
+        QStringLiteral("cp_datalake_spilled_bytes"), QStringLiteral("Bytes of run outputs spilled to disk"));
+    return gauge;
+}
+
+bool isSpilledBlob(const QVariant& value)
+{
+    return value.metaType() == QMetaType::fromType<BlobHandle>() && value.value<BlobHandle>().isSpilled();
+}
+
+bool reportsError(const QVariantMap& values)
+{
+    const auto it = values.constFind(QStringLiteral("__error"));
+    return it != values.cend() && !it->toString().trimmed().isEmpty();
+}
+
+// Footprint of one pin, as summed by DataLake::approximateBytes()
+qint64 pinBytes(const QString& pin, const QVariant& value)
+{
+    const qint64 keyBytes = pin.size() * static_cast<qint64>(sizeof(QChar));
+    return isSpilledBlob(value) ? keyBytes : keyBytes + ExecutionTrace::approximateSize(value);
+}
+
+} // namespace
+
+DataLake::DataLake(std::shared_ptr<const ExecutionPlan> plan, qint64 memoryBudget)
+    : m_plan(std::move(plan))
+    , m_budget(memoryBudget)
+{
+    if (m_plan) {
+        const int count = m_plan->nodes().size();
+        m_outstanding = std::make_unique<std::atomic<int>[]>(static_cast<size_t>(count));
+        for (int i = 0; i < count; ++i) m_outstanding[i].store(0, std::memory_order_relaxed);
+    }
+    m_spillDir = QDir(QDir::tempPath()).filePath(
+        QStringLiteral("CognitivePipelines-lake/%1").arg(QUuid::createUuid().toString(QUuid::WithoutBraces)));
+}
+
+DataLake::~DataLake()
+{
+    memoryGauge().add(-m_publishedMemoryBytes.load());
+    spilledGauge().add(-m_publishedSpilledBytes.load());
+    if (m_ownsSpillDir) {
+        QDir(m_spillDir).removeRecursively();
+        return;
+    }
+    for (const Stripe& stripe : m_stripes) {
+        for (auto it = stripe.entries.cbegin(); it != stripe.entries.cend(); ++it) {
+            if (it->spilled) QFile::remove(spillPath(it.key()));
+        }
+    }
+}
+
+void DataLake::setMemoryBudget(qint64 bytes)
+{
+    m_budget = std::max<qint64>(0, bytes);
+}
+
+qint64 DataLake::memoryBudget() const
+{
+    return m_budget;
+}
+
+void DataLake::setDropsAllowed(bool allowed)
+{
+    m_dropsAllowed = allowed;
+}
+
+void DataLake::setSpillDirectory(const QString& directory)
+{
+    if (directory.isEmpty()) return;
+    QMutexLocker eviction(&m_evictionMutex);
+    lockAllStripes();
+    m_spillDir = directory;
+    m_ownsSpillDir = false;
+    unlockAllStripes();
+}
+
+void DataLake::merge(const QUuid& node, const QVariantMap& values)
+{
+    const quint64 serial = ++m_writeSerial;
+    {
+        Stripe& stripe = stripeFor(node);
+        QWriteLocker locker(&stripe.lock);
+        Entry& entry = stripe.entries[node];
+        if (entry.spilled) {
+            QVariantMap merged = load(node, entry);
+            for (auto it = values.cbegin(); it != values.cend(); ++it) {
+                merged.insert(it.key(), it.value());
+                entry.versions.insert(it.key(), serial);
+            }
+            store(node, entry, std::move(merged), serial);
+        } else {
+            // In place, so an unshared bucket isn't copied and only the written pins are measured
+            qint64 delta = 0;
+            bool errorWritten = false;
+            for (auto it = values.cbegin(); it != values.cend(); ++it) {
+                const auto previous = entry.values.constFind(it.key());
+                if (previous != entry.values.cend()) delta -= pinBytes(it.key(), previous.value());
+                delta += pinBytes(it.key(), it.value());
+                entry.values.insert(it.key(), it.value());
+                entry.versions.insert(it.key(), serial);
+                errorWritten = errorWritten || it.key() == QLatin1String("__error");
+            }
+            if (errorWritten) entry.hasError = reportsError(entry.values);
+            entry.bytes += delta;
+            entry.writeSerial = serial;
+            entry.pinned = false;
+            addMemoryBytes(delta);
+        }
+    }
+    afterWrite(node);
+}
+
+void DataLake::replace(const QUuid& node, const QVariantMap& values)
+{
+    const quint64 serial = ++m_writeSerial;
+    {
+        Stripe& stripe = stripeFor(node);
+        QWriteLocker locker(&stripe.lock);
+        Entry& entry = stripe.entries[node];
+        entry.versions.clear();
+        for (auto it = values.cbegin(); it != values.cend(); ++it) entry.versions.insert(it.key(), serial);
+        store(node, entry, values, serial);
+    }
+    afterWrite(node);
+}
+
+bool DataLake::contains(const QUuid& node) const
+{
+    const Stripe& stripe = stripeFor(node);
+    QReadLocker locker(&stripe.lock);
+    return stripe.entries.contains(node);
+}
+
+QVariantMap DataLake::bucket(const QUuid& node) const
+{
+    const Stripe& stripe = stripeFor(node);
+    QReadLocker locker(&stripe.lock);
+    const auto it = stripe.entries.constFind(node);
+    if (it == stripe.entries.cend()) return {};
+    return it->spilled ? load(node, *it) : it->values;
+}
+
+QVariant DataLake::value(const QUuid& node, const QString& pin, quint64* version) const
+{
+    const Stripe& stripe = stripeFor(node);
+    QReadLocker locker(&stripe.lock);
+    if (version) *version = 0;
+    const auto it = stripe.entries.constFind(node);
+    if (it == stripe.entries.cend()) return {};
+    if (version) *version = it->versions.value(pin, 0);
+    if (!it->spilled || it->values.contains(pin)) return it->values.value(pin);
+    return load(node, *it).value(pin);
+}
+
+quint64 DataLake::version(const QUuid& node, const QString& pin) const
+{
+    const Stripe& stripe = stripeFor(node);
+    QReadLocker locker(&stripe.lock);
+    const auto it = stripe.entries.constFind(node);
+    return it == stripe.entries.cend() ? 0 : it->versions.value(pin, 0);
+}
+
+bool DataLake::hasError() const
+{
+    for (const Stripe& stripe : m_stripes) {
+        QReadLocker locker(&stripe.lock);
+        for (const Entry& entry : stripe.entries) {
+            if (entry.hasError) return true;
+        }
+    }
+    return false;
+}
+
+QHash<QUuid, QVariantMap> DataLake::toHash() const
+{
+    QHash<QUuid, QVariantMap> all;
+    for (const Stripe& stripe : m_stripes) {
+        QReadLocker locker(&stripe.lock);
+        for (auto it = stripe.entries.cbegin(); it != stripe.entries.cend(); ++it) {
+            all.insert(it.key(), it->spilled ? load(it.key(), *it) : it->values);
+        }
+    }
+    return all;
+}
+
+void DataLake::taskScheduled(int nodeIndex)
+{
+    if (!m_plan || nodeIndex < 0 || nodeIndex >= m_plan->nodes().size()) return;
+    m_outstanding[nodeIndex].fetch_add(1, std::memory_order_acq_rel);
+}
+
+void DataLake::taskFinished(int nodeIndex)
+{
+    if (!m_plan || nodeIndex < 0 || nodeIndex >= m_plan->nodes().size()) return;
+    m_outstanding[nodeIndex].fetch_sub(1, std::memory_order_acq_rel);
+}
+
+DataLake::Metrics DataLake::metrics() const
+{
+    Metrics metrics;
+    metrics.memoryBytes = m_memoryBytes.load();
+    metrics.peakMemoryBytes = m_peakMemoryBytes.load();
+    metrics.spilledBytes = m_spilledBytes.load();
+    metrics.droppedBuckets = m_droppedBuckets.load();
+    for (const Stripe& stripe : m_stripes) {
+        QReadLocker locker(&stripe.lock);
+        for (const Entry& entry : stripe.entries) {
+            if (entry.spilled) {
+                ++metrics.spilledBuckets;
+            } else {
+                ++metrics.residentBuckets;
+            }
+        }
+    }
+    return metrics;
+}
+
+qint64 DataLake::approximateBytes(const QVariantMap& values)
+{
+    qint64 total = 0;
+    for (auto it = values.cbegin(); it != values.cend(); ++it) {
+        total += pinBytes(it.key(), it.value());
+    }
+    return total;
+}
+
+DataLake::Stripe& DataLake::stripeFor(const QUuid& node)
+{
+    return m_stripes[qHash(node) % kStripeCount];
+}
+
+const DataLake::Stripe& DataLake::stripeFor(const QUuid& node) const
+{
+    return m_stripes[qHash(node) % kStripeCount];
+}
+
+void DataLake::lockAllStripes() const
+{
+    for (const Stripe& stripe : m_stripes) stripe.lock.lockForWrite();
+}
+
+void DataLake::unlockAllStripes() const
+{
+    for (auto it = m_stripes.crbegin(); it != m_stripes.crend(); ++it) it->lock.unlock();
+}
+
+void DataLake::store(const QUuid& node, Entry& entry, QVariantMap values, quint64 serial)
+{
+    removeSpill(node, entry);
+    const qint64 previousBytes = entry.bytes;
+    entry.hasError = reportsError(values);
+    entry.bytes = approximateBytes(values);
+    entry.values = std::move(values);
+    entry.writeSerial = serial;
+    entry.pinned = false;
+    addMemoryBytes(entry.bytes - previousBytes);
+}
+
+void DataLake::addMemoryBytes(qint64 delta)
+{
+    const qint64 now = m_memoryBytes.fetch_add(delta, std::memory_order_acq_rel) + delta;
+    qint64 peak = m_peakMemoryBytes.load(std::memory_order_relaxed);
+    while (now > peak && !m_peakMemoryBytes.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {
+    }
+}
+
+void DataLake::afterWrite(const QUuid& node)
+{
+    const qint64 budget = m_budget.load();
+    if (budget > 0 && m_memoryBytes.load() > budget) {
+        QMutexLocker eviction(&m_evictionMutex);
+        lockAllStripes();
+        enforceBudget(node);
+        unlockAllStripes();
+    }
+    publishMetrics();
+}
+
+void DataLake::enforceBudget(const QUuid& justWritten)
+{
+    const qint64 budget = m_budget.load();
+    if (budget <= 0 || m_memoryBytes.load() <= budget) return;
+
+    const QVector<bool> needed = neededBuckets();
+    const bool dropsAllowed = m_dropsAllowed.load();
+    struct Candidate {
+        Stripe* stripe;
+        QUuid node;
+        int rank;
+        quint64 serial;
+    };
+    QVector<Candidate> candidates;
+    for (Stripe& stripe : m_stripes) {
+        for (auto it = stripe.entries.cbegin(); it != stripe.entries.cend(); ++it) {
+            const Entry& entry = it.value();
+            if (entry.spilled || entry.pinned || entry.bytes == 0) continue;
+            const int index = m_plan ? m_plan->indexOf(it.key()) : -1;
+            int rank = 2;
+            if (index >= 0 && !needed[index]) {
+                rank = (dropsAllowed && m_plan->node(index).hasOutgoing) ? 0 : 1;
+            }
+            candidates.push_back({&stripe, it.key(), rank, entry.writeSerial});
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.rank != b.rank ? a.rank < b.rank : a.serial < b.serial;
+    });
+
+    for (const Candidate& candidate : std::as_const(candidates)) {
+        if (m_memoryBytes.load() <= budget) break;
+        Entry& entry = candidate.stripe->entries[candidate.node];
+        if (candidate.rank == 0) {
+            addMemoryBytes(-entry.bytes);
+            ++m_droppedBuckets;
+            candidate.stripe->entries.remove(candidate.node);
+            continue;
+        }
+        if (!spill(candidate.node, entry)) {
+            entry.pinned = true;
+        }
+    }
+
+    if (m_memoryBytes.load() > budget) {
+        CP_WARN << "DataLake: still" << m_memoryBytes.load() << "bytes in memory after eviction (budget"
+                << budget << "bytes, last write" << justWritten.toString() << ")";
+    }
+}
+
+QVector<bool> DataLake::neededBuckets() const
+{
+    const int count = m_plan->nodes().size();
+    // Nodes that may still run: those with outstanding tasks and everything downstream
+    QVector<bool> live(count, false);
+    QQueue<int> frontier;
+    for (int index = 0; index < count; ++index) {
+        if (m_outstanding[index].load(std::memory_order_acquire) > 0) {
+            live[index] = true;
+            frontier.enqueue(index);
+        }
+    }
+    while (!frontier.isEmpty()) {
+        const int index = frontier.dequeue();
+        for (int edgeIndex : m_plan->node(index).outEdges) {
+            const int target = m_plan->edge(edgeIndex).targetIndex;
+            if (!live[target]) {
+                live[target] = true;
+                frontier.enqueue(target);
+            }
+        }
+    }
+
+    // A bucket is read when building inputs for the nodes it feeds
+    QVector<bool> needed(count, false);
+    for (int index = 0; index < count; ++index) {
+        for (int edgeIndex : m_plan->node(index).outEdges) {
+            if (live[m_plan->edge(edgeIndex).targetIndex]) {
+                needed[index] = true;
+                break;
+            }
+        }
+    }
+    return needed;
+}
+
+bool DataLake::spill(const QUuid& node, Entry& entry)
+{
+    QVariantMap keep;
+    QVariantMap out;
+    for (auto it = entry.values.cbegin(); it != entry.values.cend(); ++it) {
+        if (isSpilledBlob(it.value())) {
+            keep.insert(it.key(), it.value());
+        } else {
+            out.insert(it.key(), it.value());
+        }
+    }
+
+    if (!QDir().mkpath(m_spillDir)) {
+        CP_WARN << "DataLake: cannot create spill directory" << m_spillDir;
+        return false;
+    }
+    const QString path = spillPath(node);
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        CP_WARN << "DataLake: cannot write" << path << ":" << file.errorString();
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << out;
+    if (stream.status() != QDataStream::Ok) {
+        // A value without stream operators; keep the bucket in memory
+        file.cancelWriting();
+        return false;
+    }
+    if (!file.commit()) {
+        CP_WARN << "DataLake: cannot write" << path << ":" << file.errorString();
+        return false;
+    }
+
+    addMemoryBytes(-entry.bytes);
+    entry.values = std::move(keep);
+    entry.bytes = 0;
+    entry.diskBytes = QFileInfo(path).size();
+    entry.spilled = true;
+    m_spilledBytes += entry.diskBytes;
+    return true;
+}
+
+QVariantMap DataLake::load(const QUuid& node, const Entry& entry) const
+{
+    QVariantMap values;
+    QFile file(spillPath(node));
+    if (file.open(QIODevice::ReadOnly)) {
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_6_0);
+        stream >> values;
+        if (stream.status() != QDataStream::Ok) {
+            CP_WARN << "DataLake: corrupt spill file" << file.fileName();
+            values.clear();
+        }
+    } else {
+        CP_WARN << "DataLake: cannot read" << file.fileName() << ":" << file.errorString();
+    }
+    for (auto it = entry.values.cbegin(); it != entry.values.cend(); ++it) {
+        values.insert(it.key(), it.value());
+    }
+    return values;
+}
+
+QString DataLake::spillPath(const QUuid& node) const
+{
+    return QDir(m_spillDir).filePath(node.toString(QUuid::WithoutBraces) + QStringLiteral(".lake"));
+}
+
+void DataLake::removeSpill(const QUuid& node, Entry& entry)
+{
+    if (!entry.spilled) return;
+    QFile::remove(spillPath(node));
+    m_spilledBytes -= entry.diskBytes;
+    entry.diskBytes = 0;
+    entry.spilled = false;
+}
+
+void DataLake::publishMetrics()
+{
+    // Exchanged, so concurrent writers together publish exactly the net change
+    const qint64 memory = m_memoryBytes.load();
+    memoryGauge().add(memory - m_publishedMemoryBytes.exchange(memory));
+    const qint64 spilled = m_spilledBytes.load();
+    spilledGauge().add(spilled - m_publishedSpilledBytes.exchange(spilled));
+}
@@ -0,0 +1,179 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QString>
+#include <QUuid>
+#include <QVariant>
+#include <QVariantMap>
+#include <QVector>
+
+#include <array>
+#include <atomic>
+#include <memory>
+
+class ExecutionPlan;
+
+// Per-run store of every node's merged outputs, keyed by node UUID and then pin.
+//
+// Resident values are counted against a memory budget. When a write takes the lake
+// over budget, whole buckets are evicted in this order until it fits again:
+//  1. buckets no remaining consumer needs, dropped outright when drops are allowed;
+//  2. buckets no remaining consumer needs, spilled to disk;
+//  3. the remaining buckets, least recently written first, spilled to disk.
+// A bucket is still needed while any node it feeds may run again, i.e. while that
+// node or one of its ancestors has a task outstanding (see taskScheduled()). Sink
+// buckets are never dropped because they form the run's final packet.
+//
+// Spilled buckets are serialized with QDataStream into a private directory and read
+// back on access; spilled BlobHandles stay in memory since they are already file
+// backed. Reads never make a bucket resident again, writes do.
+//
+// Buckets are spread over lock stripes by node UUID, so producers of different nodes
+// write and fan-in readers read without contending on one lock. Merges update the
+// bucket in place, pin by pin, and stamp each pin with a version from a lake-wide write
+// serial. Reads of a single pin copy only that value. Eviction takes every stripe.
+//
+// Every lake adds its resident and spilled bytes to the cp_datalake_memory_bytes and
+// cp_datalake_spilled_bytes gauges in MetricsRegistry, and takes them back when destroyed.
+class DataLake {
+public:
+    struct Metrics {
+        qint64 memoryBytes {0};     // approximate size of the resident values
+        qint64 peakMemoryBytes {0};
+        qint64 spilledBytes {0};    // size of the spill files
+        int residentBuckets {0};
+        int spilledBuckets {0};
+        int droppedBuckets {0};     // cumulative
+    };
+
+    static constexpr qint64 kDefaultMemoryBudget = 512LL * 1024 * 1024;
+
+    // Without a plan consumers are not tracked and every bucket counts as needed.
+    explicit DataLake(std::shared_ptr<const ExecutionPlan> plan = {},
+                      qint64 memoryBudget = kDefaultMemoryBudget);
+    ~DataLake();
+
+    DataLake(const DataLake&) = delete;
+    DataLake& operator=(const DataLake&) = delete;
+
+    // 0 disables eviction. Applies from the next write.
+    void setMemoryBudget(qint64 bytes);
+    qint64 memoryBudget() const;
+    // Drops lose values the UI, error packets and incremental re-runs would otherwise
+    // see, so the engine only allows them for independent runs, once all entry tasks
+    // are scheduled.
+    void setDropsAllowed(bool allowed);
+    // Defaults to a per-lake directory under the temp directory, removed with the lake.
+    // Call before the first write.
+    void setSpillDirectory(const QString& directory);
+
+    // Inserts the values into the node's bucket, replacing pins it already holds
+    void merge(const QUuid& node, const QVariantMap& values);
+    // Replaces the node's bucket
+    void replace(const QUuid& node, const QVariantMap& values);
+
+    bool contains(const QUuid& node) const;
+    QVariantMap bucket(const QUuid& node) const;
+    // One pin's value; version, when given, receives the pin's version (0 when unset)
+    QVariant value(const QUuid& node, const QString& pin, quint64* version = nullptr) const;
+    // Increases with every write of the pin, so a reader can tell whether it changed
+    quint64 version(const QUuid& node, const QString& pin) const;
+    // True when any bucket holds a non-empty "__error"; does not read spilled buckets
+    bool hasError() const;
+    // Materialises every bucket, including spilled ones
+    QHash<QUuid, QVariantMap> toHash() const;
+
+    // Consumer tracking, indexed like the plan. Every scheduled task must be matched
+    // by exactly one taskFinished() once its outputs were merged and its successors
+    // scheduled; a task that is never finished only keeps its inputs resident.
+    void taskScheduled(int nodeIndex);
+    void taskFinished(int nodeIndex);
+
+    Metrics metrics() const;
+    // metrics().memoryBytes and spilledBytes without counting buckets, for frequent sampling
+    qint64 memoryBytes() const { return m_memoryBytes.load(); }
+    qint64 spilledBytes() const { return m_spilledBytes.load(); }
+
+    // Approximate in-memory footprint of a bucket; spilled BlobHandles count as free
+    static qint64 approximateBytes(const QVariantMap& values);
+
+private:
+    struct Entry {
+        QVariantMap values;    // everything while resident; spilled BlobHandles otherwise
+        QHash<QString, quint64> versions; // per pin, kept while spilled
+        qint64 bytes {0};      // resident footprint counted against the budget
+        qint64 diskBytes {0};
+        quint64 writeSerial {0};
+        bool spilled {false};
+        bool pinned {false};   // spilling failed; stays resident until rewritten
+        bool hasError {false};
+    };
+
+    static constexpr int kStripeCount = 16;
+    struct Stripe {
+        mutable QReadWriteLock lock;
+        QHash<QUuid, Entry> entries;
+    };
+
+    Stripe& stripeFor(const QUuid& node);
+    const Stripe& stripeFor(const QUuid& node) const;
+    // Eviction and settings: every stripe, in order, after m_evictionMutex
+    void lockAllStripes() const;
+    void unlockAllStripes() const;
+
+    void store(const QUuid& node, Entry& entry, QVariantMap values, quint64 serial);
+    // Called with no stripe held; evicts when the last write took the lake over budget
+    void afterWrite(const QUuid& node);
+    void enforceBudget(const QUuid& justWritten);
+    QVector<bool> neededBuckets() const;
+    bool spill(const QUuid& node, Entry& entry);
+    QVariantMap load(const QUuid& node, const Entry& entry) const;
+    QString spillPath(const QUuid& node) const;
+    void removeSpill(const QUuid& node, Entry& entry);
+    // Moves the process-wide gauges by what changed since the last call
+    void publishMetrics();
+
+    void addMemoryBytes(qint64 delta);
+
+    std::shared_ptr<const ExecutionPlan> m_plan;
+    std::unique_ptr<std::atomic<int>[]> m_outstanding;
+
+    std::array<Stripe, kStripeCount> m_stripes;
+    QMutex m_evictionMutex;
+    std::atomic<qint64> m_budget {kDefaultMemoryBudget};
+    std::atomic<bool> m_dropsAllowed {false};
+    QString m_spillDir;
+    bool m_ownsSpillDir {true};
+    std::atomic<quint64> m_writeSerial {0};
+    std::atomic<qint64> m_memoryBytes {0};
+    std::atomic<qint64> m_peakMemoryBytes {0};
+    std::atomic<qint64> m_spilledBytes {0};
+    std::atomic<int> m_droppedBuckets {0};
+    std::atomic<qint64> m_publishedMemoryBytes {0};
+    std::atomic<qint64> m_publishedSpilledBytes {0};
+};
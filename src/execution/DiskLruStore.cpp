@@ -0,0 +1,235 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "DiskLruStore.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QUuid>
+
+#include <algorithm>
+#include <vector>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+bool hardLink(const QString& from, const QString& to)
+{
+#ifdef Q_OS_WIN
+    const QString nativeFrom = QDir::toNativeSeparators(from);
+    const QString nativeTo = QDir::toNativeSeparators(to);
+    return CreateHardLinkW(reinterpret_cast<LPCWSTR>(nativeTo.utf16()),
+                           reinterpret_cast<LPCWSTR>(nativeFrom.utf16()), nullptr);
+#else
+    return ::link(QFile::encodeName(from).constData(), QFile::encodeName(to).constData()) == 0;
+#endif
+}
+
+} // namespace
+
+DiskLruStore::DiskLruStore(const QString& directory, qint64 maxBytes, const QStringList& nameFilters)
+    : m_directory(QDir::cleanPath(directory))
+    , m_maxBytes(maxBytes)
+    , m_nameFilters(nameFilters)
+{
+}
+
+void DiskLruStore::addField(QCryptographicHash& hash, const QByteArray& field)
+{
+    hash.addData(field);
+    hash.addData(QByteArray(1, '\0'));
+}
+
+// Across file systems, or where links are not supported, a copy does
+bool DiskLruStore::linkOrCopy(const QString& from, const QString& to)
+{
+    if (QFileInfo::exists(to) && !QFile::remove(to)) {
+        return false;
+    }
+    return hardLink(from, to) || QFile::copy(from, to);
+}
+
+QString DiskLruStore::entryPath(const QString& key, const QString& suffix) const
+{
+    // Fan out by the first byte so no single directory grows too large
+    return m_directory + QLatin1Char('/') + key.left(2) + QLatin1Char('/') + key + suffix;
+}
+
+QStringList DiskLruStore::entriesFor(const QString& key) const
+{
+    // Staging names are hidden files, so a half-written entry never matches
+    const QString shard = m_directory + QLatin1Char('/') + key.left(2);
+    QStringList paths;
+    for (const QString& name : QDir(shard).entryList({key + QStringLiteral(".*")}, QDir::Files)) {
+        paths.append(shard + QLatin1Char('/') + name);
+    }
+    return paths;
+}
+
+bool DiskLruStore::touch(const QString& entryPath)
+{
+    // Touching the entry keeps it at the young end of the eviction order
+    QFile entry(entryPath);
+    if (!entry.open(QIODevice::ReadWrite)) return false;
+    entry.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    return true;
+}
+
+bool DiskLruStore::fetch(const QString& entryPath, const QString& destinationPath)
+{
+    QMutexLocker locker(&m_mutex);
+    return touch(entryPath) && linkOrCopy(entryPath, destinationPath);
+}
+
+bool DiskLruStore::store(const QString& entryPath, const QString& sourcePath, const QStringList& replaces)
+{
+    QMutexLocker locker(&m_mutex);
+    const QString entryDir = QFileInfo(entryPath).absolutePath();
+    if (!QDir().mkpath(entryDir)) return false;
+    if (!m_sizeKnown) {
+        measureLocked();
+    }
+
+    // Linked under a private name first so a reader never sees a partial entry
+    const QString staging = entryDir + QStringLiteral("/.") + QUuid::createUuid().toString(QUuid::Id128);
+    if (!linkOrCopy(sourcePath, staging)) {
+        QFile::remove(staging);
+        return false;
+    }
+    qint64 delta = 0;
+    for (const QString& previous : replaces + QStringList{entryPath}) {
+        const qint64 previousSize = QFileInfo(previous).size();
+        if (QFile::remove(previous)) {
+            delta -= previousSize;
+        }
+    }
+    if (!QFile::rename(staging, entryPath)) {
+        QFile::remove(staging);
+        addedLocked(delta);
+        return false;
+    }
+    addedLocked(delta + QFileInfo(entryPath).size());
+    return true;
+}
+
+bool DiskLruStore::write(const QString& entryPath, const Writer& writer)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!QDir().mkpath(QFileInfo(entryPath).absolutePath())) return false;
+    if (!m_sizeKnown) {
+        measureLocked();
+    }
+    const qint64 previousSize = QFileInfo(entryPath).size();
+
+    QSaveFile file(entryPath);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    if (!writer(&file)) {
+        file.cancelWriting();
+        return false;
+    }
+    if (!file.commit()) return false;
+
+    addedLocked(QFileInfo(entryPath).size() - previousSize);
+    return true;
+}
+
+bool DiskLruStore::remove(const QString& entryPath)
+{
+    QMutexLocker locker(&m_mutex);
+    const qint64 size = QFileInfo(entryPath).size();
+    if (!QFile::remove(entryPath)) return false;
+    if (m_sizeKnown) {
+        m_bytes -= size;
+    }
+    return true;
+}
+
+// First write in this process: measure what earlier runs left behind
+void DiskLruStore::measureLocked()
+{
+    m_bytes = 0;
+    QDirIterator it(m_directory, m_nameFilters, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        m_bytes += it.fileInfo().size();
+    }
+    m_sizeKnown = true;
+}
+
+void DiskLruStore::addedLocked(qint64 delta)
+{
+    m_bytes += delta;
+    if (m_maxBytes > 0 && m_bytes > m_maxBytes) {
+        pruneLocked();
+    }
+}
+
+void DiskLruStore::pruneLocked()
+{
+    std::vector<QFileInfo> entries;
+    QDirIterator it(m_directory, m_nameFilters, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        entries.push_back(it.fileInfo());
+    }
+    std::sort(entries.begin(), entries.end(), [](const QFileInfo& a, const QFileInfo& b) {
+        return a.lastModified() < b.lastModified();
+    });
+
+    qint64 total = 0;
+    for (const QFileInfo& entry : entries) {
+        total += entry.size();
+    }
+    const qint64 target = m_maxBytes - m_maxBytes / 10;
+    for (const QFileInfo& entry : entries) {
+        if (total <= target) break;
+        if (QFile::remove(entry.absoluteFilePath())) {
+            total -= entry.size();
+        }
+    }
+    m_bytes = total;
+}
+
+qint64 DiskLruStore::sizeBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_bytes;
+}
+
+void DiskLruStore::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    QDir(m_directory).removeRecursively();
+    m_bytes = 0;
+    m_sizeKnown = true;
+}
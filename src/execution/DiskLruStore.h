@@ -0,0 +1,101 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+#include <functional>
+
+class QCryptographicHash;
+class QIODevice;
+
+// A directory of cache entries trimmed least recently used first.
+//
+// Entries fan out into subdirectories by the first two characters of their key
+// and are matched by nameFilters when the directory is measured or pruned, so
+// staging files and anything else sharing the directory are never counted. Files
+// are linked in under a hidden staging name and renamed into place, or written
+// through QSaveFile, so a reader never sees a partial entry. Hits refresh an
+// entry's modification time; once the directory grows beyond maxBytes the oldest
+// entries are removed down to 90% of the budget. Callers supply the key and file
+// name scheme; the store does the bookkeeping and is safe to share between threads.
+class DiskLruStore {
+public:
+    using Writer = std::function<bool(QIODevice*)>;
+
+    // An empty nameFilters list counts every file in the directory
+    DiskLruStore(const QString& directory, qint64 maxBytes, const QStringList& nameFilters = {});
+
+    // Appends a field and a terminator, so adjacent fields can never run together
+    static void addField(QCryptographicHash& hash, const QByteArray& field);
+
+    // Hard links where the file system allows it and copies otherwise, replacing
+    // any file at to.
+    static bool linkOrCopy(const QString& from, const QString& to);
+
+    const QString& directory() const { return m_directory; }
+    qint64 maxBytes() const { return m_maxBytes; }
+
+    // directory/<first two characters of key>/<key><suffix>
+    QString entryPath(const QString& key, const QString& suffix) const;
+
+    // Entries stored under key with any suffix
+    QStringList entriesFor(const QString& key) const;
+
+    // Refreshes the entry's place in the eviction order; false when it is missing
+    bool touch(const QString& entryPath);
+
+    // Touches the entry and places it at destinationPath
+    bool fetch(const QString& entryPath, const QString& destinationPath);
+
+    // Links or copies sourcePath in as entryPath, removing the entries in replaces
+    // once it is staged.
+    bool store(const QString& entryPath, const QString& sourcePath, const QStringList& replaces = {});
+
+    // Writes entryPath through writer; a false return leaves the old entry in place
+    bool write(const QString& entryPath, const Writer& writer);
+
+    bool remove(const QString& entryPath);
+
+    // Bytes of entries on disk, as tracked by this process.
+    qint64 sizeBytes() const;
+
+    void clear();
+
+private:
+    void measureLocked();
+    void addedLocked(qint64 delta);
+    void pruneLocked();
+
+    QString m_directory;
+    qint64 m_maxBytes;
+    QStringList m_nameFilters;
+    mutable QMutex m_mutex;
+    bool m_sizeKnown = false;
+    qint64 m_bytes = 0;
+};
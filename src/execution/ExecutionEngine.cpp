@@ -32,10 +32,14 @@
 #include <QThread>
 #include <QTimer>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QStandardPaths>
 #include <QDir>
+#include <QFileInfo>
 #include <QRegularExpression>
 #include <algorithm>
+#include <limits>
+#include <utility>
 
 #include <QtNodes/DataFlowGraphModel>
 #include <QtNodes/internal/Definitions.hpp>
@@ -44,23 +48,92 @@
 #include "ToolNodeDelegate.h"
 #include "RagIndexerNode.h"
 #include "ExecutionIdUtils.h"
-
-#include <unordered_set>
+#include "WorkStealingScheduler.h"
+#include "InputSignature.h"
+#include "ResultCache.h"
+#include "ExecutionTrace.h"
+#include "RunCheckpoint.h"
+#include "RunHistory.h"
+#include "RunRecording.h"
+#include "BlobHandle.h"
+#include "PartialOutputSink.h"
+#include "RetryPolicy.h"
+#include "CpuWorkerPool.h"
+#include "RemoteWorkerPool.h"
 
 namespace {
 
-QUuid nodeUuidForId(NodeGraphModel* graphModel, QtNodes::NodeId nodeId)
+// cp_node_executions by outcome, and cp_node_execution_seconds for nodes that ran
+void recordNodeExecution(const QString& typeId, const QString& outcome, double seconds = -1.0)
 {
-    return ExecIds::nodeUuid(graphModel ? graphModel->executionScopeKey() : QStringLiteral("root"), nodeId);
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    metrics.counter(QStringLiteral("cp_node_executions"), QStringLiteral("Node executions by type and outcome"),
+                    {{QStringLiteral("node_type"), typeId}, {QStringLiteral("outcome"), outcome}})
+        .increment();
+    if (seconds >= 0.0) {
+        metrics.histogram(QStringLiteral("cp_node_execution_seconds"),
+                          QStringLiteral("Node execution time, from start to its outputs"),
+                          {{QStringLiteral("node_type"), typeId}})
+            .observe(seconds);
+    }
+}
+
+// cp_node_input_bytes / cp_node_output_bytes: approximate payload sizes per execution
+void recordPayloadSizes(const QString& typeId, qint64 inputBytes, qint64 outputBytes)
+{
+    // 1 KiB to 256 MiB in powers of four
+    static const QVector<double> byteBuckets = {1024.0, 4096.0, 16384.0, 65536.0, 262144.0, 1048576.0,
+                                                4194304.0, 16777216.0, 67108864.0, 268435456.0};
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    const MetricsRegistry::Labels labels = {{QStringLiteral("node_type"), typeId}};
+    metrics.histogram(QStringLiteral("cp_node_input_bytes"),
+                      QStringLiteral("Approximate size of a node execution's input tokens"), labels, byteBuckets)
+        .observe(static_cast<double>(inputBytes));
+    metrics.histogram(QStringLiteral("cp_node_output_bytes"),
+                      QStringLiteral("Approximate size of a node execution's output tokens"), labels, byteBuckets)
+        .observe(static_cast<double>(outputBytes));
+}
+
+// cp_speculative_tasks: branches started early, by whether the decision kept them
+void recordSpeculation(const QString& outcome, quint64 count = 1)
+{
+    MetricsRegistry::instance()
+        .counter(QStringLiteral("cp_speculative_tasks"),
+                 QStringLiteral("Branch nodes started before their router decided, by outcome"),
+                 {{QStringLiteral("outcome"), outcome}})
+        .increment(count);
+}
+
+// cp_fused_tasks: tasks run straight after their producer on the same worker
+void recordFusedTask()
+{
+    MetricsRegistry::instance()
+        .counter(QStringLiteral("cp_fused_tasks"),
+                 QStringLiteral("Chain nodes run by the worker that finished their producer"))
+        .increment();
+}
+
+// Retry-After of the first error token a node marked transient (RetryPolicy), or -1
+int transientRetryAfterMs(const TokenList& tokens)
+{
+    for (const auto& token : tokens) {
+        const auto marker = token.data.constFind(QString::fromLatin1(RetryPolicy::kRetryAfterKey));
+        if (marker != token.data.cend() && token.data.contains(QStringLiteral("__error"))) {
+            return std::max(0, marker.value().toInt());
+        }
+    }
+    return -1;
 }
 
-QUuid connectionUuidForId(NodeGraphModel* graphModel, const QtNodes::ConnectionId& c)
+QUuid nodeUuidForId(NodeGraphModel* graphModel, QtNodes::NodeId nodeId)
 {
-    return ExecIds::connectionUuid(graphModel ? graphModel->executionScopeKey() : QStringLiteral("root"), c);
+    return ExecIds::nodeUuid(graphModel ? graphModel->executionScopeKey() : QStringLiteral("root"), nodeId);
 }
 
 } // namespace
 
+thread_local ExecutionEngine::FusionSlot* ExecutionEngine::s_fusionSlot = nullptr;
+
 // Thread-local execution context to expose current node id/uuid to node implementations for logging
 // Defined here and referenced as 'extern' in control-flow node translation units.
 thread_local QtNodes::NodeId g_CurrentNodeId = QtNodes::InvalidNodeId;
@@ -70,6 +143,13 @@ thread_local QUuid g_CurrentNodeUuid = QUuid();
 QString ExecutionEngine::truncateAndEscape(const QVariant& v)
 {
     QString s;
+    if (v.metaType() == QMetaType::fromType<BlobHandle>()) {
+        // Never materialise a blob just to log it
+        const BlobHandle blob = v.value<BlobHandle>();
+        return QStringLiteral("<blob %1 bytes%2>")
+            .arg(QString::number(blob.size()),
+                 blob.mimeType().isEmpty() ? QString() : QStringLiteral(", ") + blob.mimeType());
+    }
     if (v.typeId() == QMetaType::QVariantList || v.typeId() == QMetaType::QStringList || v.typeId() == QMetaType::QVariantMap) {
         s = QJsonDocument::fromVariant(v).toJson(QJsonDocument::Compact);
     } else {
@@ -99,7 +179,7 @@ QtNodes::NodeId ExecutionEngine::nodeIdForUuid(const QUuid& uuid) const
     return std::numeric_limits<unsigned int>::max();
 }
 
-QString ExecutionEngine::getNodeOutputDir(const QString& nodeId, int runIndex) const
+QString ExecutionEngine::getProjectOutputDir() const
 {
     QString sanitizedProject = m_projectName;
     // Sanitization: replace spaces/special chars with underscores
@@ -115,8 +195,12 @@ QString ExecutionEngine::getNodeOutputDir(const QString& nodeId, int runIndex) c
         base = QDir::homePath() + QStringLiteral("/Documents");
     }
     
-    QString path = base + QStringLiteral("/CognitivePipelineOutput/") 
-                 + sanitizedProject + QStringLiteral("/")
+    return QDir::cleanPath(base + QStringLiteral("/CognitivePipelineOutput/") + sanitizedProject);
+}
+
+QString ExecutionEngine::getNodeOutputDir(const QString& nodeId, int runIndex) const
+{
+    QString path = getProjectOutputDir() + QStringLiteral("/")
                  + QStringLiteral("Node_") + nodeId + QStringLiteral("/")
                  + QStringLiteral("Run_") + QString::number(runIndex) + QStringLiteral("/");
     
@@ -126,7 +210,13 @@ QString ExecutionEngine::getNodeOutputDir(const QString& nodeId, int runIndex) c
 ExecutionEngine::ExecutionEngine(NodeGraphModel* model, QObject* parent)
     : QObject(parent)
     , _graphModel(model)
+    , m_scheduler(std::make_unique<WorkStealingScheduler>(&m_threadPool))
 {
+    m_traceResidentMemory = qEnvironmentVariableIntValue("CP_TRACE_RSS") != 0;
+    m_threadQosEnabled = qEnvironmentVariable("CP_THREAD_QOS", QStringLiteral("1")) != QLatin1String("0");
+    m_utilityPool.setThreadPriority(ThreadQos::threadPriority(ThreadQos::Level::Utility));
+    m_backgroundPool.setThreadPriority(ThreadQos::threadPriority(ThreadQos::Level::Background));
+
     // Dispatcher throttling timer runs in the engine's thread (main/UI).
     // It sequences task launches at a fixed cadence to provide reliable slow-motion
     // and to avoid simultaneous sleeps across worker threads.
@@ -134,16 +224,121 @@ ExecutionEngine::ExecutionEngine(NodeGraphModel* model, QObject* parent)
     m_throttler->setSingleShot(false);
     connect(m_throttler, &QTimer::timeout, this, &ExecutionEngine::onThrottleTimeout);
 
-    m_finalizeTimer = new QTimer(this);
-    m_finalizeTimer->setSingleShot(true);
-    connect(m_finalizeTimer, &QTimer::timeout, this, &ExecutionEngine::onFinalizeTimeout);
+    // Retries wait here rather than on a worker
+    m_retryTimer = new QTimer(this);
+    m_retryTimer->setSingleShot(true);
+    connect(m_retryTimer, &QTimer::timeout, this, &ExecutionEngine::onRetryTimeout);
+
+    m_outputFlushTimer = new QTimer(this);
+    m_outputFlushTimer->setSingleShot(false);
+    m_outputFlushTimer->setInterval(kOutputFlushIntervalMs);
+    connect(m_outputFlushTimer, &QTimer::timeout, this, &ExecutionEngine::flushOutputNotifications);
+
+    setResourceBudgets(ResourceBudgets());
+    qRegisterMetaType<RunAnalysis>();
+    qRegisterMetaType<RunUsageReport>();
+
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    m_queuedTasksMetric = metrics.addGaugeCallback(QStringLiteral("cp_engine_queued_tasks"),
+                                                   QStringLiteral("Tasks scheduled and waiting to start"), {},
+                                                   [this]() { return static_cast<double>(queuedTaskCount()); });
+    m_activeTasksMetric = metrics.addGaugeCallback(QStringLiteral("cp_engine_active_tasks"),
+                                                   QStringLiteral("Tasks running, asynchronous nodes included"), {},
+                                                   [this]() { return static_cast<double>(activeTaskCount()); });
 }
 
 ExecutionEngine::~ExecutionEngine()
 {
+    m_queuedTasksMetric.reset();
+    m_activeTasksMetric.reset();
+    // Retire every run so late completions take the cancelled-run paths, then wait for
+    // any asynchronous continuation that is already inside the engine
+    {
+        QMutexLocker locker(&m_queueMutex);
+        if (const auto run = std::atomic_load(&m_run)) run->cancel();
+        for (const auto& run : std::as_const(m_independentRuns)) run->cancel();
+    }
+    {
+        QWriteLocker lifetimeLock(&m_lifetime->lock);
+        m_lifetime->alive = false;
+    }
     if (m_throttler) m_throttler->stop();
-    if (m_finalizeTimer) m_finalizeTimer->stop();
+    if (m_retryTimer) m_retryTimer->stop();
+    if (m_outputFlushTimer) m_outputFlushTimer->stop();
+    if (m_scheduler) m_scheduler->clear();
     m_threadPool.waitForDone();
+    m_utilityPool.waitForDone();
+    m_backgroundPool.waitForDone();
+    m_networkPool.waitForDone();
+    m_processPool.waitForDone();
+    m_guiPool.waitForDone();
+}
+
+void ExecutionEngine::setResourceBudgets(const ResourceBudgets& budgets)
+{
+    QMutexLocker locker(&m_queueMutex);
+    m_budgets = budgets;
+    for (int i = 0; i < kResourceClassCount; ++i) {
+        const auto resourceClass = static_cast<ResourceClass>(i);
+        poolFor(resourceClass)->setMaxThreadCount(budgets.limit(resourceClass));
+    }
+    // The global queue caps Cpu tasks across all three pools at the same budget
+    m_utilityPool.setMaxThreadCount(budgets.limit(ResourceClass::Cpu));
+    m_backgroundPool.setMaxThreadCount(budgets.limit(ResourceClass::Cpu));
+    // Work-stealing lanes run on m_threadPool, so they follow the same budget
+    m_scheduler->setLaneCount(budgets.limit(ResourceClass::Cpu));
+}
+
+ResourceBudgets ExecutionEngine::resourceBudgets() const
+{
+    QMutexLocker locker(&m_queueMutex);
+    return m_budgets;
+}
+
+void ExecutionEngine::setRemoteWorkers(std::shared_ptr<RemoteWorkerPool> workers)
+{
+    QMutexLocker locker(&m_queueMutex);
+    if (m_remoteWorkers) QObject::disconnect(m_remoteWorkers.get(), nullptr, this, nullptr);
+    m_remoteWorkers = std::move(workers);
+    if (m_remoteWorkers) {
+        // Workers coming and going change which queued tasks can launch
+        connect(m_remoteWorkers.get(), &RemoteWorkerPool::capacityChanged, this, &ExecutionEngine::processNext,
+                Qt::QueuedConnection);
+    }
+}
+
+bool ExecutionEngine::runsRemotely(const ExecutionTask& task) const
+{
+    if (!m_remoteWorkers || !task.plan || task.nodeIndex < 0) return false;
+    return m_remoteWorkers->handles(task.plan->node(task.nodeIndex).typeId);
+}
+
+ResourceClass ExecutionEngine::resourceClassOf(const ExecutionTask& task)
+{
+    if (!task.plan || task.nodeIndex < 0) return ResourceClass::Cpu;
+    return task.plan->node(task.nodeIndex).resourceClass;
+}
+
+int ExecutionEngine::concurrencyOf(const ExecutionTask& task)
+{
+    if (!task.plan || task.nodeIndex < 0) return 1;
+    return task.plan->node(task.nodeIndex).maxConcurrency;
+}
+
+QThreadPool* ExecutionEngine::poolFor(ResourceClass resourceClass, ThreadQos::Level qos)
+{
+    switch (resourceClass) {
+    case ResourceClass::Network:   return &m_networkPool;
+    case ResourceClass::Process:   return &m_processPool;
+    case ResourceClass::GuiAffine: return &m_guiPool;
+    case ResourceClass::Cpu:       break;
+    }
+    switch (qos) {
+    case ThreadQos::Level::Utility:       return &m_utilityPool;
+    case ThreadQos::Level::Background:    return &m_backgroundPool;
+    case ThreadQos::Level::UserInitiated: break;
+    }
+    return &m_threadPool;
 }
 
 void ExecutionEngine::Run(QtNodes::NodeId startNodeId, TaskPriority p)
@@ -155,53 +350,279 @@ void ExecutionEngine::Run(QtNodes::NodeId startNodeId, TaskPriority p)
     }
 }
 
+void ExecutionEngine::resumePipeline(TaskPriority p)
+{
+    m_resumeNextRun = true;
+    runPipeline({}, p);
+}
+
 void ExecutionEngine::stop()
 {
+    QList<std::shared_ptr<RunContext>> independent;
     {
         QMutexLocker locker(&m_queueMutex);
-        m_currentRunId = QUuid::createUuid();
-        m_priorityQueue.clear();
-        m_nodeInFlight.clear();
+        if (const auto run = std::atomic_load(&m_run)) {
+            run->cancel();
+            // A stopped run can be resumed from what it finished
+            if (const auto checkpoint = run->checkpoint) {
+                (void)QtConcurrent::run([checkpoint]() {
+                    QString error;
+                    if (!checkpoint->close(true, &error)) {
+                        CP_WARN << "ExecutionEngine: Could not write checkpoint" << checkpoint->path() << ":" << error;
+                    }
+                });
+            }
+        }
+        independent = m_independentRuns.values();
+        m_independentRuns.clear();
+        for (const auto& run : std::as_const(independent)) run->cancel();
+        m_readyQueue.clear();
+        m_delayedTasks.clear();
     }
+    m_scheduler->clear();
+    std::atomic_store(&m_outputMailbox, std::shared_ptr<OutputMailbox>());
     
     if (m_throttler) m_throttler->stop();
-    if (m_finalizeTimer) m_finalizeTimer->stop();
+    if (m_retryTimer) m_retryTimer->stop();
+    if (m_outputFlushTimer) m_outputFlushTimer->stop();
 
-    emit nodeLog(QStringLiteral("Pipeline execution stopped by user."));
+    postLog(QStringLiteral("Pipeline execution stopped by user."));
+    for (const auto& run : std::as_const(independent)) {
+        if (!run->finalized.exchange(true)) {
+            emit runFinished(run->id, DataPacket{}, false);
+        }
+    }
     emit pipelineStopped();
     emit executionFinished();
 }
 
-void ExecutionEngine::runPipeline(const QList<QUuid>& specificEntryPoints, TaskPriority p)
+void ExecutionEngine::cancelRun(const QUuid& runId)
+{
+    std::shared_ptr<RunContext> run;
+    {
+        QMutexLocker locker(&m_queueMutex);
+        run = m_independentRuns.take(runId);
+        if (run) run->cancel();
+    }
+    if (run && !run->finalized.exchange(true)) {
+        emit runFinished(run->id, DataPacket{}, false);
+    }
+}
+
+std::shared_ptr<ExecutionEngine::RunContext> ExecutionEngine::createRun(bool foreground, TaskPriority p,
+                                                                        QDeadlineTimer deadline)
+{
+    auto run = std::make_shared<RunContext>();
+    run->id = QUuid::createUuid();
+    run->foreground = foreground;
+    run->priority = p;
+    run->qos = m_threadQosEnabled ? threadQosOf(foreground, p) : ThreadQos::Level::UserInitiated;
+    run->cancellation = CancellationToken::create(
+        deadline.isForever() ? CancellationToken::kNoDeadline : deadline.deadline(), runSlackMs(p));
+    // Compile the topology once; workers of this run only read the snapshot
+    run->plan = ExecutionPlan::compile(_graphModel);
+
+    // Result cache directory is resolved per run so project renames are picked up
+    const QString resultCacheDir = m_resultCacheDir.isEmpty()
+        ? getProjectOutputDir() + QStringLiteral("/.result_cache")
+        : m_resultCacheDir;
+    if (!m_resultCache || m_resultCache->directory() != QDir::cleanPath(resultCacheDir)) {
+        m_resultCache = std::make_shared<const ResultCache>(resultCacheDir, m_resultCacheMaxBytes);
+    }
+    if (m_resultCacheEnabled) {
+        run->resultCache = m_resultCache;
+    }
+    run->itemCache = m_resultCache;
+    if (m_traceEnabled) {
+        run->trace = std::make_shared<ExecutionTrace>(run->id);
+    }
+    if (m_recordingEnabled) {
+        run->recording = std::make_shared<RunRecording>();
+    }
+    if (m_usageReportEnabled && foreground) {
+        run->usage = std::make_shared<RunUsageCollector>(run->id);
+    }
+    run->replay = m_replay;
+    run->replayLatencyScale = m_replayLatencyScale;
+    run->span = Tracer::instance().startSpan(QStringLiteral("pipeline run"));
+    if (run->span.isRecording()) {
+        run->span.setAttribute(QStringLiteral("cp.run.id"), run->id.toString(QUuid::WithoutBraces));
+        run->span.setAttribute(QStringLiteral("cp.run.foreground"), foreground);
+        run->span.setAttribute(QStringLiteral("cp.run.priority"), static_cast<int>(p));
+        run->span.setAttribute(QStringLiteral("cp.run.qos"), ThreadQos::name(run->qos));
+        if (!deadline.isForever()) {
+            run->span.setAttribute(QStringLiteral("cp.run.deadline_ms"), deadline.remainingTime());
+        }
+        run->span.setAttribute(QStringLiteral("cp.pipeline.node_count"),
+                               run->plan ? run->plan->nodes().size() : 0);
+    }
+    // Local models start loading while the first nodes are still being scheduled
+    if (run->plan) {
+        for (const auto& entry : run->plan->nodes()) {
+            if (entry.node) entry.node->warmUp();
+        }
+    }
+    run->lake = std::make_shared<DataLake>(run->plan, m_dataLakeBudget);
+    const int nodeCount = run->plan ? run->plan->nodes().size() : 0;
+    run->inputDepth = std::make_unique<std::atomic<int>[]>(nodeCount);
+    for (int i = 0; i < nodeCount; ++i) {
+        run->inputDepth[i].store(0, std::memory_order_relaxed);
+    }
+    run->inputQueueCapacity = m_inputQueueCapacity;
+    return run;
+}
+
+QUuid ExecutionEngine::startIndependentRun(const QHash<QUuid, QVariantMap>& presetOutputs, TaskPriority p,
+                                           QDeadlineTimer deadline)
 {
     if (!_graphModel) {
         CP_WARN << "ExecutionEngine: No graph model available.";
-        return;
+        return {};
     }
 
-    // Clear global state
+    const auto run = createRun(false, p, deadline);
+    run->presetOutputs = presetOutputs;
     {
-        QWriteLocker stateLock(&m_dataLock);
-        m_dataLake.clear();
+        QMutexLocker locker(&m_queueMutex);
+        m_independentRuns.insert(run->id, run);
+    }
+
+    for (int index = 0; index < run->plan->nodes().size(); ++index) {
+        const auto& entry = run->plan->node(index);
+        if (entry.hasIncoming) continue;
+        ExecutionTask task;
+        task.nodeId = entry.nodeId;
+        task.nodeUuid = entry.uuid;
+        task.nodeIndex = index;
+        task.run = run;
+        scheduleNode(std::move(task), p);
+    }
+    // Nothing reads an independent run's intermediate outputs once their consumers are
+    // done, so with every entry task counted the lake may drop them
+    run->lake->setDropsAllowed(true);
+
+    // Drop the seeding hold; a run with nothing to execute finishes here
+    releaseWork(run);
+    return run->id;
+}
+
+void ExecutionEngine::runPipeline(const QList<QUuid>& specificEntryPoints, TaskPriority p, RunMode mode)
+{
+    if (!_graphModel) {
+        CP_WARN << "ExecutionEngine: No graph model available.";
+        return;
     }
+
+    // Deliver anything still pending from the previous run before its marks are dropped
+    flushOutputNotifications();
+
+    // Project budgets apply from this run on
+    setResourceBudgets(ResourceBudgets::fromJson(_graphModel->resourceBudgets()));
+
+    // Retire the previous foreground run; independent runs keep going
+    if (m_throttler) m_throttler->stop();
+    m_scheduler->clear(); // only work-stealing foreground runs post here
+    QList<std::shared_ptr<RunContext>> dropped;
     {
         QMutexLocker qlock(&m_queueMutex);
-        m_activeTasks = 0;
-        m_finalized = false;
-        m_lastInputSignature.clear();
-        m_hardError = false;
+        if (const auto previousRun = std::atomic_load(&m_run)) previousRun->cancel();
+        if (pruneQueue(dropped) > 0 && m_executionDelay > 0) {
+            QMetaObject::invokeMethod(m_throttler, "start", Qt::QueuedConnection,
+                                      Q_ARG(int, std::max(1, m_executionDelay)));
+        }
     }
+    for (const auto& droppedRun : std::as_const(dropped)) releaseWork(droppedRun);
 
-    // Stop throttler and clear priority queue for a clean run
-    if (m_throttler) m_throttler->stop();
-    m_priorityQueue.clear();
-    m_nodeInFlight.clear();
+    const auto run = createRun(true, p);
+    const auto& plan = run->plan;
+
+    // Work stealing needs no throttler, so slow-motion runs always use the global queue
+    if (m_schedulerMode == SchedulerMode::WorkStealing && m_executionDelay == 0) {
+        auto mailboxes = std::make_shared<RunMailboxes>();
+        mailboxes->size = plan->nodes().size();
+        mailboxes->boxes = std::make_unique<NodeMailbox[]>(static_cast<size_t>(mailboxes->size));
+        run->mailboxes = std::move(mailboxes);
+    }
+    std::atomic_store(&m_run, run);
+
+    std::shared_ptr<OutputMailbox> outputMailbox;
+    if (m_outputMode == OutputNotificationMode::Coalesced) {
+        outputMailbox = std::make_shared<OutputMailbox>();
+        outputMailbox->runId = run->id;
+        outputMailbox->plan = plan;
+        outputMailbox->size = plan->nodes().size();
+        outputMailbox->dirty = std::make_unique<std::atomic<bool>[]>(static_cast<size_t>(outputMailbox->size));
+        m_outputFlushTimer->start();
+    } else {
+        m_outputFlushTimer->stop();
+    }
+    std::atomic_store(&m_outputMailbox, outputMailbox);
+
+    // Record what this run starts from so a later incremental run can diff against it
+    RunSnapshot current;
+    for (const auto& entry : plan->nodes()) {
+        if (entry.node) {
+            current.configSignatures.insert(entry.uuid,
+                                            RunCheckpoint::configSignature(entry.typeId, entry.node->saveState()));
+        }
+        QVector<QUuid> incoming = entry.incomingConnectionUuids;
+        std::sort(incoming.begin(), incoming.end());
+        current.incoming.insert(entry.uuid, incoming);
+    }
+    if (run->usage && m_runHistory) {
+        run->historyGraphHash = RunHistory::graphHash(*plan);
+        run->historyConfigHash = RunHistory::configHash(current.configSignatures);
+    }
+
+    // Resume answers unchanged nodes from the last checkpoint; it is read before this
+    // run's own checkpoint can replace it
+    const bool resuming = std::exchange(m_resumeNextRun, false);
+    if (resuming) {
+        QString error;
+        run->resume = RunCheckpoint::load(checkpointPath(), current.configSignatures, &error);
+        if (run->resume) {
+            postLog(QStringLiteral("ExecutionEngine: Resuming from %1 checkpointed node execution(s)")
+                        .arg(run->resume->size()));
+        } else {
+            postLog(QStringLiteral("ExecutionEngine: Nothing to resume (%1); running the full pipeline.").arg(error));
+        }
+    }
+    if (m_checkpointEnabled || resuming) {
+        run->checkpoint = std::make_shared<RunCheckpoint>(checkpointPath(), current.configSignatures,
+                                                          m_checkpointIntervalSeconds);
+    }
 
-    // New Run ID for this pipeline execution to guard against zombie threads
-    m_currentRunId = QUuid::createUuid();
+    QSet<QUuid> wanted;
+    for (const auto& u : specificEntryPoints) wanted.insert(u);
 
-    // Reset node run counters for this session/run
-    m_nodeRunCounters.clear();
+    QVector<bool> inCone;
+    RunSnapshot previous;
+    if (mode == RunMode::Incremental) {
+        {
+            QMutexLocker locker(&m_snapshotMutex);
+            previous = m_lastSuccessfulRun;
+        }
+        inCone = computeDirtyCone(*plan, previous, current, wanted);
+        if (inCone.isEmpty()) {
+            postLog(QStringLiteral("ExecutionEngine: No previous successful run; running the full pipeline."));
+        }
+    }
+    // A run from explicit entry points leaves untouched nodes out of the data lake,
+    // so only full and incremental runs can serve as a baseline
+    current.valid = specificEntryPoints.isEmpty() || !inCone.isEmpty();
+    {
+        QMutexLocker locker(&m_snapshotMutex);
+        m_pendingSnapshot = std::move(current);
+    }
+
+    // Seed clean nodes with their outputs from the last successful run
+    if (!inCone.isEmpty() && previous.dataLake) {
+        for (int index = 0; index < plan->nodes().size(); ++index) {
+            if (inCone[index]) continue;
+            const QUuid& uuid = plan->node(index).uuid;
+            if (previous.dataLake->contains(uuid)) run->lake->replace(uuid, previous.dataLake->bucket(uuid));
+        }
+    }
 
     emit executionStarted();
 
@@ -209,82 +630,134 @@ void ExecutionEngine::runPipeline(const QList<QUuid>& specificEntryPoints, TaskP
     m_lastActivityMs = QDateTime::currentMSecsSinceEpoch();
 
     // Reset canvas to Idle before starting execution
-    const auto nodeIds = _graphModel->allNodeIds();
     {
-        for (auto nodeId : nodeIds) {
-            emit nodeStatusChanged(nodeUuidForId(_graphModel, nodeId), static_cast<int>(ExecutionState::Idle));
+        for (const auto& entry : plan->nodes()) {
+            emit nodeStatusChanged(entry.uuid, static_cast<int>(ExecutionState::Idle));
         }
-        std::unordered_set<QtNodes::ConnectionId> resetConnections;
-        for (auto nodeId : nodeIds) {
-            const auto conns = _graphModel->allConnectionIds(nodeId);
-            resetConnections.insert(conns.begin(), conns.end());
-        }
-        for (const auto& cid : resetConnections) {
-            emit connectionStatusChanged(connectionUuidForId(_graphModel, cid), static_cast<int>(ExecutionState::Idle));
+        // Every connection is inbound to exactly one node, so this visits each once
+        for (const auto& entry : plan->nodes()) {
+            for (const auto& connUuid : entry.incomingConnectionUuids) {
+                emit connectionStatusChanged(connUuid, static_cast<int>(ExecutionState::Idle));
+            }
         }
     }
 
+    if (!inCone.isEmpty()) {
+        seedDirtyCone(run, inCone, p);
+        releaseWork(run);
+        return;
+    }
+
     // Seed initial tasks
-    if (specificEntryPoints.isEmpty()) {
-        const auto nodeIds = _graphModel->allNodeIds();
-        // Seed with all source nodes (nodes with no incoming edges)
-        for (auto nodeId : nodeIds) {
-            bool hasIncoming = false;
-            const auto attached = _graphModel->allConnectionIds(nodeId);
-            for (const auto& cid : attached) {
-                if (cid.inNodeId == nodeId) { hasIncoming = true; break; }
-            }
-            if (!hasIncoming) {
-                ExecutionTask task;
-                task.nodeId = nodeId;
-                task.nodeUuid = nodeUuidForId(_graphModel, nodeId);
-                // Empty inputs are acceptable for source nodes
-                scheduleNode(task, p);
-            }
-        }
-    } else {
-        // Seed only the specified entry point nodes
-        QSet<QUuid> wanted;
-        for (const auto& u : specificEntryPoints) wanted.insert(u);
-        for (auto nodeId : nodeIds) {
-            const QUuid uuid = nodeUuidForId(_graphModel, nodeId);
-            if (!wanted.contains(uuid)) continue;
-            ExecutionTask task;
-            task.nodeId = nodeId;
-            task.nodeUuid = uuid;
-            scheduleNode(task, p);
+    for (int index = 0; index < plan->nodes().size(); ++index) {
+        const auto& entry = plan->node(index);
+        // Without explicit entry points, seed all source nodes (nodes with no incoming edges)
+        if (specificEntryPoints.isEmpty() ? entry.hasIncoming : !wanted.contains(entry.uuid)) {
+            continue;
         }
+        ExecutionTask task;
+        task.nodeId = entry.nodeId;
+        task.nodeUuid = entry.uuid;
+        task.nodeIndex = index;
+        task.run = run;
+        // Empty inputs are acceptable for source nodes
+        scheduleNode(std::move(task), p);
     }
 
-    // In case there are no source nodes or all tasks were skipped, attempt finalization now
-    tryFinalize();
+    // Drop the seeding hold; with no source nodes, or every task skipped, the run finishes now
+    releaseWork(run);
+}
+
+qint64 ExecutionEngine::taskDueMs(const RunContext& run, TaskPriority p)
+{
+    const qint64 due = run.cancellation.dueBy(QDeadlineTimer::current().deadline());
+    return p > run.priority ? due - kTaskLeadMs : due;
 }
 
-void ExecutionEngine::scheduleNode(const ExecutionTask& task, TaskPriority p)
+void ExecutionEngine::scheduleNode(ExecutionTask toSchedule, TaskPriority p)
 {
-    // Assign run identity and priority at scheduling time
-    ExecutionTask toSchedule = task;
-    toSchedule.runId = m_currentRunId;
+    // Assign run identity and priority at scheduling time. The task counts towards the
+    // run's outstanding work until it is done or dropped.
+    const std::shared_ptr<RunContext> run = toSchedule.run;
+    run->outstanding.fetch_add(1, std::memory_order_relaxed);
+    toSchedule.runId = run->id;
+    toSchedule.plan = run->plan;
     toSchedule.priority = static_cast<int>(p);
+    toSchedule.dueMs = taskDueMs(*run, p);
+    if (run->trace) {
+        toSchedule.queuedAtUs = run->trace->nowUs();
+    }
+    if (run->usage) {
+        toSchedule.usageQueuedAtUs = run->usage->nowUs();
+    }
+    if (!toSchedule.speculative && toSchedule.nodeIndex >= 0 && toSchedule.plan->node(toSchedule.nodeIndex).orderedOutputs
+        && concurrencyOf(toSchedule) > 1) {
+        QMutexLocker orderLock(&run->orderMutex);
+        toSchedule.sequence = run->outputOrders[toSchedule.nodeIndex].issued++;
+    }
+    // Until finishTask() the task's inputs count as needed; tasks dropped below are
+    // never finished, which only keeps their producers' outputs resident
+    run->lake->taskScheduled(toSchedule.nodeIndex);
+    if (toSchedule.nodeIndex >= 0) {
+        run->inputDepth[toSchedule.nodeIndex].fetch_add(1, std::memory_order_acq_rel);
+    }
+    enqueueTask(std::move(toSchedule));
+}
+
+void ExecutionEngine::enqueueTask(ExecutionTask toSchedule)
+{
+    const std::shared_ptr<RunContext> run = toSchedule.run;
+
+    // Work-stealing mode: per-node mailboxes and per-worker deques, no global queue lock
+    if (run->mailboxes) {
+        if (run->cancelled) {
+            releaseWork(run);
+        } else {
+            scheduleStealing(run->mailboxes, std::move(toSchedule));
+        }
+        return;
+    }
 
     QMutexLocker locker(&m_queueMutex);
-    if (m_hardError) return;
+    if (run->hardError || run->cancelled) {
+        locker.unlock();
+        releaseWork(run);
+        return;
+    }
+
+    // The next link of a fused chain is launched onto the worker that produced its input
+    if (FusionSlot* slot = fusionSlotFor(toSchedule);
+        slot && run->nodeInFlight.value(toSchedule.nodeUuid, 0) < concurrencyOf(toSchedule)
+        && !runsRemotely(toSchedule)) {
+        ++run->nodeInFlight[toSchedule.nodeUuid];
+        ++run->activeTasks;
+        ++m_activeByClass[static_cast<int>(resourceClassOf(toSchedule))];
+        const QString nodeIdStr = QString::number(toSchedule.nodeId);
+        const int runIndex = run->nodeRunCounters.value(nodeIdStr, 0);
+        run->nodeRunCounters.insert(nodeIdStr, runIndex + 1);
+        locker.unlock();
+
+        auto done = [this, task = toSchedule]() { completeTask(task); };
+        slot->next = FusedTask{std::move(toSchedule), getNodeOutputDir(nodeIdStr, runIndex), std::move(done)};
+        return;
+    }
 
     // Source nodes bypass the throttler to allow parallel entry points even in slow-motion.
     // This maintains the original behavior for independent source nodes.
-    if (m_executionDelay > 0 && isSourceNode(toSchedule.nodeId)) {
+    if (m_executionDelay > 0 && isSourceNode(toSchedule)) {
         locker.unlock();
-        launchTask(toSchedule);
+        launchTask(std::move(toSchedule));
         return;
     }
 
-    m_priorityQueue[toSchedule.priority].append(toSchedule);
+    m_readyQueue[toSchedule.dueMs].append(std::move(toSchedule));
+    ++run->queuedTasks;
 
     if (m_executionDelay > 0) {
         // Throttle non-source launches: enqueue globally. Only trigger throttling
         // when the queue transitions from empty -> non-empty.
         int totalQueued = 0;
-        for (auto it = m_priorityQueue.cbegin(); it != m_priorityQueue.cend(); ++it) {
+        for (auto it = m_readyQueue.cbegin(); it != m_readyQueue.cend(); ++it) {
             totalQueued += it.value().size();
         }
 
@@ -300,521 +773,1453 @@ void ExecutionEngine::scheduleNode(const ExecutionTask& task, TaskPriority p)
     }
 }
 
+int ExecutionEngine::pruneQueue(QList<std::shared_ptr<RunContext>>& dropped)
+{
+    int remaining = 0;
+    for (auto it = m_readyQueue.begin(); it != m_readyQueue.end(); ++it) {
+        auto& list = it.value();
+        for (int i = 0; i < list.size();) {
+            const auto& run = list[i].run;
+            if (run->cancelled || run->hardError) {
+                --run->queuedTasks;
+                dropped.append(run);
+                list.removeAt(i);
+                continue;
+            }
+            ++i;
+        }
+        remaining += list.size();
+    }
+    return remaining;
+}
+
 void ExecutionEngine::processNext()
 {
+    QList<std::shared_ptr<RunContext>> dropped;
     QMutexLocker locker(&m_queueMutex);
-    if (m_hardError) return;
 
-    // Check if we can launch more tasks.
-    // We limit total concurrency to the thread pool size to prevent "thundering herds".
-    int maxConcurrent = m_threadPool.maxThreadCount();
+    // Tasks of stopped, replaced or failed runs never launch
+    pruneQueue(dropped);
 
-    while (m_activeTasks < maxConcurrent) {
+    // Launch while some queued task's resource class has budget left. Each class is
+    // capped separately so e.g. network calls can't starve CPU work or vice versa.
+    while (true) {
         ExecutionTask task;
         bool found = false;
 
-        // Iterate through priority buckets in descending order (High -> Normal -> Low)
-        // QMap keys are sorted ascending, so we iterate backwards.
-        auto it = m_priorityQueue.end();
-        while (it != m_priorityQueue.begin()) {
-            --it;
+        // Earliest due first; emptied keys are erased so the scan stays short
+        for (auto it = m_readyQueue.begin(); it != m_readyQueue.end();) {
             auto& list = it.value();
-            // Per-node serialization: find the first task whose node is not currently in flight
+            if (list.isEmpty()) {
+                it = m_readyQueue.erase(it);
+                continue;
+            }
+            // Per-node concurrency: find the first task whose node has fewer executions in
+            // flight for its run than it allows and whose resource class is under budget
             for (int i = 0; i < list.size(); ++i) {
-                if (m_nodeInFlight.value(list[i].nodeUuid, 0) == 0) {
+                const bool remote = runsRemotely(list[i]);
+                const ResourceClass resourceClass = resourceClassOf(list[i]);
+                if (remote ? m_remoteActive >= m_remoteWorkers->capacity()
+                           : m_activeByClass[static_cast<int>(resourceClass)] >= m_budgets.limit(resourceClass)) {
+                    continue;
+                }
+                if (list[i].run->nodeInFlight.value(list[i].nodeUuid, 0) < concurrencyOf(list[i])) {
                     task = list.takeAt(i);
+                    task.remote = remote;
                     found = true;
                     break;
                 }
             }
             if (found) break;
+            ++it;
         }
 
         if (!found) break;
 
         // Mark node as in flight
-        m_nodeInFlight.insert(task.nodeUuid, 1);
+        ++task.run->nodeInFlight[task.nodeUuid];
+        --task.run->queuedTasks;
         
-        // Update activity timestamp when a task is picked for launch
-        m_lastActivityMs = QDateTime::currentMSecsSinceEpoch();
+        // Slow motion holds the finish back from the last launch
+        if (m_executionDelay > 0) m_lastActivityMs = QDateTime::currentMSecsSinceEpoch();
 
         locker.unlock();
-        launchTask(task);
+        launchTask(std::move(task));
         locker.relock();
 
         if (m_executionDelay > 0) break; // Only one per tick if throttled
     }
+
+    // A failed run whose last tasks were just dropped finishes here
+    locker.unlock();
+    for (const auto& run : std::as_const(dropped)) releaseWork(run);
 }
 
-void ExecutionEngine::launchTask(const ExecutionTask& task)
+void ExecutionEngine::launchTask(ExecutionTask task)
 {
-    QString outputDir;
+    const QString nodeIdStr = QString::number(task.nodeId);
+    const ResourceClass resourceClass = resourceClassOf(task);
+    int runIndex = 0;
     {
         QMutexLocker locker(&m_queueMutex);
-        if (m_hardError) return;
-        ++m_activeTasks;
+        if (task.run->hardError || task.run->cancelled) {
+            locker.unlock();
+            releaseWork(task.run);
+            return;
+        }
+        ++task.run->activeTasks;
+        if (task.remote) {
+            ++m_remoteActive;
+        } else {
+            ++m_activeByClass[static_cast<int>(resourceClass)];
+        }
 
-        const QString nodeIdStr = QString::number(task.nodeId);
-        int runIndex = m_nodeRunCounters.value(nodeIdStr, 0);
-        m_nodeRunCounters.insert(nodeIdStr, runIndex + 1);
+        runIndex = task.run->nodeRunCounters.value(nodeIdStr, 0);
+        task.run->nodeRunCounters.insert(nodeIdStr, runIndex + 1);
+    }
 
-        outputDir = getNodeOutputDir(nodeIdStr, runIndex);
-        if (!QDir().mkpath(outputDir)) {
-            emit nodeLog(QStringLiteral("FAILED to create output directory: %1").arg(outputDir));
-        }
+    // Launch concurrently (discard the QFuture as we don't need to track it).
+    // The output directory is only named here; nodes that write files create it
+    // on first use via NodeOutputDir::materialize().
+    // A remote task only waits on the network here, like any network call
+    // Only Cpu work runs below UserInitiated; every worker is moved to its pool's level
+    // on its first task, including threads that inherited a lower one from their creator
+    const ThreadQos::Level qos =
+        !task.remote && resourceClass == ResourceClass::Cpu ? task.run->qos : ThreadQos::Level::UserInitiated;
+    QThreadPool* pool = task.remote ? &m_networkPool : poolFor(resourceClass, qos);
+    auto work = [this, task = std::move(task), nodeIdStr, runIndex, qos]() mutable {
+        ThreadQos::apply(qos);
+        auto done = [this, task]() { completeTask(task); };
+        executeChain(std::move(task), getNodeOutputDir(nodeIdStr, runIndex), std::move(done));
+    };
+    // A pool thread started from a lowered worker would inherit its level, which Linux
+    // does not let it leave; the engine thread starts such work instead
+    if (ThreadQos::current() > qos) {
+        QMetaObject::invokeMethod(this, [pool, work = std::move(work)]() mutable {
+            (void)QtConcurrent::run(pool, std::move(work));
+        }, Qt::QueuedConnection);
+        return;
     }
+    (void)QtConcurrent::run(pool, std::move(work));
+}
 
-    QPointer<NodeGraphModel> graphModel(_graphModel);
-    // Launch concurrently (discard the QFuture as we don't need to track it)
-    (void)QtConcurrent::run(&m_threadPool, [this, task, graphModel, outputDir]() {
-        // Update last activity time when a task actually begins its work
-        m_lastActivityMs = QDateTime::currentMSecsSinceEpoch();
-        // Worker Guard: if runId is stale, abandon work immediately
-        if (task.runId != m_currentRunId) {
-            QMutexLocker locker(&m_queueMutex);
-            --m_activeTasks;
-            tryFinalize();
+void ExecutionEngine::executeChain(ExecutionTask task, QString outputDir, std::function<void()> done)
+{
+    // Restored on return, in case a node waits on the pool and a task runs nested here
+    FusionSlot slot;
+    FusionSlot* const outer = std::exchange(s_fusionSlot, &slot);
+    for (;;) {
+        slot.run = task.run.get();
+        slot.sourceIndex = task.nodeIndex;
+        executeTask(std::move(task), outputDir, done);
+        if (!slot.next) break;
+
+        FusedTask next = std::move(*slot.next);
+        slot.next.reset();
+        recordFusedTask();
+        task = std::move(next.task);
+        outputDir = std::move(next.outputDir);
+        done = std::move(next.done);
+    }
+    s_fusionSlot = outer;
+}
+
+ExecutionEngine::FusionSlot* ExecutionEngine::fusionSlotFor(const ExecutionTask& task) const
+{
+    // Slow motion paces every hop, and speculative work stays on the normal queues
+    FusionSlot* const slot = s_fusionSlot;
+    if (!slot || slot->next || slot->targetIndex < 0 || slot->targetIndex != task.nodeIndex
+        || slot->run != task.run.get() || task.speculative || m_executionDelay > 0) {
+        return nullptr;
+    }
+    return slot;
+}
+
+void ExecutionEngine::scheduleStealing(const std::shared_ptr<RunMailboxes>& mailboxes, ExecutionTask task)
+{
+    if (task.nodeIndex < 0 || task.nodeIndex >= mailboxes->size || task.run->hardError) {
+        releaseWork(task.run);
+        return;
+    }
+
+    NodeMailbox& box = mailboxes->boxes[task.nodeIndex];
+    mailboxes->pending.fetch_add(1, std::memory_order_acq_rel);
+    {
+        QMutexLocker locker(&box.mutex);
+        if (box.inFlight >= concurrencyOf(task)) {
+            // Per-node concurrency: park until a running task of this node completes
+            box.pending[task.priority].enqueue(std::move(task));
             return;
         }
-        if (!graphModel) {
+        ++box.inFlight;
+    }
+    if (FusionSlot* slot = fusionSlotFor(task)) {
+        bool remote = false;
+        {
             QMutexLocker locker(&m_queueMutex);
-            --m_activeTasks;
-            tryFinalize();
+            remote = runsRemotely(task);
+        }
+        if (!remote) {
+            // Taken over by the worker running the chain, like a dispatched work item
+            const std::shared_ptr<RunContext> run = task.run;
+            ++run->activeTasks;
+            mailboxes->pending.fetch_sub(1, std::memory_order_acq_rel);
+            int runIndex = 0;
+            {
+                QMutexLocker locker(&box.mutex);
+                runIndex = box.runCounter++;
+            }
+            QString outputDir = getNodeOutputDir(QString::number(task.nodeId), runIndex);
+            auto done = mailboxDone(mailboxes, run, task.nodeIndex);
+            slot->next = FusedTask{std::move(task), std::move(outputDir), std::move(done)};
             return;
         }
+    }
+    dispatchStealing(mailboxes, std::move(task));
+}
 
-        auto* delegate = graphModel->delegateModel<ToolNodeDelegate>(task.nodeId);
-        if (!delegate) {
-            handleTaskCompleted(task.nodeId, task.nodeUuid, TokenList{}, task.runId);
-            QMutexLocker locker(&m_queueMutex);
-            --m_activeTasks;
-            tryFinalize();
+std::function<void()> ExecutionEngine::mailboxDone(const std::shared_ptr<RunMailboxes>& mailboxes,
+                                                   const std::shared_ptr<RunContext>& run, int nodeIndex)
+{
+    return [this, mailboxes, run, nodeIndex]() {
+        releaseMailbox(mailboxes, nodeIndex);
+        --run->activeTasks;
+        releaseWork(run);
+    };
+}
+
+void ExecutionEngine::dispatchStealing(const std::shared_ptr<RunMailboxes>& mailboxes, ExecutionTask task)
+{
+    {
+        QMutexLocker locker(&m_queueMutex);
+        task.remote = runsRemotely(task);
+    }
+    // Read before the task moves into the work item
+    const bool remote = task.remote;
+    const int priority = task.priority;
+    const ResourceClass resourceClass = resourceClassOf(task);
+    auto work = [this, mailboxes, task = std::move(task)]() mutable {
+        const std::shared_ptr<RunContext> run = task.run;
+        // Count the task as active before it stops being pending so that
+        // finalization never observes both counters at zero mid-handoff.
+        ++run->activeTasks;
+        mailboxes->pending.fetch_sub(1, std::memory_order_acq_rel);
+
+        const auto done = mailboxDone(mailboxes, run, task.nodeIndex);
+
+        if (run->cancelled || run->hardError) {
+            done();
             return;
         }
 
-        const auto node = delegate->node();
-        if (!node) {
-            handleTaskCompleted(task.nodeId, task.nodeUuid, TokenList{}, task.runId);
-            QMutexLocker locker(&m_queueMutex);
-            --m_activeTasks;
-            tryFinalize();
+        NodeMailbox& box = mailboxes->boxes[task.nodeIndex];
+        int runIndex = 0;
+        {
+            QMutexLocker locker(&box.mutex);
+            runIndex = box.runCounter++;
+        }
+        QString outputDir = getNodeOutputDir(QString::number(task.nodeId), runIndex);
+        executeChain(std::move(task), std::move(outputDir), done);
+    };
+
+    // Only CPU work is balanced across the stealing deques; other classes queue on
+    // their own pool, whose size is the class budget
+    if (remote) {
+        m_networkPool.start(std::move(work), priority);
+    } else if (resourceClass == ResourceClass::Cpu) {
+        m_scheduler->post(priority, std::move(work));
+    } else {
+        poolFor(resourceClass)->start(std::move(work), priority);
+    }
+}
+
+void ExecutionEngine::releaseMailbox(const std::shared_ptr<RunMailboxes>& mailboxes, int nodeIndex)
+{
+    NodeMailbox& box = mailboxes->boxes[nodeIndex];
+    ExecutionTask next;
+    {
+        QMutexLocker locker(&box.mutex);
+        // Highest priority bucket first, FIFO within a bucket
+        auto it = box.pending.end();
+        while (it != box.pending.begin()) {
+            --it;
+            if (it.value().isEmpty()) continue;
+            next = it.value().dequeue();
+            break;
+        }
+        // A parked task takes over the slot; otherwise it frees up
+        if (next.nodeIndex < 0) {
+            --box.inFlight;
             return;
         }
+    }
+    if (next.run->hardError || next.run->cancelled) {
+        // Drop the rest of this node's backlog; the run is over or failed
+        QMutexLocker locker(&box.mutex);
+        int dropped = 1;
+        for (auto it = box.pending.begin(); it != box.pending.end(); ++it) {
+            dropped += it.value().size();
+        }
+        box.pending.clear();
+        --box.inFlight;
+        mailboxes->pending.fetch_sub(dropped, std::memory_order_acq_rel);
+        locker.unlock();
+        releaseWork(next.run, dropped);
+        return;
+    }
+    dispatchStealing(mailboxes, std::move(next));
+}
 
-        const NodeDescriptor descriptor = node->getDescriptor();
-        const QString nodeName = descriptor.name;
+void ExecutionEngine::completeTask(const ExecutionTask& task)
+{
+    QMutexLocker locker(&m_queueMutex);
+    --task.run->activeTasks;
+    if (task.remote) {
+        --m_remoteActive;
+    } else {
+        --m_activeByClass[static_cast<int>(resourceClassOf(task))];
+    }
+    if (int& inFlight = task.run->nodeInFlight[task.nodeUuid]; inFlight > 0) --inFlight;
 
-        // Mark node and incoming connections Running
-        emit nodeStatusChanged(task.nodeUuid, static_cast<int>(ExecutionState::Running));
-        const auto attached = graphModel->allConnectionIds(task.nodeId);
-        for (const auto& cid : attached) {
-            if (cid.inNodeId == task.nodeId) {
-                emit connectionStatusChanged(connectionUuidForId(_graphModel, cid), static_cast<int>(ExecutionState::Running));
-            }
-        }
+    locker.unlock();
 
-        // Attempt to retrieve user-defined description/caption for better identification
-        QString userCaption;
-        if (delegate) {
-            userCaption = delegate->description();
-            if (userCaption.trimmed().isEmpty()) {
-                userCaption = delegate->caption();
-            }
-        }
+    if (m_executionDelay == 0) {
+        processNext();
+    }
+    releaseWork(task.run);
+}
 
-        emit nodeLog(QString::fromLatin1("Node Started: id=%1, type=%2, caption=\"%3\"")
-                         .arg(QString::number(task.nodeId))
-                         .arg(nodeName)
-                         .arg(userCaption));
-        // Backward-compatibility for existing tests/tools expecting this legacy prefix
-        emit nodeLog(QString::fromLatin1("Executing Node: %1 %2")
-                         .arg(QString::number(task.nodeId))
-                         .arg(nodeName));
-
-        // For long-running nodes like RagIndexerNode, forward progress updates
-        RagIndexerNode* ragIndexer = dynamic_cast<RagIndexerNode*>(node.get());
-        QMetaObject::Connection progressConn;
-        if (ragIndexer) {
-            progressConn = QObject::connect(ragIndexer, &RagIndexerNode::progressUpdated,
-                                            this, [this, nid = task.nodeId, uuid = task.nodeUuid, runId = task.runId](const DataPacket& progressPacket) {
-                if (runId != m_currentRunId) return; // Run ID guard for progress
-                QVariantMap variantMap;
-                for (auto it = progressPacket.cbegin(); it != progressPacket.cend(); ++it) {
-                    variantMap.insert(it.key(), it.value());
-                }
-                {
-                    if (runId != m_currentRunId) return;
-                    QWriteLocker locker(&m_dataLock);
-                    m_dataLake[uuid] = variantMap;
-                }
-                // Deliver snapshot synchronously to receivers in the UI/main thread
-                if (runId != m_currentRunId) return;
-                QMetaObject::invokeMethod(this, "nodeOutputChanged",
-                                          Qt::BlockingQueuedConnection,
-                                          Q_ARG(QtNodes::NodeId, nid));
-            });
-        }
+std::shared_ptr<QSemaphore> ExecutionEngine::nodeGate(const IToolNode* node)
+{
+    QMutexLocker locker(&m_queueMutex);
+    auto& gate = m_nodeGates[node];
+    if (!gate) gate = std::make_shared<QSemaphore>(1);
+    return gate;
+}
 
-        TokenList outputTokens;
-        try {
-            // Set thread-local context for node-level logging
-            g_CurrentNodeId = task.nodeId;
-            g_CurrentNodeUuid = task.nodeUuid;
+void ExecutionEngine::executeTask(ExecutionTask task, const QString& outputDir,
+                                  const std::function<void()>& done)
+{
+    // The span starts on the worker that runs the task; finishTask() records it
+    ExecutionTrace* const trace = task.run->trace.get();
+    if (trace) {
+        task.startedAtUs = trace->nowUs();
+        task.threadTag = ExecutionTrace::currentThreadTag();
+        if (m_traceResidentMemory) task.rssBeforeBytes = ExecutionTrace::residentMemoryBytes();
+    }
+    if (task.run->recording) task.recordedStartUs = task.run->recording->nowUs();
+    if (const auto& usage = task.run->usage; usage && task.usageQueuedAtUs >= 0 && !task.speculative) {
+        usage->recordQueueWait(task.nodeUuid, usage->nowUs() - task.usageQueuedAtUs);
+    }
 
-            // Inject system tokens (e.g., persistent node-specific output directory)
-            TokenList effectiveInputs = task.inputs;
-            if (!outputDir.isEmpty()) {
-                ExecutionToken sysToken;
-                sysToken.data.insert(QStringLiteral("_sys_node_output_dir"), outputDir);
-                effectiveInputs.push_back(std::move(sysToken));
-            }
+    if (m_executionDelay > 0) m_lastActivityMs = QDateTime::currentMSecsSinceEpoch();
+    // Worker Guard: if the run was stopped or replaced, abandon work immediately
+    if (task.run->cancelled || !task.plan || task.nodeIndex < 0) {
+        done();
+        return;
+    }
+    // A discarded speculation never starts
+    if (task.speculative && task.speculation->cancellation.isCancelled()) {
+        retireTask(task);
+        done();
+        return;
+    }
 
-            outputTokens = node->execute(effectiveInputs);
+    const ExecutionPlan::Node& planNode = task.plan->node(task.nodeIndex);
+    const auto node = planNode.node;
+    if (!node) {
+        handleTaskCompleted(task.run, task.nodeId, task.nodeUuid, TokenList{});
+        retireTask(task);
+        done();
+        return;
+    }
 
-            // Propagate forceExecution flag from any input token to all output tokens
-            bool forceExecution = false;
-            for (const auto& inTok : task.inputs) {
-                if (inTok.forceExecution) {
-                    forceExecution = true;
-                    break;
-                }
+    // Independent runs feed their inputs in place of selected nodes' outputs
+    const auto presetIt = task.run->presetOutputs.constFind(task.nodeUuid);
+    if (presetIt != task.run->presetOutputs.cend()) {
+        ExecutionToken preset;
+        preset.data = presetIt.value();
+        finishTask(task, TokenList{preset}, QString(), false);
+        done();
+        return;
+    }
+
+    // Only the foreground run reports per-node status and trace lines, and only for
+    // work it keeps: a speculative task stays silent until a real task adopts it
+    const bool foreground = task.run->foreground && !task.speculative;
+    const QString& nodeName = planNode.name;
+    const QString& userCaption = planNode.caption;
+
+    // Shared with the completion, which may end it on another thread
+    const auto nodeSpan = std::make_shared<Tracer::Span>(Tracer::instance().startSpan(
+        userCaption.isEmpty() ? nodeName : userCaption, Tracer::Kind::Internal, task.run->span.context()));
+    if (nodeSpan->isRecording()) {
+        nodeSpan->setAttribute(QStringLiteral("cp.node.id"), static_cast<qint64>(task.nodeId));
+        nodeSpan->setAttribute(QStringLiteral("cp.node.type"), nodeName);
+        nodeSpan->setAttribute(QStringLiteral("cp.run.id"), task.runId.toString(QUuid::WithoutBraces));
+        if (task.speculative) nodeSpan->setAttribute(QStringLiteral("cp.node.speculative"), true);
+    }
+    const QVector<QUuid>& attached = planNode.incomingConnectionUuids;
+
+    // Mark node and incoming connections Running
+    if (foreground) {
+        emit nodeStatusChanged(task.nodeUuid, static_cast<int>(ExecutionState::Running));
+        for (const auto& connUuid : attached) {
+            emit connectionStatusChanged(connUuid, static_cast<int>(ExecutionState::Running));
+        }
+    }
+
+    if (foreground && logEnabled(LogVerbosity::Tasks)) {
+        postLog(QString::fromLatin1("Node Started: id=%1, type=%2, caption=\"%3\"")
+                    .arg(QString::number(task.nodeId), nodeName, userCaption));
+        // Backward-compatibility for existing tests/tools expecting this legacy prefix
+        postLog(QString::fromLatin1("Executing Node: %1 %2")
+                    .arg(QString::number(task.nodeId), nodeName));
+    }
+
+    // Inject system tokens (e.g., persistent node-specific output directory)
+    TokenList effectiveInputs = task.inputs;
+    if (!outputDir.isEmpty()) {
+        ExecutionToken sysToken;
+        sysToken.data.insert(QStringLiteral("_sys_node_output_dir"), outputDir);
+        effectiveInputs.push_back(std::move(sysToken));
+    }
+
+    bool forceExecution = false;
+    for (const auto& inTok : task.inputs) {
+        if (inTok.forceExecution) {
+            forceExecution = true;
+            break;
+        }
+    }
+
+    // Speculation: a branch that already ran on these inputs while its router decided
+    // is committed instead of executed. One still queued or failed is cancelled and the
+    // node runs now; one still running finished first, as the node is serialized.
+    if (task.speculation && !task.speculative) {
+        const auto speculation = task.speculation;
+        {
+            QMutexLocker sl(&task.run->speculationMutex);
+            task.run->speculations.removeOne(speculation);
+        }
+        TokenList committed;
+        bool succeeded = false;
+        {
+            QMutexLocker sl(&speculation->mutex);
+            succeeded = speculation->finished && speculation->failure.isEmpty();
+            if (succeeded) committed = speculation->outputs;
+        }
+        if (succeeded) {
+            if (foreground && logEnabled(LogVerbosity::Tasks)) {
+                postLog(QString::fromLatin1("Node Speculated: id=%1, type=%2")
+                            .arg(QString::number(task.nodeId), planNode.name));
             }
-            if (forceExecution) {
-                for (auto& outTok : outputTokens) {
-                    outTok.forceExecution = true;
-                }
+            recordSpeculation(QStringLiteral("committed"));
+            nodeSpan->setAttribute(QStringLiteral("cp.node.speculated"), true);
+            finishTask(task, std::move(committed), QString(), false);
+            done();
+            return;
+        }
+        speculation->cancellation.cancel();
+        recordSpeculation(QStringLiteral("discarded"));
+    }
+
+    // Replay: the recorded execution stands in for the node
+    if (task.run->replay) {
+        nodeSpan->setAttribute(QStringLiteral("cp.node.replayed"), true);
+        nodeSpan->end();
+        replayTask(task, node, forceExecution, done);
+        return;
+    }
+
+    // Resume: work the interrupted run finished is not done again
+    if (task.run->resume) {
+        if (auto saved = task.run->resume->take(task.nodeUuid, task.inputs, false)) {
+            nodeSpan->setAttribute(QStringLiteral("cp.node.resumed"), true);
+            nodeSpan->end();
+            recordNodeExecution(planNode.typeId, QStringLiteral("resumed"));
+            finishTask(task, std::move(saved->outputs), QString(), forceExecution);
+            done();
+            return;
+        }
+    }
+
+    // Result cache: replay a stored result for cacheable nodes unless forced. Forcing a
+    // deterministic node (e.g. a retry passing back through it) can't change its result,
+    // so it still replays; the forced flag carries on to its outputs either way.
+    const auto resultCache = task.run->resultCache;
+    const bool deterministic = node->isDeterministic();
+    QString cacheKey;
+    if (resultCache && (node->isCacheable() || deterministic)) {
+        cacheKey = ResultCache::makeKey(planNode.typeId, node->saveState(), task.inputs);
+    }
+    if (!cacheKey.isEmpty() && (!forceExecution || deterministic)) {
+        if (auto cached = resultCache->lookup(cacheKey)) {
+            if (foreground && logEnabled(LogVerbosity::Tasks)) {
+                postLog(QString::fromLatin1("Node Cached: id=%1, type=%2")
+                            .arg(QString::number(task.nodeId), planNode.name));
             }
-        } catch (const std::exception& ex) {
-            if (task.runId != m_currentRunId) {
-                if (ragIndexer) QObject::disconnect(progressConn);
-                QMutexLocker locker(&m_queueMutex);
-                --m_activeTasks;
-                tryFinalize();
+            recordNodeExecution(planNode.typeId, QStringLiteral("cached"));
+            nodeSpan->setAttribute(QStringLiteral("cp.node.cached"), true);
+            if (const auto& usage = task.run->usage) {
+                usage->recordExecution(task.nodeUuid, QString::number(task.nodeId),
+                                       planNode.caption.isEmpty() ? planNode.name : planNode.caption, *cached, 0,
+                                       false, true);
+            }
+            finishTask(task, std::move(*cached), QString(), forceExecution);
+            done();
+            return;
+        }
+    }
+
+    // For long-running nodes like RagIndexerNode, forward progress updates
+    RagIndexerNode* ragIndexer = dynamic_cast<RagIndexerNode*>(node.get());
+    QMetaObject::Connection progressConn;
+    if (ragIndexer) {
+        progressConn = QObject::connect(ragIndexer, &RagIndexerNode::progressUpdated,
+                                        this, [this, nid = task.nodeId, index = task.nodeIndex, uuid = task.nodeUuid, run = task.run](const DataPacket& progressPacket) {
+            if (run->cancelled) return; // Run guard for progress
+            QVariantMap variantMap;
+            for (auto it = progressPacket.cbegin(); it != progressPacket.cend(); ++it) {
+                variantMap.insert(it.key(), it.value());
+            }
+            run->lake->replace(uuid, variantMap);
+            notifyNodeOutputChanged(run, nid, index);
+        });
+    }
+
+    // Nodes that can't serve several runs at once execute for one run at a time
+    // A remote task runs on its own instance on the worker
+    std::shared_ptr<QSemaphore> gate;
+    if (!task.remote && !node->supportsConcurrentRuns() && !node->isReentrant()) {
+        gate = nodeGate(node.get());
+        gate->acquire();
+    }
+
+    // Tokens the node publishes before it returns fan out right away. The gate closes
+    // before the task completes, so a late publish can't schedule work behind the
+    // lake's back once the branch is retired.
+    struct PartialGate {
+        QMutex mutex;
+        bool open{true};
+    };
+    const auto partialGate = std::make_shared<PartialGate>();
+    const auto lifetime = m_lifetime;
+    // Speculative tasks hold theirs back until they are committed.
+    const PartialOutputSink partialSink([this, lifetime, partialGate, run = task.run, nodeId = task.nodeId,
+                                         nodeUuid = task.nodeUuid,
+                                         speculative = task.speculative](const TokenList& tokens) {
+        if (speculative) return;
+        QReadLocker guard(&lifetime->lock);
+        if (!lifetime->alive) return;
+        QMutexLocker gateLock(&partialGate->mutex);
+        if (!partialGate->open) return;
+        handleTaskCompleted(run, nodeId, nodeUuid, tokens);
+        if (!run->foreground) {
+            for (const auto& token : tokens) emit runPartialOutput(run->id, nodeUuid, token.data);
+        }
+    }, [run = task.run, sourceIndex = task.nodeIndex, speculative = task.speculative]() {
+        // Wait until none of this node's published tokens are parked. Gives up when
+        // nothing else of the run executes, since then no target can drain (its class
+        // budget may be exhausted by the producer itself).
+        if (speculative || sourceIndex < 0 || run->inputQueueCapacity <= 0) return;
+        const auto parked = [&run, sourceIndex]() {
+            for (const auto& expansion : std::as_const(run->parkedExpansions)) {
+                if (expansion->sourceIndex == sourceIndex) return true;
+            }
+            return false;
+        };
+        QMutexLocker el(&run->expansionMutex);
+        while (parked() && !run->cancelled) {
+            if (!run->expansionResumed.wait(&run->expansionMutex, kCapacityPollMs) &&
+                run->activeTasks.load() <= 1) {
                 return;
             }
-            emit nodeLog(QString::fromLatin1("ExecutionEngine: Exception in node %1 %2: %3")
-                             .arg(QString::number(task.nodeId)).arg(nodeName).arg(ex.what()));
-            emit nodeStatusChanged(task.nodeUuid, static_cast<int>(ExecutionState::Error));
-            for (const auto& cid : attached) {
-                if (cid.inNodeId == task.nodeId) {
-                    emit connectionStatusChanged(connectionUuidForId(_graphModel, cid), static_cast<int>(ExecutionState::Error));
+        }
+    });
+
+    QElapsedTimer executionTimer;
+    executionTimer.start();
+    auto afterExecute = [this, task, resultCache, cacheKey, forceExecution, progressConn, gate, partialGate,
+                         done, executionTimer, nodeSpan, typeId = planNode.typeId,
+                         nodeCaption = planNode.caption.isEmpty() ? planNode.name : planNode.caption](
+                            TokenList outputTokens, const QString& failure) {
+        recordNodeExecution(typeId, failure.isEmpty() ? QStringLiteral("ok") : QStringLiteral("error"),
+                            executionTimer.nsecsElapsed() / 1e9);
+        if (const auto& usage = task.run->usage) {
+            usage->recordExecution(task.nodeUuid, QString::number(task.nodeId), nodeCaption, outputTokens,
+                                   executionTimer.nsecsElapsed() / 1000, !failure.isEmpty());
+        }
+        if (!failure.isEmpty()) {
+            nodeSpan->setError(failure);
+        } else if (nodeSpan->isRecording()) {
+            for (const auto& token : outputTokens) {
+                const auto error = token.data.constFind(QStringLiteral("__error"));
+                if (error != token.data.cend()) {
+                    nodeSpan->setError(error.value().toString());
+                    break;
                 }
             }
-            // Clear thread-local context
-            g_CurrentNodeId = QtNodes::InvalidNodeId;
-            g_CurrentNodeUuid = QUuid();
-            if (ragIndexer) QObject::disconnect(progressConn);
-            handleTaskCompleted(task.nodeId, task.nodeUuid, TokenList{}, task.runId);
-            QMutexLocker locker(&m_queueMutex);
-            --m_activeTasks;
-            tryFinalize();
-            return;
+        }
+        nodeSpan->end();
+        {
+            QMutexLocker gateLock(&partialGate->mutex);
+            partialGate->open = false;
+        }
+        if (gate) gate->release();
+        if (progressConn) QObject::disconnect(progressConn);
+        // A transient failure with attempts left is tried again later; nothing of it goes on
+        const RetryPolicy& retry = task.plan->node(task.nodeIndex).retry;
+        if (failure.isEmpty() && !task.speculative && task.attempt < retry.maxAttempts) {
+            const int retryAfterMs = transientRetryAfterMs(outputTokens);
+            if (retryAfterMs >= 0 && !task.run->cancelled) {
+                deferRetry(task, retry.delayMs(task.attempt, retryAfterMs));
+                done();
+                return;
+            }
+        }
+        if (failure.isEmpty() && !cacheKey.isEmpty()) {
+            resultCache->store(cacheKey, outputTokens);
+        }
+        finishTask(task, std::move(outputTokens), failure, forceExecution);
+        done();
+    };
+
+    const QString nodeLabel = QString::number(task.nodeId) + QLatin1Char(' ') + planNode.name;
+    std::shared_ptr<RemoteWorkerPool> remoteWorkers;
+    if (task.remote) {
+        QMutexLocker locker(&m_queueMutex);
+        remoteWorkers = m_remoteWorkers;
+    }
+    if (remoteWorkers) nodeSpan->setAttribute(QStringLiteral("cp.node.remote"), true);
+    const bool async = remoteWorkers || node->supportsAsyncExecution();
+    const CancellationToken& cancellation =
+        task.speculative ? task.speculation->cancellation : task.run->cancellation;
+    QFuture<TokenList> pending;
+    TokenList outputTokens;
+    QString failure;
+    try {
+        // Set thread-local context for node-level logging
+        g_CurrentNodeId = task.nodeId;
+        g_CurrentNodeUuid = task.nodeUuid;
+        ExecutionTrace::setCurrent(trace);
+        RunUsageCollector::setCurrent(task.run->usage.get());
+        const Tracer::Scope tracingScope(*nodeSpan);
+        const CancellationToken::Scope cancellationScope(cancellation);
+        const PartialOutputSink::Scope partialScope(partialSink);
+        const CpuWorkerPool::Scope cpuPoolScope(poolFor(ResourceClass::Cpu, task.run->qos));
+        const ResultCache::Scope itemCacheScope(task.run->itemCache.get());
+        const RetryPolicy::Scope retryScope(!task.speculative && task.attempt < planNode.retry.maxAttempts);
+
+        if (remoteWorkers) {
+            pending = remoteWorkers->execute(planNode.typeId, node->saveState(), effectiveInputs,
+                                             cancellation, partialSink);
+        } else if (async) {
+            pending = node->executeAsync(effectiveInputs);
+        } else {
+            outputTokens = node->execute(effectiveInputs);
+        }
+    } catch (const std::exception& ex) {
+        failure = QString::fromLatin1("ExecutionEngine: Exception in node %1: %2").arg(nodeLabel, QString::fromUtf8(ex.what()));
+    } catch (...) {
+        failure = QString::fromLatin1("ExecutionEngine: Unknown exception in node %1").arg(nodeLabel);
+    }
+
+    // Clear thread-local context
+    g_CurrentNodeId = QtNodes::InvalidNodeId;
+    g_CurrentNodeUuid = QUuid();
+    ExecutionTrace::setCurrent(nullptr);
+    RunUsageCollector::setCurrent(nullptr);
+
+    if (!async || !failure.isEmpty()) {
+        afterExecute(std::move(outputTokens), failure);
+        return;
+    }
+
+    // Asynchronous node: this worker is released now. The task completes on whichever
+    // thread finishes the future; the lifetime guard keeps a destroyed engine out of it.
+    pending.then(QtFuture::Launch::Sync, [lifetime, afterExecute, nodeLabel](QFuture<TokenList> finished) {
+        QReadLocker guard(&lifetime->lock);
+        if (!lifetime->alive) return;
+        TokenList tokens;
+        QString error;
+        try {
+            const QList<TokenList> results = finished.results();
+            if (!results.isEmpty()) tokens = results.first();
+        } catch (const std::exception& ex) {
+            error = QString::fromLatin1("ExecutionEngine: Exception in node %1: %2").arg(nodeLabel, QString::fromUtf8(ex.what()));
         } catch (...) {
-            if (task.runId != m_currentRunId) {
-                if (ragIndexer) QObject::disconnect(progressConn);
-                QMutexLocker locker(&m_queueMutex);
-                --m_activeTasks;
-                tryFinalize();
+            error = QString::fromLatin1("ExecutionEngine: Unknown exception in node %1").arg(nodeLabel);
+        }
+        afterExecute(std::move(tokens), error);
+    }).onCanceled([lifetime, afterExecute, nodeLabel]() {
+        QReadLocker guard(&lifetime->lock);
+        if (!lifetime->alive) return;
+        afterExecute(TokenList{}, QString::fromLatin1("ExecutionEngine: Node %1 was canceled").arg(nodeLabel));
+    });
+}
+
+void ExecutionEngine::finishTask(const ExecutionTask& task, TokenList outputTokens, const QString& failure,
+                                 bool forceExecution)
+{
+    if (task.run->cancelled) {
+        return;
+    }
+
+    // Speculative outputs wait for the router's decision; nothing fans out
+    if (task.speculative) {
+        {
+            QMutexLocker sl(&task.speculation->mutex);
+            task.speculation->outputs = std::move(outputTokens);
+            task.speculation->failure = failure;
+            task.speculation->finished = true;
+        }
+        retireTask(task);
+        return;
+    }
+
+    const qint64 inputBytes = ExecutionTrace::approximateSize(task.inputs);
+    const qint64 outputBytes = ExecutionTrace::approximateSize(outputTokens);
+    recordPayloadSizes(task.plan->node(task.nodeIndex).typeId, inputBytes, outputBytes);
+    if (const auto& usage = task.run->usage) {
+        usage->recordPayload(task.nodeUuid, inputBytes, outputBytes);
+    }
+
+    if (const auto& trace = task.run->trace) {
+        const ExecutionPlan::Node& planNode = task.plan->node(task.nodeIndex);
+        const QString& nodeName = planNode.name;
+        ExecutionTrace::Span span;
+        span.name = planNode.caption.isEmpty() ? nodeName : planNode.caption;
+        span.category = QStringLiteral("node");
+        span.nodeId = QString::number(task.nodeId);
+        span.nodeType = nodeName;
+        span.queuedUs = task.queuedAtUs;
+        span.startUs = task.startedAtUs >= 0 ? task.startedAtUs : trace->nowUs();
+        span.endUs = trace->nowUs();
+        span.threadId = task.threadTag ? task.threadTag : ExecutionTrace::currentThreadTag();
+        span.inputBytes = inputBytes;
+        span.outputBytes = outputBytes;
+        if (task.rssBeforeBytes >= 0) {
+            span.rssBeforeBytes = task.rssBeforeBytes;
+            span.rssAfterBytes = ExecutionTrace::residentMemoryBytes();
+        }
+        span.failed = !failure.isEmpty();
+        trace->record(std::move(span));
+    }
+
+    if (const auto& recording = task.run->recording) {
+        RunRecording::Execution execution;
+        execution.nodeUuid = task.nodeUuid;
+        execution.nodeType = task.plan->node(task.nodeIndex).typeId;
+        execution.inputs = task.inputs;
+        execution.outputs = outputTokens;
+        execution.failure = failure;
+        const qint64 now = recording->nowUs();
+        execution.startUs = task.recordedStartUs >= 0 ? task.recordedStartUs : now;
+        execution.durationUs = now - execution.startUs;
+        recording->record(std::move(execution));
+    }
+
+    if (const auto& checkpoint = task.run->checkpoint) {
+        RunRecording::Execution execution;
+        execution.nodeUuid = task.nodeUuid;
+        execution.nodeType = task.plan->node(task.nodeIndex).typeId;
+        execution.inputs = task.inputs;
+        execution.outputs = outputTokens;
+        execution.failure = failure;
+        checkpoint->record(std::move(execution));
+        saveCheckpoint(task.run);
+    }
+
+    if (task.sequence < 0) {
+        commitTask(task, std::move(outputTokens), failure, forceExecution);
+        return;
+    }
+
+    // Several executions of an ordered node are in flight: buffer this one, then
+    // commit every completion that is next in line unless another thread already is.
+    // The buffer is looked up under the lock each time; other nodes' may rehash the table.
+    {
+        QMutexLocker orderLock(&task.run->orderMutex);
+        OutputOrder& order = task.run->outputOrders[task.nodeIndex];
+        order.finished.insert(task.sequence, CompletedTask{task, std::move(outputTokens), failure, forceExecution});
+        if (order.draining) return;
+        order.draining = true;
+    }
+    for (;;) {
+        CompletedTask next;
+        {
+            QMutexLocker orderLock(&task.run->orderMutex);
+            OutputOrder& order = task.run->outputOrders[task.nodeIndex];
+            const auto it = order.finished.find(order.released);
+            if (it == order.finished.end()) {
+                order.draining = false;
                 return;
             }
-            emit nodeLog(QString::fromLatin1("ExecutionEngine: Unknown exception in node %1 %2")
-                             .arg(QString::number(task.nodeId)).arg(nodeName));
+            next = std::move(it.value());
+            order.finished.erase(it);
+            ++order.released;
+        }
+        commitTask(next.task, std::move(next.outputs), next.failure, next.forceExecution);
+    }
+}
+
+void ExecutionEngine::commitTask(const ExecutionTask& task, TokenList outputTokens, const QString& failure,
+                                 bool forceExecution)
+{
+    if (task.run->cancelled) {
+        return;
+    }
+
+    const bool foreground = task.run->foreground;
+    const ExecutionPlan::Node& planNode = task.plan->node(task.nodeIndex);
+    const QString& nodeName = planNode.name;
+    const QVector<QUuid>& attached = planNode.incomingConnectionUuids;
+
+    if (!failure.isEmpty()) {
+        postLog(foreground ? failure
+                           : QStringLiteral("[run %1] %2").arg(task.runId.toString(QUuid::WithoutBraces), failure));
+        if (foreground) {
             emit nodeStatusChanged(task.nodeUuid, static_cast<int>(ExecutionState::Error));
-            for (const auto& cid : attached) {
-                if (cid.inNodeId == task.nodeId) {
-                    emit connectionStatusChanged(connectionUuidForId(_graphModel, cid), static_cast<int>(ExecutionState::Error));
-                }
+            for (const auto& connUuid : attached) {
+                emit connectionStatusChanged(connUuid, static_cast<int>(ExecutionState::Error));
             }
-            // Clear thread-local context
-            g_CurrentNodeId = QtNodes::InvalidNodeId;
-            g_CurrentNodeUuid = QUuid();
-            if (ragIndexer) QObject::disconnect(progressConn);
-            handleTaskCompleted(task.nodeId, task.nodeUuid, TokenList{}, task.runId);
-            QMutexLocker locker(&m_queueMutex);
-            --m_activeTasks;
-            tryFinalize();
-            return;
         }
+        handleTaskCompleted(task.run, task.nodeId, task.nodeUuid, TokenList{});
+        discardSpeculations(*task.run, task.nodeIndex);
+        retireTask(task);
+        return;
+    }
 
-        if (ragIndexer) QObject::disconnect(progressConn);
-
-        if (task.runId != m_currentRunId) {
-            QMutexLocker locker(&m_queueMutex);
-            --m_activeTasks;
-            tryFinalize();
-            return;
+    // Propagate forceExecution flag from any input token to all output tokens
+    if (forceExecution) {
+        for (auto& outTok : outputTokens) {
+            outTok.forceExecution = true;
         }
+    }
 
-        // Log completion and dump output DataPacket key/value pairs
-        emit nodeLog(QString::fromLatin1("Node Finished: id=%1, type=%2")
-                         .arg(QString::number(task.nodeId)).arg(nodeName));
+    // Log completion and dump output DataPacket key/value pairs
+    if (foreground && logEnabled(LogVerbosity::Tasks)) {
+        postLog(QString::fromLatin1("Node Finished: id=%1, type=%2")
+                    .arg(QString::number(task.nodeId), nodeName));
+    }
+    if (foreground && logEnabled(LogVerbosity::Full)) {
         // Dump each key/value from produced tokens in a normalized, single-line format
         int tokenIndex = 0;
         for (const auto& tok : outputTokens) {
             for (auto it = tok.data.cbegin(); it != tok.data.cend(); ++it) {
-                const QString key = it.key();
-                const QString val = ExecutionEngine::truncateAndEscape(it.value());
-                emit nodeLog(QString::fromLatin1("  Output[%1] %2 = \"%3\"")
-                                 .arg(QString::number(tokenIndex))
-                                 .arg(key)
-                                 .arg(val));
+                postLog(QString::fromLatin1("  Output[%1] %2 = \"%3\"")
+                            .arg(QString::number(tokenIndex), it.key(),
+                                 ExecutionEngine::truncateAndEscape(it.value())));
             }
             ++tokenIndex;
         }
+    }
+
+    // Mark finished and propagate. A chain node's successor goes to this worker; the
+    // slot stays closed for a task finishing on a worker that runs something else.
+    FusionSlot* const slot = s_fusionSlot;
+    const bool handsOver = planNode.fusedSuccessor >= 0 && slot && slot->run == task.run.get()
+        && slot->sourceIndex == task.nodeIndex;
+    if (handsOver) slot->targetIndex = planNode.fusedSuccessor;
+    handleTaskCompleted(task.run, task.nodeId, task.nodeUuid, outputTokens);
+    if (handsOver) slot->targetIndex = -1;
+    // The branches this node chose were adopted above; the others are wasted work
+    discardSpeculations(*task.run, task.nodeIndex);
+    // Successors are scheduled by now, so the lake never sees this branch as done early
+    retireTask(task);
+
+    if (foreground) {
+        emit nodeStatusChanged(task.nodeUuid, static_cast<int>(ExecutionState::Finished));
+        for (const auto& connUuid : attached) {
+            emit connectionStatusChanged(connUuid, static_cast<int>(ExecutionState::Finished));
+        }
+    }
+}
+
+QVector<bool> ExecutionEngine::computeDirtyCone(const ExecutionPlan& plan, const RunSnapshot& previous,
+                                               const RunSnapshot& current, const QSet<QUuid>& forced)
+{
+    if (!previous.valid) return {};
+
+    const int count = plan.nodes().size();
+    QVector<bool> inCone(count, false);
+    QQueue<int> frontier;
+    for (int index = 0; index < count; ++index) {
+        const QUuid& uuid = plan.node(index).uuid;
+        const bool dirty = forced.contains(uuid)
+            || !previous.configSignatures.contains(uuid)
+            || previous.configSignatures.value(uuid) != current.configSignatures.value(uuid)
+            || previous.incoming.value(uuid) != current.incoming.value(uuid);
+        if (dirty) {
+            inCone[index] = true;
+            frontier.enqueue(index);
+        }
+    }
 
-        // Mark finished and propagate
-        handleTaskCompleted(task.nodeId, task.nodeUuid, outputTokens, task.runId);
+    // Everything downstream of a dirty node sees different inputs
+    while (!frontier.isEmpty()) {
+        const int index = frontier.dequeue();
+        for (int edgeIndex : plan.node(index).outEdges) {
+            const int target = plan.edge(edgeIndex).targetIndex;
+            if (inCone[target]) continue;
+            inCone[target] = true;
+            frontier.enqueue(target);
+        }
+    }
+    return inCone;
+}
 
-        // Clear thread-local context after successful execution
-        g_CurrentNodeId = QtNodes::InvalidNodeId;
-        g_CurrentNodeUuid = QUuid();
+void ExecutionEngine::seedDirtyCone(const std::shared_ptr<RunContext>& run, const QVector<bool>& inCone,
+                                    TaskPriority p)
+{
+    const auto& plan = run->plan;
+    int seeded = 0;
+    int reused = 0;
+    for (int index = 0; index < plan->nodes().size(); ++index) {
+        const auto& entry = plan->node(index);
+        if (!inCone[index]) {
+            ++reused;
+            continue;
+        }
 
-        emit nodeStatusChanged(task.nodeUuid, static_cast<int>(ExecutionState::Finished));
-        for (const auto& cid : attached) {
-            if (cid.inNodeId == task.nodeId) {
-                emit connectionStatusChanged(connectionUuidForId(_graphModel, cid), static_cast<int>(ExecutionState::Finished));
+        // Nodes fed by another dirty node are triggered by normal propagation
+        bool fedByCone = false;
+        for (int inIndex : entry.inEdges) {
+            if (inCone[plan->edge(inIndex).sourceIndex]) {
+                fedByCone = true;
+                break;
             }
         }
+        if (fedByCone) continue;
 
-        QMutexLocker locker(&m_queueMutex);
-        --m_activeTasks;
-        m_nodeInFlight.insert(task.nodeUuid, 0);
-
-        if (m_executionDelay == 0) {
-            locker.unlock();
-            processNext();
-            locker.relock();
+        ExecutionTask task;
+        task.nodeId = entry.nodeId;
+        task.nodeUuid = entry.uuid;
+        task.nodeIndex = index;
+        task.run = run;
+
+        if (entry.hasIncoming) {
+            // Cone roots read every input from the clean predecessors' seeded outputs
+            ExecutionToken token;
+            token.tokenId = ExecIds::tokenUuid(run->id, ++run->tokenSerial);
+            for (int inIndex : entry.inEdges) {
+                const ExecutionPlan::Edge& e = plan->edge(inIndex);
+                const QVariant v = run->lake->value(plan->node(e.sourceIndex).uuid, e.sourcePinId);
+                if (v.isValid()) token.data.insert(e.targetPinId, v);
+            }
+            if (token.data.isEmpty() || !entry.node
+                || !entry.node->isReady(token.data, entry.inEdges.size())) {
+                continue;
+            }
+            task.inputs.push_back(std::move(token));
         }
 
-        tryFinalize();
-    });
+        scheduleNode(std::move(task), p);
+        ++seeded;
+    }
+
+    for (int index = 0; index < plan->nodes().size(); ++index) {
+        if (!inCone[index]) {
+            emit nodeStatusChanged(plan->node(index).uuid, static_cast<int>(ExecutionState::Finished));
+        }
+    }
+    postLog(QStringLiteral("ExecutionEngine: Incremental run; %1 node(s) reused, %2 entry task(s) seeded.")
+                .arg(reused).arg(seeded));
 }
 
-void ExecutionEngine::tryFinalize()
+void ExecutionEngine::releaseWork(const std::shared_ptr<RunContext>& run, int count)
 {
-    if (m_finalized) return;
-    if (m_activeTasks != 0) return;
-    
-    // Ensure the priority queue is empty
-    for (auto it = m_priorityQueue.cbegin(); it != m_priorityQueue.cend(); ++it) {
-        if (!it.value().isEmpty()) return;
-    }
+    if (run->outstanding.fetch_sub(count, std::memory_order_acq_rel) != count) return;
 
     // If slow-motion is enabled, enforce a minimum delay since last activity
-    if (m_executionDelay > 0) {
-        const qint64 now = QDateTime::currentMSecsSinceEpoch();
-        const qint64 elapsed = now - m_lastActivityMs;
+    if (run->foreground && m_executionDelay > 0) {
+        const qint64 elapsed = QDateTime::currentMSecsSinceEpoch() - m_lastActivityMs.load();
         const int remaining = m_executionDelay - static_cast<int>(elapsed);
         if (remaining > 0) {
-            // Schedule finalize on engine thread regardless of caller thread
-            QTimer::singleShot(remaining, this, &ExecutionEngine::onFinalizeTimeout);
+            // Finalize on the engine thread regardless of the caller's thread
+            QTimer::singleShot(remaining, this, [this, run]() { finalizeRun(run); });
             return;
         }
     }
+    finalizeRun(run);
+}
+
+void ExecutionEngine::finalizeRun(const std::shared_ptr<RunContext>& run)
+{
+    if (run->finalized || run->cancelled) return;
 
     // Build final packet
     DataPacket finalPacket;
-    bool hasError = false;
-    {
-        QReadLocker locker(&m_dataLock);
-        for (auto it = m_dataLake.cbegin(); it != m_dataLake.cend(); ++it) {
-            const QVariantMap& bucket = it.value();
-            auto errIt = bucket.constFind(QStringLiteral("__error"));
-            if (errIt != bucket.cend() && !errIt->toString().trimmed().isEmpty()) {
-                hasError = true; break;
-            }
-        }
-    }
+    const bool hasError = run->lake->hasError();
 
     if (hasError) {
-        QReadLocker locker(&m_dataLock);
-        for (auto it = m_dataLake.cbegin(); it != m_dataLake.cend(); ++it) {
+        const QHash<QUuid, QVariantMap> all = run->lake->toHash();
+        for (auto it = all.cbegin(); it != all.cend(); ++it) {
             const QVariantMap& bucket = it.value();
             for (auto vit = bucket.cbegin(); vit != bucket.cend(); ++vit) {
                 finalPacket.insert(vit.key(), vit.value());
             }
         }
-    } else if (_graphModel) {
-        const auto allNodes = _graphModel->allNodeIds();
-        QSet<QtNodes::NodeId> hasOutgoing;
-        for (auto nid : allNodes) {
-            const auto attached = _graphModel->allConnectionIds(nid);
-            for (const auto& cid : attached) if (cid.outNodeId == nid) hasOutgoing.insert(nid);
-        }
-        QReadLocker locker(&m_dataLock);
-        for (auto nid : allNodes) {
-            if (hasOutgoing.contains(nid)) continue;
-            const QUuid uuid = nodeUuidForId(_graphModel, nid);
-            const QVariantMap bucket = m_dataLake.value(uuid);
+    } else if (run->plan) {
+        for (const auto& entry : run->plan->nodes()) {
+            if (entry.hasOutgoing) continue;
+            const QVariantMap bucket = run->lake->bucket(entry.uuid);
             for (auto it = bucket.cbegin(); it != bucket.cend(); ++it) {
                 finalPacket.insert(it.key(), it.value());
             }
         }
     }
 
-    m_finalized = true;
-    emit nodeLog(QStringLiteral("ExecutionEngine: Chain finished."));
+    if (run->finalized.exchange(true)) return;
+
+    if (run->cancellation.deadline() != CancellationToken::kNoDeadline
+        && QDeadlineTimer::current().deadline() > run->cancellation.deadline()) {
+        MetricsRegistry::instance()
+            .counter(QStringLiteral("cp_run_deadline_misses"), QStringLiteral("Runs that finished after their deadline"))
+            .increment();
+        run->span.setAttribute(QStringLiteral("cp.run.deadline_missed"), true);
+    }
+    if (run->trace) writeTrace(run);
+    if (run->recording) writeRecording(run);
+    if (run->checkpoint) {
+        // Kept for resuming unless the run got all the way through
+        QString error;
+        if (!run->checkpoint->close(hasError, &error)) {
+            CP_WARN << "ExecutionEngine: Could not update checkpoint" << run->checkpoint->path() << ":" << error;
+        } else if (hasError) {
+            postLog(QStringLiteral("ExecutionEngine: Checkpoint of %1 node execution(s) kept at %2")
+                        .arg(run->checkpoint->size())
+                        .arg(run->checkpoint->path()));
+        }
+    }
+    if (hasError) run->span.setError(QStringLiteral("A node reported an error"));
+    run->span.end();
+
+    if (!run->foreground) {
+        // Bookkeeping and the signal are deferred to the engine thread, which also lets
+        // startIndependentRun() return the id first
+        QMetaObject::invokeMethod(this, [this, runId = run->id, finalPacket, hasError]() {
+            {
+                QMutexLocker locker(&m_queueMutex);
+                m_independentRuns.remove(runId);
+            }
+            emit runFinished(runId, finalPacket, !hasError);
+        }, Qt::QueuedConnection);
+        return;
+    }
+
+    // A successful run becomes the baseline for the next incremental run
+    if (!hasError) {
+        QMutexLocker snapshotLocker(&m_snapshotMutex);
+        if (m_pendingSnapshot.valid) {
+            // Shared rather than copied, so spilled outputs stay on disk
+            m_pendingSnapshot.dataLake = run->lake;
+            m_lastSuccessfulRun = m_pendingSnapshot;
+        }
+    }
+
+    // Coalesced receivers must see the final snapshots before pipelineFinished
+    if (QThread::currentThread() == thread()) {
+        flushOutputNotifications();
+    } else {
+        QMetaObject::invokeMethod(this, &ExecutionEngine::flushOutputNotifications, Qt::QueuedConnection);
+    }
+
+    postLog(QStringLiteral("ExecutionEngine: Chain finished."));
+    const DataLake::Metrics lake = run->lake->metrics();
+    if (lake.spilledBuckets > 0 || lake.droppedBuckets > 0) {
+        postLog(QStringLiteral("ExecutionEngine: Data lake peaked at %1 KiB in memory; %2 output(s) spilled (%3 KiB).")
+                    .arg(lake.peakMemoryBytes / 1024).arg(lake.spilledBuckets).arg(lake.spilledBytes / 1024));
+    }
+    if (run->usage) reportUsage(run, !hasError);
     emit pipelineFinished(finalPacket);
     emit executionFinished();
 }
 
 QByteArray ExecutionEngine::computeInputSignature(const QVariantMap& inputPayload) const
 {
-    QJsonObject jobj = QJsonObject::fromVariantMap(inputPayload);
-    const QByteArray json = QJsonDocument(jobj).toJson(QJsonDocument::Compact);
-    return QCryptographicHash::hash(json, QCryptographicHash::Sha256);
+    return InputSignature::compute(inputPayload);
 }
 
-void ExecutionEngine::handleTaskCompleted(QtNodes::NodeId nodeId,
+void ExecutionEngine::handleTaskCompleted(const std::shared_ptr<RunContext>& run,
+                                          QtNodes::NodeId nodeId,
                                           const QUuid& nodeUuid,
-                                          const TokenList& outputTokens,
-                                          const QUuid& runId)
+                                          const TokenList& outputTokens)
 {
-    // Data Guard: if this completion belongs to a stale run, ignore
-    if (runId != m_currentRunId) return;
+    // Data Guard: if this completion belongs to a stopped or replaced run, ignore
+    if (!run || run->cancelled) return;
+    const auto& plan = run->plan;
+
+    // In work-stealing mode dedup signatures live in the per-node mailboxes
+    const auto& mailboxes = run->mailboxes;
 
     if (outputTokens.empty()) {
-        QMutexLocker ql(&m_queueMutex);
-        m_lastInputSignature.remove(nodeUuid);
+        const int index = (mailboxes && plan) ? plan->indexOf(nodeId) : -1;
+        if (index >= 0 && index < mailboxes->size) {
+            NodeMailbox& box = mailboxes->boxes[index];
+            QMutexLocker bl(&box.mutex);
+            box.lastSignature.clear();
+        } else {
+            QMutexLocker ql(&m_queueMutex);
+            run->lastInputSignature.remove(nodeUuid);
+        }
         return;
     }
 
     // Update data lake snapshot for this node (merge all produced tokens)
     bool thisNodeReportedError = false;
-    {
-        QWriteLocker locker(&m_dataLock);
-        for (const auto& token : outputTokens) {
-            const QUuid producer = token.sourceNodeId.isNull() ? nodeUuid : token.sourceNodeId;
-            QVariantMap& bucket = m_dataLake[producer];
-            for (auto it = token.data.cbegin(); it != token.data.cend(); ++it) {
-                bucket.insert(it.key(), it.value());
-            }
-            const auto errIt = token.data.constFind(QStringLiteral("__error"));
-            if (errIt != token.data.cend() && !errIt->toString().trimmed().isEmpty()) {
-                thisNodeReportedError = true;
-            }
+    for (const auto& token : outputTokens) {
+        const QUuid producer = token.sourceNodeId.isNull() ? nodeUuid : token.sourceNodeId;
+        run->lake->merge(producer, token.data);
+        const auto errIt = token.data.constFind(QStringLiteral("__error"));
+        if (errIt != token.data.cend() && !errIt->toString().trimmed().isEmpty()) {
+            thisNodeReportedError = true;
         }
     }
-
-    // Emit snapshot synchronously so tests observe per-iteration values
-    if (runId == m_currentRunId) {
-        QMetaObject::invokeMethod(this, "nodeOutputChanged",
-                                  Qt::BlockingQueuedConnection,
-                                  Q_ARG(QtNodes::NodeId, nodeId));
+    if (run->trace) {
+        run->trace->recordCounter(QStringLiteral("Data lake"),
+                                  {{QStringLiteral("memory_bytes"), run->lake->memoryBytes()},
+                                   {QStringLiteral("spilled_bytes"), run->lake->spilledBytes()}});
     }
 
+    const int sourceIndex = plan ? plan->indexOf(nodeId) : -1;
+    notifyNodeOutputChanged(run, nodeId, sourceIndex);
+
     // Propagate each produced token to all connected downstream nodes.
-    if (!_graphModel) return;
+    if (sourceIndex < 0) return;
 
     // If a hard error occurred, stop scheduling new work
     if (thisNodeReportedError) {
         QMutexLocker qlock(&m_queueMutex);
-        m_hardError = true;
+        run->hardError = true;
         return;
     }
 
-    const auto attached = _graphModel->allConnectionIds(nodeId);
-    // Build mapping of connection to pin ids
-    struct Edge { QtNodes::ConnectionId cid; PinId sourcePinId; PinId targetPinId; };
-    QVector<Edge> edges;
-    for (const auto& cid : attached) {
-        if (cid.outNodeId != nodeId) continue;
-        auto* srcDel = _graphModel->delegateModel<ToolNodeDelegate>(cid.outNodeId);
-        auto* dstDel = _graphModel->delegateModel<ToolNodeDelegate>(cid.inNodeId);
-        if (!srcDel || !dstDel) continue;
-        const PinId sPin = srcDel->pinIdForIndex(QtNodes::PortType::Out, cid.outPortIndex);
-        const PinId tPin = dstDel->pinIdForIndex(QtNodes::PortType::In, cid.inPortIndex);
-        if (sPin.isEmpty() || tPin.isEmpty()) continue;
-        edges.push_back({cid, sPin, tPin});
-    }
+    if (plan->node(sourceIndex).outEdges.isEmpty()) return;
+
+    auto expansion = std::make_shared<TokenExpansion>();
+    expansion->sourceIndex = sourceIndex;
+    expansion->nodeId = nodeId;
+    expansion->nodeUuid = nodeUuid;
+    expansion->tokens = outputTokens;
+    expansion->token = expansion->tokens.cbegin();
+    expandTokens(run, expansion, false);
+}
+
+int ExecutionEngine::expandTokens(const std::shared_ptr<RunContext>& run,
+                                  const std::shared_ptr<TokenExpansion>& expansion,
+                                  bool resumed)
+{
+    const auto& plan = run->plan;
+    const auto& mailboxes = run->mailboxes;
+    const QVector<int>& outEdges = plan->node(expansion->sourceIndex).outEdges;
+    const int capacity = run->inputQueueCapacity;
 
     // Input snapshotting: For each edge that is triggered by a token, immediately
     // build a full input payload for the target node using the triggering token
     // for that target pin and the latest values in the data lake for other pins.
-    for (const auto& tok : outputTokens) {
-        const QUuid triggerTokenId = tok.tokenId.isNull() ? QUuid::createUuid() : tok.tokenId;
-        for (const auto& e : edges) {
+    for (; expansion->token != expansion->tokens.cend(); ++expansion->token, expansion->edgePos = 0) {
+        const auto& tok = *expansion->token;
+        if (expansion->edgePos == 0) {
+            expansion->triggerTokenId = tok.tokenId.isNull() ? ExecIds::tokenUuid(run->id, ++run->tokenSerial)
+                                                             : tok.tokenId;
+        }
+        for (; expansion->edgePos < outEdges.size(); ++expansion->edgePos) {
+            if (run->cancelled || run->hardError) return -1;
+
+            const ExecutionPlan::Edge& e = plan->edge(outEdges[expansion->edgePos]);
             const auto it = tok.data.constFind(e.sourcePinId);
             if (it == tok.data.cend()) continue; // token didn't fire this pin
 
-            const QtNodes::NodeId targetNodeId = e.cid.inNodeId;
-            const QUuid targetUuid = nodeUuidForId(_graphModel, targetNodeId);
-
-            // Collect all inbound edges for the target to know required pins
-            struct InEdge { QUuid sourceNodeUuid; PinId sourcePin; PinId targetPin; };
-            QVector<InEdge> inEdges;
-            const auto inboundConnections = _graphModel->allConnectionIds(targetNodeId);
-            for (const auto& cid : inboundConnections) {
-                if (cid.inNodeId != targetNodeId) continue;
-                auto* srcDel = _graphModel->delegateModel<ToolNodeDelegate>(cid.outNodeId);
-                auto* dstDel = _graphModel->delegateModel<ToolNodeDelegate>(cid.inNodeId);
-                if (!srcDel || !dstDel) continue;
-                const PinId sPin = srcDel->pinIdForIndex(QtNodes::PortType::Out, cid.outPortIndex);
-                const PinId tPin = dstDel->pinIdForIndex(QtNodes::PortType::In, cid.inPortIndex);
-                if (sPin.isEmpty() || tPin.isEmpty()) continue;
-                inEdges.push_back({ nodeUuidForId(_graphModel, cid.outNodeId), sPin, tPin });
-            }
-
-            QVariantMap inputPayload;
-            // Start with the triggering value
-            inputPayload.insert(e.targetPinId, it.value());
-
-            // Fill remaining pins from the latest data lake snapshot under a read lock
-            {
-                QReadLocker rlock(&m_dataLock);
-                for (const auto& ie : inEdges) {
-                    if (ie.targetPin == e.targetPinId) continue; // already set by triggering token
-                    const QVariantMap bucket = m_dataLake.value(ie.sourceNodeUuid);
-                    const QVariant v = bucket.value(ie.sourcePin);
-                    if (v.isValid()) inputPayload.insert(ie.targetPin, v);
+            // Backpressure: leave the rest of the fan-out parked until the target drains.
+            // Deciding under expansionMutex pairs with retireTask(), which decrements
+            // before it looks for parked work.
+            if (capacity > 0 && run->inputDepth[e.targetIndex].load(std::memory_order_acquire) >= capacity) {
+                QMutexLocker el(&run->expansionMutex);
+                if (run->inputDepth[e.targetIndex].load(std::memory_order_acquire) >= capacity) {
+                    expansion->blockedOn = e.targetIndex;
+                    // A resumed expansion keeps its place ahead of newer ones
+                    if (resumed) {
+                        run->parkedExpansions.prepend(expansion);
+                    } else {
+                        run->parkedExpansions.append(expansion);
+                    }
+                    return e.targetIndex;
                 }
             }
 
+            const ExecutionPlan::Node& target = plan->node(e.targetIndex);
+            const QVariantMap inputPayload = snapshotInputs(*run, e, it.value());
+
             // Node-negotiated readiness: ask the target node if inputs are sufficient.
-            auto* targetDel = _graphModel->delegateModel<ToolNodeDelegate>(targetNodeId);
-            if (!targetDel) {
+            if (!target.node) {
                 continue;
             }
-            auto targetNode = targetDel->node();
-            if (!targetNode) {
-                continue;
-            }
-            if (!targetNode->isReady(inputPayload, inEdges.size())) {
-                // Inputs not sufficient per node policy; skip scheduling for now
+            if (!target.node->isReady(inputPayload, target.inEdges.size())) {
+                // Inputs not sufficient per node policy; skip scheduling for now. A
+                // control-flow node may have its branches started in the meantime;
+                // work-stealing and slow-motion runs never speculate.
+                if (!mailboxes && m_executionDelay == 0 && !tok.forceExecution) {
+                    speculate(run, e.targetIndex, inputPayload);
+                }
                 continue;
             }
 
             // Deduplicate: compute signature of inputs and avoid duplicate executions
             const QByteArray signature = computeInputSignature(inputPayload);
-            {
+            if (mailboxes && e.targetIndex < mailboxes->size) {
+                NodeMailbox& box = mailboxes->boxes[e.targetIndex];
+                QMutexLocker bl(&box.mutex);
+                if (!tok.forceExecution && !box.lastSignature.isEmpty() && box.lastSignature == signature) {
+                    continue;
+                }
+                box.lastSignature = signature;
+            } else {
                 QMutexLocker ql(&m_queueMutex);
-                const QByteArray last = m_lastInputSignature.value(targetUuid);
+                const QByteArray last = run->lastInputSignature.value(target.uuid);
                 if (!tok.forceExecution && !last.isEmpty() && last == signature) {
                     continue; // same inputs as last execution for this node
                 }
-                m_lastInputSignature.insert(targetUuid, signature);
+                run->lastInputSignature.insert(target.uuid, signature);
             }
 
             // Create the snapshot TokenList for the target node
             TokenList snap;
             ExecutionToken t;
-            t.tokenId = triggerTokenId;  // Preserve triggering token identity
-            t.sourceNodeId = nodeUuid;
-            t.connectionId = connectionUuidForId(_graphModel, e.cid);
+            t.tokenId = expansion->triggerTokenId;  // Preserve triggering token identity
+            t.sourceNodeId = expansion->nodeUuid;
+            t.connectionId = e.connectionUuid;
             t.triggeringPinId = e.targetPinId;  // The pin that received a fresh value
             t.forceExecution = tok.forceExecution; // Propagate forced execution
             t.data = inputPayload;
             snap.push_back(std::move(t));
 
             ExecutionTask next;
-            next.nodeId = targetNodeId;
-            next.nodeUuid = targetUuid;
+            next.nodeId = target.nodeId;
+            next.nodeUuid = target.uuid;
+            next.nodeIndex = e.targetIndex;
+            next.run = run;
             next.inputs = std::move(snap);
-            if (runId == m_currentRunId) {
-                scheduleNode(next, TaskPriority::High);
+            if (!tok.forceExecution) {
+                next.speculation = adoptSpeculation(*run, expansion->sourceIndex, e.targetIndex, signature);
+            }
+            if (!run->cancelled) {
+                scheduleNode(std::move(next), TaskPriority::High);
             }
         }
     }
+    return -1;
+}
+
+QVariantMap ExecutionEngine::snapshotInputs(const RunContext& run, const ExecutionPlan::Edge& edge,
+                                            const QVariant& value)
+{
+    const auto& plan = run.plan;
+    QVariantMap inputPayload;
+    // Start with the triggering value
+    inputPayload.insert(edge.targetPinId, value);
+
+    // Fill remaining pins from the latest data lake snapshot
+    for (int inIndex : plan->node(edge.targetIndex).inEdges) {
+        const ExecutionPlan::Edge& ie = plan->edge(inIndex);
+        if (ie.targetPinId == edge.targetPinId) continue; // already set by triggering token
+        const QVariant v = run.lake->value(plan->node(ie.sourceIndex).uuid, ie.sourcePinId);
+        if (v.isValid()) inputPayload.insert(ie.targetPinId, v);
+    }
+    return inputPayload;
+}
+
+void ExecutionEngine::speculate(const std::shared_ptr<RunContext>& run, int originIndex,
+                                const QVariantMap& originInputs)
+{
+    const auto& plan = run->plan;
+    const ExecutionPlan::Node& origin = plan->node(originIndex);
+    const QList<DataPacket> candidates = origin.node->speculativeOutputs(originInputs);
+
+    for (const DataPacket& candidate : candidates) {
+        for (int edgeIndex : origin.outEdges) {
+            const ExecutionPlan::Edge& e = plan->edge(edgeIndex);
+            const auto it = candidate.constFind(e.sourcePinId);
+            if (it == candidate.cend()) continue;
+
+            // Only nodes whose result depends on nothing but their inputs run before
+            // they are known to be wanted; side effects can't be taken back
+            const ExecutionPlan::Node& target = plan->node(e.targetIndex);
+            if (!target.node || !(target.node->isCacheable() || target.node->isDeterministic())
+                || run->presetOutputs.contains(target.uuid)) {
+                continue;
+            }
+            const QVariantMap inputPayload = snapshotInputs(*run, e, it.value());
+            if (!target.node->isReady(inputPayload, target.inEdges.size())) continue;
+
+            auto speculation = std::make_shared<Speculation>();
+            speculation->originIndex = originIndex;
+            speculation->targetIndex = e.targetIndex;
+            speculation->signature = computeInputSignature(inputPayload);
+            {
+                QMutexLocker sl(&run->speculationMutex);
+                if (run->cancelled) return;
+                const bool started = std::any_of(run->speculations.cbegin(), run->speculations.cend(),
+                                                 [&](const std::shared_ptr<Speculation>& other) {
+                    return other->originIndex == originIndex && other->targetIndex == e.targetIndex
+                           && other->signature == speculation->signature;
+                });
+                if (started) continue;
+                // Its own token, so the losing branch stops without touching the run
+                speculation->cancellation =
+                    CancellationToken::create(run->cancellation.deadline(), runSlackMs(run->priority));
+                run->speculations.append(speculation);
+            }
+
+            ExecutionToken t;
+            t.tokenId = ExecIds::tokenUuid(run->id, ++run->tokenSerial);
+            t.sourceNodeId = origin.uuid;
+            t.connectionId = e.connectionUuid;
+            t.triggeringPinId = e.targetPinId;
+            t.data = inputPayload;
+
+            ExecutionTask next;
+            next.nodeId = target.nodeId;
+            next.nodeUuid = target.uuid;
+            next.nodeIndex = e.targetIndex;
+            next.run = run;
+            next.inputs = TokenList{std::move(t)};
+            next.speculation = std::move(speculation);
+            next.speculative = true;
+            // Behind the run's real work
+            scheduleNode(std::move(next), run->priority);
+        }
+    }
+}
+
+std::shared_ptr<ExecutionEngine::Speculation> ExecutionEngine::adoptSpeculation(RunContext& run, int originIndex,
+                                                                                int targetIndex,
+                                                                                const QByteArray& signature)
+{
+    QMutexLocker sl(&run.speculationMutex);
+    for (const auto& speculation : run.speculations) {
+        if (!speculation->adopted && speculation->originIndex == originIndex
+            && speculation->targetIndex == targetIndex && speculation->signature == signature) {
+            speculation->adopted = true;
+            return speculation;
+        }
+    }
+    return nullptr;
+}
+
+void ExecutionEngine::discardSpeculations(RunContext& run, int originIndex)
+{
+    quint64 discarded = 0;
+    {
+        QMutexLocker sl(&run.speculationMutex);
+        for (auto it = run.speculations.begin(); it != run.speculations.end();) {
+            if ((*it)->originIndex == originIndex && !(*it)->adopted) {
+                (*it)->cancellation.cancel();
+                it = run.speculations.erase(it);
+                ++discarded;
+            } else {
+                ++it;
+            }
+        }
+    }
+    if (discarded > 0) recordSpeculation(QStringLiteral("discarded"), discarded);
+}
+
+void ExecutionEngine::resumeExpansions(const std::shared_ptr<RunContext>& run, int targetIndex)
+{
+    // Wake parked fan-outs oldest first until one of them fills the target again; one
+    // that finishes or moves on to another target leaves the freed slot to the next.
+    for (;;) {
+        std::shared_ptr<TokenExpansion> expansion;
+        {
+            QMutexLocker el(&run->expansionMutex);
+            for (auto it = run->parkedExpansions.begin(); it != run->parkedExpansions.end(); ++it) {
+                if ((*it)->blockedOn == targetIndex) {
+                    expansion = *it;
+                    run->parkedExpansions.erase(it);
+                    run->expansionResumed.wakeAll();
+                    break;
+                }
+            }
+        }
+        if (!expansion) return;
+        expansion->blockedOn = -1;
+        if (expandTokens(run, expansion, true) == targetIndex) return;
+    }
+}
+
+void ExecutionEngine::retireTask(const ExecutionTask& task)
+{
+    const auto& run = task.run;
+    run->lake->taskFinished(task.nodeIndex);
+    if (task.nodeIndex < 0) return;
+    run->inputDepth[task.nodeIndex].fetch_sub(1, std::memory_order_acq_rel);
+    // The finishing task still counts as active, so a resumed fan-out schedules its
+    // work before the run's outstanding count can reach zero
+    if (run->inputQueueCapacity > 0) {
+        {
+            QMutexLocker el(&run->expansionMutex);
+            if (run->parkedExpansions.isEmpty()) return;
+        }
+        resumeExpansions(run, task.nodeIndex);
+    }
+}
+
+void ExecutionEngine::deferRetry(ExecutionTask task, int delayMs)
+{
+    // The attempt that just ended is released by its done(); this one holds the run open
+    const std::shared_ptr<RunContext> run = task.run;
+    run->outstanding.fetch_add(1, std::memory_order_relaxed);
+    if (run->foreground && logEnabled(LogVerbosity::Tasks)) {
+        postLog(QString::fromLatin1("Node Retrying: id=%1, type=%2, attempt=%3 of %4 in %5 ms")
+                    .arg(QString::number(task.nodeId), task.plan->node(task.nodeIndex).name)
+                    .arg(task.attempt + 1)
+                    .arg(task.plan->node(task.nodeIndex).retry.maxAttempts)
+                    .arg(delayMs));
+    }
+    recordNodeExecution(task.plan->node(task.nodeIndex).typeId, QStringLiteral("retried"));
+    if (run->usage) run->usage->recordRetry(task.nodeUuid);
+    ++task.attempt;
+    const qint64 notBefore = QDeadlineTimer::current().deadline() + delayMs;
+    {
+        QMutexLocker locker(&m_queueMutex);
+        m_delayedTasks[notBefore].append(std::move(task));
+    }
+    // Workers don't own the timer; the engine thread arms it
+    QMetaObject::invokeMethod(this, [this]() { armRetryTimer(); }, Qt::QueuedConnection);
+}
+
+void ExecutionEngine::armRetryTimer()
+{
+    QMutexLocker locker(&m_queueMutex);
+    if (m_delayedTasks.isEmpty()) {
+        m_retryTimer->stop();
+        return;
+    }
+    const qint64 waitMs = m_delayedTasks.firstKey() - QDeadlineTimer::current().deadline();
+    m_retryTimer->start(static_cast<int>(std::clamp<qint64>(waitMs, 0, std::numeric_limits<int>::max())));
+}
+
+void ExecutionEngine::onRetryTimeout()
+{
+    QList<ExecutionTask> due;
+    {
+        QMutexLocker locker(&m_queueMutex);
+        const qint64 now = QDeadlineTimer::current().deadline();
+        while (!m_delayedTasks.isEmpty() && m_delayedTasks.firstKey() <= now) {
+            due.append(m_delayedTasks.take(m_delayedTasks.firstKey()));
+        }
+    }
+    // Queued anew, behind work of the same urgency that arrived while they waited
+    for (auto& task : due) {
+        const RunContext& run = *task.run;
+        task.dueMs = taskDueMs(run, static_cast<TaskPriority>(task.priority));
+        if (run.trace) task.queuedAtUs = run.trace->nowUs();
+        if (run.usage) task.usageQueuedAtUs = run.usage->nowUs();
+        enqueueTask(std::move(task));
+    }
+    armRetryTimer();
 }
 
 void ExecutionEngine::onThrottleTimeout()
@@ -823,44 +2228,393 @@ void ExecutionEngine::onThrottleTimeout()
 
     QMutexLocker locker(&m_queueMutex);
     bool empty = true;
-    for (auto it = m_priorityQueue.cbegin(); it != m_priorityQueue.cend(); ++it) {
+    for (auto it = m_readyQueue.cbegin(); it != m_readyQueue.cend(); ++it) {
         if (!it.value().isEmpty()) { empty = false; break; }
     }
 
-    if (empty) {
-        if (m_throttler) m_throttler->stop();
-        tryFinalize();
+    if (empty && m_throttler) m_throttler->stop();
+}
+
+bool ExecutionEngine::isSourceNode(const ExecutionTask& task) const
+{
+    if (!task.plan || task.nodeIndex < 0) return false;
+    return !task.plan->node(task.nodeIndex).hasIncoming;
+}
+
+void ExecutionEngine::setExecutionDelay(int ms)
+{
+    m_executionDelay = ms;
+}
+
+void ExecutionEngine::setSchedulerMode(SchedulerMode mode)
+{
+    m_schedulerMode = mode;
+}
+
+void ExecutionEngine::setResultCacheEnabled(bool enabled, const QString& directory)
+{
+    m_resultCacheEnabled = enabled;
+    m_resultCacheDir = directory;
+    if (maxBytes != m_resultCacheMaxBytes) {
+        m_resultCacheMaxBytes = maxBytes;
+        m_resultCache.reset();
     }
 }
 
-bool ExecutionEngine::isSourceNode(QtNodes::NodeId nodeId) const
+void ExecutionEngine::setTraceEnabled(bool enabled, const QString& directory)
 {
-    if (!_graphModel) return false;
-    const auto attached = _graphModel->allConnectionIds(nodeId);
-    for (const auto& cid : attached) { if (cid.inNodeId == nodeId) return false; }
-    return true;
+    m_traceEnabled = enabled;
+    m_traceDir = directory;
 }
 
-void ExecutionEngine::onFinalizeTimeout()
+void ExecutionEngine::setThreadQosEnabled(bool enabled)
 {
-    // Timer to delay finalization to satisfy slow-motion elapsed expectations
-    tryFinalize();
+    m_threadQosEnabled = enabled;
 }
 
-void ExecutionEngine::setExecutionDelay(int ms)
+void ExecutionEngine::setTraceResidentMemory(bool enabled)
 {
-    m_executionDelay = ms;
+    m_traceResidentMemory = enabled;
+}
+
+void ExecutionEngine::setRecordingEnabled(bool enabled, const QString& directory)
+{
+    m_recordingEnabled = enabled;
+    m_recordingDir = directory;
+}
+
+void ExecutionEngine::setCheckpointEnabled(bool enabled, int intervalSeconds, const QString& directory)
+{
+    m_checkpointEnabled = enabled;
+    m_checkpointIntervalSeconds = std::max(0, intervalSeconds);
+    m_checkpointDir = directory;
+}
+
+QString ExecutionEngine::checkpointPath() const
+{
+    const QString dir =
+        m_checkpointDir.isEmpty() ? getProjectOutputDir() + QStringLiteral("/checkpoints") : m_checkpointDir;
+    return QDir(dir).filePath(QStringLiteral("last-run.cpckpt"));
+}
+
+bool ExecutionEngine::hasCheckpoint() const
+{
+    return QFileInfo::exists(checkpointPath());
+}
+
+void ExecutionEngine::setUsageReportEnabled(bool enabled, const QString& directory)
+{
+    m_usageReportEnabled = enabled;
+    m_usageReportDir = directory;
+}
+
+void ExecutionEngine::setReplay(std::shared_ptr<const RunRecording> recording, double latencyScale)
+{
+    m_replay = std::move(recording);
+    m_replayLatencyScale = std::max(0.0, latencyScale);
+}
+
+void ExecutionEngine::setInputQueueCapacity(int tasks)
+{
+    m_inputQueueCapacity = std::max(0, tasks);
+}
+
+void ExecutionEngine::setDataLakeBudget(qint64 bytes)
+{
+    m_dataLakeBudget = std::max<qint64>(0, bytes);
+}
+
+void ExecutionEngine::writeTrace(const std::shared_ptr<RunContext>& run)
+{
+    const QString dir = m_traceDir.isEmpty() ? getProjectOutputDir() + QStringLiteral("/traces") : m_traceDir;
+    const QString path = QDir(dir).filePath(
+        QStringLiteral("%1-%2.trace.json")
+            .arg(QDateTime::currentDateTime().toString(QStringLiteral("yyyyMMdd-HHmmss")),
+                 run->id.toString(QUuid::WithoutBraces).left(8)));
+
+    const auto lifetime = m_lifetime;
+    const auto plan = run->foreground ? run->plan : nullptr;
+    (void)QtConcurrent::run([this, lifetime, trace = run->trace, plan, path]() {
+        QString error;
+        const bool written = trace->writeChromeTrace(path, &error);
+        RunAnalysis analysis;
+        if (plan) analysis = RunAnalysis::analyse(trace->runId(), trace->spans(), *plan);
+        QReadLocker guard(&lifetime->lock);
+        if (!lifetime->alive) return;
+        if (written) {
+            postLog(QStringLiteral("ExecutionEngine: Trace written to %1").arg(path));
+            emit traceWritten(trace->runId(), path);
+        } else {
+            CP_WARN << "ExecutionEngine: Could not write trace" << path << ":" << error;
+        }
+        if (analysis.isValid()) emit runAnalysisReady(analysis);
+    });
+}
+
+void ExecutionEngine::setRunHistory(std::shared_ptr<RunHistory> history)
+{
+    m_runHistory = std::move(history);
+}
+
+void ExecutionEngine::reportUsage(const std::shared_ptr<RunContext>& run, bool succeeded)
+{
+    const RunUsageReport report = run->usage->report();
+    emit runUsageReady(report);
+
+    const QString dir = m_usageReportDir.isEmpty() ? getProjectOutputDir() + QStringLiteral("/usage")
+                                                   : m_usageReportDir;
+    const QString path = QDir(dir).filePath(
+        QStringLiteral("%1-%2.usage.json")
+            .arg(QDateTime::currentDateTime().toString(QStringLiteral("yyyyMMdd-HHmmss")),
+                 run->id.toString(QUuid::WithoutBraces).left(8)));
+    (void)QtConcurrent::run([report, path]() {
+        QString error;
+        if (!report.writeJson(path, &error)) {
+            CP_WARN << "ExecutionEngine: Could not write usage report" << path << ":" << error;
+        }
+    });
+
+    if (!m_runHistory || run->historyGraphHash.isEmpty()) return;
+    RunHistory::Entry entry;
+    entry.project = m_projectName;
+    entry.graphHash = run->historyGraphHash;
+    entry.configHash = run->historyConfigHash;
+    entry.succeeded = succeeded;
+    entry.report = report;
+    entry.report.models.clear();
+    (void)QtConcurrent::run([this, lifetime = m_lifetime, history = m_runHistory, entry]() mutable {
+        QString error;
+        if (!history->record(entry, &error)) {
+            CP_WARN << "ExecutionEngine: Could not record run history" << history->databasePath() << ":" << error;
+            return;
+        }
+        QReadLocker guard(&lifetime->lock);
+        if (lifetime->alive) emit runHistoryUpdated(entry.project, entry.graphHash);
+    });
+}
+
+void ExecutionEngine::writeRecording(const std::shared_ptr<RunContext>& run)
+{
+    const QString dir =
+        m_recordingDir.isEmpty() ? getProjectOutputDir() + QStringLiteral("/recordings") : m_recordingDir;
+    const QString path = QDir(dir).filePath(
+        QStringLiteral("%1-%2.cprec")
+            .arg(QDateTime::currentDateTime().toString(QStringLiteral("yyyyMMdd-HHmmss")),
+                 run->id.toString(QUuid::WithoutBraces).left(8)));
+    QString error;
+    if (run->recording->writeBundle(path, &error)) {
+        postLog(QStringLiteral("ExecutionEngine: Recording of %1 node execution(s) written to %2")
+                    .arg(run->recording->size())
+                    .arg(path));
+        emit recordingWritten(run->id, path);
+    } else {
+        CP_WARN << "ExecutionEngine: Could not write recording" << path << ":" << error;
+    }
+}
+
+void ExecutionEngine::saveCheckpoint(const std::shared_ptr<RunContext>& run)
+{
+    if (!run->checkpoint->claimWrite()) return;
+    (void)QtConcurrent::run([checkpoint = run->checkpoint]() {
+        QString error;
+        if (!checkpoint->write(&error)) {
+            CP_WARN << "ExecutionEngine: Could not write checkpoint" << checkpoint->path() << ":" << error;
+        }
+    });
+}
+
+void ExecutionEngine::replayTask(const ExecutionTask& task, const std::shared_ptr<IToolNode>& node,
+                                 bool forceExecution, const std::function<void()>& done)
+{
+    const ExecutionPlan::Node& planNode = task.plan->node(task.nodeIndex);
+    const std::optional<RunRecording::Execution> recorded = task.run->replay->take(task.nodeUuid, task.inputs);
+    TokenList outputs;
+    QString failure;
+    qint64 latencyMs = 0;
+    if (recorded) {
+        outputs = recorded->outputs;
+        failure = recorded->failure;
+        latencyMs = qRound64(recorded->durationUs * task.run->replayLatencyScale / 1000.0);
+    } else {
+        failure = QString::fromLatin1("ExecutionEngine: No recorded execution of node %1 %2 for these inputs")
+                      .arg(QString::number(task.nodeId), planNode.name);
+    }
+    recordNodeExecution(planNode.typeId, QStringLiteral("replayed"));
+
+    if (latencyMs <= 0) {
+        finishTask(task, std::move(outputs), failure, forceExecution);
+        done();
+        return;
+    }
+
+    // Asynchronous and remote nodes wait without holding a worker, as they do live.
+    // The completion goes back to a pool thread: committing may block on the engine thread.
+    if (task.remote || node->supportsAsyncExecution()) {
+        const auto lifetime = m_lifetime;
+        auto complete = [this, lifetime, task, outputs, failure, forceExecution, done]() {
+            (void)QtConcurrent::run([this, lifetime, task, outputs, failure, forceExecution, done]() {
+                QReadLocker guard(&lifetime->lock);
+                if (!lifetime->alive) return;
+                finishTask(task, outputs, failure, forceExecution);
+                done();
+            });
+        };
+        QMetaObject::invokeMethod(this, [this, latencyMs, complete]() {
+            QTimer::singleShot(latencyMs, this, complete);
+        }, Qt::QueuedConnection);
+        return;
+    }
+
+    // Synchronous nodes keep their worker, and their gate, for the recorded time
+    std::shared_ptr<QSemaphore> gate;
+    if (!node->supportsConcurrentRuns() && !node->isReentrant()) {
+        gate = nodeGate(node.get());
+        gate->acquire();
+    }
+    QThread::msleep(static_cast<unsigned long>(latencyMs));
+    if (gate) gate->release();
+    finishTask(task, std::move(outputs), failure, forceExecution);
+    done();
+}
+
+void ExecutionEngine::setOutputNotificationMode(OutputNotificationMode mode)
+{
+    m_outputMode = mode;
+}
+
+void ExecutionEngine::setLogVerbosity(LogVerbosity verbosity)
+{
+    m_logVerbosity.store(static_cast<int>(verbosity), std::memory_order_relaxed);
+}
+
+void ExecutionEngine::postLog(const QString& message)
+{
+    const bool onEngineThread = QThread::currentThread() == thread();
+    bool scheduleDrain = false;
+    {
+        QMutexLocker locker(&m_logMutex);
+        if (m_logChannel.size() >= kLogChannelCapacity) {
+            m_logChannel.dequeue();
+            ++m_droppedLogLines;
+        }
+        m_logChannel.enqueue(message);
+        if (!onEngineThread && !m_logDrainScheduled) {
+            m_logDrainScheduled = true;
+            scheduleDrain = true;
+        }
+    }
+
+    if (onEngineThread) {
+        // Keep ordering with lines already buffered by workers
+        drainLogs();
+    } else if (scheduleDrain) {
+        QMetaObject::invokeMethod(this, &ExecutionEngine::drainLogs, Qt::QueuedConnection);
+    }
+}
+
+void ExecutionEngine::drainLogs()
+{
+    QQueue<QString> batch;
+    int dropped = 0;
+    {
+        QMutexLocker locker(&m_logMutex);
+        batch.swap(m_logChannel);
+        dropped = m_droppedLogLines;
+        m_droppedLogLines = 0;
+        m_logDrainScheduled = false;
+    }
+
+    if (dropped > 0) {
+        emit nodeLog(QStringLiteral("ExecutionEngine: %1 log lines dropped (log channel full).").arg(dropped));
+    }
+    for (const QString& message : batch) {
+        emit nodeLog(message);
+    }
+}
+
+void ExecutionEngine::notifyNodeOutputChanged(const std::shared_ptr<RunContext>& run, QtNodes::NodeId nodeId,
+                                              int nodeIndex)
+{
+    if (!run->foreground || run->cancelled) return;
+
+    if (const auto box = std::atomic_load(&m_outputMailbox)) {
+        if (box->runId == run->id && nodeIndex >= 0 && nodeIndex < box->size) {
+            // Repeated updates for the same node collapse into one mark
+            if (!box->dirty[nodeIndex].exchange(true, std::memory_order_acq_rel)) {
+                box->anyDirty.store(true, std::memory_order_release);
+            }
+            return;
+        }
+    }
+
+    // Deliver snapshot synchronously so receivers observe per-iteration values
+    QMetaObject::invokeMethod(this, "nodeOutputChanged",
+                              Qt::BlockingQueuedConnection,
+                              Q_ARG(QtNodes::NodeId, nodeId));
+}
+
+void ExecutionEngine::flushOutputNotifications()
+{
+    const auto box = std::atomic_load(&m_outputMailbox);
+    if (!box) return;
+
+    if (box->anyDirty.exchange(false, std::memory_order_acq_rel)) {
+        for (int index = 0; index < box->size; ++index) {
+            if (box->dirty[index].exchange(false, std::memory_order_acq_rel)) {
+                emit nodeOutputChanged(box->plan->node(index).nodeId);
+            }
+        }
+    }
+
+    // Once the run has finished nothing new can arrive; stop ticking until the next run
+    const auto run = std::atomic_load(&m_run);
+    const bool runOver = !run || run->finalized || run->cancelled;
+    if (runOver && !box->anyDirty.load(std::memory_order_acquire) && m_outputFlushTimer) {
+        m_outputFlushTimer->stop();
+    }
+}
+
+DataLake::Metrics ExecutionEngine::dataLakeMetrics() const
+{
+    const auto run = std::atomic_load(&m_run);
+    return run ? run->lake->metrics() : DataLake::Metrics{};
 }
 
 DataPacket ExecutionEngine::nodeOutput(QtNodes::NodeId nodeId) const
 {
-    QReadLocker locker(&m_dataLock);
+    const auto run = std::atomic_load(&m_run);
+    if (!run) return {};
+
     const QUuid nodeUuid = nodeUuidForId(_graphModel, nodeId);
 
-    const QVariantMap map = m_dataLake.value(nodeUuid);
+    const QVariantMap map = run->lake->bucket(nodeUuid);
     DataPacket result;
     for (auto it = map.cbegin(); it != map.cend(); ++it) {
         result.insert(it.key(), it.value());
     }
     return result;
 }
+
+int ExecutionEngine::queuedTaskCount() const
+{
+    QMutexLocker locker(&m_queueMutex);
+    int count = 0;
+    const auto add = [&count](const std::shared_ptr<RunContext>& run) {
+        if (!run) return;
+        count += run->queuedTasks.load();
+        if (run->mailboxes) count += run->mailboxes->pending.load(std::memory_order_acquire);
+    };
+    add(std::atomic_load(&m_run));
+    for (const auto& run : m_independentRuns) add(run);
+    for (auto it = m_delayedTasks.cbegin(); it != m_delayedTasks.cend(); ++it) count += it.value().size();
+    return count;
+}
+
+int ExecutionEngine::activeTaskCount() const
+{
+    QMutexLocker locker(&m_queueMutex);
+    const auto foreground = std::atomic_load(&m_run);
+    int count = foreground ? foreground->activeTasks.load() : 0;
+    for (const auto& run : m_independentRuns) count += run->activeTasks.load();
+    return count;
+}
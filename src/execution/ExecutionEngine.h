@@ -24,6 +24,7 @@
 #pragma once
 
 #include <QObject>
+#include <QDeadlineTimer>
 #include <QUuid>
 #include <QPointer>
 #include <QHash>
@@ -33,10 +34,27 @@
 #include <QReadWriteLock>
 #include <QQueue>
 #include <QThreadPool>
+#include <QSemaphore>
+#include <QWaitCondition>
 
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <optional>
+
+#include "CancellationToken.h"
 #include "CommonDataTypes.h"
+#include "DataLake.h"
+#include "ExecutionPlan.h"
 #include "ExecutionState.h"
 #include "IToolNode.h"
+#include "MetricsRegistry.h"
+#include "ResourceBudgets.h"
+#include "RunAnalysis.h"
+#include "RunUsageReport.h"
+#include "ThreadQos.h"
+#include "Tracer.h"
 
 namespace QtNodes { class DataFlowGraphModel; using NodeId = unsigned int; }
 
@@ -44,6 +62,13 @@ class NodeGraphModel;
 class QTimer;
 
 class ExecutionEngineSignatureFriend;
+class WorkStealingScheduler;
+class ResultCache;
+class ExecutionTrace;
+class RunRecording;
+class RunCheckpoint;
+class RunHistory;
+class RemoteWorkerPool;
 
 class ExecutionEngine : public QObject {
     Q_OBJECT
@@ -66,76 +91,558 @@ signals:
     // refresh the Stage Output view for the currently selected node.
     void nodeOutputChanged(QtNodes::NodeId nodeId);
 
+    // Emitted once per independent run (see startIndependentRun) when it has drained.
+    // succeeded is false when a node reported an error or the run was stopped.
+    void runFinished(const QUuid& runId, const DataPacket& finalOutput, bool succeeded);
+    // Emitted from a worker thread when a node of an independent run publishes a
+    // partial output before finishing, such as the text streamed so far by an LLM node.
+    void runPartialOutput(const QUuid& runId, const QUuid& nodeUuid, const DataPacket& partial);
+
+    // Emitted from a worker thread once a run's execution trace has been written.
+    void traceWritten(const QUuid& runId, const QString& path);
+    // Emitted from a worker thread after a traced foreground run finished, with its
+    // critical path and concurrency breakdown.
+    void runAnalysisReady(const RunAnalysis& analysis);
+    // Emitted just before pipelineFinished with the foreground run's provider calls,
+    // tokens and latencies per node and per model, unless usage reports are disabled.
+    void runUsageReady(const RunUsageReport& report);
+    // Emitted from a worker thread once a foreground run was added to the run history,
+    // with the keys its runs are listed under (see RunHistory::runs()).
+    void runHistoryUpdated(const QString& project, const QString& graphHash);
+    // Emitted from a worker thread once a run's recording was written, before the run
+    // reports that it finished.
+    void recordingWritten(const QUuid& runId, const QString& path);
+
 public:
+    // A run's class. The global queue serves tasks earliest due first: a run with a
+    // deadline is due then, others are due a class-dependent slack after each task was
+    // queued (none for High runs), so interactive work overtakes queued batch work while
+    // batch work that waited long enough still gets its turn. Within a run, High tasks
+    // (the successors of a finished task) lead Normal ones by kTaskLeadMs.
     enum TaskPriority {
         High = 200,
         Normal = 100,
         Low = 0
     };
+    static constexpr qint64 kNormalRunSlackMs = 10000;
+    static constexpr qint64 kLowRunSlackMs = 60000;
+    static constexpr qint64 kTaskLeadMs = 1000;
+    static qint64 runSlackMs(TaskPriority p)
+    {
+        return p >= High ? 0 : p >= Normal ? kNormalRunSlackMs : kLowRunSlackMs;
+    }
+    // OS scheduling level of the workers running a run's Cpu work (see ThreadQos). The
+    // foreground run and High runs are interactive; other independent runs are batch
+    // work, Normal ones at Utility and Low ones at Background.
+    static ThreadQos::Level threadQosOf(bool foreground, TaskPriority p)
+    {
+        if (foreground || p >= High) return ThreadQos::Level::UserInitiated;
+        return p >= Normal ? ThreadQos::Level::Utility : ThreadQos::Level::Background;
+    }
+
+    // GlobalQueue: one due-ordered queue guarded by the queue mutex (default).
+    // WorkStealing: per-worker deques with stealing and per-node mailboxes; intended
+    // for wide fan-outs of short tasks. Slow-motion runs always use GlobalQueue.
+    enum class SchedulerMode {
+        GlobalQueue,
+        WorkStealing
+    };
+
+    // Full: execute from the sources (or the given entry points).
+    // Incremental: execute only the nodes whose configuration or incoming connections
+    // changed since the last successful run, the given entry points, and everything
+    // downstream of them. Clean nodes keep their outputs from that run. Falls back to
+    // Full when there is no successful run to compare against.
+    enum class RunMode {
+        Full,
+        Incremental
+    };
+
+    // Synchronous: a worker blocks until nodeOutputChanged has been delivered on the
+    // engine thread, so receivers observe every intermediate snapshot (default; tests
+    // rely on this). Coalesced: workers only mark the node as changed and the engine
+    // thread emits one nodeOutputChanged per changed node on a ~60 Hz frame timer.
+    enum class OutputNotificationMode {
+        Synchronous,
+        Coalesced
+    };
+
+    // Which per-task trace lines the engine builds for nodeLog. Lifecycle and error
+    // messages are always delivered. Quiet: none; Tasks: "Node Started", "Executing
+    // Node" and "Node Finished"; Full: additionally one line per output key (default).
+    enum class LogVerbosity {
+        Quiet,
+        Tasks,
+        Full
+    };
 
 public slots:
     void Run(QtNodes::NodeId startNodeId = std::numeric_limits<unsigned int>::max(), TaskPriority p = TaskPriority::Normal);
     void stop();
     // Run the pipeline starting from specific entry point node UUIDs. If the list is empty,
     // the engine discovers all source nodes (no incoming connections) and schedules them.
-    void runPipeline(const QList<QUuid>& specificEntryPoints = {}, TaskPriority p = TaskPriority::Normal);
+    void runPipeline(const QList<QUuid>& specificEntryPoints = {}, TaskPriority p = TaskPriority::Normal,
+                     RunMode mode = RunMode::Full);
+    // Runs the whole pipeline again, answering every node whose configuration is
+    // unchanged and whose inputs match an execution in the last checkpoint from it
+    // (see RunCheckpoint); the rest executes. Without a checkpoint this is a full run.
+    // The resumed run is checkpointed in turn.
+    void resumePipeline(TaskPriority p = TaskPriority::Normal);
+    // Starts a run alongside the foreground run and any other independent runs. It
+    // shares the engine's queue, pools and budgets but has its own data lake, dedup
+    // signatures and finalization, emits no status or output signals, and reports
+    // only through runFinished(). Nodes listed in presetOutputs are not executed;
+    // their packet is used as their output, which is how batch jobs give each run its
+    // own input. Independent runs always use the global queue, and stop() ends them
+    // too. p is the run's class and deadline the time it should be done by; both order
+    // its tasks and its provider requests against other runs'. A run is not stopped
+    // when its deadline passes, only counted in cp_run_deadline_misses. Returns the
+    // new run's id.
+    QUuid startIndependentRun(const QHash<QUuid, QVariantMap>& presetOutputs = {},
+                              TaskPriority p = TaskPriority::Normal,
+                              QDeadlineTimer deadline = QDeadlineTimer(QDeadlineTimer::Forever));
+    // Ends one independent run the way stop() ends them all: its remaining work is
+    // abandoned and runFinished() reports it as failed. Does nothing once it finished.
+    void cancelRun(const QUuid& runId);
     void setExecutionDelay(int ms);
+    void setSchedulerMode(SchedulerMode mode);
+    void setOutputNotificationMode(OutputNotificationMode mode);
+    void setLogVerbosity(LogVerbosity verbosity);
+    // Opt-in persistent result cache. With an empty directory, entries are stored under
+    // the project output directory in ".result_cache". The least recently used entries
+    // are dropped past maxBytes (0 keeps ResultCache::kDefaultMaxBytes). Takes effect
+    // on the next run.
+    void setResultCacheEnabled(bool enabled, const QString& directory = {}, qint64 maxBytes = 0);
+    // Opt-in execution timeline. Each run records one span per task (queue, start and
+    // finish times, worker thread, payload sizes) and writes a Chrome Trace Event file
+    // when it finishes, by default to "traces" under the project output directory.
+    // Takes effect on the next run.
+    void setTraceEnabled(bool enabled, const QString& directory = {});
+    // Traced runs also sample process RSS before and after each node execution. RSS is
+    // process-wide, so concurrent executions blur each other's deltas. Defaults to the
+    // CP_TRACE_RSS environment variable.
+    void setTraceResidentMemory(bool enabled);
+    // Runs batch runs' Cpu work on workers at a lower OS scheduling level (see
+    // threadQosOf()). Defaults to on unless CP_THREAD_QOS is 0. Takes effect on the
+    // next run.
+    void setThreadQosEnabled(bool enabled);
+    // Opt-in run recording. Each run saves the inputs, outputs and wall time of every
+    // node execution as a bundle (see RunRecording) when it finishes, by default to
+    // "recordings" under the project output directory. Takes effect on the next run.
+    void setRecordingEnabled(bool enabled, const QString& directory = {});
+    // Opt-in run checkpoints. Foreground runs save their successful node executions
+    // to "checkpoints" under the project output directory at most every
+    // intervalSeconds, and once more when they fail or are stopped. A run that
+    // succeeds removes its checkpoint. Takes effect on the next run.
+    void setCheckpointEnabled(bool enabled, int intervalSeconds = 60, const QString& directory = {});
+    // Where the project's checkpoint is kept, and whether one is there to resume
+    QString checkpointPath() const;
+    bool hasCheckpoint() const;
+    // Run usage reports (see RunUsageReport), on by default. Each foreground run ends
+    // with runUsageReady() and a JSON report, by default in "usage" under the project
+    // output directory. Takes effect on the next run.
+    void setUsageReportEnabled(bool enabled, const QString& directory = {});
+    // Where foreground runs' usage reports are also kept for trend analysis, keyed by
+    // the project name and the graph's hash; nullptr, the default, keeps none. Needs
+    // usage reports. Takes effect on the next run.
+    void setRunHistory(std::shared_ptr<RunHistory> history);
+    // Replays a recording: nodes are not executed, each answers with the execution
+    // recorded for its inputs once its recorded wall time multiplied by latencyScale
+    // has passed (0 answers at once). A node with no recorded execution for its inputs
+    // fails. nullptr executes nodes again. Takes effect on the next run.
+    void setReplay(std::shared_ptr<const RunRecording> recording, double latencyScale = 1.0);
+    // Tasks a node may have scheduled but not finished before the producers feeding it
+    // pause their token fan-out; 0 removes the limit. Takes effect on the next run.
+    void setInputQueueCapacity(int tasks);
+    int inputQueueCapacity() const { return m_inputQueueCapacity; }
+    // Bytes of node outputs each run keeps in memory before spilling them to disk;
+    // 0 removes the limit. Takes effect on the next run.
+    void setDataLakeBudget(qint64 bytes);
+    qint64 dataLakeBudget() const { return m_dataLakeBudget; }
     void setProjectName(const QString& name);
+    // Concurrency limits per ResourceClass. runPipeline() reloads them from the graph
+    // model's saved project budgets, so this only lasts until the next run there.
+    void setResourceBudgets(const ResourceBudgets& budgets);
+    ResourceBudgets resourceBudgets() const;
+    // Sends the pool's designated node types to remote workers while some healthy
+    // worker runs them; they are then capped by the pool's capacity instead of their
+    // class budget. nullptr runs everything locally again.
+    void setRemoteWorkers(std::shared_ptr<RemoteWorkerPool> workers);
     QtNodes::NodeId nodeIdForUuid(const QUuid& uuid) const;
 
 public:
     // Thread-safe accessor to retrieve output data for a specific node
     DataPacket nodeOutput(QtNodes::NodeId nodeId) const;
+    // Size of the foreground run's data lake: resident and spilled bytes and buckets
+    DataLake::Metrics dataLakeMetrics() const;
 
 private:
     // V3.1 task-queue based execution engine state ------------------------
 
+    struct RunContext;
+    struct Speculation;
+
     // A single unit of scheduled work for a node.
     struct ExecutionTask {
         QtNodes::NodeId nodeId {0};
         QUuid            nodeUuid;
+        int              nodeIndex {-1}; // dense index into the run's ExecutionPlan
         TokenList        inputs;   // snapshot of ready-to-use input packets
-        QUuid            runId;    // run identifier for safety across restarts
+        QUuid            runId;    // run identifier, for logs and guards
         int              priority {100};
+        qint64           dueMs {0};  // queue order, monotonic ms (see TaskPriority)
+        std::shared_ptr<const ExecutionPlan> plan; // topology snapshot of the run
+        std::shared_ptr<RunContext> run;           // state of the run the task belongs to
+        // Execution trace stamps (microseconds on the run's trace clock); unset without a trace
+        qint64           queuedAtUs {-1};
+        qint64           startedAtUs {-1};
+        quintptr         threadTag {0};
+        // Queue stamp on the run usage collector's clock; unset without one
+        qint64           usageQueuedAtUs {-1};
+        // Start on the run recording's clock; unset unless the run is recorded
+        qint64           recordedStartUs {-1};
+        // Process RSS when the execution started; unset unless sampled
+        qint64           rssBeforeBytes {-1};
+        bool             remote {false}; // runs on a RemoteWorkerPool worker
+        // Speculative task: runs under the speculation's token and only records its
+        // outputs there. A real task carrying a speculation adopts its outputs instead
+        // of executing when it finished.
+        std::shared_ptr<Speculation> speculation;
+        bool             speculative {false};
+        // Position in the node's output order when several executions of an ordered
+        // node may be in flight; -1 when outputs are released as they finish
+        qint64           sequence {-1};
+        // Which try this is, counting from 1; retries of transient failures add one
+        int              attempt {1};
     };
 
-    // Global Data Lake: for each node UUID we store a QVariantMap of its
-    // successfully produced outputs, keyed by pin name
-    QHash<QUuid, QVariantMap> m_dataLake;
+    // A finished task whose outputs wait in its node's reorder buffer
+    struct CompletedTask {
+        ExecutionTask task;
+        TokenList outputs;
+        QString failure;
+        bool forceExecution {false};
+    };
 
-    // For deduplicating repeated executions with identical inputs (e.g., when
-    // multiple upstream pins trigger separately but resolve to the same full
-    // input set). Keyed by target node UUID.
-    QHash<QUuid, QByteArray> m_lastInputSignature;
+    // Reorder buffer of one ordered node: completions are committed in sequence order,
+    // by whichever finishing task finds the next one ready
+    struct OutputOrder {
+        qint64 issued {0};
+        qint64 released {0};
+        bool draining {false};
+        QMap<qint64, CompletedTask> finished;
+    };
+
+    // A fused successor handed to the worker that finished its producer (see
+    // ExecutionPlan::Node::fusedSuccessor), already counted as launched
+    struct FusedTask {
+        ExecutionTask task;
+        QString outputDir;
+        std::function<void()> done;
+    };
+
+    // Hand-off point of the worker running a chain. It takes a task only while the
+    // worker's own task schedules its fused successor in the same run.
+    struct FusionSlot {
+        const RunContext* run {nullptr};
+        int sourceIndex {-1};
+        int targetIndex {-1};
+        std::optional<FusedTask> next;
+    };
+    static thread_local FusionSlot* s_fusionSlot;
+
+    // A node started behind a control-flow node that has not decided yet (see
+    // IToolNode::speculativeOutputs()). The decision commits it when the real task has
+    // the same target and inputs, and cancels it otherwise.
+    struct Speculation {
+        int originIndex {-1};
+        int targetIndex {-1};
+        QByteArray signature;
+        CancellationToken cancellation;
+        QMutex mutex;
+        bool adopted {false}; // guarded by the run's speculationMutex
+        bool finished {false};
+        TokenList outputs;
+        QString failure;
+    };
 
     // Simple task queue mutex used for counters and guarding concurrent scheduling
     mutable QMutex       m_queueMutex;
-    int                  m_activeTasks {0};
-    bool                 m_finalized {false};
-
-    // Protects access to the data lake (readers/writers)
-    mutable QReadWriteLock m_dataLock;
 
     NodeGraphModel* _graphModel {nullptr};
 
     int m_executionDelay = 0;
 
-    // Hard error flag to stop further scheduling when a node reports an error
-    bool m_hardError = false;
+    // Work-stealing mode state ------------------------------------------------
+
+    // Per-node mailbox: keeps up to the node's maxConcurrency tasks in flight and
+    // parks the rest
+    struct NodeMailbox {
+        QMutex mutex;
+        int inFlight {0};
+        int runCounter {0};
+        QByteArray lastSignature; // dedup signature of the last scheduled input set
+        QMap<int, QQueue<ExecutionTask>> pending; // keyed by priority
+    };
+
+    // Mailboxes for one run, indexed like the run's ExecutionPlan
+    struct RunMailboxes {
+        int size {0};
+        std::unique_ptr<NodeMailbox[]> boxes;
+        std::atomic<int> pending {0}; // scheduled but not yet started (incl. parked)
+    };
+
+    SchedulerMode m_schedulerMode {SchedulerMode::GlobalQueue};
+
+    // Backpressure ---------------------------------------------------------------
+
+    static constexpr int kDefaultInputQueueCapacity = 256;
+    // How often a producer waiting in PartialOutputSink::awaitCapacity() rechecks the run
+    static constexpr int kCapacityPollMs = 50;
+
+    // The not yet scheduled part of one completion's fan-out. Expansion stops at the
+    // first target whose input queue is full, parks here, and continues from the same
+    // token and edge once a task of that target finishes.
+    struct TokenExpansion {
+        int sourceIndex {-1};
+        QtNodes::NodeId nodeId {0};
+        QUuid nodeUuid;
+        TokenList tokens;
+        TokenList::const_iterator token;
+        int edgePos {0};
+        QUuid triggerTokenId;
+        int blockedOn {-1};
+    };
+
+    int m_inputQueueCapacity {kDefaultInputQueueCapacity};
+
+    // Per-run state ------------------------------------------------------------
+
+    // Everything that belongs to a single run. The foreground run (runPipeline) drives
+    // the UI signals; independent runs only report through runFinished().
+    struct RunContext {
+        QUuid id;
+        // Serial behind the run's token ids (ExecIds::tokenUuid())
+        std::atomic<quint64> tokenSerial {0};
+        bool foreground {true};
+        TaskPriority priority {TaskPriority::Normal};
+        // Level of the Cpu pool its tasks and their nested CpuWorkerPool work run on
+        ThreadQos::Level qos {ThreadQos::Level::UserInitiated};
+        // Topology compiled once per run; workers read this instead of the graph model
+        std::shared_ptr<const ExecutionPlan> plan;
+
+        // Set by stop() or when a newer foreground run replaces this one; work of a
+        // cancelled run is abandoned at the next guard
+        std::atomic<bool> cancelled {false};
+        // Current token of the run's node executions, so nodes and backends stop too;
+        // it carries the run's deadline and slack
+        CancellationToken cancellation {CancellationToken::create()};
+        std::atomic<bool> finalized {false};
+        // Stops further scheduling once a node reported an error
+        std::atomic<bool> hardError {false};
+        std::atomic<int> activeTasks {0};
+        std::atomic<int> queuedTasks {0}; // entries in m_readyQueue
+        // Quiescence: tasks scheduled and not yet done or dropped, plus one held while the
+        // run is seeded. Whoever brings it to zero finalizes the run (releaseWork()).
+        std::atomic<int> outstanding {1};
+
+        // For each node UUID the merged outputs it produced, keyed by pin name; bounded
+        // by the engine's data lake budget
+        std::shared_ptr<DataLake> lake;
+
+        // Guarded by the engine's m_queueMutex ------------------------------------
+        // Dedup signatures of the last scheduled input set, keyed by target node UUID
+        QHash<QUuid, QByteArray> lastInputSignature;
+        // Executions in flight per nodeUuid, at most the plan node's maxConcurrency
+        QHash<QUuid, int> nodeInFlight;
+        QMap<QString, int> nodeRunCounters;
+
+        // Non-null only for a work-stealing foreground run
+        std::shared_ptr<RunMailboxes> mailboxes;
+        // Result cache for nodes that report IToolNode::isCacheable(); null when disabled
+        std::shared_ptr<const ResultCache> resultCache;
+        // Made current while nodes execute, for Iterator Scope's opt-in item cache: the
+        // result cache when enabled, otherwise one in the same default directory
+        std::shared_ptr<const ResultCache> itemCache;
+        // Independent runs: outputs used instead of executing these nodes
+        QHash<QUuid, QVariantMap> presetOutputs;
+        // Span recorder; null unless tracing is enabled
+        std::shared_ptr<ExecutionTrace> trace;
+        // Executions recorded for replay; null unless recording is enabled
+        std::shared_ptr<RunRecording> recording;
+        // Periodic on-disk progress; null unless checkpoints are enabled or the run resumes
+        std::shared_ptr<RunCheckpoint> checkpoint;
+        // Checkpointed executions the run's nodes are answered from when they match
+        std::shared_ptr<const RunRecording> resume;
+        // Provider usage of the run's executions; null for independent runs and when
+        // usage reports are disabled
+        std::shared_ptr<RunUsageCollector> usage;
+        // Keys of the run in the run history; empty unless it is recorded there
+        QString historyGraphHash;
+        QString historyConfigHash;
+        // Recording the run's nodes are answered from, instead of executing them
+        std::shared_ptr<const RunRecording> replay;
+        double replayLatencyScale {1.0};
+        // OpenTelemetry span of the whole run, parent of its node spans; records
+        // nothing unless an OTLP endpoint is configured. Ended when the run finalizes
+        // or is cancelled.
+        Tracer::Span span;
+
+        // Tasks scheduled but not finished, indexed like the plan
+        std::unique_ptr<std::atomic<int>[]> inputDepth;
+        int inputQueueCapacity {0};
+        // Parked fan-outs, oldest first; a task's finish and a producer's decision to
+        // park are serialized by expansionMutex so no wake-up is lost
+        QMutex expansionMutex;
+        QList<std::shared_ptr<TokenExpansion>> parkedExpansions;
+        // Woken whenever a parked fan-out resumes; producers in awaitCapacity() wait here
+        QWaitCondition expansionResumed;
+
+        // Speculations waiting for their origin's decision
+        QMutex speculationMutex;
+        QList<std::shared_ptr<Speculation>> speculations;
+
+        // Reorder buffers of ordered nodes running several executions, by plan index
+        QMutex orderMutex;
+        QHash<int, OutputOrder> outputOrders;
+
+        void cancel()
+        {
+            cancelled = true;
+            cancellation.cancel();
+            {
+                QMutexLocker locker(&speculationMutex);
+                for (const auto& speculation : speculations) speculation->cancellation.cancel();
+            }
+            span.setAttribute(QStringLiteral("cp.run.cancelled"), true);
+            span.end();
+        }
+    };
+
+    std::shared_ptr<RunContext> m_run; // foreground run; use atomic_load/atomic_store
+    QHash<QUuid, std::shared_ptr<RunContext>> m_independentRuns; // guarded by m_queueMutex
+
+    std::shared_ptr<RunContext> createRun(bool foreground, TaskPriority p = TaskPriority::Normal,
+                                          QDeadlineTimer deadline = QDeadlineTimer(QDeadlineTimer::Forever));
+    // Monotonic milliseconds by which a task of the run queued now should start
+    static qint64 taskDueMs(const RunContext& run, TaskPriority p);
+
+    // Nodes without IToolNode::supportsConcurrentRuns() execute for one run at a time.
+    // Gates are keyed by node instance and only contend when several runs are active.
+    QHash<const IToolNode*, std::shared_ptr<QSemaphore>> m_nodeGates; // guarded by m_queueMutex
+    std::shared_ptr<QSemaphore> nodeGate(const IToolNode* node);
+
+    // Guards asynchronous continuations against an engine destroyed mid-flight
+    struct LifetimeGuard {
+        QReadWriteLock lock;
+        bool alive {true};
+    };
+    std::shared_ptr<LifetimeGuard> m_lifetime {std::make_shared<LifetimeGuard>()};
+
+    // Coalesced output notifications ------------------------------------------
+
+    // Per-run dirty marks indexed like the run's ExecutionPlan. Workers set a mark
+    // with a single atomic exchange; the frame timer drains them on the engine thread.
+    struct OutputMailbox {
+        QUuid runId;
+        std::shared_ptr<const ExecutionPlan> plan;
+        int size {0};
+        std::unique_ptr<std::atomic<bool>[]> dirty;
+        std::atomic<bool> anyDirty {false};
+    };
+
+    static constexpr int kOutputFlushIntervalMs = 16;
+
+    OutputNotificationMode m_outputMode {OutputNotificationMode::Synchronous};
+    std::shared_ptr<OutputMailbox> m_outputMailbox;
+    QTimer* m_outputFlushTimer {nullptr};
+
+    void notifyNodeOutputChanged(const std::shared_ptr<RunContext>& run, QtNodes::NodeId nodeId, int nodeIndex);
+
+    // Log channel ------------------------------------------------------------
+
+    // Messages are buffered and delivered as nodeLog in batches on the engine thread,
+    // one queued drain per batch rather than one queued signal per line. When the
+    // buffer is full the oldest lines are dropped and a summary line is logged.
+    static constexpr int kLogChannelCapacity = 4096;
+
+    std::atomic<int> m_logVerbosity {static_cast<int>(LogVerbosity::Full)};
+    QMutex m_logMutex;
+    QQueue<QString> m_logChannel;
+    int m_droppedLogLines {0};
+    bool m_logDrainScheduled {false};
+
+    bool logEnabled(LogVerbosity level) const
+    {
+        return m_logVerbosity.load(std::memory_order_relaxed) >= static_cast<int>(level);
+    }
+    void postLog(const QString& message);
 
     // Internal helpers for the token-based scheduler
     // deprecated internal; replaced by the public runPipeline overload above
 
     // Dispatch helpers
-    void scheduleNode(const ExecutionTask& task, TaskPriority p = TaskPriority::Normal);
-    void launchTask(const ExecutionTask& task);
+    // Tasks are handed down the scheduling path by value and moved at each step
+    void scheduleNode(ExecutionTask task, TaskPriority p = TaskPriority::Normal);
+    // Hands a counted task to the run's scheduler: its mailboxes or the ready queue
+    void enqueueTask(ExecutionTask task);
+    // Queues the task's next attempt for delayMs from now, still counted as outstanding
+    void deferRetry(ExecutionTask task, int delayMs);
+    void armRetryTimer();
+    void launchTask(ExecutionTask task);
+    // Runs the task, then on the same worker each fused successor it hands over
+    void executeChain(ExecutionTask task, QString outputDir, std::function<void()> done);
+    // The current worker's slot when it accepts this task as the next link of its chain
+    FusionSlot* fusionSlotFor(const ExecutionTask& task) const;
+    // Runs the node and then calls done() exactly once: inline for synchronous nodes, or
+    // from the future's continuation for nodes with supportsAsyncExecution()
+    void executeTask(ExecutionTask task, const QString& outputDir, const std::function<void()>& done);
+    void finishTask(const ExecutionTask& task, TokenList outputTokens, const QString& failure, bool forceExecution);
+    // Merges a finished task's outputs, schedules its successors and retires it
+    void commitTask(const ExecutionTask& task, TokenList outputTokens, const QString& failure, bool forceExecution);
+    void completeTask(const ExecutionTask& task);
+    void scheduleStealing(const std::shared_ptr<RunMailboxes>& mailboxes, ExecutionTask task);
+    void dispatchStealing(const std::shared_ptr<RunMailboxes>& mailboxes, ExecutionTask task);
+    void releaseMailbox(const std::shared_ptr<RunMailboxes>& mailboxes, int nodeIndex);
+    // Completion of a mailbox task: frees its slot and finalizes the run when idle
+    std::function<void()> mailboxDone(const std::shared_ptr<RunMailboxes>& mailboxes,
+                                      const std::shared_ptr<RunContext>& run, int nodeIndex);
     void processNext();
-    void tryFinalize();
-    void handleTaskCompleted(QtNodes::NodeId nodeId,
+    // Drops queued tasks of cancelled or failed runs; returns how many remain. Each
+    // dropped task's run is appended to dropped, for releaseWork() once the lock is
+    // released. m_queueMutex must be held.
+    int pruneQueue(QList<std::shared_ptr<RunContext>>& dropped);
+    // One of the run's tasks is done or dropped; the last one finalizes the run, which
+    // emits the run-finished signals. m_queueMutex must not be held.
+    void releaseWork(const std::shared_ptr<RunContext>& run, int count = 1);
+    void finalizeRun(const std::shared_ptr<RunContext>& run);
+    void handleTaskCompleted(const std::shared_ptr<RunContext>& run,
+                             QtNodes::NodeId nodeId,
                              const QUuid& nodeUuid,
-                             const TokenList& outputTokens,
-                             const QUuid& runId);
-    bool isSourceNode(QtNodes::NodeId nodeId) const;
+                             const TokenList& outputTokens);
+    // Schedules the expansion's remaining snapshots. Returns the index of the target it
+    // parked on, or -1 once it is done or the run stopped.
+    int expandTokens(const std::shared_ptr<RunContext>& run, const std::shared_ptr<TokenExpansion>& expansion,
+                     bool resumed);
+    void resumeExpansions(const std::shared_ptr<RunContext>& run, int targetIndex);
+    // Input payload for the edge's target: value on the edge's pin, the lake's latest
+    // values on the others
+    static QVariantMap snapshotInputs(const RunContext& run, const ExecutionPlan::Edge& edge, const QVariant& value);
+    // Starts the branches behind a control-flow node that is not ready yet
+    void speculate(const std::shared_ptr<RunContext>& run, int originIndex, const QVariantMap& originInputs);
+    // Takes the origin's speculation matching a real task, if any
+    std::shared_ptr<Speculation> adoptSpeculation(RunContext& run, int originIndex, int targetIndex,
+                                                  const QByteArray& signature);
+    // Cancels the origin's speculations that its decision did not adopt
+    void discardSpeculations(RunContext& run, int originIndex);
+    // Bookkeeping once a task's outputs were merged and its successors scheduled
+    void retireTask(const ExecutionTask& task);
+    bool isSourceNode(const ExecutionTask& task) const;
+    static ResourceClass resourceClassOf(const ExecutionTask& task);
+    static int concurrencyOf(const ExecutionTask& task);
+    // Cpu work has one pool per ThreadQos level, each sized to the Cpu budget; the
+    // other classes mostly wait and keep a single interactive pool
+    QThreadPool* poolFor(ResourceClass resourceClass, ThreadQos::Level qos = ThreadQos::Level::UserInitiated);
 
 signals:
     // Global execution lifecycle
@@ -145,34 +652,115 @@ signals:
 
 private slots:
     void onThrottleTimeout();
-    void onFinalizeTimeout();
+    void onRetryTimeout();
+    void flushOutputNotifications();
+    void drainLogs();
 
 private:
     friend class ExecutionEngineSignatureFriend; // test helper
 
-    // Run identity used to guard against zombie threads from previous runs
-    QUuid m_currentRunId;
-
-    // Dispatcher: priority-bucketed queue
-    QMap<int, QList<ExecutionTask>> m_priorityQueue;
+    // Dispatcher: queue shared by all runs, keyed by due time, FIFO within a key
+    QMap<qint64, QList<ExecutionTask>> m_readyQueue;
     QTimer* m_throttler {nullptr};
-    QThreadPool m_threadPool;
+    // Retries waiting out their backoff, keyed by the monotonic ms they may start at.
+    // One single-shot timer is armed for the earliest. Guarded by m_queueMutex.
+    QMap<qint64, QList<ExecutionTask>> m_delayedTasks;
+    QTimer* m_retryTimer {nullptr};
+    QThreadPool m_threadPool; // ResourceClass::Cpu, also drives the work-stealing scheduler
+    QThreadPool m_utilityPool;    // ResourceClass::Cpu of Utility runs
+    QThreadPool m_backgroundPool; // ResourceClass::Cpu of Background runs
+    QThreadPool m_networkPool;
+    QThreadPool m_processPool;
+    QThreadPool m_guiPool;
+    std::unique_ptr<WorkStealingScheduler> m_scheduler;
+
+    // Each pool is sized to its class budget. The global queue also caps in-flight tasks
+    // per class (counting asynchronous nodes until their future finishes); work-stealing
+    // runs rely on the pool sizes alone. Guarded by m_queueMutex.
+    ResourceBudgets m_budgets;
+    std::array<int, kResourceClassCount> m_activeByClass {};
+    // Remote tasks in flight, capped by m_remoteWorkers->capacity(). Guarded by m_queueMutex.
+    std::shared_ptr<RemoteWorkerPool> m_remoteWorkers;
+    int m_remoteActive {0};
+    bool runsRemotely(const ExecutionTask& task) const;
+
+    // Slow motion only: when the last task started, so the finish is held back by one
+    // delay like every other step
+    std::atomic<qint64> m_lastActivityMs {0};
 
-    // Per-node serialization to preserve in-order execution for the same target
-    QHash<QUuid, int> m_nodeInFlight; // 0 or 1 per nodeUuid
+    QString m_projectName = QStringLiteral("Untitled");
 
-    // Finalization delay to satisfy slow-motion elapsed timing semantics
-    QTimer* m_finalizeTimer {nullptr};
-    qint64  m_lastActivityMs {0};
+    // What a run started from, kept for incremental re-runs once it succeeds
+    struct RunSnapshot {
+        bool valid {false};
+        QHash<QUuid, QByteArray> configSignatures;  // node type + saveState()
+        QHash<QUuid, QVector<QUuid>> incoming;      // sorted incoming connection UUIDs
+        std::shared_ptr<const DataLake> dataLake;
+    };
 
-    QString m_projectName = QStringLiteral("Untitled");
-    QMap<QString, int> m_nodeRunCounters;
+    QMutex m_snapshotMutex;
+    RunSnapshot m_pendingSnapshot;    // current run, dataLake filled at success
+    RunSnapshot m_lastSuccessfulRun;
 
+    // Marks the nodes an incremental run must execute; empty when no snapshot exists
+    static QVector<bool> computeDirtyCone(const ExecutionPlan& plan, const RunSnapshot& previous,
+                                          const RunSnapshot& current, const QSet<QUuid>& forced);
+    void seedDirtyCone(const std::shared_ptr<RunContext>& run, const QVector<bool>& inCone, TaskPriority p);
+
+    QString getProjectOutputDir() const;
     QString getNodeOutputDir(const QString& nodeId, int runIndex) const;
 
+    bool m_resultCacheEnabled {false};
+    QString m_resultCacheDir;
+    qint64 m_resultCacheMaxBytes {0};
+    // Kept across runs so the directory is measured once, not on every run's first store
+    std::shared_ptr<const ResultCache> m_resultCache;
+
+    qint64 m_dataLakeBudget {DataLake::kDefaultMemoryBudget};
+
+    bool m_traceEnabled {false};
+    QString m_traceDir;
+    bool m_traceResidentMemory {false};
+    bool m_threadQosEnabled {true};
+    // Writes the run's trace off the calling thread, then analyses foreground runs;
+    // m_queueMutex may be held
+    void writeTrace(const std::shared_ptr<RunContext>& run);
+
+    bool m_usageReportEnabled {true};
+    QString m_usageReportDir;
+    std::shared_ptr<RunHistory> m_runHistory;
+    // Emits runUsageReady(), then writes the JSON report and the run history entry off
+    // the calling thread
+    void reportUsage(const std::shared_ptr<RunContext>& run, bool succeeded);
+
+    bool m_recordingEnabled {false};
+    QString m_recordingDir;
+    std::shared_ptr<const RunRecording> m_replay;
+    double m_replayLatencyScale {1.0};
+    // Writes the run's recording on the calling thread, so it exists once the run
+    // reports that it finished
+    void writeRecording(const std::shared_ptr<RunContext>& run);
+    bool m_checkpointEnabled {false};
+    int m_checkpointIntervalSeconds {60};
+    QString m_checkpointDir;
+    // Set by resumePipeline() for the run it starts
+    bool m_resumeNextRun {false};
+    // Writes the checkpoint off the calling thread when its interval has passed
+    void saveCheckpoint(const std::shared_ptr<RunContext>& run);
+    // Answers the task from the run's replay recording and calls done()
+    void replayTask(const ExecutionTask& task, const std::shared_ptr<IToolNode>& node, bool forceExecution,
+                    const std::function<void()>& done);
+
     // Deduplication helper: produces a signature for a target node's input snapshot
     QByteArray computeInputSignature(const QVariantMap& inputPayload) const;
 
     // Helper to stringify QVariant for logging, truncating long strings and escaping newlines
     static QString truncateAndEscape(const QVariant& v);
+
+    // Tasks of every live run waiting to start, or running; read when metrics are exported
+    int queuedTaskCount() const;
+    int activeTaskCount() const;
+    // Sum over engines in cp_engine_queued_tasks and cp_engine_active_tasks
+    MetricsRegistry::CallbackHandle m_queuedTasksMetric;
+    MetricsRegistry::CallbackHandle m_activeTasksMetric;
 };
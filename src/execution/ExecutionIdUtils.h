@@ -56,4 +56,15 @@ inline QUuid connectionUuid(const QtNodes::ConnectionId& c)
     return connectionUuid(QStringLiteral("root"), c);
 }
 
+// Token ids of one run: the run id's first half with a per-run serial in place of
+// the rest. Unique across runs without reading the system's entropy per token.
+inline QUuid tokenUuid(const QUuid& runId, quint64 serial)
+{
+    return QUuid(runId.data1, runId.data2, runId.data3,
+                 static_cast<uchar>(serial >> 56), static_cast<uchar>(serial >> 48),
+                 static_cast<uchar>(serial >> 40), static_cast<uchar>(serial >> 32),
+                 static_cast<uchar>(serial >> 24), static_cast<uchar>(serial >> 16),
+                 static_cast<uchar>(serial >> 8), static_cast<uchar>(serial));
+}
+
 } // namespace ExecIds
@@ -0,0 +1,146 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "ExecutionPlan.h"
+
+#include <QSet>
+#include <QtNodes/DataFlowGraphModel>
+
+#include "ExecutionIdUtils.h"
+#include "NodeGraphModel.h"
+#include "ToolNodeDelegate.h"
+
+namespace {
+
+// Work short enough to run on the worker that produced its input: synchronous CPU
+// nodes with a single execution in flight, so no reorder buffer is involved
+bool runsInline(const ExecutionPlan::Node& entry)
+{
+    return entry.node && entry.resourceClass == ResourceClass::Cpu && entry.maxConcurrency == 1
+        && !entry.node->supportsAsyncExecution();
+}
+
+} // namespace
+
+std::shared_ptr<const ExecutionPlan> ExecutionPlan::compile(NodeGraphModel* graph)
+{
+    auto plan = std::make_shared<ExecutionPlan>();
+    if (!graph) {
+        return plan;
+    }
+
+    const QString scopeKey = graph->executionScopeKey();
+    const auto nodeIds = graph->allNodeIds();
+    plan->m_nodes.reserve(static_cast<int>(nodeIds.size()));
+
+    for (auto nodeId : nodeIds) {
+        Node entry;
+        entry.nodeId = nodeId;
+        entry.uuid = ExecIds::nodeUuid(scopeKey, nodeId);
+        if (auto* delegate = graph->delegateModel<ToolNodeDelegate>(nodeId)) {
+            entry.node = delegate->node();
+            entry.caption = delegate->description();
+            if (entry.caption.trimmed().isEmpty()) {
+                entry.caption = delegate->caption();
+            }
+            // The delegate's cached descriptor, so compiling a plan copies no pin maps
+            if (entry.node) {
+                const NodeDescriptor& descriptor = delegate->descriptor();
+                entry.typeId = descriptor.id;
+                entry.name = descriptor.name;
+                if (entry.node->isReentrant()) {
+                    entry.maxConcurrency = delegate->maxConcurrentExecutions();
+                }
+            }
+            entry.orderedOutputs = delegate->preservesOutputOrder();
+            entry.retry = delegate->retryPolicy();
+        }
+        if (entry.node) {
+            entry.resourceClass = entry.node->resourceClass();
+        }
+
+        const int index = plan->m_nodes.size();
+        plan->m_indexById.insert(nodeId, index);
+        plan->m_indexByUuid.insert(entry.uuid, index);
+        plan->m_nodes.push_back(std::move(entry));
+    }
+
+    // Pin ids are interned: every edge naming a pin shares one string, so the payload
+    // keys built from them during a run are reference-counted copies
+    QSet<PinId> pinIds;
+    auto intern = [&pinIds](const PinId& pinId) {
+        const auto it = pinIds.constFind(pinId);
+        return it != pinIds.cend() ? *it : *pinIds.insert(pinId);
+    };
+
+    for (int index = 0; index < plan->m_nodes.size(); ++index) {
+        Node& entry = plan->m_nodes[index];
+        const auto attached = graph->allConnectionIds(entry.nodeId);
+        for (const auto& cid : attached) {
+            if (cid.inNodeId == entry.nodeId) {
+                entry.hasIncoming = true;
+                entry.incomingConnectionUuids.push_back(ExecIds::connectionUuid(scopeKey, cid));
+            }
+            if (cid.outNodeId != entry.nodeId) {
+                continue;
+            }
+            entry.hasOutgoing = true;
+
+            // Each edge is recorded once, from its source side
+            auto* srcDel = graph->delegateModel<ToolNodeDelegate>(cid.outNodeId);
+            auto* dstDel = graph->delegateModel<ToolNodeDelegate>(cid.inNodeId);
+            if (!srcDel || !dstDel) continue;
+            const int targetIndex = plan->m_indexById.value(cid.inNodeId, -1);
+            if (targetIndex < 0) continue;
+
+            Edge edge;
+            edge.sourceIndex = index;
+            edge.targetIndex = targetIndex;
+            edge.sourcePinId = intern(srcDel->pinIdForIndex(QtNodes::PortType::Out, cid.outPortIndex));
+            edge.targetPinId = intern(dstDel->pinIdForIndex(QtNodes::PortType::In, cid.inPortIndex));
+            if (edge.sourcePinId.isEmpty() || edge.targetPinId.isEmpty()) continue;
+            edge.connectionId = cid;
+            edge.connectionUuid = ExecIds::connectionUuid(scopeKey, cid);
+
+            const int edgeIndex = plan->m_edges.size();
+            plan->m_edges.push_back(std::move(edge));
+            entry.outEdges.push_back(edgeIndex);
+            plan->m_nodes[targetIndex].inEdges.push_back(edgeIndex);
+        }
+    }
+
+    // Single-producer/single-consumer links between inline nodes form fused chains
+    for (Node& entry : plan->m_nodes) {
+        if (entry.outEdges.size() != 1 || !runsInline(entry)) continue;
+        const int targetIndex = plan->m_edges.at(entry.outEdges.front()).targetIndex;
+        const Node& target = plan->m_nodes.at(targetIndex);
+        if (&target == &entry || target.inEdges.size() != 1 || target.incomingConnectionUuids.size() != 1
+            || !runsInline(target)) {
+            continue;
+        }
+        entry.fusedSuccessor = targetIndex;
+    }
+
+    return plan;
+}
@@ -0,0 +1,102 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QUuid>
+#include <QVector>
+
+#include <memory>
+
+#include <QtNodes/internal/Definitions.hpp>
+
+#include "IToolNode.h"
+#include "RetryPolicy.h"
+
+class NodeGraphModel;
+
+// Immutable, index-based snapshot of a graph's topology. The engine compiles one
+// at the start of each run so worker threads can resolve nodes, pins, UUIDs and
+// edges without querying NodeGraphModel while the run is in flight.
+class ExecutionPlan {
+public:
+    struct Edge {
+        int sourceIndex {-1};
+        int targetIndex {-1};
+        PinId sourcePinId;
+        PinId targetPinId;
+        QtNodes::ConnectionId connectionId {};
+        QUuid connectionUuid;
+    };
+
+    struct Node {
+        QtNodes::NodeId nodeId {0};
+        QUuid uuid;
+        std::shared_ptr<IToolNode> node;
+        QString typeId;  // descriptor id, e.g. "prompt-builder"
+        QString name;    // descriptor name, e.g. "Prompt Builder"
+        QString caption; // user description, falling back to the delegate caption
+        ResourceClass resourceClass {ResourceClass::Cpu};
+        // Executions a run may have in flight for the node: the delegate's setting for
+        // reentrant nodes, 1 otherwise. Ordered nodes release outputs in input order.
+        int maxConcurrency {1};
+        bool orderedOutputs {true};
+        // Engine retries of transient failures (see RetryPolicy), from the delegate
+        RetryPolicy retry;
+        // Chain fusion: the node's only consumer, when both are synchronous CPU nodes run
+        // one execution at a time and nothing else feeds the consumer. The worker that
+        // finishes this node runs that successor next instead of queueing it. -1 otherwise.
+        int fusedSuccessor {-1};
+
+        // Indices into ExecutionPlan::edges for edges with resolvable pins
+        QVector<int> outEdges;
+        QVector<int> inEdges;
+
+        // UUIDs of every inbound connection, used for status highlighting
+        QVector<QUuid> incomingConnectionUuids;
+
+        // Raw connectivity (independent of pin resolution)
+        bool hasIncoming {false};
+        bool hasOutgoing {false};
+    };
+
+    static std::shared_ptr<const ExecutionPlan> compile(NodeGraphModel* graph);
+
+    const QVector<Node>& nodes() const { return m_nodes; }
+    const QVector<Edge>& edges() const { return m_edges; }
+
+    const Node& node(int index) const { return m_nodes.at(index); }
+    const Edge& edge(int index) const { return m_edges.at(index); }
+
+    // Returns -1 when the node is not part of the plan
+    int indexOf(QtNodes::NodeId nodeId) const { return m_indexById.value(nodeId, -1); }
+    int indexOf(const QUuid& nodeUuid) const { return m_indexByUuid.value(nodeUuid, -1); }
+
+private:
+    QVector<Node> m_nodes;
+    QVector<Edge> m_edges;
+    QHash<QtNodes::NodeId, int> m_indexById;
+    QHash<QUuid, int> m_indexByUuid;
+};
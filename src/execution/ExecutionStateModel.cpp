@@ -1,4 +1,79 @@
 #include "ExecutionStateModel.h"
 
-// Ensure a translation unit exists so Qt's AUTOMOC processes the Q_OBJECT
-// All methods are currently defined inline in the header.
+#include <QThread>
+
+ExecutionStateModel::ExecutionStateModel(QObject* parent)
+    : QObject(parent)
+{
+    flushTimer_.setSingleShot(true);
+    flushTimer_.setInterval(kFlushIntervalMs);
+    connect(&flushTimer_, &QTimer::timeout, this, &ExecutionStateModel::flush);
+}
+
+void ExecutionStateModel::setState_(const QUuid& id, ExecutionState s)
+{
+    bool schedule = false;
+    {
+        QMutexLocker lock(&mutex_);
+        auto it = states_.find(id);
+        if (it != states_.end() && it.value() == s) {
+            return;
+        }
+        states_.insert(id, s);
+        dirty_.insert(id);
+        if (!flushScheduled_ && batchDepth_ == 0) {
+            flushScheduled_ = true;
+            schedule = true;
+        }
+    }
+    if (schedule) {
+        scheduleFlush_();
+    }
+}
+
+void ExecutionStateModel::scheduleFlush_()
+{
+    if (QThread::currentThread() == thread()) {
+        flushTimer_.start();
+    } else {
+        QMetaObject::invokeMethod(&flushTimer_, qOverload<>(&QTimer::start), Qt::QueuedConnection);
+    }
+}
+
+void ExecutionStateModel::beginBatch()
+{
+    QMutexLocker lock(&mutex_);
+    ++batchDepth_;
+}
+
+void ExecutionStateModel::endBatch()
+{
+    bool schedule = false;
+    {
+        QMutexLocker lock(&mutex_);
+        if (--batchDepth_ == 0 && !dirty_.isEmpty() && !flushScheduled_) {
+            flushScheduled_ = true;
+            schedule = true;
+        }
+    }
+    if (schedule) {
+        scheduleFlush_();
+    }
+}
+
+void ExecutionStateModel::flush()
+{
+    QList<QUuid> ids;
+    {
+        QMutexLocker lock(&mutex_);
+        flushScheduled_ = false;
+        if (batchDepth_ > 0 || dirty_.isEmpty()) {
+            return;
+        }
+        ids = dirty_.values();
+        dirty_.clear();
+    }
+    flushTimer_.stop();
+    ++flushCount_;
+    emit itemsChanged(ids);
+}
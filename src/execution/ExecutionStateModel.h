@@ -10,28 +10,65 @@
 #pragma once
 
 #include <QObject>
-#include <QMap>
+#include <QHash>
+#include <QList>
 #include <QSet>
+#include <QTimer>
 #include <QUuid>
 #include <QMutex>
 #include <QMutexLocker>
 
+#include <atomic>
+
 #include "ExecutionState.h"
 
+// Node and connection states are stored as they arrive, from any thread, but are
+// announced at most once per frame: itemsChanged() carries every id that changed
+// since the last flush, so the canvas repaints those items' rectangles once however
+// many Running/Finished pairs a loop produced in between. A Batch held around a
+// burst of changes defers the flush until it closes.
 class ExecutionStateModel : public QObject
 {
     Q_OBJECT
 public:
-    explicit ExecutionStateModel(QObject* parent = nullptr)
-        : QObject(parent) {}
+    static constexpr int kFlushIntervalMs = 16;
+
+    explicit ExecutionStateModel(QObject* parent = nullptr);
 
     ExecutionState stateFor(const QUuid& id) const {
         QMutexLocker lock(&mutex_);
         return states_.value(id, ExecutionState::Idle);
     }
 
+    // Nodes and connections on the last analysed run's critical path
+    bool isOnCriticalPath(const QUuid& id) const {
+        QMutexLocker lock(&mutex_);
+        return criticalPath_.contains(id);
+    }
+
+    // Defers flushing while alive; nests
+    class Batch {
+    public:
+        explicit Batch(ExecutionStateModel& model) : model_(model) { model_.beginBatch(); }
+        ~Batch() { model_.endBatch(); }
+        Batch(const Batch&) = delete;
+        Batch& operator=(const Batch&) = delete;
+
+    private:
+        ExecutionStateModel& model_;
+    };
+
+    void beginBatch();
+    void endBatch();
+
+    // Number of itemsChanged() flushes so far
+    quint64 flushCount() const { return flushCount_.load(); }
+
 signals:
+    // Whole-scene changes, such as a new critical path
     void stateChanged();
+    // Items whose state changed since the previous flush
+    void itemsChanged(const QList<QUuid>& ids);
 
 public slots:
     void onNodeStatusChanged(const QUuid& nodeId, int state) {
@@ -40,22 +77,31 @@ public slots:
     void onConnectionStatusChanged(const QUuid& connId, int state) {
         setState_(connId, static_cast<ExecutionState>(state));
     }
-
-private:
-    void setState_(const QUuid& id, ExecutionState s) {
-        bool changed = false;
+    void setCriticalPath(const QSet<QUuid>& ids) {
         {
             QMutexLocker lock(&mutex_);
-            auto it = states_.find(id);
-            if (it == states_.end() || it.value() != s) {
-                states_[id] = s;
-                changed = true;
-            }
+            if (criticalPath_ == ids) return;
+            criticalPath_ = ids;
         }
-        if (changed) emit stateChanged();
+        emit stateChanged();
     }
+    void clearCriticalPath() { setCriticalPath({}); }
+
+    // Announces pending changes now instead of on the next frame
+    void flush();
+
+private:
+    void setState_(const QUuid& id, ExecutionState s);
+    // Starts the frame timer on the model's thread; call with the mutex unlocked
+    void scheduleFlush_();
 
 private:
     mutable QMutex mutex_;
-    QMap<QUuid, ExecutionState> states_;
+    QHash<QUuid, ExecutionState> states_;
+    QSet<QUuid> criticalPath_;
+    QSet<QUuid> dirty_;
+    int batchDepth_ {0};
+    bool flushScheduled_ {false};
+    QTimer flushTimer_;
+    std::atomic<quint64> flushCount_ {0};
 };
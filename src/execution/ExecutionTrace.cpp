@@ -0,0 +1,328 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "ExecutionTrace.h"
+
+#include "BlobHandle.h"
+
+#include <QHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QSet>
+#include <QThread>
+
+#include <algorithm>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_MACOS)
+#include <mach/mach.h>
+#elif defined(Q_OS_LINUX)
+#include <unistd.h>
+#endif
+
+namespace {
+thread_local ExecutionTrace* t_currentTrace = nullptr;
+
+constexpr int kProcessId = 1;
+
+qint64 stringBytes(const QString& s)
+{
+    return s.size() * static_cast<qint64>(sizeof(QChar));
+}
+
+// Blobs already counted are in seenBlobs
+qint64 sizeOf(const QVariant& value, QSet<const void*>& seenBlobs)
+{
+    switch (value.typeId()) {
+    case QMetaType::UnknownType:
+        return 0;
+    case QMetaType::QString:
+        return stringBytes(value.toString());
+    case QMetaType::QByteArray:
+        return value.toByteArray().size();
+    case QMetaType::QStringList: {
+        qint64 total = 0;
+        for (const QString& s : value.toStringList()) total += stringBytes(s);
+        return total;
+    }
+    case QMetaType::QVariantList: {
+        qint64 total = 0;
+        for (const QVariant& v : value.toList()) total += sizeOf(v, seenBlobs);
+        return total;
+    }
+    case QMetaType::QVariantMap: {
+        qint64 total = 0;
+        const QVariantMap map = value.toMap();
+        for (auto it = map.cbegin(); it != map.cend(); ++it) {
+            total += stringBytes(it.key()) + sizeOf(it.value(), seenBlobs);
+        }
+        return total;
+    }
+    case QMetaType::QVariantHash: {
+        qint64 total = 0;
+        const QVariantHash hash = value.toHash();
+        for (auto it = hash.cbegin(); it != hash.cend(); ++it) {
+            total += stringBytes(it.key()) + sizeOf(it.value(), seenBlobs);
+        }
+        return total;
+    }
+    default:
+        if (value.metaType() == QMetaType::fromType<BlobHandle>()) {
+            const BlobHandle blob = value.value<BlobHandle>();
+            if (blob.isNull() || seenBlobs.contains(blob.identity())) return 0;
+            seenBlobs.insert(blob.identity());
+            return blob.size();
+        }
+        return value.metaType().sizeOf();
+    }
+}
+}
+
+ExecutionTrace::ExecutionTrace(const QUuid& runId)
+    : m_runId(runId)
+{
+    m_clock.start();
+}
+
+qint64 ExecutionTrace::nowUs() const
+{
+    return m_clock.nsecsElapsed() / 1000;
+}
+
+quintptr ExecutionTrace::currentThreadTag()
+{
+    return reinterpret_cast<quintptr>(QThread::currentThreadId());
+}
+
+void ExecutionTrace::record(Span span)
+{
+    QMutexLocker locker(&m_mutex);
+    m_spans.append(std::move(span));
+}
+
+QList<ExecutionTrace::Span> ExecutionTrace::spans() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_spans;
+}
+
+void ExecutionTrace::recordCounter(const QString& name, QList<std::pair<QString, qint64>> values)
+{
+    CounterSample sample;
+    sample.name = name;
+    sample.timeUs = nowUs();
+    sample.values = std::move(values);
+    QMutexLocker locker(&m_mutex);
+    m_counters.append(std::move(sample));
+}
+
+QList<ExecutionTrace::CounterSample> ExecutionTrace::counters() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_counters;
+}
+
+QByteArray ExecutionTrace::toChromeTraceJson() const
+{
+    QList<Span> sorted = spans();
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Span& a, const Span& b) {
+        return a.startUs < b.startUs;
+    });
+
+    const QString runId = m_runId.toString(QUuid::WithoutBraces);
+    QJsonArray events;
+    events.append(QJsonObject{
+        {QStringLiteral("ph"), QStringLiteral("M")},
+        {QStringLiteral("name"), QStringLiteral("process_name")},
+        {QStringLiteral("pid"), kProcessId},
+        {QStringLiteral("args"), QJsonObject{{QStringLiteral("name"), QStringLiteral("Run %1").arg(runId)}}},
+    });
+
+    // Viewers want small thread ids; number threads by first use
+    QHash<quintptr, int> threadIds;
+    int queueEventId = 0;
+    for (const Span& span : std::as_const(sorted)) {
+        auto tidIt = threadIds.constFind(span.threadId);
+        if (tidIt == threadIds.cend()) {
+            tidIt = threadIds.insert(span.threadId, threadIds.size() + 1);
+            events.append(QJsonObject{
+                {QStringLiteral("ph"), QStringLiteral("M")},
+                {QStringLiteral("name"), QStringLiteral("thread_name")},
+                {QStringLiteral("pid"), kProcessId},
+                {QStringLiteral("tid"), tidIt.value()},
+                {QStringLiteral("args"), QJsonObject{{QStringLiteral("name"), QStringLiteral("Worker %1").arg(tidIt.value())}}},
+            });
+        }
+
+        QJsonObject args{
+            {QStringLiteral("run_id"), runId},
+            {QStringLiteral("node_id"), span.nodeId},
+            {QStringLiteral("node_type"), span.nodeType},
+        };
+        if (span.inputBytes >= 0) args.insert(QStringLiteral("input_bytes"), span.inputBytes);
+        if (span.outputBytes >= 0) args.insert(QStringLiteral("output_bytes"), span.outputBytes);
+        if (span.rssBeforeBytes >= 0 && span.rssAfterBytes >= 0) {
+            args.insert(QStringLiteral("rss_before_bytes"), span.rssBeforeBytes);
+            args.insert(QStringLiteral("rss_delta_bytes"), span.rssAfterBytes - span.rssBeforeBytes);
+        }
+        if (span.queuedUs >= 0) {
+            args.insert(QStringLiteral("queued_at_us"), span.queuedUs);
+            args.insert(QStringLiteral("queue_wait_us"), std::max<qint64>(0, span.startUs - span.queuedUs));
+        }
+        if (span.failed) args.insert(QStringLiteral("failed"), true);
+
+        events.append(QJsonObject{
+            {QStringLiteral("ph"), QStringLiteral("X")},
+            {QStringLiteral("name"), span.name},
+            {QStringLiteral("cat"), span.category},
+            {QStringLiteral("pid"), kProcessId},
+            {QStringLiteral("tid"), tidIt.value()},
+            {QStringLiteral("ts"), span.startUs},
+            {QStringLiteral("dur"), std::max<qint64>(0, span.endUs - span.startUs)},
+            {QStringLiteral("args"), args},
+        });
+
+        // Time spent waiting for a worker or budget shows as an async slice
+        if (span.queuedUs >= 0 && span.startUs > span.queuedUs) {
+            const QJsonObject waitArgs{{QStringLiteral("node_id"), span.nodeId}};
+            ++queueEventId;
+            events.append(QJsonObject{
+                {QStringLiteral("ph"), QStringLiteral("b")},
+                {QStringLiteral("name"), span.name},
+                {QStringLiteral("cat"), QStringLiteral("queue")},
+                {QStringLiteral("id"), queueEventId},
+                {QStringLiteral("pid"), kProcessId},
+                {QStringLiteral("ts"), span.queuedUs},
+                {QStringLiteral("args"), waitArgs},
+            });
+            events.append(QJsonObject{
+                {QStringLiteral("ph"), QStringLiteral("e")},
+                {QStringLiteral("name"), span.name},
+                {QStringLiteral("cat"), QStringLiteral("queue")},
+                {QStringLiteral("id"), queueEventId},
+                {QStringLiteral("pid"), kProcessId},
+                {QStringLiteral("ts"), span.startUs},
+            });
+        }
+    }
+
+    for (const CounterSample& sample : counters()) {
+        QJsonObject args;
+        for (const auto& [series, value] : sample.values) args.insert(series, value);
+        events.append(QJsonObject{
+            {QStringLiteral("ph"), QStringLiteral("C")},
+            {QStringLiteral("name"), sample.name},
+            {QStringLiteral("pid"), kProcessId},
+            {QStringLiteral("ts"), sample.timeUs},
+            {QStringLiteral("args"), args},
+        });
+    }
+
+    const QJsonObject root{
+        {QStringLiteral("traceEvents"), events},
+        {QStringLiteral("displayTimeUnit"), QStringLiteral("ms")},
+    };
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+bool ExecutionTrace::writeChromeTrace(const QString& path, QString* error) const
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    file.write(toChromeTraceJson());
+    if (!file.commit()) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+qint64 ExecutionTrace::approximateSize(const QVariant& value)
+{
+    QSet<const void*> seenBlobs;
+    return sizeOf(value, seenBlobs);
+}
+
+qint64 ExecutionTrace::approximateSize(const TokenList& tokens)
+{
+    QSet<const void*> seenBlobs;
+    qint64 total = 0;
+    for (const auto& token : tokens) {
+        for (auto it = token.data.cbegin(); it != token.data.cend(); ++it) {
+            total += stringBytes(it.key()) + sizeOf(it.value(), seenBlobs);
+        }
+    }
+    return total;
+}
+
+qint64 ExecutionTrace::residentMemoryBytes()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<qint64>(counters.WorkingSetSize);
+    }
+    return -1;
+#elif defined(Q_OS_MACOS)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count)
+        == KERN_SUCCESS) {
+        return static_cast<qint64>(info.resident_size);
+    }
+    return -1;
+#elif defined(Q_OS_LINUX)
+    // Second field of statm: resident pages
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly)) return -1;
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    bool ok = false;
+    const qint64 pages = fields.size() > 1 ? fields.at(1).toLongLong(&ok) : 0;
+    return ok ? pages * static_cast<qint64>(sysconf(_SC_PAGESIZE)) : -1;
+#else
+    return -1;
+#endif
+}
+
+ExecutionTrace* ExecutionTrace::current()
+{
+    return t_currentTrace;
+}
+
+void ExecutionTrace::setCurrent(ExecutionTrace* trace)
+{
+    t_currentTrace = trace;
+}
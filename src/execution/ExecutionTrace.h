@@ -0,0 +1,106 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QUuid>
+#include <QVariant>
+
+#include <utility>
+
+#include "IToolNode.h"
+
+// Timeline of one pipeline run, exported in the Chrome Trace Event format that
+// chrome://tracing and Perfetto open directly.
+//
+// Times are microseconds since the trace was created. The engine records one span per
+// executed task; scope bodies add nested spans for their own nodes through current(),
+// which viewers stack under the scope node because they run on the same thread.
+// Counter samples, such as the data lake's footprint, are drawn as graphs above the
+// threads.
+class ExecutionTrace {
+public:
+    struct Span {
+        QString name;
+        QString category;
+        QString nodeId;
+        QString nodeType;
+        qint64 queuedUs {-1}; // -1 when the span was never queued (nested spans)
+        qint64 startUs {0};
+        qint64 endUs {0};
+        quintptr threadId {0};
+        qint64 inputBytes {-1};
+        qint64 outputBytes {-1};
+        // Process resident memory around the execution; -1 unless sampled. It is
+        // process-wide, so concurrent executions show in each other's deltas.
+        qint64 rssBeforeBytes {-1};
+        qint64 rssAfterBytes {-1};
+        bool failed {false};
+    };
+
+    struct CounterSample {
+        QString name;
+        qint64 timeUs {0};
+        QList<std::pair<QString, qint64>> values;
+    };
+
+    explicit ExecutionTrace(const QUuid& runId);
+
+    QUuid runId() const { return m_runId; }
+    qint64 nowUs() const;
+    static quintptr currentThreadTag();
+
+    // Thread-safe
+    void record(Span span);
+    QList<Span> spans() const;
+    void recordCounter(const QString& name, QList<std::pair<QString, qint64>> values);
+    QList<CounterSample> counters() const;
+
+    QByteArray toChromeTraceJson() const;
+    bool writeChromeTrace(const QString& path, QString* error = nullptr) const;
+
+    // Rough in-memory payload size, for the span's byte counts. Nested lists and maps
+    // are walked; a blob shared by several values or tokens is counted once.
+    static qint64 approximateSize(const QVariant& value);
+    static qint64 approximateSize(const TokenList& tokens);
+
+    // Resident set size of this process, or -1 where it can't be read
+    static qint64 residentMemoryBytes();
+
+    // The trace of the task executing on this thread, or null. Set by the engine around
+    // node execution so nested executors can add spans to the same timeline.
+    static ExecutionTrace* current();
+    static void setCurrent(ExecutionTrace* trace);
+
+private:
+    QUuid m_runId;
+    QElapsedTimer m_clock;
+    mutable QMutex m_mutex;
+    QList<Span> m_spans;
+    QList<CounterSample> m_counters;
+};
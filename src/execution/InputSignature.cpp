@@ -0,0 +1,504 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "InputSignature.h"
+
+#include "BlobHandle.h"
+
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QMutex>
+#include <QQueue>
+#include <QStringList>
+#include <QVariantHash>
+#include <QVariantList>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr quint64 kPrime1 = 11400714785074694791ULL;
+constexpr quint64 kPrime2 = 14029467366897019727ULL;
+constexpr quint64 kPrime3 = 1609587929392839161ULL;
+constexpr quint64 kPrime4 = 9650029242287828579ULL;
+constexpr quint64 kPrime5 = 2870177450012600261ULL;
+
+inline quint64 rotl(quint64 x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline quint64 read64(const uchar* p)
+{
+    return qFromLittleEndian<quint64>(p);
+}
+
+inline quint32 read32(const uchar* p)
+{
+    return qFromLittleEndian<quint32>(p);
+}
+
+inline quint64 round64(quint64 acc, quint64 input)
+{
+    acc += input * kPrime2;
+    acc = rotl(acc, 31);
+    return acc * kPrime1;
+}
+
+inline quint64 mergeRound(quint64 acc, quint64 val)
+{
+    acc ^= round64(0, val);
+    return acc * kPrime1 + kPrime4;
+}
+
+// Seed of the second XXH64 lane; any value other than the first lane's 0 works
+constexpr quint64 kSecondLaneSeed = 0x9E3779B97F4A7C15ULL;
+
+// Streaming XXH64. Fast, non-cryptographic; good enough to tell two byte
+// ranges apart.
+class Xxh64 {
+public:
+    explicit Xxh64(quint64 seed = 0)
+        : m_seed(seed)
+        , m_v1(seed + kPrime1 + kPrime2)
+        , m_v2(seed + kPrime2)
+        , m_v3(seed)
+        , m_v4(seed - kPrime1)
+    {
+    }
+
+    void update(const void* data, qsizetype length)
+    {
+        if (length <= 0) return;
+        const uchar* p = static_cast<const uchar*>(data);
+        const uchar* const end = p + length;
+        m_total += static_cast<quint64>(length);
+
+        if (m_bufferSize + length < 32) {
+            std::memcpy(m_buffer + m_bufferSize, p, static_cast<size_t>(length));
+            m_bufferSize += static_cast<int>(length);
+            return;
+        }
+
+        if (m_bufferSize > 0) {
+            const int fill = 32 - m_bufferSize;
+            std::memcpy(m_buffer + m_bufferSize, p, static_cast<size_t>(fill));
+            consumeStripe(m_buffer);
+            p += fill;
+            m_bufferSize = 0;
+        }
+
+        while (end - p >= 32) {
+            consumeStripe(p);
+            p += 32;
+        }
+
+        if (p < end) {
+            m_bufferSize = static_cast<int>(end - p);
+            std::memcpy(m_buffer, p, static_cast<size_t>(m_bufferSize));
+        }
+    }
+
+    quint64 digest() const
+    {
+        quint64 h;
+        if (m_total >= 32) {
+            h = rotl(m_v1, 1) + rotl(m_v2, 7) + rotl(m_v3, 12) + rotl(m_v4, 18);
+            h = mergeRound(h, m_v1);
+            h = mergeRound(h, m_v2);
+            h = mergeRound(h, m_v3);
+            h = mergeRound(h, m_v4);
+        } else {
+            h = m_seed + kPrime5;
+        }
+        h += m_total;
+
+        const uchar* p = m_buffer;
+        const uchar* const end = m_buffer + m_bufferSize;
+        while (end - p >= 8) {
+            h ^= round64(0, read64(p));
+            h = rotl(h, 27) * kPrime1 + kPrime4;
+            p += 8;
+        }
+        if (end - p >= 4) {
+            h ^= static_cast<quint64>(read32(p)) * kPrime1;
+            h = rotl(h, 23) * kPrime2 + kPrime3;
+            p += 4;
+        }
+        while (p < end) {
+            h ^= static_cast<quint64>(*p) * kPrime5;
+            h = rotl(h, 11) * kPrime1;
+            ++p;
+        }
+
+        h ^= h >> 33;
+        h *= kPrime2;
+        h ^= h >> 29;
+        h *= kPrime3;
+        h ^= h >> 32;
+        return h;
+    }
+
+private:
+    void consumeStripe(const uchar* p)
+    {
+        m_v1 = round64(m_v1, read64(p));
+        m_v2 = round64(m_v2, read64(p + 8));
+        m_v3 = round64(m_v3, read64(p + 16));
+        m_v4 = round64(m_v4, read64(p + 24));
+    }
+
+    quint64 m_seed;
+    quint64 m_v1;
+    quint64 m_v2;
+    quint64 m_v3;
+    quint64 m_v4;
+    quint64 m_total {0};
+    uchar m_buffer[32] {};
+    int m_bufferSize {0};
+};
+
+struct Digest {
+    quint64 first {0};
+    quint64 second {0};
+};
+
+// Two XXH64 lanes with different seeds over the same stream, for a 128-bit
+// digest: signatures key the persistent ResultCache, where 64 bits leave too
+// little margin against collisions across many stored entries.
+class Hasher {
+public:
+    Hasher()
+        : m_second(kSecondLaneSeed)
+    {
+    }
+
+    void update(const void* data, qsizetype length)
+    {
+        m_first.update(data, length);
+        m_second.update(data, length);
+    }
+
+    void addTag(char tag) { update(&tag, 1); }
+
+    void addU64(quint64 v)
+    {
+        uchar bytes[8];
+        qToLittleEndian(v, bytes);
+        update(bytes, 8);
+    }
+
+    void addDigest(const Digest& digest)
+    {
+        addU64(digest.first);
+        addU64(digest.second);
+    }
+
+    quint64 digest64() const { return m_first.digest(); }
+    Digest digest() const { return Digest{m_first.digest(), m_second.digest()}; }
+
+private:
+    Xxh64 m_first;
+    Xxh64 m_second;
+};
+
+quint64 hashBytes(const void* data, qsizetype length)
+{
+    Xxh64 h;
+    h.update(data, length);
+    return h.digest();
+}
+
+Digest digestBytes(const void* data, qsizetype length)
+{
+    Hasher h;
+    h.update(data, length);
+    return h.digest();
+}
+
+// Cache of standalone hashes for large buffers, keyed by the identity of Qt's
+// implicitly shared storage. Each entry holds a copy of the value, which keeps
+// the buffer alive and read-only (any writer detaches), so a matching pointer
+// and size always means the same bytes.
+class LargeValueCache {
+public:
+    Digest hashString(const QString& s)
+    {
+        return lookup(s.constData(), s.size() * static_cast<qsizetype>(sizeof(QChar)), QVariant(s));
+    }
+
+    Digest hashByteArray(const QByteArray& b)
+    {
+        return lookup(b.constData(), b.size(), QVariant(b));
+    }
+
+    void clear()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_entries.clear();
+        m_order.clear();
+    }
+
+private:
+    static constexpr int kMaxEntries = 64;
+
+    struct Key {
+        quintptr data;
+        qsizetype length;
+        bool operator==(const Key& other) const { return data == other.data && length == other.length; }
+    };
+
+    struct Entry {
+        QVariant keepAlive;
+        Digest digest;
+    };
+
+    friend size_t qHash(const Key& key, size_t seed) noexcept
+    {
+        return qHashMulti(seed, key.data, key.length);
+    }
+
+    Digest lookup(const void* data, qsizetype length, const QVariant& keepAlive)
+    {
+        const Key key{reinterpret_cast<quintptr>(data), length};
+        {
+            QMutexLocker locker(&m_mutex);
+            const auto it = m_entries.constFind(key);
+            if (it != m_entries.cend()) return it->digest;
+        }
+
+        // Hash outside the lock; two threads racing on the same value just
+        // compute the same answer twice.
+        const Digest digest = digestBytes(data, length);
+
+        QMutexLocker locker(&m_mutex);
+        if (!m_entries.contains(key)) {
+            while (m_order.size() >= kMaxEntries) {
+                m_entries.remove(m_order.dequeue());
+            }
+            m_entries.insert(key, Entry{keepAlive, digest});
+            m_order.enqueue(key);
+        }
+        return digest;
+    }
+
+    QMutex m_mutex;
+    QHash<Key, Entry> m_entries;
+    QQueue<Key> m_order;
+};
+
+LargeValueCache& largeValueCache()
+{
+    static LargeValueCache cache;
+    return cache;
+}
+
+void hashVariant(Hasher& h, const QVariant& value);
+
+void hashString(Hasher& h, const QString& s)
+{
+    const qsizetype bytes = s.size() * static_cast<qsizetype>(sizeof(QChar));
+    if (bytes >= InputSignature::kCacheThresholdBytes) {
+        h.addTag('s');
+        h.addU64(static_cast<quint64>(s.size()));
+        h.addDigest(largeValueCache().hashString(s));
+        return;
+    }
+    h.addTag('S');
+    h.addU64(static_cast<quint64>(s.size()));
+    h.update(s.constData(), bytes);
+}
+
+void hashByteArray(Hasher& h, const QByteArray& b)
+{
+    if (b.size() >= InputSignature::kCacheThresholdBytes) {
+        h.addTag('y');
+        h.addU64(static_cast<quint64>(b.size()));
+        h.addDigest(largeValueCache().hashByteArray(b));
+        return;
+    }
+    h.addTag('Y');
+    h.addU64(static_cast<quint64>(b.size()));
+    h.update(b.constData(), b.size());
+}
+
+void hashMap(Hasher& h, const QVariantMap& map)
+{
+    // QMap iterates in key order, so equal maps always hash the same
+    h.addTag('M');
+    h.addU64(static_cast<quint64>(map.size()));
+    for (auto it = map.cbegin(); it != map.cend(); ++it) {
+        hashString(h, it.key());
+        hashVariant(h, it.value());
+    }
+}
+
+void hashHash(Hasher& h, const QVariantHash& hash)
+{
+    QStringList keys = hash.keys();
+    std::sort(keys.begin(), keys.end());
+    h.addTag('M');
+    h.addU64(static_cast<quint64>(keys.size()));
+    for (const QString& key : keys) {
+        hashString(h, key);
+        hashVariant(h, hash.value(key));
+    }
+}
+
+void hashList(Hasher& h, const QVariantList& list)
+{
+    h.addTag('L');
+    h.addU64(static_cast<quint64>(list.size()));
+    for (const QVariant& item : list) {
+        hashVariant(h, item);
+    }
+}
+
+void hashStringList(Hasher& h, const QStringList& list)
+{
+    h.addTag('L');
+    h.addU64(static_cast<quint64>(list.size()));
+    for (const QString& item : list) {
+        hashString(h, item);
+    }
+}
+
+void hashVariant(Hasher& h, const QVariant& value)
+{
+    if (!value.isValid() || value.isNull()) {
+        h.addTag('N');
+        return;
+    }
+
+    switch (value.typeId()) {
+    case QMetaType::QVariantMap:
+        hashMap(h, value.toMap());
+        return;
+    case QMetaType::QVariantHash:
+        hashHash(h, value.toHash());
+        return;
+    case QMetaType::QVariantList:
+        hashList(h, value.toList());
+        return;
+    case QMetaType::QStringList:
+        hashStringList(h, value.toStringList());
+        return;
+    case QMetaType::QString:
+        hashString(h, value.toString());
+        return;
+    case QMetaType::QByteArray:
+        hashByteArray(h, value.toByteArray());
+        return;
+    case QMetaType::Bool:
+        h.addTag(value.toBool() ? 'T' : 'F');
+        return;
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::Long:
+    case QMetaType::LongLong:
+    case QMetaType::Short:
+    case QMetaType::UShort:
+    case QMetaType::Char:
+    case QMetaType::SChar:
+    case QMetaType::UChar:
+        h.addTag('I');
+        h.addU64(static_cast<quint64>(value.toLongLong()));
+        return;
+    case QMetaType::ULong:
+    case QMetaType::ULongLong:
+        h.addTag('U');
+        h.addU64(value.toULongLong());
+        return;
+    case QMetaType::Double:
+    case QMetaType::Float: {
+        const double d = value.toDouble();
+        quint64 bits = 0;
+        std::memcpy(&bits, &d, sizeof(bits));
+        h.addTag('D');
+        h.addU64(bits);
+        return;
+    }
+    case QMetaType::QJsonObject:
+        hashMap(h, value.toJsonObject().toVariantMap());
+        return;
+    case QMetaType::QJsonArray:
+        hashList(h, value.toJsonArray().toVariantList());
+        return;
+    case QMetaType::QJsonValue:
+        hashVariant(h, value.toJsonValue().toVariant());
+        return;
+    default:
+        break;
+    }
+
+    if (value.metaType() == QMetaType::fromType<BlobHandle>()) {
+        const BlobHandle blob = value.value<BlobHandle>();
+        h.addTag('B');
+        h.addU64(static_cast<quint64>(blob.size()));
+        h.addU64(blob.contentHash());
+        return;
+    }
+
+    // Anything else: fall back to the JSON form the engine used historically
+    const QByteArray json = QJsonDocument(QJsonArray{QJsonValue::fromVariant(value)}).toJson(QJsonDocument::Compact);
+    h.addTag('J');
+    h.addU64(static_cast<quint64>(json.size()));
+    h.update(json.constData(), json.size());
+}
+
+} // namespace
+
+namespace InputSignature {
+
+QByteArray compute(const QVariantMap& payload)
+{
+    Hasher h;
+    hashMap(h, payload);
+
+    const Digest digest = h.digest();
+    QByteArray signature(16, Qt::Uninitialized);
+    qToLittleEndian(digest.first, signature.data());
+    qToLittleEndian(digest.second, signature.data() + 8);
+    return signature;
+}
+
+quint64 hashValue(const QVariant& value)
+{
+    Hasher h;
+    hashVariant(h, value);
+    return h.digest64();
+}
+
+quint64 hashBytes(QByteArrayView bytes)
+{
+    return ::hashBytes(bytes.data(), bytes.size());
+}
+
+void clearCache()
+{
+    largeValueCache().clear();
+}
+
+} // namespace InputSignature
@@ -0,0 +1,60 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QVariant>
+#include <QVariantMap>
+
+// Structural input signatures used for execution deduplication.
+//
+// The signature walks QVariantMap/QVariantList/QString/QByteArray values
+// directly and streams them through two XXH64 lanes with different seeds,
+// giving a 128-bit digest without building an intermediate JSON document.
+// Large string and byte-array values are hashed on their own and the result is
+// cached against Qt's implicitly shared buffer, so a multi-megabyte payload that
+// flows unchanged through several nodes is only read once. BlobHandle values
+// contribute their size and cached 64-bit content hash.
+//
+// Signatures are stable across processes of the same build: ResultCache keys
+// and run recordings are derived from them.
+namespace InputSignature {
+
+// Values at or above this many bytes get a standalone, cached hash.
+constexpr qsizetype kCacheThresholdBytes = 16 * 1024;
+
+// 16-byte signature: both XXH64 lanes, little-endian.
+QByteArray compute(const QVariantMap& payload);
+
+// 64-bit hash of a single value (first lane), using the same encoding as compute().
+quint64 hashValue(const QVariant& value);
+
+// Plain XXH64 of a byte range, e.g. for BlobHandle::contentHash().
+quint64 hashBytes(QByteArrayView bytes);
+
+// Drops all cached large-value hashes (and the buffers they keep alive).
+void clearCache();
+
+} // namespace InputSignature
@@ -0,0 +1,152 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "RemoteProtocol.h"
+
+#include <QDataStream>
+#include <QtEndian>
+
+namespace RemoteProtocol {
+
+namespace {
+
+void writeTokens(QDataStream& out, const TokenList& tokens)
+{
+    out << static_cast<qint32>(tokens.size());
+    for (const auto& token : tokens) {
+        out << token.tokenId << token.sourceNodeId << token.connectionId << token.triggeringPinId
+            << token.data << token.forceExecution;
+    }
+}
+
+bool readTokens(QDataStream& in, TokenList& tokens)
+{
+    qint32 count = 0;
+    in >> count;
+    if (count < 0) return false;
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        ExecutionToken token;
+        in >> token.tokenId >> token.sourceNodeId >> token.connectionId >> token.triggeringPinId >> token.data
+            >> token.forceExecution;
+        tokens.push_back(std::move(token));
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+} // namespace
+
+QByteArray encode(const Message& message)
+{
+    QByteArray frame(sizeof(quint32), '\0');
+    {
+        QDataStream out(&frame, QIODevice::WriteOnly | QIODevice::Append);
+        out.setVersion(QDataStream::Qt_6_0);
+        out << kMagic << kVersion << static_cast<quint8>(message.type) << message.callId;
+        switch (message.type) {
+        case MessageType::Hello:
+            out << static_cast<qint32>(message.capacity) << message.nodeTypes;
+            break;
+        case MessageType::Execute:
+            out << message.nodeType << message.state;
+            writeTokens(out, message.tokens);
+            break;
+        case MessageType::Partial:
+            writeTokens(out, message.tokens);
+            break;
+        case MessageType::Result:
+            out << message.error;
+            writeTokens(out, message.tokens);
+            break;
+        case MessageType::Pong:
+            out << static_cast<qint32>(message.active);
+            break;
+        case MessageType::Cancel:
+        case MessageType::Ping:
+            break;
+        }
+    }
+    qToBigEndian(static_cast<quint32>(frame.size() - sizeof(quint32)), frame.data());
+    return frame;
+}
+
+DecodeResult takeFrame(QByteArray& buffer, Message& message, QString* error)
+{
+    const auto fail = [&](const QString& reason) {
+        if (error) *error = reason;
+        return DecodeResult::Malformed;
+    };
+    if (buffer.size() < static_cast<qsizetype>(sizeof(quint32))) return DecodeResult::Incomplete;
+    const quint32 length = qFromBigEndian<quint32>(buffer.constData());
+    if (length > kMaxFrameBytes) {
+        return fail(QStringLiteral("Frame of %1 bytes exceeds the limit").arg(length));
+    }
+    if (buffer.size() < static_cast<qsizetype>(sizeof(quint32) + length)) return DecodeResult::Incomplete;
+
+    const QByteArray payload = buffer.mid(sizeof(quint32), length);
+    buffer.remove(0, sizeof(quint32) + length);
+
+    QDataStream in(payload);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint8 type = 0;
+    in >> magic >> version >> type;
+    if (magic != kMagic) return fail(QStringLiteral("Not a remote worker frame"));
+    if (version != kVersion) return fail(QStringLiteral("Unsupported protocol version %1").arg(version));
+
+    message = Message();
+    message.type = static_cast<MessageType>(type);
+    in >> message.callId;
+    qint32 number = 0;
+    bool ok = true;
+    switch (message.type) {
+    case MessageType::Hello:
+        in >> number >> message.nodeTypes;
+        message.capacity = number;
+        break;
+    case MessageType::Execute:
+        in >> message.nodeType >> message.state;
+        ok = readTokens(in, message.tokens);
+        break;
+    case MessageType::Partial:
+        ok = readTokens(in, message.tokens);
+        break;
+    case MessageType::Result:
+        in >> message.error;
+        ok = readTokens(in, message.tokens);
+        break;
+    case MessageType::Pong:
+        in >> number;
+        message.active = number;
+        break;
+    case MessageType::Cancel:
+    case MessageType::Ping:
+        break;
+    default:
+        return fail(QStringLiteral("Unknown message type %1").arg(type));
+    }
+    if (!ok || in.status() != QDataStream::Ok) return fail(QStringLiteral("Truncated frame"));
+    return DecodeResult::Decoded;
+}
+
+} // namespace RemoteProtocol
@@ -0,0 +1,90 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+#include "CommonDataTypes.h"
+
+// Framed RPC between a coordinator's RemoteWorkerPool and a worker process
+// ("--worker"). Each frame is a big-endian quint32 payload length followed by a
+// QDataStream payload: magic, protocol version, message type and call id, then the
+// fields of that type. Senders pass token payloads through a SharedBlobStore first,
+// where one is configured, so large blobs travel as references.
+//
+//   Hello    worker -> coordinator on connect: capacity and the node types it runs
+//   Execute  coordinator -> worker: node type, saved node state and input tokens
+//   Partial  worker -> coordinator: tokens the node published before finishing
+//   Result   worker -> coordinator: output tokens, or an error
+//   Cancel   coordinator -> worker: stop the call
+//   Ping     coordinator -> worker, answered by Pong with the calls in flight
+namespace RemoteProtocol {
+
+constexpr quint32 kMagic = 0x43505250; // "CPRP"
+constexpr quint32 kVersion = 1;
+// Frames above this are refused; large payloads belong in the blob store
+constexpr quint32 kMaxFrameBytes = 256 * 1024 * 1024;
+
+enum class MessageType : quint8 {
+    Hello = 1,
+    Execute,
+    Partial,
+    Result,
+    Cancel,
+    Ping,
+    Pong
+};
+
+struct Message {
+    MessageType type {MessageType::Ping};
+    quint64 callId {0};
+    // Hello
+    int capacity {0};
+    QStringList nodeTypes;
+    // Execute
+    QString nodeType;
+    QByteArray state; // IToolNode::saveState() as compact JSON
+    // Execute, Partial and Result
+    TokenList tokens;
+    // Result
+    QString error;
+    // Pong
+    int active {0};
+};
+
+// The whole frame, length prefix included
+QByteArray encode(const Message& message);
+
+enum class DecodeResult {
+    Incomplete,
+    Decoded,
+    Malformed
+};
+
+// Decodes the first frame of @p buffer and removes it from the buffer
+DecodeResult takeFrame(QByteArray& buffer, Message& message, QString* error = nullptr);
+
+} // namespace RemoteProtocol
@@ -0,0 +1,474 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "RemoteWorkerPool.h"
+
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QMetaObject>
+#include <QPromise>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+
+#include <stdexcept>
+
+#include "Logger.h"
+#include "LoggingCategories.h"
+#include "MetricsRegistry.h"
+#include "RemoteProtocol.h"
+
+namespace {
+
+// How often queued and running calls are checked for cancellation
+constexpr int kCancellationPollMs = 100;
+// A call is sent this many times before a lost worker fails it
+constexpr int kMaxAttempts = 2;
+
+void recordCall(const QString& worker, const QString& outcome)
+{
+    MetricsRegistry::instance()
+        .counter(QStringLiteral("cp_remote_calls"), QStringLiteral("Node tasks sent to remote workers by outcome"),
+                 {{QStringLiteral("worker"), worker}, {QStringLiteral("outcome"), outcome}})
+        .increment();
+}
+
+} // namespace
+
+struct RemoteWorkerPool::Worker {
+    Endpoint endpoint;
+    QTcpSocket* socket {nullptr};
+    QByteArray buffer;
+    // Hello received on the current connection
+    bool greeted {false};
+    int capacity {0};
+    QSet<QString> nodeTypes;
+    QSet<quint64> calls;
+    int unansweredPings {0};
+    QElapsedTimer pingSent;
+    qint64 roundTripMs {-1};
+
+    bool healthy() const { return greeted && socket; }
+};
+
+struct RemoteWorkerPool::Call {
+    quint64 id {0};
+    QString nodeType;
+    QByteArray state;
+    TokenList inputs;
+    CancellationToken cancellation;
+    PartialOutputSink partial;
+    QPromise<TokenList> promise;
+    Worker* worker {nullptr};
+    int attempts {0};
+};
+
+QStringList RemoteWorkerPool::Config::defaultNodeTypes()
+{
+    return {QStringLiteral("universal-llm"), QStringLiteral("pdf-to-image"), QStringLiteral("python-script")};
+}
+
+bool RemoteWorkerPool::Config::parseEndpoints(const QString& spec, QList<Endpoint>& endpoints, QString* error)
+{
+    for (const QString& entry : spec.split(u',', Qt::SkipEmptyParts)) {
+        const QString trimmed = entry.trimmed();
+        const qsizetype colon = trimmed.lastIndexOf(u':');
+        bool ok = false;
+        const int port = colon > 0 ? trimmed.mid(colon + 1).toInt(&ok) : 0;
+        if (!ok || port <= 0 || port > 65535) {
+            if (error) *error = QStringLiteral("Remote worker \"%1\" is not host:port").arg(trimmed);
+            return false;
+        }
+        QString host = trimmed.left(colon);
+        if (host.startsWith(u'[') && host.endsWith(u']')) host = host.mid(1, host.size() - 2);
+        endpoints.append(Endpoint{host, static_cast<quint16>(port)});
+    }
+    return true;
+}
+
+RemoteWorkerPool::Config RemoteWorkerPool::Config::fromEnvironment(QString* error)
+{
+    Config config;
+    parseEndpoints(qEnvironmentVariable("CP_REMOTE_WORKERS"), config.workers, error);
+    const QString types = qEnvironmentVariable("CP_REMOTE_NODE_TYPES");
+    const QStringList nodeTypes = types.trimmed().isEmpty() ? defaultNodeTypes()
+                                                            : types.split(u',', Qt::SkipEmptyParts);
+    for (const QString& type : nodeTypes) {
+        config.nodeTypes.insert(type.trimmed());
+    }
+    config.blobs = SharedBlobStore::fromEnvironment();
+    return config;
+}
+
+RemoteWorkerPool::RemoteWorkerPool(Config config, QObject* parent)
+    : QObject(parent)
+    , m_config(std::move(config))
+{
+}
+
+RemoteWorkerPool::~RemoteWorkerPool()
+{
+    if (!m_thread) return;
+    QMetaObject::invokeMethod(m_context, [this]() {
+        for (const auto& call : std::as_const(m_pending)) fail(call, QStringLiteral("Remote worker pool shut down"));
+        for (const auto& call : std::as_const(m_inFlight)) fail(call, QStringLiteral("Remote worker pool shut down"));
+        m_pending.clear();
+        m_inFlight.clear();
+        for (const auto& worker : m_workers) {
+            if (!worker->socket) continue;
+            QObject::disconnect(worker->socket, nullptr, m_context, nullptr);
+            delete worker->socket;
+        }
+        m_workers.clear();
+    }, Qt::BlockingQueuedConnection);
+    m_thread->quit();
+    m_thread->wait();
+}
+
+void RemoteWorkerPool::start()
+{
+    if (m_thread) return;
+    m_thread = std::make_unique<QThread>();
+    m_thread->setObjectName(QStringLiteral("RemoteWorkerPool"));
+    m_context = new QObject;
+    m_context->moveToThread(m_thread.get());
+    QObject::connect(m_thread.get(), &QThread::finished, m_context, &QObject::deleteLater);
+    m_thread->start();
+
+    QMetaObject::invokeMethod(m_context, [this]() {
+        for (const Endpoint& endpoint : std::as_const(m_config.workers)) {
+            auto worker = std::make_unique<Worker>();
+            worker->endpoint = endpoint;
+            m_workers.push_back(std::move(worker));
+        }
+        for (const auto& worker : m_workers) connectWorker(*worker);
+
+        auto* heartbeatTimer = new QTimer(m_context);
+        QObject::connect(heartbeatTimer, &QTimer::timeout, m_context, [this]() { heartbeat(); });
+        heartbeatTimer->start(m_config.heartbeatMs);
+
+        auto* cancellationTimer = new QTimer(m_context);
+        QObject::connect(cancellationTimer, &QTimer::timeout, m_context, [this]() {
+            for (auto it = m_pending.begin(); it != m_pending.end();) {
+                if ((*it)->cancellation.isCancelled()) {
+                    fail(*it, QStringLiteral("Remote call cancelled"));
+                    it = m_pending.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            for (auto it = m_inFlight.begin(); it != m_inFlight.end();) {
+                const std::shared_ptr<Call> call = it.value();
+                if (!call->cancellation.isCancelled()) {
+                    ++it;
+                    continue;
+                }
+                RemoteProtocol::Message cancel;
+                cancel.type = RemoteProtocol::MessageType::Cancel;
+                cancel.callId = call->id;
+                if (call->worker && call->worker->socket) {
+                    call->worker->socket->write(RemoteProtocol::encode(cancel));
+                    call->worker->calls.remove(call->id);
+                }
+                recordCall(call->worker ? call->worker->endpoint.toString() : QString(), QStringLiteral("cancelled"));
+                fail(call, QStringLiteral("Remote call cancelled"));
+                it = m_inFlight.erase(it);
+            }
+            pump();
+        });
+        cancellationTimer->start(kCancellationPollMs);
+    });
+}
+
+bool RemoteWorkerPool::waitForWorkers(int timeoutMs)
+{
+    QDeadlineTimer deadline(timeoutMs);
+    QMutexLocker locker(&m_stateMutex);
+    while (m_greeted < static_cast<int>(m_config.workers.size())) {
+        if (!m_helloReceived.wait(&m_stateMutex, deadline)) break;
+    }
+    return m_greeted >= static_cast<int>(m_config.workers.size());
+}
+
+bool RemoteWorkerPool::handles(const QString& nodeType) const
+{
+    QMutexLocker locker(&m_stateMutex);
+    return m_healthyTypes.contains(nodeType);
+}
+
+int RemoteWorkerPool::capacity() const
+{
+    QMutexLocker locker(&m_stateMutex);
+    return m_capacity;
+}
+
+QList<RemoteWorkerPool::WorkerStatus> RemoteWorkerPool::workers() const
+{
+    QMutexLocker locker(&m_stateMutex);
+    return m_status;
+}
+
+QFuture<TokenList> RemoteWorkerPool::execute(const QString& nodeType, const QJsonObject& state,
+                                             const TokenList& inputs, const CancellationToken& cancellation,
+                                             const PartialOutputSink& partial)
+{
+    auto call = std::make_shared<Call>();
+    call->nodeType = nodeType;
+    call->state = QJsonDocument(state).toJson(QJsonDocument::Compact);
+    // Large blobs are written to the shared store here, off the socket thread
+    for (const auto& token : inputs) {
+        ExecutionToken sent = token;
+        sent.data = m_config.blobs.offload(token.data);
+        call->inputs.push_back(std::move(sent));
+    }
+    call->cancellation = cancellation;
+    call->partial = partial;
+    call->promise.start();
+    QFuture<TokenList> future = call->promise.future();
+
+    if (!m_context) {
+        fail(call, QStringLiteral("Remote worker pool is not started"));
+        return future;
+    }
+    QMetaObject::invokeMethod(m_context, [this, call]() {
+        call->id = m_nextCallId++;
+        m_pending.append(call);
+        pump();
+    });
+
+    if (!m_config.blobs.isEnabled()) return future;
+    return future.then(QtFuture::Launch::Async, [blobs = m_config.blobs](TokenList tokens) {
+        for (auto& token : tokens) token.data = blobs.restore(token.data);
+        return tokens;
+    });
+}
+
+void RemoteWorkerPool::connectWorker(Worker& worker)
+{
+    if (worker.socket) return;
+    worker.socket = new QTcpSocket(m_context);
+    worker.buffer.clear();
+    worker.greeted = false;
+    worker.unansweredPings = 0;
+    QTcpSocket* socket = worker.socket;
+    QObject::connect(socket, &QTcpSocket::readyRead, m_context, [this, &worker]() { onReadyRead(worker); });
+    QObject::connect(socket, &QTcpSocket::disconnected, m_context, [this, &worker]() {
+        onWorkerLost(worker, QStringLiteral("disconnected"));
+    });
+    QObject::connect(socket, &QTcpSocket::errorOccurred, m_context, [this, &worker, socket]() {
+        onWorkerLost(worker, socket->errorString());
+    });
+    socket->connectToHost(worker.endpoint.host, worker.endpoint.port);
+}
+
+void RemoteWorkerPool::onReadyRead(Worker& worker)
+{
+    if (!worker.socket) return;
+    worker.buffer += worker.socket->readAll();
+    RemoteProtocol::Message message;
+    QString error;
+    for (;;) {
+        const RemoteProtocol::DecodeResult decoded = RemoteProtocol::takeFrame(worker.buffer, message, &error);
+        if (decoded == RemoteProtocol::DecodeResult::Incomplete) break;
+        if (decoded == RemoteProtocol::DecodeResult::Malformed) {
+            onWorkerLost(worker, error);
+            return;
+        }
+
+        switch (message.type) {
+        case RemoteProtocol::MessageType::Hello:
+            worker.greeted = true;
+            worker.capacity = qMax(1, message.capacity);
+            worker.nodeTypes = QSet<QString>(message.nodeTypes.cbegin(), message.nodeTypes.cend());
+            CP_CLOG(cp_concurrency) << "RemoteWorkerPool: worker" << worker.endpoint.toString() << "ready with capacity"
+                               << worker.capacity;
+            publishState();
+            pump();
+            break;
+        case RemoteProtocol::MessageType::Pong:
+            worker.unansweredPings = 0;
+            worker.roundTripMs = worker.pingSent.isValid() ? worker.pingSent.elapsed() : -1;
+            break;
+        case RemoteProtocol::MessageType::Partial:
+            if (const auto call = m_inFlight.value(message.callId)) {
+                for (auto& token : message.tokens) token.data = m_config.blobs.restore(token.data);
+                call->partial.publish(message.tokens);
+            }
+            break;
+        case RemoteProtocol::MessageType::Result:
+            if (const auto call = m_inFlight.take(message.callId)) {
+                worker.calls.remove(message.callId);
+                if (!message.error.isEmpty()) {
+                    recordCall(worker.endpoint.toString(), QStringLiteral("error"));
+                    fail(call, message.error);
+                } else {
+                    recordCall(worker.endpoint.toString(), QStringLiteral("ok"));
+                    call->promise.addResult(std::move(message.tokens));
+                    call->promise.finish();
+                }
+                pump();
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void RemoteWorkerPool::onWorkerLost(Worker& worker, const QString& reason)
+{
+    if (!worker.socket) return;
+    CP_WARN << "RemoteWorkerPool: worker" << worker.endpoint.toString() << "lost:" << reason;
+    QTcpSocket* socket = worker.socket;
+    worker.socket = nullptr;
+    worker.greeted = false;
+    QObject::disconnect(socket, nullptr, m_context, nullptr);
+    socket->abort();
+    socket->deleteLater();
+
+    // Its calls go to another worker once, then fail
+    for (const quint64 id : std::as_const(worker.calls)) {
+        const std::shared_ptr<Call> call = m_inFlight.take(id);
+        if (!call) continue;
+        call->worker = nullptr;
+        recordCall(worker.endpoint.toString(), QStringLiteral("lost"));
+        if (call->attempts >= kMaxAttempts) {
+            fail(call, QStringLiteral("Remote worker %1 was lost: %2").arg(worker.endpoint.toString(), reason));
+        } else {
+            m_pending.prepend(call);
+        }
+    }
+    worker.calls.clear();
+    publishState();
+
+    Worker* lost = &worker;
+    QTimer::singleShot(m_config.reconnectMs, m_context, [this, lost]() { connectWorker(*lost); });
+    pump();
+}
+
+void RemoteWorkerPool::heartbeat()
+{
+    RemoteProtocol::Message ping;
+    ping.type = RemoteProtocol::MessageType::Ping;
+    const QByteArray frame = RemoteProtocol::encode(ping);
+    for (const auto& worker : m_workers) {
+        if (!worker->healthy()) continue;
+        if (worker->unansweredPings >= m_config.missedHeartbeats) {
+            onWorkerLost(*worker, QStringLiteral("heartbeats unanswered"));
+            continue;
+        }
+        ++worker->unansweredPings;
+        worker->pingSent.start();
+        worker->socket->write(frame);
+    }
+    publishState();
+}
+
+void RemoteWorkerPool::pump()
+{
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        const std::shared_ptr<Call> call = *it;
+        Worker* best = nullptr;
+        bool anyRunsType = false;
+        for (const auto& worker : m_workers) {
+            if (!worker->healthy() || !worker->nodeTypes.contains(call->nodeType)) continue;
+            anyRunsType = true;
+            const int active = static_cast<int>(worker->calls.size());
+            if (active >= worker->capacity) continue;
+            // Least loaded relative to capacity, then the quickest to answer
+            const auto load = [](const Worker* w) { return static_cast<double>(w->calls.size()) / w->capacity; };
+            if (!best || load(worker.get()) < load(best)
+                || (load(worker.get()) == load(best) && worker->roundTripMs >= 0
+                    && (best->roundTripMs < 0 || worker->roundTripMs < best->roundTripMs))) {
+                best = worker.get();
+            }
+        }
+        if (!anyRunsType) {
+            fail(call, QStringLiteral("No healthy remote worker runs %1").arg(call->nodeType));
+            it = m_pending.erase(it);
+            continue;
+        }
+        if (!best) {
+            ++it;
+            continue;
+        }
+
+        RemoteProtocol::Message execute;
+        execute.type = RemoteProtocol::MessageType::Execute;
+        execute.callId = call->id;
+        execute.nodeType = call->nodeType;
+        execute.state = call->state;
+        execute.tokens = call->inputs;
+        best->socket->write(RemoteProtocol::encode(execute));
+        best->calls.insert(call->id);
+        call->worker = best;
+        ++call->attempts;
+        m_inFlight.insert(call->id, call);
+        it = m_pending.erase(it);
+    }
+}
+
+void RemoteWorkerPool::fail(const std::shared_ptr<Call>& call, const QString& error)
+{
+    call->promise.setException(std::make_exception_ptr(std::runtime_error(error.toStdString())));
+    call->promise.finish();
+}
+
+void RemoteWorkerPool::publishState()
+{
+    QList<WorkerStatus> status;
+    QSet<QString> healthyTypes;
+    int capacity = 0;
+    int greeted = 0;
+    for (const auto& worker : m_workers) {
+        WorkerStatus entry;
+        entry.address = worker->endpoint.toString();
+        entry.healthy = worker->healthy();
+        entry.capacity = worker->capacity;
+        entry.active = static_cast<int>(worker->calls.size());
+        entry.roundTripMs = worker->roundTripMs;
+        status.append(entry);
+        if (!entry.healthy) continue;
+        ++greeted;
+        capacity += worker->capacity;
+        for (const QString& type : std::as_const(worker->nodeTypes)) {
+            if (m_config.nodeTypes.contains(type)) healthyTypes.insert(type);
+        }
+    }
+    MetricsRegistry::instance()
+        .gauge(QStringLiteral("cp_remote_workers_healthy"), QStringLiteral("Remote workers connected and answering"))
+        .set(greeted);
+
+    bool changed = false;
+    {
+        QMutexLocker locker(&m_stateMutex);
+        changed = capacity != m_capacity || healthyTypes != m_healthyTypes;
+        m_status = std::move(status);
+        m_healthyTypes = std::move(healthyTypes);
+        m_capacity = capacity;
+        m_greeted = greeted;
+        m_helloReceived.wakeAll();
+    }
+    if (changed) emit capacityChanged();
+}
@@ -0,0 +1,151 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QFuture>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QWaitCondition>
+
+#include <memory>
+#include <vector>
+
+#include "CancellationToken.h"
+#include "CommonDataTypes.h"
+#include "PartialOutputSink.h"
+#include "SharedBlobStore.h"
+
+class QThread;
+
+// Coordinator side of remote execution. Keeps a connection to each worker process
+// ("CognitivePipelines --worker"), learns its capacity and node types from its hello,
+// pings it for health and sends it node tasks over RemoteProtocol. A task goes to
+// the healthy worker with the most free capacity that runs its node type, and waits
+// in order while every such worker is full. Tasks on a worker that disconnects or
+// misses its heartbeats are sent again elsewhere once, then fail. All sockets live on
+// the pool's own thread; execute() may be called from any thread.
+//
+// ExecutionEngine::setRemoteWorkers() routes the designated node types here while
+// handles() is true, limiting them by capacity() instead of the local budgets.
+class RemoteWorkerPool : public QObject {
+    Q_OBJECT
+public:
+    struct Endpoint {
+        QString host;
+        quint16 port {0};
+        QString toString() const { return host + QLatin1Char(':') + QString::number(port); }
+    };
+
+    struct Config {
+        QList<Endpoint> workers;
+        // Node type ids that run remotely
+        QSet<QString> nodeTypes;
+        SharedBlobStore blobs;
+        int heartbeatMs {2000};
+        // Heartbeats a worker may leave unanswered before it counts as down
+        int missedHeartbeats {3};
+        int reconnectMs {5000};
+
+        // CP_REMOTE_WORKERS=host:port,...; CP_REMOTE_NODE_TYPES=type,... (LLM, PDF
+        // rendering and Python script nodes by default); the blob store from
+        // SharedBlobStore::fromEnvironment()
+        static Config fromEnvironment(QString* error = nullptr);
+        static bool parseEndpoints(const QString& spec, QList<Endpoint>& endpoints, QString* error = nullptr);
+        static QStringList defaultNodeTypes();
+    };
+
+    struct WorkerStatus {
+        QString address;
+        bool healthy {false};
+        int capacity {0};
+        int active {0};
+        qint64 roundTripMs {-1};
+    };
+
+    explicit RemoteWorkerPool(Config config, QObject* parent = nullptr);
+    // Fails the calls still in flight
+    ~RemoteWorkerPool() override;
+
+    RemoteWorkerPool(const RemoteWorkerPool&) = delete;
+    RemoteWorkerPool& operator=(const RemoteWorkerPool&) = delete;
+
+    // Connects to the workers on the pool thread
+    void start();
+    // Waits until every worker has said hello or @p timeoutMs passed; true when all did
+    bool waitForWorkers(int timeoutMs);
+
+    // Whether @p nodeType is designated and some healthy worker runs it
+    bool handles(const QString& nodeType) const;
+    // Task slots summed over the healthy workers
+    int capacity() const;
+    QList<WorkerStatus> workers() const;
+    const Config& config() const { return m_config; }
+
+    // Runs one node task remotely. The future fails with std::runtime_error when the
+    // task cannot be run or the node threw; tokens the node publishes early go to
+    // @p partial. Cancelling @p cancellation cancels the call on the worker.
+    QFuture<TokenList> execute(const QString& nodeType, const QJsonObject& state, const TokenList& inputs,
+                               const CancellationToken& cancellation,
+                               const PartialOutputSink& partial = PartialOutputSink());
+
+signals:
+    // Emitted from the pool thread when capacity() or handles() may have changed
+    void capacityChanged();
+
+private:
+    struct Worker;
+    struct Call;
+
+    void connectWorker(Worker& worker);
+    void onReadyRead(Worker& worker);
+    void onWorkerLost(Worker& worker, const QString& reason);
+    void heartbeat();
+    void pump();
+    void fail(const std::shared_ptr<Call>& call, const QString& error);
+    void publishState();
+
+    Config m_config;
+    std::unique_ptr<QThread> m_thread;
+    QObject* m_context {nullptr};
+
+    // Pool-thread state
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    QList<std::shared_ptr<Call>> m_pending;
+    QHash<quint64, std::shared_ptr<Call>> m_inFlight;
+    quint64 m_nextCallId {1};
+
+    // Snapshot for other threads
+    mutable QMutex m_stateMutex;
+    QWaitCondition m_helloReceived;
+    QList<WorkerStatus> m_status;
+    QSet<QString> m_healthyTypes;
+    int m_capacity {0};
+    int m_greeted {0};
+};
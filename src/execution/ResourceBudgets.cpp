@@ -0,0 +1,113 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "ResourceBudgets.h"
+
+#include <QObject>
+#include <QThread>
+
+#include <algorithm>
+
+namespace {
+
+// No budget is allowed to exceed this, whatever the project file says
+constexpr int kMaxLimit = 1024;
+
+} // namespace
+
+ResourceBudgets::ResourceBudgets()
+{
+    for (int i = 0; i < kResourceClassCount; ++i) {
+        m_limits[i] = defaultLimit(static_cast<ResourceClass>(i));
+    }
+}
+
+ResourceBudgets ResourceBudgets::fromJson(const QJsonObject& json)
+{
+    ResourceBudgets budgets;
+    for (int i = 0; i < kResourceClassCount; ++i) {
+        const auto resourceClass = static_cast<ResourceClass>(i);
+        const int value = json.value(key(resourceClass)).toInt(0);
+        if (value > 0) {
+            budgets.setLimit(resourceClass, value);
+        }
+    }
+    return budgets;
+}
+
+QJsonObject ResourceBudgets::toJson() const
+{
+    QJsonObject json;
+    for (int i = 0; i < kResourceClassCount; ++i) {
+        const auto resourceClass = static_cast<ResourceClass>(i);
+        if (m_limits[i] != defaultLimit(resourceClass)) {
+            json.insert(key(resourceClass), m_limits[i]);
+        }
+    }
+    return json;
+}
+
+void ResourceBudgets::setLimit(ResourceClass resourceClass, int limit)
+{
+    m_limits[static_cast<int>(resourceClass)] = std::clamp(limit, 1, kMaxLimit);
+}
+
+int ResourceBudgets::defaultLimit(ResourceClass resourceClass)
+{
+    const int cores = std::max(1, QThread::idealThreadCount());
+    switch (resourceClass) {
+    case ResourceClass::Cpu:
+        return cores;
+    case ResourceClass::Network:
+        // Provider calls mostly wait on the remote side
+        return 64;
+    case ResourceClass::Process:
+        return cores;
+    case ResourceClass::GuiAffine:
+        // Dialogs and widget updates are serialized on the UI thread anyway
+        return 1;
+    }
+    return cores;
+}
+
+QString ResourceBudgets::key(ResourceClass resourceClass)
+{
+    switch (resourceClass) {
+    case ResourceClass::Cpu:       return QStringLiteral("cpu");
+    case ResourceClass::Network:   return QStringLiteral("network");
+    case ResourceClass::Process:   return QStringLiteral("process");
+    case ResourceClass::GuiAffine: return QStringLiteral("gui");
+    }
+    return QString();
+}
+
+QString ResourceBudgets::displayName(ResourceClass resourceClass)
+{
+    switch (resourceClass) {
+    case ResourceClass::Cpu:       return QObject::tr("CPU-bound nodes");
+    case ResourceClass::Network:   return QObject::tr("Network calls");
+    case ResourceClass::Process:   return QObject::tr("External processes");
+    case ResourceClass::GuiAffine: return QObject::tr("UI-thread nodes");
+    }
+    return QString();
+}
@@ -0,0 +1,59 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+
+#include <array>
+
+#include "IToolNode.h"
+
+// Per-resource-class concurrency limits for a pipeline run.
+//
+// Each ResourceClass gets its own worker pool in the engine, sized by its limit, and
+// at most that many of its nodes execute at once. Projects store overrides under
+// "resource_budgets" in the saved graph: {"cpu": 8, "network": 64, ...}. Classes that
+// are missing or not positive keep their default.
+class ResourceBudgets {
+public:
+    ResourceBudgets();
+
+    static ResourceBudgets fromJson(const QJsonObject& json);
+    // Only limits that differ from the defaults are written.
+    QJsonObject toJson() const;
+
+    int limit(ResourceClass resourceClass) const { return m_limits[static_cast<int>(resourceClass)]; }
+    void setLimit(ResourceClass resourceClass, int limit);
+
+    static int defaultLimit(ResourceClass resourceClass);
+    static QString key(ResourceClass resourceClass);
+    static QString displayName(ResourceClass resourceClass);
+
+    bool operator==(const ResourceBudgets& other) const { return m_limits == other.m_limits; }
+    bool operator!=(const ResourceBudgets& other) const { return !(*this == other); }
+
+private:
+    std::array<int, kResourceClassCount> m_limits;
+};
@@ -0,0 +1,124 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "ResultCache.h"
+
+#include "InputSignature.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QFile>
+#include <QJsonDocument>
+
+namespace {
+
+constexpr quint32 kEntryMagic = 0x43505243; // "CPRC"
+constexpr quint32 kEntryVersion = 1;
+
+} // namespace
+
+ResultCache::ResultCache(const QString& directory, qint64 maxBytes)
+    : m_store(directory, maxBytes > 0 ? maxBytes : kDefaultMaxBytes, {QStringLiteral("*.bin")})
+{
+}
+
+QString ResultCache::makeKey(const QString& nodeType, const QJsonObject& config, const TokenList& inputs)
+{
+    if (nodeType.isEmpty()) return {};
+
+    // Merge inputs the way nodes see them; run-specific system keys never affect output
+    QVariantMap merged;
+    for (const auto& token : inputs) {
+        for (auto it = token.data.cbegin(); it != token.data.cend(); ++it) {
+            if (it.key().startsWith(QLatin1String("_sys_"))) continue;
+            merged.insert(it.key(), it.value());
+        }
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(nodeType.toUtf8());
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(QJsonDocument(config).toJson(QJsonDocument::Compact));
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(InputSignature::compute(merged));
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QString ResultCache::entryPath(const QString& key) const
+{
+    return m_store.entryPath(key, QStringLiteral(".bin"));
+}
+
+std::optional<TokenList> ResultCache::lookup(const QString& key) const
+{
+    if (key.isEmpty()) return std::nullopt;
+
+    QFile file(entryPath(key));
+    if (!file.open(QIODevice::ReadOnly)) return std::nullopt;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 count = 0;
+    in >> magic >> version >> count;
+    if (magic != kEntryMagic || version != kEntryVersion || count < 0) return std::nullopt;
+
+    TokenList tokens;
+    for (qint32 i = 0; i < count; ++i) {
+        ExecutionToken token;
+        in >> token.data;
+        tokens.push_back(std::move(token));
+    }
+    if (in.status() != QDataStream::Ok) return std::nullopt;
+    file.close();
+    // Keeps the entry at the young end of the eviction order
+    m_store.touch(entryPath(key));
+    return tokens;
+}
+
+bool ResultCache::store(const QString& key, const TokenList& tokens) const
+{
+    if (key.isEmpty()) return false;
+    for (const auto& token : tokens) {
+        const auto errIt = token.data.constFind(QStringLiteral("__error"));
+        if (errIt != token.data.cend() && !errIt->toString().trimmed().isEmpty()) {
+            return false;
+        }
+    }
+
+    return m_store.write(entryPath(key), [&tokens](QIODevice* file) {
+        QDataStream out(file);
+        out.setVersion(QDataStream::Qt_6_0);
+        out << kEntryMagic << kEntryVersion << static_cast<qint32>(tokens.size());
+        for (const auto& token : tokens) {
+            out << token.data;
+        }
+        return out.status() == QDataStream::Ok;
+    });
+}
+
+void ResultCache::clear() const
+{
+    m_store.clear();
+}
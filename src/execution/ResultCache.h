@@ -0,0 +1,99 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+
+#include <optional>
+#include <utility>
+
+#include "DiskLruStore.h"
+#include "IToolNode.h"
+
+// Persistent, content-addressed store of node outputs.
+//
+// Entries are keyed by (node type, saved node configuration, input signature) and
+// hold the output tokens' data maps, serialized with QDataStream so variant types
+// survive the round trip. Each entry is a single file written atomically with
+// QSaveFile, so concurrent workers and crashed runs never leave partial entries.
+// Only nodes whose IToolNode::isCacheable() or isDeterministic() returns true are
+// ever stored. Hits refresh an entry's modification time, and the directory is a
+// DiskLruStore trimmed to maxBytes.
+class ResultCache {
+public:
+    static constexpr qint64 kDefaultMaxBytes = 1LL * 1024 * 1024 * 1024;
+
+    explicit ResultCache(const QString& directory, qint64 maxBytes = kDefaultMaxBytes);
+
+    const QString& directory() const { return m_store.directory(); }
+    qint64 maxBytes() const { return m_store.maxBytes(); }
+
+    // Bytes of entries on disk, as tracked by this process.
+    qint64 sizeBytes() const { return m_store.sizeBytes(); }
+
+    // Returns a hex key, or an empty string when the node's inputs cannot be keyed.
+    static QString makeKey(const QString& nodeType, const QJsonObject& config, const TokenList& inputs);
+
+    std::optional<TokenList> lookup(const QString& key) const;
+
+    // Stores the tokens unless any of them reports an "__error".
+    bool store(const QString& key, const TokenList& tokens) const;
+
+    void clear() const;
+
+    // The cache of the run the calling thread is executing a node for, or null. Nodes
+    // that memoise finer-grained work than a whole execution (Iterator Scope's item
+    // cache) read and write it directly.
+    static const ResultCache* current() { return slot(); }
+
+    // Makes a cache current for the lifetime of the scope
+    class Scope {
+    public:
+        explicit Scope(const ResultCache* cache)
+            : m_previous(std::exchange(slot(), cache))
+        {
+        }
+        ~Scope() { slot() = m_previous; }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const ResultCache* m_previous;
+    };
+
+private:
+    QString entryPath(const QString& key) const;
+
+    static const ResultCache*& slot()
+    {
+        thread_local const ResultCache* cache = nullptr;
+        return cache;
+    }
+
+    // Lookups, stores and clears go through the store's own lock
+    mutable DiskLruStore m_store;
+};
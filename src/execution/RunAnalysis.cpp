@@ -0,0 +1,239 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "RunAnalysis.h"
+
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QStringList>
+
+#include <algorithm>
+#include <limits>
+
+#include "ExecutionPlan.h"
+
+namespace {
+
+QString formatMs(qint64 us)
+{
+    return QStringLiteral("%1 ms").arg(static_cast<double>(us) / 1000.0, 0, 'f', 1);
+}
+
+QString percent(qint64 part, qint64 whole)
+{
+    if (whole <= 0) return QStringLiteral("0%");
+    return QStringLiteral("%1%").arg(100.0 * static_cast<double>(part) / static_cast<double>(whole), 0, 'f', 0);
+}
+
+} // namespace
+
+double RunAnalysis::utilisation() const
+{
+    if (wallUs <= 0 || workerCount <= 0) return 0.0;
+    return static_cast<double>(busyUs) / (static_cast<double>(wallUs) * workerCount);
+}
+
+RunAnalysis RunAnalysis::analyse(const QUuid& runId, const QList<ExecutionTrace::Span>& allSpans,
+                                 const ExecutionPlan& plan)
+{
+    RunAnalysis analysis;
+    analysis.runId = runId;
+
+    // Only engine tasks take part; nested scope spans are inside their scope node's span
+    struct Task {
+        const ExecutionTrace::Span* span;
+        int planIndex;
+    };
+    QList<Task> tasks;
+    for (const auto& span : allSpans) {
+        if (span.category != QStringLiteral("node")) continue;
+        bool ok = false;
+        const int index = plan.indexOf(static_cast<QtNodes::NodeId>(span.nodeId.toUInt(&ok)));
+        if (!ok || index < 0) continue;
+        tasks.append({&span, index});
+    }
+    if (tasks.isEmpty()) return analysis;
+
+    qint64 firstUs = std::numeric_limits<qint64>::max();
+    qint64 lastUs = 0;
+    QSet<quintptr> threads;
+    QHash<int, NodeTiming> timings;
+    QHash<int, QList<int>> tasksByNode;
+    for (int i = 0; i < tasks.size(); ++i) {
+        const auto& span = *tasks[i].span;
+        const qint64 beginUs = span.queuedUs >= 0 ? std::min(span.queuedUs, span.startUs) : span.startUs;
+        firstUs = std::min(firstUs, beginUs);
+        lastUs = std::max(lastUs, span.endUs);
+        threads.insert(span.threadId);
+
+        const qint64 executing = std::max<qint64>(0, span.endUs - span.startUs);
+        analysis.busyUs += executing;
+
+        NodeTiming& timing = timings[tasks[i].planIndex];
+        const auto& planNode = plan.node(tasks[i].planIndex);
+        timing.nodeUuid = planNode.uuid;
+        timing.nodeId = span.nodeId;
+        timing.name = span.name;
+        ++timing.executions;
+        timing.executingUs += executing;
+        if (span.queuedUs >= 0) timing.queuedUs += std::max<qint64>(0, span.startUs - span.queuedUs);
+        tasksByNode[tasks[i].planIndex].append(i);
+    }
+    analysis.wallUs = lastUs - firstUs;
+    analysis.workerCount = threads.size();
+
+    // Sweep over start/end events for concurrency, serial and idle time
+    QMap<qint64, QList<int>> starts;
+    QMap<qint64, QList<int>> ends;
+    for (int i = 0; i < tasks.size(); ++i) {
+        starts[tasks[i].span->startUs].append(i);
+        ends[tasks[i].span->endUs].append(i);
+    }
+    QList<qint64> times = starts.keys() + ends.keys();
+    std::sort(times.begin(), times.end());
+    times.erase(std::unique(times.begin(), times.end()), times.end());
+    QSet<int> active;
+    qint64 previousUs = firstUs;
+    for (const qint64 t : std::as_const(times)) {
+        const qint64 elapsed = t - previousUs;
+        if (elapsed > 0) {
+            if (active.isEmpty()) {
+                analysis.idleUs += elapsed;
+            } else if (active.size() == 1) {
+                analysis.serialUs += elapsed;
+                timings[tasks[*active.cbegin()].planIndex].soloUs += elapsed;
+            }
+        }
+        for (int i : ends.value(t)) active.remove(i);
+        for (int i : starts.value(t)) {
+            // Zero-length spans never overlap anything
+            if (tasks[i].span->endUs > t) active.insert(i);
+        }
+        analysis.peakConcurrency = std::max(analysis.peakConcurrency, static_cast<int>(active.size()));
+        previousUs = t;
+    }
+
+    // Critical path: walk back from the last execution to finish
+    int current = 0;
+    for (int i = 1; i < tasks.size(); ++i) {
+        if (tasks[i].span->endUs > tasks[current].span->endUs) current = i;
+    }
+    QList<int> path;
+    QSet<int> visited;
+    while (current >= 0 && !visited.contains(current)) {
+        visited.insert(current);
+        path.prepend(current);
+        const auto& span = *tasks[current].span;
+        const qint64 readyUs = span.queuedUs >= 0 ? span.queuedUs : span.startUs;
+        int predecessor = -1;
+        for (int edgeIndex : plan.node(tasks[current].planIndex).inEdges) {
+            const int sourceIndex = plan.edge(edgeIndex).sourceIndex;
+            for (int candidate : tasksByNode.value(sourceIndex)) {
+                const qint64 endUs = tasks[candidate].span->endUs;
+                if (endUs > readyUs) continue;
+                if (predecessor < 0 || endUs > tasks[predecessor].span->endUs) predecessor = candidate;
+            }
+        }
+        current = predecessor;
+    }
+
+    int previousNode = -1;
+    for (int i : std::as_const(path)) {
+        const auto& span = *tasks[i].span;
+        analysis.criticalExecutingUs += std::max<qint64>(0, span.endUs - span.startUs);
+        if (span.queuedUs >= 0) analysis.criticalQueuedUs += std::max<qint64>(0, span.startUs - span.queuedUs);
+
+        const int nodeIndex = tasks[i].planIndex;
+        if (nodeIndex == previousNode) continue;
+        if (previousNode >= 0) {
+            for (int edgeIndex : plan.node(nodeIndex).inEdges) {
+                const auto& edge = plan.edge(edgeIndex);
+                if (edge.sourceIndex == previousNode && !analysis.criticalConnections.contains(edge.connectionUuid)) {
+                    analysis.criticalConnections.append(edge.connectionUuid);
+                }
+            }
+        }
+        if (!analysis.criticalNodes.contains(plan.node(nodeIndex).uuid)) {
+            analysis.criticalNodes.append(plan.node(nodeIndex).uuid);
+        }
+        previousNode = nodeIndex;
+    }
+
+    analysis.nodes = timings.values();
+    std::sort(analysis.nodes.begin(), analysis.nodes.end(), [](const NodeTiming& a, const NodeTiming& b) {
+        return a.executingUs > b.executingUs;
+    });
+    return analysis;
+}
+
+QString RunAnalysis::summary() const
+{
+    if (!isValid() || nodes.isEmpty()) {
+        return QStringLiteral("No traced tasks in this run.");
+    }
+
+    QStringList lines;
+    lines << QStringLiteral("Wall time: %1 (%2 busy across %3 workers, %4 utilisation, peak %5 concurrent)")
+                 .arg(formatMs(wallUs), formatMs(busyUs), QString::number(workerCount),
+                      percent(busyUs, wallUs * std::max(1, workerCount)), QString::number(peakConcurrency));
+    lines << QStringLiteral("Serial: %1 (%2 of wall) with one task running; idle: %3")
+                 .arg(formatMs(serialUs), percent(serialUs, wallUs), formatMs(idleUs));
+
+    QHash<QUuid, QString> names;
+    for (const auto& timing : nodes) names.insert(timing.nodeUuid, timing.name);
+    QStringList pathNames;
+    for (const auto& uuid : criticalNodes) pathNames << names.value(uuid);
+    lines << QString();
+    lines << QStringLiteral("Critical path: %1 executing + %2 queued")
+                 .arg(formatMs(criticalExecutingUs), formatMs(criticalQueuedUs));
+    lines << QStringLiteral("  ") + pathNames.join(QStringLiteral(" -> "));
+
+    lines << QString();
+    lines << QStringLiteral("Per node (executions, executing, queued, running alone):");
+    for (const auto& timing : nodes) {
+        lines << QStringLiteral("  %1 [%2]: %3x, %4, %5, %6")
+                     .arg(timing.name, timing.nodeId, QString::number(timing.executions),
+                          formatMs(timing.executingUs), formatMs(timing.queuedUs), formatMs(timing.soloUs));
+    }
+
+    // Nodes that ran alone for a noticeable share of the run are where adding
+    // concurrency (an Iterator Scope, batching) would shorten wall-clock time
+    QList<NodeTiming> collapsed;
+    for (const auto& timing : nodes) {
+        if (wallUs > 0 && timing.soloUs * 10 >= wallUs) collapsed.append(timing);
+    }
+    std::sort(collapsed.begin(), collapsed.end(), [](const NodeTiming& a, const NodeTiming& b) {
+        return a.soloUs > b.soloUs;
+    });
+    if (!collapsed.isEmpty()) {
+        lines << QString();
+        lines << QStringLiteral("Parallelism collapsed at:");
+        for (const auto& timing : std::as_const(collapsed)) {
+            lines << QStringLiteral("  %1: ran alone for %2 (%3 of wall)")
+                         .arg(timing.name, formatMs(timing.soloUs), percent(timing.soloUs, wallUs));
+        }
+    }
+    return lines.join(QLatin1Char('\n'));
+}
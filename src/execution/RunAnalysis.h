@@ -0,0 +1,81 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QList>
+#include <QMetaType>
+#include <QString>
+#include <QUuid>
+
+#include "ExecutionTrace.h"
+
+class ExecutionPlan;
+
+// Post-run analysis of a traced run: where the wall-clock time went and what bounded it.
+//
+// The critical path is the chain of executions that determined when the run finished.
+// Starting from the last span to end, each step moves to the upstream execution that
+// finished last before the current one was queued. Time the path spent waiting in the
+// queue is included, so a long path made of short nodes points at scheduling limits
+// rather than slow nodes.
+struct RunAnalysis {
+    struct NodeTiming {
+        QUuid nodeUuid;
+        QString nodeId;
+        QString name;
+        int executions {0};
+        qint64 queuedUs {0};
+        qint64 executingUs {0};
+        // Time this node was the only task executing; large values mark where
+        // parallelism collapsed
+        qint64 soloUs {0};
+    };
+
+    QUuid runId;
+    qint64 wallUs {0};
+    qint64 busyUs {0};      // summed execution time of all tasks
+    qint64 serialUs {0};    // wall time with exactly one task executing
+    qint64 idleUs {0};      // wall time with no task executing
+    int workerCount {0};    // distinct worker threads that ran tasks
+    int peakConcurrency {0};
+
+    // Root-graph nodes and connections on the critical path, in execution order
+    QList<QUuid> criticalNodes;
+    QList<QUuid> criticalConnections;
+    qint64 criticalExecutingUs {0};
+    qint64 criticalQueuedUs {0};
+
+    QList<NodeTiming> nodes; // by executing time, longest first
+
+    bool isValid() const { return !runId.isNull(); }
+    // Mean busy fraction of the workers that took part in the run
+    double utilisation() const;
+    // Multi-line report for the Run Analysis panel
+    QString summary() const;
+
+    static RunAnalysis analyse(const QUuid& runId, const QList<ExecutionTrace::Span>& spans,
+                               const ExecutionPlan& plan);
+};
+
+Q_DECLARE_METATYPE(RunAnalysis)
@@ -0,0 +1,165 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "RunCheckpoint.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QMutexLocker>
+#include <QSaveFile>
+
+#include <algorithm>
+
+namespace {
+
+constexpr quint32 kCheckpointMagic = 0x4350434b; // "CPCK"
+constexpr quint32 kCheckpointVersion = 1;
+
+bool reportsError(const TokenList& tokens)
+{
+    for (const auto& token : tokens) {
+        if (token.data.contains(QStringLiteral("__error"))) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+RunCheckpoint::RunCheckpoint(const QString& path, QHash<QUuid, QByteArray> configSignatures, int intervalSeconds)
+    : m_path(path)
+    , m_configSignatures(std::move(configSignatures))
+    , m_intervalMs(std::max(0, intervalSeconds) * 1000LL)
+{
+    m_clock.start();
+}
+
+QByteArray RunCheckpoint::configSignature(const QString& typeId, const QJsonObject& state)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(typeId.toUtf8());
+    hash.addData(QJsonDocument(state).toJson(QJsonDocument::Compact));
+    return hash.result();
+}
+
+void RunCheckpoint::record(RunRecording::Execution execution)
+{
+    if (!execution.failure.isEmpty() || reportsError(execution.outputs)) return;
+    m_executions.record(std::move(execution));
+}
+
+qsizetype RunCheckpoint::size() const
+{
+    return m_executions.size();
+}
+
+bool RunCheckpoint::claimWrite()
+{
+    if (m_clock.elapsed() - m_lastWriteMs.load() < m_intervalMs) return false;
+    bool expected = false;
+    return m_writing.compare_exchange_strong(expected, true);
+}
+
+bool RunCheckpoint::write(QString* error)
+{
+    QMutexLocker locker(&m_writeMutex);
+    const bool written = m_closed || writeLocked(error);
+    m_lastWriteMs = m_clock.elapsed();
+    m_writing = false;
+    return written;
+}
+
+bool RunCheckpoint::close(bool keep, QString* error)
+{
+    QMutexLocker locker(&m_writeMutex);
+    if (m_closed) return true;
+    m_closed = true;
+    if (keep) return writeLocked(error);
+    return !QFileInfo::exists(m_path) || QFile::remove(m_path);
+}
+
+bool RunCheckpoint::writeLocked(QString* error)
+{
+    if (!QDir().mkpath(QFileInfo(m_path).absolutePath())) {
+        if (error) *error = QStringLiteral("Could not create directory for %1").arg(m_path);
+        return false;
+    }
+    QByteArray data;
+    {
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_6_0);
+        out << kCheckpointMagic << kCheckpointVersion << m_configSignatures << m_executions.toBundle();
+    }
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    file.write(data);
+    if (!file.commit()) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<RunRecording> RunCheckpoint::load(const QString& path,
+                                                  const QHash<QUuid, QByteArray>& configSignatures,
+                                                  QString* error)
+{
+    const auto fail = [error](const QString& message) {
+        if (error) *error = message;
+        return std::shared_ptr<RunRecording>();
+    };
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail(QStringLiteral("Could not open %1: %2").arg(path, file.errorString()));
+    }
+    QDataStream in(file.readAll());
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (magic != kCheckpointMagic) return fail(QStringLiteral("Not a run checkpoint"));
+    if (version != kCheckpointVersion) return fail(QStringLiteral("Unsupported run checkpoint version %1").arg(version));
+    QHash<QUuid, QByteArray> saved;
+    QByteArray bundle;
+    in >> saved >> bundle;
+    if (in.status() != QDataStream::Ok) return fail(QStringLiteral("Run checkpoint is truncated"));
+    QString bundleError;
+    const auto recording = RunRecording::fromBundle(bundle, &bundleError);
+    if (!recording) return fail(bundleError);
+
+    // Executions of nodes edited since the checkpoint would answer with stale results
+    auto current = std::make_shared<RunRecording>();
+    for (auto& execution : recording->executions()) {
+        const auto it = saved.constFind(execution.nodeUuid);
+        if (it == saved.cend() || configSignatures.value(execution.nodeUuid) != it.value()) continue;
+        current->record(std::move(execution));
+    }
+    return current;
+}
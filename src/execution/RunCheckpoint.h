@@ -0,0 +1,91 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QMutex>
+#include <QString>
+#include <QUuid>
+
+#include <atomic>
+#include <memory>
+
+#include "RunRecording.h"
+
+// On-disk progress of a foreground run, so a run that crashed, failed or was stopped
+// can be resumed without redoing the work it finished.
+//
+// Every successful node execution is kept (inputs and outputs, as in RunRecording)
+// together with the configuration signature of each node of the pipeline. The engine
+// rewrites the file atomically at most once per interval and once more when the run
+// ends without succeeding; a run that succeeds removes it. Resuming
+// (ExecutionEngine::resumePipeline()) answers each node whose configuration is
+// unchanged and whose inputs match a saved execution from the checkpoint, and
+// executes everything else. Results therefore come back in their saved order, and
+// work downstream of a changed node runs again.
+class RunCheckpoint {
+public:
+    RunCheckpoint(const QString& path, QHash<QUuid, QByteArray> configSignatures, int intervalSeconds);
+
+    const QString& path() const { return m_path; }
+
+    // Node type + saved state, the signature a checkpointed execution must still match
+    static QByteArray configSignature(const QString& typeId, const QJsonObject& state);
+
+    // Keeps an execution unless it failed or any output reports an "__error".
+    // Thread-safe.
+    void record(RunRecording::Execution execution);
+    qsizetype size() const;
+
+    // True once the interval has passed since the last write and no write is running;
+    // the caller that gets true must call write()
+    bool claimWrite();
+    // Writes the file atomically; does nothing once closed. Thread-safe.
+    bool write(QString* error = nullptr);
+    // Ends checkpointing: the file is written one last time when kept, removed otherwise
+    bool close(bool keep, QString* error = nullptr);
+
+    // The executions saved at path whose node still has the given signature
+    static std::shared_ptr<RunRecording> load(const QString& path,
+                                              const QHash<QUuid, QByteArray>& configSignatures,
+                                              QString* error = nullptr);
+
+private:
+    bool writeLocked(QString* error);
+
+    const QString m_path;
+    const QHash<QUuid, QByteArray> m_configSignatures;
+    const qint64 m_intervalMs;
+    RunRecording m_executions;
+    QElapsedTimer m_clock;
+    std::atomic<qint64> m_lastWriteMs {0};
+    std::atomic<bool> m_writing {false};
+    // Serializes writes with close()
+    QMutex m_writeMutex;
+    bool m_closed {false};
+};
@@ -0,0 +1,529 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "RunHistory.h"
+
+#include "ExecutionPlan.h"
+#include "Logger.h"
+#include "SqliteConnectionPool.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QStringList>
+#include <QVariant>
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+QMutex g_sharedMutex;
+std::shared_ptr<RunHistory> g_shared;
+bool g_sharedConfigured = false;
+
+// Stored for both runs and nodes, in the order bindTotals() and readTotals() use
+const QStringList& totalsColumns()
+{
+    static const QStringList columns {
+        QStringLiteral("executions"), QStringLiteral("failures"), QStringLiteral("calls"),
+        QStringLiteral("cache_hits"), QStringLiteral("retries"), QStringLiteral("input_tokens"),
+        QStringLiteral("output_tokens"), QStringLiteral("total_tokens"), QStringLiteral("executing_us"),
+        QStringLiteral("p50_us"), QStringLiteral("p95_us"), QStringLiteral("max_us"),
+        QStringLiteral("queue_wait_us"), QStringLiteral("input_bytes"), QStringLiteral("output_bytes")};
+    return columns;
+}
+
+QString totalsSchema()
+{
+    QStringList definitions;
+    for (const QString& column : totalsColumns()) {
+        definitions << column + QStringLiteral(" INTEGER NOT NULL DEFAULT 0");
+    }
+    return definitions.join(QStringLiteral(", "));
+}
+
+QString placeholders(int count)
+{
+    QStringList marks;
+    for (int i = 0; i < count; ++i) marks << QStringLiteral("?");
+    return marks.join(QStringLiteral(", "));
+}
+
+void bindTotals(QSqlQuery& query, const RunUsageReport::Totals& totals)
+{
+    query.addBindValue(totals.executions);
+    query.addBindValue(totals.failures);
+    query.addBindValue(totals.calls);
+    query.addBindValue(totals.cacheHits);
+    query.addBindValue(totals.retries);
+    query.addBindValue(totals.inputTokens);
+    query.addBindValue(totals.outputTokens);
+    query.addBindValue(totals.totalTokens);
+    query.addBindValue(totals.executingUs);
+    query.addBindValue(totals.p50Us);
+    query.addBindValue(totals.p95Us);
+    query.addBindValue(totals.maxUs);
+    query.addBindValue(totals.queueWaitUs);
+    query.addBindValue(totals.inputBytes);
+    query.addBindValue(totals.outputBytes);
+}
+
+void readTotals(const QSqlQuery& query, int first, RunUsageReport::Totals& totals)
+{
+    int i = first;
+    totals.executions = query.value(i++).toInt();
+    totals.failures = query.value(i++).toInt();
+    totals.calls = query.value(i++).toInt();
+    totals.cacheHits = query.value(i++).toInt();
+    totals.retries = query.value(i++).toInt();
+    totals.inputTokens = query.value(i++).toLongLong();
+    totals.outputTokens = query.value(i++).toLongLong();
+    totals.totalTokens = query.value(i++).toLongLong();
+    totals.executingUs = query.value(i++).toLongLong();
+    totals.p50Us = query.value(i++).toLongLong();
+    totals.p95Us = query.value(i++).toLongLong();
+    totals.maxUs = query.value(i++).toLongLong();
+    totals.queueWaitUs = query.value(i++).toLongLong();
+    totals.inputBytes = query.value(i++).toLongLong();
+    totals.outputBytes = query.value(i++).toLongLong();
+}
+
+template <typename T>
+T medianOf(std::vector<T> values)
+{
+    if (values.empty()) return T {};
+    std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+    return values[values.size() / 2];
+}
+
+RunUsageReport::Totals medianTotals(const QList<const RunUsageReport::Totals*>& samples)
+{
+    auto median = [&samples](auto member) {
+        std::vector<std::decay_t<decltype(samples.first()->*member)>> values;
+        values.reserve(static_cast<size_t>(samples.size()));
+        for (const auto* sample : samples) values.push_back(sample->*member);
+        return medianOf(std::move(values));
+    };
+    using Totals = RunUsageReport::Totals;
+    Totals totals;
+    totals.executions = median(&Totals::executions);
+    totals.failures = median(&Totals::failures);
+    totals.calls = median(&Totals::calls);
+    totals.cacheHits = median(&Totals::cacheHits);
+    totals.retries = median(&Totals::retries);
+    totals.inputTokens = median(&Totals::inputTokens);
+    totals.outputTokens = median(&Totals::outputTokens);
+    totals.totalTokens = median(&Totals::totalTokens);
+    totals.cacheReadTokens = median(&Totals::cacheReadTokens);
+    totals.cacheWriteTokens = median(&Totals::cacheWriteTokens);
+    totals.executingUs = median(&Totals::executingUs);
+    totals.p50Us = median(&Totals::p50Us);
+    totals.p95Us = median(&Totals::p95Us);
+    totals.maxUs = median(&Totals::maxUs);
+    totals.queueWaitUs = median(&Totals::queueWaitUs);
+    totals.inputBytes = median(&Totals::inputBytes);
+    totals.outputBytes = median(&Totals::outputBytes);
+    return totals;
+}
+
+// Compares one metric where higher is worse; minDelta keeps noise on tiny values quiet
+void check(RunHistory::Comparison& comparison, const QString& subject, const QString& metric,
+           double baseline, double current, double minDelta, double threshold, const QString& unit)
+{
+    const double delta = current - baseline;
+    if (delta <= minDelta) return;
+    if (baseline > 0 && delta / baseline <= threshold) return;
+    comparison.regressions.append({subject, metric, baseline, current, unit});
+}
+
+double cacheHitPercent(const RunUsageReport::Totals& totals)
+{
+    return totals.calls > 0 ? 100.0 * totals.cacheHits / totals.calls : 0.0;
+}
+
+} // namespace
+
+RunHistory::RunHistory(const QString& databasePath, int maxRunsPerGraph)
+    : m_databasePath(databasePath)
+    , m_maxRunsPerGraph(maxRunsPerGraph > 0 ? maxRunsPerGraph : kDefaultMaxRunsPerGraph)
+{
+}
+
+std::shared_ptr<RunHistory> RunHistory::shared()
+{
+    QMutexLocker locker(&g_sharedMutex);
+    if (!g_sharedConfigured) {
+        g_shared = std::make_shared<RunHistory>(defaultPath());
+        g_sharedConfigured = true;
+    }
+    return g_shared;
+}
+
+void RunHistory::setSharedPath(const QString& databasePath, int maxRunsPerGraph)
+{
+    QMutexLocker locker(&g_sharedMutex);
+    g_shared = databasePath.isEmpty() ? nullptr : std::make_shared<RunHistory>(databasePath, maxRunsPerGraph);
+    g_sharedConfigured = true;
+}
+
+QString RunHistory::defaultPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+           + QStringLiteral("/run_history.sqlite");
+}
+
+QString RunHistory::graphHash(const ExecutionPlan& plan)
+{
+    QStringList nodes;
+    for (const auto& node : plan.nodes()) {
+        nodes << node.uuid.toString(QUuid::WithoutBraces) + QLatin1Char(' ') + node.typeId;
+    }
+    QStringList edges;
+    for (const auto& edge : plan.edges()) {
+        if (edge.sourceIndex < 0 || edge.targetIndex < 0) continue;
+        edges << QStringLiteral("%1:%2>%3:%4")
+                     .arg(plan.node(edge.sourceIndex).uuid.toString(QUuid::WithoutBraces), edge.sourcePinId,
+                          plan.node(edge.targetIndex).uuid.toString(QUuid::WithoutBraces), edge.targetPinId);
+    }
+    nodes.sort();
+    edges.sort();
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(nodes.join(QLatin1Char('\n')).toUtf8());
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(edges.join(QLatin1Char('\n')).toUtf8());
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QString RunHistory::configHash(const QHash<QUuid, QByteArray>& configSignatures)
+{
+    QList<QUuid> uuids = configSignatures.keys();
+    std::sort(uuids.begin(), uuids.end());
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    for (const QUuid& uuid : std::as_const(uuids)) {
+        hash.addData(uuid.toRfc4122());
+        hash.addData(configSignatures.value(uuid));
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+bool RunHistory::ensureSchema(QSqlDatabase& db) const
+{
+    if (m_schemaReady) return true;
+    if (!db.isOpen()) return false;
+
+    QSqlQuery query(db);
+    if (!query.exec(QStringLiteral(
+            "CREATE TABLE IF NOT EXISTS runs ("
+            "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+            "run_id TEXT NOT NULL, "
+            "project TEXT NOT NULL, "
+            "graph_hash TEXT NOT NULL, "
+            "config_hash TEXT NOT NULL, "
+            "started_at INTEGER NOT NULL, "
+            "succeeded INTEGER NOT NULL, "
+            "wall_us INTEGER NOT NULL, %1)").arg(totalsSchema()))
+        || !query.exec(QStringLiteral(
+            "CREATE INDEX IF NOT EXISTS runs_graph ON runs(project, graph_hash, id)"))
+        || !query.exec(QStringLiteral(
+            "CREATE TABLE IF NOT EXISTS run_nodes ("
+            "run INTEGER NOT NULL, "
+            "node_uuid TEXT NOT NULL, "
+            "node_id TEXT NOT NULL, "
+            "name TEXT NOT NULL, %1)").arg(totalsSchema()))
+        || !query.exec(QStringLiteral(
+            "CREATE INDEX IF NOT EXISTS run_nodes_run ON run_nodes(run)"))) {
+        CP_WARN << "RunHistory: failed to create schema:" << query.lastError().text();
+        return false;
+    }
+    m_schemaReady = true;
+    return true;
+}
+
+bool RunHistory::record(Entry& entry, QString* error)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!QDir().mkpath(QFileInfo(m_databasePath).absolutePath())) {
+        if (error) *error = QStringLiteral("Cannot create %1").arg(QFileInfo(m_databasePath).absolutePath());
+        return false;
+    }
+    QString openError;
+    QSqlDatabase db = SqliteConnectionPool::connection(m_databasePath, &openError);
+    if (!ensureSchema(db)) {
+        if (error) *error = openError.isEmpty() ? QStringLiteral("Cannot create the run history schema") : openError;
+        return false;
+    }
+    if (!entry.startedAt.isValid()) {
+        entry.startedAt = QDateTime::currentDateTime().addMSecs(-entry.report.wallUs / 1000);
+    }
+
+    const int totalsCount = static_cast<int>(totalsColumns().size());
+    const QString columns = totalsColumns().join(QStringLiteral(", "));
+    db.transaction();
+    QSqlQuery insert(db);
+    insert.prepare(QStringLiteral(
+        "INSERT INTO runs (run_id, project, graph_hash, config_hash, started_at, succeeded, wall_us, %1) "
+        "VALUES (%2)").arg(columns, placeholders(7 + totalsCount)));
+    insert.addBindValue(entry.report.runId.toString(QUuid::WithoutBraces));
+    insert.addBindValue(entry.project);
+    insert.addBindValue(entry.graphHash);
+    insert.addBindValue(entry.configHash);
+    insert.addBindValue(entry.startedAt.toMSecsSinceEpoch());
+    insert.addBindValue(entry.succeeded ? 1 : 0);
+    insert.addBindValue(entry.report.wallUs);
+    bindTotals(insert, entry.report.total);
+    if (!insert.exec()) {
+        if (error) *error = insert.lastError().text();
+        db.rollback();
+        return false;
+    }
+    entry.id = insert.lastInsertId().toLongLong();
+
+    QSqlQuery insertNode(db);
+    insertNode.prepare(QStringLiteral(
+        "INSERT INTO run_nodes (run, node_uuid, node_id, name, %1) VALUES (%2)")
+        .arg(columns, placeholders(4 + totalsCount)));
+    for (const auto& node : std::as_const(entry.report.nodes)) {
+        insertNode.addBindValue(entry.id);
+        insertNode.addBindValue(node.nodeUuid.toString(QUuid::WithoutBraces));
+        insertNode.addBindValue(node.nodeId);
+        insertNode.addBindValue(node.name);
+        bindTotals(insertNode, node);
+        if (!insertNode.exec()) {
+            if (error) *error = insertNode.lastError().text();
+            db.rollback();
+            return false;
+        }
+    }
+
+    // Keep the newest runs of this graph
+    const QString older = QStringLiteral(
+        "SELECT id FROM runs WHERE project = ? AND graph_hash = ? ORDER BY id DESC LIMIT -1 OFFSET ?");
+    QSqlQuery prune(db);
+    for (const QString& sql : {QStringLiteral("DELETE FROM run_nodes WHERE run IN (%1)").arg(older),
+                               QStringLiteral("DELETE FROM runs WHERE id IN (%1)").arg(older)}) {
+        prune.prepare(sql);
+        prune.addBindValue(entry.project);
+        prune.addBindValue(entry.graphHash);
+        prune.addBindValue(m_maxRunsPerGraph);
+        if (!prune.exec()) {
+            CP_WARN << "RunHistory: failed to prune old runs:" << prune.lastError().text();
+        }
+    }
+    if (!db.commit()) {
+        if (error) *error = db.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+QList<RunHistory::Entry> RunHistory::runs(const QString& project, const QString& graphHash, int limit) const
+{
+    QList<Entry> entries;
+    QMutexLocker locker(&m_mutex);
+    if (!QFileInfo::exists(m_databasePath)) return entries;
+
+    QSqlDatabase db = SqliteConnectionPool::connection(m_databasePath);
+    if (!ensureSchema(db)) return entries;
+
+    const QString columns = totalsColumns().join(QStringLiteral(", "));
+    db.transaction();
+    QSqlQuery select(db);
+    select.prepare(QStringLiteral(
+        "SELECT id, run_id, config_hash, started_at, succeeded, wall_us, %1 FROM runs "
+        "WHERE project = ? AND graph_hash = ? ORDER BY id DESC LIMIT ?").arg(columns));
+    select.addBindValue(project);
+    select.addBindValue(graphHash);
+    select.addBindValue(limit > 0 ? limit : -1);
+    if (select.exec()) {
+        while (select.next()) {
+            Entry entry;
+            entry.id = select.value(0).toLongLong();
+            entry.project = project;
+            entry.graphHash = graphHash;
+            entry.report.runId = QUuid::fromString(select.value(1).toString());
+            entry.configHash = select.value(2).toString();
+            entry.startedAt = QDateTime::fromMSecsSinceEpoch(select.value(3).toLongLong());
+            entry.succeeded = select.value(4).toBool();
+            entry.report.wallUs = select.value(5).toLongLong();
+            readTotals(select, 6, entry.report.total);
+            entries.append(std::move(entry));
+        }
+    } else {
+        CP_WARN << "RunHistory: failed to read runs:" << select.lastError().text();
+    }
+    select.finish();
+
+    QSqlQuery nodes(db);
+    nodes.prepare(QStringLiteral(
+        "SELECT node_uuid, node_id, name, %1 FROM run_nodes WHERE run = ? ORDER BY rowid").arg(columns));
+    for (Entry& entry : entries) {
+        nodes.bindValue(0, entry.id);
+        if (!nodes.exec()) continue;
+        while (nodes.next()) {
+            RunUsageReport::NodeUsage node;
+            node.nodeUuid = QUuid::fromString(nodes.value(0).toString());
+            node.nodeId = nodes.value(1).toString();
+            node.name = nodes.value(2).toString();
+            readTotals(nodes, 3, node);
+            entry.report.nodes.append(std::move(node));
+        }
+    }
+    nodes.finish();
+    db.commit();
+    return entries;
+}
+
+RunHistory::Entry RunHistory::baseline(const QList<Entry>& runs)
+{
+    Entry baseline;
+    QList<const RunUsageReport::Totals*> totals;
+    std::vector<qint64> wallUs;
+    QList<QUuid> nodeOrder;
+    QHash<QUuid, QList<const RunUsageReport::Totals*>> nodes;
+    QHash<QUuid, const RunUsageReport::NodeUsage*> named;
+    for (const Entry& run : runs) {
+        if (!run.succeeded || !run.report.isValid()) continue;
+        if (totals.isEmpty()) {
+            // The newest successful run names the nodes and stands for the settings
+            baseline.id = run.id;
+            baseline.project = run.project;
+            baseline.graphHash = run.graphHash;
+            baseline.configHash = run.configHash;
+            baseline.startedAt = run.startedAt;
+            baseline.report.runId = run.report.runId;
+        }
+        totals.append(&run.report.total);
+        wallUs.push_back(run.report.wallUs);
+        for (const auto& node : run.report.nodes) {
+            auto& samples = nodes[node.nodeUuid];
+            if (samples.isEmpty()) {
+                nodeOrder.append(node.nodeUuid);
+                named.insert(node.nodeUuid, &node);
+            }
+            samples.append(&node);
+        }
+    }
+    if (totals.isEmpty()) return baseline;
+
+    baseline.report.wallUs = medianOf(std::move(wallUs));
+    baseline.report.total = medianTotals(totals);
+    for (const QUuid& uuid : std::as_const(nodeOrder)) {
+        RunUsageReport::NodeUsage node;
+        static_cast<RunUsageReport::Totals&>(node) = medianTotals(nodes.value(uuid));
+        node.nodeUuid = uuid;
+        node.nodeId = named.value(uuid)->nodeId;
+        node.name = named.value(uuid)->name;
+        baseline.report.nodes.append(std::move(node));
+    }
+    return baseline;
+}
+
+RunHistory::Comparison RunHistory::compare(const Entry& baseline, const Entry& current, double threshold)
+{
+    Comparison comparison;
+    if (!baseline.report.isValid() || !current.report.isValid()) return comparison;
+    comparison.configChanged = baseline.configHash != current.configHash;
+
+    const QString run = QStringLiteral("Run");
+    const QString ms = QStringLiteral("ms");
+    const QString tokens = QStringLiteral("tokens");
+    const RunUsageReport::Totals& before = baseline.report.total;
+    const RunUsageReport::Totals& after = current.report.total;
+    check(comparison, run, QStringLiteral("wall time"), baseline.report.wallUs / 1000.0,
+          current.report.wallUs / 1000.0, 50.0, threshold, ms);
+    check(comparison, run, QStringLiteral("queue wait"), before.queueWaitUs / 1000.0, after.queueWaitUs / 1000.0,
+          50.0, threshold, ms);
+    check(comparison, run, tokens, before.totalTokens, after.totalTokens, 100.0, threshold, tokens);
+    check(comparison, run, QStringLiteral("retries"), before.retries, after.retries, 0.5, threshold, QString());
+    check(comparison, run, QStringLiteral("failures"), before.failures, after.failures, 0.5, threshold, QString());
+    if (before.calls > 0 && after.calls > 0) {
+        // Lower is worse here, so the misses are compared
+        const double missesBefore = 100.0 - cacheHitPercent(before);
+        const double missesAfter = 100.0 - cacheHitPercent(after);
+        if (missesAfter - missesBefore > 5.0 && missesAfter - missesBefore > threshold * missesBefore) {
+            comparison.regressions.append({run, QStringLiteral("cache hit rate"), cacheHitPercent(before),
+                                           cacheHitPercent(after), QStringLiteral("%")});
+        }
+    }
+
+    QHash<QUuid, const RunUsageReport::NodeUsage*> baselineNodes;
+    for (const auto& node : baseline.report.nodes) baselineNodes.insert(node.nodeUuid, &node);
+    for (const auto& node : current.report.nodes) {
+        const RunUsageReport::NodeUsage* previous = baselineNodes.value(node.nodeUuid);
+        if (!previous) continue;
+        const QString subject = QStringLiteral("%1 [%2]").arg(node.name, node.nodeId);
+        check(comparison, subject, QStringLiteral("p50 latency"), previous->p50Us / 1000.0, node.p50Us / 1000.0,
+              5.0, threshold, ms);
+        check(comparison, subject, tokens, previous->totalTokens, node.totalTokens, 50.0, threshold, tokens);
+        check(comparison, subject, QStringLiteral("retries"), previous->retries, node.retries, 0.5, threshold,
+              QString());
+    }
+    return comparison;
+}
+
+QString RunHistory::Comparison::summary() const
+{
+    QStringList lines;
+    if (configChanged) {
+        lines << QStringLiteral("Node settings differ from the baseline.");
+    }
+    if (regressions.isEmpty()) {
+        lines << QStringLiteral("No regressions against the baseline.");
+        return lines.join(QLatin1Char('\n'));
+    }
+    lines << QStringLiteral("%1 regression(s) against the baseline:").arg(regressions.size());
+    for (const Regression& regression : regressions) {
+        const int decimals = regression.unit == QLatin1String("ms") ? 1 : 0;
+        QString unit;
+        if (!regression.unit.isEmpty()) unit = QStringLiteral(" ") + regression.unit;
+        QString line = QStringLiteral("  %1: %2 %3%5 -> %4%5")
+                           .arg(regression.subject, regression.metric,
+                                QString::number(regression.baseline, 'f', decimals),
+                                QString::number(regression.current, 'f', decimals), unit);
+        if (regression.baseline > 0 && regression.unit != QLatin1String("%")) {
+            line += QStringLiteral(" (+%1%)")
+                        .arg(qRound(100.0 * (regression.current - regression.baseline) / regression.baseline));
+        }
+        lines << line;
+    }
+    return lines.join(QLatin1Char('\n'));
+}
+
+void RunHistory::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    QFile::remove(m_databasePath);
+    QFile::remove(m_databasePath + QStringLiteral("-wal"));
+    QFile::remove(m_databasePath + QStringLiteral("-shm"));
+    m_schemaReady = false;
+}
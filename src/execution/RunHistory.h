@@ -0,0 +1,140 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QUuid>
+
+#include <memory>
+
+#include "RunUsageReport.h"
+
+class ExecutionPlan;
+class QSqlDatabase;
+
+/**
+ * @brief Local store of past runs' usage summaries, for spotting performance trends.
+ *
+ * Each foreground run's RunUsageReport is kept as one row of run totals plus one
+ * row per node, keyed by project and by graph hash: a hash of the pipeline's
+ * nodes, their types and connections, so editing a prompt or switching a
+ * provider keeps comparing against the same history while restructuring the
+ * graph starts a new one. A config hash of every node's saved state tells the
+ * runs of one graph apart by their settings. Only the newest maxRunsPerGraph
+ * runs of a graph are kept. Like EmbeddingCache, access is serialised by an
+ * internal mutex over the calling thread's pooled connection, so the history
+ * may be used from any thread.
+ */
+class RunHistory
+{
+public:
+    static constexpr int kDefaultMaxRunsPerGraph = 200;
+    // Relative change past which compare() flags a metric
+    static constexpr double kDefaultThreshold = 0.2;
+    // Earlier successful runs baseline() takes the median of
+    static constexpr int kBaselineRuns = 10;
+
+    struct Entry {
+        qint64 id {0};
+        QString project;
+        QString graphHash;
+        QString configHash;
+        QDateTime startedAt;
+        bool succeeded {true};
+        // Totals and nodes; per-model usage is not stored
+        RunUsageReport report;
+    };
+
+    /// One metric that got worse than the baseline by more than the threshold.
+    struct Regression {
+        QString subject; // "Run", or a node's name and id
+        QString metric;
+        double baseline {0};
+        double current {0};
+        QString unit;
+    };
+
+    struct Comparison {
+        QList<Regression> regressions;
+        // The compared runs' node settings differ
+        bool configChanged {false};
+        QString summary() const;
+    };
+
+    explicit RunHistory(const QString& databasePath, int maxRunsPerGraph = kDefaultMaxRunsPerGraph);
+
+    /**
+     * @brief The process-wide history, stored under the user's application data directory.
+     *
+     * Returns nullptr when it has been disabled with setSharedPath(QString()).
+     */
+    static std::shared_ptr<RunHistory> shared();
+    static void setSharedPath(const QString& databasePath, int maxRunsPerGraph = kDefaultMaxRunsPerGraph);
+    static QString defaultPath();
+
+    /// Hex SHA-256 of the plan's node uuids and types and its edges, in a stable order.
+    static QString graphHash(const ExecutionPlan& plan);
+    /// Hex SHA-256 of per-node config signatures (see RunCheckpoint::configSignature()).
+    static QString configHash(const QHash<QUuid, QByteArray>& configSignatures);
+
+    const QString& databasePath() const { return m_databasePath; }
+
+    /// Stores @p entry and sets its id; false with @p error set when the file can't be written.
+    bool record(Entry& entry, QString* error = nullptr);
+
+    /// Runs of one graph, newest first, with their nodes.
+    QList<Entry> runs(const QString& project, const QString& graphHash, int limit = 50) const;
+
+    /**
+     * @brief A run of medians over @p runs, for comparing one run against its recent past.
+     *
+     * Failed runs are skipped; per node, medians cover the runs that executed it.
+     * Returns an entry without a valid report when no run succeeded.
+     */
+    static Entry baseline(const QList<Entry>& runs);
+
+    /**
+     * @brief Metrics of @p current worse than @p baseline by more than @p threshold.
+     *
+     * Covers wall time, queue wait, tokens, retries, failures and cache hit rate
+     * for the run, and p50 latency, tokens and retries per node. Small absolute
+     * changes (a few milliseconds or tokens) are not flagged whatever their ratio.
+     */
+    static Comparison compare(const Entry& baseline, const Entry& current, double threshold = kDefaultThreshold);
+
+    void clear();
+
+private:
+    bool ensureSchema(QSqlDatabase& db) const;
+
+    QString m_databasePath;
+    int m_maxRunsPerGraph;
+    mutable QMutex m_mutex;
+    mutable bool m_schemaReady {false};
+};
@@ -0,0 +1,243 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "RunRecording.h"
+
+#include "InputSignature.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+
+#include <algorithm>
+
+namespace {
+
+constexpr quint32 kBundleMagic = 0x43505252; // "CPRR"
+constexpr quint32 kBundleVersion = 1;
+
+void writeTokens(QDataStream& out, const TokenList& tokens)
+{
+    out << static_cast<qint32>(tokens.size());
+    for (const auto& token : tokens) {
+        out << token.data;
+    }
+}
+
+bool readTokens(QDataStream& in, TokenList& tokens)
+{
+    qint32 count = 0;
+    in >> count;
+    if (count < 0) return false;
+    tokens.reserve(count);
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        ExecutionToken token;
+        in >> token.data;
+        tokens.push_back(std::move(token));
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+} // namespace
+
+RunRecording::RunRecording()
+{
+    m_clock.start();
+}
+
+qint64 RunRecording::nowUs() const
+{
+    return m_clock.nsecsElapsed() / 1000;
+}
+
+void RunRecording::record(Execution execution)
+{
+    QMutexLocker locker(&m_mutex);
+    m_executions.append(std::move(execution));
+    m_indexed = false;
+}
+
+QList<RunRecording::Execution> RunRecording::executions() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_executions;
+}
+
+qsizetype RunRecording::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_executions.size();
+}
+
+QByteArray RunRecording::replayKey(const QUuid& nodeUuid, const TokenList& inputs)
+{
+    // Merged the way nodes see them; run-specific system keys differ between runs
+    QVariantMap merged;
+    for (const auto& token : inputs) {
+        for (auto it = token.data.cbegin(); it != token.data.cend(); ++it) {
+            if (it.key().startsWith(QLatin1String("_sys_"))) continue;
+            merged.insert(it.key(), it.value());
+        }
+    }
+    return nodeUuid.toRfc4122() + InputSignature::compute(merged);
+}
+
+std::optional<RunRecording::Execution> RunRecording::take(const QUuid& nodeUuid, const TokenList& inputs,
+                                                          bool repeatLast) const
+{
+    const QByteArray key = replayKey(nodeUuid, inputs);
+    QMutexLocker locker(&m_mutex);
+    if (!m_indexed) {
+        m_index.clear();
+        for (qsizetype i = 0; i < m_executions.size(); ++i) {
+            const Execution& execution = m_executions.at(i);
+            m_index[replayKey(execution.nodeUuid, execution.inputs)].append(i);
+        }
+        m_indexed = true;
+    }
+    const auto it = m_index.constFind(key);
+    if (it == m_index.cend()) return std::nullopt;
+    qsizetype& taken = m_taken[key];
+    if (!repeatLast && taken >= it->size()) return std::nullopt;
+    const qsizetype position = std::min(taken, it->size() - 1);
+    ++taken;
+    return m_executions.at(it->at(position));
+}
+
+QByteArray RunRecording::toBundle() const
+{
+    QByteArray body;
+    {
+        QDataStream out(&body, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_6_0);
+        const QList<Execution> all = executions();
+        out << static_cast<qint32>(all.size());
+        for (const auto& execution : all) {
+            out << execution.nodeUuid << execution.nodeType;
+            writeTokens(out, execution.inputs);
+            writeTokens(out, execution.outputs);
+            out << execution.failure << execution.startUs << execution.durationUs;
+        }
+    }
+
+    QByteArray bundle;
+    QDataStream out(&bundle, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    // Outputs repeat as the next node's inputs, so the body compresses well
+    out << kBundleMagic << kBundleVersion << qCompress(body);
+    return bundle;
+}
+
+std::shared_ptr<RunRecording> RunRecording::fromBundle(const QByteArray& data, QString* error)
+{
+    const auto fail = [error](const QString& message) {
+        if (error) *error = message;
+        return std::shared_ptr<RunRecording>();
+    };
+
+    QDataStream header(data);
+    header.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QByteArray compressed;
+    header >> magic >> version;
+    if (magic != kBundleMagic) return fail(QStringLiteral("Not a run recording"));
+    if (version != kBundleVersion) return fail(QStringLiteral("Unsupported run recording version %1").arg(version));
+    header >> compressed;
+    const QByteArray body = qUncompress(compressed);
+    if (header.status() != QDataStream::Ok || body.isEmpty()) {
+        return fail(QStringLiteral("Run recording is truncated"));
+    }
+
+    QDataStream in(body);
+    in.setVersion(QDataStream::Qt_6_0);
+    qint32 count = 0;
+    in >> count;
+    if (count < 0) return fail(QStringLiteral("Run recording is corrupt"));
+    auto recording = std::make_shared<RunRecording>();
+    recording->m_executions.reserve(count);
+    for (qint32 i = 0; i < count; ++i) {
+        Execution execution;
+        in >> execution.nodeUuid >> execution.nodeType;
+        if (!readTokens(in, execution.inputs) || !readTokens(in, execution.outputs)) {
+            return fail(QStringLiteral("Run recording is corrupt"));
+        }
+        in >> execution.failure >> execution.startUs >> execution.durationUs;
+        if (in.status() != QDataStream::Ok) return fail(QStringLiteral("Run recording is corrupt"));
+        recording->m_executions.append(std::move(execution));
+    }
+    return recording;
+}
+
+bool RunRecording::writeBundle(const QString& path, QString* error) const
+{
+    if (!QDir().mkpath(QFileInfo(path).absolutePath())) {
+        if (error) *error = QStringLiteral("Could not create directory for %1").arg(path);
+        return false;
+    }
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    file.write(toBundle());
+    if (!file.commit()) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<RunRecording> RunRecording::load(const QString& path, QString* error)
+{
+    const auto readFile = [error](const QString& filePath) {
+        QFile file(filePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            if (error) *error = QStringLiteral("Could not open %1: %2").arg(filePath, file.errorString());
+            return std::shared_ptr<RunRecording>();
+        }
+        QString bundleError;
+        auto recording = fromBundle(file.readAll(), &bundleError);
+        if (!recording && error) *error = QStringLiteral("%1: %2").arg(filePath, bundleError);
+        return recording;
+    };
+
+    if (!QFileInfo(path).isDir()) return readFile(path);
+
+    const QDir dir(path);
+    const QStringList bundles = dir.entryList({QStringLiteral("*.cprec")}, QDir::Files, QDir::Name);
+    if (bundles.isEmpty()) {
+        if (error) *error = QStringLiteral("No run recordings in %1").arg(path);
+        return nullptr;
+    }
+    auto merged = std::make_shared<RunRecording>();
+    for (const QString& name : bundles) {
+        const auto recording = readFile(dir.filePath(name));
+        if (!recording) return nullptr;
+        merged->m_executions.append(recording->m_executions);
+    }
+    return merged;
+}
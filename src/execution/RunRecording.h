@@ -0,0 +1,95 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QUuid>
+
+#include <memory>
+#include <optional>
+
+#include "ExecutionToken.h"
+
+// Inputs, outputs and latency of every node execution of a run, saved as a compact
+// bundle so the run can be replayed without its nodes.
+//
+// The engine records one execution per finished task (see
+// ExecutionEngine::setRecordingEnabled()). Replaying (ExecutionEngine::setReplay())
+// runs the scheduler as usual, but each node is answered from the bundle: the
+// execution recorded for the same node and input values is waited out and its
+// outputs are published. Backend calls happen inside node executions, so their
+// round trips are part of the recorded latencies and none is made when replaying.
+class RunRecording {
+public:
+    struct Execution {
+        QUuid nodeUuid;
+        QString nodeType;
+        TokenList inputs;
+        TokenList outputs;
+        QString failure;
+        // Microseconds since the recording started, and the execution's wall time
+        qint64 startUs {0};
+        qint64 durationUs {0};
+    };
+
+    RunRecording();
+
+    qint64 nowUs() const;
+
+    // Thread-safe
+    void record(Execution execution);
+    QList<Execution> executions() const;
+    qsizetype size() const;
+
+    // Replay: the next execution recorded for the node and these inputs (system keys
+    // are ignored), in recorded order. Once they are used up the last one is repeated,
+    // so a node asked more often than it ran still answers, unless repeatLast is false.
+    // Thread-safe.
+    std::optional<Execution> take(const QUuid& nodeUuid, const TokenList& inputs, bool repeatLast = true) const;
+
+    // Bundle format: magic, version, then qCompress()ed executions
+    QByteArray toBundle() const;
+    static std::shared_ptr<RunRecording> fromBundle(const QByteArray& data, QString* error = nullptr);
+    bool writeBundle(const QString& path, QString* error = nullptr) const;
+    // A bundle file, or a directory whose *.cprec bundles are merged (as written by
+    // batch runs, one per run)
+    static std::shared_ptr<RunRecording> load(const QString& path, QString* error = nullptr);
+
+private:
+    static QByteArray replayKey(const QUuid& nodeUuid, const TokenList& inputs);
+
+    QElapsedTimer m_clock;
+    mutable QMutex m_mutex;
+    QList<Execution> m_executions;
+    // Replay index: positions in m_executions per node and inputs, and how many of
+    // them were taken; built on first take()
+    mutable QHash<QByteArray, QList<qsizetype>> m_index;
+    mutable QHash<QByteArray, qsizetype> m_taken;
+    mutable bool m_indexed {false};
+};
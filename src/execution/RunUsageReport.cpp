@@ -0,0 +1,351 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "RunUsageReport.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QSet>
+#include <QStringList>
+
+#include <algorithm>
+
+namespace {
+thread_local RunUsageCollector* t_currentCollector = nullptr;
+
+QString formatMs(qint64 us)
+{
+    return QStringLiteral("%1 ms").arg(static_cast<double>(us) / 1000.0, 0, 'f', 1);
+}
+
+// Nearest-rank percentile of sorted samples
+qint64 percentile(const std::vector<qint64>& sorted, int p)
+{
+    if (sorted.empty()) return 0;
+    const size_t rank = (sorted.size() * static_cast<size_t>(p) + 99) / 100;
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+void addCall(RunUsageReport::Totals& totals, const QVariantMap& data, bool cached)
+{
+    ++totals.calls;
+    const int attempts = data.value(QStringLiteral("_route_attempts")).toInt();
+    if (attempts > 1) totals.retries += attempts - 1;
+    if (cached) {
+        ++totals.cacheHits;
+        return;
+    }
+    totals.inputTokens += data.value(QStringLiteral("_usage.input_tokens")).toLongLong();
+    totals.outputTokens += data.value(QStringLiteral("_usage.output_tokens")).toLongLong();
+    totals.totalTokens += data.value(QStringLiteral("_usage.total_tokens")).toLongLong();
+    totals.cacheReadTokens += data.value(QStringLiteral("_usage.cache_read_tokens")).toLongLong();
+    totals.cacheWriteTokens += data.value(QStringLiteral("_usage.cache_write_tokens")).toLongLong();
+}
+
+void addTotals(RunUsageReport::Totals& into, const RunUsageReport::Totals& from)
+{
+    into.executions += from.executions;
+    into.failures += from.failures;
+    into.calls += from.calls;
+    into.cacheHits += from.cacheHits;
+    into.retries += from.retries;
+    into.inputTokens += from.inputTokens;
+    into.outputTokens += from.outputTokens;
+    into.totalTokens += from.totalTokens;
+    into.cacheReadTokens += from.cacheReadTokens;
+    into.cacheWriteTokens += from.cacheWriteTokens;
+    into.executingUs += from.executingUs;
+    into.queueWaitUs += from.queueWaitUs;
+    into.inputBytes += from.inputBytes;
+    into.outputBytes += from.outputBytes;
+}
+
+void setLatencies(RunUsageReport::Totals& totals, std::vector<qint64> latenciesUs)
+{
+    std::sort(latenciesUs.begin(), latenciesUs.end());
+    totals.p50Us = percentile(latenciesUs, 50);
+    totals.p95Us = percentile(latenciesUs, 95);
+    totals.maxUs = latenciesUs.empty() ? 0 : latenciesUs.back();
+}
+
+QJsonObject totalsToJson(const RunUsageReport::Totals& totals)
+{
+    QJsonObject object;
+    object.insert(QStringLiteral("executions"), totals.executions);
+    object.insert(QStringLiteral("failures"), totals.failures);
+    object.insert(QStringLiteral("calls"), totals.calls);
+    object.insert(QStringLiteral("cache_hits"), totals.cacheHits);
+    object.insert(QStringLiteral("retries"), totals.retries);
+    object.insert(QStringLiteral("input_tokens"), totals.inputTokens);
+    object.insert(QStringLiteral("output_tokens"), totals.outputTokens);
+    object.insert(QStringLiteral("total_tokens"), totals.totalTokens);
+    object.insert(QStringLiteral("cache_read_tokens"), totals.cacheReadTokens);
+    object.insert(QStringLiteral("cache_write_tokens"), totals.cacheWriteTokens);
+    object.insert(QStringLiteral("executing_ms"), static_cast<double>(totals.executingUs) / 1000.0);
+    object.insert(QStringLiteral("p50_ms"), static_cast<double>(totals.p50Us) / 1000.0);
+    object.insert(QStringLiteral("p95_ms"), static_cast<double>(totals.p95Us) / 1000.0);
+    object.insert(QStringLiteral("max_ms"), static_cast<double>(totals.maxUs) / 1000.0);
+    object.insert(QStringLiteral("queue_wait_ms"), static_cast<double>(totals.queueWaitUs) / 1000.0);
+    object.insert(QStringLiteral("input_bytes"), totals.inputBytes);
+    object.insert(QStringLiteral("output_bytes"), totals.outputBytes);
+    return object;
+}
+
+QString callsText(const RunUsageReport::Totals& totals)
+{
+    return QStringLiteral("%1 calls (%2 cache hits, %3 retries), %4 tokens (%5 in, %6 out)")
+        .arg(totals.calls)
+        .arg(totals.cacheHits)
+        .arg(totals.retries)
+        .arg(totals.totalTokens)
+        .arg(totals.inputTokens)
+        .arg(totals.outputTokens);
+}
+
+QString latencyText(const RunUsageReport::Totals& totals)
+{
+    return QStringLiteral("p50 %1, p95 %2, max %3")
+        .arg(formatMs(totals.p50Us), formatMs(totals.p95Us), formatMs(totals.maxUs));
+}
+
+} // namespace
+
+RunUsageCollector::RunUsageCollector(const QUuid& runId)
+    : m_runId(runId)
+{
+    m_clock.start();
+}
+
+void RunUsageCollector::recordExecution(const QUuid& nodeUuid, const QString& nodeId, const QString& name,
+                                        const TokenList& outputs, qint64 durationUs, bool failed, bool replayed)
+{
+    QMutexLocker locker(&m_mutex);
+    NodeAccumulator& node = m_nodes[nodeUuid];
+    if (node.totals.executions == 0) {
+        node.nodeId = nodeId;
+        node.name = name;
+    }
+    ++node.totals.executions;
+    bool reportedError = false;
+    QSet<QPair<QString, QString>> calledModels;
+    const auto recordCall = [&](const QVariantMap& data, qint64 latencyUs) {
+        const QString provider = data.value(QStringLiteral("_provider")).toString();
+        if (provider.isEmpty()) return;
+        const bool cached = replayed || data.value(QStringLiteral("_cache_hit")).toBool()
+                            || data.value(QStringLiteral("_coalesced")).toBool();
+        const QPair<QString, QString> key(provider, data.value(QStringLiteral("_model")).toString());
+        Accumulator& model = m_models[key];
+        addCall(node.totals, data, cached);
+        addCall(model.totals, data, cached);
+        if (!cached && !calledModels.contains(key)) {
+            calledModels.insert(key);
+            ++model.totals.executions;
+            model.totals.executingUs += latencyUs;
+            model.latenciesUs.push_back(latencyUs);
+        }
+    };
+    for (const ExecutionToken& token : outputs) {
+        const QVariantMap& data = token.data;
+        reportedError = reportedError || data.contains(QStringLiteral("__error"));
+        // A model cascade reports each model it asked, with that call's own latency
+        const QVariantList tiers = data.value(QStringLiteral("_cascade_tiers")).toList();
+        if (tiers.isEmpty()) {
+            recordCall(data, durationUs);
+            continue;
+        }
+        for (const QVariant& tier : tiers) {
+            const QVariantMap call = tier.toMap();
+            recordCall(call, call.value(QStringLiteral("latency_us")).toLongLong());
+        }
+    }
+    if (failed || reportedError) {
+        ++node.totals.failures;
+    }
+    // Cached answers took no time worth ranking
+    if (!replayed) {
+        node.totals.executingUs += durationUs;
+        node.latenciesUs.push_back(durationUs);
+    }
+}
+
+void RunUsageCollector::recordQueueWait(const QUuid& nodeUuid, qint64 waitUs)
+{
+    QMutexLocker locker(&m_mutex);
+    m_nodes[nodeUuid].totals.queueWaitUs += std::max<qint64>(waitUs, 0);
+}
+
+void RunUsageCollector::recordPayload(const QUuid& nodeUuid, qint64 inputBytes, qint64 outputBytes)
+{
+    QMutexLocker locker(&m_mutex);
+    NodeAccumulator& node = m_nodes[nodeUuid];
+    node.totals.inputBytes += inputBytes;
+    node.totals.outputBytes += outputBytes;
+}
+
+void RunUsageCollector::recordRetry(const QUuid& nodeUuid)
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_nodes[nodeUuid].totals.retries;
+}
+
+RunUsageReport RunUsageCollector::report() const
+{
+    RunUsageReport report;
+    report.runId = m_runId;
+    report.wallUs = m_clock.nsecsElapsed() / 1000;
+
+    std::vector<qint64> allLatenciesUs;
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_nodes.cbegin(); it != m_nodes.cend(); ++it) {
+        // Queued but never executed, e.g. when the run was stopped
+        if (it->totals.executions == 0) continue;
+        allLatenciesUs.insert(allLatenciesUs.end(), it->latenciesUs.cbegin(), it->latenciesUs.cend());
+        RunUsageReport::NodeUsage node;
+        static_cast<RunUsageReport::Totals&>(node) = it->totals;
+        setLatencies(node, it->latenciesUs);
+        node.nodeUuid = it.key();
+        node.nodeId = it->nodeId;
+        node.name = it->name;
+        addTotals(report.total, node);
+        report.nodes.append(std::move(node));
+    }
+    for (auto it = m_models.cbegin(); it != m_models.cend(); ++it) {
+        RunUsageReport::ModelUsage model;
+        static_cast<RunUsageReport::Totals&>(model) = it->totals;
+        setLatencies(model, it->latenciesUs);
+        model.provider = it.key().first;
+        model.model = it.key().second;
+        report.models.append(std::move(model));
+    }
+    locker.unlock();
+    setLatencies(report.total, std::move(allLatenciesUs));
+
+    std::sort(report.nodes.begin(), report.nodes.end(), [](const auto& a, const auto& b) {
+        if (a.totalTokens != b.totalTokens) return a.totalTokens > b.totalTokens;
+        return a.executingUs > b.executingUs;
+    });
+    std::sort(report.models.begin(), report.models.end(), [](const auto& a, const auto& b) {
+        if (a.totalTokens != b.totalTokens) return a.totalTokens > b.totalTokens;
+        return a.calls > b.calls;
+    });
+    return report;
+}
+
+RunUsageCollector* RunUsageCollector::current()
+{
+    return t_currentCollector;
+}
+
+void RunUsageCollector::setCurrent(RunUsageCollector* collector)
+{
+    t_currentCollector = collector;
+}
+
+QString RunUsageReport::summary() const
+{
+    if (!isValid() || nodes.isEmpty()) {
+        return QStringLiteral("No node executions in this run.");
+    }
+
+    QStringList lines;
+    lines << QStringLiteral("Wall time: %1; %2 executions (%3 failed)")
+                 .arg(formatMs(wallUs))
+                 .arg(total.executions)
+                 .arg(total.failures);
+    lines << QStringLiteral("Provider calls: %1").arg(callsText(total));
+    lines << QStringLiteral("Queue wait: %1; payloads: %2 KiB in, %3 KiB out")
+                 .arg(formatMs(total.queueWaitUs))
+                 .arg(total.inputBytes / 1024)
+                 .arg(total.outputBytes / 1024);
+
+    if (!models.isEmpty()) {
+        lines << QString();
+        lines << QStringLiteral("Per provider and model (latency of the executions that called it):");
+        for (const auto& model : models) {
+            lines << QStringLiteral("  %1/%2: %3; %4")
+                         .arg(model.provider, model.model, callsText(model), latencyText(model));
+        }
+    }
+
+    lines << QString();
+    lines << QStringLiteral("Per node (executions, executing time, latency, calls):");
+    for (const auto& node : nodes) {
+        QString line = QStringLiteral("  %1 [%2]: %3x, %4, %5")
+                           .arg(node.name, node.nodeId, QString::number(node.executions),
+                                formatMs(node.executingUs), latencyText(node));
+        if (node.calls > 0) {
+            line += QStringLiteral("; ") + callsText(node);
+        }
+        lines << line;
+    }
+    return lines.join(QLatin1Char('\n'));
+}
+
+QJsonObject RunUsageReport::toJson() const
+{
+    QJsonObject root;
+    root.insert(QStringLiteral("run_id"), runId.toString(QUuid::WithoutBraces));
+    root.insert(QStringLiteral("wall_ms"), static_cast<double>(wallUs) / 1000.0);
+    root.insert(QStringLiteral("total"), totalsToJson(total));
+
+    QJsonArray modelArray;
+    for (const auto& model : models) {
+        QJsonObject object = totalsToJson(model);
+        object.insert(QStringLiteral("provider"), model.provider);
+        object.insert(QStringLiteral("model"), model.model);
+        modelArray.append(object);
+    }
+    root.insert(QStringLiteral("models"), modelArray);
+
+    QJsonArray nodeArray;
+    for (const auto& node : nodes) {
+        QJsonObject object = totalsToJson(node);
+        object.insert(QStringLiteral("node_uuid"), node.nodeUuid.toString(QUuid::WithoutBraces));
+        object.insert(QStringLiteral("node_id"), node.nodeId);
+        object.insert(QStringLiteral("name"), node.name);
+        nodeArray.append(object);
+    }
+    root.insert(QStringLiteral("nodes"), nodeArray);
+    return root;
+}
+
+bool RunUsageReport::writeJson(const QString& path, QString* error) const
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(toJson()).toJson());
+    if (!file.commit()) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
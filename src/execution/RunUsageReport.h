@@ -0,0 +1,140 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QMetaType>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <QUuid>
+
+#include <vector>
+
+#include "ExecutionToken.h"
+
+// Where a run spent its provider calls, tokens and time, per node and per provider and
+// model, so it is clear which nodes to batch, cache or move to a cheaper model.
+//
+// Built from the output packets of the run's node executions, including the nodes of
+// scope bodies. An output carrying "_provider" counts as one provider call with the
+// "_usage.*" tokens, "_cache_hit" and "_route_attempts" it reports. Calls answered from
+// a cache, by the engine's result cache or by an identical request of another execution
+// ("_coalesced") are cache hits and add no tokens. Latency is the
+// node's execution time, so for a model it covers the calls together with the work the
+// node did around them. Providers report no prices, so cost is given in tokens. Queue
+// wait, payload sizes and engine retries of transient failures are kept per node, as the
+// engine reports them for its tasks.
+struct RunUsageReport {
+    struct Totals {
+        int executions {0};
+        int failures {0};
+        int calls {0};
+        int cacheHits {0};
+        // Extra attempts across model routes, and engine retries of the node
+        int retries {0};
+        qint64 inputTokens {0};
+        qint64 outputTokens {0};
+        qint64 totalTokens {0};
+        qint64 cacheReadTokens {0};
+        qint64 cacheWriteTokens {0};
+        qint64 executingUs {0};
+        qint64 p50Us {0};
+        qint64 p95Us {0};
+        qint64 maxUs {0};
+        // Time the node's tasks spent queued before a worker took them
+        qint64 queueWaitUs {0};
+        qint64 inputBytes {0};
+        qint64 outputBytes {0};
+    };
+    struct NodeUsage : Totals {
+        QUuid nodeUuid;
+        QString nodeId;
+        QString name;
+    };
+    struct ModelUsage : Totals {
+        QString provider;
+        QString model;
+    };
+
+    QUuid runId;
+    qint64 wallUs {0};
+    Totals total;
+    QList<NodeUsage> nodes;   // by tokens, then executing time, largest first
+    QList<ModelUsage> models; // by tokens, largest first
+
+    bool isValid() const { return !runId.isNull(); }
+    // Multi-line report for the Run Usage panel
+    QString summary() const;
+    QJsonObject toJson() const;
+    bool writeJson(const QString& path, QString* error = nullptr) const;
+};
+
+Q_DECLARE_METATYPE(RunUsageReport)
+
+// Collects a run's RunUsageReport. The engine records its tasks; scope bodies record
+// their nodes through current(), which the engine sets around node execution.
+class RunUsageCollector {
+public:
+    explicit RunUsageCollector(const QUuid& runId);
+
+    // Thread-safe. replayed marks outputs taken from a cache instead of executing. Outputs
+    // with _cascade_tiers count one call per tier, timed by the tier's latency_us.
+    void recordExecution(const QUuid& nodeUuid, const QString& nodeId, const QString& name,
+                         const TokenList& outputs, qint64 durationUs, bool failed, bool replayed = false);
+    // Thread-safe engine task bookkeeping; payload sizes are ExecutionTrace::approximateSize()
+    void recordQueueWait(const QUuid& nodeUuid, qint64 waitUs);
+    void recordPayload(const QUuid& nodeUuid, qint64 inputBytes, qint64 outputBytes);
+    void recordRetry(const QUuid& nodeUuid);
+
+    // Microseconds since the collector was created, for queue stamps
+    qint64 nowUs() const { return m_clock.nsecsElapsed() / 1000; }
+
+    // The report so far; wall time counts from the collector's creation
+    RunUsageReport report() const;
+
+    // The collector of the run whose node is executing on this thread, or null. Like
+    // ExecutionTrace::current(), work moved to another thread must set it there.
+    static RunUsageCollector* current();
+    static void setCurrent(RunUsageCollector* collector);
+
+private:
+    struct Accumulator {
+        RunUsageReport::Totals totals;
+        std::vector<qint64> latenciesUs;
+    };
+    struct NodeAccumulator : Accumulator {
+        QString nodeId;
+        QString name;
+    };
+
+    const QUuid m_runId;
+    QElapsedTimer m_clock;
+    mutable QMutex m_mutex;
+    QHash<QUuid, NodeAccumulator> m_nodes;
+    QHash<QPair<QString, QString>, Accumulator> m_models;
+};
@@ -0,0 +1,136 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "SharedBlobStore.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include "BlobHandle.h"
+#include "Logger.h"
+
+SharedBlobStore::SharedBlobStore(const QString& directory, qint64 threshold)
+    : m_directory(directory.isEmpty() ? QString() : QDir::cleanPath(directory))
+    , m_threshold(qMax<qint64>(0, threshold))
+{
+}
+
+SharedBlobStore SharedBlobStore::fromEnvironment()
+{
+    bool ok = false;
+    const qint64 threshold = qEnvironmentVariable("CP_REMOTE_BLOB_THRESHOLD").toLongLong(&ok);
+    return SharedBlobStore(qEnvironmentVariable("CP_REMOTE_BLOB_DIR"), ok && threshold >= 0 ? threshold
+                                                                                             : kDefaultThreshold);
+}
+
+QVariantMap SharedBlobStore::offload(const QVariantMap& packet) const
+{
+    if (!isEnabled()) return packet;
+    QVariantMap result;
+    for (auto it = packet.cbegin(); it != packet.cend(); ++it) {
+        result.insert(it.key(), offloadValue(it.value()));
+    }
+    return result;
+}
+
+QVariantMap SharedBlobStore::restore(const QVariantMap& packet) const
+{
+    if (!isEnabled()) return packet;
+    QVariantMap result;
+    for (auto it = packet.cbegin(); it != packet.cend(); ++it) {
+        result.insert(it.key(), restoreValue(it.value()));
+    }
+    return result;
+}
+
+QVariant SharedBlobStore::offloadValue(const QVariant& value) const
+{
+    if (value.metaType() == QMetaType::fromType<BlobHandle>()) {
+        const BlobHandle blob = value.value<BlobHandle>();
+        if (blob.isNull() || blob.size() < m_threshold) return value;
+
+        // Named by content, so a payload already in the store is not written again
+        const QString name = QStringLiteral("%1-%2.blob")
+                                 .arg(blob.contentHash(), 16, 16, QLatin1Char('0'))
+                                 .arg(blob.size());
+        const QString path = QDir(m_directory).filePath(name);
+        if (!QFileInfo::exists(path)) {
+            QSaveFile out(path);
+            const QByteArrayView bytes = blob.view();
+            if (!QDir().mkpath(m_directory) || !out.open(QIODevice::WriteOnly)
+                || out.write(bytes.data(), bytes.size()) != bytes.size() || !out.commit()) {
+                CP_WARN << "SharedBlobStore: cannot write" << path << ":" << out.errorString();
+                return value;
+            }
+        }
+        return QVariantMap{
+            {QString::fromLatin1(kReferenceKey), name},
+            {QStringLiteral("mime"), blob.mimeType()},
+            {QStringLiteral("size"), blob.size()},
+        };
+    }
+    if (value.typeId() == QMetaType::QVariantMap) {
+        return offload(value.toMap());
+    }
+    if (value.typeId() == QMetaType::QVariantList) {
+        QVariantList list = value.toList();
+        for (QVariant& item : list) {
+            item = offloadValue(item);
+        }
+        return list;
+    }
+    return value;
+}
+
+QVariant SharedBlobStore::restoreValue(const QVariant& value) const
+{
+    if (value.typeId() == QMetaType::QVariantMap) {
+        const QVariantMap map = value.toMap();
+        const auto reference = map.constFind(QString::fromLatin1(kReferenceKey));
+        if (reference == map.cend()) {
+            return restore(map);
+        }
+        // Only plain names are accepted; a reference never points outside the store
+        const QString name = reference.value().toString();
+        if (name.isEmpty() || name.contains(u'/') || name.contains(u'\\') || name.startsWith(u'.')) {
+            return QVariant();
+        }
+        const BlobHandle blob = BlobHandle::fromFile(QDir(m_directory).filePath(name),
+                                                     map.value(QStringLiteral("mime")).toString());
+        if (blob.isNull()) {
+            CP_WARN << "SharedBlobStore: missing blob" << name << "in" << m_directory;
+            return QVariant();
+        }
+        return QVariant::fromValue(blob);
+    }
+    if (value.typeId() == QMetaType::QVariantList) {
+        QVariantList list = value.toList();
+        for (QVariant& item : list) {
+            item = restoreValue(item);
+        }
+        return list;
+    }
+    return value;
+}
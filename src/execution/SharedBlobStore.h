@@ -0,0 +1,63 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QString>
+#include <QVariantMap>
+
+// Content-addressed blob directory shared by a coordinator and its remote workers,
+// typically a network file system mounted on every machine. Packets sent to or from
+// a worker carry large BlobHandle values as a small reference to a file here instead
+// of inline bytes; equal payloads are written once.
+class SharedBlobStore {
+public:
+    static constexpr qint64 kDefaultThreshold = 1024 * 1024;
+
+    // An empty directory disables the store: every blob travels inline
+    explicit SharedBlobStore(const QString& directory = {}, qint64 threshold = kDefaultThreshold);
+
+    // CP_REMOTE_BLOB_DIR and CP_REMOTE_BLOB_THRESHOLD (bytes)
+    static SharedBlobStore fromEnvironment();
+
+    bool isEnabled() const { return !m_directory.isEmpty(); }
+    QString directory() const { return m_directory; }
+    qint64 threshold() const { return m_threshold; }
+
+    // Replaces blobs of threshold() bytes or more, at any depth of lists and maps, by
+    // references into the store. Blobs that cannot be written stay inline.
+    QVariantMap offload(const QVariantMap& packet) const;
+    // Turns references back into blobs, snapshotted from the store's files. A reference
+    // whose file is missing becomes a null value.
+    QVariantMap restore(const QVariantMap& packet) const;
+
+    // Key of the map that stands in for an offloaded blob
+    static constexpr const char* kReferenceKey = "__cp_shared_blob";
+
+private:
+    QVariant offloadValue(const QVariant& value) const;
+    QVariant restoreValue(const QVariant& value) const;
+
+    QString m_directory;
+    qint64 m_threshold;
+};
@@ -0,0 +1,177 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "ThreadQos.h"
+
+#include "Logger.h"
+#include "LoggingCategories.h"
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#elif defined(Q_OS_MACOS)
+#include <pthread.h>
+#include <pthread/qos.h>
+#elif defined(Q_OS_LINUX)
+#include <cerrno>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// -1 until the thread's level was read or set
+thread_local int t_level = -1;
+
+std::atomic<bool> s_refusalLogged {false};
+
+#if defined(Q_OS_LINUX)
+// Nice value of the process, read on the main thread during static initialization;
+// interactive workers go back to it
+const int s_baseNice = getpriority(PRIO_PROCESS, 0);
+
+constexpr int kUtilityNiceOffset = 10;
+constexpr int kMaxNice = 19;
+
+pid_t currentThreadId()
+{
+    return static_cast<pid_t>(syscall(SYS_gettid));
+}
+#endif
+
+ThreadQos::Level osLevel()
+{
+#if defined(Q_OS_WIN)
+    const int priority = GetThreadPriority(GetCurrentThread());
+    if (priority <= THREAD_PRIORITY_LOWEST) return ThreadQos::Level::Background;
+    if (priority < THREAD_PRIORITY_NORMAL) return ThreadQos::Level::Utility;
+#elif defined(Q_OS_MACOS)
+    const qos_class_t qos = qos_class_self();
+    if (qos != QOS_CLASS_UNSPECIFIED) {
+        if (qos <= QOS_CLASS_BACKGROUND) return ThreadQos::Level::Background;
+        if (qos <= QOS_CLASS_UTILITY) return ThreadQos::Level::Utility;
+    }
+#elif defined(Q_OS_LINUX)
+    const pid_t tid = currentThreadId();
+    if (sched_getscheduler(tid) == SCHED_IDLE) return ThreadQos::Level::Background;
+    errno = 0;
+    const int nice = getpriority(PRIO_PROCESS, static_cast<id_t>(tid));
+    if (errno == 0 && nice > s_baseNice) return ThreadQos::Level::Utility;
+#endif
+    return ThreadQos::Level::UserInitiated;
+}
+
+bool applyToOs(ThreadQos::Level level)
+{
+#if defined(Q_OS_WIN)
+    const int priority = level == ThreadQos::Level::Background ? THREAD_PRIORITY_LOWEST
+                       : level == ThreadQos::Level::Utility   ? THREAD_PRIORITY_BELOW_NORMAL
+                                                              : THREAD_PRIORITY_NORMAL;
+    return SetThreadPriority(GetCurrentThread(), priority) != 0;
+#elif defined(Q_OS_MACOS)
+    const qos_class_t qos = level == ThreadQos::Level::Background ? QOS_CLASS_BACKGROUND
+                          : level == ThreadQos::Level::Utility   ? QOS_CLASS_UTILITY
+                                                                 : QOS_CLASS_USER_INITIATED;
+    return pthread_set_qos_class_self_np(qos, 0) == 0;
+#elif defined(Q_OS_LINUX)
+    const pid_t tid = currentThreadId();
+    sched_param param {};
+    if (level == ThreadQos::Level::Background) {
+        return setpriority(PRIO_PROCESS, static_cast<id_t>(tid), kMaxNice) == 0
+            && sched_setscheduler(tid, SCHED_IDLE, &param) == 0;
+    }
+    // Leaving SCHED_IDLE comes first; it and lowering nice need RLIMIT_NICE or CAP_SYS_NICE
+    if (sched_getscheduler(tid) == SCHED_IDLE && sched_setscheduler(tid, SCHED_OTHER, &param) != 0) {
+        return false;
+    }
+    const int nice = level == ThreadQos::Level::Utility ? std::min(kMaxNice, s_baseNice + kUtilityNiceOffset)
+                                                        : s_baseNice;
+    return setpriority(PRIO_PROCESS, static_cast<id_t>(tid), nice) == 0;
+#else
+    Q_UNUSED(level);
+    return false;
+#endif
+}
+
+} // namespace
+
+namespace ThreadQos {
+
+bool isSupported()
+{
+#if defined(Q_OS_WIN) || defined(Q_OS_MACOS) || defined(Q_OS_LINUX)
+    return true;
+#else
+    return false;
+#endif
+}
+
+Level current()
+{
+    if (t_level < 0) {
+        t_level = static_cast<int>(osLevel());
+    }
+    return static_cast<Level>(t_level);
+}
+
+bool apply(Level level)
+{
+    if (current() == level) {
+        return true;
+    }
+    if (!applyToOs(level)) {
+        if (!s_refusalLogged.exchange(true)) {
+            CP_CLOG(cp_concurrency).noquote() << QStringLiteral("[ThreadQos] the OS refused to move a worker from %1 to %2")
+                                                     .arg(name(current()), name(level));
+        }
+        return false;
+    }
+    t_level = static_cast<int>(level);
+    return true;
+}
+
+QThread::Priority threadPriority(Level level)
+{
+    switch (level) {
+    case Level::Utility:       return QThread::LowPriority;
+    case Level::Background:    return QThread::IdlePriority;
+    case Level::UserInitiated: break;
+    }
+    return QThread::InheritPriority;
+}
+
+QString name(Level level)
+{
+    switch (level) {
+    case Level::Utility:       return QStringLiteral("utility");
+    case Level::Background:    return QStringLiteral("background");
+    case Level::UserInitiated: break;
+    }
+    return QStringLiteral("user-initiated");
+}
+
+} // namespace ThreadQos
@@ -0,0 +1,68 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <QString>
+#include <QThread>
+
+// Operating system scheduling class of a worker thread.
+//
+// The engine runs the Cpu work of batch runs on worker pools whose threads sit at a
+// lower level than interactive ones, so a long indexing job or batch loop only takes
+// the cores interactive runs and the GUI leave idle. macOS maps the levels to the QoS
+// classes USER_INITIATED, UTILITY and BACKGROUND; Linux to nice 0, nice +10 and
+// SCHED_IDLE; Windows to normal, below normal and lowest thread priority.
+//
+// Linux does not let an unprivileged thread raise itself again, and threads inherit
+// their creator's level on every platform. Lowered threads are therefore kept in
+// their own pools, and work that must not run low is never started from them
+// directly (see ExecutionEngine::launchTask()).
+namespace ThreadQos {
+
+// Most to least urgent
+enum class Level {
+    UserInitiated,
+    Utility,
+    Background
+};
+constexpr int kLevelCount = 3;
+
+// Whether this platform can set thread levels at all
+bool isSupported();
+
+// The calling thread's level, read from the OS the first time
+Level current();
+
+// Moves the calling thread to level. Returns false when the OS refused, in which
+// case the thread keeps its previous level.
+bool apply(Level level);
+
+// Priority for QThreadPool::setThreadPriority(), so a pool's new threads start close
+// to its level before their first task applies it
+QThread::Priority threadPriority(Level level);
+
+QString name(Level level);
+
+} // namespace ThreadQos
@@ -0,0 +1,223 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "WorkStealingScheduler.h"
+
+#include <QThreadPool>
+
+#include <algorithm>
+
+namespace {
+
+// Identifies the lane owned by the current pool thread, if any.
+thread_local const WorkStealingScheduler* t_owner = nullptr;
+thread_local int t_laneIndex = -1;
+
+} // namespace
+
+WorkStealingScheduler::WorkStealingScheduler(QThreadPool* pool)
+    : m_pool(pool)
+    , m_lanes(kMaxLanes)
+{
+    setLaneCount(pool ? pool->maxThreadCount() : 1);
+}
+
+WorkStealingScheduler::~WorkStealingScheduler()
+{
+    clear();
+    if (m_pool) {
+        m_pool->waitForDone();
+    }
+}
+
+int WorkStealingScheduler::bandForPriority(int priority)
+{
+    if (priority >= 200) return 0;
+    if (priority >= 100) return 1;
+    return 2;
+}
+
+void WorkStealingScheduler::post(int priority, Job job)
+{
+    for (;;) {
+        const int laneCount = m_laneCount.load(std::memory_order_acquire);
+        int laneIndex = -1;
+        if (t_owner == this && t_laneIndex >= 0 && t_laneIndex < laneCount) {
+            laneIndex = t_laneIndex;
+        } else {
+            laneIndex = static_cast<int>(m_nextPostLane.fetch_add(1, std::memory_order_relaxed) % laneCount);
+        }
+
+        Lane& lane = *m_lanes[static_cast<size_t>(laneIndex)];
+        QMutexLocker locker(&lane.mutex);
+        // A shrink drains retired lanes under their lock after publishing the new count
+        if (laneIndex >= m_laneCount.load(std::memory_order_acquire)) continue;
+        lane.bands[bandForPriority(priority)].push_back(std::move(job));
+        break;
+    }
+    // Sequentially consistent with the retire check in workerLoop(): either a retiring
+    // worker sees this job or ensureWorker() sees that worker gone
+    m_queued.fetch_add(1);
+    ensureWorker();
+}
+
+void WorkStealingScheduler::setLaneCount(int count)
+{
+    count = std::clamp(count, 1, kMaxLanes);
+    QMutexLocker resizeLocker(&m_resizeMutex);
+    const int previous = m_laneCount.load(std::memory_order_acquire);
+    if (count == previous) return;
+
+    if (count > previous) {
+        for (int i = previous; i < count; ++i) {
+            if (!m_lanes[static_cast<size_t>(i)]) m_lanes[static_cast<size_t>(i)] = std::make_unique<Lane>();
+        }
+        m_laneCount.store(count, std::memory_order_release);
+        // Lanes that were empty before may now have work posted; add workers for them
+        if (m_queued.load() > 0) ensureWorker();
+        return;
+    }
+
+    m_laneCount.store(count, std::memory_order_release);
+    for (int i = count; i < previous; ++i) {
+        std::deque<Job> moved[kBandCount];
+        {
+            Lane& retired = *m_lanes[static_cast<size_t>(i)];
+            QMutexLocker locker(&retired.mutex);
+            for (int band = 0; band < kBandCount; ++band) moved[band].swap(retired.bands[band]);
+        }
+        Lane& target = *m_lanes[static_cast<size_t>(i % count)];
+        QMutexLocker locker(&target.mutex);
+        for (int band = 0; band < kBandCount; ++band) {
+            for (Job& job : moved[band]) target.bands[band].push_back(std::move(job));
+        }
+    }
+}
+
+void WorkStealingScheduler::clear()
+{
+    for (auto& lane : m_lanes) {
+        if (!lane) break;
+        QMutexLocker locker(&lane->mutex);
+        int dropped = 0;
+        for (auto& band : lane->bands) {
+            dropped += static_cast<int>(band.size());
+            band.clear();
+        }
+        if (dropped > 0) {
+            m_queued.fetch_sub(dropped, std::memory_order_acq_rel);
+        }
+    }
+}
+
+bool WorkStealingScheduler::popLocal(int laneIndex, Job& out)
+{
+    Lane& lane = *m_lanes[static_cast<size_t>(laneIndex)];
+    QMutexLocker locker(&lane.mutex);
+    for (auto& band : lane.bands) {
+        if (band.empty()) continue;
+        // Owner takes the newest job: it is the most likely to have warm inputs
+        out = std::move(band.back());
+        band.pop_back();
+        m_queued.fetch_sub(1, std::memory_order_acq_rel);
+        return true;
+    }
+    return false;
+}
+
+bool WorkStealingScheduler::steal(int thiefIndex, Job& out)
+{
+    const int laneCount = m_laneCount.load(std::memory_order_acquire);
+    // Respect priority across lanes: look for the best band everywhere before
+    // falling back to a lower one.
+    for (int bandIndex = 0; bandIndex < kBandCount; ++bandIndex) {
+        for (int offset = 0; offset < laneCount; ++offset) {
+            // A worker whose lane was retired visits every remaining lane
+            const int victimIndex = (thiefIndex + 1 + offset) % laneCount;
+            if (victimIndex == thiefIndex) continue;
+            Lane& victim = *m_lanes[static_cast<size_t>(victimIndex)];
+            QMutexLocker locker(&victim.mutex);
+            auto& band = victim.bands[bandIndex];
+            if (band.empty()) continue;
+            // Thieves take the oldest job from the opposite end of the deque
+            out = std::move(band.front());
+            band.pop_front();
+            m_queued.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingScheduler::ensureWorker()
+{
+    const int laneCount = m_laneCount.load(std::memory_order_acquire);
+    int running = m_runningWorkers.load();
+    while (running < laneCount) {
+        if (m_runningWorkers.compare_exchange_weak(running, running + 1)) {
+            const int laneIndex = static_cast<int>(m_nextWorkerLane.fetch_add(1, std::memory_order_relaxed) % laneCount);
+            m_pool->start([this, laneIndex]() { workerLoop(laneIndex); });
+            return;
+        }
+    }
+}
+
+void WorkStealingScheduler::workerLoop(int laneIndex)
+{
+    t_owner = this;
+    t_laneIndex = laneIndex;
+
+    for (;;) {
+        Job job;
+        if (popLocal(laneIndex, job) || steal(laneIndex, job)) {
+            job();
+            continue;
+        }
+
+        // Nothing to do: retire, unless work arrived after our last look and
+        // no other worker is left to pick it up. The decrement and the load are
+        // sequentially consistent, pairing with post()'s increment and
+        // ensureWorker()'s load: acquire/release alone would let both sides miss
+        // each other's write and strand the job.
+        m_runningWorkers.fetch_sub(1);
+        if (m_queued.load() == 0) {
+            break;
+        }
+        int running = m_runningWorkers.load();
+        const int laneCount = m_laneCount.load(std::memory_order_acquire);
+        bool rejoined = false;
+        while (running < laneCount) {
+            if (m_runningWorkers.compare_exchange_weak(running, running + 1)) {
+                rejoined = true;
+                break;
+            }
+        }
+        if (!rejoined) {
+            break;
+        }
+    }
+
+    t_owner = nullptr;
+    t_laneIndex = -1;
+}
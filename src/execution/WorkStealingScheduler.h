@@ -0,0 +1,96 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QMutex>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class QThreadPool;
+
+// Work-stealing job scheduler used by ExecutionEngine's WorkStealing mode.
+//
+// Each worker owns a lane with one deque per priority band. Jobs posted from a
+// worker thread land in that worker's own lane; jobs posted from other threads
+// are spread round-robin. An idle worker first drains its own lane (newest job
+// first) and then steals the oldest job from the other lanes, so no single lock
+// is shared by every scheduling and completion path. The lane count, and so the
+// number of workers, follows setLaneCount(); ExecutionEngine keeps it at the Cpu
+// budget.
+class WorkStealingScheduler {
+public:
+    using Job = std::function<void()>;
+
+    explicit WorkStealingScheduler(QThreadPool* pool);
+    ~WorkStealingScheduler();
+
+    WorkStealingScheduler(const WorkStealingScheduler&) = delete;
+    WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+
+    // Queue a job. Higher priority values run first (see ExecutionEngine::TaskPriority).
+    void post(int priority, Job job);
+
+    // Drop all queued jobs that have not started yet.
+    void clear();
+
+    // Resizes to count lanes (1..kMaxLanes). Jobs queued on lanes that go are moved
+    // to the remaining ones; their workers finish by stealing and then retire.
+    void setLaneCount(int count);
+    int laneCount() const { return m_laneCount.load(std::memory_order_acquire); }
+
+    int queuedCount() const { return m_queued.load(std::memory_order_acquire); }
+
+    // The highest Cpu budget ResourceBudgets accepts
+    static constexpr int kMaxLanes = 1024;
+
+private:
+    static constexpr int kBandCount = 3;
+
+    struct Lane {
+        QMutex mutex;
+        std::deque<Job> bands[kBandCount]; // 0 = High, 1 = Normal, 2 = Low
+    };
+
+    static int bandForPriority(int priority);
+
+    bool popLocal(int laneIndex, Job& out);
+    bool steal(int thiefIndex, Job& out);
+    void ensureWorker();
+    void workerLoop(int laneIndex);
+
+    QThreadPool* m_pool {nullptr};
+    // kMaxLanes slots, filled up to the largest count so far and never moved, so
+    // readers index them without a lock; m_laneCount says how many are in use
+    std::vector<std::unique_ptr<Lane>> m_lanes;
+    std::atomic<int> m_laneCount {0};
+    QMutex m_resizeMutex;
+    std::atomic<int> m_queued {0};
+    std::atomic<int> m_runningWorkers {0};
+    std::atomic<unsigned int> m_nextPostLane {0};
+    std::atomic<unsigned int> m_nextWorkerLane {0};
+};
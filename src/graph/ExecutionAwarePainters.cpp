@@ -3,9 +3,19 @@
 #include "NodeGraphModel.h"
 
 #include <QLinearGradient>
+#include <algorithm>
+#include <cmath>
+#include <QEvent>
+#include <QGraphicsProxyWidget>
+#include <QGraphicsView>
 #include <QPainter>
 #include <QPainterPath>
+#include <QPixmapCache>
+#include <QScrollBar>
+#include <QStyleOptionGraphicsItem>
+#include <QTimer>
 #include <QJsonDocument>
+#include <QtMath>
 #include <QtNodes/internal/NodeStyle.hpp>
 #include <QtNodes/internal/StyleCollection.hpp>
 #include <QtNodes/internal/DefaultNodePainter.hpp>
@@ -17,6 +27,8 @@ static inline bool isActiveState(ExecutionState s)
     return s == ExecutionState::Running || s == ExecutionState::Finished || s == ExecutionState::Error;
 }
 
+static const QColor kCriticalPathColor("#E67E22");
+
 static inline QColor colorFor(ExecutionState state)
 {
     switch (state) {
@@ -49,10 +61,12 @@ void ExecutionAwareNodePainter::paint(QPainter *painter, NodeGraphicsObject &ngo
 
     // Determine execution state and state-dependent color
     ExecutionState st = ExecutionState::Idle;
+    bool critical = false;
     if (model_) {
         const QString scopeKey = graphModel_ ? graphModel_->executionScopeKey() : QStringLiteral("root");
         const QUuid id = ExecIds::nodeUuid(scopeKey, nodeId);
         st = model_->stateFor(id);
+        critical = model_->isOnCriticalPath(id);
     }
 
     QColor idleColor = QColor("#808080");
@@ -69,32 +83,32 @@ void ExecutionAwareNodePainter::paint(QPainter *painter, NodeGraphicsObject &ngo
         default:                       borderColor = idleColor; break;
     }
 
-    // Step 1: Draw node body fill (gradient) without border
     QRectF boundary(0, 0, size.width(), size.height());
     double const radius = 3.0;
-    {
-        painter->setPen(Qt::NoPen);
-        
-        QLinearGradient gradient(QPointF(0.0, 0.0), QPointF(2.0, size.height()));
-        gradient.setColorAt(0.0, nodeStyle.GradientColor0);
-        gradient.setColorAt(0.10, nodeStyle.GradientColor1);
-        gradient.setColorAt(0.90, nodeStyle.GradientColor2);
-        gradient.setColorAt(1.0, nodeStyle.GradientColor3);
-        painter->setBrush(gradient);
-        
-        painter->drawRoundedRect(boundary, radius, radius);
-    }
+    const qreal titleH = geometry.captionRect(nodeId).height() + 8.0; // small padding similar to default visuals
+    const qreal detail = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
 
-    // Step 2: Draw the execution-color title bar background (fill only, no border)
-    {
-        const QRectF capRect = geometry.captionRect(nodeId);
-        const qreal titleH = capRect.height() + 8.0; // small padding similar to default visuals
-        QRectF titleBar(0, 0, size.width(), titleH);
+    // Zoomed out: a flat box in the state colour, with nothing too small to read
+    if (detail < kSimplifiedNodeDetail) {
         painter->save();
-        painter->setPen(Qt::NoPen);
-        painter->setBrush(borderColor);
-        painter->drawRect(titleBar);
+        painter->setRenderHint(QPainter::Antialiasing, false);
+        painter->fillRect(boundary, nodeStyle.GradientColor1);
+        painter->fillRect(QRectF(0, 0, size.width(), titleH), borderColor);
+        QPen pen(ngo.isSelected() ? QColor("#FFD700") : (critical ? kCriticalPathColor : borderColor));
+        pen.setCosmetic(true);
+        pen.setWidthF(ngo.isSelected() || critical ? 3.0 : 1.0);
+        painter->setPen(pen);
+        painter->setBrush(Qt::NoBrush);
+        painter->drawRect(boundary);
         painter->restore();
+        return;
+    }
+
+    // Steps 1 and 2: gradient body and execution-colour title bar, from the pixmap cache
+    {
+        const qreal deviceScale = detail * painter->device()->devicePixelRatioF();
+        const QPixmap background = cachedBackground(nodeStyle, size, titleH, borderColor, deviceScale);
+        painter->drawPixmap(boundary, background, QRectF(background.rect()));
     }
 
     // Step 3: Draw border outline on top of all fills
@@ -116,6 +130,13 @@ void ExecutionAwareNodePainter::paint(QPainter *painter, NodeGraphicsObject &ngo
         painter->setBrush(Qt::NoBrush);
         
         painter->drawRoundedRect(boundary, radius, radius);
+
+        // Critical path of the last analysed run: dashed outline just outside the border
+        if (critical) {
+            QPen criticalPen(kCriticalPathColor, 2.0, Qt::DashLine);
+            painter->setPen(criticalPen);
+            painter->drawRoundedRect(boundary.adjusted(-4.0, -4.0, 4.0, 4.0), radius + 2.0, radius + 2.0);
+        }
     }
 
     // 3) Draw connection points and filled points (these should appear on top of the title bar fill)
@@ -142,13 +163,10 @@ void ExecutionAwareNodePainter::paint(QPainter *painter, NodeGraphicsObject &ngo
             // Nudge up a bit more to better center within the colored title bar
             pos.ry() -= 4.0; // move text up by ~4 px total
 
-            QJsonDocument json2 = QJsonDocument::fromVariant(model2.nodeData(nodeId2, NodeRole::Style));
-            NodeStyle nodeStyle2(json2.object());
-
             if (isActiveState(st)) {
                 painter->setPen(Qt::black); // strong contrast on pastel backgrounds
             } else {
-                painter->setPen(nodeStyle2.FontColor); // default for Idle
+                painter->setPen(nodeStyle.FontColor); // default for Idle
             }
 
             painter->drawText(pos, name);
@@ -163,6 +181,53 @@ void ExecutionAwareNodePainter::paint(QPainter *painter, NodeGraphicsObject &ngo
     defaultPainter.drawResizeRect(painter, ngo);
 }
 
+QPixmap ExecutionAwareNodePainter::cachedBackground(const NodeStyle& style, const QSize& size, qreal titleHeight,
+                                                   const QColor& titleColor, qreal deviceScale)
+{
+    // Quarter steps keep zooming from filling the cache with near-identical pixmaps
+    const qreal scale = std::clamp(std::ceil(deviceScale * 4.0) / 4.0, 0.25, 4.0);
+    const QString key = QStringLiteral("cp-node-bg:%1x%2:%3:%4:%5:%6:%7:%8:%9")
+                            .arg(size.width())
+                            .arg(size.height())
+                            .arg(titleHeight)
+                            .arg(titleColor.rgba())
+                            .arg(style.GradientColor0.rgba())
+                            .arg(style.GradientColor1.rgba())
+                            .arg(style.GradientColor2.rgba())
+                            .arg(style.GradientColor3.rgba())
+                            .arg(scale);
+
+    QPixmap pixmap;
+    if (QPixmapCache::find(key, &pixmap)) {
+        return pixmap;
+    }
+
+    pixmap = QPixmap(QSize(qCeil(size.width() * scale), qCeil(size.height() * scale)));
+    pixmap.setDevicePixelRatio(scale);
+    pixmap.fill(Qt::transparent);
+
+    QPainter painter(&pixmap);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    painter.setPen(Qt::NoPen);
+    const QRectF boundary(0, 0, size.width(), size.height());
+    double const radius = 3.0;
+
+    QLinearGradient gradient(QPointF(0.0, 0.0), QPointF(2.0, size.height()));
+    gradient.setColorAt(0.0, style.GradientColor0);
+    gradient.setColorAt(0.10, style.GradientColor1);
+    gradient.setColorAt(0.90, style.GradientColor2);
+    gradient.setColorAt(1.0, style.GradientColor3);
+    painter.setBrush(gradient);
+    painter.drawRoundedRect(boundary, radius, radius);
+
+    painter.setBrush(titleColor);
+    painter.drawRect(QRectF(0, 0, size.width(), titleHeight));
+    painter.end();
+
+    QPixmapCache::insert(key, pixmap);
+    return pixmap;
+}
+
 QPen ExecutionAwareConnectionPainter::highlightPenFor(ExecutionState state)
 {
     QPen p{colorFor(state)};
@@ -177,15 +242,19 @@ void ExecutionAwareConnectionPainter::paint(QPainter *painter, ConnectionGraphic
     // Fully override the default connection drawing. We draw the cubic path ourselves
     // using a state-specific color and the default line width.
     painter->save();
-    painter->setRenderHint(QPainter::Antialiasing, true);
+    // Antialiasing hundreds of curves is most of the cost when zoomed out
+    const qreal detail = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    painter->setRenderHint(QPainter::Antialiasing, detail >= kSimplifiedNodeDetail);
     painter->setBrush(Qt::NoBrush);
 
     // Determine execution state (Idle if no model or unknown)
     ExecutionState st = ExecutionState::Idle;
+    bool critical = false;
     if (model_) {
         const QString scopeKey = graphModel_ ? graphModel_->executionScopeKey() : QStringLiteral("root");
         const QUuid id = ExecIds::connectionUuid(scopeKey, cgo.connectionId());
         st = model_->stateFor(id);
+        critical = model_->isOnCriticalPath(id);
     }
 
     // State colors
@@ -215,6 +284,9 @@ void ExecutionAwareConnectionPainter::paint(QPainter *painter, ConnectionGraphic
     if (selected) {
         finalPenColor = QColor("#FFD700"); // Gold for high-contrast selection
         finalPenWidth = 4.0; // Thicker line for visibility
+    } else if (critical) {
+        finalPenColor = kCriticalPathColor;
+        finalPenWidth = std::max<qreal>(finalPenWidth, 3.0);
     }
 
     QPen pen(finalPenColor);
@@ -247,3 +319,77 @@ QPainterPath ExecutionAwareConnectionPainter::getPainterStroke(ConnectionGraphic
     
     return path;
 }
+
+namespace {
+// Set on embedded widget proxies this controller hid, so it only shows those again
+const char* const kDetailHiddenProperty = "cpDetailHidden";
+} // namespace
+
+CanvasDetailController::CanvasDetailController(QGraphicsView* view)
+    : QObject(view)
+    , view_(view)
+    , refreshTimer_(new QTimer(this))
+{
+    refreshTimer_->setSingleShot(true);
+    refreshTimer_->setInterval(16);
+    connect(refreshTimer_, &QTimer::timeout, this, &CanvasDetailController::refresh);
+    connect(view_->horizontalScrollBar(), &QScrollBar::valueChanged, this, &CanvasDetailController::scheduleRefresh);
+    connect(view_->verticalScrollBar(), &QScrollBar::valueChanged, this, &CanvasDetailController::scheduleRefresh);
+    // Zooming changes the transform without a signal; it always follows one of these events
+    view_->viewport()->installEventFilter(this);
+    view_->installEventFilter(this);
+}
+
+bool CanvasDetailController::eventFilter(QObject* watched, QEvent* event)
+{
+    switch (event->type()) {
+    case QEvent::Resize:
+    case QEvent::Wheel:
+    case QEvent::KeyRelease:
+    case QEvent::MouseButtonRelease:
+    case QEvent::Show:
+        scheduleRefresh();
+        break;
+    default:
+        break;
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void CanvasDetailController::scheduleRefresh()
+{
+    if (!refreshTimer_->isActive()) {
+        refreshTimer_->start();
+    }
+}
+
+void CanvasDetailController::refresh()
+{
+    QGraphicsScene* scene = view_ ? view_->scene() : nullptr;
+    if (!scene) {
+        return;
+    }
+
+    const bool detailed = QStyleOptionGraphicsItem::levelOfDetailFromTransform(view_->transform()) >= kSimplifiedNodeDetail;
+    // A margin keeps widgets already shown when a node scrolls into view
+    const QRectF visible = view_->mapToScene(view_->viewport()->rect())
+                               .boundingRect()
+                               .adjusted(-200.0, -200.0, 200.0, 200.0);
+
+    const QList<QGraphicsItem*> items = scene->items();
+    for (QGraphicsItem* item : items) {
+        auto* proxy = qgraphicsitem_cast<QGraphicsProxyWidget*>(item);
+        if (!proxy || !proxy->parentItem()) {
+            continue;
+        }
+        const bool wanted = detailed && visible.intersects(proxy->parentItem()->sceneBoundingRect());
+        const bool hiddenByUs = proxy->property(kDetailHiddenProperty).toBool();
+        if (!wanted && proxy->isVisible()) {
+            proxy->setProperty(kDetailHiddenProperty, true);
+            proxy->setVisible(false);
+        } else if (wanted && hiddenByUs) {
+            proxy->setProperty(kDetailHiddenProperty, false);
+            proxy->setVisible(true);
+        }
+    }
+}
@@ -11,6 +11,8 @@
 #include <memory>
 
 #include <QColor>
+#include <QObject>
+#include <QPixmap>
 #include <QPen>
 
 #include <QtNodes/internal/AbstractNodePainter.hpp>
@@ -19,11 +21,18 @@
 #include <QtNodes/internal/ConnectionGraphicsObject.hpp>
 #include <QtNodes/internal/AbstractNodeGeometry.hpp>
 #include <QtNodes/internal/BasicGraphicsScene.hpp>
+#include <QtNodes/internal/NodeStyle.hpp>
 
 #include "ExecutionStateModel.h"
 #include "ExecutionIdUtils.h"
 
 class NodeGraphModel;
+class QGraphicsView;
+class QTimer;
+
+// Below this level of detail (view scale, 1.0 = 100%) nodes are drawn as flat boxes
+// with no ports, labels or caption, and their embedded widgets are hidden.
+inline constexpr qreal kSimplifiedNodeDetail = 0.45;
 
 class ExecutionAwareNodePainter : public QtNodes::AbstractNodePainter
 {
@@ -37,6 +46,10 @@ public:
 
 private:
     static QPen highlightPenFor(ExecutionState state);
+    // Gradient body and title bar, rendered once per size, state, style and scale
+    // bucket and shared through QPixmapCache
+    static QPixmap cachedBackground(const QtNodes::NodeStyle& style, const QSize& size, qreal titleHeight,
+                                    const QColor& titleColor, qreal deviceScale);
 
 private:
     std::shared_ptr<ExecutionStateModel> model_;
@@ -61,3 +74,26 @@ private:
     std::shared_ptr<ExecutionStateModel> model_;
     NodeGraphModel* graphModel_ {nullptr};
 };
+
+// Keeps a large canvas cheap to pan and zoom. Embedded node widgets are hidden
+// while their node is off screen or the view is zoomed out past
+// kSimplifiedNodeDetail, so they neither paint nor trigger repaints. Updates are
+// coalesced to one pass per frame after scrolling, zooming or resizing.
+class CanvasDetailController : public QObject
+{
+public:
+    explicit CanvasDetailController(QGraphicsView* view);
+
+    // Re-evaluates every embedded widget now; normally called from the frame timer
+    void refresh();
+    // For changes the controller cannot see, such as a new scene or fitInView()
+    void scheduleRefresh();
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+private:
+
+    QGraphicsView* view_ {nullptr};
+    QTimer* refreshTimer_ {nullptr};
+};
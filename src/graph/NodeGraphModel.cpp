@@ -57,9 +57,14 @@
 #include "CrexxRuntime.h"
 #endif
 #include "ExecutionIdUtils.h"
+#include "ExecutionPlan.h"
+#include "Logger.h"
 
+#include <QJsonArray>
 #include <QJsonObject>
+#include <QMutexLocker>
 #include <QReadLocker>
+#include <QThread>
 #include <QWriteLocker>
 
 namespace {
@@ -115,6 +120,13 @@ NodeGraphModel::NodeGraphModel(QObject* parent, GraphKind kind, const QString& e
     // By overriding setPortData below to return false without forwarding to NodeDelegateModel,
     // we prevent QtNodes from calling ToolNodeDelegate::setInData during connection changes/load.
 
+    // Any topology or port change makes the cached body plan stale
+    connect(this, &NodeGraphModel::nodeCreated, this, &NodeGraphModel::invalidateExecutionPlan);
+    connect(this, &NodeGraphModel::nodeDeleted, this, &NodeGraphModel::invalidateExecutionPlan);
+    connect(this, &NodeGraphModel::nodeUpdated, this, &NodeGraphModel::invalidateExecutionPlan);
+    connect(this, &NodeGraphModel::connectionCreated, this, &NodeGraphModel::invalidateExecutionPlan);
+    connect(this, &NodeGraphModel::connectionDeleted, this, &NodeGraphModel::invalidateExecutionPlan);
+
     auto registry = dataModelRegistry();
 
     // Register PromptBuilderNode via the generic ToolNodeDelegate adapter
@@ -256,6 +268,9 @@ NodeGraphModel::NodeGraphModel(QObject* parent, GraphKind kind, const QString& e
                                               frame,
                                               parentInputs);
         });
+        tool->setBodyFingerprint([this](const QString& bodyId) {
+            return ScopeSubgraphExecutor::fingerprint(ensureSubgraph(bodyId, GraphKind::IteratorBody));
+        });
         return std::make_unique<ToolNodeDelegate>(tool);
     }, QStringLiteral("Control Flow"));
 
@@ -300,17 +315,36 @@ void NodeGraphModel::clear()
     for (auto id : ids) {
         deleteNode(id);
     }
+    QMutexLocker locker(&m_subgraphsMutex);
     m_subgraphs.clear();
+    m_pendingSubgraphs.clear();
 }
 
-QJsonObject NodeGraphModel::save() const
+QJsonObject NodeGraphModel::saveGraph() const
 {
     QJsonObject root = DataFlowGraphModel::save();
     root.insert(QStringLiteral("_graph_kind"), graphKindToString(m_graphKind));
+    if (!m_resourceBudgets.isEmpty()) {
+        root.insert(QStringLiteral("resource_budgets"), m_resourceBudgets);
+    }
+    return root;
+}
+
+QJsonObject NodeGraphModel::save() const
+{
+    QJsonObject root = saveGraph();
     QJsonObject subgraphs;
-    for (auto it = m_subgraphs.cbegin(); it != m_subgraphs.cend(); ++it) {
-        if (it->second) {
-            subgraphs.insert(it->first, it->second->save());
+    {
+        QMutexLocker locker(&m_subgraphsMutex);
+        for (auto it = m_subgraphs.cbegin(); it != m_subgraphs.cend(); ++it) {
+            if (it->second) {
+                subgraphs.insert(it->first, it->second->save());
+            }
+        }
+        // Unopened bodies go back out exactly as they were read
+        for (auto it = m_pendingSubgraphs.cbegin(); it != m_pendingSubgraphs.cend(); ++it) {
+            const PendingSubgraph& pending = it->second;
+            subgraphs.insert(it->first, pending.compact.isEmpty() ? pending.json : PipelineFormat::toJson(pending.compact));
         }
     }
     if (!subgraphs.isEmpty()) {
@@ -319,19 +353,151 @@ QJsonObject NodeGraphModel::save() const
     return root;
 }
 
+QByteArray NodeGraphModel::saveCompact() const
+{
+    QMap<QString, QByteArray> subgraphs;
+    {
+        QMutexLocker locker(&m_subgraphsMutex);
+        for (auto it = m_subgraphs.cbegin(); it != m_subgraphs.cend(); ++it) {
+            if (it->second) {
+                subgraphs.insert(it->first, it->second->saveCompact());
+            }
+        }
+        for (auto it = m_pendingSubgraphs.cbegin(); it != m_pendingSubgraphs.cend(); ++it) {
+            const PendingSubgraph& pending = it->second;
+            subgraphs.insert(it->first, pending.compact.isEmpty() ? PipelineFormat::fromJson(pending.json) : pending.compact);
+        }
+    }
+    return PipelineFormat::encode(saveGraph(), subgraphs);
+}
+
+QJsonObject NodeGraphModel::migrateLegacyPipeline(const QJsonObject& json)
+{
+    QJsonObject migrated = json;
+    QJsonArray nodesArray = migrated.value(QStringLiteral("nodes")).toArray();
+    for (int i = 0; i < nodesArray.size(); ++i) {
+        QJsonObject nodeObj = nodesArray.at(i).toObject();
+        QJsonObject internal = nodeObj.value(QStringLiteral("internal-data")).toObject();
+        const QString modelName = internal.value(QStringLiteral("model-name")).toString();
+        QString mapped = modelName;
+
+        if (modelName.isEmpty()) {
+            // Infer from known state keys when model-name is absent (older saves)
+            if (internal.contains(QStringLiteral("text"))) {
+                mapped = QStringLiteral("text-input");
+            } else if (internal.contains(QStringLiteral("template"))) {
+                mapped = QStringLiteral("prompt-builder");
+            } else if (internal.contains(QStringLiteral("apiKey")) || internal.contains(QStringLiteral("prompt"))) {
+                // Legacy LLM connector saves should map to universal-llm
+                mapped = QStringLiteral("universal-llm");
+            } else {
+                // Fallback to a safe default to allow loading
+                mapped = QStringLiteral("text-input");
+            }
+        } else {
+            // Remap legacy human-readable names to stable IDs
+            if (modelName == QStringLiteral("LLM Connector") || modelName == QStringLiteral("LLMConnector") ||
+                modelName == QStringLiteral("Google LLM Connector") || modelName == QStringLiteral("GoogleLLMConnector") ||
+                modelName == QStringLiteral("llm-connector") || modelName == QStringLiteral("google-llm-connector")) {
+                mapped = QStringLiteral("universal-llm");
+            } else if (modelName == QStringLiteral("Prompt Builder") || modelName == QStringLiteral("PromptBuilderNode")) {
+                mapped = QStringLiteral("prompt-builder");
+            } else if (modelName == QStringLiteral("Text Input") || modelName == QStringLiteral("TextInputNode")) {
+                mapped = QStringLiteral("text-input");
+            }
+        }
+
+        if ((mapped != modelName || modelName.isEmpty()) && !mapped.isEmpty()) {
+            internal.insert(QStringLiteral("model-name"), mapped);
+            nodeObj.insert(QStringLiteral("internal-data"), internal);
+            nodesArray.replace(i, nodeObj);
+        }
+    }
+    migrated.insert(QStringLiteral("nodes"), nodesArray);
+    return migrated;
+}
+
 void NodeGraphModel::load(const QJsonObject& json)
 {
     clear();
     DataFlowGraphModel::load(json);
+    m_resourceBudgets = json.value(QStringLiteral("resource_budgets")).toObject();
 
+    // Bodies are built when first shown or executed, so large pipelines open quickly
     const QJsonObject subgraphs = json.value(QStringLiteral("subgraphs")).toObject();
+    QMutexLocker locker(&m_subgraphsMutex);
     for (auto it = subgraphs.constBegin(); it != subgraphs.constEnd(); ++it) {
-        const QJsonObject childJson = it.value().toObject();
-        const GraphKind kind = graphKindFromString(childJson.value(QStringLiteral("_graph_kind")).toString());
-        auto child = std::make_unique<NodeGraphModel>(nullptr, kind, it.key());
-        child->load(childJson);
-        m_subgraphs.emplace(it.key(), std::move(child));
+        m_pendingSubgraphs.insert_or_assign(it.key(), PendingSubgraph{it.value().toObject(), QByteArray()});
+    }
+}
+
+void NodeGraphModel::loadGraph(const QJsonObject& graph, const QMap<QString, QByteArray>& compactSubgraphs)
+{
+    load(graph);
+    QMutexLocker locker(&m_subgraphsMutex);
+    for (auto it = compactSubgraphs.constBegin(); it != compactSubgraphs.constEnd(); ++it) {
+        m_pendingSubgraphs.insert_or_assign(it.key(), PendingSubgraph{QJsonObject(), it.value()});
+    }
+}
+
+bool NodeGraphModel::loadCompact(const QByteArray& data, QString* error)
+{
+    PipelineFormat::Container container;
+    if (!PipelineFormat::decode(data, container, error)) {
+        return false;
     }
+    loadCompact(container);
+    return true;
+}
+
+void NodeGraphModel::loadCompact(const PipelineFormat::Container& container)
+{
+    loadGraph(migrateLegacyPipeline(container.graph), container.subgraphs);
+}
+
+NodeGraphModel* NodeGraphModel::materializeSubgraph(const QString& subgraphId) const
+{
+    auto found = m_pendingSubgraphs.find(subgraphId);
+    if (found == m_pendingSubgraphs.end()) {
+        return nullptr;
+    }
+    const PendingSubgraph pending = std::move(found->second);
+    m_pendingSubgraphs.erase(found);
+
+    PipelineFormat::Container container;
+    if (pending.compact.isEmpty()) {
+        container.graph = pending.json;
+    } else {
+        QString error;
+        if (!PipelineFormat::decode(pending.compact, container, &error)) {
+            CP_WARN << "NodeGraphModel: could not read scope body" << subgraphId << ":" << error;
+        }
+    }
+
+    const GraphKind kind = graphKindFromString(container.graph.value(QStringLiteral("_graph_kind")).toString());
+    auto child = std::make_unique<NodeGraphModel>(nullptr, kind, subgraphId);
+    child->loadGraph(container.graph, container.subgraphs);
+
+    // A scope executed on a worker builds its body there; the canvas and the
+    // properties panel expect the body, its delegates and nodes on our thread.
+    QThread* owner = thread();
+    if (QThread::currentThread() != owner) {
+        child->moveToThread(owner);
+        for (const QtNodes::NodeId nodeId : child->allNodeIds()) {
+            auto* delegate = child->delegateModel<ToolNodeDelegate>(nodeId);
+            if (!delegate) {
+                continue;
+            }
+            delegate->moveToThread(owner);
+            if (auto* nodeObject = dynamic_cast<QObject*>(delegate->node().get())) {
+                nodeObject->moveToThread(owner);
+            }
+        }
+    }
+
+    NodeGraphModel* ptr = child.get();
+    m_subgraphs.emplace(subgraphId, std::move(child));
+    return ptr;
 }
 
 NodeGraphModel* NodeGraphModel::ensureSubgraph(const QString& subgraphId, GraphKind kind)
@@ -340,10 +506,14 @@ NodeGraphModel* NodeGraphModel::ensureSubgraph(const QString& subgraphId, GraphK
     if (id.isEmpty()) {
         return nullptr;
     }
+    QMutexLocker locker(&m_subgraphsMutex);
     auto it = m_subgraphs.find(id);
     if (it != m_subgraphs.end()) {
         return it->second.get();
     }
+    if (NodeGraphModel* loaded = materializeSubgraph(id)) {
+        return loaded;
+    }
 
     auto child = std::make_unique<NodeGraphModel>(nullptr, kind, id);
     NodeGraphModel* ptr = child.get();
@@ -358,12 +528,20 @@ NodeGraphModel* NodeGraphModel::ensureSubgraph(const QString& subgraphId)
 
 NodeGraphModel* NodeGraphModel::subgraph(const QString& subgraphId) const
 {
+    QMutexLocker locker(&m_subgraphsMutex);
     auto it = m_subgraphs.find(subgraphId);
-    return it == m_subgraphs.cend() ? nullptr : it->second.get();
+    return it == m_subgraphs.cend() ? materializeSubgraph(subgraphId) : it->second.get();
+}
+
+bool NodeGraphModel::isSubgraphLoaded(const QString& subgraphId) const
+{
+    QMutexLocker locker(&m_subgraphsMutex);
+    return m_subgraphs.find(subgraphId) != m_subgraphs.cend();
 }
 
 QList<NodeGraphModel*> NodeGraphModel::subgraphModels() const
 {
+    QMutexLocker locker(&m_subgraphsMutex);
     QList<NodeGraphModel*> models;
     for (auto it = m_subgraphs.cbegin(); it != m_subgraphs.cend(); ++it) {
         if (it->second) {
@@ -392,9 +570,8 @@ QList<QPair<QUuid, QString>> NodeGraphModel::getEntryPoints() const
             if (!desc.isEmpty()) {
                 label = desc;
             } else {
-                if (auto node = del->node()) {
-                    const NodeDescriptor d = node->getDescriptor();
-                    label = d.name;
+                if (del->node()) {
+                    label = del->descriptor().name;
                 }
             }
         }
@@ -448,6 +625,31 @@ void NodeGraphModel::reportNodeOutput(QtNodes::NodeId nodeId, const DataPacket&
     emit executionNodeOutputChanged(nodeId);
 }
 
+void NodeGraphModel::reportNodeExecutionStatus(const QUuid& nodeUuid, int state)
+{
+    emit executionNodeStatusChanged(nodeUuid, state);
+}
+
+void NodeGraphModel::reportConnectionExecutionStatus(const QUuid& connectionUuid, int state)
+{
+    emit executionConnectionStatusChanged(connectionUuid, state);
+}
+
+std::shared_ptr<const ExecutionPlan> NodeGraphModel::executionPlan() const
+{
+    QMutexLocker locker(&m_planMutex);
+    if (!m_executionPlan) {
+        m_executionPlan = ExecutionPlan::compile(const_cast<NodeGraphModel*>(this));
+    }
+    return m_executionPlan;
+}
+
+void NodeGraphModel::invalidateExecutionPlan()
+{
+    QMutexLocker locker(&m_planMutex);
+    m_executionPlan.reset();
+}
+
 QtNodes::NodeId NodeGraphModel::addNode(QString const nodeType)
 {
     // Call base class to create the node
@@ -473,7 +675,9 @@ bool NodeGraphModel::deleteNode(QtNodes::NodeId const nodeId)
 
     const bool deleted = DataFlowGraphModel::deleteNode(nodeId);
     if (deleted && !childBodyId.isEmpty()) {
+        QMutexLocker locker(&m_subgraphsMutex);
         m_subgraphs.erase(childBodyId);
+        m_pendingSubgraphs.erase(childBodyId);
     }
     return deleted;
 }
@@ -26,17 +26,24 @@
 #include <QtNodes/DataFlowGraphModel>
 
 #include <QObject>
+#include <QJsonObject>
 #include <QVariant>
 #include <QList>
+#include <QMap>
 #include <QPair>
 #include <QHash>
+#include <QMutex>
 #include <QReadWriteLock>
 #include <QUuid>
 
+#include <atomic>
 #include <map>
 #include <memory>
 
 #include "CommonDataTypes.h"
+#include "PipelineFormat.h"
+
+class ExecutionPlan;
 
 class NodeGraphModel : public QtNodes::DataFlowGraphModel
 {
@@ -66,6 +73,16 @@ public:
     // Persist nested child graphs alongside the visible graph.
     QJsonObject save() const override;
     void load(QJsonObject const &json) override;
+    // The same document as a PipelineFormat container. Bodies stay encoded until
+    // first used, and unopened ones are written back without re-encoding.
+    // loadCompact() applies migrateLegacyPipeline() itself.
+    QByteArray saveCompact() const;
+    bool loadCompact(const QByteArray& data, QString* error = nullptr);
+    // For callers that decoded the file up front to check it
+    void loadCompact(const PipelineFormat::Container& container);
+    // Maps legacy model names in a saved pipeline to current node ids (inferring them
+    // for very old saves) so the result can be passed to load().
+    static QJsonObject migrateLegacyPipeline(const QJsonObject& json);
 
     // Disable reactive data propagation from the base model. Our pipelines execute only via ExecutionEngine.
     bool setPortData(QtNodes::NodeId nodeId,
@@ -79,17 +96,35 @@ public:
     // Label resolution: ToolNodeDelegate::description() if non-empty, otherwise node type name from descriptor.
     QList<QPair<QUuid, QString>> getEntryPoints() const;
 
+    // Bodies read by load() stay as JSON until first asked for here, then are built
+    // once; a body built off this model's thread is handed over to it.
     NodeGraphModel* ensureSubgraph(const QString& subgraphId, GraphKind kind);
     NodeGraphModel* ensureSubgraph(const QString& subgraphId);
     NodeGraphModel* subgraph(const QString& subgraphId) const;
+    // Built bodies only; bodies still held as JSON have no outputs or widgets to visit.
     QList<NodeGraphModel*> subgraphModels() const;
+    bool isSubgraphLoaded(const QString& subgraphId) const;
     GraphKind graphKind() const { return m_graphKind; }
+    // Per-project concurrency overrides (ResourceBudgets JSON), saved with the root graph
+    QJsonObject resourceBudgets() const { return m_resourceBudgets; }
+    void setResourceBudgets(const QJsonObject& budgets) { m_resourceBudgets = budgets; }
     QString executionScopeKey() const { return m_executionScopeKey; }
     DataPacket nodeOutput(QtNodes::NodeId nodeId) const;
     void clearNodeExecutionOutputs();
     void reportNodeExecutionStatus(QtNodes::NodeId nodeId, int state);
     void reportConnectionExecutionStatus(const QtNodes::ConnectionId& connectionId, int state);
     void reportNodeOutput(QtNodes::NodeId nodeId, const DataPacket& packet);
+    // Same, for callers holding the execution uuids from an ExecutionPlan
+    void reportNodeExecutionStatus(const QUuid& nodeUuid, int state);
+    void reportConnectionExecutionStatus(const QUuid& connectionUuid, int state);
+
+    // Compiled topology of this graph, cached until the next node, connection or port
+    // change. Scope bodies execute every pass from it instead of re-walking the model.
+    std::shared_ptr<const ExecutionPlan> executionPlan() const;
+    // True while the graph is shown on a canvas. Hidden iterator bodies report
+    // execution states only for sampled passes.
+    void setExecutionObserved(bool observed) { m_executionObserved = observed; }
+    bool isExecutionObserved() const { return m_executionObserved; }
 
 signals:
     void childGraphOpenRequested(const QString& bodyId, const QString& title, int graphKind);
@@ -111,10 +146,29 @@ private:
     
     // Helper to establish signal connections for a node (used by both addNode and loadNode)
     void connectNodeSignals(QtNodes::NodeId nodeId);
+    void invalidateExecutionPlan();
+    // Expects m_subgraphsMutex to be held
+    NodeGraphModel* materializeSubgraph(const QString& subgraphId) const;
+    // save() without the "subgraphs" entry
+    QJsonObject saveGraph() const;
+    void loadGraph(const QJsonObject& graph, const QMap<QString, QByteArray>& compactSubgraphs);
+
+    // A saved body not built yet, as read: JSON, or an encoded PipelineFormat container
+    struct PendingSubgraph {
+        QJsonObject json;
+        QByteArray compact;
+    };
 
-    std::map<QString, std::unique_ptr<NodeGraphModel>> m_subgraphs;
+    mutable QMutex m_subgraphsMutex;
+    mutable std::map<QString, std::unique_ptr<NodeGraphModel>> m_subgraphs;
+    // Saved bodies not built yet, keyed like m_subgraphs
+    mutable std::map<QString, PendingSubgraph> m_pendingSubgraphs;
     GraphKind m_graphKind {GraphKind::Root};
     QString m_executionScopeKey {QStringLiteral("root")};
+    QJsonObject m_resourceBudgets;
     mutable QReadWriteLock m_nodeOutputsLock;
     QHash<QtNodes::NodeId, DataPacket> m_nodeOutputs;
+    mutable QMutex m_planMutex;
+    mutable std::shared_ptr<const ExecutionPlan> m_executionPlan;
+    std::atomic<bool> m_executionObserved {false};
 };
@@ -0,0 +1,97 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "NodeWidgetFactory.h"
+
+#include "ConditionalRouterNode.h"
+#include "CrexxControllerNode.h"
+#include "DatabaseNode.h"
+#include "GetInputNode.h"
+#include "GetItemNode.h"
+#include "HumanInputNode.h"
+#include "ImageGenNode.h"
+#include "ImageNode.h"
+#include "IngestInputNode.h"
+#include "IteratorScopeNode.h"
+#include "MermaidNode.h"
+#include "NodeInfoWidget.h"
+#include "PdfToImageNode.h"
+#include "ProcessNode.h"
+#include "PromptBuilderNode.h"
+#include "PythonScriptNode.h"
+#include "RagIndexerNode.h"
+#include "RagQueryNode.h"
+#include "SetItemResultNode.h"
+#include "SetOutputNode.h"
+#include "TextChunkerNode.h"
+#include "TextInputNode.h"
+#include "TextOutputNode.h"
+#include "ToolNodeDelegate.h"
+#include "TransformScopeNode.h"
+#include "UniversalLLMNode.h"
+#include "UniversalScriptNode.h"
+#include "VaultOutputNode.h"
+
+#include <utility>
+
+namespace {
+
+template <typename Node>
+bool tryCreate(IToolNode* node, QWidget** widget)
+{
+    if (auto* typed = dynamic_cast<Node*>(node)) {
+        *widget = typed->createConfigurationWidget(nullptr);
+        return true;
+    }
+    return false;
+}
+
+template <typename... Nodes>
+QWidget* createFor(IToolNode* node)
+{
+    QWidget* widget = nullptr;
+    (tryCreate<Nodes>(node, &widget) || ...);
+    return widget;
+}
+
+} // namespace
+
+void NodeWidgetFactory::install()
+{
+    ToolNodeDelegate::WidgetFactory factory;
+    factory.configurationWidget = [](IToolNode* node) {
+        return createFor<PromptBuilderNode, TextChunkerNode, TextInputNode, IngestInputNode, ImageNode,
+                         MermaidNode, PdfToImageNode, TextOutputNode, VaultOutputNode, ProcessNode,
+                         UniversalLLMNode, ImageGenNode, PythonScriptNode, DatabaseNode, RagIndexerNode,
+                         RagQueryNode, HumanInputNode, ConditionalRouterNode, CrexxControllerNode,
+                         TransformScopeNode, IteratorScopeNode, GetInputNode, SetOutputNode, GetItemNode,
+                         SetItemResultNode, UniversalScriptNode>(node);
+    };
+    factory.infoWidget = [](ToolNodeDelegate* delegate) -> QWidget* {
+        auto* widget = new NodeInfoWidget();
+        widget->setDescription(delegate->description());
+        QObject::connect(delegate, &ToolNodeDelegate::descriptionChanged, widget, &NodeInfoWidget::setDescription);
+        return widget;
+    };
+    ToolNodeDelegate::setWidgetFactory(std::move(factory));
+}
@@ -0,0 +1,139 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "PipelineFormat.h"
+
+#include <QCborMap>
+#include <QCborParserError>
+#include <QCborValue>
+#include <QJsonValue>
+
+namespace {
+
+const QString kFormatKey = QStringLiteral("format");
+const QString kFormatName = QStringLiteral("cognitive-pipeline");
+const QString kVersionKey = QStringLiteral("version");
+const QString kGraphKey = QStringLiteral("graph");
+const QString kSubgraphsKey = QStringLiteral("subgraphs");
+
+void setError(QString* error, const QString& message)
+{
+    if (error) {
+        *error = message;
+    }
+}
+
+} // namespace
+
+namespace PipelineFormat {
+
+bool isCompact(const QByteArray& data)
+{
+    // Tag 55799 encodes as d9 d9 f7
+    return data.size() >= 3 && static_cast<unsigned char>(data[0]) == 0xd9
+        && static_cast<unsigned char>(data[1]) == 0xd9 && static_cast<unsigned char>(data[2]) == 0xf7;
+}
+
+bool isCompactPath(const QString& path)
+{
+    return path.endsWith(QLatin1String(".cflow"), Qt::CaseInsensitive);
+}
+
+QByteArray encode(const QJsonObject& graph, const QMap<QString, QByteArray>& subgraphs)
+{
+    QCborMap bodies;
+    for (auto it = subgraphs.constBegin(); it != subgraphs.constEnd(); ++it) {
+        bodies.insert(it.key(), it.value());
+    }
+
+    QCborMap container;
+    container.insert(kFormatKey, kFormatName);
+    container.insert(kVersionKey, kVersion);
+    container.insert(kGraphKey, QCborMap::fromJsonObject(graph));
+    if (!bodies.isEmpty()) {
+        container.insert(kSubgraphsKey, bodies);
+    }
+    return QCborValue(QCborKnownTags::Signature, container).toCbor();
+}
+
+bool decode(const QByteArray& data, Container& container, QString* error)
+{
+    QCborParserError parseError;
+    QCborValue value = QCborValue::fromCbor(data, &parseError);
+    if (parseError.error != QCborError::NoError) {
+        setError(error, QStringLiteral("Invalid compact pipeline: %1").arg(parseError.errorString()));
+        return false;
+    }
+    if (value.isTag() && value.tag() == QCborTag(QCborKnownTags::Signature)) {
+        value = value.taggedValue();
+    }
+
+    const QCborMap map = value.toMap();
+    if (map.value(kFormatKey).toString() != kFormatName) {
+        setError(error, QStringLiteral("Not a compact pipeline file"));
+        return false;
+    }
+    const qint64 version = map.value(kVersionKey).toInteger();
+    if (version < 1 || version > kVersion) {
+        setError(error, QStringLiteral("Unsupported compact pipeline version %1").arg(version));
+        return false;
+    }
+
+    container.graph = map.value(kGraphKey).toMap().toJsonObject();
+    container.subgraphs.clear();
+    const QCborMap bodies = map.value(kSubgraphsKey).toMap();
+    for (auto it = bodies.constBegin(); it != bodies.constEnd(); ++it) {
+        container.subgraphs.insert(it.key().toString(), it.value().toByteArray());
+    }
+    return true;
+}
+
+QByteArray fromJson(const QJsonObject& pipeline)
+{
+    QJsonObject graph = pipeline;
+    const QJsonObject subgraphs = graph.take(kSubgraphsKey).toObject();
+    QMap<QString, QByteArray> bodies;
+    for (auto it = subgraphs.constBegin(); it != subgraphs.constEnd(); ++it) {
+        bodies.insert(it.key(), fromJson(it.value().toObject()));
+    }
+    return encode(graph, bodies);
+}
+
+QJsonObject toJson(const QByteArray& data, QString* error)
+{
+    Container container;
+    if (!decode(data, container, error)) {
+        return {};
+    }
+    QJsonObject pipeline = container.graph;
+    QJsonObject subgraphs;
+    for (auto it = container.subgraphs.constBegin(); it != container.subgraphs.constEnd(); ++it) {
+        subgraphs.insert(it.key(), toJson(it.value(), error));
+    }
+    if (!subgraphs.isEmpty()) {
+        pipeline.insert(kSubgraphsKey, subgraphs);
+    }
+    return pipeline;
+}
+
+} // namespace PipelineFormat
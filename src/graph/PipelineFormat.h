@@ -0,0 +1,61 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QMap>
+#include <QString>
+
+// Compact binary pipeline files (".cflow"), next to the JSON ".flow" format.
+//
+// A file is one CBOR map behind the self-describe tag:
+//   { "format": "cognitive-pipeline", "version": 1,
+//     "graph": <the graph's own save() JSON, without "subgraphs">,
+//     "subgraphs": { <body id>: <byte string holding that body's container> } }
+// Each scope body is a container of its own, so a reader takes the root topology
+// and leaves bodies encoded until they are opened or run, and a writer copies an
+// untouched body's bytes instead of encoding it again. The conversions below go
+// to and from the JSON format losslessly.
+namespace PipelineFormat {
+
+struct Container {
+    QJsonObject graph;
+    QMap<QString, QByteArray> subgraphs;
+};
+
+inline constexpr int kVersion = 1;
+
+// Sniffs the leading self-describe tag, so any extension can be opened
+bool isCompact(const QByteArray& data);
+bool isCompactPath(const QString& path);
+
+QByteArray encode(const QJsonObject& graph, const QMap<QString, QByteArray>& subgraphs);
+bool decode(const QByteArray& data, Container& container, QString* error = nullptr);
+
+// Whole-pipeline conversions, nested bodies included
+QByteArray fromJson(const QJsonObject& pipeline);
+QJsonObject toJson(const QByteArray& data, QString* error = nullptr);
+
+} // namespace PipelineFormat
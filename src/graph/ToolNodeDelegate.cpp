@@ -33,7 +33,6 @@
 #include <algorithm>
 
 #include "PromptBuilderNode.h"
-#include "NodeInfoWidget.h"
 
 using namespace QtNodes;
 
@@ -112,23 +111,13 @@ unsigned int ToolNodeDelegate::nPorts(PortType portType) const
 NodeDataType ToolNodeDelegate::dataType(PortType portType, PortIndex portIndex) const
 {
     ensureDescriptorCached();
-    NodeDataType t;
+    // Asked on every paint, so answered from the arrays built with the cache
     if (portType == PortType::In) {
-        if (portIndex < _inputOrder.size()) {
-            const auto &pinId = _inputOrder[portIndex];
-            const auto &pin = _descriptor.inputPins.value(pinId);
-            t.id = pin.type;
-            t.name = pin.name;
-        }
+        if (portIndex < _inputTypes.size()) return _inputTypes[portIndex];
     } else if (portType == PortType::Out) {
-        if (portIndex < _outputOrder.size()) {
-            const auto &pinId = _outputOrder[portIndex];
-            const auto &pin = _descriptor.outputPins.value(pinId);
-            t.id = pin.type;
-            t.name = pin.name;
-        }
+        if (portIndex < _outputTypes.size()) return _outputTypes[portIndex];
     }
-    return t;
+    return NodeDataType();
 }
 
 void ToolNodeDelegate::setInData(std::shared_ptr<NodeData> nodeData, PortIndex const portIndex)
@@ -155,14 +144,7 @@ std::shared_ptr<NodeData> ToolNodeDelegate::outData(PortIndex const port)
 
     const QString pinId = outputPinIdForIndex(port);
     const QVariant v = _outputs.value(pinId);
-
-    NodeDataType t;
-    if (port < _outputOrder.size()) {
-        const auto &pin = _descriptor.outputPins.value(pinId);
-        t.id = pin.type;
-        t.name = pin.name;
-    }
-    return std::make_shared<VariantNodeData>(t, v);
+    return std::make_shared<VariantNodeData>(dataType(PortType::Out, port), v);
 }
 
 void ToolNodeDelegate::onNodeInputPinsUpdateRequested(const QStringList& newVariables)
@@ -185,6 +167,7 @@ void ToolNodeDelegate::onNodeInputPinsUpdateRequested(const QStringList& newVari
         
         _descriptor.inputPins.clear();
         _inputOrder.clear();
+        rebuildPinIndex();
         // prune runtime inputs
         QMap<QString, QVariant> newInputs;
         for (const QString& v : newVariables) {
@@ -208,6 +191,7 @@ void ToolNodeDelegate::onNodeInputPinsUpdateRequested(const QStringList& newVari
             _descriptor.inputPins.insert(in.id, in);
             _inputOrder.push_back(in.id);
         }
+        rebuildPinIndex();
         
         emit portsInserted();
     }
@@ -371,10 +355,8 @@ void ToolNodeDelegate::onOutputPinsChanged()
 QWidget *ToolNodeDelegate::embeddedWidget()
 {
     // Lazily create the info widget to display the node description inside the node
-    if (!m_infoWidget) {
-        m_infoWidget = new NodeInfoWidget();
-        // Initialize with current description
-        m_infoWidget->setDescription(m_nodeDescription);
+    if (!m_infoWidget && widgetFactory().infoWidget) {
+        m_infoWidget = widgetFactory().infoWidget(this);
     }
     return m_infoWidget;
 }
@@ -382,26 +364,46 @@ QWidget *ToolNodeDelegate::embeddedWidget()
 QWidget* ToolNodeDelegate::configurationWidget()
 {
     // Lazily create the configuration widget for use in the properties panel only.
-    if (!_widget) {
-        _widget = _node ? _node->createConfigurationWidget(nullptr) : nullptr;
+    if (!_widget && _node && widgetFactory().configurationWidget) {
+        _widget = widgetFactory().configurationWidget(_node.get());
     }
     return _widget;
 }
 
+void ToolNodeDelegate::setWidgetFactory(WidgetFactory factory)
+{
+    widgetFactory() = std::move(factory);
+}
+
+ToolNodeDelegate::WidgetFactory& ToolNodeDelegate::widgetFactory()
+{
+    static WidgetFactory factory;
+    return factory;
+}
+
 void ToolNodeDelegate::setDescription(const QString& desc)
 {
     m_nodeDescription = desc;
-    
+
     // Sync with the embedded info widget if it exists
-    if (m_infoWidget) {
-        m_infoWidget->setDescription(desc);
-    }
-    
+    emit descriptionChanged(desc);
+
     // Notify the view that the embedded widget size may have changed
     // This triggers the node to recalculate its geometry
     emit embeddedWidgetSizeUpdated();
 }
 
+void ToolNodeDelegate::setMaxConcurrentExecutions(int count)
+{
+    m_maxConcurrentExecutions = std::clamp(count, 1, kMaxConcurrentExecutionsLimit);
+}
+
+void ToolNodeDelegate::setRetryPolicy(const RetryPolicy& policy)
+{
+    m_retryPolicy.maxAttempts = std::clamp(policy.maxAttempts, 1, RetryPolicy::kMaxAttemptsLimit);
+    m_retryPolicy.baseDelayMs = std::clamp(policy.baseDelayMs, 1, RetryPolicy::kMaxDelayMs);
+}
+
 void ToolNodeDelegate::ensureDescriptorCached() const
 {
     if (_descriptorCached || !_node) return;
@@ -440,6 +442,45 @@ void ToolNodeDelegate::rebuildCachedDescriptor(const NodeDescriptor& descriptor)
     appendOrderedPins(_outputOrder, _descriptor.outputPins, _descriptor.outputPinOrder);
 
     _descriptorCached = true;
+    rebuildPinIndex();
+}
+
+void ToolNodeDelegate::rebuildPinIndex() const
+{
+    const auto build = [](const std::vector<QString>& order, const QMap<QString, PinDefinition>& pins,
+                          QHash<QString, int>& index, std::vector<NodeDataType>& types) {
+        index.clear();
+        index.reserve(static_cast<qsizetype>(order.size()));
+        types.clear();
+        types.reserve(order.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            index.insert(order[i], static_cast<int>(i));
+            const auto pin = pins.constFind(order[i]);
+            NodeDataType t;
+            if (pin != pins.constEnd()) {
+                t.id = pin->type;
+                t.name = pin->name;
+            }
+            types.push_back(t);
+        }
+    };
+    build(_inputOrder, _descriptor.inputPins, _inputIndex, _inputTypes);
+    build(_outputOrder, _descriptor.outputPins, _outputIndex, _outputTypes);
+    ++_descriptorVersion;
+}
+
+const NodeDescriptor& ToolNodeDelegate::descriptor() const
+{
+    ensureDescriptorCached();
+    return _descriptor;
+}
+
+int ToolNodeDelegate::portIndexForPinId(PortType portType, const QString& pinId) const
+{
+    ensureDescriptorCached();
+    if (portType == PortType::In) return _inputIndex.value(pinId, -1);
+    if (portType == PortType::Out) return _outputIndex.value(pinId, -1);
+    return -1;
 }
 
 QString ToolNodeDelegate::inputPinIdForIndex(PortIndex idx) const
@@ -475,6 +516,16 @@ QJsonObject ToolNodeDelegate::save() const
     if (!m_nodeDescription.isEmpty()) {
         obj.insert(QStringLiteral("node-description"), m_nodeDescription);
     }
+    if (m_maxConcurrentExecutions != 1) {
+        obj.insert(QStringLiteral("max-concurrent-executions"), m_maxConcurrentExecutions);
+    }
+    if (!m_preserveOutputOrder) {
+        obj.insert(QStringLiteral("preserve-output-order"), false);
+    }
+    if (m_retryPolicy.retries()) {
+        obj.insert(QStringLiteral("retry-attempts"), m_retryPolicy.maxAttempts);
+        obj.insert(QStringLiteral("retry-backoff-ms"), m_retryPolicy.baseDelayMs);
+    }
 
     // Merge node-specific state into the internal-data object.
     if (_node) {
@@ -492,6 +543,12 @@ void ToolNodeDelegate::load(QJsonObject const& data)
     if (data.contains(QStringLiteral("node-description"))) {
         setDescription(data.value(QStringLiteral("node-description")).toString());
     }
+    setMaxConcurrentExecutions(data.value(QStringLiteral("max-concurrent-executions")).toInt(1));
+    setPreservesOutputOrder(data.value(QStringLiteral("preserve-output-order")).toBool(true));
+    RetryPolicy retry;
+    retry.maxAttempts = data.value(QStringLiteral("retry-attempts")).toInt(1);
+    retry.baseDelayMs = data.value(QStringLiteral("retry-backoff-ms")).toInt(RetryPolicy::kDefaultBaseDelayMs);
+    setRetryPolicy(retry);
 
     if (_node) {
         _node->loadState(data);
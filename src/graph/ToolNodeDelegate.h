@@ -23,6 +23,7 @@
 //
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <vector>
 #include <unordered_map>
@@ -30,6 +31,7 @@
 #include <QtNodes/NodeDelegateModel>
 #include <QtNodes/NodeData>
 
+#include <QHash>
 #include <QObject>
 #include <QPointer>
 #include <QVariant>
@@ -37,10 +39,9 @@
 
 #include "ExecutionToken.h"
 #include "IToolNode.h"
+#include "RetryPolicy.h"
 #include "CommonDataTypes.h"
 
-class NodeInfoWidget;
-
 // Generic adapter that bridges IToolNode to QtNodes::NodeDelegateModel
 class ToolNodeDelegate : public QtNodes::NodeDelegateModel {
     Q_OBJECT
@@ -68,14 +69,46 @@ public:
     // Returns the configuration widget for the properties panel (not embedded in node)
     QWidget* configurationWidget();
 
+    // Builds the widgets above. The editor installs one (NodeWidgetFactory) before it
+    // creates a graph; the headless core has none, so both stay null there.
+    struct WidgetFactory {
+        std::function<QWidget*(IToolNode* node)> configurationWidget;
+        std::function<QWidget*(ToolNodeDelegate* delegate)> infoWidget;
+    };
+    static void setWidgetFactory(WidgetFactory factory);
+
     // Expose the underlying node for engine/execution control.
     std::shared_ptr<IToolNode> node() const { return _node; }
 
+    // Cached descriptor, refreshed only when the node signals inputPinsChanged() or
+    // outputPinsChanged() (or Prompt Builder rewrites its inputs). Each refresh bumps
+    // descriptorVersion(), so callers holding derived data can tell it is stale.
+    const NodeDescriptor& descriptor() const;
+    quint64 descriptorVersion() const { ensureDescriptorCached(); return _descriptorVersion; }
+
+    // Port index of a pin id, or -1 when the node has no such pin
+    int portIndexForPinId(QtNodes::PortType portType, const QString& pinId) const;
+
     // Node description accessor methods
     QString description() const { return m_nodeDescription; }
     void setDescription(const QString& desc);
 
+    // Executions one run may have in flight for this node at once. Only reentrant
+    // nodes (IToolNode::isReentrant()) go above 1; see ExecutionPlan::Node.
+    static constexpr int kMaxConcurrentExecutionsLimit = 64;
+    int maxConcurrentExecutions() const { return m_maxConcurrentExecutions; }
+    void setMaxConcurrentExecutions(int count);
+    // With several executions in flight, release their outputs in the order the
+    // inputs arrived rather than the order they finish
+    bool preservesOutputOrder() const { return m_preserveOutputOrder; }
+    void setPreservesOutputOrder(bool ordered) { m_preserveOutputOrder = ordered; }
+    // Attempts the engine makes when an execution fails transiently, and the backoff
+    // base between them; see RetryPolicy
+    RetryPolicy retryPolicy() const { return m_retryPolicy; }
+    void setRetryPolicy(const RetryPolicy& policy);
+
 private:
+    static WidgetFactory& widgetFactory();
     void setToolNode(std::shared_ptr<IToolNode> node);
     // Minimal generic NodeData that carries QVariant and a declared type id/name
     class VariantNodeData : public QtNodes::NodeData {
@@ -90,6 +123,8 @@ private:
 
     void ensureDescriptorCached() const;
     void rebuildCachedDescriptor(const NodeDescriptor& descriptor) const;
+    // Recomputes the pin id -> index maps and port data types from the pin orders
+    void rebuildPinIndex() const;
 
     // Helpers to translate between port index and our pin ids
     QString inputPinIdForIndex(QtNodes::PortIndex idx) const;
@@ -99,6 +134,10 @@ public:
     // Public helper for external components (ExecutionEngine) to map indices to pin ids
     QString pinIdForIndex(QtNodes::PortType portType, QtNodes::PortIndex idx) const;
 
+Q_SIGNALS:
+    // The embedded info widget follows the description through this
+    void descriptionChanged(const QString& description);
+
 private Q_SLOTS:
     void onNodeInputPinsUpdateRequested(const QStringList& newVariables);
     void onInputPinsChanged();
@@ -112,6 +151,11 @@ private:
     mutable NodeDescriptor _descriptor;
     mutable std::vector<QString> _inputOrder;
     mutable std::vector<QString> _outputOrder;
+    mutable QHash<QString, int> _inputIndex;
+    mutable QHash<QString, int> _outputIndex;
+    mutable std::vector<QtNodes::NodeDataType> _inputTypes;
+    mutable std::vector<QtNodes::NodeDataType> _outputTypes;
+    mutable quint64 _descriptorVersion {0};
     QMetaObject::Connection _dynamicPinsConnection;
     QMetaObject::Connection _capsConnection;
     QMetaObject::Connection _outputPinsConnection;
@@ -124,8 +168,13 @@ private:
     QPointer<QWidget> _widget;
     
     // Embedded info widget for displaying description inside the node
-    QPointer<NodeInfoWidget> m_infoWidget;
+    QPointer<QWidget> m_infoWidget;
 
     // Node description (generic metadata)
     QString m_nodeDescription;
+
+    // Generic execution settings, persisted next to the description
+    int m_maxConcurrentExecutions {1};
+    bool m_preserveOutputOrder {true};
+    RetryPolicy m_retryPolicy;
 };
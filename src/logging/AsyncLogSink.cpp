@@ -0,0 +1,271 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "AsyncLogSink.h"
+#include "RotatingLogFile.h"
+
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QThread>
+
+#include <chrono>
+#include <limits>
+
+namespace {
+
+constexpr qint64 kRateWindowMs = 1000;
+
+} // namespace
+
+AsyncLogSink::Config AsyncLogSink::Config::fromEnvironment()
+{
+    Config config;
+    config.jsonPath = qEnvironmentVariable("CP_LOG_JSON");
+    bool ok = false;
+    const int rateLimit = qEnvironmentVariableIntValue("CP_LOG_RATE_LIMIT", &ok);
+    if (ok) {
+        config.rateLimitPerSecond = qMax(0, rateLimit);
+    }
+    const QStringList rules = qEnvironmentVariable("CP_LOG_SAMPLE").split(u',', Qt::SkipEmptyParts);
+    for (const QString& rule : rules) {
+        const qsizetype colon = rule.lastIndexOf(u':');
+        const int keepOneIn = colon > 0 ? rule.mid(colon + 1).toInt() : 0;
+        if (keepOneIn > 1) {
+            config.sampling.insert(rule.left(colon).trimmed(), keepOneIn);
+        }
+    }
+    return config;
+}
+
+AsyncLogSink::AsyncLogSink(Config config, Display display)
+    : m_config(std::move(config))
+    , m_head(new Node)
+    , m_display(std::move(display))
+{
+    m_tail = m_head.load(std::memory_order_relaxed);
+    m_writer = std::thread([this]() { run(); });
+}
+
+AsyncLogSink::~AsyncLogSink()
+{
+    m_stopping.store(true);
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_wake.notify_one();
+    }
+    m_writer.join();
+    delete m_tail;
+}
+
+void AsyncLogSink::post(Level level, QString category, QString message)
+{
+    auto* node = new Node;
+    node->record.timestampMs = QDateTime::currentMSecsSinceEpoch();
+    node->record.level = level;
+    node->record.category = std::move(category);
+    node->record.message = std::move(message);
+    node->record.threadId = static_cast<quint64>(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+
+    m_posted.fetch_add(1);
+    Node* previous = m_head.exchange(node);
+    previous->next.store(node);
+
+    // Only a writer that has gone idle needs waking; a busy one finds the node itself
+    if (m_writerSleeping.load()) {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_wake.notify_one();
+    }
+}
+
+void AsyncLogSink::flush()
+{
+    // The display callback logging and flushing would wait for itself
+    if (std::this_thread::get_id() == m_writer.get_id()) {
+        return;
+    }
+    const quint64 target = m_posted.load();
+    std::unique_lock<std::mutex> lock(m_wakeMutex);
+    m_wake.notify_one();
+    m_writtenChanged.wait(lock, [this, target]() { return m_written.load() >= target; });
+}
+
+int AsyncLogSink::takeBatch(QList<Record>& batch)
+{
+    int taken = 0;
+    while (taken < kMaxBatch) {
+        // A producer between its exchange and its link shows as the end of the queue
+        Node* tail = m_tail;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (!next) {
+            break;
+        }
+        batch.append(std::move(next->record));
+        m_tail = next;
+        delete tail;
+        ++taken;
+    }
+    return taken;
+}
+
+bool AsyncLogSink::admit(const Record& record, QList<Record>& out)
+{
+    if (record.level == Level::Warning) {
+        return true;
+    }
+    CategoryState& state = m_categories[record.category];
+    const int keepOneIn = m_config.sampling.value(record.category, 1);
+    if (keepOneIn > 1 && state.seen++ % static_cast<quint64>(keepOneIn) != 0) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (m_config.rateLimitPerSecond <= 0) {
+        return true;
+    }
+    if (record.timestampMs - state.windowStartMs >= kRateWindowMs) {
+        summarizeLimited(record.timestampMs, out);
+        state.windowStartMs = record.timestampMs;
+        state.inWindow = 0;
+    }
+    if (state.inWindow >= m_config.rateLimitPerSecond) {
+        ++state.limited;
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    ++state.inWindow;
+    return true;
+}
+
+void AsyncLogSink::summarizeLimited(qint64 nowMs, QList<Record>& out)
+{
+    for (auto it = m_categories.begin(); it != m_categories.end(); ++it) {
+        CategoryState& state = it.value();
+        if (state.limited == 0 || nowMs - state.windowStartMs < kRateWindowMs) {
+            continue;
+        }
+        Record summary;
+        summary.timestampMs = qMin(nowMs, state.windowStartMs + kRateWindowMs);
+        summary.category = it.key();
+        summary.message = QStringLiteral("%1 records dropped by the rate limit of %2 per second")
+                              .arg(state.limited)
+                              .arg(m_config.rateLimitPerSecond);
+        out.append(std::move(summary));
+        state.limited = 0;
+    }
+}
+
+void AsyncLogSink::run()
+{
+    QList<Record> batch;
+    QList<Record> out;
+    for (;;) {
+        batch.clear();
+        out.clear();
+        const int taken = takeBatch(batch);
+        for (Record& record : batch) {
+            if (admit(record, out)) {
+                out.append(std::move(record));
+            }
+        }
+        const bool stopping = taken == 0 && m_stopping.load();
+        summarizeLimited(stopping ? std::numeric_limits<qint64>::max() : QDateTime::currentMSecsSinceEpoch(), out);
+        if (!out.isEmpty()) {
+            write(out);
+        }
+
+        if (taken > 0) {
+            m_written.fetch_add(static_cast<quint64>(taken));
+            {
+                std::lock_guard<std::mutex> lock(m_wakeMutex);
+            }
+            m_writtenChanged.notify_all();
+            continue;
+        }
+        if (stopping) {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_writerSleeping.store(true);
+        // Checked after raising the flag, so a producer either sees it or is seen here
+        if (!m_tail->next.load() && !m_stopping.load()) {
+            m_wake.wait_for(lock, std::chrono::milliseconds(kWriterIdleMs));
+        }
+        m_writerSleeping.store(false);
+    }
+}
+
+void AsyncLogSink::write(const QList<Record>& batch)
+{
+    if (m_display) {
+        m_display(batch);
+    }
+    if (m_config.jsonPath.isEmpty() || m_jsonFailed) {
+        return;
+    }
+    if (!m_jsonFile) {
+        m_jsonFile = std::make_unique<RotatingLogFile>(m_config.jsonPath);
+    }
+    QStringList lines;
+    lines.reserve(batch.size());
+    for (const Record& record : batch) {
+        lines.append(QString::fromUtf8(toJsonLine(record)));
+    }
+    if (!m_jsonFile->append(lines)) {
+        m_jsonFailed = true;
+        qWarning().noquote() << QStringLiteral("AsyncLogSink: cannot write %1: %2")
+                                    .arg(m_jsonFile->path(), m_jsonFile->errorString());
+    }
+}
+
+QString AsyncLogSink::formatLine(const Record& record)
+{
+    QString line;
+    line.reserve(record.message.size() + record.category.size() + 12);
+    if (record.level == Level::Warning) {
+        line += QStringLiteral("Warning: ");
+    }
+    if (!record.category.isEmpty()) {
+        line += u'[';
+        line += record.category;
+        line += QStringLiteral("] ");
+    }
+    line += record.message;
+    return line;
+}
+
+QByteArray AsyncLogSink::toJsonLine(const Record& record)
+{
+    QJsonObject object;
+    object.insert(QStringLiteral("ts"),
+                  QDateTime::fromMSecsSinceEpoch(record.timestampMs).toUTC().toString(Qt::ISODateWithMs));
+    object.insert(QStringLiteral("level"),
+                  record.level == Level::Warning ? QStringLiteral("warning") : QStringLiteral("info"));
+    if (!record.category.isEmpty()) {
+        object.insert(QStringLiteral("category"), record.category);
+    }
+    object.insert(QStringLiteral("thread"), QString::number(record.threadId, 16));
+    object.insert(QStringLiteral("message"), record.message);
+    return QJsonDocument(object).toJson(QJsonDocument::Compact);
+}
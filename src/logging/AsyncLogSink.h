@@ -0,0 +1,146 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+class RotatingLogFile;
+
+// Takes log records from any thread and writes them on one background thread, so
+// logging costs the caller an allocation and an atomic exchange rather than a lock,
+// a cross-thread invocation and file I/O. post() links the record into a
+// multi-producer, single-consumer queue; the writer takes what has queued up, drops
+// what per-category sampling and rate limits reject, hands the rest to the display
+// callback as one batch and, with a JSON path set, appends one JSON object per record
+// to a rotating file. Warnings are never sampled or rate limited. A category that
+// was limited gets one summary line saying how many records were dropped.
+//
+// Config::fromEnvironment() reads:
+//   CP_LOG_JSON=<path>             JSON lines output, rotated like the Debug Log file
+//   CP_LOG_RATE_LIMIT=<n>          records per second per category, 0 for no limit
+//   CP_LOG_SAMPLE=<cat>:<n>,...    keep one record in n of these categories
+class AsyncLogSink {
+public:
+    static constexpr int kDefaultRateLimit = 500;
+    static constexpr int kWriterIdleMs = 50;
+
+    enum class Level { Info, Warning };
+
+    struct Record {
+        qint64 timestampMs {0};
+        Level level {Level::Info};
+        // Empty for CP_LOG and CP_WARN
+        QString category;
+        QString message;
+        quint64 threadId {0};
+    };
+
+    struct Config {
+        QString jsonPath;
+        int rateLimitPerSecond {kDefaultRateLimit};
+        // Category -> keep one record in n
+        QHash<QString, int> sampling;
+
+        static Config fromEnvironment();
+    };
+
+    // Runs on the writer thread with each batch that got through
+    using Display = std::function<void(const QList<Record>& records)>;
+
+    explicit AsyncLogSink(Config config = Config(), Display display = Display());
+    // Writes whatever is still queued, then stops the writer
+    ~AsyncLogSink();
+
+    AsyncLogSink(const AsyncLogSink&) = delete;
+    AsyncLogSink& operator=(const AsyncLogSink&) = delete;
+
+    void post(Level level, QString category, QString message);
+    // Blocks until every record posted before the call has been written
+    void flush();
+
+    bool hasJsonOutput() const { return !m_config.jsonPath.isEmpty(); }
+    // Records dropped by sampling or rate limits so far
+    quint64 droppedRecords() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    // "[category] message", with "Warning: " in front of warnings
+    static QString formatLine(const Record& record);
+    static QByteArray toJsonLine(const Record& record);
+
+private:
+    struct Node {
+        std::atomic<Node*> next {nullptr};
+        Record record;
+    };
+    struct CategoryState {
+        qint64 windowStartMs {0};
+        int inWindow {0};
+        quint64 seen {0};
+        quint64 limited {0};
+    };
+
+    static constexpr int kMaxBatch = 1024;
+
+    void run();
+    // Moves up to kMaxBatch queued records onto batch; returns how many
+    int takeBatch(QList<Record>& batch);
+    bool admit(const Record& record, QList<Record>& out);
+    // Summary lines for categories whose rate limit window has closed
+    void summarizeLimited(qint64 nowMs, QList<Record>& out);
+    void write(const QList<Record>& batch);
+
+    Config m_config;
+
+    // Producers swap themselves in at m_head; the writer alone follows m_tail, which
+    // always points at an already consumed node
+    std::atomic<Node*> m_head;
+    Node* m_tail;
+
+    std::atomic<quint64> m_posted {0};
+    std::atomic<quint64> m_written {0};
+    std::atomic<quint64> m_dropped {0};
+    std::atomic<bool> m_writerSleeping {false};
+    std::atomic<bool> m_stopping {false};
+
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_writtenChanged;
+
+    // Writer thread only
+    Display m_display;
+    QHash<QString, CategoryState> m_categories;
+    std::unique_ptr<RotatingLogFile> m_jsonFile;
+    bool m_jsonFailed {false};
+
+    std::thread m_writer;
+};
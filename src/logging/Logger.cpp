@@ -4,12 +4,51 @@
 // Copyright (c) 2025 Adrian Sutherland
 //
 #include "Logger.h"
-#include "MainWindow.h"
+#include "AsyncLogSink.h"
+
+#include <atomic>
 
 bool AppLogHelper::s_globalDebugEnabled = false;
 
-AppLogHelper::AppLogHelper(bool isWarn)
-    : m_isWarn(isWarn)
+namespace {
+
+std::atomic<AppLogHelper::LineViewer> s_lineViewer {nullptr};
+
+// Runs on the sink's writer thread with each batch
+void showRecords(const QList<AsyncLogSink::Record>& records)
+{
+    if (const AppLogHelper::LineViewer viewer = s_lineViewer.load()) {
+        QStringList lines;
+        lines.reserve(records.size());
+        for (const AsyncLogSink::Record& record : records) {
+            lines.append(AsyncLogSink::formatLine(record));
+        }
+        viewer(lines);
+        return;
+    }
+    // Fallback for tests or headless mode
+    // Only print debug logs if global debug is enabled.
+    // Warnings always go to console when headless.
+    for (const AsyncLogSink::Record& record : records) {
+        if (record.level == AsyncLogSink::Level::Warning) {
+            qWarning().noquote() << record.message;
+        } else if (AppLogHelper::isGlobalDebugEnabled()) {
+            qDebug().noquote() << AsyncLogSink::formatLine(record);
+        }
+    }
+}
+
+AsyncLogSink& sink()
+{
+    static AsyncLogSink instance(AsyncLogSink::Config::fromEnvironment(), showRecords);
+    return instance;
+}
+
+} // namespace
+
+AppLogHelper::AppLogHelper(bool isWarn, const char* category)
+    : m_category(category)
+    , m_isWarn(isWarn)
 {
 }
 
@@ -23,22 +62,23 @@ bool AppLogHelper::isGlobalDebugEnabled()
     return s_globalDebugEnabled;
 }
 
+bool AppLogHelper::isEnabled(bool isWarn)
+{
+    return isWarn || s_globalDebugEnabled || s_lineViewer.load() != nullptr || sink().hasJsonOutput();
+}
+
+void AppLogHelper::setLineViewer(LineViewer viewer)
+{
+    s_lineViewer.store(viewer);
+}
+
+void AppLogHelper::flush()
+{
+    sink().flush();
+}
+
 AppLogHelper::~AppLogHelper()
 {
-    if (MainWindow::instanceExists()) {
-        if (m_isWarn) {
-            MainWindow::logMessage(QStringLiteral("Warning: ") + m_buffer);
-        } else {
-            MainWindow::logMessage(m_buffer);
-        }
-    } else {
-        // Fallback for tests or headless mode
-        // Only print debug logs if global debug is enabled.
-        // Warnings always go to console when headless.
-        if (m_isWarn) {
-            qWarning().noquote() << m_buffer;
-        } else if (s_globalDebugEnabled) {
-            qDebug().noquote() << m_buffer;
-        }
-    }
+    sink().post(m_isWarn ? AsyncLogSink::Level::Warning : AsyncLogSink::Level::Info,
+                m_category ? QString::fromLatin1(m_category) : QString(), std::move(m_buffer));
 }
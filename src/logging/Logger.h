@@ -6,23 +6,44 @@
 #pragma once
 
 #include <QString>
+#include <QStringList>
 #include <QDebug>
 
+// Collects one log line and posts it to the AsyncLogSink when destroyed, so formatting
+// and delivery happen on the sink's writer thread. The macros skip building the line
+// when nothing would show it: debug output is off, no line viewer is installed and
+// there is no JSON log. Warnings are always built.
 class AppLogHelper {
 public:
-    AppLogHelper(bool isWarn);
+    explicit AppLogHelper(bool isWarn, const char* category = nullptr);
     ~AppLogHelper();
     QDebug stream() { return QDebug(&m_buffer).nospace(); }
 
     static void setGlobalDebugEnabled(bool enabled);
     static bool isGlobalDebugEnabled();
+    static bool isEnabled(bool isWarn);
+
+    // Receives each batch of formatted lines on the sink's writer thread instead of the
+    // console. The GUI installs one while its window exists; null restores the console.
+    using LineViewer = void (*)(const QStringList& lines);
+    static void setLineViewer(LineViewer viewer);
+    // Blocks until every line logged so far has been delivered
+    static void flush();
 
 private:
     QString m_buffer;
+    const char* m_category;
     bool m_isWarn;
     static bool s_globalDebugEnabled;
 };
 
-#define CP_LOG AppLogHelper(false).stream()
+// Turns a streamed line into void so the disabled branch of the macros can be (void)0;
+// '&' binds looser than '<<', so the whole line is streamed first
+struct AppLogVoidify {
+    void operator&(const QDebug&) const {}
+};
+
+#define CP_LOG !AppLogHelper::isEnabled(false) ? (void)0 : AppLogVoidify() & AppLogHelper(false).stream()
 #define CP_WARN AppLogHelper(true).stream()
-#define CP_CLOG(category) (AppLogHelper(false).stream() << "[" #category "] ")
+#define CP_CLOG(category) \
+    !AppLogHelper::isEnabled(false) ? (void)0 : AppLogVoidify() & AppLogHelper(false, #category).stream()
@@ -6,3 +6,4 @@ Q_LOGGING_CATEGORY(cp_params, "cp.params")
 Q_LOGGING_CATEGORY(cp_endpoint, "cp.endpoint")
 Q_LOGGING_CATEGORY(cp_discovery, "cp.discovery")
 Q_LOGGING_CATEGORY(cp_caps, "cp.caps")
+Q_LOGGING_CATEGORY(cp_concurrency, "cp.concurrency")
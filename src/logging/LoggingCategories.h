@@ -20,3 +20,6 @@ Q_DECLARE_LOGGING_CATEGORY(cp_discovery)
 
 // Capability baseline/ad-hoc capability logs
 Q_DECLARE_LOGGING_CATEGORY(cp_caps)
+
+// Adaptive provider concurrency: limit changes and throttle events
+Q_DECLARE_LOGGING_CATEGORY(cp_concurrency)
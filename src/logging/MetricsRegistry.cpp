@@ -0,0 +1,382 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "MetricsRegistry.h"
+#include "Logger.h"
+
+#include <QDateTime>
+#include <QJsonArray>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <cmath>
+
+struct MetricsRegistry::CallbackHandle::State {
+    QMutex mutex;
+    std::function<double()> read;
+};
+
+namespace {
+
+QString escapeLabelValue(const QString& value)
+{
+    QString escaped;
+    escaped.reserve(value.size());
+    for (const QChar c : value) {
+        if (c == u'\\') {
+            escaped += QStringLiteral("\\\\");
+        } else if (c == u'"') {
+            escaped += QStringLiteral("\\\"");
+        } else if (c == u'\n') {
+            escaped += QStringLiteral("\\n");
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+// {a="1",b="2"}, with extra appended last (the histogram's "le")
+QString renderLabels(const MetricsRegistry::Labels& labels, const QString& extraName = QString(),
+                     const QString& extraValue = QString())
+{
+    if (labels.isEmpty() && extraName.isEmpty()) {
+        return QString();
+    }
+    QStringList parts;
+    for (const auto& label : labels) {
+        parts.append(QStringLiteral("%1=\"%2\"").arg(label.first, escapeLabelValue(label.second)));
+    }
+    if (!extraName.isEmpty()) {
+        parts.append(QStringLiteral("%1=\"%2\"").arg(extraName, extraValue));
+    }
+    return QStringLiteral("{%1}").arg(parts.join(u','));
+}
+
+QString formatNumber(double value)
+{
+    if (std::isinf(value)) {
+        return value > 0 ? QStringLiteral("+Inf") : QStringLiteral("-Inf");
+    }
+    if (std::isnan(value)) {
+        return QStringLiteral("NaN");
+    }
+    if (value == std::floor(value) && std::fabs(value) < 1e15) {
+        return QString::number(static_cast<qint64>(value));
+    }
+    return QString::number(value, 'g', 15);
+}
+
+QString typeName(MetricsRegistry::Type type)
+{
+    switch (type) {
+    case MetricsRegistry::Type::Counter:
+        return QStringLiteral("counter");
+    case MetricsRegistry::Type::Gauge:
+        return QStringLiteral("gauge");
+    case MetricsRegistry::Type::Histogram:
+        return QStringLiteral("histogram");
+    }
+    return QString();
+}
+
+} // namespace
+
+MetricsRegistry::Histogram::Histogram(QVector<double> bounds)
+    : m_bounds(std::move(bounds))
+    , m_buckets(std::make_unique<std::atomic<quint64>[]>(static_cast<std::size_t>(m_bounds.size()) + 1))
+{
+    std::sort(m_bounds.begin(), m_bounds.end());
+    for (qsizetype i = 0; i <= m_bounds.size(); ++i) {
+        m_buckets[static_cast<std::size_t>(i)].store(0, std::memory_order_relaxed);
+    }
+}
+
+void MetricsRegistry::Histogram::observe(double value)
+{
+    const auto bucket = std::lower_bound(m_bounds.cbegin(), m_bounds.cend(), value) - m_bounds.cbegin();
+    m_buckets[static_cast<std::size_t>(bucket)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    double sum = m_sum.load(std::memory_order_relaxed);
+    while (!m_sum.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed)) {
+    }
+}
+
+QVector<quint64> MetricsRegistry::Histogram::bucketCounts() const
+{
+    QVector<quint64> counts(m_bounds.size() + 1);
+    for (qsizetype i = 0; i < counts.size(); ++i) {
+        counts[i] = m_buckets[static_cast<std::size_t>(i)].load(std::memory_order_relaxed);
+    }
+    return counts;
+}
+
+MetricsRegistry::CallbackHandle::CallbackHandle(std::shared_ptr<State> state)
+    : m_state(std::move(state))
+{
+}
+
+MetricsRegistry::CallbackHandle::~CallbackHandle()
+{
+    reset();
+}
+
+MetricsRegistry::CallbackHandle::CallbackHandle(CallbackHandle&& other) noexcept
+    : m_state(std::move(other.m_state))
+{
+}
+
+MetricsRegistry::CallbackHandle& MetricsRegistry::CallbackHandle::operator=(CallbackHandle&& other) noexcept
+{
+    if (this != &other) {
+        reset();
+        m_state = std::move(other.m_state);
+    }
+    return *this;
+}
+
+void MetricsRegistry::CallbackHandle::reset()
+{
+    if (!m_state) {
+        return;
+    }
+    // Waits for an export reading the callback; the registry drops the state later
+    QMutexLocker locker(&m_state->mutex);
+    m_state->read = nullptr;
+    locker.unlock();
+    m_state.reset();
+}
+
+MetricsRegistry& MetricsRegistry::instance()
+{
+    // Never destroyed: workers may still record while statics are torn down
+    static MetricsRegistry* registry = new MetricsRegistry();
+    return *registry;
+}
+
+const QVector<double>& MetricsRegistry::latencyBuckets()
+{
+    static const QVector<double> buckets = {0.001, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5,
+                                            1.0,   2.5,   5.0,  10.0,  30.0, 60.0, 120.0};
+    return buckets;
+}
+
+MetricsRegistry::Series* MetricsRegistry::series(const QString& name, const QString& help, Type type,
+                                                 const Labels& labels)
+{
+    const auto familyIt = m_families.find(name);
+    if (familyIt != m_families.end() && familyIt->second.type != type) {
+        CP_WARN << "MetricsRegistry:" << name << "is a" << typeName(familyIt->second.type) << "not a"
+                << typeName(type);
+        m_detached.push_back(std::make_unique<Series>());
+        return m_detached.back().get();
+    }
+    Family& family = familyIt != m_families.end() ? familyIt->second : m_families[name];
+    if (familyIt == m_families.end()) {
+        family.type = type;
+        family.help = help;
+    }
+    Series& entry = family.series[renderLabels(labels)];
+    entry.labels = labels;
+    return &entry;
+}
+
+MetricsRegistry::Counter& MetricsRegistry::counter(const QString& name, const QString& help, const Labels& labels)
+{
+    QMutexLocker locker(&m_mutex);
+    Series* found = series(name, help, Type::Counter, labels);
+    if (!found->counter) {
+        found->counter = std::make_unique<Counter>();
+    }
+    return *found->counter;
+}
+
+MetricsRegistry::Gauge& MetricsRegistry::gauge(const QString& name, const QString& help, const Labels& labels)
+{
+    QMutexLocker locker(&m_mutex);
+    Series* found = series(name, help, Type::Gauge, labels);
+    if (!found->gauge) {
+        found->gauge = std::make_unique<Gauge>();
+    }
+    return *found->gauge;
+}
+
+MetricsRegistry::Histogram& MetricsRegistry::histogram(const QString& name, const QString& help,
+                                                       const Labels& labels, const QVector<double>& bounds)
+{
+    QMutexLocker locker(&m_mutex);
+    Series* found = series(name, help, Type::Histogram, labels);
+    if (!found->histogram) {
+        found->histogram = std::make_unique<Histogram>(bounds);
+    }
+    return *found->histogram;
+}
+
+MetricsRegistry::CallbackHandle MetricsRegistry::addGaugeCallback(const QString& name, const QString& help,
+                                                                  const Labels& labels,
+                                                                  std::function<double()> read)
+{
+    auto state = std::make_shared<CallbackHandle::State>();
+    state->read = std::move(read);
+    QMutexLocker locker(&m_mutex);
+    auto& callbacks = series(name, help, Type::Gauge, labels)->callbacks;
+    // Handles that were reset leave their state behind until the next registration
+    callbacks.erase(std::remove_if(callbacks.begin(), callbacks.end(),
+                                   [](const std::shared_ptr<CallbackHandle::State>& entry) {
+                                       return entry.use_count() == 1;
+                                   }),
+                    callbacks.end());
+    callbacks.push_back(state);
+    return CallbackHandle(std::move(state));
+}
+
+std::vector<MetricsRegistry::FamilySnapshot> MetricsRegistry::snapshot() const
+{
+    std::vector<FamilySnapshot> families;
+    {
+        QMutexLocker locker(&m_mutex);
+        families.reserve(m_families.size());
+        for (const auto& [name, family] : m_families) {
+            FamilySnapshot copy;
+            copy.name = name;
+            copy.type = family.type;
+            copy.help = family.help;
+            for (const auto& entry : family.series) {
+                const Series& source = entry.second;
+                SeriesSnapshot sample;
+                sample.labels = source.labels;
+                if (source.counter) {
+                    sample.value = static_cast<double>(source.counter->value());
+                }
+                if (source.gauge) {
+                    sample.value = static_cast<double>(source.gauge->value());
+                }
+                if (source.histogram) {
+                    sample.bounds = source.histogram->bounds();
+                    sample.buckets = source.histogram->bucketCounts();
+                    sample.count = source.histogram->count();
+                    sample.sum = source.histogram->sum();
+                }
+                sample.callbacks = source.callbacks;
+                copy.series.push_back(std::move(sample));
+            }
+            families.push_back(std::move(copy));
+        }
+    }
+
+    // Outside the registry lock, so a callback may itself take locks that code
+    // updating metrics holds
+    for (FamilySnapshot& family : families) {
+        for (SeriesSnapshot& sample : family.series) {
+            for (const auto& state : sample.callbacks) {
+                QMutexLocker locker(&state->mutex);
+                if (state->read) {
+                    sample.value += state->read();
+                }
+            }
+            sample.callbacks.clear();
+        }
+    }
+    return families;
+}
+
+QByteArray MetricsRegistry::exposition(TextFormat format) const
+{
+    const bool openMetrics = format == TextFormat::OpenMetrics;
+    QString text;
+    for (const FamilySnapshot& family : snapshot()) {
+        const bool isCounter = family.type == Type::Counter;
+        const QString sampleName = isCounter ? family.name + QStringLiteral("_total") : family.name;
+        // The text format names a counter family after its samples, OpenMetrics does not
+        const QString familyName = isCounter && !openMetrics ? sampleName : family.name;
+        if (!family.help.isEmpty()) {
+            text += QStringLiteral("# HELP %1 %2\n").arg(familyName, QString(family.help).replace(u'\n', u' '));
+        }
+        text += QStringLiteral("# TYPE %1 %2\n").arg(familyName, typeName(family.type));
+        for (const SeriesSnapshot& sample : family.series) {
+            if (family.type != Type::Histogram) {
+                text += sampleName + renderLabels(sample.labels) + u' ' + formatNumber(sample.value) + u'\n';
+                continue;
+            }
+            quint64 cumulative = 0;
+            for (qsizetype i = 0; i < sample.buckets.size(); ++i) {
+                cumulative += sample.buckets.at(i);
+                const QString bound = i < sample.bounds.size() ? formatNumber(sample.bounds.at(i))
+                                                               : QStringLiteral("+Inf");
+                text += family.name + QStringLiteral("_bucket")
+                    + renderLabels(sample.labels, QStringLiteral("le"), bound) + u' '
+                    + QString::number(cumulative) + u'\n';
+            }
+            text += family.name + QStringLiteral("_sum") + renderLabels(sample.labels) + u' '
+                + formatNumber(sample.sum) + u'\n';
+            text += family.name + QStringLiteral("_count") + renderLabels(sample.labels) + u' '
+                + QString::number(sample.count) + u'\n';
+        }
+    }
+    if (openMetrics) {
+        text += QStringLiteral("# EOF\n");
+    }
+    return text.toUtf8();
+}
+
+QJsonObject MetricsRegistry::toJson() const
+{
+    QJsonArray metrics;
+    for (const FamilySnapshot& family : snapshot()) {
+        QJsonArray samples;
+        for (const SeriesSnapshot& sample : family.series) {
+            QJsonObject labels;
+            for (const auto& label : sample.labels) {
+                labels.insert(label.first, label.second);
+            }
+            QJsonObject entry;
+            entry.insert(QStringLiteral("labels"), labels);
+            if (family.type == Type::Histogram) {
+                QJsonObject buckets;
+                quint64 cumulative = 0;
+                for (qsizetype i = 0; i < sample.buckets.size(); ++i) {
+                    cumulative += sample.buckets.at(i);
+                    const QString bound = i < sample.bounds.size() ? formatNumber(sample.bounds.at(i))
+                                                                   : QStringLiteral("+Inf");
+                    buckets.insert(bound, static_cast<qint64>(cumulative));
+                }
+                entry.insert(QStringLiteral("buckets"), buckets);
+                entry.insert(QStringLiteral("count"), static_cast<qint64>(sample.count));
+                entry.insert(QStringLiteral("sum"), sample.sum);
+            } else {
+                entry.insert(QStringLiteral("value"), sample.value);
+            }
+            samples.append(entry);
+        }
+        QJsonObject object;
+        object.insert(QStringLiteral("name"), family.name);
+        object.insert(QStringLiteral("type"), typeName(family.type));
+        object.insert(QStringLiteral("help"), family.help);
+        object.insert(QStringLiteral("samples"), samples);
+        metrics.append(object);
+    }
+    QJsonObject root;
+    root.insert(QStringLiteral("timestamp"), QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs));
+    root.insert(QStringLiteral("metrics"), metrics);
+    return root;
+}
@@ -0,0 +1,171 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+// Process-wide counters, gauges and histograms, exported in the Prometheus text format
+// (or OpenMetrics) and as JSON. Looking a metric up takes a lock; updating it is a
+// relaxed atomic operation, so hot paths look their metrics up once and keep the
+// reference, which stays valid for the life of the process. A series is a family name
+// plus label values; asking for it again returns the same object. Gauges that are
+// cheaper to read than to keep current can be registered as callbacks, which are
+// called when the registry is exported and summed with the series' own value.
+class MetricsRegistry {
+public:
+    using Labels = QList<QPair<QString, QString>>;
+
+    enum class Type { Counter, Gauge, Histogram };
+    enum class TextFormat { Prometheus, OpenMetrics };
+
+    class Counter {
+    public:
+        void increment(quint64 by = 1) { m_value.fetch_add(by, std::memory_order_relaxed); }
+        quint64 value() const { return m_value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<quint64> m_value {0};
+    };
+
+    class Gauge {
+    public:
+        void set(qint64 value) { m_value.store(value, std::memory_order_relaxed); }
+        void add(qint64 delta) { m_value.fetch_add(delta, std::memory_order_relaxed); }
+        qint64 value() const { return m_value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<qint64> m_value {0};
+    };
+
+    class Histogram {
+    public:
+        // Upper bounds, ascending; a last bucket above them all is implied
+        explicit Histogram(QVector<double> bounds);
+
+        void observe(double value);
+        const QVector<double>& bounds() const { return m_bounds; }
+        // Per bucket rather than cumulative, bounds().size() + 1 entries
+        QVector<quint64> bucketCounts() const;
+        quint64 count() const { return m_count.load(std::memory_order_relaxed); }
+        double sum() const { return m_sum.load(std::memory_order_relaxed); }
+
+    private:
+        QVector<double> m_bounds;
+        std::unique_ptr<std::atomic<quint64>[]> m_buckets;
+        std::atomic<quint64> m_count {0};
+        std::atomic<double> m_sum {0.0};
+    };
+
+    // Keeps a callback gauge registered; destroying it removes the callback and waits
+    // for a call in progress to return
+    class CallbackHandle {
+    public:
+        CallbackHandle() = default;
+        ~CallbackHandle();
+        CallbackHandle(CallbackHandle&& other) noexcept;
+        CallbackHandle& operator=(CallbackHandle&& other) noexcept;
+
+        void reset();
+
+    private:
+        friend class MetricsRegistry;
+        struct State;
+        explicit CallbackHandle(std::shared_ptr<State> state);
+
+        std::shared_ptr<State> m_state;
+    };
+
+    static MetricsRegistry& instance();
+    // 1 ms to 2 minutes
+    static const QVector<double>& latencyBuckets();
+
+    MetricsRegistry() = default;
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    // Names follow Prometheus conventions; a counter's samples get "_total" appended.
+    // Asking for a name under another type logs a warning and returns a series that
+    // is never exported.
+    Counter& counter(const QString& name, const QString& help, const Labels& labels = Labels());
+    Gauge& gauge(const QString& name, const QString& help, const Labels& labels = Labels());
+    Histogram& histogram(const QString& name, const QString& help, const Labels& labels = Labels(),
+                         const QVector<double>& bounds = latencyBuckets());
+    [[nodiscard]] CallbackHandle addGaugeCallback(const QString& name, const QString& help, const Labels& labels,
+                                                  std::function<double()> read);
+
+    QByteArray exposition(TextFormat format = TextFormat::Prometheus) const;
+    // {"timestamp": ..., "metrics": [{"name", "type", "help", "samples": [...]}, ...]}
+    QJsonObject toJson() const;
+
+private:
+    struct Series {
+        Labels labels;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+        std::vector<std::shared_ptr<CallbackHandle::State>> callbacks;
+    };
+    struct Family {
+        Type type {Type::Counter};
+        QString help;
+        // Keyed by the rendered label set, so output is ordered
+        std::map<QString, Series> series;
+    };
+    struct SeriesSnapshot {
+        Labels labels;
+        double value {0.0};
+        QVector<double> bounds;
+        QVector<quint64> buckets;
+        quint64 count {0};
+        double sum {0.0};
+        // Read once the registry lock is released
+        std::vector<std::shared_ptr<CallbackHandle::State>> callbacks;
+    };
+    struct FamilySnapshot {
+        QString name;
+        Type type {Type::Counter};
+        QString help;
+        std::vector<SeriesSnapshot> series;
+    };
+
+    Series* series(const QString& name, const QString& help, Type type, const Labels& labels);
+    std::vector<FamilySnapshot> snapshot() const;
+
+    mutable QMutex m_mutex;
+    std::map<QString, Family> m_families;
+    // Series handed out for a name already taken by another type
+    std::vector<std::unique_ptr<Series>> m_detached;
+};
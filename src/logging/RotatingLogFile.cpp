@@ -0,0 +1,91 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "RotatingLogFile.h"
+
+#include <QDir>
+#include <QFileInfo>
+
+RotatingLogFile::RotatingLogFile(const QString& path, qint64 maxBytes, int keepFiles)
+    : m_path(path)
+    , m_maxBytes(qMax<qint64>(1, maxBytes))
+    , m_keepFiles(qMax(0, keepFiles))
+    , m_file(path)
+{
+}
+
+QString RotatingLogFile::rotatedPath(const QString& path, int index)
+{
+    return QStringLiteral("%1.%2").arg(path).arg(index);
+}
+
+bool RotatingLogFile::ensureOpen()
+{
+    if (m_file.isOpen()) {
+        return true;
+    }
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+    return m_file.open(QIODevice::WriteOnly | QIODevice::Append);
+}
+
+bool RotatingLogFile::append(const QStringList& lines)
+{
+    if (lines.isEmpty()) {
+        return true;
+    }
+    if (!ensureOpen()) {
+        return false;
+    }
+    for (const QString& line : lines) {
+        QByteArray bytes = line.toUtf8();
+        bytes.append('\n');
+        // A line longer than the limit still gets a file of its own
+        if (m_file.size() > 0 && m_file.size() + bytes.size() > m_maxBytes) {
+            rotate();
+            if (!ensureOpen()) {
+                return false;
+            }
+        }
+        if (m_file.write(bytes) != bytes.size()) {
+            return false;
+        }
+    }
+    return m_file.flush();
+}
+
+void RotatingLogFile::rotate()
+{
+    m_file.close();
+    if (m_keepFiles == 0) {
+        QFile::remove(m_path);
+        return;
+    }
+    QFile::remove(rotatedPath(m_path, m_keepFiles));
+    for (int index = m_keepFiles - 1; index >= 1; --index) {
+        const QString from = rotatedPath(m_path, index);
+        if (QFile::exists(from)) {
+            QFile::rename(from, rotatedPath(m_path, index + 1));
+        }
+    }
+    QFile::rename(m_path, rotatedPath(m_path, 1));
+}
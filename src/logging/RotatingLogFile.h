@@ -0,0 +1,57 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QFile>
+#include <QString>
+#include <QStringList>
+
+// Appends log lines to a file that is rotated by size. When the file would grow past
+// maxBytes it is renamed to "<path>.1", older files move up to "<path>.2" and so on,
+// and the oldest past keepFiles is deleted. Not thread-safe; one owner writes to it.
+class RotatingLogFile {
+public:
+    static constexpr qint64 kDefaultMaxBytes = 10 * 1024 * 1024;
+    static constexpr int kDefaultKeepFiles = 5;
+
+    explicit RotatingLogFile(const QString& path, qint64 maxBytes = kDefaultMaxBytes,
+                             int keepFiles = kDefaultKeepFiles);
+
+    // Writes each line with a newline and flushes; false if the file can't be written
+    bool append(const QStringList& lines);
+
+    QString path() const { return m_path; }
+    QString errorString() const { return m_file.errorString(); }
+
+    static QString rotatedPath(const QString& path, int index);
+
+private:
+    bool ensureOpen();
+    void rotate();
+
+    QString m_path;
+    qint64 m_maxBytes;
+    int m_keepFiles;
+    QFile m_file;
+};
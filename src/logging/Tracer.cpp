@@ -0,0 +1,515 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "Tracer.h"
+
+#include "Logger.h"
+
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QStringList>
+
+#include <cpr/cpr.h>
+
+#include <chrono>
+
+namespace {
+
+// Export requests give up after this long; the batch is dropped
+constexpr int kExportTimeoutMs = 10000;
+
+thread_local Tracer::Context t_currentContext;
+thread_local Tracer::Span* t_currentSpan = nullptr;
+
+qint64 nowUnixNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+QByteArray randomHexId(int bytes)
+{
+    QByteArray id(bytes, Qt::Uninitialized);
+    do {
+        QRandomGenerator::global()->fillRange(reinterpret_cast<quint32*>(id.data()), bytes / 4);
+    } while (id.count('\0') == bytes);
+    return id.toHex();
+}
+
+bool isLowerHex(QByteArrayView digits)
+{
+    for (const char c : digits) {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool isAllZero(QByteArrayView digits)
+{
+    for (const char c : digits) {
+        if (c != '0') {
+            return false;
+        }
+    }
+    return true;
+}
+
+QJsonObject attributeValue(const QVariant& value)
+{
+    switch (value.typeId()) {
+    case QMetaType::Bool:
+        return {{QStringLiteral("boolValue"), value.toBool()}};
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::Long:
+    case QMetaType::ULong:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+        // 64-bit integers are decimal strings in the JSON encoding
+        return {{QStringLiteral("intValue"), QString::number(value.toLongLong())}};
+    case QMetaType::Float:
+    case QMetaType::Double:
+        return {{QStringLiteral("doubleValue"), value.toDouble()}};
+    case QMetaType::QStringList: {
+        QJsonArray values;
+        for (const QString& item : value.toStringList()) {
+            values.append(QJsonObject{{QStringLiteral("stringValue"), item}});
+        }
+        return {{QStringLiteral("arrayValue"), QJsonObject{{QStringLiteral("values"), values}}}};
+    }
+    default:
+        return {{QStringLiteral("stringValue"), value.toString()}};
+    }
+}
+
+QJsonArray attributeList(const QList<QPair<QString, QVariant>>& attributes)
+{
+    QJsonArray list;
+    for (const auto& attribute : attributes) {
+        list.append(QJsonObject{
+            {QStringLiteral("key"), attribute.first},
+            {QStringLiteral("value"), attributeValue(attribute.second)},
+        });
+    }
+    return list;
+}
+
+void appendHeaders(QList<QPair<QByteArray, QByteArray>>& headers, const QString& list)
+{
+    for (const QString& entry : list.split(u',', Qt::SkipEmptyParts)) {
+        const qsizetype equals = entry.indexOf(u'=');
+        if (equals <= 0) {
+            continue;
+        }
+        headers.append({entry.left(equals).trimmed().toLatin1(),
+                        QByteArray::fromPercentEncoding(entry.mid(equals + 1).trimmed().toUtf8())});
+    }
+}
+
+} // namespace
+
+QByteArray Tracer::Context::traceparent() const
+{
+    return "00-" + traceId + '-' + spanId + (sampled ? "-01" : "-00");
+}
+
+Tracer::Context Tracer::Context::fromTraceparent(QByteArrayView header)
+{
+    // version-traceid-spanid-flags, 2, 32, 16 and 2 hex digits
+    const QByteArrayView value = header.trimmed();
+    if (value.size() != 55 || value[2] != '-' || value[35] != '-' || value[52] != '-'
+        || !value.startsWith("00")) {
+        return Context();
+    }
+    const QByteArrayView traceId = value.sliced(3, 32);
+    const QByteArrayView spanId = value.sliced(36, 16);
+    const QByteArrayView flags = value.sliced(53, 2);
+    if (!isLowerHex(traceId) || !isLowerHex(spanId) || !isLowerHex(flags) || isAllZero(traceId)
+        || isAllZero(spanId)) {
+        return Context();
+    }
+    Context context;
+    context.traceId = traceId.toByteArray();
+    context.spanId = spanId.toByteArray();
+    context.sampled = (QByteArray::fromHex(flags.toByteArray()).at(0) & 0x01) != 0;
+    return context;
+}
+
+Tracer::Config Tracer::Config::fromEnvironment()
+{
+    Config config;
+    const QString disabled = qEnvironmentVariable("OTEL_SDK_DISABLED").trimmed().toLower();
+    const QString exporter = qEnvironmentVariable("OTEL_TRACES_EXPORTER").trimmed().toLower();
+    if (disabled == QLatin1String("true") || (!exporter.isEmpty() && exporter != QLatin1String("otlp"))) {
+        return config;
+    }
+
+    config.endpoint = qEnvironmentVariable("OTEL_EXPORTER_OTLP_TRACES_ENDPOINT").trimmed();
+    if (config.endpoint.isEmpty()) {
+        QString base = qEnvironmentVariable("OTEL_EXPORTER_OTLP_ENDPOINT").trimmed();
+        while (base.endsWith(u'/')) {
+            base.chop(1);
+        }
+        if (!base.isEmpty()) {
+            config.endpoint = base + QStringLiteral("/v1/traces");
+        }
+    }
+    QString protocol = qEnvironmentVariable("OTEL_EXPORTER_OTLP_TRACES_PROTOCOL").trimmed();
+    if (protocol.isEmpty()) {
+        protocol = qEnvironmentVariable("OTEL_EXPORTER_OTLP_PROTOCOL").trimmed();
+    }
+    if (!config.endpoint.isEmpty() && !protocol.isEmpty() && protocol != QLatin1String("http/json")) {
+        CP_WARN << "Tracer: only the http/json OTLP protocol is supported, not" << protocol
+                << "; exporting JSON to" << config.endpoint;
+    }
+
+    appendHeaders(config.headers, qEnvironmentVariable("OTEL_EXPORTER_OTLP_HEADERS"));
+    appendHeaders(config.headers, qEnvironmentVariable("OTEL_EXPORTER_OTLP_TRACES_HEADERS"));
+    const QString serviceName = qEnvironmentVariable("OTEL_SERVICE_NAME").trimmed();
+    if (!serviceName.isEmpty()) {
+        config.serviceName = serviceName;
+    }
+    config.parent = Context::fromTraceparent(qgetenv("TRACEPARENT"));
+
+    bool ok = false;
+    const int delay = qEnvironmentVariableIntValue("OTEL_BSP_SCHEDULE_DELAY", &ok);
+    if (ok && delay > 0) {
+        config.scheduleDelayMs = delay;
+    }
+    const int queueSize = qEnvironmentVariableIntValue("OTEL_BSP_MAX_QUEUE_SIZE", &ok);
+    if (ok && queueSize > 0) {
+        config.maxQueueSize = queueSize;
+    }
+    const int batchSize = qEnvironmentVariableIntValue("OTEL_BSP_MAX_EXPORT_BATCH_SIZE", &ok);
+    if (ok && batchSize > 0) {
+        config.maxBatchSize = qMin(batchSize, config.maxQueueSize);
+    }
+    return config;
+}
+
+struct Tracer::Span::Data {
+    Tracer* tracer {nullptr};
+    Context context;
+    std::mutex mutex;
+    Record record;
+    bool ended {false};
+};
+
+Tracer::Span::Span() = default;
+
+Tracer::Span::Span(std::unique_ptr<Data> data)
+    : m_data(std::move(data))
+{
+}
+
+Tracer::Span::~Span()
+{
+    end();
+}
+
+Tracer::Span::Span(Span&& other) noexcept = default;
+
+Tracer::Span& Tracer::Span::operator=(Span&& other) noexcept
+{
+    if (this != &other) {
+        end();
+        m_data = std::move(other.m_data);
+    }
+    return *this;
+}
+
+Tracer::Context Tracer::Span::context() const
+{
+    return m_data ? m_data->context : Context();
+}
+
+void Tracer::Span::setAttribute(const QString& key, const QVariant& value)
+{
+    if (!m_data) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_data->mutex);
+    if (m_data->ended) {
+        return;
+    }
+    for (auto& attribute : m_data->record.attributes) {
+        if (attribute.first == key) {
+            attribute.second = value;
+            return;
+        }
+    }
+    m_data->record.attributes.append({key, value});
+}
+
+void Tracer::Span::setError(const QString& message)
+{
+    if (!m_data) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_data->mutex);
+    if (!m_data->ended) {
+        m_data->record.error = true;
+        m_data->record.statusMessage = message;
+    }
+}
+
+void Tracer::Span::end()
+{
+    if (!m_data) {
+        return;
+    }
+    Record record;
+    {
+        std::lock_guard<std::mutex> lock(m_data->mutex);
+        if (m_data->ended) {
+            return;
+        }
+        m_data->ended = true;
+        record = std::move(m_data->record);
+    }
+    record.endNs = nowUnixNs();
+    m_data->tracer->enqueue(std::move(record));
+}
+
+Tracer::Scope::Scope(Span& span)
+    : m_previousContext(t_currentContext)
+    , m_previousSpan(t_currentSpan)
+{
+    if (span.isRecording()) {
+        t_currentContext = span.context();
+        t_currentSpan = &span;
+    }
+}
+
+Tracer::Scope::Scope(const Context& context)
+    : m_previousContext(t_currentContext)
+    , m_previousSpan(t_currentSpan)
+{
+    t_currentContext = context;
+    t_currentSpan = nullptr;
+}
+
+Tracer::Scope::~Scope()
+{
+    t_currentContext = m_previousContext;
+    t_currentSpan = m_previousSpan;
+}
+
+Tracer& Tracer::instance()
+{
+    // Never destroyed: workers may still end spans while statics are torn down.
+    // main() flushes it before returning.
+    static Tracer* tracer = new Tracer(Config::fromEnvironment());
+    return *tracer;
+}
+
+Tracer::Tracer(Config config, Sender sender)
+    : m_config(std::move(config))
+    , m_sender(std::move(sender))
+    , m_enabled(!m_config.endpoint.isEmpty() || m_sender)
+{
+    if (!m_enabled) {
+        return;
+    }
+    if (!m_sender) {
+        m_sender = [endpoint = m_config.endpoint.toStdString(), headers = m_config.headers](const QByteArray& body) {
+            cpr::Header header {{"Content-Type", "application/json"}};
+            for (const auto& entry : headers) {
+                header[entry.first.toStdString()] = entry.second.toStdString();
+            }
+            const cpr::Response response = cpr::Post(cpr::Url {endpoint}, header,
+                                                     cpr::Body {body.constData(), static_cast<size_t>(body.size())},
+                                                     cpr::Timeout {kExportTimeoutMs});
+            return response.status_code >= 200 && response.status_code < 300;
+        };
+        CP_CLOG(tracing) << "Exporting traces to" << m_config.endpoint;
+    }
+    m_exporter = std::thread([this]() { run(); });
+}
+
+Tracer::~Tracer()
+{
+    if (!m_exporter.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_exporter.join();
+}
+
+Tracer::Span Tracer::startSpan(const QString& name, Kind kind)
+{
+    return startSpan(name, kind, current());
+}
+
+Tracer::Span Tracer::startSpan(const QString& name, Kind kind, const Context& parent)
+{
+    if (!m_enabled) {
+        return Span();
+    }
+    const Context& effectiveParent = parent.isValid() ? parent : m_config.parent;
+    // Parent-based sampling: an unsampled caller keeps its whole trace unrecorded
+    if (effectiveParent.isValid() && !effectiveParent.sampled) {
+        return Span();
+    }
+
+    auto data = std::make_unique<Span::Data>();
+    data->tracer = this;
+    data->context.traceId = effectiveParent.isValid() ? effectiveParent.traceId : randomHexId(16);
+    data->context.spanId = randomHexId(8);
+    data->record.context = data->context;
+    data->record.parentSpanId = effectiveParent.isValid() ? effectiveParent.spanId : QByteArray();
+    data->record.name = name;
+    data->record.kind = kind;
+    data->record.startNs = nowUnixNs();
+    return Span(std::move(data));
+}
+
+Tracer::Context Tracer::current()
+{
+    return t_currentContext;
+}
+
+Tracer::Span* Tracer::currentSpan()
+{
+    return t_currentSpan;
+}
+
+void Tracer::flush()
+{
+    if (!m_exporter.joinable()) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_flushRequested = true;
+    m_wake.notify_one();
+    m_idle.wait(lock, [this]() { return m_queue.empty() && !m_exporting; });
+}
+
+void Tracer::enqueue(Record record)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (static_cast<int>(m_queue.size()) >= m_config.maxQueueSize) {
+        m_dropped.fetch_add(1);
+        return;
+    }
+    m_queue.push_back(std::move(record));
+    if (static_cast<int>(m_queue.size()) >= m_config.maxBatchSize) {
+        m_wake.notify_one();
+    }
+}
+
+void Tracer::run()
+{
+    bool failing = false;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_wake.wait_for(lock, std::chrono::milliseconds(m_config.scheduleDelayMs), [this]() {
+            return m_stopping || m_flushRequested || static_cast<int>(m_queue.size()) >= m_config.maxBatchSize;
+        });
+        if (m_queue.empty()) {
+            m_flushRequested = false;
+            m_idle.notify_all();
+            if (m_stopping) {
+                return;
+            }
+            continue;
+        }
+
+        const std::size_t count = std::min<std::size_t>(m_queue.size(), static_cast<std::size_t>(m_config.maxBatchSize));
+        std::vector<Record> batch;
+        batch.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            batch.push_back(std::move(m_queue.front()));
+            m_queue.pop_front();
+        }
+        m_exporting = true;
+        lock.unlock();
+
+        const bool sent = m_sender(exportBody(batch));
+        // One warning per outage rather than one per batch
+        if (!sent && !failing) {
+            CP_WARN << "Tracer: could not export" << batch.size() << "spans to" << m_config.endpoint
+                    << "; spans are dropped until the collector answers";
+        }
+        failing = !sent;
+
+        lock.lock();
+        m_exporting = false;
+        if (!sent) {
+            m_dropped.fetch_add(batch.size());
+        }
+    }
+}
+
+QByteArray Tracer::exportBody(const std::vector<Record>& records) const
+{
+    QJsonArray spans;
+    for (const Record& record : records) {
+        QJsonObject span{
+            {QStringLiteral("traceId"), QString::fromLatin1(record.context.traceId)},
+            {QStringLiteral("spanId"), QString::fromLatin1(record.context.spanId)},
+            {QStringLiteral("name"), record.name},
+            {QStringLiteral("kind"), static_cast<int>(record.kind)},
+            {QStringLiteral("startTimeUnixNano"), QString::number(record.startNs)},
+            {QStringLiteral("endTimeUnixNano"), QString::number(record.endNs)},
+            {QStringLiteral("attributes"), attributeList(record.attributes)},
+        };
+        if (!record.parentSpanId.isEmpty()) {
+            span.insert(QStringLiteral("parentSpanId"), QString::fromLatin1(record.parentSpanId));
+        }
+        if (record.error) {
+            // STATUS_CODE_ERROR
+            span.insert(QStringLiteral("status"), QJsonObject{
+                {QStringLiteral("code"), 2},
+                {QStringLiteral("message"), record.statusMessage},
+            });
+        }
+        spans.append(span);
+    }
+
+    QList<QPair<QString, QVariant>> resource = {{QStringLiteral("service.name"), m_config.serviceName}};
+    const QString version = QCoreApplication::applicationVersion();
+    if (!version.isEmpty()) {
+        resource.append({QStringLiteral("service.version"), version});
+    }
+    const QJsonObject scopeSpans{
+        {QStringLiteral("scope"), QJsonObject{{QStringLiteral("name"), QStringLiteral("cognitive-pipelines")}}},
+        {QStringLiteral("spans"), spans},
+    };
+    const QJsonObject resourceSpans{
+        {QStringLiteral("resource"), QJsonObject{{QStringLiteral("attributes"), attributeList(resource)}}},
+        {QStringLiteral("scopeSpans"), QJsonArray{scopeSpans}},
+    };
+    const QJsonObject root{{QStringLiteral("resourceSpans"), QJsonArray{resourceSpans}}};
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
@@ -0,0 +1,194 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QVariant>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// OpenTelemetry spans for pipeline runs, node executions, scope body passes and
+// backend requests, exported over OTLP/HTTP in its JSON encoding. Ending a span queues
+// it; one exporter thread posts batches, so the only cost on a worker is building the
+// record. Outgoing backend requests carry the W3C traceparent header of their span.
+//
+// The current span is kept per thread, like CancellationToken: a Scope makes a span
+// current, and work that moves to another thread captures current() and installs it
+// there with a Scope so its spans keep their parent.
+//
+// Config::fromEnvironment() reads the standard variables:
+//   OTEL_EXPORTER_OTLP_TRACES_ENDPOINT   full URL of the traces endpoint, or
+//   OTEL_EXPORTER_OTLP_ENDPOINT          base URL, with /v1/traces appended
+//   OTEL_EXPORTER_OTLP_(TRACES_)HEADERS  key=value,... sent with every export
+//   OTEL_SERVICE_NAME                    service.name, cognitive-pipelines by default
+//   OTEL_BSP_SCHEDULE_DELAY, OTEL_BSP_MAX_QUEUE_SIZE, OTEL_BSP_MAX_EXPORT_BATCH_SIZE
+//   OTEL_SDK_DISABLED=true or OTEL_TRACES_EXPORTER=none turn tracing off
+//   TRACEPARENT                          parent of root spans, e.g. from a CI job
+// Tracing is off unless an endpoint is set.
+class Tracer {
+public:
+    static constexpr int kDefaultScheduleDelayMs = 5000;
+    static constexpr int kDefaultMaxQueueSize = 2048;
+    static constexpr int kDefaultMaxBatchSize = 512;
+
+    enum class Kind { Internal = 1, Server = 2, Client = 3 };
+
+    struct Context {
+        // Lowercase hex: 32 digits for the trace, 16 for the span
+        QByteArray traceId;
+        QByteArray spanId;
+        bool sampled {true};
+
+        bool isValid() const { return traceId.size() == 32 && spanId.size() == 16; }
+        // "00-<trace id>-<span id>-<flags>"
+        QByteArray traceparent() const;
+        // An invalid context unless the header is a well-formed version 00 traceparent
+        static Context fromTraceparent(QByteArrayView header);
+    };
+
+    struct Config {
+        // Full URL of the traces endpoint; empty leaves tracing off
+        QString endpoint;
+        QString serviceName {QStringLiteral("cognitive-pipelines")};
+        QList<QPair<QByteArray, QByteArray>> headers;
+        Context parent;
+        int scheduleDelayMs {kDefaultScheduleDelayMs};
+        int maxQueueSize {kDefaultMaxQueueSize};
+        int maxBatchSize {kDefaultMaxBatchSize};
+
+        static Config fromEnvironment();
+    };
+
+    // Posts one export request body; false when the collector did not take it
+    using Sender = std::function<bool(const QByteArray& body)>;
+
+    class Span {
+    public:
+        // A span that records nothing
+        Span();
+        ~Span();
+        Span(Span&& other) noexcept;
+        Span& operator=(Span&& other) noexcept;
+
+        bool isRecording() const { return m_data != nullptr; }
+        Context context() const;
+
+        // Thread-safe; ignored once the span has ended
+        void setAttribute(const QString& key, const QVariant& value);
+        void setError(const QString& message);
+        // Queues the span for export; later calls do nothing. The destructor ends it too.
+        void end();
+
+    private:
+        friend class Tracer;
+        struct Data;
+        explicit Span(std::unique_ptr<Data> data);
+
+        std::unique_ptr<Data> m_data;
+    };
+
+    // Makes a span, or only its context, current on this thread for the lifetime of the scope
+    class Scope {
+    public:
+        explicit Scope(Span& span);
+        explicit Scope(const Context& context);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Context m_previousContext;
+        Span* m_previousSpan {nullptr};
+    };
+
+    // Configured from the environment on first use; never destroyed
+    static Tracer& instance();
+
+    // Posts to config.endpoint unless another sender is given
+    explicit Tracer(Config config, Sender sender = Sender());
+    // Exports what is still queued
+    ~Tracer();
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    bool isEnabled() const { return m_enabled; }
+
+    // A child of current(), or a root span when no span is current
+    Span startSpan(const QString& name, Kind kind = Kind::Internal);
+    Span startSpan(const QString& name, Kind kind, const Context& parent);
+
+    // The context of the span current on this thread, if any
+    static Context current();
+    // The span made current on this thread, or null when only a context was installed
+    static Span* currentSpan();
+
+    // Blocks until every span ended so far has been exported or dropped
+    void flush();
+    // Spans dropped because the queue was full or the collector refused them
+    quint64 droppedSpans() const { return m_dropped.load(); }
+
+private:
+    struct Record {
+        Context context;
+        QByteArray parentSpanId;
+        QString name;
+        Kind kind {Kind::Internal};
+        qint64 startNs {0};
+        qint64 endNs {0};
+        QList<QPair<QString, QVariant>> attributes;
+        bool error {false};
+        QString statusMessage;
+    };
+
+    void enqueue(Record record);
+    void run();
+    QByteArray exportBody(const std::vector<Record>& records) const;
+
+    Config m_config;
+    Sender m_sender;
+    const bool m_enabled;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    std::deque<Record> m_queue;
+    bool m_exporting {false};
+    bool m_flushRequested {false};
+    bool m_stopping {false};
+    std::atomic<quint64> m_dropped {0};
+    std::thread m_exporter;
+};
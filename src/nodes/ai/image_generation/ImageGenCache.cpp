@@ -0,0 +1,115 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "ImageGenCache.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutex>
+#include <QStandardPaths>
+
+namespace {
+
+QMutex g_sharedMutex;
+std::shared_ptr<ImageGenCache> g_shared;
+bool g_sharedConfigured = false;
+
+} // namespace
+
+ImageGenCache::ImageGenCache(const QString& directory, qint64 maxBytes)
+    : m_store(directory, maxBytes > 0 ? maxBytes : kDefaultMaxBytes)
+{
+}
+
+std::shared_ptr<ImageGenCache> ImageGenCache::shared()
+{
+    QMutexLocker locker(&g_sharedMutex);
+    if (!g_sharedConfigured) {
+        g_sharedConfigured = true;
+        const QString configured = qEnvironmentVariable("CP_IMAGE_GEN_CACHE").trimmed();
+        if (configured.isEmpty() || configured == QStringLiteral("1")) {
+            g_shared = std::make_shared<ImageGenCache>(defaultDirectory());
+        } else if (configured != QStringLiteral("0")) {
+            g_shared = std::make_shared<ImageGenCache>(configured);
+        }
+    }
+    return g_shared;
+}
+
+void ImageGenCache::setShared(std::shared_ptr<ImageGenCache> cache)
+{
+    QMutexLocker locker(&g_sharedMutex);
+    g_shared = std::move(cache);
+    g_sharedConfigured = true;
+}
+
+QString ImageGenCache::defaultDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/generated_images");
+}
+
+QString ImageGenCache::makeKey(const QString& providerId, const QString& model, const QString& prompt,
+                               const QString& size, const QString& quality, const QString& style, int index)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    DiskLruStore::addField(hash, providerId.toUtf8());
+    DiskLruStore::addField(hash, model.toUtf8());
+    DiskLruStore::addField(hash, prompt.toUtf8());
+    DiskLruStore::addField(hash, size.toUtf8());
+    DiskLruStore::addField(hash, quality.toUtf8());
+    DiskLruStore::addField(hash, style.toUtf8());
+    DiskLruStore::addField(hash, QByteArray::number(index));
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QString ImageGenCache::fetch(const QString& key, const QString& directory, const QString& baseName)
+{
+    if (key.isEmpty()) return {};
+
+    const QStringList entries = m_store.entriesFor(key);
+    if (entries.isEmpty() || !QDir().mkpath(directory)) return {};
+    const QString destination =
+        QDir(directory).filePath(baseName + QLatin1Char('.') + QFileInfo(entries.first()).suffix());
+    return m_store.fetch(entries.first(), destination) ? destination : QString();
+}
+
+bool ImageGenCache::store(const QString& key, const QString& sourcePath)
+{
+    if (key.isEmpty()) return false;
+
+    const QString suffix = QFileInfo(sourcePath).suffix().isEmpty() ? QStringLiteral("png")
+                                                                     : QFileInfo(sourcePath).suffix();
+    // A regenerated image replaces the old one, whatever its format was
+    return m_store.store(m_store.entryPath(key, QLatin1Char('.') + suffix), sourcePath, m_store.entriesFor(key));
+}
+
+qint64 ImageGenCache::sizeBytes() const
+{
+    return m_store.sizeBytes();
+}
+
+void ImageGenCache::clear()
+{
+    m_store.clear();
+}
@@ -0,0 +1,73 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <QString>
+
+#include <memory>
+
+#include "DiskLruStore.h"
+
+// Shared on-disk cache of generated images.
+//
+// Entries are keyed on the SHA-256 of everything that shapes a request: provider,
+// model, prompt, size, quality, style and the image's index within the run, so
+// asking for three images again returns the same three. A hit is hard linked into
+// the run's output directory, falling back to a copy where links are not
+// possible, and stores link the downloaded file into the cache the same way.
+// Entries keep the file's suffix and live in a DiskLruStore trimmed to maxBytes.
+//
+// The shared instance lives in defaultDirectory() unless CP_IMAGE_GEN_CACHE names
+// another directory; "0" turns it off.
+class ImageGenCache {
+public:
+    static constexpr qint64 kDefaultMaxBytes = 1LL * 1024 * 1024 * 1024;
+
+    explicit ImageGenCache(const QString& directory, qint64 maxBytes = kDefaultMaxBytes);
+
+    // The cache ImageGenNode consults, or nullptr while caching is off.
+    static std::shared_ptr<ImageGenCache> shared();
+    static void setShared(std::shared_ptr<ImageGenCache> cache);
+    static QString defaultDirectory();
+
+    static QString makeKey(const QString& providerId, const QString& model, const QString& prompt,
+                           const QString& size, const QString& quality, const QString& style, int index);
+
+    const QString& directory() const { return m_store.directory(); }
+
+    // Places the cached image in directory as baseName plus the entry's suffix,
+    // replacing any file there. Returns the new path, or empty on a miss.
+    QString fetch(const QString& key, const QString& directory, const QString& baseName);
+
+    bool store(const QString& key, const QString& sourcePath);
+
+    // Bytes of entries on disk, as tracked by this process.
+    qint64 sizeBytes() const;
+
+    void clear();
+
+private:
+    DiskLruStore m_store;
+};
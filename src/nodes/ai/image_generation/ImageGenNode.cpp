@@ -22,18 +22,28 @@
 // SOFTWARE.
 //
 #include "ImageGenNode.h"
-#include "ImageGenPropertiesWidget.h"
+#include "ImageGenCache.h"
 #include "ai/registry/LLMProviderRegistry.h"
 #include "ai/backends/ILLMBackend.h"
 #include "ai/catalog/ModelCatalogService.h"
 #include "ModelCapsRegistry.h"
 #include "Logger.h"
+#include "NodeOutputDir.h"
+#include "PartialOutputSink.h"
 
+#include <QDir>
+#include <QFile>
 #include <QJsonObject>
 #include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPromise>
 #include <QVariant>
 #include <QFuture>
 
+#include <atomic>
+#include <memory>
+
 ImageGenNode::ImageGenNode(QObject* parent)
     : QObject(parent)
     , m_providerId(QString::fromLatin1(kProviderOpenAI))
@@ -78,27 +88,23 @@ NodeDescriptor ImageGenNode::getDescriptor() const
     outPin.type = QStringLiteral("text");
     desc.outputPins.insert(outPin.id, outPin);
 
+    // Output pin: every saved image, in request order
+    PinDefinition pathsPin;
+    pathsPin.direction = PinDirection::Output;
+    pathsPin.id = QString::fromLatin1(kOutputImagePathsPinId);
+    pathsPin.name = QStringLiteral("Images");
+    pathsPin.type = QStringLiteral("json");
+    desc.outputPins.insert(pathsPin.id, pathsPin);
+
     return desc;
 }
 
-QWidget* ImageGenNode::createConfigurationWidget(QWidget* parent)
+TokenList ImageGenNode::execute(const TokenList& incomingTokens)
 {
-    auto* widget = new ImageGenPropertiesWidget(parent);
-    m_widget = widget;
-
-    widget->setProvider(m_providerId);
-    widget->setModel(m_model);
-    widget->setSize(m_size);
-    widget->setQuality(m_quality);
-    widget->setStyle(m_style);
-
-    connect(widget, &ImageGenPropertiesWidget::configChanged,
-            this, &ImageGenNode::handleConfigChanged);
-
-    return widget;
+    return executeAsync(incomingTokens).result();
 }
 
-TokenList ImageGenNode::execute(const TokenList& incomingTokens)
+QFuture<TokenList> ImageGenNode::executeAsync(const TokenList& incomingTokens)
 {
     // Merge incoming tokens
     DataPacket inputs;
@@ -124,13 +130,19 @@ TokenList ImageGenNode::execute(const TokenList& incomingTokens)
     const QString style = m_style.trimmed().isEmpty()
         ? QStringLiteral("vivid")
         : m_style.trimmed();
+    const int count = qBound(1, m_count, kMaxCount);
+    // Hits are linked into the run directory, so without one every image is requested.
+    // Always regenerating skips the lookup but still stores, so the newest image is reused.
+    const std::shared_ptr<ImageGenCache> cache = ImageGenCache::shared();
+    const bool lookUp = !m_alwaysRegenerate;
 
     const QString prompt = inputs.value(QString::fromLatin1(kInputPromptPinId)).toString().trimmed();
-    const QString outputDir = inputs.value(QStringLiteral("_sys_node_output_dir")).toString();
+    const QString outputDir = NodeOutputDir::materialize(inputs);
 
     DataPacket output;
     const QString outputPinId = QString::fromLatin1(kOutputImagePathPinId);
     output.insert(outputPinId, QVariant());
+    output.insert(QString::fromLatin1(kOutputImagePathsPinId), QStringList{});
     output.insert(QStringLiteral("_provider"), providerId);
     output.insert(QStringLiteral("_model"), model);
     if (const auto resolvedRule = ModelCapsRegistry::instance().resolveWithRule(model, providerId);
@@ -140,13 +152,14 @@ TokenList ImageGenNode::execute(const TokenList& incomingTokens)
     output.insert(QStringLiteral("_size"), size);
     output.insert(QStringLiteral("_quality"), quality);
     output.insert(QStringLiteral("_style"), style);
+    output.insert(QStringLiteral("_count"), count);
 
     if (prompt.isEmpty()) {
         const QString err = QStringLiteral("Image generation prompt is empty.");
         output.insert(outputPinId, err);
         output.insert(QStringLiteral("__error"), err);
 
-        ExecutionToken token; token.data = output; return TokenList{token};
+        ExecutionToken token; token.data = output; return makeReadyTokenFuture(TokenList{token});
     }
 
     ILLMBackend* backend = LLMProviderRegistry::instance().getBackend(providerId);
@@ -156,35 +169,171 @@ TokenList ImageGenNode::execute(const TokenList& incomingTokens)
         output.insert(outputPinId, err);
         output.insert(QStringLiteral("__error"), err);
 
-        ExecutionToken token; token.data = output; return TokenList{token};
+        ExecutionToken token; token.data = output; return makeReadyTokenFuture(TokenList{token});
     }
 
-    QString imagePath;
-    try {
-        QFuture<QString> future = backend->generateImage(prompt, model, size, quality, style, outputDir);
-        imagePath = future.result();
-    } catch (const std::exception& e) {
-        imagePath = QStringLiteral("ERROR: Exception during image generation: %1").arg(QString::fromUtf8(e.what()));
-    } catch (...) {
-        imagePath = QStringLiteral("ERROR: Unknown exception during image generation.");
-    }
+    // Every request lands on its own; the last one to land completes the token. A single
+    // image is written straight into the run directory as before, several go to a
+    // subdirectory per request and are moved up under their index once saved.
+    struct Batch {
+        QPromise<TokenList> promise;
+        QMutex mutex;
+        QStringList paths;
+        QStringList errors;
+        int remaining {0};
+        std::atomic<int> cacheHits {0};
+    };
+    auto batch = std::make_shared<Batch>();
+    batch->paths.resize(count);
+    batch->remaining = count;
+    batch->promise.start();
+    QFuture<TokenList> result = batch->promise.future();
 
-    QFileInfo fileInfo(imagePath);
-    if (imagePath.trimmed().isEmpty() || !fileInfo.exists()) {
-        const QString err = imagePath.trimmed().isEmpty()
-            ? QStringLiteral("Image generation failed for provider '%1' model '%2'.").arg(providerId, model)
-            : imagePath;
-        CP_WARN.noquote() << QStringLiteral("ImageGenNode: generation failure provider=%1 model=%2 message=%3")
-                                      .arg(providerId, model, err);
-        output.insert(outputPinId, err);
-        output.insert(QStringLiteral("__error"), err);
-    } else {
-        output.insert(outputPinId, fileInfo.absoluteFilePath());
+    const PartialOutputSink sink = PartialOutputSink::current();
+    const QString imagePathsPinId = QString::fromLatin1(kOutputImagePathsPinId);
+
+    auto land = [batch, output, outputPinId, imagePathsPinId, providerId, model, outputDir, count,
+                 sink, cached = cache != nullptr](int index, QString imagePath) mutable {
+        QFileInfo fileInfo(imagePath);
+        QString error;
+        if (imagePath.trimmed().isEmpty() || !fileInfo.exists()) {
+            error = imagePath.trimmed().isEmpty()
+                ? QStringLiteral("Image generation failed for provider '%1' model '%2'.").arg(providerId, model)
+                : imagePath;
+            CP_WARN.noquote() << QStringLiteral("ImageGenNode: generation failure provider=%1 model=%2 image=%3 message=%4")
+                                          .arg(providerId, model)
+                                          .arg(index + 1)
+                                          .arg(error);
+        } else if (count > 1) {
+            imagePath = fileInfo.absoluteFilePath();
+            if (!outputDir.isEmpty()) {
+                const QString suffix = fileInfo.suffix().isEmpty() ? QStringLiteral("png") : fileInfo.suffix();
+                const QString finalPath = QDir(outputDir).filePath(
+                    QStringLiteral("generated_image_%1.%2").arg(index + 1).arg(suffix));
+                QFile::remove(finalPath);
+                if (QFile::rename(imagePath, finalPath)) {
+                    QDir().rmdir(fileInfo.absolutePath());
+                    imagePath = finalPath;
+                }
+            }
+            // Out as soon as it is saved, so downstream nodes start on it while the rest download
+            ExecutionToken image;
+            image.data.insert(outputPinId, imagePath);
+            image.forceExecution = true;
+            sink.publish(TokenList{image});
+        } else {
+            imagePath = fileInfo.absoluteFilePath();
+        }
+
+        QStringList paths;
+        QStringList errors;
+        {
+            QMutexLocker locker(&batch->mutex);
+            if (error.isEmpty()) {
+                batch->paths[index] = imagePath;
+            } else {
+                batch->errors << (count > 1 ? QStringLiteral("Image %1: %2").arg(index + 1).arg(error) : error);
+            }
+            if (--batch->remaining > 0) {
+                return;
+            }
+            for (const QString& path : std::as_const(batch->paths)) {
+                if (!path.isEmpty()) {
+                    paths << path;
+                }
+            }
+            errors = batch->errors;
+        }
+
+        output.insert(imagePathsPinId, paths);
+        if (cached) {
+            output.insert(QStringLiteral("_image_cache_hits"), batch->cacheHits.load());
+        }
+        if (paths.isEmpty()) {
+            const QString err = errors.join(QLatin1Char('\n'));
+            output.insert(outputPinId, err);
+            output.insert(QStringLiteral("__error"), err);
+        } else {
+            // Several images already went out one by one; repeating the first would run it twice downstream
+            if (count == 1 || !sink.isActive()) {
+                output.insert(outputPinId, paths.first());
+            }
+            if (!errors.isEmpty()) {
+                output.insert(QStringLiteral("_errors"), errors);
+            }
+        }
+
+        ExecutionToken token;
+        token.data = output;
+        batch->promise.addResult(TokenList{token});
+        batch->promise.finish();
+    };
+
+    for (int i = 0; i < count; ++i) {
+        QString targetDir = outputDir;
+        if (count > 1 && !outputDir.isEmpty()) {
+            targetDir = QDir(outputDir).filePath(QStringLiteral("image_%1").arg(i + 1));
+            QDir().mkpath(targetDir);
+        }
+
+        const QString cacheKey = cache && !outputDir.isEmpty()
+            ? ImageGenCache::makeKey(providerId, model, prompt, size, quality, style, i)
+            : QString();
+        if (lookUp && !cacheKey.isEmpty()) {
+            const QString cachedPath = cache->fetch(cacheKey, targetDir, QStringLiteral("generated_image"));
+            if (!cachedPath.isEmpty()) {
+                batch->cacheHits.fetch_add(1);
+                land(i, cachedPath);
+                continue;
+            }
+        }
+        if (cache && !targetDir.isEmpty()) {
+            // An earlier hit may be a link into the cache; writing through it would change the entry
+            const QDir dir(targetDir);
+            for (const QString& previous : dir.entryList({QStringLiteral("generated_image.*")}, QDir::Files)) {
+                QFile::remove(dir.filePath(previous));
+            }
+        }
+
+        // Each request takes its own turn through the provider's shared limiters
+        QFuture<QString> future;
+        try {
+            future = backend->generateImage(prompt, model, size, quality, style, targetDir);
+        } catch (const std::exception& e) {
+            land(i, QStringLiteral("ERROR: Exception during image generation: %1").arg(QString::fromUtf8(e.what())));
+            continue;
+        } catch (...) {
+            land(i, QStringLiteral("ERROR: Unknown exception during image generation."));
+            continue;
+        }
+
+        // Continue on whichever thread finishes the download; no thread waits for it
+        future.then(QtFuture::Launch::Sync, [land, i, cache, cacheKey](QFuture<QString> finished) mutable {
+            QString imagePath;
+            try {
+                imagePath = finished.result();
+            } catch (const std::exception& e) {
+                imagePath = QStringLiteral("ERROR: Exception during image generation: %1").arg(QString::fromUtf8(e.what()));
+            } catch (...) {
+                imagePath = QStringLiteral("ERROR: Unknown exception during image generation.");
+            }
+            // Stored before land() moves the file; the link follows it
+            if (!cacheKey.isEmpty() && !imagePath.trimmed().isEmpty() && QFileInfo(imagePath).isFile()) {
+                cache->store(cacheKey, imagePath);
+            }
+            land(i, imagePath);
+        });
     }
 
-    ExecutionToken token;
-    token.data = output;
-    return TokenList{token};
+    return result;
+}
+
+void ImageGenNode::warmUp()
+{
+    const QString providerId = m_providerId.trimmed().isEmpty()
+        ? QString::fromLatin1(kProviderOpenAI)
+        : m_providerId.trimmed().toLower();
+    LLMProviderRegistry::instance().warmUpInBackground(providerId, m_model.trimmed());
 }
 
 QJsonObject ImageGenNode::saveState() const
@@ -195,6 +344,8 @@ QJsonObject ImageGenNode::saveState() const
     obj.insert(QStringLiteral("size"), m_size);
     obj.insert(QStringLiteral("quality"), m_quality);
     obj.insert(QStringLiteral("style"), m_style);
+    obj.insert(QStringLiteral("count"), m_count);
+    obj.insert(QStringLiteral("always_regenerate"), m_alwaysRegenerate);
     return obj;
 }
 
@@ -215,24 +366,10 @@ void ImageGenNode::loadState(const QJsonObject& data)
     if (data.contains(QStringLiteral("style"))) {
         m_style = data.value(QStringLiteral("style")).toString(m_style);
     }
-
-    if (m_widget) {
-        m_widget->setProvider(m_providerId);
-        m_widget->setModel(m_model);
-        m_widget->setSize(m_size);
-        m_widget->setQuality(m_quality);
-        m_widget->setStyle(m_style);
+    if (data.contains(QStringLiteral("count"))) {
+        m_count = qBound(1, data.value(QStringLiteral("count")).toInt(m_count), kMaxCount);
     }
-}
+    m_alwaysRegenerate = data.value(QStringLiteral("always_regenerate")).toBool(m_alwaysRegenerate);
 
-void ImageGenNode::handleConfigChanged()
-{
-    if (!m_widget) return;
-
-    const QString providerName = m_widget->provider().trimmed();
-    m_providerId = providerName.isEmpty() ? QString::fromLatin1(kProviderOpenAI) : providerName.toLower();
-    m_model = m_widget->model().trimmed();
-    m_size = m_widget->size().trimmed();
-    m_quality = m_widget->quality().trimmed();
-    m_style = m_widget->style().trimmed();
+    emit stateLoaded();
 }
@@ -24,13 +24,12 @@
 #pragma once
 
 #include <QObject>
-#include <QPointer>
 #include <QString>
 
 #include "IToolNode.h"
 #include "CommonDataTypes.h"
 
-class ImageGenPropertiesWidget;
+class QWidget;
 
 class ImageGenNode : public QObject, public IToolNode {
     Q_OBJECT
@@ -40,18 +39,27 @@ public:
     ~ImageGenNode() override = default;
 
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in ImageGenPropertiesWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     TokenList execute(const TokenList& incomingTokens) override;
+    ResourceClass resourceClass() const override { return ResourceClass::Network; }
+    bool supportsAsyncExecution() const override { return true; }
+    QFuture<TokenList> executeAsync(const TokenList& incomingTokens) override;
+    void warmUp() override;
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
 
 public:
     static constexpr const char* kInputPromptPinId = "prompt";
     static constexpr const char* kOutputImagePathPinId = "image_path";
+    static constexpr const char* kOutputImagePathsPinId = "image_paths";
     static constexpr const char* kProviderOpenAI = "openai";
+    // Images per run; each one is its own concurrent request
+    static constexpr int kMaxCount = 10;
 
-private slots:
-    void handleConfigChanged();
+signals:
+    // loadState() replaced the settings; an open properties widget shows them again
+    void stateLoaded();
 
 private:
     QString m_providerId;
@@ -59,6 +67,7 @@ private:
     QString m_size;
     QString m_quality;
     QString m_style;
-
-    QPointer<ImageGenPropertiesWidget> m_widget;
+    int m_count {1};
+    // Always call the provider instead of linking a cached image (the result is still stored)
+    bool m_alwaysRegenerate {false};
 };
@@ -22,6 +22,7 @@
 // SOFTWARE.
 //
 #include "ImageGenPropertiesWidget.h"
+#include "ImageGenNode.h"
 
 #include <QCheckBox>
 #include <QComboBox>
@@ -31,6 +32,7 @@
 #include <QLabel>
 #include <QPushButton>
 #include <QSignalBlocker>
+#include <QSpinBox>
 #include <QStandardItemModel>
 #include <QVBoxLayout>
 
@@ -166,6 +168,19 @@ ImageGenPropertiesWidget::ImageGenPropertiesWidget(QWidget* parent)
     });
     layout->addRow(tr("Style:"), m_styleCombo);
 
+    // Images per run, each its own request
+    m_countSpin = new QSpinBox(this);
+    m_countSpin->setRange(1, ImageGenNode::kMaxCount);
+    m_countSpin->setValue(1);
+    m_countSpin->setToolTip(tr("Requests run concurrently within the provider's rate limit; "
+                               "each image is passed on as soon as it is saved"));
+    layout->addRow(tr("Images:"), m_countSpin);
+
+    m_alwaysRegenerateCheck = new QCheckBox(tr("Always regenerate"), this);
+    m_alwaysRegenerateCheck->setToolTip(tr("Call the image API even when the same prompt and settings were "
+                                           "generated before, instead of linking the cached image"));
+    layout->addRow(QString(), m_alwaysRegenerateCheck);
+
     rootLayout->addLayout(layout);
     rootLayout->addStretch();
 
@@ -180,6 +195,8 @@ ImageGenPropertiesWidget::ImageGenPropertiesWidget(QWidget* parent)
     connectCombo(m_sizeCombo);
     connectCombo(m_qualityCombo);
     connectCombo(m_styleCombo);
+    connect(m_countSpin, &QSpinBox::valueChanged, this, &ImageGenPropertiesWidget::configChanged);
+    connect(m_alwaysRegenerateCheck, &QCheckBox::toggled, this, &ImageGenPropertiesWidget::configChanged);
 
     connect(m_providerCombo, qOverload<int>(&QComboBox::currentIndexChanged),
             this, &ImageGenPropertiesWidget::onProviderChanged);
@@ -230,6 +247,16 @@ QString ImageGenPropertiesWidget::style() const
     return m_styleCombo ? m_styleCombo->currentText() : QString();
 }
 
+int ImageGenPropertiesWidget::count() const
+{
+    return m_countSpin ? m_countSpin->value() : 1;
+}
+
+bool ImageGenPropertiesWidget::alwaysRegenerate() const
+{
+    return m_alwaysRegenerateCheck && m_alwaysRegenerateCheck->isChecked();
+}
+
 void ImageGenPropertiesWidget::setProvider(const QString& providerName)
 {
     if (setComboValue(m_providerCombo, providerName) < 0 && m_providerCombo && m_providerCombo->count() > 0) {
@@ -260,6 +287,22 @@ void ImageGenPropertiesWidget::setStyle(const QString& styleValue)
     setComboValue(m_styleCombo, styleValue);
 }
 
+void ImageGenPropertiesWidget::setCount(int count)
+{
+    if (m_countSpin) {
+        QSignalBlocker blocker(m_countSpin);
+        m_countSpin->setValue(count);
+    }
+}
+
+void ImageGenPropertiesWidget::setAlwaysRegenerate(bool always)
+{
+    if (m_alwaysRegenerateCheck) {
+        QSignalBlocker blocker(m_alwaysRegenerateCheck);
+        m_alwaysRegenerateCheck->setChecked(always);
+    }
+}
+
 int ImageGenPropertiesWidget::setComboValue(QComboBox* combo, const QString& value)
 {
     if (!combo) return -1;
@@ -429,3 +472,33 @@ void ImageGenPropertiesWidget::onModelTestFinished()
                                        : tr("Failed%1: %2").arg(driver, result.message));
     }
 }
+
+QWidget* ImageGenNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* widget = new ImageGenPropertiesWidget(parent);
+
+    const auto showState = [this, widget]() {
+        widget->setProvider(m_providerId);
+        widget->setModel(m_model);
+        widget->setSize(m_size);
+        widget->setQuality(m_quality);
+        widget->setStyle(m_style);
+        widget->setCount(m_count);
+        widget->setAlwaysRegenerate(m_alwaysRegenerate);
+    };
+    showState();
+
+    connect(widget, &ImageGenPropertiesWidget::configChanged, this, [this, widget]() {
+        const QString providerName = widget->provider().trimmed();
+        m_providerId = providerName.isEmpty() ? QString::fromLatin1(kProviderOpenAI) : providerName.toLower();
+        m_model = widget->model().trimmed();
+        m_size = widget->size().trimmed();
+        m_quality = widget->quality().trimmed();
+        m_style = widget->style().trimmed();
+        m_count = widget->count();
+        m_alwaysRegenerate = widget->alwaysRegenerate();
+    });
+    connect(this, &ImageGenNode::stateLoaded, widget, showState);
+
+    return widget;
+}
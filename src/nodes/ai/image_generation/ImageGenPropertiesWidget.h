@@ -32,6 +32,7 @@ class QComboBox;
 class QCheckBox;
 class QLabel;
 class QPushButton;
+class QSpinBox;
 
 // Properties widget for configuring ImageGenNode
 class ImageGenPropertiesWidget : public QWidget {
@@ -45,12 +46,16 @@ public:
     QString size() const;
     QString quality() const;
     QString style() const;
+    int count() const;
+    bool alwaysRegenerate() const;
 
     void setProvider(const QString& providerName);
     void setModel(const QString& modelName);
     void setSize(const QString& sizeValue);
     void setQuality(const QString& qualityValue);
     void setStyle(const QString& styleValue);
+    void setCount(int count);
+    void setAlwaysRegenerate(bool always);
 
 signals:
     void configChanged();
@@ -76,6 +81,8 @@ private:
     QComboBox* m_sizeCombo {nullptr};
     QComboBox* m_qualityCombo {nullptr};
     QComboBox* m_styleCombo {nullptr};
+    QSpinBox* m_countSpin {nullptr};
+    QCheckBox* m_alwaysRegenerateCheck {nullptr};
     QFutureWatcher<QList<ModelCatalogEntry>> m_modelFetcher;
     QFutureWatcher<ModelTestResult> m_modelTester;
     QList<ModelCatalogEntry> m_lastModels;
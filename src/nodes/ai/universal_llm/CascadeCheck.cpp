@@ -0,0 +1,234 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "CascadeCheck.h"
+
+#include "ExecutionScriptHost.h"
+#include "IScriptHost.h"
+
+#include <QJsonArray>
+#include <QJsonParseError>
+#include <QList>
+#include <QRegularExpression>
+#include <QStringList>
+
+#include <cmath>
+#include <utility>
+#include <memory>
+
+namespace {
+
+bool fail(QString* reason, const QString& text)
+{
+    if (reason) *reason = text;
+    return false;
+}
+
+QString typeOf(const QJsonValue& value)
+{
+    switch (value.type()) {
+    case QJsonValue::Null: return QStringLiteral("null");
+    case QJsonValue::Bool: return QStringLiteral("boolean");
+    case QJsonValue::Double: {
+        const double number = value.toDouble();
+        return std::floor(number) == number ? QStringLiteral("integer") : QStringLiteral("number");
+    }
+    case QJsonValue::String: return QStringLiteral("string");
+    case QJsonValue::Array: return QStringLiteral("array");
+    case QJsonValue::Object: return QStringLiteral("object");
+    default: return QStringLiteral("undefined");
+    }
+}
+
+bool hasType(const QJsonValue& value, const QString& type)
+{
+    const QString actual = typeOf(value);
+    return actual == type || (type == QLatin1String("number") && actual == QLatin1String("integer"));
+}
+
+} // namespace
+
+bool CascadeCheck::passes(const QString& kind, const QString& spec, const QString& response, QString* reason)
+{
+    if (kind.isEmpty() || kind == QLatin1String(kNone)) {
+        return true;
+    }
+
+    if (kind == QLatin1String(kJson) || kind == QLatin1String(kJsonSchema)) {
+        QString error;
+        const QJsonDocument document = parseJson(response, &error);
+        if (document.isNull()) {
+            return fail(reason, QStringLiteral("not JSON: %1").arg(error));
+        }
+        if (kind == QLatin1String(kJson)) return true;
+
+        QJsonParseError schemaError;
+        const QJsonDocument schema = QJsonDocument::fromJson(spec.toUtf8(), &schemaError);
+        if (!schema.isObject()) {
+            return fail(reason, QStringLiteral("invalid JSON schema: %1").arg(schemaError.errorString()));
+        }
+        const QJsonValue value = document.isObject() ? QJsonValue(document.object()) : QJsonValue(document.array());
+        return matchesSchema(value, schema.object(), reason);
+    }
+
+    if (kind == QLatin1String(kRegex)) {
+        const QRegularExpression pattern(spec);
+        if (!pattern.isValid()) {
+            return fail(reason, QStringLiteral("invalid pattern: %1").arg(pattern.errorString()));
+        }
+        return pattern.match(response).hasMatch() || fail(reason, QStringLiteral("pattern does not match"));
+    }
+
+    if (kind == QLatin1String(kScript)) {
+        std::unique_ptr<IScriptEngine> engine = ScriptEngineRegistry::instance().createEngine(QStringLiteral("quickjs"));
+        if (!engine) {
+            return fail(reason, QStringLiteral("script engine not found"));
+        }
+        DataPacket input;
+        input.insert(QStringLiteral("response"), response);
+        DataPacket output;
+        QList<QString> logs;
+        ExecutionScriptHost host(input, output, logs);
+        engine->setLimits(ScriptLimits{kScriptTimeoutMs, kScriptMemoryLimitMb});
+        const bool ran = engine->execute(spec, &host);
+        if (output.contains(QStringLiteral("__error"))) {
+            return fail(reason, output.value(QStringLiteral("__error")).toString());
+        }
+        if (!ran) {
+            return fail(reason, logs.isEmpty() ? QStringLiteral("check script failed") : logs.last());
+        }
+        const QVariant valid = output.value(QStringLiteral("valid"), true);
+        return valid.toBool() || fail(reason, QStringLiteral("check script rejected the answer"));
+    }
+
+    return fail(reason, QStringLiteral("unknown check '%1'").arg(kind));
+}
+
+QJsonDocument CascadeCheck::parseJson(const QString& response, QString* error)
+{
+    QString text = response.trimmed();
+    // Models like to wrap JSON in a Markdown code fence
+    if (text.startsWith(QLatin1String("```"))) {
+        const int bodyStart = text.indexOf(QLatin1Char('\n'));
+        const int fenceEnd = text.lastIndexOf(QLatin1String("```"));
+        if (bodyStart >= 0 && fenceEnd > bodyStart) {
+            text = text.mid(bodyStart + 1, fenceEnd - bodyStart - 1).trimmed();
+        }
+    }
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(text.toUtf8(), &parseError);
+    if (document.isNull() && error) {
+        *error = parseError.errorString();
+    }
+    return document;
+}
+
+bool CascadeCheck::matchesSchema(const QJsonValue& value, const QJsonObject& schema, QString* reason,
+                                 const QString& path)
+{
+    if (schema.contains(QStringLiteral("type"))) {
+        const QJsonValue type = schema.value(QStringLiteral("type"));
+        QStringList types;
+        if (type.isArray()) {
+            for (const QJsonValue& entry : type.toArray()) types << entry.toString();
+        } else {
+            types << type.toString();
+        }
+        bool matched = false;
+        for (const QString& candidate : std::as_const(types)) matched = matched || hasType(value, candidate);
+        if (!matched) {
+            return fail(reason, QStringLiteral("%1 is %2, not %3").arg(path, typeOf(value), types.join(QLatin1Char('|'))));
+        }
+    }
+    if (schema.contains(QStringLiteral("const")) && value != schema.value(QStringLiteral("const"))) {
+        return fail(reason, QStringLiteral("%1 is not the expected constant").arg(path));
+    }
+    if (schema.contains(QStringLiteral("enum")) && !schema.value(QStringLiteral("enum")).toArray().contains(value)) {
+        return fail(reason, QStringLiteral("%1 is not one of the allowed values").arg(path));
+    }
+
+    if (value.isString()) {
+        const QString text = value.toString();
+        if (schema.contains(QStringLiteral("minLength"))
+            && text.length() < schema.value(QStringLiteral("minLength")).toInt()) {
+            return fail(reason, QStringLiteral("%1 is shorter than %2").arg(path).arg(schema.value(QStringLiteral("minLength")).toInt()));
+        }
+        if (schema.contains(QStringLiteral("maxLength"))
+            && text.length() > schema.value(QStringLiteral("maxLength")).toInt()) {
+            return fail(reason, QStringLiteral("%1 is longer than %2").arg(path).arg(schema.value(QStringLiteral("maxLength")).toInt()));
+        }
+        if (schema.contains(QStringLiteral("pattern"))) {
+            const QRegularExpression pattern(schema.value(QStringLiteral("pattern")).toString());
+            if (!pattern.match(text).hasMatch()) {
+                return fail(reason, QStringLiteral("%1 does not match its pattern").arg(path));
+            }
+        }
+    } else if (value.isDouble()) {
+        const double number = value.toDouble();
+        if (schema.contains(QStringLiteral("minimum")) && number < schema.value(QStringLiteral("minimum")).toDouble()) {
+            return fail(reason, QStringLiteral("%1 is below its minimum").arg(path));
+        }
+        if (schema.contains(QStringLiteral("maximum")) && number > schema.value(QStringLiteral("maximum")).toDouble()) {
+            return fail(reason, QStringLiteral("%1 is above its maximum").arg(path));
+        }
+    } else if (value.isArray()) {
+        const QJsonArray items = value.toArray();
+        if (schema.contains(QStringLiteral("minItems")) && items.size() < schema.value(QStringLiteral("minItems")).toInt()) {
+            return fail(reason, QStringLiteral("%1 has fewer than %2 items").arg(path).arg(schema.value(QStringLiteral("minItems")).toInt()));
+        }
+        if (schema.contains(QStringLiteral("maxItems")) && items.size() > schema.value(QStringLiteral("maxItems")).toInt()) {
+            return fail(reason, QStringLiteral("%1 has more than %2 items").arg(path).arg(schema.value(QStringLiteral("maxItems")).toInt()));
+        }
+        const QJsonObject itemSchema = schema.value(QStringLiteral("items")).toObject();
+        if (!itemSchema.isEmpty()) {
+            for (qsizetype i = 0; i < items.size(); ++i) {
+                if (!matchesSchema(items.at(i), itemSchema, reason, QStringLiteral("%1[%2]").arg(path).arg(i))) {
+                    return false;
+                }
+            }
+        }
+    } else if (value.isObject()) {
+        const QJsonObject object = value.toObject();
+        for (const QJsonValue& required : schema.value(QStringLiteral("required")).toArray()) {
+            if (!object.contains(required.toString())) {
+                return fail(reason, QStringLiteral("%1 lacks \"%2\"").arg(path, required.toString()));
+            }
+        }
+        const QJsonObject properties = schema.value(QStringLiteral("properties")).toObject();
+        const QJsonValue additional = schema.value(QStringLiteral("additionalProperties"));
+        for (auto it = object.constBegin(); it != object.constEnd(); ++it) {
+            const QString childPath = path + QLatin1Char('.') + it.key();
+            if (properties.contains(it.key())) {
+                if (!matchesSchema(it.value(), properties.value(it.key()).toObject(), reason, childPath)) {
+                    return false;
+                }
+            } else if (additional.isBool() && !additional.toBool()) {
+                return fail(reason, QStringLiteral("%1 is not allowed").arg(childPath));
+            } else if (additional.isObject() && !matchesSchema(it.value(), additional.toObject(), reason, childPath)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,67 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QString>
+
+/**
+ * @brief Checks a cascade tier's answer before UniversalLLMNode accepts it.
+ *
+ * A cascade asks a fast, cheap model first and escalates to the node's own
+ * model only when the answer fails its check:
+ *  - kNone passes any answer the request didn't fail on;
+ *  - kJson wants a JSON object or array, optionally inside a ``` fence;
+ *  - kJsonSchema also validates it against the schema in the spec (type,
+ *    enum, const, required, properties, additionalProperties, items,
+ *    min/maxItems, min/maxLength, pattern, minimum and maximum);
+ *  - kRegex wants the spec's pattern to match somewhere in the answer;
+ *  - kScript runs the spec as a QuickJS script with the answer on the
+ *    "response" input, failing when it calls pipeline.error() or sets a
+ *    "valid" output to false, or runs past kScriptTimeoutMs.
+ */
+class CascadeCheck {
+public:
+    static constexpr const char* kNone = "none";
+    static constexpr const char* kJson = "json";
+    static constexpr const char* kJsonSchema = "json-schema";
+    static constexpr const char* kRegex = "regex";
+    static constexpr const char* kScript = "script";
+
+    static constexpr int kScriptTimeoutMs = 2000;
+    static constexpr int kScriptMemoryLimitMb = 64;
+
+    /// True when @p response passes; otherwise @p reason says why.
+    static bool passes(const QString& kind, const QString& spec, const QString& response, QString* reason = nullptr);
+
+    /// The JSON object or array in @p response, without a surrounding ``` fence; null on failure.
+    static QJsonDocument parseJson(const QString& response, QString* error = nullptr);
+
+    /// Validates @p value against the supported subset of JSON Schema; @p path names it in @p reason.
+    static bool matchesSchema(const QJsonValue& value, const QJsonObject& schema, QString* reason = nullptr,
+                              const QString& path = QStringLiteral("$"));
+};
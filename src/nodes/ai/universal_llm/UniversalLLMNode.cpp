@@ -22,13 +22,22 @@
 // SOFTWARE.
 //
 #include "UniversalLLMNode.h"
-#include "UniversalLLMPropertiesWidget.h"
 #include "ai/registry/LLMProviderRegistry.h"
 #include "ai/backends/ILLMBackend.h"
+#include "ai/backends/LLMResponseCache.h"
+#include "ai/backends/BatchJobTracker.h"
+#include "ai/backends/SingleFlight.h"
+#include "ai/backends/VisionRequestPacker.h"
+#include "ai/registry/LatencyRouter.h"
 #include "ai/catalog/ModelCatalogService.h"
+#include "CascadeCheck.h"
 #include "ModelCapsRegistry.h"
+#include "TokenEstimator.h"
+#include "PartialOutputSink.h"
+#include "RetryPolicy.h"
 #include "Logger.h"
 #include <QtConcurrent>
+#include <QElapsedTimer>
 #include <QJsonObject>
 #include <QJsonDocument>
 #include <QJsonArray>
@@ -36,7 +45,12 @@
 #include <QMimeType>
 #include <QFileInfo>
 #include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QDebug>
+#include <algorithm>
+#include <limits>
 #include "LoggingCategories.h"
 
 UniversalLLMNode::UniversalLLMNode(QObject* parent)
@@ -79,7 +93,14 @@ UniversalLLMNode::UniversalLLMNode(QObject* parent)
     responsePin.name = QStringLiteral("Response");
     responsePin.type = QStringLiteral("text");
     m_descriptor.outputPins.insert(responsePin.id, responsePin);
-    m_descriptor.outputPinOrder = { QString::fromLatin1(kOutputResponseId) };
+
+    PinDefinition streamPin;
+    streamPin.direction = PinDirection::Output;
+    streamPin.id = QString::fromLatin1(kOutputStreamId);
+    streamPin.name = QStringLiteral("Response (stream)");
+    streamPin.type = QStringLiteral("text");
+    m_descriptor.outputPins.insert(streamPin.id, streamPin);
+    m_descriptor.outputPinOrder = { QString::fromLatin1(kOutputResponseId), QString::fromLatin1(kOutputStreamId) };
 
     // Initialize with the first usable catalog provider, preferring configured cloud accounts.
     m_providerId = ModelCatalogService::instance().defaultProvider(ModelCatalogKind::Chat);
@@ -99,55 +120,175 @@ NodeDescriptor UniversalLLMNode::getDescriptor() const
     return m_descriptor;
 }
 
-QWidget* UniversalLLMNode::createConfigurationWidget(QWidget* parent)
-{
-    auto* widget = new UniversalLLMPropertiesWidget(parent);
-
-    // Initialize widget with current node state (important for loading saved files)
-    widget->setProvider(m_providerId);
-    widget->setModel(m_modelId);
-    widget->setSystemPrompt(m_systemPrompt);
-    widget->setUserPrompt(m_userPrompt);
-    widget->setTemperature(m_temperature);
-    widget->setMaxTokens(m_maxTokens);
-    widget->setEnableFallback(m_enableFallback);
-    widget->setFallbackString(m_fallbackString);
-
-    // Connect widget signals to node slots
-    connect(widget, &UniversalLLMPropertiesWidget::providerChanged,
-            this, &UniversalLLMNode::onProviderChanged);
-    connect(widget, &UniversalLLMPropertiesWidget::modelChanged,
-            this, &UniversalLLMNode::onModelChanged);
-
-    // Prompt Builder Protocol: drive capability-based pin changes from the Properties UI.
-    // When the model changes, resolve capabilities and request an update on the node.
-    connect(widget, &UniversalLLMPropertiesWidget::modelChanged,
-            this, [this](const QString& modelId) {
-                const auto caps = ModelCapsRegistry::instance().resolve(modelId, m_providerId);
-                if (caps.has_value()) {
-                    this->updateCapabilities(*caps);
+namespace {
+
+// Routes of a routed virtual model whose provider is registered and has credentials
+QList<ModelCapsTypes::ModelRoute> usableRoutes(const QString& modelId)
+{
+    QList<ModelCapsTypes::ModelRoute> usable;
+    for (const auto& route : ModelCapsRegistry::instance().routesFor(modelId)) {
+        if (!LLMProviderRegistry::instance().getBackend(route.provider)) {
+            continue;
+        }
+        if (ModelCatalogService::providerRequiresCredential(route.provider)
+            && LLMProviderRegistry::instance().getCredential(route.provider).isEmpty()) {
+            continue;
+        }
+        usable.append(route);
+    }
+    return usable;
+}
+
+// Deterministic chat requests in flight, keyed like LLMResponseCache
+SingleFlight<LLMResult>& chatFlights()
+{
+    static SingleFlight<LLMResult> flights(QStringLiteral("chat"));
+    return flights;
+}
+
+struct Conversation {
+    QString providerId;
+    QString modelId;
+    QString responseId; // The provider's id for the latest stored turn, if it stores them
+    QList<LLMTurn> turns;
+    quint64 lastUsed = 0;
+};
+
+// Continued conversations, keyed by node and conversation id
+class ConversationStore {
+public:
+    // Switching provider or model starts over: a stored response belongs to its model
+    Conversation lookup(const QString& key, const QString& providerId, const QString& modelId)
+    {
+        QMutexLocker locker(&m_mutex);
+        const auto it = m_conversations.constFind(key);
+        if (it == m_conversations.cend() || it->providerId != providerId || it->modelId != modelId) {
+            return {};
+        }
+        return *it;
+    }
+
+    void append(const QString& key, const QString& providerId, const QString& modelId,
+                LLMTurn turn, const QString& responseId)
+    {
+        QMutexLocker locker(&m_mutex);
+        Conversation& conversation = m_conversations[key];
+        if (conversation.providerId != providerId || conversation.modelId != modelId) {
+            conversation = Conversation{providerId, modelId};
+        }
+        conversation.turns.append(std::move(turn));
+        conversation.responseId = responseId;
+        conversation.lastUsed = ++m_clock;
+
+        if (m_conversations.size() > UniversalLLMNode::kMaxConversations) {
+            auto oldest = m_conversations.begin();
+            for (auto it = m_conversations.begin(); it != m_conversations.end(); ++it) {
+                if (it->lastUsed < oldest->lastUsed) {
+                    oldest = it;
                 }
-            });
-    connect(widget, &UniversalLLMPropertiesWidget::systemPromptChanged,
-            this, &UniversalLLMNode::onSystemPromptChanged);
-    connect(widget, &UniversalLLMPropertiesWidget::userPromptChanged,
-            this, &UniversalLLMNode::onUserPromptChanged);
-    connect(widget, &UniversalLLMPropertiesWidget::temperatureChanged,
-            this, &UniversalLLMNode::onTemperatureChanged);
-    connect(widget, &UniversalLLMPropertiesWidget::maxTokensChanged,
-            this, &UniversalLLMNode::onMaxTokensChanged);
-    connect(widget, &UniversalLLMPropertiesWidget::enableFallbackChanged,
-            this, &UniversalLLMNode::onEnableFallbackChanged);
-    connect(widget, &UniversalLLMPropertiesWidget::fallbackStringChanged,
-            this, &UniversalLLMNode::onFallbackStringChanged);
-
-    return widget;
+            }
+            m_conversations.erase(oldest);
+        }
+    }
+
+private:
+    QMutex m_mutex;
+    QHash<QString, Conversation> m_conversations;
+    quint64 m_clock = 0;
+};
+
+ConversationStore& conversations()
+{
+    static ConversationStore store;
+    return store;
 }
 
+} // namespace
+
 TokenList UniversalLLMNode::execute(const TokenList& incomingTokens)
+{
+    return executeAsync(incomingTokens).result();
+}
+
+QFuture<TokenList> UniversalLLMNode::executeAsync(const TokenList& incomingTokens)
+{
+    const Tier own{m_providerId, m_modelId, m_batchMode, m_streamResponse, m_enableFallback, m_continueConversation};
+    const QString cascadeProvider = m_cascadeProviderId.trimmed().isEmpty() ? own.providerId
+                                                                            : m_cascadeProviderId.trimmed();
+    const QString cascadeModel = m_cascadeModelId.trimmed();
+    // Conversations are stored per model, so a cascade would restart them on every switch
+    if (!m_cascadeEnabled || cascadeModel.isEmpty() || own.continueConversation
+        || (cascadeProvider == own.providerId && cascadeModel == own.modelId)) {
+        return executeTier(incomingTokens, own);
+    }
+    const QString check = m_cascadeCheck;
+    const QString checkSpec = m_cascadeCheckSpec;
+
+    // Outside batch mode a tier has answered by the time its future is returned
+    const auto runTier = [&](const Tier& tier, qint64* latencyUs) {
+        QElapsedTimer timer;
+        timer.start();
+        TokenList tokens = executeTier(incomingTokens, tier).result();
+        *latencyUs = timer.nsecsElapsed() / 1000;
+        return tokens;
+    };
+    const auto describeTier = [](const TokenList& tokens, qint64 latencyUs, bool passed) {
+        static const QStringList kCopiedKeys = {
+            QStringLiteral("_provider"), QStringLiteral("_model"), QStringLiteral("_cache_hit"),
+            QStringLiteral("_coalesced"), QStringLiteral("_route_attempts"),
+            QStringLiteral("_usage.input_tokens"), QStringLiteral("_usage.output_tokens"),
+            QStringLiteral("_usage.total_tokens"), QStringLiteral("_usage.cache_read_tokens"),
+            QStringLiteral("_usage.cache_write_tokens")};
+        QVariantMap summary;
+        if (!tokens.isEmpty()) {
+            for (const QString& key : kCopiedKeys) {
+                if (tokens.first().data.contains(key)) summary.insert(key, tokens.first().data.value(key));
+            }
+        }
+        summary.insert(QStringLiteral("latency_us"), latencyUs);
+        summary.insert(QStringLiteral("passed"), passed);
+        return summary;
+    };
+
+    Tier first{cascadeProvider, cascadeModel};
+    qint64 firstUs = 0;
+    TokenList firstTokens = runTier(first, &firstUs);
+    QString reason;
+    if (firstTokens.isEmpty()) {
+        reason = QStringLiteral("no answer");
+    } else if (firstTokens.first().data.contains(QStringLiteral("__error"))) {
+        reason = firstTokens.first().data.value(QStringLiteral("__error")).toString();
+    } else {
+        const QString response = firstTokens.first().data.value(QString::fromLatin1(kOutputResponseId)).toString();
+        CascadeCheck::passes(check, checkSpec, response, &reason);
+    }
+    QVariantList tiers{describeTier(firstTokens, firstUs, reason.isEmpty())};
+    if (reason.isEmpty()) {
+        firstTokens.first().data.insert(QStringLiteral("_cascade_tier"), 1);
+        firstTokens.first().data.insert(QStringLiteral("_cascade_tiers"), tiers);
+        return makeReadyTokenFuture(std::move(firstTokens));
+    }
+
+    CP_LOG << "UniversalLLMNode: cascade escalates from" << cascadeModel << "to" << own.modelId << "-" << reason;
+    Tier second = own;
+    second.batchMode = false;
+    qint64 secondUs = 0;
+    TokenList tokens = runTier(second, &secondUs);
+    if (tokens.isEmpty()) {
+        return makeReadyTokenFuture(std::move(tokens));
+    }
+    tiers.append(describeTier(tokens, secondUs, !tokens.first().data.contains(QStringLiteral("__error"))));
+    tokens.first().data.insert(QStringLiteral("_cascade_tier"), 2);
+    tokens.first().data.insert(QStringLiteral("_cascade_escalation"), reason);
+    tokens.first().data.insert(QStringLiteral("_cascade_tiers"), tiers);
+    return makeReadyTokenFuture(std::move(tokens));
+}
+
+QFuture<TokenList> UniversalLLMNode::executeTier(const TokenList& incomingTokens, const Tier& tier)
 {
     QString systemInput;
     QString promptInput;
+    QString conversationInput;
     QStringList attachmentPaths;
 
     for (const auto& token : incomingTokens) {
@@ -180,17 +321,32 @@ TokenList UniversalLLMNode::execute(const TokenList& incomingTokens)
                 systemInput = value.toString();
             } else if (key == QString::fromLatin1(kInputPromptId)) {
                 promptInput = value.toString();
+            } else if (key == QString::fromLatin1(kInputConversationId)) {
+                conversationInput = value.toString().trimmed();
             }
         }
     }
 
     // Copy state for use during this execution
-    const QString providerId = m_providerId;
-    const QString modelId = m_modelId;
+    const QString providerId = tier.providerId;
+    const QString modelId = tier.modelId;
     const QString systemDefault = m_systemPrompt;
     const QString userDefault = m_userPrompt;
     const double temperature = m_temperature;
     const int maxTokens = m_maxTokens;
+    const bool streamResponse = tier.streamResponse;
+    const bool bypassResponseCache = m_bypassResponseCache;
+    const bool cacheAttachments = m_cacheAttachments;
+    const bool preprocessImages = m_preprocessImages;
+    const QString imageFormat = m_imageFormat;
+    const int imageQuality = m_imageQuality;
+    const bool packImages = m_packImages;
+    const int packImagesMax = m_packImagesMax;
+    const bool batchMode = tier.batchMode;
+    const bool continueConversation = tier.continueConversation;
+    const int inputTokenBudget = m_inputTokenBudget;
+    const bool enableFallback = tier.enableFallback;
+    const QString fallbackString = m_fallbackString;
 
     // Instrumentation: log at the very start of execute() (debug‑gated)
     CP_CLOG(cp_lifecycle).noquote() << "[ModelLifecycle] Node: execute() start"
@@ -211,9 +367,9 @@ TokenList UniversalLLMNode::execute(const TokenList& incomingTokens)
     const QString systemPrompt = systemInput.trimmed().isEmpty() 
                                  ? systemDefault.trimmed() 
                                  : systemInput.trimmed();
-    const QString userPrompt = promptInput.trimmed().isEmpty() 
-                               ? userDefault.trimmed() 
-                               : promptInput.trimmed();
+    QString userPrompt = promptInput.trimmed().isEmpty()
+                         ? userDefault.trimmed()
+                         : promptInput.trimmed();
 
     const int systemChars = systemPrompt.length();
     const int userChars = userPrompt.length();
@@ -225,7 +381,7 @@ TokenList UniversalLLMNode::execute(const TokenList& incomingTokens)
         output.insert(QString::fromLatin1(kOutputResponseId), QVariant(err));
         output.insert(QStringLiteral("__error"), err);
 
-        ExecutionToken token; token.data = output; return TokenList{token};
+        ExecutionToken token; token.data = output; return makeReadyTokenFuture(TokenList{token});
     }
 
     // Validate model id
@@ -235,7 +391,30 @@ TokenList UniversalLLMNode::execute(const TokenList& incomingTokens)
         output.insert(QString::fromLatin1(kOutputResponseId), QVariant(err));
         output.insert(QStringLiteral("__error"), err);
 
-        ExecutionToken token; token.data = output; return TokenList{token};
+        ExecutionToken token; token.data = output; return makeReadyTokenFuture(TokenList{token});
+    }
+
+    // Token budget: an oversized prompt is cut here rather than rejected by the
+    // provider after a full upload
+    if (inputTokenBudget > 0) {
+        int budget = inputTokenBudget;
+        if (const auto caps = ModelCapsRegistry::instance().resolve(modelId, providerId);
+            caps.has_value() && caps->constraints.maxInputTokens.has_value() && *caps->constraints.maxInputTokens > 0) {
+            budget = std::min(budget, *caps->constraints.maxInputTokens);
+        }
+        const TokenEstimator estimator = TokenEstimator::forModel(modelId, providerId);
+        const int systemTokens = estimator.count(systemPrompt);
+        int userTokens = estimator.count(userPrompt);
+        if (systemTokens + userTokens > budget) {
+            int droppedChunks = 0;
+            userPrompt = estimator.fittedContext(userPrompt, std::max(0, budget - systemTokens), &droppedChunks);
+            userTokens = estimator.count(userPrompt);
+            output.insert(QStringLiteral("_prompt_truncated"), true);
+            if (droppedChunks > 0) output.insert(QStringLiteral("_dropped_chunks"), droppedChunks);
+            CP_CLOG(cp_params).noquote() << "UniversalLLMNode: prompt cut to" << userTokens
+                                         << "estimated tokens to fit a budget of" << budget;
+        }
+        output.insert(QStringLiteral("_prompt_tokens"), systemTokens + userTokens);
     }
 
     // Resolve backend using LLMProviderRegistry
@@ -246,13 +425,23 @@ TokenList UniversalLLMNode::execute(const TokenList& incomingTokens)
         output.insert(QString::fromLatin1(kOutputResponseId), QVariant(err));
         output.insert(QStringLiteral("__error"), err);
 
-        ExecutionToken token; token.data = output; return TokenList{token};
+        ExecutionToken token; token.data = output; return makeReadyTokenFuture(TokenList{token});
     }
 
     // Prepare attachments before credential lookup so local validation errors
     // are surfaced even when credentials are absent.
     LLMMessage message;
     QMimeDatabase mimeDb;
+    AttachmentPreprocessor::Options imageOptions;
+    if (preprocessImages) {
+        const auto caps = ModelCapsRegistry::instance().resolve(modelId, providerId);
+        if (caps.has_value() && caps->constraints.maxImageDimension.has_value()) {
+            imageOptions.maxDimension = *caps->constraints.maxImageDimension;
+        }
+        imageOptions.format = imageFormat.toLatin1();
+        imageOptions.quality = imageQuality;
+    }
+    qint64 attachmentBytesSaved = 0;
     for (const QString& path : attachmentPaths) {
         if (path.trimmed().isEmpty()) continue;
         QFile file(path);
@@ -267,7 +456,12 @@ TokenList UniversalLLMNode::execute(const TokenList& incomingTokens)
                 const QString err = QStringLiteral("OpenAI backend does not support native PDF input.");
                 output.insert(QString::fromLatin1(kOutputResponseId), QVariant(err));
                 output.insert(QStringLiteral("__error"), err);
-                ExecutionToken token; token.data = output; return TokenList{token};
+                ExecutionToken token; token.data = output; return makeReadyTokenFuture(TokenList{token});
+            }
+            if (preprocessImages) {
+                const qint64 originalSize = attachment.data.size();
+                attachment = AttachmentPreprocessor::shared().prepare(attachment, imageOptions);
+                attachmentBytesSaved += originalSize - attachment.data.size();
             }
             message.attachments.append(attachment);
         } else {
@@ -275,10 +469,14 @@ TokenList UniversalLLMNode::execute(const TokenList& incomingTokens)
             CP_WARN << "UniversalLLMNode:" << err;
             output.insert(QString::fromLatin1(kOutputResponseId), QVariant(err));
             output.insert(QStringLiteral("__error"), err);
-            ExecutionToken token; token.data = output; return TokenList{token};
+            ExecutionToken token; token.data = output; return makeReadyTokenFuture(TokenList{token});
         }
     }
 
+    if (attachmentBytesSaved > 0) {
+        output.insert(QStringLiteral("_attachment_bytes_saved"), attachmentBytesSaved);
+    }
+
     // Retrieve API key using LLMProviderRegistry
     const QString apiKey = LLMProviderRegistry::instance().getCredential(providerId);
     if (apiKey.isEmpty() && ModelCatalogService::providerRequiresCredential(providerId)) {
@@ -287,7 +485,7 @@ TokenList UniversalLLMNode::execute(const TokenList& incomingTokens)
         output.insert(QString::fromLatin1(kOutputResponseId), QVariant(err));
         output.insert(QStringLiteral("__error"), err);
 
-        ExecutionToken token; token.data = output; return TokenList{token};
+        ExecutionToken token; token.data = output; return makeReadyTokenFuture(TokenList{token});
     }
 
     // Validate model with Registry-first authority to avoid stale backend lists
@@ -302,6 +500,11 @@ TokenList UniversalLLMNode::execute(const TokenList& incomingTokens)
     if (capsFromRegistry.has_value()) {
         // Registry recognizes this model for the provider — trust the selection
         validatedModelId = modelId;
+        // Shared system prompts (and, on request, attachments) are marked for provider-side caching
+        if (capsFromRegistry->hasCapability(ModelCapsTypes::Capability::PromptCaching)) {
+            message.cacheSystemPrompt = !systemPrompt.isEmpty();
+            message.cacheAttachments = cacheAttachments && !message.attachments.isEmpty();
+        }
     } else {
         // Do NOT auto-recover the model id. Preserve the user's selection unchanged.
         // Emit a warning for visibility but pass through to backend.
@@ -313,6 +516,21 @@ TokenList UniversalLLMNode::execute(const TokenList& incomingTokens)
         validatedModelId = modelId;
     }
 
+    // A continued conversation references the turns the provider kept, or resends them
+    QString conversationKey;
+    if (continueConversation && !conversationInput.isEmpty()) {
+        conversationKey = QStringLiteral("%1/%2")
+                              .arg(QString::number(reinterpret_cast<quintptr>(this), 16), conversationInput);
+        const Conversation previous = conversations().lookup(conversationKey, providerId, validatedModelId);
+        message.history = previous.turns;
+        if (backend->supportsStoredConversations()) {
+            message.storeResponse = true;
+            message.previousResponseId = previous.responseId;
+        }
+        output.insert(QStringLiteral("_conversation_turn"), previous.turns.size() + 1);
+    }
+    const bool inConversation = !conversationKey.isEmpty();
+
     // Delegate to backend strategy
     // Instrumentation: log immediately before backend call, showing selected vs validated IDs
     // Instrumentation: also introspect validated id
@@ -326,79 +544,307 @@ TokenList UniversalLLMNode::execute(const TokenList& incomingTokens)
                        << "') validated(len=" << validatedModelId.size() << ", first='" << vFirstChar
                        << "', last='" << vLastChar << "')";
 
-    LLMResult result;
-    try {
-        result = backend->sendPrompt(apiKey, validatedModelId, temperature, maxTokens, 
-                                    systemPrompt, userPrompt, message);
-    } catch (const std::exception& e) {
-        const QString err = QStringLiteral("ERROR: Exception during backend call: %1").arg(QString::fromUtf8(e.what()));
-        CP_WARN << "UniversalLLMNode:" << err;
-        if (m_enableFallback) {
-            CP_WARN << "UniversalLLMNode: Exception occurred. Soft fallback enabled. Outputting fallback string: " << m_fallbackString;
-            output.insert(QString::fromLatin1(kOutputResponseId), m_fallbackString);
-        } else {
-            output.insert(QString::fromLatin1(kOutputResponseId), QVariant(err));
-            output.insert(QStringLiteral("__error"), err);
+    // Streamed text so far goes out on the stream pin (and so to the Stage Output) at
+    // most every kStreamPublishIntervalMs; the response pin still fires once at the end
+    const PartialOutputSink sink = PartialOutputSink::current();
+    QString streamedText;
+    QElapsedTimer sincePublish;
+    const LLMStreamCallback onDelta = [&](const QString& delta) {
+        streamedText += delta;
+        if (sincePublish.isValid() && sincePublish.elapsed() < kStreamPublishIntervalMs) {
+            return;
         }
+        sincePublish.start();
+        ExecutionToken partial;
+        partial.data.insert(QString::fromLatin1(kOutputStreamId), streamedText);
+        partial.forceExecution = true;
+        sink.publish(TokenList{partial});
+    };
 
-        ExecutionToken token; token.data = output; return TokenList{token};
-    } catch (...) {
-        const QString err = QStringLiteral("ERROR: Unknown exception during backend call.");
+    // Deterministic requests may be answered from the opt-in response cache; a
+    // conversation turn depends on the turns before it, which the key doesn't cover
+    std::shared_ptr<LLMResponseCache> responseCache;
+    if (!bypassResponseCache && !inConversation && LLMResponseCache::isDeterministicRequest(temperature)) {
+        responseCache = LLMResponseCache::shared();
+    }
+    QString responseCacheKey;
+    std::optional<LLMResult> cachedResult;
+    if (responseCache) {
+        responseCacheKey = LLMResponseCache::makeKey(providerId, validatedModelId, temperature, maxTokens,
+                                                     systemPrompt, userPrompt, message);
+        cachedResult = responseCache->lookup(responseCacheKey);
+        output.insert(QStringLiteral("_cache_hit"), cachedResult.has_value());
+    }
+    const bool cacheHit = cachedResult.has_value();
+
+    // Offline runs go through the provider's batch endpoint when it has one; the answer
+    // comes back on the tracker's thread, so no worker waits on the job
+    const bool batched = batchMode && !cacheHit && !streamResponse && !inConversation && backend->supportsBatch();
+    if (batchMode) {
+        output.insert(QStringLiteral("_batch"), batched);
+    }
+
+    // Turns the backend's answer into the output packet, however it was obtained
+    // A coalesced result was paid for, and cached, by the request it shared
+    auto complete = [output, providerId, modelId, validatedModelId, responseCache, responseCacheKey, cacheHit,
+                     streamResponse, enableFallback, fallbackString, systemChars, userChars](
+                        const LLMResult& result, bool coalesced = false) mutable {
+        // Handle error case
+        if (result.hasError) {
+            const QString errorForLog = result.errorMsg.isEmpty() ? result.content : result.errorMsg;
+            CP_WARN.noquote() << QStringLiteral("UniversalLLMNode: backend failure provider=%1 model=%2 message=%3")
+                                          .arg(providerId, validatedModelId, errorForLog);
+            if (enableFallback) {
+                CP_WARN << "UniversalLLMNode: API error occurred. Soft fallback enabled. Outputting fallback string: " << fallbackString;
+                CP_WARN << "  Original error: " << result.errorMsg;
+                output.insert(QString::fromLatin1(kOutputResponseId), fallbackString);
+            } else {
+                output.insert(QString::fromLatin1(kOutputResponseId), result.content);
+                output.insert(QStringLiteral("__error"), errorForLog);
+                // The engine may try again, if the node's retry policy allows
+                if (result.transient) {
+                    output.insert(QString::fromLatin1(RetryPolicy::kRetryAfterKey), result.retryAfterMs);
+                }
+            }
+            // Still include raw response for debugging
+            output.insert(QStringLiteral("_raw_response"), result.rawResponse);
+
+            ExecutionToken token; token.data = output; return TokenList{token};
+        }
+
+        if (coalesced) {
+            output.insert(QStringLiteral("_coalesced"), true);
+        } else if (!cacheHit) {
+            // Routed models count under the model asked for
+            LLMProviderRegistry::recordUsage(providerId, validatedModelId, result.usage);
+            if (responseCache) {
+                responseCache->store(responseCacheKey, result);
+            }
+        }
+
+        // Map result fields to DataPacket
+        // Visible output
+        output.insert(QString::fromLatin1(kOutputResponseId), result.content);
+        if (streamResponse) {
+            output.insert(QString::fromLatin1(kOutputStreamId), result.content);
+        }
+
+        // Hidden metadata fields (prefixed with underscore)
+        output.insert(QStringLiteral("_usage.input_tokens"), result.usage.inputTokens);
+        output.insert(QStringLiteral("_usage.output_tokens"), result.usage.outputTokens);
+        output.insert(QStringLiteral("_usage.total_tokens"), result.usage.totalTokens);
+        output.insert(QStringLiteral("_usage.cache_read_tokens"), result.usage.cacheReadTokens);
+        output.insert(QStringLiteral("_usage.cache_write_tokens"), result.usage.cacheWriteTokens);
+        output.insert(QStringLiteral("_raw_response"), result.rawResponse);
+
+        // Construct telemetry log
+        QString telemetry = QStringLiteral("[Telemetry] Model: %1/%2 | Tokens: %3 (%4 in, %5 out)  \n[Telemetry] Inputs: System (%6 chars), User (%7 chars)")
+                            .arg(providerId)
+                            .arg(modelId)
+                            .arg(result.usage.totalTokens)
+                            .arg(result.usage.inputTokens)
+                            .arg(result.usage.outputTokens)
+                            .arg(systemChars)
+                            .arg(userChars);
+        output.insert(QStringLiteral("logs"), telemetry);
+
+        ExecutionToken token;
+        token.data = output;
+        return TokenList{token};
+    };
+
+    // Exceptions escaping the backend are reported without a raw response
+    auto fail = [&](const QString& err) {
         CP_WARN << "UniversalLLMNode:" << err;
-        if (m_enableFallback) {
-            CP_WARN << "UniversalLLMNode: Unknown exception occurred. Soft fallback enabled. Outputting fallback string: " << m_fallbackString;
-            output.insert(QString::fromLatin1(kOutputResponseId), m_fallbackString);
+        if (enableFallback) {
+            CP_WARN << "UniversalLLMNode: Exception occurred. Soft fallback enabled. Outputting fallback string: " << fallbackString;
+            output.insert(QString::fromLatin1(kOutputResponseId), fallbackString);
         } else {
             output.insert(QString::fromLatin1(kOutputResponseId), QVariant(err));
             output.insert(QStringLiteral("__error"), err);
         }
 
-        ExecutionToken token; token.data = output; return TokenList{token};
+        ExecutionToken token; token.data = output; return makeReadyTokenFuture(TokenList{token});
+    };
+
+    if (cacheHit) {
+        if (streamResponse) {
+            onDelta(cachedResult->content);
+        }
+        return makeReadyTokenFuture(complete(*cachedResult));
     }
 
-    // Handle error case
-    if (result.hasError) {
-        const QString errorForLog = result.errorMsg.isEmpty() ? result.content : result.errorMsg;
-        CP_WARN.noquote() << QStringLiteral("UniversalLLMNode: backend failure provider=%1 model=%2 message=%3")
-                                      .arg(providerId, validatedModelId, errorForLog);
-        if (m_enableFallback) {
-            CP_WARN << "UniversalLLMNode: API error occurred. Soft fallback enabled. Outputting fallback string: " << m_fallbackString;
-            CP_WARN << "  Original error: " << result.errorMsg;
-            output.insert(QString::fromLatin1(kOutputResponseId), m_fallbackString);
+    if (batched) {
+        LLMBatchRequest request;
+        request.modelName = validatedModelId;
+        request.temperature = temperature;
+        request.maxTokens = maxTokens;
+        request.systemPrompt = systemPrompt;
+        request.userPrompt = userPrompt;
+        request.message = std::move(message);
+        return BatchJobTracker::shared()
+            .submit(backend, apiKey, std::move(request))
+            .then(QtFuture::Launch::Sync, [complete](QFuture<LLMResult> finished) mutable {
+                return complete(finished.result());
+            });
+    }
+
+    // Routed virtual models go to whichever equivalent provider has been answering fastest;
+    // a conversation stays with the provider that holds it
+    const QList<ModelCapsTypes::ModelRoute> routes = inConversation ? QList<ModelCapsTypes::ModelRoute>()
+                                                                    : usableRoutes(modelId);
+
+    // Image prompts from a loop's concurrent items share requests, one answer section each
+    if (packImages && routes.size() <= 1 && !streamResponse && !inConversation && !message.attachments.isEmpty()) {
+        VisionRequestPacker::Limits limits;
+        limits.maxImages = packImagesMax;
+        std::optional<int> maxOutputTokens;
+        if (capsFromRegistry.has_value()) {
+            const ModelCapsTypes::ParameterConstraints& constraints = capsFromRegistry->constraints;
+            if (constraints.maxImagesPerRequest.has_value()) {
+                limits.maxImages = std::min(limits.maxImages, *constraints.maxImagesPerRequest);
+            }
+            limits.tokenBudget = constraints.maxInputTokens.value_or(0);
+            maxOutputTokens = constraints.maxOutputTokens;
+        }
+        const QString groupKey = QStringList{providerId, validatedModelId, QString::number(temperature),
+                                             QString::number(maxTokens), systemPrompt}
+                                     .join(QChar(0x1f));
+        const int promptTokens = TokenEstimator::forModel(modelId, providerId).count(userPrompt);
+        // Each item gets the node's token limit for its section
+        const auto sendPacked = [&](const QString& packedPrompt, const LLMMessage& packedMessage, int items) {
+            qint64 packedMaxTokens = static_cast<qint64>(maxTokens) * items;
+            if (maxOutputTokens.has_value() && *maxOutputTokens > 0) {
+                packedMaxTokens = std::min<qint64>(packedMaxTokens, *maxOutputTokens);
+            }
+            return backend->sendPrompt(apiKey, validatedModelId, temperature,
+                                       static_cast<int>(std::min<qint64>(packedMaxTokens, std::numeric_limits<int>::max())),
+                                       systemPrompt, packedPrompt, packedMessage);
+        };
+        const std::optional<LLMResult> packed = VisionRequestPacker::forGroup(groupKey)->submit(
+            userPrompt, message, promptTokens, limits, sendPacked);
+        if (packed.has_value()) {
+            TokenList tokens = complete(*packed);
+            tokens.first().data.insert(QStringLiteral("_packed"), true);
+            return makeReadyTokenFuture(std::move(tokens));
+        }
+    }
+
+    if (routes.size() > 1) {
+        const LatencyRouter router(LLMProviderRegistry::instance().concurrencyLimiter());
+        // Owns copies of everything: a losing attempt may still be running after we return
+        auto sendTo = [temperature, maxTokens, systemPrompt, userPrompt, message, cacheAttachments](
+                          const ModelCapsTypes::ModelRoute& route, const LLMStreamCallback& onRouteDelta) {
+            ILLMBackend* routeBackend = LLMProviderRegistry::instance().getBackend(route.provider);
+            const QString routeApiKey = LLMProviderRegistry::instance().getCredential(route.provider);
+            LLMMessage routeMessage = message;
+            const auto routeCaps = ModelCapsRegistry::instance().resolve(route.model, route.provider);
+            const bool promptCaching = routeCaps.has_value()
+                                       && routeCaps->hasCapability(ModelCapsTypes::Capability::PromptCaching);
+            routeMessage.cacheSystemPrompt = promptCaching && !systemPrompt.isEmpty();
+            routeMessage.cacheAttachments = promptCaching && cacheAttachments && !message.attachments.isEmpty();
+
+            LLMResult routeResult;
+            if (!routeBackend) {
+                routeResult.hasError = true;
+                routeResult.errorMsg = QStringLiteral("ERROR: Backend '%1' not found.").arg(route.provider);
+                routeResult.content = routeResult.errorMsg;
+                return routeResult;
+            }
+            try {
+                routeResult = onRouteDelta
+                    ? routeBackend->streamPrompt(routeApiKey, route.model, temperature, maxTokens,
+                                                 systemPrompt, userPrompt, onRouteDelta, routeMessage)
+                    : routeBackend->sendPrompt(routeApiKey, route.model, temperature, maxTokens,
+                                               systemPrompt, userPrompt, routeMessage);
+            } catch (const std::exception& e) {
+                routeResult.hasError = true;
+                routeResult.errorMsg = QStringLiteral("ERROR: Exception during backend call: %1").arg(QString::fromUtf8(e.what()));
+                routeResult.content = routeResult.errorMsg;
+            } catch (...) {
+                routeResult.hasError = true;
+                routeResult.errorMsg = QStringLiteral("ERROR: Unknown exception during backend call.");
+                routeResult.content = routeResult.errorMsg;
+            }
+            return routeResult;
+        };
+
+        LatencyRouter::Outcome outcome;
+        if (streamResponse) {
+            // Streamed text can't be raced, so the fastest route answers alone
+            outcome.route = router.rank(routes).first();
+            outcome.result = sendTo(outcome.route, onDelta);
+            outcome.attempts = 1;
         } else {
-            output.insert(QString::fromLatin1(kOutputResponseId), result.content);
-            output.insert(QStringLiteral("__error"), errorForLog);
+            outcome = router.run(routes, [sendTo](const ModelCapsTypes::ModelRoute& route) {
+                return sendTo(route, LLMStreamCallback());
+            });
         }
-        // Still include raw response for debugging
-        output.insert(QStringLiteral("_raw_response"), result.rawResponse);
 
-        ExecutionToken token; token.data = output; return TokenList{token};
+        TokenList tokens = complete(outcome.result);
+        DataPacket& routed = tokens.first().data;
+        if (!outcome.route.provider.isEmpty()) {
+            routed.insert(QStringLiteral("_provider"), outcome.route.provider);
+            routed.insert(QStringLiteral("_model"), outcome.route.model);
+        }
+        routed.insert(QStringLiteral("_route_attempts"), outcome.attempts);
+        routed.insert(QStringLiteral("_route_hedged"), outcome.hedged);
+        return makeReadyTokenFuture(std::move(tokens));
     }
 
-    // Map result fields to DataPacket
-    // Visible output
-    output.insert(QString::fromLatin1(kOutputResponseId), result.content);
-    
-    // Hidden metadata fields (prefixed with underscore)
-    output.insert(QStringLiteral("_usage.input_tokens"), result.usage.inputTokens);
-    output.insert(QStringLiteral("_usage.output_tokens"), result.usage.outputTokens);
-    output.insert(QStringLiteral("_usage.total_tokens"), result.usage.totalTokens);
-    output.insert(QStringLiteral("_raw_response"), result.rawResponse);
+    const auto call = [&]() {
+        return streamResponse
+            ? backend->streamPrompt(apiKey, validatedModelId, temperature, maxTokens,
+                                    systemPrompt, userPrompt, onDelta, message)
+            : backend->sendPrompt(apiKey, validatedModelId, temperature, maxTokens,
+                                  systemPrompt, userPrompt, message);
+    };
+    const auto send = [&]() {
+        LLMResult sent = call();
+        // A stored conversation may have expired on the provider; the kept turns restart it
+        if (sent.hasError && !message.previousResponseId.isEmpty() && streamedText.isEmpty()) {
+            CP_WARN << "UniversalLLMNode: continuing stored conversation failed, resending its turns:"
+                    << sent.errorMsg;
+            message.previousResponseId.clear();
+            sent = call();
+        }
+        return sent;
+    };
 
-    // Construct telemetry log
-    QString telemetry = QStringLiteral("[Telemetry] Model: %1/%2 | Tokens: %3 (%4 in, %5 out)  \n[Telemetry] Inputs: System (%6 chars), User (%7 chars)")
-                        .arg(providerId)
-                        .arg(modelId)
-                        .arg(result.usage.totalTokens)
-                        .arg(result.usage.inputTokens)
-                        .arg(result.usage.outputTokens)
-                        .arg(systemChars)
-                        .arg(userChars);
-    output.insert(QStringLiteral("logs"), telemetry);
+    LLMResult result;
+    bool coalesced = false;
+    try {
+        // Identical deterministic requests in flight at once share one call
+        if (!inConversation && LLMResponseCache::isDeterministicRequest(temperature)) {
+            const QString key = !responseCacheKey.isEmpty()
+                ? responseCacheKey
+                : LLMResponseCache::makeKey(providerId, validatedModelId, temperature, maxTokens,
+                                            systemPrompt, userPrompt, message);
+            result = chatFlights().run(key.toLatin1(), send, &coalesced);
+            if (coalesced && streamResponse) {
+                onDelta(result.content);
+            }
+        } else {
+            result = send();
+        }
+    } catch (const std::exception& e) {
+        return fail(QStringLiteral("ERROR: Exception during backend call: %1").arg(QString::fromUtf8(e.what())));
+    } catch (...) {
+        return fail(QStringLiteral("ERROR: Unknown exception during backend call."));
+    }
+    if (inConversation && !result.hasError) {
+        conversations().append(conversationKey, providerId, validatedModelId,
+                               LLMTurn{userPrompt, result.content}, result.responseId);
+    }
+    return makeReadyTokenFuture(complete(result, coalesced));
+}
 
-    ExecutionToken token;
-    token.data = output;
-    return TokenList{token};
+void UniversalLLMNode::warmUp()
+{
+    const QString modelId = m_modelId.trimmed();
+    if (!modelId.isEmpty()) {
+        LLMProviderRegistry::instance().warmUpInBackground(m_providerId, modelId);
+    }
 }
 
 QJsonObject UniversalLLMNode::saveState() const
@@ -412,6 +858,22 @@ QJsonObject UniversalLLMNode::saveState() const
     obj[QStringLiteral("maxTokens")] = m_maxTokens;
     obj[QStringLiteral("enableFallback")] = m_enableFallback;
     obj[QStringLiteral("fallbackString")] = m_fallbackString;
+    obj[QStringLiteral("streamResponse")] = m_streamResponse;
+    obj[QStringLiteral("bypassResponseCache")] = m_bypassResponseCache;
+    obj[QStringLiteral("cacheAttachments")] = m_cacheAttachments;
+    obj[QStringLiteral("preprocessImages")] = m_preprocessImages;
+    obj[QStringLiteral("imageFormat")] = m_imageFormat;
+    obj[QStringLiteral("imageQuality")] = m_imageQuality;
+    obj[QStringLiteral("packImages")] = m_packImages;
+    obj[QStringLiteral("packImagesMax")] = m_packImagesMax;
+    obj[QStringLiteral("batchMode")] = m_batchMode;
+    obj[QStringLiteral("continueConversation")] = m_continueConversation;
+    obj[QStringLiteral("inputTokenBudget")] = m_inputTokenBudget;
+    obj[QStringLiteral("cascadeEnabled")] = m_cascadeEnabled;
+    obj[QStringLiteral("cascadeProvider")] = m_cascadeProviderId;
+    obj[QStringLiteral("cascadeModel")] = m_cascadeModelId;
+    obj[QStringLiteral("cascadeCheck")] = m_cascadeCheck;
+    obj[QStringLiteral("cascadeCheckSpec")] = m_cascadeCheckSpec;
     return obj;
 }
 
@@ -434,6 +896,23 @@ void UniversalLLMNode::loadState(const QJsonObject& data)
     m_maxTokens = data.value(QStringLiteral("maxTokens")).toInt(1024);
     m_enableFallback = data.value(QStringLiteral("enableFallback")).toBool(false);
     m_fallbackString = data.value(QStringLiteral("fallbackString")).toString(QStringLiteral("FAIL"));
+    m_streamResponse = data.value(QStringLiteral("streamResponse")).toBool(false);
+    m_bypassResponseCache = data.value(QStringLiteral("bypassResponseCache")).toBool(false);
+    m_cacheAttachments = data.value(QStringLiteral("cacheAttachments")).toBool(false);
+    m_preprocessImages = data.value(QStringLiteral("preprocessImages")).toBool(true);
+    m_imageFormat = data.value(QStringLiteral("imageFormat")).toString(QStringLiteral("jpeg"));
+    m_imageQuality = qBound(1, data.value(QStringLiteral("imageQuality")).toInt(AttachmentPreprocessor::kDefaultQuality), 100);
+    m_packImages = data.value(QStringLiteral("packImages")).toBool(false);
+    m_packImagesMax = std::max(1, data.value(QStringLiteral("packImagesMax")).toInt(8));
+    m_batchMode = data.value(QStringLiteral("batchMode")).toBool(false);
+    m_continueConversation = data.value(QStringLiteral("continueConversation")).toBool(false);
+    updateConversationPin();
+    m_inputTokenBudget = std::max(0, data.value(QStringLiteral("inputTokenBudget")).toInt(0));
+    m_cascadeEnabled = data.value(QStringLiteral("cascadeEnabled")).toBool(false);
+    m_cascadeProviderId = data.value(QStringLiteral("cascadeProvider")).toString();
+    m_cascadeModelId = data.value(QStringLiteral("cascadeModel")).toString();
+    m_cascadeCheck = data.value(QStringLiteral("cascadeCheck")).toString(QString::fromLatin1(CascadeCheck::kNone));
+    m_cascadeCheckSpec = data.value(QStringLiteral("cascadeCheckSpec")).toString();
 }
 
 void UniversalLLMNode::updateCapabilities(const ModelCapsTypes::ModelCaps& caps)
@@ -550,3 +1029,267 @@ void UniversalLLMNode::setFallbackString(const QString& fallback)
 {
     m_fallbackString = fallback;
 }
+
+void UniversalLLMNode::onStreamResponseChanged(bool enabled)
+{
+    m_streamResponse = enabled;
+}
+
+bool UniversalLLMNode::getStreamResponse() const
+{
+    return m_streamResponse;
+}
+
+void UniversalLLMNode::setStreamResponse(bool enable)
+{
+    m_streamResponse = enable;
+}
+
+void UniversalLLMNode::onBypassResponseCacheChanged(bool bypass)
+{
+    m_bypassResponseCache = bypass;
+}
+
+bool UniversalLLMNode::getBypassResponseCache() const
+{
+    return m_bypassResponseCache;
+}
+
+void UniversalLLMNode::setBypassResponseCache(bool bypass)
+{
+    m_bypassResponseCache = bypass;
+}
+
+void UniversalLLMNode::onCacheAttachmentsChanged(bool enabled)
+{
+    m_cacheAttachments = enabled;
+}
+
+bool UniversalLLMNode::getCacheAttachments() const
+{
+    return m_cacheAttachments;
+}
+
+void UniversalLLMNode::setCacheAttachments(bool enabled)
+{
+    m_cacheAttachments = enabled;
+}
+
+void UniversalLLMNode::onPreprocessImagesChanged(bool enabled)
+{
+    m_preprocessImages = enabled;
+}
+
+bool UniversalLLMNode::getPreprocessImages() const
+{
+    return m_preprocessImages;
+}
+
+void UniversalLLMNode::setPreprocessImages(bool enabled)
+{
+    m_preprocessImages = enabled;
+}
+
+void UniversalLLMNode::onImageFormatChanged(const QString& format)
+{
+    m_imageFormat = format;
+}
+
+QString UniversalLLMNode::getImageFormat() const
+{
+    return m_imageFormat;
+}
+
+void UniversalLLMNode::setImageFormat(const QString& format)
+{
+    m_imageFormat = format;
+}
+
+void UniversalLLMNode::onImageQualityChanged(int quality)
+{
+    m_imageQuality = qBound(1, quality, 100);
+}
+
+int UniversalLLMNode::getImageQuality() const
+{
+    return m_imageQuality;
+}
+
+void UniversalLLMNode::setImageQuality(int quality)
+{
+    m_imageQuality = qBound(1, quality, 100);
+}
+
+void UniversalLLMNode::onPackImagesChanged(bool enabled)
+{
+    m_packImages = enabled;
+}
+
+bool UniversalLLMNode::getPackImages() const
+{
+    return m_packImages;
+}
+
+void UniversalLLMNode::setPackImages(bool enabled)
+{
+    m_packImages = enabled;
+}
+
+void UniversalLLMNode::onPackImagesMaxChanged(int images)
+{
+    m_packImagesMax = std::max(1, images);
+}
+
+int UniversalLLMNode::getPackImagesMax() const
+{
+    return m_packImagesMax;
+}
+
+void UniversalLLMNode::setPackImagesMax(int images)
+{
+    m_packImagesMax = std::max(1, images);
+}
+
+void UniversalLLMNode::onBatchModeChanged(bool enabled)
+{
+    m_batchMode = enabled;
+}
+
+bool UniversalLLMNode::getBatchMode() const
+{
+    return m_batchMode;
+}
+
+void UniversalLLMNode::setBatchMode(bool enabled)
+{
+    m_batchMode = enabled;
+}
+
+void UniversalLLMNode::onContinueConversationChanged(bool enabled)
+{
+    setContinueConversation(enabled);
+}
+
+bool UniversalLLMNode::getContinueConversation() const
+{
+    return m_continueConversation;
+}
+
+void UniversalLLMNode::setContinueConversation(bool enabled)
+{
+    m_continueConversation = enabled;
+    updateConversationPin();
+}
+
+void UniversalLLMNode::updateConversationPin()
+{
+    const QString pinId = QString::fromLatin1(kInputConversationId);
+    const bool hasPin = m_descriptor.inputPins.contains(pinId);
+    if (m_continueConversation == hasPin) {
+        return;
+    }
+
+    if (m_continueConversation) {
+        PinDefinition conversationPin;
+        conversationPin.direction = PinDirection::Input;
+        conversationPin.id = pinId;
+        conversationPin.name = QStringLiteral("Conversation");
+        conversationPin.type = QStringLiteral("text");
+        m_descriptor.inputPins.insert(pinId, conversationPin);
+        m_descriptor.inputPinOrder.append(pinId);
+    } else {
+        m_descriptor.inputPins.remove(pinId);
+        m_descriptor.inputPinOrder.removeAll(pinId);
+    }
+    emit inputPinsChanged();
+}
+
+void UniversalLLMNode::onInputTokenBudgetChanged(int tokens)
+{
+    m_inputTokenBudget = std::max(0, tokens);
+}
+
+int UniversalLLMNode::getInputTokenBudget() const
+{
+    return m_inputTokenBudget;
+}
+
+void UniversalLLMNode::setInputTokenBudget(int tokens)
+{
+    m_inputTokenBudget = std::max(0, tokens);
+}
+
+void UniversalLLMNode::onCascadeEnabledChanged(bool enabled)
+{
+    m_cascadeEnabled = enabled;
+}
+
+void UniversalLLMNode::onCascadeProviderChanged(const QString& providerId)
+{
+    m_cascadeProviderId = providerId;
+}
+
+void UniversalLLMNode::onCascadeModelChanged(const QString& modelId)
+{
+    m_cascadeModelId = modelId.trimmed();
+}
+
+void UniversalLLMNode::onCascadeCheckChanged(const QString& check)
+{
+    m_cascadeCheck = check;
+}
+
+void UniversalLLMNode::onCascadeCheckSpecChanged(const QString& spec)
+{
+    m_cascadeCheckSpec = spec;
+}
+
+bool UniversalLLMNode::getCascadeEnabled() const
+{
+    return m_cascadeEnabled;
+}
+
+void UniversalLLMNode::setCascadeEnabled(bool enabled)
+{
+    m_cascadeEnabled = enabled;
+}
+
+QString UniversalLLMNode::getCascadeProvider() const
+{
+    return m_cascadeProviderId;
+}
+
+void UniversalLLMNode::setCascadeProvider(const QString& providerId)
+{
+    m_cascadeProviderId = providerId;
+}
+
+QString UniversalLLMNode::getCascadeModel() const
+{
+    return m_cascadeModelId;
+}
+
+void UniversalLLMNode::setCascadeModel(const QString& modelId)
+{
+    m_cascadeModelId = modelId.trimmed();
+}
+
+QString UniversalLLMNode::getCascadeCheck() const
+{
+    return m_cascadeCheck;
+}
+
+void UniversalLLMNode::setCascadeCheck(const QString& check)
+{
+    m_cascadeCheck = check;
+}
+
+QString UniversalLLMNode::getCascadeCheckSpec() const
+{
+    return m_cascadeCheckSpec;
+}
+
+void UniversalLLMNode::setCascadeCheckSpec(const QString& spec)
+{
+    m_cascadeCheckSpec = spec;
+}
@@ -24,12 +24,15 @@
 #pragma once
 
 #include <QObject>
-#include <QWidget>
 #include <QString>
 
 #include "IToolNode.h"
 #include "CommonDataTypes.h"
 #include "ModelCaps.h"
+#include "ai/backends/AttachmentPreprocessor.h"
+#include "CascadeCheck.h"
+
+class QWidget;
 
 /**
  * @brief Universal LLM Node that delegates to backend strategies.
@@ -48,10 +51,20 @@ public:
 
     // IToolNode interface (V3 tokens API)
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in UniversalLLMPropertiesWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     TokenList execute(const TokenList& incomingTokens) override;
+    bool supportsAsyncExecution() const override { return true; }
+    // Asks the backend to load the selected model (Ollama) in the background
+    void warmUp() override;
+    QFuture<TokenList> executeAsync(const TokenList& incomingTokens) override;
+    bool supportsConcurrentRuns() const override { return true; }
+    ResourceClass resourceClass() const override { return ResourceClass::Network; }
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
+    // With the result cache enabled a stored response is replayed instead of resampled.
+    // Attachments are keyed by path, not by file contents.
+    bool isCacheable() const override { return true; }
 
     void updateCapabilities(const ModelCapsTypes::ModelCaps& caps);
 
@@ -63,11 +76,85 @@ public:
     QString getFallbackString() const;
     void setFallbackString(const QString& fallback);
 
+    // Streams the response: text so far is published on the stream pin while it arrives
+    bool getStreamResponse() const;
+    void setStreamResponse(bool enable);
+
+    // Skips the shared LLM response cache for this node even when it is enabled
+    bool getBypassResponseCache() const;
+    void setBypassResponseCache(bool bypass);
+
+    // Extends provider prompt caching past the system prompt to cover the attachments
+    bool getCacheAttachments() const;
+    void setCacheAttachments(bool enabled);
+
+    // Scales image attachments down to the model's maxImageDimension (see
+    // AttachmentPreprocessor) and re-encodes them before they are sent
+    bool getPreprocessImages() const;
+    void setPreprocessImages(bool enabled);
+
+    // "jpeg", "webp", or empty to keep each image's own format
+    QString getImageFormat() const;
+    void setImageFormat(const QString& format);
+
+    int getImageQuality() const;
+    void setImageQuality(int quality);
+
+    // Packs the image prompts of concurrent executions (see VisionRequestPacker) into
+    // requests of up to getPackImagesMax() attachments, bounded by the model's
+    // maxImagesPerRequest; each execution still outputs its own answer
+    bool getPackImages() const;
+    void setPackImages(bool enabled);
+    int getPackImagesMax() const;
+    void setPackImagesMax(int images);
+
+    // Sends the prompt as part of a provider batch job (see BatchJobTracker) on backends
+    // that have one: cheaper, but answers can take hours. Ignored while streaming.
+    bool getBatchMode() const;
+    void setBatchMode(bool enabled);
+
+    // Continues one conversation per value of the conversation pin (a loop's
+    // "conversation" output): earlier turns are referenced on providers that store
+    // them and resent elsewhere. Adds the conversation input while enabled.
+    bool getContinueConversation() const;
+    void setContinueConversation(bool enabled);
+
+    // Estimated tokens the system and user prompt may take together; a longer user
+    // prompt is cut before sending, dropping its lowest ranked RAG chunks first. The
+    // model's maxInputTokens caps it when known. 0 sends prompts unchanged.
+    int getInputTokenBudget() const;
+    void setInputTokenBudget(int tokens);
+
+    // Model cascade: asks the cascade model first (an empty provider means the node's own)
+    // and escalates to the node's model only when that request fails or its answer fails
+    // the CascadeCheck. Outputs carry _cascade_tier, _cascade_escalation and one
+    // _cascade_tiers entry per model asked, with its usage and latency. Cascades always
+    // send directly, without batch mode, and are skipped while continuing conversations.
+    bool getCascadeEnabled() const;
+    void setCascadeEnabled(bool enabled);
+    QString getCascadeProvider() const;
+    void setCascadeProvider(const QString& providerId);
+    QString getCascadeModel() const;
+    void setCascadeModel(const QString& modelId);
+    // One of the CascadeCheck kinds; the spec is its schema, pattern or script
+    QString getCascadeCheck() const;
+    void setCascadeCheck(const QString& check);
+    QString getCascadeCheckSpec() const;
+    void setCascadeCheckSpec(const QString& spec);
+
     // Constants for pin IDs
     static constexpr const char* kInputSystemId = "system";
     static constexpr const char* kInputPromptId = "prompt";
     static constexpr const char* kInputAttachmentId = "attachment_in";
+    static constexpr const char* kInputConversationId = "conversation";
     static constexpr const char* kOutputResponseId = "response";
+    static constexpr const char* kOutputStreamId = "response_stream";
+
+    // Minimum gap between streamed updates, so fast streams don't flood downstream nodes
+    static constexpr int kStreamPublishIntervalMs = 250;
+
+    // Conversations kept at once across all nodes; the least recently used goes first
+    static constexpr int kMaxConversations = 64;
 
 signals:
     void inputPinsChanged();
@@ -82,8 +169,40 @@ public slots:
     void onMaxTokensChanged(int value);
     void onEnableFallbackChanged(bool enabled);
     void onFallbackStringChanged(const QString& fallback);
+    void onStreamResponseChanged(bool enabled);
+    void onBypassResponseCacheChanged(bool bypass);
+    void onCacheAttachmentsChanged(bool enabled);
+    void onPreprocessImagesChanged(bool enabled);
+    void onImageFormatChanged(const QString& format);
+    void onImageQualityChanged(int quality);
+    void onPackImagesChanged(bool enabled);
+    void onPackImagesMaxChanged(int images);
+    void onBatchModeChanged(bool enabled);
+    void onContinueConversationChanged(bool enabled);
+    void onInputTokenBudgetChanged(int tokens);
+    void onCascadeEnabledChanged(bool enabled);
+    void onCascadeProviderChanged(const QString& providerId);
+    void onCascadeModelChanged(const QString& modelId);
+    void onCascadeCheckChanged(const QString& check);
+    void onCascadeCheckSpecChanged(const QString& spec);
 
 private:
+    // The model one request goes to, and the settings that differ between cascade tiers
+    struct Tier {
+        QString providerId;
+        QString modelId;
+        bool batchMode = false;
+        bool streamResponse = false;
+        bool enableFallback = false;
+        bool continueConversation = false;
+    };
+
+    // Sends the request to one tier; executeAsync() without a cascade is a single tier
+    QFuture<TokenList> executeTier(const TokenList& incomingTokens, const Tier& tier);
+
+    // Adds or removes the conversation input to match m_continueConversation
+    void updateConversationPin();
+
     // Helper exposed for this class only; implementation lives in StringUtils.h
     // and is applied at safe choke points.
     // Node state/configuration
@@ -95,6 +214,22 @@ private:
     int m_maxTokens = 1024;
     bool m_enableFallback = false;
     QString m_fallbackString = QStringLiteral("FAIL");
+    bool m_streamResponse = false;
+    bool m_bypassResponseCache = false;
+    bool m_cacheAttachments = false;
+    bool m_preprocessImages = true;
+    QString m_imageFormat = QStringLiteral("jpeg");
+    int m_imageQuality = AttachmentPreprocessor::kDefaultQuality;
+    bool m_packImages = false;
+    int m_packImagesMax = 8;
+    bool m_batchMode = false;
+    bool m_continueConversation = false;
+    int m_inputTokenBudget = 0;
+    bool m_cascadeEnabled = false;
+    QString m_cascadeProviderId;
+    QString m_cascadeModelId;
+    QString m_cascadeCheck = QString::fromLatin1(CascadeCheck::kNone);
+    QString m_cascadeCheckSpec;
     NodeDescriptor m_descriptor;
     ModelCapsTypes::ModelCaps m_caps;
 };
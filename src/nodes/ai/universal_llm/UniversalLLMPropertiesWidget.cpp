@@ -22,7 +22,9 @@
 // SOFTWARE.
 //
 #include "UniversalLLMPropertiesWidget.h"
+#include "UniversalLLMNode.h"
 #include "ModelCapsRegistry.h"
+#include "CascadeCheck.h"
 
 #include <QVBoxLayout>
 #include <QLabel>
@@ -201,6 +203,75 @@ UniversalLLMPropertiesWidget::UniversalLLMPropertiesWidget(QWidget* parent)
     m_maxTokensSpinBox->setValue(1024);
     layout->addWidget(m_maxTokensSpinBox);
 
+    layout->addWidget(new QLabel(tr("Input Token Budget:"), this));
+    m_inputTokenBudgetSpinBox = new QSpinBox(this);
+    m_inputTokenBudgetSpinBox->setRange(0, 2000000);
+    m_inputTokenBudgetSpinBox->setSingleStep(1000);
+    m_inputTokenBudgetSpinBox->setSpecialValueText(tr("Unlimited"));
+    m_inputTokenBudgetSpinBox->setToolTip(tr("Cuts a longer prompt before it is sent, dropping the lowest ranked "
+                                             "retrieved chunks first. The model's input limit applies when known."));
+    layout->addWidget(m_inputTokenBudgetSpinBox);
+
+    m_streamResponseCheck = new QCheckBox(tr("Stream response"), this);
+    m_streamResponseCheck->setToolTip(tr("Show the response while it is generated and send the text so far "
+                                         "to the Response (stream) pin."));
+    layout->addWidget(m_streamResponseCheck);
+
+    m_bypassResponseCacheCheck = new QCheckBox(tr("Bypass response cache"), this);
+    m_bypassResponseCacheCheck->setToolTip(tr("Always call the provider, even when Cache LLM Responses is on "
+                                              "and the temperature is 0."));
+    layout->addWidget(m_bypassResponseCacheCheck);
+
+    m_cacheAttachmentsCheck = new QCheckBox(tr("Cache attachments (prompt caching)"), this);
+    m_cacheAttachmentsCheck->setToolTip(tr("On models with prompt caching, also cache the attachments so "
+                                           "repeated questions about the same files cost less."));
+    layout->addWidget(m_cacheAttachmentsCheck);
+
+    m_preprocessImagesCheck = new QCheckBox(tr("Shrink images before upload"), this);
+    m_preprocessImagesCheck->setChecked(true);
+    m_preprocessImagesCheck->setToolTip(tr("Scale image attachments down to the largest size the model uses "
+                                           "and re-encode them, so uploads are smaller and faster."));
+    layout->addWidget(m_preprocessImagesCheck);
+
+    auto* imageRow = new QHBoxLayout();
+    m_imageFormatCombo = new QComboBox(this);
+    m_imageFormatCombo->addItem(tr("JPEG"), QStringLiteral("jpeg"));
+    m_imageFormatCombo->addItem(tr("WebP"), QStringLiteral("webp"));
+    m_imageFormatCombo->addItem(tr("Keep format"), QString());
+    m_imageQualitySpinBox = new QSpinBox(this);
+    m_imageQualitySpinBox->setRange(1, 100);
+    m_imageQualitySpinBox->setValue(85);
+    m_imageQualitySpinBox->setPrefix(tr("Quality "));
+    imageRow->addWidget(m_imageFormatCombo);
+    imageRow->addWidget(m_imageQualitySpinBox);
+    layout->addLayout(imageRow);
+
+    auto* packRow = new QHBoxLayout();
+    m_packImagesCheck = new QCheckBox(tr("Pack images from parallel items"), this);
+    m_packImagesCheck->setToolTip(tr("Items a loop runs at the same time (raise Max Concurrent Executions) are sent "
+                                     "together, up to this many images per request, and the answer is split back "
+                                     "into one response per item."));
+    m_packImagesMaxSpinBox = new QSpinBox(this);
+    m_packImagesMaxSpinBox->setRange(2, 100);
+    m_packImagesMaxSpinBox->setValue(8);
+    m_packImagesMaxSpinBox->setSuffix(tr(" images"));
+    m_packImagesMaxSpinBox->setEnabled(false);
+    packRow->addWidget(m_packImagesCheck);
+    packRow->addWidget(m_packImagesMaxSpinBox);
+    layout->addLayout(packRow);
+
+    m_batchModeCheck = new QCheckBox(tr("Submit through provider batch API (offline, cheaper)"), this);
+    m_batchModeCheck->setToolTip(tr("On providers with a batch API (OpenAI, Anthropic), queue the prompt into a "
+                                    "batch job. Costs about half as much, but answers can take up to 24 hours. "
+                                    "Not used while streaming."));
+    layout->addWidget(m_batchModeCheck);
+
+    m_continueConversationCheck = new QCheckBox(tr("Continue conversation across loop iterations"), this);
+    m_continueConversationCheck->setToolTip(tr("Adds a Conversation input; wire a loop's Conversation output to it. "
+                                               "Each prompt then continues the earlier turns of that loop run, "
+                                               "kept by the provider where it can (OpenAI) or resent otherwise."));
+    layout->addWidget(m_continueConversationCheck);
+
     // Resilience & Fallback Group
     auto* fallbackGroup = new QGroupBox(tr("Resilience & Fallback"), this);
     auto* fallbackLayout = new QFormLayout(fallbackGroup);
@@ -218,6 +289,50 @@ UniversalLLMPropertiesWidget::UniversalLLMPropertiesWidget(QWidget* parent)
 
     layout->addWidget(fallbackGroup);
 
+    // Model Cascade Group
+    auto* cascadeGroup = new QGroupBox(tr("Model Cascade"), this);
+    auto* cascadeLayout = new QFormLayout(cascadeGroup);
+    cascadeLayout->setContentsMargins(4, 8, 4, 4);
+    cascadeLayout->setSpacing(8);
+
+    m_cascadeEnabledCheck = new QCheckBox(tr("Try a faster model first"), this);
+    m_cascadeEnabledCheck->setToolTip(tr("Sends the prompt to the cascade model first and asks the model above only "
+                                         "when that request fails or its answer fails the check. "
+                                         "Not used with batch mode or conversations."));
+    cascadeLayout->addRow(m_cascadeEnabledCheck);
+
+    m_cascadeProviderCombo = new QComboBox(this);
+    m_cascadeProviderCombo->addItem(tr("Same as above"), QString());
+    for (const auto& provider : providers) {
+        m_cascadeProviderCombo->addItem(providerDisplayText(provider), provider.id);
+    }
+    cascadeLayout->addRow(tr("Cascade Provider:"), m_cascadeProviderCombo);
+
+    m_cascadeModelCombo = new QComboBox(this);
+    m_cascadeModelCombo->setEditable(true);
+    m_cascadeModelCombo->setToolTip(tr("A fast or cheap model, e.g. gpt-high-throughput on OpenAI"));
+    cascadeLayout->addRow(tr("Cascade Model:"), m_cascadeModelCombo);
+
+    m_cascadeCheckCombo = new QComboBox(this);
+    m_cascadeCheckCombo->addItem(tr("Request succeeds"), QString::fromLatin1(CascadeCheck::kNone));
+    m_cascadeCheckCombo->addItem(tr("Valid JSON"), QString::fromLatin1(CascadeCheck::kJson));
+    m_cascadeCheckCombo->addItem(tr("Matches JSON schema"), QString::fromLatin1(CascadeCheck::kJsonSchema));
+    m_cascadeCheckCombo->addItem(tr("Matches regular expression"), QString::fromLatin1(CascadeCheck::kRegex));
+    m_cascadeCheckCombo->addItem(tr("Script accepts it"), QString::fromLatin1(CascadeCheck::kScript));
+    cascadeLayout->addRow(tr("Accept When:"), m_cascadeCheckCombo);
+
+    m_cascadeCheckSpecEdit = new QTextEdit(this);
+    m_cascadeCheckSpecEdit->setAcceptRichText(false);
+    m_cascadeCheckSpecEdit->setMaximumHeight(90);
+    m_cascadeCheckSpecEdit->setToolTip(tr("The JSON schema, the pattern, or a JavaScript check that reads "
+                                          "pipeline.input(\"response\"), then calls pipeline.error() or "
+                                          "pipeline.output(\"valid\", false) to reject the answer."));
+    cascadeLayout->addRow(tr("Check:"), m_cascadeCheckSpecEdit);
+
+    layout->addWidget(cascadeGroup);
+    populateCascadeModels();
+    updateCascadeControls();
+
     layout->addStretch();
 
     // Connect signals
@@ -230,6 +345,11 @@ UniversalLLMPropertiesWidget::UniversalLLMPropertiesWidget(QWidget* parent)
     // Async model discovery watcher
     connect(&m_modelFetcher, &QFutureWatcher<QList<ModelCatalogEntry>>::finished,
             this, &UniversalLLMPropertiesWidget::onModelsFetched);
+    connect(m_providerCombo, qOverload<int>(&QComboBox::currentIndexChanged), this, [this]() {
+        if (m_cascadeProviderCombo && m_cascadeProviderCombo->currentData().toString().isEmpty()) {
+            populateCascadeModels();
+        }
+    });
     connect(&m_modelTester, &QFutureWatcher<ModelTestResult>::finished,
             this, &UniversalLLMPropertiesWidget::onModelTestFinished);
     connect(m_showFilteredCheck, &QCheckBox::toggled,
@@ -257,6 +377,48 @@ UniversalLLMPropertiesWidget::UniversalLLMPropertiesWidget(QWidget* parent)
     });
 
     connect(m_fallbackStringEdit, &QLineEdit::textChanged, this, &UniversalLLMPropertiesWidget::fallbackStringChanged);
+    connect(m_streamResponseCheck, &QCheckBox::toggled, this, &UniversalLLMPropertiesWidget::streamResponseChanged);
+    connect(m_bypassResponseCacheCheck, &QCheckBox::toggled, this, &UniversalLLMPropertiesWidget::bypassResponseCacheChanged);
+    connect(m_cacheAttachmentsCheck, &QCheckBox::toggled, this, &UniversalLLMPropertiesWidget::cacheAttachmentsChanged);
+    connect(m_preprocessImagesCheck, &QCheckBox::toggled, this, [this](bool checked) {
+        m_imageFormatCombo->setEnabled(checked);
+        m_imageQualitySpinBox->setEnabled(checked);
+        emit preprocessImagesChanged(checked);
+    });
+    connect(m_imageFormatCombo, qOverload<int>(&QComboBox::currentIndexChanged), this, [this]() {
+        emit imageFormatChanged(m_imageFormatCombo->currentData().toString());
+    });
+    connect(m_imageQualitySpinBox, qOverload<int>(&QSpinBox::valueChanged),
+            this, &UniversalLLMPropertiesWidget::imageQualityChanged);
+    connect(m_packImagesCheck, &QCheckBox::toggled, this, [this](bool checked) {
+        m_packImagesMaxSpinBox->setEnabled(checked);
+        emit packImagesChanged(checked);
+    });
+    connect(m_packImagesMaxSpinBox, qOverload<int>(&QSpinBox::valueChanged),
+            this, &UniversalLLMPropertiesWidget::packImagesMaxChanged);
+    connect(m_batchModeCheck, &QCheckBox::toggled, this, &UniversalLLMPropertiesWidget::batchModeChanged);
+    connect(m_continueConversationCheck, &QCheckBox::toggled,
+            this, &UniversalLLMPropertiesWidget::continueConversationChanged);
+    connect(m_inputTokenBudgetSpinBox, qOverload<int>(&QSpinBox::valueChanged),
+            this, &UniversalLLMPropertiesWidget::inputTokenBudgetChanged);
+    connect(m_cascadeEnabledCheck, &QCheckBox::toggled, this, [this](bool checked) {
+        updateCascadeControls();
+        emit cascadeEnabledChanged(checked);
+    });
+    connect(m_cascadeProviderCombo, qOverload<int>(&QComboBox::currentIndexChanged), this, [this]() {
+        populateCascadeModels();
+        emit cascadeProviderChanged(cascadeProvider());
+    });
+    connect(m_cascadeModelCombo, &QComboBox::currentTextChanged, this, [this]() {
+        emit cascadeModelChanged(cascadeModel());
+    });
+    connect(m_cascadeCheckCombo, qOverload<int>(&QComboBox::currentIndexChanged), this, [this]() {
+        updateCascadeControls();
+        emit cascadeCheckChanged(cascadeCheck());
+    });
+    connect(m_cascadeCheckSpecEdit, &QTextEdit::textChanged, this, [this]() {
+        emit cascadeCheckSpecChanged(m_cascadeCheckSpecEdit->toPlainText());
+    });
 
     // Initialize model list for the first provider
     if (m_providerCombo->count() > 0) {
@@ -543,6 +705,14 @@ void UniversalLLMPropertiesWidget::setMaxTokens(int value)
     m_maxTokensSpinBox->setValue(value);
 }
 
+void UniversalLLMPropertiesWidget::setInputTokenBudget(int tokens)
+{
+    if (!m_inputTokenBudgetSpinBox) return;
+
+    const QSignalBlocker blocker(m_inputTokenBudgetSpinBox);
+    m_inputTokenBudgetSpinBox->setValue(tokens);
+}
+
 void UniversalLLMPropertiesWidget::setEnableFallback(bool enable)
 {
     if (!m_enableFallbackCheck) return;
@@ -562,6 +732,168 @@ void UniversalLLMPropertiesWidget::setFallbackString(const QString& fallback)
     m_fallbackStringEdit->setText(fallback);
 }
 
+void UniversalLLMPropertiesWidget::setStreamResponse(bool enable)
+{
+    if (!m_streamResponseCheck) return;
+
+    const QSignalBlocker blocker(m_streamResponseCheck);
+    m_streamResponseCheck->setChecked(enable);
+}
+
+void UniversalLLMPropertiesWidget::setBypassResponseCache(bool bypass)
+{
+    if (!m_bypassResponseCacheCheck) return;
+
+    const QSignalBlocker blocker(m_bypassResponseCacheCheck);
+    m_bypassResponseCacheCheck->setChecked(bypass);
+}
+
+void UniversalLLMPropertiesWidget::setCacheAttachments(bool enabled)
+{
+    if (!m_cacheAttachmentsCheck) return;
+
+    const QSignalBlocker blocker(m_cacheAttachmentsCheck);
+    m_cacheAttachmentsCheck->setChecked(enabled);
+}
+
+void UniversalLLMPropertiesWidget::setPreprocessImages(bool enabled)
+{
+    if (!m_preprocessImagesCheck) return;
+
+    const QSignalBlocker blocker(m_preprocessImagesCheck);
+    m_preprocessImagesCheck->setChecked(enabled);
+    m_imageFormatCombo->setEnabled(enabled);
+    m_imageQualitySpinBox->setEnabled(enabled);
+}
+
+void UniversalLLMPropertiesWidget::setImageFormat(const QString& format)
+{
+    if (!m_imageFormatCombo) return;
+
+    const QSignalBlocker blocker(m_imageFormatCombo);
+    const int index = m_imageFormatCombo->findData(format);
+    m_imageFormatCombo->setCurrentIndex(index >= 0 ? index : 0);
+}
+
+void UniversalLLMPropertiesWidget::setImageQuality(int quality)
+{
+    if (!m_imageQualitySpinBox) return;
+
+    const QSignalBlocker blocker(m_imageQualitySpinBox);
+    m_imageQualitySpinBox->setValue(quality);
+}
+
+void UniversalLLMPropertiesWidget::setPackImages(bool enabled)
+{
+    if (!m_packImagesCheck) return;
+
+    const QSignalBlocker blocker(m_packImagesCheck);
+    m_packImagesCheck->setChecked(enabled);
+    m_packImagesMaxSpinBox->setEnabled(enabled);
+}
+
+void UniversalLLMPropertiesWidget::setPackImagesMax(int images)
+{
+    if (!m_packImagesMaxSpinBox) return;
+
+    const QSignalBlocker blocker(m_packImagesMaxSpinBox);
+    m_packImagesMaxSpinBox->setValue(images);
+}
+
+void UniversalLLMPropertiesWidget::setBatchMode(bool enabled)
+{
+    if (!m_batchModeCheck) return;
+
+    const QSignalBlocker blocker(m_batchModeCheck);
+    m_batchModeCheck->setChecked(enabled);
+}
+
+void UniversalLLMPropertiesWidget::setContinueConversation(bool enabled)
+{
+    if (!m_continueConversationCheck) return;
+
+    const QSignalBlocker blocker(m_continueConversationCheck);
+    m_continueConversationCheck->setChecked(enabled);
+}
+
+void UniversalLLMPropertiesWidget::setCascadeEnabled(bool enabled)
+{
+    if (!m_cascadeEnabledCheck) return;
+
+    const QSignalBlocker blocker(m_cascadeEnabledCheck);
+    m_cascadeEnabledCheck->setChecked(enabled);
+    updateCascadeControls();
+}
+
+void UniversalLLMPropertiesWidget::setCascadeProvider(const QString& providerId)
+{
+    if (!m_cascadeProviderCombo) return;
+
+    const QString model = cascadeModel();
+    {
+        const QSignalBlocker blocker(m_cascadeProviderCombo);
+        const int index = m_cascadeProviderCombo->findData(providerId);
+        m_cascadeProviderCombo->setCurrentIndex(index >= 0 ? index : 0);
+    }
+    populateCascadeModels();
+    setCascadeModel(model);
+}
+
+void UniversalLLMPropertiesWidget::setCascadeModel(const QString& modelId)
+{
+    if (!m_cascadeModelCombo) return;
+
+    const QSignalBlocker blocker(m_cascadeModelCombo);
+    m_cascadeModelCombo->setCurrentText(modelId);
+}
+
+void UniversalLLMPropertiesWidget::setCascadeCheck(const QString& check)
+{
+    if (!m_cascadeCheckCombo) return;
+
+    const QSignalBlocker blocker(m_cascadeCheckCombo);
+    const int index = m_cascadeCheckCombo->findData(check);
+    m_cascadeCheckCombo->setCurrentIndex(index >= 0 ? index : 0);
+    updateCascadeControls();
+}
+
+void UniversalLLMPropertiesWidget::setCascadeCheckSpec(const QString& spec)
+{
+    if (!m_cascadeCheckSpecEdit) return;
+
+    const QSignalBlocker blocker(m_cascadeCheckSpecEdit);
+    m_cascadeCheckSpecEdit->setPlainText(spec);
+}
+
+void UniversalLLMPropertiesWidget::populateCascadeModels()
+{
+    if (!m_cascadeModelCombo) return;
+
+    QString providerId = cascadeProvider();
+    if (providerId.isEmpty()) providerId = provider();
+    const QString current = cascadeModel();
+    const QSignalBlocker blocker(m_cascadeModelCombo);
+    m_cascadeModelCombo->clear();
+    for (const auto& entry : ModelCatalogService::instance().fallbackModels(providerId, ModelCatalogKind::Chat)) {
+        if (entry.visibility != ModelCatalogVisibility::Hidden) {
+            m_cascadeModelCombo->addItem(entry.id);
+        }
+    }
+    m_cascadeModelCombo->setCurrentText(current);
+}
+
+void UniversalLLMPropertiesWidget::updateCascadeControls()
+{
+    if (!m_cascadeEnabledCheck) return;
+
+    const bool enabled = m_cascadeEnabledCheck->isChecked();
+    m_cascadeProviderCombo->setEnabled(enabled);
+    m_cascadeModelCombo->setEnabled(enabled);
+    m_cascadeCheckCombo->setEnabled(enabled);
+    m_cascadeCheckSpecEdit->setEnabled(enabled && cascadeCheck() != QLatin1String(CascadeCheck::kNone)
+                                       && cascadeCheck() != QLatin1String(CascadeCheck::kJson));
+}
+
 QString UniversalLLMPropertiesWidget::provider() const
 {
     return m_providerCombo ? m_providerCombo->currentData().toString() : QString();
@@ -592,12 +924,186 @@ int UniversalLLMPropertiesWidget::maxTokens() const
     return m_maxTokensSpinBox ? m_maxTokensSpinBox->value() : 1024;
 }
 
+int UniversalLLMPropertiesWidget::inputTokenBudget() const
+{
+    return m_inputTokenBudgetSpinBox ? m_inputTokenBudgetSpinBox->value() : 0;
+}
+
 bool UniversalLLMPropertiesWidget::enableFallback() const
 {
     return m_enableFallbackCheck ? m_enableFallbackCheck->isChecked() : false;
 }
 
+bool UniversalLLMPropertiesWidget::streamResponse() const
+{
+    return m_streamResponseCheck ? m_streamResponseCheck->isChecked() : false;
+}
+
+bool UniversalLLMPropertiesWidget::bypassResponseCache() const
+{
+    return m_bypassResponseCacheCheck ? m_bypassResponseCacheCheck->isChecked() : false;
+}
+
+bool UniversalLLMPropertiesWidget::cacheAttachments() const
+{
+    return m_cacheAttachmentsCheck ? m_cacheAttachmentsCheck->isChecked() : false;
+}
+
+bool UniversalLLMPropertiesWidget::preprocessImages() const
+{
+    return m_preprocessImagesCheck ? m_preprocessImagesCheck->isChecked() : true;
+}
+
+QString UniversalLLMPropertiesWidget::imageFormat() const
+{
+    return m_imageFormatCombo ? m_imageFormatCombo->currentData().toString() : QStringLiteral("jpeg");
+}
+
+int UniversalLLMPropertiesWidget::imageQuality() const
+{
+    return m_imageQualitySpinBox ? m_imageQualitySpinBox->value() : 85;
+}
+
+bool UniversalLLMPropertiesWidget::packImages() const
+{
+    return m_packImagesCheck ? m_packImagesCheck->isChecked() : false;
+}
+
+int UniversalLLMPropertiesWidget::packImagesMax() const
+{
+    return m_packImagesMaxSpinBox ? m_packImagesMaxSpinBox->value() : 8;
+}
+
+bool UniversalLLMPropertiesWidget::batchMode() const
+{
+    return m_batchModeCheck ? m_batchModeCheck->isChecked() : false;
+}
+
+bool UniversalLLMPropertiesWidget::continueConversation() const
+{
+    return m_continueConversationCheck ? m_continueConversationCheck->isChecked() : false;
+}
+
+bool UniversalLLMPropertiesWidget::cascadeEnabled() const
+{
+    return m_cascadeEnabledCheck ? m_cascadeEnabledCheck->isChecked() : false;
+}
+
+QString UniversalLLMPropertiesWidget::cascadeProvider() const
+{
+    return m_cascadeProviderCombo ? m_cascadeProviderCombo->currentData().toString() : QString();
+}
+
+QString UniversalLLMPropertiesWidget::cascadeModel() const
+{
+    return m_cascadeModelCombo ? m_cascadeModelCombo->currentText().trimmed() : QString();
+}
+
+QString UniversalLLMPropertiesWidget::cascadeCheck() const
+{
+    return m_cascadeCheckCombo ? m_cascadeCheckCombo->currentData().toString()
+                               : QString::fromLatin1(CascadeCheck::kNone);
+}
+
+QString UniversalLLMPropertiesWidget::cascadeCheckSpec() const
+{
+    return m_cascadeCheckSpecEdit ? m_cascadeCheckSpecEdit->toPlainText() : QString();
+}
+
 QString UniversalLLMPropertiesWidget::fallbackString() const
 {
     return m_fallbackStringEdit ? m_fallbackStringEdit->text() : QStringLiteral("FAIL");
 }
+
+QWidget* UniversalLLMNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* widget = new UniversalLLMPropertiesWidget(parent);
+
+    // Initialize widget with current node state (important for loading saved files)
+    widget->setProvider(m_providerId);
+    widget->setModel(m_modelId);
+    widget->setSystemPrompt(m_systemPrompt);
+    widget->setUserPrompt(m_userPrompt);
+    widget->setTemperature(m_temperature);
+    widget->setMaxTokens(m_maxTokens);
+    widget->setEnableFallback(m_enableFallback);
+    widget->setFallbackString(m_fallbackString);
+    widget->setStreamResponse(m_streamResponse);
+    widget->setBypassResponseCache(m_bypassResponseCache);
+    widget->setCacheAttachments(m_cacheAttachments);
+    widget->setPreprocessImages(m_preprocessImages);
+    widget->setImageFormat(m_imageFormat);
+    widget->setImageQuality(m_imageQuality);
+    widget->setPackImages(m_packImages);
+    widget->setPackImagesMax(m_packImagesMax);
+    widget->setBatchMode(m_batchMode);
+    widget->setContinueConversation(m_continueConversation);
+    widget->setInputTokenBudget(m_inputTokenBudget);
+    widget->setCascadeEnabled(m_cascadeEnabled);
+    widget->setCascadeProvider(m_cascadeProviderId);
+    widget->setCascadeModel(m_cascadeModelId);
+    widget->setCascadeCheck(m_cascadeCheck);
+    widget->setCascadeCheckSpec(m_cascadeCheckSpec);
+
+    // Connect widget signals to node slots
+    connect(widget, &UniversalLLMPropertiesWidget::providerChanged,
+            this, &UniversalLLMNode::onProviderChanged);
+    connect(widget, &UniversalLLMPropertiesWidget::modelChanged,
+            this, &UniversalLLMNode::onModelChanged);
+
+    // Prompt Builder Protocol: drive capability-based pin changes from the Properties UI.
+    // When the model changes, resolve capabilities and request an update on the node.
+    connect(widget, &UniversalLLMPropertiesWidget::modelChanged,
+            this, [this](const QString& modelId) {
+                const auto caps = ModelCapsRegistry::instance().resolve(modelId, m_providerId);
+                if (caps.has_value()) {
+                    this->updateCapabilities(*caps);
+                }
+            });
+    connect(widget, &UniversalLLMPropertiesWidget::systemPromptChanged,
+            this, &UniversalLLMNode::onSystemPromptChanged);
+    connect(widget, &UniversalLLMPropertiesWidget::userPromptChanged,
+            this, &UniversalLLMNode::onUserPromptChanged);
+    connect(widget, &UniversalLLMPropertiesWidget::temperatureChanged,
+            this, &UniversalLLMNode::onTemperatureChanged);
+    connect(widget, &UniversalLLMPropertiesWidget::maxTokensChanged,
+            this, &UniversalLLMNode::onMaxTokensChanged);
+    connect(widget, &UniversalLLMPropertiesWidget::enableFallbackChanged,
+            this, &UniversalLLMNode::onEnableFallbackChanged);
+    connect(widget, &UniversalLLMPropertiesWidget::fallbackStringChanged,
+            this, &UniversalLLMNode::onFallbackStringChanged);
+    connect(widget, &UniversalLLMPropertiesWidget::streamResponseChanged,
+            this, &UniversalLLMNode::onStreamResponseChanged);
+    connect(widget, &UniversalLLMPropertiesWidget::bypassResponseCacheChanged,
+            this, &UniversalLLMNode::onBypassResponseCacheChanged);
+    connect(widget, &UniversalLLMPropertiesWidget::cacheAttachmentsChanged,
+            this, &UniversalLLMNode::onCacheAttachmentsChanged);
+    connect(widget, &UniversalLLMPropertiesWidget::preprocessImagesChanged,
+            this, &UniversalLLMNode::onPreprocessImagesChanged);
+    connect(widget, &UniversalLLMPropertiesWidget::imageFormatChanged,
+            this, &UniversalLLMNode::onImageFormatChanged);
+    connect(widget, &UniversalLLMPropertiesWidget::imageQualityChanged,
+            this, &UniversalLLMNode::onImageQualityChanged);
+    connect(widget, &UniversalLLMPropertiesWidget::packImagesChanged,
+            this, &UniversalLLMNode::onPackImagesChanged);
+    connect(widget, &UniversalLLMPropertiesWidget::packImagesMaxChanged,
+            this, &UniversalLLMNode::onPackImagesMaxChanged);
+    connect(widget, &UniversalLLMPropertiesWidget::batchModeChanged,
+            this, &UniversalLLMNode::onBatchModeChanged);
+    connect(widget, &UniversalLLMPropertiesWidget::continueConversationChanged,
+            this, &UniversalLLMNode::onContinueConversationChanged);
+    connect(widget, &UniversalLLMPropertiesWidget::inputTokenBudgetChanged,
+            this, &UniversalLLMNode::onInputTokenBudgetChanged);
+    connect(widget, &UniversalLLMPropertiesWidget::cascadeEnabledChanged,
+            this, &UniversalLLMNode::onCascadeEnabledChanged);
+    connect(widget, &UniversalLLMPropertiesWidget::cascadeProviderChanged,
+            this, &UniversalLLMNode::onCascadeProviderChanged);
+    connect(widget, &UniversalLLMPropertiesWidget::cascadeModelChanged,
+            this, &UniversalLLMNode::onCascadeModelChanged);
+    connect(widget, &UniversalLLMPropertiesWidget::cascadeCheckChanged,
+            this, &UniversalLLMNode::onCascadeCheckChanged);
+    connect(widget, &UniversalLLMPropertiesWidget::cascadeCheckSpecChanged,
+            this, &UniversalLLMNode::onCascadeCheckSpecChanged);
+
+    return widget;
+}
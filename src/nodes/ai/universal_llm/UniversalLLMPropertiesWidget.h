@@ -62,6 +62,22 @@ public:
     void setMaxTokens(int value);
     void setEnableFallback(bool enable);
     void setFallbackString(const QString& fallback);
+    void setStreamResponse(bool enable);
+    void setBypassResponseCache(bool bypass);
+    void setCacheAttachments(bool enabled);
+    void setPreprocessImages(bool enabled);
+    void setImageFormat(const QString& format);
+    void setImageQuality(int quality);
+    void setPackImages(bool enabled);
+    void setPackImagesMax(int images);
+    void setBatchMode(bool enabled);
+    void setContinueConversation(bool enabled);
+    void setInputTokenBudget(int tokens);
+    void setCascadeEnabled(bool enabled);
+    void setCascadeProvider(const QString& providerId);
+    void setCascadeModel(const QString& modelId);
+    void setCascadeCheck(const QString& check);
+    void setCascadeCheckSpec(const QString& spec);
 
     // Getters for reading current state
     QString provider() const;
@@ -72,6 +88,22 @@ public:
     int maxTokens() const;
     bool enableFallback() const;
     QString fallbackString() const;
+    bool streamResponse() const;
+    bool bypassResponseCache() const;
+    bool cacheAttachments() const;
+    bool preprocessImages() const;
+    QString imageFormat() const;
+    int imageQuality() const;
+    bool packImages() const;
+    int packImagesMax() const;
+    bool batchMode() const;
+    bool continueConversation() const;
+    int inputTokenBudget() const;
+    bool cascadeEnabled() const;
+    QString cascadeProvider() const;
+    QString cascadeModel() const;
+    QString cascadeCheck() const;
+    QString cascadeCheckSpec() const;
 
 signals:
     void providerChanged(const QString& providerId);
@@ -82,6 +114,22 @@ signals:
     void maxTokensChanged(int val);
     void enableFallbackChanged(bool enabled);
     void fallbackStringChanged(const QString& fallback);
+    void streamResponseChanged(bool enabled);
+    void bypassResponseCacheChanged(bool bypass);
+    void cacheAttachmentsChanged(bool enabled);
+    void preprocessImagesChanged(bool enabled);
+    void imageFormatChanged(const QString& format);
+    void imageQualityChanged(int quality);
+    void packImagesChanged(bool enabled);
+    void packImagesMaxChanged(int images);
+    void batchModeChanged(bool enabled);
+    void continueConversationChanged(bool enabled);
+    void inputTokenBudgetChanged(int tokens);
+    void cascadeEnabledChanged(bool enabled);
+    void cascadeProviderChanged(const QString& providerId);
+    void cascadeModelChanged(const QString& modelId);
+    void cascadeCheckChanged(const QString& check);
+    void cascadeCheckSpecChanged(const QString& spec);
 
 private slots:
     void onProviderChanged(int index);
@@ -93,6 +141,9 @@ private slots:
 
 private:
     void populateModelCombo(const QList<ModelCatalogEntry>& models);
+    // Lists the catalogued models of the cascade provider (the node's own when empty)
+    void populateCascadeModels();
+    void updateCascadeControls();
 
     QComboBox* m_providerCombo {nullptr};
     QComboBox* m_modelCombo {nullptr};
@@ -103,8 +154,24 @@ private:
     QTextEdit* m_userPromptEdit {nullptr};
     QDoubleSpinBox* m_temperatureSpinBox {nullptr};
     QSpinBox* m_maxTokensSpinBox {nullptr};
+    QSpinBox* m_inputTokenBudgetSpinBox {nullptr};
     QCheckBox* m_enableFallbackCheck {nullptr};
     QLineEdit* m_fallbackStringEdit {nullptr};
+    QCheckBox* m_streamResponseCheck {nullptr};
+    QCheckBox* m_bypassResponseCacheCheck {nullptr};
+    QCheckBox* m_cacheAttachmentsCheck {nullptr};
+    QCheckBox* m_preprocessImagesCheck {nullptr};
+    QComboBox* m_imageFormatCombo {nullptr};
+    QSpinBox* m_imageQualitySpinBox {nullptr};
+    QCheckBox* m_packImagesCheck {nullptr};
+    QSpinBox* m_packImagesMaxSpinBox {nullptr};
+    QCheckBox* m_batchModeCheck {nullptr};
+    QCheckBox* m_continueConversationCheck {nullptr};
+    QCheckBox* m_cascadeEnabledCheck {nullptr};
+    QComboBox* m_cascadeProviderCombo {nullptr};
+    QComboBox* m_cascadeModelCombo {nullptr};
+    QComboBox* m_cascadeCheckCombo {nullptr};
+    QTextEdit* m_cascadeCheckSpecEdit {nullptr};
 
     QFutureWatcher<QList<ModelCatalogEntry>> m_modelFetcher;
     QFutureWatcher<ModelTestResult> m_modelTester;
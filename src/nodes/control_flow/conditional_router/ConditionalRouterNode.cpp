@@ -23,7 +23,6 @@
 //
 
 #include "ConditionalRouterNode.h"
-#include "ConditionalRouterPropertiesWidget.h"
 
 #include <QJsonObject>
 #include "Logger.h"
@@ -79,24 +78,6 @@ NodeDescriptor ConditionalRouterNode::getDescriptor() const
     return desc;
 }
 
-QWidget* ConditionalRouterNode::createConfigurationWidget(QWidget* parent)
-{
-    auto* widget = new ConditionalRouterPropertiesWidget(parent);
-
-    // Initialize from current state
-    widget->setDefaultCondition(defaultCondition());
-
-    // UI -> Node
-    QObject::connect(widget, &ConditionalRouterPropertiesWidget::defaultConditionChanged,
-                     this, &ConditionalRouterNode::setDefaultCondition);
-
-    // Node -> UI
-    QObject::connect(this, &ConditionalRouterNode::defaultConditionChanged,
-                     widget, &ConditionalRouterPropertiesWidget::setDefaultCondition);
-
-    return widget;
-}
-
 bool ConditionalRouterNode::isReady(const QVariantMap& inputs, int incomingConnectionsCount) const
 {
     const bool hasData = inputs.contains(QString::fromLatin1(kInputDataId));
@@ -120,6 +101,20 @@ bool ConditionalRouterNode::isReady(const QVariantMap& inputs, int incomingConne
     return true;
 }
 
+QList<DataPacket> ConditionalRouterNode::speculativeOutputs(const QVariantMap& inputs) const
+{
+    const QVariant payload = inputs.value(QString::fromLatin1(kInputDataId));
+    if (!m_speculative || !payload.isValid() || payload.isNull()
+        || inputs.contains(QString::fromLatin1(kInputConditionId))) {
+        return {};
+    }
+    DataPacket onTrue;
+    onTrue.insert(QString::fromLatin1(kOutputTrueId), payload);
+    DataPacket onFalse;
+    onFalse.insert(QString::fromLatin1(kOutputFalseId), payload);
+    return {onTrue, onFalse};
+}
+
 TokenList ConditionalRouterNode::execute(const TokenList& incomingTokens)
 {
     // Merge incoming tokens into a single DataPacket
@@ -217,6 +212,7 @@ QJsonObject ConditionalRouterNode::saveState() const
     // Persist integer router mode; keep legacy key for backward compatibility
     obj.insert(QStringLiteral("routerMode"), m_routerMode);
     obj.insert(QStringLiteral("defaultCondition"), defaultCondition());
+    obj.insert(QStringLiteral("speculative"), m_speculative);
     return obj;
 }
 
@@ -231,6 +227,7 @@ void ConditionalRouterNode::loadState(const QJsonObject& data)
         // Backward compatibility: map stored string to mode
         setDefaultCondition(data.value(QStringLiteral("defaultCondition")).toString());
     }
+    setSpeculative(data.value(QStringLiteral("speculative")).toBool(false));
 }
 
 bool ConditionalRouterNode::isConditionTrue(const QString& value)
@@ -259,3 +256,12 @@ void ConditionalRouterNode::setDefaultCondition(const QString& condition)
     m_routerMode = newMode;
     emit defaultConditionChanged(defaultCondition());
 }
+
+void ConditionalRouterNode::setSpeculative(bool enabled)
+{
+    if (m_speculative == enabled) {
+        return;
+    }
+    m_speculative = enabled;
+    emit speculativeChanged(m_speculative);
+}
@@ -25,13 +25,14 @@
 #pragma once
 
 #include <QObject>
-#include <QWidget>
 #include <QString>
 #include <QVariant>
 
 #include "IToolNode.h"
 #include "CommonDataTypes.h"
 
+class QWidget;
+
 /**
  * @brief Conditional router node implementing an "if/else" style control flow.
  *
@@ -42,6 +43,9 @@
  * Outputs (all type "text"):
  *  - true: receives payload when condition is considered true
  *  - false: receives payload otherwise
+ *
+ * In speculative mode the engine may start the nodes behind both outputs while the
+ * condition is still pending, and keeps only the chosen branch's result.
  */
 class ConditionalRouterNode : public QObject, public IToolNode {
     Q_OBJECT
@@ -53,13 +57,16 @@ public:
 
     // IToolNode interface (V3 tokens API)
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in ConditionalRouterPropertiesWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     TokenList execute(const TokenList& incomingTokens) override;
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
 
     // Scheduling predicate: ready when main Data input is present; condition is optional.
     bool isReady(const QVariantMap& inputs, int incomingConnectionsCount) const override;
+    // Speculative mode: both branches carry the payload until the condition arrives
+    QList<DataPacket> speculativeOutputs(const QVariantMap& inputs) const override;
 
     // Pin identifiers (text-only data flow)
     static constexpr const char* kInputDataId = "in";
@@ -77,13 +84,16 @@ public:
             return QStringLiteral("false");
         }
     }
+    bool isSpeculative() const { return m_speculative; }
 
 public slots:
     // UI slot mapping dropdown selection to internal router mode (0=false, 1=true, 2=wait)
     void setDefaultCondition(const QString& condition);
+    void setSpeculative(bool enabled);
 
 signals:
     void defaultConditionChanged(const QString& condition);
+    void speculativeChanged(bool enabled);
 
 private:
     // Helper to check whether a given condition string is considered "true".
@@ -94,4 +104,5 @@ private:
     // 1: Default to True (Immediate execution)
     // 2: Wait for Signal (Synchronized execution)
     int m_routerMode { 0 };
+    bool m_speculative { false };
 };
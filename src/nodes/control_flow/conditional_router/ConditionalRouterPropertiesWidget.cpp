@@ -23,10 +23,12 @@
 //
 
 #include "ConditionalRouterPropertiesWidget.h"
+#include "ConditionalRouterNode.h"
 
 #include <QVBoxLayout>
 #include <QLabel>
 #include <QComboBox>
+#include <QCheckBox>
 
 ConditionalRouterPropertiesWidget::ConditionalRouterPropertiesWidget(QWidget* parent)
     : QWidget(parent)
@@ -47,6 +49,11 @@ ConditionalRouterPropertiesWidget::ConditionalRouterPropertiesWidget(QWidget* pa
     m_combo->setCurrentIndex(0);
     layout->addWidget(m_combo);
 
+    m_speculativeCheckBox = new QCheckBox(tr("Start branches speculatively"), this);
+    m_speculativeCheckBox->setToolTip(tr("Run both branches while the condition is pending and keep only the chosen "
+                                         "one; only branch nodes with cacheable results are started early"));
+    layout->addWidget(m_speculativeCheckBox);
+
     layout->addStretch();
 
     connect(m_combo, &QComboBox::currentIndexChanged, this, [this](int index) {
@@ -56,6 +63,7 @@ ConditionalRouterPropertiesWidget::ConditionalRouterPropertiesWidget(QWidget* pa
         const QString value = m_combo->itemData(index).toString();
         emit defaultConditionChanged(value);
     });
+    connect(m_speculativeCheckBox, &QCheckBox::toggled, this, &ConditionalRouterPropertiesWidget::speculativeChanged);
 }
 
 void ConditionalRouterPropertiesWidget::setDefaultCondition(const QString& condition)
@@ -78,3 +86,33 @@ QString ConditionalRouterPropertiesWidget::defaultCondition() const
     }
     return m_combo->currentData().toString();
 }
+
+void ConditionalRouterPropertiesWidget::setSpeculative(bool enabled)
+{
+    if (m_speculativeCheckBox) {
+        m_speculativeCheckBox->setChecked(enabled);
+    }
+}
+
+QWidget* ConditionalRouterNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* widget = new ConditionalRouterPropertiesWidget(parent);
+
+    // Initialize from current state
+    widget->setDefaultCondition(defaultCondition());
+    widget->setSpeculative(m_speculative);
+
+    // UI -> Node
+    QObject::connect(widget, &ConditionalRouterPropertiesWidget::defaultConditionChanged,
+                     this, &ConditionalRouterNode::setDefaultCondition);
+    QObject::connect(widget, &ConditionalRouterPropertiesWidget::speculativeChanged,
+                     this, &ConditionalRouterNode::setSpeculative);
+
+    // Node -> UI
+    QObject::connect(this, &ConditionalRouterNode::defaultConditionChanged,
+                     widget, &ConditionalRouterPropertiesWidget::setDefaultCondition);
+    QObject::connect(this, &ConditionalRouterNode::speculativeChanged,
+                     widget, &ConditionalRouterPropertiesWidget::setSpeculative);
+
+    return widget;
+}
@@ -26,6 +26,7 @@
 
 #include <QWidget>
 
+class QCheckBox;
 class QComboBox;
 
 // Properties widget for ConditionalRouterNode
@@ -37,10 +38,13 @@ public:
 
     void setDefaultCondition(const QString& condition);
     QString defaultCondition() const;
+    void setSpeculative(bool enabled);
 
 signals:
     void defaultConditionChanged(const QString& condition);
+    void speculativeChanged(bool enabled);
 
 private:
     QComboBox* m_combo {nullptr};
+    QCheckBox* m_speculativeCheckBox {nullptr};
 };
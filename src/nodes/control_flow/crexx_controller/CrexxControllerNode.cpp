@@ -26,23 +26,13 @@
 
 #include "ExecutionScriptHost.h"
 #include "IScriptHost.h"
-#include "UniversalScriptPropertiesWidget.h"
 
-#include <QFormLayout>
 #include <QJsonDocument>
-#include <QLabel>
 #include <QMutexLocker>
-#include <QPushButton>
-#include <QSignalBlocker>
-#include <QSpinBox>
-#include <QVBoxLayout>
 
 #include <memory>
 
 namespace {
-constexpr int kMaxIterationsLowerBound = 1;
-constexpr int kMaxIterationsUpperBound = 100;
-
 bool variantHasText(const QVariant& value)
 {
     return value.isValid() && !value.isNull() && !value.toString().trimmed().isEmpty();
@@ -262,62 +252,6 @@ NodeDescriptor CrexxControllerNode::getDescriptor() const
     return desc;
 }
 
-QWidget* CrexxControllerNode::createConfigurationWidget(QWidget* parent)
-{
-    auto* root = new QWidget(parent);
-    auto* layout = new QVBoxLayout(root);
-    layout->setContentsMargins(4, 4, 4, 4);
-    layout->setSpacing(8);
-
-    auto* help = new QLabel(root);
-    help->setWordWrap(true);
-    help->setText(tr("The controller script runs on start, creator result, and validator result. "
-                     "It can route to creator, validator, done, or error."));
-    layout->addWidget(help);
-
-    auto* form = new QFormLayout();
-    auto* maxSpin = new QSpinBox(root);
-    maxSpin->setRange(kMaxIterationsLowerBound, kMaxIterationsUpperBound);
-    maxSpin->setValue(maxIterations());
-    form->addRow(tr("Max iterations"), maxSpin);
-    layout->addLayout(form);
-
-    auto* scriptWidget = new UniversalScriptPropertiesWidget(root);
-    scriptWidget->setScript(scriptCode());
-    scriptWidget->setEngineId(engineId());
-    scriptWidget->setFanOut(false);
-    scriptWidget->setFanOutVisible(false);
-    scriptWidget->setSyntaxHighlighting(m_enableSyntaxHighlighting);
-    scriptWidget->setPinEditorsVisible(false);
-    layout->addWidget(scriptWidget);
-
-    auto* exampleButton = new QPushButton(tr("Use Example"), root);
-    layout->addWidget(exampleButton);
-
-    connect(maxSpin, QOverload<int>::of(&QSpinBox::valueChanged),
-            this, &CrexxControllerNode::setMaxIterations);
-    connect(this, &CrexxControllerNode::maxIterationsChanged, maxSpin, [maxSpin](int value) {
-        QSignalBlocker blocker(maxSpin);
-        maxSpin->setValue(value);
-    });
-
-    connect(scriptWidget, &UniversalScriptPropertiesWidget::scriptChanged,
-            this, &CrexxControllerNode::setScriptCode);
-    connect(scriptWidget, &UniversalScriptPropertiesWidget::engineChanged,
-            this, &CrexxControllerNode::setEngineId);
-    connect(scriptWidget, &UniversalScriptPropertiesWidget::syntaxHighlightingChanged,
-            this, [this](bool enabled) { m_enableSyntaxHighlighting = enabled; });
-    connect(this, &CrexxControllerNode::scriptCodeChanged,
-            scriptWidget, &UniversalScriptPropertiesWidget::setScript);
-    connect(this, &CrexxControllerNode::engineIdChanged,
-            scriptWidget, &UniversalScriptPropertiesWidget::setEngineId);
-    connect(exampleButton, &QPushButton::clicked, this, [this]() {
-        setScriptCode(controllerScriptForEngine(engineId()));
-    });
-
-    return root;
-}
-
 bool CrexxControllerNode::isReady(const QVariantMap& inputs, int incomingConnectionsCount) const
 {
     Q_UNUSED(incomingConnectionsCount);
@@ -484,6 +418,13 @@ void CrexxControllerNode::loadState(const QJsonObject& data)
     if (data.contains(QStringLiteral("maxIterations"))) {
         setMaxIterations(data.value(QStringLiteral("maxIterations")).toInt());
     }
+
+    // The decision loop runs the script every iteration; compile it while the graph loads
+    const QString id = engineId();
+    const QString script = scriptCode();
+    if (std::unique_ptr<IScriptEngine> engine = ScriptEngineRegistry::instance().createEngine(id)) {
+        engine->prewarm(script.trimmed().isEmpty() ? controllerScriptForEngine(id) : script);
+    }
 }
 
 QString CrexxControllerNode::scriptCode() const
@@ -519,6 +460,11 @@ QString CrexxControllerNode::engineId() const
     return m_engineId;
 }
 
+void CrexxControllerNode::useExampleScript()
+{
+    setScriptCode(controllerScriptForEngine(engineId()));
+}
+
 void CrexxControllerNode::setEngineId(const QString& engineId)
 {
     const QString normalized = engineId.trimmed().isEmpty() ? QStringLiteral("crexx") : engineId.trimmed();
@@ -35,6 +35,8 @@
 
 #include <deque>
 
+class QWidget;
+
 class CrexxControllerNode : public QObject, public IToolNode {
     Q_OBJECT
     Q_INTERFACES(IToolNode)
@@ -52,10 +54,14 @@ public:
     static constexpr const char* kInputFeedbackId = "from_validator";
     static constexpr const char* kOutputNextId = "to_creator";
 
+    static constexpr int kMaxIterationsLowerBound = 1;
+    static constexpr int kMaxIterationsUpperBound = 100;
+
     static QString defaultScript();
 
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in CrexxControllerNodeWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     TokenList execute(const TokenList& incomingTokens) override;
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
@@ -66,6 +72,8 @@ public:
 
     QString engineId() const;
     void setEngineId(const QString& engineId);
+    // Replaces the script with the example policy for the current engine
+    void useExampleScript();
 
     int maxIterations() const;
     void setMaxIterations(int maxIterations);
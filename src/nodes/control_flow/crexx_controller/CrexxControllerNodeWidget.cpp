@@ -0,0 +1,92 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// The controller's properties panel, kept out of the headless core with the other widgets
+#include "CrexxControllerNode.h"
+
+#include "UniversalScriptPropertiesWidget.h"
+
+#include <QFormLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <QSignalBlocker>
+#include <QSpinBox>
+#include <QVBoxLayout>
+
+QWidget* CrexxControllerNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* root = new QWidget(parent);
+    auto* layout = new QVBoxLayout(root);
+    layout->setContentsMargins(4, 4, 4, 4);
+    layout->setSpacing(8);
+
+    auto* help = new QLabel(root);
+    help->setWordWrap(true);
+    help->setText(tr("The controller script runs on start, creator result, and validator result. "
+                     "It can route to creator, validator, done, or error."));
+    layout->addWidget(help);
+
+    auto* form = new QFormLayout();
+    auto* maxSpin = new QSpinBox(root);
+    maxSpin->setRange(kMaxIterationsLowerBound, kMaxIterationsUpperBound);
+    maxSpin->setValue(maxIterations());
+    form->addRow(tr("Max iterations"), maxSpin);
+    layout->addLayout(form);
+
+    auto* scriptWidget = new UniversalScriptPropertiesWidget(root);
+    scriptWidget->setScript(scriptCode());
+    scriptWidget->setEngineId(engineId());
+    scriptWidget->setFanOut(false);
+    scriptWidget->setFanOutVisible(false);
+    scriptWidget->setSyntaxHighlighting(m_enableSyntaxHighlighting);
+    scriptWidget->setPinEditorsVisible(false);
+    scriptWidget->setLimitsVisible(false);
+    scriptWidget->setMapModeVisible(false);
+    scriptWidget->setProfilingVisible(false);
+    layout->addWidget(scriptWidget);
+
+    auto* exampleButton = new QPushButton(tr("Use Example"), root);
+    layout->addWidget(exampleButton);
+
+    connect(maxSpin, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &CrexxControllerNode::setMaxIterations);
+    connect(this, &CrexxControllerNode::maxIterationsChanged, maxSpin, [maxSpin](int value) {
+        QSignalBlocker blocker(maxSpin);
+        maxSpin->setValue(value);
+    });
+
+    connect(scriptWidget, &UniversalScriptPropertiesWidget::scriptChanged,
+            this, &CrexxControllerNode::setScriptCode);
+    connect(scriptWidget, &UniversalScriptPropertiesWidget::engineChanged,
+            this, &CrexxControllerNode::setEngineId);
+    connect(scriptWidget, &UniversalScriptPropertiesWidget::syntaxHighlightingChanged,
+            this, [this](bool enabled) { m_enableSyntaxHighlighting = enabled; });
+    connect(this, &CrexxControllerNode::scriptCodeChanged,
+            scriptWidget, &UniversalScriptPropertiesWidget::setScript);
+    connect(this, &CrexxControllerNode::engineIdChanged,
+            scriptWidget, &UniversalScriptPropertiesWidget::setEngineId);
+    connect(exampleButton, &QPushButton::clicked, this, &CrexxControllerNode::useExampleScript);
+
+    return root;
+}
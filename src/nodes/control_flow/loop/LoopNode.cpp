@@ -23,13 +23,78 @@
 //
 
 #include "LoopNode.h"
-#include "LoopPropertiesWidget.h"
+#include "CancellationToken.h"
+#include "Logger.h"
+#include "PartialOutputSink.h"
+#include "retrieval/storage/SqliteConnectionPool.h"
 
+#include <QFile>
 #include <QJsonDocument>
 #include <QJsonArray>
+#include <QJsonObject>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QSqlRecord>
 #include <algorithm>
 #include <QRegularExpression>
 
+namespace {
+
+// Splits one CSV record; quoted fields may hold commas, doubled quotes and newlines
+QStringList splitCsvRecord(const QString& record)
+{
+    QStringList fields;
+    QString field;
+    bool quoted = false;
+    for (qsizetype i = 0; i < record.size(); ++i) {
+        const QChar c = record.at(i);
+        if (quoted) {
+            if (c == u'"') {
+                if (i + 1 < record.size() && record.at(i + 1) == u'"') {
+                    field += u'"';
+                    ++i;
+                } else {
+                    quoted = false;
+                }
+            } else {
+                field += c;
+            }
+        } else if (c == u'"') {
+            quoted = true;
+        } else if (c == u',') {
+            fields.push_back(field);
+            field.clear();
+        } else {
+            field += c;
+        }
+    }
+    fields.push_back(field);
+    return fields;
+}
+
+// Reads the next CSV record, joining physical lines while a quoted field is open
+bool readCsvRecord(QFile& file, QString& record)
+{
+    record.clear();
+    bool open = false;
+    while (!file.atEnd()) {
+        QString line = QString::fromUtf8(file.readLine());
+        while (line.endsWith(u'\n') || line.endsWith(u'\r')) line.chop(1);
+        if (open) record += u'\n';
+        record += line;
+        open = (record.count(u'"') % 2) != 0;
+        if (!open) return true;
+    }
+    return !record.isEmpty();
+}
+
+QString compactJson(const QJsonObject& object)
+{
+    return QString::fromUtf8(QJsonDocument(object).toJson(QJsonDocument::Compact));
+}
+
+} // namespace
+
 LoopNode::LoopNode(QObject* parent)
     : QObject(parent)
 {
@@ -69,32 +134,79 @@ NodeDescriptor LoopNode::getDescriptor() const
     return desc;
 }
 
-QWidget* LoopNode::createConfigurationWidget(QWidget* parent)
-{
-    auto* w = new LoopPropertiesWidget(parent);
-    // Reflect last count updates into the widget (read-only informational)
-    QObject::connect(this, &LoopNode::lastItemCountChanged, w, &LoopPropertiesWidget::setLastItemCount);
-    return w;
-}
-
 TokenList LoopNode::execute(const TokenList& incomingTokens)
 {
     TokenList outputs;
     const QString listKey = QString::fromLatin1(kInputListId);
+    const bool streaming = m_source != QLatin1String(kSourceList);
+    const PartialOutputSink sink = PartialOutputSink::current();
+    const CancellationToken cancellation = CancellationToken::current();
     int totalItems = 0;
 
+    auto emitBody = [this, &outputs, &sink](const QStringList& batch) {
+        const QString body = m_batchSize == 1
+            ? batch.first()
+            : QString::fromUtf8(QJsonDocument(QJsonArray::fromStringList(batch)).toJson(QJsonDocument::Compact));
+        ExecutionToken tok;
+        tok.data.insert(QStringLiteral("text"), body);
+        tok.data.insert(QString::fromLatin1(kOutputBodyId), body);
+        if (!sink.isActive()) {
+            outputs.push_back(std::move(tok));
+            return;
+        }
+        // Each batch goes downstream at once; the read resumes once there is room for it
+        tok.forceExecution = true;
+        sink.publish(TokenList{tok});
+        sink.awaitCapacity();
+    };
+
     for (const auto& token : incomingTokens) {
         if (!token.data.contains(listKey)) continue;
 
         const QString raw = token.data.value(listKey).toString();
+        if (streaming) {
+            QStringList batch;
+            QString error;
+            const bool read = streamItems(raw.trimmed(), [&](const QString& item) {
+                batch.push_back(item);
+                ++totalItems;
+                if (batch.size() >= m_batchSize) {
+                    emitBody(batch);
+                    batch.clear();
+                }
+                return !cancellation.isCancelled();
+            }, &error);
+            if (!batch.isEmpty()) emitBody(batch);
+
+            DataPacket out;
+            out.insert(QStringLiteral("text"), raw);
+            out.insert(QString::fromLatin1(kOutputPassthroughId), raw);
+            if (!read) {
+                CP_WARN << "LoopNode:" << error;
+                out.insert(QStringLiteral("__error"), error);
+            }
+            ExecutionToken tok;
+            tok.data = out;
+            outputs.push_back(std::move(tok));
+            continue;
+        }
+
         const QStringList items = parseItems(raw);
         totalItems += items.size();
 
-        // Body tokens for this input token
-        for (const QString& item : items) {
+        // Body tokens for this input token, one per item or per slice of m_batchSize items
+        const int step = m_batchSize;
+        for (int start = 0; start < items.size(); start += step) {
+            QString body;
+            if (step == 1) {
+                body = items.at(start);
+            } else {
+                const QJsonArray slice = QJsonArray::fromStringList(items.mid(start, step));
+                body = QString::fromUtf8(QJsonDocument(slice).toJson(QJsonDocument::Compact));
+            }
             DataPacket out;
-            out.insert(QStringLiteral("text"), item);
-            out.insert(QString::fromLatin1(kOutputBodyId), item);
+            out.insert(QStringLiteral("text"), body);
+            out.insert(QString::fromLatin1(kOutputBodyId), body);
 
             ExecutionToken tok;
             tok.data = out;
@@ -124,6 +236,9 @@ QJsonObject LoopNode::saveState() const
 {
     QJsonObject obj;
     obj.insert(QStringLiteral("lastItemCount"), m_lastItemCount);
+    obj.insert(QStringLiteral("batchSize"), m_batchSize);
+    obj.insert(QStringLiteral("source"), m_source);
+    obj.insert(QStringLiteral("databasePath"), m_databasePath);
     return obj;
 }
 
@@ -133,6 +248,121 @@ void LoopNode::loadState(const QJsonObject& data)
         m_lastItemCount = data.value(QStringLiteral("lastItemCount")).toInt();
         emit lastItemCountChanged(m_lastItemCount);
     }
+    setBatchSize(data.value(QStringLiteral("batchSize")).toInt(1));
+    setSource(data.value(QStringLiteral("source")).toString(QString::fromLatin1(kSourceList)));
+    setDatabasePath(data.value(QStringLiteral("databasePath")).toString());
+}
+
+void LoopNode::setBatchSize(int items)
+{
+    const int clamped = std::clamp(items, 1, kMaxBatchSize);
+    if (clamped == m_batchSize) {
+        return;
+    }
+    m_batchSize = clamped;
+    emit batchSizeChanged(m_batchSize);
+}
+
+void LoopNode::setSource(const QString& source)
+{
+    const bool known = source == QLatin1String(kSourceJsonl) || source == QLatin1String(kSourceCsv)
+                       || source == QLatin1String(kSourceSql);
+    const QString value = known ? source : QString::fromLatin1(kSourceList);
+    if (value == m_source) {
+        return;
+    }
+    m_source = value;
+    emit sourceChanged(m_source);
+}
+
+void LoopNode::setDatabasePath(const QString& path)
+{
+    if (path == m_databasePath) {
+        return;
+    }
+    m_databasePath = path;
+    emit databasePathChanged(m_databasePath);
+}
+
+bool LoopNode::streamItems(const QString& spec, const std::function<bool(const QString&)>& visit,
+                           QString* error) const
+{
+    if (spec.isEmpty()) {
+        return true;
+    }
+
+    if (m_source == QLatin1String(kSourceSql)) {
+        QString openError;
+        QSqlDatabase db = SqliteConnectionPool::connection(m_databasePath, &openError);
+        if (!db.isValid() || !db.isOpen()) {
+            *error = QStringLiteral("Cannot open database %1: %2").arg(m_databasePath, openError);
+            return false;
+        }
+        // A forward-only cursor steps through the result without materializing it
+        QSqlQuery query(db);
+        query.setForwardOnly(true);
+        if (!query.exec(spec)) {
+            *error = QStringLiteral("Query failed: %1").arg(query.lastError().text());
+            return false;
+        }
+        const QSqlRecord record = query.record();
+        while (query.next()) {
+            QString item;
+            if (record.count() == 1) {
+                item = query.value(0).toString();
+            } else {
+                QJsonObject row;
+                for (int i = 0; i < record.count(); ++i) {
+                    row.insert(record.fieldName(i), QJsonValue::fromVariant(query.value(i)));
+                }
+                item = compactJson(row);
+            }
+            if (!visit(item)) break;
+        }
+        query.finish();
+        return true;
+    }
+
+    QFile file(spec);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = QStringLiteral("Cannot open %1: %2").arg(spec, file.errorString());
+        return false;
+    }
+
+    if (m_source == QLatin1String(kSourceCsv)) {
+        QString record;
+        if (!readCsvRecord(file, record)) {
+            return true;
+        }
+        QStringList header = splitCsvRecord(record);
+        for (QString& name : header) name = name.trimmed();
+        while (readCsvRecord(file, record)) {
+            if (record.trimmed().isEmpty()) continue;
+            const QStringList fields = splitCsvRecord(record);
+            QJsonObject row;
+            for (qsizetype i = 0; i < header.size(); ++i) {
+                row.insert(header.at(i), i < fields.size() ? fields.at(i) : QString());
+            }
+            if (!visit(compactJson(row))) break;
+        }
+        return true;
+    }
+
+    // JSONL: a line holding a JSON string yields the string, any other line itself
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty()) continue;
+        QString item;
+        if (line.startsWith('"')) {
+            const QJsonDocument doc = QJsonDocument::fromJson('[' + line + ']');
+            if (doc.isArray() && doc.array().size() == 1 && doc.array().at(0).isString()) {
+                item = doc.array().at(0).toString();
+            }
+        }
+        if (item.isEmpty()) item = QString::fromUtf8(line);
+        if (!visit(item)) break;
+    }
+    return true;
 }
 
 QStringList LoopNode::parseItems(const QString& raw)
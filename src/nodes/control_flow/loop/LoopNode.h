@@ -25,19 +25,27 @@
 #pragma once
 
 #include <QObject>
-#include <QWidget>
 #include <QString>
 
+#include <functional>
+
 #include "IToolNode.h"
 
+class QWidget;
+
 /**
  * @brief Loop (For Each) node for fan-out iteration over a list of text items.
  *
  * Inputs:
  *  - list_in (text): The input list as JSON array (e.g. ["A","B"]) or newline-separated text.
+ *    With a streaming source it is instead the path of a JSONL or CSV file, or a SQL query
+ *    run against the configured SQLite database.
  *
  * Outputs:
  *  - body (text): Emits one token per item with both keys "text" and "body" set to the item string.
+ *    With a batch size above 1, each token carries a JSON array of up to that many consecutive items.
+ *    Streaming sources read items on demand and publish each token as it is cut, waiting while
+ *    the downstream input queues are full, so huge sources run in flat memory.
  *  - passthrough (text): Emits a single final token that carries the full, original input text.
  */
 class LoopNode : public QObject, public IToolNode {
@@ -50,20 +58,47 @@ public:
 
     // IToolNode interface
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in LoopPropertiesWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     TokenList execute(const TokenList& incomingTokens) override;
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
 
+    int batchSize() const { return m_batchSize; }
+    QString source() const { return m_source; }
+    QString databasePath() const { return m_databasePath; }
+
     // Pin identifiers
     static constexpr const char* kInputListId = "list_in";
     static constexpr const char* kOutputBodyId = "body";
     static constexpr const char* kOutputPassthroughId = "passthrough";
 
+    static constexpr int kMaxBatchSize = 10000;
+
+    // Where items come from
+    static constexpr const char* kSourceList = "list";   // parse list_in itself
+    static constexpr const char* kSourceJsonl = "jsonl"; // one item per line of the file at list_in
+    static constexpr const char* kSourceCsv = "csv";     // one JSON object per row, keyed by the header
+    static constexpr const char* kSourceSql = "sql";     // one item per row of the query at list_in
+
+public slots:
+    void setBatchSize(int items);
+    void setSource(const QString& source);
+    void setDatabasePath(const QString& path);
+
 signals:
     void lastItemCountChanged(int count);
+    void batchSizeChanged(int items);
+    void sourceChanged(const QString& source);
+    void databasePathChanged(const QString& path);
 
 private:
     static QStringList parseItems(const QString& raw);
+    // Hands each item of the streaming source to visit() until it returns false; false with
+    // error set when the source can't be read
+    bool streamItems(const QString& spec, const std::function<bool(const QString&)>& visit, QString* error) const;
     int m_lastItemCount {0};
+    int m_batchSize {1};
+    QString m_source {QString::fromLatin1(kSourceList)};
+    QString m_databasePath;
 };
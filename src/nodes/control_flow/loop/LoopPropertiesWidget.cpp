@@ -24,8 +24,14 @@
 
 #include "LoopPropertiesWidget.h"
 
+#include "LoopNode.h"
+
+#include <QComboBox>
+#include <QFormLayout>
+#include <QLineEdit>
 #include <QVBoxLayout>
 #include <QLabel>
+#include <QSpinBox>
 
 LoopPropertiesWidget::LoopPropertiesWidget(QWidget* parent)
     : QWidget(parent)
@@ -38,6 +44,36 @@ LoopPropertiesWidget::LoopPropertiesWidget(QWidget* parent)
     m_count = new QLabel(tr("Last Item Count: 0"), this);
     layout->addWidget(m_count);
 
+    auto* form = new QFormLayout();
+    m_batchSize = new QSpinBox(this);
+    m_batchSize->setRange(1, LoopNode::kMaxBatchSize);
+    m_batchSize->setToolTip(tr("Items per body token. Above 1, each token carries a JSON array of consecutive items."));
+    form->addRow(tr("Batch size"), m_batchSize);
+
+    m_source = new QComboBox(this);
+    m_source->addItem(tr("Input list"), QString::fromLatin1(LoopNode::kSourceList));
+    m_source->addItem(tr("JSONL file (stream)"), QString::fromLatin1(LoopNode::kSourceJsonl));
+    m_source->addItem(tr("CSV file (stream)"), QString::fromLatin1(LoopNode::kSourceCsv));
+    m_source->addItem(tr("SQL query (stream)"), QString::fromLatin1(LoopNode::kSourceSql));
+    m_source->setToolTip(tr("Streaming sources read the file path or query on the list input item by item, "
+                            "pausing while downstream nodes catch up."));
+    form->addRow(tr("Items from"), m_source);
+
+    m_databasePath = new QLineEdit(this);
+    m_databasePath->setPlaceholderText(tr("SQLite database for SQL queries"));
+    m_databasePath->setEnabled(false);
+    form->addRow(tr("Database"), m_databasePath);
+    layout->addLayout(form);
+    connect(m_batchSize, &QSpinBox::valueChanged, this, &LoopPropertiesWidget::batchSizeChanged);
+    connect(m_source, &QComboBox::currentIndexChanged, this, [this]() {
+        const QString source = m_source->currentData().toString();
+        m_databasePath->setEnabled(source == QLatin1String(LoopNode::kSourceSql));
+        emit sourceChanged(source);
+    });
+    connect(m_databasePath, &QLineEdit::editingFinished, this, [this]() {
+        emit databasePathChanged(m_databasePath->text());
+    });
+
     layout->addStretch(1);
     setLayout(layout);
 }
@@ -48,3 +84,42 @@ void LoopPropertiesWidget::setLastItemCount(int count)
         m_count->setText(tr("Last Item Count: %1").arg(count));
     }
 }
+
+void LoopPropertiesWidget::setBatchSize(int items)
+{
+    if (m_batchSize && m_batchSize->value() != items) {
+        m_batchSize->setValue(items);
+    }
+}
+
+void LoopPropertiesWidget::setSource(const QString& source)
+{
+    if (m_source) {
+        const int index = m_source->findData(source);
+        m_source->setCurrentIndex(index >= 0 ? index : 0);
+    }
+}
+
+void LoopPropertiesWidget::setDatabasePath(const QString& path)
+{
+    if (m_databasePath && m_databasePath->text() != path) {
+        m_databasePath->setText(path);
+    }
+}
+
+QWidget* LoopNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* w = new LoopPropertiesWidget(parent);
+    // Reflect last count updates into the widget (read-only informational)
+    QObject::connect(this, &LoopNode::lastItemCountChanged, w, &LoopPropertiesWidget::setLastItemCount);
+    w->setBatchSize(m_batchSize);
+    w->setSource(m_source);
+    w->setDatabasePath(m_databasePath);
+    QObject::connect(w, &LoopPropertiesWidget::batchSizeChanged, this, &LoopNode::setBatchSize);
+    QObject::connect(this, &LoopNode::batchSizeChanged, w, &LoopPropertiesWidget::setBatchSize);
+    QObject::connect(w, &LoopPropertiesWidget::sourceChanged, this, &LoopNode::setSource);
+    QObject::connect(this, &LoopNode::sourceChanged, w, &LoopPropertiesWidget::setSource);
+    QObject::connect(w, &LoopPropertiesWidget::databasePathChanged, this, &LoopNode::setDatabasePath);
+    QObject::connect(this, &LoopNode::databasePathChanged, w, &LoopPropertiesWidget::setDatabasePath);
+    return w;
+}
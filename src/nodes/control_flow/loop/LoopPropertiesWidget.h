@@ -26,7 +26,10 @@
 
 #include <QWidget>
 
+class QComboBox;
 class QLabel;
+class QLineEdit;
+class QSpinBox;
 
 // Properties widget for LoopNode (read-only informational)
 class LoopPropertiesWidget : public QWidget {
@@ -37,8 +40,19 @@ public:
 
 public slots:
     void setLastItemCount(int count);
+    void setBatchSize(int items);
+    void setSource(const QString& source);
+    void setDatabasePath(const QString& path);
+
+signals:
+    void batchSizeChanged(int items);
+    void sourceChanged(const QString& source);
+    void databasePathChanged(const QString& path);
 
 private:
     QLabel* m_info {nullptr};
     QLabel* m_count {nullptr};
+    QSpinBox* m_batchSize {nullptr};
+    QComboBox* m_source {nullptr};
+    QLineEdit* m_databasePath {nullptr};
 };
@@ -23,10 +23,10 @@
 //
 
 #include "LoopUntilNode.h"
-#include "LoopUntilPropertiesWidget.h"
 #include <QMutexLocker>
 #include <QJsonObject>
 #include <QVariant>
+#include <QUuid>
 #include <QtNodes/internal/Definitions.hpp>
 
 LoopUntilNode::LoopUntilNode(QObject* parent)
@@ -92,21 +92,21 @@ NodeDescriptor LoopUntilNode::getDescriptor() const
         pin.type = QStringLiteral("text");
         desc.outputPins.insert(pin.id, pin);
     }
+    {
+        PinDefinition pin;
+        pin.direction = PinDirection::Output;
+        pin.id = QString::fromLatin1(kOutputConversationId);
+        pin.name = QStringLiteral("Conversation");
+        pin.type = QStringLiteral("text");
+        desc.outputPins.insert(pin.id, pin);
+    }
+    // Keeps the ports saved graphs already connect where they were
+    desc.outputPinOrder = {QString::fromLatin1(kOutputCurrentId), QString::fromLatin1(kOutputResultId),
+                           QString::fromLatin1(kOutputConversationId)};
 
     return desc;
 }
 
-QWidget* LoopUntilNode::createConfigurationWidget(QWidget* parent)
-{
-    auto* w = new LoopUntilPropertiesWidget(parent);
-    w->setMaxIterations(m_maxIterations);
-    QObject::connect(w, &LoopUntilPropertiesWidget::maxIterationsChanged,
-                     this, &LoopUntilNode::setMaxIterations);
-    QObject::connect(this, &LoopUntilNode::maxIterationsChanged,
-                     w, &LoopUntilPropertiesWidget::setMaxIterations);
-    return w;
-}
-
 bool LoopUntilNode::isReady(const QVariantMap& inputs, int incomingConnectionsCount) const
 {
     Q_UNUSED(incomingConnectionsCount);
@@ -226,6 +226,7 @@ TokenList LoopUntilNode::execute(const TokenList& incomingTokens)
 
             DataPacket out;
             out.insert(QStringLiteral("text"), m_pendingFeedback);
+            out.insert(QString::fromLatin1(kOutputConversationId), m_conversationId);
             if (finalStop) {
                 out.insert(QString::fromLatin1(kOutputResultId), m_pendingFeedback);
                 m_isProcessing = false;
@@ -251,9 +252,11 @@ TokenList LoopUntilNode::execute(const TokenList& incomingTokens)
         m_hasPendingFeedback = true;
         m_isProcessing = true;
         m_hasLastEvaluatedCondition = false; // Reset for new run
+        m_conversationId = QUuid::createUuid().toString(QUuid::WithoutBraces);
 
         DataPacket out;
         out.insert(QStringLiteral("text"), m_pendingFeedback);
+        out.insert(QString::fromLatin1(kOutputConversationId), m_conversationId);
         out.insert(QString::fromLatin1(kOutputCurrentId), m_pendingFeedback);
 
         ExecutionToken tok;
@@ -25,7 +25,6 @@
 #pragma once
 
 #include <QObject>
-#include <QWidget>
 #include <QString>
 #include <QVariant>
 #include <QMutex>
@@ -34,6 +33,8 @@
 #include "IToolNode.h"
 #include "CommonDataTypes.h"
 
+class QWidget;
+
 class LoopUntilPropertiesWidget;
 
 /**
@@ -47,9 +48,14 @@ class LoopUntilPropertiesWidget;
  *  - Outputs:
  *      current   (any): Current attempt (emitted while looping)
  *      result    (any): Final result (when condition true or max iterations reached)
+ *      conversation (text): Id of the current run, fresh for each start value; wire it to
+ *                   a Universal AI node's conversation input to continue one conversation
  *
  * Properties:
  *  - Max Iterations (default 10)
+ *
+ * Every iteration is a round trip through the engine. Transform Scope's
+ * retry_until_accepted mode runs the same loop over a body canvas inside one execution.
  */
 class LoopUntilNode : public QObject, public IToolNode {
     Q_OBJECT
@@ -61,7 +67,8 @@ public:
 
     // IToolNode
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in LoopUntilPropertiesWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     TokenList execute(const TokenList& incomingTokens) override;
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
@@ -75,6 +82,7 @@ public:
     static constexpr const char* kInputConditionId = "condition";
     static constexpr const char* kOutputCurrentId = "current";
     static constexpr const char* kOutputResultId = "result";
+    static constexpr const char* kOutputConversationId = "conversation";
 
     // Accessors
     int maxIterations() const { return m_maxIterations; }
@@ -97,6 +105,7 @@ private:
     QVariant m_lastIngestedStart;
     bool m_hasLastIngestedStart {false};
     bool m_hasLastEvaluatedCondition {false};
+    QString m_conversationId;
 
     // Event-driven latch state (persisted): feedback payload waiting for a condition trigger
     QString m_pendingFeedback;
@@ -23,6 +23,7 @@
 //
 
 #include "LoopUntilPropertiesWidget.h"
+#include "LoopUntilNode.h"
 
 #include <QVBoxLayout>
 #include <QLabel>
@@ -61,3 +62,14 @@ int LoopUntilPropertiesWidget::maxIterations() const
 {
     return m_spin ? m_spin->value() : 10;
 }
+
+QWidget* LoopUntilNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* w = new LoopUntilPropertiesWidget(parent);
+    w->setMaxIterations(m_maxIterations);
+    QObject::connect(w, &LoopUntilPropertiesWidget::maxIterationsChanged,
+                     this, &LoopUntilNode::setMaxIterations);
+    QObject::connect(this, &LoopUntilNode::maxIterationsChanged,
+                     w, &LoopUntilPropertiesWidget::setMaxIterations);
+    return w;
+}
@@ -23,9 +23,9 @@
 //
 
 #include "RetryLoopNode.h"
-#include "RetryLoopPropertiesWidget.h"
 #include <QMutexLocker>
 #include <QDebug>
+#include <QUuid>
 
 RetryLoopNode::RetryLoopNode(QObject* parent)
     : QObject(parent)
@@ -71,6 +71,18 @@ NodeDescriptor RetryLoopNode::getDescriptor() const
     verifiedResult.type = QStringLiteral("text");
     desc.outputPins.insert(verifiedResult.id, verifiedResult);
 
+    // Output: conversation (The id of the current task, shared by its retries)
+    PinDefinition conversation;
+    conversation.direction = PinDirection::Output;
+    conversation.id = QString::fromLatin1(kOutputConversationId);
+    conversation.name = QStringLiteral("Conversation");
+    conversation.type = QStringLiteral("text");
+    desc.outputPins.insert(conversation.id, conversation);
+    // Keeps the ports saved graphs already connect where they were
+    desc.outputPinOrder = {QString::fromLatin1(kOutputVerifiedResultId),
+                           QString::fromLatin1(kOutputWorkerInstructionId),
+                           QString::fromLatin1(kOutputConversationId)};
+
     return desc;
 }
 
@@ -90,11 +102,6 @@ void RetryLoopNode::setMaxRetries(int value)
     }
 }
 
-QWidget* RetryLoopNode::createConfigurationWidget(QWidget* parent)
-{
-    return new RetryLoopPropertiesWidget(this, parent);
-}
-
 bool RetryLoopNode::isReady(const QVariantMap& inputs, int incomingConnectionsCount) const
 {
     Q_UNUSED(incomingConnectionsCount);
@@ -129,6 +136,7 @@ TokenList RetryLoopNode::execute(const TokenList& incomingTokens)
                         ExecutionToken outToken;
                         outToken.forceExecution = true; // Bypass deduplication for retries
                         outToken.data.insert(QString::fromLatin1(kOutputWorkerInstructionId), m_cachedPayload);
+                        outToken.data.insert(QString::fromLatin1(kOutputConversationId), m_conversationId);
                         outToken.data.insert(QStringLiteral("text"), m_cachedPayload);
                         outputs.push_back(std::move(outToken));
                     } else {
@@ -145,6 +153,7 @@ TokenList RetryLoopNode::execute(const TokenList& incomingTokens)
                     // Success
                     ExecutionToken outToken;
                     outToken.data.insert(QString::fromLatin1(kOutputVerifiedResultId), feedbackPayload);
+                    outToken.data.insert(QString::fromLatin1(kOutputConversationId), m_conversationId);
                     outToken.data.insert(QStringLiteral("text"), feedbackPayload);
                     outputs.push_back(std::move(outToken));
 
@@ -162,9 +171,11 @@ TokenList RetryLoopNode::execute(const TokenList& incomingTokens)
         m_taskQueue.pop_front();
         m_retryCount = 0;
         m_isProcessing = true;
+        m_conversationId = QUuid::createUuid().toString(QUuid::WithoutBraces);
 
         ExecutionToken outToken;
         outToken.data.insert(QString::fromLatin1(kOutputWorkerInstructionId), m_cachedPayload);
+        outToken.data.insert(QString::fromLatin1(kOutputConversationId), m_conversationId);
         outToken.data.insert(QStringLiteral("text"), m_cachedPayload);
         outputs.push_back(std::move(outToken));
     }
@@ -31,8 +31,13 @@
 #include <deque>
 #include "IToolNode.h"
 
+class QWidget;
+
 /**
  * @brief RetryLoopNode acts as a "Reliability Supervisor" that retries a task if worker feedback indicates failure.
+ *
+ * Transform Scope's retry_from_input mode retries a body canvas the same way without
+ * routing each attempt back through the engine.
  */
 class RetryLoopNode : public QObject, public IToolNode {
     Q_OBJECT
@@ -44,7 +49,8 @@ public:
 
     // IToolNode interface
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in RetryLoopPropertiesWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     TokenList execute(const TokenList& incomingTokens) override;
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
@@ -68,12 +74,16 @@ public:
     static constexpr const char* kOutputWorkerInstructionId = "worker_instruction";
     static constexpr const char* kInputWorkerFeedbackId = "worker_feedback";
     static constexpr const char* kOutputVerifiedResultId = "verified_result";
+    // Id of the task being worked on, fresh for each task; retries of it share one
+    // conversation on a Universal AI node whose conversation input is wired to it
+    static constexpr const char* kOutputConversationId = "conversation";
 
 private:
     mutable QMutex m_mutex;
     std::deque<QVariant> m_taskQueue;
     bool m_isProcessing {false};
     QVariant m_cachedPayload;
+    QString m_conversationId;
     int m_retryCount {0};
     int m_maxRetries {3};
     QString m_failureString {QStringLiteral("FAIL")};
@@ -51,3 +51,8 @@ RetryLoopPropertiesWidget::RetryLoopPropertiesWidget(RetryLoopNode* node, QWidge
     connect(m_node, &RetryLoopNode::failureStringChanged, m_failureLineEdit, &QLineEdit::setText);
     connect(m_node, &RetryLoopNode::maxRetriesChanged, m_maxRetriesSpinBox, &QSpinBox::setValue);
 }
+
+QWidget* RetryLoopNode::createConfigurationWidget(QWidget* parent)
+{
+    return new RetryLoopPropertiesWidget(this, parent);
+}
@@ -1,7 +1,6 @@
 #include "GetInputNode.h"
 
 #include <QJsonObject>
-#include <QLabel>
 
 namespace {
 void addOutput(NodeDescriptor& desc, const QString& id, const QString& name)
@@ -38,17 +37,16 @@ NodeDescriptor GetInputNode::getDescriptor() const
     addOutput(desc, QString::fromLatin1(kOutputInputId), QStringLiteral("Input"));
     addOutput(desc, QString::fromLatin1(kOutputPreviousOutputId), QStringLiteral("Previous Output"));
     addOutput(desc, QString::fromLatin1(kOutputTextId), QStringLiteral("Text"));
+    addOutput(desc, QString::fromLatin1(kOutputConversationId), QStringLiteral("Conversation"));
+    // Keeps the ports saved bodies already connect where they were
+    desc.outputPinOrder = {QString::fromLatin1(kOutputAttemptId), QString::fromLatin1(kOutputContextId),
+                           QString::fromLatin1(kOutputHistoryId), QString::fromLatin1(kOutputInputId),
+                           QString::fromLatin1(kOutputPreviousOutputId), QString::fromLatin1(kOutputTextId),
+                           QString::fromLatin1(kOutputConversationId)};
 
     return desc;
 }
 
-QWidget* GetInputNode::createConfigurationWidget(QWidget* parent)
-{
-    auto* label = new QLabel(QObject::tr("Reads the current Transform Scope body input."), parent);
-    label->setWordWrap(true);
-    return label;
-}
-
 TokenList GetInputNode::execute(const TokenList& incomingTokens)
 {
     DataPacket input;
@@ -67,6 +65,7 @@ TokenList GetInputNode::execute(const TokenList& incomingTokens)
     output.insert(QString::fromLatin1(kOutputAttemptId), firstValue(input, QStringLiteral("_transform_attempt")));
     output.insert(QString::fromLatin1(kOutputPreviousOutputId), firstValue(input, QStringLiteral("_transform_previous_output")));
     output.insert(QString::fromLatin1(kOutputHistoryId), firstValue(input, QStringLiteral("_scope_history")));
+    output.insert(QString::fromLatin1(kOutputConversationId), firstValue(input, QStringLiteral("_scope_conversation")));
 
     ExecutionToken token;
     token.data = output;
@@ -4,6 +4,8 @@
 
 #include <QObject>
 
+class QWidget;
+
 class GetInputNode : public QObject, public IToolNode {
     Q_OBJECT
     Q_INTERFACES(IToolNode)
@@ -13,7 +15,8 @@ public:
     ~GetInputNode() override = default;
 
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in ScopeNodeLabels.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     TokenList execute(const TokenList& incomingTokens) override;
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
@@ -24,4 +27,6 @@ public:
     static constexpr const char* kOutputAttemptId = "attempt";
     static constexpr const char* kOutputPreviousOutputId = "previous_output";
     static constexpr const char* kOutputHistoryId = "history";
+    // Fresh for each Transform Scope execution and shared by its attempts
+    static constexpr const char* kOutputConversationId = "conversation";
 };
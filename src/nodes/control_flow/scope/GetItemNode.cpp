@@ -1,7 +1,6 @@
 #include "GetItemNode.h"
 
 #include <QJsonObject>
-#include <QLabel>
 
 namespace {
 void addOutput(NodeDescriptor& desc, const QString& id, const QString& name)
@@ -42,13 +41,6 @@ NodeDescriptor GetItemNode::getDescriptor() const
     return desc;
 }
 
-QWidget* GetItemNode::createConfigurationWidget(QWidget* parent)
-{
-    auto* label = new QLabel(QObject::tr("Reads the current Iterator Scope item."), parent);
-    label->setWordWrap(true);
-    return label;
-}
-
 TokenList GetItemNode::execute(const TokenList& incomingTokens)
 {
     DataPacket input;
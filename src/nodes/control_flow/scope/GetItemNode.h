@@ -4,6 +4,8 @@
 
 #include <QObject>
 
+class QWidget;
+
 class GetItemNode : public QObject, public IToolNode {
     Q_OBJECT
     Q_INTERFACES(IToolNode)
@@ -13,7 +15,8 @@ public:
     ~GetItemNode() override = default;
 
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in ScopeNodeLabels.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     TokenList execute(const TokenList& incomingTokens) override;
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
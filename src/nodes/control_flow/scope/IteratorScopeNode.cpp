@@ -1,9 +1,23 @@
 #include "IteratorScopeNode.h"
-#include "IteratorScopePropertiesWidget.h"
+
+#include "CancellationToken.h"
+#include "ExecutionTrace.h"
+#include "RunUsageReport.h"
+#include "Tracer.h"
+#include "PartialOutputSink.h"
+#include "ResultCache.h"
 
 #include <QJsonObject>
+#include <QMutex>
+#include <QThreadPool>
 #include <QUuid>
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <limits>
+#include <vector>
+
 namespace {
 void addInput(NodeDescriptor& desc, const QString& id, const QString& name)
 {
@@ -36,6 +50,31 @@ QVariantMap historyEntry(int index, const ScopeBodyResult& body)
     return entry;
 }
 
+// What the item cache keeps of a pass: everything absorb() and the stream read
+QVariantMap cachedPassEntry(const ScopeBodyResult& body)
+{
+    QVariantMap entry;
+    entry.insert(QStringLiteral("output"), body.output);
+    entry.insert(QStringLiteral("skip"), body.skip);
+    entry.insert(QStringLiteral("context"), body.context);
+    entry.insert(QStringLiteral("message"), body.message);
+    entry.insert(QStringLiteral("status"), body.status);
+    return entry;
+}
+
+ScopeBodyResult cachedPassResult(const QVariantMap& entry)
+{
+    ScopeBodyResult body;
+    body.ok = true;
+    body.output = entry.value(QStringLiteral("output"));
+    body.skip = entry.value(QStringLiteral("skip")).toBool();
+    body.context = scopeVariantToMap(entry.value(QStringLiteral("context")));
+    body.message = entry.value(QStringLiteral("message")).toString();
+    body.status = entry.value(QStringLiteral("status")).toString();
+    body.raw = entry;
+    return body;
+}
+
 QVariantMap errorEntry(int index, const QVariant& item, const QString& error)
 {
     QVariantMap entry;
@@ -65,17 +104,13 @@ NodeDescriptor IteratorScopeNode::getDescriptor() const
     addOutput(desc, QString::fromLatin1(kOutputErrorsId), QStringLiteral("Errors"));
     addOutput(desc, QString::fromLatin1(kOutputResultsId), QStringLiteral("Results"));
     addOutput(desc, QString::fromLatin1(kOutputStatusId), QStringLiteral("Status"));
+    addOutput(desc, QString::fromLatin1(kOutputStreamId), QStringLiteral("Item Results (stream)"));
     addOutput(desc, QString::fromLatin1(kOutputSummaryId), QStringLiteral("Summary"));
     addOutput(desc, QString::fromLatin1(kOutputTextId), QStringLiteral("Text"));
 
     return desc;
 }
 
-QWidget* IteratorScopeNode::createConfigurationWidget(QWidget* parent)
-{
-    return new IteratorScopePropertiesWidget(this, parent);
-}
-
 bool IteratorScopeNode::isReady(const QVariantMap& inputs, int incomingConnectionsCount) const
 {
     Q_UNUSED(incomingConnectionsCount);
@@ -102,19 +137,82 @@ TokenList IteratorScopeNode::execute(const TokenList& incomingTokens)
     QVariantList results;
     QVariantList errors;
     int skipped = 0;
-
-    for (int index = 0; index < items.size(); ++index) {
-        const QVariant item = items.at(index);
-        setLastStatus(QStringLiteral("Item %1/%2").arg(index + 1).arg(items.size()));
-
-        const ScopeFrame frame = makeFrame(item, index, items.size(), context, history);
+    QString failure;
+
+    // With a batch size above 1 each pass carries a slice of consecutive items as a list;
+    // a pass's index is that of its first item
+    const bool batched = m_batchSize > 1;
+    QVariantList passItems;
+    QVector<int> passStart;
+    if (batched) {
+        for (int start = 0; start < items.size(); start += m_batchSize) {
+            passItems.append(QVariant(items.mid(start, m_batchSize)));
+            passStart.append(start);
+        }
+    } else {
+        passItems = items;
+        for (int start = 0; start < items.size(); ++start) {
+            passStart.append(start);
+        }
+    }
+    const int passCount = passItems.size();
+
+    // Item cache: a pass is keyed by the body graph's content hash, its item and the
+    // context it starts from, plus any other scope inputs. Index, item count and history
+    // are left out so that appending or reordering items keeps earlier entries valid;
+    // bodies that read them should leave the cache off.
+    const ResultCache* const itemCache = m_cacheItemResults ? ResultCache::current() : nullptr;
+    const QByteArray bodyHash = itemCache && m_bodyFingerprint ? m_bodyFingerprint(m_bodyId) : QByteArray();
+    QVariantMap otherInputs;
+    for (auto it = inputs.cbegin(); it != inputs.cend(); ++it) {
+        if (it.key() != QLatin1String(kInputItemsId) && it.key() != QLatin1String(kInputContextId)) {
+            otherInputs.insert(it.key(), it.value());
+        }
+    }
+    const auto itemKey = [&](int pass, const QVariantMap& passContext) {
+        if (bodyHash.isEmpty()) {
+            return QString();
+        }
+        QJsonObject config;
+        config.insert(QStringLiteral("body"), QString::fromLatin1(bodyHash.toHex()));
+        config.insert(QStringLiteral("batch_size"), m_batchSize);
+        ExecutionToken key;
+        key.data.insert(QStringLiteral("item"), passItems.at(pass));
+        key.data.insert(QStringLiteral("context"), passContext);
+        key.data.insert(QStringLiteral("inputs"), otherInputs);
+        return ResultCache::makeKey(QStringLiteral("iterator-scope-item"), config, TokenList{std::move(key)});
+    };
+    std::atomic<int> cachedPasses {0};
+    // Runs one pass, or replays it from the item cache; successful passes are stored
+    const auto runPass = [&](const ScopeFrame& frame, int pass) {
+        const QString key = itemKey(pass, frame.context);
+        if (!key.isEmpty()) {
+            const std::optional<TokenList> cached = itemCache->lookup(key);
+            if (cached && !cached->empty()) {
+                ++cachedPasses;
+                return cachedPassResult(cached->front().data);
+            }
+        }
         ScopeBodyResult body = m_bodyRunner(m_bodyId, ScopeBodyKind::Iterator, frame, inputs);
+        if (!key.isEmpty() && body.ok) {
+            ExecutionToken entry;
+            entry.data = cachedPassEntry(body);
+            itemCache->store(key, TokenList{std::move(entry)});
+        }
+        return body;
+    };
+
+    // Folds one finished pass into the outputs; false once the failure policy stops the scope
+    const auto absorb = [&](int pass, const ScopeBodyResult& body) {
+        const QVariant& item = passItems.at(pass);
+        const int index = passStart.at(pass);
         if (!body.ok) {
             const QString message = body.error.isEmpty() ? QStringLiteral("Iterator body failed.") : body.error;
             errors.append(errorEntry(index, item, message));
 
             if (m_failurePolicy == QStringLiteral("stop")) {
-                return errorOutput(message, errors);
+                failure = message;
+                return false;
             }
             if (m_failurePolicy == QStringLiteral("include_error")) {
                 results.append(QVariantMap{
@@ -123,7 +221,7 @@ TokenList IteratorScopeNode::execute(const TokenList& incomingTokens)
                     {QStringLiteral("item"), item}
                 });
             }
-            continue;
+            return true;
         }
 
         scopeMergeMap(context, body.context);
@@ -131,9 +229,130 @@ TokenList IteratorScopeNode::execute(const TokenList& incomingTokens)
 
         if (body.skip) {
             ++skipped;
-            continue;
+            return true;
+        }
+        // A batch pass that returns a list contributes one result per element
+        const QVariant output = scopePreferredValue(body.output, item);
+        if (batched && output.typeId() == QMetaType::QVariantList) {
+            results.append(output.toList());
+        } else {
+            results.append(output);
+        }
+        return true;
+    };
+
+    // Each successful pass's results go out on the stream pin as soon as the pass ends,
+    // in completion order, so downstream work overlaps with the remaining passes.
+    // Forced so that equal consecutive results still reach downstream nodes.
+    const PartialOutputSink stream = PartialOutputSink::current();
+    const auto publish = [&](int pass, const ScopeBodyResult& body) {
+        if (!stream.isActive() || !body.ok || body.skip) {
+            return;
+        }
+        const QVariant output = scopePreferredValue(body.output, passItems.at(pass));
+        const QVariantList values = batched && output.typeId() == QMetaType::QVariantList
+            ? output.toList()
+            : QVariantList{output};
+        TokenList tokens;
+        for (const QVariant& value : values) {
+            ExecutionToken token;
+            token.data.insert(QString::fromLatin1(kOutputStreamId), value);
+            token.forceExecution = true;
+            tokens.push_back(std::move(token));
+        }
+        stream.publish(tokens);
+    };
+
+    const QString passLabel = batched ? QStringLiteral("Batch") : QStringLiteral("Item");
+    const int parallelism = std::min<int>(m_maxParallelism, passCount);
+    if (parallelism <= 1) {
+        for (int pass = 0; pass < passCount; ++pass) {
+            setLastStatus(QStringLiteral("%1 %2/%3").arg(passLabel).arg(pass + 1).arg(passCount));
+
+            const ScopeFrame frame = makeFrame(passItems.at(pass), passStart.at(pass), items.size(), context, history);
+            const ScopeBodyResult body = runPass(frame, pass);
+            if (!absorb(pass, body)) {
+                return errorOutput(failure, errors);
+            }
+            publish(pass, body);
+        }
+    } else {
+        // Concurrent passes all start from the scope's input context and see no history;
+        // their context deltas are merged in the order the results are assembled.
+        const QVariantMap initialContext = context;
+        const CancellationToken cancellation = CancellationToken::current();
+        ExecutionTrace* const trace = ExecutionTrace::current();
+        RunUsageCollector* const usage = RunUsageCollector::current();
+        const Tracer::Context tracingContext = Tracer::current();
+        const auto serializer = std::make_shared<ScopeNodeSerializer>();
+
+        std::vector<ScopeBodyResult> bodies(passCount);
+        std::vector<bool> ran(passCount, false);
+        // Under "stop", passes after the lowest failed index are not started
+        std::atomic<int> firstFailure {std::numeric_limits<int>::max()};
+        QMutex progressMutex;
+        QList<int> completionOrder;
+
+        QThreadPool pool;
+        pool.setMaxThreadCount(parallelism);
+        for (int pass = 0; pass < passCount; ++pass) {
+            pool.start([&, pass]() {
+                if (pass > firstFailure.load() || cancellation.isCancelled()) {
+                    return;
+                }
+                CancellationToken::Scope cancellationScope(cancellation);
+                const Tracer::Scope tracingScope(tracingContext);
+                const ResultCache::Scope itemCacheScope(itemCache);
+                ExecutionTrace::setCurrent(trace);
+                RunUsageCollector::setCurrent(usage);
+                ScopeFrame frame = makeFrame(passItems.at(pass), passStart.at(pass), items.size(), initialContext, {});
+                frame.serializer = serializer;
+                ScopeBodyResult body;
+                // Exceptions must not escape a pool thread; report them as a failed pass
+                try {
+                    body = runPass(frame, pass);
+                } catch (const std::exception& e) {
+                    body.error = QString::fromUtf8(e.what());
+                } catch (...) {
+                    body.error = QStringLiteral("Iterator body threw an unknown exception.");
+                }
+                ExecutionTrace::setCurrent(nullptr);
+                RunUsageCollector::setCurrent(nullptr);
+                publish(pass, body);
+
+                if (!body.ok && m_failurePolicy == QStringLiteral("stop")) {
+                    int expected = firstFailure.load();
+                    while (pass < expected && !firstFailure.compare_exchange_weak(expected, pass)) {
+                    }
+                }
+                QMutexLocker locker(&progressMutex);
+                bodies[pass] = std::move(body);
+                ran[pass] = true;
+                completionOrder.append(pass);
+                setLastStatus(QStringLiteral("%1 %2/%3 done").arg(passLabel).arg(completionOrder.size()).arg(passCount));
+            });
+        }
+        pool.waitForDone();
+
+        if (cancellation.isCancelled()) {
+            return errorOutput(QStringLiteral("Iterator Scope cancelled."), errors);
+        }
+
+        QList<int> order;
+        if (m_resultOrder == QStringLiteral("completion")) {
+            order = completionOrder;
+        } else {
+            for (int pass = 0; pass < passCount; ++pass) {
+                if (ran[pass]) {
+                    order.append(pass);
+                }
+            }
+        }
+        for (int pass : order) {
+            if (!absorb(pass, bodies[pass])) {
+                return errorOutput(failure, errors);
+            }
         }
-        results.append(scopePreferredValue(body.output, item));
     }
 
     QVariantMap summary;
@@ -145,6 +364,11 @@ TokenList IteratorScopeNode::execute(const TokenList& incomingTokens)
     summary.insert(QStringLiteral("skipped"), skipped);
     summary.insert(QStringLiteral("error_count"), errors.size());
     summary.insert(QStringLiteral("failure_policy"), m_failurePolicy);
+    summary.insert(QStringLiteral("max_parallelism"), m_maxParallelism);
+    summary.insert(QStringLiteral("result_order"), m_resultOrder);
+    summary.insert(QStringLiteral("batch_size"), m_batchSize);
+    summary.insert(QStringLiteral("pass_count"), passCount);
+    summary.insert(QStringLiteral("cached_passes"), cachedPasses.load());
     summary.insert(QStringLiteral("history"), history);
 
     QVariantMap outputContext = context;
@@ -203,8 +427,10 @@ ScopeFrame IteratorScopeNode::makeFrame(const QVariant& item,
     frame.count = count;
     frame.item = item;
     frame.input = item;
+    frame.batchSize = m_batchSize > 1 ? static_cast<int>(item.toList().size()) : 1;
     frame.context = context;
     frame.history = history;
+    frame.budget = m_budget;
     return frame;
 }
 
@@ -213,6 +439,11 @@ QJsonObject IteratorScopeNode::saveState() const
     QJsonObject obj;
     obj.insert(QStringLiteral("body_id"), m_bodyId);
     obj.insert(QStringLiteral("failure_policy"), m_failurePolicy);
+    obj.insert(QStringLiteral("max_parallelism"), m_maxParallelism);
+    obj.insert(QStringLiteral("result_order"), m_resultOrder);
+    obj.insert(QStringLiteral("batch_size"), m_batchSize);
+    obj.insert(QStringLiteral("budget"), m_budget.toJson());
+    obj.insert(QStringLiteral("cache_item_results"), m_cacheItemResults);
     return obj;
 }
 
@@ -223,6 +454,14 @@ void IteratorScopeNode::loadState(const QJsonObject& data)
         m_bodyId = bodyId;
     }
     setFailurePolicy(data.value(QStringLiteral("failure_policy")).toString(m_failurePolicy));
+    setMaxParallelism(data.value(QStringLiteral("max_parallelism")).toInt(1));
+    setResultOrder(data.value(QStringLiteral("result_order")).toString(QStringLiteral("input")));
+    setBatchSize(data.value(QStringLiteral("batch_size")).toInt(1));
+    if (data.contains(QStringLiteral("budget"))) {
+        m_budget = ScopeBudget::fromJson(data.value(QStringLiteral("budget")).toObject());
+        emit budgetChanged();
+    }
+    setCacheItemResults(data.value(QStringLiteral("cache_item_results")).toBool(false));
 }
 
 void IteratorScopeNode::setBodyRunner(ScopeBodyRunner runner)
@@ -230,6 +469,11 @@ void IteratorScopeNode::setBodyRunner(ScopeBodyRunner runner)
     m_bodyRunner = std::move(runner);
 }
 
+void IteratorScopeNode::setBodyFingerprint(ScopeBodyFingerprint fingerprint)
+{
+    m_bodyFingerprint = std::move(fingerprint);
+}
+
 void IteratorScopeNode::setFailurePolicy(const QString& policy)
 {
     QString normalized = policy.trimmed().toLower();
@@ -246,6 +490,60 @@ void IteratorScopeNode::setFailurePolicy(const QString& policy)
     emit failurePolicyChanged(m_failurePolicy);
 }
 
+void IteratorScopeNode::setMaxParallelism(int passes)
+{
+    const int clamped = std::clamp(passes, 1, kMaxParallelismLimit);
+    if (clamped == m_maxParallelism) {
+        emit maxParallelismChanged(m_maxParallelism);
+        return;
+    }
+    m_maxParallelism = clamped;
+    emit maxParallelismChanged(m_maxParallelism);
+}
+
+void IteratorScopeNode::setBatchSize(int items)
+{
+    const int clamped = std::clamp(items, 1, kMaxBatchSize);
+    if (clamped == m_batchSize) {
+        emit batchSizeChanged(m_batchSize);
+        return;
+    }
+    m_batchSize = clamped;
+    emit batchSizeChanged(m_batchSize);
+}
+
+void IteratorScopeNode::setResultOrder(const QString& order)
+{
+    QString normalized = order.trimmed().toLower();
+    if (normalized != QStringLiteral("input") && normalized != QStringLiteral("completion")) {
+        normalized = QStringLiteral("input");
+    }
+    if (normalized == m_resultOrder) {
+        emit resultOrderChanged(m_resultOrder);
+        return;
+    }
+    m_resultOrder = normalized;
+    emit resultOrderChanged(m_resultOrder);
+}
+
+void IteratorScopeNode::setMaxSteps(int steps)
+{
+    m_budget.maxSteps = qBound(1, steps, ScopeBudget::kMaxStepsLimit);
+    emit budgetChanged();
+}
+
+void IteratorScopeNode::setTimeLimitSeconds(int seconds)
+{
+    m_budget.timeLimitSeconds = qBound(0, seconds, ScopeBudget::kMaxTimeLimitSeconds);
+    emit budgetChanged();
+}
+
+void IteratorScopeNode::setCacheItemResults(bool enabled)
+{
+    m_cacheItemResults = enabled;
+    emit cacheItemResultsChanged(m_cacheItemResults);
+}
+
 void IteratorScopeNode::requestOpenBody()
 {
     emit openBodyRequested(m_bodyId, QStringLiteral("Iterator Body %1").arg(m_bodyId.left(8)));
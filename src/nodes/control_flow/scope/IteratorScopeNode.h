@@ -6,6 +6,8 @@
 #include <QObject>
 #include <QString>
 
+class QWidget;
+
 class IteratorScopeNode : public QObject, public IToolNode {
     Q_OBJECT
     Q_INTERFACES(IToolNode)
@@ -15,16 +17,23 @@ public:
     ~IteratorScopeNode() override = default;
 
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in IteratorScopePropertiesWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     bool isReady(const QVariantMap& inputs, int incomingConnectionsCount) const override;
     TokenList execute(const TokenList& incomingTokens) override;
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
 
     void setBodyRunner(ScopeBodyRunner runner);
+    void setBodyFingerprint(ScopeBodyFingerprint fingerprint);
 
     QString bodyId() const { return m_bodyId; }
     QString failurePolicy() const { return m_failurePolicy; }
+    int maxParallelism() const { return m_maxParallelism; }
+    QString resultOrder() const { return m_resultOrder; }
+    int batchSize() const { return m_batchSize; }
+    ScopeBudget budget() const { return m_budget; }
+    bool cacheItemResults() const { return m_cacheItemResults; }
     QString lastStatus() const { return m_lastStatus; }
 
     static constexpr const char* kInputContextId = "context";
@@ -33,15 +42,36 @@ public:
     static constexpr const char* kOutputErrorsId = "errors";
     static constexpr const char* kOutputResultsId = "results";
     static constexpr const char* kOutputStatusId = "status";
+    static constexpr const char* kOutputStreamId = "stream";
     static constexpr const char* kOutputSummaryId = "summary";
     static constexpr const char* kOutputTextId = "text";
 
+    static constexpr int kMaxParallelismLimit = 64;
+    static constexpr int kMaxBatchSize = 10000;
+
 public slots:
     void setFailurePolicy(const QString& policy);
+    // Body passes run at once; above 1 each pass sees the input context and no history
+    void setMaxParallelism(int passes);
+    // "input" assembles results in item order, "completion" in the order passes finish
+    void setResultOrder(const QString& order);
+    // Items per body pass; above 1 the pass's item is a list slice
+    void setBatchSize(int items);
+    // Per-pass body limits; see ScopeBudget
+    void setMaxSteps(int steps);
+    void setTimeLimitSeconds(int seconds);
+    // Replay stored Set Item Result values for passes whose body, item and starting
+    // context are unchanged since an earlier run; only new or changed items execute
+    void setCacheItemResults(bool enabled);
     void requestOpenBody();
 
 signals:
     void failurePolicyChanged(const QString& policy);
+    void maxParallelismChanged(int passes);
+    void resultOrderChanged(const QString& order);
+    void batchSizeChanged(int items);
+    void budgetChanged();
+    void cacheItemResultsChanged(bool enabled);
     void statusChanged(const QString& status);
     void openBodyRequested(const QString& bodyId, const QString& title);
 
@@ -57,6 +87,12 @@ private:
 private:
     QString m_bodyId;
     QString m_failurePolicy {QStringLiteral("stop")};
+    int m_maxParallelism {1};
+    QString m_resultOrder {QStringLiteral("input")};
+    int m_batchSize {1};
+    ScopeBudget m_budget;
+    bool m_cacheItemResults {false};
     QString m_lastStatus;
     ScopeBodyRunner m_bodyRunner;
+    ScopeBodyFingerprint m_bodyFingerprint;
 };
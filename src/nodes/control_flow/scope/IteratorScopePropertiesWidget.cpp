@@ -1,11 +1,14 @@
 #include "IteratorScopePropertiesWidget.h"
 
 #include "IteratorScopeNode.h"
+#include "ScopeRuntime.h"
 
+#include <QCheckBox>
 #include <QComboBox>
 #include <QFormLayout>
 #include <QLabel>
 #include <QPushButton>
+#include <QSpinBox>
 #include <QVBoxLayout>
 
 IteratorScopePropertiesWidget::IteratorScopePropertiesWidget(IteratorScopeNode* node, QWidget* parent)
@@ -21,6 +24,41 @@ IteratorScopePropertiesWidget::IteratorScopePropertiesWidget(IteratorScopeNode*
     m_failurePolicyCombo->addItem(tr("Include error rows"), QStringLiteral("include_error"));
     form->addRow(tr("Failure policy"), m_failurePolicyCombo);
 
+    m_parallelismSpin = new QSpinBox(this);
+    m_parallelismSpin->setRange(1, IteratorScopeNode::kMaxParallelismLimit);
+    m_parallelismSpin->setToolTip(tr("Body passes that run at once. Concurrent passes each see the "
+                                     "scope's input context and no history."));
+    form->addRow(tr("Max parallelism"), m_parallelismSpin);
+
+    m_resultOrderCombo = new QComboBox(this);
+    m_resultOrderCombo->addItem(tr("Input order"), QStringLiteral("input"));
+    m_resultOrderCombo->addItem(tr("Completion order"), QStringLiteral("completion"));
+    form->addRow(tr("Result order"), m_resultOrderCombo);
+
+    m_batchSizeSpin = new QSpinBox(this);
+    m_batchSizeSpin->setRange(1, IteratorScopeNode::kMaxBatchSize);
+    m_batchSizeSpin->setToolTip(tr("Items per body pass. Above 1, Get Item emits a list of consecutive "
+                                   "items, and a list result is spread back into one result per item."));
+    form->addRow(tr("Batch size"), m_batchSizeSpin);
+
+    m_maxStepsSpin = new QSpinBox(this);
+    m_maxStepsSpin->setRange(1, ScopeBudget::kMaxStepsLimit);
+    m_maxStepsSpin->setToolTip(tr("Body node executions allowed per pass."));
+    form->addRow(tr("Step budget"), m_maxStepsSpin);
+
+    m_timeLimitSpin = new QSpinBox(this);
+    m_timeLimitSpin->setRange(0, ScopeBudget::kMaxTimeLimitSeconds);
+    m_timeLimitSpin->setSuffix(tr(" s"));
+    m_timeLimitSpin->setSpecialValueText(tr("No limit"));
+    m_timeLimitSpin->setToolTip(tr("Wall time allowed per pass, checked between body node executions."));
+    form->addRow(tr("Time limit"), m_timeLimitSpin);
+
+    m_cacheItemsCheck = new QCheckBox(tr("Reuse results of unchanged items"), this);
+    m_cacheItemsCheck->setToolTip(tr("Replays each item's stored Set Item Result on later runs while the body, "
+                                     "the item and its starting context are unchanged. Leave off for bodies "
+                                     "that read the item index, count or history."));
+    form->addRow(tr("Item cache"), m_cacheItemsCheck);
+
     layout->addLayout(form);
 
     m_openButton = new QPushButton(tr("Open Body"), this);
@@ -33,6 +71,11 @@ IteratorScopePropertiesWidget::IteratorScopePropertiesWidget(IteratorScopeNode*
 
     if (m_node) {
         setFailurePolicy(m_node->failurePolicy());
+        setMaxParallelism(m_node->maxParallelism());
+        setResultOrder(m_node->resultOrder());
+        setBatchSize(m_node->batchSize());
+        setBudget();
+        setCacheItemResults(m_node->cacheItemResults());
         setStatus(m_node->lastStatus());
 
         connect(m_failurePolicyCombo, &QComboBox::currentIndexChanged, this, [this](int index) {
@@ -41,11 +84,37 @@ IteratorScopePropertiesWidget::IteratorScopePropertiesWidget(IteratorScopeNode*
             }
             m_node->setFailurePolicy(m_failurePolicyCombo->itemData(index).toString());
         });
+        connect(m_parallelismSpin, &QSpinBox::valueChanged,
+                m_node, &IteratorScopeNode::setMaxParallelism);
+        connect(m_resultOrderCombo, &QComboBox::currentIndexChanged, this, [this](int index) {
+            if (!m_node) {
+                return;
+            }
+            m_node->setResultOrder(m_resultOrderCombo->itemData(index).toString());
+        });
+        connect(m_batchSizeSpin, &QSpinBox::valueChanged,
+                m_node, &IteratorScopeNode::setBatchSize);
+        connect(m_maxStepsSpin, &QSpinBox::valueChanged,
+                m_node, &IteratorScopeNode::setMaxSteps);
+        connect(m_timeLimitSpin, &QSpinBox::valueChanged,
+                m_node, &IteratorScopeNode::setTimeLimitSeconds);
+        connect(m_cacheItemsCheck, &QCheckBox::toggled,
+                m_node, &IteratorScopeNode::setCacheItemResults);
         connect(m_openButton, &QPushButton::clicked,
                 m_node, &IteratorScopeNode::requestOpenBody);
 
         connect(m_node, &IteratorScopeNode::failurePolicyChanged,
                 this, &IteratorScopePropertiesWidget::setFailurePolicy);
+        connect(m_node, &IteratorScopeNode::maxParallelismChanged,
+                this, &IteratorScopePropertiesWidget::setMaxParallelism);
+        connect(m_node, &IteratorScopeNode::resultOrderChanged,
+                this, &IteratorScopePropertiesWidget::setResultOrder);
+        connect(m_node, &IteratorScopeNode::batchSizeChanged,
+                this, &IteratorScopePropertiesWidget::setBatchSize);
+        connect(m_node, &IteratorScopeNode::budgetChanged,
+                this, &IteratorScopePropertiesWidget::setBudget);
+        connect(m_node, &IteratorScopeNode::cacheItemResultsChanged,
+                this, &IteratorScopePropertiesWidget::setCacheItemResults);
         connect(m_node, &IteratorScopeNode::statusChanged,
                 this, &IteratorScopePropertiesWidget::setStatus,
                 Qt::QueuedConnection);
@@ -63,6 +132,52 @@ void IteratorScopePropertiesWidget::setFailurePolicy(const QString& policy)
     }
 }
 
+void IteratorScopePropertiesWidget::setMaxParallelism(int passes)
+{
+    if (m_parallelismSpin && m_parallelismSpin->value() != passes) {
+        m_parallelismSpin->setValue(passes);
+    }
+}
+
+void IteratorScopePropertiesWidget::setResultOrder(const QString& order)
+{
+    if (!m_resultOrderCombo) {
+        return;
+    }
+    const int index = m_resultOrderCombo->findData(order);
+    if (index >= 0 && index != m_resultOrderCombo->currentIndex()) {
+        m_resultOrderCombo->setCurrentIndex(index);
+    }
+}
+
+void IteratorScopePropertiesWidget::setBatchSize(int items)
+{
+    if (m_batchSizeSpin && m_batchSizeSpin->value() != items) {
+        m_batchSizeSpin->setValue(items);
+    }
+}
+
+void IteratorScopePropertiesWidget::setBudget()
+{
+    if (!m_node) {
+        return;
+    }
+    const ScopeBudget budget = m_node->budget();
+    if (m_maxStepsSpin && m_maxStepsSpin->value() != budget.maxSteps) {
+        m_maxStepsSpin->setValue(budget.maxSteps);
+    }
+    if (m_timeLimitSpin && m_timeLimitSpin->value() != budget.timeLimitSeconds) {
+        m_timeLimitSpin->setValue(budget.timeLimitSeconds);
+    }
+}
+
+void IteratorScopePropertiesWidget::setCacheItemResults(bool enabled)
+{
+    if (m_cacheItemsCheck && m_cacheItemsCheck->isChecked() != enabled) {
+        m_cacheItemsCheck->setChecked(enabled);
+    }
+}
+
 void IteratorScopePropertiesWidget::setStatus(const QString& status)
 {
     if (m_statusLabel) {
@@ -71,3 +186,8 @@ void IteratorScopePropertiesWidget::setStatus(const QString& status)
             : tr("Status: %1").arg(status));
     }
 }
+
+QWidget* IteratorScopeNode::createConfigurationWidget(QWidget* parent)
+{
+    return new IteratorScopePropertiesWidget(this, parent);
+}
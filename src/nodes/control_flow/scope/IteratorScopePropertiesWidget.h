@@ -2,9 +2,11 @@
 
 #include <QWidget>
 
+class QCheckBox;
 class QLabel;
 class QComboBox;
 class QPushButton;
+class QSpinBox;
 class IteratorScopeNode;
 
 class IteratorScopePropertiesWidget : public QWidget {
@@ -16,11 +18,22 @@ public:
 
 public slots:
     void setFailurePolicy(const QString& policy);
+    void setMaxParallelism(int passes);
+    void setResultOrder(const QString& order);
+    void setBatchSize(int items);
+    void setBudget();
+    void setCacheItemResults(bool enabled);
     void setStatus(const QString& status);
 
 private:
     IteratorScopeNode* m_node {nullptr};
     QComboBox* m_failurePolicyCombo {nullptr};
+    QSpinBox* m_parallelismSpin {nullptr};
+    QComboBox* m_resultOrderCombo {nullptr};
+    QSpinBox* m_batchSizeSpin {nullptr};
+    QSpinBox* m_maxStepsSpin {nullptr};
+    QSpinBox* m_timeLimitSpin {nullptr};
+    QCheckBox* m_cacheItemsCheck {nullptr};
     QLabel* m_statusLabel {nullptr};
     QPushButton* m_openButton {nullptr};
 };
@@ -0,0 +1,35 @@
+// Properties panels of the scope body markers: a line saying what each one does
+#include "GetInputNode.h"
+#include "GetItemNode.h"
+#include "SetItemResultNode.h"
+#include "SetOutputNode.h"
+
+#include <QLabel>
+
+QWidget* GetInputNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* label = new QLabel(QObject::tr("Reads the current Transform Scope body input."), parent);
+    label->setWordWrap(true);
+    return label;
+}
+
+QWidget* SetOutputNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* label = new QLabel(QObject::tr("Finishes one Transform Scope body pass. Accepted=false asks the parent scope to retry."), parent);
+    label->setWordWrap(true);
+    return label;
+}
+
+QWidget* GetItemNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* label = new QLabel(QObject::tr("Reads the current Iterator Scope item."), parent);
+    label->setWordWrap(true);
+    return label;
+}
+
+QWidget* SetItemResultNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* label = new QLabel(QObject::tr("Finishes one Iterator Scope body pass and returns the current item's result."), parent);
+    label->setWordWrap(true);
+    return label;
+}
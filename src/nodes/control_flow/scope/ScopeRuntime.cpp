@@ -146,3 +146,52 @@ void scopeMergeMap(QVariantMap& target, const QVariantMap& delta)
         target.insert(it.key(), it.value());
     }
 }
+
+std::shared_ptr<QMutex> ScopeNodeSerializer::mutexFor(const IToolNode* node)
+{
+    QMutexLocker locker(&m_mutex);
+    auto& lock = m_locks[node];
+    if (!lock) {
+        lock = std::make_shared<QMutex>();
+    }
+    return lock;
+}
+
+std::optional<TokenList> ScopeReplayMemo::lookup(const QUuid& node, const QByteArray& signature) const
+{
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_entries.constFind(node);
+    if (it == m_entries.cend() || it->signature != signature) {
+        return std::nullopt;
+    }
+    ++m_replays;
+    return it->outputs;
+}
+
+void ScopeReplayMemo::store(const QUuid& node, const QByteArray& signature, const TokenList& outputs)
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.insert(node, Entry{signature, outputs});
+}
+
+int ScopeReplayMemo::replayCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_replays;
+}
+
+QJsonObject ScopeBudget::toJson() const
+{
+    QJsonObject obj;
+    obj.insert(QStringLiteral("max_steps"), maxSteps);
+    obj.insert(QStringLiteral("time_limit_seconds"), timeLimitSeconds);
+    return obj;
+}
+
+ScopeBudget ScopeBudget::fromJson(const QJsonObject& json)
+{
+    ScopeBudget budget;
+    budget.maxSteps = qBound(1, json.value(QStringLiteral("max_steps")).toInt(kDefaultMaxSteps), kMaxStepsLimit);
+    budget.timeLimitSeconds = qBound(0, json.value(QStringLiteral("time_limit_seconds")).toInt(0), kMaxTimeLimitSeconds);
+    return budget;
+}
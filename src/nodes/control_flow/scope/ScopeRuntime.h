@@ -1,7 +1,11 @@
 #pragma once
 
 #include "CommonDataTypes.h"
+#include "ExecutionToken.h"
 
+#include <QHash>
+#include <QJsonObject>
+#include <QMutex>
 #include <QVariant>
 #include <QVariantList>
 #include <QVariantMap>
@@ -9,24 +13,82 @@
 #include <QString>
 
 #include <functional>
+#include <memory>
+#include <optional>
+
+class IToolNode;
+
+// Shared by the concurrent passes of one scope execution. Body nodes that do not
+// support concurrent runs execute for one pass at a time.
+class ScopeNodeSerializer {
+public:
+    std::shared_ptr<QMutex> mutexFor(const IToolNode* node);
+
+private:
+    QMutex m_mutex;
+    QHash<const IToolNode*, std::shared_ptr<QMutex>> m_locks;
+};
+
+// Shared by the attempts of one Transform Scope execution. Body nodes that report
+// IToolNode::isDeterministic() replay their previous outputs when an attempt feeds
+// them the same inputs as the last one, so a retry only re-runs what changed.
+class ScopeReplayMemo {
+public:
+    std::optional<TokenList> lookup(const QUuid& node, const QByteArray& signature) const;
+    void store(const QUuid& node, const QByteArray& signature, const TokenList& outputs);
+    int replayCount() const;
+
+private:
+    struct Entry {
+        QByteArray signature;
+        TokenList outputs;
+    };
+
+    mutable QMutex m_mutex;
+    QHash<QUuid, Entry> m_entries;
+    mutable int m_replays {0};
+};
 
 enum class ScopeBodyKind {
     Transform,
     Iterator
 };
 
+// Limits for one body pass: node executions, and wall time in seconds (0 = none)
+struct ScopeBudget {
+    static constexpr int kDefaultMaxSteps = 10000;
+    static constexpr int kMaxStepsLimit = 1000000;
+    static constexpr int kMaxTimeLimitSeconds = 86400;
+
+    int maxSteps {kDefaultMaxSteps};
+    int timeLimitSeconds {0};
+
+    QJsonObject toJson() const;
+    static ScopeBudget fromJson(const QJsonObject& json);
+};
+
 struct ScopeFrame {
     QString bodyId;
     ScopeBodyKind kind {ScopeBodyKind::Transform};
     QUuid activationId;
     int attempt {0};
     int index {-1};
+    // Items in an iterator scope; a transform scope's attempt limit
     int count {-1};
+    // Items carried by an iterator pass; above 1 the item is a list slice
+    int batchSize {1};
     QVariant input;
     QVariant item;
     QVariant previousOutput;
     QVariantMap context;
     QVariantList history;
+    // Shared by every attempt of one Transform Scope execution, for Get Input's Conversation
+    QString conversationId;
+    ScopeBudget budget;
+    // Set when passes of the same scope run concurrently; null for sequential passes
+    std::shared_ptr<ScopeNodeSerializer> serializer;
+    // Set by Transform Scope so retry attempts replay unchanged deterministic nodes
+    std::shared_ptr<ScopeReplayMemo> replay;
 };
 
 struct ScopeBodyResult {
@@ -48,6 +110,9 @@ using ScopeBodyRunner = std::function<ScopeBodyResult(const QString& bodyId,
                                                       const ScopeFrame& frame,
                                                       const DataPacket& parentInputs)>;
 
+// Content hash of a body graph (ScopeSubgraphExecutor::fingerprint); empty when unknown
+using ScopeBodyFingerprint = std::function<QByteArray(const QString& bodyId)>;
+
 QString scopeBodyKindToString(ScopeBodyKind kind);
 ScopeBodyKind scopeBodyKindFromString(const QString& value,
                                       ScopeBodyKind fallback = ScopeBodyKind::Transform);
@@ -3,32 +3,293 @@
 #include "NodeGraphModel.h"
 #include "SetItemResultNode.h"
 #include "SetOutputNode.h"
-#include "ToolNodeDelegate.h"
 #include "ExecutionState.h"
+#include "InputSignature.h"
+#include "ExecutionTrace.h"
+#include "RunUsageReport.h"
+#include "Tracer.h"
+#include "CancellationToken.h"
+#include "PartialOutputSink.h"
+#include "ExecutionPlan.h"
+#include "ResultCache.h"
 
 #include <QtNodes/Definitions>
-
 #include <QCryptographicHash>
 #include <QJsonDocument>
+
+#include <QElapsedTimer>
 #include <QQueue>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
 
 namespace {
 struct QueuedExecution {
-    QtNodes::NodeId nodeId {QtNodes::InvalidNodeId};
+    int nodeIndex {-1};
     TokenList inputs;
 };
 
-struct Edge {
-    QtNodes::ConnectionId cid;
-    PinId sourcePin;
-    PinId targetPin;
+// Result of one body node execution, produced on whichever thread ran it
+struct CompletedExecution {
+    int nodeIndex {-1};
+    TokenList inputs;
+    TokenList outputs;
+    QString failure;
+    qint64 startUs {0};
+    qint64 endUs {0};
+    quintptr threadId {0};
+    bool replayed {false};
 };
 
-QByteArray inputSignature(const QVariantMap& input)
-{
-    return QCryptographicHash::hash(QJsonDocument::fromVariant(input).toJson(QJsonDocument::Compact),
-                                    QCryptographicHash::Sha256);
-}
+// Runs ready body nodes concurrently on the global thread pool, each node at most once
+// at a time. The dispatching thread runs a node itself when it is the only work or the
+// pool is saturated, so linear bodies need no hand-off and nested scopes never wait for
+// a pool slot. Completions are handed back to the dispatching thread, which owns the
+// body data lake and all reporting.
+class BodyDispatcher {
+public:
+    BodyDispatcher(const ExecutionPlan& plan, const ScopeFrame& frame, ExecutionTrace* trace,
+                   CancellationToken cancellation)
+        : m_plan(plan)
+        , m_frame(frame)
+        , m_trace(trace)
+        , m_usage(RunUsageCollector::current())
+        , m_itemCache(ResultCache::current())
+        , m_cancellation(std::move(cancellation))
+        , m_tracingContext(Tracer::current())
+        , m_running(plan.nodes().size(), false)
+    {
+    }
+    ~BodyDispatcher() { drain(); }
+    BodyDispatcher(const BodyDispatcher&) = delete;
+    BodyDispatcher& operator=(const BodyDispatcher&) = delete;
+
+    bool isRunning(int nodeIndex) const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_running.at(nodeIndex);
+    }
+
+    int inFlight() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_inFlight;
+    }
+
+    bool hasWork() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_inFlight > 0 || !m_completed.isEmpty();
+    }
+
+    void launch(QueuedExecution item, bool runInline)
+    {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_running[item.nodeIndex] = true;
+            ++m_inFlight;
+        }
+        auto work = [this, item = std::move(item)]() {
+            CompletedExecution done = execute(item);
+            QMutexLocker locker(&m_mutex);
+            m_running[done.nodeIndex] = false;
+            --m_inFlight;
+            m_completed.enqueue(std::move(done));
+            m_changed.wakeAll();
+        };
+        if (runInline) {
+            work();
+            return;
+        }
+        const bool started = QThreadPool::globalInstance()->tryStart([this, work]() {
+            CancellationToken::Scope cancellationScope(m_cancellation);
+            const Tracer::Scope tracingScope(m_tracingContext);
+            const ResultCache::Scope itemCacheScope(m_itemCache);
+            ExecutionTrace::setCurrent(m_trace);
+            RunUsageCollector::setCurrent(m_usage);
+            work();
+            ExecutionTrace::setCurrent(nullptr);
+            RunUsageCollector::setCurrent(nullptr);
+        });
+        if (!started) {
+            work();
+        }
+    }
+
+    // Waits up to timeoutMs for a finished node; false if none finished in time
+    bool takeCompleted(CompletedExecution& done, int timeoutMs)
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_completed.isEmpty() && m_inFlight > 0) {
+            m_changed.wait(&m_mutex, timeoutMs);
+        }
+        if (m_completed.isEmpty()) {
+            return false;
+        }
+        done = m_completed.dequeue();
+        return true;
+    }
+
+    // Node executions cannot be interrupted; early exits wait for the ones in flight
+    void drain()
+    {
+        QMutexLocker locker(&m_mutex);
+        while (m_inFlight > 0) {
+            m_changed.wait(&m_mutex);
+        }
+    }
+
+private:
+    CompletedExecution execute(const QueuedExecution& item) const
+    {
+        CompletedExecution done;
+        done.nodeIndex = item.nodeIndex;
+        done.inputs = item.inputs;
+        const ExecutionPlan::Node& entry = m_plan.node(item.nodeIndex);
+
+        // Deterministic nodes fed the same inputs as in an earlier attempt replay its outputs
+        QByteArray replayKey;
+        if (m_frame.replay && entry.node->isDeterministic()) {
+            QVariantMap payload;
+            for (const auto& token : item.inputs) {
+                for (auto it = token.data.cbegin(); it != token.data.cend(); ++it) {
+                    payload.insert(it.key(), it.value());
+                }
+            }
+            replayKey = InputSignature::compute(payload);
+            if (auto previous = m_frame.replay->lookup(entry.uuid, replayKey)) {
+                done.outputs = std::move(*previous);
+                done.replayed = true;
+                recordUsage(entry, done, 0);
+                done.startUs = done.endUs = m_trace ? m_trace->nowUs() : 0;
+                done.threadId = ExecutionTrace::currentThreadTag();
+                return done;
+            }
+        }
+
+        std::unique_lock<QMutex> nodeGuard;
+        if (m_frame.serializer && !entry.node->supportsConcurrentRuns()) {
+            nodeGuard = std::unique_lock<QMutex>(*m_frame.serializer->mutexFor(entry.node.get()));
+        }
+        done.startUs = m_trace ? m_trace->nowUs() : 0;
+        QElapsedTimer executionTimer;
+        executionTimer.start();
+        Tracer::Span span = Tracer::instance().startSpan(entry.caption);
+        if (span.isRecording()) {
+            span.setAttribute(QStringLiteral("cp.node.id"),
+                              QStringLiteral("%1/%2").arg(m_frame.bodyId, QString::number(entry.nodeId)));
+            span.setAttribute(QStringLiteral("cp.node.type"), entry.name);
+        }
+        const Tracer::Scope tracingScope(span);
+        // Body outputs stay inside the scope; only the scope node itself streams outward
+        const PartialOutputSink::Scope noPartialOutput{PartialOutputSink{}};
+        try {
+            done.outputs = entry.node->execute(item.inputs);
+        } catch (const std::exception& e) {
+            done.failure = QString::fromUtf8(e.what());
+        } catch (...) {
+            done.failure = QStringLiteral("Body node threw an unknown exception.");
+        }
+        if (!done.failure.isEmpty()) {
+            span.setError(done.failure);
+        }
+        done.endUs = m_trace ? m_trace->nowUs() : 0;
+        done.threadId = ExecutionTrace::currentThreadTag();
+        recordUsage(entry, done, executionTimer.nsecsElapsed() / 1000);
+        if (!replayKey.isEmpty() && done.failure.isEmpty()) {
+            m_frame.replay->store(entry.uuid, replayKey, done.outputs);
+        }
+        return done;
+    }
+
+    void recordUsage(const ExecutionPlan::Node& entry, const CompletedExecution& done, qint64 durationUs) const
+    {
+        if (!m_usage) return;
+        m_usage->recordExecution(entry.uuid, QStringLiteral("%1/%2").arg(m_frame.bodyId, QString::number(entry.nodeId)),
+                                 entry.caption.isEmpty() ? entry.name : entry.caption, done.outputs, durationUs,
+                                 !done.failure.isEmpty(), done.replayed);
+    }
+
+    const ExecutionPlan& m_plan;
+    const ScopeFrame& m_frame;
+    ExecutionTrace* m_trace;
+    // Shared by every pass of the body, so a node's passes add up to one entry
+    RunUsageCollector* m_usage;
+    // So nested Iterator Scopes on pool threads find the run's item cache
+    const ResultCache* m_itemCache;
+    const CancellationToken m_cancellation;
+    // The body pass span, for nodes run on pool threads
+    const Tracer::Context m_tracingContext;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_changed;
+    QVector<bool> m_running;
+    int m_inFlight {0};
+    QQueue<CompletedExecution> m_completed;
+};
+
+// Hidden iterator bodies report canvas states for the first, last and every
+// kReportSampleInterval-th pass only; hidden transform bodies for the first two,
+// the last allowed and every kAttemptReportSampleInterval-th attempt
+constexpr int kReportSampleInterval = 100;
+constexpr int kAttemptReportSampleInterval = 10;
+
+// Records the body activation as a span nested under the scope node's own span, in the
+// run's trace and as the current tracing span for the body's nodes
+class BodyTraceSpan {
+public:
+    explicit BodyTraceSpan(const ScopeFrame& frame)
+        : m_trace(ExecutionTrace::current())
+        , m_tracingSpan(Tracer::instance().startSpan(spanName(frame)))
+        , m_tracingScope(m_tracingSpan)
+    {
+        if (m_tracingSpan.isRecording()) {
+            m_tracingSpan.setAttribute(QStringLiteral("cp.scope.body_id"), frame.bodyId);
+            m_tracingSpan.setAttribute(QStringLiteral("cp.scope.kind"), scopeBodyKindToString(frame.kind));
+            m_tracingSpan.setAttribute(frame.kind == ScopeBodyKind::Iterator ? QStringLiteral("cp.scope.index")
+                                                                             : QStringLiteral("cp.scope.attempt"),
+                                       frame.kind == ScopeBodyKind::Iterator ? frame.index : frame.attempt);
+        }
+        if (!m_trace) return;
+        m_span.name = spanName(frame);
+        m_span.category = QStringLiteral("scope");
+        m_span.nodeId = frame.bodyId;
+        m_span.nodeType = scopeBodyKindToString(frame.kind);
+        m_span.startUs = m_trace->nowUs();
+        m_span.threadId = ExecutionTrace::currentThreadTag();
+    }
+    ~BodyTraceSpan()
+    {
+        if (!m_trace) return;
+        m_span.endUs = m_trace->nowUs();
+        m_trace->record(std::move(m_span));
+    }
+    BodyTraceSpan(const BodyTraceSpan&) = delete;
+    BodyTraceSpan& operator=(const BodyTraceSpan&) = delete;
+
+    ExecutionTrace* trace() const { return m_trace; }
+    void setFailed(const QString& reason)
+    {
+        m_span.failed = true;
+        m_tracingSpan.setError(reason);
+    }
+
+private:
+    static QString spanName(const ScopeFrame& frame)
+    {
+        return frame.kind == ScopeBodyKind::Iterator
+            ? QStringLiteral("Iterator body #%1").arg(frame.index)
+            : QStringLiteral("Transform body attempt %1").arg(frame.attempt);
+    }
+
+    ExecutionTrace* m_trace {nullptr};
+    ExecutionTrace::Span m_span;
+    Tracer::Span m_tracingSpan;
+    const Tracer::Scope m_tracingScope;
+};
 
 DataPacket systemFramePacket(const ScopeFrame& frame, const DataPacket& parentInputs)
 {
@@ -38,6 +299,7 @@ DataPacket systemFramePacket(const ScopeFrame& frame, const DataPacket& parentIn
     packet.insert(QStringLiteral("_scope_activation_id"), frame.activationId);
     packet.insert(QStringLiteral("_scope_context"), frame.context);
     packet.insert(QStringLiteral("_scope_history"), frame.history);
+    packet.insert(QStringLiteral("_scope_conversation"), frame.conversationId);
 
     packet.insert(QStringLiteral("_transform_input"), frame.input);
     packet.insert(QStringLiteral("_transform_attempt"), frame.attempt);
@@ -46,6 +308,7 @@ DataPacket systemFramePacket(const ScopeFrame& frame, const DataPacket& parentIn
     packet.insert(QStringLiteral("_iterator_item"), frame.item);
     packet.insert(QStringLiteral("_iterator_index"), frame.index);
     packet.insert(QStringLiteral("_iterator_count"), frame.count);
+    packet.insert(QStringLiteral("_iterator_batch_size"), frame.batchSize);
 
     for (auto it = parentInputs.cbegin(); it != parentInputs.cend(); ++it) {
         packet.insert(QStringLiteral("_parent_%1").arg(it.key()), it.value());
@@ -53,89 +316,68 @@ DataPacket systemFramePacket(const ScopeFrame& frame, const DataPacket& parentIn
     return packet;
 }
 
-bool hasIncoming(NodeGraphModel* graph, QtNodes::NodeId nodeId)
-{
-    const auto connections = graph->allConnectionIds(nodeId);
-    for (const auto& cid : connections) {
-        if (cid.inNodeId == nodeId) {
-            return true;
-        }
+// Forwards body execution states and outputs to the child graph for subcanvas
+// highlighting; a disabled reporter drops them
+class BodyReporter {
+public:
+    BodyReporter(NodeGraphModel* graph, const ExecutionPlan& plan, bool enabled)
+        : m_graph(graph)
+        , m_plan(plan)
+        , m_enabled(enabled)
+    {
     }
-    return false;
-}
 
-QVector<Edge> outgoingEdges(NodeGraphModel* graph, QtNodes::NodeId nodeId)
-{
-    QVector<Edge> edges;
-    const auto connections = graph->allConnectionIds(nodeId);
-    for (const auto& cid : connections) {
-        if (cid.outNodeId != nodeId) {
-            continue;
-        }
-        auto* srcDel = graph->delegateModel<ToolNodeDelegate>(cid.outNodeId);
-        auto* dstDel = graph->delegateModel<ToolNodeDelegate>(cid.inNodeId);
-        if (!srcDel || !dstDel) {
-            continue;
+    static bool shouldReport(const NodeGraphModel* graph, const ScopeFrame& frame)
+    {
+        if (frame.kind == ScopeBodyKind::Transform) {
+            return graph->isExecutionObserved()
+                || frame.attempt < 2
+                || frame.attempt + 1 >= frame.count
+                || frame.attempt % kAttemptReportSampleInterval == 0;
         }
-        const PinId sourcePin = srcDel->pinIdForIndex(QtNodes::PortType::Out, cid.outPortIndex);
-        const PinId targetPin = dstDel->pinIdForIndex(QtNodes::PortType::In, cid.inPortIndex);
-        if (sourcePin.isEmpty() || targetPin.isEmpty()) {
-            continue;
-        }
-        edges.push_back({cid, sourcePin, targetPin});
+        return graph->isExecutionObserved()
+            || frame.index <= 0
+            || frame.index + frame.batchSize >= frame.count
+            || (frame.index / std::max(1, frame.batchSize)) % kReportSampleInterval == 0;
     }
-    return edges;
-}
 
-QVector<Edge> incomingEdges(NodeGraphModel* graph, QtNodes::NodeId nodeId)
-{
-    QVector<Edge> edges;
-    const auto connections = graph->allConnectionIds(nodeId);
-    for (const auto& cid : connections) {
-        if (cid.inNodeId != nodeId) {
-            continue;
-        }
-        auto* srcDel = graph->delegateModel<ToolNodeDelegate>(cid.outNodeId);
-        auto* dstDel = graph->delegateModel<ToolNodeDelegate>(cid.inNodeId);
-        if (!srcDel || !dstDel) {
-            continue;
+    void reset() const
+    {
+        if (!m_enabled) return;
+        for (int index = 0; index < m_plan.nodes().size(); ++index) {
+            node(index, ExecutionState::Idle);
+            m_graph->reportNodeOutput(m_plan.node(index).nodeId, DataPacket{});
         }
-        const PinId sourcePin = srcDel->pinIdForIndex(QtNodes::PortType::Out, cid.outPortIndex);
-        const PinId targetPin = dstDel->pinIdForIndex(QtNodes::PortType::In, cid.inPortIndex);
-        if (sourcePin.isEmpty() || targetPin.isEmpty()) {
-            continue;
-        }
-        edges.push_back({cid, sourcePin, targetPin});
     }
-    return edges;
-}
 
-void reportNode(NodeGraphModel* graph, QtNodes::NodeId nodeId, ExecutionState state)
-{
-    if (graph) {
-        graph->reportNodeExecutionStatus(nodeId, static_cast<int>(state));
+    // Reports the node together with its incoming connections
+    void node(int index, ExecutionState state) const
+    {
+        if (!m_enabled) return;
+        const ExecutionPlan::Node& entry = m_plan.node(index);
+        m_graph->reportNodeExecutionStatus(entry.uuid, static_cast<int>(state));
+        for (const QUuid& connectionUuid : entry.incomingConnectionUuids) {
+            m_graph->reportConnectionExecutionStatus(connectionUuid, static_cast<int>(state));
+        }
     }
-}
 
-void reportIncomingConnections(NodeGraphModel* graph, QtNodes::NodeId nodeId, ExecutionState state)
-{
-    if (!graph) {
-        return;
-    }
-    const auto connections = graph->allConnectionIds(nodeId);
-    for (const auto& cid : connections) {
-        if (cid.inNodeId == nodeId) {
-            graph->reportConnectionExecutionStatus(cid, static_cast<int>(state));
-        }
+    void connection(const ExecutionPlan::Edge& edge, ExecutionState state) const
+    {
+        if (!m_enabled) return;
+        m_graph->reportConnectionExecutionStatus(edge.connectionUuid, static_cast<int>(state));
     }
-}
 
-void reportConnection(NodeGraphModel* graph, const QtNodes::ConnectionId& cid, ExecutionState state)
-{
-    if (graph) {
-        graph->reportConnectionExecutionStatus(cid, static_cast<int>(state));
+    void output(int index, const DataPacket& packet) const
+    {
+        if (!m_enabled) return;
+        m_graph->reportNodeOutput(m_plan.node(index).nodeId, packet);
     }
-}
+
+private:
+    NodeGraphModel* m_graph;
+    const ExecutionPlan& m_plan;
+    bool m_enabled;
+};
 
 ScopeBodyResult transformResultFromMap(const QVariantMap& map)
 {
@@ -187,35 +429,31 @@ ScopeBodyResult ScopeSubgraphExecutor::run(NodeGraphModel* graph,
         result.error = QStringLiteral("Scope body graph is not available.");
         return result;
     }
-    if (graph->allNodeIds().empty()) {
+    // Compiled once per body edit and shared by every pass
+    const std::shared_ptr<const ExecutionPlan> plan = graph->executionPlan();
+    if (plan->nodes().isEmpty()) {
         result.error = kind == ScopeBodyKind::Iterator
             ? QStringLiteral("Iterator body is empty. Add Get Item, body work, and Set Item Result.")
             : QStringLiteral("Transform body is empty. Add Get Input, body work, and Set Output.");
         return result;
     }
 
+    BodyTraceSpan bodySpan(frame);
+    ExecutionTrace* const trace = bodySpan.trace();
+    const BodyReporter report(graph, *plan, BodyReporter::shouldReport(graph, frame));
+
     const DataPacket framePacket = systemFramePacket(frame, parentInputs);
     QQueue<QueuedExecution> queue;
-    QMap<QtNodes::NodeId, QVariantMap> dataLake;
-    QMap<QtNodes::NodeId, QByteArray> lastSignature;
-
-    const auto nodeIds = graph->allNodeIds();
-    for (auto nodeId : nodeIds) {
-        reportNode(graph, nodeId, ExecutionState::Idle);
-        graph->reportNodeOutput(nodeId, DataPacket{});
-        const auto connections = graph->allConnectionIds(nodeId);
-        for (const auto& cid : connections) {
-            if (cid.outNodeId == nodeId) {
-                reportConnection(graph, cid, ExecutionState::Idle);
-            }
-        }
-    }
+    QVector<QVariantMap> dataLake(plan->nodes().size());
+    QVector<QByteArray> lastSignature(plan->nodes().size());
+
+    report.reset();
 
-    for (auto nodeId : nodeIds) {
-        if (!hasIncoming(graph, nodeId)) {
+    for (int index = 0; index < plan->nodes().size(); ++index) {
+        if (!plan->node(index).hasIncoming) {
             ExecutionToken seed;
             seed.data = framePacket;
-            queue.enqueue({nodeId, TokenList{std::move(seed)}});
+            queue.enqueue({index, TokenList{std::move(seed)}});
         }
     }
 
@@ -224,27 +462,90 @@ ScopeBodyResult ScopeSubgraphExecutor::run(NodeGraphModel* graph,
         return result;
     }
 
+    const CancellationToken cancellation = CancellationToken::current();
+    BodyDispatcher dispatcher(*plan, frame, trace, cancellation);
+    const qint64 timeLimitMs = static_cast<qint64>(frame.budget.timeLimitSeconds) * 1000;
+    QElapsedTimer elapsed;
+    elapsed.start();
     int steps = 0;
-    constexpr int kMaxSteps = 1000;
-    while (!queue.isEmpty()) {
-        if (++steps > kMaxSteps) {
-            result.error = QStringLiteral("Scope body exceeded the internal step limit.");
+    // Budgets and cancellation are checked at least this often while nodes run
+    constexpr int kPollIntervalMs = 50;
+
+    for (;;) {
+        if (cancellation.isCancelled()) {
+            result.error = QStringLiteral("Scope body cancelled.");
+            bodySpan.setFailed(result.error);
+            return result;
+        }
+        if (timeLimitMs > 0 && elapsed.elapsed() > timeLimitMs) {
+            result.error = QStringLiteral("Scope body exceeded its time limit of %1 s.")
+                               .arg(frame.budget.timeLimitSeconds);
+            bodySpan.setFailed(result.error);
             return result;
         }
 
-        QueuedExecution item = queue.dequeue();
-        auto* delegate = graph->delegateModel<ToolNodeDelegate>(item.nodeId);
-        if (!delegate || !delegate->node()) {
-            continue;
+        // Start every queued execution whose node is idle, oldest first
+        QVector<QueuedExecution> ready;
+        QVector<bool> picked(plan->nodes().size(), false);
+        for (auto it = queue.begin(); it != queue.end();) {
+            if (!plan->node(it->nodeIndex).node) {
+                it = queue.erase(it);
+            } else if (!picked.at(it->nodeIndex) && !dispatcher.isRunning(it->nodeIndex)) {
+                picked[it->nodeIndex] = true;
+                ready.push_back(std::move(*it));
+                it = queue.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        const bool runInline = ready.size() == 1 && dispatcher.inFlight() == 0;
+        for (QueuedExecution& item : ready) {
+            if (++steps > frame.budget.maxSteps) {
+                result.error = QStringLiteral("Scope body exceeded its step budget of %1 node executions.")
+                                   .arg(frame.budget.maxSteps);
+                bodySpan.setFailed(result.error);
+                return result;
+            }
+            report.node(item.nodeIndex, ExecutionState::Running);
+            dispatcher.launch(std::move(item), runInline);
         }
 
-        reportNode(graph, item.nodeId, ExecutionState::Running);
-        reportIncomingConnections(graph, item.nodeId, ExecutionState::Running);
+        if (!dispatcher.hasWork()) {
+            if (queue.isEmpty()) {
+                break;
+            }
+            continue;
+        }
+        CompletedExecution done;
+        if (!dispatcher.takeCompleted(done, kPollIntervalMs)) {
+            continue;
+        }
 
-        const TokenList outputs = delegate->node()->execute(item.inputs);
+        const ExecutionPlan::Node& entry = plan->node(done.nodeIndex);
+        const TokenList& outputs = done.outputs;
+        if (trace) {
+            ExecutionTrace::Span span;
+            span.name = entry.caption;
+            span.category = done.replayed ? QStringLiteral("scope.replay") : QStringLiteral("scope.node");
+            span.nodeId = QStringLiteral("%1/%2").arg(frame.bodyId, QString::number(entry.nodeId));
+            span.nodeType = entry.name;
+            span.startUs = done.startUs;
+            span.endUs = done.endUs;
+            span.threadId = done.threadId;
+            span.inputBytes = ExecutionTrace::approximateSize(done.inputs);
+            span.outputBytes = ExecutionTrace::approximateSize(outputs);
+            span.failed = !done.failure.isEmpty();
+            trace->record(std::move(span));
+        }
+        if (!done.failure.isEmpty()) {
+            result.error = done.failure;
+            bodySpan.setFailed(result.error);
+            result.status = QStringLiteral("error");
+            report.node(done.nodeIndex, ExecutionState::Error);
+            return result;
+        }
         if (outputs.empty()) {
-            reportNode(graph, item.nodeId, ExecutionState::Finished);
-            reportIncomingConnections(graph, item.nodeId, ExecutionState::Finished);
+            report.node(done.nodeIndex, ExecutionState::Finished);
             continue;
         }
 
@@ -255,8 +556,8 @@ ScopeBodyResult ScopeSubgraphExecutor::run(NodeGraphModel* graph,
             }
         }
         result.lastPacket = merged;
-        dataLake[item.nodeId] = merged;
-        graph->reportNodeOutput(item.nodeId, merged);
+        dataLake[done.nodeIndex] = merged;
+        report.output(done.nodeIndex, merged);
 
         const QVariant terminalValue = kind == ScopeBodyKind::Iterator
             ? merged.value(QString::fromLatin1(SetItemResultNode::kOutputBodyResultId))
@@ -266,67 +567,60 @@ ScopeBodyResult ScopeSubgraphExecutor::run(NodeGraphModel* graph,
                 ? iteratorResultFromMap(scopeVariantToMap(terminalValue))
                 : transformResultFromMap(scopeVariantToMap(terminalValue));
             result.lastPacket = merged;
-            const auto state = result.ok ? ExecutionState::Finished : ExecutionState::Error;
-            reportNode(graph, item.nodeId, state);
-            reportIncomingConnections(graph, item.nodeId, state);
+            report.node(done.nodeIndex, result.ok ? ExecutionState::Finished : ExecutionState::Error);
             return result;
         }
 
         const QString error = merged.value(QStringLiteral("__error")).toString().trimmed();
         if (!error.isEmpty()) {
             result.error = error;
+            bodySpan.setFailed(result.error);
             result.status = QStringLiteral("error");
-            reportNode(graph, item.nodeId, ExecutionState::Error);
-            reportIncomingConnections(graph, item.nodeId, ExecutionState::Error);
+            report.node(done.nodeIndex, ExecutionState::Error);
             return result;
         }
 
-        reportNode(graph, item.nodeId, ExecutionState::Finished);
-        reportIncomingConnections(graph, item.nodeId, ExecutionState::Finished);
+        report.node(done.nodeIndex, ExecutionState::Finished);
 
-        const QVector<Edge> outEdges = outgoingEdges(graph, item.nodeId);
         for (const auto& token : outputs) {
-            for (const Edge& edge : outEdges) {
-                const auto outIt = token.data.constFind(edge.sourcePin);
+            for (int edgeIndex : entry.outEdges) {
+                const ExecutionPlan::Edge& edge = plan->edge(edgeIndex);
+                const auto outIt = token.data.constFind(edge.sourcePinId);
                 if (outIt == token.data.cend()) {
                     continue;
                 }
 
                 QVariantMap inputPayload;
-                inputPayload.insert(edge.targetPin, outIt.value());
+                inputPayload.insert(edge.targetPinId, outIt.value());
 
-                const QVector<Edge> inEdges = incomingEdges(graph, edge.cid.inNodeId);
-                for (const Edge& inEdge : inEdges) {
-                    if (inEdge.targetPin == edge.targetPin) {
+                const ExecutionPlan::Node& target = plan->node(edge.targetIndex);
+                for (int inIndex : target.inEdges) {
+                    const ExecutionPlan::Edge& inEdge = plan->edge(inIndex);
+                    if (inEdge.targetPinId == edge.targetPinId) {
                         continue;
                     }
-                    const QVariantMap bucket = dataLake.value(inEdge.cid.outNodeId);
-                    const QVariant value = bucket.value(inEdge.sourcePin);
+                    const QVariant value = dataLake.at(inEdge.sourceIndex).value(inEdge.sourcePinId);
                     if (value.isValid()) {
-                        inputPayload.insert(inEdge.targetPin, value);
+                        inputPayload.insert(inEdge.targetPinId, value);
                     }
                 }
 
-                auto* targetDelegate = graph->delegateModel<ToolNodeDelegate>(edge.cid.inNodeId);
-                if (!targetDelegate || !targetDelegate->node()) {
-                    continue;
-                }
-                if (!targetDelegate->node()->isReady(inputPayload, inEdges.size())) {
+                if (!target.node || !target.node->isReady(inputPayload, target.inEdges.size())) {
                     continue;
                 }
 
-                const QByteArray signature = inputSignature(inputPayload);
-                if (lastSignature.value(edge.cid.inNodeId) == signature) {
+                const QByteArray signature = InputSignature::compute(inputPayload);
+                if (lastSignature.at(edge.targetIndex) == signature) {
                     continue;
                 }
-                lastSignature.insert(edge.cid.inNodeId, signature);
+                lastSignature[edge.targetIndex] = signature;
 
-                reportConnection(graph, edge.cid, ExecutionState::Finished);
+                report.connection(edge, ExecutionState::Finished);
 
                 ExecutionToken next;
                 next.data = inputPayload;
-                next.triggeringPinId = edge.targetPin;
-                queue.enqueue({edge.cid.inNodeId, TokenList{std::move(next)}});
+                next.triggeringPinId = edge.targetPinId;
+                queue.enqueue({edge.targetIndex, TokenList{std::move(next)}});
             }
         }
     }
@@ -336,3 +630,39 @@ ScopeBodyResult ScopeSubgraphExecutor::run(NodeGraphModel* graph,
         : QStringLiteral("Transform body completed without Set Output.");
     return result;
 }
+
+QByteArray ScopeSubgraphExecutor::fingerprint(NodeGraphModel* graph)
+{
+    if (!graph) {
+        return {};
+    }
+    const std::shared_ptr<const ExecutionPlan> plan = graph->executionPlan();
+    const QVector<ExecutionPlan::Node>& nodes = plan->nodes();
+
+    // Sorted lines so the hash does not depend on the order nodes were added in
+    QList<QByteArray> lines;
+    for (const ExecutionPlan::Node& node : nodes) {
+        const QJsonObject state = node.node ? node.node->saveState() : QJsonObject();
+        QByteArray line = node.uuid.toByteArray(QUuid::WithoutBraces) + ' ' + node.typeId.toUtf8() + ' '
+            + QJsonDocument(state).toJson(QJsonDocument::Compact);
+        const QString nestedId = state.value(QStringLiteral("body_id")).toString();
+        if (!nestedId.isEmpty()) {
+            line += ' ' + fingerprint(graph->subgraph(nestedId)).toHex();
+        }
+        lines.append(line);
+    }
+    for (const ExecutionPlan::Edge& edge : plan->edges()) {
+        lines.append(QByteArrayLiteral("edge ") + nodes.at(edge.sourceIndex).uuid.toByteArray(QUuid::WithoutBraces)
+                     + ':' + edge.sourcePinId.toUtf8() + " -> "
+                     + nodes.at(edge.targetIndex).uuid.toByteArray(QUuid::WithoutBraces) + ':'
+                     + edge.targetPinId.toUtf8());
+    }
+    std::sort(lines.begin(), lines.end());
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    for (const QByteArray& line : lines) {
+        hash.addData(line);
+        hash.addData(QByteArray(1, '\n'));
+    }
+    return hash.result();
+}
@@ -10,4 +10,9 @@ public:
                                ScopeBodyKind kind,
                                const ScopeFrame& frame,
                                const DataPacket& parentInputs);
+
+    // Content hash of a body graph: its nodes' types and saved state, its connections,
+    // and any nested scope bodies. Node positions and runtime status do not count, so
+    // the hash only changes when an edit could change what the body computes.
+    static QByteArray fingerprint(NodeGraphModel* graph);
 };
@@ -2,7 +2,6 @@
 #include "ScopeRuntime.h"
 
 #include <QJsonObject>
-#include <QLabel>
 
 namespace {
 void addInput(NodeDescriptor& desc, const QString& id, const QString& name)
@@ -37,13 +36,6 @@ NodeDescriptor SetItemResultNode::getDescriptor() const
     return desc;
 }
 
-QWidget* SetItemResultNode::createConfigurationWidget(QWidget* parent)
-{
-    auto* label = new QLabel(QObject::tr("Finishes one Iterator Scope body pass and returns the current item's result."), parent);
-    label->setWordWrap(true);
-    return label;
-}
-
 bool SetItemResultNode::isReady(const QVariantMap& inputs, int incomingConnectionsCount) const
 {
     return incomingConnectionsCount > 0 && static_cast<int>(inputs.size()) >= incomingConnectionsCount;
@@ -2,7 +2,6 @@
 #include "ScopeRuntime.h"
 
 #include <QJsonObject>
-#include <QLabel>
 
 namespace {
 void addInput(NodeDescriptor& desc, const QString& id, const QString& name)
@@ -38,13 +37,6 @@ NodeDescriptor SetOutputNode::getDescriptor() const
     return desc;
 }
 
-QWidget* SetOutputNode::createConfigurationWidget(QWidget* parent)
-{
-    auto* label = new QLabel(QObject::tr("Finishes one Transform Scope body pass. Accepted=false asks the parent scope to retry."), parent);
-    label->setWordWrap(true);
-    return label;
-}
-
 bool SetOutputNode::isReady(const QVariantMap& inputs, int incomingConnectionsCount) const
 {
     return incomingConnectionsCount > 0 && static_cast<int>(inputs.size()) >= incomingConnectionsCount;
@@ -1,5 +1,4 @@
 #include "TransformScopeNode.h"
-#include "TransformScopePropertiesWidget.h"
 
 #include <QJsonArray>
 #include <QJsonObject>
@@ -63,11 +62,6 @@ NodeDescriptor TransformScopeNode::getDescriptor() const
     return desc;
 }
 
-QWidget* TransformScopeNode::createConfigurationWidget(QWidget* parent)
-{
-    return new TransformScopePropertiesWidget(this, parent);
-}
-
 bool TransformScopeNode::isReady(const QVariantMap& inputs, int incomingConnectionsCount) const
 {
     Q_UNUSED(incomingConnectionsCount);
@@ -94,12 +88,21 @@ TokenList TransformScopeNode::execute(const TokenList& incomingTokens)
     QString status = QStringLiteral("completed");
     QString message;
 
-    const bool retry = (m_mode == QStringLiteral("retry_until_accepted"));
+    // retry_from_input is Retry Loop in body form: every attempt starts from the
+    // scope's input. retry_until_accepted refines, like Loop Until.
+    const bool fromInput = (m_mode == QStringLiteral("retry_from_input"));
+    const bool retry = fromInput || (m_mode == QStringLiteral("retry_until_accepted"));
     const int limit = retry ? qMax(1, m_maxAttempts) : 1;
+    // Attempts share a memo, so deterministic steps upstream of the failed part replay
+    const auto replay = std::make_shared<ScopeReplayMemo>();
+    const QString conversationId = QUuid::createUuid().toString(QUuid::WithoutBraces);
 
     for (int attempt = 0; attempt < limit; ++attempt) {
         setLastStatus(QStringLiteral("Attempt %1/%2").arg(attempt + 1).arg(limit));
-        const ScopeFrame frame = makeFrame(inputs, currentInput, lastOutput, attempt, context, history);
+        ScopeFrame frame = makeFrame(inputs, currentInput, lastOutput, attempt, context, history);
+        frame.count = limit;
+        frame.conversationId = conversationId;
+        frame.replay = replay;
         ScopeBodyResult body = m_bodyRunner(m_bodyId, ScopeBodyKind::Transform, frame, inputs);
         if (!body.ok) {
             return errorOutput(body.error.isEmpty() ? QStringLiteral("Transform body failed.") : body.error);
@@ -115,7 +118,9 @@ TokenList TransformScopeNode::execute(const TokenList& incomingTokens)
             break;
         }
 
-        currentInput = scopePreferredValue(body.nextInput, lastOutput);
+        if (!fromInput) {
+            currentInput = scopePreferredValue(body.nextInput, lastOutput);
+        }
         status = QStringLiteral("exhausted");
     }
 
@@ -125,6 +130,7 @@ TokenList TransformScopeNode::execute(const TokenList& incomingTokens)
     scopeInfo.insert(QStringLiteral("mode"), m_mode);
     scopeInfo.insert(QStringLiteral("status"), status);
     scopeInfo.insert(QStringLiteral("attempts"), history.size());
+    scopeInfo.insert(QStringLiteral("replayed_nodes"), replay->replayCount());
     scopeInfo.insert(QStringLiteral("message"), message);
     scopeInfo.insert(QStringLiteral("history"), history);
 
@@ -185,6 +191,7 @@ ScopeFrame TransformScopeNode::makeFrame(const DataPacket& inputs,
     frame.previousOutput = previousOutput;
     frame.context = context;
     frame.history = history;
+    frame.budget = m_budget;
     return frame;
 }
 
@@ -194,6 +201,7 @@ QJsonObject TransformScopeNode::saveState() const
     obj.insert(QStringLiteral("body_id"), m_bodyId);
     obj.insert(QStringLiteral("mode"), m_mode);
     obj.insert(QStringLiteral("max_attempts"), m_maxAttempts);
+    obj.insert(QStringLiteral("budget"), m_budget.toJson());
     return obj;
 }
 
@@ -207,6 +215,10 @@ void TransformScopeNode::loadState(const QJsonObject& data)
     if (data.contains(QStringLiteral("max_attempts"))) {
         setMaxAttempts(data.value(QStringLiteral("max_attempts")).toInt(m_maxAttempts));
     }
+    if (data.contains(QStringLiteral("budget"))) {
+        m_budget = ScopeBudget::fromJson(data.value(QStringLiteral("budget")).toObject());
+        emit budgetChanged();
+    }
 }
 
 void TransformScopeNode::setBodyRunner(ScopeBodyRunner runner)
@@ -218,7 +230,8 @@ void TransformScopeNode::setMode(const QString& mode)
 {
     QString normalized = mode.trimmed().toLower();
     if (normalized != QStringLiteral("run_once") &&
-        normalized != QStringLiteral("retry_until_accepted")) {
+        normalized != QStringLiteral("retry_until_accepted") &&
+        normalized != QStringLiteral("retry_from_input")) {
         normalized = QStringLiteral("run_once");
     }
     if (normalized == m_mode) {
@@ -240,6 +253,18 @@ void TransformScopeNode::setMaxAttempts(int value)
     emit maxAttemptsChanged(m_maxAttempts);
 }
 
+void TransformScopeNode::setMaxSteps(int steps)
+{
+    m_budget.maxSteps = qBound(1, steps, ScopeBudget::kMaxStepsLimit);
+    emit budgetChanged();
+}
+
+void TransformScopeNode::setTimeLimitSeconds(int seconds)
+{
+    m_budget.timeLimitSeconds = qBound(0, seconds, ScopeBudget::kMaxTimeLimitSeconds);
+    emit budgetChanged();
+}
+
 void TransformScopeNode::requestOpenBody()
 {
     emit openBodyRequested(m_bodyId, QStringLiteral("Transform Body %1").arg(m_bodyId.left(8)));
@@ -6,6 +6,8 @@
 #include <QObject>
 #include <QString>
 
+class QWidget;
+
 class TransformScopeNode : public QObject, public IToolNode {
     Q_OBJECT
     Q_INTERFACES(IToolNode)
@@ -15,7 +17,8 @@ public:
     ~TransformScopeNode() override = default;
 
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in TransformScopePropertiesWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     bool isReady(const QVariantMap& inputs, int incomingConnectionsCount) const override;
     TokenList execute(const TokenList& incomingTokens) override;
     QJsonObject saveState() const override;
@@ -26,6 +29,7 @@ public:
     QString bodyId() const { return m_bodyId; }
     QString mode() const { return m_mode; }
     int maxAttempts() const { return m_maxAttempts; }
+    ScopeBudget budget() const { return m_budget; }
     QString lastStatus() const { return m_lastStatus; }
 
     static constexpr const char* kInputContextId = "context";
@@ -39,11 +43,15 @@ public:
 public slots:
     void setMode(const QString& mode);
     void setMaxAttempts(int value);
+    // Per-pass body limits; see ScopeBudget
+    void setMaxSteps(int steps);
+    void setTimeLimitSeconds(int seconds);
     void requestOpenBody();
 
 signals:
     void modeChanged(const QString& mode);
     void maxAttemptsChanged(int value);
+    void budgetChanged();
     void statusChanged(const QString& status);
     void openBodyRequested(const QString& bodyId, const QString& title);
 
@@ -61,6 +69,7 @@ private:
     QString m_bodyId;
     QString m_mode {QStringLiteral("run_once")};
     int m_maxAttempts {3};
+    ScopeBudget m_budget;
     QString m_lastStatus;
     ScopeBodyRunner m_bodyRunner;
 };
@@ -1,6 +1,7 @@
 #include "TransformScopePropertiesWidget.h"
 
 #include "TransformScopeNode.h"
+#include "ScopeRuntime.h"
 
 #include <QComboBox>
 #include <QFormLayout>
@@ -19,12 +20,25 @@ TransformScopePropertiesWidget::TransformScopePropertiesWidget(TransformScopeNod
     m_modeCombo = new QComboBox(this);
     m_modeCombo->addItem(tr("Run once"), QStringLiteral("run_once"));
     m_modeCombo->addItem(tr("Retry until accepted"), QStringLiteral("retry_until_accepted"));
+    m_modeCombo->addItem(tr("Retry from the input until accepted"), QStringLiteral("retry_from_input"));
     form->addRow(tr("Mode"), m_modeCombo);
 
     m_maxAttemptsSpin = new QSpinBox(this);
     m_maxAttemptsSpin->setRange(1, 1000);
     form->addRow(tr("Max attempts"), m_maxAttemptsSpin);
 
+    m_maxStepsSpin = new QSpinBox(this);
+    m_maxStepsSpin->setRange(1, ScopeBudget::kMaxStepsLimit);
+    m_maxStepsSpin->setToolTip(tr("Body node executions allowed per pass."));
+    form->addRow(tr("Step budget"), m_maxStepsSpin);
+
+    m_timeLimitSpin = new QSpinBox(this);
+    m_timeLimitSpin->setRange(0, ScopeBudget::kMaxTimeLimitSeconds);
+    m_timeLimitSpin->setSuffix(tr(" s"));
+    m_timeLimitSpin->setSpecialValueText(tr("No limit"));
+    m_timeLimitSpin->setToolTip(tr("Wall time allowed per pass, checked between body node executions."));
+    form->addRow(tr("Time limit"), m_timeLimitSpin);
+
     layout->addLayout(form);
 
     m_openButton = new QPushButton(tr("Open Body"), this);
@@ -38,6 +52,7 @@ TransformScopePropertiesWidget::TransformScopePropertiesWidget(TransformScopeNod
     if (m_node) {
         setMode(m_node->mode());
         setMaxAttempts(m_node->maxAttempts());
+        setBudget();
         setStatus(m_node->lastStatus());
 
         connect(m_modeCombo, &QComboBox::currentIndexChanged, this, [this](int index) {
@@ -48,6 +63,10 @@ TransformScopePropertiesWidget::TransformScopePropertiesWidget(TransformScopeNod
         });
         connect(m_maxAttemptsSpin, &QSpinBox::valueChanged,
                 m_node, &TransformScopeNode::setMaxAttempts);
+        connect(m_maxStepsSpin, &QSpinBox::valueChanged,
+                m_node, &TransformScopeNode::setMaxSteps);
+        connect(m_timeLimitSpin, &QSpinBox::valueChanged,
+                m_node, &TransformScopeNode::setTimeLimitSeconds);
         connect(m_openButton, &QPushButton::clicked,
                 m_node, &TransformScopeNode::requestOpenBody);
 
@@ -55,6 +74,8 @@ TransformScopePropertiesWidget::TransformScopePropertiesWidget(TransformScopeNod
                 this, &TransformScopePropertiesWidget::setMode);
         connect(m_node, &TransformScopeNode::maxAttemptsChanged,
                 this, &TransformScopePropertiesWidget::setMaxAttempts);
+        connect(m_node, &TransformScopeNode::budgetChanged,
+                this, &TransformScopePropertiesWidget::setBudget);
         connect(m_node, &TransformScopeNode::statusChanged,
                 this, &TransformScopePropertiesWidget::setStatus,
                 Qt::QueuedConnection);
@@ -79,6 +100,20 @@ void TransformScopePropertiesWidget::setMaxAttempts(int value)
     }
 }
 
+void TransformScopePropertiesWidget::setBudget()
+{
+    if (!m_node) {
+        return;
+    }
+    const ScopeBudget budget = m_node->budget();
+    if (m_maxStepsSpin && m_maxStepsSpin->value() != budget.maxSteps) {
+        m_maxStepsSpin->setValue(budget.maxSteps);
+    }
+    if (m_timeLimitSpin && m_timeLimitSpin->value() != budget.timeLimitSeconds) {
+        m_timeLimitSpin->setValue(budget.timeLimitSeconds);
+    }
+}
+
 void TransformScopePropertiesWidget::setStatus(const QString& status)
 {
     if (m_statusLabel) {
@@ -87,3 +122,8 @@ void TransformScopePropertiesWidget::setStatus(const QString& status)
             : tr("Status: %1").arg(status));
     }
 }
+
+QWidget* TransformScopeNode::createConfigurationWidget(QWidget* parent)
+{
+    return new TransformScopePropertiesWidget(this, parent);
+}
@@ -18,12 +18,15 @@ public:
 public slots:
     void setMode(const QString& mode);
     void setMaxAttempts(int value);
+    void setBudget();
     void setStatus(const QString& status);
 
 private:
     TransformScopeNode* m_node {nullptr};
     QComboBox* m_modeCombo {nullptr};
     QSpinBox* m_maxAttemptsSpin {nullptr};
+    QSpinBox* m_maxStepsSpin {nullptr};
+    QSpinBox* m_timeLimitSpin {nullptr};
     QLabel* m_statusLabel {nullptr};
     QPushButton* m_openButton {nullptr};
 };
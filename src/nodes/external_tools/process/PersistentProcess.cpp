@@ -0,0 +1,178 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "PersistentProcess.h"
+#include "CancellationToken.h"
+
+#include <QElapsedTimer>
+#include <QMetaObject>
+#include <QObject>
+#include <QProcess>
+#include <QThread>
+
+#include "Logger.h"
+
+namespace {
+
+constexpr int kStartTimeoutMs = 10000;
+// stdin is handed to the pipe in slices so a large item is not buffered twice
+constexpr qint64 kWriteSliceBytes = 64 * 1024;
+
+} // namespace
+
+PersistentProcess::PersistentProcess()
+    : m_thread(std::make_unique<QThread>())
+    , m_context(new QObject)
+{
+    m_thread->setObjectName(QStringLiteral("PersistentProcess"));
+    m_context->moveToThread(m_thread.get());
+    QObject::connect(m_thread.get(), &QThread::finished, m_context, &QObject::deleteLater);
+    m_thread->start();
+}
+
+PersistentProcess::~PersistentProcess()
+{
+    stop();
+    m_thread->quit();
+    m_thread->wait();
+}
+
+PersistentProcess::Exchange PersistentProcess::exchange(const QString& command, const QStringList& records,
+                                                        const QByteArray& delimiter, int timeoutMs)
+{
+    Exchange result;
+    const CancellationToken cancellation = CancellationToken::current();
+    QMetaObject::invokeMethod(m_context, [&]() {
+        if (m_process && (m_command != command || m_process->state() != QProcess::Running)) {
+            shutDown();
+        }
+        if (!m_process) {
+            QStringList args = QProcess::splitCommand(command);
+            if (args.isEmpty()) {
+                result.error = QStringLiteral("ERROR: Invalid command: '") + command + QStringLiteral("'");
+                return;
+            }
+            const QString program = args.takeFirst();
+            auto process = std::make_unique<QProcess>();
+            process->setProcessChannelMode(QProcess::SeparateChannels);
+            process->start(program, args);
+            if (!process->waitForStarted(kStartTimeoutMs)) {
+                result.error = QStringLiteral("Failed to start process: ") + process->errorString();
+                return;
+            }
+            m_process = std::move(process);
+            m_command = command;
+        }
+
+        QByteArray input;
+        for (const QString& record : records) {
+            input += record.toUtf8();
+            input += delimiter;
+        }
+
+        const auto takeRecords = [&]() {
+            m_pending += m_process->readAllStandardOutput();
+            qsizetype end = 0;
+            while (result.records.size() < records.size() && (end = m_pending.indexOf(delimiter)) >= 0) {
+                QByteArray record = m_pending.left(end);
+                if (delimiter == "\n" && record.endsWith('\r')) {
+                    record.chop(1);
+                }
+                result.records.append(QString::fromUtf8(record));
+                m_pending.remove(0, end + delimiter.size());
+            }
+            return result.records.size() == records.size();
+        };
+
+        qsizetype written = 0;
+        QElapsedTimer waited;
+        waited.start();
+        while (!takeRecords()) {
+            if (written < input.size() && m_process->bytesToWrite() < kWriteSliceBytes) {
+                const qint64 slice = qMin<qint64>(kWriteSliceBytes, input.size() - written);
+                m_process->write(input.constData() + written, slice);
+                written += slice;
+            }
+            if (m_process->state() != QProcess::Running) {
+                if (takeRecords()) {
+                    break;
+                }
+                const QString stderrText = QString::fromUtf8(m_process->readAllStandardError()).trimmed();
+                result.error = QStringLiteral("Process exited with code %1: %2")
+                                   .arg(m_process->exitCode())
+                                   .arg(stderrText.isEmpty() ? m_process->errorString() : stderrText);
+                break;
+            }
+            if (cancellation.isCancelled()) {
+                result.error = QStringLiteral("Process cancelled");
+                break;
+            }
+            if (waited.elapsed() >= timeoutMs) {
+                result.error = QStringLiteral("Process timed out");
+                break;
+            }
+            // Short slices so that stopping the run is noticed right away
+            if (m_process->bytesToWrite() > 0) {
+                m_process->waitForBytesWritten(100);
+            } else {
+                m_process->waitForReadyRead(100);
+            }
+        }
+
+        result.stderrText += QString::fromUtf8(m_process->readAllStandardError());
+        if (!result.error.isEmpty()) {
+            CP_WARN << "PersistentProcess:" << result.error << ", stopping" << m_command;
+            shutDown();
+        }
+    }, Qt::BlockingQueuedConnection);
+    return result;
+}
+
+void PersistentProcess::stop()
+{
+    QMetaObject::invokeMethod(m_context, [this]() { shutDown(); }, Qt::BlockingQueuedConnection);
+}
+
+qint64 PersistentProcess::processId() const
+{
+    qint64 id = 0;
+    QMetaObject::invokeMethod(m_context, [this, &id]() {
+        id = m_process ? m_process->processId() : 0;
+    }, Qt::BlockingQueuedConnection);
+    return id;
+}
+
+void PersistentProcess::shutDown()
+{
+    if (m_process) {
+        // Closing stdin lets a filter finish on its own
+        m_process->closeWriteChannel();
+        if (!m_process->waitForFinished(1000)) {
+            m_process->kill();
+            m_process->waitForFinished();
+        }
+        m_process.reset();
+    }
+    m_command.clear();
+    m_pending.clear();
+}
@@ -0,0 +1,79 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+#include <memory>
+
+class QObject;
+class QProcess;
+class QThread;
+
+// One long-running filter process kept alive across executions.
+//
+// Records go to the filter's stdin, each followed by the delimiter, and the same
+// number of delimited records is read back, so the filter must answer every record
+// with exactly one and flush as it goes (`cat`, `sed -u`, `jq -c --unbuffered`).
+// The process lives on a private thread because a QProcess can only be driven from
+// the thread that made it, while a node's executions land on any worker. It is
+// started on first use, restarted when the command changes, and stopped after an
+// exchange fails or times out, so the next one starts a fresh filter.
+class PersistentProcess {
+public:
+    struct Exchange {
+        QStringList records;
+        QString stderrText;
+        QString error;
+    };
+
+    PersistentProcess();
+    ~PersistentProcess();
+
+    PersistentProcess(const PersistentProcess&) = delete;
+    PersistentProcess& operator=(const PersistentProcess&) = delete;
+
+    // Sends records and waits for as many replies. Honours CancellationToken::current().
+    Exchange exchange(const QString& command, const QStringList& records, const QByteArray& delimiter,
+                      int timeoutMs);
+
+    // Ends the filter; the next exchange starts it again.
+    void stop();
+
+    // Process id of the running filter, or 0
+    qint64 processId() const;
+
+private:
+    // Runs on m_thread
+    void shutDown();
+
+    std::unique_ptr<QThread> m_thread;
+    QObject* m_context {nullptr};
+    // Touched only on m_thread
+    std::unique_ptr<QProcess> m_process;
+    QString m_command;
+    QByteArray m_pending;
+};
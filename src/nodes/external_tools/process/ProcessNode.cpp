@@ -22,14 +22,75 @@
 // SOFTWARE.
 //
 #include "ProcessNode.h"
-#include "ProcessPropertiesWidget.h"
+#include "PersistentProcess.h"
 
 #include <QJsonObject>
 #include <QtConcurrent/QtConcurrent>
 #include "Logger.h"
+#include "CancellationToken.h"
+#include "PartialOutputSink.h"
 
+#include <QElapsedTimer>
 #include <QProcess>
 
+namespace {
+
+// stdin is handed to the pipe in slices so a large item is not buffered twice
+constexpr qint64 kWriteSliceBytes = 64 * 1024;
+
+// A list on stdin is written one element per record, text as it is
+QByteArray stdinBytes(const QVariant& value, const QByteArray& delimiter)
+{
+    if (value.typeId() != QMetaType::QVariantList && value.typeId() != QMetaType::QStringList) {
+        return value.toString().toUtf8();
+    }
+    QByteArray bytes;
+    for (const QVariant& element : value.toList()) {
+        bytes += element.toString().toUtf8();
+        bytes += delimiter;
+    }
+    return bytes;
+}
+
+// The records a persistent filter is sent: list elements, or the text split at the delimiter
+QStringList stdinRecords(const QVariant& value, const QByteArray& delimiter)
+{
+    if (value.typeId() == QMetaType::QVariantList || value.typeId() == QMetaType::QStringList) {
+        return value.toStringList();
+    }
+    QStringList records = value.toString().split(QString::fromUtf8(delimiter));
+    if (records.size() > 1 && records.last().isEmpty()) {
+        records.removeLast();
+    }
+    return records;
+}
+
+QString recordText(QByteArray record, const QByteArray& delimiter)
+{
+    if (delimiter == "\n" && record.endsWith('\r')) {
+        record.chop(1);
+    }
+    return QString::fromUtf8(record);
+}
+
+// Forced so that equal consecutive lines still reach downstream nodes
+ExecutionToken lineToken(const QString& line)
+{
+    ExecutionToken token;
+    token.data.insert(QString::fromLatin1(ProcessNode::kOutLine), line);
+    token.forceExecution = true;
+    return token;
+}
+
+} // namespace
+
+ProcessNode::ProcessNode(QObject* parent)
+    : QObject(parent)
+{
+}
+
+ProcessNode::~ProcessNode() = default;
+
 NodeDescriptor ProcessNode::getDescriptor() const
 {
     NodeDescriptor desc;
@@ -62,20 +123,15 @@ NodeDescriptor ProcessNode::getDescriptor() const
     out2.type = QStringLiteral("text");
     desc.outputPins.insert(out2.id, out2);
 
-    return desc;
-}
+    // Output pin: line (text), one token per stdout record when streaming
+    PinDefinition out3;
+    out3.direction = PinDirection::Output;
+    out3.id = QString::fromLatin1(kOutLine);
+    out3.name = QStringLiteral("line");
+    out3.type = QStringLiteral("text");
+    desc.outputPins.insert(out3.id, out3);
 
-QWidget* ProcessNode::createConfigurationWidget(QWidget* parent)
-{
-    if (!propertiesWidget) {
-        propertiesWidget = new ProcessPropertiesWidget(parent);
-        // initialize UI from current state
-        propertiesWidget->setCommand(m_command);
-        // connect UI -> node
-        QObject::connect(propertiesWidget, &ProcessPropertiesWidget::commandChanged,
-                         this, &ProcessNode::onCommandChanged);
-    }
-    return propertiesWidget;
+    return desc;
 }
 
 TokenList ProcessNode::execute(const TokenList& incomingTokens)
@@ -89,10 +145,46 @@ TokenList ProcessNode::execute(const TokenList& incomingTokens)
     }
 
     // Gather stdin from inputs (optional)
-    const QString stdinText = inputs.value(QString::fromLatin1(kInStdin)).toString();
+    const QVariant stdinValue = inputs.value(QString::fromLatin1(kInStdin));
     const QString command = m_command.trimmed();
+    const QByteArray delimiter = delimiterBytes(m_delimiter);
+    const bool stream = m_streamOutput;
+    const PartialOutputSink sink = PartialOutputSink::current();
 
-    QFuture<DataPacket> fut = QtConcurrent::run([stdinText, command]() -> DataPacket {
+    if (m_persistent && !command.isEmpty()) {
+        if (!m_persistentProcess) {
+            m_persistentProcess = std::make_unique<PersistentProcess>();
+        }
+        const PersistentProcess::Exchange exchange =
+            m_persistentProcess->exchange(command, stdinRecords(stdinValue, delimiter), delimiter, 60000);
+
+        DataPacket packet;
+        if (!exchange.error.isEmpty()) {
+            packet.insert(QString::fromLatin1(kOutStdout), QString());
+            packet.insert(QString::fromLatin1(kOutStderr), exchange.error);
+            packet.insert(QStringLiteral("__error"), exchange.error);
+        } else {
+            packet.insert(QString::fromLatin1(kOutStdout), exchange.records.join(QString::fromUtf8(delimiter)));
+            packet.insert(QString::fromLatin1(kOutStderr), exchange.stderrText);
+            if (stream) {
+                TokenList lines;
+                for (const QString& record : exchange.records) {
+                    lines.push_back(lineToken(record));
+                }
+                sink.publish(lines);
+            }
+        }
+
+        ExecutionToken token;
+        token.data = packet;
+        TokenList result;
+        result.push_back(std::move(token));
+        return result;
+    }
+
+    const QByteArray input = stdinBytes(stdinValue, delimiter);
+    QFuture<DataPacket> fut = QtConcurrent::run([input, command, delimiter, stream, sink,
+                                                 cancellation = CancellationToken::current()]() -> DataPacket {
         DataPacket packet;
         const QString outKey = QString::fromLatin1(kOutStdout);
         const QString errKey = QString::fromLatin1(kOutStderr);
@@ -138,29 +230,77 @@ TokenList ProcessNode::execute(const TokenList& incomingTokens)
             return packet;
         }
 
-        // Feed stdin (if any) and close write channel to signal EOF
-        if (!stdinText.isEmpty()) {
-            const QByteArray bytes = stdinText.toUtf8();
-            proc.write(bytes);
-        }
-        proc.closeWriteChannel();
+        // Feed stdin a slice at a time as the child drains it, then close the write
+        // channel to signal EOF
+        qsizetype written = 0;
+        bool closed = false;
+        const auto feed = [&]() {
+            if (written < input.size() && proc.bytesToWrite() < kWriteSliceBytes) {
+                const qint64 slice = qMin<qint64>(kWriteSliceBytes, input.size() - written);
+                proc.write(input.constData() + written, slice);
+                written += slice;
+            }
+            if (written == input.size() && !closed) {
+                proc.closeWriteChannel();
+                closed = true;
+            }
+        };
+
+        // Streaming: complete stdout records go out on the line pin as they arrive and
+        // only the unfinished one is held
+        QByteArray pending;
+        int lineCount = 0;
+        const auto drain = [&](bool atEnd) {
+            pending += proc.readAllStandardOutput();
+            TokenList lines;
+            qsizetype end = 0;
+            while ((end = pending.indexOf(delimiter)) >= 0) {
+                lines.push_back(lineToken(recordText(pending.left(end), delimiter)));
+                pending.remove(0, end + delimiter.size());
+            }
+            if (atEnd && !pending.isEmpty()) {
+                lines.push_back(lineToken(recordText(pending, delimiter)));
+                pending.clear();
+            }
+            lineCount += static_cast<int>(lines.size());
+            sink.publish(lines);
+        };
 
-        // Wait for process to finish (60s default to mirror other nodes)
-        if (!proc.waitForFinished(60000)) {
-            CP_WARN << "ProcessNode: process timeout, killing...";
+        // Wait for process to finish (60s default to mirror other nodes), in short slices
+        // so that stopping the run kills the child right away
+        QElapsedTimer waited;
+        waited.start();
+        feed();
+        while (proc.state() != QProcess::NotRunning && !cancellation.isCancelled() && waited.elapsed() < 60000) {
+            if (stream) {
+                proc.waitForReadyRead(100);
+                drain(false);
+            } else {
+                proc.waitForFinished(100);
+            }
+            feed();
+        }
+        if (proc.state() != QProcess::NotRunning) {
+            const QString msg = cancellation.isCancelled() ? QStringLiteral("Process cancelled")
+                                                           : QStringLiteral("Process timed out");
+            CP_WARN << "ProcessNode:" << msg << ", killing...";
             proc.kill();
             proc.waitForFinished();
             packet.insert(outKey, QString());
-            packet.insert(errKey, QStringLiteral("Process timed out"));
-            packet.insert(QStringLiteral("__error"), QStringLiteral("Process timed out"));
+            packet.insert(errKey, msg);
+            packet.insert(QStringLiteral("__error"), msg);
             return packet;
         }
 
-        const QString stdoutStr = QString::fromUtf8(proc.readAllStandardOutput());
         const QString stderrStr = QString::fromUtf8(proc.readAllStandardError());
         const int exitCode = proc.exitCode();
 
-        packet.insert(outKey, stdoutStr);
+        if (stream) {
+            drain(true);
+            packet.insert(QStringLiteral("_line_count"), lineCount);
+        } else {
+            packet.insert(outKey, QString::fromUtf8(proc.readAllStandardOutput()));
+        }
         packet.insert(errKey, stderrStr);
         packet.insert(QStringLiteral("_exit_code"), exitCode);
         if (proc.exitStatus() != QProcess::NormalExit || exitCode != 0) {
@@ -182,10 +322,25 @@ TokenList ProcessNode::execute(const TokenList& incomingTokens)
     return result;
 }
 
+QByteArray ProcessNode::delimiterBytes(const QString& delimiter)
+{
+    if (delimiter.isEmpty()) {
+        return QByteArrayLiteral("\n");
+    }
+    QString decoded = delimiter;
+    decoded.replace(QLatin1String("\\n"), QStringLiteral("\n"));
+    decoded.replace(QLatin1String("\\t"), QStringLiteral("\t"));
+    decoded.replace(QLatin1String("\\0"), QString(QChar(u'\0')));
+    return decoded.toUtf8();
+}
+
 QJsonObject ProcessNode::saveState() const
 {
     QJsonObject state;
     state.insert(QStringLiteral("command"), m_command);
+    state.insert(QStringLiteral("streamOutput"), m_streamOutput);
+    state.insert(QStringLiteral("persistent"), m_persistent);
+    state.insert(QStringLiteral("delimiter"), m_delimiter);
     return state;
 }
 
@@ -193,10 +348,17 @@ void ProcessNode::loadState(const QJsonObject& state)
 {
     if (state.contains(QStringLiteral("command"))) {
         m_command = state.value(QStringLiteral("command")).toString();
-        if (propertiesWidget) {
-            propertiesWidget->setCommand(m_command);
-        }
     }
+    if (state.value(QStringLiteral("streamOutput")).isBool()) {
+        m_streamOutput = state.value(QStringLiteral("streamOutput")).toBool();
+    }
+    if (state.value(QStringLiteral("persistent")).isBool()) {
+        m_persistent = state.value(QStringLiteral("persistent")).toBool();
+    }
+    if (state.value(QStringLiteral("delimiter")).isString()) {
+        m_delimiter = state.value(QStringLiteral("delimiter")).toString();
+    }
+    emit stateLoaded();
 }
 
 void ProcessNode::onCommandChanged(const QString &newCommand)
@@ -204,3 +366,23 @@ void ProcessNode::onCommandChanged(const QString &newCommand)
     if (m_command == newCommand) return;
     m_command = newCommand;
 }
+
+void ProcessNode::onStreamOutputChanged(bool stream)
+{
+    m_streamOutput = stream;
+}
+
+void ProcessNode::onPersistentChanged(bool persistent)
+{
+    if (m_persistent == persistent) return;
+    m_persistent = persistent;
+    // A filter left running would keep its state for when the mode comes back
+    if (!m_persistent) {
+        m_persistentProcess.reset();
+    }
+}
+
+void ProcessNode::onDelimiterChanged(const QString& delimiter)
+{
+    m_delimiter = delimiter;
+}
@@ -24,42 +24,61 @@
 #pragma once
 
 #include <QObject>
-#include <QWidget>
 #include <QFuture>
 #include <QString>
 #include <QJsonObject>
 
+#include <memory>
+
 #include "IToolNode.h"
 #include "CommonDataTypes.h"
 
-class ProcessPropertiesWidget;
+class PersistentProcess;
+class QWidget;
 
 class ProcessNode : public QObject, public IToolNode {
     Q_OBJECT
     Q_INTERFACES(IToolNode)
 public:
-    explicit ProcessNode(QObject* parent = nullptr)
-        : QObject(parent)
-    {}
-    ~ProcessNode() override = default;
+    explicit ProcessNode(QObject* parent = nullptr);
+    ~ProcessNode() override;
 
     // IToolNode interface
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in ProcessPropertiesWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     TokenList execute(const TokenList& incomingTokens) override;
+    ResourceClass resourceClass() const override { return ResourceClass::Process; }
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
 
+signals:
+    // The settings were replaced by loadState()
+    void stateLoaded();
+
 public slots:
     void onCommandChanged(const QString &newCommand);
+    void onStreamOutputChanged(bool stream);
+    void onPersistentChanged(bool persistent);
+    void onDelimiterChanged(const QString& delimiter);
 
 private:
-    ProcessPropertiesWidget *propertiesWidget = nullptr;
     QString m_command;
+    // Publish each stdout record on the line pin as it arrives instead of buffering stdout
+    bool m_streamOutput {false};
+    // Keep one filter process alive across executions, one reply record per input record
+    bool m_persistent {false};
+    // Record separator as typed, with \n, \t and \0 escapes; empty means a newline
+    QString m_delimiter {QStringLiteral("\\n")};
+    std::unique_ptr<PersistentProcess> m_persistentProcess;
 
 public:
     // Pin IDs
     static constexpr const char* kInStdin = "stdin";
     static constexpr const char* kOutStdout = "stdout";
     static constexpr const char* kOutStderr = "stderr";
+    static constexpr const char* kOutLine = "line";
+
+    // Decodes a delimiter as stored in the node state
+    static QByteArray delimiterBytes(const QString& delimiter);
 };
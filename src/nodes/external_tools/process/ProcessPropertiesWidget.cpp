@@ -22,8 +22,10 @@
 // SOFTWARE.
 //
 #include "ProcessPropertiesWidget.h"
+#include "ProcessNode.h"
 
 #include <QVBoxLayout>
+#include <QCheckBox>
 #include <QLabel>
 #include <QLineEdit>
 #include <QSignalBlocker>
@@ -43,11 +45,32 @@ ProcessPropertiesWidget::ProcessPropertiesWidget(QWidget* parent)
     commandLineEdit->setPlaceholderText(tr("Enter command line (e.g., /usr/bin/python3 script.py --arg)")); 
     layout->addWidget(commandLineEdit);
 
+    streamCheckBox = new QCheckBox(tr("Stream stdout records to the line pin"), this);
+    layout->addWidget(streamCheckBox);
+
+    persistentCheckBox = new QCheckBox(tr("Keep the process running across items"), this);
+    persistentCheckBox->setToolTip(tr("The command must answer each input record with one output record"));
+    layout->addWidget(persistentCheckBox);
+
+    auto* delimiterLabel = new QLabel(tr("Record delimiter:"), this);
+    layout->addWidget(delimiterLabel);
+
+    delimiterLineEdit = new QLineEdit(this);
+    delimiterLineEdit->setText(QStringLiteral("\\n"));
+    delimiterLineEdit->setPlaceholderText(tr("\\n, \\t, \\0 or any text"));
+    layout->addWidget(delimiterLineEdit);
+
     layout->addStretch();
 
     // Forward edits to our signal
     QObject::connect(commandLineEdit, &QLineEdit::textChanged,
                      this, &ProcessPropertiesWidget::commandChanged);
+    QObject::connect(streamCheckBox, &QCheckBox::toggled,
+                     this, &ProcessPropertiesWidget::streamOutputChanged);
+    QObject::connect(persistentCheckBox, &QCheckBox::toggled,
+                     this, &ProcessPropertiesWidget::persistentChanged);
+    QObject::connect(delimiterLineEdit, &QLineEdit::textChanged,
+                     this, &ProcessPropertiesWidget::delimiterChanged);
 }
 
 QString ProcessPropertiesWidget::getCommand() const
@@ -70,3 +93,64 @@ void ProcessPropertiesWidget::setCommand(const QString& command)
     // Explicitly emit our signal to propagate programmatic changes to listeners (e.g., ProcessNode)
     emit commandChanged(command);
 }
+
+void ProcessPropertiesWidget::setStreamOutput(bool stream)
+{
+    if (!streamCheckBox || streamCheckBox->isChecked() == stream)
+        return;
+
+    {
+        QSignalBlocker blocker(streamCheckBox);
+        streamCheckBox->setChecked(stream);
+    }
+    emit streamOutputChanged(stream);
+}
+
+void ProcessPropertiesWidget::setPersistent(bool persistent)
+{
+    if (!persistentCheckBox || persistentCheckBox->isChecked() == persistent)
+        return;
+
+    {
+        QSignalBlocker blocker(persistentCheckBox);
+        persistentCheckBox->setChecked(persistent);
+    }
+    emit persistentChanged(persistent);
+}
+
+void ProcessPropertiesWidget::setDelimiter(const QString& delimiter)
+{
+    if (!delimiterLineEdit || delimiterLineEdit->text() == delimiter)
+        return;
+
+    {
+        QSignalBlocker blocker(delimiterLineEdit);
+        delimiterLineEdit->setText(delimiter);
+    }
+    emit delimiterChanged(delimiter);
+}
+
+QWidget* ProcessNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* widget = new ProcessPropertiesWidget(parent);
+    const auto showState = [this, widget]() {
+        widget->setCommand(m_command);
+        widget->setStreamOutput(m_streamOutput);
+        widget->setPersistent(m_persistent);
+        widget->setDelimiter(m_delimiter);
+    };
+    // initialize UI from current state
+    showState();
+    // connect UI -> node
+    QObject::connect(widget, &ProcessPropertiesWidget::commandChanged,
+                     this, &ProcessNode::onCommandChanged);
+    QObject::connect(widget, &ProcessPropertiesWidget::streamOutputChanged,
+                     this, &ProcessNode::onStreamOutputChanged);
+    QObject::connect(widget, &ProcessPropertiesWidget::persistentChanged,
+                     this, &ProcessNode::onPersistentChanged);
+    QObject::connect(widget, &ProcessPropertiesWidget::delimiterChanged,
+                     this, &ProcessNode::onDelimiterChanged);
+    // node -> UI after a pipeline load
+    QObject::connect(this, &ProcessNode::stateLoaded, widget, showState);
+    return widget;
+}
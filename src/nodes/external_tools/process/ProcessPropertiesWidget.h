@@ -26,6 +26,7 @@
 #include <QWidget>
 #include <QString>
 
+class QCheckBox;
 class QLineEdit;
 
 class ProcessPropertiesWidget : public QWidget {
@@ -35,10 +36,19 @@ public:
 
     QString getCommand() const;
     void setCommand(const QString& command);
+    void setStreamOutput(bool stream);
+    void setPersistent(bool persistent);
+    void setDelimiter(const QString& delimiter);
 
 signals:
     void commandChanged(const QString& command);
+    void streamOutputChanged(bool stream);
+    void persistentChanged(bool persistent);
+    void delimiterChanged(const QString& delimiter);
 
 private:
     QLineEdit* commandLineEdit {nullptr};
+    QCheckBox* streamCheckBox {nullptr};
+    QCheckBox* persistentCheckBox {nullptr};
+    QLineEdit* delimiterLineEdit {nullptr};
 };
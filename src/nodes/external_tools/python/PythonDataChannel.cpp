@@ -0,0 +1,220 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "PythonDataChannel.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonValue>
+#include <QUuid>
+
+namespace {
+
+const char kModuleSource[] = R"PY(
+"""Data pins of the Python Script node, exchanged through memory-mapped files."""
+import json, mmap, os
+
+ARROW_STREAM = 'application/vnd.apache.arrow.stream'
+JSON_LINES = 'application/x-ndjson'
+_mappings = []
+
+
+def mime_type():
+    """Content type of the Data input, or '' without one."""
+    return os.environ.get('CP_DATA_IN_TYPE', '')
+
+
+def buffer():
+    """The Data input as a read-only memoryview over its mapping, or None."""
+    path = os.environ.get('CP_DATA_IN', '')
+    if not path or os.path.getsize(path) == 0:
+        return None
+    with open(path, 'rb') as f:
+        mapping = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+    _mappings.append(mapping)
+    return memoryview(mapping)
+
+
+def read_arrow():
+    """The Data input as a pyarrow.Table, parsed by Arrow straight from the mapping."""
+    import pyarrow as pa
+    view = buffer()
+    if view is None:
+        return None
+    kind = mime_type()
+    if kind == ARROW_STREAM:
+        return pa.ipc.open_stream(pa.py_buffer(view)).read_all()
+    if kind == JSON_LINES:
+        import pyarrow.json as pj
+        return pj.read_json(pa.BufferReader(pa.py_buffer(view)))
+    if kind == 'application/json':
+        return pa.Table.from_pylist(json.loads(bytes(view)))
+    raise ValueError('Data input of type %r is not a table' % kind)
+
+
+def read_pandas():
+    """The Data input as a pandas DataFrame, by way of read_arrow()."""
+    table = read_arrow()
+    return None if table is None else table.to_pandas()
+
+
+def read():
+    """The Data input decoded: JSON as Python values, text as str, Arrow streams as a
+    pyarrow.Table and anything else as the memoryview itself."""
+    view = buffer()
+    if view is None:
+        return None
+    kind = mime_type()
+    if kind == 'application/json':
+        return json.loads(bytes(view))
+    if kind == JSON_LINES:
+        return [json.loads(line) for line in bytes(view).splitlines() if line.strip()]
+    if kind.startswith('text/'):
+        return str(view, 'utf-8')
+    if kind == ARROW_STREAM:
+        return read_arrow()
+    return view
+
+
+def write(value):
+    """Sends value out on the Data output: bytes-like values as they are, str as text,
+    pyarrow tables, record batches and pandas DataFrames as an Arrow IPC stream, and
+    anything else as JSON."""
+    path = os.environ.get('CP_DATA_OUT', '')
+    if not path:
+        raise RuntimeError('No Data output channel')
+    module = type(value).__module__ or ''
+    if module.startswith('pandas'):
+        import pyarrow as pa
+        value = pa.Table.from_pandas(value, preserve_index=False)
+        module = 'pyarrow'
+    if isinstance(value, (bytes, bytearray, memoryview)):
+        kind = 'application/octet-stream'
+        with open(path, 'wb') as f:
+            f.write(value)
+    elif isinstance(value, str):
+        kind = 'text/plain'
+        with open(path, 'wb') as f:
+            f.write(value.encode('utf-8'))
+    elif module.startswith('pyarrow'):
+        import pyarrow as pa
+        kind = ARROW_STREAM
+        with pa.OSFile(path, 'wb') as sink, pa.ipc.new_stream(sink, value.schema) as writer:
+            writer.write(value)
+    else:
+        kind = 'application/json'
+        with open(path, 'w', encoding='utf-8') as f:
+            json.dump(value, f)
+    with open(path + '.type', 'w') as f:
+        f.write(kind)
+)PY";
+
+bool isListOfObjects(const QVariantList& list)
+{
+    if (list.isEmpty()) return false;
+    for (const QVariant& element : list) {
+        if (element.typeId() != QMetaType::QVariantMap) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+QString PythonDataChannel::moduleSource()
+{
+    return QString::fromLatin1(kModuleSource);
+}
+
+BlobHandle PythonDataChannel::materialize(const QVariant& value)
+{
+    if (!value.isValid() || value.isNull()) return {};
+
+    if (value.metaType() == QMetaType::fromType<BlobHandle>()) {
+        const BlobHandle blob = value.value<BlobHandle>();
+        // Already a file: the script maps the same pages the handle does
+        if (blob.isNull() || blob.isSpilled()) return blob;
+        return BlobHandle::fromBytes(blob.bytes(), blob.mimeType(), BlobHandle::Storage::Spill);
+    }
+    if (value.typeId() == QMetaType::QByteArray) {
+        return BlobHandle::fromBytes(value.toByteArray(), QStringLiteral("application/octet-stream"),
+                                     BlobHandle::Storage::Spill);
+    }
+    if (value.typeId() == QMetaType::QString) {
+        return BlobHandle::fromText(value.toString(), QStringLiteral("text/plain"), BlobHandle::Storage::Spill);
+    }
+    if (value.typeId() == QMetaType::QVariantList && isListOfObjects(value.toList())) {
+        // One object per line, which pyarrow.json reads without building Python objects
+        QByteArray lines;
+        for (const QVariant& row : value.toList()) {
+            lines += QJsonDocument::fromVariant(row).toJson(QJsonDocument::Compact);
+            lines += '\n';
+        }
+        return BlobHandle::fromBytes(lines, QString::fromLatin1(kJsonLinesType), BlobHandle::Storage::Spill);
+    }
+    const QJsonValue json = QJsonValue::fromVariant(value);
+    const QByteArray bytes = json.isObject() || json.isArray()
+        ? QJsonDocument::fromVariant(value).toJson(QJsonDocument::Compact)
+        : QJsonDocument(QJsonArray{json}).toJson(QJsonDocument::Compact).mid(1).chopped(1);
+    return BlobHandle::fromBytes(bytes, QStringLiteral("application/json"), BlobHandle::Storage::Spill);
+}
+
+QString PythonDataChannel::outputPath()
+{
+    const QString dir = BlobHandle::spillDirectory();
+    QDir().mkpath(dir);
+    return QDir(dir).filePath(
+        QStringLiteral("python-data-%1.out").arg(QUuid::createUuid().toString(QUuid::Id128)));
+}
+
+QVariant PythonDataChannel::collect(const QString& path)
+{
+    const QString typePath = path + QStringLiteral(".type");
+    QString mimeType = QStringLiteral("application/octet-stream");
+    QFile typeFile(typePath);
+    if (typeFile.open(QIODevice::ReadOnly)) {
+        mimeType = QString::fromUtf8(typeFile.readAll()).trimmed();
+        typeFile.close();
+        QFile::remove(typePath);
+    }
+
+    QVariant result;
+    if (QFileInfo(path).size() > 0) {
+        if (mimeType == QStringLiteral("application/json")) {
+            QFile file(path);
+            if (file.open(QIODevice::ReadOnly)) {
+                const QByteArray bytes = file.readAll();
+                // Scalars parse as the only element of an array
+                const QJsonDocument doc = QJsonDocument::fromJson("[" + bytes + "]");
+                result = doc.isArray() && !doc.array().isEmpty() ? doc.array().first().toVariant() : QVariant();
+            }
+        } else {
+            const BlobHandle blob = BlobHandle::fromFile(path, mimeType);
+            if (!blob.isNull()) result = QVariant::fromValue(blob);
+        }
+    }
+    QFile::remove(path);
+    return result;
+}
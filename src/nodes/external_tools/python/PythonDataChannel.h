@@ -0,0 +1,64 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <QString>
+#include <QVariant>
+
+#include "BlobHandle.h"
+
+// Shared-memory exchange for the Python Script node's Data pins.
+//
+// The Data input is materialised once into a file-backed BlobHandle (a spilled blob
+// is handed over as it is) and the script maps that file read-only, so large tables
+// and byte payloads never pass through stdin or stdout as text. The `cp_data` module
+// the script imports reads the mapping: Arrow IPC streams and JSON Lines tables go to
+// pyarrow's native readers without a Python-level parse. Results come back the same
+// way, written by `cp_data.write()` to a file that becomes a BlobHandle on the Data
+// output, or a QVariant when the script wrote JSON.
+class PythonDataChannel {
+public:
+    // Environment variables the module reads
+    static constexpr const char* kInputPathVar = "CP_DATA_IN";
+    static constexpr const char* kInputTypeVar = "CP_DATA_IN_TYPE";
+    static constexpr const char* kOutputPathVar = "CP_DATA_OUT";
+    static constexpr const char* kModuleName = "cp_data";
+
+    static constexpr const char* kArrowStreamType = "application/vnd.apache.arrow.stream";
+    static constexpr const char* kJsonLinesType = "application/x-ndjson";
+
+    // Python source of the cp_data module
+    static QString moduleSource();
+
+    // A file-backed blob holding value: lists of objects as JSON Lines, strings as
+    // UTF-8 text, byte arrays as they are, anything else as JSON. Null for no value.
+    static BlobHandle materialize(const QVariant& value);
+
+    // A fresh path for the script's Data output, in the blob spill directory
+    static QString outputPath();
+
+    // What the script wrote to path (invalid when nothing), removing the file
+    static QVariant collect(const QString& path);
+};
@@ -23,14 +23,16 @@
 //
 
 #include "PythonScriptNode.h"
-#include "PythonScriptPropertiesWidget.h"
+#include "PythonDataChannel.h"
+#include "NodeOutputDir.h"
+#include "CancellationToken.h"
 
-#include <QLineEdit>
-#include <QTextEdit>
 #include <QtConcurrent/QtConcurrent>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QProcess>
+#include <QProcessEnvironment>
 #include <QStandardPaths>
 #include <QTemporaryFile>
 #include <QUuid>
@@ -58,6 +60,14 @@ NodeDescriptor PythonScriptNode::getDescriptor() const
     in.type = QStringLiteral("text");
     desc.inputPins.insert(in.id, in);
 
+    // Input pin: data, mapped into the script's memory through cp_data
+    PinDefinition inData;
+    inData.direction = PinDirection::Input;
+    inData.id = QString::fromLatin1(kDataPinId);
+    inData.name = QStringLiteral("data");
+    inData.type = QStringLiteral("json");
+    desc.inputPins.insert(inData.id, inData);
+
     // Output pin: stdout (text)
     PinDefinition outStdout;
     outStdout.direction = PinDirection::Output;
@@ -74,42 +84,15 @@ NodeDescriptor PythonScriptNode::getDescriptor() const
     outStderr.type = QStringLiteral("text");
     desc.outputPins.insert(outStderr.id, outStderr);
 
-    return desc;
-}
-
-QWidget* PythonScriptNode::createConfigurationWidget(QWidget* parent)
-{
-    auto* widget = new PythonScriptPropertiesWidget(parent);
+    // Output pin: data, whatever the script passed to cp_data.write()
+    PinDefinition outData;
+    outData.direction = PinDirection::Output;
+    outData.id = QString::fromLatin1(kDataPinId);
+    outData.name = QStringLiteral("data");
+    outData.type = QStringLiteral("json");
+    desc.outputPins.insert(outData.id, outData);
 
-    // Initialize the UI from our current state
-    if (!m_executable.isEmpty()) {
-        if (auto* exeEdit = widget->findChild<QLineEdit*>(QString(), Qt::FindDirectChildrenOnly)) {
-            // Not using objectName; this finds first QLineEdit direct child
-            exeEdit->setText(m_executable);
-        } else {
-            // Fallback: try any QLineEdit in the subtree
-            if (auto* exeAny = widget->findChild<QLineEdit*>()) {
-                exeAny->setText(m_executable);
-            }
-        }
-    }
-    if (!m_scriptContent.isEmpty()) {
-        if (auto* scriptEdit = widget->findChild<QTextEdit*>(QString(), Qt::FindDirectChildrenOnly)) {
-            scriptEdit->setPlainText(m_scriptContent);
-        } else {
-            if (auto* scriptAny = widget->findChild<QTextEdit*>()) {
-                scriptAny->setPlainText(m_scriptContent);
-            }
-        }
-    }
-
-    // Wire signals to keep the state in sync
-    connect(widget, &PythonScriptPropertiesWidget::executableChanged,
-            this, &PythonScriptNode::onExecutableChanged);
-    connect(widget, &PythonScriptPropertiesWidget::scriptContentChanged,
-            this, &PythonScriptNode::onScriptContentChanged);
-
-    return widget;
+    return desc;
 }
 
 TokenList PythonScriptNode::execute(const TokenList& incomingTokens)
@@ -127,6 +110,14 @@ TokenList PythonScriptNode::execute(const TokenList& incomingTokens)
     const QString executable = m_executable.trimmed();
     const QString scriptContent = m_scriptContent; // may be empty; we'll still attempt to run
 
+    // Data travels through files the script maps rather than through the pipes
+    const BlobHandle dataIn = PythonDataChannel::materialize(inputs.value(QString::fromLatin1(kDataPinId)));
+    const QString dataOutPath = PythonDataChannel::outputPath();
+    QHash<QString, QString> dataEnvironment;
+    dataEnvironment.insert(QString::fromLatin1(PythonDataChannel::kInputPathVar), dataIn.filePath());
+    dataEnvironment.insert(QString::fromLatin1(PythonDataChannel::kInputTypeVar), dataIn.mimeType());
+    dataEnvironment.insert(QString::fromLatin1(PythonDataChannel::kOutputPathVar), dataOutPath);
+
     DataPacket packet;
     const QString outKey = QStringLiteral("stdout");
     const QString errKey = QStringLiteral("stderr");
@@ -137,9 +128,31 @@ TokenList PythonScriptNode::execute(const TokenList& incomingTokens)
         packet.insert(errKey, msg);
         packet.insert(QStringLiteral("__error"), msg);
         CP_WARN << "PythonScriptNode:" << msg;
+    } else if (m_persistentWorker) {
+        // No script file: the worker receives the source and runs it in a fresh namespace
+        PythonWorkerPool::JobContext context;
+        context.environment = dataEnvironment;
+        context.modules.insert(QString::fromLatin1(PythonDataChannel::kModuleName), PythonDataChannel::moduleSource());
+        const PythonWorkerPool::Result run =
+            PythonWorkerPool::run(executable, scriptContent, stdinText, m_workerMaxJobs, 60000, context);
+        if (!run.error.isEmpty()) {
+            packet.insert(outKey, QString());
+            packet.insert(errKey, run.error);
+            packet.insert(QStringLiteral("__error"), run.error);
+        } else {
+            packet.insert(outKey, run.stdoutText);
+            packet.insert(errKey, run.stderrText);
+            packet.insert(QStringLiteral("_exit_code"), run.exitCode);
+            if (run.exitCode != 0) {
+                const QString msg = QStringLiteral("Python process exited with code %1: %2")
+                                        .arg(run.exitCode)
+                                        .arg(run.stderrText.trimmed());
+                packet.insert(QStringLiteral("__error"), msg);
+            }
+        }
     } else {
         // Create a script file in the node-specific output directory
-        QString outDir = inputs.value(QStringLiteral("_sys_node_output_dir")).toString();
+        QString outDir = NodeOutputDir::materialize(inputs);
         if (outDir.isEmpty()) {
             outDir = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
             if (outDir.isEmpty()) {
@@ -170,6 +183,16 @@ TokenList PythonScriptNode::execute(const TokenList& incomingTokens)
                 scriptFile.flush();
                 scriptFile.close();
 
+                // The script's directory leads sys.path, so `import cp_data` finds this
+                QFile moduleFile(outDir + QDir::separator() + QString::fromLatin1(PythonDataChannel::kModuleName)
+                                 + QStringLiteral(".py"));
+                if (moduleFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                    moduleFile.write(PythonDataChannel::moduleSource().toUtf8());
+                    moduleFile.close();
+                } else {
+                    CP_WARN << "PythonScriptNode: failed to write the cp_data module:" << moduleFile.errorString();
+                }
+
                 // Prepare process
                 QProcess proc;
                 proc.setProcessChannelMode(QProcess::SeparateChannels);
@@ -189,6 +212,11 @@ TokenList PythonScriptNode::execute(const TokenList& incomingTokens)
                     args << scriptPath;
                     proc.setProgram(program);
                     proc.setArguments(args);
+                    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+                    for (auto it = dataEnvironment.constBegin(); it != dataEnvironment.constEnd(); ++it) {
+                        environment.insert(it.key(), it.value());
+                    }
+                    proc.setProcessEnvironment(environment);
 
                     // Start the process
                     proc.start();
@@ -209,14 +237,24 @@ TokenList PythonScriptNode::execute(const TokenList& incomingTokens)
                         }
                         proc.closeWriteChannel();
 
-                        // Wait for finish with timeout (60s)
-                        if (!proc.waitForFinished(60000)) {
-                            CP_WARN << "PythonScriptNode: process timeout, killing...";
+                        // Wait for finish with timeout (60s), in short slices so that
+                        // stopping the run kills the interpreter right away
+                        const CancellationToken cancellation = CancellationToken::current();
+                        QElapsedTimer waited;
+                        waited.start();
+                        bool finished = false;
+                        while (!(finished = proc.waitForFinished(100)) && proc.state() != QProcess::NotRunning
+                               && !cancellation.isCancelled() && waited.elapsed() < 60000) {
+                        }
+                        if (!finished && proc.state() != QProcess::NotRunning) {
+                            const QString msg = cancellation.isCancelled() ? QStringLiteral("Process cancelled")
+                                                                           : QStringLiteral("Process timed out");
+                            CP_WARN << "PythonScriptNode:" << msg << ", killing...";
                             proc.kill();
                             proc.waitForFinished();
                             packet.insert(outKey, QString());
-                            packet.insert(errKey, QStringLiteral("Process timed out"));
-                            packet.insert(QStringLiteral("__error"), QStringLiteral("Process timed out"));
+                            packet.insert(errKey, msg);
+                            packet.insert(QStringLiteral("__error"), msg);
                         } else {
                             const QString stdoutStr = QString::fromUtf8(proc.readAllStandardOutput());
                             const QString stderrStr = QString::fromUtf8(proc.readAllStandardError());
@@ -238,6 +276,12 @@ TokenList PythonScriptNode::execute(const TokenList& incomingTokens)
         }
     }
 
+    // Collected even after a failure so the output files never outlive the run
+    const QVariant dataOut = PythonDataChannel::collect(dataOutPath);
+    if (dataOut.isValid()) {
+        packet.insert(QString::fromLatin1(kDataPinId), dataOut);
+    }
+
     ExecutionToken token;
     token.data = packet;
 
@@ -251,6 +295,8 @@ QJsonObject PythonScriptNode::saveState() const
     QJsonObject obj;
     obj.insert(QStringLiteral("executable"), m_executable);
     obj.insert(QStringLiteral("script"), m_scriptContent);
+    obj.insert(QStringLiteral("persistentWorker"), m_persistentWorker);
+    obj.insert(QStringLiteral("workerMaxJobs"), m_workerMaxJobs);
     return obj;
 }
 
@@ -262,6 +308,12 @@ void PythonScriptNode::loadState(const QJsonObject& data)
     if (data.contains(QStringLiteral("script")) && data.value(QStringLiteral("script")).isString()) {
         m_scriptContent = data.value(QStringLiteral("script")).toString();
     }
+    if (data.value(QStringLiteral("persistentWorker")).isBool()) {
+        m_persistentWorker = data.value(QStringLiteral("persistentWorker")).toBool();
+    }
+    if (data.value(QStringLiteral("workerMaxJobs")).isDouble()) {
+        m_workerMaxJobs = qMax(1, data.value(QStringLiteral("workerMaxJobs")).toInt());
+    }
 }
 
 void PythonScriptNode::onExecutableChanged(const QString& executable)
@@ -273,3 +325,13 @@ void PythonScriptNode::onScriptContentChanged(const QString& scriptContent)
 {
     m_scriptContent = scriptContent;
 }
+
+void PythonScriptNode::onPersistentWorkerChanged(bool persistent)
+{
+    m_persistentWorker = persistent;
+}
+
+void PythonScriptNode::onWorkerMaxJobsChanged(int maxJobs)
+{
+    m_workerMaxJobs = maxJobs;
+}
@@ -25,24 +25,29 @@
 #pragma once
 
 #include <QObject>
-#include <QWidget>
 
 #include "IToolNode.h"
 #include "CommonDataTypes.h"
-#include "PythonScriptPropertiesWidget.h"
+#include "PythonWorkerPool.h"
 
+class QWidget;
 
 class PythonScriptNode : public QObject, public IToolNode {
     Q_OBJECT
     Q_INTERFACES(IToolNode)
 public:
+    // Input and output pin exchanging data through memory-mapped files (PythonDataChannel)
+    static constexpr const char* kDataPinId = "data";
+
     explicit PythonScriptNode(QObject* parent = nullptr);
     ~PythonScriptNode() override = default;
 
     // IToolNode interface (blueprint-aligned, V3 tokens API)
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in PythonScriptPropertiesWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     TokenList execute(const TokenList& incomingTokens) override;
+    ResourceClass resourceClass() const override { return ResourceClass::Process; }
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
 
@@ -54,6 +59,8 @@ public:
 private slots:
     void onExecutableChanged(const QString& executable);
     void onScriptContentChanged(const QString& scriptContent);
+    void onPersistentWorkerChanged(bool persistent);
+    void onWorkerMaxJobsChanged(int maxJobs);
 
 private:
     // Configuration (mutable by the UI)
@@ -64,4 +71,6 @@ private:
     // New state bound to the properties widget
     QString m_executable;       // e.g., "python3 -u"
     QString m_scriptContent;    // Python script text
+    bool m_persistentWorker {false}; // run on a PythonWorkerPool worker instead of a fresh process
+    int m_workerMaxJobs {PythonWorkerPool::kDefaultMaxJobs}; // jobs before that worker is recycled
 };
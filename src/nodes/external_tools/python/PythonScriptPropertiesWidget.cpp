@@ -22,12 +22,17 @@
 // SOFTWARE.
 //
 #include "PythonScriptPropertiesWidget.h"
+#include "PythonScriptNode.h"
 
 #include <QVBoxLayout>
+#include <QCheckBox>
 #include <QLabel>
 #include <QLineEdit>
+#include <QSpinBox>
 #include <QTextEdit>
 
+#include "PythonWorkerPool.h"
+
 PythonScriptPropertiesWidget::PythonScriptPropertiesWidget(QWidget* parent)
     : QWidget(parent)
 {
@@ -53,6 +58,21 @@ PythonScriptPropertiesWidget::PythonScriptPropertiesWidget(QWidget* parent)
     m_scriptEdit->setPlaceholderText(tr("Write your Python script here"));
     layout->addWidget(m_scriptEdit);
 
+    // Persistent worker mode
+    m_persistentCheck = new QCheckBox(tr("Run in a persistent worker process"), this);
+    m_persistentCheck->setToolTip(tr("Reuses a long-lived interpreter so start-up and imports are paid once; "
+                                     "each run still gets a fresh namespace"));
+    layout->addWidget(m_persistentCheck);
+
+    auto* maxJobsLabel = new QLabel(tr("Recycle worker after (jobs):"), this);
+    layout->addWidget(maxJobsLabel);
+
+    m_maxJobsSpin = new QSpinBox(this);
+    m_maxJobsSpin->setRange(1, 100000);
+    m_maxJobsSpin->setValue(PythonWorkerPool::kDefaultMaxJobs);
+    m_maxJobsSpin->setEnabled(false);
+    layout->addWidget(m_maxJobsSpin);
+
     layout->addStretch();
 
     // Forward changes to public signals
@@ -62,4 +82,59 @@ PythonScriptPropertiesWidget::PythonScriptPropertiesWidget(QWidget* parent)
     connect(m_scriptEdit, &QTextEdit::textChanged, this, [this]() {
         emit scriptContentChanged(m_scriptEdit->toPlainText());
     });
+
+    connect(m_persistentCheck, &QCheckBox::toggled, this, [this](bool checked) {
+        m_maxJobsSpin->setEnabled(checked);
+        emit persistentWorkerChanged(checked);
+    });
+
+    connect(m_maxJobsSpin, &QSpinBox::valueChanged,
+            this, &PythonScriptPropertiesWidget::workerMaxJobsChanged);
+}
+
+QWidget* PythonScriptNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* widget = new PythonScriptPropertiesWidget(parent);
+
+    // Initialize the UI from our current state
+    if (!m_executable.isEmpty()) {
+        if (auto* exeEdit = widget->findChild<QLineEdit*>(QString(), Qt::FindDirectChildrenOnly)) {
+            // Not using objectName; this finds first QLineEdit direct child
+            exeEdit->setText(m_executable);
+        } else {
+            // Fallback: try any QLineEdit in the subtree
+            if (auto* exeAny = widget->findChild<QLineEdit*>()) {
+                exeAny->setText(m_executable);
+            }
+        }
+    }
+    if (!m_scriptContent.isEmpty()) {
+        if (auto* scriptEdit = widget->findChild<QTextEdit*>(QString(), Qt::FindDirectChildrenOnly)) {
+            scriptEdit->setPlainText(m_scriptContent);
+        } else {
+            if (auto* scriptAny = widget->findChild<QTextEdit*>()) {
+                scriptAny->setPlainText(m_scriptContent);
+            }
+        }
+    }
+
+    if (auto* persistentCheck = widget->findChild<QCheckBox*>()) {
+        persistentCheck->setChecked(m_persistentWorker);
+    }
+    if (auto* maxJobsSpin = widget->findChild<QSpinBox*>()) {
+        maxJobsSpin->setValue(m_workerMaxJobs);
+        maxJobsSpin->setEnabled(m_persistentWorker);
+    }
+
+    // Wire signals to keep the state in sync
+    connect(widget, &PythonScriptPropertiesWidget::executableChanged,
+            this, &PythonScriptNode::onExecutableChanged);
+    connect(widget, &PythonScriptPropertiesWidget::scriptContentChanged,
+            this, &PythonScriptNode::onScriptContentChanged);
+    connect(widget, &PythonScriptPropertiesWidget::persistentWorkerChanged,
+            this, &PythonScriptNode::onPersistentWorkerChanged);
+    connect(widget, &PythonScriptPropertiesWidget::workerMaxJobsChanged,
+            this, &PythonScriptNode::onWorkerMaxJobsChanged);
+
+    return widget;
 }
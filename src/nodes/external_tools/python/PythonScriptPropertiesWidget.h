@@ -25,7 +25,9 @@
 
 #include <QWidget>
 
+class QCheckBox;
 class QLineEdit;
+class QSpinBox;
 class QTextEdit;
 
 // Properties panel for the Python Script node
@@ -38,8 +40,12 @@ public:
 signals:
     void executableChanged(const QString& executable);
     void scriptContentChanged(const QString& scriptContent);
+    void persistentWorkerChanged(bool persistent);
+    void workerMaxJobsChanged(int maxJobs);
 
 private:
     QLineEdit* m_executableEdit {nullptr};
     QTextEdit* m_scriptEdit {nullptr};
+    QCheckBox* m_persistentCheck {nullptr};
+    QSpinBox* m_maxJobsSpin {nullptr};
 };
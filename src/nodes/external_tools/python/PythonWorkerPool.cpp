@@ -0,0 +1,330 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "PythonWorkerPool.h"
+#include "CancellationToken.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QtEndian>
+
+#include <memory>
+#include <optional>
+
+#include "Logger.h"
+
+namespace {
+
+constexpr int kStartTimeoutMs = 10000;
+constexpr qint64 kIdlePingMs = 30000;
+constexpr int kPingTimeoutMs = 2000;
+
+// Keeps the protocol on duplicates of fds 0 and 1, then points fd 0 at the null
+// device and fd 1 at stderr so nothing a script or its children write can land
+// inside a frame.
+const char kBootstrap[] = R"PY(
+import builtins, io, json, os, struct, sys, traceback, types
+
+def main():
+    proto_in = os.fdopen(os.dup(0), 'rb', buffering=0)
+    proto_out = os.fdopen(os.dup(1), 'wb', buffering=0)
+    null = os.open(os.devnull, os.O_RDONLY)
+    os.dup2(null, 0)
+    os.close(null)
+    os.dup2(2, 1)
+    home = os.getcwd()
+    base_path = list(sys.path)
+
+    def read_exact(n):
+        data = b''
+        while len(data) < n:
+            part = proto_in.read(n - len(data))
+            if not part:
+                return None
+            data += part
+        return data
+
+    def send(reply):
+        body = json.dumps(reply).encode('utf-8')
+        proto_out.write(struct.pack('>I', len(body)) + body)
+
+    while True:
+        header = read_exact(4)
+        body = read_exact(struct.unpack('>I', header)[0]) if header else None
+        if body is None:
+            return
+        job = json.loads(body.decode('utf-8'))
+        if job.get('ping'):
+            send({'pong': True})
+            continue
+        out, err = io.StringIO(), io.StringIO()
+        sys.stdin, sys.stdout, sys.stderr = io.StringIO(job.get('stdin', '')), out, err
+        sys.argv = ['<script>']
+        code = 0
+        saved_env = {k: os.environ.get(k) for k in job.get('env', {})}
+        saved_modules = {k: sys.modules.get(k) for k in job.get('modules', {})}
+        try:
+            os.environ.update(job.get('env', {}))
+            for name, source in job.get('modules', {}).items():
+                module = types.ModuleType(name)
+                exec(compile(source, '<%s>' % name, 'exec'), module.__dict__)
+                sys.modules[name] = module
+            exec(compile(job.get('script', ''), '<script>', 'exec'),
+                 {'__name__': '__main__', '__builtins__': builtins})
+        except SystemExit as e:
+            if isinstance(e.code, int):
+                code = e.code
+            elif e.code is not None:
+                print(e.code, file=err)
+                code = 1
+        except BaseException:
+            traceback.print_exc(file=err)
+            code = 1
+        finally:
+            sys.stdin, sys.stdout, sys.stderr = sys.__stdin__, sys.__stdout__, sys.__stderr__
+            os.chdir(home)
+            sys.path[:] = base_path
+            for k, v in saved_env.items():
+                if v is None:
+                    os.environ.pop(k, None)
+                else:
+                    os.environ[k] = v
+            for k, v in saved_modules.items():
+                if v is None:
+                    sys.modules.pop(k, None)
+                else:
+                    sys.modules[k] = v
+        send({'stdout': out.getvalue(), 'stderr': err.getvalue(), 'exit_code': code})
+
+main()
+)PY";
+
+struct Worker {
+    std::unique_ptr<QProcess> process;
+    int jobs {0};
+    QElapsedTimer idle;
+};
+
+void stopWorker(Worker& worker)
+{
+    if (worker.process) {
+        // Closing stdin ends the bootstrap loop
+        worker.process->closeWriteChannel();
+        if (!worker.process->waitForFinished(1000)) {
+            worker.process->kill();
+            worker.process->waitForFinished();
+        }
+        worker.process.reset();
+    }
+    worker.jobs = 0;
+}
+
+struct ThreadWorkers {
+    QHash<QString, Worker> byExecutable;
+
+    ~ThreadWorkers()
+    {
+        for (Worker& worker : byExecutable) {
+            stopWorker(worker);
+        }
+    }
+};
+
+ThreadWorkers& threadWorkers()
+{
+    thread_local ThreadWorkers workers;
+    return workers;
+}
+
+bool startWorker(Worker& worker, const QString& executable, QString* error)
+{
+    QStringList args = QProcess::splitCommand(executable);
+    if (args.isEmpty()) {
+        *error = QStringLiteral("ERROR: Invalid Python executable/command: '") + executable + QStringLiteral("'");
+        return false;
+    }
+    const QString program = args.takeFirst();
+    args << QStringLiteral("-c") << QString::fromLatin1(kBootstrap);
+
+    auto process = std::make_unique<QProcess>();
+    process->setProcessChannelMode(QProcess::SeparateChannels);
+    process->start(program, args);
+    if (!process->waitForStarted(kStartTimeoutMs)) {
+        *error = QStringLiteral("Failed to start process: ") + process->errorString();
+        return false;
+    }
+    worker.process = std::move(process);
+    worker.jobs = 0;
+    worker.idle.start();
+    return true;
+}
+
+bool sendFrame(QProcess& process, const QJsonObject& message)
+{
+    const QByteArray body = QJsonDocument(message).toJson(QJsonDocument::Compact);
+    QByteArray frame(4, Qt::Uninitialized);
+    qToBigEndian<quint32>(static_cast<quint32>(body.size()), frame.data());
+    frame += body;
+    return process.write(frame) == frame.size();
+}
+
+enum class ReceiveFailure { None, Exited, TimedOut, Cancelled, Malformed };
+
+std::optional<QJsonObject> receiveFrame(QProcess& process, int timeoutMs, ReceiveFailure* failure)
+{
+    const CancellationToken cancellation = CancellationToken::current();
+    QElapsedTimer waited;
+    waited.start();
+    qint64 length = -1;
+    for (;;) {
+        if (length < 0 && process.bytesAvailable() >= 4) {
+            length = qFromBigEndian<quint32>(process.read(4).constData());
+        }
+        if (length >= 0 && process.bytesAvailable() >= length) {
+            break;
+        }
+        if (process.state() == QProcess::NotRunning) {
+            *failure = ReceiveFailure::Exited;
+            return std::nullopt;
+        }
+        if (cancellation.isCancelled()) {
+            *failure = ReceiveFailure::Cancelled;
+            return std::nullopt;
+        }
+        if (waited.elapsed() >= timeoutMs) {
+            *failure = ReceiveFailure::TimedOut;
+            return std::nullopt;
+        }
+        // Short slices so that stopping the run is noticed right away
+        process.waitForReadyRead(100);
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument reply = QJsonDocument::fromJson(process.read(length), &parseError);
+    if (parseError.error != QJsonParseError::NoError || !reply.isObject()) {
+        *failure = ReceiveFailure::Malformed;
+        return std::nullopt;
+    }
+    *failure = ReceiveFailure::None;
+    return reply.object();
+}
+
+// A worker that sat idle may have died or wedged since its last job
+bool isHealthy(Worker& worker)
+{
+    if (worker.process->state() != QProcess::Running) {
+        return false;
+    }
+    if (worker.idle.elapsed() < kIdlePingMs) {
+        return true;
+    }
+    ReceiveFailure failure = ReceiveFailure::None;
+    if (!sendFrame(*worker.process, QJsonObject{{QStringLiteral("ping"), true}})) {
+        return false;
+    }
+    const std::optional<QJsonObject> pong = receiveFrame(*worker.process, kPingTimeoutMs, &failure);
+    return pong && pong->value(QStringLiteral("pong")).toBool();
+}
+
+} // namespace
+
+PythonWorkerPool::Result PythonWorkerPool::run(const QString& executable, const QString& script,
+                                               const QString& stdinText, int maxJobs, int timeoutMs,
+                                               const JobContext& context)
+{
+    Result result;
+    Worker& worker = threadWorkers().byExecutable[executable];
+    if (worker.process && !isHealthy(worker)) {
+        CP_WARN << "PythonWorkerPool: replacing unresponsive worker for" << executable;
+        stopWorker(worker);
+    }
+    if (!worker.process && !startWorker(worker, executable, &result.error)) {
+        return result;
+    }
+
+    QProcess& process = *worker.process;
+    // Whatever reached fd 2 between jobs belongs to no run
+    process.readAllStandardError();
+
+    ReceiveFailure failure = ReceiveFailure::Exited;
+    std::optional<QJsonObject> reply;
+    QJsonObject job{{QStringLiteral("script"), script}, {QStringLiteral("stdin"), stdinText}};
+    const auto toJson = [](const QHash<QString, QString>& values) {
+        QJsonObject object;
+        for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+            object.insert(it.key(), it.value());
+        }
+        return object;
+    };
+    if (!context.environment.isEmpty()) job.insert(QStringLiteral("env"), toJson(context.environment));
+    if (!context.modules.isEmpty()) job.insert(QStringLiteral("modules"), toJson(context.modules));
+    if (sendFrame(process, job)) {
+        reply = receiveFrame(process, timeoutMs, &failure);
+    }
+    const QString processStderr = QString::fromUtf8(process.readAllStandardError());
+
+    if (!reply) {
+        switch (failure) {
+        case ReceiveFailure::Cancelled:
+            result.error = QStringLiteral("Process cancelled");
+            break;
+        case ReceiveFailure::TimedOut:
+            result.error = QStringLiteral("Process timed out");
+            break;
+        case ReceiveFailure::Malformed:
+            result.error = QStringLiteral("Python worker sent a malformed reply");
+            break;
+        default:
+            result.error = QStringLiteral("Python worker exited: ")
+                + (processStderr.trimmed().isEmpty() ? process.errorString() : processStderr.trimmed());
+            break;
+        }
+        CP_WARN << "PythonWorkerPool:" << result.error << ", stopping worker";
+        stopWorker(worker);
+        return result;
+    }
+
+    result.stdoutText = reply->value(QStringLiteral("stdout")).toString();
+    result.stderrText = reply->value(QStringLiteral("stderr")).toString() + processStderr;
+    result.exitCode = reply->value(QStringLiteral("exit_code")).toInt();
+
+    // Recycling bounds whatever imports and leaks pile up in one interpreter
+    if (maxJobs > 0 && ++worker.jobs >= maxJobs) {
+        stopWorker(worker);
+    } else {
+        worker.idle.restart();
+    }
+    return result;
+}
+
+void PythonWorkerPool::shutdown()
+{
+    ThreadWorkers& workers = threadWorkers();
+    for (Worker& worker : workers.byExecutable) {
+        stopWorker(worker);
+    }
+    workers.byExecutable.clear();
+}
@@ -0,0 +1,65 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QHash>
+#include <QString>
+
+// Long-lived Python interpreters that run scripts sent to them as jobs.
+//
+// Each thread keeps one worker process per executable command. A job travels
+// as a length-prefixed JSON frame over the worker's stdin, runs in a fresh
+// module namespace with sys.stdin/stdout/stderr swapped for in-memory streams,
+// and comes back the same way, so the interpreter start-up and the modules a
+// script imports are paid for once per worker rather than once per run.
+// Workers idle for a while are pinged before they take a job, and each one is
+// replaced after maxJobs jobs, a timeout, a cancellation or a broken frame.
+class PythonWorkerPool {
+public:
+    struct Result {
+        QString stdoutText;
+        QString stderrText;
+        int exitCode {0};
+        // Set when the job never ran to completion; the script's own failures show in exitCode
+        QString error;
+    };
+
+    // Per-job additions to the worker's environment: variables set in os.environ and
+    // modules, given as source, the script can import. Both are undone after the job.
+    struct JobContext {
+        QHash<QString, QString> environment;
+        QHash<QString, QString> modules;
+    };
+
+    static constexpr int kDefaultMaxJobs = 100;
+
+    // Runs script on this thread's worker for executable, starting one when needed.
+    // Honours CancellationToken::current().
+    static Result run(const QString& executable, const QString& script, const QString& stdinText,
+                      int maxJobs = kDefaultMaxJobs, int timeoutMs = 60000,
+                      const JobContext& context = {});
+
+    // Stops this thread's workers.
+    static void shutdown();
+};
@@ -22,17 +22,11 @@
 // SOFTWARE.
 //
 #include "HumanInputNode.h"
-#include "HumanInputPropertiesWidget.h"
-#include "MainWindow.h"
+#include "HumanInputQueue.h"
+#include "CancellationToken.h"
 
-#include <QtConcurrent/QtConcurrent>
 #include <QJsonObject>
-#include <QMetaObject>
 #include <QFuture>
-#include <QPromise>
-#include <QTextEdit>
-#include <QThread>
-#include <QApplication>
 
 HumanInputNode::HumanInputNode(QObject* parent)
     : QObject(parent)
@@ -65,22 +59,29 @@ NodeDescriptor HumanInputNode::getDescriptor() const
     return desc;
 }
 
-QWidget* HumanInputNode::createConfigurationWidget(QWidget* parent)
+namespace {
+
+TokenList answerTokens(const HumanInputQueue::Answer& answer)
 {
-    if (!m_propertiesWidget) {
-        m_propertiesWidget = new HumanInputPropertiesWidget(parent);
-        // Load the default prompt into the widget
-        m_propertiesWidget->setDefaultPrompt(m_defaultPrompt);
-        // Connect signal to update m_defaultPrompt when user edits
-        connect(m_propertiesWidget, &HumanInputPropertiesWidget::defaultPromptChanged,
-                this, &HumanInputNode::onDefaultPromptChanged);
-    } else if (m_propertiesWidget->parent() != parent && parent) {
-        m_propertiesWidget->setParent(parent);
+    DataPacket output;
+    // If user canceled, return error to stop the pipeline
+    if (!answer.accepted) {
+        output.insert(QStringLiteral("__error"), QStringLiteral("User canceled input"));
+    } else {
+        output.insert(QString::fromLatin1(HumanInputNode::kOutputId), answer.text);
     }
-    return m_propertiesWidget;
+
+    ExecutionToken token;
+    token.data = output;
+
+    TokenList result;
+    result.push_back(std::move(token));
+    return result;
 }
 
-TokenList HumanInputNode::execute(const TokenList& incomingTokens)
+} // namespace
+
+QString HumanInputNode::effectivePrompt(const TokenList& incomingTokens) const
 {
     // Merge incoming tokens into a single DataPacket
     DataPacket inputs;
@@ -90,74 +91,37 @@ TokenList HumanInputNode::execute(const TokenList& incomingTokens)
         }
     }
 
-    // Retrieve text from input pin
+    // Input pin > default prompt > hardcoded fallback
     const QString inputPrompt = inputs.value(QString::fromLatin1(kInputId)).toString();
-
-    // Determine effective prompt: input pin > default prompt > hardcoded fallback
-    QString effectivePrompt;
     if (!inputPrompt.isEmpty()) {
-        effectivePrompt = inputPrompt;
-    } else if (!m_defaultPrompt.isEmpty()) {
-        effectivePrompt = m_defaultPrompt;
-    } else {
-        effectivePrompt = QStringLiteral("Please provide input:");
+        return inputPrompt;
     }
-
-    // Get MainWindow instance
-    MainWindow* mainWindow = nullptr;
-    QWidget* activeWindow = QApplication::activeWindow();
-    if (activeWindow) {
-        mainWindow = qobject_cast<MainWindow*>(activeWindow);
-    }
-    if (!mainWindow) {
-        // Fallback: search through top-level widgets
-        for (QWidget* widget : QApplication::topLevelWidgets()) {
-            mainWindow = qobject_cast<MainWindow*>(widget);
-            if (mainWindow) break;
-        }
-    }
-
-    QString returnedText;
-    bool accepted = false;
-    if (mainWindow) {
-        // Call the slot on the main thread using BlockingQueuedConnection
-        QMetaObject::invokeMethod(mainWindow, "requestUserInput",
-                                 Qt::BlockingQueuedConnection,
-                                 Q_RETURN_ARG(bool, accepted),
-                                 Q_ARG(QString, effectivePrompt),
-                                 Q_ARG(QString&, returnedText));
-    }
-
-    // Create output packet
-    DataPacket output;
-
-    // If user canceled, return error to stop the pipeline
-    if (!accepted) {
-        output.insert(QStringLiteral("__error"), QStringLiteral("User canceled input"));
-    } else {
-        // User accepted: return the text
-        output.insert(QString::fromLatin1(kOutputId), returnedText);
+    if (!m_defaultPrompt.isEmpty()) {
+        return m_defaultPrompt;
     }
+    return QStringLiteral("Please provide input:");
+}
 
-    ExecutionToken token;
-    token.data = output;
+TokenList HumanInputNode::execute(const TokenList& incomingTokens)
+{
+    // Synchronous fallback for scope bodies and tests: blocks this thread, never the UI's
+    QFuture<HumanInputQueue::Answer> answer =
+        HumanInputQueue::instance().ask(effectivePrompt(incomingTokens), CancellationToken::current());
+    return answerTokens(answer.result());
+}
 
-    TokenList result;
-    result.push_back(std::move(token));
-    return result;
+QFuture<TokenList> HumanInputNode::executeAsync(const TokenList& incomingTokens)
+{
+    return HumanInputQueue::instance()
+        .ask(effectivePrompt(incomingTokens), CancellationToken::current())
+        .then([](const HumanInputQueue::Answer& answer) { return answerTokens(answer); });
 }
 
 QJsonObject HumanInputNode::saveState() const
 {
-    QString textToSave = m_defaultPrompt;
-    
-    // If widget exists, read current value from it (user may have edited it)
-    if (m_propertiesWidget) {
-        textToSave = m_propertiesWidget->defaultPrompt();
-    }
-
+    // The properties widget reports every edit, so m_defaultPrompt is current
     QJsonObject obj;
-    obj.insert(QStringLiteral("default_prompt"), textToSave);
+    obj.insert(QStringLiteral("default_prompt"), m_defaultPrompt);
     return obj;
 }
 
@@ -171,10 +135,8 @@ void HumanInputNode::loadState(const QJsonObject& data)
         m_defaultPrompt = data.value(QStringLiteral("text")).toString();
     }
 
-    // Update widget if it already exists
-    if (m_propertiesWidget) {
-        m_propertiesWidget->setDefaultPrompt(m_defaultPrompt);
-    }
+    // An open properties widget follows
+    emit defaultPromptLoaded(m_defaultPrompt);
 }
 
 void HumanInputNode::onDefaultPromptChanged(const QString& text)
@@ -24,15 +24,16 @@
 #pragma once
 
 #include <QObject>
-#include <QWidget>
 #include <QFuture>
 #include <QString>
 
 #include "IToolNode.h"
 #include "CommonDataTypes.h"
-#include "HumanInputPropertiesWidget.h"
 
-// Human-in-the-Loop input node: receives a prompt and will wait for human input
+class QWidget;
+
+// Human-in-the-Loop input node: receives a prompt and waits for human input. The prompt
+// goes to HumanInputQueue, and the task holds no worker while it waits for the answer.
 class HumanInputNode : public QObject, public IToolNode {
     Q_OBJECT
     Q_INTERFACES(IToolNode)
@@ -42,8 +43,14 @@ public:
 
     // IToolNode interface
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in HumanInputPropertiesWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     TokenList execute(const TokenList& incomingTokens) override;
+    // Waiting on a person is like waiting on a provider: no thread is held, and parallel
+    // review points neither queue behind one another nor block the UI-thread budget
+    ResourceClass resourceClass() const override { return ResourceClass::Network; }
+    bool supportsAsyncExecution() const override { return true; }
+    QFuture<TokenList> executeAsync(const TokenList& incomingTokens) override;
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
 
@@ -51,10 +58,15 @@ public:
     static constexpr const char* kInputId = "prompt";
     static constexpr const char* kOutputId = "text";
 
+signals:
+    // loadState() read a new default prompt
+    void defaultPromptLoaded(const QString& text);
+
 private slots:
     void onDefaultPromptChanged(const QString& text);
 
 private:
-    HumanInputPropertiesWidget* m_propertiesWidget = nullptr; // cached UI widget
+    QString effectivePrompt(const TokenList& incomingTokens) const;
+
     QString m_defaultPrompt; // user-configured default prompt used as fallback
 };
@@ -22,6 +22,8 @@
 // SOFTWARE.
 //
 #include "HumanInputPropertiesWidget.h"
+#include "HumanInputNode.h"
+
 #include <QLabel>
 
 HumanInputPropertiesWidget::HumanInputPropertiesWidget(QWidget* parent)
@@ -61,3 +63,16 @@ void HumanInputPropertiesWidget::setDefaultPrompt(const QString& text)
         m_textEdit->blockSignals(false);
     }
 }
+
+QWidget* HumanInputNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* widget = new HumanInputPropertiesWidget(parent);
+    // Load the default prompt into the widget
+    widget->setDefaultPrompt(m_defaultPrompt);
+    // Connect signal to update m_defaultPrompt when user edits
+    connect(widget, &HumanInputPropertiesWidget::defaultPromptChanged,
+            this, &HumanInputNode::onDefaultPromptChanged);
+    connect(this, &HumanInputNode::defaultPromptLoaded,
+            widget, &HumanInputPropertiesWidget::setDefaultPrompt);
+    return widget;
+}
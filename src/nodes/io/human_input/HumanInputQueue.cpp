@@ -0,0 +1,149 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "HumanInputQueue.h"
+
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QPromise>
+#include <QThread>
+#include <QTimer>
+
+struct HumanInputQueue::Entry {
+    Prompt prompt;
+    CancellationToken cancellation;
+    QPromise<Answer> promise;
+};
+
+HumanInputQueue& HumanInputQueue::instance()
+{
+    static HumanInputQueue* queue = new HumanInputQueue();
+    return *queue;
+}
+
+HumanInputQueue::HumanInputQueue()
+    : m_cancellationTimer(new QTimer(this))
+{
+    // The first ask() may come from a worker; timers and front ends need the app thread
+    if (QCoreApplication* app = QCoreApplication::instance()) {
+        moveToThread(app->thread());
+    }
+    m_cancellationTimer->setInterval(kCancellationPollMs);
+    connect(m_cancellationTimer, &QTimer::timeout, this, &HumanInputQueue::withdrawCancelled);
+}
+
+QFuture<HumanInputQueue::Answer> HumanInputQueue::ask(const QString& prompt, const CancellationToken& cancellation)
+{
+    auto entry = std::make_shared<Entry>();
+    entry->prompt.text = prompt;
+    entry->cancellation = cancellation;
+    entry->promise.start();
+    QFuture<Answer> future = entry->promise.future();
+
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_frontEnds == 0) {
+            locker.unlock();
+            entry->promise.addResult(Answer());
+            entry->promise.finish();
+            return future;
+        }
+        entry->prompt.id = m_nextId++;
+        m_entries.emplace(entry->prompt.id, entry);
+    }
+
+    emit promptQueued(entry->prompt.id, prompt);
+    QMetaObject::invokeMethod(m_cancellationTimer, [timer = m_cancellationTimer]() {
+        if (!timer->isActive()) timer->start();
+    }, Qt::QueuedConnection);
+    return future;
+}
+
+QList<HumanInputQueue::Prompt> HumanInputQueue::pending() const
+{
+    QMutexLocker locker(&m_mutex);
+    QList<Prompt> prompts;
+    prompts.reserve(static_cast<qsizetype>(m_entries.size()));
+    for (const auto& [id, entry] : m_entries) {
+        prompts.append(entry->prompt);
+    }
+    return prompts;
+}
+
+bool HumanInputQueue::answer(quint64 id, const QString& text)
+{
+    return resolve(id, Answer{true, text});
+}
+
+bool HumanInputQueue::decline(quint64 id)
+{
+    return resolve(id, Answer());
+}
+
+void HumanInputQueue::attachFrontEnd()
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_frontEnds;
+}
+
+void HumanInputQueue::detachFrontEnd()
+{
+    QList<quint64> orphaned;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_frontEnds > 0 && --m_frontEnds == 0) {
+            for (const auto& [id, entry] : m_entries) orphaned.append(id);
+        }
+    }
+    // Nobody is left to answer them
+    for (const quint64 id : orphaned) decline(id);
+}
+
+bool HumanInputQueue::resolve(quint64 id, const Answer& answer)
+{
+    std::shared_ptr<Entry> entry;
+    {
+        QMutexLocker locker(&m_mutex);
+        const auto it = m_entries.find(id);
+        if (it == m_entries.end()) return false;
+        entry = std::move(it->second);
+        m_entries.erase(it);
+    }
+    entry->promise.addResult(answer);
+    entry->promise.finish();
+    emit promptClosed(id);
+    return true;
+}
+
+void HumanInputQueue::withdrawCancelled()
+{
+    QList<quint64> cancelled;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (const auto& [id, entry] : m_entries) {
+            if (entry->cancellation.isCancelled()) cancelled.append(id);
+        }
+        if (m_entries.size() == static_cast<size_t>(cancelled.size())) m_cancellationTimer->stop();
+    }
+    for (const quint64 id : cancelled) decline(id);
+}
@@ -0,0 +1,97 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QFuture>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+
+#include <map>
+#include <memory>
+
+#include "CancellationToken.h"
+
+class QTimer;
+
+/**
+ * @brief Prompts of Human Input nodes that wait for an answer.
+ *
+ * ask() queues a prompt and returns a future at once, so the node's task releases its
+ * worker for as long as the person takes. Front ends present the queued prompts and
+ * settle them with answer() or decline(): the main window shows them one dialog at a
+ * time, and a pipeline server lists them on GET /input and takes answers on
+ * POST /input/<id>. A prompt asked while no front end is attached is declined at once,
+ * as the node used to fail without a main window. Prompts whose run is cancelled are
+ * withdrawn within kCancellationPollMs. The queue lives on the application thread.
+ */
+class HumanInputQueue : public QObject {
+    Q_OBJECT
+public:
+    struct Answer {
+        bool accepted {false};
+        QString text;
+    };
+
+    struct Prompt {
+        quint64 id {0};
+        QString text;
+    };
+
+    static constexpr int kCancellationPollMs = 250;
+
+    static HumanInputQueue& instance();
+
+    QFuture<Answer> ask(const QString& prompt, const CancellationToken& cancellation = CancellationToken());
+
+    // Waiting prompts, oldest first
+    QList<Prompt> pending() const;
+
+    // Settle a waiting prompt; false if it is no longer waiting
+    bool answer(quint64 id, const QString& text);
+    bool decline(quint64 id);
+
+    void attachFrontEnd();
+    void detachFrontEnd();
+
+signals:
+    void promptQueued(quint64 id, const QString& text);
+    // Answered, declined or withdrawn
+    void promptClosed(quint64 id);
+
+private:
+    struct Entry;
+
+    HumanInputQueue();
+    bool resolve(quint64 id, const Answer& answer);
+    void withdrawCancelled();
+
+    mutable QMutex m_mutex;
+    // Keyed by id, which is also arrival order
+    std::map<quint64, std::shared_ptr<Entry>> m_entries;
+    quint64 m_nextId {1};
+    int m_frontEnds {0};
+    QTimer* m_cancellationTimer {nullptr};
+};
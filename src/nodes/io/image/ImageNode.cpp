@@ -22,11 +22,11 @@
 // SOFTWARE.
 //
 #include "ImageNode.h"
-#include "ImagePropertiesWidget.h"
 
 #include <QtConcurrent/QtConcurrent>
 #include <QFileInfo>
 #include <QJsonObject>
+#include <QPointer>
 
 ImageNode::ImageNode(QObject* parent)
     : QObject(parent)
@@ -66,28 +66,6 @@ NodeDescriptor ImageNode::getDescriptor() const
     return desc;
 }
 
-QWidget* ImageNode::createConfigurationWidget(QWidget* parent)
-{
-    auto* w = new ImagePropertiesWidget(parent);
-    // Store widget pointer for thread-safe UI updates from Execute
-    m_widget = w;
-    
-    // Initialize from current state
-    // Prefer m_lastExecutedPath if Execute has already run, otherwise use m_imagePath
-    QString initialPath = m_lastExecutedPath.isEmpty() ? m_imagePath : m_lastExecutedPath;
-    w->setImagePath(initialPath);
-
-    // UI -> Node (live updates)
-    QObject::connect(w, &ImagePropertiesWidget::imagePathChanged,
-                     this, &ImageNode::setImagePath);
-
-    // Node -> UI (reflect programmatic changes)
-    QObject::connect(this, &ImageNode::imagePathChanged,
-                     w, &ImagePropertiesWidget::setImagePath);
-
-    return w;
-}
-
 TokenList ImageNode::execute(const TokenList& incomingTokens)
 {
     // Merge incoming tokens into a single DataPacket
@@ -99,7 +77,6 @@ TokenList ImageNode::execute(const TokenList& incomingTokens)
     }
 
     const QString internalPath = m_imagePath;
-    QPointer<ImagePropertiesWidget> widget = m_widget;
     QPointer<ImageNode> self(this);
 
     DataPacket output;
@@ -133,12 +110,10 @@ TokenList ImageNode::execute(const TokenList& incomingTokens)
     }
 
     // Step 3: Update UI (Thread-Safe)
-    // execute runs on a background thread in the ExecutionEngine, so we must use
-    // QMetaObject::invokeMethod to call setImagePath on the main thread
-    if (widget && !resolvedPath.isEmpty()) {
-        QMetaObject::invokeMethod(widget, "setImagePath",
-                                 Qt::QueuedConnection,
-                                 Q_ARG(QString, resolvedPath));
+    // execute runs on a background thread in the ExecutionEngine; the widget's
+    // connection to this signal is queued onto the main thread
+    if (!resolvedPath.isEmpty()) {
+        emit displayPathChanged(resolvedPath);
     }
 
     // Step 3: Output
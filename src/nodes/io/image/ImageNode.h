@@ -24,15 +24,13 @@
 #pragma once
 
 #include <QObject>
-#include <QWidget>
 #include <QFuture>
 #include <QString>
-#include <QPointer>
 
 #include "IToolNode.h"
 #include "CommonDataTypes.h"
 
-class ImagePropertiesWidget;
+class QWidget;
 
 class ImageNode : public QObject, public IToolNode {
     Q_OBJECT
@@ -43,7 +41,8 @@ public:
 
     // IToolNode interface
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in ImagePropertiesWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     TokenList execute(const TokenList& incomingTokens) override;
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
@@ -56,6 +55,8 @@ public slots:
 
 signals:
     void imagePathChanged(const QString& path);
+    // The path execute() resolved, emitted from the engine's worker thread
+    void displayPathChanged(const QString& path);
 
 public:
     static constexpr const char* kImagePinId = "image";
@@ -63,5 +64,4 @@ public:
 private:
     QString m_imagePath;
     QString m_lastExecutedPath; // Last resolved path from Execute (for late widget initialization)
-    QPointer<ImagePropertiesWidget> m_widget;
 };
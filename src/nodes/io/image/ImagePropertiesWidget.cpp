@@ -22,7 +22,9 @@
 // SOFTWARE.
 //
 #include "ImagePropertiesWidget.h"
+#include "ImageNode.h"
 #include "ImagePopupDialog.h"
+#include "ImageThumbnailService.h"
 #include <QFileDialog>
 #include <QPixmap>
 #include <QEvent>
@@ -88,6 +90,8 @@ ImagePropertiesWidget::ImagePropertiesWidget(QWidget* parent)
 
     // Connect view full size button
     connect(m_viewFullSizeButton, &QPushButton::clicked, this, &ImagePropertiesWidget::onViewFullSize);
+    connect(&m_thumbnailWatcher, &QFutureWatcher<QImage>::finished,
+            this, &ImagePropertiesWidget::onThumbnailReady);
 
     layout->addStretch();
 }
@@ -106,18 +110,40 @@ void ImagePropertiesWidget::setImagePath(const QString& path)
         }
     }
     
-    // Load the image into m_originalPixmap
+    // Decode a preview-sized copy off the GUI thread
     if (path.isEmpty()) {
-        m_originalPixmap = QPixmap();
+        m_thumbnailPixmap = QPixmap();
+        updatePreview();
     } else {
-        m_originalPixmap.load(path);
-        // Verify that the pixmap loaded successfully
-        if (m_originalPixmap.isNull()) {
-            CP_WARN << "ImagePropertiesWidget::setImagePath: Failed to load image from path:" << path;
+        requestThumbnail();
+    }
+}
+
+void ImagePropertiesWidget::requestThumbnail()
+{
+    // One decode at a time; paths set meanwhile are caught up when it finishes
+    if (m_thumbnailWatcher.isRunning()) {
+        return;
+    }
+    m_thumbnailPath = m_currentPath;
+    m_thumbnailWatcher.setFuture(ImageThumbnailService::shared()->thumbnail(
+        m_thumbnailPath, QSize(kPreviewWidth, kPreviewWidth * 4)));
+}
+
+void ImagePropertiesWidget::onThumbnailReady()
+{
+    if (m_thumbnailPath != m_currentPath) {
+        if (m_currentPath.isEmpty()) {
+            return;
         }
+        requestThumbnail();
+        return;
+    }
+
+    m_thumbnailPixmap = QPixmap::fromImage(m_thumbnailWatcher.result());
+    if (m_thumbnailPixmap.isNull()) {
+        CP_WARN << "ImagePropertiesWidget: Failed to load image from path:" << m_currentPath;
     }
-    
-    // Update the preview
     updatePreview();
 }
 
@@ -136,7 +162,7 @@ void ImagePropertiesWidget::updatePreview()
         return;
     }
     
-    if (m_originalPixmap.isNull()) {
+    if (m_thumbnailPixmap.isNull()) {
         // Clear preview
         m_previewLabel->clear();
         m_previewLabel->setText(tr("No image selected"));
@@ -160,7 +186,7 @@ void ImagePropertiesWidget::updatePreview()
         // Step 1: Scale the image to fit the available width exactly, maintaining aspect ratio
         // Critical: Use scaledToWidth() to ensure the image fills the panel width
         // The height will scale proportionally, and if it exceeds 300px, it will be cropped below
-        QPixmap scaled = m_originalPixmap.scaledToWidth(
+        QPixmap scaled = m_thumbnailPixmap.scaledToWidth(
             availableWidth,
             Qt::SmoothTransformation
         );
@@ -210,12 +236,36 @@ void ImagePropertiesWidget::showEvent(QShowEvent* event)
 void ImagePropertiesWidget::onViewFullSize()
 {
     // Check if we have a valid image
-    if (m_currentPath.isEmpty() || m_originalPixmap.isNull()) {
+    if (m_currentPath.isEmpty() || m_thumbnailPixmap.isNull()) {
         CP_WARN << "ImagePropertiesWidget::onViewFullSize: No valid image to display";
         return;
     }
     
-    // Create and show the popup dialog
-    ImagePopupDialog dialog(m_originalPixmap, this);
+    // The popup is the one place that decodes the full-resolution image
+    ImagePopupDialog dialog(m_currentPath, this);
     dialog.exec();
 }
+
+QWidget* ImageNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* w = new ImagePropertiesWidget(parent);
+
+    // Initialize from current state
+    // Prefer m_lastExecutedPath if Execute has already run, otherwise use m_imagePath
+    QString initialPath = m_lastExecutedPath.isEmpty() ? m_imagePath : m_lastExecutedPath;
+    w->setImagePath(initialPath);
+
+    // UI -> Node (live updates)
+    QObject::connect(w, &ImagePropertiesWidget::imagePathChanged,
+                     this, &ImageNode::setImagePath);
+
+    // Node -> UI (reflect programmatic changes)
+    QObject::connect(this, &ImageNode::imagePathChanged,
+                     w, &ImagePropertiesWidget::setImagePath);
+
+    // Execute -> UI (queued from the engine's worker thread)
+    QObject::connect(this, &ImageNode::displayPathChanged,
+                     w, &ImagePropertiesWidget::setImagePath);
+
+    return w;
+}
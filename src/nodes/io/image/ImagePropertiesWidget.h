@@ -23,6 +23,8 @@
 //
 #pragma once
 
+#include <QFutureWatcher>
+#include <QImage>
 #include <QWidget>
 #include <QLabel>
 #include <QPushButton>
@@ -33,6 +35,9 @@
 class ImagePropertiesWidget : public QWidget {
     Q_OBJECT
 public:
+    // Widest preview decoded, enough for a wide panel on a 2x display
+    static constexpr int kPreviewWidth = 768;
+
     explicit ImagePropertiesWidget(QWidget* parent = nullptr);
     ~ImagePropertiesWidget() override = default;
 
@@ -49,6 +54,7 @@ signals:
 
 private slots:
     void onViewFullSize();
+    void onThumbnailReady();
 
 protected:
     bool eventFilter(QObject* watched, QEvent* event) override;
@@ -57,12 +63,16 @@ protected:
 
 private:
     void updatePreview();
+    void requestThumbnail();
 
     QLabel* m_previewLabel {nullptr};
     QLabel* m_pathLabel {nullptr};
     QPushButton* m_selectButton {nullptr};
     QPushButton* m_viewFullSizeButton {nullptr};
-    QPixmap m_originalPixmap;
+    // Downscaled copy from ImageThumbnailService; only the popup loads full resolution
+    QPixmap m_thumbnailPixmap;
     QString m_currentPath;
+    QString m_thumbnailPath;
+    QFutureWatcher<QImage> m_thumbnailWatcher;
     bool m_isLayoutReady = false;
 };
@@ -0,0 +1,186 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "ImageThumbnailService.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QIODevice>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <QThread>
+#include <QtConcurrent>
+
+namespace {
+
+QMutex g_sharedMutex;
+std::shared_ptr<ImageThumbnailService> g_shared;
+
+} // namespace
+
+ImageThumbnailService::ImageThumbnailService(const QString& directory, qint64 maxBytes)
+    : m_directory(directory.isEmpty() ? QString() : QDir::cleanPath(directory))
+{
+    if (!m_directory.isEmpty()) {
+        m_disk = std::make_unique<DiskLruStore>(m_directory, maxBytes > 0 ? maxBytes : kDefaultMaxBytes,
+                                                QStringList{QStringLiteral("*.png")});
+    }
+    // Leave most of the machine to the pipeline that produces the images
+    m_pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount() / 2, 4));
+}
+
+ImageThumbnailService::~ImageThumbnailService()
+{
+    m_pool.waitForDone();
+}
+
+std::shared_ptr<ImageThumbnailService> ImageThumbnailService::shared()
+{
+    QMutexLocker locker(&g_sharedMutex);
+    if (!g_shared) {
+        const QString configured = qEnvironmentVariable("CP_THUMBNAIL_CACHE").trimmed();
+        QString directory;
+        if (configured.isEmpty() || configured == QStringLiteral("1")) {
+            directory = defaultDirectory();
+        } else if (configured != QStringLiteral("0")) {
+            directory = configured;
+        }
+        g_shared = std::make_shared<ImageThumbnailService>(directory);
+    }
+    return g_shared;
+}
+
+void ImageThumbnailService::setShared(std::shared_ptr<ImageThumbnailService> service)
+{
+    QMutexLocker locker(&g_sharedMutex);
+    g_shared = std::move(service);
+}
+
+QString ImageThumbnailService::defaultDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/thumbnails");
+}
+
+QString ImageThumbnailService::makeKey(const QString& absolutePath, qint64 size, qint64 modifiedMs,
+                                       const QSize& bound)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    DiskLruStore::addField(hash, absolutePath.toUtf8());
+    DiskLruStore::addField(hash, QByteArray::number(size));
+    DiskLruStore::addField(hash, QByteArray::number(modifiedMs));
+    DiskLruStore::addField(hash, QByteArray::number(bound.width()) + 'x' + QByteArray::number(bound.height()));
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QFuture<QImage> ImageThumbnailService::thumbnail(const QString& path, const QSize& bound)
+{
+    return QtConcurrent::run(&m_pool, [this, path, bound]() { return load(path, bound); });
+}
+
+QImage ImageThumbnailService::load(const QString& path, const QSize& bound)
+{
+    const QFileInfo info(path);
+    if (!info.isFile() || !bound.isValid() || bound.isEmpty()) {
+        return QImage();
+    }
+    const QString key = makeKey(info.absoluteFilePath(), info.size(),
+                                info.lastModified().toMSecsSinceEpoch(), bound);
+    {
+        QMutexLocker locker(&m_mutex);
+        if (const QImage* cached = m_images.object(key)) {
+            return *cached;
+        }
+    }
+
+    QImage image;
+    if (m_disk) {
+        const QString entry = entryPath(key);
+        if (image.load(entry, "PNG")) {
+            ++m_diskHits;
+            m_disk->touch(entry);
+        }
+    }
+    if (image.isNull()) {
+        bool downscaled = false;
+        image = decode(path, bound, &downscaled);
+        if (image.isNull()) {
+            return image;
+        }
+        // Small images decode about as fast as a cached copy would
+        if (downscaled && m_disk) {
+            store(key, image);
+        }
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_images.insert(key, new QImage(image), static_cast<int>(qMin<qsizetype>(image.sizeInBytes(), kMemoryBytes)));
+    return image;
+}
+
+QImage ImageThumbnailService::decode(const QString& path, const QSize& bound, bool* downscaled)
+{
+    QImageReader reader(path);
+    const QSize size = reader.size();
+    *downscaled = size.isValid() && (size.width() > bound.width() || size.height() > bound.height());
+    if (*downscaled) {
+        // The decoder only produces the pixels it is asked for
+        reader.setScaledSize(size.scaled(bound, Qt::KeepAspectRatio));
+    }
+    QImage image = reader.read();
+    if (!size.isValid() && !image.isNull()
+        && (image.width() > bound.width() || image.height() > bound.height())) {
+        // Formats that cannot report their size up front are shrunk after decoding
+        image = image.scaled(bound, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        *downscaled = true;
+    }
+    return image;
+}
+
+QString ImageThumbnailService::entryPath(const QString& key) const
+{
+    return m_disk->entryPath(key, QStringLiteral(".png"));
+}
+
+void ImageThumbnailService::store(const QString& key, const QImage& image)
+{
+    m_disk->write(entryPath(key), [&image](QIODevice* file) { return image.save(file, "PNG"); });
+}
+
+qint64 ImageThumbnailService::sizeBytes() const
+{
+    return m_disk ? m_disk->sizeBytes() : 0;
+}
+
+void ImageThumbnailService::clear()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_images.clear();
+    }
+    if (m_disk) {
+        m_disk->clear();
+    }
+}
@@ -0,0 +1,98 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QCache>
+#include <QFuture>
+#include <QImage>
+#include <QMutex>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+
+#include <atomic>
+#include <memory>
+
+#include "DiskLruStore.h"
+
+// Downscaled previews of image files, decoded off the GUI thread.
+//
+// QImageReader::setScaledSize() lets the decoder skip most of the pixels of a
+// large image, so a 4K render costs a fraction of a full load. Thumbnails are
+// keyed on the file's absolute path, size and modification time plus the
+// bounding box asked for, kept in memory (kMemoryBytes, least recently used)
+// and, for images that had to be shrunk, on disk as PNG in a DiskLruStore under
+// directory() trimmed to maxBytes.
+//
+// The shared instance keeps its files in defaultDirectory() unless
+// CP_THUMBNAIL_CACHE names another directory; "0" keeps thumbnails in memory only.
+class ImageThumbnailService {
+public:
+    static constexpr qint64 kDefaultMaxBytes = 256LL * 1024 * 1024;
+    static constexpr int kMemoryBytes = 32 * 1024 * 1024;
+
+    // An empty directory keeps thumbnails in memory only
+    explicit ImageThumbnailService(const QString& directory, qint64 maxBytes = kDefaultMaxBytes);
+    // Waits for decodes in flight
+    ~ImageThumbnailService();
+
+    ImageThumbnailService(const ImageThumbnailService&) = delete;
+    ImageThumbnailService& operator=(const ImageThumbnailService&) = delete;
+
+    static std::shared_ptr<ImageThumbnailService> shared();
+    static void setShared(std::shared_ptr<ImageThumbnailService> service);
+    static QString defaultDirectory();
+
+    static QString makeKey(const QString& absolutePath, qint64 size, qint64 modifiedMs, const QSize& bound);
+
+    // Decodes on the service's own pool; the image fits within bound and is
+    // null when the file cannot be read.
+    QFuture<QImage> thumbnail(const QString& path, const QSize& bound);
+
+    // The same, on the calling thread
+    QImage load(const QString& path, const QSize& bound);
+
+    const QString& directory() const { return m_directory; }
+
+    // Thumbnails read back from disk rather than decoded from the source
+    int diskHits() const { return m_diskHits.load(); }
+
+    qint64 sizeBytes() const;
+
+    void clear();
+
+private:
+    static QImage decode(const QString& path, const QSize& bound, bool* downscaled);
+    QString entryPath(const QString& key) const;
+    void store(const QString& key, const QImage& image);
+
+    QString m_directory;
+    // Null while thumbnails stay in memory only
+    std::unique_ptr<DiskLruStore> m_disk;
+    mutable QMutex m_mutex;
+    QCache<QString, QImage> m_images {kMemoryBytes};
+    std::atomic<int> m_diskHits {0};
+    // Last, so running decodes finish before the members they use go away
+    QThreadPool m_pool;
+};
@@ -1,29 +1,20 @@
 #include "IngestInputNode.h"
+#include "BlobHandle.h"
 
-#include "IngestInputPropertiesWidget.h"
-#include "MainWindow.h"
-#include "NodeGraphModel.h"
-#include "ToolNodeDelegate.h"
-
-#include <QApplication>
-#include <QClipboard>
+#include <QBuffer>
 #include <QCoreApplication>
+#include <QCryptographicHash>
 #include <QFile>
 #include <QFileInfo>
 #include <QImage>
 #include <QJsonObject>
-#include <QMetaObject>
 #include <QMimeData>
 #include <QMimeDatabase>
-#include <QPixmap>
 #include <QSaveFile>
 #include <QStandardPaths>
 #include <QTextStream>
-#include <QDateTime>
 #include <QDir>
-#include <QUuid>
 #include <QUrl>
-#include <limits>
 
 namespace {
 
@@ -93,6 +84,24 @@ bool readUtf8File(const QString& path, QString* contentOut)
     return true;
 }
 
+// Clipboard payloads are named by content, so pasting the same screenshot or text
+// again reuses the file already in the ingest directory instead of writing another
+QString storeByContent(const QString& dirPath, const QByteArray& bytes, const QString& suffix)
+{
+    const QString hash = QString::fromLatin1(QCryptographicHash::hash(bytes, QCryptographicHash::Sha256).toHex().left(32));
+    const QString filePath = QDir(dirPath).filePath(QStringLiteral("clipboard_%1.%2").arg(hash, suffix));
+    if (QFileInfo(filePath).size() == bytes.size()) {
+        return filePath;
+    }
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return {};
+    }
+    file.write(bytes);
+    return file.commit() ? filePath : QString();
+}
+
 } // namespace
 
 IngestInputNode::IngestInputNode(QObject* parent)
@@ -127,23 +136,6 @@ NodeDescriptor IngestInputNode::getDescriptor() const
     return desc;
 }
 
-QWidget* IngestInputNode::createConfigurationWidget(QWidget* parent)
-{
-    if (!m_widget) {
-        auto* widget = new IngestInputPropertiesWidget(parent);
-        connect(widget, &IngestInputPropertiesWidget::fileChosen,
-                this, &IngestInputNode::ingestFile);
-        connect(widget, &IngestInputPropertiesWidget::clipboardPasteRequested,
-                this, &IngestInputNode::ingestClipboard);
-        m_widget = widget;
-        updateWidget();
-    } else if (parent && m_widget->parent() != parent) {
-        m_widget->setParent(parent);
-    }
-
-    return m_widget;
-}
-
 TokenList IngestInputNode::execute(const TokenList& /*incomingTokens*/)
 {
     DataPacket output;
@@ -151,23 +143,33 @@ TokenList IngestInputNode::execute(const TokenList& /*incomingTokens*/)
     if (m_sourcePath.trimmed().isEmpty()) {
         const QString msg = QStringLiteral("No ingested content selected.");
         output.insert(QStringLiteral("__error"), msg);
-        setStatusMessage(QStringLiteral("Status: %1").arg(msg));
+        emit statusMessageChanged(QStringLiteral("Status: %1").arg(msg));
     } else {
         output.insert(QString::fromLatin1(kOutputFilePathId), m_sourcePath);
         output.insert(QString::fromLatin1(kOutputMimeTypeId), m_mimeType);
         output.insert(QString::fromLatin1(kOutputKindId), m_kind);
 
         if (m_kind == QStringLiteral("markdown") || m_kind == QStringLiteral("text")) {
+            const QString pinId = (m_kind == QStringLiteral("markdown"))
+                ? QString::fromLatin1(kOutputMarkdownId)
+                : QString::fromLatin1(kOutputTextId);
             QString content;
-            if (readUtf8File(m_sourcePath, &content)) {
-                const QString pinId = (m_kind == QStringLiteral("markdown"))
-                    ? QString::fromLatin1(kOutputMarkdownId)
-                    : QString::fromLatin1(kOutputTextId);
+            BlobHandle blob;
+            // Large documents travel as a file-backed handle and are only decoded by
+            // the nodes that read them. Keeping the last snapshot alive lets a re-run
+            // of unchanged content share it rather than snapshot the file again.
+            if (QFileInfo(m_sourcePath).size() > BlobHandle::spillThreshold()) {
+                blob = BlobHandle::fromFile(m_sourcePath, m_mimeType);
+                m_snapshot = blob;
+            }
+            if (!blob.isNull()) {
+                output.insert(pinId, QVariant::fromValue(blob));
+            } else if (readUtf8File(m_sourcePath, &content)) {
                 output.insert(pinId, content);
             } else {
                 const QString msg = QStringLiteral("Failed to read ingested file: %1").arg(m_sourcePath);
                 output.insert(QStringLiteral("__error"), msg);
-                setStatusMessage(QStringLiteral("Status: %1").arg(msg));
+                emit statusMessageChanged(QStringLiteral("Status: %1").arg(msg));
             }
         } else if (m_kind == QStringLiteral("image")) {
             output.insert(QString::fromLatin1(kOutputImageId), m_sourcePath);
@@ -176,7 +178,7 @@ TokenList IngestInputNode::execute(const TokenList& /*incomingTokens*/)
         }
 
         if (!output.contains(QStringLiteral("__error"))) {
-            setStatusMessage(QStringLiteral("Status: emitted %1 from %2").arg(m_kind, m_sourcePath));
+            emit statusMessageChanged(QStringLiteral("Status: emitted %1 from %2").arg(m_kind, m_sourcePath));
         }
     }
 
@@ -208,73 +210,67 @@ void IngestInputNode::loadState(const QJsonObject& data)
         m_kind = classifyKind(m_sourcePath, m_mimeType);
     }
 
-    updateWidget();
+    publishPayload();
 }
 
 void IngestInputNode::ingestFile(const QString& path)
 {
     if (!ingestLocalFile(path)) {
-        setStatusMessage(QStringLiteral("Status: failed to ingest file %1").arg(path));
+        emit statusMessageChanged(QStringLiteral("Status: failed to ingest file %1").arg(path));
         return;
     }
 
-    setStatusMessage(QStringLiteral("Status: ingested %1").arg(m_sourcePath));
+    emit statusMessageChanged(QStringLiteral("Status: ingested %1").arg(m_sourcePath));
     requestImmediateRun();
 }
 
-void IngestInputNode::ingestClipboard()
+void IngestInputNode::ingestClipboard(const QMimeData* mimeData)
 {
-    QClipboard* clipboard = QApplication::clipboard();
-    if (!clipboard) {
-        setStatusMessage(QStringLiteral("Status: clipboard is not available."));
-        return;
-    }
-
-    const QMimeData* mimeData = clipboard->mimeData();
     if (!mimeData) {
-        setStatusMessage(QStringLiteral("Status: clipboard is empty."));
+        emit statusMessageChanged(QStringLiteral("Status: clipboard is empty."));
         return;
     }
 
     const QList<QUrl> urls = mimeData->urls();
     for (const QUrl& url : urls) {
         if (url.isLocalFile() && ingestLocalFile(url.toLocalFile())) {
-            setStatusMessage(QStringLiteral("Status: ingested clipboard file %1").arg(m_sourcePath));
+            emit statusMessageChanged(QStringLiteral("Status: ingested clipboard file %1").arg(m_sourcePath));
             requestImmediateRun();
             return;
         }
     }
 
-    const QImage image = clipboard->image();
+    const QImage image = qvariant_cast<QImage>(mimeData->imageData());
     if (!image.isNull() && ingestClipboardImage(image)) {
-        setStatusMessage(QStringLiteral("Status: ingested clipboard image."));
+        emit statusMessageChanged(QStringLiteral("Status: ingested clipboard image."));
         requestImmediateRun();
         return;
     }
 
     const QString text = mimeData->text().trimmed();
     if (!text.isEmpty() && ingestClipboardText(text)) {
-        setStatusMessage(QStringLiteral("Status: ingested clipboard text."));
+        emit statusMessageChanged(QStringLiteral("Status: ingested clipboard text."));
         requestImmediateRun();
         return;
     }
 
-    setStatusMessage(QStringLiteral("Status: clipboard did not contain a supported file, image, or text payload."));
+    emit statusMessageChanged(QStringLiteral("Status: clipboard did not contain a supported file, image, or text payload."));
 }
 
 bool IngestInputNode::ingestLocalFile(const QString& path)
 {
     const QFileInfo fileInfo(path);
     if (!fileInfo.exists() || !fileInfo.isFile()) {
-        setStatusMessage(QStringLiteral("Status: file does not exist: %1").arg(path));
+        emit statusMessageChanged(QStringLiteral("Status: file does not exist: %1").arg(path));
         return false;
     }
 
     QMimeDatabase mimeDb;
+    m_snapshot = BlobHandle();
     m_sourcePath = fileInfo.absoluteFilePath();
     m_mimeType = mimeDb.mimeTypeForFile(m_sourcePath).name();
     m_kind = classifyKind(m_sourcePath, m_mimeType);
-    updateWidget();
+    publishPayload();
     return true;
 }
 
@@ -292,16 +288,15 @@ bool IngestInputNode::ingestClipboardImage(const QImage& image)
         return false;
     }
 
-    const QString filePath = QDir(dirPath).filePath(
-        QStringLiteral("clipboard_%1_%2.png")
-            .arg(QDateTime::currentDateTimeUtc().toString(QStringLiteral("yyyyMMdd_HHmmss")))
-            .arg(QUuid::createUuid().toString(QUuid::Id128)));
-
-    if (!image.save(filePath, "PNG")) {
+    QByteArray png;
+    QBuffer buffer(&png);
+    buffer.open(QIODevice::WriteOnly);
+    if (!image.save(&buffer, "PNG")) {
         return false;
     }
 
-    return ingestLocalFile(filePath);
+    const QString filePath = storeByContent(dirPath, png, QStringLiteral("png"));
+    return !filePath.isEmpty() && ingestLocalFile(filePath);
 }
 
 bool IngestInputNode::ingestClipboardText(const QString& text)
@@ -319,111 +314,37 @@ bool IngestInputNode::ingestClipboardText(const QString& text)
         return false;
     }
 
-    const QString filePath = QDir(dirPath).filePath(
-        QStringLiteral("clipboard_%1_%2.md")
-            .arg(QDateTime::currentDateTimeUtc().toString(QStringLiteral("yyyyMMdd_HHmmss")))
-            .arg(QUuid::createUuid().toString(QUuid::Id128)));
-
-    QSaveFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        return false;
-    }
-    file.write(text.toUtf8());
-    if (!file.commit()) {
-        return false;
-    }
-
-    return ingestLocalFile(filePath);
+    const QString filePath = storeByContent(dirPath, text.toUtf8(), QStringLiteral("md"));
+    return !filePath.isEmpty() && ingestLocalFile(filePath);
 }
 
-void IngestInputNode::updateWidget()
+void IngestInputNode::publishPayload()
 {
-    if (!m_widget) {
-        return;
-    }
-
     if (m_sourcePath.isEmpty()) {
-        m_widget->clearPayload();
-        return;
-    }
-
-    QPixmap previewPixmap;
-    if (m_kind == QStringLiteral("image")) {
-        previewPixmap.load(m_sourcePath);
-    }
-
-    m_widget->setPayload(m_kind,
-                         m_sourcePath,
-                         m_mimeType,
-                         previewTextForPath(m_sourcePath, m_kind),
-                         previewPixmap);
-}
-
-void IngestInputNode::setStatusMessage(const QString& message)
-{
-    auto* widget = m_widget.data();
-    if (!widget) {
+        emit payloadChanged(QString(), QString(), QString(), QString());
         return;
     }
 
-    QMetaObject::invokeMethod(widget, [widget, message]() {
-        widget->setStatusMessage(message);
-    }, Qt::QueuedConnection);
+    emit payloadChanged(m_kind, m_sourcePath, m_mimeType, previewTextForPath(m_sourcePath, m_kind));
 }
 
-void IngestInputNode::requestImmediateRun()
+void IngestInputNode::setRunRequestHandler(RunRequestHandler handler)
 {
-    MainWindow* mainWindow = findMainWindow();
-    if (!mainWindow) {
-        return;
-    }
-
-    const unsigned int nodeId = resolveNodeId(mainWindow);
-    if (nodeId == std::numeric_limits<unsigned int>::max()) {
-        return;
-    }
-
-    QMetaObject::invokeMethod(mainWindow, [mainWindow, nodeId]() {
-        mainWindow->runScenarioFromNodeId(nodeId);
-    }, Qt::QueuedConnection);
+    runRequestHandler() = std::move(handler);
 }
 
-MainWindow* IngestInputNode::findMainWindow() const
+IngestInputNode::RunRequestHandler& IngestInputNode::runRequestHandler()
 {
-    QWidget* activeWindow = QApplication::activeWindow();
-    if (activeWindow) {
-        if (auto* mainWindow = qobject_cast<MainWindow*>(activeWindow)) {
-            return mainWindow;
-        }
-    }
-
-    for (QWidget* widget : QApplication::topLevelWidgets()) {
-        if (auto* mainWindow = qobject_cast<MainWindow*>(widget)) {
-            return mainWindow;
-        }
-    }
-
-    return nullptr;
+    static RunRequestHandler handler;
+    return handler;
 }
 
-unsigned int IngestInputNode::resolveNodeId(const MainWindow* mainWindow) const
+void IngestInputNode::requestImmediateRun()
 {
-    if (!mainWindow || !mainWindow->graphModel()) {
-        return std::numeric_limits<unsigned int>::max();
+    // Only the editor can start a run; without one the ingested content waits for the next
+    if (const RunRequestHandler& handler = runRequestHandler()) {
+        handler(this);
     }
-
-    IToolNode* selfTool = const_cast<IngestInputNode*>(this);
-    for (auto nodeId : mainWindow->graphModel()->allNodeIds()) {
-        auto* delegate = mainWindow->graphModel()->delegateModel<ToolNodeDelegate>(nodeId);
-        if (!delegate || !delegate->node()) {
-            continue;
-        }
-        if (delegate->node().get() == selfTool) {
-            return nodeId;
-        }
-    }
-
-    return std::numeric_limits<unsigned int>::max();
 }
 
 QString IngestInputNode::cacheDirectoryPath() const
@@ -1,13 +1,15 @@
 #pragma once
 
 #include <QObject>
-#include <QPointer>
 
+#include <functional>
+
+#include "BlobHandle.h"
 #include "IToolNode.h"
 
-class IngestInputPropertiesWidget;
-class MainWindow;
 class QImage;
+class QMimeData;
+class QWidget;
 
 class IngestInputNode : public QObject, public IToolNode {
     Q_OBJECT
@@ -17,7 +19,8 @@ public:
     ~IngestInputNode() override = default;
 
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in IngestInputPropertiesWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     TokenList execute(const TokenList& incomingTokens) override;
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
@@ -30,24 +33,35 @@ public:
     static constexpr const char* kOutputMimeTypeId = "mime_type";
     static constexpr const char* kOutputKindId = "kind";
 
+    // Starts a run from the node after a drop or paste. The GUI installs it (on its
+    // thread) to find the node in its graph; headless builds have none.
+    using RunRequestHandler = std::function<void(IToolNode* node)>;
+    static void setRunRequestHandler(RunRequestHandler handler);
+
+signals:
+    // The ingested content changed; an empty path means nothing is ingested
+    void payloadChanged(const QString& kind, const QString& path,
+                        const QString& mimeType, const QString& previewText);
+    void statusMessageChanged(const QString& message);
+
 public slots:
     void ingestFile(const QString& path);
-    void ingestClipboard();
+    // Takes a file URL, an image or text from pasted data (the editor passes its clipboard)
+    void ingestClipboard(const QMimeData* mimeData);
 
 private:
     bool ingestLocalFile(const QString& path);
     bool ingestClipboardImage(const QImage& image);
     bool ingestClipboardText(const QString& text);
-    void updateWidget();
-    void setStatusMessage(const QString& message);
+    void publishPayload();
     void requestImmediateRun();
-    MainWindow* findMainWindow() const;
-    unsigned int resolveNodeId(const MainWindow* mainWindow) const;
+    static RunRequestHandler& runRequestHandler();
 
     QString cacheDirectoryPath() const;
 
     QString m_sourcePath;
     QString m_mimeType;
     QString m_kind;
-    QPointer<IngestInputPropertiesWidget> m_widget;
+    // Snapshot of the last large text payload, shared by re-runs of unchanged content
+    BlobHandle m_snapshot;
 };
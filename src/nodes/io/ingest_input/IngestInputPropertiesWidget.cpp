@@ -1,5 +1,8 @@
 #include "IngestInputPropertiesWidget.h"
+#include "IngestInputNode.h"
 
+#include <QApplication>
+#include <QClipboard>
 #include <QDragEnterEvent>
 #include <QDropEvent>
 #include <QFileDialog>
@@ -156,3 +159,38 @@ void IngestInputPropertiesWidget::updatePreviewVisibility(bool hasTextPreview, b
     m_textPreviewEdit->setVisible(hasTextPreview);
     m_imagePreviewLabel->setVisible(hasImagePreview);
 }
+
+QWidget* IngestInputNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* widget = new IngestInputPropertiesWidget(parent);
+    connect(widget, &IngestInputPropertiesWidget::fileChosen,
+            this, &IngestInputNode::ingestFile);
+    connect(widget, &IngestInputPropertiesWidget::clipboardPasteRequested, this, [this]() {
+        QClipboard* clipboard = QApplication::clipboard();
+        if (!clipboard) {
+            emit statusMessageChanged(QStringLiteral("Status: clipboard is not available."));
+            return;
+        }
+        ingestClipboard(clipboard->mimeData());
+    });
+
+    const auto showPayload = [widget](const QString& kind, const QString& path,
+                                      const QString& mimeType, const QString& previewText) {
+        if (path.isEmpty()) {
+            widget->clearPayload();
+            return;
+        }
+
+        QPixmap previewPixmap;
+        if (kind == QStringLiteral("image")) {
+            previewPixmap.load(path);
+        }
+        widget->setPayload(kind, path, mimeType, previewText, previewPixmap);
+    };
+    connect(this, &IngestInputNode::payloadChanged, widget, showPayload);
+    connect(this, &IngestInputNode::statusMessageChanged,
+            widget, &IngestInputPropertiesWidget::setStatusMessage);
+    publishPayload();
+
+    return widget;
+}
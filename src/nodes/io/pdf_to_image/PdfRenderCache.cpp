@@ -0,0 +1,134 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "PdfRenderCache.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+
+namespace {
+
+QMutex g_sharedMutex;
+std::shared_ptr<PdfRenderCache> g_shared;
+bool g_sharedConfigured = false;
+
+} // namespace
+
+PdfRenderCache::PdfRenderCache(const QString& directory, qint64 maxBytes)
+    : m_store(directory, maxBytes > 0 ? maxBytes : kDefaultMaxBytes, {QStringLiteral("*.img")})
+{
+}
+
+std::shared_ptr<PdfRenderCache> PdfRenderCache::shared()
+{
+    QMutexLocker locker(&g_sharedMutex);
+    if (!g_sharedConfigured) {
+        g_sharedConfigured = true;
+        const QString configured = qEnvironmentVariable("CP_PDF_RENDER_CACHE").trimmed();
+        if (configured.isEmpty() || configured == QStringLiteral("1")) {
+            g_shared = std::make_shared<PdfRenderCache>(defaultDirectory());
+        } else if (configured != QStringLiteral("0")) {
+            g_shared = std::make_shared<PdfRenderCache>(configured);
+        }
+    }
+    return g_shared;
+}
+
+void PdfRenderCache::setShared(std::shared_ptr<PdfRenderCache> cache)
+{
+    QMutexLocker locker(&g_sharedMutex);
+    g_shared = std::move(cache);
+    g_sharedConfigured = true;
+}
+
+QString PdfRenderCache::defaultDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/pdf_renders");
+}
+
+QByteArray PdfRenderCache::documentHash(const QString& pdfPath)
+{
+    const QFileInfo info(pdfPath);
+    const QString path = info.absoluteFilePath();
+    {
+        QMutexLocker locker(&m_mutex);
+        const auto it = m_hashes.constFind(path);
+        if (it != m_hashes.cend() && it->size == info.size() && it->modified == info.lastModified()) {
+            return it->hash;
+        }
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if (!hash.addData(&file)) {
+        return QByteArray();
+    }
+    const QByteArray result = hash.result();
+
+    QMutexLocker locker(&m_mutex);
+    m_hashes.insert(path, HashedFile{info.size(), info.lastModified(), result});
+    return result;
+}
+
+QString PdfRenderCache::makeKey(const QByteArray& documentHash, const QString& variant, qreal scale,
+                                const QByteArray& format, int pngCompression, int quality)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    DiskLruStore::addField(hash, documentHash);
+    DiskLruStore::addField(hash, variant.toUtf8());
+    DiskLruStore::addField(hash, QByteArray::number(scale, 'g', 6));
+    DiskLruStore::addField(hash, format);
+    // Only the setting the format reads changes its bytes
+    DiskLruStore::addField(hash, QByteArray::number(format == "png" ? pngCompression : quality));
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QString PdfRenderCache::entryPath(const QString& key) const
+{
+    return m_store.entryPath(key, QStringLiteral(".img"));
+}
+
+bool PdfRenderCache::fetch(const QString& key, const QString& destinationPath)
+{
+    return !key.isEmpty() && m_store.fetch(entryPath(key), destinationPath);
+}
+
+bool PdfRenderCache::store(const QString& key, const QString& sourcePath)
+{
+    return !key.isEmpty() && m_store.store(entryPath(key), sourcePath);
+}
+
+qint64 PdfRenderCache::sizeBytes() const
+{
+    return m_store.sizeBytes();
+}
+
+void PdfRenderCache::clear()
+{
+    m_store.clear();
+}
@@ -0,0 +1,90 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+#include <memory>
+
+#include "DiskLruStore.h"
+
+// Shared on-disk cache of rendered PDF images.
+//
+// Entries are keyed on the SHA-256 of the PDF's bytes plus what shapes the
+// image (page or stitched layout, scale, format and encoder settings), so a
+// document copied to a new path or run directory still hits. A hit is hard
+// linked into the output path, falling back to a copy where links are not
+// possible, and stores link the freshly written file into the cache the same
+// way, so neither side pays for a second copy of the pixels. The files live in a
+// DiskLruStore trimmed to maxBytes.
+//
+// The shared instance lives in defaultDirectory() unless CP_PDF_RENDER_CACHE names
+// another directory; "0" turns it off.
+class PdfRenderCache {
+public:
+    static constexpr qint64 kDefaultMaxBytes = 2LL * 1024 * 1024 * 1024;
+
+    explicit PdfRenderCache(const QString& directory, qint64 maxBytes = kDefaultMaxBytes);
+
+    // The cache PdfToImageNode consults, or nullptr while caching is off.
+    static std::shared_ptr<PdfRenderCache> shared();
+    static void setShared(std::shared_ptr<PdfRenderCache> cache);
+    static QString defaultDirectory();
+
+    // SHA-256 of the file, remembered while its size and modification time hold
+    QByteArray documentHash(const QString& pdfPath);
+
+    // variant names the image within the document, e.g. "page:3" or "strip"
+    static QString makeKey(const QByteArray& documentHash, const QString& variant, qreal scale,
+                           const QByteArray& format, int pngCompression, int quality);
+
+    const QString& directory() const { return m_store.directory(); }
+
+    // Places the cached image at destinationPath, replacing any file there.
+    bool fetch(const QString& key, const QString& destinationPath);
+
+    bool store(const QString& key, const QString& sourcePath);
+
+    // Bytes of entries on disk, as tracked by this process.
+    qint64 sizeBytes() const;
+
+    void clear();
+
+private:
+    struct HashedFile {
+        qint64 size {0};
+        QDateTime modified;
+        QByteArray hash;
+    };
+
+    QString entryPath(const QString& key) const;
+
+    DiskLruStore m_store;
+    QMutex m_mutex;
+    QHash<QString, HashedFile> m_hashes;
+};
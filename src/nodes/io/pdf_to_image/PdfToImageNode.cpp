@@ -22,14 +22,21 @@
 // SOFTWARE.
 //
 #include "PdfToImageNode.h"
-#include "PdfToImagePropertiesWidget.h"
 #include "Logger.h"
+#include "NodeOutputDir.h"
+#include "CancellationToken.h"
+#include "CpuWorkerPool.h"
+#include "PartialOutputSink.h"
+#include "PdfRenderCache.h"
+#include "StreamingPngWriter.h"
 
 #include <QtConcurrent/QtConcurrent>
 #include <QJsonObject>
 #include <QPdfDocument>
+#include <QPdfSelection>
 #include <QPainter>
 #include <QImage>
+#include <QImageWriter>
 #include <QTemporaryFile>
 #include <QStandardPaths>
 #include <QDir>
@@ -38,6 +45,77 @@
 #include <QSizeF>
 #include <QRectF>
 #include <QFileInfo>
+#include <QMutex>
+#include <QThread>
+
+#include <atomic>
+#include <limits>
+#include <vector>
+
+namespace {
+
+// Pages are handed out one at a time, so a few workers keep every core busy
+constexpr int kMaxRenderWorkers = 8;
+
+struct ImageEncoding {
+    QByteArray format;
+    int pngCompression {-1};
+    int quality {90};
+};
+
+// An earlier run may have left a link into the render cache at path; writing
+// through it would change the cached entry, so the old file is unlinked first
+bool clearOutput(const QString& path, QString* error)
+{
+    if (QFileInfo::exists(path) && !QFile::remove(path)) {
+        *error = QStringLiteral("cannot replace the existing file");
+        return false;
+    }
+    return true;
+}
+
+bool saveImage(const QImage& image, const QString& path, const ImageEncoding& encoding, QString* error)
+{
+    if (!clearOutput(path, error)) {
+        return false;
+    }
+    QImageWriter writer(path, encoding.format);
+    if (encoding.format == "png") {
+        // Qt's PNG handler maps quality 0-100 onto zlib levels 9-0
+        if (encoding.pngCompression >= 0) {
+            writer.setQuality(100 - (qMin(encoding.pngCompression, 9) * 91 + 8) / 9);
+        }
+    } else {
+        writer.setQuality(encoding.quality);
+    }
+    // JPEG has no alpha channel; pages render on white, so nothing is lost
+    const bool opaque = encoding.format == "jpg";
+    if (!writer.write(opaque ? image.convertToFormat(QImage::Format_RGB888) : image)) {
+        *error = writer.errorString();
+        return false;
+    }
+    return true;
+}
+
+// Born-digital pages hold plenty of real characters; scans hold none or a few stray
+// glyphs, and fonts without a usable encoding extract as mostly symbols
+bool hasUsableText(const QString& text, int minChars)
+{
+    int visible = 0;
+    int wordChars = 0;
+    for (const QChar c : text) {
+        if (c.isSpace()) {
+            continue;
+        }
+        ++visible;
+        if (c.isLetterOrNumber()) {
+            ++wordChars;
+        }
+    }
+    return visible >= qMax(1, minChars) && wordChars * 2 >= visible;
+}
+
+} // namespace
 
 PdfToImageNode::PdfToImageNode(QObject* parent)
     : QObject(parent)
@@ -81,25 +159,21 @@ NodeDescriptor PdfToImageNode::getDescriptor() const
     pageCountPin.type = QStringLiteral("text");
     desc.outputPins.insert(pageCountPin.id, pageCountPin);
 
-    return desc;
-}
+    PinDefinition pageTextPin;
+    pageTextPin.direction = PinDirection::Output;
+    pageTextPin.id = QString::fromLatin1(kPageTextPinId);
+    pageTextPin.name = QStringLiteral("Page Text");
+    pageTextPin.type = QStringLiteral("text");
+    desc.outputPins.insert(pageTextPin.id, pageTextPin);
 
-QWidget* PdfToImageNode::createConfigurationWidget(QWidget* parent)
-{
-    if (!m_widget) {
-        m_widget = new PdfToImagePropertiesWidget(parent);
-        
-        // Connect widget signal to update internal state
-        connect(m_widget, &PdfToImagePropertiesWidget::pdfPathChanged, this, &PdfToImageNode::onPdfPathChanged);
-        connect(m_widget, &PdfToImagePropertiesWidget::splitPagesChanged, this, &PdfToImageNode::onSplitPagesChanged);
-        
-        // Initialize widget with current state
-        if (!m_pdfPath.isEmpty()) {
-            m_widget->setPdfPath(m_pdfPath);
-        }
-        m_widget->setSplitPages(m_splitPages);
-    }
-    return m_widget;
+    PinDefinition pageTextsPin;
+    pageTextsPin.direction = PinDirection::Output;
+    pageTextsPin.id = QString::fromLatin1(kPageTextsPinId);
+    pageTextsPin.name = QStringLiteral("Page Texts");
+    pageTextsPin.type = QStringLiteral("json");
+    desc.outputPins.insert(pageTextsPin.id, pageTextsPin);
+
+    return desc;
 }
 
 void PdfToImageNode::onPdfPathChanged(const QString& path)
@@ -134,24 +208,41 @@ TokenList PdfToImageNode::execute(const TokenList& incomingTokens)
     };
 
     // Step 1: Resolve Output Path
-    QString sysOutDir = inputs.value(QStringLiteral("_sys_node_output_dir")).toString();
+    QString sysOutDir = NodeOutputDir::materialize(inputs);
     QString outPath;
     bool isPersistent = !sysOutDir.isEmpty();
     std::unique_ptr<QTemporaryFile> tempFile;
 
-    // Capture m_splitPages for path resolution
+    // Capture m_splitPages and the encoding settings for path resolution
     const bool splitPages = m_splitPages;
+    const QString stitchMode = m_stitchMode;
+    const bool tiled = !splitPages && stitchMode == QLatin1String(kStitchTiles);
+    const bool strip = !splitPages && stitchMode == QLatin1String(kStitchStrip);
+    const bool textLayer = splitPages && m_textLayer;
+    const int minTextChars = m_minTextChars;
+    ImageEncoding encoding;
+    // The strip encoder writes PNG only
+    encoding.format = strip ? QByteArrayLiteral("png") : m_imageFormat.toLatin1();
+    encoding.pngCompression = m_pngCompression;
+    encoding.quality = m_imageQuality;
+    if (!QImageWriter::supportedImageFormats().contains(encoding.format)) {
+        return fail(QStringLiteral("Image format '%1' is not available in this Qt build").arg(m_imageFormat));
+    }
+    const QString extension = QString::fromLatin1(encoding.format);
 
     if (isPersistent) {
         // Case A: Persistent Output
-        QString fileName = splitPages ? QStringLiteral("page.png") : QStringLiteral("stitched_output.png");
-        outPath = sysOutDir + QDir::separator() + fileName;
+        QString fileName = splitPages ? QStringLiteral("page.") : tiled ? QStringLiteral("tile.") : QStringLiteral("stitched_output.");
+        outPath = sysOutDir + QDir::separator() + fileName + extension;
     } else {
         // Case B: Fallback to QTemporaryFile (System Temp)
         QString tempDir = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
         if (tempDir.isEmpty()) tempDir = QDir::tempPath();
 
-        QString templateStr = splitPages ? QStringLiteral("pdf_page_XXXXXX.png") : QStringLiteral("pdf_stitched_XXXXXX.png");
+        QString templateStr = (splitPages ? QStringLiteral("pdf_page_XXXXXX.")
+                               : tiled    ? QStringLiteral("pdf_tile_XXXXXX.")
+                                          : QStringLiteral("pdf_stitched_XXXXXX."))
+            + extension;
         tempFile = std::make_unique<QTemporaryFile>(tempDir + QDir::separator() + templateStr);
         tempFile->setAutoRemove(false);
         if (!tempFile->open()) {
@@ -225,30 +316,162 @@ TokenList PdfToImageNode::execute(const TokenList& incomingTokens)
     // Step 5: Render and Save
     const qreal scale = 2.0;
     const QString imagePathPinId = QString::fromLatin1(kImagePathPinId);
+    const PartialOutputSink sink = PartialOutputSink::current();
+    const CancellationToken cancellation = CancellationToken::current();
+
+    // Tiles are not cached: they depend on the tile height and come out as a set
+    std::shared_ptr<PdfRenderCache> cache = m_renderCache && !tiled ? PdfRenderCache::shared() : nullptr;
+    const QByteArray documentHash = cache ? cache->documentHash(absolutePdfPath) : QByteArray();
+    if (documentHash.isEmpty()) {
+        cache.reset();
+    }
+    const auto cacheKey = [&](const QString& variant) {
+        return PdfRenderCache::makeKey(documentHash, variant, scale, encoding.format, encoding.pngCompression,
+                                       encoding.quality);
+    };
+    std::atomic<int> cacheHits {0};
+
+    // Split pages and tiles are numbered files next to the resolved output path
+    QString basePath = outPath;
+    if (basePath.endsWith(QLatin1Char('.') + extension, Qt::CaseInsensitive)) {
+        basePath.chop(extension.size() + 1);
+    }
+
+    // Single-file stitches are cached whole, under the layout that produced them
+    const QString stitchedKey =
+        cache && !splitPages ? cacheKey(strip ? QStringLiteral("strip") : QStringLiteral("stitched")) : QString();
 
-    if (splitPages) {
+    if (!stitchedKey.isEmpty() && cache->fetch(stitchedKey, outPath)) {
+        CP_CLOG(PDF_DEBUG) << "Reused cached stitched render at:" << outPath;
+        cacheHits.fetch_add(1);
+        output.insert(imagePathPinId, outPath);
+        output.insert(QString::fromLatin1(kImagePathsPinId), QStringList{outPath});
+        output.insert(QString::fromLatin1(kPageCountPinId), pageCount);
+    } else if (splitPages) {
         // Mode: Split pages into separate images
         QStringList generatedPaths;
-        QString basePath = outPath;
-        if (basePath.endsWith(QStringLiteral(".png"), Qt::CaseInsensitive)) {
-            basePath.chop(4);
-        }
 
-        for (int i = 0; i < pageCount; ++i) {
-            QSizeF pageSize = pdfDoc.pagePointSize(i);
-            QSize pageImageSize(static_cast<int>(pageSize.width() * scale),
-                               static_cast<int>(pageSize.height() * scale));
+        // Each worker renders and encodes whichever page is next with its own document,
+        // and every page goes out on the image pin as soon as its file is written.
+        // With the text layer on, pages that have usable text go out on the text pin
+        // instead and are never rendered.
+        const int workers = qMin(pageCount, qBound(1, QThread::idealThreadCount(), kMaxRenderWorkers));
+        std::vector<QString> pagePaths(static_cast<std::size_t>(pageCount));
+        std::vector<QString> pageTexts(static_cast<std::size_t>(pageCount));
+        const QString pageTextPinId = QString::fromLatin1(kPageTextPinId);
+        std::atomic<int> nextPage {0};
+        std::atomic<bool> failed {false};
+        QMutex errorMutex;
+        QString error;
+
+        const auto setError = [&](const QString& msg) {
+            CP_CLOG(PDF_DEBUG) << msg;
+            QMutexLocker locker(&errorMutex);
+            if (error.isEmpty()) {
+                error = msg;
+            }
+            failed.store(true);
+        };
+
+        // Workers other than the calling thread open their own document the first
+        // time they need it, so a fully cached PDF is only parsed once
+        const auto renderPages = [&](QPdfDocument* preloaded) {
+            std::unique_ptr<QPdfDocument> ownDoc;
+            const auto document = [&]() -> QPdfDocument* {
+                if (preloaded) {
+                    return preloaded;
+                }
+                if (!ownDoc) {
+                    ownDoc = std::make_unique<QPdfDocument>();
+                    ownDoc->load(pdfPath);
+                }
+                if (ownDoc->status() != QPdfDocument::Status::Ready) {
+                    setError(QStringLiteral("Failed to load PDF: %1").arg(absolutePdfPath));
+                    return nullptr;
+                }
+                return ownDoc.get();
+            };
+            for (int i = nextPage.fetch_add(1); i < pageCount; i = nextPage.fetch_add(1)) {
+                if (failed.load() || cancellation.isCancelled()) {
+                    return;
+                }
+                if (textLayer) {
+                    QPdfDocument* doc = document();
+                    if (!doc) {
+                        return;
+                    }
+                    QString text = doc->getAllText(i).text();
+                    if (hasUsableText(text, minTextChars)) {
+                        CP_CLOG(PDF_DEBUG) << "Took page" << (i + 1) << "from the text layer," << text.size() << "chars";
+                        ExecutionToken page;
+                        page.data.insert(pageTextPinId, text);
+                        page.forceExecution = true;
+                        pageTexts[static_cast<std::size_t>(i)] = std::move(text);
+                        sink.publish(TokenList{page});
+                        continue;
+                    }
+                }
+                QString pagePath = basePath + QStringLiteral("_p%1.%2").arg(i + 1).arg(extension);
+                const QString key = cache ? cacheKey(QStringLiteral("page:%1").arg(i)) : QString();
+                if (cache && cache->fetch(key, pagePath)) {
+                    CP_CLOG(PDF_DEBUG) << "Reused cached render of page" << (i + 1) << "at:" << pagePath;
+                    cacheHits.fetch_add(1);
+                } else {
+                    QPdfDocument* doc = document();
+                    if (!doc) {
+                        return;
+                    }
+                    QSizeF pageSize = doc->pagePointSize(i);
+                    QSize pageImageSize(static_cast<int>(pageSize.width() * scale),
+                                       static_cast<int>(pageSize.height() * scale));
+
+                    QImage pageImage = doc->render(i, pageImageSize);
+
+                    QString saveError;
+                    if (!saveImage(pageImage, pagePath, encoding, &saveError)) {
+                        setError(QStringLiteral("Failed to save rendered PDF page image: %1 (%2)")
+                                     .arg(pagePath, saveError));
+                        return;
+                    }
+                    CP_CLOG(PDF_DEBUG) << "Saved page" << (i + 1) << "to:" << pagePath;
+                    if (cache) {
+                        cache->store(key, pagePath);
+                    }
+                }
+                pagePaths[static_cast<std::size_t>(i)] = pagePath;
+
+                ExecutionToken page;
+                page.data.insert(imagePathPinId, pagePath);
+                page.forceExecution = true;
+                sink.publish(TokenList{page});
+            }
+        };
 
-            QImage pageImage = pdfDoc.render(i, pageImageSize);
-            QString pagePath = basePath + QStringLiteral("_p%1.png").arg(i + 1);
+        QThreadPool* pool = CpuWorkerPool::current() ? CpuWorkerPool::current() : QThreadPool::globalInstance();
+        QList<QFuture<void>> others;
+        for (int w = 1; w < workers; ++w) {
+            others.append(QtConcurrent::run(pool, [&]() { renderPages(nullptr); }));
+        }
+        renderPages(&pdfDoc);
+        for (QFuture<void>& future : others) {
+            future.waitForFinished();
+        }
 
-            if (pageImage.save(pagePath, "PNG")) {
-                generatedPaths << pagePath;
-                CP_CLOG(PDF_DEBUG) << "Saved page" << (i + 1) << "to:" << pagePath;
+        if (failed.load()) {
+            return fail(error);
+        }
+        if (cancellation.isCancelled()) {
+            return fail(QStringLiteral("PDF rendering cancelled"));
+        }
+        QStringList texts;
+        QList<int> textPages;
+        for (int i = 0; i < pageCount; ++i) {
+            QString& text = pageTexts[static_cast<std::size_t>(i)];
+            if (!text.isNull()) {
+                texts << std::move(text);
+                textPages << i + 1;
             } else {
-                const QString msg = QStringLiteral("Failed to save rendered PDF page image: %1").arg(pagePath);
-                CP_CLOG(PDF_DEBUG) << msg;
-                return fail(msg);
+                generatedPaths << std::move(pagePaths[static_cast<std::size_t>(i)]);
             }
         }
 
@@ -258,10 +481,136 @@ TokenList PdfToImageNode::execute(const TokenList& incomingTokens)
         }
 
         output.insert(QString::fromLatin1(kImagePathsPinId), generatedPaths);
-        output.insert(imagePathPinId, generatedPaths.isEmpty() ? QString() : generatedPaths.first());
+        // Pages already streamed out one by one; repeating the first would run it twice downstream
+        if (!sink.isActive()) {
+            output.insert(imagePathPinId, generatedPaths.isEmpty() ? QString() : generatedPaths.first());
+        }
+        output.insert(QString::fromLatin1(kPageCountPinId), pageCount);
+        if (textLayer) {
+            output.insert(QString::fromLatin1(kPageTextsPinId), texts);
+            if (!sink.isActive() && !texts.isEmpty()) {
+                output.insert(pageTextPinId, texts.first());
+            }
+            QVariantList pageNumbers;
+            for (const int page : textPages) {
+                pageNumbers << page;
+            }
+            output.insert(QStringLiteral("_text_pages"), pageNumbers);
+        }
+    } else if (strip || tiled) {
+        // Modes: stream the stitched document a page at a time, either into one PNG
+        // written in bands or into fixed-height tiles, so memory holds one page and
+        // at most one tile whatever the page count
+        QList<QSize> pageImageSizes;
+        int imageWidth = 0;
+        qint64 imageHeight = 0;
+        for (int i = 0; i < pageCount; ++i) {
+            const QSizeF pageSize = pdfDoc.pagePointSize(i);
+            const QSize pageImageSize(static_cast<int>(pageSize.width() * scale),
+                                      static_cast<int>(pageSize.height() * scale));
+            pageImageSizes << pageImageSize;
+            imageWidth = qMax(imageWidth, pageImageSize.width());
+            imageHeight += pageImageSize.height();
+        }
+        if (imageWidth <= 0 || imageHeight <= 0 || imageHeight > std::numeric_limits<int>::max()) {
+            return fail(QStringLiteral("Stitched PDF image size is out of range: %1").arg(absolutePdfPath));
+        }
+
+        std::unique_ptr<StreamingPngWriter> stripWriter;
+        if (strip) {
+            QString clearError;
+            if (!clearOutput(outPath, &clearError)) {
+                return fail(QStringLiteral("Failed to write stitched PDF image: %1 (%2)").arg(outPath, clearError));
+            }
+            stripWriter = std::make_unique<StreamingPngWriter>(outPath, imageWidth, static_cast<int>(imageHeight),
+                                                               encoding.pngCompression);
+            if (!stripWriter->open()) {
+                return fail(QStringLiteral("Failed to write stitched PDF image: %1 (%2)")
+                                .arg(outPath, stripWriter->errorString()));
+            }
+        }
+
+        const int tileHeight = qMax(1, m_tileHeight);
+        QImage tile;
+        int tileRows = 0;
+        QStringList tilePaths;
+        QString tileError;
+        const auto writeTile = [&]() {
+            const QImage finished = tileRows == tile.height() ? tile : tile.copy(0, 0, imageWidth, tileRows);
+            const QString tilePath = basePath + QStringLiteral("_t%1.%2").arg(tilePaths.size() + 1).arg(extension);
+            QString saveError;
+            if (!saveImage(finished, tilePath, encoding, &saveError)) {
+                tileError = QStringLiteral("Failed to save PDF tile image: %1 (%2)").arg(tilePath, saveError);
+                return false;
+            }
+            CP_CLOG(PDF_DEBUG) << "Saved tile" << tilePaths.size() + 1 << "to:" << tilePath;
+            tilePaths << tilePath;
+            ExecutionToken tileToken;
+            tileToken.data.insert(imagePathPinId, tilePath);
+            tileToken.forceExecution = true;
+            sink.publish(TokenList{tileToken});
+            tile.fill(Qt::white);
+            tileRows = 0;
+            return true;
+        };
+        if (tiled) {
+            tile = QImage(imageWidth, tileHeight, QImage::Format_RGB32);
+            tile.fill(Qt::white);
+        }
+
+        for (int i = 0; i < pageCount; ++i) {
+            if (cancellation.isCancelled()) {
+                return fail(QStringLiteral("PDF rendering cancelled"));
+            }
+            const QImage pageImage = pdfDoc.render(i, pageImageSizes.at(i));
+            if (strip) {
+                if (!stripWriter->appendRows(pageImage)) {
+                    return fail(QStringLiteral("Failed to write stitched PDF image: %1 (%2)")
+                                    .arg(outPath, stripWriter->errorString()));
+                }
+                continue;
+            }
+            // A page may fill the rest of one tile and spill into the next ones
+            for (int y = 0; y < pageImage.height();) {
+                const int rows = qMin(pageImage.height() - y, tileHeight - tileRows);
+                QPainter painter(&tile);
+                painter.drawImage(QPoint(0, tileRows), pageImage, QRect(0, y, pageImage.width(), rows));
+                painter.end();
+                tileRows += rows;
+                y += rows;
+                if (tileRows == tileHeight && !writeTile()) {
+                    return fail(tileError);
+                }
+            }
+        }
+
+        if (strip) {
+            if (!stripWriter->finish()) {
+                return fail(QStringLiteral("Failed to write stitched PDF image: %1 (%2)")
+                                .arg(outPath, stripWriter->errorString()));
+            }
+            CP_CLOG(PDF_DEBUG) << "Saved stitched strip output to:" << outPath;
+            if (cache) {
+                cache->store(stitchedKey, outPath);
+            }
+            output.insert(imagePathPinId, outPath);
+            output.insert(QString::fromLatin1(kImagePathsPinId), QStringList{outPath});
+        } else {
+            if (tileRows > 0 && !writeTile()) {
+                return fail(tileError);
+            }
+            if (!isPersistent && QFile::exists(outPath)) {
+                QFile::remove(outPath);
+            }
+            output.insert(QString::fromLatin1(kImagePathsPinId), tilePaths);
+            // Tiles already went out one by one, like split pages
+            if (!sink.isActive()) {
+                output.insert(imagePathPinId, tilePaths.isEmpty() ? QString() : tilePaths.first());
+            }
+        }
         output.insert(QString::fromLatin1(kPageCountPinId), pageCount);
     } else {
-        // Mode: Stitch all pages into one tall image
+        // Mode: Stitch all pages into one tall image held in memory
         qreal totalHeight = 0.0;
         qreal maxWidth = 0.0;
 
@@ -293,18 +642,26 @@ TokenList PdfToImageNode::execute(const TokenList& incomingTokens)
         }
         painter.end();
 
-        if (!stitchedImage.save(outPath, "PNG")) {
-            const QString msg = QStringLiteral("Failed to save stitched PDF image: %1").arg(outPath);
+        QString saveError;
+        if (!saveImage(stitchedImage, outPath, encoding, &saveError)) {
+            const QString msg = QStringLiteral("Failed to save stitched PDF image: %1 (%2)").arg(outPath, saveError);
             CP_CLOG(PDF_DEBUG) << msg;
             return fail(msg);
         }
 
         CP_CLOG(PDF_DEBUG) << "Saved stitched output to:" << outPath;
+        if (cache) {
+            cache->store(stitchedKey, outPath);
+        }
         output.insert(imagePathPinId, outPath);
         output.insert(QString::fromLatin1(kImagePathsPinId), QStringList{outPath});
         output.insert(QString::fromLatin1(kPageCountPinId), pageCount);
     }
 
+    if (cache) {
+        output.insert(QStringLiteral("_render_cache_hits"), cacheHits.load());
+    }
+
     ExecutionToken token;
     token.data = output;
     return TokenList{token};
@@ -317,6 +674,14 @@ QJsonObject PdfToImageNode::saveState() const
         obj[QStringLiteral("pdf_path")] = m_pdfPath;
     }
     obj[QStringLiteral("split_pages")] = m_splitPages;
+    obj[QStringLiteral("stitch_mode")] = m_stitchMode;
+    obj[QStringLiteral("tile_height")] = m_tileHeight;
+    obj[QStringLiteral("image_format")] = m_imageFormat;
+    obj[QStringLiteral("png_compression")] = m_pngCompression;
+    obj[QStringLiteral("image_quality")] = m_imageQuality;
+    obj[QStringLiteral("render_cache")] = m_renderCache;
+    obj[QStringLiteral("text_layer")] = m_textLayer;
+    obj[QStringLiteral("min_text_chars")] = m_minTextChars;
     return obj;
 }
 
@@ -324,19 +689,36 @@ void PdfToImageNode::loadState(const QJsonObject& data)
 {
     if (data.contains(QStringLiteral("pdf_path"))) {
         m_pdfPath = data[QStringLiteral("pdf_path")].toString();
-        
-        // Update widget if it exists
-        if (m_widget) {
-            m_widget->setPdfPath(m_pdfPath);
-        }
     }
 
     if (data.contains(QStringLiteral("split_pages"))) {
         m_splitPages = data[QStringLiteral("split_pages")].toBool();
-        
-        // Update widget if it exists
-        if (m_widget) {
-            m_widget->setSplitPages(m_splitPages);
-        }
     }
+
+    if (data.contains(QStringLiteral("stitch_mode"))) {
+        m_stitchMode = data[QStringLiteral("stitch_mode")].toString(QString::fromLatin1(kStitchSingle));
+    }
+    if (data.contains(QStringLiteral("tile_height"))) {
+        m_tileHeight = qMax(1, data[QStringLiteral("tile_height")].toInt(m_tileHeight));
+    }
+    if (data.contains(QStringLiteral("image_format"))) {
+        m_imageFormat = data[QStringLiteral("image_format")].toString(QStringLiteral("png")).toLower();
+    }
+    if (data.contains(QStringLiteral("png_compression"))) {
+        m_pngCompression = qBound(-1, data[QStringLiteral("png_compression")].toInt(-1), 9);
+    }
+    if (data.contains(QStringLiteral("image_quality"))) {
+        m_imageQuality = qBound(0, data[QStringLiteral("image_quality")].toInt(m_imageQuality), 100);
+    }
+    if (data.contains(QStringLiteral("render_cache"))) {
+        m_renderCache = data[QStringLiteral("render_cache")].toBool(true);
+    }
+    if (data.contains(QStringLiteral("text_layer"))) {
+        m_textLayer = data[QStringLiteral("text_layer")].toBool(false);
+    }
+    if (data.contains(QStringLiteral("min_text_chars"))) {
+        m_minTextChars = qMax(1, data[QStringLiteral("min_text_chars")].toInt(kDefaultMinTextChars));
+    }
+    // Update widget if it exists
+    emit stateLoaded();
 }
@@ -24,16 +24,14 @@
 #pragma once
 
 #include <QObject>
-#include <QWidget>
 #include <QFuture>
 #include <QString>
-#include <QPointer>
 #include <QTemporaryFile>
 
 #include "IToolNode.h"
 #include "CommonDataTypes.h"
 
-class PdfToImagePropertiesWidget;
+class QWidget;
 
 class PdfToImageNode : public QObject, public IToolNode {
     Q_OBJECT
@@ -44,13 +42,16 @@ public:
 
     // IToolNode interface
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in PdfToImagePropertiesWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     TokenList execute(const TokenList& incomingTokens) override;
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
 
 signals:
     void splitPagesChanged(bool split);
+    // Emitted at the end of loadState()
+    void stateLoaded();
 
 public slots:
     void onPdfPathChanged(const QString& path);
@@ -61,9 +62,28 @@ public:
     static constexpr const char* kImagePathPinId = "image_path";
     static constexpr const char* kImagePathsPinId = "image_paths";
     static constexpr const char* kPageCountPinId = "page_count";
+    static constexpr const char* kPageTextPinId = "page_text";
+    static constexpr const char* kPageTextsPinId = "page_texts";
+
+    // Fewest visible characters a page's text layer needs to be used instead of a render
+    static constexpr int kDefaultMinTextChars = 50;
+
+    // Stitch modes: one image in memory, one PNG streamed in bands, or fixed-height tiles
+    static constexpr const char* kStitchSingle = "single";
+    static constexpr const char* kStitchStrip = "strip";
+    static constexpr const char* kStitchTiles = "tiles";
 
 private:
-    QPointer<PdfToImagePropertiesWidget> m_widget;
     QString m_pdfPath;  // PDF path configured via properties widget (Source Mode)
     bool m_splitPages {false};
+    QString m_stitchMode {QString::fromLatin1(kStitchSingle)};
+    // Rows per tile; the default suits common vision model input sizes
+    int m_tileHeight {1568};
+    QString m_imageFormat {QStringLiteral("png")};  // png, jpg or webp
+    int m_pngCompression {-1};  // zlib level 0-9, -1 for the default
+    int m_imageQuality {90};    // jpg and webp
+    bool m_renderCache {true};  // reuse images rendered from identical PDFs
+    // Split pages with a usable text layer go out as text; only the rest are rendered
+    bool m_textLayer {false};
+    int m_minTextChars {kDefaultMinTextChars};
 };
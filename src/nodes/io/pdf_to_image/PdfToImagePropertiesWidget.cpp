@@ -22,6 +22,7 @@
 // SOFTWARE.
 //
 #include "PdfToImagePropertiesWidget.h"
+#include "PdfToImageNode.h"
 
 #include <QVBoxLayout>
 #include <QLabel>
@@ -52,8 +53,93 @@ PdfToImagePropertiesWidget::PdfToImagePropertiesWidget(QWidget* parent)
     m_splitCheckBox = new QCheckBox(tr("Split pages into separate images"), this);
     layout->addWidget(m_splitCheckBox);
 
+    // Text layer, used when pages are split
+    m_textLayerCheckBox = new QCheckBox(tr("Use the text layer where pages have one"), this);
+    m_textLayerCheckBox->setToolTip(tr("Pages with extractable text go out on Page Text instead of being rendered; "
+                                       "only scanned pages become images"));
+    m_textLayerCheckBox->setEnabled(false);
+    layout->addWidget(m_textLayerCheckBox);
+
+    layout->addWidget(new QLabel(tr("Minimum characters per text page:"), this));
+    m_minTextCharsSpin = new QSpinBox(this);
+    m_minTextCharsSpin->setRange(1, 100000);
+    m_minTextCharsSpin->setValue(PdfToImageNode::kDefaultMinTextChars);
+    m_minTextCharsSpin->setToolTip(tr("Pages with fewer visible characters, or mostly symbols, are rendered"));
+    m_minTextCharsSpin->setEnabled(false);
+    layout->addWidget(m_minTextCharsSpin);
+
+    // Stitched output, used when pages are not split
+    layout->addWidget(new QLabel(tr("Stitched output:"), this));
+    m_stitchModeCombo = new QComboBox(this);
+    m_stitchModeCombo->addItem(tr("Single image"), QString::fromLatin1(PdfToImageNode::kStitchSingle));
+    m_stitchModeCombo->addItem(tr("Single PNG, written in bands"), QString::fromLatin1(PdfToImageNode::kStitchStrip));
+    m_stitchModeCombo->addItem(tr("Fixed-height tiles"), QString::fromLatin1(PdfToImageNode::kStitchTiles));
+    m_stitchModeCombo->setToolTip(tr("Banded PNG and tiles keep memory to about one page, whatever the page count"));
+    layout->addWidget(m_stitchModeCombo);
+
+    layout->addWidget(new QLabel(tr("Tile height (px):"), this));
+    m_tileHeightSpin = new QSpinBox(this);
+    m_tileHeightSpin->setRange(1, 16384);
+    m_tileHeightSpin->setValue(1568);
+    m_tileHeightSpin->setEnabled(false);
+    layout->addWidget(m_tileHeightSpin);
+
+    // Encoding
+    layout->addWidget(new QLabel(tr("Image format:"), this));
+    m_formatCombo = new QComboBox(this);
+    m_formatCombo->addItem(tr("PNG"), QStringLiteral("png"));
+    m_formatCombo->addItem(tr("JPEG"), QStringLiteral("jpg"));
+    m_formatCombo->addItem(tr("WebP"), QStringLiteral("webp"));
+    layout->addWidget(m_formatCombo);
+
+    layout->addWidget(new QLabel(tr("PNG compression:"), this));
+    m_pngCompressionSpin = new QSpinBox(this);
+    m_pngCompressionSpin->setRange(-1, 9);
+    m_pngCompressionSpin->setSpecialValueText(tr("Default"));
+    m_pngCompressionSpin->setValue(-1);
+    m_pngCompressionSpin->setToolTip(tr("Lower levels encode faster and write larger files"));
+    layout->addWidget(m_pngCompressionSpin);
+
+    layout->addWidget(new QLabel(tr("JPEG/WebP quality:"), this));
+    m_qualitySpin = new QSpinBox(this);
+    m_qualitySpin->setRange(0, 100);
+    m_qualitySpin->setValue(90);
+    m_qualitySpin->setEnabled(false);
+    layout->addWidget(m_qualitySpin);
+
+    m_renderCacheCheckBox = new QCheckBox(tr("Reuse cached renders"), this);
+    m_renderCacheCheckBox->setChecked(true);
+    m_renderCacheCheckBox->setToolTip(tr("Link images rendered earlier from the same PDF and settings instead of rendering again"));
+    layout->addWidget(m_renderCacheCheckBox);
+
     // Connect checkbox signal
     connect(m_splitCheckBox, &QCheckBox::toggled, this, &PdfToImagePropertiesWidget::splitPagesChanged);
+    connect(m_splitCheckBox, &QCheckBox::toggled, m_stitchModeCombo, &QWidget::setDisabled);
+    connect(m_splitCheckBox, &QCheckBox::toggled, this, [this](bool split) {
+        m_textLayerCheckBox->setEnabled(split);
+        m_minTextCharsSpin->setEnabled(split && m_textLayerCheckBox->isChecked());
+    });
+    connect(m_textLayerCheckBox, &QCheckBox::toggled, this, [this](bool enabled) {
+        m_minTextCharsSpin->setEnabled(enabled && m_splitCheckBox->isChecked());
+        emit textLayerChanged(enabled);
+    });
+    connect(m_minTextCharsSpin, &QSpinBox::valueChanged, this, &PdfToImagePropertiesWidget::minTextCharsChanged);
+
+    connect(m_stitchModeCombo, &QComboBox::currentIndexChanged, this, [this]() {
+        const QString mode = m_stitchModeCombo->currentData().toString();
+        m_tileHeightSpin->setEnabled(mode == QLatin1String(PdfToImageNode::kStitchTiles));
+        emit stitchModeChanged(mode);
+    });
+    connect(m_tileHeightSpin, &QSpinBox::valueChanged, this, &PdfToImagePropertiesWidget::tileHeightChanged);
+    connect(m_formatCombo, &QComboBox::currentIndexChanged, this, [this]() {
+        const QString format = m_formatCombo->currentData().toString();
+        m_pngCompressionSpin->setEnabled(format == QLatin1String("png"));
+        m_qualitySpin->setEnabled(format != QLatin1String("png"));
+        emit imageFormatChanged(format);
+    });
+    connect(m_pngCompressionSpin, &QSpinBox::valueChanged, this, &PdfToImagePropertiesWidget::pngCompressionChanged);
+    connect(m_qualitySpin, &QSpinBox::valueChanged, this, &PdfToImagePropertiesWidget::imageQualityChanged);
+    connect(m_renderCacheCheckBox, &QCheckBox::toggled, this, &PdfToImagePropertiesWidget::renderCacheChanged);
 
     // Connect button click handler
     connect(m_selectButton, &QPushButton::clicked, this, [this]() {
@@ -89,6 +175,64 @@ void PdfToImagePropertiesWidget::setSplitPages(bool split)
     }
 }
 
+void PdfToImagePropertiesWidget::setStitchMode(const QString& mode)
+{
+    if (m_stitchModeCombo) {
+        const int index = m_stitchModeCombo->findData(mode);
+        m_stitchModeCombo->setCurrentIndex(index >= 0 ? index : 0);
+    }
+}
+
+void PdfToImagePropertiesWidget::setTileHeight(int height)
+{
+    if (m_tileHeightSpin) {
+        m_tileHeightSpin->setValue(height);
+    }
+}
+
+void PdfToImagePropertiesWidget::setImageFormat(const QString& format)
+{
+    if (m_formatCombo) {
+        const int index = m_formatCombo->findData(format);
+        m_formatCombo->setCurrentIndex(index >= 0 ? index : 0);
+    }
+}
+
+void PdfToImagePropertiesWidget::setPngCompression(int level)
+{
+    if (m_pngCompressionSpin) {
+        m_pngCompressionSpin->setValue(level);
+    }
+}
+
+void PdfToImagePropertiesWidget::setImageQuality(int quality)
+{
+    if (m_qualitySpin) {
+        m_qualitySpin->setValue(quality);
+    }
+}
+
+void PdfToImagePropertiesWidget::setRenderCache(bool enabled)
+{
+    if (m_renderCacheCheckBox) {
+        m_renderCacheCheckBox->setChecked(enabled);
+    }
+}
+
+void PdfToImagePropertiesWidget::setTextLayer(bool enabled)
+{
+    if (m_textLayerCheckBox) {
+        m_textLayerCheckBox->setChecked(enabled);
+    }
+}
+
+void PdfToImagePropertiesWidget::setMinTextChars(int chars)
+{
+    if (m_minTextCharsSpin) {
+        m_minTextCharsSpin->setValue(chars);
+    }
+}
+
 QString PdfToImagePropertiesWidget::pdfPath() const
 {
     if (m_pathLineEdit && !m_pathLineEdit->text().isEmpty()) {
@@ -101,3 +245,56 @@ bool PdfToImagePropertiesWidget::splitPages() const
 {
     return m_splitCheckBox && m_splitCheckBox->isChecked();
 }
+
+QWidget* PdfToImageNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* widget = new PdfToImagePropertiesWidget(parent);
+
+    // Connect widget signal to update internal state
+    connect(widget, &PdfToImagePropertiesWidget::pdfPathChanged, this, &PdfToImageNode::onPdfPathChanged);
+    connect(widget, &PdfToImagePropertiesWidget::splitPagesChanged, this, &PdfToImageNode::onSplitPagesChanged);
+    connect(widget, &PdfToImagePropertiesWidget::stitchModeChanged, this, [this](const QString& mode) {
+        m_stitchMode = mode;
+    });
+    connect(widget, &PdfToImagePropertiesWidget::tileHeightChanged, this, [this](int height) {
+        m_tileHeight = height;
+    });
+    connect(widget, &PdfToImagePropertiesWidget::imageFormatChanged, this, [this](const QString& format) {
+        m_imageFormat = format;
+    });
+    connect(widget, &PdfToImagePropertiesWidget::pngCompressionChanged, this, [this](int level) {
+        m_pngCompression = level;
+    });
+    connect(widget, &PdfToImagePropertiesWidget::imageQualityChanged, this, [this](int quality) {
+        m_imageQuality = quality;
+    });
+    connect(widget, &PdfToImagePropertiesWidget::renderCacheChanged, this, [this](bool enabled) {
+        m_renderCache = enabled;
+    });
+    connect(widget, &PdfToImagePropertiesWidget::textLayerChanged, this, [this](bool enabled) {
+        m_textLayer = enabled;
+    });
+    connect(widget, &PdfToImagePropertiesWidget::minTextCharsChanged, this, [this](int chars) {
+        m_minTextChars = chars;
+    });
+
+    // Initialize widget with current state, and again whenever loadState() replaces it
+    const auto showState = [this, widget]() {
+        if (!m_pdfPath.isEmpty()) {
+            widget->setPdfPath(m_pdfPath);
+        }
+        widget->setSplitPages(m_splitPages);
+        widget->setStitchMode(m_stitchMode);
+        widget->setTileHeight(m_tileHeight);
+        widget->setImageFormat(m_imageFormat);
+        widget->setPngCompression(m_pngCompression);
+        widget->setImageQuality(m_imageQuality);
+        widget->setRenderCache(m_renderCache);
+        widget->setTextLayer(m_textLayer);
+        widget->setMinTextChars(m_minTextChars);
+    };
+    showState();
+    connect(this, &PdfToImageNode::stateLoaded, widget, showState);
+
+    return widget;
+}
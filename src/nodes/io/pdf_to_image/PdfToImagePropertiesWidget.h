@@ -27,6 +27,8 @@
 #include <QLineEdit>
 #include <QPushButton>
 #include <QCheckBox>
+#include <QComboBox>
+#include <QSpinBox>
 
 class PdfToImagePropertiesWidget : public QWidget {
     Q_OBJECT
@@ -37,6 +39,14 @@ public:
     // Initialize / update UI value from external state
     void setPdfPath(const QString& path);
     void setSplitPages(bool split);
+    void setStitchMode(const QString& mode);
+    void setTileHeight(int height);
+    void setImageFormat(const QString& format);
+    void setPngCompression(int level);
+    void setImageQuality(int quality);
+    void setRenderCache(bool enabled);
+    void setTextLayer(bool enabled);
+    void setMinTextChars(int chars);
 
     // Read current values
     QString pdfPath() const;
@@ -45,9 +55,25 @@ public:
 signals:
     void pdfPathChanged(const QString& path);
     void splitPagesChanged(bool split);
+    void stitchModeChanged(const QString& mode);
+    void tileHeightChanged(int height);
+    void imageFormatChanged(const QString& format);
+    void pngCompressionChanged(int level);
+    void imageQualityChanged(int quality);
+    void renderCacheChanged(bool enabled);
+    void textLayerChanged(bool enabled);
+    void minTextCharsChanged(int chars);
 
 private:
     QLineEdit* m_pathLineEdit {nullptr};
     QPushButton* m_selectButton {nullptr};
     QCheckBox* m_splitCheckBox {nullptr};
+    QComboBox* m_stitchModeCombo {nullptr};
+    QSpinBox* m_tileHeightSpin {nullptr};
+    QComboBox* m_formatCombo {nullptr};
+    QSpinBox* m_pngCompressionSpin {nullptr};
+    QSpinBox* m_qualitySpin {nullptr};
+    QCheckBox* m_renderCacheCheckBox {nullptr};
+    QCheckBox* m_textLayerCheckBox {nullptr};
+    QSpinBox* m_minTextCharsSpin {nullptr};
 };
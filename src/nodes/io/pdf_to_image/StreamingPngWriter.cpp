@@ -0,0 +1,220 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "StreamingPngWriter.h"
+
+#include <QImage>
+#include <QtEndian>
+
+#include <cstring>
+
+#include <zlib.h>
+
+namespace {
+
+constexpr int kIdatChunkBytes = 64 * 1024;
+constexpr uchar kSubFilter = 1;
+
+} // namespace
+
+struct StreamingPngWriter::Deflater {
+    z_stream stream {};
+    bool initialized {false};
+    QByteArray buffer = QByteArray(kIdatChunkBytes, Qt::Uninitialized);
+
+    ~Deflater()
+    {
+        if (initialized) {
+            deflateEnd(&stream);
+        }
+    }
+};
+
+StreamingPngWriter::StreamingPngWriter(const QString& path, int width, int height, int compressionLevel)
+    : m_file(path)
+    , m_width(width)
+    , m_height(height)
+    , m_compressionLevel(compressionLevel < 0 ? Z_DEFAULT_COMPRESSION : qMin(compressionLevel, 9))
+{
+}
+
+StreamingPngWriter::~StreamingPngWriter() = default;
+
+bool StreamingPngWriter::open()
+{
+    if (m_width <= 0 || m_height <= 0) {
+        return fail(QStringLiteral("Image size %1x%2 is empty").arg(m_width).arg(m_height));
+    }
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return fail(m_file.errorString());
+    }
+
+    m_deflater = std::make_unique<Deflater>();
+    if (deflateInit(&m_deflater->stream, m_compressionLevel) != Z_OK) {
+        return fail(QStringLiteral("Failed to initialize the PNG compressor"));
+    }
+    m_deflater->initialized = true;
+    m_deflater->stream.next_out = reinterpret_cast<Bytef*>(m_deflater->buffer.data());
+    m_deflater->stream.avail_out = static_cast<uInt>(m_deflater->buffer.size());
+
+    m_row = QByteArray(1 + 3 * qsizetype(m_width), Qt::Uninitialized);
+    m_filtered = QByteArray(m_row.size(), Qt::Uninitialized);
+
+    static const char signature[] = "\x89PNG\r\n\x1a\n";
+    if (m_file.write(signature, 8) != 8) {
+        return fail(m_file.errorString());
+    }
+
+    // RGB, 8 bits per channel, deflate, adaptive filtering, no interlace
+    QByteArray header(13, '\0');
+    qToBigEndian<quint32>(static_cast<quint32>(m_width), header.data());
+    qToBigEndian<quint32>(static_cast<quint32>(m_height), header.data() + 4);
+    header[8] = 8;
+    header[9] = 2;
+    return writeChunk("IHDR", header);
+}
+
+bool StreamingPngWriter::appendRows(const QImage& band)
+{
+    if (!m_deflater || m_finished) {
+        return fail(QStringLiteral("PNG writer is not open"));
+    }
+    const QImage rgb = band.convertToFormat(QImage::Format_RGB888);
+    const int columns = qMin(rgb.width(), m_width);
+    for (int y = 0; y < rgb.height() && m_rowsWritten < m_height; ++y) {
+        uchar* row = reinterpret_cast<uchar*>(m_row.data()) + 1;
+        std::memcpy(row, rgb.constScanLine(y), 3 * std::size_t(columns));
+        std::memset(row + 3 * columns, 0xff, 3 * std::size_t(m_width - columns));
+        if (!deflateRow(false)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool StreamingPngWriter::finish()
+{
+    if (m_finished) {
+        return m_error.isEmpty();
+    }
+    if (!m_deflater) {
+        return fail(QStringLiteral("PNG writer is not open"));
+    }
+    while (m_rowsWritten < m_height) {
+        std::memset(m_row.data() + 1, 0xff, std::size_t(m_row.size() - 1));
+        if (!deflateRow(false)) {
+            return false;
+        }
+    }
+    if (!deflateRow(true) || !writeChunk("IEND", QByteArray())) {
+        return false;
+    }
+    m_finished = true;
+    m_deflater.reset();
+    if (!m_file.flush()) {
+        return fail(m_file.errorString());
+    }
+    m_file.close();
+    return true;
+}
+
+// Sub-filters m_row and feeds it to the compressor until every row is in; with last
+// set, ends the compressed stream
+bool StreamingPngWriter::deflateRow(bool last)
+{
+    z_stream& stream = m_deflater->stream;
+    const bool feedRow = m_rowsWritten < m_height;
+    if (feedRow) {
+        const uchar* raw = reinterpret_cast<const uchar*>(m_row.constData()) + 1;
+        uchar* out = reinterpret_cast<uchar*>(m_filtered.data());
+        out[0] = kSubFilter;
+        const qsizetype bytes = m_row.size() - 1;
+        for (qsizetype i = 0; i < qMin<qsizetype>(3, bytes); ++i) {
+            out[1 + i] = raw[i];
+        }
+        for (qsizetype i = 3; i < bytes; ++i) {
+            out[1 + i] = static_cast<uchar>(raw[i] - raw[i - 3]);
+        }
+        stream.next_in = reinterpret_cast<Bytef*>(m_filtered.data());
+        stream.avail_in = static_cast<uInt>(m_filtered.size());
+        ++m_rowsWritten;
+    } else {
+        stream.next_in = nullptr;
+        stream.avail_in = 0;
+    }
+
+    const int flush = last ? Z_FINISH : Z_NO_FLUSH;
+    for (;;) {
+        const int status = deflate(&stream, flush);
+        if (status == Z_STREAM_ERROR) {
+            return fail(QStringLiteral("PNG compression failed"));
+        }
+        const bool full = stream.avail_out == 0;
+        if (full || status == Z_STREAM_END) {
+            const qsizetype produced = m_deflater->buffer.size() - stream.avail_out;
+            if (produced > 0 && !writeChunk("IDAT", m_deflater->buffer.first(produced))) {
+                return false;
+            }
+            stream.next_out = reinterpret_cast<Bytef*>(m_deflater->buffer.data());
+            stream.avail_out = static_cast<uInt>(m_deflater->buffer.size());
+        }
+        if (status == Z_STREAM_END) {
+            return true;
+        }
+        if (!full && stream.avail_in == 0 && flush != Z_FINISH) {
+            return true;
+        }
+    }
+}
+
+bool StreamingPngWriter::writeChunk(const char type[4], const QByteArray& data)
+{
+    char length[4];
+    qToBigEndian<quint32>(static_cast<quint32>(data.size()), length);
+    uLong crc = crc32(0L, reinterpret_cast<const Bytef*>(type), 4);
+    // crc32() resets to 0 when handed a null buffer, which an empty chunk may carry
+    if (!data.isEmpty()) {
+        crc = crc32(crc, reinterpret_cast<const Bytef*>(data.constData()), static_cast<uInt>(data.size()));
+    }
+    char crcBytes[4];
+    qToBigEndian<quint32>(static_cast<quint32>(crc), crcBytes);
+
+    if (m_file.write(length, 4) != 4 || m_file.write(type, 4) != 4
+        || m_file.write(data) != data.size() || m_file.write(crcBytes, 4) != 4) {
+        return fail(m_file.errorString());
+    }
+    return true;
+}
+
+bool StreamingPngWriter::fail(const QString& message)
+{
+    if (m_error.isEmpty()) {
+        m_error = message;
+    }
+    m_deflater.reset();
+    if (m_file.isOpen()) {
+        m_file.close();
+        m_file.remove();
+    }
+    return false;
+}
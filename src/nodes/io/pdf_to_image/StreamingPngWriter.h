@@ -0,0 +1,79 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include <memory>
+
+class QImage;
+
+// Writes an RGB PNG a band of rows at a time.
+//
+// QImage::save() needs the whole picture in memory; this encoder only needs the
+// rows being appended, so a document stitched page by page costs one page of
+// pixels however many pages it has. Rows are Sub-filtered and deflated as they
+// arrive, and compressed data goes to the file in IDAT chunks as it fills.
+class StreamingPngWriter {
+public:
+    // compressionLevel is zlib's 0-9, or -1 for its default
+    StreamingPngWriter(const QString& path, int width, int height, int compressionLevel = -1);
+    ~StreamingPngWriter();
+
+    StreamingPngWriter(const StreamingPngWriter&) = delete;
+    StreamingPngWriter& operator=(const StreamingPngWriter&) = delete;
+
+    bool open();
+
+    // Appends the rows of band below those already written. A narrower band is
+    // padded with white on the right; rows past the image height are dropped.
+    bool appendRows(const QImage& band);
+
+    // Pads any missing rows with white and writes the end of the file.
+    bool finish();
+
+    int rowsWritten() const { return m_rowsWritten; }
+    QString errorString() const { return m_error; }
+
+private:
+    struct Deflater;
+
+    bool deflateRow(bool last);
+    bool writeChunk(const char type[4], const QByteArray& data);
+    bool fail(const QString& message);
+
+    QFile m_file;
+    const int m_width;
+    const int m_height;
+    const int m_compressionLevel;
+    int m_rowsWritten {0};
+    bool m_finished {false};
+    QString m_error;
+    // Filter type byte followed by the row's RGB bytes
+    QByteArray m_row;
+    QByteArray m_filtered;
+    std::unique_ptr<Deflater> m_deflater;
+};
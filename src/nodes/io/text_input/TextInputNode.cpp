@@ -22,7 +22,6 @@
 // SOFTWARE.
 //
 #include "TextInputNode.h"
-#include "TextInputPropertiesWidget.h"
 
 #include <QJsonObject>
 
@@ -58,23 +57,6 @@ NodeDescriptor TextInputNode::getDescriptor() const
     return desc;
 }
 
-QWidget* TextInputNode::createConfigurationWidget(QWidget* parent)
-{
-    auto* w = new TextInputPropertiesWidget(parent);
-    // Initialize from current state
-    w->setText(m_text);
-
-    // UI -> Node (live updates)
-    QObject::connect(w, &TextInputPropertiesWidget::textChanged,
-                     this, &TextInputNode::setText);
-
-    // Node -> UI (reflect programmatic changes)
-    QObject::connect(this, &TextInputNode::textChanged,
-                     w, &TextInputPropertiesWidget::setText);
-
-    return w;
-}
-
 TokenList TextInputNode::execute(const TokenList& /*incomingTokens*/)
 {
     // This is a source node: it ignores incoming tokens and simply emits its
@@ -24,13 +24,14 @@
 #pragma once
 
 #include <QObject>
-#include <QWidget>
 #include <QFuture>
 #include <QString>
 
 #include "IToolNode.h"
 #include "CommonDataTypes.h"
 
+class QWidget;
+
 class TextInputNode : public QObject, public IToolNode {
     Q_OBJECT
     Q_INTERFACES(IToolNode)
@@ -40,8 +41,10 @@ public:
 
     // IToolNode interface
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in TextInputPropertiesWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     TokenList execute(const TokenList& incomingTokens) override;
+    bool supportsConcurrentRuns() const override { return true; }
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
 
@@ -22,6 +22,7 @@
 // SOFTWARE.
 //
 #include "TextInputPropertiesWidget.h"
+#include "TextInputNode.h"
 #include <QVBoxLayout>
 #include <QLabel>
 
@@ -59,3 +60,20 @@ QString TextInputPropertiesWidget::text() const
 {
     return m_textEdit ? m_textEdit->toPlainText() : QString();
 }
+
+QWidget* TextInputNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* w = new TextInputPropertiesWidget(parent);
+    // Initialize from current state
+    w->setText(m_text);
+
+    // UI -> Node (live updates)
+    QObject::connect(w, &TextInputPropertiesWidget::textChanged,
+                     this, &TextInputNode::setText);
+
+    // Node -> UI (reflect programmatic changes)
+    QObject::connect(this, &TextInputNode::textChanged,
+                     w, &TextInputPropertiesWidget::setText);
+
+    return w;
+}
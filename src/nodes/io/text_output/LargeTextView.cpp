@@ -0,0 +1,178 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "LargeTextView.h"
+
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <QSaveFile>
+#include <QTextEdit>
+#include <QVBoxLayout>
+#include <QtConcurrent>
+
+namespace {
+
+// Characters encoded and written per step when saving
+constexpr qsizetype kSaveSliceLength = 1024 * 1024;
+
+// Keeps a cut from separating a surrogate pair
+qsizetype adjustCut(const QString& text, qsizetype cut)
+{
+    if (cut > 0 && cut < text.size() && text.at(cut - 1).isHighSurrogate()) {
+        return cut - 1;
+    }
+    return cut;
+}
+
+QList<qsizetype> pageStarts(const QString& text)
+{
+    QList<qsizetype> starts;
+    qsizetype start = 0;
+    while (start < text.size()) {
+        starts.append(start);
+        qsizetype end = start + LargeTextView::kPageLength;
+        if (end >= text.size()) {
+            break;
+        }
+        const qsizetype newline = QStringView(text).sliced(start, end - start).lastIndexOf(u'\n');
+        end = newline > 0 ? start + newline + 1 : adjustCut(text, end);
+        start = end;
+    }
+    return starts;
+}
+
+} // namespace
+
+LargeTextView::LargeTextView(QWidget* parent)
+    : QWidget(parent)
+{
+    auto* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(4);
+
+    m_textEdit = new QTextEdit(this);
+    m_textEdit->setReadOnly(true);
+    m_textEdit->setUndoRedoEnabled(false);
+    layout->addWidget(m_textEdit);
+
+    m_pageBar = new QWidget(this);
+    auto* pageLayout = new QHBoxLayout(m_pageBar);
+    pageLayout->setContentsMargins(0, 0, 0, 0);
+    m_previousButton = new QPushButton(tr("Previous"), m_pageBar);
+    m_nextButton = new QPushButton(tr("Next"), m_pageBar);
+    m_pageLabel = new QLabel(m_pageBar);
+    pageLayout->addWidget(m_previousButton);
+    pageLayout->addWidget(m_pageLabel, 1, Qt::AlignCenter);
+    pageLayout->addWidget(m_nextButton);
+    m_pageBar->setVisible(false);
+    layout->addWidget(m_pageBar);
+
+    connect(m_previousButton, &QPushButton::clicked, this, [this]() { setCurrentPage(m_currentPage - 1); });
+    connect(m_nextButton, &QPushButton::clicked, this, [this]() { setCurrentPage(m_currentPage + 1); });
+}
+
+void LargeTextView::setMarkdown(const QString& markdown)
+{
+    setText(markdown, true);
+}
+
+void LargeTextView::setPlainText(const QString& text)
+{
+    setText(text, false);
+}
+
+void LargeTextView::clear()
+{
+    setText(QString(), false);
+}
+
+QString LargeTextView::toPlainText() const
+{
+    return isPaged() ? m_text : m_textEdit->toPlainText();
+}
+
+void LargeTextView::setCurrentPage(int index)
+{
+    if (!isPaged()) {
+        return;
+    }
+    m_currentPage = qBound(0, index, pageCount() - 1);
+    const qsizetype start = m_pageStarts.at(m_currentPage);
+    const qsizetype end = m_currentPage + 1 < pageCount() ? m_pageStarts.at(m_currentPage + 1) : m_text.size();
+    m_textEdit->setPlainText(m_text.sliced(start, end - start));
+    m_pageLabel->setText(tr("Page %1 of %2 (%3 characters)")
+                             .arg(m_currentPage + 1)
+                             .arg(pageCount())
+                             .arg(m_text.size()));
+    m_previousButton->setEnabled(m_currentPage > 0);
+    m_nextButton->setEnabled(m_currentPage + 1 < pageCount());
+}
+
+void LargeTextView::setText(const QString& text, bool markdown)
+{
+    if (text.size() <= kPagedThreshold) {
+        m_text.clear();
+        m_pageStarts.clear();
+        m_currentPage = 0;
+        m_pageBar->setVisible(false);
+        if (markdown) {
+            m_textEdit->setMarkdown(text);
+        } else {
+            m_textEdit->setPlainText(text);
+        }
+        return;
+    }
+
+    // Markdown layout of the whole text is what freezes the UI, so pages are plain text.
+    // Refreshes while a run updates the output keep the page being read.
+    const int page = isPaged() ? m_currentPage : 0;
+    m_text = text;
+    m_pageStarts = pageStarts(m_text);
+    m_pageBar->setVisible(true);
+    setCurrentPage(page);
+}
+
+QFuture<QString> LargeTextView::saveTextAsync(const QString& text, const QString& path)
+{
+    return QtConcurrent::run([text, path]() -> QString {
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            return file.errorString();
+        }
+        qsizetype offset = 0;
+        while (offset < text.size()) {
+            const qsizetype end = adjustCut(text, qMin(offset + kSaveSliceLength, text.size()));
+            const QByteArray bytes = QStringView(text).sliced(offset, end - offset).toUtf8();
+            if (file.write(bytes) != bytes.size()) {
+                file.cancelWriting();
+                return file.errorString();
+            }
+            offset = end;
+        }
+        if (!file.commit()) {
+            return file.errorString();
+        }
+        return QString();
+    });
+}
@@ -0,0 +1,77 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QFuture>
+#include <QList>
+#include <QString>
+#include <QWidget>
+
+class QLabel;
+class QPushButton;
+class QTextEdit;
+
+// Read-only text view that stays responsive for multi-megabyte output.
+//
+// Text up to kPagedThreshold characters is shown as before, as Markdown or
+// plain text. Anything longer is split into pages of about kPageLength
+// characters, broken after a line end where there is one, and only the current
+// page is laid out, as plain text, with a bar to move between pages.
+class LargeTextView : public QWidget {
+    Q_OBJECT
+public:
+    static constexpr qsizetype kPagedThreshold = 256 * 1024;
+    static constexpr qsizetype kPageLength = 64 * 1024;
+
+    explicit LargeTextView(QWidget* parent = nullptr);
+
+    void setMarkdown(const QString& markdown);
+    void setPlainText(const QString& text);
+    void clear();
+
+    // The rendered text while unpaged, otherwise the whole text as given
+    QString toPlainText() const;
+
+    bool isPaged() const { return !m_pageStarts.isEmpty(); }
+    int pageCount() const { return static_cast<int>(m_pageStarts.size()); }
+    int currentPage() const { return m_currentPage; }
+    void setCurrentPage(int index);
+
+    // Writes text to path on a pool thread, encoding it a slice at a time.
+    // The future yields an error message, or an empty string once saved.
+    static QFuture<QString> saveTextAsync(const QString& text, const QString& path);
+
+private:
+    void setText(const QString& text, bool markdown);
+
+    QTextEdit* m_textEdit {nullptr};
+    QWidget* m_pageBar {nullptr};
+    QPushButton* m_previousButton {nullptr};
+    QPushButton* m_nextButton {nullptr};
+    QLabel* m_pageLabel {nullptr};
+
+    QString m_text;
+    QList<qsizetype> m_pageStarts;
+    int m_currentPage {0};
+};
@@ -22,13 +22,12 @@
 // SOFTWARE.
 //
 #include "TextOutputNode.h"
-#include "TextOutputPropertiesWidget.h"
 
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QMetaObject>
-#include <QTextEdit>
+#include <QMutexLocker>
 #include <QThread>
 
 TextOutputNode::TextOutputNode(QObject* parent)
@@ -56,25 +55,6 @@ NodeDescriptor TextOutputNode::getDescriptor() const
     return desc;
 }
 
-QWidget* TextOutputNode::createConfigurationWidget(QWidget* parent)
-{
-    if (!m_propertiesWidget) {
-        m_propertiesWidget = new TextOutputPropertiesWidget(parent);
-        // If we have a pending value from a previous Execute before the widget existed,
-        // apply it immediately. Otherwise, fall back to any text loaded from state.
-        if (m_hasPendingText) {
-            m_propertiesWidget->onSetText(m_lastText);
-            m_hasPendingText = false; // consumed
-        } else if (!m_loadedText.isEmpty()) {
-            QMetaObject::invokeMethod(m_propertiesWidget, "onSetText", Qt::QueuedConnection,
-                                      Q_ARG(QString, m_loadedText));
-        }
-    } else if (m_propertiesWidget->parent() != parent && parent) {
-        m_propertiesWidget->setParent(parent);
-    }
-    return m_propertiesWidget;
-}
-
 TokenList TextOutputNode::execute(const TokenList& incomingTokens)
 {
     // Merge incoming tokens into a single DataPacket, then behave as a sink node
@@ -95,28 +75,42 @@ TokenList TextOutputNode::execute(const TokenList& incomingTokens)
         text = QJsonDocument(QJsonObject::fromVariantMap(val.toMap())).toJson(QJsonDocument::Indented);
         text = QStringLiteral("```json\n%1\n```").arg(text);
     } else {
+        // Markdown line breaks are added by the widget, and only for text short enough to lay out
         text = val.toString();
-        // If it looks like it has multiple lines, ensure newlines are preserved in Markdown
-        if (text.contains(QLatin1Char('\n'))) {
-            text.replace(QStringLiteral("\n"), QStringLiteral("  \n"));
-        }
     }
     // Remember the last text even if the widget is not created yet (fan-out first run case)
     m_lastText = text;
     m_hasPendingText = (m_propertiesWidget == nullptr);
 
-    // Forward to properties widget on the UI thread safely
-    auto* widget = m_propertiesWidget.data();
+    // Hand the text to the UI thread without waiting for it to be laid out. Updates
+    // that arrive before the UI gets to the last one replace it, so only the newest
+    // text is shown and the worker never blocks on a repaint.
+    QObject* widget = m_propertiesWidget.data();
     if (widget) {
-        // Block the worker thread until the UI has processed the update to avoid
-        // a race where the displayed text lags behind by one execution step.
-        // Use a direct call if we're already on the same thread to avoid deadlocks.
-        const bool crossThread = QThread::currentThread() != widget->thread();
-        const Qt::ConnectionType type = crossThread
-                                        ? Qt::BlockingQueuedConnection
-                                        : Qt::DirectConnection;
-        QMetaObject::invokeMethod(widget, "onSetText", type,
-                                  Q_ARG(QString, text));
+        if (QThread::currentThread() == widget->thread()) {
+            QMetaObject::invokeMethod(widget, "onSetText", Qt::DirectConnection, Q_ARG(QString, text));
+        } else {
+            QMutexLocker locker(&m_displayMutex);
+            m_displayText = text;
+            if (!m_displayPosted) {
+                m_displayPosted = true;
+                QPointer<TextOutputNode> self(this);
+                QMetaObject::invokeMethod(widget, [self, widget]() {
+                    if (!self) {
+                        return;
+                    }
+                    QString latest;
+                    {
+                        QMutexLocker locker(&self->m_displayMutex);
+                        latest = std::move(self->m_displayText);
+                        self->m_displayText.clear();
+                        self->m_displayPosted = false;
+                    }
+                    QMetaObject::invokeMethod(widget, "onSetText", Qt::DirectConnection,
+                                              Q_ARG(QString, latest));
+                }, Qt::QueuedConnection);
+            }
+        }
     }
 
     // Sink node: produce a single empty-result token so downstream nodes
@@ -143,7 +137,7 @@ void TextOutputNode::loadState(const QJsonObject& data)
 {
     m_loadedText = data.value(QStringLiteral("text")).toString();
 
-    auto* widget = m_propertiesWidget.data();
+    QObject* widget = m_propertiesWidget.data();
     if (widget) {
         QMetaObject::invokeMethod(widget, "onSetText", Qt::QueuedConnection,
                                   Q_ARG(QString, m_loadedText));
@@ -156,10 +150,15 @@ void TextOutputNode::clearOutput()
     m_lastText.clear();
     m_loadedText.clear();
     m_hasPendingText = false;
+    {
+        // An update still queued for the widget shows nothing
+        QMutexLocker locker(&m_displayMutex);
+        m_displayText.clear();
+    }
 
     // Clear the widget display if it exists
     // Use immediate invocation to ensure the widget is cleared before saveState() is called
-    auto* widget = m_propertiesWidget.data();
+    QObject* widget = m_propertiesWidget.data();
     if (widget) {
         const bool crossThread = QThread::currentThread() != widget->thread();
         const Qt::ConnectionType type = crossThread
@@ -23,14 +23,15 @@
 //
 #pragma once
 
+#include <QMutex>
 #include <QObject>
-#include <QWidget>
 #include <QString>
 #include <QPointer>
 
 #include "IToolNode.h"
 #include "CommonDataTypes.h"
-#include "TextOutputPropertiesWidget.h"
+
+class QWidget;
 
 // Skeleton TextOutput node: consumes text and presents it in a read-only widget
 class TextOutputNode : public QObject, public IToolNode {
@@ -42,8 +43,10 @@ public:
 
     // IToolNode interface
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in TextOutputPropertiesWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     TokenList execute(const TokenList& incomingTokens) override;
+    ResourceClass resourceClass() const override { return ResourceClass::GuiAffine; }
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
 
@@ -54,10 +57,15 @@ public:
     static constexpr const char* kInputId = "text";
 
 private:
-    QPointer<TextOutputPropertiesWidget> m_propertiesWidget; // cached UI widget
+    // Cached UI widget; updated through its onSetText slot so the core needs no widget code
+    QPointer<QObject> m_propertiesWidget;
     QString m_loadedText; // cached text from loaded state to apply on widget creation
     // Cache the last value received via Execute so that if the widget wasn't yet created,
     // we can display it immediately upon widget creation (fixes first-run fan-out cases).
     QString m_lastText;
     bool m_hasPendingText {false};
+    // Newest text waiting for the queued widget update, and whether one is queued
+    QMutex m_displayMutex;
+    QString m_displayText;
+    bool m_displayPosted {false};
 };
@@ -22,6 +22,16 @@
 // SOFTWARE.
 //
 #include "TextOutputPropertiesWidget.h"
+#include "TextOutputNode.h"
+#include "LargeTextView.h"
+
+#include <QDir>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <QVBoxLayout>
 
 TextOutputPropertiesWidget::TextOutputPropertiesWidget(QWidget* parent)
     : QWidget(parent)
@@ -29,15 +39,80 @@ TextOutputPropertiesWidget::TextOutputPropertiesWidget(QWidget* parent)
     auto* vbox = new QVBoxLayout(this);
     vbox->setContentsMargins(4, 4, 4, 4);
 
-    m_textEdit = new QTextEdit(this);
-    m_textEdit->setReadOnly(true);
+    m_textView = new LargeTextView(this);
+    vbox->addWidget(m_textView);
+
+    auto* saveRow = new QHBoxLayout();
+    m_saveButton = new QPushButton(tr("Save..."), this);
+    m_saveStatusLabel = new QLabel(this);
+    saveRow->addWidget(m_saveButton);
+    saveRow->addWidget(m_saveStatusLabel, 1);
+    vbox->addLayout(saveRow);
 
-    vbox->addWidget(m_textEdit);
+    connect(m_saveButton, &QPushButton::clicked, this, &TextOutputPropertiesWidget::onSaveClicked);
+    connect(&m_saveWatcher, &QFutureWatcher<QString>::finished, this, &TextOutputPropertiesWidget::onSaveFinished);
 }
 
 void TextOutputPropertiesWidget::onSetText(const QString& text)
 {
-    if (m_textEdit) {
-        m_textEdit->setMarkdown(text);
+    if (!m_textView) {
+        return;
+    }
+    // Paged text is shown plain, so only shorter text needs Markdown hard breaks
+    if (text.size() <= LargeTextView::kPagedThreshold && text.contains(QLatin1Char('\n'))) {
+        QString markdown = text;
+        markdown.replace(QStringLiteral("\n"), QStringLiteral("  \n"));
+        m_textView->setMarkdown(markdown);
+    } else {
+        m_textView->setMarkdown(text);
+    }
+}
+
+void TextOutputPropertiesWidget::onSaveClicked()
+{
+    if (!m_textView || m_saveWatcher.isRunning()) {
+        return;
+    }
+    const QString fileName = QFileDialog::getSaveFileName(this,
+                                                          tr("Save Output As"),
+                                                          QDir::homePath(),
+                                                          tr("Text Files (*.txt);;All Files (*)"));
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    m_savePath = fileName;
+    m_saveButton->setEnabled(false);
+    m_saveStatusLabel->setText(tr("Saving..."));
+    m_saveWatcher.setFuture(LargeTextView::saveTextAsync(m_textView->toPlainText(), fileName));
+}
+
+void TextOutputPropertiesWidget::onSaveFinished()
+{
+    const QString error = m_saveWatcher.result();
+    m_saveButton->setEnabled(true);
+    m_saveStatusLabel->setText(error.isEmpty()
+                                   ? tr("Saved to %1").arg(QFileInfo(m_savePath).fileName())
+                                   : tr("Save failed: %1").arg(error));
+}
+
+QWidget* TextOutputNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* widget = qobject_cast<TextOutputPropertiesWidget*>(m_propertiesWidget.data());
+    if (!widget) {
+        widget = new TextOutputPropertiesWidget(parent);
+        m_propertiesWidget = widget;
+        // If we have a pending value from a previous Execute before the widget existed,
+        // apply it immediately. Otherwise, fall back to any text loaded from state.
+        if (m_hasPendingText) {
+            widget->onSetText(m_lastText);
+            m_hasPendingText = false; // consumed
+        } else if (!m_loadedText.isEmpty()) {
+            QMetaObject::invokeMethod(widget, "onSetText", Qt::QueuedConnection,
+                                      Q_ARG(QString, m_loadedText));
+        }
+    } else if (widget->parent() != parent && parent) {
+        widget->setParent(parent);
     }
+    return widget;
 }
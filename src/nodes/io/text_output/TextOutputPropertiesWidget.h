@@ -23,9 +23,12 @@
 //
 #pragma once
 
+#include <QFutureWatcher>
 #include <QWidget>
-#include <QTextEdit>
-#include <QVBoxLayout>
+
+class LargeTextView;
+class QLabel;
+class QPushButton;
 
 // Properties widget for TextOutputNode
 class TextOutputPropertiesWidget : public QWidget {
@@ -38,6 +41,14 @@ public slots:
     // Update the displayed text
     void onSetText(const QString& text);
 
+private slots:
+    void onSaveClicked();
+    void onSaveFinished();
+
 private:
-    QTextEdit* m_textEdit {nullptr};
+    LargeTextView* m_textView {nullptr};
+    QPushButton* m_saveButton {nullptr};
+    QLabel* m_saveStatusLabel {nullptr};
+    QFutureWatcher<QString> m_saveWatcher;
+    QString m_savePath;
 };
@@ -1,6 +1,6 @@
 #include "VaultOutputNode.h"
 
-#include "VaultOutputPropertiesWidget.h"
+#include "VaultWriter.h"
 #include "DocumentLoader.h"
 #include "ModelCapsRegistry.h"
 #include "ai/backends/ILLMBackend.h"
@@ -15,10 +15,8 @@
 #include <QFileInfo>
 #include <QJsonDocument>
 #include <QJsonObject>
-#include <QMetaObject>
 #include <QMimeDatabase>
 #include <QRegularExpression>
-#include <QSaveFile>
 #include <QTextStream>
 
 namespace {
@@ -159,18 +157,6 @@ QString sanitizeFilenameBase(QString raw, const QString& fallbackTitle)
     return raw;
 }
 
-QString uniqueMarkdownPath(const QString& directoryPath, const QString& fileBase)
-{
-    const QString base = fileBase.isEmpty() ? QStringLiteral("note") : fileBase;
-    QString candidate = QDir(directoryPath).filePath(base + QStringLiteral(".md"));
-    int suffix = 2;
-    while (QFileInfo::exists(candidate)) {
-        candidate = QDir(directoryPath).filePath(QStringLiteral("%1-%2.md").arg(base).arg(suffix));
-        ++suffix;
-    }
-    return candidate;
-}
-
 QString extractFirstJsonObjectText(const QString& text)
 {
     int start = -1;
@@ -306,38 +292,6 @@ NodeDescriptor VaultOutputNode::getDescriptor() const
     return desc;
 }
 
-QWidget* VaultOutputNode::createConfigurationWidget(QWidget* parent)
-{
-    if (!m_widget) {
-        auto* widget = new VaultOutputPropertiesWidget(parent);
-        widget->setVaultRoot(m_vaultRoot);
-        widget->setProvider(m_providerId);
-        widget->setModel(m_modelId);
-        widget->setRoutingPrompt(m_routingPrompt);
-        widget->setTemperature(m_temperature);
-        widget->setMaxTokens(m_maxTokens);
-
-        connect(widget, &VaultOutputPropertiesWidget::vaultRootChanged,
-                this, &VaultOutputNode::setVaultRoot);
-        connect(widget, &VaultOutputPropertiesWidget::providerChanged,
-                this, &VaultOutputNode::setProviderId);
-        connect(widget, &VaultOutputPropertiesWidget::modelChanged,
-                this, &VaultOutputNode::setModelId);
-        connect(widget, &VaultOutputPropertiesWidget::routingPromptChanged,
-                this, &VaultOutputNode::setRoutingPrompt);
-        connect(widget, &VaultOutputPropertiesWidget::temperatureChanged,
-                this, &VaultOutputNode::setTemperature);
-        connect(widget, &VaultOutputPropertiesWidget::maxTokensChanged,
-                this, &VaultOutputNode::setMaxTokens);
-
-        m_widget = widget;
-    } else if (parent && m_widget->parent() != parent) {
-        m_widget->setParent(parent);
-    }
-
-    return m_widget;
-}
-
 TokenList VaultOutputNode::execute(const TokenList& incomingTokens)
 {
     DataPacket inputs;
@@ -361,13 +315,13 @@ TokenList VaultOutputNode::execute(const TokenList& incomingTokens)
 
     auto fail = [this, &output](const QString& message) {
         output.insert(QStringLiteral("__error"), message);
-        setStatusMessage(QStringLiteral("Status: %1").arg(message));
+        emit statusMessageChanged(QStringLiteral("Status: %1").arg(message));
         ExecutionToken token;
         token.data = output;
         return TokenList{token};
     };
 
-    setStatusMessage(QStringLiteral("Status: routing note to vault..."));
+    emit statusMessageChanged(QStringLiteral("Status: routing note to vault..."));
 
     if (markdown.trimmed().isEmpty()) {
         return fail(QStringLiteral("Vault Output requires markdown input."));
@@ -423,6 +377,7 @@ TokenList VaultOutputNode::execute(const TokenList& incomingTokens)
                                                  m_maxTokens,
                                                  systemPrompt,
                                                  userPrompt);
+    LLMProviderRegistry::recordUsage(m_providerId, resolvedModel, result.usage);
 
     output.insert(QStringLiteral("_raw_response"), result.rawResponse);
     if (result.hasError) {
@@ -446,14 +401,16 @@ TokenList VaultOutputNode::execute(const TokenList& incomingTokens)
         return fail(QStringLiteral("Failed to create vault subfolder: %1").arg(targetDirPath));
     }
 
-    const QString targetPath = uniqueMarkdownPath(targetDirPath, filenameBase);
-    QSaveFile file(targetPath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        return fail(QStringLiteral("Failed to open vault output file: %1").arg(targetPath));
-    }
-    file.write(markdown.toUtf8());
-    if (!file.commit()) {
-        return fail(QStringLiteral("Failed to save vault output file: %1").arg(targetPath));
+    // Names come from the writer's cached listing; the note itself is written off this thread
+    VaultWriter& writer = VaultWriter::shared();
+    QString targetPath = writer.reservePath(targetDirPath, filenameBase);
+    const QFuture<QString> saved = writer.write(targetPath, markdown.toUtf8());
+    if (!m_writeInBackground) {
+        const QString reservedPath = targetPath;
+        targetPath = saved.result();
+        if (targetPath.isEmpty()) {
+            return fail(QStringLiteral("Failed to save vault output file: %1").arg(reservedPath));
+        }
     }
 
     QVariantMap decisionMap = decision.toVariantMap();
@@ -467,7 +424,7 @@ TokenList VaultOutputNode::execute(const TokenList& incomingTokens)
     output.insert(QString::fromLatin1(kOutputSubfolderId), relativeSubfolder);
     output.insert(QString::fromLatin1(kOutputFilenameId), QFileInfo(targetPath).fileName());
     output.insert(QString::fromLatin1(kOutputDecisionId), decisionMap);
-    setStatusMessage(QStringLiteral("Status: saved %1").arg(QFileInfo(targetPath).absoluteFilePath()));
+    emit statusMessageChanged(QStringLiteral("Status: saved %1").arg(QFileInfo(targetPath).absoluteFilePath()));
 
     ExecutionToken token;
     token.data = output;
@@ -483,6 +440,7 @@ QJsonObject VaultOutputNode::saveState() const
     state.insert(QStringLiteral("routing_prompt"), m_routingPrompt);
     state.insert(QStringLiteral("temperature"), m_temperature);
     state.insert(QStringLiteral("max_tokens"), m_maxTokens);
+    state.insert(QStringLiteral("write_in_background"), m_writeInBackground);
     return state;
 }
 
@@ -498,15 +456,9 @@ void VaultOutputNode::loadState(const QJsonObject& data)
     if (data.contains(QStringLiteral("max_tokens"))) {
         m_maxTokens = data.value(QStringLiteral("max_tokens")).toInt(m_maxTokens);
     }
+    m_writeInBackground = data.value(QStringLiteral("write_in_background")).toBool(m_writeInBackground);
 
-    if (m_widget) {
-        m_widget->setVaultRoot(m_vaultRoot);
-        m_widget->setProvider(m_providerId);
-        m_widget->setModel(m_modelId);
-        m_widget->setRoutingPrompt(m_routingPrompt);
-        m_widget->setTemperature(m_temperature);
-        m_widget->setMaxTokens(m_maxTokens);
-    }
+    emit stateLoaded();
 }
 
 void VaultOutputNode::setVaultRoot(const QString& path)
@@ -539,14 +491,7 @@ void VaultOutputNode::setMaxTokens(int value)
     m_maxTokens = value;
 }
 
-void VaultOutputNode::setStatusMessage(const QString& message)
+void VaultOutputNode::setWriteInBackground(bool enabled)
 {
-    auto* widget = m_widget.data();
-    if (!widget) {
-        return;
-    }
-
-    QMetaObject::invokeMethod(widget, [widget, message]() {
-        widget->setStatusMessage(message);
-    }, Qt::QueuedConnection);
+    m_writeInBackground = enabled;
 }
@@ -1,11 +1,10 @@
 #pragma once
 
 #include <QObject>
-#include <QPointer>
 
 #include "IToolNode.h"
 
-class VaultOutputPropertiesWidget;
+class QWidget;
 
 class VaultOutputNode : public QObject, public IToolNode {
     Q_OBJECT
@@ -15,7 +14,8 @@ public:
     ~VaultOutputNode() override = default;
 
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in VaultOutputPropertiesWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     TokenList execute(const TokenList& incomingTokens) override;
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
@@ -29,6 +29,11 @@ public:
     static constexpr const char* kOutputFilenameId = "filename";
     static constexpr const char* kOutputDecisionId = "decision";
 
+signals:
+    // Progress of the current note, for the properties widget
+    void statusMessageChanged(const QString& message);
+    void stateLoaded();
+
 public slots:
     void setVaultRoot(const QString& path);
     void setProviderId(const QString& providerId);
@@ -36,15 +41,15 @@ public slots:
     void setRoutingPrompt(const QString& prompt);
     void setTemperature(double value);
     void setMaxTokens(int value);
+    void setWriteInBackground(bool enabled);
 
 private:
-    void setStatusMessage(const QString& message);
-
     QString m_vaultRoot;
     QString m_providerId;
     QString m_modelId;
     QString m_routingPrompt;
     double m_temperature {0.2};
     int m_maxTokens {800};
-    QPointer<VaultOutputPropertiesWidget> m_widget;
+    // saved_path is reported before the note reaches disk
+    bool m_writeInBackground {true};
 };
@@ -1,4 +1,5 @@
 #include "VaultOutputPropertiesWidget.h"
+#include "VaultOutputNode.h"
 
 #include <QCheckBox>
 #include <QComboBox>
@@ -145,6 +146,11 @@ VaultOutputPropertiesWidget::VaultOutputPropertiesWidget(QWidget* parent)
     m_maxTokensSpinBox->setValue(800);
     form->addRow(tr("Max Tokens:"), m_maxTokensSpinBox);
 
+    m_writeInBackgroundCheck = new QCheckBox(tr("Write notes in the background"), this);
+    m_writeInBackgroundCheck->setChecked(true);
+    m_writeInBackgroundCheck->setToolTip(tr("Continue as soon as the note is queued; turn off when a later node reads the saved file"));
+    form->addRow(QString(), m_writeInBackgroundCheck);
+
     layout->addLayout(form);
 
     layout->addWidget(new QLabel(tr("Routing Prompt:"), this));
@@ -178,6 +184,8 @@ VaultOutputPropertiesWidget::VaultOutputPropertiesWidget(QWidget* parent)
             this, &VaultOutputPropertiesWidget::temperatureChanged);
     connect(m_maxTokensSpinBox, qOverload<int>(&QSpinBox::valueChanged),
             this, &VaultOutputPropertiesWidget::maxTokensChanged);
+    connect(m_writeInBackgroundCheck, &QCheckBox::toggled,
+            this, &VaultOutputPropertiesWidget::writeInBackgroundChanged);
 
     if (m_providerCombo->count() > 0) {
         onProviderIndexChanged(0);
@@ -256,6 +264,16 @@ void VaultOutputPropertiesWidget::setMaxTokens(int value)
     m_maxTokensSpinBox->setValue(value);
 }
 
+void VaultOutputPropertiesWidget::setWriteInBackground(bool enabled)
+{
+    if (!m_writeInBackgroundCheck) {
+        return;
+    }
+
+    const QSignalBlocker blocker(m_writeInBackgroundCheck);
+    m_writeInBackgroundCheck->setChecked(enabled);
+}
+
 void VaultOutputPropertiesWidget::setStatusMessage(const QString& message)
 {
     if (!m_statusLabel) {
@@ -295,6 +313,11 @@ int VaultOutputPropertiesWidget::maxTokens() const
     return m_maxTokensSpinBox ? m_maxTokensSpinBox->value() : 800;
 }
 
+bool VaultOutputPropertiesWidget::writeInBackground() const
+{
+    return !m_writeInBackgroundCheck || m_writeInBackgroundCheck->isChecked();
+}
+
 void VaultOutputPropertiesWidget::onBrowseVaultRoot()
 {
     const QString dir = QFileDialog::getExistingDirectory(
@@ -467,3 +490,40 @@ void VaultOutputPropertiesWidget::onModelTestFinished()
                                        : tr("Failed%1: %2").arg(driver, result.message));
     }
 }
+
+QWidget* VaultOutputNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* widget = new VaultOutputPropertiesWidget(parent);
+    const auto showState = [this, widget]() {
+        widget->setVaultRoot(m_vaultRoot);
+        widget->setProvider(m_providerId);
+        widget->setModel(m_modelId);
+        widget->setRoutingPrompt(m_routingPrompt);
+        widget->setTemperature(m_temperature);
+        widget->setMaxTokens(m_maxTokens);
+        widget->setWriteInBackground(m_writeInBackground);
+    };
+    showState();
+
+    connect(widget, &VaultOutputPropertiesWidget::vaultRootChanged,
+            this, &VaultOutputNode::setVaultRoot);
+    connect(widget, &VaultOutputPropertiesWidget::providerChanged,
+            this, &VaultOutputNode::setProviderId);
+    connect(widget, &VaultOutputPropertiesWidget::modelChanged,
+            this, &VaultOutputNode::setModelId);
+    connect(widget, &VaultOutputPropertiesWidget::routingPromptChanged,
+            this, &VaultOutputNode::setRoutingPrompt);
+    connect(widget, &VaultOutputPropertiesWidget::temperatureChanged,
+            this, &VaultOutputNode::setTemperature);
+    connect(widget, &VaultOutputPropertiesWidget::maxTokensChanged,
+            this, &VaultOutputNode::setMaxTokens);
+    connect(widget, &VaultOutputPropertiesWidget::writeInBackgroundChanged,
+            this, &VaultOutputNode::setWriteInBackground);
+
+    // Status lines come from the engine's worker thread and are queued to the widget
+    connect(this, &VaultOutputNode::statusMessageChanged,
+            widget, &VaultOutputPropertiesWidget::setStatusMessage);
+    connect(this, &VaultOutputNode::stateLoaded, widget, showState);
+
+    return widget;
+}
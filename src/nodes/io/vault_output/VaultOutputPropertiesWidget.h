@@ -26,6 +26,7 @@ public:
     void setRoutingPrompt(const QString& prompt);
     void setTemperature(double value);
     void setMaxTokens(int value);
+    void setWriteInBackground(bool enabled);
     void setStatusMessage(const QString& message);
 
     QString vaultRoot() const;
@@ -34,6 +35,7 @@ public:
     QString routingPrompt() const;
     double temperature() const;
     int maxTokens() const;
+    bool writeInBackground() const;
 
 signals:
     void vaultRootChanged(const QString& path);
@@ -42,6 +44,7 @@ signals:
     void routingPromptChanged(const QString& prompt);
     void temperatureChanged(double value);
     void maxTokensChanged(int value);
+    void writeInBackgroundChanged(bool enabled);
 
 private slots:
     void onBrowseVaultRoot();
@@ -66,6 +69,7 @@ private:
     QTextEdit* m_routingPromptEdit {nullptr};
     QDoubleSpinBox* m_temperatureSpinBox {nullptr};
     QSpinBox* m_maxTokensSpinBox {nullptr};
+    QCheckBox* m_writeInBackgroundCheck {nullptr};
     QFutureWatcher<QList<ModelCatalogEntry>> m_modelFetcher;
     QFutureWatcher<ModelTestResult> m_modelTester;
     QList<ModelCatalogEntry> m_lastModels;
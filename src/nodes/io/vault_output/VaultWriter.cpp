@@ -0,0 +1,350 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "VaultWriter.h"
+#include "Logger.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QPromise>
+#include <QUuid>
+
+#include <algorithm>
+#include <vector>
+
+#if defined(Q_OS_UNIX)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <io.h>
+#endif
+
+struct VaultWriter::Pending {
+    QString directory;
+    QString fileBase;
+    QString fileName;
+    QString tempPath;
+    QByteArray content;
+    QPromise<QString> promise;
+    bool written {false};
+    bool saved {false};
+};
+
+namespace {
+
+// Names clash the way the filesystem compares them
+QString nameKey(const QString& name)
+{
+#if defined(Q_OS_WIN) || defined(Q_OS_MACOS)
+    return name.toLower();
+#else
+    return name;
+#endif
+}
+
+QString fileBaseOf(const QString& fileName)
+{
+    return fileName.endsWith(QStringLiteral(".md"), Qt::CaseInsensitive) ? fileName.chopped(3) : fileName;
+}
+
+#if !defined(Q_OS_LINUX)
+bool syncFile(QFile& file)
+{
+    if (!file.flush()) {
+        return false;
+    }
+#if defined(Q_OS_WIN)
+    return ::_commit(file.handle()) == 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+#endif
+
+// One syncfs per filesystem the batch touched, instead of an fsync per note
+void syncFilesystems(const QStringList& directories)
+{
+#if defined(Q_OS_LINUX)
+    std::vector<dev_t> synced;
+    for (const QString& directory : directories) {
+        const int fd = ::open(QFile::encodeName(directory).constData(), O_RDONLY | O_DIRECTORY);
+        if (fd < 0) {
+            continue;
+        }
+        struct stat info {};
+        if (::fstat(fd, &info) == 0 && std::find(synced.begin(), synced.end(), info.st_dev) == synced.end()) {
+            ::syncfs(fd);
+            synced.push_back(info.st_dev);
+        }
+        ::close(fd);
+    }
+#else
+    Q_UNUSED(directories);
+#endif
+}
+
+// Makes the renames themselves durable
+void syncDirectories(const QStringList& directories)
+{
+#if defined(Q_OS_UNIX)
+    for (const QString& directory : directories) {
+        const int fd = ::open(QFile::encodeName(directory).constData(), O_RDONLY);
+        if (fd >= 0) {
+            ::fsync(fd);
+            ::close(fd);
+        }
+    }
+#else
+    Q_UNUSED(directories);
+#endif
+}
+
+} // namespace
+
+VaultWriter::VaultWriter()
+{
+    m_pool.setMaxThreadCount(1);
+}
+
+VaultWriter::~VaultWriter()
+{
+    flush();
+    m_pool.waitForDone();
+}
+
+VaultWriter& VaultWriter::shared()
+{
+    static VaultWriter writer;
+    return writer;
+}
+
+QString VaultWriter::reservePath(const QString& directoryPath, const QString& fileBase)
+{
+    const QString absolutePath = QDir(directoryPath).absolutePath();
+    QMutexLocker locker(&m_mutex);
+    Directory& directory = directoryFor(absolutePath);
+    const QString fileName = takeName(directory, fileBase);
+    ++directory.pending;
+    return QDir(absolutePath).filePath(fileName);
+}
+
+QFuture<QString> VaultWriter::write(const QString& path, const QByteArray& content)
+{
+    const QFileInfo info(path);
+    auto pending = std::make_shared<Pending>();
+    pending->directory = info.absolutePath();
+    pending->fileName = info.fileName();
+    pending->fileBase = fileBaseOf(pending->fileName);
+    pending->content = content;
+    pending->promise.start();
+    QFuture<QString> future = pending->promise.future();
+
+    QMutexLocker locker(&m_mutex);
+    m_queue.push_back(std::move(pending));
+    ++m_inFlight;
+    if (!m_draining) {
+        m_draining = true;
+        m_pool.start([this]() { drain(); });
+    }
+    return future;
+}
+
+void VaultWriter::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_inFlight > 0) {
+        m_idle.wait(&m_mutex);
+    }
+}
+
+int VaultWriter::pendingWrites() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_inFlight;
+}
+
+void VaultWriter::invalidate()
+{
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_directories.begin(); it != m_directories.end();) {
+        if (it->pending == 0) {
+            it = m_directories.erase(it);
+        } else {
+            // Listed again once its writes are done
+            it->listedModified = QDateTime();
+            ++it;
+        }
+    }
+}
+
+VaultWriter::Directory& VaultWriter::directoryFor(const QString& directoryPath)
+{
+    const QDateTime modified = QFileInfo(directoryPath).lastModified();
+    auto it = m_directories.find(directoryPath);
+    if (it != m_directories.end() && (it->pending > 0 || it->listedModified == modified)) {
+        return *it;
+    }
+
+    Directory listed;
+    listed.listedModified = modified;
+    const QStringList entries = QDir(directoryPath).entryList(
+        QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot, QDir::NoSort);
+    listed.names.reserve(entries.size());
+    for (const QString& entry : entries) {
+        listed.names.insert(nameKey(entry));
+    }
+    return *m_directories.insert(directoryPath, std::move(listed));
+}
+
+QString VaultWriter::takeName(Directory& directory, const QString& fileBase)
+{
+    const QString base = fileBase.isEmpty() ? QStringLiteral("note") : fileBase;
+    QString fileName = base + QStringLiteral(".md");
+    if (directory.names.contains(nameKey(fileName))) {
+        // Start past the suffixes already handed out for this base
+        int suffix = directory.nextSuffix.value(nameKey(base), 2);
+        do {
+            fileName = QStringLiteral("%1-%2.md").arg(base).arg(suffix);
+            ++suffix;
+        } while (directory.names.contains(nameKey(fileName)));
+        directory.nextSuffix.insert(nameKey(base), suffix);
+    }
+    directory.names.insert(nameKey(fileName));
+    return fileName;
+}
+
+void VaultWriter::drain()
+{
+    for (;;) {
+        std::deque<std::shared_ptr<Pending>> batch;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_queue.empty()) {
+                m_draining = false;
+                return;
+            }
+            while (!m_queue.empty() && static_cast<int>(batch.size()) < kMaxBatch) {
+                batch.push_back(std::move(m_queue.front()));
+                m_queue.pop_front();
+            }
+        }
+        writeBatch(batch);
+    }
+}
+
+void VaultWriter::writeBatch(std::deque<std::shared_ptr<Pending>>& batch)
+{
+    QStringList directories;
+    for (const std::shared_ptr<Pending>& pending : batch) {
+        if (!directories.contains(pending->directory)) {
+            directories << pending->directory;
+        }
+
+        pending->tempPath = QDir(pending->directory).filePath(
+            QStringLiteral(".%1.%2.tmp").arg(pending->fileName, QUuid::createUuid().toString(QUuid::Id128)));
+        QFile file(pending->tempPath);
+        if (!file.open(QIODevice::WriteOnly)) {
+            CP_WARN.noquote() << QStringLiteral("VaultWriter: failed to open %1: %2")
+                                     .arg(pending->tempPath, file.errorString());
+            continue;
+        }
+        bool ok = file.write(pending->content) == pending->content.size();
+#if !defined(Q_OS_LINUX)
+        ok = ok && syncFile(file);
+#endif
+        file.close();
+        if (!ok) {
+            CP_WARN.noquote() << QStringLiteral("VaultWriter: failed to write %1: %2")
+                                     .arg(pending->tempPath, file.errorString());
+            QFile::remove(pending->tempPath);
+            continue;
+        }
+        pending->written = true;
+    }
+
+    syncFilesystems(directories);
+
+    for (const std::shared_ptr<Pending>& pending : batch) {
+        if (!pending->written) {
+            continue;
+        }
+        const QString target = QDir(pending->directory).filePath(pending->fileName);
+        // QFile::rename refuses to replace an existing file
+        if (QFile::rename(pending->tempPath, target)) {
+            pending->saved = true;
+            continue;
+        }
+        if (!QFileInfo::exists(target)) {
+            CP_WARN.noquote() << QStringLiteral("VaultWriter: failed to save %1").arg(target);
+            QFile::remove(pending->tempPath);
+            continue;
+        }
+
+        QString fileName;
+        {
+            QMutexLocker locker(&m_mutex);
+            Directory& directory = m_directories[pending->directory];
+            fileName = takeName(directory, pending->fileBase);
+        }
+        const QString fallback = QDir(pending->directory).filePath(fileName);
+        if (QFile::rename(pending->tempPath, fallback)) {
+            CP_WARN.noquote() << QStringLiteral("VaultWriter: %1 appeared while queued; saved as %2")
+                                     .arg(target, fallback);
+            pending->saved = true;
+        } else {
+            CP_WARN.noquote() << QStringLiteral("VaultWriter: failed to save %1").arg(fallback);
+            QFile::remove(pending->tempPath);
+        }
+        // The reservation moves to the new name; the old one stays taken
+        pending->fileName = fileName;
+    }
+
+    syncDirectories(directories);
+
+    for (const std::shared_ptr<Pending>& pending : batch) {
+        finishWrite(pending->directory, pending->fileName, pending->saved);
+        pending->promise.addResult(pending->saved ? QDir(pending->directory).filePath(pending->fileName) : QString());
+        pending->promise.finish();
+    }
+}
+
+void VaultWriter::finishWrite(const QString& directoryPath, const QString& fileName, bool saved)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_directories.find(directoryPath);
+    if (it != m_directories.end()) {
+        if (!saved) {
+            it->names.remove(nameKey(fileName));
+        }
+        if (it->pending > 0 && --it->pending == 0 && it->listedModified.isValid()) {
+            // Our own renames moved the directory's mtime; that is not a reason to list it again
+            it->listedModified = QFileInfo(directoryPath).lastModified();
+        }
+    }
+    if (--m_inFlight == 0) {
+        m_idle.wakeAll();
+    }
+}
@@ -0,0 +1,104 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QFuture>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <deque>
+#include <memory>
+
+// Allocates note names and writes them into a vault off the calling thread.
+//
+// Each directory is listed once and its names kept in memory, so a unique name
+// is found without probing the filesystem, and colliding titles take the next
+// free "-N" suffix directly instead of stepping through every earlier one. A
+// listing is read again when the directory changes while none of our own
+// writes are outstanding there.
+//
+// Writes are queued and drained by a single worker in batches: every note in a
+// batch goes to a temporary file, the batch is flushed to disk together, and
+// the notes are then renamed into place with each directory synced once. A
+// name taken by another process in the meantime is not overwritten; the note is
+// saved under the next free name and a warning logged.
+class VaultWriter {
+public:
+    static constexpr int kMaxBatch = 256;
+
+    VaultWriter();
+    // Waits for queued writes.
+    ~VaultWriter();
+
+    VaultWriter(const VaultWriter&) = delete;
+    VaultWriter& operator=(const VaultWriter&) = delete;
+
+    static VaultWriter& shared();
+
+    // Path of a free "<fileBase>.md" (or "<fileBase>-N.md") in directoryPath,
+    // held until its write finishes or fails.
+    QString reservePath(const QString& directoryPath, const QString& fileBase);
+
+    // Queues content for a reserved path. The future yields where the note was
+    // saved, which differs only after a collision, or an empty string on failure.
+    QFuture<QString> write(const QString& path, const QByteArray& content);
+
+    // Blocks until every queued write has finished.
+    void flush();
+
+    int pendingWrites() const;
+
+    // Drops the cached listings, e.g. after files were moved behind our back.
+    void invalidate();
+
+private:
+    struct Directory {
+        QSet<QString> names;
+        QHash<QString, int> nextSuffix;
+        QDateTime listedModified;
+        int pending {0};
+    };
+
+    struct Pending;
+
+    Directory& directoryFor(const QString& directoryPath);
+    QString takeName(Directory& directory, const QString& fileBase);
+    void drain();
+    void writeBatch(std::deque<std::shared_ptr<Pending>>& batch);
+    void finishWrite(const QString& directoryPath, const QString& fileName, bool saved);
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_idle;
+    QHash<QString, Directory> m_directories;
+    std::deque<std::shared_ptr<Pending>> m_queue;
+    bool m_draining {false};
+    int m_inFlight {0};
+    QThreadPool m_pool;
+};
@@ -23,11 +23,15 @@
 //
 #include "DatabaseNode.h"
 #include "CommonDataTypes.h"
-#include "DatabasePropertiesWidget.h"
 
 #include <QtConcurrent/QtConcurrent>
+#include "CancellationToken.h"
 #include "Logger.h"
-#include <QUuid>
+#include "PartialOutputSink.h"
+#include "retrieval/storage/SqliteConnectionPool.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
 
 // QtSql
 #include <QSqlDatabase>
@@ -35,6 +39,24 @@
 #include <QSqlError>
 #include <QSqlRecord>
 
+#include <algorithm>
+
+namespace {
+
+// Column value as JSON; BLOBs are base64 encoded
+QJsonValue jsonCell(const QVariant& value)
+{
+    if (value.isNull()) {
+        return QJsonValue(QJsonValue::Null);
+    }
+    if (value.typeId() == QMetaType::QByteArray) {
+        return QString::fromLatin1(value.toByteArray().toBase64());
+    }
+    return QJsonValue::fromVariant(value);
+}
+
+} // namespace
+
 DatabaseNode::DatabaseNode(QObject* parent)
     : QObject(parent)
 {
@@ -80,6 +102,14 @@ NodeDescriptor DatabaseNode::getDescriptor() const
     outStdout.type = QStringLiteral("text");
     desc.outputPins.insert(outStdout.id, outStdout);
 
+    // Output pin: rows (text) - JSON arrays of row objects, one token per page
+    PinDefinition outRows;
+    outRows.direction = PinDirection::Output;
+    outRows.id = QStringLiteral("rows");
+    outRows.name = QStringLiteral("Rows");
+    outRows.type = QStringLiteral("text");
+    desc.outputPins.insert(outRows.id, outRows);
+
     // Output pin: stderr (text)
     PinDefinition outStderr;
     outStderr.direction = PinDirection::Output;
@@ -91,22 +121,6 @@ NodeDescriptor DatabaseNode::getDescriptor() const
     return desc;
 }
 
-QWidget* DatabaseNode::createConfigurationWidget(QWidget* parent)
-{
-    if (!propertiesWidget) {
-        propertiesWidget = new DatabasePropertiesWidget(parent);
-        // initialize UI from current state
-        propertiesWidget->setDatabasePath(m_databasePath);
-        propertiesWidget->setSqlQuery(m_sqlQuery);
-        // connect UI -> node
-        QObject::connect(propertiesWidget, &DatabasePropertiesWidget::databasePathChanged,
-                         this, &DatabaseNode::onDatabasePathChanged);
-        QObject::connect(propertiesWidget, &DatabasePropertiesWidget::sqlQueryChanged,
-                         this, &DatabaseNode::onSqlQueryChanged);
-    }
-    return propertiesWidget;
-}
-
 TokenList DatabaseNode::execute(const TokenList& incomingTokens)
 {
     // Merge incoming tokens into a single DataPacket, preserving the
@@ -130,7 +144,14 @@ TokenList DatabaseNode::execute(const TokenList& incomingTokens)
         dbPath = m_databasePath;
     }
 
-    auto work = [sql, dbPath]() -> DataPacket {
+    // In rows mode, pages go downstream as they fill; without a sink they join the result
+    const bool rowsMode = m_resultFormat == QLatin1String(kResultRows);
+    const int pageSize = m_pageSize;
+    const PartialOutputSink sink = PartialOutputSink::current();
+    const CancellationToken cancellation = CancellationToken::current();
+    TokenList pageTokens;
+
+    auto work = [sql, dbPath, rowsMode, pageSize, &sink, &cancellation, &pageTokens]() -> DataPacket {
         DataPacket packet;
         const QString outKey = QStringLiteral("stdout");
         const QString errKey = QStringLiteral("stderr");
@@ -154,20 +175,14 @@ TokenList DatabaseNode::execute(const TokenList& incomingTokens)
             return packet;
         }
 
-        const QString connectionName = QUuid::createUuid().toString(QUuid::WithoutBraces);
-
         QString stdoutText;
         QString stderrText;
         {
-            // Scope to ensure db and query are destroyed before removeDatabase
-            QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
-            db.setDatabaseName(dbPath);
+            // Pooled per thread; every path below ends its transaction before returning it
+            QSqlDatabase db = SqliteConnectionPool::connection(dbPath, &stderrText);
 
-            if (!db.open()) {
-                stderrText = db.lastError().text();
+            if (!db.isOpen()) {
                 CP_WARN << "DatabaseNode: failed to open DB" << dbPath << ":" << stderrText;
-                // Ensure close before leaving scope
-                if (db.isOpen()) db.close();
             } else {
                 // Split SQL by semicolon to handle multi-statement scripts
                 QStringList statements = sql.split(QLatin1Char(';'), Qt::SkipEmptyParts);
@@ -176,9 +191,10 @@ TokenList DatabaseNode::execute(const TokenList& incomingTokens)
                 if (!db.transaction()) {
                     stderrText = QStringLiteral("Failed to start transaction: ") + db.lastError().text();
                     CP_WARN << "DatabaseNode:" << stderrText;
-                    db.close();
                 } else {
                     QSqlQuery query(db);
+                    // Rows are stepped through once, so the driver needn't keep them for seeking back
+                    query.setForwardOnly(true);
                     bool allSuccess = true;
                     qint64 totalRowsAffected = 0;
                     
@@ -207,16 +223,49 @@ TokenList DatabaseNode::execute(const TokenList& incomingTokens)
                             stderrText += QStringLiteral(" (Rollback also failed: ") + db.lastError().text() + QStringLiteral(")");
                             CP_WARN << "DatabaseNode: rollback failed:" << db.lastError().text();
                         }
-                        db.close();
                     } else {
                         // Commit on success
                         if (!db.commit()) {
                             stderrText = QStringLiteral("Failed to commit transaction: ") + db.lastError().text();
                             CP_WARN << "DatabaseNode: commit failed:" << stderrText;
-                            db.close();
+                            db.rollback();
                         } else {
                             // Success: format results. If last query was a SELECT, show table
-                            if (query.isSelect()) {
+                            if (query.isSelect() && rowsMode) {
+                                // The cursor is the keyset: rows are read in order, page by page,
+                                // without re-running the query with LIMIT/OFFSET
+                                const QSqlRecord rec = query.record();
+                                const int colCount = rec.count();
+                                QJsonArray page;
+                                qint64 rowCount = 0;
+                                int pageCount = 0;
+                                auto flush = [&]() {
+                                    ExecutionToken pageToken;
+                                    pageToken.data.insert(QStringLiteral("rows"),
+                                                          QString::fromUtf8(QJsonDocument(page).toJson(QJsonDocument::Compact)));
+                                    pageToken.data.insert(QStringLiteral("database"), dbPath);
+                                    page = QJsonArray();
+                                    ++pageCount;
+                                    if (!sink.isActive()) {
+                                        pageTokens.push_back(std::move(pageToken));
+                                        return;
+                                    }
+                                    pageToken.forceExecution = true;
+                                    sink.publish(TokenList{pageToken});
+                                    sink.awaitCapacity();
+                                };
+                                while (query.next() && !cancellation.isCancelled()) {
+                                    QJsonObject row;
+                                    for (int i = 0; i < colCount; ++i) {
+                                        row.insert(rec.fieldName(i), jsonCell(query.value(i)));
+                                    }
+                                    page.append(row);
+                                    ++rowCount;
+                                    if (page.size() >= pageSize) flush();
+                                }
+                                if (!page.isEmpty()) flush();
+                                stdoutText = QStringLiteral("Rows returned: %1 in %2 pages").arg(rowCount).arg(pageCount);
+                            } else if (query.isSelect()) {
                                 // Build Markdown table with headers
                                 auto sanitizeCell = [](const QString& in) -> QString {
                                     // First escape HTML-sensitive characters so Markdown renderers
@@ -276,14 +325,11 @@ TokenList DatabaseNode::execute(const TokenList& incomingTokens)
                                 // Non-SELECT queries: show total rows affected
                                 stdoutText = QStringLiteral("Rows affected: ") + QString::number(totalRowsAffected);
                             }
-                            db.close();
                         }
                     }
                 }
             }
         }
-        // After db and query are out of scope, remove the connection
-        QSqlDatabase::removeDatabase(connectionName);
 
         packet.insert(QStringLiteral("stdout"), stdoutText);
         packet.insert(QStringLiteral("stderr"), stderrText);
@@ -299,7 +345,7 @@ TokenList DatabaseNode::execute(const TokenList& incomingTokens)
     ExecutionToken token;
     token.data = packet;
 
-    TokenList result;
+    TokenList result = std::move(pageTokens);
     result.push_back(token);
     return result;
 }
@@ -309,6 +355,8 @@ QJsonObject DatabaseNode::saveState() const
     QJsonObject state;
     state.insert(QStringLiteral("databasePath"), m_databasePath);
     state.insert(QStringLiteral("sqlQuery"), m_sqlQuery);
+    state.insert(QStringLiteral("resultFormat"), m_resultFormat);
+    state.insert(QStringLiteral("pageSize"), m_pageSize);
     return state;
 }
 
@@ -316,16 +364,13 @@ void DatabaseNode::loadState(const QJsonObject& data)
 {
     if (data.contains(QStringLiteral("databasePath"))) {
         m_databasePath = data.value(QStringLiteral("databasePath")).toString();
-        if (propertiesWidget) {
-            propertiesWidget->setDatabasePath(m_databasePath);
-        }
     }
     if (data.contains(QStringLiteral("sqlQuery"))) {
         m_sqlQuery = data.value(QStringLiteral("sqlQuery")).toString();
-        if (propertiesWidget) {
-            propertiesWidget->setSqlQuery(m_sqlQuery);
-        }
     }
+    onResultFormatChanged(data.value(QStringLiteral("resultFormat")).toString(QString::fromLatin1(kResultMarkdown)));
+    onPageSizeChanged(data.value(QStringLiteral("pageSize")).toInt(kDefaultPageSize));
+    emit stateLoaded();
 }
 
 void DatabaseNode::onDatabasePathChanged(const QString& path)
@@ -339,3 +384,14 @@ void DatabaseNode::onSqlQueryChanged(const QString& query)
     if (m_sqlQuery == query) return;
     m_sqlQuery = query;
 }
+
+void DatabaseNode::onResultFormatChanged(const QString& format)
+{
+    m_resultFormat = format == QLatin1String(kResultRows) ? QString::fromLatin1(kResultRows)
+                                                          : QString::fromLatin1(kResultMarkdown);
+}
+
+void DatabaseNode::onPageSizeChanged(int rows)
+{
+    m_pageSize = std::clamp(rows, 1, kMaxPageSize);
+}
@@ -24,12 +24,12 @@
 #pragma once
 
 #include <QObject>
-#include <QWidget>
 #include <QJsonObject>
 #include <QString>
 
 #include "IToolNode.h" // includes CommonDataTypes.h
-#include "DatabasePropertiesWidget.h"
+
+class QWidget;
 
 class DatabaseNode : public QObject, public IToolNode {
     Q_OBJECT
@@ -40,17 +40,34 @@ public:
 
     // IToolNode interface
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in DatabasePropertiesWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     TokenList execute(const TokenList& incomingTokens) override;
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
 
+    // Result formats: one Markdown table on stdout, or pages of rows on the rows pin
+    static constexpr const char* kResultMarkdown = "markdown";
+    static constexpr const char* kResultRows = "rows";
+    static constexpr int kDefaultPageSize = 500;
+    static constexpr int kMaxPageSize = 100000;
+
+    QString resultFormat() const { return m_resultFormat; }
+    int pageSize() const { return m_pageSize; }
+
+signals:
+    // Emitted by loadState() so an open properties widget can refresh
+    void stateLoaded();
+
 private slots:
     void onDatabasePathChanged(const QString& path);
     void onSqlQueryChanged(const QString& query);
+    void onResultFormatChanged(const QString& format);
+    void onPageSizeChanged(int rows);
 
 private:
-    DatabasePropertiesWidget* propertiesWidget {nullptr};
     QString m_databasePath;
     QString m_sqlQuery;
+    QString m_resultFormat {QString::fromLatin1(kResultMarkdown)};
+    int m_pageSize {kDefaultPageSize};
 };
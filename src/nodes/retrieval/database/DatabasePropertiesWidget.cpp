@@ -22,7 +22,10 @@
 // SOFTWARE.
 //
 #include "DatabasePropertiesWidget.h"
+#include "DatabaseNode.h"
 
+#include <QComboBox>
+#include <QSpinBox>
 #include <QVBoxLayout>
 #include <QLabel>
 #include <QLineEdit>
@@ -53,6 +56,21 @@ DatabasePropertiesWidget::DatabasePropertiesWidget(QWidget* parent)
     m_sqlEdit->setMaximumHeight(100);
     layout->addWidget(m_sqlEdit);
 
+    layout->addWidget(new QLabel(tr("Query results:"), this));
+    m_formatCombo = new QComboBox(this);
+    m_formatCombo->addItem(tr("Markdown table on stdout"), QString::fromLatin1(DatabaseNode::kResultMarkdown));
+    m_formatCombo->addItem(tr("Pages of rows on the rows pin"), QString::fromLatin1(DatabaseNode::kResultRows));
+    m_formatCombo->setToolTip(tr("Rows are read through the cursor and sent as JSON arrays of row objects, "
+                                 "a page at a time, so large results never sit in memory whole"));
+    layout->addWidget(m_formatCombo);
+
+    layout->addWidget(new QLabel(tr("Rows per page:"), this));
+    m_pageSizeSpin = new QSpinBox(this);
+    m_pageSizeSpin->setRange(1, DatabaseNode::kMaxPageSize);
+    m_pageSizeSpin->setValue(DatabaseNode::kDefaultPageSize);
+    m_pageSizeSpin->setEnabled(false);
+    layout->addWidget(m_pageSizeSpin);
+
     layout->addStretch();
 
     // Forward edits to our signal
@@ -60,6 +78,12 @@ DatabasePropertiesWidget::DatabasePropertiesWidget(QWidget* parent)
                      this, &DatabasePropertiesWidget::databasePathChanged);
     QObject::connect(m_sqlEdit, &QTextEdit::textChanged,
                      this, [this]() { emit sqlQueryChanged(m_sqlEdit->toPlainText()); });
+    QObject::connect(m_formatCombo, &QComboBox::currentIndexChanged, this, [this]() {
+        const QString format = m_formatCombo->currentData().toString();
+        m_pageSizeSpin->setEnabled(format == QLatin1String(DatabaseNode::kResultRows));
+        emit resultFormatChanged(format);
+    });
+    QObject::connect(m_pageSizeSpin, &QSpinBox::valueChanged, this, &DatabasePropertiesWidget::pageSizeChanged);
 }
 
 void DatabasePropertiesWidget::setDatabasePath(const QString& path)
@@ -103,3 +127,43 @@ QString DatabasePropertiesWidget::sqlQuery() const
 {
     return m_sqlEdit ? m_sqlEdit->toPlainText() : QString();
 }
+
+void DatabasePropertiesWidget::setResultFormat(const QString& format)
+{
+    if (m_formatCombo) {
+        const int index = m_formatCombo->findData(format);
+        m_formatCombo->setCurrentIndex(index >= 0 ? index : 0);
+    }
+}
+
+void DatabasePropertiesWidget::setPageSize(int rows)
+{
+    if (m_pageSizeSpin) {
+        m_pageSizeSpin->setValue(rows);
+    }
+}
+
+QWidget* DatabaseNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* widget = new DatabasePropertiesWidget(parent);
+    const auto showState = [this, widget]() {
+        widget->setDatabasePath(m_databasePath);
+        widget->setSqlQuery(m_sqlQuery);
+        widget->setResultFormat(m_resultFormat);
+        widget->setPageSize(m_pageSize);
+    };
+    // initialize UI from current state
+    showState();
+    // connect UI -> node
+    QObject::connect(widget, &DatabasePropertiesWidget::databasePathChanged,
+                     this, &DatabaseNode::onDatabasePathChanged);
+    QObject::connect(widget, &DatabasePropertiesWidget::sqlQueryChanged,
+                     this, &DatabaseNode::onSqlQueryChanged);
+    QObject::connect(widget, &DatabasePropertiesWidget::resultFormatChanged,
+                     this, &DatabaseNode::onResultFormatChanged);
+    QObject::connect(widget, &DatabasePropertiesWidget::pageSizeChanged,
+                     this, &DatabaseNode::onPageSizeChanged);
+    // node -> UI when a saved pipeline is loaded
+    QObject::connect(this, &DatabaseNode::stateLoaded, widget, showState);
+    return widget;
+}
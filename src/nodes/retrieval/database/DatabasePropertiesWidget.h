@@ -26,7 +26,9 @@
 #include <QWidget>
 #include <QString>
 
+class QComboBox;
 class QLineEdit;
+class QSpinBox;
 class QTextEdit;
 
 // Properties panel widget for the Database node.
@@ -42,11 +44,18 @@ public:
     void setSqlQuery(const QString& query);
     QString sqlQuery() const;
 
+    void setResultFormat(const QString& format);
+    void setPageSize(int rows);
+
 signals:
     void databasePathChanged(const QString& path);
     void sqlQueryChanged(const QString& query);
+    void resultFormatChanged(const QString& format);
+    void pageSizeChanged(int rows);
 
 private:
     QLineEdit* m_pathEdit {nullptr};
     QTextEdit* m_sqlEdit {nullptr};
+    QComboBox* m_formatCombo {nullptr};
+    QSpinBox* m_pageSizeSpin {nullptr};
 };
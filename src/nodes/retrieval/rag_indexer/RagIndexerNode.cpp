@@ -22,14 +22,22 @@
 // SOFTWARE.
 //
 #include "RagIndexerNode.h"
-#include "RagIndexerPropertiesWidget.h"
+#include "retrieval/documents/DirectoryScanner.h"
 #include "retrieval/documents/DocumentLoader.h"
+#include "retrieval/chunking/ParallelChunker.h"
+#include "retrieval/chunking/StreamingChunker.h"
 #include "retrieval/chunking/TextChunker.h"
 #include "retrieval/storage/RagUtils.h"
+#include "retrieval/storage/DuplicateIndex.h"
+#include "retrieval/storage/EmbeddingCache.h"
+#include "retrieval/storage/RagQueryCache.h"
+#include "retrieval/storage/SqliteConnectionPool.h"
 #include "ai/registry/LLMProviderRegistry.h"
 #include "ai/backends/ILLMBackend.h"
 #include "ai/catalog/ModelCatalogService.h"
 #include "ModelCapsRegistry.h"
+#include "CancellationToken.h"
+#include "Tracer.h"
 
 #include <QtConcurrent>
 #include <QSqlDatabase>
@@ -37,18 +45,33 @@
 #include <QSqlError>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QCryptographicHash>
 #include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QSet>
 #include "Logger.h"
 #include <QUuid>
 #include <QElapsedTimer>
 #include <QVector>
+#include <QThread>
+#include <QThreadPool>
+
+#include <deque>
+#include <map>
+#include <optional>
+#include <vector>
 
 namespace {
 
-struct ChunkLineRange {
-    int startLine {0};
-    int endLine {0};
-};
+// Chunks handed to ILLMBackend::getEmbeddings() at once. The backend splits
+// further to fit provider limits; this only bounds how long a cancel takes.
+constexpr int kEmbeddingBatchChunks = 64;
+
+// Files larger than this are hashed and chunked as a stream of windows
+// rather than decoded into one string first.
+constexpr qint64 kStreamedFileBytes = 256LL * 1024 * 1024;
 
 FileType fileTypeForChunkingStrategy(const QString& strategy, const QString& filePath)
 {
@@ -80,56 +103,206 @@ FileType fileTypeForChunkingStrategy(const QString& strategy, const QString& fil
     return DocumentLoader::getFileTypeFromExtension(filePath);
 }
 
-int lineNumberForOffset(const QString& text, int offset)
+// A source_files row as it stood before this run
+struct IndexedFile {
+    qint64 id {0};
+    qint64 lastModified {0};
+    qint64 size {-1};
+    QString contentHash;
+    QString chunking;
+    QString provider;
+    QString model;
+    int dimensions {0};
+    QString metadata;
+};
+
+// A scanned file that may need (re-)indexing
+struct FileToIndex {
+    QString filePath;
+    qint64 lastModified {0};
+    qint64 size {0};
+    // The stored row, or id 0 for a new file
+    IndexedFile known;
+    // Content handed in on the text pin; null when the file is read from disk
+    QString text;
+};
+
+// A file read and chunked by a pipeline worker
+struct PreparedFile {
+    QString filePath;
+    bool empty {true};
+    // Same text as the stored row, so it was not chunked
+    bool unchanged {false};
+    QString contentHash;
+    // Chunks are ranges of the text, materialised one embedding batch at a time
+    QString content;
+    QList<TextChunkSpan> spans;
+    // A streamed file's chunks, since its whole text is never held
+    QStringList chunkTexts;
+    // Per chunk, for deduplication: DuplicateIndex::contentHash() and, for near matching, simHash()
+    QList<qint64> chunkHashes;
+    QList<quint64> chunkSimHashes;
+};
+
+QStringView chunkText(const PreparedFile& prepared, qsizetype i)
+{
+    const TextChunkSpan& span = prepared.spans.at(i);
+    return prepared.chunkTexts.isEmpty() ? QStringView(prepared.content).mid(span.offset, span.length)
+                                         : QStringView(prepared.chunkTexts.at(i));
+}
+
+// Fills in a prepared file's chunk fingerprints on its worker thread
+void fingerprintChunks(PreparedFile& prepared, bool nearDuplicates)
 {
-    if (text.isEmpty()) {
-        return 0;
+    prepared.chunkHashes.reserve(prepared.spans.size());
+    if (nearDuplicates) {
+        prepared.chunkSimHashes.reserve(prepared.spans.size());
+    }
+    for (qsizetype i = 0; i < prepared.spans.size(); ++i) {
+        const QStringView text = chunkText(prepared, i);
+        prepared.chunkHashes.append(DuplicateIndex::contentHash(text));
+        if (nearDuplicates) {
+            prepared.chunkSimHashes.append(DuplicateIndex::simHash(text));
+        }
     }
-    const int safeOffset = qBound(0, offset, text.size() - 1);
-    return text.left(safeOffset).count(QLatin1Char('\n')) + 1;
 }
 
-QVector<ChunkLineRange> calculateChunkLineRanges(const QString& content, const QStringList& chunks)
+// A chunk whose text is already stored or queued. The handle is a fragment id when
+// positive; otherwise -1 - handle is the run-wide position of the chunk it repeats.
+struct DuplicateChunk {
+    int chunkIndex {0};
+    qint64 handle {0};
+    // Same text, so the target's content is compared on insert to rule out a hash collision
+    bool exact {true};
+};
+
+// A file between the read/chunk stage and the writer
+struct PendingFile {
+    int fileIndex {0};
+    FileToIndex file;
+    QFuture<PreparedFile> prepared;
+    bool started {false};
+    std::vector<QStringList> batchTexts;
+    // Chunk index of each text in batchTexts
+    std::vector<std::vector<int>> batchChunks;
+    // Run-wide position of the first of them, for resolving DuplicateChunk handles
+    qint64 firstOrdinal {0};
+    // Chunks stored as fragment_sources rows of an existing or earlier fragment instead of being embedded
+    std::vector<DuplicateChunk> duplicates;
+    std::vector<QFuture<EmbeddingBatchResult>> batches;
+};
+
+QString contentHash(const QString& content)
 {
-    QVector<ChunkLineRange> ranges;
-    ranges.reserve(chunks.size());
+    return QString::fromLatin1(QCryptographicHash::hash(content.toUtf8(), QCryptographicHash::Sha256).toHex());
+}
 
-    int searchFrom = 0;
-    int previousStartLine = 1;
-    int previousEndLine = 1;
+// Reads a large file twice as a stream: once to hash it, and only if it
+// changed once more to chunk it, so its text is never decoded whole.
+PreparedFile prepareStreamedFile(const QString& filePath, const QString& knownHash, int chunkSize, int chunkOverlap,
+                                 FileType fileType)
+{
+    PreparedFile prepared;
+    prepared.filePath = filePath;
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    const bool readable = DocumentLoader::streamTextFile(filePath, [&prepared, &hash](QStringView window) {
+        prepared.empty = false;
+        hash.addData(window.toUtf8());
+        return true;
+    });
+    if (!readable || prepared.empty) {
+        prepared.empty = true;
+        return prepared;
+    }
+    prepared.contentHash = QString::fromLatin1(hash.result().toHex());
+    if (prepared.contentHash == knownHash) {
+        prepared.unchanged = true;
+        return prepared;
+    }
 
-    for (const QString& chunk : chunks) {
-        ChunkLineRange range;
-        if (chunk.isEmpty() || content.isEmpty()) {
-            ranges.append(range);
-            continue;
-        }
+    StreamingChunker chunker(chunkSize, chunkOverlap, fileType,
+                             [&prepared](const QString& chunk, const TextChunkSpan& span) {
+                                 prepared.chunkTexts.append(chunk);
+                                 prepared.spans.append(span);
+                             });
+    DocumentLoader::streamTextFile(filePath, [&chunker](QStringView window) {
+        chunker.append(window);
+        return true;
+    });
+    chunker.finish();
+    return prepared;
+}
 
-        const int lookupStart = qMax(0, searchFrom - 1024);
-        int found = content.indexOf(chunk, lookupStart);
-        if (found < 0) {
-            const QString prefix = chunk.left(qMin(160, chunk.size()));
-            if (!prefix.isEmpty()) {
-                found = content.indexOf(prefix, lookupStart);
+// The whole table for a directory walk, or only the given paths for an ingested token
+QHash<QString, IndexedFile> loadIndexedFiles(QSqlDatabase& db, const QStringList& paths = {})
+{
+    QHash<QString, IndexedFile> indexed;
+    QSqlQuery query(db);
+    const QString select = QStringLiteral("SELECT id, file_path, last_modified, file_size, content_hash, chunking, "
+                                          "provider, model, metadata, embedding_dimensions FROM source_files");
+    auto read = [&query, &indexed]() {
+        while (query.next()) {
+            IndexedFile file;
+            file.id = query.value(0).toLongLong();
+            file.lastModified = query.value(2).toLongLong();
+            file.size = query.value(3).isNull() ? -1 : query.value(3).toLongLong();
+            file.contentHash = query.value(4).toString();
+            file.chunking = query.value(5).toString();
+            file.provider = query.value(6).toString();
+            file.model = query.value(7).toString();
+            file.metadata = query.value(8).toString();
+            file.dimensions = query.value(9).toInt();
+            indexed.insert(query.value(1).toString(), file);
+        }
+    };
+    if (!paths.isEmpty()) {
+        query.prepare(select + QStringLiteral(" WHERE file_path = ?"));
+        for (const QString& path : paths) {
+            query.bindValue(0, path);
+            if (!query.exec()) {
+                CP_WARN << "RagIndexerNode: Failed to read indexed file" << path << ":" << query.lastError().text();
+                continue;
             }
+            read();
         }
+        return indexed;
+    }
+    if (!query.exec(select)) {
+        CP_WARN << "RagIndexerNode: Failed to read indexed files:" << query.lastError().text();
+        return indexed;
+    }
+    read();
+    return indexed;
+}
 
-        if (found < 0) {
-            range.startLine = previousStartLine;
-            range.endLine = previousEndLine;
-        } else {
-            const int endOffset = qMax(found, found + chunk.size() - 1);
-            range.startLine = lineNumberForOffset(content, found);
-            range.endLine = lineNumberForOffset(content, endOffset);
-            previousStartLine = range.startLine;
-            previousEndLine = range.endLine;
-            searchFrom = found + 1;
+// Paths on the file pin: a list, or one per line of a text value
+QStringList ingestPathsFrom(const QVariant& value)
+{
+    QStringList raw;
+    if (value.typeId() == QMetaType::QStringList) {
+        raw = value.toStringList();
+    } else if (value.typeId() == QMetaType::QVariantList) {
+        for (const QVariant& item : value.toList()) {
+            raw.append(item.toString());
         }
-
-        ranges.append(range);
+    } else {
+        raw = value.toString().split(QLatin1Char('\n'));
     }
-
-    return ranges;
+    QStringList paths;
+    QSet<QString> seen;
+    for (const QString& path : std::as_const(raw)) {
+        const QString trimmed = path.trimmed();
+        if (trimmed.isEmpty()) {
+            continue;
+        }
+        const QString absolute = QFileInfo(trimmed).absoluteFilePath();
+        if (!seen.contains(absolute)) {
+            seen.insert(absolute);
+            paths.append(absolute);
+        }
+    }
+    return paths;
 }
 
 bool ensureFragmentLineColumns(QSqlDatabase& db)
@@ -163,6 +336,224 @@ bool ensureFragmentLineColumns(QSqlDatabase& db)
     return true;
 }
 
+bool ensureEmbeddingFormatColumns(QSqlDatabase& db)
+{
+    QSqlQuery pragmaQuery(db);
+    bool hasFormat = false;
+    bool hasDimensions = false;
+    bool hasFullPrecision = false;
+    if (!pragmaQuery.exec(QStringLiteral("PRAGMA table_xinfo(source_files)"))) {
+        CP_WARN << "RagIndexerNode: Failed to inspect source_files table columns:" << pragmaQuery.lastError().text();
+        return false;
+    }
+    while (pragmaQuery.next()) {
+        hasFormat = hasFormat || pragmaQuery.value(1).toString() == QStringLiteral("embedding_format");
+        hasDimensions = hasDimensions || pragmaQuery.value(1).toString() == QStringLiteral("embedding_dimensions");
+    }
+    if (!pragmaQuery.exec(QStringLiteral("PRAGMA table_info(fragments)"))) {
+        CP_WARN << "RagIndexerNode: Failed to inspect fragments table columns:" << pragmaQuery.lastError().text();
+        return false;
+    }
+    while (pragmaQuery.next()) {
+        hasFullPrecision = hasFullPrecision || pragmaQuery.value(1).toString() == QStringLiteral("embedding_full");
+    }
+
+    QSqlQuery alterQuery(db);
+    if (!hasFormat
+        && !alterQuery.exec(QStringLiteral(
+            "ALTER TABLE source_files ADD COLUMN embedding_format TEXT NOT NULL DEFAULT 'float32'"))) {
+        CP_WARN << "RagIndexerNode: Failed to add source_files.embedding_format:" << alterQuery.lastError().text();
+        return false;
+    }
+    if (!hasDimensions
+        && !alterQuery.exec(QStringLiteral(
+            "ALTER TABLE source_files ADD COLUMN embedding_dimensions INTEGER NOT NULL DEFAULT 0"))) {
+        CP_WARN << "RagIndexerNode: Failed to add source_files.embedding_dimensions:" << alterQuery.lastError().text();
+        return false;
+    }
+    if (!hasFullPrecision
+        && !alterQuery.exec(QStringLiteral("ALTER TABLE fragments ADD COLUMN embedding_full BLOB"))) {
+        CP_WARN << "RagIndexerNode: Failed to add fragments.embedding_full:" << alterQuery.lastError().text();
+        return false;
+    }
+
+    return true;
+}
+
+bool ensureIncrementalColumns(QSqlDatabase& db)
+{
+    QSqlQuery pragmaQuery(db);
+    QSet<QString> columns;
+    if (!pragmaQuery.exec(QStringLiteral("PRAGMA table_xinfo(source_files)"))) {
+        CP_WARN << "RagIndexerNode: Failed to inspect source_files table columns:" << pragmaQuery.lastError().text();
+        return false;
+    }
+    while (pragmaQuery.next()) {
+        columns.insert(pragmaQuery.value(1).toString());
+    }
+
+    // Rows from older databases have no hash, so their files are re-indexed once
+    QSqlQuery alterQuery(db);
+    const QList<QPair<QString, QString>> added {
+        {QStringLiteral("file_size"), QStringLiteral("INTEGER")},
+        {QStringLiteral("content_hash"), QStringLiteral("TEXT")},
+        {QStringLiteral("chunking"), QStringLiteral("TEXT")},
+    };
+    for (const auto& [name, type] : added) {
+        if (!columns.contains(name)
+            && !alterQuery.exec(QStringLiteral("ALTER TABLE source_files ADD COLUMN %1 %2").arg(name, type))) {
+            CP_WARN << "RagIndexerNode: Failed to add source_files." << name << ":" << alterQuery.lastError().text();
+            return false;
+        }
+    }
+
+    // Search filters work without these, only slower, so a failure is not fatal
+    if (!columns.contains(QStringLiteral("file_type"))
+        && !alterQuery.exec(QString::fromLatin1(kRagSchemaSourceFileTypeColumn)
+                                .arg(QString::fromLatin1(kRagSourceFileTypeExpression)))) {
+        CP_WARN << "RagIndexerNode: Failed to add source_files.file_type:" << alterQuery.lastError().text();
+    }
+
+    return true;
+}
+
+// Queries work without these, only slower, so a failure is not fatal
+void createSecondaryIndexes(QSqlDatabase& db)
+{
+    QSqlQuery indexQuery(db);
+    for (const char* statement : kRagSchemaSearchFilterIndexes) {
+        if (!indexQuery.exec(QString::fromLatin1(statement))) {
+            CP_WARN << "RagIndexerNode: Failed to create search filter index:" << indexQuery.lastError().text();
+        }
+    }
+    for (const char* statement : kRagSchemaFragmentIndexes) {
+        if (!indexQuery.exec(QString::fromLatin1(statement))) {
+            CP_WARN << "RagIndexerNode: Failed to create fragments index:" << indexQuery.lastError().text();
+        }
+    }
+}
+
+// A bulk load into empty tables builds each index once at the end instead of row by row
+void dropSecondaryIndexes(QSqlDatabase& db)
+{
+    QSqlQuery indexQuery(db);
+    for (const char* name : kRagSchemaSecondaryIndexNames) {
+        if (!indexQuery.exec(QStringLiteral("DROP INDEX IF EXISTS %1").arg(QString::fromLatin1(name)))) {
+            CP_WARN << "RagIndexerNode: Failed to drop index" << name << ":" << indexQuery.lastError().text();
+        }
+    }
+}
+
+// One multi-row INSERT for a whole embedding batch, 9 bound values per row
+QString fragmentInsertSql(int rows)
+{
+    QString sql = QStringLiteral(
+        "INSERT INTO fragments (file_id, chunk_index, start_line, end_line, content, embedding, embedding_full, "
+        "content_hash, simhash) VALUES ");
+    for (int row = 0; row < rows; ++row) {
+        sql += row == 0 ? QStringLiteral("(?, ?, ?, ?, ?, ?, ?, ?, ?)") : QStringLiteral(", (?, ?, ?, ?, ?, ?, ?, ?, ?)");
+    }
+    return sql;
+}
+
+bool ensureDeduplicationSchema(QSqlDatabase& db)
+{
+    QSqlQuery pragmaQuery(db);
+    QSet<QString> columns;
+    if (!pragmaQuery.exec(QStringLiteral("PRAGMA table_info(fragments)"))) {
+        CP_WARN << "RagIndexerNode: Failed to inspect fragments table columns:" << pragmaQuery.lastError().text();
+        return false;
+    }
+    while (pragmaQuery.next()) {
+        columns.insert(pragmaQuery.value(1).toString());
+    }
+
+    QSqlQuery alterQuery(db);
+    for (const QString& name : {QStringLiteral("content_hash"), QStringLiteral("simhash")}) {
+        if (!columns.contains(name)
+            && !alterQuery.exec(QStringLiteral("ALTER TABLE fragments ADD COLUMN %1 INTEGER").arg(name))) {
+            CP_WARN << "RagIndexerNode: Failed to add fragments." << name << ":" << alterQuery.lastError().text();
+            return false;
+        }
+    }
+    if (!alterQuery.exec(QString::fromLatin1(kRagSchemaFragmentSources))) {
+        CP_WARN << "RagIndexerNode: Failed to create fragment_sources table:" << alterQuery.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+// Deletes a file's fragments and duplicate rows. A fragment other files share passes to its
+// oldest remaining fragment_sources row instead, keeping its id, text and embedding.
+bool releaseFileFragments(QSqlDatabase& db, qint64 fileId, QString& error)
+{
+    QSqlQuery query(db);
+    query.prepare(QStringLiteral("DELETE FROM fragment_sources WHERE file_id = ?"));
+    query.addBindValue(fileId);
+    if (!query.exec()) {
+        error = query.lastError().text();
+        return false;
+    }
+
+    query.prepare(QStringLiteral(
+        "SELECT MIN(d.id) FROM fragment_sources d JOIN fragments f ON f.id = d.fragment_id "
+        "WHERE f.file_id = ? GROUP BY d.fragment_id"));
+    query.addBindValue(fileId);
+    if (!query.exec()) {
+        error = query.lastError().text();
+        return false;
+    }
+    QVector<qint64> heirs;
+    while (query.next()) {
+        heirs.append(query.value(0).toLongLong());
+    }
+
+    QSqlQuery promoteQuery(db);
+    promoteQuery.prepare(QStringLiteral(
+        "UPDATE fragments SET (file_id, chunk_index, start_line, end_line) = "
+        "(SELECT file_id, chunk_index, start_line, end_line FROM fragment_sources WHERE id = ?) "
+        "WHERE id = (SELECT fragment_id FROM fragment_sources WHERE id = ?)"));
+    QSqlQuery dropQuery(db);
+    dropQuery.prepare(QStringLiteral("DELETE FROM fragment_sources WHERE id = ?"));
+    for (const qint64 heir : std::as_const(heirs)) {
+        promoteQuery.bindValue(0, heir);
+        promoteQuery.bindValue(1, heir);
+        dropQuery.bindValue(0, heir);
+        if (!promoteQuery.exec() || !dropQuery.exec()) {
+            error = promoteQuery.lastError().text() + dropQuery.lastError().text();
+            return false;
+        }
+    }
+
+    query.prepare(QStringLiteral("DELETE FROM fragments WHERE file_id = ?"));
+    query.addBindValue(fileId);
+    if (!query.exec()) {
+        error = query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+// Records a run's progress in index_jobs; the row stays "running" if the process dies
+bool writeIndexJob(QSqlDatabase& db, const QString& directory, const QString& state, int filesTotal, int filesDone)
+{
+    QSqlQuery query(db);
+    query.prepare(QStringLiteral(
+        "INSERT INTO index_jobs (directory, state, files_total, files_done, updated_at) VALUES (?, ?, ?, ?, ?) "
+        "ON CONFLICT(directory) DO UPDATE SET state = excluded.state, files_total = excluded.files_total, "
+        "files_done = excluded.files_done, updated_at = excluded.updated_at"));
+    query.addBindValue(directory);
+    query.addBindValue(state);
+    query.addBindValue(filesTotal);
+    query.addBindValue(filesDone);
+    query.addBindValue(QDateTime::currentMSecsSinceEpoch());
+    if (!query.exec()) {
+        CP_WARN << "RagIndexerNode: Failed to record indexing job for" << directory << ":" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
 } // namespace
 
 RagIndexerNode::RagIndexerNode(QObject* parent)
@@ -192,6 +583,12 @@ NodeDescriptor RagIndexerNode::getDescriptor() const
     desc.inputPins.insert(QString::fromLatin1(kInputDirectoryPath), 
         PinDefinition{PinDirection::Input, QString::fromLatin1(kInputDirectoryPath), 
                      QStringLiteral("Directory"), QStringLiteral("text")});
+    desc.inputPins.insert(QString::fromLatin1(kInputFilePath),
+        PinDefinition{PinDirection::Input, QString::fromLatin1(kInputFilePath),
+                     QStringLiteral("File"), QStringLiteral("text")});
+    desc.inputPins.insert(QString::fromLatin1(kInputText),
+        PinDefinition{PinDirection::Input, QString::fromLatin1(kInputText),
+                     QStringLiteral("Text"), QStringLiteral("text")});
 
     // Output pins
     desc.outputPins.insert(QString::fromLatin1(kOutputCount), 
@@ -201,71 +598,6 @@ NodeDescriptor RagIndexerNode::getDescriptor() const
     return desc;
 }
 
-QWidget* RagIndexerNode::createConfigurationWidget(QWidget* parent)
-{
-    auto* widget = new RagIndexerPropertiesWidget(parent);
-    
-    // Initialize widget with current state
-    widget->setDirectoryPath(m_directoryPath);
-    widget->setDatabasePath(m_databasePath);
-    widget->setIndexMetadata(m_indexMetadata);
-    widget->setProviderId(m_providerId);
-    widget->setModelId(m_modelId);
-    widget->setChunkSize(m_chunkSize);
-    widget->setChunkOverlap(m_chunkOverlap);
-    widget->setFileFilter(m_fileFilter);
-    widget->setChunkingStrategy(m_chunkingStrategy);
-    widget->setClearDatabase(m_clearDatabase);
-
-    // Connect widget signals to node slots
-    QObject::connect(widget, &RagIndexerPropertiesWidget::directoryPathChanged,
-                     this, &RagIndexerNode::setDirectoryPath);
-    QObject::connect(widget, &RagIndexerPropertiesWidget::databasePathChanged,
-                     this, &RagIndexerNode::setDatabasePath);
-    QObject::connect(widget, &RagIndexerPropertiesWidget::indexMetadataChanged,
-                     this, &RagIndexerNode::setIndexMetadata);
-    QObject::connect(widget, &RagIndexerPropertiesWidget::providerChanged,
-                     this, &RagIndexerNode::setProviderId);
-    QObject::connect(widget, &RagIndexerPropertiesWidget::modelChanged,
-                     this, &RagIndexerNode::setModelId);
-    QObject::connect(widget, &RagIndexerPropertiesWidget::chunkSizeChanged,
-                     this, &RagIndexerNode::setChunkSize);
-    QObject::connect(widget, &RagIndexerPropertiesWidget::chunkOverlapChanged,
-                     this, &RagIndexerNode::setChunkOverlap);
-    QObject::connect(widget, &RagIndexerPropertiesWidget::fileFilterChanged,
-                     this, &RagIndexerNode::setFileFilter);
-    QObject::connect(widget, &RagIndexerPropertiesWidget::chunkingStrategyChanged,
-                     this, &RagIndexerNode::setChunkingStrategy);
-    QObject::connect(widget, &RagIndexerPropertiesWidget::clearDatabaseChanged,
-                     this, &RagIndexerNode::setClearDatabase);
-
-    // Connect node signals back to widget for external updates
-    QObject::connect(this, &RagIndexerNode::directoryPathChanged,
-                     widget, &RagIndexerPropertiesWidget::setDirectoryPath);
-    QObject::connect(this, &RagIndexerNode::databasePathChanged,
-                     widget, &RagIndexerPropertiesWidget::setDatabasePath);
-    QObject::connect(this, &RagIndexerNode::indexMetadataChanged,
-                     widget, &RagIndexerPropertiesWidget::setIndexMetadata);
-    QObject::connect(this, &RagIndexerNode::providerChanged,
-                     widget, &RagIndexerPropertiesWidget::setProviderId);
-    QObject::connect(this, &RagIndexerNode::modelChanged,
-                     widget, &RagIndexerPropertiesWidget::setModelId);
-    QObject::connect(this, &RagIndexerNode::chunkSizeChanged,
-                     widget, &RagIndexerPropertiesWidget::setChunkSize);
-    QObject::connect(this, &RagIndexerNode::chunkOverlapChanged,
-                     widget, &RagIndexerPropertiesWidget::setChunkOverlap);
-    QObject::connect(this, &RagIndexerNode::fileFilterChanged,
-                     widget, &RagIndexerPropertiesWidget::setFileFilter);
-    QObject::connect(this, &RagIndexerNode::chunkingStrategyChanged,
-                     widget, &RagIndexerPropertiesWidget::setChunkingStrategy);
-    QObject::connect(this, &RagIndexerNode::clearDatabaseChanged,
-                     widget, &RagIndexerPropertiesWidget::setClearDatabase);
-    QObject::connect(this, &RagIndexerNode::statusChanged,
-                     widget, &RagIndexerPropertiesWidget::setStatusMessage);
-
-    return widget;
-}
-
 TokenList RagIndexerNode::execute(const TokenList& incomingTokens)
 {
     // Merge incoming tokens into a single DataPacket to preserve the
@@ -290,7 +622,11 @@ TokenList RagIndexerNode::execute(const TokenList& incomingTokens)
 
 QFuture<DataPacket> RagIndexerNode::Execute(const DataPacket& inputs)
 {
-    return QtConcurrent::run([this, inputs]() -> DataPacket {
+    // Indexing runs on another thread, so it takes the caller's run token along
+    return QtConcurrent::run([this, inputs, cancellation = CancellationToken::current(),
+                              tracingContext = Tracer::current()]() -> DataPacket {
+        const CancellationToken::Scope cancellationScope(cancellation);
+        const Tracer::Scope tracingScope(tracingContext);
         DataPacket output;
 
         // Verbose logging is opt-in to avoid noisy debug output during
@@ -319,6 +655,22 @@ QFuture<DataPacket> RagIndexerNode::Execute(const DataPacket& inputs)
             metadata = m_indexMetadata;
         }
 
+        // Ingest mode: documents handed in by an upstream node go into the existing index one
+        // token at a time, each committed when its execution ends, instead of a directory walk
+        const bool ingest = inputs.contains(QString::fromLatin1(kInputFilePath))
+                            || inputs.contains(QString::fromLatin1(kInputText));
+        QStringList ingestPaths = ingestPathsFrom(inputs.value(QString::fromLatin1(kInputFilePath)));
+        QHash<QString, QString> ingestTexts;
+        if (const QString text = inputs.value(QString::fromLatin1(kInputText)).toString(); !text.isEmpty()) {
+            // Named by its one path so a later version replaces it; otherwise by its content
+            const QString name = ingestPaths.size() == 1 ? ingestPaths.front()
+                                                         : QStringLiteral("text:%1").arg(contentHash(text));
+            if (!ingestPaths.contains(name)) {
+                ingestPaths.append(name);
+            }
+            ingestTexts.insert(name, text);
+        }
+
         output.insert(QString::fromLatin1(kOutputCount), QString::number(0));
         if (!dbPath.isEmpty()) {
             output.insert(QString::fromLatin1(kOutputDatabasePath), dbPath);
@@ -339,8 +691,54 @@ QFuture<DataPacket> RagIndexerNode::Execute(const DataPacket& inputs)
 
         emit statusChanged(QStringLiteral("Status: preparing index run..."));
 
+        // Maintenance mode: only the database is touched, so no directory or provider is needed
+        if (m_compactIndex) {
+            if (dbPath.isEmpty()) {
+                const QString msg = QStringLiteral("RAG Indexer database path is empty.");
+                CP_WARN << msg;
+                return fail(msg);
+            }
+            emit statusChanged(QStringLiteral("Status: compacting index..."));
+            RagUtils::IndexCompaction compaction;
+            try {
+                compaction = RagUtils::compactIndex(dbPath);
+            } catch (const std::exception& ex) {
+                const QString msg = QString::fromUtf8(ex.what());
+                CP_WARN << "RagIndexerNode: Index compaction failed:" << msg;
+                RagQueryCache::bumpGeneration(dbPath);
+                return fail(msg);
+            }
+            RagQueryCache::bumpGeneration(dbPath);
+
+            const RagUtils::IndexStatistics& after = compaction.after;
+            QStringList dimensions;
+            for (auto it = after.dimensions.cbegin(); it != after.dimensions.cend(); ++it) {
+                dimensions.append(QStringLiteral("%1:%2").arg(it.key()).arg(it.value()));
+            }
+            output.insert(QString::fromLatin1(kOutputCount), QString::number(after.fragments));
+            output.insert(QStringLiteral("files"), after.files);
+            output.insert(QStringLiteral("fragments"), after.fragments);
+            output.insert(QStringLiteral("embedding_format"), RagUtils::embeddingFormatName(after.format));
+            output.insert(QStringLiteral("embedding_dimensions"), dimensions.join(QStringLiteral(", ")));
+            output.insert(QStringLiteral("bytes_per_vector"), after.bytesPerVector);
+            output.insert(QStringLiteral("orphans_removed"), compaction.orphansRemoved);
+            output.insert(QStringLiteral("vacuumed"), compaction.vacuumed);
+            output.insert(QStringLiteral("fragmentation_before"), compaction.before.fragmentation());
+            output.insert(QStringLiteral("fragmentation_after"), after.fragmentation());
+            output.insert(QStringLiteral("database_bytes_before"), compaction.before.databaseBytes);
+            output.insert(QStringLiteral("database_bytes_after"), after.databaseBytes);
+            output.insert(QStringLiteral("sidecar_bytes"), after.sidecarBytes);
+            output.insert(QStringLiteral("ann_index_rebuilt"), compaction.annIndexRebuilt);
+            output.insert(QStringLiteral("vector_file_rebuilt"), compaction.vectorFileRebuilt);
+            emit statusChanged(QStringLiteral("Status: compacted %1 fragments, %2 -> %3 bytes")
+                                   .arg(after.fragments)
+                                   .arg(compaction.before.databaseBytes)
+                                   .arg(after.databaseBytes));
+            return output;
+        }
+
         // Validate inputs
-        if (dirPath.isEmpty()) {
+        if (dirPath.isEmpty() && !ingest) {
             const QString msg = QStringLiteral("RAG Indexer directory path is empty.");
             CP_WARN << msg;
             return fail(msg);
@@ -384,6 +782,8 @@ QFuture<DataPacket> RagIndexerNode::Execute(const DataPacket& inputs)
         QString connectionName = QStringLiteral("rag_indexer_") + QUuid::createUuid().toString();
         QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
         db.setDatabaseName(dbPath);
+        // Waits out a reader finishing a WAL checkpoint rather than failing the run
+        db.setConnectOptions(QStringLiteral("QSQLITE_BUSY_TIMEOUT=%1").arg(SqliteConnectionPool::kBusyTimeoutMs));
 
         if (!db.open()) {
             const QString msg = QStringLiteral("Failed to open RAG database: %1").arg(db.lastError().text());
@@ -409,6 +809,11 @@ QFuture<DataPacket> RagIndexerNode::Execute(const DataPacket& inputs)
                 QSqlDatabase::removeDatabase(connectionName);
                 return fail(msg);
             }
+
+            // Concurrent queries then read the last checkpoint instead of waiting for the run's transaction
+            if (!checkQuery.exec(QString::fromLatin1(kRagSchemaJournalMode))) {
+                CP_WARN << "RagIndexerNode: Failed to enable WAL journaling:" << checkQuery.lastError().text();
+            }
             
             // Check if source_files table exists
             bool sourceFilesExists = false;
@@ -422,6 +827,10 @@ QFuture<DataPacket> RagIndexerNode::Execute(const DataPacket& inputs)
             
             // Create source_files table if it doesn't exist
             if (!sourceFilesExists) {
+                // Only takes effect before the first table; lets compaction free pages without a full VACUUM
+                if (!checkQuery.exec(QString::fromLatin1(kRagSchemaAutoVacuum))) {
+                    CP_WARN << "RagIndexerNode: Failed to enable incremental auto-vacuum:" << checkQuery.lastError().text();
+                }
                 if (!checkQuery.exec(QString::fromLatin1(kRagSchemaSourceFiles))) {
                     const QString msg = QStringLiteral("Failed to create source_files table: %1")
                                             .arg(checkQuery.lastError().text());
@@ -463,11 +872,76 @@ QFuture<DataPacket> RagIndexerNode::Execute(const DataPacket& inputs)
                 QSqlDatabase::removeDatabase(connectionName);
                 return fail(msg);
             }
+
+            if (!ensureEmbeddingFormatColumns(db)) {
+                const QString msg = QStringLiteral("Failed to migrate RAG tables for quantised embedding storage.");
+                db.close();
+                db = QSqlDatabase();
+                QSqlDatabase::removeDatabase(connectionName);
+                return fail(msg);
+            }
+
+            if (!ensureIncrementalColumns(db)) {
+                const QString msg = QStringLiteral("Failed to migrate source_files table for incremental indexing.");
+                db.close();
+                db = QSqlDatabase();
+                QSqlDatabase::removeDatabase(connectionName);
+                return fail(msg);
+            }
+
+            if (!ensureDeduplicationSchema(db)) {
+                const QString msg = QStringLiteral("Failed to migrate RAG tables for duplicate detection.");
+                db.close();
+                db = QSqlDatabase();
+                QSqlDatabase::removeDatabase(connectionName);
+                return fail(msg);
+            }
+
+            // Migration for databases created before the fragments indexes existed
+            createSecondaryIndexes(db);
+
+            if (!checkQuery.exec(QString::fromLatin1(kRagSchemaIndexJobs))) {
+                const QString msg = QStringLiteral("Failed to create index_jobs table: %1")
+                                        .arg(checkQuery.lastError().text());
+                CP_WARN << "RagIndexerNode:" << msg;
+                db.close();
+                db = QSqlDatabase();
+                QSqlDatabase::removeDatabase(connectionName);
+                return fail(msg);
+            }
         } // checkQuery goes out of scope here
 
-        // Clear database if requested (after schema creation to ensure tables exist)
-        if (m_clearDatabase) {
+        // A previous run over this directory that never finished left its
+        // checkpointed files behind. Incremental indexing picks up after them;
+        // with resume enabled the clear is skipped so they are not thrown away.
+        // Ingested documents belong to no directory, so they keep no job row either
+        const QString rootDirectory = ingest ? QString() : QDir(dirPath).absolutePath();
+        auto recordJob = [&db, &rootDirectory, ingest](const QString& state, int filesTotal, int filesDone) {
+            if (!ingest) {
+                writeIndexJob(db, rootDirectory, state, filesTotal, filesDone);
+            }
+        };
+        bool resumed = false;
+        if (!ingest) {
+            QSqlQuery jobQuery(db);
+            jobQuery.prepare(QStringLiteral("SELECT state, files_done FROM index_jobs WHERE directory = ?"));
+            jobQuery.addBindValue(rootDirectory);
+            if (jobQuery.exec() && jobQuery.next()) {
+                resumed = jobQuery.value(0).toString() != QStringLiteral("completed");
+                if (resumed) {
+                    CP_LOG << "RagIndexerNode: Resuming interrupted run over" << rootDirectory << "after"
+                           << jobQuery.value(1).toInt() << "checkpointed files";
+                }
+            }
+        }
+        output.insert(QStringLiteral("resumed"), resumed);
+
+        // Clear database if requested (after schema creation to ensure tables exist); never per
+        // ingested token, as each would throw away the documents before it
+        if (m_clearDatabase && !ingest && !(resumed && m_resumeInterrupted)) {
             emit statusChanged(QStringLiteral("Status: clearing existing RAG index..."));
+            // Dropped first so the delete does not run a trigger per fragment; rebuilt empty below
+            RagUtils::removeFullTextIndex(dbPath);
             if (!db.transaction()) {
                 const QString msg = QStringLiteral("Failed to start transaction for clearing RAG database: %1")
                                         .arg(db.lastError().text());
@@ -481,8 +955,9 @@ QFuture<DataPacket> RagIndexerNode::Execute(const DataPacket& inputs)
                 bool clearSuccess = true;
                 QString clearError;
                 
-                // Delete all fragments
-                if (!clearQuery.exec(QStringLiteral("DELETE FROM fragments"))) {
+                // Delete all fragments, duplicate references first
+                if (!clearQuery.exec(QStringLiteral("DELETE FROM fragment_sources"))
+                    || !clearQuery.exec(QStringLiteral("DELETE FROM fragments"))) {
                     clearError = QStringLiteral("Failed to delete fragments: %1").arg(clearQuery.lastError().text());
                     CP_WARN << "RagIndexerNode:" << clearError;
                     clearSuccess = false;
@@ -505,6 +980,15 @@ QFuture<DataPacket> RagIndexerNode::Execute(const DataPacket& inputs)
                         clearSuccess = false;
                     }
                 }
+
+                // Jobs over other directories described rows that are now gone
+                if (clearSuccess) {
+                    if (!clearQuery.exec(QStringLiteral("DELETE FROM index_jobs"))) {
+                        clearError = QStringLiteral("Failed to delete index_jobs: %1").arg(clearQuery.lastError().text());
+                        CP_WARN << "RagIndexerNode:" << clearError;
+                        clearSuccess = false;
+                    }
+                }
                 
                 if (!clearSuccess) {
                     if (!db.rollback()) {
@@ -524,7 +1008,68 @@ QFuture<DataPacket> RagIndexerNode::Execute(const DataPacket& inputs)
                         QSqlDatabase::removeDatabase(connectionName);
                         return fail(msg);
                     }
+                    RagQueryCache::bumpGeneration(dbPath);
+                    // Fragment ids restart from 1, so existing sidecars would point at the wrong rows
+                    RagUtils::removeAnnIndex(dbPath);
+                    RagUtils::removeVectorFile(dbPath);
+                }
+            }
+        }
+
+        // Stored vectors are unit length from kRagNormalizedEmbeddingsVersion; older databases are rescaled once
+        try {
+            RagUtils::normalizeStoredEmbeddings(dbPath);
+        } catch (const std::exception& ex) {
+            const QString msg = QString::fromUtf8(ex.what());
+            CP_WARN << "RagIndexerNode:" << msg;
+            db.close();
+            db = QSqlDatabase();
+            QSqlDatabase::removeDatabase(connectionName);
+            return fail(msg);
+        }
+
+        // An empty index, new or just cleared, is filled in bulk-load mode: secondary indexes and the
+        // full-text triggers are dropped and built once after the load, and commits skip the fsync.
+        // A run that dies part way leaves them missing until the next run recreates them on open.
+        // Ingest mode keeps them, so the index can be queried while it grows.
+        bool bulkLoad = false;
+        if (!ingest) {
+            QSqlQuery emptyQuery(db);
+            bulkLoad = emptyQuery.exec(QStringLiteral("SELECT 1 FROM source_files LIMIT 1")) && !emptyQuery.next();
+        }
+        output.insert(QStringLiteral("bulk_load"), bulkLoad);
+
+        // Keyword search reads fragments_fts; its triggers keep it current from here on
+        if (m_buildTextIndex && !bulkLoad) {
+            try {
+                if (RagUtils::ensureFullTextIndex(dbPath)) {
+                    emit statusChanged(QStringLiteral("Status: built full-text index"));
                 }
+            } catch (const std::exception& ex) {
+                CP_WARN << "RagIndexerNode: full-text index unavailable:" << ex.what();
+                output.insert(QStringLiteral("text_index_error"), QString::fromUtf8(ex.what()));
+            }
+        } else {
+            RagUtils::removeFullTextIndex(dbPath);
+        }
+
+        // One encoding per index: vectors in different formats cannot be ranked together
+        const RagEmbeddingFormat embeddingFormat = RagUtils::embeddingFormatFromName(m_embeddingFormat);
+        const bool keepFullPrecision = m_keepFullPrecision && embeddingFormat != RagEmbeddingFormat::Float32;
+        {
+            QSqlQuery formatQuery(db);
+            formatQuery.prepare(QStringLiteral(
+                "SELECT embedding_format FROM source_files WHERE embedding_format <> ? LIMIT 1"));
+            formatQuery.addBindValue(RagUtils::embeddingFormatName(embeddingFormat));
+            if (formatQuery.exec() && formatQuery.next()) {
+                const QString msg = QStringLiteral("RAG database stores %1 embeddings; clear the existing index to "
+                                                   "re-index it as %2.")
+                                        .arg(formatQuery.value(0).toString(), RagUtils::embeddingFormatName(embeddingFormat));
+                CP_WARN << "RagIndexerNode:" << msg;
+                db.close();
+                db = QSqlDatabase();
+                QSqlDatabase::removeDatabase(connectionName);
+                return fail(msg);
             }
         }
 
@@ -540,15 +1085,28 @@ QFuture<DataPacket> RagIndexerNode::Execute(const DataPacket& inputs)
             }
         }
         
-        // Scan directory for files (with optional name filters)
-        QStringList files = DocumentLoader::scanDirectory(dirPath, nameFilters);
-        if (verbose) {
-            CP_LOG << "RagIndexerNode: Found" << files.size() << "files in" << dirPath
-                     << (nameFilters.isEmpty() ? "(no filter)" : QStringLiteral("(filter: %1)").arg(nameFilters.join(", ")));
+        // Walk the directory on several threads, honouring .gitignore/.ragignore. Files are
+        // indexed as the walk hands them out, so the first ones are embedded while it goes on.
+        // Ingested paths only go through the file filter; inline text always passes.
+        std::optional<DirectoryScanner> scanner;
+        QStringList discovered;
+        if (ingest) {
+            for (const QString& path : std::as_const(ingestPaths)) {
+                if (nameFilters.isEmpty() || ingestTexts.contains(path)
+                    || QDir::match(nameFilters, QFileInfo(path).fileName())) {
+                    discovered.append(path);
+                }
+            }
+        } else {
+            scanner.emplace(dirPath, nameFilters);
+            scanner->start();
+            while (discovered.isEmpty() && !cancellation.isCancelled() && scanner->takeFiles(discovered, 100)) {
+            }
         }
 
-        if (files.isEmpty()) {
-            const QString msg = QStringLiteral("No files found in directory: %1").arg(dirPath);
+        if (discovered.isEmpty() && !cancellation.isCancelled()) {
+            const QString msg = ingest ? QStringLiteral("No documents to index in the incoming token.")
+                                       : QStringLiteral("No files found in directory: %1").arg(dirPath);
             CP_WARN << "RagIndexerNode:" << msg;
             db.close();
             db = QSqlDatabase();
@@ -559,13 +1117,83 @@ QFuture<DataPacket> RagIndexerNode::Execute(const DataPacket& inputs)
             return output;
         }
 
+        // Only files whose modification time or size moved since the last run
+        // are read again; the writer then compares content hashes, so a file
+        // that was merely touched is not re-chunked or re-embedded.
+        const QString chunking = QStringLiteral("%1;%2;%3").arg(m_chunkingStrategy).arg(m_chunkSize).arg(m_chunkOverlap);
+        QHash<QString, IndexedFile> indexedFiles = loadIndexedFiles(db, ingest ? discovered : QStringList());
+        QVector<FileToIndex> filesToIndex;
+        QVector<qint64> unchangedMetadataIds;
+        int scannedFiles = 0;
+        int unchangedFiles = 0;
+        auto classifyFiles = [&](const QStringList& paths) {
+            scannedFiles += paths.size();
+            for (const QString& filePath : paths) {
+                FileToIndex file;
+                file.filePath = filePath;
+                if (const auto text = ingestTexts.constFind(filePath); text != ingestTexts.constEnd()) {
+                    // No stat to compare, so only the content hash can tell it is unchanged
+                    file.text = *text;
+                    file.lastModified = QDateTime::currentMSecsSinceEpoch();
+                    file.size = file.text.toUtf8().size();
+                } else {
+                    const QFileInfo info(filePath);
+                    file.lastModified = info.lastModified().toMSecsSinceEpoch();
+                    file.size = info.size();
+                }
+                if (const auto it = indexedFiles.constFind(filePath); it != indexedFiles.constEnd()) {
+                    file.known = *it;
+                    indexedFiles.erase(it);
+                    const IndexedFile& known = file.known;
+                    const bool sameSettings = !known.contentHash.isEmpty() && known.chunking == chunking
+                                              && known.provider == m_providerId && known.model == m_modelId
+                                              && known.dimensions == m_embeddingDimensions;
+                    if (!sameSettings) {
+                        // Re-chunked and re-embedded whatever the hash says
+                        file.known.contentHash.clear();
+                    } else if (file.text.isNull() && known.lastModified == file.lastModified
+                               && known.size == file.size) {
+                        ++unchangedFiles;
+                        if (known.metadata != metadata) {
+                            unchangedMetadataIds.append(known.id);
+                        }
+                        continue;
+                    }
+                }
+                filesToIndex.append(file);
+            }
+        };
+        classifyFiles(discovered);
+
         int totalChunks = 0;
         int embeddingFailures = 0;
+        qint64 embeddingCacheHits = 0;
+        qint64 embeddingCacheMisses = 0;
         int skippedFiles = 0;
         int databaseInsertFailures = 0;
+        int duplicateChunks = 0;
+        int addedFiles = 0;
+        int updatedFiles = 0;
+        int removedFiles = 0;
+        int checkpoints = 0;
 
         // Scope for database operations to ensure all QSqlQuery objects are destroyed before removeDatabase
         {
+            if (bulkLoad) {
+                RagUtils::removeFullTextIndex(dbPath);
+                dropSecondaryIndexes(db);
+                QSqlQuery pragmaQuery(db);
+                for (const QString& pragma : {QStringLiteral("PRAGMA synchronous = OFF"),
+                                              QStringLiteral("PRAGMA cache_size = -65536")}) {
+                    if (!pragmaQuery.exec(pragma)) {
+                        CP_WARN << "RagIndexerNode: Failed to set" << pragma << "for the bulk load:"
+                                << pragmaQuery.lastError().text();
+                    }
+                }
+            }
+
+            recordJob(QStringLiteral("running"), static_cast<int>(filesToIndex.size()), 0);
+
             // Start transaction for bulk insert
             if (!db.transaction()) {
                 const QString msg = QStringLiteral("Failed to start RAG index transaction: %1")
@@ -577,27 +1205,363 @@ QFuture<DataPacket> RagIndexerNode::Execute(const DataPacket& inputs)
                 return fail(msg);
             }
             
-            // Prepare queries for the new two-table schema
+            // Prepare queries for the new two-table schema. A file's content hash
+            // is written only once all its chunks are stored, so a file with
+            // failed chunks is retried by the next run.
             QSqlQuery fileQuery(db);
             fileQuery.prepare(QStringLiteral(
-                "INSERT OR REPLACE INTO source_files (file_path, provider, model, last_modified, metadata) "
-                "VALUES (:file_path, :provider, :model, :last_modified, :metadata)"));
-            
-            QSqlQuery fileIdQuery(db);
-            fileIdQuery.prepare(QStringLiteral(
-                "SELECT id FROM source_files WHERE file_path = :file_path"));
-            
+                "INSERT INTO source_files (file_path, provider, model, last_modified, metadata, embedding_format, "
+                "file_size, chunking, embedding_dimensions) "
+                "VALUES (:file_path, :provider, :model, :last_modified, :metadata, :embedding_format, "
+                ":file_size, :chunking, :embedding_dimensions)"));
+
+            QSqlQuery fileUpdateQuery(db);
+            fileUpdateQuery.prepare(QStringLiteral(
+                "UPDATE source_files SET provider = :provider, model = :model, last_modified = :last_modified, "
+                "metadata = :metadata, embedding_format = :embedding_format, file_size = :file_size, "
+                "content_hash = NULL, chunking = :chunking, embedding_dimensions = :embedding_dimensions WHERE id = :id"));
+
+            QSqlQuery touchQuery(db);
+            touchQuery.prepare(QStringLiteral(
+                "UPDATE source_files SET last_modified = :last_modified, file_size = :file_size, metadata = :metadata "
+                "WHERE id = :id"));
+
+            QSqlQuery metadataQuery(db);
+            metadataQuery.prepare(QStringLiteral("UPDATE source_files SET metadata = :metadata WHERE id = :id"));
+
+            QSqlQuery hashQuery(db);
+            hashQuery.prepare(QStringLiteral("UPDATE source_files SET content_hash = :content_hash WHERE id = :id"));
+
+            // Fragments are released explicitly rather than through ON DELETE CASCADE, which
+            // needs the foreign_keys pragma and would drop fragments other files share
+            QSqlQuery removeFileQuery(db);
+            removeFileQuery.prepare(QStringLiteral("DELETE FROM source_files WHERE id = :id"));
+
+            auto removeFile = [&](qint64 fileId, const QString& filePath) {
+                QString releaseError;
+                removeFileQuery.bindValue(QStringLiteral(":id"), fileId);
+                if (!releaseFileFragments(db, fileId, releaseError) || !removeFileQuery.exec()) {
+                    CP_WARN << "RagIndexerNode: Failed to remove" << filePath << "from the index:"
+                            << releaseError << removeFileQuery.lastError().text();
+                    ++databaseInsertFailures;
+                    return;
+                }
+                ++removedFiles;
+            };
+
+            // Once the walk is over, rows left over were indexed from this directory but are no
+            // longer scanned. Other directories indexed into the same database are left alone,
+            // and an ingested token removes nothing it was not given.
+            bool scanFinished = false;
+            auto finishScan = [&]() {
+                scanFinished = true;
+                const QString rootPrefix = rootDirectory + QLatin1Char('/');
+                int removedFromScan = 0;
+                for (auto it = indexedFiles.constBegin(); it != indexedFiles.constEnd() && !ingest; ++it) {
+                    if (it.key().startsWith(rootPrefix)) {
+                        removeFile(it->id, it.key());
+                        ++removedFromScan;
+                    }
+                }
+                for (const qint64 fileId : std::as_const(unchangedMetadataIds)) {
+                    metadataQuery.bindValue(QStringLiteral(":metadata"), metadata);
+                    metadataQuery.bindValue(QStringLiteral(":id"), fileId);
+                    if (!metadataQuery.exec()) {
+                        CP_WARN << "RagIndexerNode: Failed to update metadata of source file" << fileId << ":"
+                                << metadataQuery.lastError().text();
+                        ++databaseInsertFailures;
+                    }
+                }
+                if (verbose) {
+                    CP_LOG << "RagIndexerNode: Found" << scannedFiles << "files in" << dirPath
+                           << (nameFilters.isEmpty() ? "(no filter)"
+                                                     : QStringLiteral("(filter: %1)").arg(nameFilters.join(", ")))
+                           << "-" << filesToIndex.size() << "to check," << unchangedFiles << "unchanged,"
+                           << removedFromScan << "removed";
+                }
+            };
+            if (ingest) {
+                finishScan();
+            }
+
             QSqlQuery fragmentQuery(db);
             fragmentQuery.prepare(QStringLiteral(
-                "INSERT INTO fragments (file_id, chunk_index, start_line, end_line, content, embedding) "
-                "VALUES (:file_id, :chunk_index, :start_line, :end_line, :content, :embedding)"));
+                "INSERT INTO fragments (file_id, chunk_index, start_line, end_line, content, embedding, embedding_full, "
+                "content_hash, simhash) VALUES (:file_id, :chunk_index, :start_line, :end_line, :content, :embedding, "
+                ":embedding_full, :content_hash, :simhash)"));
+
+            // Multi-row statements by row count; a batch that fails as a whole is retried row by row
+            std::map<int, QSqlQuery> fragmentBatchQueries;
+            struct FragmentRow {
+                int chunkIndex {0};
+                qint64 ordinal {0};
+                QString content;
+                QByteArray embedding;
+                QVariant embeddingFull;
+                QVariant contentHash;
+                QVariant simHash;
+            };
+            std::vector<FragmentRow> fragmentRows;
+            fragmentRows.reserve(kEmbeddingBatchChunks);
+
+            const int embeddingConcurrency = qBound(1, m_embeddingConcurrency, kMaxEmbeddingConcurrency);
+            const int chunkSize = m_chunkSize;
+            const int chunkOverlap = m_chunkOverlap;
+            const QString chunkingStrategy = m_chunkingStrategy;
+            const QString modelId = m_modelId;
+            const QString providerId = m_providerId;
+            const int dimensions = m_embeddingDimensions;
+            const bool deduplicate = m_deduplication != QLatin1String(kDeduplicationOff);
+            const bool nearDuplicates = m_deduplication == QLatin1String(kDeduplicationNear);
+            const std::shared_ptr<EmbeddingCache> cache = EmbeddingCache::shared();
+            const auto cacheCounters = std::make_shared<EmbeddingCache::Counters>();
+
+            // Staged pipeline: read/chunk workers run ahead of the writer in a
+            // bounded queue of files, up to embeddingConcurrency embedding
+            // batches are in flight, and this thread, which owns the SQLite
+            // connection, inserts results in file order inside the one
+            // transaction. Workers capture only values, so the local pools
+            // can wait for them on every exit path.
+            QThreadPool preparePool;
+            preparePool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+            QThreadPool embeddingPool;
+            embeddingPool.setMaxThreadCount(embeddingConcurrency);
+
+            // Files are chunked side by side; a very large one is also split into regions on the same pool
+            auto prepare = [chunkSize, chunkOverlap, chunkingStrategy, deduplicate, nearDuplicates,
+                            pool = &preparePool](const QString& filePath, const QString& knownHash,
+                                                 const QString& inlineText) {
+                const FileType fileType = fileTypeForChunkingStrategy(chunkingStrategy, filePath);
+                PreparedFile prepared;
+                if (inlineText.isNull() && QFileInfo(filePath).size() > kStreamedFileBytes) {
+                    prepared = prepareStreamedFile(filePath, knownHash, chunkSize, chunkOverlap, fileType);
+                } else {
+                    prepared.filePath = filePath;
+                    const QString content = inlineText.isNull() ? DocumentLoader::readTextFile(filePath) : inlineText;
+                    if (content.isEmpty()) {
+                        return prepared;
+                    }
+                    prepared.empty = false;
+                    prepared.contentHash = contentHash(content);
+                    if (prepared.contentHash == knownHash) {
+                        prepared.unchanged = true;
+                        return prepared;
+                    }
+                    prepared.spans = ParallelChunker::splitSpans(content, chunkSize, chunkOverlap, fileType, pool);
+                    prepared.content = content;
+                }
+                if (deduplicate) {
+                    fingerprintChunks(prepared, nearDuplicates);
+                }
+                return prepared;
+            };
+            auto embed = [backend, apiKey, providerId, modelId, dimensions, cache, cacheCounters,
+                          cancellation, tracingContext](const QStringList& batch) {
+                const CancellationToken::Scope workerScope(cancellation);
+                const Tracer::Scope tracingScope(tracingContext);
+                if (cancellation.isCancelled()) {
+                    EmbeddingBatchResult skipped;
+                    skipped.hasError = true;
+                    skipped.errorMsg = QStringLiteral("Request cancelled");
+                    return skipped;
+                }
+                QElapsedTimer elapsed;
+                elapsed.start();
+                EmbeddingBatchResult embedded = cache
+                    ? cache->embed(*backend, providerId, apiKey, modelId, batch, dimensions, cacheCounters.get())
+                    : dimensions > 0 ? backend->getEmbeddingsAtDimension(apiKey, modelId, batch, dimensions)
+                                     : backend->getEmbeddings(apiKey, modelId, batch);
+                LLMProviderRegistry::recordEmbeddings(providerId, batch.size(), elapsed.nsecsElapsed() / 1e9,
+                                                      embedded.hasError);
+                return embedded;
+            };
+
+            // Chunks already stored, or queued earlier in this run, are referenced rather than embedded
+            // again. Stored exact matches are looked up through idx_fragments_content_hash; stored
+            // fingerprints for near matching are loaded once. An empty index has neither.
+            DuplicateIndex duplicateIndex;
+            // Fragment id of each chunk queued for embedding this run, 0 until written
+            qint64 queuedChunks = 0;
+            std::vector<qint64> writtenFragmentIds;
+            QSqlQuery storedDuplicateQuery(db);
+            storedDuplicateQuery.prepare(QStringLiteral(
+                "SELECT id FROM fragments WHERE content_hash = ? AND content = ? AND file_id <> ? LIMIT 1"));
+            if (nearDuplicates && !bulkLoad) {
+                QSqlQuery simHashQuery(db);
+                simHashQuery.setForwardOnly(true);
+                if (simHashQuery.exec(QStringLiteral("SELECT id, file_id, simhash FROM fragments WHERE simhash IS NOT NULL"))) {
+                    while (simHashQuery.next()) {
+                        duplicateIndex.addNear(static_cast<quint64>(simHashQuery.value(2).toLongLong()),
+                                               simHashQuery.value(0).toLongLong(), simHashQuery.value(1).toLongLong());
+                    }
+                } else {
+                    CP_WARN << "RagIndexerNode: Failed to load fragment fingerprints:" << simHashQuery.lastError().text();
+                }
+            }
+            QSqlQuery sourceQuery(db);
+            auto prepareSourceQuery = [&sourceQuery](bool exact) {
+                sourceQuery.prepare(exact
+                    ? QStringLiteral("INSERT INTO fragment_sources (fragment_id, file_id, chunk_index, start_line, end_line) "
+                                     "SELECT id, ?, ?, ?, ? FROM fragments WHERE id = ? AND content = ?")
+                    : QStringLiteral("INSERT INTO fragment_sources (fragment_id, file_id, chunk_index, start_line, end_line) "
+                                     "SELECT id, ?, ?, ?, ? FROM fragments WHERE id = ?"));
+            };
+
+            std::deque<PendingFile> pending;
+            int nextFile = 0;
+            int queuedBatches = 0;
+            const int prepareQueueDepth = qMax(2, preparePool.maxThreadCount() * 2);
+            const int maxQueuedBatches = embeddingConcurrency * 2;
+            bool cancelled = false;
+            QString checkpointError;
+
+            // Work up to the last checkpoint survives a stop or crash
+            const int checkpointFiles = m_checkpointFiles;
+            const qint64 checkpointIntervalMs = static_cast<qint64>(m_checkpointSeconds) * 1000;
+            int filesDone = 0;
+            int filesSinceCheckpoint = 0;
+            QElapsedTimer checkpointTimer;
+            checkpointTimer.start();
+            struct CommittedCounts {
+                int files {0};
+                int chunks {0};
+                int added {0};
+                int updated {0};
+                int removed {0};
+                int duplicates {0};
+            } committed;
+
+            // Grows with the walk; final once scanFinished is set
+            int totalFiles = static_cast<int>(filesToIndex.size());
+
+            while (!pending.empty() || nextFile < totalFiles || !scanFinished) {
+                if (cancellation.isCancelled()) {
+                    cancelled = true;
+                    break;
+                }
 
-            const int totalFiles = files.size();
+                // Take what the walk has found; wait for it only when there is nothing else to do
+                if (!scanFinished) {
+                    const bool idle = pending.empty() && nextFile >= totalFiles;
+                    QStringList found;
+                    const bool scanning = scanner->takeFiles(found, idle ? 100 : 0);
+                    classifyFiles(found);
+                    totalFiles = static_cast<int>(filesToIndex.size());
+                    if (!scanning) {
+                        finishScan();
+                    }
+                    if (pending.empty() && nextFile >= totalFiles) {
+                        continue;
+                    }
+                }
+
+                const bool checkpointDue = filesSinceCheckpoint > 0
+                    && ((checkpointFiles > 0 && filesSinceCheckpoint >= checkpointFiles)
+                        || (checkpointIntervalMs > 0 && checkpointTimer.elapsed() >= checkpointIntervalMs));
+                if (checkpointDue) {
+                    recordJob(QStringLiteral("running"), totalFiles, filesDone);
+                    if (!db.commit() || !db.transaction()) {
+                        checkpointError = QStringLiteral("Failed to commit RAG index checkpoint: %1")
+                                              .arg(db.lastError().text());
+                        CP_WARN << "RagIndexerNode:" << checkpointError;
+                        break;
+                    }
+                    RagQueryCache::bumpGeneration(dbPath);
+                    committed = {filesDone, totalChunks, addedFiles, updatedFiles, removedFiles, duplicateChunks};
+                    ++checkpoints;
+                    filesSinceCheckpoint = 0;
+                    checkpointTimer.restart();
+                    if (verbose) {
+                        CP_LOG << "RagIndexerNode: Checkpoint after" << filesDone << "of" << totalFiles << "files";
+                    }
+                }
+
+                // Stage 1: keep the read/chunk queue topped up
+                while (static_cast<int>(pending.size()) < prepareQueueDepth && nextFile < totalFiles) {
+                    PendingFile next;
+                    next.fileIndex = nextFile + 1;
+                    next.file = filesToIndex.at(nextFile);
+                    next.prepared = QtConcurrent::run(&preparePool, prepare, next.file.filePath,
+                                                      next.file.known.contentHash, next.file.text);
+                    pending.push_back(std::move(next));
+                    ++nextFile;
+                }
+
+                // Stage 2: queue embedding batches in file order. The front file
+                // is always started so the writer never waits on an empty stage;
+                // later files only while they are chunked and the budget allows.
+                for (std::size_t p = 0; p < pending.size(); ++p) {
+                    PendingFile& file = pending[p];
+                    if (file.started) {
+                        continue;
+                    }
+                    if (p > 0 && (!file.prepared.isFinished() || queuedBatches >= maxQueuedBatches)) {
+                        break;
+                    }
+                    const PreparedFile& prepared = file.prepared.result();
+                    file.firstOrdinal = queuedChunks;
+                    std::vector<int> toEmbed;
+                    toEmbed.reserve(static_cast<std::size_t>(prepared.spans.size()));
+                    for (int i = 0; i < static_cast<int>(prepared.spans.size()); ++i) {
+                        if (!deduplicate) {
+                            toEmbed.push_back(i);
+                            continue;
+                        }
+                        // A changed file's own old fragments are about to go, so they never count
+                        const qint64 ownId = file.file.known.id;
+                        const qint64 hash = prepared.chunkHashes.at(i);
+                        const quint64 simHash = nearDuplicates ? prepared.chunkSimHashes.at(i) : 0;
+                        DuplicateChunk duplicate {i, duplicateIndex.findExact(hash, ownId), true};
+                        if (duplicate.handle == 0 && !bulkLoad) {
+                            storedDuplicateQuery.bindValue(0, hash);
+                            storedDuplicateQuery.bindValue(1, chunkText(prepared, i).toString());
+                            storedDuplicateQuery.bindValue(2, ownId);
+                            if (storedDuplicateQuery.exec() && storedDuplicateQuery.next()) {
+                                duplicate.handle = storedDuplicateQuery.value(0).toLongLong();
+                            }
+                            storedDuplicateQuery.finish();
+                        }
+                        if (duplicate.handle == 0 && nearDuplicates) {
+                            duplicate.handle = duplicateIndex.findNear(simHash, ownId);
+                            duplicate.exact = false;
+                        }
+                        if (duplicate.handle != 0) {
+                            file.duplicates.push_back(duplicate);
+                            continue;
+                        }
+                        // Entries of this run carry no file id, so a file's repeated chunks match too
+                        const qint64 handle = -1 - queuedChunks++;
+                        duplicateIndex.addExact(hash, handle, 0);
+                        duplicateIndex.addNear(simHash, handle, 0);
+                        toEmbed.push_back(i);
+                    }
+                    for (std::size_t batchStart = 0; batchStart < toEmbed.size(); batchStart += kEmbeddingBatchChunks) {
+                        const std::size_t batchEnd = qMin(batchStart + kEmbeddingBatchChunks, toEmbed.size());
+                        QStringList batch;
+                        batch.reserve(static_cast<qsizetype>(batchEnd - batchStart));
+                        for (std::size_t k = batchStart; k < batchEnd; ++k) {
+                            batch.append(chunkText(prepared, toEmbed[k]).toString());
+                        }
+                        file.batches.push_back(QtConcurrent::run(&embeddingPool, embed, batch));
+                        file.batchTexts.push_back(std::move(batch));
+                        file.batchChunks.emplace_back(toEmbed.begin() + static_cast<std::ptrdiff_t>(batchStart),
+                                                      toEmbed.begin() + static_cast<std::ptrdiff_t>(batchEnd));
+                        ++queuedBatches;
+                    }
+                    file.started = true;
+                }
+
+                // Stage 3: write the front file while later batches are in flight
+                PendingFile file = std::move(pending.front());
+                pending.pop_front();
+                // Files are written whole, so everything popped before a checkpoint is in it
+                ++filesDone;
+                ++filesSinceCheckpoint;
+                const PreparedFile prepared = file.prepared.result();
+                const QString& filePath = prepared.filePath;
+                const int fileIndex = file.fileIndex;
+                queuedBatches -= static_cast<int>(file.batches.size());
 
-            // Process each file
-            int fileIndex = 0;
-            for (const QString& filePath : files) {
-                ++fileIndex;
                 emit statusChanged(QStringLiteral("Status: indexing file %1 of %2: %3")
                                        .arg(fileIndex)
                                        .arg(totalFiles)
@@ -606,55 +1570,96 @@ QFuture<DataPacket> RagIndexerNode::Execute(const DataPacket& inputs)
                     CP_LOG << "RagIndexerNode: Processing file" << filePath;
                 }
 
-                // Read file content
-                QString content = DocumentLoader::readTextFile(filePath);
-                if (content.isEmpty()) {
+                const IndexedFile& known = file.file.known;
+                if (prepared.empty) {
                     ++skippedFiles;
+                    if (known.id > 0) {
+                        removeFile(known.id, filePath);
+                    }
                     if (verbose) {
                         CP_LOG << "RagIndexerNode: Skipping empty file:" << filePath;
                     }
                     continue;
                 }
 
-                // Step 1: Register the source file with provider and model metadata
-                fileQuery.bindValue(QStringLiteral(":file_path"), filePath);
-                fileQuery.bindValue(QStringLiteral(":provider"), m_providerId);
-                fileQuery.bindValue(QStringLiteral(":model"), m_modelId);
-                fileQuery.bindValue(QStringLiteral(":last_modified"), QDateTime::currentSecsSinceEpoch());
-                fileQuery.bindValue(QStringLiteral(":metadata"), metadata);
-                
-                if (!fileQuery.exec()) {
-                    CP_WARN << "RagIndexerNode: Failed to insert source file" << filePath 
-                               << ":" << fileQuery.lastError().text();
-                    ++databaseInsertFailures;
+                if (prepared.unchanged) {
+                    // Touched but not edited: keep the fragments, remember the new stat
+                    ++unchangedFiles;
+                    touchQuery.bindValue(QStringLiteral(":last_modified"), file.file.lastModified);
+                    touchQuery.bindValue(QStringLiteral(":file_size"), file.file.size);
+                    touchQuery.bindValue(QStringLiteral(":metadata"), metadata);
+                    touchQuery.bindValue(QStringLiteral(":id"), known.id);
+                    if (!touchQuery.exec()) {
+                        CP_WARN << "RagIndexerNode: Failed to update source file" << filePath
+                                << ":" << touchQuery.lastError().text();
+                        ++databaseInsertFailures;
+                    }
                     continue;
                 }
 
-                // Step 2: Retrieve the file_id
-                fileIdQuery.bindValue(QStringLiteral(":file_path"), filePath);
-                if (!fileIdQuery.exec() || !fileIdQuery.next()) {
-                    CP_WARN << "RagIndexerNode: Failed to retrieve file_id for" << filePath 
-                               << ":" << fileIdQuery.lastError().text();
+                // Step 1: Register the source file with provider and model metadata,
+                // replacing the fragments of a changed file while keeping its id
+                QSqlQuery& registerQuery = known.id > 0 ? fileUpdateQuery : fileQuery;
+                if (known.id > 0) {
+                    registerQuery.bindValue(QStringLiteral(":id"), known.id);
+                } else {
+                    registerQuery.bindValue(QStringLiteral(":file_path"), filePath);
+                }
+                registerQuery.bindValue(QStringLiteral(":provider"), m_providerId);
+                registerQuery.bindValue(QStringLiteral(":model"), m_modelId);
+                registerQuery.bindValue(QStringLiteral(":last_modified"), file.file.lastModified);
+                registerQuery.bindValue(QStringLiteral(":metadata"), metadata);
+                registerQuery.bindValue(QStringLiteral(":embedding_format"), RagUtils::embeddingFormatName(embeddingFormat));
+                registerQuery.bindValue(QStringLiteral(":file_size"), file.file.size);
+                registerQuery.bindValue(QStringLiteral(":chunking"), chunking);
+                registerQuery.bindValue(QStringLiteral(":embedding_dimensions"), m_embeddingDimensions);
+
+                if (!registerQuery.exec()) {
+                    CP_WARN << "RagIndexerNode: Failed to register source file" << filePath
+                               << ":" << registerQuery.lastError().text();
                     ++databaseInsertFailures;
                     continue;
                 }
-                qint64 fileId = fileIdQuery.value(0).toLongLong();
 
-                const FileType fileType = fileTypeForChunkingStrategy(m_chunkingStrategy, filePath);
+                // Step 2: Resolve the file_id and drop the fragments it replaces
+                qint64 fileId = known.id;
+                if (fileId > 0) {
+                    QString releaseError;
+                    if (!releaseFileFragments(db, fileId, releaseError)) {
+                        CP_WARN << "RagIndexerNode: Failed to replace fragments of" << filePath
+                                   << ":" << releaseError;
+                        ++databaseInsertFailures;
+                        continue;
+                    }
+                    ++updatedFiles;
+                } else {
+                    fileId = registerQuery.lastInsertId().toLongLong();
+                    ++addedFiles;
+                }
 
-                // Chunk the text
-                QStringList chunks = TextChunker::split(content, m_chunkSize, m_chunkOverlap, fileType);
-                const QVector<ChunkLineRange> lineRanges = calculateChunkLineRanges(content, chunks);
+                const QList<TextChunkSpan>& spans = prepared.spans;
                 if (verbose) {
-                    CP_LOG << "RagIndexerNode: Generated" << chunks.size() << "chunks for" << filePath;
+                    CP_LOG << "RagIndexerNode: Generated" << spans.size() << "chunks for" << filePath;
                 }
 
                 int insertedForFile = 0;
 
-                // Process each chunk
-                const int chunkCountForFile = chunks.size();
-                for (int i = 0; i < chunks.size(); ++i) {
-                    const QString& chunk = chunks[i];
+                // Insert each batch's fragments as its embeddings arrive
+                const int chunkCountForFile = static_cast<int>(spans.size());
+                // A fragment written for a queued chunk, so later duplicates of it can find it
+                auto recordWritten = [&](const FragmentRow& row, qint64 fragmentId) {
+                    if (!deduplicate) {
+                        return;
+                    }
+                    if (writtenFragmentIds.size() <= static_cast<std::size_t>(row.ordinal)) {
+                        writtenFragmentIds.resize(static_cast<std::size_t>(queuedChunks), 0);
+                    }
+                    writtenFragmentIds[static_cast<std::size_t>(row.ordinal)] = fragmentId;
+                };
+                for (std::size_t b = 0; b < file.batches.size(); ++b) {
+                    const std::vector<int>& batchChunks = file.batchChunks[b];
+                    const int batchStart = batchChunks.front();
+                    const QStringList& batch = file.batchTexts[b];
 
                     // Emit throttled progress updates for Stage Output so the
                     // user can see that indexing is still making progress.
@@ -664,12 +1669,12 @@ QFuture<DataPacket> RagIndexerNode::Execute(const DataPacket& inputs)
                             QStringLiteral("Indexing file %1 of %2\nChunk %3 of %4")
                                 .arg(fileIndex)
                                 .arg(totalFiles)
-                                .arg(i + 1)
+                                .arg(batchStart + 1)
                                 .arg(chunkCountForFile));
                         progress.insert(QStringLiteral("file_path"), filePath);
                         progress.insert(QStringLiteral("files_total"), totalFiles);
                         progress.insert(QStringLiteral("file_index"), fileIndex);
-                        progress.insert(QStringLiteral("chunk_index"), i + 1);
+                        progress.insert(QStringLiteral("chunk_index"), batchStart + 1);
                         progress.insert(QStringLiteral("chunks_in_file"), chunkCountForFile);
                         progress.insert(QStringLiteral("chunks_total_completed"), totalChunks);
 
@@ -677,85 +1682,317 @@ QFuture<DataPacket> RagIndexerNode::Execute(const DataPacket& inputs)
                         progressTimer.restart();
                     }
 
-                    // Generate embedding
-                    EmbeddingResult embResult = backend->getEmbedding(apiKey, m_modelId, chunk);
-                    
+                    const EmbeddingBatchResult embResult = file.batches[b].result();
+                    if (cancellation.isCancelled()) {
+                        cancelled = true;
+                        break;
+                    }
+
                     if (embResult.hasError) {
-                        CP_WARN.noquote() << QStringLiteral("RagIndexerNode: embedding failure provider=%1 model=%2 file=%3 chunk=%4 message=%5")
+                        CP_WARN.noquote() << QStringLiteral("RagIndexerNode: embedding failure provider=%1 model=%2 file=%3 chunks=%4-%5 message=%6")
                                                       .arg(m_providerId, m_modelId, filePath)
-                                                      .arg(i)
+                                                      .arg(batchStart)
+                                                      .arg(batchChunks.back())
                                                       .arg(embResult.errorMsg);
-                        ++embeddingFailures;
+                        embeddingFailures += batch.size();
                         continue;
                     }
 
-                    if (embResult.vector.empty()) {
-                        CP_WARN.noquote() << QStringLiteral("RagIndexerNode: empty embedding provider=%1 model=%2 file=%3 chunk=%4")
-                                                      .arg(m_providerId, m_modelId, filePath)
-                                                      .arg(i);
+                    fragmentRows.clear();
+                    for (int j = 0; j < batch.size(); ++j) {
+                        const int i = batchChunks[static_cast<std::size_t>(j)];
+                        const std::vector<float>& vector = embResult.vectors[static_cast<std::size_t>(j)];
+
+                        if (vector.empty()) {
+                            CP_WARN.noquote() << QStringLiteral("RagIndexerNode: empty embedding provider=%1 model=%2 file=%3 chunk=%4")
+                                                          .arg(m_providerId, m_modelId, filePath)
+                                                          .arg(i);
+                            ++embeddingFailures;
+                            continue;
+                        }
+
+                        // Serialize the unit-length embedding vector to BLOB in the index's format
+                        fragmentRows.push_back(FragmentRow{
+                            i, file.firstOrdinal + static_cast<qint64>(b) * kEmbeddingBatchChunks + j, batch[j],
+                            RagUtils::encodeEmbedding(vector, embeddingFormat),
+                            keepFullPrecision ? QVariant(RagUtils::encodeEmbedding(vector)) : QVariant(),
+                            deduplicate ? QVariant(prepared.chunkHashes.at(i)) : QVariant(),
+                            nearDuplicates ? QVariant(static_cast<qint64>(prepared.chunkSimHashes.at(i))) : QVariant()});
+                    }
+
+                    // Step 3: Insert the batch's fragments with their file_id reference
+                    const int rowCount = static_cast<int>(fragmentRows.size());
+                    if (rowCount > 1) {
+                        const auto [it, added] = fragmentBatchQueries.try_emplace(rowCount, db);
+                        QSqlQuery& batchQuery = it->second;
+                        if (added) {
+                            batchQuery.prepare(fragmentInsertSql(rowCount));
+                        }
+                        int position = 0;
+                        for (const FragmentRow& row : fragmentRows) {
+                            const TextChunkSpan& span = spans.at(row.chunkIndex);
+                            batchQuery.bindValue(position++, fileId);
+                            batchQuery.bindValue(position++, row.chunkIndex);
+                            batchQuery.bindValue(position++, span.startLine > 0 ? QVariant(span.startLine) : QVariant());
+                            batchQuery.bindValue(position++, span.endLine > 0 ? QVariant(span.endLine) : QVariant());
+                            batchQuery.bindValue(position++, row.content);
+                            batchQuery.bindValue(position++, row.embedding);
+                            batchQuery.bindValue(position++, row.embeddingFull);
+                            batchQuery.bindValue(position++, row.contentHash);
+                            batchQuery.bindValue(position++, row.simHash);
+                        }
+                        if (batchQuery.exec()) {
+                            // One statement's rows take consecutive ids ending at the last one
+                            const qint64 lastId = batchQuery.lastInsertId().toLongLong();
+                            for (int k = 0; k < rowCount; ++k) {
+                                recordWritten(fragmentRows[static_cast<std::size_t>(k)], lastId - rowCount + 1 + k);
+                            }
+                            totalChunks += rowCount;
+                            insertedForFile += rowCount;
+                            continue;
+                        }
+                        CP_WARN << "RagIndexerNode: Failed to insert chunks" << fragmentRows.front().chunkIndex << "-"
+                                << fragmentRows.back().chunkIndex << "of" << filePath << "together, retrying one by one:"
+                                << batchQuery.lastError().text();
+                    }
+                    for (const FragmentRow& row : fragmentRows) {
+                        fragmentQuery.bindValue(QStringLiteral(":file_id"), fileId);
+                        fragmentQuery.bindValue(QStringLiteral(":chunk_index"), row.chunkIndex);
+                        const TextChunkSpan& span = spans.at(row.chunkIndex);
+                        fragmentQuery.bindValue(QStringLiteral(":start_line"),
+                                                span.startLine > 0 ? QVariant(span.startLine) : QVariant());
+                        fragmentQuery.bindValue(QStringLiteral(":end_line"),
+                                                span.endLine > 0 ? QVariant(span.endLine) : QVariant());
+                        fragmentQuery.bindValue(QStringLiteral(":content"), row.content);
+                        fragmentQuery.bindValue(QStringLiteral(":embedding"), row.embedding);
+                        fragmentQuery.bindValue(QStringLiteral(":embedding_full"), row.embeddingFull);
+                        fragmentQuery.bindValue(QStringLiteral(":content_hash"), row.contentHash);
+                        fragmentQuery.bindValue(QStringLiteral(":simhash"), row.simHash);
+
+                        if (!fragmentQuery.exec()) {
+                            CP_WARN << "RagIndexerNode: Failed to insert chunk" << row.chunkIndex << "of" << filePath
+                                       << ":" << fragmentQuery.lastError().text();
+                            ++databaseInsertFailures;
+                            continue;
+                        }
+                        recordWritten(row, fragmentQuery.lastInsertId().toLongLong());
+
+                        totalChunks++;
+                        ++insertedForFile;
+                    }
+                }
+
+                // Step 4: Point duplicate chunks at the fragment that holds their text
+                std::vector<int> orphanedChunks;
+                for (std::size_t d = 0; d < file.duplicates.size() && !cancelled; ++d) {
+                    const DuplicateChunk& duplicate = file.duplicates[d];
+                    qint64 fragmentId = duplicate.handle;
+                    if (fragmentId < 0) {
+                        const auto ordinal = static_cast<std::size_t>(-1 - fragmentId);
+                        fragmentId = ordinal < writtenFragmentIds.size() ? writtenFragmentIds[ordinal] : 0;
+                    }
+                    if (fragmentId == 0) {
+                        // The chunk it repeats failed to embed, and was counted then
                         ++embeddingFailures;
                         continue;
                     }
-
-                    // Serialize embedding vector to BLOB
-                    QByteArray embeddingBlob(reinterpret_cast<const char*>(embResult.vector.data()), 
-                                            embResult.vector.size() * sizeof(float));
-
-                    // Step 3: Insert fragment with file_id reference
-                    fragmentQuery.bindValue(QStringLiteral(":file_id"), fileId);
-                    fragmentQuery.bindValue(QStringLiteral(":chunk_index"), i);
-                    const ChunkLineRange lineRange = (i < lineRanges.size()) ? lineRanges.at(i) : ChunkLineRange{};
-                    fragmentQuery.bindValue(QStringLiteral(":start_line"),
-                                            lineRange.startLine > 0 ? QVariant(lineRange.startLine) : QVariant());
-                    fragmentQuery.bindValue(QStringLiteral(":end_line"),
-                                            lineRange.endLine > 0 ? QVariant(lineRange.endLine) : QVariant());
-                    fragmentQuery.bindValue(QStringLiteral(":content"), chunk);
-                    fragmentQuery.bindValue(QStringLiteral(":embedding"), embeddingBlob);
-
-                    if (!fragmentQuery.exec()) {
-                        CP_WARN << "RagIndexerNode: Failed to insert chunk" << i << "of" << filePath 
-                                   << ":" << fragmentQuery.lastError().text();
+                    const TextChunkSpan& span = spans.at(duplicate.chunkIndex);
+                    prepareSourceQuery(duplicate.exact);
+                    sourceQuery.addBindValue(fileId);
+                    sourceQuery.addBindValue(duplicate.chunkIndex);
+                    sourceQuery.addBindValue(span.startLine > 0 ? QVariant(span.startLine) : QVariant());
+                    sourceQuery.addBindValue(span.endLine > 0 ? QVariant(span.endLine) : QVariant());
+                    sourceQuery.addBindValue(fragmentId);
+                    if (duplicate.exact) {
+                        sourceQuery.addBindValue(chunkText(prepared, duplicate.chunkIndex).toString());
+                    }
+                    if (!sourceQuery.exec()) {
+                        CP_WARN << "RagIndexerNode: Failed to record chunk" << duplicate.chunkIndex << "of" << filePath
+                                << "as a duplicate of fragment" << fragmentId << ":" << sourceQuery.lastError().text();
                         ++databaseInsertFailures;
                         continue;
                     }
-
-                    totalChunks++;
+                    if (sourceQuery.numRowsAffected() != 1) {
+                        // Its fragment went with a file replaced or removed earlier in this run
+                        orphanedChunks.push_back(duplicate.chunkIndex);
+                        continue;
+                    }
+                    ++duplicateChunks;
                     ++insertedForFile;
                 }
+                if (!orphanedChunks.empty() && !cancelled) {
+                    QStringList batch;
+                    for (const int i : orphanedChunks) {
+                        batch.append(chunkText(prepared, i).toString());
+                    }
+                    const EmbeddingBatchResult embResult = embed(batch);
+                    for (std::size_t k = 0; k < orphanedChunks.size(); ++k) {
+                        const int i = orphanedChunks[k];
+                        if (embResult.hasError || embResult.vectors[k].empty()) {
+                            CP_WARN.noquote() << QStringLiteral("RagIndexerNode: embedding failure provider=%1 model=%2 file=%3 chunk=%4 message=%5")
+                                                          .arg(m_providerId, m_modelId, filePath)
+                                                          .arg(i)
+                                                          .arg(embResult.errorMsg);
+                            ++embeddingFailures;
+                            continue;
+                        }
+                        const TextChunkSpan& span = spans.at(i);
+                        fragmentQuery.bindValue(QStringLiteral(":file_id"), fileId);
+                        fragmentQuery.bindValue(QStringLiteral(":chunk_index"), i);
+                        fragmentQuery.bindValue(QStringLiteral(":start_line"),
+                                                span.startLine > 0 ? QVariant(span.startLine) : QVariant());
+                        fragmentQuery.bindValue(QStringLiteral(":end_line"),
+                                                span.endLine > 0 ? QVariant(span.endLine) : QVariant());
+                        fragmentQuery.bindValue(QStringLiteral(":content"), batch[static_cast<qsizetype>(k)]);
+                        fragmentQuery.bindValue(QStringLiteral(":embedding"),
+                                                RagUtils::encodeEmbedding(embResult.vectors[k], embeddingFormat));
+                        fragmentQuery.bindValue(QStringLiteral(":embedding_full"),
+                                                keepFullPrecision ? QVariant(RagUtils::encodeEmbedding(embResult.vectors[k]))
+                                                                  : QVariant());
+                        fragmentQuery.bindValue(QStringLiteral(":content_hash"), prepared.chunkHashes.at(i));
+                        fragmentQuery.bindValue(QStringLiteral(":simhash"),
+                                                nearDuplicates ? QVariant(static_cast<qint64>(prepared.chunkSimHashes.at(i)))
+                                                               : QVariant());
+                        if (!fragmentQuery.exec()) {
+                            CP_WARN << "RagIndexerNode: Failed to insert chunk" << i << "of" << filePath
+                                       << ":" << fragmentQuery.lastError().text();
+                            ++databaseInsertFailures;
+                            continue;
+                        }
+                        totalChunks++;
+                        ++insertedForFile;
+                    }
+                }
                 
+                if (cancelled) break;
+                if (insertedForFile == chunkCountForFile) {
+                    hashQuery.bindValue(QStringLiteral(":content_hash"), prepared.contentHash);
+                    hashQuery.bindValue(QStringLiteral(":id"), fileId);
+                    if (!hashQuery.exec()) {
+                        CP_WARN << "RagIndexerNode: Failed to record content hash of" << filePath
+                                   << ":" << hashQuery.lastError().text();
+                    }
+                }
                 if (verbose) {
                     CP_LOG << "RagIndexerNode: Inserted" << insertedForFile << "fragments for" << filePath;
                 }
             }
 
-            // Commit transaction
-            if (!db.commit()) {
+            // Outstanding workers see the cancelled token and return early
+            if (scanner) {
+                scanner->stop();
+            }
+            preparePool.waitForDone();
+            embeddingPool.waitForDone();
+            embeddingCacheHits = cacheCounters->hits.load();
+            embeddingCacheMisses = cacheCounters->misses.load();
+
+            // Commit transaction; a cancelled or failed run keeps only its checkpoints
+            auto rollBackToCheckpoint = [&](const QString& state) {
+                db.rollback();
+                totalChunks = committed.chunks;
+                addedFiles = committed.added;
+                updatedFiles = committed.updated;
+                removedFiles = committed.removed;
+                duplicateChunks = committed.duplicates;
+                recordJob(state, totalFiles, committed.files);
+            };
+            if (cancelled) {
+                rollBackToCheckpoint(QStringLiteral("cancelled"));
+                output.insert(QStringLiteral("__error"), QStringLiteral("RAG indexing cancelled."));
+            } else if (!checkpointError.isEmpty()) {
+                rollBackToCheckpoint(QStringLiteral("failed"));
+                output.insert(QStringLiteral("__error"), checkpointError);
+            } else if (!db.commit()) {
                 const QString msg = QStringLiteral("Failed to commit RAG index transaction: %1")
                                         .arg(db.lastError().text());
                 CP_WARN << "RagIndexerNode:" << msg;
-                db.rollback();
+                rollBackToCheckpoint(QStringLiteral("failed"));
                 output.insert(QStringLiteral("__error"), msg);
-                totalChunks = 0;
             } else {
+                recordJob(QStringLiteral("completed"), totalFiles, totalFiles);
                 if (verbose) {
                     CP_LOG << "RagIndexerNode: Successfully indexed" << totalChunks << "chunks from" 
-                             << files.size() << "files";
+                             << scannedFiles << "files";
+                }
+            }
+
+            // Rebuilt on every outcome, as a stopped run keeps the rows of its checkpoints
+            if (bulkLoad) {
+                QSqlQuery pragmaQuery(db);
+                if (!pragmaQuery.exec(QStringLiteral("PRAGMA synchronous = NORMAL"))) {
+                    CP_WARN << "RagIndexerNode: Failed to restore synchronous writes:" << pragmaQuery.lastError().text();
                 }
+                emit statusChanged(QStringLiteral("Status: building RAG indexes..."));
+                createSecondaryIndexes(db);
             }
-        } // All QSqlQuery objects (fileQuery, fileIdQuery, fragmentQuery) go out of scope here
+        } // All QSqlQuery objects go out of scope here
 
         // Close database - now safe since all queries are destroyed
         db.close();
         db = QSqlDatabase();
         QSqlDatabase::removeDatabase(connectionName);
 
+        // Populated in one pass over the loaded fragments rather than by a trigger per insert
+        if (bulkLoad && m_buildTextIndex) {
+            try {
+                if (RagUtils::ensureFullTextIndex(dbPath)) {
+                    emit statusChanged(QStringLiteral("Status: built full-text index"));
+                }
+            } catch (const std::exception& ex) {
+                CP_WARN << "RagIndexerNode: full-text index unavailable:" << ex.what();
+                output.insert(QStringLiteral("text_index_error"), QString::fromUtf8(ex.what()));
+            }
+        }
+
+        // Bring the ANN sidecar up to date; if this fails queries fall back to exact search
+        if (m_buildAnnIndex && !output.contains(QStringLiteral("__error"))) {
+            emit statusChanged(QStringLiteral("Status: updating ANN search index..."));
+            try {
+                const RagUtils::AnnIndexUpdate annUpdate = RagUtils::updateAnnIndex(dbPath);
+                output.insert(QStringLiteral("ann_index_vectors"), annUpdate.total);
+                output.insert(QStringLiteral("ann_index_added"), annUpdate.added);
+                output.insert(QStringLiteral("ann_index_rebuilt"), annUpdate.rebuilt);
+            } catch (const std::exception& ex) {
+                CP_WARN << "RagIndexerNode: ANN index update failed:" << ex.what();
+                output.insert(QStringLiteral("ann_index_error"), QString::fromUtf8(ex.what()));
+            }
+        }
+
+        // Likewise the vector file; without it queries read embeddings from SQLite
+        if (m_buildVectorFile && !output.contains(QStringLiteral("__error"))) {
+            emit statusChanged(QStringLiteral("Status: updating vector file..."));
+            try {
+                const RagUtils::VectorFileUpdate vectorUpdate = RagUtils::updateVectorFile(dbPath);
+                output.insert(QStringLiteral("vector_file_rows"), vectorUpdate.live);
+                output.insert(QStringLiteral("vector_file_added"), vectorUpdate.added);
+                output.insert(QStringLiteral("vector_file_rebuilt"), vectorUpdate.rebuilt);
+            } catch (const std::exception& ex) {
+                CP_WARN << "RagIndexerNode: vector file update failed:" << ex.what();
+                output.insert(QStringLiteral("vector_file_error"), QString::fromUtf8(ex.what()));
+            }
+        }
+
+        // Cached query results for this index predate the run, whatever its outcome
+        RagQueryCache::bumpGeneration(dbPath);
+
         // Set outputs
         output.insert(QString::fromLatin1(kOutputDatabasePath), dbPath);
         output.insert(QString::fromLatin1(kOutputCount), QString::number(totalChunks));
         output.insert(QStringLiteral("embedding_failures"), embeddingFailures);
+        output.insert(QStringLiteral("embedding_cache_hits"), embeddingCacheHits);
+        output.insert(QStringLiteral("embedding_cache_misses"), embeddingCacheMisses);
         output.insert(QStringLiteral("database_insert_failures"), databaseInsertFailures);
+        output.insert(QStringLiteral("duplicate_chunks"), duplicateChunks);
         output.insert(QStringLiteral("skipped_files"), skippedFiles);
+        output.insert(QStringLiteral("files_added"), addedFiles);
+        output.insert(QStringLiteral("files_updated"), updatedFiles);
+        output.insert(QStringLiteral("files_unchanged"), unchangedFiles);
+        output.insert(QStringLiteral("files_removed"), removedFiles);
+        output.insert(QStringLiteral("checkpoints"), checkpoints);
         output.insert(QStringLiteral("chunking_strategy"), m_chunkingStrategy);
+        output.insert(QStringLiteral("embedding_format"), RagUtils::embeddingFormatName(embeddingFormat));
+        output.insert(QStringLiteral("embedding_dimensions"), m_embeddingDimensions);
 
         if (!output.contains(QStringLiteral("__error")) && totalChunks == 0
             && (embeddingFailures > 0 || databaseInsertFailures > 0)) {
@@ -765,9 +2002,12 @@ QFuture<DataPacket> RagIndexerNode::Execute(const DataPacket& inputs)
                               .arg(databaseInsertFailures));
         }
 
-        emit statusChanged(QStringLiteral("Status: indexed %1 chunks from %2 files. Embedding failures: %3; database failures: %4.")
+        emit statusChanged(QStringLiteral("Status: indexed %1 chunks from %2 new or changed files (%3 unchanged, %4 removed). "
+                                          "Embedding failures: %5; database failures: %6.")
                                .arg(totalChunks)
-                               .arg(files.size())
+                               .arg(addedFiles + updatedFiles)
+                               .arg(unchangedFiles)
+                               .arg(removedFiles)
                                .arg(embeddingFailures)
                                .arg(databaseInsertFailures));
 
@@ -775,6 +2015,14 @@ QFuture<DataPacket> RagIndexerNode::Execute(const DataPacket& inputs)
     });
 }
 
+// Connects to the embedding provider, or loads a local embedding model, while the files are read
+void RagIndexerNode::warmUp()
+{
+    if (!m_providerId.isEmpty() && !m_modelId.isEmpty()) {
+        LLMProviderRegistry::instance().warmUpInBackground(m_providerId, m_modelId);
+    }
+}
+
 QJsonObject RagIndexerNode::saveState() const
 {
     QJsonObject state;
@@ -785,9 +2033,21 @@ QJsonObject RagIndexerNode::saveState() const
     state.insert(QStringLiteral("model_id"), m_modelId);
     state.insert(QStringLiteral("chunk_size"), m_chunkSize);
     state.insert(QStringLiteral("chunk_overlap"), m_chunkOverlap);
+    state.insert(QStringLiteral("embedding_concurrency"), m_embeddingConcurrency);
     state.insert(QStringLiteral("file_filter"), m_fileFilter);
     state.insert(QStringLiteral("chunking_strategy"), m_chunkingStrategy);
     state.insert(QStringLiteral("clear_database"), m_clearDatabase);
+    state.insert(QStringLiteral("build_ann_index"), m_buildAnnIndex);
+    state.insert(QStringLiteral("build_vector_file"), m_buildVectorFile);
+    state.insert(QStringLiteral("build_text_index"), m_buildTextIndex);
+    state.insert(QStringLiteral("embedding_format"), m_embeddingFormat);
+    state.insert(QStringLiteral("keep_full_precision"), m_keepFullPrecision);
+    state.insert(QStringLiteral("embedding_dimensions"), m_embeddingDimensions);
+    state.insert(QStringLiteral("checkpoint_files"), m_checkpointFiles);
+    state.insert(QStringLiteral("checkpoint_seconds"), m_checkpointSeconds);
+    state.insert(QStringLiteral("resume_interrupted"), m_resumeInterrupted);
+    state.insert(QStringLiteral("compact_index"), m_compactIndex);
+    state.insert(QStringLiteral("deduplication"), m_deduplication);
     return state;
 }
 
@@ -814,6 +2074,9 @@ void RagIndexerNode::loadState(const QJsonObject& data)
     if (data.contains(QStringLiteral("chunk_overlap"))) {
         m_chunkOverlap = data[QStringLiteral("chunk_overlap")].toInt();
     }
+    if (data.contains(QStringLiteral("embedding_concurrency"))) {
+        m_embeddingConcurrency = qBound(1, data[QStringLiteral("embedding_concurrency")].toInt(), kMaxEmbeddingConcurrency);
+    }
     if (data.contains(QStringLiteral("file_filter"))) {
         m_fileFilter = data[QStringLiteral("file_filter")].toString();
     }
@@ -823,6 +2086,44 @@ void RagIndexerNode::loadState(const QJsonObject& data)
     if (data.contains(QStringLiteral("clear_database"))) {
         m_clearDatabase = data[QStringLiteral("clear_database")].toBool();
     }
+    if (data.contains(QStringLiteral("build_ann_index"))) {
+        m_buildAnnIndex = data[QStringLiteral("build_ann_index")].toBool();
+    }
+    if (data.contains(QStringLiteral("build_vector_file"))) {
+        m_buildVectorFile = data[QStringLiteral("build_vector_file")].toBool();
+    }
+    if (data.contains(QStringLiteral("build_text_index"))) {
+        m_buildTextIndex = data[QStringLiteral("build_text_index")].toBool();
+    }
+    if (data.contains(QStringLiteral("embedding_format"))) {
+        m_embeddingFormat = RagUtils::embeddingFormatName(
+            RagUtils::embeddingFormatFromName(data[QStringLiteral("embedding_format")].toString()));
+    }
+    if (data.contains(QStringLiteral("keep_full_precision"))) {
+        m_keepFullPrecision = data[QStringLiteral("keep_full_precision")].toBool();
+    }
+    if (data.contains(QStringLiteral("embedding_dimensions"))) {
+        m_embeddingDimensions = qMax(0, data[QStringLiteral("embedding_dimensions")].toInt());
+    }
+    if (data.contains(QStringLiteral("checkpoint_files"))) {
+        m_checkpointFiles = qMax(0, data[QStringLiteral("checkpoint_files")].toInt());
+    }
+    if (data.contains(QStringLiteral("checkpoint_seconds"))) {
+        m_checkpointSeconds = qMax(0, data[QStringLiteral("checkpoint_seconds")].toInt());
+    }
+    if (data.contains(QStringLiteral("resume_interrupted"))) {
+        m_resumeInterrupted = data[QStringLiteral("resume_interrupted")].toBool();
+    }
+    if (data.contains(QStringLiteral("compact_index"))) {
+        m_compactIndex = data[QStringLiteral("compact_index")].toBool();
+    }
+    if (data.contains(QStringLiteral("deduplication"))) {
+        const QString mode = data[QStringLiteral("deduplication")].toString();
+        if (mode == QLatin1String(kDeduplicationOff) || mode == QLatin1String(kDeduplicationExact)
+            || mode == QLatin1String(kDeduplicationNear)) {
+            m_deduplication = mode;
+        }
+    }
 }
 
 // Property setters
@@ -882,6 +2183,15 @@ void RagIndexerNode::setChunkOverlap(int overlap)
     }
 }
 
+void RagIndexerNode::setEmbeddingConcurrency(int requests)
+{
+    const int bounded = qBound(1, requests, kMaxEmbeddingConcurrency);
+    if (m_embeddingConcurrency != bounded) {
+        m_embeddingConcurrency = bounded;
+        emit embeddingConcurrencyChanged(bounded);
+    }
+}
+
 void RagIndexerNode::setFileFilter(const QString& filter)
 {
     if (m_fileFilter != filter) {
@@ -905,3 +2215,99 @@ void RagIndexerNode::setClearDatabase(bool clear)
         emit clearDatabaseChanged(clear);
     }
 }
+
+void RagIndexerNode::setBuildAnnIndex(bool build)
+{
+    if (m_buildAnnIndex != build) {
+        m_buildAnnIndex = build;
+        emit buildAnnIndexChanged(build);
+    }
+}
+
+void RagIndexerNode::setBuildVectorFile(bool build)
+{
+    if (m_buildVectorFile != build) {
+        m_buildVectorFile = build;
+        emit buildVectorFileChanged(build);
+    }
+}
+
+void RagIndexerNode::setBuildTextIndex(bool build)
+{
+    if (m_buildTextIndex != build) {
+        m_buildTextIndex = build;
+        emit buildTextIndexChanged(build);
+    }
+}
+
+void RagIndexerNode::setEmbeddingFormat(const QString& format)
+{
+    const QString canonical = RagUtils::embeddingFormatName(RagUtils::embeddingFormatFromName(format));
+    if (m_embeddingFormat != canonical) {
+        m_embeddingFormat = canonical;
+        emit embeddingFormatChanged(canonical);
+    }
+}
+
+void RagIndexerNode::setKeepFullPrecision(bool keep)
+{
+    if (m_keepFullPrecision != keep) {
+        m_keepFullPrecision = keep;
+        emit keepFullPrecisionChanged(keep);
+    }
+}
+
+void RagIndexerNode::setEmbeddingDimensions(int dimensions)
+{
+    const int bounded = qMax(0, dimensions);
+    if (m_embeddingDimensions != bounded) {
+        m_embeddingDimensions = bounded;
+        emit embeddingDimensionsChanged(bounded);
+    }
+}
+
+void RagIndexerNode::setCheckpointFiles(int files)
+{
+    const int bounded = qMax(0, files);
+    if (m_checkpointFiles != bounded) {
+        m_checkpointFiles = bounded;
+        emit checkpointFilesChanged(bounded);
+    }
+}
+
+void RagIndexerNode::setCheckpointSeconds(int seconds)
+{
+    const int bounded = qMax(0, seconds);
+    if (m_checkpointSeconds != bounded) {
+        m_checkpointSeconds = bounded;
+        emit checkpointSecondsChanged(bounded);
+    }
+}
+
+void RagIndexerNode::setResumeInterrupted(bool resume)
+{
+    if (m_resumeInterrupted != resume) {
+        m_resumeInterrupted = resume;
+        emit resumeInterruptedChanged(resume);
+    }
+}
+
+void RagIndexerNode::setCompactIndex(bool compact)
+{
+    if (m_compactIndex != compact) {
+        m_compactIndex = compact;
+        emit compactIndexChanged(compact);
+    }
+}
+
+void RagIndexerNode::setDeduplication(const QString& mode)
+{
+    if (mode != QLatin1String(kDeduplicationOff) && mode != QLatin1String(kDeduplicationExact)
+        && mode != QLatin1String(kDeduplicationNear)) {
+        return;
+    }
+    if (m_deduplication != mode) {
+        m_deduplication = mode;
+        emit deduplicationChanged(mode);
+    }
+}
@@ -24,13 +24,14 @@
 #pragma once
 
 #include <QObject>
-#include <QWidget>
 #include <QFuture>
 #include <QString>
 
 #include "IToolNode.h"
 #include "CommonDataTypes.h"
 
+class QWidget;
+
 /**
  * @brief RagIndexerNode orchestrates the RAG ingestion pipeline.
  * 
@@ -54,13 +55,21 @@ public:
 
     // IToolNode interface (V3 tokens API)
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in RagIndexerPropertiesWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     TokenList execute(const TokenList& incomingTokens) override;
+    ResourceClass resourceClass() const override { return ResourceClass::Network; }
+    void warmUp() override;
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
 
     // Port IDs
     static constexpr const char* kInputDirectoryPath = "directory_path";
+    // Ingest mode: a token on either pin is indexed into the existing index
+    // without a directory walk. file_path takes a path or a list of paths;
+    // text takes document content, named by a single file_path if given.
+    static constexpr const char* kInputFilePath = "file_path";
+    static constexpr const char* kInputText = "text";
     // Legacy packet key: retained so older flows/tests can still override the
     // property path, but no visible database input pin is exposed.
     static constexpr const char* kInputDatabasePath = "database_path";
@@ -70,6 +79,13 @@ public:
     static constexpr const char* kOutputDatabasePath = "database_path";
     static constexpr const char* kOutputCount = "count";
 
+    static constexpr int kMaxEmbeddingConcurrency = 16;
+
+    // Duplicate chunk detection modes
+    static constexpr const char* kDeduplicationOff = "off";
+    static constexpr const char* kDeduplicationExact = "exact";
+    static constexpr const char* kDeduplicationNear = "near";
+
     // Property accessors
     QString directoryPath() const { return m_directoryPath; }
     QString databasePath() const { return m_databasePath; }
@@ -78,9 +94,21 @@ public:
     QString modelId() const { return m_modelId; }
     int chunkSize() const { return m_chunkSize; }
     int chunkOverlap() const { return m_chunkOverlap; }
+    int embeddingConcurrency() const { return m_embeddingConcurrency; }
     QString fileFilter() const { return m_fileFilter; }
     QString chunkingStrategy() const { return m_chunkingStrategy; }
     bool clearDatabase() const { return m_clearDatabase; }
+    bool buildAnnIndex() const { return m_buildAnnIndex; }
+    bool buildVectorFile() const { return m_buildVectorFile; }
+    bool buildTextIndex() const { return m_buildTextIndex; }
+    QString embeddingFormat() const { return m_embeddingFormat; }
+    bool keepFullPrecision() const { return m_keepFullPrecision; }
+    int embeddingDimensions() const { return m_embeddingDimensions; }
+    int checkpointFiles() const { return m_checkpointFiles; }
+    int checkpointSeconds() const { return m_checkpointSeconds; }
+    bool resumeInterrupted() const { return m_resumeInterrupted; }
+    bool compactIndex() const { return m_compactIndex; }
+    QString deduplication() const { return m_deduplication; }
 
 public slots:
     void setDirectoryPath(const QString& path);
@@ -90,9 +118,21 @@ public slots:
     void setModelId(const QString& id);
     void setChunkSize(int size);
     void setChunkOverlap(int overlap);
+    void setEmbeddingConcurrency(int requests);
     void setFileFilter(const QString& filter);
     void setChunkingStrategy(const QString& strategy);
     void setClearDatabase(bool clear);
+    void setBuildAnnIndex(bool build);
+    void setBuildVectorFile(bool build);
+    void setBuildTextIndex(bool build);
+    void setEmbeddingFormat(const QString& format);
+    void setKeepFullPrecision(bool keep);
+    void setEmbeddingDimensions(int dimensions);
+    void setCheckpointFiles(int files);
+    void setCheckpointSeconds(int seconds);
+    void setResumeInterrupted(bool resume);
+    void setCompactIndex(bool compact);
+    void setDeduplication(const QString& mode);
 
 signals:
     void directoryPathChanged(const QString& path);
@@ -102,9 +142,21 @@ signals:
     void modelChanged(const QString& id);
     void chunkSizeChanged(int size);
     void chunkOverlapChanged(int overlap);
+    void embeddingConcurrencyChanged(int requests);
     void fileFilterChanged(const QString& filter);
     void chunkingStrategyChanged(const QString& strategy);
     void clearDatabaseChanged(bool clear);
+    void buildAnnIndexChanged(bool build);
+    void buildVectorFileChanged(bool build);
+    void buildTextIndexChanged(bool build);
+    void embeddingFormatChanged(const QString& format);
+    void keepFullPrecisionChanged(bool keep);
+    void embeddingDimensionsChanged(int dimensions);
+    void checkpointFilesChanged(int files);
+    void checkpointSecondsChanged(int seconds);
+    void resumeInterruptedChanged(bool resume);
+    void compactIndexChanged(bool compact);
+    void deduplicationChanged(const QString& mode);
     void statusChanged(const QString& message);
 
     // Emitted periodically while indexing is running to report progress
@@ -126,7 +178,31 @@ private:
     QString m_modelId { QStringLiteral("text-embedding-3-small") };
     int m_chunkSize { 1000 };
     int m_chunkOverlap { 200 };
+    // Embedding batches allowed in flight at once during a run
+    int m_embeddingConcurrency { 4 };
     QString m_fileFilter;
     QString m_chunkingStrategy { QStringLiteral("Auto") };
     bool m_clearDatabase { false };
+    // Keep the HNSW sidecar (RagUtils::annIndexPath) in step with the database after each run
+    bool m_buildAnnIndex { false };
+    // Likewise the memory-mapped vector file (RagUtils::vectorFilePath) that queries scan in place
+    bool m_buildVectorFile { false };
+    // Keep the fragments_fts BM25 index that RAG Query's hybrid modes search
+    bool m_buildTextIndex { true };
+    // fragments.embedding encoding (RagUtils::embeddingFormatName); fixed for the life of an index
+    QString m_embeddingFormat { QStringLiteral("float32") };
+    // Also store float32 copies of quantised vectors so queries can rescore their top candidates
+    bool m_keepFullPrecision { false };
+    // Size asked of the provider for each embedding (Matryoshka truncation); 0 keeps the model's own
+    int m_embeddingDimensions { 0 };
+    // Commit the run every this many files or seconds (0 disables either trigger)
+    int m_checkpointFiles { 50 };
+    int m_checkpointSeconds { 60 };
+    // Skip clear_database when the last run over the directory did not finish
+    bool m_resumeInterrupted { true };
+    // Run RagUtils::compactIndex on the database and report its statistics instead of indexing
+    bool m_compactIndex { false };
+    // Chunks whose text is already indexed (exactly, or within a few SimHash bits for "near")
+    // are recorded in fragment_sources instead of being embedded and stored again
+    QString m_deduplication { QString::fromLatin1(kDeduplicationExact) };
 };
@@ -22,6 +22,7 @@
 // SOFTWARE.
 //
 #include "RagIndexerPropertiesWidget.h"
+#include "RagIndexerNode.h"
 #include "ai/catalog/ModelCatalogService.h"
 
 #include <QFormLayout>
@@ -184,6 +185,13 @@ RagIndexerPropertiesWidget::RagIndexerPropertiesWidget(QWidget* parent)
     m_chunkOverlapSpinBox->setSuffix(QStringLiteral(" chars"));
     formLayout->addRow(QStringLiteral("Chunk Overlap:"), m_chunkOverlapSpinBox);
 
+    // Embedding concurrency
+    m_embeddingConcurrencySpinBox = new QSpinBox(this);
+    m_embeddingConcurrencySpinBox->setRange(1, RagIndexerNode::kMaxEmbeddingConcurrency);
+    m_embeddingConcurrencySpinBox->setValue(4);
+    m_embeddingConcurrencySpinBox->setToolTip(QStringLiteral("Embedding requests kept in flight while indexing"));
+    formLayout->addRow(QStringLiteral("Parallel Requests:"), m_embeddingConcurrencySpinBox);
+
     // File filter
     m_fileFilterEdit = new QLineEdit(this);
     m_fileFilterEdit->setPlaceholderText(QStringLiteral("*.cpp; *.h"));
@@ -206,6 +214,91 @@ RagIndexerPropertiesWidget::RagIndexerPropertiesWidget(QWidget* parent)
     m_clearDatabaseCheckBox->setChecked(false);  // Default to false
     formLayout->addRow(QStringLiteral(""), m_clearDatabaseCheckBox);
 
+    m_buildAnnIndexCheckBox = new QCheckBox(QStringLiteral("Maintain ANN search index (HNSW)"), this);
+    m_buildAnnIndexCheckBox->setChecked(false);
+    m_buildAnnIndexCheckBox->setToolTip(QStringLiteral("Keeps a .hnsw file next to the database so queries on large indexes "
+                                                       "skip the full scan"));
+    formLayout->addRow(QStringLiteral(""), m_buildAnnIndexCheckBox);
+
+    m_buildVectorFileCheckBox = new QCheckBox(QStringLiteral("Maintain memory-mapped vector file"), this);
+    m_buildVectorFileCheckBox->setChecked(false);
+    m_buildVectorFileCheckBox->setToolTip(QStringLiteral("Keeps a .vec copy of the embeddings next to the database that "
+                                                         "queries scan in place instead of reading them from SQLite"));
+    formLayout->addRow(QStringLiteral(""), m_buildVectorFileCheckBox);
+
+    m_buildTextIndexCheckBox = new QCheckBox(QStringLiteral("Maintain full-text (BM25) index"), this);
+    m_buildTextIndexCheckBox->setChecked(true);
+    m_buildTextIndexCheckBox->setToolTip(QStringLiteral("Keeps an FTS5 keyword index of the fragments for RAG Query's "
+                                                        "hybrid search modes"));
+    formLayout->addRow(QStringLiteral(""), m_buildTextIndexCheckBox);
+
+    // Stored vector encoding
+    m_embeddingFormatCombo = new QComboBox(this);
+    m_embeddingFormatCombo->addItem(QStringLiteral("Float32 (exact)"), QStringLiteral("float32"));
+    m_embeddingFormatCombo->addItem(QStringLiteral("Float16 (half size)"), QStringLiteral("float16"));
+    m_embeddingFormatCombo->addItem(QStringLiteral("Int8 (quarter size)"), QStringLiteral("int8"));
+    m_embeddingFormatCombo->setToolTip(QStringLiteral("Encoding of stored embeddings. Changing it on an existing index "
+                                                      "requires clearing the index first."));
+    formLayout->addRow(QStringLiteral("Embedding Storage:"), m_embeddingFormatCombo);
+
+    m_keepFullPrecisionCheckBox = new QCheckBox(QStringLiteral("Keep float32 copies for rescoring"), this);
+    m_keepFullPrecisionCheckBox->setChecked(false);
+    m_keepFullPrecisionCheckBox->setEnabled(false);
+    m_keepFullPrecisionCheckBox->setToolTip(QStringLiteral("Queries scan the compact vectors, then re-rank the best "
+                                                           "candidates exactly. Saves scan bandwidth, not disk space."));
+    formLayout->addRow(QStringLiteral(""), m_keepFullPrecisionCheckBox);
+
+    m_embeddingDimensionsSpinBox = new QSpinBox(this);
+    m_embeddingDimensionsSpinBox->setRange(0, 8192);
+    m_embeddingDimensionsSpinBox->setSingleStep(64);
+    m_embeddingDimensionsSpinBox->setValue(0);
+    m_embeddingDimensionsSpinBox->setSpecialValueText(QStringLiteral("Model default"));
+    m_embeddingDimensionsSpinBox->setToolTip(QStringLiteral("Asks the model for shorter vectors, e.g. 256 or 512 for "
+                                                            "text-embedding-3 or nomic-embed-text. Only for models "
+                                                            "trained for it; changing it re-embeds every file."));
+    formLayout->addRow(QStringLiteral("Embedding Dimensions:"), m_embeddingDimensionsSpinBox);
+
+    m_deduplicationCombo = new QComboBox(this);
+    m_deduplicationCombo->addItem(QStringLiteral("Index every chunk"), QString::fromLatin1(RagIndexerNode::kDeduplicationOff));
+    m_deduplicationCombo->addItem(QStringLiteral("Reuse exact copies"), QString::fromLatin1(RagIndexerNode::kDeduplicationExact));
+    m_deduplicationCombo->addItem(QStringLiteral("Reuse exact and near copies"),
+                                  QString::fromLatin1(RagIndexerNode::kDeduplicationNear));
+    m_deduplicationCombo->setCurrentIndex(1);
+    m_deduplicationCombo->setToolTip(QStringLiteral("Chunks already in the index are linked to the stored fragment "
+                                                    "instead of being embedded again. Near copies differ only in "
+                                                    "whitespace, case or a few words."));
+    formLayout->addRow(QStringLiteral("Duplicate Chunks:"), m_deduplicationCombo);
+
+    // Checkpoint commits
+    m_checkpointFilesSpinBox = new QSpinBox(this);
+    m_checkpointFilesSpinBox->setRange(0, 100000);
+    m_checkpointFilesSpinBox->setValue(50);
+    m_checkpointFilesSpinBox->setSuffix(QStringLiteral(" files"));
+    m_checkpointFilesSpinBox->setSpecialValueText(QStringLiteral("Never"));
+    m_checkpointFilesSpinBox->setToolTip(QStringLiteral("Commits the run after this many files, so a stop or crash "
+                                                        "keeps the work done so far"));
+    formLayout->addRow(QStringLiteral("Checkpoint Every:"), m_checkpointFilesSpinBox);
+
+    m_checkpointSecondsSpinBox = new QSpinBox(this);
+    m_checkpointSecondsSpinBox->setRange(0, 3600);
+    m_checkpointSecondsSpinBox->setValue(60);
+    m_checkpointSecondsSpinBox->setSuffix(QStringLiteral(" s"));
+    m_checkpointSecondsSpinBox->setSpecialValueText(QStringLiteral("Never"));
+    m_checkpointSecondsSpinBox->setToolTip(QStringLiteral("Also commits once this long has passed since the last checkpoint"));
+    formLayout->addRow(QStringLiteral("Checkpoint After:"), m_checkpointSecondsSpinBox);
+
+    m_resumeInterruptedCheckBox = new QCheckBox(QStringLiteral("Resume an interrupted run instead of clearing"), this);
+    m_resumeInterruptedCheckBox->setChecked(true);
+    m_resumeInterruptedCheckBox->setToolTip(QStringLiteral("When the last run over this directory did not finish, keep "
+                                                           "its checkpointed files even if clearing is ticked"));
+    formLayout->addRow(QStringLiteral(""), m_resumeInterruptedCheckBox);
+
+    m_compactIndexCheckBox = new QCheckBox(QStringLiteral("Compact the index instead of indexing"), this);
+    m_compactIndexCheckBox->setChecked(false);
+    m_compactIndexCheckBox->setToolTip(QStringLiteral("Removes orphaned fragments, vacuums the database, rebuilds the "
+                                                      "search sidecars and reports index statistics; no files are read"));
+    formLayout->addRow(QStringLiteral(""), m_compactIndexCheckBox);
+
     mainLayout->addLayout(formLayout);
     mainLayout->addStretch();
 
@@ -241,12 +334,32 @@ RagIndexerPropertiesWidget::RagIndexerPropertiesWidget(QWidget* parent)
             this, &RagIndexerPropertiesWidget::chunkSizeChanged);
     connect(m_chunkOverlapSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
             this, &RagIndexerPropertiesWidget::chunkOverlapChanged);
+    connect(m_embeddingConcurrencySpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &RagIndexerPropertiesWidget::embeddingConcurrencyChanged);
 
     // Connect new controls
     connect(m_fileFilterEdit, &QLineEdit::textChanged, this, &RagIndexerPropertiesWidget::fileFilterChanged);
     connect(m_chunkingStrategyCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
             this, &RagIndexerPropertiesWidget::onStrategyChanged);
     connect(m_clearDatabaseCheckBox, &QCheckBox::toggled, this, &RagIndexerPropertiesWidget::clearDatabaseChanged);
+    connect(m_buildAnnIndexCheckBox, &QCheckBox::toggled, this, &RagIndexerPropertiesWidget::buildAnnIndexChanged);
+    connect(m_buildVectorFileCheckBox, &QCheckBox::toggled, this, &RagIndexerPropertiesWidget::buildVectorFileChanged);
+    connect(m_buildTextIndexCheckBox, &QCheckBox::toggled, this, &RagIndexerPropertiesWidget::buildTextIndexChanged);
+    connect(m_embeddingFormatCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this]() {
+        m_keepFullPrecisionCheckBox->setEnabled(embeddingFormat() != QStringLiteral("float32"));
+        emit embeddingFormatChanged(embeddingFormat());
+    });
+    connect(m_keepFullPrecisionCheckBox, &QCheckBox::toggled, this, &RagIndexerPropertiesWidget::keepFullPrecisionChanged);
+    connect(m_deduplicationCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+            [this]() { emit deduplicationChanged(deduplication()); });
+    connect(m_embeddingDimensionsSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &RagIndexerPropertiesWidget::embeddingDimensionsChanged);
+    connect(m_checkpointFilesSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &RagIndexerPropertiesWidget::checkpointFilesChanged);
+    connect(m_checkpointSecondsSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &RagIndexerPropertiesWidget::checkpointSecondsChanged);
+    connect(m_resumeInterruptedCheckBox, &QCheckBox::toggled, this, &RagIndexerPropertiesWidget::resumeInterruptedChanged);
+    connect(m_compactIndexCheckBox, &QCheckBox::toggled, this, &RagIndexerPropertiesWidget::compactIndexChanged);
     connect(m_showFilteredCheck, &QCheckBox::toggled, this, &RagIndexerPropertiesWidget::onShowFilteredChanged);
     connect(m_testModelButton, &QPushButton::clicked, this, &RagIndexerPropertiesWidget::onTestModelClicked);
     connect(&m_modelTester, &QFutureWatcher<ModelTestResult>::finished,
@@ -302,6 +415,11 @@ int RagIndexerPropertiesWidget::chunkOverlap() const
     return m_chunkOverlapSpinBox->value();
 }
 
+int RagIndexerPropertiesWidget::embeddingConcurrency() const
+{
+    return m_embeddingConcurrencySpinBox->value();
+}
+
 QString RagIndexerPropertiesWidget::fileFilter() const
 {
     return m_fileFilterEdit->text();
@@ -317,6 +435,61 @@ bool RagIndexerPropertiesWidget::clearDatabase() const
     return m_clearDatabaseCheckBox->isChecked();
 }
 
+bool RagIndexerPropertiesWidget::buildAnnIndex() const
+{
+    return m_buildAnnIndexCheckBox->isChecked();
+}
+
+bool RagIndexerPropertiesWidget::buildVectorFile() const
+{
+    return m_buildVectorFileCheckBox->isChecked();
+}
+
+bool RagIndexerPropertiesWidget::buildTextIndex() const
+{
+    return m_buildTextIndexCheckBox->isChecked();
+}
+
+QString RagIndexerPropertiesWidget::embeddingFormat() const
+{
+    return m_embeddingFormatCombo->currentData().toString();
+}
+
+bool RagIndexerPropertiesWidget::keepFullPrecision() const
+{
+    return m_keepFullPrecisionCheckBox->isChecked();
+}
+
+int RagIndexerPropertiesWidget::embeddingDimensions() const
+{
+    return m_embeddingDimensionsSpinBox->value();
+}
+
+int RagIndexerPropertiesWidget::checkpointFiles() const
+{
+    return m_checkpointFilesSpinBox->value();
+}
+
+int RagIndexerPropertiesWidget::checkpointSeconds() const
+{
+    return m_checkpointSecondsSpinBox->value();
+}
+
+bool RagIndexerPropertiesWidget::resumeInterrupted() const
+{
+    return m_resumeInterruptedCheckBox->isChecked();
+}
+
+bool RagIndexerPropertiesWidget::compactIndex() const
+{
+    return m_compactIndexCheckBox->isChecked();
+}
+
+QString RagIndexerPropertiesWidget::deduplication() const
+{
+    return m_deduplicationCombo->currentData().toString();
+}
+
 // Setters
 void RagIndexerPropertiesWidget::setDirectoryPath(const QString& path)
 {
@@ -387,6 +560,15 @@ void RagIndexerPropertiesWidget::setChunkOverlap(int overlap)
     }
 }
 
+void RagIndexerPropertiesWidget::setEmbeddingConcurrency(int requests)
+{
+    if (m_embeddingConcurrencySpinBox->value() != requests) {
+        m_embeddingConcurrencySpinBox->blockSignals(true);
+        m_embeddingConcurrencySpinBox->setValue(requests);
+        m_embeddingConcurrencySpinBox->blockSignals(false);
+    }
+}
+
 void RagIndexerPropertiesWidget::setFileFilter(const QString& filter)
 {
     if (m_fileFilterEdit->text() != filter) {
@@ -422,6 +604,108 @@ void RagIndexerPropertiesWidget::setClearDatabase(bool clear)
     }
 }
 
+void RagIndexerPropertiesWidget::setBuildAnnIndex(bool build)
+{
+    if (m_buildAnnIndexCheckBox->isChecked() != build) {
+        m_buildAnnIndexCheckBox->blockSignals(true);
+        m_buildAnnIndexCheckBox->setChecked(build);
+        m_buildAnnIndexCheckBox->blockSignals(false);
+    }
+}
+
+void RagIndexerPropertiesWidget::setBuildVectorFile(bool build)
+{
+    if (m_buildVectorFileCheckBox->isChecked() != build) {
+        m_buildVectorFileCheckBox->blockSignals(true);
+        m_buildVectorFileCheckBox->setChecked(build);
+        m_buildVectorFileCheckBox->blockSignals(false);
+    }
+}
+
+void RagIndexerPropertiesWidget::setBuildTextIndex(bool build)
+{
+    if (m_buildTextIndexCheckBox->isChecked() != build) {
+        m_buildTextIndexCheckBox->blockSignals(true);
+        m_buildTextIndexCheckBox->setChecked(build);
+        m_buildTextIndexCheckBox->blockSignals(false);
+    }
+}
+
+void RagIndexerPropertiesWidget::setEmbeddingFormat(const QString& format)
+{
+    const int index = m_embeddingFormatCombo->findData(format);
+    if (index >= 0 && m_embeddingFormatCombo->currentIndex() != index) {
+        m_embeddingFormatCombo->blockSignals(true);
+        m_embeddingFormatCombo->setCurrentIndex(index);
+        m_embeddingFormatCombo->blockSignals(false);
+    }
+    m_keepFullPrecisionCheckBox->setEnabled(embeddingFormat() != QStringLiteral("float32"));
+}
+
+void RagIndexerPropertiesWidget::setKeepFullPrecision(bool keep)
+{
+    if (m_keepFullPrecisionCheckBox->isChecked() != keep) {
+        m_keepFullPrecisionCheckBox->blockSignals(true);
+        m_keepFullPrecisionCheckBox->setChecked(keep);
+        m_keepFullPrecisionCheckBox->blockSignals(false);
+    }
+}
+
+void RagIndexerPropertiesWidget::setEmbeddingDimensions(int dimensions)
+{
+    if (m_embeddingDimensionsSpinBox->value() != dimensions) {
+        m_embeddingDimensionsSpinBox->blockSignals(true);
+        m_embeddingDimensionsSpinBox->setValue(dimensions);
+        m_embeddingDimensionsSpinBox->blockSignals(false);
+    }
+}
+
+void RagIndexerPropertiesWidget::setCheckpointFiles(int files)
+{
+    if (m_checkpointFilesSpinBox->value() != files) {
+        m_checkpointFilesSpinBox->blockSignals(true);
+        m_checkpointFilesSpinBox->setValue(files);
+        m_checkpointFilesSpinBox->blockSignals(false);
+    }
+}
+
+void RagIndexerPropertiesWidget::setCheckpointSeconds(int seconds)
+{
+    if (m_checkpointSecondsSpinBox->value() != seconds) {
+        m_checkpointSecondsSpinBox->blockSignals(true);
+        m_checkpointSecondsSpinBox->setValue(seconds);
+        m_checkpointSecondsSpinBox->blockSignals(false);
+    }
+}
+
+void RagIndexerPropertiesWidget::setResumeInterrupted(bool resume)
+{
+    if (m_resumeInterruptedCheckBox->isChecked() != resume) {
+        m_resumeInterruptedCheckBox->blockSignals(true);
+        m_resumeInterruptedCheckBox->setChecked(resume);
+        m_resumeInterruptedCheckBox->blockSignals(false);
+    }
+}
+
+void RagIndexerPropertiesWidget::setCompactIndex(bool compact)
+{
+    if (m_compactIndexCheckBox->isChecked() != compact) {
+        m_compactIndexCheckBox->blockSignals(true);
+        m_compactIndexCheckBox->setChecked(compact);
+        m_compactIndexCheckBox->blockSignals(false);
+    }
+}
+
+void RagIndexerPropertiesWidget::setDeduplication(const QString& mode)
+{
+    const int index = m_deduplicationCombo->findData(mode);
+    if (index >= 0 && m_deduplicationCombo->currentIndex() != index) {
+        m_deduplicationCombo->blockSignals(true);
+        m_deduplicationCombo->setCurrentIndex(index);
+        m_deduplicationCombo->blockSignals(false);
+    }
+}
+
 void RagIndexerPropertiesWidget::setStatusMessage(const QString& message)
 {
     if (!m_statusLabel) {
@@ -651,3 +935,128 @@ void RagIndexerPropertiesWidget::onStrategyChanged(int index)
     const QString strategy = m_chunkingStrategyCombo->itemText(index);
     emit chunkingStrategyChanged(strategy);
 }
+
+QWidget* RagIndexerNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* widget = new RagIndexerPropertiesWidget(parent);
+    
+    // Initialize widget with current state
+    widget->setDirectoryPath(m_directoryPath);
+    widget->setDatabasePath(m_databasePath);
+    widget->setIndexMetadata(m_indexMetadata);
+    widget->setProviderId(m_providerId);
+    widget->setModelId(m_modelId);
+    widget->setChunkSize(m_chunkSize);
+    widget->setChunkOverlap(m_chunkOverlap);
+    widget->setEmbeddingConcurrency(m_embeddingConcurrency);
+    widget->setFileFilter(m_fileFilter);
+    widget->setChunkingStrategy(m_chunkingStrategy);
+    widget->setClearDatabase(m_clearDatabase);
+    widget->setBuildAnnIndex(m_buildAnnIndex);
+    widget->setBuildVectorFile(m_buildVectorFile);
+    widget->setBuildTextIndex(m_buildTextIndex);
+    widget->setEmbeddingFormat(m_embeddingFormat);
+    widget->setKeepFullPrecision(m_keepFullPrecision);
+    widget->setEmbeddingDimensions(m_embeddingDimensions);
+    widget->setCheckpointFiles(m_checkpointFiles);
+    widget->setCheckpointSeconds(m_checkpointSeconds);
+    widget->setResumeInterrupted(m_resumeInterrupted);
+    widget->setCompactIndex(m_compactIndex);
+    widget->setDeduplication(m_deduplication);
+
+    // Connect widget signals to node slots
+    QObject::connect(widget, &RagIndexerPropertiesWidget::directoryPathChanged,
+                     this, &RagIndexerNode::setDirectoryPath);
+    QObject::connect(widget, &RagIndexerPropertiesWidget::databasePathChanged,
+                     this, &RagIndexerNode::setDatabasePath);
+    QObject::connect(widget, &RagIndexerPropertiesWidget::indexMetadataChanged,
+                     this, &RagIndexerNode::setIndexMetadata);
+    QObject::connect(widget, &RagIndexerPropertiesWidget::providerChanged,
+                     this, &RagIndexerNode::setProviderId);
+    QObject::connect(widget, &RagIndexerPropertiesWidget::modelChanged,
+                     this, &RagIndexerNode::setModelId);
+    QObject::connect(widget, &RagIndexerPropertiesWidget::chunkSizeChanged,
+                     this, &RagIndexerNode::setChunkSize);
+    QObject::connect(widget, &RagIndexerPropertiesWidget::chunkOverlapChanged,
+                     this, &RagIndexerNode::setChunkOverlap);
+    QObject::connect(widget, &RagIndexerPropertiesWidget::embeddingConcurrencyChanged,
+                     this, &RagIndexerNode::setEmbeddingConcurrency);
+    QObject::connect(widget, &RagIndexerPropertiesWidget::fileFilterChanged,
+                     this, &RagIndexerNode::setFileFilter);
+    QObject::connect(widget, &RagIndexerPropertiesWidget::chunkingStrategyChanged,
+                     this, &RagIndexerNode::setChunkingStrategy);
+    QObject::connect(widget, &RagIndexerPropertiesWidget::clearDatabaseChanged,
+                     this, &RagIndexerNode::setClearDatabase);
+    QObject::connect(widget, &RagIndexerPropertiesWidget::buildAnnIndexChanged,
+                     this, &RagIndexerNode::setBuildAnnIndex);
+    QObject::connect(widget, &RagIndexerPropertiesWidget::buildVectorFileChanged,
+                     this, &RagIndexerNode::setBuildVectorFile);
+    QObject::connect(widget, &RagIndexerPropertiesWidget::buildTextIndexChanged,
+                     this, &RagIndexerNode::setBuildTextIndex);
+    QObject::connect(widget, &RagIndexerPropertiesWidget::embeddingFormatChanged,
+                     this, &RagIndexerNode::setEmbeddingFormat);
+    QObject::connect(widget, &RagIndexerPropertiesWidget::keepFullPrecisionChanged,
+                     this, &RagIndexerNode::setKeepFullPrecision);
+    QObject::connect(widget, &RagIndexerPropertiesWidget::embeddingDimensionsChanged,
+                     this, &RagIndexerNode::setEmbeddingDimensions);
+    QObject::connect(widget, &RagIndexerPropertiesWidget::checkpointFilesChanged,
+                     this, &RagIndexerNode::setCheckpointFiles);
+    QObject::connect(widget, &RagIndexerPropertiesWidget::checkpointSecondsChanged,
+                     this, &RagIndexerNode::setCheckpointSeconds);
+    QObject::connect(widget, &RagIndexerPropertiesWidget::resumeInterruptedChanged,
+                     this, &RagIndexerNode::setResumeInterrupted);
+    QObject::connect(widget, &RagIndexerPropertiesWidget::compactIndexChanged,
+                     this, &RagIndexerNode::setCompactIndex);
+    QObject::connect(widget, &RagIndexerPropertiesWidget::deduplicationChanged,
+                     this, &RagIndexerNode::setDeduplication);
+
+    // Connect node signals back to widget for external updates
+    QObject::connect(this, &RagIndexerNode::directoryPathChanged,
+                     widget, &RagIndexerPropertiesWidget::setDirectoryPath);
+    QObject::connect(this, &RagIndexerNode::databasePathChanged,
+                     widget, &RagIndexerPropertiesWidget::setDatabasePath);
+    QObject::connect(this, &RagIndexerNode::indexMetadataChanged,
+                     widget, &RagIndexerPropertiesWidget::setIndexMetadata);
+    QObject::connect(this, &RagIndexerNode::providerChanged,
+                     widget, &RagIndexerPropertiesWidget::setProviderId);
+    QObject::connect(this, &RagIndexerNode::modelChanged,
+                     widget, &RagIndexerPropertiesWidget::setModelId);
+    QObject::connect(this, &RagIndexerNode::chunkSizeChanged,
+                     widget, &RagIndexerPropertiesWidget::setChunkSize);
+    QObject::connect(this, &RagIndexerNode::chunkOverlapChanged,
+                     widget, &RagIndexerPropertiesWidget::setChunkOverlap);
+    QObject::connect(this, &RagIndexerNode::embeddingConcurrencyChanged,
+                     widget, &RagIndexerPropertiesWidget::setEmbeddingConcurrency);
+    QObject::connect(this, &RagIndexerNode::fileFilterChanged,
+                     widget, &RagIndexerPropertiesWidget::setFileFilter);
+    QObject::connect(this, &RagIndexerNode::chunkingStrategyChanged,
+                     widget, &RagIndexerPropertiesWidget::setChunkingStrategy);
+    QObject::connect(this, &RagIndexerNode::clearDatabaseChanged,
+                     widget, &RagIndexerPropertiesWidget::setClearDatabase);
+    QObject::connect(this, &RagIndexerNode::buildAnnIndexChanged,
+                     widget, &RagIndexerPropertiesWidget::setBuildAnnIndex);
+    QObject::connect(this, &RagIndexerNode::buildVectorFileChanged,
+                     widget, &RagIndexerPropertiesWidget::setBuildVectorFile);
+    QObject::connect(this, &RagIndexerNode::buildTextIndexChanged,
+                     widget, &RagIndexerPropertiesWidget::setBuildTextIndex);
+    QObject::connect(this, &RagIndexerNode::embeddingFormatChanged,
+                     widget, &RagIndexerPropertiesWidget::setEmbeddingFormat);
+    QObject::connect(this, &RagIndexerNode::keepFullPrecisionChanged,
+                     widget, &RagIndexerPropertiesWidget::setKeepFullPrecision);
+    QObject::connect(this, &RagIndexerNode::embeddingDimensionsChanged,
+                     widget, &RagIndexerPropertiesWidget::setEmbeddingDimensions);
+    QObject::connect(this, &RagIndexerNode::checkpointFilesChanged,
+                     widget, &RagIndexerPropertiesWidget::setCheckpointFiles);
+    QObject::connect(this, &RagIndexerNode::checkpointSecondsChanged,
+                     widget, &RagIndexerPropertiesWidget::setCheckpointSeconds);
+    QObject::connect(this, &RagIndexerNode::resumeInterruptedChanged,
+                     widget, &RagIndexerPropertiesWidget::setResumeInterrupted);
+    QObject::connect(this, &RagIndexerNode::compactIndexChanged,
+                     widget, &RagIndexerPropertiesWidget::setCompactIndex);
+    QObject::connect(this, &RagIndexerNode::deduplicationChanged,
+                     widget, &RagIndexerPropertiesWidget::setDeduplication);
+    QObject::connect(this, &RagIndexerNode::statusChanged,
+                     widget, &RagIndexerPropertiesWidget::setStatusMessage);
+
+    return widget;
+}
@@ -59,9 +59,21 @@ public:
     QString modelId() const;
     int chunkSize() const;
     int chunkOverlap() const;
+    int embeddingConcurrency() const;
     QString fileFilter() const;
     QString chunkingStrategy() const;
     bool clearDatabase() const;
+    bool buildAnnIndex() const;
+    bool buildVectorFile() const;
+    bool buildTextIndex() const;
+    QString embeddingFormat() const;
+    bool keepFullPrecision() const;
+    int embeddingDimensions() const;
+    int checkpointFiles() const;
+    int checkpointSeconds() const;
+    bool resumeInterrupted() const;
+    bool compactIndex() const;
+    QString deduplication() const;
 
 public slots:
     // Setters (for initializing from node state)
@@ -72,9 +84,21 @@ public slots:
     void setModelId(const QString& id);
     void setChunkSize(int size);
     void setChunkOverlap(int overlap);
+    void setEmbeddingConcurrency(int requests);
     void setFileFilter(const QString& filter);
     void setChunkingStrategy(const QString& strategy);
     void setClearDatabase(bool clear);
+    void setBuildAnnIndex(bool build);
+    void setBuildVectorFile(bool build);
+    void setBuildTextIndex(bool build);
+    void setEmbeddingFormat(const QString& format);
+    void setKeepFullPrecision(bool keep);
+    void setEmbeddingDimensions(int dimensions);
+    void setCheckpointFiles(int files);
+    void setCheckpointSeconds(int seconds);
+    void setResumeInterrupted(bool resume);
+    void setCompactIndex(bool compact);
+    void setDeduplication(const QString& mode);
     void setStatusMessage(const QString& message);
 
 signals:
@@ -86,9 +110,21 @@ signals:
     void modelChanged(const QString& id);
     void chunkSizeChanged(int size);
     void chunkOverlapChanged(int overlap);
+    void embeddingConcurrencyChanged(int requests);
     void fileFilterChanged(const QString& filter);
     void chunkingStrategyChanged(const QString& strategy);
     void clearDatabaseChanged(bool clear);
+    void buildAnnIndexChanged(bool build);
+    void buildVectorFileChanged(bool build);
+    void buildTextIndexChanged(bool build);
+    void embeddingFormatChanged(const QString& format);
+    void keepFullPrecisionChanged(bool keep);
+    void embeddingDimensionsChanged(int dimensions);
+    void checkpointFilesChanged(int files);
+    void checkpointSecondsChanged(int seconds);
+    void resumeInterruptedChanged(bool resume);
+    void compactIndexChanged(bool compact);
+    void deduplicationChanged(const QString& mode);
 
 private slots:
     void onBrowseDirectory();
@@ -112,6 +148,7 @@ private:
     QComboBox* m_modelCombo {nullptr};
     QSpinBox* m_chunkSizeSpinBox {nullptr};
     QSpinBox* m_chunkOverlapSpinBox {nullptr};
+    QSpinBox* m_embeddingConcurrencySpinBox {nullptr};
     QPushButton* m_browseDirectoryBtn {nullptr};
     QPushButton* m_createDatabaseBtn {nullptr};
     QPushButton* m_openDatabaseBtn {nullptr};
@@ -119,6 +156,17 @@ private:
     QLineEdit* m_fileFilterEdit {nullptr};
     QComboBox* m_chunkingStrategyCombo {nullptr};
     QCheckBox* m_clearDatabaseCheckBox {nullptr};
+    QCheckBox* m_buildAnnIndexCheckBox {nullptr};
+    QCheckBox* m_buildVectorFileCheckBox {nullptr};
+    QCheckBox* m_buildTextIndexCheckBox {nullptr};
+    QComboBox* m_embeddingFormatCombo {nullptr};
+    QCheckBox* m_keepFullPrecisionCheckBox {nullptr};
+    QSpinBox* m_embeddingDimensionsSpinBox {nullptr};
+    QSpinBox* m_checkpointFilesSpinBox {nullptr};
+    QSpinBox* m_checkpointSecondsSpinBox {nullptr};
+    QCheckBox* m_resumeInterruptedCheckBox {nullptr};
+    QCheckBox* m_compactIndexCheckBox {nullptr};
+    QComboBox* m_deduplicationCombo {nullptr};
     QCheckBox* m_showFilteredCheck {nullptr};
     QPushButton* m_testModelButton {nullptr};
     QLabel* m_testStatusLabel {nullptr};
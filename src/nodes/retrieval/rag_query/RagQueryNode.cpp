@@ -24,24 +24,201 @@
 
 #include "RagQueryNode.h"
 
-#include "RagQueryPropertiesWidget.h"
 #include "retrieval/storage/RagUtils.h"
+#include "retrieval/storage/EmbeddingCache.h"
+#include "retrieval/storage/RagQueryCache.h"
+#include "retrieval/storage/RagIndexClient.h"
+#include "retrieval/ranking/Reranker.h"
 #include "ai/registry/LLMProviderRegistry.h"
 #include "ai/backends/ILLMBackend.h"
 #include "ai/catalog/ModelCatalogService.h"
 #include "ModelCapsRegistry.h"
+#include "CancellationToken.h"
+#include "CpuWorkerPool.h"
+#include "ScopeRuntime.h"
+#include "Tracer.h"
 
 #include <QtConcurrent>
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QJsonDocument>
 #include <QFileInfo>
-#include <QSqlDatabase>
-#include <QSqlQuery>
-#include <QSqlError>
-#include <QUuid>
+#include <QSet>
 #include "Logger.h"
 
+namespace {
+
+RagSearchMode searchModeFromName(const QString& name)
+{
+    if (name == QStringLiteral("hybrid")) {
+        return RagSearchMode::Hybrid;
+    }
+    if (name == QStringLiteral("keyword_prefilter")) {
+        return RagSearchMode::KeywordPrefilter;
+    }
+    return RagSearchMode::Vector;
+}
+
+void appendReference(QString& out, const RagUtils::SearchResult& r)
+{
+    if (r.filePath.isEmpty()) {
+        out += QLatin1String("file_id=");
+        out += QString::number(r.fileId);
+    } else {
+        out += r.filePath;
+    }
+    if (r.startLine > 0 && r.endLine > 0) {
+        out += QLatin1Char(':');
+        out += QString::number(r.startLine);
+        out += QLatin1Char('-');
+        out += QString::number(r.endLine);
+    }
+}
+
+// Each match as a reference header followed by its text, appended into one buffer sized up front
+QString formatContext(const std::vector<RagUtils::SearchResult>& searchResults)
+{
+    qsizetype size = 0;
+    for (const auto& r : searchResults) {
+        size += r.content.size() + r.filePath.size() + 64;
+    }
+    QString contextText;
+    contextText.reserve(size);
+    for (const auto& r : searchResults) {
+        contextText += QLatin1String("[Reference: ");
+        appendReference(contextText, r);
+        contextText += QLatin1String(" | Score: ");
+        contextText += QString::number(r.score, 'f', 4);
+        if (r.rerankScore >= 0.0) {
+            contextText += QLatin1String(" | Rerank: ");
+            contextText += QString::number(r.rerankScore, 'f', 2);
+        }
+        contextText += QLatin1String("]\n");
+        contextText += r.content;
+        contextText += QLatin1String("\n\n");
+    }
+    return contextText;
+}
+
+QVariantList formatResults(const std::vector<RagUtils::SearchResult>& searchResults)
+{
+    QVariantList results;
+    for (const auto& r : searchResults) {
+        const QString sourceLabel = r.filePath.isEmpty()
+            ? QStringLiteral("file_id=%1").arg(r.fileId)
+            : r.filePath;
+        QString reference;
+        appendReference(reference, r);
+
+        QVariantMap item;
+        item.insert(QStringLiteral("source"), sourceLabel);
+        item.insert(QStringLiteral("reference"), reference);
+        item.insert(QStringLiteral("score"), r.score);
+        if (r.fusedScore > 0.0) {
+            item.insert(QStringLiteral("fused_score"), r.fusedScore);
+        }
+        if (r.rerankScore >= 0.0) {
+            item.insert(QStringLiteral("rerank_score"), r.rerankScore);
+        }
+        item.insert(QStringLiteral("text"), r.content);
+        item.insert(QStringLiteral("fragment_id"), r.fragmentId);
+        item.insert(QStringLiteral("file_id"), r.fileId);
+        item.insert(QStringLiteral("chunk_index"), r.chunkIndex);
+        if (!r.indexPath.isEmpty()) {
+            item.insert(QStringLiteral("index"), r.indexPath);
+        }
+        if (!r.duplicatePaths.isEmpty()) {
+            item.insert(QStringLiteral("also_in"), r.duplicatePaths);
+        }
+        if (r.startLine > 0) {
+            item.insert(QStringLiteral("start_line"), r.startLine);
+        }
+        if (r.endLine > 0) {
+            item.insert(QStringLiteral("end_line"), r.endLine);
+        }
+        results.append(item);
+    }
+    return results;
+}
+
+// One database of a search, with its results per query
+struct IndexShard {
+    QString path;
+    RagUtils::IndexConfig config;
+    int group {0};
+    // Served by a retrieval daemon (rag://host:port/name)
+    bool remote {false};
+    // RagQueryCache key per query, empty when the cache answered it, the query is blank or the
+    // index is remote
+    QList<QByteArray> cacheKeys;
+    // Queries this index still has to search
+    std::vector<bool> searching;
+    std::vector<std::vector<RagUtils::SearchResult>> results;
+    QString error;
+};
+
+// The indexes sharing a provider, model and dimension, which share query embeddings
+struct ModelGroup {
+    RagUtils::IndexConfig config;
+    QString apiKey;
+    ILLMBackend* backend {nullptr};
+    // Queries some index of the group still has to search, and their embeddings
+    std::vector<bool> pending;
+    std::vector<std::vector<float>> embeddings;
+    QString error;
+};
+
+EmbeddingBatchResult embedQueries(ILLMBackend& backend, EmbeddingCache* cache, const QString& apiKey,
+                                  const RagUtils::IndexConfig& config, const QStringList& texts,
+                                  EmbeddingCache::Counters* counters)
+{
+    if (cache) {
+        return cache->embed(backend, config.providerId, apiKey, config.modelId, texts, config.dimension, counters);
+    }
+    if (config.dimension > 0) {
+        // Asked at the stored size, so an index built with reduced dimensions gets matching queries
+        return backend.getEmbeddingsAtDimension(apiKey, config.modelId, texts, config.dimension);
+    }
+    if (texts.size() == 1) {
+        EmbeddingBatchResult embResult;
+        EmbeddingResult single = backend.getEmbedding(apiKey, config.modelId, texts.front());
+        embResult.usage = single.usage;
+        embResult.hasError = single.hasError;
+        embResult.errorMsg = single.errorMsg;
+        if (!single.hasError) {
+            embResult.vectors.push_back(std::move(single.vector));
+        }
+        return embResult;
+    }
+    return backend.getEmbeddings(apiKey, config.modelId, texts);
+}
+
+// Runs work(0) .. work(count - 1) together, the calling thread taking the first, each under the caller's run scopes
+template <typename Work>
+void forEachConcurrently(std::size_t count, Work&& work)
+{
+    const CancellationToken cancellation = CancellationToken::current();
+    const Tracer::Context tracingContext = Tracer::current();
+    QThreadPool* cpuPool = CpuWorkerPool::current();
+    QList<QFuture<void>> others;
+    for (std::size_t i = 1; i < count; ++i) {
+        others.append(QtConcurrent::run([&work, i, cancellation, tracingContext, cpuPool]() {
+            const CancellationToken::Scope cancellationScope(cancellation);
+            const Tracer::Scope tracingScope(tracingContext);
+            const CpuWorkerPool::Scope cpuPoolScope(cpuPool);
+            work(i);
+        }));
+    }
+    if (count > 0) {
+        work(0);
+    }
+    for (QFuture<void>& future : others) {
+        future.waitForFinished();
+    }
+}
+
+} // namespace
+
 RagQueryNode::RagQueryNode(QObject* parent)
     : QObject(parent)
 {
@@ -58,11 +235,20 @@ NodeDescriptor RagQueryNode::getDescriptor() const
     desc.inputPins.insert(QString::fromLatin1(kInputQuery),
         PinDefinition{PinDirection::Input, QString::fromLatin1(kInputQuery),
                       QStringLiteral("Query"), QStringLiteral("text")});
+    desc.inputPins.insert(QString::fromLatin1(kInputQueries),
+        PinDefinition{PinDirection::Input, QString::fromLatin1(kInputQueries),
+                      QStringLiteral("Queries"), QStringLiteral("json")});
+    desc.inputPins.insert(QString::fromLatin1(kInputFilter),
+        PinDefinition{PinDirection::Input, QString::fromLatin1(kInputFilter),
+                      QStringLiteral("Filter"), QStringLiteral("text")});
 
     // Outputs
     desc.outputPins.insert(QString::fromLatin1(kOutputContext),
         PinDefinition{PinDirection::Output, QString::fromLatin1(kOutputContext),
                       QStringLiteral("Context"), QStringLiteral("text")});
+    desc.outputPins.insert(QString::fromLatin1(kOutputContexts),
+        PinDefinition{PinDirection::Output, QString::fromLatin1(kOutputContexts),
+                      QStringLiteral("Contexts"), QStringLiteral("json")});
     desc.outputPins.insert(QString::fromLatin1(kOutputResults),
         PinDefinition{PinDirection::Output, QString::fromLatin1(kOutputResults),
                       QStringLiteral("Results"), QStringLiteral("json")});
@@ -70,26 +256,12 @@ NodeDescriptor RagQueryNode::getDescriptor() const
     return desc;
 }
 
-QWidget* RagQueryNode::createConfigurationWidget(QWidget* parent)
+TokenList RagQueryNode::execute(const TokenList& incomingTokens)
 {
-    auto* widget = new RagQueryPropertiesWidget(parent);
-    widget->setMaxResults(m_maxResults);
-    widget->setMinRelevance(m_minRelevance);
-    widget->setDatabasePath(m_databasePath);
-    widget->setQueryText(m_queryText);
-
-    QObject::connect(widget, &RagQueryPropertiesWidget::maxResultsChanged,
-                     this, &RagQueryNode::setMaxResults);
-    QObject::connect(widget, &RagQueryPropertiesWidget::minRelevanceChanged,
-                     this, &RagQueryNode::setMinRelevance);
-    QObject::connect(widget, &RagQueryPropertiesWidget::databasePathChanged,
-                     this, &RagQueryNode::setDatabasePath);
-    QObject::connect(widget, &RagQueryPropertiesWidget::queryTextChanged,
-                     this, &RagQueryNode::setQueryText);
-    return widget;
+    return executeAsync(incomingTokens).result();
 }
 
-TokenList RagQueryNode::execute(const TokenList& incomingTokens)
+QFuture<TokenList> RagQueryNode::executeAsync(const TokenList& incomingTokens)
 {
     // Merge incoming tokens into a single DataPacket to preserve the
     // previous Execute(DataPacket) contract.
@@ -100,20 +272,24 @@ TokenList RagQueryNode::execute(const TokenList& incomingTokens)
         }
     }
 
-    QFuture<DataPacket> fut = Execute(inputs);
-    const DataPacket out = fut.result();
-
-    ExecutionToken token;
-    token.data = out;
+    return Execute(inputs).then(QtFuture::Launch::Sync, [](const DataPacket& out) {
+        ExecutionToken token;
+        token.data = out;
 
-    TokenList result;
-    result.push_back(std::move(token));
-    return result;
+        TokenList result;
+        result.push_back(std::move(token));
+        return result;
+    });
 }
 
 QFuture<DataPacket> RagQueryNode::Execute(const DataPacket& inputs)
 {
-    return QtConcurrent::run([this, inputs]() -> DataPacket {
+    // The query runs on another thread, so it takes the caller's run token along
+    return QtConcurrent::run([this, inputs, cancellation = CancellationToken::current(),
+                              tracingContext = Tracer::current(), cpuPool = CpuWorkerPool::current()]() -> DataPacket {
+        const CancellationToken::Scope cancellationScope(cancellation);
+        const Tracer::Scope tracingScope(tracingContext);
+        const CpuWorkerPool::Scope cpuPoolScope(cpuPool);
         DataPacket output;
         auto fail = [&output](const QString& message) {
             output.insert(QStringLiteral("__error"), message);
@@ -125,38 +301,105 @@ QFuture<DataPacket> RagQueryNode::Execute(const DataPacket& inputs)
             queryText = m_queryText.trimmed();
         }
 
-        QString dbPath = inputs.value(QString::fromLatin1(kInputDbPath)).toString().trimmed();
-        if (dbPath.isEmpty()) {
-            dbPath = m_databasePath.trimmed();
+        // A list on the Queries pin switches to multi-query mode: one embedding call, one scan
+        QStringList queries;
+        for (const QVariant& item : scopeVariantToList(inputs.value(QString::fromLatin1(kInputQueries)))) {
+            queries.append(item.toString().trimmed());
+        }
+        const bool multiQuery = !queries.isEmpty();
+        if (!multiQuery) {
+            queries.append(queryText);
         }
 
-        if (queryText.isEmpty()) {
+        // A path list on the database input replaces the configured ones; several paths are searched as one
+        QStringList dbPaths;
+        auto addPath = [&dbPaths](const QString& path) {
+            const QString trimmed = path.trimmed();
+            if (!trimmed.isEmpty() && !dbPaths.contains(trimmed)) {
+                dbPaths.append(trimmed);
+            }
+        };
+        for (const QVariant& item : scopeVariantToList(inputs.value(QString::fromLatin1(kInputDbPath)))) {
+            addPath(item.toString());
+        }
+        if (dbPaths.isEmpty()) {
+            addPath(m_databasePath);
+            for (const QString& path : m_additionalDatabasePaths) {
+                addPath(path);
+            }
+        }
+        const bool federated = dbPaths.size() > 1;
+
+        if (!multiQuery && queryText.isEmpty()) {
             const QString msg = QStringLiteral("RAG Query text is empty.");
             CP_WARN << msg;
             return fail(msg);
         }
 
-        if (dbPath.isEmpty()) {
+        if (dbPaths.isEmpty()) {
             const QString msg = QStringLiteral("RAG Query database path is empty.");
             CP_WARN << msg;
             return fail(msg);
         }
 
-        QFileInfo fi(dbPath);
-        if (!fi.exists() || !fi.isFile()) {
-            const QString msg = QStringLiteral("RAG Query database file does not exist: %1").arg(dbPath);
-            CP_WARN << msg;
-            return fail(msg);
+        for (const QString& dbPath : dbPaths) {
+            if (RagIndexClient::isRemote(dbPath)) {
+                continue;
+            }
+            QFileInfo fi(dbPath);
+            if (!fi.exists() || !fi.isFile()) {
+                const QString msg = QStringLiteral("RAG Query database file does not exist: %1").arg(dbPath);
+                CP_WARN << msg;
+                return fail(msg);
+            }
         }
 
-        RagUtils::IndexConfig indexCfg;
+        // A malformed filter fails before anything is embedded
+        QString filterExpression = inputs.value(QString::fromLatin1(kInputFilter)).toString().trimmed();
+        if (filterExpression.isEmpty()) {
+            filterExpression = m_filterExpression.trimmed();
+        }
+        RagSearchFilter filter;
         try {
-            indexCfg = RagUtils::getIndexConfig(dbPath);
+            filter = RagUtils::parseSearchFilter(filterExpression);
         } catch (const std::exception& ex) {
-            const QString msg = QStringLiteral("Failed to inspect RAG index config: %1").arg(QString::fromUtf8(ex.what()));
+            const QString msg = QStringLiteral("Invalid RAG search filter: %1").arg(QString::fromUtf8(ex.what()));
             CP_WARN << "RagQueryNode:" << msg;
             return fail(msg);
         }
+
+        // Indexes built with the same model and size share one query embedding
+        std::vector<IndexShard> shards;
+        std::vector<ModelGroup> groups;
+        for (const QString& dbPath : dbPaths) {
+            IndexShard shard;
+            shard.path = dbPath;
+            shard.remote = RagIndexClient::isRemote(dbPath);
+            try {
+                shard.config = shard.remote ? RagIndexClient::indexConfig(dbPath) : RagUtils::getIndexConfig(dbPath);
+            } catch (const std::exception& ex) {
+                QString msg = QStringLiteral("Failed to inspect RAG index config: %1").arg(QString::fromUtf8(ex.what()));
+                if (federated) {
+                    msg += QStringLiteral(" (%1)").arg(dbPath);
+                }
+                CP_WARN << "RagQueryNode:" << msg;
+                return fail(msg);
+            }
+            const auto sameModel = std::find_if(groups.begin(), groups.end(), [&shard](const ModelGroup& group) {
+                return group.config.providerId == shard.config.providerId
+                    && group.config.modelId == shard.config.modelId
+                    && group.config.dimension == shard.config.dimension;
+            });
+            shard.group = static_cast<int>(sameModel - groups.begin());
+            if (sameModel == groups.end()) {
+                ModelGroup group;
+                group.config = shard.config;
+                groups.push_back(std::move(group));
+            }
+            shards.push_back(std::move(shard));
+        }
+
+        const RagUtils::IndexConfig& indexCfg = groups.front().config;
         output.insert(QStringLiteral("_provider"), indexCfg.providerId);
         output.insert(QStringLiteral("_model"), indexCfg.modelId);
         if (const auto resolvedRule = ModelCapsRegistry::instance().resolveWithRule(indexCfg.modelId, indexCfg.providerId);
@@ -164,158 +407,355 @@ QFuture<DataPacket> RagQueryNode::Execute(const DataPacket& inputs)
             output.insert(QStringLiteral("_driver"), resolvedRule->driverProfileId);
         }
 
-        if (indexCfg.providerId.isEmpty() || indexCfg.modelId.isEmpty()) {
-            const QString msg = QStringLiteral("RAG index configuration returned an empty provider or model.");
-            CP_WARN << "RagQueryNode:" << msg;
-            return fail(msg);
-        }
+        for (ModelGroup& group : groups) {
+            const RagUtils::IndexConfig& config = group.config;
+            if (config.providerId.isEmpty() || config.modelId.isEmpty()) {
+                const QString msg = QStringLiteral("RAG index configuration returned an empty provider or model.");
+                CP_WARN << "RagQueryNode:" << msg;
+                return fail(msg);
+            }
 
-        // Resolve credentials and backend via LLMProviderRegistry
-        QString apiKey = LLMProviderRegistry::instance().getCredential(indexCfg.providerId);
-        if (apiKey.isEmpty() && ModelCatalogService::providerRequiresCredential(indexCfg.providerId)) {
-            const QString msg = QStringLiteral("No API key found for provider '%1'.").arg(indexCfg.providerId);
-            CP_WARN << "RagQueryNode:" << msg;
-            return fail(msg);
-        }
+            // Resolve credentials and backend via LLMProviderRegistry
+            group.apiKey = LLMProviderRegistry::instance().getCredential(config.providerId);
+            if (group.apiKey.isEmpty() && ModelCatalogService::providerRequiresCredential(config.providerId)) {
+                const QString msg = QStringLiteral("No API key found for provider '%1'.").arg(config.providerId);
+                CP_WARN << "RagQueryNode:" << msg;
+                return fail(msg);
+            }
 
-        ILLMBackend* backend = LLMProviderRegistry::instance().getBackend(indexCfg.providerId);
-        if (!backend) {
-            const QString msg = QStringLiteral("Backend not found for provider '%1'.").arg(indexCfg.providerId);
-            CP_WARN << "RagQueryNode:" << msg;
-            return fail(msg);
+            group.backend = LLMProviderRegistry::instance().getBackend(config.providerId);
+            if (!group.backend) {
+                const QString msg = QStringLiteral("Backend not found for provider '%1'.").arg(config.providerId);
+                CP_WARN << "RagQueryNode:" << msg;
+                return fail(msg);
+            }
         }
 
-        // Vectorization
-        EmbeddingResult embResult = backend->getEmbedding(apiKey, indexCfg.modelId, queryText);
-        if (embResult.hasError) {
-            CP_WARN.noquote() << QStringLiteral("RagQueryNode: embedding failure provider=%1 model=%2 message=%3")
-                                          .arg(indexCfg.providerId, indexCfg.modelId, embResult.errorMsg);
-            return fail(QStringLiteral("Embedding failure for provider '%1' model '%2': %3")
-                            .arg(indexCfg.providerId, indexCfg.modelId, embResult.errorMsg));
+        // A reranking stage reorders a wider candidate list and keeps the best m_maxResults
+        const QString rerankProvider = m_rerankProvider.trimmed();
+        const QString rerankModel = m_rerankModel.trimmed();
+        const bool rerank = !rerankProvider.isEmpty() && !rerankModel.isEmpty();
+        const int searchLimit = rerank ? std::max(m_maxResults, m_rerankCandidates) : m_maxResults;
+        QString rerankApiKey;
+        ILLMBackend* rerankBackend = nullptr;
+        if (rerank) {
+            rerankApiKey = LLMProviderRegistry::instance().getCredential(rerankProvider);
+            if (rerankApiKey.isEmpty() && ModelCatalogService::providerRequiresCredential(rerankProvider)) {
+                const QString msg = QStringLiteral("No API key found for reranking provider '%1'.").arg(rerankProvider);
+                CP_WARN << "RagQueryNode:" << msg;
+                return fail(msg);
+            }
+            rerankBackend = LLMProviderRegistry::instance().getBackend(rerankProvider);
+            if (!rerankBackend) {
+                const QString msg = QStringLiteral("Backend not found for reranking provider '%1'.").arg(rerankProvider);
+                CP_WARN << "RagQueryNode:" << msg;
+                return fail(msg);
+            }
         }
 
-        if (embResult.vector.empty()) {
-            CP_WARN.noquote() << QStringLiteral("RagQueryNode: empty embedding provider=%1 model=%2")
-                                          .arg(indexCfg.providerId, indexCfg.modelId);
-            return fail(QStringLiteral("Embedding result was empty for provider '%1' model '%2'.")
-                            .arg(indexCfg.providerId, indexCfg.modelId));
+        RagSearchOptions searchOptions;
+        searchOptions.ef = m_searchEf;
+        searchOptions.coarseDimensions = m_coarseDimensions;
+        searchOptions.mode = searchModeFromName(m_searchMode);
+        searchOptions.queryText = queryText;
+        searchOptions.filter = filter;
+
+        // A query asked before against the same index state is answered without embedding or scanning.
+        // Blank entries of a query list are not sent and get no results. A model group embeds the
+        // queries that any of its indexes still has to search. A daemon's index changes out of
+        // sight, so remote indexes are always searched.
+        RagQueryCache& resultCache = RagQueryCache::shared();
+        const std::size_t queryCount = static_cast<std::size_t>(queries.size());
+        int resultCacheHits = 0;
+        for (IndexShard& shard : shards) {
+            shard.results.resize(queryCount);
+            shard.searching.resize(queryCount, false);
+            ModelGroup& group = groups[static_cast<std::size_t>(shard.group)];
+            group.pending.resize(queryCount, false);
+            for (qsizetype i = 0; i < queries.size(); ++i) {
+                QByteArray key;
+                if (!queries[i].isEmpty() && shard.remote) {
+                    shard.searching[static_cast<std::size_t>(i)] = true;
+                    group.pending[static_cast<std::size_t>(i)] = true;
+                } else if (!queries[i].isEmpty()) {
+                    RagSearchOptions keyOptions = searchOptions;
+                    keyOptions.queryText = queries[i];
+                    key = RagQueryCache::makeKey(shard.path, shard.config.providerId, shard.config.modelId,
+                                                 queries[i], searchLimit, m_minRelevance, keyOptions);
+                    if (resultCache.lookup(key, shard.results[static_cast<std::size_t>(i)])) {
+                        ++resultCacheHits;
+                        key.clear();
+                    } else {
+                        shard.searching[static_cast<std::size_t>(i)] = true;
+                        group.pending[static_cast<std::size_t>(i)] = true;
+                    }
+                }
+                shard.cacheKeys.append(key);
+            }
         }
+        output.insert(QStringLiteral("result_cache_hits"), resultCacheHits);
+
+        // Vectorization, one request per model group, the groups in parallel; repeated
+        // questions are answered from the embedding cache
+        const std::shared_ptr<EmbeddingCache> cache = EmbeddingCache::shared();
+        EmbeddingCache::Counters cacheCounters;
+        forEachConcurrently(groups.size(), [&](std::size_t index) {
+            ModelGroup& group = groups[index];
+            QStringList texts;
+            for (std::size_t i = 0; i < queryCount; ++i) {
+                if (group.pending[i]) {
+                    texts.append(queries[static_cast<qsizetype>(i)]);
+                }
+            }
+            group.embeddings.resize(queryCount);
+            if (texts.isEmpty()) {
+                // Everything came from the result cache
+                return;
+            }
+            const RagUtils::IndexConfig& config = group.config;
+            EmbeddingBatchResult embResult = embedQueries(*group.backend, cache.get(), group.apiKey, config, texts,
+                                                          &cacheCounters);
+            if (embResult.hasError) {
+                CP_WARN.noquote() << QStringLiteral("RagQueryNode: embedding failure provider=%1 model=%2 message=%3")
+                                              .arg(config.providerId, config.modelId, embResult.errorMsg);
+                group.error = QStringLiteral("Embedding failure for provider '%1' model '%2': %3")
+                                  .arg(config.providerId, config.modelId, embResult.errorMsg);
+                return;
+            }
+            if (embResult.vectors.size() != static_cast<std::size_t>(texts.size())
+                || std::any_of(embResult.vectors.begin(), embResult.vectors.end(),
+                               [](const std::vector<float>& vector) { return vector.empty(); })) {
+                CP_WARN.noquote() << QStringLiteral("RagQueryNode: empty embedding provider=%1 model=%2")
+                                              .arg(config.providerId, config.modelId);
+                group.error = QStringLiteral("Embedding result was empty for provider '%1' model '%2'.")
+                                  .arg(config.providerId, config.modelId);
+                return;
+            }
 
-        // Search
-        std::vector<RagUtils::SearchResult> searchResults;
-        try {
-            searchResults = RagUtils::findMostRelevantChunks(dbPath, embResult.vector, m_maxResults, m_minRelevance);
-        } catch (const std::exception& ex) {
-            const QString msg = QStringLiteral("RAG search error: %1").arg(QString::fromUtf8(ex.what()));
-            CP_WARN << "RagQueryNode:" << msg;
-            return fail(msg);
+            // Only queries still waiting for results get an embedding
+            for (std::size_t i = 0, next = 0; i < queryCount; ++i) {
+                if (group.pending[i]) {
+                    group.embeddings[i] = std::move(embResult.vectors[next++]);
+                }
+            }
+        });
+        if (cache) {
+            output.insert(QStringLiteral("embedding_cache_hits"), cacheCounters.hits.load());
+            output.insert(QStringLiteral("embedding_cache_misses"), cacheCounters.misses.load());
+        }
+        for (const ModelGroup& group : groups) {
+            if (!group.error.isEmpty()) {
+                return fail(group.error);
+            }
         }
 
-        // Optionally resolve file paths for nicer "Source" labels.
-        QMap<qint64, QString> filePathById;
-        QString connectionName;
-        bool dbOpened = false;
-
-        if (!searchResults.empty()) {
-            connectionName = QStringLiteral("rag_query_%1").arg(QUuid::createUuid().toString(QUuid::Id128));
-            QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
-            db.setDatabaseName(dbPath);
-            if (!db.open()) {
-                CP_WARN << "RagQueryNode: Failed to open database for source resolution:" << db.lastError().text();
-            } else {
-                dbOpened = true;
-                QSqlQuery query(db);
-                for (const auto& r : searchResults) {
-                    if (filePathById.contains(r.fileId)) {
+        // Search: every query of a list is scored in the same pass over each index, and
+        // the indexes are searched in parallel
+        forEachConcurrently(shards.size(), [&](std::size_t index) {
+            IndexShard& shard = shards[index];
+            const ModelGroup& group = groups[static_cast<std::size_t>(shard.group)];
+            std::vector<std::vector<float>> embeddings(queryCount);
+            bool searched = false;
+            for (std::size_t i = 0; i < queryCount; ++i) {
+                if (shard.searching[i]) {
+                    embeddings[i] = group.embeddings[i];
+                    searched = true;
+                }
+            }
+            if (!searched) {
+                return;
+            }
+            try {
+                std::vector<std::vector<RagUtils::SearchResult>> found;
+                if (shard.remote) {
+                    if (!multiQuery) {
+                        embeddings.resize(1);
+                    }
+                    found = RagIndexClient::search(shard.path, embeddings, multiQuery ? queries : QStringList{queryText},
+                                                   searchLimit, m_minRelevance, searchOptions);
+                } else if (multiQuery) {
+                    found = RagUtils::findMostRelevantChunksBatch(shard.path, embeddings, searchLimit,
+                                                                  m_minRelevance, searchOptions, queries);
+                } else {
+                    found.push_back(RagUtils::findMostRelevantChunks(shard.path, embeddings.front(), searchLimit,
+                                                                     m_minRelevance, searchOptions));
+                }
+                for (std::size_t i = 0; i < found.size() && i < queryCount; ++i) {
+                    if (!shard.searching[i]) {
                         continue;
                     }
-                    query.prepare(QStringLiteral("SELECT file_path FROM source_files WHERE id = ?"));
-                    query.addBindValue(r.fileId);
-                    if (query.exec() && query.next()) {
-                        filePathById.insert(r.fileId, query.value(0).toString());
-                    } else if (query.lastError().isValid()) {
-                        CP_WARN << "RagQueryNode: Failed to resolve file_path for id" << r.fileId
-                                   << ":" << query.lastError().text();
+                    const QByteArray& key = shard.cacheKeys[static_cast<qsizetype>(i)];
+                    if (!key.isEmpty()) {
+                        resultCache.insert(key, found[i]);
                     }
+                    shard.results[i] = std::move(found[i]);
+                }
+            } catch (const std::exception& ex) {
+                shard.error = QStringLiteral("RAG search error: %1").arg(QString::fromUtf8(ex.what()));
+                if (federated) {
+                    shard.error += QStringLiteral(" (%1)").arg(shard.path);
                 }
-
-                db.close();
             }
-
-            if (dbOpened) {
-                QSqlDatabase::removeDatabase(connectionName);
+        });
+        for (const IndexShard& shard : shards) {
+            if (!shard.error.isEmpty()) {
+                CP_WARN << "RagQueryNode:" << shard.error;
+                return fail(shard.error);
             }
         }
 
-        // Format context string
-        QString contextText;
-        contextText.reserve(1024);
-
-        for (const auto& r : searchResults) {
-            QString sourceLabel;
-            if (filePathById.contains(r.fileId)) {
-                sourceLabel = filePathById.value(r.fileId);
-            } else {
-                sourceLabel = QStringLiteral("file_id=%1").arg(r.fileId);
+        // Each query's lists from the several indexes become one ranking
+        std::vector<std::vector<RagUtils::SearchResult>> searchResults(queryCount);
+        if (!federated) {
+            searchResults = std::move(shards.front().results);
+        } else {
+            std::vector<int> modelGroups;
+            for (const IndexShard& shard : shards) {
+                modelGroups.push_back(shard.group);
             }
-
-            const QString lineSuffix = (r.startLine > 0 && r.endLine > 0)
-                ? QStringLiteral(":%1-%2").arg(r.startLine).arg(r.endLine)
-                : QString();
-            const QString reference = QStringLiteral("%1%2").arg(sourceLabel, lineSuffix);
-            contextText += QStringLiteral("[Reference: %1 | Score: %2]\n")
-                               .arg(reference)
-                               .arg(r.score, 0, 'f', 4);
-            contextText += r.content;
-            contextText += QStringLiteral("\n\n");
-        }
-
-        QVariantList results;
-        for (const auto& r : searchResults) {
-            QString sourceLabel;
-            if (filePathById.contains(r.fileId)) {
-                sourceLabel = filePathById.value(r.fileId);
-            } else {
-                sourceLabel = QStringLiteral("file_id=%1").arg(r.fileId);
+            for (std::size_t i = 0; i < queryCount; ++i) {
+                std::vector<std::vector<RagUtils::SearchResult>> perShard;
+                for (IndexShard& shard : shards) {
+                    for (RagUtils::SearchResult& result : shard.results[i]) {
+                        result.indexPath = shard.path;
+                    }
+                    perShard.push_back(std::move(shard.results[i]));
+                }
+                searchResults[i] = RagUtils::mergeShardResults(std::move(perShard), modelGroups, searchLimit);
             }
+            output.insert(QStringLiteral("indexes_searched"), static_cast<int>(shards.size()));
+            output.insert(QStringLiteral("embedding_models"), static_cast<int>(groups.size()));
+        }
 
-            const QString lineSuffix = (r.startLine > 0 && r.endLine > 0)
-                ? QStringLiteral(":%1-%2").arg(r.startLine).arg(r.endLine)
-                : QString();
-            const QString reference = QStringLiteral("%1%2").arg(sourceLabel, lineSuffix);
-
-            QVariantMap item;
-            item.insert(QStringLiteral("source"), sourceLabel);
-            item.insert(QStringLiteral("reference"), reference);
-            item.insert(QStringLiteral("score"), r.score);
-            item.insert(QStringLiteral("text"), r.content);
-            item.insert(QStringLiteral("fragment_id"), r.fragmentId);
-            item.insert(QStringLiteral("file_id"), r.fileId);
-            item.insert(QStringLiteral("chunk_index"), r.chunkIndex);
-            if (r.startLine > 0) {
-                item.insert(QStringLiteral("start_line"), r.startLine);
-            }
-            if (r.endLine > 0) {
-                item.insert(QStringLiteral("end_line"), r.endLine);
+        // Each query's candidates are scored by the reranking model, the queries in parallel
+        if (rerank) {
+            std::vector<RerankResult> reranked(queryCount);
+            forEachConcurrently(queryCount, [&](std::size_t i) {
+                QStringList documents;
+                for (const RagUtils::SearchResult& result : searchResults[i]) {
+                    documents.append(result.content);
+                }
+                reranked[i] = Reranker::rerank(*rerankBackend, rerankProvider, rerankApiKey, rerankModel,
+                                               queries[static_cast<qsizetype>(i)], documents);
+            });
+            int rerankedCandidates = 0;
+            for (std::size_t i = 0; i < queryCount; ++i) {
+                if (reranked[i].hasError) {
+                    const QString msg = QStringLiteral("Reranking failure for provider '%1' model '%2': %3")
+                                            .arg(rerankProvider, rerankModel, reranked[i].errorMsg);
+                    CP_WARN << "RagQueryNode:" << msg;
+                    return fail(msg);
+                }
+                std::vector<RagUtils::SearchResult>& results = searchResults[i];
+                for (std::size_t r = 0; r < results.size(); ++r) {
+                    results[r].rerankScore = reranked[i].scores[r];
+                }
+                rerankedCandidates += static_cast<int>(results.size());
+                // Equal grades keep the retrieval order
+                std::stable_sort(results.begin(), results.end(),
+                                 [](const RagUtils::SearchResult& lhs, const RagUtils::SearchResult& rhs) {
+                                     return lhs.rerankScore > rhs.rerankScore;
+                                 });
+                if (results.size() > static_cast<std::size_t>(m_maxResults)) {
+                    results.resize(static_cast<std::size_t>(m_maxResults));
+                }
             }
-            results.append(item);
+            output.insert(QStringLiteral("reranked_candidates"), rerankedCandidates);
         }
 
-        output.insert(QString::fromLatin1(kOutputContext), contextText);
-        output.insert(QString::fromLatin1(kOutputResults), results);
+        if (!multiQuery) {
+            const QVariantList results = formatResults(searchResults.front());
+            output.insert(QString::fromLatin1(kOutputContext), formatContext(searchResults.front()));
+            output.insert(QString::fromLatin1(kOutputResults), results);
+            output.insert(QStringLiteral("_results_json"),
+                          QString::fromUtf8(QJsonDocument::fromVariant(results).toJson(QJsonDocument::Compact)));
+            return output;
+        }
+
+        // One context and one result list per query, in input order
+        QVariantList contexts;
+        QVariantList resultLists;
+        QString combinedContext;
+        for (std::size_t i = 0; i < searchResults.size(); ++i) {
+            const QString context = formatContext(searchResults[i]);
+            contexts.append(context);
+            resultLists.append(QVariant(formatResults(searchResults[i])));
+            combinedContext += QStringLiteral("[Query: %1]\n").arg(queries[static_cast<qsizetype>(i)]);
+            combinedContext += context;
+        }
+        output.insert(QString::fromLatin1(kOutputContexts), contexts);
+        output.insert(QString::fromLatin1(kOutputContext), combinedContext);
+        output.insert(QString::fromLatin1(kOutputResults), resultLists);
         output.insert(QStringLiteral("_results_json"),
-                      QString::fromUtf8(QJsonDocument::fromVariant(results).toJson(QJsonDocument::Compact)));
+                      QString::fromUtf8(QJsonDocument::fromVariant(resultLists).toJson(QJsonDocument::Compact)));
 
         return output;
     });
 }
 
+void RagQueryNode::warmUp()
+{
+    warmIndexes(true);
+}
+
+void RagQueryNode::warmIndexes(bool connectProviders)
+{
+    QStringList paths;
+    for (const QString& path : QStringList{m_databasePath} + m_additionalDatabasePaths) {
+        const bool remote = RagIndexClient::isRemote(path);
+        if (!path.isEmpty() && (remote ? connectProviders : QFileInfo(path).isFile())) {
+            paths.append(path);
+        }
+    }
+    if (connectProviders && !m_rerankProvider.isEmpty() && !m_rerankModel.isEmpty()) {
+        LLMProviderRegistry::instance().warmUpInBackground(m_rerankProvider, m_rerankModel);
+    }
+    if (paths.isEmpty()) {
+        return;
+    }
+    // Each index names the embedding model its queries go to; remote index configs come over
+    // the pooled connection the search will use, so that one is opened here as well
+    (void)QtConcurrent::run([paths, connectProviders]() {
+        QSet<QString> warmed;
+        for (const QString& path : paths) {
+            RagUtils::IndexConfig config;
+            try {
+                if (RagIndexClient::isRemote(path)) {
+                    config = RagIndexClient::indexConfig(path);
+                } else {
+                    RagUtils::warmIndex(path);
+                    if (!connectProviders) {
+                        continue;
+                    }
+                    config = RagUtils::getIndexConfig(path);
+                }
+            } catch (const std::exception&) {
+                continue; // execute() reports unreadable indexes
+            }
+            const QString key = config.providerId + u'/' + config.modelId;
+            if (config.providerId.isEmpty() || config.modelId.isEmpty() || warmed.contains(key)) {
+                continue;
+            }
+            warmed.insert(key);
+            LLMProviderRegistry::instance().warmUpInBackground(config.providerId, config.modelId);
+        }
+    });
+}
+
 QJsonObject RagQueryNode::saveState() const
 {
     QJsonObject obj;
     obj.insert(QStringLiteral("max_results"), m_maxResults);
     obj.insert(QStringLiteral("min_relevance"), m_minRelevance);
+    obj.insert(QStringLiteral("search_ef"), m_searchEf);
+    obj.insert(QStringLiteral("coarse_dimensions"), m_coarseDimensions);
+    obj.insert(QStringLiteral("search_mode"), m_searchMode);
+    obj.insert(QStringLiteral("filter"), m_filterExpression);
+    obj.insert(QStringLiteral("rerank_provider"), m_rerankProvider);
+    obj.insert(QStringLiteral("rerank_model"), m_rerankModel);
+    obj.insert(QStringLiteral("rerank_candidates"), m_rerankCandidates);
     obj.insert(QStringLiteral("database_path"), m_databasePath);
+    obj.insert(QStringLiteral("additional_database_paths"), QJsonArray::fromStringList(m_additionalDatabasePaths));
     obj.insert(QStringLiteral("query_text"), m_queryText);
     return obj;
 }
@@ -328,12 +768,42 @@ void RagQueryNode::loadState(const QJsonObject& data)
     if (data.contains(QStringLiteral("min_relevance"))) {
         m_minRelevance = data.value(QStringLiteral("min_relevance")).toDouble(m_minRelevance);
     }
+    if (data.contains(QStringLiteral("search_ef"))) {
+        setSearchEf(data.value(QStringLiteral("search_ef")).toInt(m_searchEf));
+    }
+    if (data.contains(QStringLiteral("coarse_dimensions"))) {
+        setCoarseDimensions(data.value(QStringLiteral("coarse_dimensions")).toInt(m_coarseDimensions));
+    }
+    if (data.contains(QStringLiteral("search_mode"))) {
+        setSearchMode(data.value(QStringLiteral("search_mode")).toString());
+    }
+    if (data.contains(QStringLiteral("filter"))) {
+        m_filterExpression = data.value(QStringLiteral("filter")).toString();
+    }
+    if (data.contains(QStringLiteral("rerank_provider"))) {
+        m_rerankProvider = data.value(QStringLiteral("rerank_provider")).toString();
+    }
+    if (data.contains(QStringLiteral("rerank_model"))) {
+        m_rerankModel = data.value(QStringLiteral("rerank_model")).toString();
+    }
+    if (data.contains(QStringLiteral("rerank_candidates"))) {
+        setRerankCandidates(data.value(QStringLiteral("rerank_candidates")).toInt(m_rerankCandidates));
+    }
     if (data.contains(QStringLiteral("database_path"))) {
         m_databasePath = data.value(QStringLiteral("database_path")).toString();
     }
+    if (data.contains(QStringLiteral("additional_database_paths"))) {
+        QStringList paths;
+        for (const QJsonValue& value : data.value(QStringLiteral("additional_database_paths")).toArray()) {
+            paths.append(value.toString());
+        }
+        setAdditionalDatabasePaths(paths);
+    }
     if (data.contains(QStringLiteral("query_text"))) {
         m_queryText = data.value(QStringLiteral("query_text")).toString();
     }
+    // A loaded pipeline's indexes are ready before it first runs; providers wait for the run
+    warmIndexes(false);
 }
 
 void RagQueryNode::setMaxResults(int value)
@@ -356,11 +826,66 @@ void RagQueryNode::setMinRelevance(double value)
     m_minRelevance = value;
 }
 
+void RagQueryNode::setSearchEf(int value)
+{
+    m_searchEf = qBound(0, value, 2000);
+}
+
+void RagQueryNode::setCoarseDimensions(int value)
+{
+    m_coarseDimensions = qBound(0, value, 8192);
+}
+
+void RagQueryNode::setSearchMode(const QString& mode)
+{
+    switch (searchModeFromName(mode.trimmed().toLower())) {
+    case RagSearchMode::Hybrid:
+        m_searchMode = QStringLiteral("hybrid");
+        break;
+    case RagSearchMode::KeywordPrefilter:
+        m_searchMode = QStringLiteral("keyword_prefilter");
+        break;
+    case RagSearchMode::Vector:
+        m_searchMode = QStringLiteral("vector");
+        break;
+    }
+}
+
+void RagQueryNode::setFilterExpression(const QString& expression)
+{
+    m_filterExpression = expression;
+}
+
+void RagQueryNode::setRerankProvider(const QString& providerId)
+{
+    m_rerankProvider = providerId;
+}
+
+void RagQueryNode::setRerankModel(const QString& modelId)
+{
+    m_rerankModel = modelId;
+}
+
+void RagQueryNode::setRerankCandidates(int value)
+{
+    m_rerankCandidates = qBound(1, value, 200);
+}
+
 void RagQueryNode::setDatabasePath(const QString& path)
 {
     m_databasePath = path;
 }
 
+void RagQueryNode::setAdditionalDatabasePaths(const QStringList& paths)
+{
+    m_additionalDatabasePaths.clear();
+    for (const QString& path : paths) {
+        if (!path.trimmed().isEmpty()) {
+            m_additionalDatabasePaths.append(path.trimmed());
+        }
+    }
+}
+
 void RagQueryNode::setQueryText(const QString& text)
 {
     m_queryText = text;
@@ -25,12 +25,15 @@
 #pragma once
 
 #include <QObject>
-#include <QWidget>
 #include <QFuture>
 #include <QString>
+#include <QStringList>
 
 #include "IToolNode.h"
 #include "CommonDataTypes.h"
+#include "retrieval/storage/RagUtils.h"
+
+class QWidget;
 
 /**
  * @brief Node that performs semantic retrieval from a RAG index.
@@ -38,6 +41,13 @@
  * This node accepts a natural-language query, opens the configured database
  * path, discovers the embedding model used for the index, generates a query
  * embedding via the appropriate backend, and returns the most relevant chunks.
+ * Additional database paths are searched together with the first: indexes
+ * built with the same model share one query embedding, all of them are
+ * searched in parallel, and their results are merged into one top-k list
+ * (RagUtils::mergeShardResults()). With a reranking provider and model set,
+ * the search returns rerankCandidates() matches, the reranking model grades
+ * them against the query (Reranker), and the best maxResults are kept in
+ * that order.
  */
 class RagQueryNode : public QObject, public IToolNode {
     Q_OBJECT
@@ -49,37 +59,83 @@ public:
 
     // IToolNode interface (V3 tokens API)
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in RagQueryPropertiesWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     TokenList execute(const TokenList& incomingTokens) override;
+    ResourceClass resourceClass() const override { return ResourceClass::Network; }
+    bool supportsAsyncExecution() const override { return true; }
+    QFuture<TokenList> executeAsync(const TokenList& incomingTokens) override;
+    // Loads the configured local indexes in the background (RagUtils::warmIndex)
+    void warmUp() override;
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
 
     // Port IDs
     static constexpr const char* kInputQuery = "query";
+    // A list of queries, answered together; the outputs then hold one entry per query
+    static constexpr const char* kInputQueries = "queries";
+    // Search filter expression (RagUtils::parseSearchFilter); overrides the property when set
+    static constexpr const char* kInputFilter = "filter";
     // Legacy packet key: retained so older flows/tests can still override the
-    // property path, but no visible database input pin is exposed.
+    // property path, but no visible database input pin is exposed. A list of
+    // paths replaces the primary and additional databases.
     static constexpr const char* kInputDbPath = "database";
     static constexpr const char* kOutputContext = "context";
+    static constexpr const char* kOutputContexts = "contexts";
     static constexpr const char* kOutputResults = "results";
 
     // Property accessors (used by tests and potential UI bindings)
     QString databasePath() const { return m_databasePath; }
+    QStringList additionalDatabasePaths() const { return m_additionalDatabasePaths; }
     QString queryText() const { return m_queryText; }
+    int searchEf() const { return m_searchEf; }
+    int coarseDimensions() const { return m_coarseDimensions; }
+    /// "vector", "hybrid" or "keyword_prefilter" (RagSearchMode)
+    QString searchMode() const { return m_searchMode; }
+    QString filterExpression() const { return m_filterExpression; }
+    QString rerankProvider() const { return m_rerankProvider; }
+    QString rerankModel() const { return m_rerankModel; }
+    int rerankCandidates() const { return m_rerankCandidates; }
 
 public slots:
     void setMaxResults(int value);
     void setMinRelevance(double value);
+    void setSearchEf(int value);
+    void setCoarseDimensions(int value);
+    void setSearchMode(const QString& mode);
+    void setFilterExpression(const QString& expression);
+    void setRerankProvider(const QString& providerId);
+    void setRerankModel(const QString& modelId);
+    void setRerankCandidates(int value);
     void setDatabasePath(const QString& path);
+    void setAdditionalDatabasePaths(const QStringList& paths);
     void setQueryText(const QString& text);
 
 private:
     // Legacy async helper preserved to reuse existing QtConcurrent-based
-    // implementation. The public execute(TokenList&) wrapper calls this
-    // and adapts the result to the V3 token API.
+    // implementation. executeAsync(TokenList&) chains onto this and adapts
+    // the result to the V3 token API.
     QFuture<DataPacket> Execute(const DataPacket& inputs);
+    // Warms the local indexes on a pool thread; with connectProviders also remote index
+    // servers and the embedding and rerank providers the queries will call
+    void warmIndexes(bool connectProviders);
 
     int m_maxResults {5};
     double m_minRelevance {0.5};
+    // HNSW candidate list size when the database has an ANN sidecar; 0 scans every fragment
+    int m_searchEf {RagSearchOptions{}.ef};
+    // Leading dimensions an exact scan scores before re-scoring its best candidates; 0 scores full vectors
+    int m_coarseDimensions {0};
+    QString m_searchMode {QStringLiteral("vector")};
+    // e.g. "path:/repo/src type:cpp,h tag:backend"; empty searches the whole index
+    QString m_filterExpression;
+    // Reranking stage; off while either is empty
+    QString m_rerankProvider;
+    QString m_rerankModel;
+    // Matches retrieved for the reranking model to grade, of which m_maxResults are kept
+    int m_rerankCandidates {30};
     QString m_databasePath;
+    // Further indexes searched with m_databasePath, e.g. one per project shard
+    QStringList m_additionalDatabasePaths;
     QString m_queryText;
 };
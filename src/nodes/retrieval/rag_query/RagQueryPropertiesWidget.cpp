@@ -23,6 +23,9 @@
 //
 
 #include "RagQueryPropertiesWidget.h"
+#include "RagQueryNode.h"
+#include "retrieval/storage/RagUtils.h"
+#include "ai/catalog/ModelCatalogService.h"
 
 #include <QFormLayout>
 #include <QVBoxLayout>
@@ -54,6 +57,19 @@ RagQueryPropertiesWidget::RagQueryPropertiesWidget(QWidget* parent)
     dbLayout->addWidget(m_browseDatabaseBtn);
     formLayout->addRow(tr("RAG Database:"), dbLayout);
 
+    // Further databases searched together with the first, one per line
+    m_additionalDatabasesEdit = new QPlainTextEdit(this);
+    m_additionalDatabasesEdit->setPlaceholderText(tr("One index path per line"));
+    m_additionalDatabasesEdit->setToolTip(tr("Indexes searched together with the RAG Database, e.g. one per project. "
+                                             "They are searched in parallel and their best matches merged; indexes "
+                                             "built with different models are ranked against each other by rank."));
+    m_additionalDatabasesEdit->setMaximumHeight(72);
+    m_addDatabaseBtn = new QPushButton(QStringLiteral("Add..."), this);
+    auto* additionalLayout = new QHBoxLayout();
+    additionalLayout->addWidget(m_additionalDatabasesEdit);
+    additionalLayout->addWidget(m_addDatabaseBtn, 0, Qt::AlignTop);
+    formLayout->addRow(tr("Additional Databases:"), additionalLayout);
+
     // Default query (multi-line)
     m_queryEdit = new QPlainTextEdit(this);
     m_queryEdit->setPlaceholderText(tr("Enter default query text"));
@@ -70,8 +86,64 @@ RagQueryPropertiesWidget::RagQueryPropertiesWidget(QWidget* parent)
     m_minRelevanceSpinBox->setDecimals(2);
     m_minRelevanceSpinBox->setValue(0.5);
 
+    m_searchEfSpinBox = new QSpinBox(this);
+    m_searchEfSpinBox->setRange(0, 2000);
+    m_searchEfSpinBox->setSingleStep(32);
+    m_searchEfSpinBox->setValue(RagSearchOptions{}.ef);
+    m_searchEfSpinBox->setSpecialValueText(tr("Exact"));
+    m_searchEfSpinBox->setToolTip(tr("Candidates examined in the ANN (HNSW) index, when the indexer built one. "
+                                     "Higher values are slower but closer to an exact search; Exact always scans every fragment."));
+
+    m_coarseDimensionsSpinBox = new QSpinBox(this);
+    m_coarseDimensionsSpinBox->setRange(0, 8192);
+    m_coarseDimensionsSpinBox->setSingleStep(64);
+    m_coarseDimensionsSpinBox->setValue(0);
+    m_coarseDimensionsSpinBox->setSpecialValueText(tr("Off"));
+    m_coarseDimensionsSpinBox->setToolTip(tr("Scans only the first dimensions of each embedding, then re-ranks the best "
+                                             "candidates in full. For Matryoshka models such as text-embedding-3: "
+                                             "256 of 3072 dimensions is a twelfth of the work."));
+
+    m_searchModeCombo = new QComboBox(this);
+    m_searchModeCombo->addItem(tr("Vector"), QStringLiteral("vector"));
+    m_searchModeCombo->addItem(tr("Hybrid (vector + keyword)"), QStringLiteral("hybrid"));
+    m_searchModeCombo->addItem(tr("Keyword prefilter"), QStringLiteral("keyword_prefilter"));
+    m_searchModeCombo->setToolTip(tr("Hybrid fuses the vector ranking with a BM25 keyword ranking, which finds exact "
+                                     "identifiers and rare terms. Keyword prefilter scores vectors only for keyword "
+                                     "matches. Both need the indexer's full-text index and fall back to Vector without it."));
+
+    m_filterEdit = new QLineEdit(this);
+    m_filterEdit->setPlaceholderText(tr("path:/repo/src type:cpp,h tag:backend"));
+    m_filterEdit->setToolTip(tr("Searches only files that match every term: path: prefix, type: extensions, "
+                                "tag: from the indexed metadata's \"tags\", or key=value for another metadata field. "
+                                "A connected Filter input takes precedence."));
+
+    m_rerankProviderCombo = new QComboBox(this);
+    m_rerankProviderCombo->addItem(tr("Off"), QString());
+    for (const ProviderCatalogEntry& provider : ModelCatalogService::instance().providers(ModelCatalogKind::Chat)) {
+        m_rerankProviderCombo->addItem(provider.name, provider.id);
+    }
+    m_rerankProviderCombo->setToolTip(tr("Provider of a model that re-orders the retrieved matches by how well they "
+                                         "answer the query. Fewer, better matches keep prompts small."));
+
+    m_rerankModelEdit = new QLineEdit(this);
+    m_rerankModelEdit->setPlaceholderText(tr("e.g. a small local chat model"));
+    m_rerankModelEdit->setToolTip(tr("Models with the rerank capability use the provider's rerank endpoint. "
+                                     "Any other model grades the matches in a prompt."));
+
+    m_rerankCandidatesSpinBox = new QSpinBox(this);
+    m_rerankCandidatesSpinBox->setRange(1, 200);
+    m_rerankCandidatesSpinBox->setValue(30);
+    m_rerankCandidatesSpinBox->setToolTip(tr("Matches retrieved for the reranker to grade. Max Results of them are kept."));
+
     formLayout->addRow(tr("Max Results"), m_maxResultsSpinBox);
     formLayout->addRow(tr("Min Relevance"), m_minRelevanceSpinBox);
+    formLayout->addRow(tr("Search Recall (ef)"), m_searchEfSpinBox);
+    formLayout->addRow(tr("Coarse Dimensions"), m_coarseDimensionsSpinBox);
+    formLayout->addRow(tr("Search Mode"), m_searchModeCombo);
+    formLayout->addRow(tr("Filter"), m_filterEdit);
+    formLayout->addRow(tr("Rerank Provider"), m_rerankProviderCombo);
+    formLayout->addRow(tr("Rerank Model"), m_rerankModelEdit);
+    formLayout->addRow(tr("Rerank Candidates"), m_rerankCandidatesSpinBox);
 
     mainLayout->addLayout(formLayout);
     mainLayout->addStretch();
@@ -80,12 +152,33 @@ RagQueryPropertiesWidget::RagQueryPropertiesWidget(QWidget* parent)
             this, &RagQueryPropertiesWidget::maxResultsChanged);
     connect(m_minRelevanceSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
             this, &RagQueryPropertiesWidget::minRelevanceChanged);
+    connect(m_searchEfSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &RagQueryPropertiesWidget::searchEfChanged);
+    connect(m_coarseDimensionsSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &RagQueryPropertiesWidget::coarseDimensionsChanged);
+    connect(m_searchModeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this]() {
+        emit searchModeChanged(searchMode());
+    });
+    connect(m_filterEdit, &QLineEdit::textChanged,
+            this, &RagQueryPropertiesWidget::filterExpressionChanged);
+    connect(m_rerankProviderCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this]() {
+        emit rerankProviderChanged(rerankProvider());
+    });
+    connect(m_rerankModelEdit, &QLineEdit::textChanged,
+            this, &RagQueryPropertiesWidget::rerankModelChanged);
+    connect(m_rerankCandidatesSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &RagQueryPropertiesWidget::rerankCandidatesChanged);
 
     // New controls wiring
     connect(m_databaseEdit, &QLineEdit::textChanged,
             this, &RagQueryPropertiesWidget::databasePathChanged);
     connect(m_browseDatabaseBtn, &QPushButton::clicked,
             this, &RagQueryPropertiesWidget::onBrowseDatabase);
+    connect(m_additionalDatabasesEdit, &QPlainTextEdit::textChanged, this, [this]() {
+        emit additionalDatabasePathsChanged(additionalDatabasePaths());
+    });
+    connect(m_addDatabaseBtn, &QPushButton::clicked,
+            this, &RagQueryPropertiesWidget::onAddDatabase);
     connect(m_helpButton, &QPushButton::clicked,
             this, &RagQueryPropertiesWidget::onHelpClicked);
 
@@ -104,11 +197,60 @@ double RagQueryPropertiesWidget::minRelevance() const
     return m_minRelevanceSpinBox ? m_minRelevanceSpinBox->value() : 0.5;
 }
 
+int RagQueryPropertiesWidget::searchEf() const
+{
+    return m_searchEfSpinBox ? m_searchEfSpinBox->value() : RagSearchOptions{}.ef;
+}
+
+int RagQueryPropertiesWidget::coarseDimensions() const
+{
+    return m_coarseDimensionsSpinBox ? m_coarseDimensionsSpinBox->value() : 0;
+}
+
+QString RagQueryPropertiesWidget::searchMode() const
+{
+    return m_searchModeCombo ? m_searchModeCombo->currentData().toString() : QStringLiteral("vector");
+}
+
+QString RagQueryPropertiesWidget::filterExpression() const
+{
+    return m_filterEdit ? m_filterEdit->text() : QString();
+}
+
+QString RagQueryPropertiesWidget::rerankProvider() const
+{
+    return m_rerankProviderCombo ? m_rerankProviderCombo->currentData().toString() : QString();
+}
+
+QString RagQueryPropertiesWidget::rerankModel() const
+{
+    return m_rerankModelEdit ? m_rerankModelEdit->text() : QString();
+}
+
+int RagQueryPropertiesWidget::rerankCandidates() const
+{
+    return m_rerankCandidatesSpinBox ? m_rerankCandidatesSpinBox->value() : 30;
+}
+
 QString RagQueryPropertiesWidget::databasePath() const
 {
     return m_databaseEdit ? m_databaseEdit->text() : QString();
 }
 
+QStringList RagQueryPropertiesWidget::additionalDatabasePaths() const
+{
+    QStringList paths;
+    if (!m_additionalDatabasesEdit) {
+        return paths;
+    }
+    for (const QString& line : m_additionalDatabasesEdit->toPlainText().split(QLatin1Char('\n'))) {
+        if (!line.trimmed().isEmpty()) {
+            paths.append(line.trimmed());
+        }
+    }
+    return paths;
+}
+
 QString RagQueryPropertiesWidget::queryText() const
 {
     return m_queryEdit ? m_queryEdit->toPlainText() : QString();
@@ -128,6 +270,72 @@ void RagQueryPropertiesWidget::setMinRelevance(double value)
     }
 }
 
+void RagQueryPropertiesWidget::setSearchEf(int value)
+{
+    if (m_searchEfSpinBox && m_searchEfSpinBox->value() != value) {
+        m_searchEfSpinBox->setValue(value);
+    }
+}
+
+void RagQueryPropertiesWidget::setCoarseDimensions(int value)
+{
+    if (m_coarseDimensionsSpinBox && m_coarseDimensionsSpinBox->value() != value) {
+        m_coarseDimensionsSpinBox->setValue(value);
+    }
+}
+
+void RagQueryPropertiesWidget::setSearchMode(const QString& mode)
+{
+    if (!m_searchModeCombo) {
+        return;
+    }
+    const int index = m_searchModeCombo->findData(mode);
+    if (index >= 0 && m_searchModeCombo->currentIndex() != index) {
+        const QSignalBlocker blocker(m_searchModeCombo);
+        m_searchModeCombo->setCurrentIndex(index);
+    }
+}
+
+void RagQueryPropertiesWidget::setFilterExpression(const QString& expression)
+{
+    if (m_filterEdit && m_filterEdit->text() != expression) {
+        const QSignalBlocker blocker(m_filterEdit);
+        m_filterEdit->setText(expression);
+    }
+}
+
+void RagQueryPropertiesWidget::setRerankProvider(const QString& providerId)
+{
+    if (!m_rerankProviderCombo) {
+        return;
+    }
+    // A provider missing from the catalog is kept selectable so the setting survives
+    int index = m_rerankProviderCombo->findData(providerId);
+    if (index < 0) {
+        m_rerankProviderCombo->addItem(providerId, providerId);
+        index = m_rerankProviderCombo->count() - 1;
+    }
+    if (m_rerankProviderCombo->currentIndex() != index) {
+        const QSignalBlocker blocker(m_rerankProviderCombo);
+        m_rerankProviderCombo->setCurrentIndex(index);
+    }
+}
+
+void RagQueryPropertiesWidget::setRerankModel(const QString& modelId)
+{
+    if (m_rerankModelEdit && m_rerankModelEdit->text() != modelId) {
+        const QSignalBlocker blocker(m_rerankModelEdit);
+        m_rerankModelEdit->setText(modelId);
+    }
+}
+
+void RagQueryPropertiesWidget::setRerankCandidates(int value)
+{
+    if (m_rerankCandidatesSpinBox && m_rerankCandidatesSpinBox->value() != value) {
+        m_rerankCandidatesSpinBox->setValue(value);
+    }
+}
+
 void RagQueryPropertiesWidget::setDatabasePath(const QString& path)
 {
     if (!m_databaseEdit) {
@@ -139,6 +347,17 @@ void RagQueryPropertiesWidget::setDatabasePath(const QString& path)
     }
 }
 
+void RagQueryPropertiesWidget::setAdditionalDatabasePaths(const QStringList& paths)
+{
+    if (!m_additionalDatabasesEdit) {
+        return;
+    }
+    if (additionalDatabasePaths() != paths) {
+        const QSignalBlocker blocker(m_additionalDatabasesEdit);
+        m_additionalDatabasesEdit->setPlainText(paths.join(QLatin1Char('\n')));
+    }
+}
+
 void RagQueryPropertiesWidget::setQueryText(const QString& text)
 {
     if (!m_queryEdit) {
@@ -165,6 +384,23 @@ void RagQueryPropertiesWidget::onBrowseDatabase()
     }
 }
 
+void RagQueryPropertiesWidget::onAddDatabase()
+{
+    const QString fileName = QFileDialog::getOpenFileName(
+        this,
+        tr("Add Database File"),
+        databasePath(),
+        QStringLiteral("SQLite Databases (*.db *.sqlite);;All Files (*)"));
+
+    if (!fileName.isEmpty() && m_additionalDatabasesEdit) {
+        QStringList paths = additionalDatabasePaths();
+        if (!paths.contains(fileName)) {
+            paths.append(fileName);
+            m_additionalDatabasesEdit->setPlainText(paths.join(QLatin1Char('\n')));
+        }
+    }
+}
+
 void RagQueryPropertiesWidget::onHelpClicked()
 {
     QMessageBox::information(
@@ -174,7 +410,54 @@ void RagQueryPropertiesWidget::onHelpClicked()
            "1. Open a database created by the RAG Indexer.\n"
            "2. Enter a default query here or connect text to the Query input pin.\n"
            "3. Max Results limits the number of returned matches.\n"
-           "4. Min Relevance filters low-scoring matches.\n\n"
+           "4. Min Relevance filters low-scoring matches.\n"
+           "5. Search Mode Hybrid adds a keyword (BM25) ranking, which helps with exact names and identifiers.\n"
+           "6. Filter limits the search to matching files, e.g. path:/repo/src type:cpp,h tag:backend.\n"
+           "7. Additional Databases are searched together with the first, and their best matches merged.\n"
+           "8. A Rerank Provider and Model grade Rerank Candidates matches and keep the best Max Results.\n\n"
            "The Context output includes each match as a reference with source file and line range. "
            "The Results JSON also includes source, reference, start_line, and end_line fields."));
 }
+
+QWidget* RagQueryNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* widget = new RagQueryPropertiesWidget(parent);
+    widget->setMaxResults(m_maxResults);
+    widget->setMinRelevance(m_minRelevance);
+    widget->setSearchEf(m_searchEf);
+    widget->setCoarseDimensions(m_coarseDimensions);
+    widget->setSearchMode(m_searchMode);
+    widget->setFilterExpression(m_filterExpression);
+    widget->setRerankProvider(m_rerankProvider);
+    widget->setRerankModel(m_rerankModel);
+    widget->setRerankCandidates(m_rerankCandidates);
+    widget->setDatabasePath(m_databasePath);
+    widget->setAdditionalDatabasePaths(m_additionalDatabasePaths);
+    widget->setQueryText(m_queryText);
+
+    QObject::connect(widget, &RagQueryPropertiesWidget::maxResultsChanged,
+                     this, &RagQueryNode::setMaxResults);
+    QObject::connect(widget, &RagQueryPropertiesWidget::minRelevanceChanged,
+                     this, &RagQueryNode::setMinRelevance);
+    QObject::connect(widget, &RagQueryPropertiesWidget::searchEfChanged,
+                     this, &RagQueryNode::setSearchEf);
+    QObject::connect(widget, &RagQueryPropertiesWidget::coarseDimensionsChanged,
+                     this, &RagQueryNode::setCoarseDimensions);
+    QObject::connect(widget, &RagQueryPropertiesWidget::searchModeChanged,
+                     this, &RagQueryNode::setSearchMode);
+    QObject::connect(widget, &RagQueryPropertiesWidget::filterExpressionChanged,
+                     this, &RagQueryNode::setFilterExpression);
+    QObject::connect(widget, &RagQueryPropertiesWidget::rerankProviderChanged,
+                     this, &RagQueryNode::setRerankProvider);
+    QObject::connect(widget, &RagQueryPropertiesWidget::rerankModelChanged,
+                     this, &RagQueryNode::setRerankModel);
+    QObject::connect(widget, &RagQueryPropertiesWidget::rerankCandidatesChanged,
+                     this, &RagQueryNode::setRerankCandidates);
+    QObject::connect(widget, &RagQueryPropertiesWidget::databasePathChanged,
+                     this, &RagQueryNode::setDatabasePath);
+    QObject::connect(widget, &RagQueryPropertiesWidget::additionalDatabasePathsChanged,
+                     this, &RagQueryNode::setAdditionalDatabasePaths);
+    QObject::connect(widget, &RagQueryPropertiesWidget::queryTextChanged,
+                     this, &RagQueryNode::setQueryText);
+    return widget;
+}
@@ -29,6 +29,8 @@
 #include <QDoubleSpinBox>
 #include <QLineEdit>
 #include <QPushButton>
+#include <QComboBox>
+#include <QStringList>
 
 class QPlainTextEdit;
 
@@ -37,9 +39,16 @@ class QPlainTextEdit;
  *
  * Exposes controls for:
  * - Database file path (with browse button)
+ * - Additional databases searched with it, one path per line
  * - Default query text (multi-line)
  * - Max Results: integer in [1, 50], default 5
  * - Min Relevance: double in [0.0, 1.0], default 0.5
+ * - Search Recall (ef): HNSW candidates in [0, 2000], 0 = exact scan
+ * - Coarse Dimensions: prefix scored before full rescoring in [0, 8192], 0 = off
+ * - Search Mode: vector, hybrid (vector + BM25) or keyword prefilter
+ * - Filter: path:, type:, tag: and key=value terms restricting the search
+ * - Rerank Provider / Model: optional reranking stage, off by default
+ * - Rerank Candidates: matches graded by the reranker in [1, 200], default 30
  */
 class RagQueryPropertiesWidget : public QWidget {
     Q_OBJECT
@@ -48,30 +57,64 @@ public:
     ~RagQueryPropertiesWidget() override = default;
     int maxResults() const;
     double minRelevance() const;
+    int searchEf() const;
+    int coarseDimensions() const;
+    QString searchMode() const;
+    QString filterExpression() const;
+    QString rerankProvider() const;
+    QString rerankModel() const;
+    int rerankCandidates() const;
     QString databasePath() const;
+    QStringList additionalDatabasePaths() const;
     QString queryText() const;
 
 public slots:
     void setMaxResults(int value);
     void setMinRelevance(double value);
+    void setSearchEf(int value);
+    void setCoarseDimensions(int value);
+    void setSearchMode(const QString& mode);
+    void setFilterExpression(const QString& expression);
+    void setRerankProvider(const QString& providerId);
+    void setRerankModel(const QString& modelId);
+    void setRerankCandidates(int value);
     void setDatabasePath(const QString& path);
+    void setAdditionalDatabasePaths(const QStringList& paths);
     void setQueryText(const QString& text);
 
 signals:
     void maxResultsChanged(int value);
     void minRelevanceChanged(double value);
+    void searchEfChanged(int value);
+    void coarseDimensionsChanged(int value);
+    void searchModeChanged(const QString& mode);
+    void filterExpressionChanged(const QString& expression);
+    void rerankProviderChanged(const QString& providerId);
+    void rerankModelChanged(const QString& modelId);
+    void rerankCandidatesChanged(int value);
     void databasePathChanged(const QString& path);
+    void additionalDatabasePathsChanged(const QStringList& paths);
     void queryTextChanged(const QString& text);
 
 private:
     QSpinBox* m_maxResultsSpinBox {nullptr};
     QDoubleSpinBox* m_minRelevanceSpinBox {nullptr};
+    QSpinBox* m_searchEfSpinBox {nullptr};
+    QSpinBox* m_coarseDimensionsSpinBox {nullptr};
+    QComboBox* m_searchModeCombo {nullptr};
+    QLineEdit* m_filterEdit {nullptr};
+    QComboBox* m_rerankProviderCombo {nullptr};
+    QLineEdit* m_rerankModelEdit {nullptr};
+    QSpinBox* m_rerankCandidatesSpinBox {nullptr};
     QLineEdit* m_databaseEdit {nullptr};
     QPushButton* m_browseDatabaseBtn {nullptr};
+    QPlainTextEdit* m_additionalDatabasesEdit {nullptr};
+    QPushButton* m_addDatabaseBtn {nullptr};
     QPushButton* m_helpButton {nullptr};
     QPlainTextEdit* m_queryEdit {nullptr};
 
 private slots:
     void onBrowseDatabase();
+    void onAddDatabase();
     void onHelpClicked();
 };
@@ -5,16 +5,27 @@
 //
 
 #include "UniversalScriptNode.h"
-#include "UniversalScriptPropertiesWidget.h"
 #include "IScriptHost.h"
 #include "ExecutionScriptHost.h"
 #include "ExecutionToken.h"
+#include "CancellationToken.h"
+#include "CpuWorkerPool.h"
+#include "NodeOutputDir.h"
 
+#include <QDir>
+#include <QFile>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QJsonDocument>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QWaitCondition>
 #include "Logger.h"
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <vector>
 
 namespace {
 QStringList pinsFromJsonValue(const QJsonValue& value)
@@ -34,6 +45,139 @@ QStringList pinsFromJsonValue(const QJsonValue& value)
     return pins;
 }
 
+// Frames listed in the properties panel after a profiled run
+constexpr int kProfileSummaryFrames = 8;
+
+// Self time per innermost frame, hottest first
+QString profileSummary(const ScriptProfile& profile, const QString& path)
+{
+    QHash<QString, qint64> selfTimes;
+    for (auto it = profile.stacks.cbegin(); it != profile.stacks.cend(); ++it) {
+        selfTimes[it.key().section(QLatin1Char(';'), -1)] += it.value();
+    }
+    QList<QPair<QString, qint64>> frames;
+    for (auto it = selfTimes.cbegin(); it != selfTimes.cend(); ++it) {
+        frames.append({it.key(), it.value()});
+    }
+    std::sort(frames.begin(), frames.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+
+    const qint64 total = std::max<qint64>(1, profile.totalMicros());
+    QStringList lines;
+    lines << QStringLiteral("Profiled %1 ms").arg(profile.totalMicros() / 1000.0, 0, 'f', 1);
+    for (qsizetype i = 0; i < frames.size() && i < kProfileSummaryFrames; ++i) {
+        lines << QStringLiteral("%1 ms %2%  %3")
+                     .arg(frames.at(i).second / 1000.0, 8, 'f', 1)
+                     .arg(100 * frames.at(i).second / total, 3)
+                     .arg(frames.at(i).first);
+    }
+    if (!path.isEmpty()) {
+        lines << QStringLiteral("Flame graph input: %1").arg(QDir::toNativeSeparators(path));
+    }
+    return lines.join(QLatin1Char('\n'));
+}
+
+// Items a map participant claims at a time, so threads don't contend per item
+constexpr qsizetype kMapBatchSize = 32;
+
+// One script run per list item, shared out across the Cpu pool. Each thread
+// makes its own engine, which for QuickJS means the thread's runtime and the
+// shared bytecode cache, so the script is compiled once for all items.
+class MapJob : public std::enable_shared_from_this<MapJob> {
+public:
+    MapJob(const QString& engineId, const QString& script, const ScriptLimits& limits, bool profiling,
+           const DataPacket& input, const QString& pin, const QVariantList& items)
+        : outputs(static_cast<std::size_t>(items.size()))
+        , succeeded(static_cast<std::size_t>(items.size()), 0)
+        , m_engineId(engineId)
+        , m_script(script)
+        , m_limits(limits)
+        , m_profiling(profiling)
+        , m_input(input)
+        , m_pin(pin)
+        , m_items(items)
+        , m_cancellation(CancellationToken::current())
+    {
+    }
+
+    void run(QThreadPool* pool)
+    {
+        const qsizetype batches = (m_items.size() + kMapBatchSize - 1) / kMapBatchSize;
+        const qsizetype participants = std::min<qsizetype>(std::max(1, pool->maxThreadCount()), batches);
+        for (qsizetype i = 1; i < participants; ++i) {
+            pool->start([self = shared_from_this()]() {
+                CancellationToken::Scope cancellation(self->m_cancellation);
+                self->participate();
+            });
+        }
+        participate();
+
+        QMutexLocker locker(&m_mutex);
+        while (m_active > 0) {
+            m_finished.wait(&m_mutex);
+        }
+    }
+
+    std::vector<DataPacket> outputs;
+    std::vector<char> succeeded;
+    // All items' profiles added together; complete once run() returns
+    ScriptProfile profile;
+
+private:
+    void participate()
+    {
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_next.load() >= m_items.size()) {
+                return;
+            }
+            ++m_active;
+        }
+
+        std::unique_ptr<IScriptEngine> engine = ScriptEngineRegistry::instance().createEngine(m_engineId);
+        if (engine) {
+            engine->setLimits(m_limits);
+            engine->setProfiling(m_profiling);
+        }
+        ScriptProfile participantProfile;
+        for (qsizetype begin = m_next.fetch_add(kMapBatchSize); engine && begin < m_items.size();
+             begin = m_next.fetch_add(kMapBatchSize)) {
+            const qsizetype end = std::min(begin + kMapBatchSize, m_items.size());
+            for (qsizetype i = begin; i < end && !m_cancellation.isCancelled(); ++i) {
+                DataPacket input = m_input;
+                input.insert(m_pin, m_items.at(i));
+                input.insert(QStringLiteral("_index"), i);
+                DataPacket& output = outputs[static_cast<std::size_t>(i)];
+                QList<QString> logs;
+                ExecutionScriptHost host(input, output, logs);
+                succeeded[static_cast<std::size_t>(i)] = engine->execute(m_script, &host);
+                if (m_profiling) {
+                    participantProfile.merge(engine->takeProfile());
+                }
+            }
+        }
+
+        QMutexLocker locker(&m_mutex);
+        profile.merge(participantProfile);
+        if (--m_active == 0) {
+            m_finished.wakeAll();
+        }
+    }
+
+    const QString m_engineId;
+    const QString m_script;
+    const ScriptLimits m_limits;
+    const bool m_profiling;
+    const DataPacket m_input;
+    const QString m_pin;
+    const QVariantList m_items;
+    const CancellationToken m_cancellation;
+    std::atomic<qsizetype> m_next {0};
+
+    QMutex m_mutex;
+    QWaitCondition m_finished;
+    int m_active {0};
+};
+
 QJsonArray pinsToJsonArray(const QStringList& pins)
 {
     QJsonArray arr;
@@ -66,51 +210,26 @@ NodeDescriptor UniversalScriptNode::getDescriptor() const
     return desc;
 }
 
-QWidget* UniversalScriptNode::createConfigurationWidget(QWidget* parent)
-{
-    auto* widget = new UniversalScriptPropertiesWidget(parent);
-    widget->setScript(m_scriptCode);
-    widget->setEngineId(m_engineId);
-    widget->setFanOut(m_enableFanOut);
-    widget->setSyntaxHighlighting(m_enableSyntaxHighlighting);
-    widget->setInputPins(m_inputPins);
-    widget->setOutputPins(m_outputPins);
-
-    connect(widget, &UniversalScriptPropertiesWidget::scriptChanged, this, &UniversalScriptNode::onScriptChanged);
-    connect(widget, &UniversalScriptPropertiesWidget::engineChanged, this, &UniversalScriptNode::onEngineChanged);
-    connect(widget, &UniversalScriptPropertiesWidget::fanOutChanged, this, &UniversalScriptNode::onFanOutChanged);
-    connect(widget, &UniversalScriptPropertiesWidget::syntaxHighlightingChanged, this, &UniversalScriptNode::onSyntaxHighlightingChanged);
-    connect(widget, &UniversalScriptPropertiesWidget::inputPinsChanged, this, &UniversalScriptNode::onInputPinsChanged);
-    connect(widget, &UniversalScriptPropertiesWidget::outputPinsChanged, this, &UniversalScriptNode::onOutputPinsChanged);
-
-    return widget;
-}
-
 TokenList UniversalScriptNode::execute(const TokenList& incomingTokens)
 {
-    // Step 1: Merge incoming tokens into a single DataPacket
+    // Step 1: Merge incoming tokens into a single DataPacket; the host lists the
+    // tokens themselves under "_tokens" only if the script asks for them
     DataPacket input;
-    QVariantList tokenSnapshots;
-    for (const auto& token : incomingTokens) {
-        QVariantMap tokenSnapshot;
-        for (auto it = token.data.cbegin(); it != token.data.cend(); ++it) {
-            input.insert(it.key(), it.value());
-            tokenSnapshot.insert(it.key(), it.value());
-        }
-        if (!tokenSnapshot.isEmpty()) {
-            tokenSnapshots.append(tokenSnapshot);
+    if (incomingTokens.size() == 1) {
+        input = incomingTokens.front().data;
+    } else {
+        for (const auto& token : incomingTokens) {
+            for (auto it = token.data.cbegin(); it != token.data.cend(); ++it) {
+                input.insert(it.key(), it.value());
+            }
         }
     }
-    if (!tokenSnapshots.isEmpty()) {
-        input.insert(QStringLiteral("_tokens"), tokenSnapshots);
-    }
 
     DataPacket output;
     QList<QString> logs;
 
     // Step 2: Retrieve the ScriptEngineFactory
-    // Note: The instruction mentions ScriptEngineRegistry::instance().getFactory(m_engineId)
-    // but IScriptHost.h shows createEngine(id). I'll use createEngine.
+    // Engines are cheap to create; QuickJS engines share a runtime per thread
     std::unique_ptr<IScriptEngine> engine = ScriptEngineRegistry::instance().createEngine(m_engineId);
 
     if (!engine) {
@@ -122,11 +241,41 @@ TokenList UniversalScriptNode::execute(const TokenList& incomingTokens)
         return TokenList{token};
     }
 
-    // Step 3: Create the bridge
-    ExecutionScriptHost host(input, output, logs);
+    bool success = false;
+    ScriptProfile profile;
+    const QString mapPin = m_inputPins.value(0, QString::fromLatin1(kInputId));
+    const QVariant mapInput = input.value(mapPin);
+    if (m_mapMode && (mapInput.typeId() == QMetaType::QVariantList || mapInput.typeId() == QMetaType::QStringList)) {
+        // Map mode: the script runs once per item of the first input pin
+        success = executeMap(input, mapPin, mapInput.toList(), output, profile);
+    } else {
+        // Step 3: Create the bridge
+        ExecutionScriptHost host(input, incomingTokens, output, logs);
+
+        // Step 4: Run it, within the node's budgets
+        engine->setLimits(ScriptLimits{m_timeoutMs, m_memoryLimitMb});
+        engine->setProfiling(m_profiling);
+        success = engine->execute(m_scriptCode, &host);
+        profile = engine->takeProfile();
+    }
 
-    // Step 4: Run it
-    bool success = engine->execute(m_scriptCode, &host);
+    if (m_profiling && !profile.isEmpty()) {
+        const QString path = writeProfile(profile, input);
+        if (!path.isEmpty()) {
+            QString currentLogs = output.value(QStringLiteral("logs")).toString();
+            if (!currentLogs.isEmpty()) {
+                currentLogs += QStringLiteral("  \n");
+            }
+            currentLogs += QStringLiteral("Profile written to %1").arg(QDir::toNativeSeparators(path));
+            output.insert(QStringLiteral("logs"), currentLogs);
+        }
+        const QString summary = profileSummary(profile, path);
+        {
+            QMutexLocker locker(&m_profileMutex);
+            m_lastProfileSummary = summary;
+        }
+        emit profileSummaryChanged(summary);
+    }
 
     if (!success) {
         CP_WARN << "Script execution failed";
@@ -207,15 +356,94 @@ TokenList UniversalScriptNode::execute(const TokenList& incomingTokens)
     return result;
 }
 
+bool UniversalScriptNode::executeMap(const DataPacket& input, const QString& pin, const QVariantList& items,
+                                     DataPacket& output, ScriptProfile& profile) const
+{
+    const auto job = std::make_shared<MapJob>(m_engineId, m_scriptCode, ScriptLimits{m_timeoutMs, m_memoryLimitMb},
+                                              m_profiling, input, pin, items);
+    if (!items.isEmpty()) {
+        job->run(CpuWorkerPool::current() ? CpuWorkerPool::current() : QThreadPool::globalInstance());
+    }
+    profile = std::move(job->profile);
+
+    // Each output key becomes a list in item order, null where an item didn't set it
+    const QString logsKey = QStringLiteral("logs");
+    const QString errorKey = QStringLiteral("__error");
+    const QString statusKey = QString::fromLatin1(kStatusId);
+    QMap<QString, QVariantList> lists;
+    QStringList itemLogs;
+    qsizetype failures = 0;
+    QString firstError;
+    for (qsizetype i = 0; i < items.size(); ++i) {
+        const DataPacket& itemOutput = job->outputs[static_cast<std::size_t>(i)];
+        for (auto it = itemOutput.cbegin(); it != itemOutput.cend(); ++it) {
+            if (it.key() == logsKey || it.key() == errorKey || it.key() == statusKey) {
+                continue;
+            }
+            QVariantList& list = lists[it.key()];
+            if (list.isEmpty()) {
+                list.resize(items.size());
+            }
+            list[i] = it.value();
+        }
+        const QString logText = itemOutput.value(logsKey).toString();
+        if (!logText.isEmpty()) {
+            itemLogs << QStringLiteral("[%1] %2").arg(i).arg(logText);
+        }
+        if (!job->succeeded[static_cast<std::size_t>(i)]) {
+            if (failures++ == 0) {
+                firstError = itemOutput.value(errorKey, QStringLiteral("Script execution failed")).toString();
+                firstError = QStringLiteral("Item %1: %2").arg(i).arg(firstError);
+            }
+        }
+    }
+
+    for (auto it = lists.cbegin(); it != lists.cend(); ++it) {
+        output.insert(it.key(), it.value());
+    }
+    if (!output.contains(QString::fromLatin1(kOutputId))) {
+        output.insert(QString::fromLatin1(kOutputId), QVariantList());
+    }
+    if (!itemLogs.isEmpty()) {
+        output.insert(logsKey, itemLogs.join(QStringLiteral("  \n")));
+    }
+    if (failures > 0) {
+        output.insert(errorKey, QStringLiteral("%1 of %2 items failed. %3")
+                                    .arg(failures).arg(items.size()).arg(firstError));
+        output.insert(statusKey, QStringLiteral("FAIL"));
+    }
+    return failures == 0;
+}
+
+QString UniversalScriptNode::writeProfile(const ScriptProfile& profile, const DataPacket& input) const
+{
+    QString dir = NodeOutputDir::materialize(input);
+    if (dir.isEmpty()) {
+        dir = QDir::tempPath();
+    }
+    const QString path = QDir(dir).filePath(QString::fromLatin1(kProfileFileName));
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        CP_WARN << "Could not write script profile to" << path;
+        return QString();
+    }
+    file.write(profile.folded().toUtf8());
+    return path;
+}
+
 QJsonObject UniversalScriptNode::saveState() const
 {
     QJsonObject obj;
     obj.insert(QStringLiteral("scriptCode"), m_scriptCode);
     obj.insert(QStringLiteral("engineId"), m_engineId);
     obj.insert(QStringLiteral("enableFanOut"), m_enableFanOut);
+    obj.insert(QStringLiteral("mapMode"), m_mapMode);
     obj.insert(QStringLiteral("enableSyntaxHighlighting"), m_enableSyntaxHighlighting);
     obj.insert(QStringLiteral("inputPins"), pinsToJsonArray(m_inputPins));
     obj.insert(QStringLiteral("outputPins"), pinsToJsonArray(m_outputPins));
+    obj.insert(QStringLiteral("timeoutMs"), m_timeoutMs);
+    obj.insert(QStringLiteral("memoryLimitMb"), m_memoryLimitMb);
+    obj.insert(QStringLiteral("profiling"), m_profiling);
     return obj;
 }
 
@@ -230,6 +458,9 @@ void UniversalScriptNode::loadState(const QJsonObject& data)
     if (data.contains(QStringLiteral("enableFanOut"))) {
         m_enableFanOut = data.value(QStringLiteral("enableFanOut")).toBool();
     }
+    if (data.contains(QStringLiteral("mapMode"))) {
+        m_mapMode = data.value(QStringLiteral("mapMode")).toBool();
+    }
     if (data.contains(QStringLiteral("enableSyntaxHighlighting"))) {
         m_enableSyntaxHighlighting = data.value(QStringLiteral("enableSyntaxHighlighting")).toBool(true);
     }
@@ -243,6 +474,15 @@ void UniversalScriptNode::loadState(const QJsonObject& data)
                                        QStringList{QString::fromLatin1(kOutputId), QString::fromLatin1(kStatusId)});
         emit outputPinsChanged();
     }
+    if (data.contains(QStringLiteral("timeoutMs"))) {
+        m_timeoutMs = qMax(0, data.value(QStringLiteral("timeoutMs")).toInt(kDefaultTimeoutMs));
+    }
+    if (data.contains(QStringLiteral("memoryLimitMb"))) {
+        m_memoryLimitMb = qMax(0, data.value(QStringLiteral("memoryLimitMb")).toInt(kDefaultMemoryLimitMb));
+    }
+    if (data.contains(QStringLiteral("profiling"))) {
+        m_profiling = data.value(QStringLiteral("profiling")).toBool();
+    }
     
     if (m_engineId.isEmpty()) {
         m_engineId = QStringLiteral("quickjs");
@@ -251,6 +491,13 @@ void UniversalScriptNode::loadState(const QJsonObject& data)
     if (!m_scriptCode.trimmed().isEmpty() && UniversalScriptTemplates::isManagedTemplate(m_scriptCode)) {
         m_scriptCode = UniversalScriptTemplates::forEngine(m_engineId);
     }
+
+    // Compile while the graph loads rather than on the first run
+    if (!m_scriptCode.trimmed().isEmpty()) {
+        if (std::unique_ptr<IScriptEngine> engine = ScriptEngineRegistry::instance().createEngine(m_engineId)) {
+            engine->prewarm(m_scriptCode);
+        }
+    }
 }
 
 bool UniversalScriptNode::isReady(const QVariantMap& inputs, int incomingConnectionsCount) const
@@ -279,6 +526,11 @@ void UniversalScriptNode::onFanOutChanged(bool enabled)
     m_enableFanOut = enabled;
 }
 
+void UniversalScriptNode::onMapModeChanged(bool enabled)
+{
+    m_mapMode = enabled;
+}
+
 void UniversalScriptNode::onSyntaxHighlightingChanged(bool enabled)
 {
     m_enableSyntaxHighlighting = enabled;
@@ -304,6 +556,21 @@ void UniversalScriptNode::onOutputPinsChanged(const QStringList& pins)
     emit outputPinsChanged();
 }
 
+void UniversalScriptNode::onTimeoutChanged(int timeoutMs)
+{
+    m_timeoutMs = qMax(0, timeoutMs);
+}
+
+void UniversalScriptNode::onMemoryLimitChanged(int memoryLimitMb)
+{
+    m_memoryLimitMb = qMax(0, memoryLimitMb);
+}
+
+void UniversalScriptNode::onProfilingChanged(bool enabled)
+{
+    m_profiling = enabled;
+}
+
 QStringList UniversalScriptNode::sanitizePinList(QStringList pins, const QStringList& fallback)
 {
     QStringList cleaned;
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <QMutex>
 #include <QObject>
 #include <QString>
 #include <QStringList>
@@ -13,8 +14,11 @@
 
 #include "IToolNode.h"
 #include "CommonDataTypes.h"
+#include "IScriptHost.h"
 #include "UniversalScriptTemplates.h"
 
+class QWidget;
+
 /**
  * @brief Node that executes a script using a registered script engine.
  */
@@ -30,9 +34,14 @@ public:
     static constexpr const char* kOutputId = "output";
     static constexpr const char* kStatusId = "status";
 
+    // Execution budgets; 0 turns a limit off
+    static constexpr int kDefaultTimeoutMs = 60000;
+    static constexpr int kDefaultMemoryLimitMb = 256;
+
     // IToolNode interface
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in UniversalScriptPropertiesWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     TokenList execute(const TokenList& incomingTokens) override;
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
@@ -40,20 +49,39 @@ public:
 
     QStringList inputPins() const { return m_inputPins; }
     QStringList outputPins() const { return m_outputPins; }
+    int timeoutMs() const { return m_timeoutMs; }
+    int memoryLimitMb() const { return m_memoryLimitMb; }
+    bool mapMode() const { return m_mapMode; }
+    bool profiling() const { return m_profiling; }
+
+    // Name of the folded-stack file a profiled run leaves in the node's output directory
+    static constexpr const char* kProfileFileName = "script-profile.folded";
 
 signals:
     void inputPinsChanged();
     void outputPinsChanged();
+    // Hottest frames of the last profiled run, for the properties panel
+    void profileSummaryChanged(const QString& summary);
 
 private slots:
     void onScriptChanged(const QString& script);
     void onEngineChanged(const QString& engineId);
     void onFanOutChanged(bool enabled);
+    void onMapModeChanged(bool enabled);
     void onSyntaxHighlightingChanged(bool enabled);
     void onInputPinsChanged(const QStringList& pins);
     void onOutputPinsChanged(const QStringList& pins);
+    void onTimeoutChanged(int timeoutMs);
+    void onMemoryLimitChanged(int memoryLimitMb);
+    void onProfilingChanged(bool enabled);
 
 private:
+    // Map mode: runs the script once per item on the Cpu pool, with the item on @p pin,
+    // and collects each output key into a list in item order
+    bool executeMap(const DataPacket& input, const QString& pin, const QVariantList& items,
+                    DataPacket& output, ScriptProfile& profile) const;
+    // Writes the folded stacks next to the node's other outputs and returns the path
+    QString writeProfile(const ScriptProfile& profile, const DataPacket& input) const;
     static QStringList sanitizePinList(QStringList pins, const QStringList& fallback);
     static void addPin(QMap<QString, PinDefinition>& pins,
                        QStringList& order,
@@ -63,7 +91,15 @@ private:
     QString m_scriptCode;
     QString m_engineId{QStringLiteral("quickjs")};
     bool m_enableFanOut = false;
+    bool m_mapMode = false;
     bool m_enableSyntaxHighlighting = true;
     QStringList m_inputPins{QStringLiteral("input")};
     QStringList m_outputPins{QStringLiteral("output"), QStringLiteral("status")};
+    int m_timeoutMs = kDefaultTimeoutMs;
+    int m_memoryLimitMb = kDefaultMemoryLimitMb;
+    bool m_profiling = false;
+
+    // Written by execute(), read when a new properties panel opens
+    mutable QMutex m_profileMutex;
+    QString m_lastProfileSummary;
 };
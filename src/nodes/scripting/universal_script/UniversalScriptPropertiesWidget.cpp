@@ -5,6 +5,7 @@
 //
 
 #include "UniversalScriptPropertiesWidget.h"
+#include "UniversalScriptNode.h"
 #include "IScriptHost.h"
 #include "ScriptEditorWidget.h"
 #include "ScriptSyntaxHighlighter.h"
@@ -20,6 +21,7 @@
 #include <QPlainTextEdit>
 #include <QPushButton>
 #include <QSignalBlocker>
+#include <QSpinBox>
 #include <QVBoxLayout>
 
 namespace {
@@ -56,6 +58,12 @@ UniversalScriptPropertiesWidget::UniversalScriptPropertiesWidget(QWidget* parent
     m_fanOutCheck = new QCheckBox();
     formLayout->addRow(m_fanOutLabel, m_fanOutCheck);
 
+    m_mapModeLabel = new QLabel(tr("Map Over List Input"));
+    m_mapModeCheck = new QCheckBox();
+    m_mapModeCheck->setToolTip(tr("When the first input pin holds a list, run the script once per item in parallel "
+                                  "and collect each output into a list in item order"));
+    formLayout->addRow(m_mapModeLabel, m_mapModeCheck);
+
     m_inputPinsLabel = new QLabel(tr("Input Pins"));
     m_inputPinsEdit = new QLineEdit();
     m_inputPinsEdit->setPlaceholderText(tr("input"));
@@ -66,6 +74,37 @@ UniversalScriptPropertiesWidget::UniversalScriptPropertiesWidget(QWidget* parent
     m_outputPinsEdit->setPlaceholderText(tr("output, status"));
     formLayout->addRow(m_outputPinsLabel, m_outputPinsEdit);
 
+    m_timeoutLabel = new QLabel(tr("Time Limit"));
+    m_timeoutSpin = new QSpinBox();
+    m_timeoutSpin->setRange(0, 3600000);
+    m_timeoutSpin->setSingleStep(1000);
+    m_timeoutSpin->setSuffix(tr(" ms"));
+    m_timeoutSpin->setSpecialValueText(tr("No limit"));
+    m_timeoutSpin->setToolTip(tr("Scripts still running after this long are stopped"));
+    formLayout->addRow(m_timeoutLabel, m_timeoutSpin);
+
+    m_memoryLimitLabel = new QLabel(tr("Memory Limit"));
+    m_memoryLimitSpin = new QSpinBox();
+    m_memoryLimitSpin->setRange(0, 65536);
+    m_memoryLimitSpin->setSingleStep(64);
+    m_memoryLimitSpin->setSuffix(tr(" MB"));
+    m_memoryLimitSpin->setSpecialValueText(tr("No limit"));
+    m_memoryLimitSpin->setToolTip(tr("Scripts that allocate more than this are stopped"));
+    formLayout->addRow(m_memoryLimitLabel, m_memoryLimitSpin);
+
+    m_profilingLabel = new QLabel(tr("Profile Script"));
+    m_profilingCheck = new QCheckBox();
+    m_profilingCheck->setToolTip(tr("Sample where the script spends its time and write a flame graph input "
+                                    "(script-profile.folded) to the node's output directory"));
+    formLayout->addRow(m_profilingLabel, m_profilingCheck);
+
+    m_profileSummaryLabel = new QLabel();
+    m_profileSummaryLabel->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    m_profileSummaryLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    m_profileSummaryLabel->setWordWrap(true);
+    m_profileSummaryLabel->setVisible(false);
+    formLayout->addRow(m_profileSummaryLabel);
+
     m_syntaxHighlightCheck = new QCheckBox();
     m_syntaxHighlightCheck->setChecked(true);
     formLayout->addRow(tr("Syntax Highlighting"), m_syntaxHighlightCheck);
@@ -95,9 +134,13 @@ UniversalScriptPropertiesWidget::UniversalScriptPropertiesWidget(QWidget* parent
     connect(m_scriptEditor, &QPlainTextEdit::textChanged, this, &UniversalScriptPropertiesWidget::onScriptTextChanged);
     connect(m_engineCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &UniversalScriptPropertiesWidget::onEngineIndexChanged);
     connect(m_fanOutCheck, &QCheckBox::toggled, this, &UniversalScriptPropertiesWidget::fanOutChanged);
+    connect(m_mapModeCheck, &QCheckBox::toggled, this, &UniversalScriptPropertiesWidget::mapModeChanged);
     connect(m_syntaxHighlightCheck, &QCheckBox::toggled, this, &UniversalScriptPropertiesWidget::onSyntaxHighlightingToggled);
     connect(m_inputPinsEdit, &QLineEdit::editingFinished, this, &UniversalScriptPropertiesWidget::onInputPinsEdited);
     connect(m_outputPinsEdit, &QLineEdit::editingFinished, this, &UniversalScriptPropertiesWidget::onOutputPinsEdited);
+    connect(m_timeoutSpin, &QSpinBox::valueChanged, this, &UniversalScriptPropertiesWidget::timeoutChanged);
+    connect(m_memoryLimitSpin, &QSpinBox::valueChanged, this, &UniversalScriptPropertiesWidget::memoryLimitChanged);
+    connect(m_profilingCheck, &QCheckBox::toggled, this, &UniversalScriptPropertiesWidget::profilingChanged);
     connect(m_addExampleButton, &QPushButton::clicked, this, &UniversalScriptPropertiesWidget::onAddExampleClicked);
 
     maybeInstallTemplateForEngine(m_engineCombo->currentText(), false);
@@ -146,6 +189,20 @@ void UniversalScriptPropertiesWidget::setFanOutVisible(bool visible)
     }
 }
 
+void UniversalScriptPropertiesWidget::setMapMode(bool enabled)
+{
+    if (m_mapModeCheck->isChecked() != enabled) {
+        QSignalBlocker blocker(m_mapModeCheck);
+        m_mapModeCheck->setChecked(enabled);
+    }
+}
+
+void UniversalScriptPropertiesWidget::setMapModeVisible(bool visible)
+{
+    m_mapModeLabel->setVisible(visible);
+    m_mapModeCheck->setVisible(visible);
+}
+
 void UniversalScriptPropertiesWidget::setSyntaxHighlighting(bool enabled)
 {
     if (m_syntaxHighlightCheck->isChecked() != enabled) {
@@ -189,6 +246,51 @@ void UniversalScriptPropertiesWidget::setOutputPins(const QStringList& pins)
     }
 }
 
+void UniversalScriptPropertiesWidget::setTimeoutMs(int timeoutMs)
+{
+    if (m_timeoutSpin->value() != timeoutMs) {
+        QSignalBlocker blocker(m_timeoutSpin);
+        m_timeoutSpin->setValue(timeoutMs);
+    }
+}
+
+void UniversalScriptPropertiesWidget::setMemoryLimitMb(int memoryLimitMb)
+{
+    if (m_memoryLimitSpin->value() != memoryLimitMb) {
+        QSignalBlocker blocker(m_memoryLimitSpin);
+        m_memoryLimitSpin->setValue(memoryLimitMb);
+    }
+}
+
+void UniversalScriptPropertiesWidget::setLimitsVisible(bool visible)
+{
+    m_timeoutLabel->setVisible(visible);
+    m_timeoutSpin->setVisible(visible);
+    m_memoryLimitLabel->setVisible(visible);
+    m_memoryLimitSpin->setVisible(visible);
+}
+
+void UniversalScriptPropertiesWidget::setProfiling(bool enabled)
+{
+    if (m_profilingCheck->isChecked() != enabled) {
+        QSignalBlocker blocker(m_profilingCheck);
+        m_profilingCheck->setChecked(enabled);
+    }
+}
+
+void UniversalScriptPropertiesWidget::setProfileSummary(const QString& summary)
+{
+    m_profileSummaryLabel->setText(summary);
+    m_profileSummaryLabel->setVisible(!summary.isEmpty() && !m_profilingCheck->isHidden());
+}
+
+void UniversalScriptPropertiesWidget::setProfilingVisible(bool visible)
+{
+    m_profilingLabel->setVisible(visible);
+    m_profilingCheck->setVisible(visible);
+    m_profileSummaryLabel->setVisible(visible && !m_profileSummaryLabel->text().isEmpty());
+}
+
 QString UniversalScriptPropertiesWidget::script() const
 {
     return m_scriptEditor->toPlainText();
@@ -261,6 +363,7 @@ void UniversalScriptPropertiesWidget::applySyntaxHighlighter()
 
     if (!m_highlighter) {
         m_highlighter = std::make_unique<ScriptSyntaxHighlighter>(m_scriptEditor->document());
+        m_highlighter->setEditor(m_scriptEditor);
     }
     m_highlighter->setEngineId(m_engineCombo->currentText());
 }
@@ -298,3 +401,36 @@ void UniversalScriptPropertiesWidget::updateAddExampleVisibility()
     }
     m_addExampleButton->setVisible(m_scriptEditor->toPlainText().trimmed().isEmpty());
 }
+
+QWidget* UniversalScriptNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* widget = new UniversalScriptPropertiesWidget(parent);
+    widget->setScript(m_scriptCode);
+    widget->setEngineId(m_engineId);
+    widget->setFanOut(m_enableFanOut);
+    widget->setMapMode(m_mapMode);
+    widget->setSyntaxHighlighting(m_enableSyntaxHighlighting);
+    widget->setInputPins(m_inputPins);
+    widget->setOutputPins(m_outputPins);
+    widget->setTimeoutMs(m_timeoutMs);
+    widget->setMemoryLimitMb(m_memoryLimitMb);
+    widget->setProfiling(m_profiling);
+    {
+        QMutexLocker locker(&m_profileMutex);
+        widget->setProfileSummary(m_lastProfileSummary);
+    }
+
+    connect(widget, &UniversalScriptPropertiesWidget::scriptChanged, this, &UniversalScriptNode::onScriptChanged);
+    connect(widget, &UniversalScriptPropertiesWidget::engineChanged, this, &UniversalScriptNode::onEngineChanged);
+    connect(widget, &UniversalScriptPropertiesWidget::fanOutChanged, this, &UniversalScriptNode::onFanOutChanged);
+    connect(widget, &UniversalScriptPropertiesWidget::mapModeChanged, this, &UniversalScriptNode::onMapModeChanged);
+    connect(widget, &UniversalScriptPropertiesWidget::syntaxHighlightingChanged, this, &UniversalScriptNode::onSyntaxHighlightingChanged);
+    connect(widget, &UniversalScriptPropertiesWidget::inputPinsChanged, this, &UniversalScriptNode::onInputPinsChanged);
+    connect(widget, &UniversalScriptPropertiesWidget::outputPinsChanged, this, &UniversalScriptNode::onOutputPinsChanged);
+    connect(widget, &UniversalScriptPropertiesWidget::timeoutChanged, this, &UniversalScriptNode::onTimeoutChanged);
+    connect(widget, &UniversalScriptPropertiesWidget::memoryLimitChanged, this, &UniversalScriptNode::onMemoryLimitChanged);
+    connect(widget, &UniversalScriptPropertiesWidget::profilingChanged, this, &UniversalScriptNode::onProfilingChanged);
+    connect(this, &UniversalScriptNode::profileSummaryChanged, widget, &UniversalScriptPropertiesWidget::setProfileSummary);
+
+    return widget;
+}
@@ -16,6 +16,7 @@ class QPlainTextEdit;
 class QCheckBox;
 class QPushButton;
 class QLabel;
+class QSpinBox;
 class ScriptSyntaxHighlighter;
 
 /**
@@ -46,6 +47,12 @@ public:
 
     void setFanOutVisible(bool visible);
 
+    /**
+     * @brief Sets whether the script runs once per item of a list input.
+     */
+    void setMapMode(bool enabled);
+    void setMapModeVisible(bool visible);
+
     /**
      * @brief Sets whether syntax highlighting should be applied to the editor.
      */
@@ -55,6 +62,20 @@ public:
     void setInputPins(const QStringList& pins);
     void setOutputPins(const QStringList& pins);
 
+    /**
+     * @brief Sets the execution budgets shown; 0 means no limit.
+     */
+    void setTimeoutMs(int timeoutMs);
+    void setMemoryLimitMb(int memoryLimitMb);
+    void setLimitsVisible(bool visible);
+
+    /**
+     * @brief Sets whether runs are profiled, and shows the last run's hottest stacks.
+     */
+    void setProfiling(bool enabled);
+    void setProfileSummary(const QString& summary);
+    void setProfilingVisible(bool visible);
+
     /**
      * @brief Returns the current script content.
      */
@@ -83,8 +104,16 @@ signals:
      */
     void fanOutChanged(bool enabled);
 
+    /**
+     * @brief Emitted when map mode is toggled.
+     */
+    void mapModeChanged(bool enabled);
+
     void inputPinsChanged(const QStringList& pins);
     void outputPinsChanged(const QStringList& pins);
+    void timeoutChanged(int timeoutMs);
+    void memoryLimitChanged(int memoryLimitMb);
+    void profilingChanged(bool enabled);
 
     /**
      * @brief Emitted when syntax highlighting is toggled.
@@ -107,11 +136,20 @@ private:
     QComboBox* m_engineCombo;
     QLabel* m_fanOutLabel;
     QCheckBox* m_fanOutCheck;
+    QLabel* m_mapModeLabel;
+    QCheckBox* m_mapModeCheck;
     QCheckBox* m_syntaxHighlightCheck;
     QLabel* m_inputPinsLabel;
     QLineEdit* m_inputPinsEdit;
     QLabel* m_outputPinsLabel;
     QLineEdit* m_outputPinsEdit;
+    QLabel* m_timeoutLabel;
+    QSpinBox* m_timeoutSpin;
+    QLabel* m_memoryLimitLabel;
+    QSpinBox* m_memoryLimitSpin;
+    QLabel* m_profilingLabel;
+    QCheckBox* m_profilingCheck;
+    QLabel* m_profileSummaryLabel;
     QPushButton* m_addExampleButton;
     QPlainTextEdit* m_scriptEditor;
     std::unique_ptr<ScriptSyntaxHighlighter> m_highlighter;
@@ -22,12 +22,65 @@
 // SOFTWARE.
 //
 #include "PromptBuilderNode.h"
-#include "PromptBuilderPropertiesWidget.h"
+#include "TokenEstimator.h"
 
 #include <QtConcurrent/QtConcurrent>
 #include <QJsonObject>
-#include <QRegularExpression>
-#include <QSet>
+
+#include <algorithm>
+
+namespace {
+
+// Renders tpl, first shrinking values until the estimate fits budget (0 = unbounded).
+// The estimate and what was cut are reported in meta when given.
+QString renderWithinBudget(const PromptTemplate& tpl, QStringList values, int budget,
+                           const TokenEstimator& estimator, DataPacket* meta)
+{
+    if (budget <= 0) {
+        return tpl.render(values);
+    }
+
+    // Fixed text of the template, then the values, each counted once per use
+    QList<int> costs;
+    qint64 total = estimator.count(tpl.literalText());
+    for (int i = 0; i < values.size(); ++i) {
+        costs.append(estimator.count(values[i]));
+        total += static_cast<qint64>(costs[i]) * tpl.uses(i);
+    }
+
+    // Retrieved contexts give way first, then the largest values
+    QList<int> order;
+    for (int i = 0; i < values.size(); ++i) order.append(i);
+    std::stable_sort(order.begin(), order.end(), [&](int lhs, int rhs) {
+        const bool lhsContext = TokenEstimator::isReferenceContext(values[lhs]);
+        const bool rhsContext = TokenEstimator::isReferenceContext(values[rhs]);
+        if (lhsContext != rhsContext) return lhsContext;
+        return costs[lhs] > costs[rhs];
+    });
+    bool truncated = false;
+    int droppedChunks = 0;
+    for (int i : order) {
+        if (total <= budget) break;
+        const int uses = std::max(1, tpl.uses(i));
+        const qint64 excess = (total - budget + uses - 1) / uses;
+        const int target = static_cast<int>(std::max<qint64>(0, costs[i] - excess));
+        int dropped = 0;
+        values[i] = estimator.fittedContext(values[i], target, &dropped);
+        droppedChunks += dropped;
+        const int cost = estimator.count(values[i]);
+        truncated = truncated || cost < costs[i];
+        total -= static_cast<qint64>(costs[i] - cost) * tpl.uses(i);
+        costs[i] = cost;
+    }
+    if (meta) {
+        meta->insert(QStringLiteral("_prompt_tokens"), static_cast<int>(std::min<qint64>(total, 1 << 30)));
+        meta->insert(QStringLiteral("_prompt_truncated"), truncated);
+        if (droppedChunks > 0) meta->insert(QStringLiteral("_dropped_chunks"), droppedChunks);
+    }
+    return tpl.render(values);
+}
+
+} // namespace
 
 PromptBuilderNode::PromptBuilderNode(QObject* parent)
     : QObject(parent)
@@ -41,18 +94,7 @@ void PromptBuilderNode::setTemplateText(const QString& text)
     }
 
     // Parse variables from the provided template and route through the main slot
-    static const QRegularExpression re(QStringLiteral("\\{([^{}]+)\\}"));
-    QStringList vars;
-    QSet<QString> seen;
-    auto it = re.globalMatch(text);
-    while (it.hasNext()) {
-        const auto m = it.next();
-        const QString var = m.captured(1).trimmed();
-        if (!var.isEmpty() && !seen.contains(var)) {
-            seen.insert(var);
-            vars.append(var);
-        }
-    }
+    QStringList vars = PromptTemplate(text).variables();
     if (vars.isEmpty()) {
         // Keep a convenient default variable for quick usage
         vars.append(QString::fromLatin1(kInputId));
@@ -66,6 +108,9 @@ void PromptBuilderNode::onTemplateChanged(const QString& newTemplate, const QStr
     emit inputPinsUpdateRequested(newVariables);
 
     // Update internal state and notify UI
+    if (m_template != newTemplate) {
+        m_compiled = std::make_shared<const PromptTemplate>(newTemplate);
+    }
     m_template = newTemplate;
     m_variables = newVariables;
     emit templateTextChanged(m_template);
@@ -89,22 +134,6 @@ NodeDescriptor PromptBuilderNode::getDescriptor() const
     return desc;
 }
 
-QWidget* PromptBuilderNode::createConfigurationWidget(QWidget* parent)
-{
-    auto* w = new PromptBuilderPropertiesWidget(parent);
-    // Initialize from current state
-    w->setTemplateText(m_template);
-
-    // UI -> Node (live updates)
-    QObject::connect(w, &PromptBuilderPropertiesWidget::templateChanged,
-                     this, &PromptBuilderNode::onTemplateChanged);
-    // Node -> UI (reflect programmatic changes)
-    QObject::connect(this, &PromptBuilderNode::templateTextChanged,
-                     w, &PromptBuilderPropertiesWidget::setTemplateText);
-
-    return w;
-}
-
 TokenList PromptBuilderNode::execute(const TokenList& incomingTokens)
 {
     // Merge incoming tokens into a single DataPacket
@@ -116,17 +145,12 @@ TokenList PromptBuilderNode::execute(const TokenList& incomingTokens)
     }
 
     // Capture state for execution
-    const QString tpl = m_template;
-    const QStringList vars = m_variables;
+    const std::shared_ptr<const PromptTemplate> compiled = m_compiled;
+    const TokenEstimator estimator(TokenEstimator::familyFromName(m_tokenizer));
 
     DataPacket output;
-    QString result = tpl;
-    for (const QString& var : vars) {
-        const QString key = QStringLiteral("{") + var + QStringLiteral("}");
-        const QString value = inputs.value(var).toString();
-        result.replace(key, value);
-    }
-    output.insert(QString::fromLatin1(kOutputId), result);
+    output.insert(QString::fromLatin1(kOutputId),
+                  renderWithinBudget(*compiled, compiled->valuesFrom(inputs), m_tokenBudget, estimator, &output));
 
     ExecutionToken token;
     token.data = output;
@@ -136,11 +160,25 @@ TokenList PromptBuilderNode::execute(const TokenList& incomingTokens)
     return resultTokens;
 }
 
+QStringList PromptBuilderNode::renderBatch(const QList<DataPacket>& inputs) const
+{
+    const std::shared_ptr<const PromptTemplate> compiled = m_compiled;
+    const TokenEstimator estimator(TokenEstimator::familyFromName(m_tokenizer));
+    QStringList prompts;
+    prompts.reserve(inputs.size());
+    for (const DataPacket& input : inputs) {
+        prompts.append(renderWithinBudget(*compiled, compiled->valuesFrom(input), m_tokenBudget, estimator, nullptr));
+    }
+    return prompts;
+}
+
 
 QJsonObject PromptBuilderNode::saveState() const
 {
     QJsonObject obj;
     obj.insert(QStringLiteral("template"), m_template);
+    obj.insert(QStringLiteral("token_budget"), m_tokenBudget);
+    obj.insert(QStringLiteral("tokenizer"), m_tokenizer);
     return obj;
 }
 
@@ -149,4 +187,26 @@ void PromptBuilderNode::loadState(const QJsonObject& data)
     if (data.contains(QStringLiteral("template"))) {
         setTemplateText(data.value(QStringLiteral("template")).toString());
     }
+    setTokenBudget(data.value(QStringLiteral("token_budget")).toInt(0));
+    setTokenizer(data.value(QStringLiteral("tokenizer")).toString(QStringLiteral("generic")));
+}
+
+void PromptBuilderNode::setTokenBudget(int tokens)
+{
+    tokens = std::max(0, tokens);
+    if (m_tokenBudget == tokens) {
+        return;
+    }
+    m_tokenBudget = tokens;
+    emit tokenBudgetChanged(m_tokenBudget);
+}
+
+void PromptBuilderNode::setTokenizer(const QString& family)
+{
+    const QString normalized = TokenEstimator::familyName(TokenEstimator::familyFromName(family));
+    if (m_tokenizer == normalized) {
+        return;
+    }
+    m_tokenizer = normalized;
+    emit tokenizerChanged(m_tokenizer);
 }
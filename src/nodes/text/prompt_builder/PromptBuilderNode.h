@@ -24,13 +24,28 @@
 #pragma once
 
 #include <QObject>
-#include <QWidget>
 #include <QString>
 #include <QStringList>
 
+#include <memory>
+
 #include "IToolNode.h"
 #include "CommonDataTypes.h"
+#include "PromptTemplate.h"
+
+class QWidget;
 
+/**
+ * @brief Fills a {placeholder} template from its input pins.
+ *
+ * With a token budget set, the assembled prompt is estimated with the chosen
+ * tokenizer (TokenEstimator) and shrunk to fit: retrieved contexts lose their
+ * lowest ranked chunks first, then the largest remaining values are cut. The
+ * template text itself is never changed.
+ *
+ * The template is compiled into a PromptTemplate whenever it changes, so
+ * executions only fill slots.
+ */
 class PromptBuilderNode : public QObject, public IToolNode {
     Q_OBJECT
     Q_INTERFACES(IToolNode)
@@ -40,20 +55,34 @@ public:
 
     // IToolNode interface
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in PromptBuilderPropertiesWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     TokenList execute(const TokenList& incomingTokens) override;
+    bool supportsConcurrentRuns() const override { return true; }
+    bool isDeterministic() const override { return true; }
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
 
     // Accessors
     QString templateText() const { return m_template; }
+    // 0 leaves the prompt unbounded
+    int tokenBudget() const { return m_tokenBudget; }
+    // TokenEstimator family name: "generic", "openai", "anthropic" or "google"
+    QString tokenizer() const { return m_tokenizer; }
+
+    // Renders the current template, within the token budget, once per input packet
+    QStringList renderBatch(const QList<DataPacket>& inputs) const;
 
 public slots:
     void setTemplateText(const QString& text);
+    void setTokenBudget(int tokens);
+    void setTokenizer(const QString& family);
     void onTemplateChanged(const QString& newTemplate, const QStringList& newVariables);
 
 signals:
     void templateTextChanged(const QString& text);
+    void tokenBudgetChanged(int tokens);
+    void tokenizerChanged(const QString& family);
     // Request the delegate to update input pins to match the variable list
     void inputPinsUpdateRequested(const QStringList& newVariables);
 
@@ -63,5 +92,9 @@ public:
 
 private:
     QString m_template { QStringLiteral("{input}") };
+    // Replaced, never modified, so executions can keep the one they started with
+    std::shared_ptr<const PromptTemplate> m_compiled { std::make_shared<const PromptTemplate>(m_template) };
     QStringList m_variables { QStringList{ QString::fromLatin1(kInputId) } };
+    int m_tokenBudget { 0 };
+    QString m_tokenizer { QStringLiteral("generic") };
 };
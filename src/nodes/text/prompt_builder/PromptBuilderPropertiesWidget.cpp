@@ -22,10 +22,12 @@
 // SOFTWARE.
 //
 #include "PromptBuilderPropertiesWidget.h"
+#include "PromptBuilderNode.h"
+#include "PromptTemplate.h"
 #include <QVBoxLayout>
 #include <QLabel>
-#include <QRegularExpression>
-#include <QSet>
+#include <QComboBox>
+#include <QSpinBox>
 
 PromptBuilderPropertiesWidget::PromptBuilderPropertiesWidget(QWidget* parent)
     : QWidget(parent)
@@ -43,8 +45,30 @@ PromptBuilderPropertiesWidget::PromptBuilderPropertiesWidget(QWidget* parent)
     m_templateEdit->setAcceptRichText(false);
     layout->addWidget(m_templateEdit);
 
+    layout->addWidget(new QLabel(tr("Token budget:"), this));
+    m_tokenBudgetSpin = new QSpinBox(this);
+    m_tokenBudgetSpin->setRange(0, 2000000);
+    m_tokenBudgetSpin->setSingleStep(1000);
+    m_tokenBudgetSpin->setSpecialValueText(tr("Unlimited"));
+    m_tokenBudgetSpin->setToolTip(tr("Shrinks the inputs until the prompt fits: retrieved contexts lose their "
+                                     "lowest ranked chunks first, then the longest values are cut"));
+    layout->addWidget(m_tokenBudgetSpin);
+
+    layout->addWidget(new QLabel(tr("Count tokens as:"), this));
+    m_tokenizerCombo = new QComboBox(this);
+    m_tokenizerCombo->addItem(tr("Generic (4 characters per token)"), QStringLiteral("generic"));
+    m_tokenizerCombo->addItem(tr("OpenAI"), QStringLiteral("openai"));
+    m_tokenizerCombo->addItem(tr("Anthropic"), QStringLiteral("anthropic"));
+    m_tokenizerCombo->addItem(tr("Google"), QStringLiteral("google"));
+    layout->addWidget(m_tokenizerCombo);
+
     layout->addStretch();
 
+    connect(m_tokenBudgetSpin, &QSpinBox::valueChanged, this, &PromptBuilderPropertiesWidget::tokenBudgetChanged);
+    connect(m_tokenizerCombo, &QComboBox::currentIndexChanged, this, [this]() {
+        emit tokenizerChanged(m_tokenizerCombo->currentData().toString());
+    });
+
     // Debounce timer to avoid heavy parsing on every keystroke
     m_debounceTimer = new QTimer(this);
     m_debounceTimer->setSingleShot(true);
@@ -70,6 +94,21 @@ void PromptBuilderPropertiesWidget::setTemplateText(const QString& text)
     }
 }
 
+void PromptBuilderPropertiesWidget::setTokenBudget(int tokens)
+{
+    if (m_tokenBudgetSpin) {
+        m_tokenBudgetSpin->setValue(tokens);
+    }
+}
+
+void PromptBuilderPropertiesWidget::setTokenizer(const QString& family)
+{
+    if (m_tokenizerCombo) {
+        const int index = m_tokenizerCombo->findData(family);
+        m_tokenizerCombo->setCurrentIndex(index >= 0 ? index : 0);
+    }
+}
+
 QString PromptBuilderPropertiesWidget::templateText() const
 {
     return m_templateEdit ? m_templateEdit->toPlainText() : QString();
@@ -86,21 +125,32 @@ void PromptBuilderPropertiesWidget::onDebounceTimeout()
 {
     const QString text = m_templateEdit ? m_templateEdit->toPlainText() : QString();
     // Parse unique variables of the form {var}
-    static const QRegularExpression re(QStringLiteral("\\{([^{}]+)\\}"));
-    QStringList vars;
-    QSet<QString> seen;
-    auto it = re.globalMatch(text);
-    while (it.hasNext()) {
-        const auto m = it.next();
-        const QString var = m.captured(1).trimmed();
-        if (!var.isEmpty() && !seen.contains(var)) {
-            seen.insert(var);
-            vars.append(var);
-        }
-    }
+    QStringList vars = PromptTemplate(text).variables();
     // Ensure at least one convenience input exists so users always have an input pin
     if (vars.isEmpty()) {
         vars.append(QStringLiteral("input"));
     }
     emit templateChanged(text, vars);
 }
+
+QWidget* PromptBuilderNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* w = new PromptBuilderPropertiesWidget(parent);
+    // Initialize from current state
+    w->setTemplateText(m_template);
+    w->setTokenBudget(m_tokenBudget);
+    w->setTokenizer(m_tokenizer);
+
+    // UI -> Node (live updates)
+    QObject::connect(w, &PromptBuilderPropertiesWidget::templateChanged,
+                     this, &PromptBuilderNode::onTemplateChanged);
+    // Node -> UI (reflect programmatic changes)
+    QObject::connect(this, &PromptBuilderNode::templateTextChanged,
+                     w, &PromptBuilderPropertiesWidget::setTemplateText);
+    QObject::connect(w, &PromptBuilderPropertiesWidget::tokenBudgetChanged,
+                     this, &PromptBuilderNode::setTokenBudget);
+    QObject::connect(w, &PromptBuilderPropertiesWidget::tokenizerChanged,
+                     this, &PromptBuilderNode::setTokenizer);
+
+    return w;
+}
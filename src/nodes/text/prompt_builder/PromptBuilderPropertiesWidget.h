@@ -28,6 +28,9 @@
 #include <QStringList>
 #include <QTimer>
 
+class QComboBox;
+class QSpinBox;
+
 // Property editor widget for PromptBuilderNode
 class PromptBuilderPropertiesWidget : public QWidget {
     Q_OBJECT
@@ -37,6 +40,8 @@ public:
 
     // Initialize / update UI values from external state
     void setTemplateText(const QString& text);
+    void setTokenBudget(int tokens);
+    void setTokenizer(const QString& family);
 
     // Read current values
     QString templateText() const;
@@ -45,10 +50,14 @@ signals:
     // Emitted whenever the template text changes in the editor. Provides the
     // full template and the extracted unique variable list (order of first occurrence).
     void templateChanged(const QString& newTemplate, const QStringList& newVariables);
+    void tokenBudgetChanged(int tokens);
+    void tokenizerChanged(const QString& family);
 
 private:
     QTextEdit* m_templateEdit {nullptr};
     QTimer* m_debounceTimer {nullptr};
+    QSpinBox* m_tokenBudgetSpin {nullptr};
+    QComboBox* m_tokenizerCombo {nullptr};
 
 private slots:
     void onTextChanged();
@@ -0,0 +1,119 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "PromptTemplate.h"
+
+PromptTemplate::PromptTemplate(const QString& text)
+    : m_text(text)
+{
+    const QStringView view(m_text);
+    qsizetype literalStart = 0;
+    qsizetype at = 0;
+    auto addLiteral = [this](qsizetype from, qsizetype to) {
+        if (to > from) {
+            m_segments.append(Segment{from, to - from, -1});
+            m_literalLength += to - from;
+        }
+    };
+
+    // Same placeholders as \{([^{}]+)\}: the innermost brace pair with text between
+    while ((at = view.indexOf(u'{', at)) >= 0) {
+        qsizetype close = at + 1;
+        while (close < view.size() && view[close] != u'{' && view[close] != u'}') ++close;
+        if (close >= view.size()) break;
+        if (view[close] == u'{' || close == at + 1) {
+            at = close == at + 1 ? at + 1 : close;
+            continue;
+        }
+        const QString name = view.sliced(at + 1, close - at - 1).trimmed().toString();
+        if (name.isEmpty()) {
+            at = close + 1;
+            continue;
+        }
+        addLiteral(literalStart, at);
+        int index = static_cast<int>(m_variables.indexOf(name));
+        if (index < 0) {
+            index = static_cast<int>(m_variables.size());
+            m_variables.append(name);
+            m_uses.append(0);
+        }
+        ++m_uses[index];
+        m_segments.append(Segment{at, close + 1 - at, index});
+        literalStart = at = close + 1;
+    }
+    addLiteral(literalStart, view.size());
+}
+
+QString PromptTemplate::literalText() const
+{
+    QString literal;
+    literal.reserve(m_literalLength);
+    for (const Segment& segment : m_segments) {
+        if (segment.variable < 0) literal += QStringView(m_text).sliced(segment.offset, segment.length);
+    }
+    return literal;
+}
+
+QString PromptTemplate::render(const QStringList& values) const
+{
+    qsizetype size = m_literalLength;
+    for (int i = 0; i < m_uses.size() && i < values.size(); ++i) {
+        size += values[i].size() * m_uses[i];
+    }
+
+    QString result;
+    result.reserve(size);
+    for (const Segment& segment : m_segments) {
+        if (segment.variable < 0) {
+            result += QStringView(m_text).sliced(segment.offset, segment.length);
+        } else if (segment.variable < values.size()) {
+            result += values[segment.variable];
+        }
+    }
+    return result;
+}
+
+QString PromptTemplate::render(const QVariantMap& inputs) const
+{
+    return render(valuesFrom(inputs));
+}
+
+QStringList PromptTemplate::renderBatch(const QList<QVariantMap>& inputs) const
+{
+    QStringList results;
+    results.reserve(inputs.size());
+    for (const QVariantMap& input : inputs) {
+        results.append(render(input));
+    }
+    return results;
+}
+
+QStringList PromptTemplate::valuesFrom(const QVariantMap& inputs) const
+{
+    QStringList values;
+    values.reserve(m_variables.size());
+    for (const QString& name : m_variables) {
+        values.append(inputs.value(name).toString());
+    }
+    return values;
+}
@@ -0,0 +1,73 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+
+/**
+ * @brief A {placeholder} template parsed once into literal spans and variable slots.
+ *
+ * Rendering walks the segments into a buffer sized up front, so filling the same
+ * template many times costs one allocation per result and no rescans. Placeholder
+ * names are trimmed; "{}" and "{ }" stay literal text. Values are inserted as is
+ * and never scanned for placeholders themselves.
+ */
+class PromptTemplate {
+public:
+    PromptTemplate() = default;
+    explicit PromptTemplate(const QString& text);
+
+    const QString& text() const { return m_text; }
+    // Unique placeholder names in order of first use
+    const QStringList& variables() const { return m_variables; }
+    // Number of slots that read variables()[index]
+    int uses(int index) const { return m_uses.value(index); }
+    // The template with every placeholder removed
+    QString literalText() const;
+
+    // values are aligned with variables(); missing entries render empty
+    QString render(const QStringList& values) const;
+    QString render(const QVariantMap& inputs) const;
+    QStringList renderBatch(const QList<QVariantMap>& inputs) const;
+
+    // Values for variables() looked up by name
+    QStringList valuesFrom(const QVariantMap& inputs) const;
+
+private:
+    struct Segment {
+        qsizetype offset {0};
+        qsizetype length {0};
+        // Index into m_variables, or -1 for a literal span of m_text
+        int variable {-1};
+    };
+
+    QString m_text;
+    QStringList m_variables;
+    QList<int> m_uses;
+    QList<Segment> m_segments;
+    qsizetype m_literalLength {0};
+};
@@ -1,7 +1,9 @@
 #include "TextChunkerNode.h"
-#include "TextChunkerPropertiesWidget.h"
 
-#include "retrieval/chunking/TextChunker.h"
+#include "CancellationToken.h"
+#include "PartialOutputSink.h"
+#include "retrieval/chunking/ParallelChunker.h"
+#include "retrieval/chunking/StreamingChunker.h"
 
 #include <QJsonObject>
 
@@ -40,6 +42,9 @@ FileType fileTypeFromString(const QString& value)
     return FileType::PlainText;
 }
 
+// Streaming cuts regions this long, so the first chunks leave after a few pages of text
+constexpr qsizetype kStreamRegionLength = 64 * 1024;
+
 QString normalizeFileType(const QString& value)
 {
     const QString v = value.trimmed().toLower();
@@ -74,15 +79,11 @@ NodeDescriptor TextChunkerNode::getDescriptor() const
     addOutput(desc, QString::fromLatin1(kOutputCountId), QStringLiteral("Count"));
     addOutput(desc, QString::fromLatin1(kOutputSummaryId), QStringLiteral("Summary"));
     addOutput(desc, QString::fromLatin1(kOutputTextId), QStringLiteral("Text"));
+    addOutput(desc, QString::fromLatin1(kOutputChunkId), QStringLiteral("Chunk (stream)"));
 
     return desc;
 }
 
-QWidget* TextChunkerNode::createConfigurationWidget(QWidget* parent)
-{
-    return new TextChunkerPropertiesWidget(this, parent);
-}
-
 bool TextChunkerNode::isReady(const QVariantMap& inputs, int incomingConnectionsCount) const
 {
     Q_UNUSED(incomingConnectionsCount);
@@ -99,24 +100,54 @@ TokenList TextChunkerNode::execute(const TokenList& incomingTokens)
     }
 
     const QString text = inputs.value(QString::fromLatin1(kInputTextId)).toString();
-    const QStringList chunks = TextChunker::split(text, m_chunkSize, m_chunkOverlap, fileTypeFromString(m_fileType));
+    const FileType fileType = fileTypeFromString(m_fileType);
 
     QVariantList chunkList;
-    chunkList.reserve(chunks.size());
-    for (const QString& chunk : chunks) {
-        chunkList.append(chunk);
+    int count = 0;
+    if (m_streamChunks) {
+        // Regions are cut and chunked a window at a time, and each chunk goes downstream
+        // at once, so consumers start on the first chunks while the rest are still cut
+        const PartialOutputSink sink = PartialOutputSink::current();
+        const CancellationToken cancellation = CancellationToken::current();
+        const QString chunkPinId = QString::fromLatin1(kOutputChunkId);
+        StreamingChunker chunker(
+            m_chunkSize, m_chunkOverlap, fileType,
+            [&sink, &chunkPinId, &count](const QString& chunk, const TextChunkSpan&) {
+                ExecutionToken token;
+                token.data.insert(chunkPinId, chunk);
+                token.forceExecution = true;
+                sink.publish(TokenList{token});
+                ++count;
+            },
+            kStreamRegionLength);
+        const QStringView view(text);
+        for (qsizetype offset = 0; offset < view.size() && !cancellation.isCancelled(); offset += kStreamRegionLength) {
+            chunker.append(view.mid(offset, kStreamRegionLength));
+        }
+        chunker.finish();
+    } else {
+        // Large inputs are chunked region by region on the run's Cpu pool
+        const QList<TextChunkSpan> spans = ParallelChunker::splitSpans(text, m_chunkSize, m_chunkOverlap, fileType);
+        chunkList.reserve(spans.size());
+        for (const TextChunkSpan& span : spans) {
+            chunkList.append(text.mid(span.offset, span.length));
+        }
+        count = static_cast<int>(chunkList.size());
     }
 
     QVariantMap summary;
     summary.insert(QStringLiteral("chunk_size"), m_chunkSize);
     summary.insert(QStringLiteral("chunk_overlap"), m_chunkOverlap);
     summary.insert(QStringLiteral("file_type"), m_fileType);
-    summary.insert(QStringLiteral("count"), chunkList.size());
+    summary.insert(QStringLiteral("count"), count);
+    summary.insert(QStringLiteral("streamed"), m_streamChunks);
 
     DataPacket output;
-    output.insert(QString::fromLatin1(kOutputChunksId), chunkList);
-    output.insert(QString::fromLatin1(kOutputTextId), chunkList);
-    output.insert(QString::fromLatin1(kOutputCountId), chunkList.size());
+    if (!m_streamChunks) {
+        output.insert(QString::fromLatin1(kOutputChunksId), chunkList);
+        output.insert(QString::fromLatin1(kOutputTextId), chunkList);
+    }
+    output.insert(QString::fromLatin1(kOutputCountId), count);
     output.insert(QString::fromLatin1(kOutputSummaryId), summary);
 
     ExecutionToken token;
@@ -130,6 +161,7 @@ QJsonObject TextChunkerNode::saveState() const
     obj.insert(QStringLiteral("chunk_size"), m_chunkSize);
     obj.insert(QStringLiteral("chunk_overlap"), m_chunkOverlap);
     obj.insert(QStringLiteral("file_type"), m_fileType);
+    obj.insert(QStringLiteral("stream_chunks"), m_streamChunks);
     return obj;
 }
 
@@ -144,6 +176,9 @@ void TextChunkerNode::loadState(const QJsonObject& data)
     if (data.contains(QStringLiteral("file_type"))) {
         setFileType(data.value(QStringLiteral("file_type")).toString(m_fileType));
     }
+    if (data.contains(QStringLiteral("stream_chunks"))) {
+        setStreamChunks(data.value(QStringLiteral("stream_chunks")).toBool(m_streamChunks));
+    }
 }
 
 void TextChunkerNode::setChunkSize(int value)
@@ -182,3 +217,12 @@ void TextChunkerNode::setFileType(const QString& fileType)
     m_fileType = normalized;
     emit fileTypeChanged(m_fileType);
 }
+
+void TextChunkerNode::setStreamChunks(bool stream)
+{
+    if (stream == m_streamChunks) {
+        return;
+    }
+    m_streamChunks = stream;
+    emit streamChunksChanged(m_streamChunks);
+}
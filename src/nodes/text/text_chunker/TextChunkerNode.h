@@ -5,6 +5,8 @@
 #include <QObject>
 #include <QString>
 
+class QWidget;
+
 class TextChunkerNode : public QObject, public IToolNode {
     Q_OBJECT
     Q_INTERFACES(IToolNode)
@@ -14,34 +16,45 @@ public:
     ~TextChunkerNode() override = default;
 
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in TextChunkerPropertiesWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     bool isReady(const QVariantMap& inputs, int incomingConnectionsCount) const override;
     TokenList execute(const TokenList& incomingTokens) override;
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
+    // A streaming run's chunks reach downstream nodes only as they are published
+    bool isCacheable() const override { return !m_streamChunks; }
+    bool isDeterministic() const override { return !m_streamChunks; }
 
     int chunkSize() const { return m_chunkSize; }
     int chunkOverlap() const { return m_chunkOverlap; }
     QString fileType() const { return m_fileType; }
+    bool streamChunks() const { return m_streamChunks; }
 
     static constexpr const char* kInputTextId = "text";
     static constexpr const char* kOutputChunksId = "chunks";
     static constexpr const char* kOutputCountId = "count";
     static constexpr const char* kOutputSummaryId = "summary";
     static constexpr const char* kOutputTextId = "text";
+    // One chunk per token while streaming
+    static constexpr const char* kOutputChunkId = "chunk";
 
 public slots:
     void setChunkSize(int value);
     void setChunkOverlap(int value);
     void setFileType(const QString& fileType);
+    void setStreamChunks(bool stream);
 
 signals:
     void chunkSizeChanged(int value);
     void chunkOverlapChanged(int value);
     void fileTypeChanged(const QString& fileType);
+    void streamChunksChanged(bool stream);
 
 private:
     int m_chunkSize {1000};
     int m_chunkOverlap {100};
     QString m_fileType {QStringLiteral("plain")};
+    // Publish each chunk on the chunk pin as it is cut instead of returning the whole list
+    bool m_streamChunks {false};
 };
@@ -2,6 +2,7 @@
 
 #include "TextChunkerNode.h"
 
+#include <QCheckBox>
 #include <QComboBox>
 #include <QFormLayout>
 #include <QSpinBox>
@@ -32,10 +33,15 @@ TextChunkerPropertiesWidget::TextChunkerPropertiesWidget(TextChunkerNode* node,
     m_fileTypeCombo->addItem(tr("YAML / HCL"), QStringLiteral("yaml"));
     form->addRow(tr("File type"), m_fileTypeCombo);
 
+    m_streamChunksCheck = new QCheckBox(tr("Stream chunks to the chunk pin"), this);
+    m_streamChunksCheck->setToolTip(tr("Sends each chunk downstream as soon as it is cut instead of one list at the end"));
+    form->addRow(QString(), m_streamChunksCheck);
+
     if (m_node) {
         setChunkSize(m_node->chunkSize());
         setChunkOverlap(m_node->chunkOverlap());
         setFileType(m_node->fileType());
+        setStreamChunks(m_node->streamChunks());
 
         connect(m_chunkSizeSpin, &QSpinBox::valueChanged,
                 m_node, &TextChunkerNode::setChunkSize);
@@ -47,12 +53,17 @@ TextChunkerPropertiesWidget::TextChunkerPropertiesWidget(TextChunkerNode* node,
             }
         });
 
+        connect(m_streamChunksCheck, &QCheckBox::toggled,
+                m_node, &TextChunkerNode::setStreamChunks);
+
         connect(m_node, &TextChunkerNode::chunkSizeChanged,
                 this, &TextChunkerPropertiesWidget::setChunkSize);
         connect(m_node, &TextChunkerNode::chunkOverlapChanged,
                 this, &TextChunkerPropertiesWidget::setChunkOverlap);
         connect(m_node, &TextChunkerNode::fileTypeChanged,
                 this, &TextChunkerPropertiesWidget::setFileType);
+        connect(m_node, &TextChunkerNode::streamChunksChanged,
+                this, &TextChunkerPropertiesWidget::setStreamChunks);
     }
 }
 
@@ -83,3 +94,15 @@ void TextChunkerPropertiesWidget::setFileType(const QString& fileType)
         m_fileTypeCombo->setCurrentIndex(index);
     }
 }
+
+void TextChunkerPropertiesWidget::setStreamChunks(bool stream)
+{
+    if (m_streamChunksCheck && m_streamChunksCheck->isChecked() != stream) {
+        m_streamChunksCheck->setChecked(stream);
+    }
+}
+
+QWidget* TextChunkerNode::createConfigurationWidget(QWidget* parent)
+{
+    return new TextChunkerPropertiesWidget(this, parent);
+}
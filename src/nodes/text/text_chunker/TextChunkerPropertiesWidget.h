@@ -2,6 +2,7 @@
 
 #include <QWidget>
 
+class QCheckBox;
 class QComboBox;
 class QSpinBox;
 class TextChunkerNode;
@@ -17,10 +18,12 @@ public slots:
     void setChunkSize(int value);
     void setChunkOverlap(int value);
     void setFileType(const QString& fileType);
+    void setStreamChunks(bool stream);
 
 private:
     TextChunkerNode* m_node {nullptr};
     QSpinBox* m_chunkSizeSpin {nullptr};
     QSpinBox* m_chunkOverlapSpin {nullptr};
     QComboBox* m_fileTypeCombo {nullptr};
+    QCheckBox* m_streamChunksCheck {nullptr};
 };
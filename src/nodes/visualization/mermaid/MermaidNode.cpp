@@ -23,14 +23,13 @@
 //
 #include "MermaidNode.h"
 
-#include "MermaidPropertiesWidget.h"
-#include "MermaidRenderService.h"
+#include "MermaidRenderer.h"
+#include "NodeOutputDir.h"
 
 #include <QDir>
 #include <QFileInfo>
 #include "Logger.h"
 #include <QFile>
-#include <QMetaObject>
 #include <QStandardPaths>
 #include <QTemporaryFile>
 #include <QUuid>
@@ -67,19 +66,6 @@ NodeDescriptor MermaidNode::getDescriptor() const
     return desc;
 }
 
-QWidget* MermaidNode::createConfigurationWidget(QWidget* parent)
-{
-    auto* widget = new MermaidPropertiesWidget(parent);
-    widget->setCode(m_lastCode);
-    widget->setScale(m_scaleFactor);
-    connect(widget, &MermaidPropertiesWidget::scaleChanged, this, [this](double value) {
-        if (value < 0.1) value = 0.1;
-        m_scaleFactor = value;
-    });
-    m_propertiesWidget = widget;
-    return widget;
-}
-
 TokenList MermaidNode::execute(const TokenList& incomingTokens)
 {
     DataPacket inputs;
@@ -105,15 +91,30 @@ TokenList MermaidNode::execute(const TokenList& incomingTokens)
         return TokenList{token};
     }
 
+    // cp-run without the cp_mermaid_webengine plugin has no renderer
+    MermaidRenderer* renderer = MermaidRenderer::instance();
+    if (!renderer) {
+        const QString err = QStringLiteral("ERROR: No Mermaid renderer is available; cp-run needs the cp_mermaid_webengine plugin next to it.");
+        output.insert(outputPinId, err);
+        output.insert(QStringLiteral("__error"), err);
+
+        ExecutionToken token;
+        token.data = output;
+        return TokenList{token};
+    }
+
     // Step 1: Resolve Output Path
-    QString sysOutDir = inputs.value(QStringLiteral("_sys_node_output_dir")).toString();
+    QString sysOutDir = NodeOutputDir::materialize(inputs);
     QString outputPath;
     bool isPersistent = !sysOutDir.isEmpty();
     std::unique_ptr<QTemporaryFile> tempFile;
 
+    // Headless renders skip the screen grab and write the SVG itself
+    const QString extension = MermaidRenderer::isHeadless() ? QStringLiteral("svg") : QStringLiteral("png");
+
     if (isPersistent) {
         // Case A: Persistent Output
-        outputPath = sysOutDir + QDir::separator() + QStringLiteral("diagram.png");
+        outputPath = sysOutDir + QDir::separator() + QStringLiteral("diagram.") + extension;
 
         // Bonus: Write source to file for debugging
         QString sourcePath = sysOutDir + QDir::separator() + QStringLiteral("source.mmd");
@@ -128,7 +129,7 @@ TokenList MermaidNode::execute(const TokenList& incomingTokens)
         QString tempDir = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
         if (tempDir.isEmpty()) tempDir = QDir::tempPath();
 
-        tempFile = std::make_unique<QTemporaryFile>(tempDir + QDir::separator() + QStringLiteral("mermaid_render_XXXXXX.png"));
+        tempFile = std::make_unique<QTemporaryFile>(tempDir + QDir::separator() + QStringLiteral("mermaid_render_XXXXXX.") + extension);
         tempFile->setAutoRemove(false);
         if (!tempFile->open()) {
             const QString err = QStringLiteral("ERROR: Could not create temporary file for Mermaid render.");
@@ -147,7 +148,7 @@ TokenList MermaidNode::execute(const TokenList& incomingTokens)
         m_scaleFactor = 0.1;
     }
 
-    const auto renderResult = MermaidRenderService::instance().renderMermaid(code, outputPath, m_scaleFactor);
+    const MermaidRenderer::Result renderResult = renderer->render(code, outputPath, m_scaleFactor);
 
     QFileInfo fileInfo(outputPath);
     if (!renderResult.ok || !fileInfo.exists()) {
@@ -163,10 +164,11 @@ TokenList MermaidNode::execute(const TokenList& incomingTokens)
         if (renderResult.clamped && !renderResult.detail.isEmpty()) {
             output.insert(QStringLiteral("__warning"), renderResult.detail);
         }
+        output.insert(QStringLiteral("_cache_hit"), renderResult.cached);
     }
 
     m_lastCode = code;
-    updatePropertiesWidget(code);
+    emit renderedCodeChanged(code, m_scaleFactor);
 
     ExecutionToken token;
     token.data = output;
@@ -196,18 +198,5 @@ void MermaidNode::loadState(const QJsonObject& data)
             }
         }
     }
-    updatePropertiesWidget(m_lastCode);
-}
-
-void MermaidNode::updatePropertiesWidget(const QString& code)
-{
-    auto* widget = m_propertiesWidget.data();
-    if (!widget) return;
-
-    const double scale = m_scaleFactor;
-
-    QMetaObject::invokeMethod(widget, [widget, code, scale]() {
-        widget->setCode(code);
-        widget->setScale(scale);
-    }, Qt::QueuedConnection);
+    emit renderedCodeChanged(m_lastCode, m_scaleFactor);
 }
@@ -24,14 +24,13 @@
 #pragma once
 
 #include <QObject>
-#include <QPointer>
 #include <QTemporaryFile>
 #include <memory>
 
 #include "IToolNode.h"
 #include "CommonDataTypes.h"
 
-class MermaidPropertiesWidget;
+class QWidget;
 
 class MermaidNode : public QObject, public IToolNode {
     Q_OBJECT
@@ -42,8 +41,10 @@ public:
 
     // IToolNode interface
     NodeDescriptor getDescriptor() const override;
-    QWidget* createConfigurationWidget(QWidget* parent) override;
+    // Defined in MermaidPropertiesWidget.cpp, outside the headless core
+    QWidget* createConfigurationWidget(QWidget* parent);
     TokenList execute(const TokenList& incomingTokens) override;
+    ResourceClass resourceClass() const override { return ResourceClass::Process; }
     QJsonObject saveState() const override;
     void loadState(const QJsonObject& data) override;
 
@@ -53,12 +54,10 @@ public:
 
 signals:
     void finished();
+    // The code last rendered (or loaded) and its scale, for the properties widget
+    void renderedCodeChanged(const QString& code, double scale);
 
 private:
-    void updatePropertiesWidget(const QString& code);
-
-private:
-    QPointer<MermaidPropertiesWidget> m_propertiesWidget;
     QString m_lastCode;
     double m_scaleFactor {1.0};
 };
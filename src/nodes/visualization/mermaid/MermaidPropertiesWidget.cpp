@@ -22,6 +22,7 @@
 // SOFTWARE.
 //
 #include "MermaidPropertiesWidget.h"
+#include "MermaidNode.h"
 
 #include <QDoubleSpinBox>
 #include <QFontDatabase>
@@ -86,3 +87,20 @@ void MermaidPropertiesWidget::setScale(double value)
     QSignalBlocker blocker(m_scaleSpin);
     m_scaleSpin->setValue(value);
 }
+
+QWidget* MermaidNode::createConfigurationWidget(QWidget* parent)
+{
+    auto* widget = new MermaidPropertiesWidget(parent);
+    widget->setCode(m_lastCode);
+    widget->setScale(m_scaleFactor);
+    connect(widget, &MermaidPropertiesWidget::scaleChanged, this, [this](double value) {
+        if (value < 0.1) value = 0.1;
+        m_scaleFactor = value;
+    });
+    // Renders finish on the engine's worker thread; the update is queued to the widget
+    connect(this, &MermaidNode::renderedCodeChanged, widget, [widget](const QString& code, double scale) {
+        widget->setCode(code);
+        widget->setScale(scale);
+    });
+    return widget;
+}
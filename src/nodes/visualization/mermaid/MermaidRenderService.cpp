@@ -26,21 +26,29 @@
 
 #include <QCoreApplication>
 #include "Logger.h"
+#include <QColor>
+#include <QCryptographicHash>
 #include <QDir>
 #include <QEventLoop>
 #include <QFile>
 #include <QFileInfo>
+#include <QImage>
 #include <QImageReader>
+#include <QJsonArray>
+#include <QJsonDocument>
 #include <QGuiApplication>
 #include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QPointer>
+#include <QPromise>
 #include <QScreen>
 #include <QMetaObject>
 #include <QPixmap>
+#include <QSaveFile>
 #include <QStandardPaths>
 #include <QThread>
 #include <QTimer>
 #include <QUrl>
-#include <QUrlQuery>
 #include <QVariant>
 #include <QWebEngineLoadingInfo>
 #include <QWebEnginePage>
@@ -50,6 +58,7 @@
 #include <QUuid>
 #include <algorithm>
 #include <cmath>
+#include <functional>
 
 namespace {
 constexpr int kDefaultWidth = 1024;
@@ -86,6 +95,105 @@ QString formatClampDetail(double requestedScale,
         .arg(viewHeight)
         .arg(devicePixelRatio, 0, 'f', 2);
 }
+
+bool isBlank(const QPixmap& p) {
+    if (p.isNull()) return true;
+    const QImage img = p.toImage();
+    if (img.isNull()) return true;
+
+    const int w = img.width();
+    const int h = img.height();
+    if (w == 0 || h == 0) return true;
+
+    // Sample more points for wide diagrams to see if it's all white or transparent
+    // We check a few vertical spans to be sure we don't miss thin lines
+    for (int i = 1; i < 10; ++i) {
+        int x = i * w / 10;
+        for (int y = 0; y < h; y += std::max(1, h / 5)) {
+            if (x >= w || y >= h) continue;
+            const QColor c = img.pixelColor(x, y);
+            // "Ink" is anything not fully transparent and not "almost white"
+            if (c.alpha() > 0 && (c.red() < 250 || c.green() < 250 || c.blue() < 250)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+QString startRenderScript(const QString& mermaidCode) {
+    // The source goes in as a JSON string literal, so no escaping reaches the page
+    QString sourceLiteral = QString::fromUtf8(QJsonDocument(QJsonArray{mermaidCode}).toJson(QJsonDocument::Compact));
+    sourceLiteral = sourceLiteral.mid(1, sourceLiteral.size() - 2);
+
+    return QStringLiteral("window.__mermaidSource = ") + sourceLiteral + QStringLiteral(";") + QStringLiteral(
+        "(() => {"
+        "  const container = document.getElementById('mermaid-container');"
+        "  const meta = { mermaidType: typeof mermaid, hasContainer: !!container };"
+        "  window.__mermaidRenderResult = null;"
+        "  const fail = (msg) => { window.__mermaidRenderResult = { ok: false, error: msg, ...meta }; return 'fail'; };"
+        "  if (typeof mermaid === 'undefined') { return fail('FATAL: mermaid object is undefined. Library did not load.'); }"
+        "  if (!container) { return fail('mermaid container not found'); }"
+        "  container.innerHTML = '';"
+        "  Array.from(document.body.children).forEach((el) => { if (el !== container && el.tagName !== 'SCRIPT') el.remove(); });"
+        "  const run = async () => {"
+        "    try {"
+        "      const code = String(window.__mermaidSource || '').trim();"
+        "      if (!code) { return fail('mermaid code is empty'); }"
+        "      if (!window.__mermaidInitialized) { mermaid.initialize({ startOnLoad: false, securityLevel: 'loose' }); window.__mermaidInitialized = true; }"
+        "      window.__mermaidRenderCount = (window.__mermaidRenderCount || 0) + 1;"
+        "      const renderResult = await mermaid.render('rendered-mermaid-' + window.__mermaidRenderCount, code, container);"
+        "      container.innerHTML = renderResult && renderResult.svg ? renderResult.svg : '';"
+        "      const svg = container.querySelector('svg');"
+        "      const bbox = svg && svg.getBBox ? svg.getBBox() : null;"
+        "      const rect = svg && svg.getBoundingClientRect ? svg.getBoundingClientRect() : null;"
+        "      const width = Math.max(bbox ? bbox.width : 0, rect ? rect.width : 0);"
+        "      const height = Math.max(bbox ? bbox.height : 0, rect ? rect.height : 0);"
+        "      const docEl = document.documentElement;"
+        "      const body = document.body;"
+        "      const bodyStyle = body && window.getComputedStyle ? window.getComputedStyle(body) : null;"
+        "      const metrics = {"
+        "        htmlScrollWidth: docEl ? docEl.scrollWidth : null,"
+        "        htmlScrollHeight: docEl ? docEl.scrollHeight : null,"
+        "        htmlClientWidth: docEl ? docEl.clientWidth : null,"
+        "        htmlClientHeight: docEl ? docEl.clientHeight : null,"
+        "        bodyScrollWidth: body ? body.scrollWidth : null,"
+        "        bodyScrollHeight: body ? body.scrollHeight : null,"
+        "        bodyClientWidth: body ? body.clientWidth : null,"
+        "        bodyClientHeight: body ? body.clientHeight : null,"
+        "        bodyMarginLeft: bodyStyle ? bodyStyle.marginLeft : null,"
+        "        bodyMarginRight: bodyStyle ? bodyStyle.marginRight : null,"
+        "        bodyOverflowX: bodyStyle ? bodyStyle.overflowX : null,"
+        "        bodyOverflowY: bodyStyle ? bodyStyle.overflowY : null"
+        "      };"
+        "      if (!width || !height) { return fail('mermaid produced zero-sized svg'); }"
+        "      window.__mermaidRenderResult = { ok: !!svg, error: svg ? null : 'no svg generated', width: width, height: height, bboxWidth: bbox ? bbox.width : null, bboxHeight: bbox ? bbox.height : null, rectWidth: rect ? rect.width : null, rectHeight: rect ? rect.height : null, svgPresent: !!svg, codeLength: code.length, ...metrics, ...meta };"
+        "      return window.__mermaidRenderResult.ok ? 'render-succeeded' : 'render-no-svg';"
+        "    } catch (e) { return fail('JS Exception: ' + (e ? (e.message || e.toString()) : 'Unknown error')); }"
+        "  };"
+        "  run();"
+        "  return 'render-started';"
+        "})()"
+    );
+}
+
+// A standalone copy of the rendered SVG, sized to the diagram times the scale
+QString svgMarkupScript(double scaleFactor) {
+    return QStringLiteral(
+        "(() => {"
+        "  const svg = document.querySelector('#mermaid-container svg');"
+        "  if (!svg) { return ''; }"
+        "  const view = svg.viewBox && svg.viewBox.baseVal && svg.viewBox.baseVal.width ? svg.viewBox.baseVal : svg.getBBox();"
+        "  const scale = %1;"
+        "  const copy = svg.cloneNode(true);"
+        "  copy.setAttribute('width', String(Math.ceil(view.width * scale)));"
+        "  copy.setAttribute('height', String(Math.ceil(view.height * scale)));"
+        "  copy.style.removeProperty('max-width');"
+        "  copy.setAttribute('xmlns', 'http://www.w3.org/2000/svg');"
+        "  return new XMLSerializer().serializeToString(copy);"
+        "})()")
+        .arg(scaleFactor, 0, 'g', 6);
+}
 } // namespace
 
 MermaidRenderService& MermaidRenderService::instance() {
@@ -93,6 +201,10 @@ MermaidRenderService& MermaidRenderService::instance() {
     return instance;
 }
 
+void MermaidRenderService::install() {
+    MermaidRenderer::setInstance(&instance());
+}
+
 MermaidRenderService::MermaidRenderService(QObject* parent)
     : QObject(parent) {
     // Ensure the service lives on the main (GUI) thread so rendering happens
@@ -101,6 +213,30 @@ MermaidRenderService::MermaidRenderService(QObject* parent)
     if (QCoreApplication::instance() && thread() != QCoreApplication::instance()->thread()) {
         moveToThread(QCoreApplication::instance()->thread());
     }
+    // Warm pages must close while WebEngine is still up, not at static destruction
+    if (QCoreApplication::instance()) {
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, [this]() {
+            m_idleViews.clear();
+            m_idlePages.clear();
+        });
+    }
+}
+
+MermaidRenderService::~MermaidRenderService() {
+    // Past the application's lifetime a view can no longer be destroyed safely
+    if (!QCoreApplication::instance()) {
+        for (auto& view : m_idleViews) {
+            static_cast<void>(view.release());
+        }
+        for (auto& page : m_idlePages) {
+            static_cast<void>(page.release());
+        }
+    }
+    m_idleViews.clear();
+    m_idlePages.clear();
+    if (!m_pageFile.isEmpty()) {
+        QFile::remove(m_pageFile);
+    }
 }
 
 void MermaidRenderService::ensureProfileInitialized() {
@@ -132,160 +268,68 @@ void MermaidRenderService::ensureProfileInitialized() {
     m_profileInitialized = true;
 }
 
-MermaidRenderService::RenderResult MermaidRenderService::renderMermaid(const QString& mermaidCode, const QString& outputPath, double scaleFactor) {
-    RenderResult result;
-
-    // Avoid BlockingQueuedConnection deadlock when already on the target thread
-    // (e.g., UI thread). Use a direct call in that case; otherwise block until
-    // the render finishes on the object's (GUI) thread.
-    if (QThread::currentThread() == thread()) {
-        renderOnMainThread(mermaidCode, outputPath, scaleFactor, &result);
-    } else {
-        QMetaObject::invokeMethod(
-            this,
-            "renderOnMainThread",
-            Qt::BlockingQueuedConnection,
-            Q_ARG(QString, mermaidCode),
-            Q_ARG(QString, outputPath),
-            Q_ARG(double, scaleFactor),
-            Q_ARG(MermaidRenderService::RenderResult*, &result));
-    }
-
-    if (!result.ok && result.error.isEmpty()) {
-        result.error = QStringLiteral("Mermaid rendering failed for %1").arg(outputPath);
-    }
-
-    if (!result.ok) {
-        CP_WARN << "MermaidRenderService::renderMermaid failed for output" << outputPath << "error" << result.error;
-    }
-
-    return result;
+QString MermaidRenderService::renderCacheKey(const QString& mermaidCode, double scaleFactor, const QString& format, double devicePixelRatio)
+{
+    // Themes are set by %%{init}%% directives in the source, so the source hash covers them
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(mermaidCode.toUtf8());
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(QByteArray::number(scaleFactor, 'g', 6));
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(format.toUtf8());
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(QByteArray::number(devicePixelRatio, 'g', 6));
+    return QString::fromLatin1(hash.result().toHex());
 }
 
-MermaidRenderService::RenderSizing MermaidRenderService::planRenderSizing(double svgWidth, double svgHeight, double scaleFactor, double devicePixelRatio) {
-    RenderSizing sizing;
-
-    double scale = scaleFactor;
-    if (scale < kMinScale) {
-        scale = kMinScale;
-    }
-    double dpr = devicePixelRatio > 0.0 ? devicePixelRatio : 1.0;
-
-    const double paddedWidth = (svgWidth > 0.0 ? std::ceil(svgWidth) : kDefaultWidth) + kPadding;
-    const double paddedHeight = (svgHeight > 0.0 ? std::ceil(svgHeight) : kDefaultHeight) + kPadding;
-
-    const double requestedWidth = paddedWidth * scale;
-    const double requestedHeight = paddedHeight * scale;
-
-    const double requestedWidthPixels = requestedWidth * dpr;
-    const double requestedHeightPixels = requestedHeight * dpr;
-    const double requestedBytes = requestedWidthPixels * requestedHeightPixels * 4.0; // RGBA
-
-    double clampScale = 1.0;
-
-    // Dimension-based clamp to avoid exceeding texture/pixmap limits (account for devicePixelRatio)
-    if (requestedWidthPixels > kMaxDimension || requestedHeightPixels > kMaxDimension) {
-        const double dimScale = std::min(kMaxDimension / requestedWidthPixels, kMaxDimension / requestedHeightPixels);
-        clampScale = std::min(clampScale, dimScale);
-    }
-
-    // Tile memory budget clamp to avoid Chromium tile manager failures
-    const qint64 tileBudgetBytes = static_cast<qint64>(kTileMemoryBudgetMb) * 1024 * 1024;
-    if (tileBudgetBytes > 0 && requestedBytes > static_cast<double>(tileBudgetBytes)) {
-        const double tileScale = std::sqrt(static_cast<double>(tileBudgetBytes) / requestedBytes);
-        clampScale = std::min(clampScale, tileScale);
-    }
-
-    // Memory-based clamp using QImageReader allocation limit (in MB)
-    const int allocLimitMb = QImageReader::allocationLimit();
-    const qint64 maxBytes = allocLimitMb > 0 ? static_cast<qint64>(allocLimitMb) * 1024 * 1024 : 0;
-    if (maxBytes > 0) {
-        if (requestedBytes > static_cast<double>(maxBytes)) {
-            const double byteScale = std::sqrt(static_cast<double>(maxBytes) / requestedBytes);
-            clampScale = std::min(clampScale, byteScale);
+bool MermaidRenderService::takeCachedRender(const QString& key, const QString& outputPath, RenderResult* result)
+{
+    QByteArray image;
+    {
+        QMutexLocker locker(&m_cacheMutex);
+        const CachedRender* cached = m_renders.object(key);
+        if (!cached) {
+            return false;
         }
+        image = cached->image;
+        *result = cached->result;
     }
 
-    if (clampScale < kMinClampScale) {
-        sizing.error = QStringLiteral("Requested render size %1x%2 (scale %3, dpr %4) exceeds safe limits; reduce the resolution scale.")
-                           .arg(std::ceil(requestedWidthPixels))
-                           .arg(std::ceil(requestedHeightPixels))
-                           .arg(scaleFactor, 0, 'f', 2)
-                           .arg(dpr, 0, 'f', 2);
-        return sizing;
-    }
-
-    sizing.effectiveScale = scale * clampScale;
-    sizing.viewWidth = static_cast<int>(std::ceil(paddedWidth * sizing.effectiveScale));
-    sizing.viewHeight = static_cast<int>(std::ceil(paddedHeight * sizing.effectiveScale));
-
-    const double maxViewWidth = static_cast<double>(kMaxDimension) / dpr;
-    const double maxViewHeight = static_cast<double>(kMaxDimension) / dpr;
-    if (sizing.viewWidth > maxViewWidth) sizing.viewWidth = static_cast<int>(std::floor(maxViewWidth));
-    if (sizing.viewHeight > maxViewHeight) sizing.viewHeight = static_cast<int>(std::floor(maxViewHeight));
-
-    sizing.clamped = std::abs(sizing.effectiveScale - scale) > 1e-6
-                     || sizing.viewWidth < static_cast<int>(std::ceil(requestedWidth))
-                     || sizing.viewHeight < static_cast<int>(std::ceil(requestedHeight));
-    if (sizing.clamped) {
-        sizing.detail = QStringLiteral("Scale %1 clamped to %2; render size %3x%4 (dpr %5)")
-                            .arg(scaleFactor, 0, 'f', 2)
-                            .arg(sizing.effectiveScale, 0, 'f', 2)
-                            .arg(sizing.viewWidth)
-                            .arg(sizing.viewHeight)
-                            .arg(dpr, 0, 'f', 2);
+    QSaveFile file(outputPath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(image) != image.size() || !file.commit()) {
+        *result = RenderResult{};
+        return false;
     }
-
-    return sizing;
+    result->cached = true;
+    return true;
 }
 
-QString MermaidRenderService::formatClampDetail(double requestedScale,
-                                                double effectiveScale,
-                                                const QString& reason,
-                                                int viewWidth,
-                                                int viewHeight,
-                                                double devicePixelRatio)
+void MermaidRenderService::storeCachedRender(const QString& key, const QString& outputPath, const RenderResult& result)
 {
-    return ::formatClampDetail(requestedScale, effectiveScale, reason, viewWidth, viewHeight, devicePixelRatio);
-}
-
-void MermaidRenderService::renderOnMainThread(const QString& mermaidCode, const QString& outputPath, double scaleFactor, RenderResult* result) {
-    if (!result) {
-        CP_WARN << "MermaidRenderService::renderOnMainThread called with null result pointer";
+    QFile file(outputPath);
+    if (!file.open(QIODevice::ReadOnly)) {
         return;
     }
+    auto cached = std::make_unique<CachedRender>();
+    cached->image = file.readAll();
+    cached->result = result;
+    const qsizetype cost = qMax<qsizetype>(1, cached->image.size());
 
-    *result = RenderResult{};
-    result->requestedScale = scaleFactor;
-    result->effectiveScale = scaleFactor;
-    if (scaleFactor < 0.1) {
-        scaleFactor = 0.1;
-    }
-
-    // Increase the global image allocation limit so large-but-bounded renders can be read back
-    // (still subject to explicit clamping checks below).
-    static bool allocationLimitRaised = false;
-    if (!allocationLimitRaised) {
-        const int currentLimit = QImageReader::allocationLimit();
-        const int targetLimit = std::max(currentLimit, kTargetAllocationLimitMb);
-        QImageReader::setAllocationLimit(targetLimit);
-        allocationLimitRaised = true;
-    }
-
-    ensureProfileInitialized();
+    QMutexLocker locker(&m_cacheMutex);
+    m_renders.insert(key, cached.release(), cost);
+}
 
-    const QFileInfo outputInfo(outputPath);
-    QDir outputDir = outputInfo.dir();
-    if (!outputDir.exists() && !outputDir.mkpath(QStringLiteral("."))) {
-        result->error = QStringLiteral("Could not create output directory: %1").arg(outputPath);
-        return;
-    }
+void MermaidRenderService::clearRenderCache()
+{
+    QMutexLocker locker(&m_cacheMutex);
+    m_renders.clear();
+}
 
-    QString tempDir = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
-    if (tempDir.isEmpty()) {
-        tempDir = QDir::tempPath();
+QString MermaidRenderService::pageFilePath(QString* error)
+{
+    if (!m_pageFile.isEmpty() && QFileInfo::exists(m_pageFile)) {
+        return m_pageFile;
     }
-    QDir systemTempDir(tempDir);
 
     const QString templateResource = QStringLiteral(":/mermaid/template.html");
     const QString jsResource = QStringLiteral(":/mermaid/mermaid.min.js");
@@ -296,8 +340,8 @@ void MermaidRenderService::renderOnMainThread(const QString& mermaidCode, const
         templateHtml = QString::fromUtf8(templateFile.readAll());
         templateFile.close();
     } else {
-        result->error = QStringLiteral("Could not read Mermaid template HTML");
-        return;
+        *error = QStringLiteral("Could not read Mermaid template HTML");
+        return QString();
     }
 
     QFile libFile(jsResource);
@@ -306,8 +350,8 @@ void MermaidRenderService::renderOnMainThread(const QString& mermaidCode, const
         mermaidLibJs = QString::fromUtf8(libFile.readAll());
         libFile.close();
     } else {
-        result->error = QStringLiteral("Could not read mermaid library script");
-        return;
+        *error = QStringLiteral("Could not read mermaid library script");
+        return QString();
     }
 
     const QString inlineScriptTag = QStringLiteral("<script>%1</script>").arg(mermaidLibJs);
@@ -338,597 +382,913 @@ void MermaidRenderService::renderOnMainThread(const QString& mermaidCode, const
         templateHtml.prepend(enforcedCss);
     }
 
-    const QString runNonce = QUuid::createUuid().toString(QUuid::WithoutBraces);
-    const QString codePath = systemTempDir.filePath(QStringLiteral("mermaid_input_%1.mmd").arg(runNonce));
-    {
-        QFile codeFile(codePath);
-        if (codeFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
-            const QByteArray utf8 = mermaidCode.toUtf8();
-            if (codeFile.write(utf8) != utf8.size()) {
-                result->error = QStringLiteral("Failed to write Mermaid input to %1").arg(codePath);
-                return;
+    QString tempDir = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
+    if (tempDir.isEmpty()) {
+        tempDir = QDir::tempPath();
+    }
+    const QString path = QDir(tempDir).filePath(
+        QStringLiteral("mermaid_page_%1.html").arg(QUuid::createUuid().toString(QUuid::WithoutBraces)));
+    QFile pageFile(path);
+    if (!pageFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        *error = QStringLiteral("Failed to write Mermaid page %1: %2").arg(path, pageFile.errorString());
+        return QString();
+    }
+    pageFile.write(templateHtml.toUtf8());
+    pageFile.close();
+    CP_CLOG(MERMAID_DEBUG) << "Generated Mermaid page:" << path;
+
+    m_pageFile = path;
+    return m_pageFile;
+}
+
+// One render, carried forward by WebEngine signals, script replies and timers
+// on the GUI thread. Every wait bumps m_step; a reply or timer that belongs to
+// an earlier step, or to a job that is gone, is dropped.
+class MermaidRenderService::Job : public QObject {
+public:
+    Job(MermaidRenderService* service,
+        const QString& mermaidCode,
+        const QString& outputPath,
+        double scaleFactor,
+        std::shared_ptr<QPromise<RenderResult>> promise)
+        : QObject(service)
+        , m_service(service)
+        , m_code(mermaidCode)
+        , m_outputPath(outputPath)
+        , m_scaleFactor(scaleFactor)
+        , m_promise(std::move(promise)) {
+        m_timeoutTimer.setSingleShot(true);
+    }
+
+    void start();
+
+private:
+    QWebEnginePage* page() const { return m_view ? m_view->page() : m_page.get(); }
+
+    std::function<void(const QVariant&)> reply(std::function<void(const QVariant&)> handler);
+    void wait(int timeoutMs, std::function<void()> onTimeout, int pollMs = 0, std::function<void()> tick = {});
+    void stopWaiting();
+    void after(int delayMs, std::function<void()> next);
+
+    void loadPage(const QString& pagePath);
+    void beginRender();
+    void onRendered(const QVariantMap& renderResult);
+    void writeSvg();
+    void writeDebugSnapshot();
+    void applySizing(const RenderSizing& sizing, const QString& timeoutError, std::function<void()> next);
+    void waitForViewport(int targetWidth, int targetHeight, std::function<void(bool)> done);
+    void checkViewport(std::function<void(bool)> done);
+    void grab(int attemptsLeft, std::function<void(bool)> done);
+    void capture(std::function<void(bool)> done);
+    void captureAfterSizing();
+    void enforceLimit(qint64 byteLimit, const QString& label, std::function<void()> next);
+    void save();
+    void fail(const QString& error);
+    void complete();
+
+    MermaidRenderService* m_service;
+    const QString m_code;
+    const QString m_outputPath;
+    double m_scaleFactor;
+    std::shared_ptr<QPromise<RenderResult>> m_promise;
+
+    RenderResult m_result;
+    bool m_svg {false};
+    bool m_finished {false};
+    QString m_cacheKey;
+    QString m_loadError;
+    const QString m_runNonce = QUuid::createUuid().toString(QUuid::WithoutBraces);
+
+    // Exactly one is set: a view for screen grabs, a bare page for SVG
+    std::unique_ptr<QWebEngineView> m_view;
+    std::unique_ptr<QWebEnginePage> m_page;
+
+    int m_step {0};
+    QTimer m_pollTimer;
+    QTimer m_timeoutTimer;
+
+    double m_svgWidth {0.0};
+    double m_svgHeight {0.0};
+    double m_screenDpr {1.0};
+    double m_dpr {1.0};
+    RenderSizing m_sizing;
+    QStringList m_detailParts;
+
+    QPixmap m_shot;
+    qint64 m_shotPixelWidth {0};
+    qint64 m_shotPixelHeight {0};
+    qint64 m_estimatedBytes {0};
+    qreal m_shotDpr {1.0};
+
+    // Viewport metrics last reported while waiting for a resize
+    QElapsedTimer m_logClock;
+    int m_lastJsWidth {-1};
+    int m_lastJsHeight {-1};
+    int m_lastDocWidth {-1};
+    int m_lastDocHeight {-1};
+    int m_lastBodyWidth {-1};
+    int m_lastBodyHeight {-1};
+    double m_lastJsDpr {-1.0};
+};
+
+std::function<void(const QVariant&)> MermaidRenderService::Job::reply(std::function<void(const QVariant&)> handler) {
+    return [self = QPointer<Job>(this), step = m_step, handler = std::move(handler)](const QVariant& value) {
+        if (self && self->m_step == step) {
+            handler(value);
+        }
+    };
+}
+
+void MermaidRenderService::Job::wait(int timeoutMs, std::function<void()> onTimeout, int pollMs, std::function<void()> tick) {
+    stopWaiting();
+    const int step = m_step;
+    QObject::connect(&m_timeoutTimer, &QTimer::timeout, this, [this, step, onTimeout]() {
+        if (m_step == step) {
+            m_pollTimer.stop();
+            onTimeout();
+        }
+    });
+    m_timeoutTimer.start(timeoutMs);
+    if (pollMs > 0 && tick) {
+        QObject::connect(&m_pollTimer, &QTimer::timeout, this, [this, step, tick]() {
+            if (m_step == step) {
+                tick();
             }
-            codeFile.close();
-        } else {
-            result->error = QStringLiteral("Could not open %1 for writing").arg(codePath);
-            return;
+        });
+        m_pollTimer.start(pollMs);
+        tick();
+    }
+}
+
+void MermaidRenderService::Job::stopWaiting() {
+    m_pollTimer.stop();
+    m_timeoutTimer.stop();
+    m_pollTimer.disconnect(this);
+    m_timeoutTimer.disconnect(this);
+}
+
+void MermaidRenderService::Job::after(int delayMs, std::function<void()> next) {
+    ++m_step;
+    QTimer::singleShot(delayMs, this, [this, step = m_step, next]() {
+        if (m_step == step) {
+            next();
         }
+    });
+}
+
+void MermaidRenderService::Job::start() {
+    m_result.requestedScale = m_scaleFactor;
+    m_result.effectiveScale = m_scaleFactor;
+    if (m_scaleFactor < kMinScale) {
+        m_scaleFactor = kMinScale;
     }
 
-    const QString artifactPath = systemTempDir.filePath(QStringLiteral("mermaid_debug_%1.html").arg(runNonce));
-    CP_CLOG(MERMAID_DEBUG) << "Generated temp file:" << artifactPath;
-    const QString logPrefix = QStringLiteral("[MermaidRender %1]").arg(runNonce);
+    // Increase the global image allocation limit so large-but-bounded renders can be read back
+    // (still subject to explicit clamping checks below).
+    static bool allocationLimitRaised = false;
+    if (!allocationLimitRaised) {
+        const int currentLimit = QImageReader::allocationLimit();
+        const int targetLimit = std::max(currentLimit, kTargetAllocationLimitMb);
+        QImageReader::setAllocationLimit(targetLimit);
+        allocationLimitRaised = true;
+    }
 
-    QWebEngineView view;
-    view.setWindowFlag(Qt::Tool, true);
-    view.setWindowFlag(Qt::FramelessWindowHint, true);
-    view.move(-20000, -20000);
-    view.setAttribute(Qt::WA_DontShowOnScreen, true);
-    auto* page = view.page();
+    m_service->ensureProfileInitialized();
 
-    // Enable local file access and remote resources if needed.
-    // fetch() on file:// URLs often requires these settings.
-    auto* settings = page->settings();
-    settings->setAttribute(QWebEngineSettings::LocalContentCanAccessFileUrls, true);
-    settings->setAttribute(QWebEngineSettings::LocalContentCanAccessRemoteUrls, true);
+    const QFileInfo outputInfo(m_outputPath);
+    QDir outputDir = outputInfo.dir();
+    if (!outputDir.exists() && !outputDir.mkpath(QStringLiteral("."))) {
+        fail(QStringLiteral("Could not create output directory: %1").arg(m_outputPath));
+        return;
+    }
 
-    QUrl inputUrl = QUrl::fromLocalFile(codePath);
-    const QString inlineInputPath = inputUrl.toString(QUrl::FullyEncoded).replace(QStringLiteral("'"), QStringLiteral("\\'"));
+    const QString format = outputInfo.suffix().toLower();
+    m_svg = MermaidRenderer::isHeadless() || format == QLatin1String("svg");
+    m_screenDpr = qApp && qApp->primaryScreen() ? qApp->primaryScreen()->devicePixelRatio() : 1.0;
+    m_cacheKey = m_svg ? renderCacheKey(m_code, m_scaleFactor, QStringLiteral("svg"), 1.0)
+                       : renderCacheKey(m_code, m_scaleFactor, format, m_screenDpr);
+    RenderResult cached;
+    if (m_service->takeCachedRender(m_cacheKey, m_outputPath, &cached)) {
+        CP_CLOG(MERMAID_DEBUG) << "Served cached render to:" << m_outputPath;
+        m_result = cached;
+        complete();
+        return;
+    }
 
-    const QString fullHtml = templateHtml + QStringLiteral(R"(
-<!-- Injected by MermaidRenderService -->
-<script>window.__mermaidInputPath='%1';</script>
-<!-- Instrumentation note: initial HTML written before render; a post-render snapshot will overwrite this file. -->
-)")
-                                         .arg(inlineInputPath);
+    if (m_svg) {
+        m_page = m_service->takeIdlePage();
+    } else {
+        m_view = m_service->takeIdleView();
+    }
+    if (page()) {
+        beginRender();
+        return;
+    }
 
-    {
-        QFile artifactFile(artifactPath);
-        if (artifactFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
-            artifactFile.write(fullHtml.toUtf8());
-            artifactFile.close();
-        } else {
-            result->error = QStringLiteral("Failed to write artifact %1: %2").arg(artifactPath, artifactFile.errorString());
-            return;
-        }
+    QString error;
+    const QString pagePath = m_service->pageFilePath(&error);
+    if (pagePath.isEmpty()) {
+        fail(error);
+        return;
     }
+    loadPage(pagePath);
+}
 
-    QObject::connect(page, &QWebEnginePage::renderProcessTerminated, &view, [result](QWebEnginePage::RenderProcessTerminationStatus status, int code) {
-        if (!result->ok) {
-            result->error = QStringLiteral("Render process terminated (%1) code %2").arg(static_cast<int>(status)).arg(code);
-        }
-    });
+void MermaidRenderService::Job::loadPage(const QString& pagePath) {
+    if (m_svg) {
+        m_page = std::make_unique<QWebEnginePage>();
+    } else {
+        m_view = std::make_unique<QWebEngineView>();
+        m_view->setWindowFlag(Qt::Tool, true);
+        m_view->setWindowFlag(Qt::FramelessWindowHint, true);
+        m_view->move(-20000, -20000);
+        m_view->setAttribute(Qt::WA_DontShowOnScreen, true);
+        // Diagrams are laid out at the size a fresh view has; a view is put back to it after each render
+        m_service->m_initialPageSize = m_view->size();
+    }
+
+    // Enable local file access and remote resources if needed.
+    auto* settings = page()->settings();
+    settings->setAttribute(QWebEngineSettings::LocalContentCanAccessFileUrls, true);
+    settings->setAttribute(QWebEngineSettings::LocalContentCanAccessRemoteUrls, true);
 
-    QObject::connect(page, &QWebEnginePage::loadingChanged, &view, [result](const QWebEngineLoadingInfo& info) {
+    ++m_step;
+    const int step = m_step;
+    QObject::connect(page(), &QWebEnginePage::loadingChanged, this, [this](const QWebEngineLoadingInfo& info) {
         const bool httpOk = info.errorDomain() == QWebEngineLoadingInfo::HttpStatusCodeDomain && info.errorCode() == 200;
         const bool isFailure = info.status() == QWebEngineLoadingInfo::LoadFailedStatus && !httpOk;
-        if (isFailure && result->error.isEmpty()) {
-            result->error = QStringLiteral("Load failed: %1 (%2:%3)")
-                                .arg(info.errorString())
-                                .arg(static_cast<int>(info.errorDomain()))
-                                .arg(static_cast<int>(info.errorCode()));
+        if (isFailure && m_loadError.isEmpty()) {
+            m_loadError = QStringLiteral("Load failed: %1 (%2:%3)")
+                              .arg(info.errorString())
+                              .arg(static_cast<int>(info.errorDomain()))
+                              .arg(static_cast<int>(info.errorCode()));
+        }
+    });
+    QObject::connect(page(), &QWebEnginePage::loadFinished, this, [this, step, pagePath](bool ok) {
+        if (m_step != step) {
+            return;
         }
+        if (!ok) {
+            fail(m_loadError.isEmpty() ? QStringLiteral("Failed to load Mermaid page %1").arg(pagePath) : m_loadError);
+            return;
+        }
+        beginRender();
     });
+    page()->load(QUrl::fromLocalFile(pagePath));
+}
 
-    QEventLoop loop;
-    bool loadSuccess = false;
-    QObject::connect(page, &QWebEnginePage::loadFinished, &loop, [&loop, &loadSuccess](bool ok) {
-        loadSuccess = ok;
-        loop.quit();
+void MermaidRenderService::Job::beginRender() {
+    ++m_step;
+    QObject::connect(page(), &QWebEnginePage::renderProcessTerminated, this, [this](QWebEnginePage::RenderProcessTerminationStatus status, int code) {
+        fail(QStringLiteral("Render process terminated (%1) code %2").arg(static_cast<int>(status)).arg(code));
     });
 
-    QUrl artifactUrl = QUrl::fromLocalFile(artifactPath);
-    view.load(artifactUrl);
-    loop.exec();
+    page()->runJavaScript(startRenderScript(m_code));
 
-    if (!loadSuccess) {
-        if (result->error.isEmpty()) {
-            result->error = QStringLiteral("Failed to load artifact %1").arg(artifactPath);
-        }
-        return;
-    }
-
-    const QString startRenderJs = QStringLiteral(
-        "(() => {"
-        "  const inputPath = window.__mermaidInputPath;"
-        "  const container = document.getElementById('mermaid-container');"
-        "  const meta = { mermaidType: typeof mermaid, hasContainer: !!container, inputPath: inputPath };"
-        "  window.__mermaidRenderResult = null;"
-        "  const fail = (msg) => { window.__mermaidRenderResult = { ok: false, error: msg, ...meta }; return 'fail'; };"
-        "  if (typeof mermaid === 'undefined') { return fail('FATAL: mermaid object is undefined. Library did not load.'); }"
-        "  if (!container) { return fail('mermaid container not found'); }"
-        "  const run = async () => {"
-        "    try {"
-        "      const resp = await fetch(inputPath);"
-        "      if (!resp || !resp.ok) { return fail('fetch failed with status ' + (resp ? resp.status : 'unknown')); }"
-        "      const code = (await resp.text()).trim();"
-        "      if (!code) { return fail('mermaid code is empty after fetch'); }"
-        "      if (!window.__mermaidInitialized) { mermaid.initialize({ startOnLoad: false, securityLevel: 'loose' }); window.__mermaidInitialized = true; }"
-        "      const renderResult = await mermaid.render('rendered-mermaid', code, container);"
-        "      container.innerHTML = renderResult && renderResult.svg ? renderResult.svg : '';"
-        "      const svg = container.querySelector('svg');"
-        "      const bbox = svg && svg.getBBox ? svg.getBBox() : null;"
-        "      const rect = svg && svg.getBoundingClientRect ? svg.getBoundingClientRect() : null;"
-        "      const width = Math.max(bbox ? bbox.width : 0, rect ? rect.width : 0);"
-        "      const height = Math.max(bbox ? bbox.height : 0, rect ? rect.height : 0);"
-        "      const docEl = document.documentElement;"
-        "      const body = document.body;"
-        "      const bodyStyle = body && window.getComputedStyle ? window.getComputedStyle(body) : null;"
-        "      const metrics = {"
-        "        htmlScrollWidth: docEl ? docEl.scrollWidth : null,"
-        "        htmlScrollHeight: docEl ? docEl.scrollHeight : null,"
-        "        htmlClientWidth: docEl ? docEl.clientWidth : null,"
-        "        htmlClientHeight: docEl ? docEl.clientHeight : null,"
-        "        bodyScrollWidth: body ? body.scrollWidth : null,"
-        "        bodyScrollHeight: body ? body.scrollHeight : null,"
-        "        bodyClientWidth: body ? body.clientWidth : null,"
-        "        bodyClientHeight: body ? body.clientHeight : null,"
-        "        bodyMarginLeft: bodyStyle ? bodyStyle.marginLeft : null,"
-        "        bodyMarginRight: bodyStyle ? bodyStyle.marginRight : null,"
-        "        bodyOverflowX: bodyStyle ? bodyStyle.overflowX : null,"
-        "        bodyOverflowY: bodyStyle ? bodyStyle.overflowY : null"
-        "      };"
-        "      if (!width || !height) { return fail('mermaid produced zero-sized svg'); }"
-        "      window.__mermaidRenderResult = { ok: !!svg, error: svg ? null : 'no svg generated', width: width, height: height, bboxWidth: bbox ? bbox.width : null, bboxHeight: bbox ? bbox.height : null, rectWidth: rect ? rect.width : null, rectHeight: rect ? rect.height : null, svgPresent: !!svg, codeLength: code.length, ...metrics, ...meta };"
-        "      return window.__mermaidRenderResult.ok ? 'render-succeeded' : 'render-no-svg';"
-        "    } catch (e) { return fail('JS Exception: ' + (e ? (e.message || e.toString()) : 'Unknown error')); }"
-        "  };"
-        "  run();"
-        "  return 'render-started';"
-        "})()"
-    );
-
-    view.page()->runJavaScript(startRenderJs);
-
-    QVariantMap renderResult;
-    QEventLoop renderLoop;
-    QTimer renderTimeout;
-    QTimer pollTimer;
-    renderTimeout.setSingleShot(true);
-    renderTimeout.setInterval(10000);
-
-    auto pollResult = [&renderResult, &renderLoop, &renderTimeout, page]() {
-        page->runJavaScript(QStringLiteral("window.__mermaidRenderResult"), [&renderResult, &renderLoop, &renderTimeout](const QVariant& value) {
+    // mermaid.render() is asynchronous, so its result is polled for
+    wait(10000, [this]() { fail(QStringLiteral("Mermaid render script did not return a result")); }, 150, [this]() {
+        page()->runJavaScript(QStringLiteral("window.__mermaidRenderResult"), reply([this](const QVariant& value) {
             const QVariantMap candidate = value.toMap();
             if (!candidate.isEmpty()) {
-                renderResult = candidate;
-                renderTimeout.stop();
-                renderLoop.quit();
+                onRendered(candidate);
             }
-        });
-    };
-
-    QObject::connect(&renderTimeout, &QTimer::timeout, &renderLoop, [&renderLoop]() {
-        renderLoop.quit();
-    });
-    QObject::connect(&pollTimer, &QTimer::timeout, &renderLoop, [&pollResult]() {
-        pollResult();
+        }));
     });
+}
 
-    renderTimeout.start();
-    pollTimer.start(150);
-    pollResult();
-    renderLoop.exec();
-    pollTimer.stop();
-
-    if (renderResult.isEmpty()) {
-        result->error = QStringLiteral("Mermaid render script did not return a result");
-        return;
-    }
+void MermaidRenderService::Job::onRendered(const QVariantMap& renderResult) {
+    ++m_step;
+    stopWaiting();
 
     const bool renderOk = renderResult.value(QStringLiteral("ok")).toBool();
     if (!renderOk) {
         const QString error = renderResult.value(QStringLiteral("error")).toString();
-        result->error = error.isEmpty() ? QStringLiteral("Mermaid render failed") : error;
+        fail(error.isEmpty() ? QStringLiteral("Mermaid render failed") : error);
         return;
     }
 
-    const double svgWidth = renderResult.value(QStringLiteral("width")).toDouble();
-    const double svgHeight = renderResult.value(QStringLiteral("height")).toDouble();
+    m_svgWidth = renderResult.value(QStringLiteral("width")).toDouble();
+    m_svgHeight = renderResult.value(QStringLiteral("height")).toDouble();
     const double bboxWidth = renderResult.value(QStringLiteral("bboxWidth")).toDouble();
     const double bboxHeight = renderResult.value(QStringLiteral("bboxHeight")).toDouble();
     const double rectWidth = renderResult.value(QStringLiteral("rectWidth")).toDouble();
     const double rectHeight = renderResult.value(QStringLiteral("rectHeight")).toDouble();
 
-    if (svgWidth <= 0.0 || svgHeight <= 0.0) {
-        result->error = QStringLiteral("Mermaid render returned zero size (bbox %1x%2, rect %3x%4)")
-                            .arg(bboxWidth, 0, 'f', 2)
-                            .arg(bboxHeight, 0, 'f', 2)
-                            .arg(rectWidth, 0, 'f', 2)
-                            .arg(rectHeight, 0, 'f', 2);
+    if (m_svgWidth <= 0.0 || m_svgHeight <= 0.0) {
+        fail(QStringLiteral("Mermaid render returned zero size (bbox %1x%2, rect %3x%4)")
+                 .arg(bboxWidth, 0, 'f', 2)
+                 .arg(bboxHeight, 0, 'f', 2)
+                 .arg(rectWidth, 0, 'f', 2)
+                 .arg(rectHeight, 0, 'f', 2));
         return;
     }
 
-    const qreal viewDpr = view.devicePixelRatioF();
-    const qreal screenDpr = qApp && qApp->primaryScreen() ? qApp->primaryScreen()->devicePixelRatio() : 1.0;
-    const qreal dpr = std::max(viewDpr, screenDpr);
-    result->devicePixelRatio = dpr;
+    writeDebugSnapshot();
 
-    QString postRenderHtml;
-    {
-        QEventLoop htmlLoop;
-        QTimer htmlTimeout;
-        htmlTimeout.setSingleShot(true);
-        htmlTimeout.setInterval(2000);
-        QObject::connect(&htmlTimeout, &QTimer::timeout, &htmlLoop, &QEventLoop::quit);
-        page->toHtml([&postRenderHtml, &htmlLoop](const QString& html) {
-            postRenderHtml = html;
-            htmlLoop.quit();
-        });
-        htmlTimeout.start();
-        htmlLoop.exec();
+    if (m_svg) {
+        writeSvg();
+        return;
+    }
+
+    m_dpr = std::max(m_view->devicePixelRatioF(), m_screenDpr);
+    m_result.devicePixelRatio = m_dpr;
+
+    m_sizing = planRenderSizing(m_svgWidth, m_svgHeight, m_scaleFactor, m_dpr);
+    if (!m_sizing.error.isEmpty()) {
+        fail(m_sizing.error);
+        return;
+    }
+
+    m_result.clamped = m_sizing.clamped;
+    m_result.effectiveScale = m_sizing.effectiveScale;
+
+    if (m_sizing.clamped && m_sizing.detail.isEmpty()) {
+        m_detailParts << QStringLiteral("Scale adjusted due to size limits.");
+    } else if (m_sizing.clamped) {
+        m_detailParts << m_sizing.detail;
     }
 
-    if (!postRenderHtml.isEmpty()) {
+    applySizing(m_sizing, QStringLiteral("Timed out waiting for viewport resize"), [this]() { captureAfterSizing(); });
+}
+
+void MermaidRenderService::Job::writeSvg() {
+    wait(5000, [this]() { fail(QStringLiteral("Timed out reading the rendered SVG")); });
+    page()->runJavaScript(svgMarkupScript(m_scaleFactor), reply([this](const QVariant& value) {
+        ++m_step;
+        stopWaiting();
+        const QByteArray markup = value.toString().toUtf8();
+        if (!markup.startsWith("<svg")) {
+            fail(QStringLiteral("Mermaid render produced no SVG markup"));
+            return;
+        }
+        QSaveFile file(m_outputPath);
+        if (!file.open(QIODevice::WriteOnly) || file.write(markup) != markup.size() || !file.commit()) {
+            fail(QStringLiteral("Failed to save Mermaid SVG to %1").arg(m_outputPath));
+            return;
+        }
+        m_result.effectiveScale = m_scaleFactor;
+        m_result.devicePixelRatio = 1.0;
+        m_result.detail = QStringLiteral("Rendered SVG %1x%2 (scale %3)")
+                              .arg(std::ceil(m_svgWidth * m_scaleFactor))
+                              .arg(std::ceil(m_svgHeight * m_scaleFactor))
+                              .arg(m_scaleFactor, 0, 'f', 2);
+        m_result.ok = true;
+        complete();
+    }));
+}
+
+// The post-render snapshot serialises the whole page, inlined library and all,
+// so it is only written when asked for while debugging
+void MermaidRenderService::Job::writeDebugSnapshot() {
+    if (!qEnvironmentVariableIsSet("CP_MERMAID_DEBUG_ARTIFACTS")) {
+        return;
+    }
+    QString tempDir = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
+    if (tempDir.isEmpty()) {
+        tempDir = QDir::tempPath();
+    }
+    const QString artifactPath = QDir(tempDir).filePath(QStringLiteral("mermaid_debug_%1.html").arg(m_runNonce));
+    // Holds nothing of the job, so it may land after the job has finished
+    page()->toHtml([artifactPath](const QString& html) {
         QFile artifactFile(artifactPath);
-        if (artifactFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
-            artifactFile.write(postRenderHtml.toUtf8());
+        if (!html.isEmpty() && artifactFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            artifactFile.write(html.toUtf8());
             artifactFile.close();
+            CP_CLOG(MERMAID_DEBUG) << "Generated temp file:" << artifactPath;
         } else {
-            CP_WARN << logPrefix << "Failed to write post-render artifact" << artifactPath << artifactFile.errorString();
+            CP_WARN << "Failed to write post-render artifact" << artifactPath << artifactFile.errorString();
         }
-    }
+    });
+}
 
-    RenderSizing sizing = planRenderSizing(svgWidth, svgHeight, scaleFactor, dpr);
-    if (!sizing.error.isEmpty()) {
-        result->error = sizing.error;
-        return;
-    }
+void MermaidRenderService::Job::applySizing(const RenderSizing& sizing, const QString& timeoutError, std::function<void()> next) {
+    page()->setZoomFactor(sizing.effectiveScale);
+    m_view->resize(sizing.viewWidth, sizing.viewHeight);
+    m_view->show();
 
-    result->clamped = sizing.clamped;
-    result->effectiveScale = sizing.effectiveScale;
+    waitForViewport(sizing.viewWidth, sizing.viewHeight, [this, timeoutError, next](bool ok) {
+        if (!ok) {
+            fail(timeoutError);
+            return;
+        }
+        next();
+    });
+}
 
-    QStringList detailParts;
-    if (sizing.clamped && sizing.detail.isEmpty()) {
-        detailParts << QStringLiteral("Scale adjusted due to size limits.");
-    } else if (sizing.clamped) {
-        detailParts << sizing.detail;
+void MermaidRenderService::Job::waitForViewport(int targetWidth, int targetHeight, std::function<void(bool)> done) {
+    ++m_step;
+    if (targetWidth <= 0 || targetHeight <= 0) {
+        done(false);
+        return;
     }
 
-    const auto waitForResize = [&view, page](int targetWidth, int targetHeight) -> bool {
-        if (targetWidth <= 0 || targetHeight <= 0) {
-            return false;
+    m_logClock.start();
+    m_lastJsWidth = -1;
+    m_lastJsHeight = -1;
+    m_lastDocWidth = -1;
+    m_lastDocHeight = -1;
+    m_lastBodyWidth = -1;
+    m_lastBodyHeight = -1;
+    m_lastJsDpr = -1.0;
+
+    const auto settle = [this, done]() {
+        // A short pause lets the compositor catch up with the new size before a grab
+        after(100, [done]() { done(true); });
+    };
+
+    wait(2000, [this, done, settle]() {
+        if (m_lastJsWidth >= 0 && m_lastJsHeight >= 0) {
+            CP_WARN << "Timed out waiting for viewport resize after clamping. Last JS" << m_lastJsWidth << "x" << m_lastJsHeight
+                       << "Doc" << m_lastDocWidth << "x" << m_lastDocHeight
+                       << "Body" << m_lastBodyWidth << "x" << m_lastBodyHeight
+                       << "DPR" << m_lastJsDpr
+                       << "View" << m_view->width() << "x" << m_view->height()
+                       << "Zoom" << page()->zoomFactor();
+        }
+        // Some offscreen WebEngine combinations report zero window.innerWidth/innerHeight
+        // even after the backing widget has been resized. Fall through to capture in that case.
+        if ((m_lastJsWidth <= 0 || m_lastJsHeight <= 0)
+            && (m_lastDocWidth <= 0 || m_lastDocHeight <= 0)
+            && (m_lastBodyWidth <= 0 || m_lastBodyHeight <= 0)
+            && m_view->width() > 0 && m_view->height() > 0) {
+            CP_WARN << "Proceeding despite zero viewport metrics; relying on widget size for offscreen capture.";
+            settle();
+        } else {
+            ++m_step;
+            done(false);
+        }
+    }, 50, [this, settle]() {
+        const int viewWidth = m_view->width();
+        const int viewHeight = m_view->height();
+        if (viewWidth <= 0 || viewHeight <= 0) {
+            return;
         }
 
-        QEventLoop waitLoop;
-        QTimer pollTimer;
-        QTimer timeoutTimer;
-        bool matched = false;
-        QElapsedTimer logClock;
-        logClock.start();
-        int lastJsWidth = -1;
-        int lastJsHeight = -1;
-        int lastDocWidth = -1;
-        int lastDocHeight = -1;
-        int lastBodyWidth = -1;
-        int lastBodyHeight = -1;
-        double lastJsDpr = -1.0;
-
-        pollTimer.setSingleShot(false);
-        pollTimer.setInterval(50);
-        timeoutTimer.setSingleShot(true);
-        timeoutTimer.setInterval(2000);
-
-        const auto check = [&]() {
-            const int viewWidth = view.width();
-            const int viewHeight = view.height();
-            if (viewWidth <= 0 || viewHeight <= 0) {
+        static const QString script = QStringLiteral(
+            "(() => {"
+            "  const doc = document.documentElement;"
+            "  const body = document.body;"
+            "  return ["
+            "    window.innerWidth || 0,"
+            "    window.innerHeight || 0,"
+            "    window.devicePixelRatio || 0,"
+            "    doc ? (doc.clientWidth || 0) : 0,"
+            "    doc ? (doc.clientHeight || 0) : 0,"
+            "    body ? (body.clientWidth || 0) : 0,"
+            "    body ? (body.clientHeight || 0) : 0"
+            "  ];"
+            "})()");
+        page()->runJavaScript(script, reply([this, viewWidth, viewHeight, settle](const QVariant& value) {
+            const QVariantList dims = value.toList();
+            if (dims.size() < 2) {
+                return;
+            }
+            const int jsWidth = dims.at(0).toInt();
+            const int jsHeight = dims.at(1).toInt();
+            const double jsDpr = dims.size() >= 3 ? dims.at(2).toDouble() : -1.0;
+            const int docWidth = dims.size() >= 5 ? dims.at(3).toInt() : -1;
+            const int docHeight = dims.size() >= 5 ? dims.at(4).toInt() : -1;
+            const int bodyWidth = dims.size() >= 7 ? dims.at(5).toInt() : -1;
+            const int bodyHeight = dims.size() >= 7 ? dims.at(6).toInt() : -1;
+            m_lastJsWidth = jsWidth;
+            m_lastJsHeight = jsHeight;
+            m_lastDocWidth = docWidth;
+            m_lastDocHeight = docHeight;
+            m_lastBodyWidth = bodyWidth;
+            m_lastBodyHeight = bodyHeight;
+            m_lastJsDpr = jsDpr;
+
+            const qreal zoomFactor = page()->zoomFactor();
+            if (zoomFactor <= 0.0) {
                 return;
             }
 
-            static const QString script = QStringLiteral(
-                "(() => {"
-                "  const doc = document.documentElement;"
-                "  const body = document.body;"
-                "  return ["
-                "    window.innerWidth || 0,"
-                "    window.innerHeight || 0,"
-                "    window.devicePixelRatio || 0,"
-                "    doc ? (doc.clientWidth || 0) : 0,"
-                "    doc ? (doc.clientHeight || 0) : 0,"
-                "    body ? (body.clientWidth || 0) : 0,"
-                "    body ? (body.clientHeight || 0) : 0"
-                "  ];"
-                "})()");
-            page->runJavaScript(script, [&, viewWidth, viewHeight](const QVariant& value) {
-                const QVariantList dims = value.toList();
-                if (dims.size() >= 2) {
-                    const int jsWidth = dims.at(0).toInt();
-                    const int jsHeight = dims.at(1).toInt();
-                    const double jsDpr = dims.size() >= 3 ? dims.at(2).toDouble() : -1.0;
-                    const int docWidth = dims.size() >= 5 ? dims.at(3).toInt() : -1;
-                    const int docHeight = dims.size() >= 5 ? dims.at(4).toInt() : -1;
-                    const int bodyWidth = dims.size() >= 7 ? dims.at(5).toInt() : -1;
-                    const int bodyHeight = dims.size() >= 7 ? dims.at(6).toInt() : -1;
-                    lastJsWidth = jsWidth;
-                    lastJsHeight = jsHeight;
-                    lastDocWidth = docWidth;
-                    lastDocHeight = docHeight;
-                    lastBodyWidth = bodyWidth;
-                    lastBodyHeight = bodyHeight;
-                    lastJsDpr = jsDpr;
-
-                    const qreal zoomFactor = page->zoomFactor();
-                    if (zoomFactor <= 0.0) {
-                        return;
-                    }
-
-                    const int expectedJsWidth = qRound(static_cast<qreal>(viewWidth) / zoomFactor);
-                    const int expectedJsHeight = qRound(static_cast<qreal>(viewHeight) / zoomFactor);
-                    const auto withinTolerance = [](int a, int b) {
-                        return std::abs(a - b) <= 2;
-                    };
-
-                    const auto viewportMatches = [&](int width, int height) {
-                        return width > 0 && height > 0
-                               && withinTolerance(width, expectedJsWidth)
-                               && withinTolerance(height, expectedJsHeight);
-                    };
-
-                    if (viewportMatches(jsWidth, jsHeight)
-                        || viewportMatches(docWidth, docHeight)
-                        || viewportMatches(bodyWidth, bodyHeight)) {
-                        matched = true;
-                        timeoutTimer.stop();
-                        waitLoop.quit();
-                        return;
-                    }
-
-                    if (logClock.elapsed() >= 1000) {
-                        CP_WARN << "Waiting for resize: JS says" << jsWidth << "x" << jsHeight
-                                   << "Doc" << docWidth << "x" << docHeight
-                                   << "Body" << bodyWidth << "x" << bodyHeight
-                                   << "DPR" << jsDpr
-                                   << "Expected" << expectedJsWidth << "x" << expectedJsHeight
-                                   << "(View:" << viewWidth << "x" << viewHeight << "Zoom:" << zoomFactor << ")";
-                        logClock.restart();
-                    }
-                }
-            });
-            QCoreApplication::processEvents(QEventLoop::AllEvents, 5);
-        };
-
-        QObject::connect(&pollTimer, &QTimer::timeout, &waitLoop, check);
-        QObject::connect(&timeoutTimer, &QTimer::timeout, &waitLoop, &QEventLoop::quit);
-
-        timeoutTimer.start();
-        pollTimer.start();
-        check();
-        waitLoop.exec();
-        pollTimer.stop();
-        timeoutTimer.stop();
-
-        if (!matched) {
-            if (lastJsWidth >= 0 && lastJsHeight >= 0) {
-                CP_WARN << "Timed out waiting for viewport resize after clamping. Last JS" << lastJsWidth << "x" << lastJsHeight
-                           << "Doc" << lastDocWidth << "x" << lastDocHeight
-                           << "Body" << lastBodyWidth << "x" << lastBodyHeight
-                           << "DPR" << lastJsDpr
-                           << "View" << view.width() << "x" << view.height()
-                           << "Zoom" << page->zoomFactor();
+            const int expectedJsWidth = qRound(static_cast<qreal>(viewWidth) / zoomFactor);
+            const int expectedJsHeight = qRound(static_cast<qreal>(viewHeight) / zoomFactor);
+            const auto withinTolerance = [](int a, int b) {
+                return std::abs(a - b) <= 2;
+            };
+
+            const auto viewportMatches = [&](int width, int height) {
+                return width > 0 && height > 0
+                       && withinTolerance(width, expectedJsWidth)
+                       && withinTolerance(height, expectedJsHeight);
+            };
+
+            if (viewportMatches(jsWidth, jsHeight)
+                || viewportMatches(docWidth, docHeight)
+                || viewportMatches(bodyWidth, bodyHeight)) {
+                stopWaiting();
+                settle();
+                return;
             }
-            // Some offscreen WebEngine combinations report zero window.innerWidth/innerHeight
-            // even after the backing widget has been resized. Fall through to capture in that case.
-            if ((lastJsWidth <= 0 || lastJsHeight <= 0)
-                && (lastDocWidth <= 0 || lastDocHeight <= 0)
-                && (lastBodyWidth <= 0 || lastBodyHeight <= 0)
-                && view.width() > 0 && view.height() > 0) {
-                CP_WARN << "Proceeding despite zero viewport metrics; relying on widget size for offscreen capture.";
-            } else {
-                return false;
+
+            if (m_logClock.elapsed() >= 1000) {
+                CP_WARN << "Waiting for resize: JS says" << jsWidth << "x" << jsHeight
+                           << "Doc" << docWidth << "x" << docHeight
+                           << "Body" << bodyWidth << "x" << bodyHeight
+                           << "DPR" << jsDpr
+                           << "Expected" << expectedJsWidth << "x" << expectedJsHeight
+                           << "(View:" << viewWidth << "x" << viewHeight << "Zoom:" << zoomFactor << ")";
+                m_logClock.restart();
             }
+        }));
+    });
+}
+
+void MermaidRenderService::Job::grab(int attemptsLeft, std::function<void(bool)> done) {
+    m_shot = m_view->grab();
+    if (!m_shot.isNull() && !isBlank(m_shot)) {
+        done(true);
+        return;
+    }
+    if (attemptsLeft > 1) {
+        after(100, [this, attemptsLeft, done]() { grab(attemptsLeft - 1, done); });
+        return;
+    }
+    done(false);
+}
+
+void MermaidRenderService::Job::capture(std::function<void(bool)> done) {
+    const auto measured = [this, done](bool ok) {
+        if (ok) {
+            m_shotDpr = m_shot.devicePixelRatio();
+            m_shotPixelWidth = static_cast<qint64>(std::ceil(static_cast<double>(m_shot.width()) * m_shotDpr));
+            m_shotPixelHeight = static_cast<qint64>(std::ceil(static_cast<double>(m_shot.height()) * m_shotDpr));
+            m_estimatedBytes = m_shotPixelWidth * m_shotPixelHeight * 4; // RGBA
         }
+        done(ok);
+    };
 
-        QElapsedTimer settleClock;
-        settleClock.start();
-        while (settleClock.elapsed() < 100) {
-            QCoreApplication::processEvents(QEventLoop::AllEvents, 20);
-            QThread::msleep(5);
+    grab(20, [this, measured](bool ok) {
+        if (ok || !m_view->testAttribute(Qt::WA_DontShowOnScreen)) {
+            measured(ok);
+            return;
         }
+        CP_WARN << "MermaidRenderService: Offscreen grab remained blank; retrying with a real window positioned off-screen.";
+        m_view->hide();
+        m_view->setAttribute(Qt::WA_DontShowOnScreen, false);
+        m_view->show();
+        waitForViewport(m_view->width(), m_view->height(), [this, measured](bool stable) {
+            if (!stable) {
+                CP_WARN << "MermaidRenderService: Windowed off-screen fallback did not report a stable viewport.";
+            }
+            grab(20, [measured](bool latched) {
+                if (!latched) {
+                    CP_WARN << "MermaidRenderService: Visual latch timed out, image may be blank.";
+                }
+                measured(latched);
+            });
+        });
+    });
+}
 
-        return true;
+void MermaidRenderService::Job::captureAfterSizing() {
+    const qint64 tileMaxBytes = static_cast<qint64>(kTileMemoryBudgetMb) * 1024 * 1024;
+    const qint64 allocMaxBytes = static_cast<qint64>(QImageReader::allocationLimit()) * 1024 * 1024;
+    const auto enforceLimits = [this, tileMaxBytes, allocMaxBytes]() {
+        enforceLimit(tileMaxBytes, QStringLiteral("tile memory"), [this, allocMaxBytes]() {
+            enforceLimit(allocMaxBytes, QStringLiteral("allocation"), [this]() { save(); });
+        });
     };
 
-    page->setZoomFactor(sizing.effectiveScale);
-    view.resize(sizing.viewWidth, sizing.viewHeight);
-    view.show();
+    capture([this, enforceLimits](bool ok) {
+        if (!ok) {
+            fail(QStringLiteral("Failed to capture Mermaid image (empty pixmap)"));
+            return;
+        }
+
+        // If the actual grab DPR is higher than our sizing DPR, recompute sizing before enforcing limits.
+        if (m_shotDpr <= m_dpr + 1e-3) {
+            enforceLimits();
+            return;
+        }
+        m_sizing = planRenderSizing(m_svgWidth, m_svgHeight, m_sizing.effectiveScale, m_shotDpr);
+        m_result.clamped = m_result.clamped || m_sizing.clamped;
+        m_result.effectiveScale = m_sizing.effectiveScale;
+        applySizing(m_sizing, QStringLiteral("Timed out waiting for viewport resize after DPR rescale"), [this, enforceLimits]() {
+            capture([this, enforceLimits](bool recaptured) {
+                if (!recaptured) {
+                    fail(QStringLiteral("Failed to capture Mermaid image after DPR rescale"));
+                    return;
+                }
+                enforceLimits();
+            });
+        });
+    });
+}
 
-    if (!waitForResize(sizing.viewWidth, sizing.viewHeight)) {
-        result->error = QStringLiteral("Timed out waiting for viewport resize");
+void MermaidRenderService::Job::enforceLimit(qint64 byteLimit, const QString& label, std::function<void()> next) {
+    if (byteLimit <= 0 || m_estimatedBytes <= byteLimit) {
+        next();
         return;
     }
 
-    const auto grabAndEstimate = [&](QPixmap& pix, qint64& pixelWidth, qint64& pixelHeight, qint64& estimatedBytes, qreal& pixDpr) {
-        auto isBlank = [](const QPixmap& p) {
-            if (p.isNull()) return true;
-            const QImage img = p.toImage();
-            if (img.isNull()) return true;
-
-            const int w = img.width();
-            const int h = img.height();
-            if (w == 0 || h == 0) return true;
-
-            // Sample more points for wide diagrams to see if it's all white or transparent
-            // We check a few vertical spans to be sure we don't miss thin lines
-            for (int i = 1; i < 10; ++i) {
-                int x = i * w / 10;
-                for (int y = 0; y < h; y += std::max(1, h / 5)) {
-                    if (x >= w || y >= h) continue;
-                    const QColor c = img.pixelColor(x, y);
-                    // "Ink" is anything not fully transparent and not "almost white"
-                    if (c.alpha() > 0 && (c.red() < 250 || c.green() < 250 || c.blue() < 250)) {
-                        return false;
-                    }
-                }
-            }
-            return true;
-        };
-
-        const auto attemptGrab = [&](int maxAttempts) {
-            int attempts = 0;
-            while (attempts < maxAttempts) {
-                pix = view.grab();
-                if (!pix.isNull() && !isBlank(pix)) {
-                    return true;
-                }
+    const double byteClamp = std::sqrt(static_cast<double>(byteLimit) / static_cast<double>(m_estimatedBytes));
+    const double targetScale = m_sizing.effectiveScale * byteClamp * 0.98; // small buffer below limit
+
+    if (targetScale < kMinClampScale) {
+        fail(QStringLiteral("Render size %1x%2 at dpr %3 exceeds %4 limit (%5 MB); requested scale %6, applied %7")
+                 .arg(m_shotPixelWidth)
+                 .arg(m_shotPixelHeight)
+                 .arg(m_shotDpr, 0, 'f', 2)
+                 .arg(label)
+                 .arg(byteLimit / (1024 * 1024))
+                 .arg(m_scaleFactor, 0, 'f', 2)
+                 .arg(m_sizing.effectiveScale, 0, 'f', 2));
+        return;
+    }
 
-                if (attempts + 1 < maxAttempts) {
-                    QCoreApplication::processEvents(QEventLoop::AllEvents, 50);
-                    QThread::msleep(100);
-                }
-                attempts++;
-            }
-            return false;
-        };
-
-        if (!attemptGrab(20) && view.testAttribute(Qt::WA_DontShowOnScreen)) {
-            CP_WARN << "MermaidRenderService: Offscreen grab remained blank; retrying with a real window positioned off-screen.";
-            view.hide();
-            view.setAttribute(Qt::WA_DontShowOnScreen, false);
-            view.show();
-            if (!waitForResize(view.width(), view.height())) {
-                CP_WARN << "MermaidRenderService: Windowed off-screen fallback did not report a stable viewport.";
+    const RenderSizing retrySizing = planRenderSizing(m_svgWidth, m_svgHeight, targetScale, m_shotDpr);
+    if (!retrySizing.error.isEmpty()) {
+        fail(retrySizing.error);
+        return;
+    }
+
+    m_sizing = retrySizing;
+    m_result.clamped = true;
+    m_result.effectiveScale = retrySizing.effectiveScale;
+    m_detailParts << MermaidRenderService::formatClampDetail(m_scaleFactor,
+                                                             retrySizing.effectiveScale,
+                                                             label,
+                                                             retrySizing.viewWidth,
+                                                             retrySizing.viewHeight,
+                                                             m_shotDpr);
+
+    applySizing(retrySizing, QStringLiteral("Timed out waiting for viewport resize after clamping"), [this, byteLimit, label, next]() {
+        capture([this, byteLimit, label, next](bool ok) {
+            if (!ok) {
+                fail(QStringLiteral("Failed to capture Mermaid image after downscaling for %1 limit").arg(label));
+                return;
             }
-            if (!attemptGrab(20)) {
-                CP_WARN << "MermaidRenderService: Visual latch timed out, image may be blank.";
+            if (m_estimatedBytes > byteLimit) {
+                fail(QStringLiteral("Render size %1x%2 at dpr %3 still exceeds %4 limit (%5 MB) after clamping; requested scale %6, applied %7")
+                         .arg(m_shotPixelWidth)
+                         .arg(m_shotPixelHeight)
+                         .arg(m_shotDpr, 0, 'f', 2)
+                         .arg(label)
+                         .arg(byteLimit / (1024 * 1024))
+                         .arg(m_scaleFactor, 0, 'f', 2)
+                         .arg(m_sizing.effectiveScale, 0, 'f', 2));
+                return;
             }
-        }
-
-        if (pix.isNull() || isBlank(pix)) return false;
-        pixDpr = pix.devicePixelRatio();
-        pixelWidth = static_cast<qint64>(std::ceil(static_cast<double>(pix.width()) * pixDpr));
-        pixelHeight = static_cast<qint64>(std::ceil(static_cast<double>(pix.height()) * pixDpr));
-        estimatedBytes = pixelWidth * pixelHeight * 4; // RGBA
-        return true;
-    };
+            next();
+        });
+    });
+}
 
-    QPixmap shot;
-    qint64 shotPixelWidth = 0;
-    qint64 shotPixelHeight = 0;
-    qint64 estimatedBytes = 0;
-    qreal shotDpr = dpr;
+void MermaidRenderService::Job::save() {
+    m_result.devicePixelRatio = m_shotDpr;
 
-    if (!grabAndEstimate(shot, shotPixelWidth, shotPixelHeight, estimatedBytes, shotDpr)) {
-        result->error = QStringLiteral("Failed to capture Mermaid image (empty pixmap)");
+    if (m_shot.isNull() || !m_shot.save(m_outputPath)) {
+        fail(QStringLiteral("Failed to save Mermaid image to %1").arg(m_outputPath));
         return;
     }
 
-    // If the actual grab DPR is higher than our sizing DPR, recompute sizing before enforcing limits.
-    if (shotDpr > dpr + 1e-3) {
-        sizing = planRenderSizing(svgWidth, svgHeight, sizing.effectiveScale, shotDpr);
-        result->clamped = result->clamped || sizing.clamped;
-        result->effectiveScale = sizing.effectiveScale;
-        page->setZoomFactor(sizing.effectiveScale);
-        view.resize(sizing.viewWidth, sizing.viewHeight);
+    const QString summary = QStringLiteral("Rendered %1x%2 (requested scale %3, applied %4, dpr %5)")
+                                .arg(m_sizing.viewWidth)
+                                .arg(m_sizing.viewHeight)
+                                .arg(m_scaleFactor, 0, 'f', 2)
+                                .arg(m_result.effectiveScale, 0, 'f', 2)
+                                .arg(m_result.devicePixelRatio, 0, 'f', 2);
 
-        if (!waitForResize(sizing.viewWidth, sizing.viewHeight)) {
-            result->error = QStringLiteral("Timed out waiting for viewport resize after DPR rescale");
-            return;
-        }
+    m_detailParts << summary;
+    m_result.detail = m_detailParts.join(QStringLiteral("; "));
 
-        if (!grabAndEstimate(shot, shotPixelWidth, shotPixelHeight, estimatedBytes, shotDpr)) {
-            result->error = QStringLiteral("Failed to capture Mermaid image after DPR rescale");
-            return;
-        }
-    }
+    m_result.ok = true;
+    complete();
+}
+
+void MermaidRenderService::Job::fail(const QString& error) {
+    m_result.ok = false;
+    m_result.error = error;
+    complete();
+}
 
-    if (shot.isNull()) {
-        result->error = QStringLiteral("Failed to capture Mermaid image (empty pixmap)");
+void MermaidRenderService::Job::complete() {
+    if (m_finished) {
         return;
     }
+    m_finished = true;
+    ++m_step;
+    stopWaiting();
 
-    const qint64 tileMaxBytes = static_cast<qint64>(kTileMemoryBudgetMb) * 1024 * 1024;
-    const qint64 allocMaxBytes = static_cast<qint64>(QImageReader::allocationLimit()) * 1024 * 1024;
+    if (!m_result.ok && m_result.error.isEmpty()) {
+        m_result.error = QStringLiteral("Mermaid rendering failed for %1").arg(m_outputPath);
+    }
+    if (!m_result.ok) {
+        CP_WARN << "MermaidRenderService: render failed for output" << m_outputPath << "error" << m_result.error;
+    }
 
-    auto downscaleForLimit = [&](qint64 byteLimit, const QString& label) -> bool {
-        if (byteLimit <= 0 || estimatedBytes <= byteLimit) {
-            return true;
+    if (m_result.ok && !m_result.cached) {
+        m_service->storeCachedRender(m_cacheKey, m_outputPath, m_result);
+        if (m_view) {
+            m_service->releaseView(std::move(m_view));
+        } else {
+            m_service->releasePage(std::move(m_page));
         }
+    }
+    // A page that failed may be mid-signal, so it goes once control is back in the event loop
+    if (m_view) {
+        m_view.release()->deleteLater();
+    }
+    if (m_page) {
+        m_page.release()->deleteLater();
+    }
 
-        const double byteClamp = std::sqrt(static_cast<double>(byteLimit) / static_cast<double>(estimatedBytes));
-        const double targetScale = sizing.effectiveScale * byteClamp * 0.98; // small buffer below limit
-
-        if (targetScale < kMinClampScale) {
-            result->error = QStringLiteral("Render size %1x%2 at dpr %3 exceeds %4 limit (%5 MB); requested scale %6, applied %7")
-                                .arg(shotPixelWidth)
-                                .arg(shotPixelHeight)
-                                .arg(shotDpr, 0, 'f', 2)
-                                .arg(label)
-                                .arg(byteLimit / (1024 * 1024))
-                                .arg(scaleFactor, 0, 'f', 2)
-                                .arg(sizing.effectiveScale, 0, 'f', 2);
-            return false;
-        }
+    m_promise->addResult(m_result);
+    m_promise->finish();
+    m_service->jobFinished(this);
+}
 
-        const RenderSizing retrySizing = planRenderSizing(svgWidth, svgHeight, targetScale, shotDpr);
-        if (!retrySizing.error.isEmpty()) {
-            result->error = retrySizing.error;
-            return false;
-        }
+MermaidRenderer::Result MermaidRenderService::render(const QString& mermaidCode, const QString& outputPath, double scaleFactor) {
+    return renderMermaid(mermaidCode, outputPath, scaleFactor);
+}
 
-        sizing = retrySizing;
-        result->clamped = true;
-        result->effectiveScale = retrySizing.effectiveScale;
-        detailParts << MermaidRenderService::formatClampDetail(scaleFactor,
-                                                               retrySizing.effectiveScale,
-                                                               label,
-                                                               retrySizing.viewWidth,
-                                                               retrySizing.viewHeight,
-                                                               shotDpr);
-
-        page->setZoomFactor(retrySizing.effectiveScale);
-        view.resize(retrySizing.viewWidth, retrySizing.viewHeight);
-
-        if (!waitForResize(retrySizing.viewWidth, retrySizing.viewHeight)) {
-            result->error = QStringLiteral("Timed out waiting for viewport resize after clamping");
-            return false;
-        }
+QFuture<MermaidRenderService::RenderResult> MermaidRenderService::renderMermaidAsync(const QString& mermaidCode, const QString& outputPath, double scaleFactor) {
+    auto promise = std::make_shared<QPromise<RenderResult>>();
+    promise->start();
+    QFuture<RenderResult> future = promise->future();
+
+    if (!QCoreApplication::instance()) {
+        RenderResult result;
+        result.requestedScale = scaleFactor;
+        result.error = QStringLiteral("Mermaid rendering needs a running application");
+        promise->addResult(result);
+        promise->finish();
+        return future;
+    }
 
-        if (!grabAndEstimate(shot, shotPixelWidth, shotPixelHeight, estimatedBytes, shotDpr)) {
-            result->error = QStringLiteral("Failed to capture Mermaid image after downscaling for %1 limit").arg(label);
-            return false;
-        }
+    // Always queued, so a request made on the GUI thread also returns before any work starts
+    QMetaObject::invokeMethod(this, [this, mermaidCode, outputPath, scaleFactor, promise]() {
+        enqueue(new Job(this, mermaidCode, outputPath, scaleFactor, promise));
+    }, Qt::QueuedConnection);
+    return future;
+}
 
-        if (estimatedBytes > byteLimit) {
-            result->error = QStringLiteral("Render size %1x%2 at dpr %3 still exceeds %4 limit (%5 MB) after clamping; requested scale %6, applied %7")
-                                .arg(shotPixelWidth)
-                                .arg(shotPixelHeight)
-                                .arg(shotDpr, 0, 'f', 2)
-                                .arg(label)
-                                .arg(byteLimit / (1024 * 1024))
-                                .arg(scaleFactor, 0, 'f', 2)
-                                .arg(retrySizing.effectiveScale, 0, 'f', 2);
-            return false;
+MermaidRenderService::RenderResult MermaidRenderService::renderMermaid(const QString& mermaidCode, const QString& outputPath, double scaleFactor) {
+    QFuture<RenderResult> future = renderMermaidAsync(mermaidCode, outputPath, scaleFactor);
+
+    // The queue runs on this thread, so blocking here would stall it
+    if (QThread::currentThread() == thread() && !future.isFinished()) {
+        QFutureWatcher<RenderResult> watcher;
+        QEventLoop loop;
+        QObject::connect(&watcher, &QFutureWatcherBase::finished, &loop, &QEventLoop::quit);
+        watcher.setFuture(future);
+        if (!future.isFinished()) {
+            loop.exec();
         }
+    }
+    return future.result();
+}
 
-        return true;
-    };
+void MermaidRenderService::enqueue(Job* job) {
+    m_queue.push_back(job);
+    startQueuedJobs();
+}
+
+void MermaidRenderService::startQueuedJobs() {
+    while (m_running < kMaxConcurrentRenders && !m_queue.empty()) {
+        Job* job = m_queue.front();
+        m_queue.pop_front();
+        ++m_running;
+        job->start();
+    }
+}
+
+void MermaidRenderService::jobFinished(Job* job) {
+    --m_running;
+    job->deleteLater();
+    startQueuedJobs();
+}
+
+std::unique_ptr<QWebEngineView> MermaidRenderService::takeIdleView() {
+    if (m_idleViews.empty()) {
+        return nullptr;
+    }
+    std::unique_ptr<QWebEngineView> view = std::move(m_idleViews.back());
+    m_idleViews.pop_back();
+    return view;
+}
+
+std::unique_ptr<QWebEnginePage> MermaidRenderService::takeIdlePage() {
+    if (m_idlePages.empty()) {
+        return nullptr;
+    }
+    std::unique_ptr<QWebEnginePage> page = std::move(m_idlePages.back());
+    m_idlePages.pop_back();
+    return page;
+}
 
-    if (!downscaleForLimit(tileMaxBytes, QStringLiteral("tile memory"))) {
+void MermaidRenderService::releaseView(std::unique_ptr<QWebEngineView> view) {
+    if (!view) {
+        return;
+    }
+    if (static_cast<int>(m_idleViews.size()) >= kMaxIdlePages) {
+        view.release()->deleteLater();
         return;
     }
+    view->hide();
+    view->page()->setZoomFactor(1.0);
+    view->resize(m_initialPageSize);
+    m_idleViews.push_back(std::move(view));
+}
 
-    if (!downscaleForLimit(allocMaxBytes, QStringLiteral("allocation"))) {
+void MermaidRenderService::releasePage(std::unique_ptr<QWebEnginePage> page) {
+    if (!page) {
         return;
     }
+    if (static_cast<int>(m_idlePages.size()) >= kMaxIdlePages) {
+        page.release()->deleteLater();
+        return;
+    }
+    m_idlePages.push_back(std::move(page));
+}
 
-    result->devicePixelRatio = shotDpr;
+MermaidRenderService::RenderSizing MermaidRenderService::planRenderSizing(double svgWidth, double svgHeight, double scaleFactor, double devicePixelRatio) {
+    RenderSizing sizing;
 
-    const bool saved = shot.save(outputPath);
-    if (!saved) {
-        result->error = QStringLiteral("Failed to save Mermaid image to %1").arg(outputPath);
-        return;
+    double scale = scaleFactor;
+    if (scale < kMinScale) {
+        scale = kMinScale;
     }
+    double dpr = devicePixelRatio > 0.0 ? devicePixelRatio : 1.0;
 
-    const QString summary = QStringLiteral("Rendered %1x%2 (requested scale %3, applied %4, dpr %5)")
-                                .arg(sizing.viewWidth)
-                                .arg(sizing.viewHeight)
-                                .arg(scaleFactor, 0, 'f', 2)
-                                .arg(result->effectiveScale, 0, 'f', 2)
-                                .arg(result->devicePixelRatio, 0, 'f', 2);
+    const double paddedWidth = (svgWidth > 0.0 ? std::ceil(svgWidth) : kDefaultWidth) + kPadding;
+    const double paddedHeight = (svgHeight > 0.0 ? std::ceil(svgHeight) : kDefaultHeight) + kPadding;
+
+    const double requestedWidth = paddedWidth * scale;
+    const double requestedHeight = paddedHeight * scale;
+
+    const double requestedWidthPixels = requestedWidth * dpr;
+    const double requestedHeightPixels = requestedHeight * dpr;
+    const double requestedBytes = requestedWidthPixels * requestedHeightPixels * 4.0; // RGBA
+
+    double clampScale = 1.0;
+
+    // Dimension-based clamp to avoid exceeding texture/pixmap limits (account for devicePixelRatio)
+    if (requestedWidthPixels > kMaxDimension || requestedHeightPixels > kMaxDimension) {
+        const double dimScale = std::min(kMaxDimension / requestedWidthPixels, kMaxDimension / requestedHeightPixels);
+        clampScale = std::min(clampScale, dimScale);
+    }
+
+    // Tile memory budget clamp to avoid Chromium tile manager failures
+    const qint64 tileBudgetBytes = static_cast<qint64>(kTileMemoryBudgetMb) * 1024 * 1024;
+    if (tileBudgetBytes > 0 && requestedBytes > static_cast<double>(tileBudgetBytes)) {
+        const double tileScale = std::sqrt(static_cast<double>(tileBudgetBytes) / requestedBytes);
+        clampScale = std::min(clampScale, tileScale);
+    }
+
+    // Memory-based clamp using QImageReader allocation limit (in MB)
+    const int allocLimitMb = QImageReader::allocationLimit();
+    const qint64 maxBytes = allocLimitMb > 0 ? static_cast<qint64>(allocLimitMb) * 1024 * 1024 : 0;
+    if (maxBytes > 0) {
+        if (requestedBytes > static_cast<double>(maxBytes)) {
+            const double byteScale = std::sqrt(static_cast<double>(maxBytes) / requestedBytes);
+            clampScale = std::min(clampScale, byteScale);
+        }
+    }
+
+    if (clampScale < kMinClampScale) {
+        sizing.error = QStringLiteral("Requested render size %1x%2 (scale %3, dpr %4) exceeds safe limits; reduce the resolution scale.")
+                           .arg(std::ceil(requestedWidthPixels))
+                           .arg(std::ceil(requestedHeightPixels))
+                           .arg(scaleFactor, 0, 'f', 2)
+                           .arg(dpr, 0, 'f', 2);
+        return sizing;
+    }
+
+    sizing.effectiveScale = scale * clampScale;
+    sizing.viewWidth = static_cast<int>(std::ceil(paddedWidth * sizing.effectiveScale));
+    sizing.viewHeight = static_cast<int>(std::ceil(paddedHeight * sizing.effectiveScale));
+
+    const double maxViewWidth = static_cast<double>(kMaxDimension) / dpr;
+    const double maxViewHeight = static_cast<double>(kMaxDimension) / dpr;
+    if (sizing.viewWidth > maxViewWidth) sizing.viewWidth = static_cast<int>(std::floor(maxViewWidth));
+    if (sizing.viewHeight > maxViewHeight) sizing.viewHeight = static_cast<int>(std::floor(maxViewHeight));
+
+    sizing.clamped = std::abs(sizing.effectiveScale - scale) > 1e-6
+                     || sizing.viewWidth < static_cast<int>(std::ceil(requestedWidth))
+                     || sizing.viewHeight < static_cast<int>(std::ceil(requestedHeight));
+    if (sizing.clamped) {
+        sizing.detail = QStringLiteral("Scale %1 clamped to %2; render size %3x%4 (dpr %5)")
+                            .arg(scaleFactor, 0, 'f', 2)
+                            .arg(sizing.effectiveScale, 0, 'f', 2)
+                            .arg(sizing.viewWidth)
+                            .arg(sizing.viewHeight)
+                            .arg(dpr, 0, 'f', 2);
+    }
 
-    detailParts << summary;
-    result->detail = detailParts.join(QStringLiteral("; "));
+    return sizing;
+}
 
-    result->ok = true;
+QString MermaidRenderService::formatClampDetail(double requestedScale,
+                                                double effectiveScale,
+                                                const QString& reason,
+                                                int viewWidth,
+                                                int viewHeight,
+                                                double devicePixelRatio)
+{
+    return ::formatClampDetail(requestedScale, effectiveScale, reason, viewWidth, viewHeight, devicePixelRatio);
 }
+
@@ -23,12 +23,41 @@
 //
 #pragma once
 
+#include <QCache>
+#include <QByteArray>
+#include <QFuture>
+#include <QMutex>
 #include <QObject>
+#include <QSize>
 #include <QString>
 
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "MermaidRenderer.h"
+
 class QWebEngineView;
+class QWebEnginePage;
+
+// Renders Mermaid diagrams with QtWebEngine on the GUI thread.
+//
+// Requests from any thread join a queue on the GUI thread and come back as a
+// QFuture. Each render is a chain of WebEngine callbacks and timers, so neither
+// the caller nor the GUI thread waits in a nested event loop, and a few renders
+// make progress side by side. Pages with the Mermaid library already loaded are
+// kept warm and take each new source through JavaScript. Finished images are
+// kept in memory, keyed on the source, scale, output format and device pixel
+// ratio, and a repeat request is written straight from there.
+//
+// An ".svg" output, or any output once MermaidRenderer::setHeadless(true) is set,
+// takes the SVG path: the diagram's markup is serialised from a windowless page,
+// with no widget, resize or screen grab involved.
+//
+// Built into the editor and tests, and into the cp_mermaid_webengine plugin for
+// cp-run; the core only sees the MermaidRenderer interface.
 
-class MermaidRenderService : public QObject {
+class MermaidRenderService : public QObject, public MermaidRenderer {
     Q_OBJECT
 public:
     struct RenderSizing {
@@ -40,17 +69,11 @@ public:
         QString error;
     };
 
-    struct RenderResult {
-        bool ok {false};
-        QString error;
-        QString detail;
-        bool clamped {false};
-        double requestedScale {1.0};
-        double effectiveScale {1.0};
-        double devicePixelRatio {1.0};
-    };
+    using RenderResult = MermaidRenderer::Result;
 
     static MermaidRenderService& instance();
+    // Makes the service the MermaidRenderer nodes render through
+    static void install();
 
     // Compute the effective scale and viewport size for a render request without
     // invoking WebEngine, to allow preflight checks and testing.
@@ -63,19 +86,59 @@ public:
                                      int viewHeight,
                                      double devicePixelRatio);
 
+    // Queues a render and returns at once; callable from any thread.
+    QFuture<RenderResult> renderMermaidAsync(const QString& mermaidCode, const QString& outputPath, double scaleFactor = 1.0);
+
+    // Waits for renderMermaidAsync(). A worker thread blocks on the future; the GUI
+    // thread, which runs the queue, waits in a local event loop instead.
     RenderResult renderMermaid(const QString& mermaidCode, const QString& outputPath, double scaleFactor = 1.0);
 
-private:
-    explicit MermaidRenderService(QObject* parent = nullptr);
-    ~MermaidRenderService() override = default;
+    Result render(const QString& mermaidCode, const QString& outputPath, double scaleFactor) override;
 
-private slots:
-    void renderOnMainThread(const QString& mermaidCode, const QString& outputPath, double scaleFactor, RenderResult* result);
+    static QString renderCacheKey(const QString& mermaidCode, double scaleFactor, const QString& format, double devicePixelRatio);
+
+    void clearRenderCache();
+
+    // Renders in flight at once; the rest wait in the queue
+    static constexpr int kMaxConcurrentRenders = 2;
+    // Warm pages of each kind kept between renders
+    static constexpr int kMaxIdlePages = 2;
+    static constexpr qsizetype kRenderCacheBytes = 64 * 1024 * 1024;
 
 private:
+    explicit MermaidRenderService(QObject* parent = nullptr);
+    ~MermaidRenderService() override;
+
     Q_DISABLE_COPY(MermaidRenderService);
 
+    class Job;
+
+    struct CachedRender {
+        QByteArray image;
+        RenderResult result;
+    };
+
     void ensureProfileInitialized();
+    QString pageFilePath(QString* error);
+    void enqueue(Job* job);
+    void startQueuedJobs();
+    void jobFinished(Job* job);
+    std::unique_ptr<QWebEngineView> takeIdleView();
+    std::unique_ptr<QWebEnginePage> takeIdlePage();
+    void releaseView(std::unique_ptr<QWebEngineView> view);
+    void releasePage(std::unique_ptr<QWebEnginePage> page);
+    bool takeCachedRender(const QString& key, const QString& outputPath, RenderResult* result);
+    void storeCachedRender(const QString& key, const QString& outputPath, const RenderResult& result);
 
     bool m_profileInitialized{false};
+    // GUI thread only
+    QString m_pageFile;
+    QSize m_initialPageSize;
+    std::vector<std::unique_ptr<QWebEngineView>> m_idleViews;
+    std::vector<std::unique_ptr<QWebEnginePage>> m_idlePages;
+    std::deque<Job*> m_queue;
+    int m_running{0};
+
+    QMutex m_cacheMutex;
+    QCache<QString, CachedRender> m_renders{kRenderCacheBytes};
 };
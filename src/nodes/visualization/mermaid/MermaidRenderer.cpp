@@ -0,0 +1,83 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "MermaidRenderer.h"
+
+#include <QDir>
+#include <QLibrary>
+#include <QPluginLoader>
+
+#include <atomic>
+
+namespace {
+std::atomic<MermaidRenderer*> g_renderer {nullptr};
+std::atomic<bool> g_headless {false};
+} // namespace
+
+void MermaidRenderer::setInstance(MermaidRenderer* renderer)
+{
+    g_renderer.store(renderer);
+}
+
+MermaidRenderer* MermaidRenderer::instance()
+{
+    return g_renderer.load();
+}
+
+void MermaidRenderer::setHeadless(bool headless)
+{
+    g_headless.store(headless);
+}
+
+bool MermaidRenderer::isHeadless()
+{
+    return g_headless.load();
+}
+
+QString MermaidRenderer::findPlugin(const QString& directory)
+{
+    if (directory.isEmpty()) {
+        return {};
+    }
+    const QDir dir(directory);
+    const QStringList entries = dir.entryList({QStringLiteral("*cp_mermaid_webengine*")}, QDir::Files);
+    for (const QString& entry : entries) {
+        const QString path = dir.filePath(entry);
+        if (QLibrary::isLibrary(path)) {
+            return path;
+        }
+    }
+    return {};
+}
+
+QString MermaidRenderer::loadPlugin(const QString& path)
+{
+    QPluginLoader loader(path);
+    auto* plugin = qobject_cast<MermaidRendererPlugin*>(loader.instance());
+    if (!plugin) {
+        const QString reason = loader.errorString();
+        return QStringLiteral("Cannot load the Mermaid renderer %1: %2").arg(path, reason);
+    }
+    setInstance(plugin->renderer());
+    return {};
+}
@@ -0,0 +1,74 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <QString>
+#include <QtPlugin>
+
+// What MermaidNode needs from a diagram renderer. The QtWebEngine renderer
+// (MermaidRenderService) sits outside the headless core: the editor installs it at
+// startup, and cp-run loads it from the cp_mermaid_webengine plugin when that ships
+// next to the binary. With no renderer installed, Mermaid nodes fail with an error.
+class MermaidRenderer {
+public:
+    struct Result {
+        bool ok {false};
+        QString error;
+        QString detail;
+        bool clamped {false};
+        double requestedScale {1.0};
+        double effectiveScale {1.0};
+        double devicePixelRatio {1.0};
+        bool cached {false};  // served from the render cache
+    };
+
+    virtual ~MermaidRenderer() = default;
+
+    // Renders to outputPath, PNG or SVG by its suffix, and waits; callable from any thread
+    virtual Result render(const QString& mermaidCode, const QString& outputPath, double scaleFactor) = 0;
+
+    // The installed renderer, or nullptr. The renderer must outlive every run.
+    static void setInstance(MermaidRenderer* renderer);
+    static MermaidRenderer* instance();
+
+    // Headless runs have no screen to grab, so every render writes SVG.
+    static void setHeadless(bool headless);
+    static bool isHeadless();
+
+    // The cp_mermaid_webengine plugin in directory, or an empty string when there is none
+    static QString findPlugin(const QString& directory);
+    // Loads the plugin and installs its renderer. Returns an error message, empty on success.
+    static QString loadPlugin(const QString& path);
+};
+
+// Implemented by the cp_mermaid_webengine plugin
+class MermaidRendererPlugin {
+public:
+    virtual ~MermaidRendererPlugin() = default;
+    virtual MermaidRenderer* renderer() = 0;
+};
+
+#define MermaidRendererPlugin_iid "com.cognitivepipelines.MermaidRendererPlugin/1.0"
+Q_DECLARE_INTERFACE(MermaidRendererPlugin, MermaidRendererPlugin_iid)
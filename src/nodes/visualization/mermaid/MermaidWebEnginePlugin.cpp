@@ -0,0 +1,38 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// The cp_mermaid_webengine plugin: hands cp-run the QtWebEngine renderer, which the
+// headless core does not link.
+#include <QObject>
+
+#include "MermaidRenderService.h"
+
+class MermaidWebEnginePlugin : public QObject, public MermaidRendererPlugin {
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID MermaidRendererPlugin_iid)
+    Q_INTERFACES(MermaidRendererPlugin)
+public:
+    MermaidRenderer* renderer() override { return &MermaidRenderService::instance(); }
+};
+
+#include "MermaidWebEnginePlugin.moc"
@@ -3,6 +3,12 @@
 
 #include <QString>
 #include <QStringList>
+#include <QStringView>
+
+#include <algorithm>
+#include <vector>
+
+#include "retrieval/chunking/TextChunker.h"
 
 /**
  * @brief Abstract base class for text chunking strategies.
@@ -24,11 +30,44 @@ public:
 
     /**
      * @brief Split the given text into chunks according to the concrete
-     *        strategy's rules.
+     *        strategy's rules, as spans over @p text with line ranges.
      */
-    virtual QStringList chunk(const QString &text) = 0;
+    virtual QList<TextChunkSpan> chunkSpans(const QString &text) = 0;
+
+    /// The chunks of chunkSpans() as strings.
+    QStringList chunk(const QString &text)
+    {
+        const QList<TextChunkSpan> spans = chunkSpans(text);
+        QStringList chunks;
+        chunks.reserve(spans.size());
+        for (const TextChunkSpan &span : spans) {
+            chunks.append(text.mid(span.offset, span.length));
+        }
+        return chunks;
+    }
 
 protected:
+    /**
+     * @brief Fill in startLine/endLine of every span over @p text.
+     *
+     * Newline offsets are collected once, so each span costs two binary
+     * searches however large or repetitive the text is.
+     */
+    static void assignLineNumbers(QStringView text, QList<TextChunkSpan> &spans)
+    {
+        std::vector<qsizetype> newlines;
+        for (qsizetype i = text.indexOf(u'\n'); i >= 0; i = text.indexOf(u'\n', i + 1)) {
+            newlines.push_back(i);
+        }
+        auto lineAt = [&newlines](qsizetype offset) {
+            return static_cast<int>(std::lower_bound(newlines.begin(), newlines.end(), offset) - newlines.begin()) + 1;
+        };
+        for (TextChunkSpan &span : spans) {
+            span.startLine = lineAt(span.offset);
+            span.endLine = lineAt(qMax(span.offset, span.offset + span.length - 1));
+        }
+    }
+
     /**
      * @brief Find a natural word boundary near the given ideal position.
      *
@@ -36,12 +75,12 @@ protected:
      * a space or newline. If found, the position just after the boundary is
      * returned; otherwise @p idealPos is returned unchanged.
      */
-    static int findWordBoundary(const QString &text, int idealPos, int maxLookback)
+    static qsizetype findWordBoundary(QStringView text, qsizetype idealPos, int maxLookback)
     {
-        int searchStart = qMax(0, idealPos - maxLookback);
-        for (int i = idealPos - 1; i >= searchStart; --i) {
-            QChar c = text[i];
-            if (c == ' ' || c == '\n') {
+        const qsizetype searchStart = qMax<qsizetype>(0, idealPos - maxLookback);
+        for (qsizetype i = idealPos - 1; i >= searchStart; --i) {
+            const QChar c = text[i];
+            if (c == u' ' || c == u'\n') {
                 return i + 1;
             }
         }
@@ -49,33 +88,34 @@ protected:
     }
 
     /**
-     * @brief Extract an overlap segment from the end of a chunk while trying
+     * @brief Where the overlap carried from the end of a chunk starts, trying
      *        to start at a semantic boundary.
      *
      * This mirrors TextChunker::extractOverlapSmart: prefer newlines, then
      * sentence endings, then simple word boundaries, finally falling back to a
-     * raw suffix when no boundary is found within the search window.
+     * raw suffix when no boundary is found within the search window. The
+     * overlap is chunk.sliced(overlapStart(chunk, overlapSize)).
      */
-    static QString extractOverlapSmart(const QString &chunk, int overlapSize)
+    static qsizetype overlapStart(QStringView chunk, int overlapSize)
     {
         if (chunk.length() <= overlapSize) {
-            return chunk;
+            return 0;
         }
 
-        int idealStart = chunk.length() - overlapSize;
-        int searchStart = qMax(0, idealStart - 150);
+        const qsizetype idealStart = chunk.length() - overlapSize;
+        const qsizetype searchStart = qMax<qsizetype>(0, idealStart - 150);
 
         // Phase 1: strong separators (newlines)
-        for (int i = idealStart - 1; i >= searchStart; --i) {
-            QChar c = chunk[i];
-            if (c == '\n' || c == '\r') {
-                int boundaryPos = i + 1;
-                QString candidate = chunk.mid(boundaryPos);
+        for (qsizetype i = idealStart - 1; i >= searchStart; --i) {
+            const QChar c = chunk[i];
+            if (c == u'\n' || c == u'\r') {
+                const qsizetype boundaryPos = i + 1;
+                const QStringView candidate = chunk.sliced(boundaryPos);
 
                 int firstWordLen = 0;
-                for (int j = 0; j < candidate.length(); ++j) {
-                    QChar ch = candidate[j];
-                    if (ch == ' ' || ch == '\n' || ch == '\r') {
+                for (qsizetype j = 0; j < candidate.length(); ++j) {
+                    const QChar ch = candidate[j];
+                    if (ch == u' ' || ch == u'\n' || ch == u'\r') {
                         break;
                     }
                     if (!ch.isSpace()) {
@@ -83,51 +123,49 @@ protected:
                     }
                 }
 
-                if (firstWordLen > 3 || candidate.contains(' ')) {
-                    return candidate;
+                if (firstWordLen > 3 || candidate.contains(u' ')) {
+                    return boundaryPos;
                 }
             }
         }
 
         // Phase 2: weak separators (period followed by space/newline)
-        for (int i = idealStart - 1; i >= searchStart; --i) {
+        for (qsizetype i = idealStart - 1; i >= searchStart; --i) {
             if (i + 1 < chunk.length()) {
-                QChar c = chunk[i];
-                QChar next = chunk[i + 1];
-                if (c == '.' && (next == ' ' || next == '\n' || next == '\r')) {
-                    int boundaryPos = i + 1;
+                const QChar c = chunk[i];
+                const QChar next = chunk[i + 1];
+                if (c == u'.' && (next == u' ' || next == u'\n' || next == u'\r')) {
+                    qsizetype boundaryPos = i + 1;
                     while (boundaryPos < chunk.length() && chunk[boundaryPos].isSpace()) {
                         boundaryPos++;
                     }
-                    if (boundaryPos < chunk.length()) {
-                        QString candidate = chunk.mid(boundaryPos);
-                        if (candidate.length() >= 10) {
-                            return candidate;
-                        }
+                    if (boundaryPos < chunk.length() && chunk.length() - boundaryPos >= 10) {
+                        return boundaryPos;
                     }
                 }
             }
         }
 
         // Phase 3: simple word boundaries (spaces)
-        for (int i = idealStart - 1; i >= searchStart; --i) {
-            QChar c = chunk[i];
-            if (c == ' ') {
-                int boundaryPos = i + 1;
-                QString candidate = chunk.mid(boundaryPos);
-                if (candidate.length() >= 10) {
-                    return candidate;
+        for (qsizetype i = idealStart - 1; i >= searchStart; --i) {
+            if (chunk[i] == u' ') {
+                const qsizetype boundaryPos = i + 1;
+                if (chunk.length() - boundaryPos >= 10) {
+                    return boundaryPos;
                 }
             }
         }
 
         // Fallback: raw suffix
-        return chunk.right(overlapSize);
+        return idealStart;
     }
 
 protected:
     int max_chunk_size_;
     int chunk_overlap_;
+
+    // Stitches regions chunked apart with the same overlap rule
+    friend class ParallelChunker;
 };
 
 #endif // CHUNKERSTRATEGY_H
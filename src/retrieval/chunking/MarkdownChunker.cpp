@@ -2,24 +2,14 @@
 
 #include <QStringList>
 
-namespace {
-
-static QStringList splitLinesPreserveEmpty(const QString &text)
-{
-    // QString::split with KeepEmptyParts preserves structure-relevant blank
-    // lines which are important for Markdown semantics.
-    return text.split('\n', Qt::KeepEmptyParts);
-}
-
-}
-
-QStringList MarkdownChunker::chunk(const QString &text)
+QList<TextChunkSpan> MarkdownChunker::chunkSpans(const QString &text)
 {
-    QStringList chunks;
+    QList<TextChunkSpan> chunks;
 
     if (text.isEmpty() || max_chunk_size_ <= 0) {
         if (!text.isEmpty()) {
-            chunks.append(text);
+            chunks.append(TextChunkSpan{0, text.length()});
+            assignLineNumbers(text, chunks);
         }
         return chunks;
     }
@@ -34,8 +24,15 @@ QStringList MarkdownChunker::chunk(const QString &text)
         effectiveOverlap = 0;
     }
 
-    QStringList lines = splitLinesPreserveEmpty(text);
-    QString currentChunk;
+    // Lines are walked in place, keeping blank lines since they are
+    // structure-relevant for Markdown. The current chunk is always the
+    // contiguous range [chunkBegin, chunkEnd) of the text, and each line
+    // carries its trailing newline (lineWithSep) except the last.
+    const QStringView source(text);
+    qsizetype chunkBegin = 0;
+    qsizetype chunkEnd = 0;
+    auto chunkLength = [&]() { return chunkEnd - chunkBegin; };
+    auto flushChunk = [&]() { chunks.append(TextChunkSpan{chunkBegin, chunkEnd - chunkBegin}); };
 
     // Tracks whether currentChunk only contains a single Markdown header line
     // plus optional whitespace/blank lines. Used to implement "sticky
@@ -51,51 +48,65 @@ QStringList MarkdownChunker::chunk(const QString &text)
 
     const int tableMaxChunkSize = effectiveChunkSize + effectiveChunkSize / 4; // +25%
 
-    for (int i = 0; i < lines.size(); ++i) {
-        const QString &line = lines[i];
-        const bool isLastLine = (i == lines.size() - 1);
+    qsizetype nextLineStart = 0;
+    for (qsizetype lineStart = 0; lineStart >= 0; lineStart = nextLineStart) {
+        // Nothing follows a final newline; treating it as a line could flush
+        // an oversized chunk and leave a chunk of pure overlap behind.
+        if (lineStart == source.length()) {
+            break;
+        }
+        const qsizetype newline = source.indexOf(u'\n', lineStart);
+        const bool isLastLine = (newline < 0);
+        const QStringView line = isLastLine ? source.sliced(lineStart) : source.sliced(lineStart, newline - lineStart);
+        nextLineStart = isLastLine ? -1 : newline + 1;
         const bool isHeader = isHeaderLine(line);
 
         // Header Hard-Split: if line is header and current buffer has content,
         // flush current chunk and start a new one from the header line. This
         // boundary is a *clean* break: there is intentionally no overlap
         // carried from the previous paragraph into the header chunk.
-        if (!currentChunk.isEmpty() && isHeader) {
-            chunks.append(currentChunk);
-            currentChunk.clear();
+        if (chunkLength() > 0 && isHeader) {
+            flushChunk();
+            chunkBegin = chunkEnd = lineStart;
             currentChunkIsHeaderOnly = false;
         }
 
-        QString lineWithSep = line;
-
         // Table-aware handling: detect whether we are inside a contiguous
         // Markdown table block. We now *preserve* the real newlines between
         // table rows so that the visual structure (one row per line) is
         // retained. Chunk-size enforcement later uses these row boundaries as
         // preferred split points when a table no longer fits.
-        bool isTableRow = line.trimmed().startsWith('|');
+        const bool isTableRow = line.trimmed().startsWith(u'|');
         bool nextIsTableRow = false;
         if (!isLastLine) {
-            const QString &nextLine = lines[i + 1];
-            nextIsTableRow = nextLine.trimmed().startsWith('|');
+            const qsizetype nextNewline = source.indexOf(u'\n', nextLineStart);
+            const QStringView nextLine = nextNewline < 0
+                ? source.sliced(nextLineStart)
+                : source.sliced(nextLineStart, nextNewline - nextLineStart);
+            nextIsTableRow = nextLine.trimmed().startsWith(u'|');
         }
 
         // Newline is always preserved; separator "priority" is encoded in
         // how we later decide to flush or overflow (tables get a larger
         // allowance via tableMaxChunkSize but still honour row boundaries).
-        if (!isLastLine) {
-            lineWithSep.append('\n');
-        }
+        const qsizetype lineEnd = isLastLine ? source.length() : newline + 1;
+        const qsizetype lineWithSepLength = lineEnd - lineStart;
 
-        QString candidate = currentChunk + lineWithSep;
+        const qsizetype candidateLength = chunkLength() > 0 ? lineEnd - chunkBegin : lineWithSepLength;
+        auto acceptLine = [&]() {
+            if (chunkLength() == 0) {
+                chunkBegin = lineStart;
+            }
+            chunkEnd = lineEnd;
+        };
 
         // Sticky Headers: if the current chunk so far only consists of a
         // header (and maybe blank lines), force the *next* block of text to be
         // appended to it, even if that means slightly exceeding
         // effectiveChunkSize. This prevents "lonely" tiny header-only chunks
         // that would otherwise create poor RAG context and odd overlaps.
-        if (currentChunkIsHeaderOnly && candidate.length() > effectiveChunkSize) {
-            currentChunk = candidate;
+        if (currentChunkIsHeaderOnly && candidateLength > effectiveChunkSize) {
+            acceptLine();
 
             // As soon as we append a non-header, non-empty line, this chunk is
             // no longer considered header-only.
@@ -107,14 +118,14 @@ QStringList MarkdownChunker::chunk(const QString &text)
             continue;
         }
 
-        if (candidate.length() <= effectiveChunkSize) {
-            currentChunk = candidate;
+        if (candidateLength <= effectiveChunkSize) {
+            acceptLine();
 
             // Update header-only tracking: only remain header-only while we
             // see headers and blank lines; any real content clears it.
-            if (currentChunk.isEmpty()) {
+            if (chunkLength() == 0) {
                 currentChunkIsHeaderOnly = false;
-            } else if (currentChunk.size() == lineWithSep.size()) {
+            } else if (chunkLength() == lineWithSepLength) {
                 // Starting a new chunk from this line.
                 currentChunkIsHeaderOnly = isHeader;
             } else if (currentChunkIsHeaderOnly && !line.trimmed().isEmpty() && !isHeader) {
@@ -130,30 +141,34 @@ QStringList MarkdownChunker::chunk(const QString &text)
         // between "| Title |" and "| :-- |" lines while still keeping
         // pathological tables bounded.
         const bool inTableRegion = isTableRow || lastLineWasTableRow || nextIsTableRow;
-        if (inTableRegion && candidate.length() <= tableMaxChunkSize) {
-            currentChunk = candidate;
+        if (inTableRegion && candidateLength <= tableMaxChunkSize) {
+            acceptLine();
             lastLineWasTableRow = isTableRow;
             continue;
         }
 
         // If the line itself is larger than a chunk, perform a hard character
         // split using word-boundary aware logic.
-        if (currentChunk.isEmpty() && lineWithSep.length() > effectiveChunkSize) {
-            int start = 0;
+        if (chunkLength() == 0 && lineWithSepLength > effectiveChunkSize) {
+            const QStringView lineWithSep = source.sliced(lineStart, lineWithSepLength);
+            qsizetype start = 0;
             while (start < lineWithSep.length()) {
-                int idealEnd = start + effectiveChunkSize;
+                const qsizetype idealEnd = start + effectiveChunkSize;
                 if (idealEnd >= lineWithSep.length()) {
-                    chunks.append(lineWithSep.mid(start));
+                    chunks.append(TextChunkSpan{lineStart + start, lineWithSep.length() - start});
                     break;
                 }
 
-                int actualEnd = findWordBoundary(lineWithSep, idealEnd, 50);
-                QString chunkPiece = lineWithSep.mid(start, actualEnd - start);
-                chunks.append(chunkPiece);
+                qsizetype actualEnd = findWordBoundary(lineWithSep, idealEnd, 50);
+                if (actualEnd <= start) {
+                    actualEnd = idealEnd;
+                }
+                chunks.append(TextChunkSpan{lineStart + start, actualEnd - start});
 
                 if (effectiveOverlap > 0) {
-                    QString overlap = ChunkerStrategy::extractOverlapSmart(chunkPiece, effectiveOverlap);
-                    start = actualEnd - overlap.length();
+                    const QStringView chunkPiece = lineWithSep.sliced(start, actualEnd - start);
+                    const qsizetype overlapLength = chunkPiece.length() - overlapStart(chunkPiece, effectiveOverlap);
+                    start = qMax(start + 1, actualEnd - overlapLength);
                 } else {
                     start = actualEnd;
                 }
@@ -163,37 +178,39 @@ QStringList MarkdownChunker::chunk(const QString &text)
         }
 
         // Normal case: flush currentChunk, compute overlap, then start new chunk
-        if (!currentChunk.isEmpty()) {
-            chunks.append(currentChunk);
+        if (chunkLength() > 0) {
+            flushChunk();
 
-            if (effectiveOverlap > 0 && currentChunk.length() > effectiveOverlap) {
-                QString overlap = ChunkerStrategy::extractOverlapSmart(currentChunk, effectiveOverlap);
-                currentChunk = overlap + lineWithSep;
+            if (effectiveOverlap > 0 && chunkLength() > effectiveOverlap) {
+                chunkBegin += overlapStart(source.sliced(chunkBegin, chunkLength()), effectiveOverlap);
             } else {
-                currentChunk = lineWithSep;
+                chunkBegin = lineStart;
             }
+            chunkEnd = lineEnd;
 
             // Starting from an overlap or fresh line means the chunk can no
             // longer be "header only".
-            currentChunkIsHeaderOnly = isHeader && currentChunk.size() == lineWithSep.size();
+            currentChunkIsHeaderOnly = isHeader && chunkLength() == lineWithSepLength;
         } else {
-            currentChunk = lineWithSep;
+            chunkBegin = lineStart;
+            chunkEnd = lineEnd;
             currentChunkIsHeaderOnly = isHeader;
         }
 
         lastLineWasTableRow = isTableRow;
     }
 
-    if (!currentChunk.isEmpty()) {
-        chunks.append(currentChunk);
+    if (chunkLength() > 0) {
+        flushChunk();
     }
 
+    assignLineNumbers(text, chunks);
     return chunks;
 }
 
-bool MarkdownChunker::isHeaderLine(const QString &line)
+bool MarkdownChunker::isHeaderLine(QStringView line)
 {
-    QString trimmed = line.trimmed();
+    const QStringView trimmed = line.trimmed();
     if (!trimmed.startsWith('#')) {
         return false;
     }
@@ -19,7 +19,7 @@
  *    inside a cell.
  *  - Standard accumulation (priority 3): other lines are appended until
  *    maxChunkSize is reached, then overlap-aware splitting is applied via
- *    extractOverlapSmart().
+ *    overlapStart().
  */
 class MarkdownChunker : public ChunkerStrategy
 {
@@ -29,10 +29,10 @@ public:
     {
     }
 
-    QStringList chunk(const QString &text) override;
+    QList<TextChunkSpan> chunkSpans(const QString &text) override;
 
 private:
-    static bool isHeaderLine(const QString &line);
+    static bool isHeaderLine(QStringView line);
 };
 
 #endif // MARKDOWNCHUNKER_H
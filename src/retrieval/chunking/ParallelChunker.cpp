@@ -0,0 +1,268 @@
+#include "retrieval/chunking/ParallelChunker.h"
+
+#include "retrieval/chunking/ChunkerStrategy.h"
+#include "CpuWorkerPool.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStringView>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace {
+
+// A range of one document that is chunked on its own
+struct Region {
+    qsizetype document {0};
+    qsizetype begin {0};
+    qsizetype end {0};
+    // Starts at a Markdown header, which the chunker breaks without overlap
+    bool cleanBreak {false};
+    QList<TextChunkSpan> spans;
+    qsizetype newlines {0};
+};
+
+bool isBlankLineBefore(QStringView text, qsizetype newline)
+{
+    qsizetype i = newline - 1;
+    if (i >= 0 && text[i] == u'\r') {
+        --i;
+    }
+    return i >= 0 && text[i] == u'\n';
+}
+
+bool isMarkdownHeaderAt(QStringView text, qsizetype lineStart)
+{
+    qsizetype hashes = 0;
+    while (lineStart + hashes < text.length() && text[lineStart + hashes] == u'#') {
+        ++hashes;
+    }
+    if (hashes < 1 || hashes > 6) {
+        return false;
+    }
+    const qsizetype next = lineStart + hashes;
+    return next == text.length() || text[next] == u' ' || text[next] == u'\r' || text[next] == u'\n';
+}
+
+// The first line start in [from, limit) the rest of the text can be chunked from, or -1
+qsizetype findCut(QStringView text, qsizetype from, qsizetype limit, FileType fileType, bool& cleanBreak)
+{
+    const bool markdown = fileType == FileType::CodeMarkdown;
+    const bool code = !markdown && fileType != FileType::PlainText;
+    qsizetype blankLineCut = -1;
+
+    for (qsizetype newline = text.indexOf(u'\n', from); newline >= 0 && newline + 1 < limit;
+         newline = text.indexOf(u'\n', newline + 1)) {
+        const qsizetype lineStart = newline + 1;
+        if (markdown && isMarkdownHeaderAt(text, lineStart)) {
+            cleanBreak = true;
+            return lineStart;
+        }
+        if (blankLineCut >= 0 || !isBlankLineBefore(text, newline)) {
+            continue;
+        }
+        const QChar first = text[lineStart];
+        if (first == u'\n' || first == u'\r') {
+            continue; // still inside the blank-line run
+        }
+        // In code, only an unindented line after a blank run starts a top-level declaration
+        if (code && first.isSpace()) {
+            continue;
+        }
+        blankLineCut = lineStart;
+        if (!markdown) {
+            break;
+        }
+    }
+
+    cleanBreak = false;
+    return blankLineCut;
+}
+
+std::vector<Region> planRegions(const QStringList& texts, const QList<FileType>& fileTypes, int chunkSize,
+                                qsizetype regionLength)
+{
+    std::vector<Region> regions;
+    for (qsizetype document = 0; document < texts.size(); ++document) {
+        const QStringView text(texts.at(document));
+        const FileType fileType = fileTypes.value(document, FileType::PlainText);
+        qsizetype begin = 0;
+        bool cleanBreak = false;
+
+        while (chunkSize > 0 && regionLength > 0 && text.length() - begin > regionLength) {
+            bool cutIsClean = false;
+            const QStringView rest = text.sliced(begin);
+            const qsizetype cut =
+                ParallelChunker::nextRegionCut(rest, regionLength, rest.length(), regionLength, fileType, &cutIsClean);
+            if (cut < 0) {
+                break;
+            }
+            regions.push_back(Region{document, begin, begin + cut, cleanBreak});
+            begin += cut;
+            cleanBreak = cutIsClean;
+        }
+        regions.push_back(Region{document, begin, text.length(), cleanBreak});
+    }
+    return regions;
+}
+
+// Hands regions out to the calling thread and any pool threads that join in
+class RegionJob : public std::enable_shared_from_this<RegionJob> {
+public:
+    RegionJob(const QStringList& texts, const QList<FileType>& fileTypes, int chunkSize, int chunkOverlap,
+              std::vector<Region> regions)
+        : regions(std::move(regions))
+        , m_texts(texts)
+        , m_fileTypes(fileTypes)
+        , m_chunkSize(chunkSize)
+        , m_chunkOverlap(chunkOverlap)
+    {
+    }
+
+    void run(QThreadPool* pool)
+    {
+        const qsizetype participants = std::min<qsizetype>(std::max(1, pool->maxThreadCount()),
+                                                           static_cast<qsizetype>(regions.size()));
+        for (qsizetype i = 1; i < participants; ++i) {
+            pool->start([self = shared_from_this()]() { self->participate(); });
+        }
+        participate();
+
+        QMutexLocker locker(&m_mutex);
+        while (m_active > 0) {
+            m_finished.wait(&m_mutex);
+        }
+    }
+
+    std::vector<Region> regions;
+
+private:
+    void participate()
+    {
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_next.load() >= regions.size()) {
+                return;
+            }
+            ++m_active;
+        }
+
+        for (std::size_t i = m_next.fetch_add(1); i < regions.size(); i = m_next.fetch_add(1)) {
+            Region& region = regions[i];
+            const QString& text = m_texts.at(region.document);
+            // Borrows the document's buffer; the chunkers only read it
+            const QString regionText = QString::fromRawData(text.constData() + region.begin, region.end - region.begin);
+            region.spans = TextChunker::splitSpans(regionText, m_chunkSize, m_chunkOverlap,
+                                                   m_fileTypes.value(region.document, FileType::PlainText));
+            region.newlines = QStringView(regionText).count(u'\n');
+        }
+
+        QMutexLocker locker(&m_mutex);
+        if (--m_active == 0) {
+            m_finished.wakeAll();
+        }
+    }
+
+    const QStringList m_texts;
+    const QList<FileType> m_fileTypes;
+    const int m_chunkSize;
+    const int m_chunkOverlap;
+    std::atomic<std::size_t> m_next {0};
+
+    QMutex m_mutex;
+    QWaitCondition m_finished;
+    int m_active {0};
+};
+
+} // namespace
+
+QList<TextChunkSpan> ParallelChunker::splitSpans(const QString& text, int chunkSize, int chunkOverlap,
+                                                 FileType fileType, QThreadPool* pool, qsizetype regionLength)
+{
+    return splitSpansMany(QStringList{text}, QList<FileType>{fileType}, chunkSize, chunkOverlap, pool, regionLength)
+        .first();
+}
+
+QList<QList<TextChunkSpan>> ParallelChunker::splitSpansMany(const QStringList& texts,
+                                                            const QList<FileType>& fileTypes,
+                                                            int chunkSize, int chunkOverlap,
+                                                            QThreadPool* pool, qsizetype regionLength)
+{
+    QList<QList<TextChunkSpan>> result(texts.size());
+    if (texts.isEmpty()) {
+        return result;
+    }
+
+    if (!pool) {
+        pool = CpuWorkerPool::current() ? CpuWorkerPool::current() : QThreadPool::globalInstance();
+    }
+    const auto job = std::make_shared<RegionJob>(texts, fileTypes, chunkSize, chunkOverlap,
+                                                 planRegions(texts, fileTypes, chunkSize, regionLength));
+    job->run(pool);
+
+    // Normalised as the chunkers do, so the stitched overlap matches theirs
+    const int effectiveOverlap = qBound(0, chunkOverlap, qMax(0, chunkSize - 1));
+
+    // Regions are in document order; shift each to its document and stitch it to the one before
+    qsizetype lineBase = 0;
+    qsizetype document = -1;
+    for (Region& region : job->regions) {
+        if (region.document != document) {
+            document = region.document;
+            lineBase = 0;
+        }
+        for (TextChunkSpan& span : region.spans) {
+            span.offset += region.begin;
+            span.startLine += static_cast<int>(lineBase);
+            span.endLine += static_cast<int>(lineBase);
+        }
+
+        QList<TextChunkSpan>& spans = result[document];
+        if (!spans.isEmpty() && !region.spans.isEmpty() && !region.cleanBreak) {
+            carryOverlap(texts.at(document), spans.last(), region.spans.first(), chunkSize, effectiveOverlap);
+        }
+        spans.append(std::move(region.spans));
+        lineBase += region.newlines;
+    }
+    return result;
+}
+
+qsizetype ParallelChunker::nextRegionCut(QStringView text, qsizetype from, qsizetype limit, qsizetype regionLength,
+                                         FileType fileType, bool* cleanBreak)
+{
+    // Look one region length at a time until a boundary turns up
+    for (; from < limit; from += regionLength) {
+        bool clean = false;
+        const qsizetype cut = findCut(text, from, qMin(limit, from + regionLength), fileType, clean);
+        if (cut >= 0) {
+            if (cleanBreak) {
+                *cleanBreak = clean;
+            }
+            return cut;
+        }
+    }
+    return -1;
+}
+
+void ParallelChunker::carryOverlap(QStringView text, const TextChunkSpan& previous, TextChunkSpan& next,
+                                   int chunkSize, int chunkOverlap)
+{
+    if (chunkOverlap <= 0 || previous.length <= chunkOverlap) {
+        return;
+    }
+    const qsizetype start =
+        previous.offset + ChunkerStrategy::overlapStart(text.sliced(previous.offset, previous.length), chunkOverlap);
+    const qsizetype end = next.offset + next.length;
+    // Only while the chunk still fits, as when the chunker seeds a chunk itself
+    if (start >= next.offset || end - start > chunkSize) {
+        return;
+    }
+    next.startLine -= static_cast<int>(text.sliced(start, next.offset - start).count(u'\n'));
+    next.offset = start;
+    next.length = end - start;
+}
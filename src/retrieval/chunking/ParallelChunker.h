@@ -0,0 +1,64 @@
+#ifndef PARALLELCHUNKER_H
+#define PARALLELCHUNKER_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+
+#include "retrieval/chunking/TextChunker.h"
+
+class QThreadPool;
+
+/**
+ * @brief Chunks many documents, and very large single documents, on several threads.
+ *
+ * A document longer than the region length is first cut into regions at
+ * boundaries the chunkers already treat as breaks: Markdown headers,
+ * otherwise blank-line runs (followed by an unindented line, i.e. a
+ * top-level declaration, in code). Every region of every document is then
+ * chunked independently with TextChunker and the spans are stitched back:
+ * offsets and line numbers are shifted to the document, and across a
+ * blank-line cut the next chunk is extended back over the overlap the
+ * previous chunk would have carried. Markdown header cuts need no overlap
+ * since MarkdownChunker makes them clean breaks.
+ *
+ * Work runs on @p pool when given, otherwise on the run's Cpu pool
+ * (CpuWorkerPool) or the global pool. The calling thread chunks regions
+ * itself and pool tasks only help, so it is safe to call from a pool thread.
+ */
+class ParallelChunker
+{
+public:
+    /// Documents up to this many characters are chunked as one region.
+    static constexpr qsizetype kDefaultRegionLength = 1 << 20;
+
+    /// TextChunker::splitSpans() for @p text, chunking large texts region by region.
+    static QList<TextChunkSpan> splitSpans(const QString& text, int chunkSize, int chunkOverlap,
+                                           FileType fileType = FileType::PlainText,
+                                           QThreadPool* pool = nullptr,
+                                           qsizetype regionLength = kDefaultRegionLength);
+
+    /// The spans of each of @p texts, chunked concurrently; @p fileTypes pairs with @p texts (PlainText if short).
+    static QList<QList<TextChunkSpan>> splitSpansMany(const QStringList& texts, const QList<FileType>& fileTypes,
+                                                      int chunkSize, int chunkOverlap,
+                                                      QThreadPool* pool = nullptr,
+                                                      qsizetype regionLength = kDefaultRegionLength);
+
+    /**
+     * @brief Where the region at the start of @p text ends, or -1 if it does not.
+     *
+     * Windows of @p regionLength characters from @p from up to @p limit are
+     * searched in turn, and the first boundary found wins. @p cleanBreak
+     * reports whether the cut is a Markdown header. Text past @p limit is
+     * only read to classify a line at the limit.
+     */
+    static qsizetype nextRegionCut(QStringView text, qsizetype from, qsizetype limit, qsizetype regionLength,
+                                   FileType fileType, bool* cleanBreak = nullptr);
+
+    /// Extends @p next back over the overlap @p previous would carry, if the result still fits in a chunk.
+    static void carryOverlap(QStringView text, const TextChunkSpan& previous, TextChunkSpan& next,
+                             int chunkSize, int chunkOverlap);
+};
+
+#endif // PARALLELCHUNKER_H
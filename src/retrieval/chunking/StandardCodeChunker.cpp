@@ -58,44 +58,44 @@ QStringList StandardCodeChunker::getSeparatorsForType(FileType fileType)
     }
 }
 
-bool StandardCodeChunker::isCommentStart(const QString &line, FileType fileType)
+bool StandardCodeChunker::isCommentStart(QStringView line, FileType fileType)
 {
-    QString trimmed = line.trimmed();
+    const QStringView trimmed = line.trimmed();
 
     switch (fileType) {
     case FileType::CodeCpp:
-        return trimmed.startsWith("//") || trimmed.startsWith("/*");
+        return trimmed.startsWith(u"//") || trimmed.startsWith(u"/*");
     case FileType::CodePython:
-        return trimmed.startsWith("#");
+        return trimmed.startsWith(u'#');
     case FileType::CodeRexx:
-        return trimmed.startsWith("--") || trimmed.startsWith("/*");
+        return trimmed.startsWith(u"--") || trimmed.startsWith(u"/*");
     case FileType::CodeSql:
-        return trimmed.startsWith("--");
+        return trimmed.startsWith(u"--");
     case FileType::CodeShell:
-        return trimmed.startsWith("#");
+        return trimmed.startsWith(u'#');
     case FileType::CodeCobol:
-        return trimmed.startsWith("*");
+        return trimmed.startsWith(u'*');
     case FileType::CodeMarkdown:
         return false;
     case FileType::CodeYaml:
-        return trimmed.startsWith("#");
+        return trimmed.startsWith(u'#');
     case FileType::PlainText:
     default:
         return false;
     }
 }
 
-bool StandardCodeChunker::isMarkdownHeader(const QString &line)
+bool StandardCodeChunker::isMarkdownHeader(QStringView line)
 {
-    QString trimmed = line.trimmed();
+    const QStringView trimmed = line.trimmed();
 
-    if (trimmed.startsWith("#")) {
+    if (trimmed.startsWith(u'#')) {
         int hashCount = 0;
-        for (int i = 0; i < trimmed.length() && trimmed[i] == '#'; ++i) {
+        for (int i = 0; i < trimmed.length() && trimmed[i] == u'#'; ++i) {
             hashCount++;
         }
         if (hashCount >= 1 && hashCount <= 6) {
-            if (hashCount == trimmed.length() || trimmed[hashCount] == ' ') {
+            if (hashCount == trimmed.length() || trimmed[hashCount] == u' ') {
                 return true;
             }
         }
@@ -103,176 +103,173 @@ bool StandardCodeChunker::isMarkdownHeader(const QString &line)
     return false;
 }
 
-QStringList StandardCodeChunker::chunk(const QString &text)
+QList<TextChunkSpan> StandardCodeChunker::chunkSpans(const QString &text)
 {
     if (text.isEmpty()) {
-        return QStringList();
+        return {};
     }
 
-    if (max_chunk_size_ <= 0) {
-        return QStringList{text};
-    }
-
-    int effectiveChunkSize = max_chunk_size_;
-    int effectiveOverlap = chunk_overlap_;
-    if (effectiveOverlap >= effectiveChunkSize) {
-        effectiveOverlap = effectiveChunkSize - 1;
-    }
-    if (effectiveOverlap < 0) {
-        effectiveOverlap = 0;
-    }
+    QList<TextChunkSpan> spans;
+    if (max_chunk_size_ <= 0 || text.length() <= max_chunk_size_) {
+        spans.append(TextChunkSpan{0, text.length()});
+    } else {
+        int effectiveChunkSize = max_chunk_size_;
+        int effectiveOverlap = chunk_overlap_;
+        if (effectiveOverlap >= effectiveChunkSize) {
+            effectiveOverlap = effectiveChunkSize - 1;
+        }
+        if (effectiveOverlap < 0) {
+            effectiveOverlap = 0;
+        }
 
-    if (text.length() <= effectiveChunkSize) {
-        return QStringList{text};
+        const QStringList separators = getSeparatorsForType(file_type_);
+        spans = splitRecursive(text, TextChunkSpan{0, text.length()}, effectiveChunkSize, effectiveOverlap,
+                               separators, 0);
     }
 
-    QStringList separators = getSeparatorsForType(file_type_);
-    return splitRecursive(text, effectiveChunkSize, effectiveOverlap, separators);
+    assignLineNumbers(text, spans);
+    return spans;
 }
 
-QStringList StandardCodeChunker::splitRecursive(const QString &text,
-                                                int chunkSize,
-                                                int chunkOverlap,
-                                                const QStringList &separators) const
+TextChunkSpan StandardCodeChunker::overlapOf(QStringView source, const TextChunkSpan &chunk, int chunkOverlap)
 {
-    if (text.length() <= chunkSize) {
-        return QStringList{text};
+    if (chunkOverlap <= 0 || chunk.length <= chunkOverlap) {
+        return TextChunkSpan{chunk.offset + chunk.length, 0};
     }
+    const qsizetype start = overlapStart(source.sliced(chunk.offset, chunk.length), chunkOverlap);
+    return TextChunkSpan{chunk.offset + start, chunk.length - start};
+}
 
-    if (separators.isEmpty()) {
-        QStringList result;
-        int pos = 0;
-        QString overlap;
-
-        while (pos < text.length()) {
-            QString chunk;
-
-            if (!overlap.isEmpty()) {
-                chunk = overlap;
-            }
-
-            int remaining = chunkSize - chunk.length();
-            if (remaining > 0) {
-                int idealEnd = pos + remaining;
-                int actualEnd = idealEnd;
-
-                if (idealEnd < text.length()) {
-                    actualEnd = ChunkerStrategy::findWordBoundary(text, idealEnd, 50);
-                    if (actualEnd <= pos) {
-                        actualEnd = idealEnd;
-                    }
-                }
-
-                int actualLength = actualEnd - pos;
-                chunk += text.mid(pos, actualLength);
-                pos = actualEnd;
-            }
+QList<TextChunkSpan> StandardCodeChunker::splitFixedWidth(QStringView source,
+                                                          const TextChunkSpan &range,
+                                                          int chunkSize,
+                                                          int chunkOverlap)
+{
+    QList<TextChunkSpan> result;
+    result.reserve(range.length / qMax(1, chunkSize - chunkOverlap) + 1);
+    const qsizetype end = range.offset + range.length;
+    qsizetype chunkBegin = range.offset;
+    qsizetype pos = range.offset;
+
+    while (pos < end) {
+        const qsizetype take = qMin<qsizetype>(chunkSize - (pos - chunkBegin), end - pos);
+        pos += take;
+        const TextChunkSpan chunk{chunkBegin, pos - chunkBegin};
+        result.append(chunk);
+
+        // An overlap leaving no room for new text is dropped, as a single piece would be
+        const TextChunkSpan overlap = overlapOf(source, chunk, chunkOverlap);
+        chunkBegin = (overlap.length > 0 && overlap.length < chunkSize) ? overlap.offset : pos;
+    }
 
-            if (!chunk.isEmpty()) {
-                result.append(chunk);
+    return result;
+}
 
-                if (chunkOverlap > 0 && chunk.length() > chunkOverlap) {
-                    overlap = ChunkerStrategy::extractOverlapSmart(chunk, chunkOverlap);
-                } else {
-                    overlap = chunk;
-                }
-            }
-        }
+QList<TextChunkSpan> StandardCodeChunker::splitRecursive(QStringView source,
+                                                         const TextChunkSpan &range,
+                                                         int chunkSize,
+                                                         int chunkOverlap,
+                                                         const QStringList &separators,
+                                                         qsizetype level) const
+{
+    if (range.length <= chunkSize) {
+        return QList<TextChunkSpan>{range};
+    }
 
-        return result;
+    // Lowest level, or no separator applies: cut the text into windows. This
+    // is what merging it one character at a time used to produce.
+    if (level >= separators.size() || separators[level].isEmpty()) {
+        return splitFixedWidth(source, range, chunkSize, chunkOverlap);
     }
 
-    const QString separator = separators.first();
-    const QStringList remainingSeparators = separators.mid(1);
+    const QString &separator = separators[level];
+    const QStringView text = source.sliced(range.offset, range.length);
 
-    // Split the text by the current separator into original parts.
-    QStringList parts;
-    if (separator.isEmpty()) {
-        // Lowest level: split into single characters.
-        for (int i = 0; i < text.length(); ++i) {
-            parts.append(text.mid(i, 1));
-        }
-    } else {
-        parts = text.split(separator, Qt::KeepEmptyParts);
-    }
+    // Walk the original parts between separators as ranges of the source.
+    QList<TextChunkSpan> result;
+    TextChunkSpan currentChunk{range.offset, 0};
 
-    QStringList result;
-    QString currentChunk;
-
-    for (int partIndex = 0; partIndex < parts.size(); ++partIndex) {
-        const QString &part = parts[partIndex];
-        const bool isLastPart = (partIndex == parts.size() - 1);
-
-        // Decide which logical pieces we will emit for this part: either the
-        // part itself (if small enough) or the sub-chunks produced by
-        // recursion on remaining separators.
-        QStringList pieces;
-        if (part.length() > chunkSize && !remainingSeparators.isEmpty()) {
-            pieces = splitRecursive(part, chunkSize, chunkOverlap, remainingSeparators);
-        } else if (part.length() > chunkSize && remainingSeparators.isEmpty()) {
-            // Fallback: use the character-level splitter from the base case.
-            pieces = splitRecursive(part, chunkSize, chunkOverlap, remainingSeparators);
+    qsizetype partStart = 0;
+    for (;;) {
+        const qsizetype partEnd = text.indexOf(separator, partStart);
+        const bool isLastPart = (partEnd < 0);
+        const TextChunkSpan part{range.offset + partStart, (isLastPart ? text.length() : partEnd) - partStart};
+
+        // Emit either the part itself (if small enough) or the sub-chunks
+        // produced by recursion on the remaining separators.
+        if (part.length <= chunkSize) {
+            mergeSplits(source, result, currentChunk, part, separator, chunkSize, chunkOverlap, true, !isLastPart);
         } else {
-            pieces.append(part);
+            const QList<TextChunkSpan> pieces =
+                splitRecursive(source, part, chunkSize, chunkOverlap, separators, level + 1);
+            for (qsizetype pieceIndex = 0; pieceIndex < pieces.size(); ++pieceIndex) {
+                const bool hasNextPiece = (pieceIndex + 1 < pieces.size()) || !isLastPart;
+                mergeSplits(source,
+                            result,
+                            currentChunk,
+                            pieces[pieceIndex],
+                            separator,
+                            chunkSize,
+                            chunkOverlap,
+                            pieceIndex == 0,
+                            hasNextPiece);
+            }
         }
 
-        for (int pieceIndex = 0; pieceIndex < pieces.size(); ++pieceIndex) {
-            const QString &piece = pieces[pieceIndex];
-            const bool isFirstPieceOfPart = (pieceIndex == 0);
-            const bool hasNextPiece = (pieceIndex + 1 < pieces.size()) || !isLastPart;
-
-            mergeSplits(result,
-                        currentChunk,
-                        piece,
-                        separator,
-                        chunkSize,
-                        chunkOverlap,
-                        isFirstPieceOfPart,
-                        hasNextPiece);
+        if (isLastPart) {
+            break;
         }
+        partStart = partEnd + separator.length();
     }
 
-    if (!currentChunk.isEmpty()) {
+    if (currentChunk.length > 0) {
         result.append(currentChunk);
     }
 
     return result;
 }
 
-void StandardCodeChunker::mergeSplits(QStringList &result,
-                                      QString &currentChunk,
-                                      const QString &piece,
+void StandardCodeChunker::mergeSplits(QStringView source,
+                                      QList<TextChunkSpan> &result,
+                                      TextChunkSpan &currentChunk,
+                                      const TextChunkSpan &piece,
                                       const QString &separator,
                                       int chunkSize,
                                       int chunkOverlap,
                                       bool isFirstPieceOfPart,
                                       bool hasNextPiece) const
 {
-    if (piece.isEmpty() && !hasNextPiece) {
+    if (piece.length == 0) {
         return;
     }
 
-    const bool isComment = (separator == "\n" || separator == "\n\n") &&
-                           file_type_ != FileType::PlainText &&
-                           isCommentStart(piece, file_type_);
-
-    QString candidateChunk = currentChunk;
-
-    // Golden Rule: only append the current separator when transitioning
-    // between original parts. Callers therefore pass isFirstPieceOfPart to
-    // indicate that we are at the start of a new part; we never insert the
-    // separator between recursive sub-pieces of the same part.
-    if (!candidateChunk.isEmpty() && !piece.isEmpty() && !separator.isEmpty() && isFirstPieceOfPart) {
-        candidateChunk += separator;
+    const qsizetype pieceEnd = piece.offset + piece.length;
+    const qsizetype currentEnd = currentChunk.offset + currentChunk.length;
+    // A recursive sub-piece may already lie inside the chunk through its own overlap
+    if (currentChunk.length > 0 && pieceEnd <= currentEnd) {
+        return;
     }
 
-    candidateChunk += piece;
+    const QStringView pieceText = source.sliced(piece.offset, piece.length);
+    const bool lineSeparator = (separator == QLatin1String("\n") || separator == QLatin1String("\n\n"));
+    const bool isComment = lineSeparator &&
+                           file_type_ != FileType::PlainText &&
+                           isCommentStart(pieceText, file_type_);
+
+    // Pieces arrive in source order, so extending a chunk to the end of the
+    // next piece takes in the separator between original parts (the "Golden
+    // Rule": separators only ever come from the text between parts) and
+    // swallows the overlap a recursive sub-piece starts with.
+    auto extendTo = [pieceEnd](TextChunkSpan start) {
+        return TextChunkSpan{start.offset, pieceEnd - start.offset};
+    };
+    const TextChunkSpan candidateChunk = currentChunk.length > 0 ? extendTo(currentChunk) : piece;
 
     const bool isPythonDefBoundary =
-        file_type_ == FileType::CodePython && separator.startsWith("\ndef ") && isFirstPieceOfPart;
+        file_type_ == FileType::CodePython && separator.startsWith(QLatin1String("\ndef ")) && isFirstPieceOfPart;
 
     // If the candidate still fits, accept it.
-    if (candidateChunk.length() <= chunkSize) {
+    if (candidateChunk.length <= chunkSize) {
         currentChunk = candidateChunk;
         return;
     }
@@ -282,41 +279,27 @@ void StandardCodeChunker::mergeSplits(QStringList &result,
     // existing chunk first and start a new one from this definition so that
     // small functions (like the ones used in tests) stay intact within a
     // single chunk when possible.
-    if (isPythonDefBoundary && !currentChunk.isEmpty()) {
+    if (isPythonDefBoundary && currentChunk.length > 0) {
         result.append(currentChunk);
 
-        if (chunkOverlap > 0 && currentChunk.length() > chunkOverlap) {
-            currentChunk = ChunkerStrategy::extractOverlapSmart(currentChunk, chunkOverlap);
-        } else {
-            currentChunk.clear();
-        }
-
-        candidateChunk = currentChunk;
-        if (!candidateChunk.isEmpty() && !separator.isEmpty()) {
-            candidateChunk += separator;
-        }
-        candidateChunk += piece;
-
-        if (candidateChunk.length() <= chunkSize) {
-            currentChunk = candidateChunk;
-        } else {
-            // As a last resort, fall back to keeping just the piece; deeper
-            // recursion or character-level splitting will handle oversize
-            // bodies.
-            currentChunk = piece;
-        }
-
+        const TextChunkSpan overlap = overlapOf(source, currentChunk, chunkOverlap);
+        const TextChunkSpan seeded = extendTo(overlap);
+        // As a last resort, fall back to keeping just the piece; deeper
+        // recursion or character-level splitting will handle oversize
+        // bodies.
+        currentChunk = (overlap.length > 0 && seeded.length <= chunkSize) ? seeded : piece;
         return;
     }
 
-    if (!currentChunk.isEmpty()) {
+    if (currentChunk.length > 0) {
         // Compute information about the last logical line in the current
         // chunk. This is used for both leading-comment and trailing-comment
         // glue behaviours.
-        const int lastNewline = currentChunk.lastIndexOf('\n');
-        const QString lastLine = (lastNewline == -1) ? currentChunk : currentChunk.mid(lastNewline + 1);
+        const QStringView currentText = source.sliced(currentChunk.offset, currentChunk.length);
+        const qsizetype lastNewline = currentText.lastIndexOf(u'\n');
+        const QStringView lastLine = (lastNewline == -1) ? currentText : currentText.sliced(lastNewline + 1);
         const bool lastLineIsComment =
-            (separator == "\n" || separator == "\n\n") &&
+            lineSeparator &&
             file_type_ != FileType::PlainText &&
             isCommentStart(lastLine, file_type_);
 
@@ -327,9 +310,9 @@ void StandardCodeChunker::mergeSplits(QStringList &result,
         // logically group documentation comments with the code they describe
         // and is only applied when both pieces individually fit within the
         // size limit to avoid unbounded growth.
-        if (!isComment && (separator == "\n" || separator == "\n\n") && lastLineIsComment &&
+        if (!isComment && lineSeparator && lastLineIsComment &&
             lastNewline == -1 &&
-            currentChunk.length() <= chunkSize && piece.length() <= chunkSize) {
+            currentChunk.length <= chunkSize && piece.length <= chunkSize) {
             // Accept the oversized candidate as-is so that the leading
             // comment stays attached to the following header (e.g., REXX
             // "/* Routine: foo */" + "foo: Procedure").
@@ -341,112 +324,42 @@ void StandardCodeChunker::mergeSplits(QStringList &result,
         // trailing comment line and adding this (likely code) piece would
         // overflow, migrate the comment forward so that it stays attached to
         // the code it documents.
-        if (!isComment && (separator == "\n" || separator == "\n\n") && hasNextPiece &&
+        if (!isComment && lineSeparator && hasNextPiece &&
             lastLineIsComment && lastNewline != -1) {
-            const QString chunkWithoutLastLine = currentChunk.left(lastNewline + 1);
-            const QString migratedComment = lastLine;
-
-            QString candidateWithoutComment = chunkWithoutLastLine;
-            if (!candidateWithoutComment.isEmpty() && !separator.isEmpty() && isFirstPieceOfPart) {
-                candidateWithoutComment += separator;
-            }
-            candidateWithoutComment += piece;
+            const qsizetype withoutCommentLength = (lastNewline + 1)
+                + ((!separator.isEmpty() && isFirstPieceOfPart) ? separator.length() : 0) + piece.length;
 
-            if (candidateWithoutComment.length() <= chunkSize) {
+            if (withoutCommentLength <= chunkSize) {
                 // Flush chunk without the trailing comment, start next chunk
                 // from the comment plus this piece.
+                const TextChunkSpan chunkWithoutLastLine{currentChunk.offset, lastNewline + 1};
                 result.append(chunkWithoutLastLine);
 
-                if (chunkOverlap > 0 && chunkWithoutLastLine.length() > chunkOverlap) {
-                    currentChunk =
-                        ChunkerStrategy::extractOverlapSmart(chunkWithoutLastLine, chunkOverlap);
-                } else {
-                    currentChunk.clear();
-                }
-
-                if (!currentChunk.isEmpty() && !separator.isEmpty() && isFirstPieceOfPart) {
-                    currentChunk += separator;
-                }
-                currentChunk += migratedComment;
-                if (!separator.isEmpty()) {
-                    currentChunk += separator;
-                }
-                currentChunk += piece;
+                const TextChunkSpan overlap = overlapOf(source, chunkWithoutLastLine, chunkOverlap);
+                currentChunk = extendTo(overlap);
                 return;
             }
         }
+
+        result.append(currentChunk);
+        const TextChunkSpan overlap = overlapOf(source, currentChunk, chunkOverlap);
+
         // Comment glue: keep trailing comment lines attached to the following
         // code by starting the next chunk from the comment rather than
         // leaving it orphaned at the previous boundary.
         if (isComment && hasNextPiece) {
-            result.append(currentChunk);
-
-            if (chunkOverlap > 0 && currentChunk.length() > chunkOverlap) {
-                currentChunk = ChunkerStrategy::extractOverlapSmart(currentChunk, chunkOverlap);
-            } else {
-                currentChunk.clear();
-            }
-
-            if (!currentChunk.isEmpty() && !separator.isEmpty() && isFirstPieceOfPart) {
-                currentChunk += separator;
-            }
-            currentChunk += piece;
+            currentChunk = overlap.length > 0 ? extendTo(overlap) : piece;
+        } else if (overlap.length > 0) {
+            // Seed the new chunk with the overlap. Because chunks are ranges
+            // of the source, a piece that starts inside the overlap (as
+            // recursive sub-pieces do) is never duplicated.
+            const TextChunkSpan seeded = extendTo(overlap);
+
+            // When the piece still does not fit together with the overlap,
+            // start the new chunk from the piece alone.
+            currentChunk = seeded.length <= chunkSize ? seeded : piece;
         } else {
-            result.append(currentChunk);
-
-            if (chunkOverlap > 0 && currentChunk.length() > chunkOverlap) {
-                currentChunk = ChunkerStrategy::extractOverlapSmart(currentChunk, chunkOverlap);
-
-                // Deduplicate across the chunk boundary: when we seed the new
-                // chunk from an overlap taken from the end of the previous
-                // chunk, the very next piece is often the same logical line
-                // (e.g. a SQL statement or code line). The raw overlap text
-                // may already contain that line in full, so blindly
-                // appending the piece would duplicate it inside the new
-                // chunk. To avoid this, trim any common suffix/prefix between
-                // the current overlap and the upcoming piece.
-
-                QString adjustedPiece = piece;
-
-                // Find the longest suffix of currentChunk that is also a
-                // prefix of piece.
-                int maxShared = qMin(currentChunk.length(), piece.length());
-                int sharedLen = 0;
-                for (int len = maxShared; len > 0; --len) {
-                    if (currentChunk.right(len) == piece.left(len)) {
-                        sharedLen = len;
-                        break;
-                    }
-                }
-
-                if (sharedLen > 0) {
-                    adjustedPiece = piece.mid(sharedLen);
-
-                    // If the piece is fully covered by the overlap, there is
-                    // nothing new to append for this boundary.
-                    if (adjustedPiece.isEmpty()) {
-                        return;
-                    }
-                }
-
-                candidateChunk = currentChunk;
-                if (!candidateChunk.isEmpty() && !adjustedPiece.isEmpty() && !separator.isEmpty() &&
-                    isFirstPieceOfPart) {
-                    candidateChunk += separator;
-                }
-                candidateChunk += adjustedPiece;
-
-                if (candidateChunk.length() <= chunkSize) {
-                    currentChunk = candidateChunk;
-                } else {
-                    // The adjusted piece still does not fit when combined
-                    // with the overlap; fall back to starting the new chunk
-                    // from the (deduplicated) piece alone.
-                    currentChunk = adjustedPiece;
-                }
-            } else {
-                currentChunk = piece;
-            }
+            currentChunk = piece;
         }
     } else {
         currentChunk = piece;
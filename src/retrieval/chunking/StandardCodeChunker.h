@@ -21,17 +21,35 @@ public:
     {
     }
 
-    QStringList chunk(const QString &text) override;
+    QList<TextChunkSpan> chunkSpans(const QString &text) override;
 
 private:
     static QStringList getSeparatorsForType(FileType fileType);
-    static bool isCommentStart(const QString &line, FileType fileType);
-    static bool isMarkdownHeader(const QString &line);
+    static bool isCommentStart(QStringView line, FileType fileType);
+    static bool isMarkdownHeader(QStringView line);
 
-    QStringList splitRecursive(const QString &text,
-                               int chunkSize,
-                               int chunkOverlap,
-                               const QStringList &separators) const;
+    ///
+    /// @brief Split @p range of @p source on separators[level], recursing into parts that are still too large.
+    ///
+    /// Parts are ranges of @p source and each level scans it once, so the
+    /// work is linear in the input for a fixed separator hierarchy. Nothing
+    /// is copied; chunks are returned as spans.
+    ///
+    QList<TextChunkSpan> splitRecursive(QStringView source,
+                                        const TextChunkSpan &range,
+                                        int chunkSize,
+                                        int chunkOverlap,
+                                        const QStringList &separators,
+                                        qsizetype level) const;
+
+    /// Last resort for text no separator can break: consecutive windows of chunkSize characters with overlap.
+    static QList<TextChunkSpan> splitFixedWidth(QStringView source,
+                                                const TextChunkSpan &range,
+                                                int chunkSize,
+                                                int chunkOverlap);
+
+    /// The trailing part of @p chunk to repeat at the start of the next one; empty (at the chunk end) if none.
+    static TextChunkSpan overlapOf(QStringView source, const TextChunkSpan &chunk, int chunkOverlap);
 
     ///
     /// @brief Append a single logical piece of text to the current chunk list.
@@ -40,11 +58,13 @@ private:
     /// It is intentionally unaware of recursion topology: callers are
     /// responsible for honouring the "Golden Rule" that high-level separators
     /// are only re-inserted between original top-level parts, never between
-    /// recursively produced sub-chunks.
+    /// recursively produced sub-chunks. Since pieces are ranges of
+    /// @p source, that holds by construction.
     ///
-    void mergeSplits(QStringList &result,
-                     QString &currentChunk,
-                     const QString &piece,
+    void mergeSplits(QStringView source,
+                     QList<TextChunkSpan> &result,
+                     TextChunkSpan &currentChunk,
+                     const TextChunkSpan &piece,
                      const QString &separator,
                      int chunkSize,
                      int chunkOverlap,
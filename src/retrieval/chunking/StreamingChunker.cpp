@@ -0,0 +1,145 @@
+#include "retrieval/chunking/StreamingChunker.h"
+
+#include <utility>
+
+namespace {
+
+// Characters past a scanned window that classifying a line at its end may read
+constexpr qsizetype kLookahead = 8;
+
+} // namespace
+
+StreamingChunker::StreamingChunker(int chunkSize, int chunkOverlap, FileType fileType, ChunkHandler handler,
+                                   qsizetype regionLength)
+    : m_chunkSize(chunkSize)
+    , m_chunkOverlap(chunkOverlap)
+    , m_fileType(fileType)
+    , m_handler(std::move(handler))
+    , m_regionLength(regionLength)
+{
+}
+
+void StreamingChunker::append(QStringView text)
+{
+    m_buffer.append(text);
+    if (m_chunkSize <= 0 || m_regionLength <= 0) {
+        return;
+    }
+
+    // Only whole windows are scanned, so a cut is the one the whole text would give
+    for (;;) {
+        const qsizetype limit = (m_buffer.length() - kLookahead) / m_regionLength * m_regionLength;
+        if (limit < 2 * m_regionLength || limit <= m_scanned) {
+            return;
+        }
+        bool cutIsClean = false;
+        const qsizetype cut = ParallelChunker::nextRegionCut(m_buffer, qMax(m_scanned, m_regionLength), limit,
+                                                             m_regionLength, m_fileType, &cutIsClean);
+        if (cut >= 0) {
+            emitRegion(cut, cutIsClean);
+            continue;
+        }
+        m_scanned = limit;
+        if (m_buffer.length() < 4 * m_regionLength) {
+            return;
+        }
+        emitRegion(forcedCut(), false);
+    }
+}
+
+void StreamingChunker::finish()
+{
+    if (m_chunkSize > 0 && m_regionLength > 0) {
+        while (m_buffer.length() > m_regionLength) {
+            bool cutIsClean = false;
+            const qsizetype cut = ParallelChunker::nextRegionCut(m_buffer, qMax(m_scanned, m_regionLength),
+                                                                 m_buffer.length(), m_regionLength, m_fileType,
+                                                                 &cutIsClean);
+            if (cut < 0) {
+                break;
+            }
+            emitRegion(cut, cutIsClean);
+        }
+    }
+    if (!m_buffer.isEmpty()) {
+        emitRegion(m_buffer.length(), false);
+    }
+
+    m_bufferOffset = 0;
+    m_bufferLine = 0;
+    m_scanned = 0;
+    m_cleanBreak = false;
+    m_hasCarry = false;
+    m_carry.clear();
+}
+
+void StreamingChunker::emitRegion(qsizetype cut, bool nextStartsCleanly)
+{
+    // region borrows the buffer, so text kept past this call is taken as copies of the view
+    const QString region = QString::fromRawData(m_buffer.constData(), cut);
+    const QStringView view(region);
+    QList<TextChunkSpan> spans = TextChunker::splitSpans(region, m_chunkSize, m_chunkOverlap, m_fileType);
+    for (TextChunkSpan& span : spans) {
+        span.offset += m_bufferOffset;
+        span.startLine += static_cast<int>(m_bufferLine);
+        span.endLine += static_cast<int>(m_bufferLine);
+    }
+
+    if (spans.isEmpty()) {
+        if (m_hasCarry) {
+            m_carry += view;
+        }
+    } else {
+        // Stitch the first chunk to the last one of the previous region, as ParallelChunker does
+        QString firstText;
+        if (m_hasCarry && !m_cleanBreak) {
+            TextChunkSpan& first = spans.first();
+            const qsizetype carryOffset = m_carrySpan.offset;
+            const QString joined = m_carry + view.first(first.offset + first.length - m_bufferOffset).toString();
+            TextChunkSpan previous = m_carrySpan;
+            previous.offset = 0;
+            TextChunkSpan next = first;
+            next.offset -= carryOffset;
+            const qsizetype unstitched = next.offset;
+            ParallelChunker::carryOverlap(joined, previous, next, m_chunkSize,
+                                          qBound(0, m_chunkOverlap, qMax(0, m_chunkSize - 1)));
+            if (next.offset != unstitched) {
+                firstText = joined.mid(next.offset, next.length);
+                next.offset += carryOffset;
+                first = next;
+            }
+        }
+
+        QString lastText;
+        for (qsizetype i = 0; i < spans.size(); ++i) {
+            const TextChunkSpan& span = spans.at(i);
+            lastText = (i == 0 && !firstText.isNull())
+                ? firstText
+                : view.sliced(span.offset - m_bufferOffset, span.length).toString();
+            m_handler(lastText, span);
+        }
+
+        const TextChunkSpan& last = spans.last();
+        const qsizetype lastEnd = last.offset + last.length - m_bufferOffset;
+        m_carry = lastText + view.sliced(lastEnd).toString();
+        m_carrySpan = last;
+        m_hasCarry = true;
+    }
+
+    m_bufferLine += view.count(u'\n');
+    m_bufferOffset += cut;
+    m_buffer.remove(0, cut);
+    m_scanned = 0;
+    m_cleanBreak = nextStartsCleanly;
+}
+
+qsizetype StreamingChunker::forcedCut() const
+{
+    // After the last line end in the first two regions, else mid-line between code points
+    const qsizetype newline = QStringView(m_buffer).first(2 * m_regionLength).lastIndexOf(u'\n');
+    qsizetype cut = newline > 0 ? newline + 1 : 2 * m_regionLength;
+    if (m_buffer.at(cut - 1).isHighSurrogate()) {
+        --cut;
+    }
+    return cut;
+}
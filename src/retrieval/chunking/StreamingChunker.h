@@ -0,0 +1,62 @@
+#ifndef STREAMINGCHUNKER_H
+#define STREAMINGCHUNKER_H
+
+#include <QString>
+#include <QStringView>
+
+#include <functional>
+
+#include "retrieval/chunking/ParallelChunker.h"
+#include "retrieval/chunking/TextChunker.h"
+
+/**
+ * @brief Chunks text that arrives in windows, holding about one region at a time.
+ *
+ * Text is buffered until a region boundary (see ParallelChunker) is certain,
+ * then that region is chunked, its chunks are handed to the handler and the
+ * buffer is dropped up to the cut. The chunks equal those of
+ * ParallelChunker::splitSpans() over the whole text, with offsets and lines
+ * counted from the start of the stream. Text with no boundary at all is cut
+ * at a line end once four regions are buffered, so memory stays bounded.
+ */
+class StreamingChunker
+{
+public:
+    /// Receives each chunk's text and its span over the whole stream, in order.
+    using ChunkHandler = std::function<void(const QString& chunk, const TextChunkSpan& span)>;
+
+    StreamingChunker(int chunkSize, int chunkOverlap, FileType fileType, ChunkHandler handler,
+                     qsizetype regionLength = ParallelChunker::kDefaultRegionLength);
+
+    /// Adds the next window of text; any regions it completes are chunked and emitted.
+    void append(QStringView text);
+
+    /// Chunks and emits the rest of the text. The chunker can then take a new stream.
+    void finish();
+
+private:
+    void emitRegion(qsizetype cut, bool nextStartsCleanly);
+    qsizetype forcedCut() const;
+
+    const int m_chunkSize;
+    const int m_chunkOverlap;
+    const FileType m_fileType;
+    const ChunkHandler m_handler;
+    const qsizetype m_regionLength;
+
+    // Text not chunked yet, starting m_bufferOffset characters and m_bufferLine lines into the stream
+    QString m_buffer;
+    qsizetype m_bufferOffset {0};
+    qsizetype m_bufferLine {0};
+    // m_buffer holds no region boundary before this
+    qsizetype m_scanned {0};
+    // m_buffer starts at a Markdown header, which takes no overlap
+    bool m_cleanBreak {false};
+
+    // The last chunk emitted and the text after it up to m_buffer, to carry its overlap
+    bool m_hasCarry {false};
+    QString m_carry;
+    TextChunkSpan m_carrySpan;
+};
+
+#endif // STREAMINGCHUNKER_H
@@ -5,16 +5,26 @@
 
 #include <memory>
 
-QStringList TextChunker::split(const QString &text, int chunkSize, int chunkOverlap,
-                               FileType fileType)
-{
-    std::unique_ptr<ChunkerStrategy> strategy;
+namespace {
 
+std::unique_ptr<ChunkerStrategy> strategyFor(int chunkSize, int chunkOverlap, FileType fileType)
+{
     if (fileType == FileType::CodeMarkdown) {
-        strategy = std::make_unique<MarkdownChunker>(chunkSize, chunkOverlap);
-    } else {
-        strategy = std::make_unique<StandardCodeChunker>(chunkSize, chunkOverlap, fileType);
+        return std::make_unique<MarkdownChunker>(chunkSize, chunkOverlap);
     }
+    return std::make_unique<StandardCodeChunker>(chunkSize, chunkOverlap, fileType);
+}
+
+} // namespace
 
-    return strategy->chunk(text);
+QStringList TextChunker::split(const QString &text, int chunkSize, int chunkOverlap,
+                               FileType fileType)
+{
+    return strategyFor(chunkSize, chunkOverlap, fileType)->chunk(text);
+}
+
+QList<TextChunkSpan> TextChunker::splitSpans(const QString &text, int chunkSize, int chunkOverlap,
+                                             FileType fileType)
+{
+    return strategyFor(chunkSize, chunkOverlap, fileType)->chunkSpans(text);
 }
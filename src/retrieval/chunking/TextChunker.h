@@ -1,6 +1,7 @@
 #ifndef TEXTCHUNKER_H
 #define TEXTCHUNKER_H
 
+#include <QList>
 #include <QString>
 #include <QStringList>
 
@@ -20,6 +21,20 @@ enum class FileType
     CodeYaml     // YAML/Terraform-family: YAML, Terraform, HCL
 };
 
+/**
+ * @brief One chunk as a range of the source text.
+ *
+ * Chunks are contiguous ranges of the text they were cut from; consecutive
+ * spans overlap by the chunk overlap. Lines are 1-based and inclusive, and a
+ * chunk ending in a newline ends on that newline's line.
+ */
+struct TextChunkSpan {
+    qsizetype offset {0};
+    qsizetype length {0};
+    int startLine {0};
+    int endLine {0};
+};
+
 /**
  * @brief TextChunker implements a Recursive Character Text Splitter strategy
  *        for breaking large documents into overlapping chunks suitable for
@@ -52,6 +67,15 @@ public:
      */
     static QStringList split(const QString& text, int chunkSize, int chunkOverlap,
                              FileType fileType = FileType::PlainText);
+
+    /**
+     * @brief The chunks split() returns, as spans over @p text with their line ranges.
+     *
+     * Nothing is copied: callers materialise a chunk with
+     * text.mid(span.offset, span.length) when they need its text.
+     */
+    static QList<TextChunkSpan> splitSpans(const QString& text, int chunkSize, int chunkOverlap,
+                                           FileType fileType = FileType::PlainText);
 };
 
 #endif // TEXTCHUNKER_H
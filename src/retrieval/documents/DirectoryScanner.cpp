@@ -0,0 +1,359 @@
+#include "DirectoryScanner.h"
+#include "DocumentLoader.h"
+#include "MetricsRegistry.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <deque>
+#include <optional>
+#include <vector>
+
+namespace {
+
+struct IgnoreRule {
+    // Directory of the ignore file, with a trailing slash
+    QString basePrefix;
+    QRegularExpression pattern;
+    bool negated {false};
+    bool directoryOnly {false};
+    // Matched against the path below basePrefix rather than the bare name
+    bool anchored {false};
+};
+
+// Shared down the tree; a directory with its own ignore files gets an extended copy
+using IgnoreRules = std::shared_ptr<const std::vector<IgnoreRule>>;
+
+struct PendingDirectory {
+    QString path;
+    IgnoreRules rules;
+};
+
+// gitignore wildcards: '*' and '?' stop at '/', '**' crosses directories
+QString globToRegularExpression(QStringView glob)
+{
+    QString regex;
+    for (qsizetype i = 0; i < glob.size(); ++i) {
+        const QChar c = glob[i];
+        if (c == u'*') {
+            if (i + 1 < glob.size() && glob[i + 1] == u'*') {
+                ++i;
+                if (i + 1 < glob.size() && glob[i + 1] == u'/') {
+                    ++i;
+                    regex += QStringLiteral("(?:.*/)?");
+                } else {
+                    regex += QStringLiteral(".*");
+                }
+            } else {
+                regex += QStringLiteral("[^/]*");
+            }
+        } else if (c == u'?') {
+            regex += QStringLiteral("[^/]");
+        } else if (c == u'[') {
+            // A ']' straight after the '[' belongs to the set
+            const qsizetype close = glob.indexOf(u']', i + 2);
+            if (close < 0) {
+                regex += QStringLiteral("\\[");
+                continue;
+            }
+            QStringView set = glob.sliced(i + 1, close - i - 1);
+            regex += u'[';
+            if (set.startsWith(u'!') || set.startsWith(u'^')) {
+                regex += u'^';
+                set = set.sliced(1);
+            }
+            for (const QChar member : set) {
+                if (member == u'\\' || member == u'[') {
+                    regex += u'\\';
+                }
+                regex += member;
+            }
+            regex += u']';
+            i = close;
+        } else if (c == u'\\' && i + 1 < glob.size()) {
+            regex += QRegularExpression::escape(glob.sliced(++i, 1));
+        } else {
+            regex += QRegularExpression::escape(glob.sliced(i, 1));
+        }
+    }
+    return regex;
+}
+
+std::optional<IgnoreRule> parseIgnoreLine(QString line, const QString& basePrefix)
+{
+    // Trailing blanks are dropped unless escaped
+    while (!line.isEmpty() && line.back().isSpace() && !line.endsWith(QLatin1String("\\ "))) {
+        line.chop(1);
+    }
+    if (line.isEmpty() || line.startsWith(u'#')) {
+        return std::nullopt;
+    }
+
+    IgnoreRule rule;
+    rule.basePrefix = basePrefix;
+    if (line.startsWith(u'!')) {
+        rule.negated = true;
+        line.remove(0, 1);
+    } else if (line.startsWith(QLatin1String("\\!")) || line.startsWith(QLatin1String("\\#"))) {
+        line.remove(0, 1);
+    }
+    if (line.endsWith(u'/')) {
+        rule.directoryOnly = true;
+        line.chop(1);
+    }
+    if (line.startsWith(u'/')) {
+        rule.anchored = true;
+        line.remove(0, 1);
+    }
+    // A slash anywhere but the end ties the pattern to the ignore file's directory
+    rule.anchored = rule.anchored || line.contains(u'/');
+    if (line.isEmpty()) {
+        return std::nullopt;
+    }
+
+    rule.pattern = QRegularExpression(QRegularExpression::anchoredPattern(globToRegularExpression(line)));
+    if (!rule.pattern.isValid()) {
+        return std::nullopt;
+    }
+    return rule;
+}
+
+IgnoreRules withIgnoreFiles(const IgnoreRules& inherited, const QString& directory)
+{
+    const QString basePrefix = directory.endsWith(u'/') ? directory : directory + u'/';
+    std::vector<IgnoreRule> added;
+    for (const QLatin1String fileName : {QLatin1String(".gitignore"), QLatin1String(".ragignore")}) {
+        QFile file(basePrefix + fileName);
+        if (!file.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        const QStringList lines = QString::fromUtf8(file.readAll()).split(u'\n');
+        for (const QString& line : lines) {
+            if (std::optional<IgnoreRule> rule = parseIgnoreLine(line, basePrefix)) {
+                added.push_back(std::move(*rule));
+            }
+        }
+    }
+    if (added.empty()) {
+        return inherited;
+    }
+
+    auto rules = std::make_shared<std::vector<IgnoreRule>>();
+    if (inherited) {
+        *rules = *inherited;
+    }
+    rules->insert(rules->end(), std::make_move_iterator(added.begin()), std::make_move_iterator(added.end()));
+    return rules;
+}
+
+// The last rule that matches decides
+bool isIgnored(const std::vector<IgnoreRule>& rules, const QString& path, const QString& name, bool isDirectory)
+{
+    for (auto it = rules.rbegin(); it != rules.rend(); ++it) {
+        const IgnoreRule& rule = *it;
+        if (rule.directoryOnly && !isDirectory) {
+            continue;
+        }
+        const QString subject = rule.anchored ? path.mid(rule.basePrefix.length()) : name;
+        if (rule.pattern.match(subject).hasMatch()) {
+            return !rule.negated;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+struct DirectoryScanner::Shared {
+    QString rootPath;
+    QStringList nameFilters;
+    bool useIgnoreFiles {true};
+    QThreadPool pool;
+
+    QMutex mutex;
+    QWaitCondition directoriesQueued;
+    QWaitCondition filesFound;
+    std::deque<PendingDirectory> directories;
+    QStringList found;
+    // Workers listing a directory, which may queue more
+    int active {0};
+    QElapsedTimer elapsed;
+    bool finished {false};
+    bool stopped {false};
+
+    void work();
+    void listDirectory(const PendingDirectory& directory, QStringList& files,
+                       std::vector<PendingDirectory>& subdirectories) const;
+};
+
+void DirectoryScanner::Shared::work()
+{
+    for (;;) {
+        PendingDirectory directory;
+        {
+            QMutexLocker locker(&mutex);
+            while (directories.empty() && active > 0 && !stopped) {
+                directoriesQueued.wait(&mutex);
+            }
+            if (stopped || directories.empty()) {
+                return;
+            }
+            directory = std::move(directories.front());
+            directories.pop_front();
+            ++active;
+        }
+
+        QStringList files;
+        std::vector<PendingDirectory> subdirectories;
+        listDirectory(directory, files, subdirectories);
+
+        QMutexLocker locker(&mutex);
+        if (!stopped) {
+            for (PendingDirectory& subdirectory : subdirectories) {
+                directories.push_back(std::move(subdirectory));
+            }
+        }
+        if (!files.isEmpty()) {
+            found.append(files);
+            filesFound.wakeAll();
+        }
+        --active;
+        if (active == 0 && directories.empty()) {
+            finished = true;
+            if (!stopped) {
+                MetricsRegistry::instance()
+                    .histogram(QStringLiteral("cp_rag_scan_seconds"),
+                               QStringLiteral("Time to walk a document directory tree"))
+                    .observe(elapsed.nsecsElapsed() / 1e9);
+            }
+            filesFound.wakeAll();
+            directoriesQueued.wakeAll();
+        } else if (!subdirectories.empty()) {
+            directoriesQueued.wakeAll();
+        }
+    }
+}
+
+void DirectoryScanner::Shared::listDirectory(const PendingDirectory& directory, QStringList& files,
+                                             std::vector<PendingDirectory>& subdirectories) const
+{
+    const IgnoreRules rules = useIgnoreFiles ? withIgnoreFiles(directory.rules, directory.path) : directory.rules;
+
+    // Without QDir::Hidden, as QDirIterator walks by default
+    const QFileInfoList entries =
+        QDir(directory.path).entryInfoList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot, QDir::NoSort);
+    for (const QFileInfo& entry : entries) {
+        const QString name = entry.fileName();
+        const QString path = entry.absoluteFilePath();
+        if (entry.isDir()) {
+            if (entry.isSymLink() || prunedDirectoryNames().contains(name)
+                || (rules && isIgnored(*rules, path, name, true))) {
+                continue;
+            }
+            subdirectories.push_back(PendingDirectory{path, rules});
+        } else if (entry.isFile()) {
+            if (rules && isIgnored(*rules, path, name, false)) {
+                continue;
+            }
+            const bool wanted = nameFilters.isEmpty() ? DocumentLoader::hasSupportedExtension(name)
+                                                      : QDir::match(nameFilters, name);
+            if (wanted) {
+                files.append(path);
+            }
+        }
+    }
+}
+
+const QStringList& DirectoryScanner::prunedDirectoryNames()
+{
+    static const QStringList names = {
+        QStringLiteral(".git"),
+        QStringLiteral(".hg"),
+        QStringLiteral(".svn"),
+        QStringLiteral("node_modules"),
+        QStringLiteral("__pycache__"),
+    };
+    return names;
+}
+
+DirectoryScanner::DirectoryScanner(const QString& rootPath, const QStringList& nameFilters, bool useIgnoreFiles,
+                                   int threads)
+    : m_shared(std::make_unique<Shared>())
+    , m_threads(threads > 0 ? threads : qBound(1, QThread::idealThreadCount(), 8))
+{
+    m_shared->rootPath = QDir(rootPath).absolutePath();
+    m_shared->nameFilters = nameFilters;
+    m_shared->useIgnoreFiles = useIgnoreFiles;
+    m_shared->pool.setMaxThreadCount(m_threads);
+}
+
+DirectoryScanner::~DirectoryScanner()
+{
+    stop();
+    m_shared->pool.waitForDone();
+}
+
+void DirectoryScanner::start()
+{
+    if (m_started) {
+        return;
+    }
+    m_started = true;
+    {
+        QMutexLocker locker(&m_shared->mutex);
+        m_shared->elapsed.start();
+        m_shared->directories.push_back(PendingDirectory{m_shared->rootPath, IgnoreRules()});
+    }
+    Shared* shared = m_shared.get();
+    for (int i = 0; i < m_threads; ++i) {
+        m_shared->pool.start([shared]() { shared->work(); });
+    }
+}
+
+bool DirectoryScanner::takeFiles(QStringList& files, int timeoutMs)
+{
+    QMutexLocker locker(&m_shared->mutex);
+    if (m_shared->found.isEmpty() && !m_shared->finished && timeoutMs > 0) {
+        m_shared->filesFound.wait(&m_shared->mutex, static_cast<unsigned long>(timeoutMs));
+    }
+    const bool took = !m_shared->found.isEmpty();
+    files.append(m_shared->found);
+    m_shared->found.clear();
+    return took || !m_shared->finished;
+}
+
+bool DirectoryScanner::isFinished() const
+{
+    QMutexLocker locker(&m_shared->mutex);
+    return m_shared->finished;
+}
+
+void DirectoryScanner::stop()
+{
+    QMutexLocker locker(&m_shared->mutex);
+    m_shared->stopped = true;
+    m_shared->directories.clear();
+    if (m_shared->active == 0) {
+        m_shared->finished = true;
+    }
+    m_shared->directoriesQueued.wakeAll();
+    m_shared->filesFound.wakeAll();
+}
+
+QStringList DirectoryScanner::scan(const QString& rootPath, const QStringList& nameFilters, bool useIgnoreFiles)
+{
+    DirectoryScanner scanner(rootPath, nameFilters, useIgnoreFiles);
+    scanner.start();
+    QStringList files;
+    while (scanner.takeFiles(files, 100)) {
+    }
+    files.sort();
+    return files;
+}
@@ -0,0 +1,71 @@
+#ifndef DIRECTORYSCANNER_H
+#define DIRECTORYSCANNER_H
+
+#include <QString>
+#include <QStringList>
+
+#include <memory>
+
+/**
+ * @brief Walks a directory tree on several threads, handing out files as they are found.
+ *
+ * Each directory is listed by whichever worker takes it, and its subdirectories
+ * are queued for the others, so a wide tree is walked in parallel. Files match
+ * the same rules as DocumentLoader::scanDirectory(): @p nameFilters when given,
+ * otherwise the supported extensions. Hidden entries and symbolic links to
+ * directories are skipped as before, and directories that never hold sources
+ * (version control metadata, node_modules) are pruned without being listed.
+ *
+ * With ignore files enabled, `.gitignore` and `.ragignore` in every directory
+ * apply to that directory and below, using the common gitignore syntax:
+ * comments, `!` negation, a trailing `/` for directories only, a leading or
+ * inner `/` to anchor a pattern to its directory, and `*`, `?`, `[...]` and
+ * `**` wildcards. Rules read later win, children override their parents and
+ * `.ragignore` overrides `.gitignore`. An ignored directory is not descended.
+ *
+ * Files arrive in no particular order; scan() returns them sorted.
+ */
+class DirectoryScanner
+{
+public:
+    /// Directory names that are never descended into.
+    static const QStringList& prunedDirectoryNames();
+
+    DirectoryScanner(const QString& rootPath, const QStringList& nameFilters = QStringList(),
+                     bool useIgnoreFiles = true, int threads = 0);
+    /// Stops the walk and waits for the workers.
+    ~DirectoryScanner();
+
+    DirectoryScanner(const DirectoryScanner&) = delete;
+    DirectoryScanner& operator=(const DirectoryScanner&) = delete;
+
+    /// Starts the workers; files can be taken right away.
+    void start();
+
+    /**
+     * @brief Moves the files found since the last call onto @p files.
+     *
+     * Waits up to @p timeoutMs for at least one file when none are waiting.
+     * @return false once the walk is over and every file has been taken
+     */
+    bool takeFiles(QStringList& files, int timeoutMs = 0);
+
+    /// Whether the walk is over; files may still be waiting to be taken.
+    bool isFinished() const;
+
+    /// Ends the walk early; directories not yet listed are dropped.
+    void stop();
+
+    /// Runs a whole scan and returns the sorted absolute paths.
+    static QStringList scan(const QString& rootPath, const QStringList& nameFilters = QStringList(),
+                            bool useIgnoreFiles = true);
+
+private:
+    struct Shared;
+
+    std::unique_ptr<Shared> m_shared;
+    int m_threads;
+    bool m_started {false};
+};
+
+#endif // DIRECTORYSCANNER_H
@@ -2,7 +2,7 @@
 #include "TextChunker.h"
 #include <QDirIterator>
 #include <QFile>
-#include <QTextStream>
+#include <QStringDecoder>
 #include <QFileInfo>
 #include "Logger.h"
 
@@ -42,23 +42,92 @@ QStringList DocumentLoader::scanDirectory(const QString& rootPath, const QString
 }
 
 QString DocumentLoader::readTextFile(const QString& filePath)
+{
+    QString content;
+    content.reserve(static_cast<qsizetype>(QFileInfo(filePath).size()));
+    const bool ok = streamTextFile(filePath, [&content](QStringView window) {
+        content.append(window);
+        return true;
+    });
+    return ok ? content : QString();
+}
+
+bool DocumentLoader::streamTextFile(const QString& filePath,
+                                    const std::function<bool(QStringView window)>& consumer,
+                                    qint64 windowBytes)
 {
     QFile file(filePath);
     
     // Try to open the file for reading
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    if (!file.open(QIODevice::ReadOnly)) {
         CP_WARN << "DocumentLoader: Failed to open file:" << filePath 
                    << "Error:" << file.errorString();
-        return QString();
+        return false;
     }
-    
-    // Read the content as UTF-8 text
-    QTextStream stream(&file);
-    stream.setEncoding(QStringConverter::Utf8);
-    QString content = stream.readAll();
-    
-    file.close();
-    return content;
+
+    // Decoded as UTF-8, skipping a byte order mark as QTextStream does
+    QStringDecoder decoder(QStringConverter::Utf8);
+    windowBytes = qMax<qint64>(1, windowBytes);
+    const qint64 size = file.size();
+    bool pendingCarriageReturn = false;
+    QByteArray block;
+
+    // Line endings are normalised as a QIODevice::Text read does. A '\r'
+    // ending a window waits for the next one in case it starts with '\n'.
+    auto deliver = [&](QString window, bool last) {
+        if (pendingCarriageReturn) {
+            window.prepend(QLatin1Char('\r'));
+            pendingCarriageReturn = false;
+        }
+        if (!last && window.endsWith(QLatin1Char('\r'))) {
+            window.chop(1);
+            pendingCarriageReturn = true;
+        }
+        window.replace(QLatin1String("\r\n"), QLatin1String("\n"));
+        return window.isEmpty() || consumer(window);
+    };
+
+    for (qint64 pos = 0; size == 0 || pos < size;) {
+        QString window;
+        if (size > 0) {
+            const qint64 length = qMin(windowBytes, size - pos);
+            if (uchar* mapped = file.map(pos, length)) {
+                window = decoder(QByteArrayView(mapped, length));
+                file.unmap(mapped);
+                pos += length;
+            } else {
+                // Not mappable (e.g. a pipe or some network filesystems)
+                if (!file.seek(pos)) {
+                    break;
+                }
+                block = file.read(length);
+                if (block.isEmpty()) {
+                    break;
+                }
+                window = decoder(block);
+                pos += block.size();
+            }
+        } else {
+            // Devices that report no size are read until they run dry
+            block = file.read(windowBytes);
+            if (block.isEmpty()) {
+                break;
+            }
+            window = decoder(block);
+            pos += block.size();
+        }
+        if (!deliver(std::move(window), false)) {
+            return true;
+        }
+    }
+
+    if (file.error() != QFileDevice::NoError) {
+        CP_WARN << "DocumentLoader: Failed to read file:" << filePath
+                   << "Error:" << file.errorString();
+        return false;
+    }
+    deliver(QString(), true);
+    return true;
 }
 
 bool DocumentLoader::hasSupportedExtension(const QString& fileName)
@@ -3,8 +3,11 @@
 
 #include <QString>
 #include <QStringList>
+#include <QStringView>
 #include "TextChunker.h"
 
+#include <functional>
+
 /**
  * @brief Utility class for scanning directories and reading text files.
  *
@@ -25,6 +28,9 @@ public:
      *
      * Supported extensions (case-insensitive):
      * .cpp, .h, .hpp, .c, .py, .js, .ts, .md, .txt, .json, .xml, .cmake
+     *
+     * The walk is serial and ignore files are not read; DirectoryScanner walks
+     * in parallel, honours .gitignore/.ragignore and hands files out as found.
      */
     static QStringList scanDirectory(const QString& rootPath, const QStringList& nameFilters = QStringList());
 
@@ -39,6 +45,26 @@ public:
      */
     static QString readTextFile(const QString& filePath);
 
+    /// Bytes of a file mapped and decoded at a time by streamTextFile().
+    static constexpr qint64 kStreamWindowBytes = 1 << 20;
+
+    /**
+     * @brief Decodes a text file window by window instead of all at once.
+     *
+     * @param filePath The absolute path to the file to read
+     * @param consumer Called with each decoded window in order; returns false to stop reading
+     * @param windowBytes Bytes of the file decoded per window
+     * @return false if the file cannot be opened or read
+     *
+     * Each window of the file is memory-mapped (or read, where mapping is
+     * not possible) and decoded as UTF-8 with the state carried over, so
+     * only one window of text exists at a time. The windows concatenate to
+     * exactly what readTextFile() returns.
+     */
+    static bool streamTextFile(const QString& filePath,
+                               const std::function<bool(QStringView window)>& consumer,
+                               qint64 windowBytes = kStreamWindowBytes);
+
     /**
      * @brief Maps a file path or name to the appropriate FileType for code-aware chunking.
      *
@@ -53,8 +79,7 @@ public:
      */
     static FileType getFileTypeFromExtension(const QString& filePath);
 
-private:
-    // Helper method to check if a file has a supported extension
+    /// Whether @p fileName has one of the extensions scanDirectory() picks up without name filters.
     static bool hasSupportedExtension(const QString& fileName);
 };
 
@@ -0,0 +1,161 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "Reranker.h"
+
+#include "CancellationToken.h"
+#include "CpuWorkerPool.h"
+#include "ModelCapsRegistry.h"
+
+#include <QFuture>
+#include <QList>
+#include <QRegularExpression>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+namespace {
+
+const QString kSystemPrompt = QStringLiteral(
+    "You grade how well passages answer a search query. Give each passage a whole number from 0 "
+    "(unrelated) to 10 (answers the query directly). Reply with only a JSON array holding one grade "
+    "per passage, in passage order, for example [7, 0, 3].");
+
+} // namespace
+
+RerankResult Reranker::rerank(ILLMBackend& backend, const QString& providerId, const QString& apiKey,
+                              const QString& modelId, const QString& query, const QStringList& documents)
+{
+    if (documents.isEmpty()) {
+        return {};
+    }
+    if (usesRerankEndpoint(backend, providerId, modelId)) {
+        RerankResult result = backend.rerank(apiKey, modelId, query, documents);
+        if (!result.hasError && result.scores.size() != static_cast<size_t>(documents.size())) {
+            result.hasError = true;
+            result.errorMsg = QStringLiteral("Rerank returned %1 scores for %2 documents")
+                                  .arg(result.scores.size())
+                                  .arg(documents.size());
+        }
+        return result;
+    }
+
+    QList<QStringList> groups;
+    for (qsizetype i = 0; i < documents.size(); i += kPromptDocuments) {
+        groups.append(documents.mid(i, kPromptDocuments));
+    }
+
+    // The groups' prompts go out together, each on its own thread with the caller's run scopes
+    const CancellationToken cancellation = CancellationToken::current();
+    QThreadPool* cpuPool = CpuWorkerPool::current();
+    auto grade = [&](const QStringList& group) {
+        const CancellationToken::Scope cancellationScope(cancellation);
+        const CpuWorkerPool::Scope cpuPoolScope(cpuPool);
+        // Room for a short reply even when a model adds a few words around the list
+        const int maxTokens = 64 + 4 * static_cast<int>(group.size());
+        return backend.sendPrompt(apiKey, modelId, 0.0, maxTokens, kSystemPrompt, buildPrompt(query, group));
+    };
+    QList<QFuture<LLMResult>> pending;
+    for (qsizetype i = 1; i < groups.size(); ++i) {
+        pending.append(QtConcurrent::run(grade, groups.at(i)));
+    }
+    QList<LLMResult> replies;
+    replies.append(grade(groups.front()));
+    for (QFuture<LLMResult>& future : pending) {
+        replies.append(future.result());
+    }
+
+    RerankResult result;
+    result.scores.reserve(static_cast<size_t>(documents.size()));
+    for (qsizetype i = 0; i < replies.size(); ++i) {
+        const LLMResult& reply = replies.at(i);
+        result.usage.inputTokens += reply.usage.inputTokens;
+        result.usage.outputTokens += reply.usage.outputTokens;
+        result.usage.totalTokens += reply.usage.totalTokens;
+        if (result.hasError) {
+            continue;
+        }
+        if (reply.hasError) {
+            result.hasError = true;
+            result.errorMsg = reply.errorMsg;
+            continue;
+        }
+        const std::vector<double> scores = parseScores(reply.content, static_cast<int>(groups.at(i).size()));
+        if (scores.empty()) {
+            result.hasError = true;
+            result.errorMsg = QStringLiteral("Could not read %1 grades from the reranking model's reply: %2")
+                                  .arg(groups.at(i).size())
+                                  .arg(reply.content.left(200));
+            continue;
+        }
+        result.scores.insert(result.scores.end(), scores.begin(), scores.end());
+    }
+    if (result.hasError) {
+        result.scores.clear();
+    }
+    return result;
+}
+
+bool Reranker::usesRerankEndpoint(const ILLMBackend& backend, const QString& providerId, const QString& modelId)
+{
+    if (!backend.supportsRerank()) {
+        return false;
+    }
+    const auto caps = ModelCapsRegistry::instance().resolve(modelId, providerId);
+    return caps.has_value() && caps->hasCapability(ModelCapsTypes::Capability::Rerank);
+}
+
+QString Reranker::buildPrompt(const QString& query, const QStringList& documents)
+{
+    QString prompt = QStringLiteral("Query: %1\n\n").arg(query);
+    for (qsizetype i = 0; i < documents.size(); ++i) {
+        QString text = documents.at(i).simplified();
+        if (text.size() > kMaxDocumentChars) {
+            text.truncate(kMaxDocumentChars);
+            text += QStringLiteral("...");
+        }
+        prompt += QStringLiteral("Passage %1:\n%2\n\n").arg(i + 1).arg(text);
+    }
+    prompt += QStringLiteral("Grade all %1 passages.").arg(documents.size());
+    return prompt;
+}
+
+std::vector<double> Reranker::parseScores(const QString& reply, int count)
+{
+    const qsizetype open = reply.indexOf(QLatin1Char('['));
+    const qsizetype close = reply.indexOf(QLatin1Char(']'), open + 1);
+    if (open < 0 || close < 0) {
+        return {};
+    }
+
+    static const QRegularExpression number(QStringLiteral("-?\\d+(?:\\.\\d+)?"));
+    std::vector<double> scores;
+    auto it = number.globalMatch(reply.mid(open + 1, close - open - 1));
+    while (it.hasNext()) {
+        scores.push_back(std::clamp(it.next().captured().toDouble() / 10.0, 0.0, 1.0));
+    }
+    if (scores.size() != static_cast<size_t>(count)) {
+        return {};
+    }
+    return scores;
+}
@@ -0,0 +1,66 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QString>
+#include <QStringList>
+
+#include <vector>
+
+#include "ai/backends/ILLMBackend.h"
+
+/**
+ * @brief Scores retrieval candidates against a query with a reranking model.
+ *
+ * A model with the `rerank` capability on a backend that supportsRerank()
+ * scores every candidate in one ILLMBackend::rerank() request. Any other
+ * model is prompted as a chat model to grade the candidates 0-10: groups of
+ * up to kPromptDocuments candidates share one prompt, the prompts are sent
+ * in parallel, and each candidate's text is cut to kMaxDocumentChars so a
+ * small local context window holds the whole group.
+ */
+class Reranker
+{
+public:
+    static constexpr int kPromptDocuments = 10;
+    static constexpr int kMaxDocumentChars = 1500;
+
+    /// Scores in [0, 1], one per document in input order, or an error.
+    static RerankResult rerank(ILLMBackend& backend, const QString& providerId, const QString& apiKey,
+                               const QString& modelId, const QString& query, const QStringList& documents);
+
+    /// Whether @p modelId is sent to the backend's rerank endpoint rather than prompted.
+    static bool usesRerankEndpoint(const ILLMBackend& backend, const QString& providerId, const QString& modelId);
+
+    /// The grading prompt for one group of documents, numbered from 1.
+    static QString buildPrompt(const QString& query, const QStringList& documents);
+
+    /**
+     * @brief Reads @p count grades from a reply such as "[7, 2, 10]" and scales them to [0, 1].
+     *
+     * Text around the list is ignored. Returns an empty vector unless exactly
+     * @p count numbers are found.
+     */
+    static std::vector<double> parseScores(const QString& reply, int count);
+};
@@ -0,0 +1,160 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "DuplicateIndex.h"
+
+#include <QCryptographicHash>
+#include <QtAlgorithms>
+
+#include <array>
+#include <cstring>
+
+namespace {
+
+constexpr int kBands = 4;
+constexpr int kBandBits = 16;
+constexpr quint64 kFnvOffset = 14695981039346656037ULL;
+constexpr quint64 kFnvPrime = 1099511628211ULL;
+
+quint32 bandKey(int band, quint64 simHash)
+{
+    return (static_cast<quint32>(band) << kBandBits)
+        | static_cast<quint32>((simHash >> (band * kBandBits)) & 0xFFFFu);
+}
+
+} // namespace
+
+qint64 DuplicateIndex::contentHash(QStringView text)
+{
+    const QByteArray digest = QCryptographicHash::hash(
+        QByteArrayView(reinterpret_cast<const char*>(text.utf16()), text.size() * 2), QCryptographicHash::Sha256);
+    qint64 value = 0;
+    std::memcpy(&value, digest.constData(), sizeof(value));
+    return value;
+}
+
+quint64 DuplicateIndex::simHash(QStringView text)
+{
+    // FNV-1a per word, lower-cased, so the fingerprint is stable across runs and processes
+    std::vector<quint64> words;
+    quint64 word = kFnvOffset;
+    bool inWord = false;
+    for (const QChar c : text) {
+        if (c.isLetterOrNumber()) {
+            const char16_t unit = c.toLower().unicode();
+            word = (word ^ (unit & 0xFFu)) * kFnvPrime;
+            word = (word ^ (unit >> 8)) * kFnvPrime;
+            inWord = true;
+        } else if (inWord) {
+            words.push_back(word);
+            word = kFnvOffset;
+            inWord = false;
+        }
+    }
+    if (inWord) {
+        words.push_back(word);
+    }
+    if (static_cast<int>(words.size()) < kMinSimHashWords) {
+        return 0;
+    }
+
+    std::array<int, 64> weights {};
+    for (std::size_t i = 0; i + 2 < words.size(); ++i) {
+        // Order matters inside a trigram, so each word is mixed in turn
+        quint64 shingle = kFnvOffset;
+        for (std::size_t k = 0; k < 3; ++k) {
+            shingle = (shingle ^ words[i + k]) * kFnvPrime;
+            shingle ^= shingle >> 29;
+        }
+        for (int bit = 0; bit < 64; ++bit) {
+            weights[static_cast<std::size_t>(bit)] += (shingle >> bit) & 1u ? 1 : -1;
+        }
+    }
+    quint64 fingerprint = 0;
+    for (int bit = 0; bit < 64; ++bit) {
+        if (weights[static_cast<std::size_t>(bit)] > 0) {
+            fingerprint |= quint64(1) << bit;
+        }
+    }
+    return fingerprint;
+}
+
+int DuplicateIndex::distance(quint64 a, quint64 b)
+{
+    return static_cast<int>(qPopulationCount(a ^ b));
+}
+
+void DuplicateIndex::addExact(qint64 contentHash, qint64 handle, qint64 fileId)
+{
+    if (!m_exact.contains(contentHash)) {
+        m_exact.insert(contentHash, Entry {0, handle, fileId});
+    }
+}
+
+void DuplicateIndex::addNear(quint64 simHash, qint64 handle, qint64 fileId)
+{
+    if (simHash == 0) {
+        return;
+    }
+    const auto position = static_cast<quint32>(m_near.size());
+    m_near.push_back(Entry {simHash, handle, fileId});
+    for (int band = 0; band < kBands; ++band) {
+        m_bands[bandKey(band, simHash)].push_back(position);
+    }
+}
+
+qint64 DuplicateIndex::findExact(qint64 contentHash, qint64 excludedFileId) const
+{
+    const auto it = m_exact.constFind(contentHash);
+    if (it == m_exact.constEnd() || (excludedFileId > 0 && it->fileId == excludedFileId)) {
+        return 0;
+    }
+    return it->handle;
+}
+
+qint64 DuplicateIndex::findNear(quint64 simHash, qint64 excludedFileId) const
+{
+    if (simHash == 0) {
+        return 0;
+    }
+    qint64 best = 0;
+    int bestDistance = kMaxNearDistance + 1;
+    for (int band = 0; band < kBands && bestDistance > 0; ++band) {
+        const auto bucket = m_bands.constFind(bandKey(band, simHash));
+        if (bucket == m_bands.constEnd()) {
+            continue;
+        }
+        for (const quint32 position : *bucket) {
+            const Entry& entry = m_near[position];
+            if (excludedFileId > 0 && entry.fileId == excludedFileId) {
+                continue;
+            }
+            const int d = distance(entry.simHash, simHash);
+            if (d < bestDistance) {
+                bestDistance = d;
+                best = entry.handle;
+            }
+        }
+    }
+    return best;
+}
@@ -0,0 +1,81 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QHash>
+#include <QStringView>
+
+#include <vector>
+
+/**
+ * @brief Finds chunks that a RAG index already stores or is about to store.
+ *
+ * Exact matches compare the leading 64 bits of a SHA-256 of the chunk text;
+ * callers confirm them against the stored text before relying on one, since
+ * 64 bits can in principle collide. Near matches
+ * compare 64-bit SimHash fingerprints over lower-cased word trigrams; two
+ * chunks match when at most kMaxNearDistance bits differ. Each fingerprint is
+ * filed under its four 16-bit bands, and any two within that distance share
+ * at least one band, so a lookup reads only the buckets of its own bands.
+ *
+ * Entries carry an opaque handle (a stored fragment id, or a chunk of the
+ * current run that is still being written) and the id of the file they came
+ * from. A lookup can leave out one file's entries, which lets a changed file
+ * skip its own old fragments while they are being replaced. Not thread-safe.
+ */
+class DuplicateIndex {
+public:
+    static constexpr int kMaxNearDistance = 3;
+    /// Chunks with fewer words get no SimHash and match only exactly.
+    static constexpr int kMinSimHashWords = 8;
+
+    /// Leading 8 bytes of the SHA-256 of @p text's UTF-16, the value kept in fragments.content_hash.
+    static qint64 contentHash(QStringView text);
+    /// SimHash of @p text, or 0 when it has fewer than kMinSimHashWords words.
+    static quint64 simHash(QStringView text);
+    static int distance(quint64 a, quint64 b);
+
+    /// The first entry for a hash is kept; later ones are ignored.
+    void addExact(qint64 contentHash, qint64 handle, qint64 fileId);
+    void addNear(quint64 simHash, qint64 handle, qint64 fileId);
+
+    /// Handle of the entry with this hash unless it belongs to @p excludedFileId, else 0.
+    qint64 findExact(qint64 contentHash, qint64 excludedFileId) const;
+    /// Handle of the closest entry within kMaxNearDistance bits outside @p excludedFileId, else 0.
+    qint64 findNear(quint64 simHash, qint64 excludedFileId) const;
+
+    qsizetype size() const { return m_exact.size() + static_cast<qsizetype>(m_near.size()); }
+
+private:
+    struct Entry {
+        quint64 simHash {0};
+        qint64 handle {0};
+        qint64 fileId {0};
+    };
+
+    QHash<qint64, Entry> m_exact;
+    std::vector<Entry> m_near;
+    // Band number in the top bits, band value below; values index m_near
+    QHash<quint32, std::vector<quint32>> m_bands;
+};
@@ -0,0 +1,345 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "EmbeddingCache.h"
+
+#include "Logger.h"
+#include "SqliteConnectionPool.h"
+#include "ai/backends/SingleFlight.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QVariant>
+
+#include <cstring>
+#include <utility>
+
+namespace {
+
+QMutex g_sharedMutex;
+std::shared_ptr<EmbeddingCache> g_shared;
+bool g_sharedConfigured = false;
+
+QByteArray vectorToBlob(const std::vector<float>& vector)
+{
+    return QByteArray(reinterpret_cast<const char*>(vector.data()),
+                      static_cast<qsizetype>(vector.size() * sizeof(float)));
+}
+
+std::vector<float> blobToVector(const QByteArray& blob)
+{
+    std::vector<float> vector;
+    if (blob.isEmpty() || blob.size() % static_cast<qsizetype>(sizeof(float)) != 0) {
+        return vector;
+    }
+    vector.resize(static_cast<std::size_t>(blob.size()) / sizeof(float));
+    std::memcpy(vector.data(), blob.constData(), static_cast<std::size_t>(blob.size()));
+    return vector;
+}
+
+// Embedding requests for cache misses in flight, keyed by the texts' cache keys
+SingleFlight<EmbeddingBatchResult>& embeddingFlights()
+{
+    static SingleFlight<EmbeddingBatchResult> flights(QStringLiteral("embedding"));
+    return flights;
+}
+
+} // namespace
+
+EmbeddingCache::EmbeddingCache(const QString& databasePath, qint64 maxBytes)
+    : m_databasePath(databasePath)
+    , m_maxBytes(maxBytes > 0 ? maxBytes : kDefaultMaxBytes)
+{
+}
+
+std::shared_ptr<EmbeddingCache> EmbeddingCache::shared()
+{
+    QMutexLocker locker(&g_sharedMutex);
+    if (!g_sharedConfigured) {
+        g_shared = std::make_shared<EmbeddingCache>(defaultPath());
+        g_sharedConfigured = true;
+    }
+    return g_shared;
+}
+
+void EmbeddingCache::setSharedPath(const QString& databasePath, qint64 maxBytes)
+{
+    QMutexLocker locker(&g_sharedMutex);
+    g_shared = databasePath.isEmpty() ? nullptr : std::make_shared<EmbeddingCache>(databasePath, maxBytes);
+    g_sharedConfigured = true;
+}
+
+QString EmbeddingCache::defaultPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+           + QStringLiteral("/embedding_cache.sqlite");
+}
+
+QString EmbeddingCache::normalise(const QString& text)
+{
+    QString normalised = text.normalized(QString::NormalizationForm_C);
+    normalised.replace(QStringLiteral("\r\n"), QStringLiteral("\n"));
+    normalised.replace(QLatin1Char('\r'), QLatin1Char('\n'));
+    return normalised.trimmed();
+}
+
+QByteArray EmbeddingCache::makeKey(const QString& providerId, const QString& modelId, const QString& text)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(providerId.trimmed().toLower().toUtf8());
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(modelId.trimmed().toUtf8());
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(normalise(text).toUtf8());
+    return hash.result();
+}
+
+bool EmbeddingCache::ensureSchema(QSqlDatabase& db)
+{
+    if (m_schemaReady) return true;
+    if (!db.isOpen()) return false;
+
+    QSqlQuery query(db);
+    if (!query.exec(QStringLiteral(
+            "CREATE TABLE IF NOT EXISTS embeddings ("
+            "key BLOB PRIMARY KEY, "
+            "dims INTEGER NOT NULL, "
+            "vector BLOB NOT NULL, "
+            "last_used INTEGER NOT NULL)"))
+        || !query.exec(QStringLiteral(
+            "CREATE INDEX IF NOT EXISTS embeddings_last_used ON embeddings(last_used)"))) {
+        CP_WARN << "EmbeddingCache: failed to create schema:" << query.lastError().text();
+        return false;
+    }
+
+    // One scan per process; afterwards the total is kept up to date as entries come and go
+    if (query.exec(QStringLiteral("SELECT COALESCE(SUM(LENGTH(vector)), 0) FROM embeddings")) && query.next()) {
+        m_bytes = query.value(0).toLongLong();
+    }
+    m_schemaReady = true;
+    return true;
+}
+
+std::vector<std::vector<float>> EmbeddingCache::lookup(const QString& providerId,
+                                                       const QString& modelId,
+                                                       const QStringList& texts,
+                                                       int dimension)
+{
+    std::vector<std::vector<float>> vectors(static_cast<std::size_t>(texts.size()));
+    if (texts.isEmpty()) return vectors;
+
+    QMutexLocker locker(&m_mutex);
+    if (!QFileInfo::exists(m_databasePath)) return vectors;
+
+    QSqlDatabase db = SqliteConnectionPool::connection(m_databasePath);
+    if (!ensureSchema(db)) return vectors;
+
+    db.transaction();
+    QSqlQuery select(db);
+    select.prepare(QStringLiteral("SELECT dims, vector FROM embeddings WHERE key = :key"));
+    QSqlQuery touch(db);
+    touch.prepare(QStringLiteral("UPDATE embeddings SET last_used = :now WHERE key = :key"));
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    for (int i = 0; i < texts.size(); ++i) {
+        const QByteArray key = makeKey(providerId, modelId, texts.at(i));
+        select.bindValue(QStringLiteral(":key"), key);
+        if (!select.exec() || !select.next()) continue;
+        const int dims = select.value(0).toInt();
+        if (dimension > 0 && dims != dimension) continue;
+        std::vector<float> vector = blobToVector(select.value(1).toByteArray());
+        if (static_cast<int>(vector.size()) != dims) continue;
+        vectors[static_cast<std::size_t>(i)] = std::move(vector);
+
+        touch.bindValue(QStringLiteral(":now"), now);
+        touch.bindValue(QStringLiteral(":key"), key);
+        touch.exec();
+    }
+    select.finish();
+    touch.finish();
+    db.commit();
+    return vectors;
+}
+
+void EmbeddingCache::store(const QString& providerId,
+                           const QString& modelId,
+                           const QStringList& texts,
+                           const std::vector<std::vector<float>>& vectors)
+{
+    if (texts.isEmpty()) return;
+
+    QMutexLocker locker(&m_mutex);
+    if (!QDir().mkpath(QFileInfo(m_databasePath).absolutePath())) return;
+
+    QSqlDatabase db = SqliteConnectionPool::connection(m_databasePath);
+    if (!ensureSchema(db)) return;
+
+    db.transaction();
+    {
+        QSqlQuery insert(db);
+        insert.prepare(QStringLiteral(
+            "INSERT OR IGNORE INTO embeddings (key, dims, vector, last_used) "
+            "VALUES (:key, :dims, :vector, :now)"));
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        const int count = qMin(texts.size(), static_cast<int>(vectors.size()));
+        for (int i = 0; i < count; ++i) {
+            const std::vector<float>& vector = vectors[static_cast<std::size_t>(i)];
+            if (vector.empty()) continue;
+            const QByteArray blob = vectorToBlob(vector);
+            insert.bindValue(QStringLiteral(":key"), makeKey(providerId, modelId, texts.at(i)));
+            insert.bindValue(QStringLiteral(":dims"), static_cast<int>(vector.size()));
+            insert.bindValue(QStringLiteral(":vector"), blob);
+            insert.bindValue(QStringLiteral(":now"), now);
+            if (insert.exec() && insert.numRowsAffected() > 0) {
+                m_bytes += blob.size();
+            }
+        }
+    }
+    if (m_bytes > m_maxBytes) {
+        evictLocked(db);
+    }
+    if (!db.commit()) {
+        CP_WARN << "EmbeddingCache: failed to commit entries:" << db.lastError().text();
+    }
+}
+
+void EmbeddingCache::evictLocked(QSqlDatabase& db)
+{
+    const qint64 target = m_maxBytes - m_maxBytes / 10;
+    QSqlQuery oldest(db);
+    QSqlQuery remove(db);
+    remove.prepare(QStringLiteral("DELETE FROM embeddings WHERE key = :key"));
+    while (m_bytes > target) {
+        if (!oldest.exec(QStringLiteral(
+                "SELECT key, LENGTH(vector) FROM embeddings ORDER BY last_used ASC, rowid ASC LIMIT 256"))) {
+            CP_WARN << "EmbeddingCache: eviction query failed:" << oldest.lastError().text();
+            return;
+        }
+        QList<QPair<QByteArray, qint64>> victims;
+        while (oldest.next() && m_bytes > target) {
+            victims.append(qMakePair(oldest.value(0).toByteArray(), oldest.value(1).toLongLong()));
+            m_bytes -= victims.last().second;
+        }
+        oldest.finish();
+        if (victims.isEmpty()) {
+            m_bytes = 0;
+            return;
+        }
+        for (const auto& victim : victims) {
+            remove.bindValue(QStringLiteral(":key"), victim.first);
+            remove.exec();
+        }
+    }
+}
+
+EmbeddingBatchResult EmbeddingCache::embed(ILLMBackend& backend,
+                                           const QString& providerId,
+                                           const QString& apiKey,
+                                           const QString& modelId,
+                                           const QStringList& texts,
+                                           int dimension,
+                                           Counters* run)
+{
+    EmbeddingBatchResult result;
+    result.vectors = lookup(providerId, modelId, texts, dimension);
+
+    QStringList missing;
+    std::vector<std::size_t> missingSlots;
+    for (std::size_t i = 0; i < result.vectors.size(); ++i) {
+        if (result.vectors[i].empty()) {
+            missing.append(texts.at(static_cast<int>(i)));
+            missingSlots.push_back(i);
+        }
+    }
+
+    const qint64 hitCount = texts.size() - missing.size();
+    m_counters.hits += hitCount;
+    m_counters.misses += missing.size();
+    if (run) {
+        run->hits += hitCount;
+        run->misses += missing.size();
+    }
+    if (missing.isEmpty()) return result;
+
+    // Callers missing the same texts at the same moment, e.g. branches embedding one
+    // document, share a single request
+    QCryptographicHash flightKey(QCryptographicHash::Sha256);
+    flightKey.addData(QByteArray::number(dimension));
+    for (const QString& text : std::as_const(missing)) {
+        flightKey.addData(makeKey(providerId, modelId, text));
+    }
+    bool coalesced = false;
+    EmbeddingBatchResult fresh = embeddingFlights().run(flightKey.result(), [&]() {
+        return dimension > 0
+            ? backend.getEmbeddingsAtDimension(apiKey, modelId, missing, dimension)
+            : backend.getEmbeddings(apiKey, modelId, missing);
+    }, &coalesced);
+    if (coalesced) {
+        // Stored, and billed, by the request it shared
+        fresh.usage = {};
+    }
+    result.usage = fresh.usage;
+    if (!fresh.hasError && fresh.vectors.size() != missingSlots.size()) {
+        fresh.hasError = true;
+        fresh.errorMsg = QStringLiteral("Embedding backend returned %1 vectors for %2 inputs")
+                             .arg(static_cast<qulonglong>(fresh.vectors.size()))
+                             .arg(missing.size());
+    }
+    if (fresh.hasError) {
+        result.vectors.clear();
+        result.hasError = true;
+        result.errorMsg = fresh.errorMsg;
+        return result;
+    }
+
+    if (!coalesced) {
+        store(providerId, modelId, missing, fresh.vectors);
+    }
+    for (std::size_t j = 0; j < missingSlots.size(); ++j) {
+        result.vectors[missingSlots[j]] = std::move(fresh.vectors[j]);
+    }
+    return result;
+}
+
+qint64 EmbeddingCache::sizeBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_bytes;
+}
+
+void EmbeddingCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    QFile::remove(m_databasePath);
+    QFile::remove(m_databasePath + QStringLiteral("-wal"));
+    QFile::remove(m_databasePath + QStringLiteral("-shm"));
+    m_schemaReady = false;
+    m_bytes = 0;
+}
@@ -0,0 +1,139 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "ai/backends/ILLMBackend.h"
+
+class QSqlDatabase;
+
+/**
+ * @brief Persistent cache of text embeddings shared by RAG indexing and querying.
+ *
+ * Entries live in one SQLite file and are keyed by a SHA-256 of (provider,
+ * model, normalised text); each row also records its dimension so callers
+ * that know the index dimension never receive a vector of another size.
+ * The file is bounded to maxBytes of vector data: when a store goes over,
+ * the least recently used entries are evicted down to 90% of the budget.
+ * All access is serialised by an internal mutex and each call borrows the
+ * calling thread's pooled connection (SqliteConnectionPool), so the cache may
+ * be used from any thread.
+ */
+class EmbeddingCache
+{
+public:
+    static constexpr qint64 kDefaultMaxBytes = 512LL * 1024 * 1024;
+
+    /// Hit/miss counters; one set per cache plus any a caller passes to embed().
+    struct Counters {
+        std::atomic<qint64> hits {0};
+        std::atomic<qint64> misses {0};
+    };
+
+    explicit EmbeddingCache(const QString& databasePath, qint64 maxBytes = kDefaultMaxBytes);
+
+    /**
+     * @brief The process-wide cache, stored under the user's cache directory.
+     *
+     * Returns nullptr when caching has been disabled with setSharedPath(QString()).
+     */
+    static std::shared_ptr<EmbeddingCache> shared();
+
+    /**
+     * @brief Points shared() at another file; an empty path disables caching.
+     *
+     * Callers already holding the previous cache keep using it.
+     */
+    static void setSharedPath(const QString& databasePath, qint64 maxBytes = kDefaultMaxBytes);
+
+    static QString defaultPath();
+
+    /// Trims the text, unifies line endings and applies Unicode NFC so trivial edits still hit.
+    static QString normalise(const QString& text);
+
+    static QByteArray makeKey(const QString& providerId, const QString& modelId, const QString& text);
+
+    const QString& databasePath() const { return m_databasePath; }
+
+    /**
+     * @brief Returns one vector per text; an empty vector marks a miss.
+     *
+     * A positive @p dimension rejects entries of any other size. Hits are
+     * marked as recently used.
+     */
+    std::vector<std::vector<float>> lookup(const QString& providerId,
+                                           const QString& modelId,
+                                           const QStringList& texts,
+                                           int dimension = 0);
+
+    /// Stores vectors for texts (same order); empty vectors are skipped.
+    void store(const QString& providerId,
+               const QString& modelId,
+               const QStringList& texts,
+               const std::vector<std::vector<float>>& vectors);
+
+    /**
+     * @brief Embeds texts, asking @p backend only for those not already cached.
+     *
+     * A positive @p dimension only accepts cached vectors of that size and
+     * asks the backend for that size (ILLMBackend::getEmbeddingsAtDimension()).
+     * Fresh vectors are stored before returning. Usage covers only the
+     * backend request. Hits and misses go to this cache's counters and to
+     * @p run when given.
+     */
+    EmbeddingBatchResult embed(ILLMBackend& backend,
+                               const QString& providerId,
+                               const QString& apiKey,
+                               const QString& modelId,
+                               const QStringList& texts,
+                               int dimension = 0,
+                               Counters* run = nullptr);
+
+    qint64 hits() const { return m_counters.hits.load(); }
+    qint64 misses() const { return m_counters.misses.load(); }
+
+    /// Bytes of vector data currently held, as tracked by this process.
+    qint64 sizeBytes() const;
+
+    void clear();
+
+private:
+    bool ensureSchema(QSqlDatabase& db);
+    void evictLocked(QSqlDatabase& db);
+
+    QString m_databasePath;
+    qint64 m_maxBytes;
+    mutable QMutex m_mutex;
+    bool m_schemaReady {false};
+    qint64 m_bytes {0};
+    Counters m_counters;
+};
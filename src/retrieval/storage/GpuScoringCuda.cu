@@ -0,0 +1,330 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "GpuScoringDevice.h"
+
+#include <cuda_fp16.h>
+#include <cuda_runtime.h>
+
+#include <cmath>
+#include <mutex>
+
+namespace {
+
+constexpr int kWarpSize = 32;
+constexpr int kWarps = GpuScoringDevice::kThreadsPerBlock / kWarpSize;
+constexpr unsigned kFullMask = 0xffffffffu;
+// Left free for the rest of the process when sizing the matrix
+constexpr std::size_t kDeviceReserveBytes = std::size_t {256} << 20;
+
+bool check(cudaError_t status, const char* what, std::string& error)
+{
+    if (status == cudaSuccess) {
+        return true;
+    }
+    error = std::string(what) + ": " + cudaGetErrorString(status);
+    return false;
+}
+
+// One warp scores a row; lanes take strided dimensions, then the sum is reduced across the warp
+template <int Format>
+__device__ float rowDot(const unsigned char* row, const float* query, int dimension, int lane)
+{
+    float sum = 0.0f;
+    if (Format == 0) {
+        const float* values = reinterpret_cast<const float*>(row);
+        for (int d = lane; d < dimension; d += kWarpSize) {
+            sum += values[d] * query[d];
+        }
+    } else if (Format == 1) {
+        const __half* values = reinterpret_cast<const __half*>(row);
+        for (int d = lane; d < dimension; d += kWarpSize) {
+            sum += __half2float(values[d]) * query[d];
+        }
+    } else {
+        const signed char* codes = reinterpret_cast<const signed char*>(row + sizeof(float));
+        for (int d = lane; d < dimension; d += kWarpSize) {
+            sum += static_cast<float>(codes[d]) * query[d];
+        }
+    }
+    for (int offset = kWarpSize / 2; offset > 0; offset /= 2) {
+        sum += __shfl_down_sync(kFullMask, sum, offset);
+    }
+    if (Format == 2) {
+        sum *= *reinterpret_cast<const float*>(row);
+    }
+    return sum;
+}
+
+__device__ bool ranksBefore(float score, int index, float otherScore, int otherIndex)
+{
+    if (otherIndex < 0) {
+        return index >= 0;
+    }
+    return index >= 0 && (score > otherScore || (score == otherScore && index < otherIndex));
+}
+
+// Block (x, y) scores rows [x * kRowsPerBlock, ...) against query y into shared memory,
+// then takes its k best out one block-wide argmax at a time
+template <int Format>
+__global__ void scoreAndSelect(const unsigned char* rows,
+                               const unsigned char* live,
+                               long long rowCount,
+                               int stride,
+                               int dimension,
+                               const float* queries,
+                               int k,
+                               long long* outRows,
+                               float* outScores)
+{
+    extern __shared__ float shared[];
+    float* query = shared;
+    float* scores = shared + dimension;
+    __shared__ float warpScores[kWarps];
+    __shared__ int warpIndexes[kWarps];
+
+    const long long first = static_cast<long long>(blockIdx.x) * GpuScoringDevice::kRowsPerBlock;
+    const int count = static_cast<int>(min(static_cast<long long>(GpuScoringDevice::kRowsPerBlock), rowCount - first));
+    const int warp = threadIdx.x / kWarpSize;
+    const int lane = threadIdx.x % kWarpSize;
+
+    for (int d = threadIdx.x; d < dimension; d += blockDim.x) {
+        query[d] = queries[static_cast<size_t>(blockIdx.y) * dimension + d];
+    }
+    __syncthreads();
+
+    for (int r = warp; r < count; r += kWarps) {
+        const long long row = first + r;
+        const float score = rowDot<Format>(rows + row * stride, query, dimension, lane);
+        if (lane == 0) {
+            scores[r] = live[row] ? score : -INFINITY;
+        }
+    }
+    __syncthreads();
+
+    const size_t out = (static_cast<size_t>(blockIdx.y) * gridDim.x + blockIdx.x) * k;
+    for (int round = 0; round < k; ++round) {
+        float best = -INFINITY;
+        int index = -1;
+        for (int r = threadIdx.x; r < count; r += blockDim.x) {
+            if (scores[r] > best) {
+                best = scores[r];
+                index = r;
+            }
+        }
+        for (int offset = kWarpSize / 2; offset > 0; offset /= 2) {
+            const float otherScore = __shfl_down_sync(kFullMask, best, offset);
+            const int otherIndex = __shfl_down_sync(kFullMask, index, offset);
+            if (ranksBefore(otherScore, otherIndex, best, index)) {
+                best = otherScore;
+                index = otherIndex;
+            }
+        }
+        if (lane == 0) {
+            warpScores[warp] = best;
+            warpIndexes[warp] = index;
+        }
+        __syncthreads();
+        if (threadIdx.x == 0) {
+            best = warpScores[0];
+            index = warpIndexes[0];
+            for (int w = 1; w < kWarps; ++w) {
+                if (ranksBefore(warpScores[w], warpIndexes[w], best, index)) {
+                    best = warpScores[w];
+                    index = warpIndexes[w];
+                }
+            }
+            outRows[out + round] = index >= 0 ? first + index : -1;
+            outScores[out + round] = best;
+            if (index >= 0) {
+                scores[index] = -INFINITY;
+            }
+        }
+        __syncthreads();
+    }
+}
+
+} // namespace
+
+struct GpuScoringDevice::Matrix {
+    int format {0};
+    int dimension {0};
+    int stride {0};
+    std::int64_t rows {0};
+    unsigned char* data {nullptr};
+    unsigned char* live {nullptr};
+
+    // Scratch buffers, grown as needed and reused by later searches
+    std::mutex mutex;
+    float* queries {nullptr};
+    std::size_t queryCapacity {0};
+    long long* outRows {nullptr};
+    float* outScores {nullptr};
+    std::size_t outCapacity {0};
+};
+
+const char* GpuScoringDevice::name()
+{
+    return "cuda";
+}
+
+bool GpuScoringDevice::available()
+{
+    int devices = 0;
+    return cudaGetDeviceCount(&devices) == cudaSuccess && devices > 0;
+}
+
+GpuScoringDevice::Matrix* GpuScoringDevice::createMatrix(int format, int dimension, int stride, std::int64_t rows,
+                                                         std::string& error)
+{
+    const std::size_t bytes = static_cast<std::size_t>(rows) * static_cast<std::size_t>(stride + 1);
+    std::size_t freeBytes = 0;
+    std::size_t totalBytes = 0;
+    if (!check(cudaMemGetInfo(&freeBytes, &totalBytes), "cudaMemGetInfo", error)) {
+        return nullptr;
+    }
+    if (bytes + kDeviceReserveBytes > freeBytes) {
+        error = "the index needs " + std::to_string(bytes >> 20) + " MiB of device memory, "
+                + std::to_string(freeBytes >> 20) + " MiB are free";
+        return nullptr;
+    }
+
+    auto* matrix = new Matrix;
+    matrix->format = format;
+    matrix->dimension = dimension;
+    matrix->stride = stride;
+    matrix->rows = rows;
+    if (!check(cudaMalloc(reinterpret_cast<void**>(&matrix->data), static_cast<std::size_t>(rows) * stride),
+               "cudaMalloc", error)
+        || !check(cudaMalloc(reinterpret_cast<void**>(&matrix->live), static_cast<std::size_t>(rows)), "cudaMalloc",
+                  error)) {
+        destroyMatrix(matrix);
+        return nullptr;
+    }
+    return matrix;
+}
+
+void GpuScoringDevice::destroyMatrix(Matrix* matrix)
+{
+    if (!matrix) {
+        return;
+    }
+    cudaFree(matrix->data);
+    cudaFree(matrix->live);
+    cudaFree(matrix->queries);
+    cudaFree(matrix->outRows);
+    cudaFree(matrix->outScores);
+    delete matrix;
+}
+
+std::int64_t GpuScoringDevice::deviceBytes(const Matrix* matrix)
+{
+    return matrix ? matrix->rows * (matrix->stride + 1) : 0;
+}
+
+bool GpuScoringDevice::upload(Matrix* matrix, std::int64_t first, std::int64_t count, const void* rows,
+                              const std::uint8_t* live, std::string& error)
+{
+    return check(cudaMemcpy(matrix->data + first * matrix->stride, rows, static_cast<std::size_t>(count) * matrix->stride,
+                            cudaMemcpyHostToDevice),
+                 "cudaMemcpy", error)
+           && check(cudaMemcpy(matrix->live + first, live, static_cast<std::size_t>(count), cudaMemcpyHostToDevice),
+                    "cudaMemcpy", error);
+}
+
+bool GpuScoringDevice::topK(Matrix* matrix, const float* queries, int queryCount, int k, std::int64_t* rows,
+                            float* scores, std::string& error)
+{
+    const int blocks = static_cast<int>((matrix->rows + kRowsPerBlock - 1) / kRowsPerBlock);
+    const std::size_t queryFloats = static_cast<std::size_t>(queryCount) * matrix->dimension;
+    const std::size_t outSlots = static_cast<std::size_t>(queryCount) * blocks * k;
+
+    std::lock_guard<std::mutex> lock(matrix->mutex);
+    if (queryFloats > matrix->queryCapacity) {
+        cudaFree(matrix->queries);
+        matrix->queries = nullptr;
+        matrix->queryCapacity = 0;
+        if (!check(cudaMalloc(reinterpret_cast<void**>(&matrix->queries), queryFloats * sizeof(float)), "cudaMalloc",
+                   error)) {
+            return false;
+        }
+        matrix->queryCapacity = queryFloats;
+    }
+    if (outSlots > matrix->outCapacity) {
+        cudaFree(matrix->outRows);
+        cudaFree(matrix->outScores);
+        matrix->outRows = nullptr;
+        matrix->outScores = nullptr;
+        matrix->outCapacity = 0;
+        if (!check(cudaMalloc(reinterpret_cast<void**>(&matrix->outRows), outSlots * sizeof(long long)), "cudaMalloc",
+                   error)
+            || !check(cudaMalloc(reinterpret_cast<void**>(&matrix->outScores), outSlots * sizeof(float)), "cudaMalloc",
+                      error)) {
+            return false;
+        }
+        matrix->outCapacity = outSlots;
+    }
+    if (!check(cudaMemcpy(matrix->queries, queries, queryFloats * sizeof(float), cudaMemcpyHostToDevice), "cudaMemcpy",
+               error)) {
+        return false;
+    }
+
+    const dim3 grid(static_cast<unsigned>(blocks), static_cast<unsigned>(queryCount));
+    const std::size_t sharedBytes = (static_cast<std::size_t>(matrix->dimension) + kRowsPerBlock) * sizeof(float);
+    switch (matrix->format) {
+    case 0:
+        scoreAndSelect<0><<<grid, kThreadsPerBlock, sharedBytes>>>(matrix->data, matrix->live, matrix->rows,
+            matrix->stride, matrix->dimension, matrix->queries, k, matrix->outRows, matrix->outScores);
+        break;
+    case 1:
+        scoreAndSelect<1><<<grid, kThreadsPerBlock, sharedBytes>>>(matrix->data, matrix->live, matrix->rows,
+            matrix->stride, matrix->dimension, matrix->queries, k, matrix->outRows, matrix->outScores);
+        break;
+    default:
+        scoreAndSelect<2><<<grid, kThreadsPerBlock, sharedBytes>>>(matrix->data, matrix->live, matrix->rows,
+            matrix->stride, matrix->dimension, matrix->queries, k, matrix->outRows, matrix->outScores);
+        break;
+    }
+    if (!check(cudaGetLastError(), "kernel launch", error)) {
+        return false;
+    }
+
+    std::vector<long long> blockRows(outSlots);
+    std::vector<float> blockScores(outSlots);
+    if (!check(cudaMemcpy(blockRows.data(), matrix->outRows, outSlots * sizeof(long long), cudaMemcpyDeviceToHost),
+               "cudaMemcpy", error)
+        || !check(cudaMemcpy(blockScores.data(), matrix->outScores, outSlots * sizeof(float), cudaMemcpyDeviceToHost),
+                  "cudaMemcpy", error)) {
+        return false;
+    }
+
+    const std::size_t perQuery = static_cast<std::size_t>(blocks) * k;
+    std::vector<std::int64_t> candidates(perQuery);
+    for (int q = 0; q < queryCount; ++q) {
+        std::copy(blockRows.begin() + static_cast<std::ptrdiff_t>(q * perQuery),
+                  blockRows.begin() + static_cast<std::ptrdiff_t>((q + 1) * perQuery), candidates.begin());
+        mergeBlockWinners(candidates.data(), blockScores.data() + q * perQuery, blocks, k,
+                          rows + static_cast<std::size_t>(q) * k, scores + static_cast<std::size_t>(q) * k);
+    }
+    return true;
+}
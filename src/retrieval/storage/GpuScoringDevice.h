@@ -0,0 +1,89 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <vector>
+
+// Device side of GpuVectorScorer, implemented once per GPU API: GpuScoringCuda.cu
+// (CP_HAS_CUDA_SCORING) or GpuScoringMetal.mm (CP_HAS_METAL_SCORING). Free of Qt so
+// nvcc and the Objective-C++ compiler only see plain C++.
+//
+// A Matrix holds rows laid out as in a VectorFile: `stride` bytes apart, each in
+// RagEmbeddingFormat `format` (0 float32, 1 float16, 2 int8 with a leading float
+// scale), and a byte per row that is 0 for a deleted row. topK() scores every live
+// row against each query and returns the k largest dot products per query.
+namespace GpuScoringDevice {
+
+struct Matrix;
+
+// Rows ranked per thread block before the host merges the blocks' winners
+constexpr int kRowsPerBlock = 2048;
+constexpr int kThreadsPerBlock = 256;
+
+// "cuda" or "metal"
+const char* name();
+
+// Whether a usable device is present
+bool available();
+
+// Allocates device memory for @p rows rows; nullptr when the device cannot hold them
+Matrix* createMatrix(int format, int dimension, int stride, std::int64_t rows, std::string& error);
+void destroyMatrix(Matrix* matrix);
+std::int64_t deviceBytes(const Matrix* matrix);
+
+// Copies @p count rows (count * stride bytes) and their live flags to rows [first, first + count)
+bool upload(Matrix* matrix, std::int64_t first, std::int64_t count, const void* rows, const std::uint8_t* live,
+            std::string& error);
+
+// @p queries holds queryCount * dimension floats. Fills k entries per query of @p rows
+// and @p scores, best first; rows are -1 past the number of live rows.
+bool topK(Matrix* matrix, const float* queries, int queryCount, int k, std::int64_t* rows, float* scores,
+          std::string& error);
+
+// Merges the k winners of each of @p blocks blocks (as the kernels write them, -1 rows
+// for empty slots) into the k best overall, higher score first and lower row on ties
+inline void mergeBlockWinners(const std::int64_t* blockRows, const float* blockScores, int blocks, int k,
+                              std::int64_t* rows, float* scores)
+{
+    std::vector<std::int64_t> order(static_cast<std::size_t>(blocks) * static_cast<std::size_t>(k));
+    std::iota(order.begin(), order.end(), std::int64_t {0});
+    order.erase(std::remove_if(order.begin(), order.end(), [&](std::int64_t i) { return blockRows[i] < 0; }),
+                order.end());
+    const auto better = [&](std::int64_t a, std::int64_t b) {
+        return blockScores[a] != blockScores[b] ? blockScores[a] > blockScores[b] : blockRows[a] < blockRows[b];
+    };
+    const std::size_t kept = std::min(order.size(), static_cast<std::size_t>(k));
+    std::partial_sort(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(kept), order.end(), better);
+    for (int i = 0; i < k; ++i) {
+        const bool filled = static_cast<std::size_t>(i) < kept;
+        rows[i] = filled ? blockRows[order[static_cast<std::size_t>(i)]] : -1;
+        scores[i] = filled ? blockScores[order[static_cast<std::size_t>(i)]] : 0.0f;
+    }
+}
+
+} // namespace GpuScoringDevice
@@ -0,0 +1,340 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "GpuScoringDevice.h"
+
+#import <Foundation/Foundation.h>
+#import <Metal/Metal.h>
+
+#include <cstring>
+#include <mutex>
+
+// Built with -fobjc-arc: the Objective-C members below release themselves.
+
+namespace {
+
+// The same scoring and selection as GpuScoringCuda.cu, as a Metal compute kernel
+const char* const kKernelSource = R"(
+#include <metal_stdlib>
+using namespace metal;
+
+constant uint kRowsPerBlock = 2048;
+// Enough for any SIMD-group width down to 8 lanes
+constant uint kMaxWarps = 32;
+
+struct Params {
+    ulong rows;
+    uint stride;
+    uint dimension;
+    uint k;
+    uint format;
+};
+
+static bool ranksBefore(float score, int index, float otherScore, int otherIndex)
+{
+    if (otherIndex < 0) {
+        return index >= 0;
+    }
+    return index >= 0 && (score > otherScore || (score == otherScore && index < otherIndex));
+}
+
+kernel void scoreAndSelect(device const uchar* rows [[buffer(0)]],
+                           device const uchar* live [[buffer(1)]],
+                           constant Params& params [[buffer(2)]],
+                           device const float* queries [[buffer(3)]],
+                           device long* outRows [[buffer(4)]],
+                           device float* outScores [[buffer(5)]],
+                           threadgroup float* shared [[threadgroup(0)]],
+                           uint2 group [[threadgroup_position_in_grid]],
+                           uint2 groups [[threadgroups_per_grid]],
+                           uint tid [[thread_index_in_threadgroup]],
+                           uint threads [[threads_per_threadgroup]],
+                           uint lane [[thread_index_in_simdgroup]],
+                           uint warp [[simdgroup_index_in_threadgroup]],
+                           uint warpSize [[threads_per_simdgroup]])
+{
+    threadgroup float warpScores[kMaxWarps];
+    threadgroup int warpIndexes[kMaxWarps];
+    threadgroup float* query = shared;
+    threadgroup float* scores = shared + params.dimension;
+    const uint warps = threads / warpSize;
+
+    const ulong first = ulong(group.x) * kRowsPerBlock;
+    const uint count = uint(min(ulong(kRowsPerBlock), params.rows - first));
+    for (uint d = tid; d < params.dimension; d += threads) {
+        query[d] = queries[ulong(group.y) * params.dimension + d];
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    for (uint r = warp; r < count; r += warps) {
+        const ulong row = first + r;
+        device const uchar* data = rows + row * params.stride;
+        float sum = 0.0f;
+        if (params.format == 0) {
+            device const float* values = reinterpret_cast<device const float*>(data);
+            for (uint d = lane; d < params.dimension; d += warpSize) {
+                sum += values[d] * query[d];
+            }
+        } else if (params.format == 1) {
+            device const half* values = reinterpret_cast<device const half*>(data);
+            for (uint d = lane; d < params.dimension; d += warpSize) {
+                sum += float(values[d]) * query[d];
+            }
+        } else {
+            device const char* codes = reinterpret_cast<device const char*>(data + 4);
+            for (uint d = lane; d < params.dimension; d += warpSize) {
+                sum += float(codes[d]) * query[d];
+            }
+        }
+        sum = simd_sum(sum);
+        if (params.format == 2) {
+            sum *= *reinterpret_cast<device const float*>(data);
+        }
+        if (lane == 0) {
+            scores[r] = live[row] ? sum : -INFINITY;
+        }
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    const ulong out = (ulong(group.y) * groups.x + group.x) * params.k;
+    for (uint pick = 0; pick < params.k; ++pick) {
+        float best = -INFINITY;
+        int index = -1;
+        for (uint r = tid; r < count; r += threads) {
+            if (scores[r] > best) {
+                best = scores[r];
+                index = int(r);
+            }
+        }
+        for (uint offset = warpSize / 2; offset > 0; offset /= 2) {
+            const float otherScore = simd_shuffle_down(best, ushort(offset));
+            const int otherIndex = simd_shuffle_down(index, ushort(offset));
+            if (lane + offset < warpSize && ranksBefore(otherScore, otherIndex, best, index)) {
+                best = otherScore;
+                index = otherIndex;
+            }
+        }
+        if (lane == 0) {
+            warpScores[warp] = best;
+            warpIndexes[warp] = index;
+        }
+        threadgroup_barrier(mem_flags::mem_threadgroup);
+        if (tid == 0) {
+            best = warpScores[0];
+            index = warpIndexes[0];
+            for (uint w = 1; w < warps; ++w) {
+                if (ranksBefore(warpScores[w], warpIndexes[w], best, index)) {
+                    best = warpScores[w];
+                    index = warpIndexes[w];
+                }
+            }
+            outRows[out + pick] = index >= 0 ? long(first) + index : -1;
+            outScores[out + pick] = best;
+            if (index >= 0) {
+                scores[index] = -INFINITY;
+            }
+        }
+        threadgroup_barrier(mem_flags::mem_threadgroup);
+    }
+}
+)";
+
+struct KernelParams {
+    std::uint64_t rows;
+    std::uint32_t stride;
+    std::uint32_t dimension;
+    std::uint32_t k;
+    std::uint32_t format;
+};
+
+struct Pipeline {
+    id<MTLDevice> device;
+    id<MTLComputePipelineState> state;
+    id<MTLCommandQueue> queue;
+    std::string error;
+};
+
+// Compiled once per process
+const Pipeline& pipeline()
+{
+    static const Pipeline shared = []() {
+        Pipeline created;
+        @autoreleasepool {
+            created.device = MTLCreateSystemDefaultDevice();
+            if (!created.device) {
+                created.error = "no Metal device";
+                return created;
+            }
+            NSError* compileError = nil;
+            id<MTLLibrary> library = [created.device newLibraryWithSource:@(kKernelSource) options:nil error:&compileError];
+            id<MTLFunction> function = library ? [library newFunctionWithName:@"scoreAndSelect"] : nil;
+            created.state = function ? [created.device newComputePipelineStateWithFunction:function error:&compileError]
+                                     : nil;
+            if (!created.state) {
+                created.error = compileError ? compileError.localizedDescription.UTF8String : "kernel did not compile";
+                created.device = nil;
+                return created;
+            }
+            created.queue = [created.device newCommandQueue];
+        }
+        return created;
+    }();
+    return shared;
+}
+
+} // namespace
+
+struct GpuScoringDevice::Matrix {
+    int format {0};
+    int dimension {0};
+    int stride {0};
+    std::int64_t rows {0};
+    // Shared storage: on unified memory the GPU reads these buffers in place
+    id<MTLBuffer> data;
+    id<MTLBuffer> live;
+    std::mutex mutex;
+};
+
+const char* GpuScoringDevice::name()
+{
+    return "metal";
+}
+
+bool GpuScoringDevice::available()
+{
+    return pipeline().device != nil;
+}
+
+GpuScoringDevice::Matrix* GpuScoringDevice::createMatrix(int format, int dimension, int stride, std::int64_t rows,
+                                                         std::string& error)
+{
+    const Pipeline& shared = pipeline();
+    if (!shared.device) {
+        error = shared.error;
+        return nullptr;
+    }
+    const std::uint64_t dataBytes = static_cast<std::uint64_t>(rows) * static_cast<std::uint64_t>(stride);
+    if (dataBytes > shared.device.maxBufferLength
+        || dataBytes + static_cast<std::uint64_t>(rows) > shared.device.recommendedMaxWorkingSetSize) {
+        error = "the index needs " + std::to_string(dataBytes >> 20) + " MiB, more than the Metal device allows";
+        return nullptr;
+    }
+    const std::size_t threadgroupBytes = (static_cast<std::size_t>(dimension) + kRowsPerBlock) * sizeof(float);
+    if (threadgroupBytes > shared.device.maxThreadgroupMemoryLength) {
+        error = "embeddings of " + std::to_string(dimension) + " dimensions do not fit in threadgroup memory";
+        return nullptr;
+    }
+
+    auto* matrix = new Matrix;
+    matrix->format = format;
+    matrix->dimension = dimension;
+    matrix->stride = stride;
+    matrix->rows = rows;
+    matrix->data = [shared.device newBufferWithLength:dataBytes options:MTLResourceStorageModeShared];
+    matrix->live = [shared.device newBufferWithLength:static_cast<NSUInteger>(rows) options:MTLResourceStorageModeShared];
+    if (!matrix->data || !matrix->live) {
+        error = "cannot allocate Metal buffers";
+        delete matrix;
+        return nullptr;
+    }
+    return matrix;
+}
+
+void GpuScoringDevice::destroyMatrix(Matrix* matrix)
+{
+    delete matrix;
+}
+
+std::int64_t GpuScoringDevice::deviceBytes(const Matrix* matrix)
+{
+    return matrix ? matrix->rows * (matrix->stride + 1) : 0;
+}
+
+bool GpuScoringDevice::upload(Matrix* matrix, std::int64_t first, std::int64_t count, const void* rows,
+                              const std::uint8_t* live, std::string& error)
+{
+    (void)error;
+    std::memcpy(static_cast<char*>(matrix->data.contents) + first * matrix->stride, rows,
+                static_cast<std::size_t>(count) * matrix->stride);
+    std::memcpy(static_cast<char*>(matrix->live.contents) + first, live, static_cast<std::size_t>(count));
+    return true;
+}
+
+bool GpuScoringDevice::topK(Matrix* matrix, const float* queries, int queryCount, int k, std::int64_t* rows,
+                            float* scores, std::string& error)
+{
+    const Pipeline& shared = pipeline();
+    const int blocks = static_cast<int>((matrix->rows + kRowsPerBlock - 1) / kRowsPerBlock);
+    const std::size_t queryBytes = static_cast<std::size_t>(queryCount) * matrix->dimension * sizeof(float);
+    const std::size_t outSlots = static_cast<std::size_t>(queryCount) * blocks * k;
+
+    std::lock_guard<std::mutex> lock(matrix->mutex);
+    @autoreleasepool {
+        id<MTLBuffer> queryBuffer = [shared.device newBufferWithBytes:queries
+                                                               length:queryBytes
+                                                              options:MTLResourceStorageModeShared];
+        id<MTLBuffer> outRows = [shared.device newBufferWithLength:outSlots * sizeof(std::int64_t)
+                                                           options:MTLResourceStorageModeShared];
+        id<MTLBuffer> outScores = [shared.device newBufferWithLength:outSlots * sizeof(float)
+                                                             options:MTLResourceStorageModeShared];
+        if (!queryBuffer || !outRows || !outScores) {
+            error = "cannot allocate Metal buffers";
+            return false;
+        }
+
+        const KernelParams params {static_cast<std::uint64_t>(matrix->rows), static_cast<std::uint32_t>(matrix->stride),
+                                   static_cast<std::uint32_t>(matrix->dimension), static_cast<std::uint32_t>(k),
+                                   static_cast<std::uint32_t>(matrix->format)};
+        id<MTLCommandBuffer> commands = [shared.queue commandBuffer];
+        id<MTLComputeCommandEncoder> encoder = [commands computeCommandEncoder];
+        [encoder setComputePipelineState:shared.state];
+        [encoder setBuffer:matrix->data offset:0 atIndex:0];
+        [encoder setBuffer:matrix->live offset:0 atIndex:1];
+        [encoder setBytes:&params length:sizeof(params) atIndex:2];
+        [encoder setBuffer:queryBuffer offset:0 atIndex:3];
+        [encoder setBuffer:outRows offset:0 atIndex:4];
+        [encoder setBuffer:outScores offset:0 atIndex:5];
+        // Threadgroup memory lengths must be multiples of 16 bytes
+        const std::size_t threadgroupBytes =
+            ((static_cast<std::size_t>(matrix->dimension) + kRowsPerBlock) * sizeof(float) + 15) & ~std::size_t {15};
+        [encoder setThreadgroupMemoryLength:threadgroupBytes atIndex:0];
+        [encoder dispatchThreadgroups:MTLSizeMake(static_cast<NSUInteger>(blocks), static_cast<NSUInteger>(queryCount), 1)
+                threadsPerThreadgroup:MTLSizeMake(kThreadsPerBlock, 1, 1)];
+        [encoder endEncoding];
+        [commands commit];
+        [commands waitUntilCompleted];
+        if (commands.status != MTLCommandBufferStatusCompleted) {
+            error = commands.error ? commands.error.localizedDescription.UTF8String : "Metal command buffer failed";
+            return false;
+        }
+
+        const auto* blockRows = static_cast<const std::int64_t*>(outRows.contents);
+        const auto* blockScores = static_cast<const float*>(outScores.contents);
+        const std::size_t perQuery = static_cast<std::size_t>(blocks) * k;
+        for (int q = 0; q < queryCount; ++q) {
+            mergeBlockWinners(blockRows + q * perQuery, blockScores + q * perQuery, blocks, k,
+                              rows + static_cast<std::size_t>(q) * k, scores + static_cast<std::size_t>(q) * k);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,184 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "GpuVectorScorer.h"
+#include "GpuScoringDevice.h"
+#include "VectorFile.h"
+#include "Logger.h"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Slots staged in host memory per copy to the device
+constexpr qint64 kUploadRows = 16384;
+
+} // namespace
+
+GpuVectorScorer::~GpuVectorScorer()
+{
+#if CP_HAS_CUDA_SCORING || CP_HAS_METAL_SCORING
+    GpuScoringDevice::destroyMatrix(m_matrix);
+#endif
+}
+
+bool GpuVectorScorer::isAvailable()
+{
+#if CP_HAS_CUDA_SCORING || CP_HAS_METAL_SCORING
+    static const bool available = GpuScoringDevice::available();
+    return available;
+#else
+    return false;
+#endif
+}
+
+QString GpuVectorScorer::backendName()
+{
+#if CP_HAS_CUDA_SCORING || CP_HAS_METAL_SCORING
+    return QString::fromLatin1(GpuScoringDevice::name());
+#else
+    return {};
+#endif
+}
+
+qint64 GpuVectorScorer::deviceBytes() const
+{
+#if CP_HAS_CUDA_SCORING || CP_HAS_METAL_SCORING
+    return GpuScoringDevice::deviceBytes(m_matrix);
+#else
+    return 0;
+#endif
+}
+
+std::unique_ptr<GpuVectorScorer> GpuVectorScorer::create(const VectorFile& vectors, QString* error)
+{
+#if CP_HAS_CUDA_SCORING || CP_HAS_METAL_SCORING
+    if (!isAvailable()) {
+        if (error) *error = QStringLiteral("No GPU device");
+        return nullptr;
+    }
+    if (vectors.dimension() <= 0 || vectors.dimension() > kMaxDimension || vectors.maxId() <= 0) {
+        if (error) *error = QStringLiteral("Vector file is empty or its embeddings are too large for the GPU");
+        return nullptr;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    std::string deviceError;
+    std::unique_ptr<GpuVectorScorer> scorer(new GpuVectorScorer);
+    scorer->m_maxId = vectors.maxId();
+    scorer->m_dimension = vectors.dimension();
+    scorer->m_matrix = GpuScoringDevice::createMatrix(vectors.format(), vectors.dimension(), vectors.stride(),
+                                                      vectors.maxId(), deviceError);
+    if (!scorer->m_matrix) {
+        if (error) *error = QString::fromStdString(deviceError);
+        return nullptr;
+    }
+
+    // Row r holds id r + 1; deleted slots are copied as zeros and flagged dead
+    const qint64 stride = vectors.stride();
+    QByteArray rows(static_cast<qsizetype>(std::min(kUploadRows, vectors.maxId()) * stride), '\0');
+    std::vector<std::uint8_t> live(static_cast<size_t>(std::min(kUploadRows, vectors.maxId())));
+    for (qint64 first = 1; first <= vectors.maxId(); first += kUploadRows) {
+        const qint64 count = std::min(kUploadRows, vectors.maxId() - first + 1);
+        for (qint64 i = 0; i < count; ++i) {
+            char* slot = rows.data() + i * stride;
+            if (const char* row = vectors.row(first + i)) {
+                std::memcpy(slot, row, static_cast<size_t>(vectors.rowBytes()));
+                live[static_cast<size_t>(i)] = 1;
+            } else {
+                std::memset(slot, 0, static_cast<size_t>(stride));
+                live[static_cast<size_t>(i)] = 0;
+            }
+        }
+        if (!GpuScoringDevice::upload(scorer->m_matrix, first - 1, count, rows.constData(), live.data(), deviceError)) {
+            if (error) *error = QString::fromStdString(deviceError);
+            return nullptr;
+        }
+    }
+    CP_CLOG(cp_lifecycle).noquote() << "GpuVectorScorer: uploaded" << vectors.maxId() << "rows,"
+                                    << (scorer->deviceBytes() >> 20) << "MiB to" << backendName() << "in"
+                                    << timer.elapsed() << "ms";
+    return scorer;
+#else
+    Q_UNUSED(vectors)
+    if (error) *error = QStringLiteral("This build has no GPU scoring");
+    return nullptr;
+#endif
+}
+
+bool GpuVectorScorer::search(const std::vector<std::vector<float>>& queries, int k,
+                             std::vector<std::vector<Hit>>& hits, QString* error) const
+{
+    hits.assign(queries.size(), {});
+    if (queries.empty() || k <= 0) {
+        return true;
+    }
+    if (k > kMaxCandidates) {
+        if (error) *error = QStringLiteral("At most %1 candidates per query").arg(kMaxCandidates);
+        return false;
+    }
+#if CP_HAS_CUDA_SCORING || CP_HAS_METAL_SCORING
+    const size_t dimension = static_cast<size_t>(m_dimension);
+    std::vector<float> packed;
+    packed.reserve(queries.size() * dimension);
+    for (const std::vector<float>& query : queries) {
+        if (query.size() != dimension) {
+            if (error) {
+                *error = QStringLiteral("Query has %1 dimensions, the index %2")
+                             .arg(static_cast<qulonglong>(query.size()))
+                             .arg(m_dimension);
+            }
+            return false;
+        }
+        packed.insert(packed.end(), query.begin(), query.end());
+    }
+
+    const size_t slots = queries.size() * static_cast<size_t>(k);
+    std::vector<std::int64_t> rows(slots);
+    std::vector<float> scores(slots);
+    std::string deviceError;
+    if (!GpuScoringDevice::topK(m_matrix, packed.data(), static_cast<int>(queries.size()), k, rows.data(),
+                                scores.data(), deviceError)) {
+        if (error) *error = QString::fromStdString(deviceError);
+        return false;
+    }
+    for (size_t q = 0; q < queries.size(); ++q) {
+        for (size_t i = 0; i < static_cast<size_t>(k); ++i) {
+            const std::int64_t row = rows[q * static_cast<size_t>(k) + i];
+            if (row < 0) {
+                break;
+            }
+            hits[q].push_back(Hit {row + 1, scores[q * static_cast<size_t>(k) + i]});
+        }
+    }
+    return true;
+#else
+    if (error) *error = QStringLiteral("This build has no GPU scoring");
+    return false;
+#endif
+}
@@ -0,0 +1,95 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QString>
+
+#include <memory>
+#include <vector>
+
+class VectorFile;
+
+namespace GpuScoringDevice {
+struct Matrix;
+}
+
+/**
+ * @brief A vector file's rows held in GPU memory, ranked against queries on the device.
+ *
+ * create() copies every slot of a mapped VectorFile to the device once; the
+ * copy then serves any number of searches until the file changes. search()
+ * scores all live rows against a batch of queries in one launch: each thread
+ * block scores GpuScoringDevice::kRowsPerBlock rows into shared memory and
+ * keeps its k best, and only those leave the device to be merged on the host.
+ *
+ * Builds with CP_HAS_CUDA_SCORING or CP_HAS_METAL_SCORING have a device path;
+ * elsewhere isAvailable() is false and create() always fails.
+ */
+class GpuVectorScorer
+{
+public:
+    struct Hit {
+        qint64 id {0};      ///< fragments.id
+        float score {0.0f}; ///< Dot product with the query
+    };
+
+    /// Largest k search() takes; larger candidate lists are ranked on the CPU.
+    static constexpr int kMaxCandidates = 256;
+    /// Largest embedding the kernels keep in shared memory.
+    static constexpr int kMaxDimension = 4096;
+
+    ~GpuVectorScorer();
+
+    GpuVectorScorer(const GpuVectorScorer&) = delete;
+    GpuVectorScorer& operator=(const GpuVectorScorer&) = delete;
+
+    /// True when this build has a device path and a device is present.
+    static bool isAvailable();
+    /// "cuda", "metal", or empty without a device path.
+    static QString backendName();
+
+    /// Uploads @p vectors; nullptr (with @p error set) without a device or when it cannot hold them.
+    static std::unique_ptr<GpuVectorScorer> create(const VectorFile& vectors, QString* error = nullptr);
+
+    /// Highest id uploaded; rows added to the file later are not on the device.
+    qint64 maxId() const { return m_maxId; }
+    int dimension() const { return m_dimension; }
+    qint64 deviceBytes() const;
+
+    /**
+     * @brief The k live rows with the largest dot product for each query, best first.
+     *
+     * Queries must have dimension() entries; @p k is at most kMaxCandidates.
+     * Returns false with @p error set when the device fails.
+     */
+    bool search(const std::vector<std::vector<float>>& queries, int k, std::vector<std::vector<Hit>>& hits,
+                QString* error = nullptr) const;
+
+private:
+    GpuVectorScorer() = default;
+
+    GpuScoringDevice::Matrix* m_matrix {nullptr};
+    qint64 m_maxId {0};
+    int m_dimension {0};
+};
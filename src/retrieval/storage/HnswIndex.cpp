@@ -0,0 +1,440 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "HnswIndex.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+namespace {
+
+constexpr quint32 kFileMagic = 0x4350484e; // "CPHN"
+constexpr quint32 kFileVersion = 1;
+constexpr float kCodeScale = 127.0f;
+constexpr qint64 kRawChunkBytes = 64 * 1024 * 1024; // QDataStream raw I/O takes int lengths
+
+struct WorseFirst {
+    bool operator()(const std::pair<float, quint32>& lhs, const std::pair<float, quint32>& rhs) const
+    {
+        return lhs.first > rhs.first;
+    }
+};
+
+} // namespace
+
+void HnswIndex::VisitedSet::reset(std::size_t size)
+{
+    if (m_marks.size() < size) {
+        m_marks.resize(size, 0);
+    }
+    if (++m_epoch == 0) {
+        std::fill(m_marks.begin(), m_marks.end(), 0);
+        m_epoch = 1;
+    }
+}
+
+bool HnswIndex::VisitedSet::insert(quint32 node)
+{
+    if (m_marks[node] == m_epoch) {
+        return false;
+    }
+    m_marks[node] = m_epoch;
+    return true;
+}
+
+HnswIndex::HnswIndex(int dimension, int m, int efConstruction)
+    : m_dimension(qMax(0, dimension))
+    , m_m(qMax(2, m))
+    , m_efConstruction(qMax(m_m, efConstruction))
+    , m_levelMultiplier(1.0 / std::log(static_cast<double>(qMax(2, m))))
+{
+}
+
+bool HnswIndex::encode(const std::vector<float>& vector, std::vector<qint8>& code) const
+{
+    if (vector.empty() || static_cast<int>(vector.size()) != m_dimension) {
+        return false;
+    }
+
+    double norm = 0.0;
+    for (const float value : vector) {
+        norm += static_cast<double>(value) * value;
+    }
+    if (norm <= 0.0) {
+        return false;
+    }
+
+    const double scale = kCodeScale / std::sqrt(norm);
+    code.resize(vector.size());
+    for (std::size_t i = 0; i < vector.size(); ++i) {
+        const long quantised = std::lround(vector[i] * scale);
+        code[i] = static_cast<qint8>(std::clamp(quantised, -127L, 127L));
+    }
+    return true;
+}
+
+float HnswIndex::similarity(const qint8* a, const qint8* b) const
+{
+    qint32 dot = 0;
+    for (int i = 0; i < m_dimension; ++i) {
+        dot += static_cast<qint32>(a[i]) * b[i];
+    }
+    return static_cast<float>(dot) / (kCodeScale * kCodeScale);
+}
+
+quint32 HnswIndex::greedyClosest(const qint8* query, quint32 entry, int layer) const
+{
+    quint32 current = entry;
+    float best = similarity(query, codeOf(current));
+    for (bool improved = true; improved;) {
+        improved = false;
+        if (layer >= static_cast<int>(m_nodes[current].links.size())) {
+            break;
+        }
+        for (const quint32 neighbour : m_nodes[current].links[layer]) {
+            const float score = similarity(query, codeOf(neighbour));
+            if (score > best) {
+                best = score;
+                current = neighbour;
+                improved = true;
+            }
+        }
+    }
+    return current;
+}
+
+std::vector<HnswIndex::Scored> HnswIndex::searchLayer(const qint8* query, quint32 entry, int ef, int layer,
+                                                      VisitedSet& visited, const Filter* accept) const
+{
+    visited.reset(m_nodes.size());
+    visited.insert(entry);
+    // Rejected nodes are still walked through, they just never take a result slot
+    const auto accepted = [this, accept](quint32 node) { return !accept || (*accept)(m_nodes[node].id); };
+
+    const Scored start {similarity(query, codeOf(entry)), entry};
+    std::priority_queue<Scored> candidates; // best first
+    std::priority_queue<Scored, std::vector<Scored>, WorseFirst> found; // worst first, at most ef
+    candidates.push(start);
+    if (accepted(entry)) {
+        found.push(start);
+    }
+
+    while (!candidates.empty()) {
+        const Scored candidate = candidates.top();
+        if (static_cast<int>(found.size()) >= ef && candidate.first < found.top().first) {
+            break;
+        }
+        candidates.pop();
+
+        const Node& node = m_nodes[candidate.second];
+        if (layer >= static_cast<int>(node.links.size())) {
+            continue;
+        }
+        for (const quint32 neighbour : node.links[layer]) {
+            if (!visited.insert(neighbour)) {
+                continue;
+            }
+            const float score = similarity(query, codeOf(neighbour));
+            if (static_cast<int>(found.size()) < ef || score > found.top().first) {
+                candidates.push({score, neighbour});
+                if (!accepted(neighbour)) {
+                    continue;
+                }
+                found.push({score, neighbour});
+                if (static_cast<int>(found.size()) > ef) {
+                    found.pop();
+                }
+            }
+        }
+    }
+
+    std::vector<Scored> result;
+    result.reserve(found.size());
+    while (!found.empty()) {
+        result.push_back(found.top());
+        found.pop();
+    }
+    std::reverse(result.begin(), result.end());
+    return result;
+}
+
+std::vector<quint32> HnswIndex::selectNeighbours(const std::vector<Scored>& candidates, int m) const
+{
+    // Keep a candidate only if it is closer to the query than to every neighbour already
+    // kept, so links spread across clusters; top up with the closest rejects.
+    std::vector<quint32> selected;
+    std::vector<quint32> rejected;
+    selected.reserve(m);
+    for (const Scored& candidate : candidates) {
+        if (static_cast<int>(selected.size()) >= m) {
+            break;
+        }
+        const qint8* code = codeOf(candidate.second);
+        const bool diverse = std::none_of(selected.cbegin(), selected.cend(), [&](quint32 kept) {
+            return similarity(code, codeOf(kept)) > candidate.first;
+        });
+        (diverse ? selected : rejected).push_back(candidate.second);
+    }
+    for (std::size_t i = 0; i < rejected.size() && static_cast<int>(selected.size()) < m; ++i) {
+        selected.push_back(rejected[i]);
+    }
+    return selected;
+}
+
+void HnswIndex::connect(quint32 from, quint32 to, int layer)
+{
+    std::vector<quint32>& links = m_nodes[from].links[layer];
+    links.push_back(to);
+    if (static_cast<int>(links.size()) <= maxLinks(layer)) {
+        return;
+    }
+
+    const qint8* base = codeOf(from);
+    std::vector<Scored> scored;
+    scored.reserve(links.size());
+    for (const quint32 neighbour : links) {
+        scored.push_back({similarity(base, codeOf(neighbour)), neighbour});
+    }
+    std::sort(scored.begin(), scored.end(), [](const Scored& lhs, const Scored& rhs) {
+        return lhs.first > rhs.first;
+    });
+    links = selectNeighbours(scored, maxLinks(layer));
+}
+
+int HnswIndex::randomLevel()
+{
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    const double sample = std::max(uniform(m_rng), 1e-12);
+    return static_cast<int>(-std::log(sample) * m_levelMultiplier);
+}
+
+bool HnswIndex::add(qint64 id, const std::vector<float>& vector)
+{
+    m_maxId = std::max(m_maxId, id);
+    if (m_dimension == 0) {
+        m_dimension = static_cast<int>(vector.size());
+    }
+
+    std::vector<qint8> code;
+    if (!encode(vector, code)) {
+        return false;
+    }
+
+    const quint32 node = static_cast<quint32>(m_nodes.size());
+    const int level = randomLevel();
+    m_codes.insert(m_codes.end(), code.begin(), code.end());
+    Node added;
+    added.id = id;
+    added.links.resize(static_cast<std::size_t>(level) + 1);
+    m_nodes.push_back(std::move(added));
+
+    if (m_maxLevel < 0) {
+        m_entryPoint = node;
+        m_maxLevel = level;
+        return true;
+    }
+
+    const qint8* query = codeOf(node);
+    quint32 entry = m_entryPoint;
+    for (int layer = m_maxLevel; layer > level; --layer) {
+        entry = greedyClosest(query, entry, layer);
+    }
+
+    for (int layer = std::min(level, m_maxLevel); layer >= 0; --layer) {
+        const std::vector<Scored> nearest = searchLayer(query, entry, m_efConstruction, layer, m_buildVisited);
+        const std::vector<quint32> neighbours = selectNeighbours(nearest, m_m);
+        m_nodes[node].links[layer] = neighbours;
+        for (const quint32 neighbour : neighbours) {
+            connect(neighbour, node, layer);
+        }
+        entry = nearest.front().second;
+    }
+
+    if (level > m_maxLevel) {
+        m_maxLevel = level;
+        m_entryPoint = node;
+    }
+    return true;
+}
+
+std::vector<HnswIndex::Hit> HnswIndex::search(const std::vector<float>& query, int k, int ef) const
+{
+    return searchImpl(query, k, ef, nullptr);
+}
+
+std::vector<HnswIndex::Hit> HnswIndex::search(const std::vector<float>& query, int k, int ef,
+                                              const Filter& accept) const
+{
+    return searchImpl(query, k, ef, accept ? &accept : nullptr);
+}
+
+std::vector<HnswIndex::Hit> HnswIndex::searchImpl(const std::vector<float>& query, int k, int ef,
+                                                  const Filter* accept) const
+{
+    std::vector<Hit> hits;
+    std::vector<qint8> code;
+    if (k <= 0 || m_nodes.empty() || !encode(query, code)) {
+        return hits;
+    }
+
+    quint32 entry = m_entryPoint;
+    for (int layer = m_maxLevel; layer > 0; --layer) {
+        entry = greedyClosest(code.data(), entry, layer);
+    }
+
+    VisitedSet visited;
+    const std::vector<Scored> nearest = searchLayer(code.data(), entry, std::max(ef, k), 0, visited, accept);
+    hits.reserve(std::min<std::size_t>(nearest.size(), static_cast<std::size_t>(k)));
+    for (const Scored& scored : nearest) {
+        if (static_cast<int>(hits.size()) >= k) {
+            break;
+        }
+        hits.push_back({m_nodes[scored.second].id, scored.first});
+    }
+    return hits;
+}
+
+bool HnswIndex::save(const QString& path, QString* error) const
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+
+    QDataStream out(&file);
+    out << kFileMagic << kFileVersion << qint32(m_dimension) << qint32(m_m) << qint32(m_efConstruction)
+        << qint32(m_maxLevel) << quint32(m_entryPoint) << qint64(m_maxId) << quint64(m_nodes.size());
+    const char* codes = reinterpret_cast<const char*>(m_codes.data());
+    for (qint64 offset = 0; offset < static_cast<qint64>(m_codes.size()); offset += kRawChunkBytes) {
+        const qint64 chunk = std::min<qint64>(kRawChunkBytes, static_cast<qint64>(m_codes.size()) - offset);
+        out.writeRawData(codes + offset, static_cast<int>(chunk));
+    }
+    for (const Node& node : m_nodes) {
+        out << qint64(node.id) << quint32(node.links.size());
+        for (const std::vector<quint32>& links : node.links) {
+            out << quint32(links.size());
+            for (const quint32 neighbour : links) {
+                out << neighbour;
+            }
+        }
+    }
+
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<HnswIndex> HnswIndex::load(const QString& path, QString* error)
+{
+    auto failed = [error](const QString& message) -> std::unique_ptr<HnswIndex> {
+        if (error) {
+            *error = message;
+        }
+        return nullptr;
+    };
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return failed(file.errorString());
+    }
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 dimension = 0;
+    qint32 m = 0;
+    qint32 efConstruction = 0;
+    qint32 maxLevel = -1;
+    quint32 entryPoint = 0;
+    qint64 maxId = 0;
+    quint64 count = 0;
+    in >> magic >> version >> dimension >> m >> efConstruction >> maxLevel >> entryPoint >> maxId >> count;
+    if (in.status() != QDataStream::Ok || magic != kFileMagic || version != kFileVersion || dimension < 0
+        || (count > 0 && (dimension == 0 || entryPoint >= count || maxLevel < 0))) {
+        return failed(QStringLiteral("not an ANN index file or unsupported version"));
+    }
+
+    auto index = std::make_unique<HnswIndex>(dimension, m, efConstruction);
+    index->m_maxLevel = maxLevel;
+    index->m_entryPoint = entryPoint;
+    index->m_maxId = maxId;
+    const quint64 codeBytes = count * static_cast<quint64>(dimension);
+    if (codeBytes > static_cast<quint64>(file.size())) {
+        return failed(QStringLiteral("truncated ANN index file"));
+    }
+    index->m_codes.resize(static_cast<std::size_t>(codeBytes));
+    char* codes = reinterpret_cast<char*>(index->m_codes.data());
+    for (qint64 offset = 0; offset < static_cast<qint64>(codeBytes); offset += kRawChunkBytes) {
+        const qint64 chunk = std::min<qint64>(kRawChunkBytes, static_cast<qint64>(codeBytes) - offset);
+        if (in.readRawData(codes + offset, static_cast<int>(chunk)) != static_cast<int>(chunk)) {
+            return failed(QStringLiteral("truncated ANN index file"));
+        }
+    }
+
+    index->m_nodes.resize(static_cast<std::size_t>(count));
+    for (Node& node : index->m_nodes) {
+        quint32 layers = 0;
+        in >> node.id >> layers;
+        if (layers == 0 || layers > static_cast<quint32>(maxLevel) + 1) {
+            return failed(QStringLiteral("corrupt ANN index file"));
+        }
+        node.links.resize(layers);
+        for (std::vector<quint32>& links : node.links) {
+            quint32 linkCount = 0;
+            in >> linkCount;
+            if (in.status() != QDataStream::Ok || linkCount > static_cast<quint32>(2 * index->m_m)) {
+                return failed(QStringLiteral("corrupt ANN index file"));
+            }
+            links.resize(linkCount);
+            for (quint32& neighbour : links) {
+                in >> neighbour;
+                if (neighbour >= count) {
+                    return failed(QStringLiteral("corrupt ANN index file"));
+                }
+            }
+        }
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        return failed(QStringLiteral("truncated ANN index file"));
+    }
+    if (count > 0 && index->m_nodes[entryPoint].links.size() != static_cast<std::size_t>(maxLevel) + 1) {
+        return failed(QStringLiteral("corrupt ANN index file"));
+    }
+    return index;
+}
@@ -0,0 +1,136 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+
+#include <functional>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Approximate nearest-neighbour index (HNSW) over RAG fragment embeddings.
+ *
+ * A hierarchical navigable small-world graph: every vector is a node linked
+ * to its closest neighbours, with a sparse hierarchy of upper layers for
+ * long hops, so a search visits a few thousand nodes instead of all of them.
+ * Vectors are normalised and stored as 8-bit codes, a quarter of the size
+ * of the float blobs in SQLite; callers re-score the returned candidates
+ * against the exact embeddings. Ids are fragments.id values and only ever
+ * grow, so maxId() tells which rows an index has already seen.
+ *
+ * add() is single-threaded; search() is const and may run concurrently.
+ */
+class HnswIndex
+{
+public:
+    static constexpr int kDefaultM = 16;
+    static constexpr int kDefaultEfConstruction = 100;
+    static constexpr int kDefaultEfSearch = 128;
+
+    struct Hit {
+        qint64 id {0};
+        float score {0.0f}; ///< Approximate cosine similarity
+    };
+
+    /// A dimension of 0 is taken from the first vector added.
+    explicit HnswIndex(int dimension = 0, int m = kDefaultM, int efConstruction = kDefaultEfConstruction);
+
+    int dimension() const { return m_dimension; }
+    int size() const { return static_cast<int>(m_nodes.size()); }
+    qint64 maxId() const { return m_maxId; }
+
+    /**
+     * @brief Inserts one vector.
+     *
+     * Returns false when the dimension differs or the vector is all zeros;
+     * the id still counts towards maxId() so the row is not offered again.
+     */
+    bool add(qint64 id, const std::vector<float>& vector);
+
+    /// Up to k hits, best first; ef (raised to at least k) trades speed for recall.
+    std::vector<Hit> search(const std::vector<float>& query, int k, int ef = kDefaultEfSearch) const;
+
+    /// Accepts or rejects a fragment id during a filtered search.
+    using Filter = std::function<bool(qint64 id)>;
+
+    /**
+     * @brief Up to k hits among the ids @p accept allows, best first.
+     *
+     * The graph is walked as usual, but only accepted nodes fill the ef
+     * result slots, so the walk goes on until ef of them are found. Cost
+     * grows with 1 / selectivity; very narrow filters are better served by
+     * scanning their rows directly.
+     */
+    std::vector<Hit> search(const std::vector<float>& query, int k, int ef, const Filter& accept) const;
+
+    bool save(const QString& path, QString* error = nullptr) const;
+    static std::unique_ptr<HnswIndex> load(const QString& path, QString* error = nullptr);
+
+private:
+    using Scored = std::pair<float, quint32>; // similarity, node
+
+    struct Node {
+        qint64 id {0};
+        std::vector<std::vector<quint32>> links; // one neighbour list per layer
+    };
+
+    // Epoch-stamped visited marks, so a reused set clears in O(1)
+    class VisitedSet {
+    public:
+        void reset(std::size_t size);
+        bool insert(quint32 node);
+
+    private:
+        std::vector<quint32> m_marks;
+        quint32 m_epoch {0};
+    };
+
+    bool encode(const std::vector<float>& vector, std::vector<qint8>& code) const;
+    const qint8* codeOf(quint32 node) const { return m_codes.data() + static_cast<std::size_t>(node) * m_dimension; }
+    float similarity(const qint8* a, const qint8* b) const;
+    quint32 greedyClosest(const qint8* query, quint32 entry, int layer) const;
+    std::vector<Scored> searchLayer(const qint8* query, quint32 entry, int ef, int layer, VisitedSet& visited,
+                                    const Filter* accept = nullptr) const;
+    std::vector<Hit> searchImpl(const std::vector<float>& query, int k, int ef, const Filter* accept) const;
+    std::vector<quint32> selectNeighbours(const std::vector<Scored>& candidates, int m) const;
+    void connect(quint32 from, quint32 to, int layer);
+    int maxLinks(int layer) const { return layer == 0 ? m_m * 2 : m_m; }
+    int randomLevel();
+
+    int m_dimension {0};
+    int m_m {kDefaultM};
+    int m_efConstruction {kDefaultEfConstruction};
+    double m_levelMultiplier {0.0};
+    int m_maxLevel {-1};
+    quint32 m_entryPoint {0};
+    qint64 m_maxId {0};
+    std::vector<qint8> m_codes;
+    std::vector<Node> m_nodes;
+    std::mt19937 m_rng {0x5eed};
+    VisitedSet m_buildVisited;
+};
@@ -0,0 +1,358 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "RagIndexClient.h"
+
+#include "ai/backends/HttpConnectionPool.h"
+
+#include <QDateTime>
+#include <QHash>
+#include <QJsonDocument>
+#include <QMutex>
+#include <QUrl>
+#include <QtEndian>
+
+#include <stdexcept>
+
+namespace {
+
+QString modeName(RagSearchMode mode)
+{
+    switch (mode) {
+    case RagSearchMode::Hybrid: return QStringLiteral("hybrid");
+    case RagSearchMode::KeywordPrefilter: return QStringLiteral("keyword_prefilter");
+    case RagSearchMode::Vector: break;
+    }
+    return QStringLiteral("vector");
+}
+
+bool modeFromName(const QString& name, RagSearchMode& mode)
+{
+    if (name.isEmpty() || name == QLatin1String("vector")) {
+        mode = RagSearchMode::Vector;
+    } else if (name == QLatin1String("hybrid")) {
+        mode = RagSearchMode::Hybrid;
+    } else if (name == QLatin1String("keyword_prefilter")) {
+        mode = RagSearchMode::KeywordPrefilter;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Little-endian float32, base64: a quarter of the size of a JSON number array
+QString encodeVector(const std::vector<float>& vector)
+{
+    QByteArray bytes(static_cast<qsizetype>(vector.size() * sizeof(float)), Qt::Uninitialized);
+    qToLittleEndian<float>(vector.data(), static_cast<qsizetype>(vector.size()), bytes.data());
+    return QString::fromLatin1(bytes.toBase64());
+}
+
+bool decodeVector(const QString& text, std::vector<float>& vector)
+{
+    const auto decoded = QByteArray::fromBase64Encoding(text.toLatin1());
+    if (!decoded || decoded.decoded.size() % static_cast<qsizetype>(sizeof(float)) != 0) {
+        return false;
+    }
+    vector.resize(static_cast<std::size_t>(decoded.decoded.size()) / sizeof(float));
+    qFromLittleEndian<float>(decoded.decoded.constData(), static_cast<qsizetype>(vector.size()), vector.data());
+    return true;
+}
+
+QJsonArray toJsonArray(const QStringList& list)
+{
+    return QJsonArray::fromStringList(list);
+}
+
+QStringList toStringList(const QJsonValue& value)
+{
+    QStringList list;
+    for (const QJsonValue& item : value.toArray()) {
+        list.append(item.toString());
+    }
+    return list;
+}
+
+struct CachedConfig {
+    RagUtils::IndexConfig config;
+    qint64 fetchedAtMs {0};
+};
+
+QMutex g_configMutex;
+QHash<QString, CachedConfig> g_configs;
+
+// Sends one request and returns the parsed JSON body of a 200 answer
+QJsonObject exchange(const RagIndexClient::Address& address, const QString& path, const QByteArray* body)
+{
+    const cpr::Url url{(address.baseUrl() + path).toStdString()};
+    const cpr::Response response =
+        body ? HttpConnectionPool::post(url, cpr::Header{{"Content-Type", "application/json"}, {"Expect", ""}},
+                                        cpr::Body{body->toStdString()}, cpr::ConnectTimeout{2000},
+                                        cpr::Timeout{RagIndexClient::kTimeoutMs})
+             : HttpConnectionPool::get(url, cpr::ConnectTimeout{2000}, cpr::Timeout{RagIndexClient::kTimeoutMs});
+    if (response.error) {
+        throw std::runtime_error(QStringLiteral("Retrieval daemon %1 unreachable: %2")
+                                     .arg(address.baseUrl(), QString::fromStdString(response.error.message))
+                                     .toStdString());
+    }
+    const QJsonObject json = QJsonDocument::fromJson(QByteArray::fromStdString(response.text)).object();
+    if (response.status_code != 200) {
+        const QString message = json.value(QStringLiteral("error")).toString();
+        throw std::runtime_error(QStringLiteral("Retrieval daemon %1 answered %2: %3")
+                                     .arg(address.baseUrl())
+                                     .arg(response.status_code)
+                                     .arg(message.isEmpty() ? QString::fromStdString(response.status_line) : message)
+                                     .toStdString());
+    }
+    return json;
+}
+
+} // namespace
+
+QString RagIndexClient::Address::baseUrl() const
+{
+    const QString bracketed = host.contains(QLatin1Char(':')) ? QLatin1Char('[') + host + QLatin1Char(']') : host;
+    return QStringLiteral("http://%1:%2").arg(bracketed).arg(port);
+}
+
+bool RagIndexClient::parseAddress(const QString& url, Address& address, QString* error)
+{
+    const QUrl parsed(url, QUrl::StrictMode);
+    const QString index = parsed.path().mid(1);
+    if (!parsed.isValid() || parsed.scheme() != QLatin1String("rag") || parsed.host().isEmpty()
+        || parsed.port() <= 0 || index.isEmpty() || index.contains(QLatin1Char('/'))) {
+        if (error) {
+            *error = QStringLiteral("\"%1\" is not a rag://host:port/index address").arg(url);
+        }
+        return false;
+    }
+    address.host = parsed.host();
+    address.port = parsed.port();
+    address.index = index;
+    return true;
+}
+
+RagUtils::IndexConfig RagIndexClient::indexConfig(const QString& url)
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    {
+        QMutexLocker locker(&g_configMutex);
+        const auto cached = g_configs.constFind(url);
+        if (cached != g_configs.constEnd() && now - cached->fetchedAtMs < kConfigTtlMs) {
+            return cached->config;
+        }
+    }
+
+    Address address;
+    QString error;
+    if (!parseAddress(url, address, &error)) {
+        throw std::runtime_error(error.toStdString());
+    }
+    const RagUtils::IndexConfig config = configFromJson(
+        exchange(address, QStringLiteral("/indexes/") + QString::fromLatin1(QUrl::toPercentEncoding(address.index)),
+                 nullptr));
+    QMutexLocker locker(&g_configMutex);
+    g_configs.insert(url, CachedConfig{config, now});
+    return config;
+}
+
+std::vector<std::vector<RagUtils::SearchResult>> RagIndexClient::search(
+    const QString& url, const std::vector<std::vector<float>>& embeddings, const QStringList& queryTexts,
+    int limit, double minRelevance, const RagSearchOptions& options)
+{
+    Address address;
+    QString error;
+    if (!parseAddress(url, address, &error)) {
+        throw std::runtime_error(error.toStdString());
+    }
+    SearchRequest request;
+    request.index = address.index;
+    request.embeddings = embeddings;
+    request.queryTexts = queryTexts;
+    request.limit = limit;
+    request.minRelevance = minRelevance;
+    request.options = options;
+    const QByteArray body = QJsonDocument(request.toJson()).toJson(QJsonDocument::Compact);
+
+    std::vector<std::vector<RagUtils::SearchResult>> results =
+        resultsFromJson(exchange(address, QStringLiteral("/search"), &body).value(QStringLiteral("results")).toArray());
+    if (results.size() != embeddings.size()) {
+        throw std::runtime_error(QStringLiteral("Retrieval daemon %1 answered %2 result lists for %3 queries")
+                                     .arg(address.baseUrl())
+                                     .arg(results.size())
+                                     .arg(embeddings.size())
+                                     .toStdString());
+    }
+    return results;
+}
+
+QJsonObject RagIndexClient::SearchRequest::toJson() const
+{
+    QJsonArray encoded;
+    for (const std::vector<float>& embedding : embeddings) {
+        encoded.append(encodeVector(embedding));
+    }
+    QJsonObject metadata;
+    for (auto it = options.filter.metadata.cbegin(); it != options.filter.metadata.cend(); ++it) {
+        metadata.insert(it.key(), it.value());
+    }
+    return QJsonObject{
+        {QStringLiteral("index"), index},
+        {QStringLiteral("embeddings"), encoded},
+        {QStringLiteral("queries"), toJsonArray(queryTexts)},
+        {QStringLiteral("limit"), limit},
+        {QStringLiteral("min_relevance"), minRelevance},
+        {QStringLiteral("mode"), modeName(options.mode)},
+        {QStringLiteral("use_ann_index"), options.useAnnIndex},
+        {QStringLiteral("ef"), options.ef},
+        {QStringLiteral("rescore"), options.rescore},
+        {QStringLiteral("use_vector_file"), options.useVectorFile},
+        {QStringLiteral("coarse_dimensions"), options.coarseDimensions},
+        {QStringLiteral("filter"),
+         QJsonObject{
+             {QStringLiteral("path_prefix"), options.filter.pathPrefix},
+             {QStringLiteral("file_types"), toJsonArray(options.filter.fileTypes)},
+             {QStringLiteral("tags"), toJsonArray(options.filter.tags)},
+             {QStringLiteral("metadata"), metadata},
+         }},
+    };
+}
+
+bool RagIndexClient::SearchRequest::fromJson(const QJsonObject& json, SearchRequest& request, QString* error)
+{
+    const auto fail = [error](const QString& message) {
+        if (error) {
+            *error = message;
+        }
+        return false;
+    };
+    request.index = json.value(QStringLiteral("index")).toString();
+    if (request.index.isEmpty()) {
+        return fail(QStringLiteral("index is required"));
+    }
+    request.embeddings.clear();
+    for (const QJsonValue& item : json.value(QStringLiteral("embeddings")).toArray()) {
+        std::vector<float> embedding;
+        if (!decodeVector(item.toString(), embedding)) {
+            return fail(QStringLiteral("embeddings must be base64 float32 vectors"));
+        }
+        request.embeddings.push_back(std::move(embedding));
+    }
+    request.queryTexts = toStringList(json.value(QStringLiteral("queries")));
+    request.limit = json.value(QStringLiteral("limit")).toInt(request.limit);
+    request.minRelevance = json.value(QStringLiteral("min_relevance")).toDouble(request.minRelevance);
+    if (request.limit <= 0) {
+        return fail(QStringLiteral("limit must be positive"));
+    }
+    if (!modeFromName(json.value(QStringLiteral("mode")).toString(), request.options.mode)) {
+        return fail(QStringLiteral("unknown mode \"%1\"").arg(json.value(QStringLiteral("mode")).toString()));
+    }
+    request.options.useAnnIndex = json.value(QStringLiteral("use_ann_index")).toBool(request.options.useAnnIndex);
+    request.options.ef = json.value(QStringLiteral("ef")).toInt(request.options.ef);
+    request.options.rescore = json.value(QStringLiteral("rescore")).toBool(request.options.rescore);
+    request.options.useVectorFile = json.value(QStringLiteral("use_vector_file")).toBool(request.options.useVectorFile);
+    request.options.coarseDimensions = json.value(QStringLiteral("coarse_dimensions")).toInt(0);
+
+    const QJsonObject filter = json.value(QStringLiteral("filter")).toObject();
+    request.options.filter.pathPrefix = filter.value(QStringLiteral("path_prefix")).toString();
+    request.options.filter.fileTypes = toStringList(filter.value(QStringLiteral("file_types")));
+    request.options.filter.tags = toStringList(filter.value(QStringLiteral("tags")));
+    const QJsonObject metadata = filter.value(QStringLiteral("metadata")).toObject();
+    for (auto it = metadata.constBegin(); it != metadata.constEnd(); ++it) {
+        request.options.filter.metadata.insert(it.key(), it.value().toString());
+    }
+    return true;
+}
+
+QJsonObject RagIndexClient::configToJson(const RagUtils::IndexConfig& config)
+{
+    return QJsonObject{
+        {QStringLiteral("provider"), config.providerId},
+        {QStringLiteral("model"), config.modelId},
+        {QStringLiteral("dimension"), config.dimension},
+        {QStringLiteral("requested_dimensions"), config.requestedDimensions},
+        {QStringLiteral("format"), RagUtils::embeddingFormatName(config.format)},
+    };
+}
+
+RagUtils::IndexConfig RagIndexClient::configFromJson(const QJsonObject& json)
+{
+    RagUtils::IndexConfig config;
+    config.providerId = json.value(QStringLiteral("provider")).toString();
+    config.modelId = json.value(QStringLiteral("model")).toString();
+    config.dimension = json.value(QStringLiteral("dimension")).toInt();
+    config.requestedDimensions = json.value(QStringLiteral("requested_dimensions")).toInt();
+    config.format = RagUtils::embeddingFormatFromName(json.value(QStringLiteral("format")).toString());
+    return config;
+}
+
+QJsonArray RagIndexClient::resultsToJson(const std::vector<std::vector<RagUtils::SearchResult>>& results)
+{
+    QJsonArray lists;
+    for (const auto& list : results) {
+        QJsonArray items;
+        for (const RagUtils::SearchResult& r : list) {
+            items.append(QJsonObject{
+                {QStringLiteral("fragment_id"), r.fragmentId},
+                {QStringLiteral("file_id"), r.fileId},
+                {QStringLiteral("chunk_index"), r.chunkIndex},
+                {QStringLiteral("start_line"), r.startLine},
+                {QStringLiteral("end_line"), r.endLine},
+                {QStringLiteral("content"), r.content},
+                {QStringLiteral("file_path"), r.filePath},
+                {QStringLiteral("score"), r.score},
+                {QStringLiteral("fused_score"), r.fusedScore},
+                {QStringLiteral("duplicate_paths"), QJsonArray::fromStringList(r.duplicatePaths)},
+            });
+        }
+        lists.append(items);
+    }
+    return lists;
+}
+
+std::vector<std::vector<RagUtils::SearchResult>> RagIndexClient::resultsFromJson(const QJsonArray& json)
+{
+    std::vector<std::vector<RagUtils::SearchResult>> results;
+    for (const QJsonValue& list : json) {
+        std::vector<RagUtils::SearchResult> items;
+        for (const QJsonValue& value : list.toArray()) {
+            const QJsonObject item = value.toObject();
+            RagUtils::SearchResult r;
+            r.fragmentId = item.value(QStringLiteral("fragment_id")).toInteger();
+            r.fileId = item.value(QStringLiteral("file_id")).toInteger();
+            r.chunkIndex = item.value(QStringLiteral("chunk_index")).toInt();
+            r.startLine = item.value(QStringLiteral("start_line")).toInt();
+            r.endLine = item.value(QStringLiteral("end_line")).toInt();
+            r.content = item.value(QStringLiteral("content")).toString();
+            r.filePath = item.value(QStringLiteral("file_path")).toString();
+            r.score = item.value(QStringLiteral("score")).toDouble();
+            r.fusedScore = item.value(QStringLiteral("fused_score")).toDouble();
+            for (const QJsonValue& path : item.value(QStringLiteral("duplicate_paths")).toArray()) {
+                r.duplicatePaths.append(path.toString());
+            }
+            items.push_back(std::move(r));
+        }
+        results.push_back(std::move(items));
+    }
+    return results;
+}
@@ -0,0 +1,96 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+
+#include <vector>
+
+#include "RagUtils.h"
+
+/**
+ * @brief Client of a retrieval daemon (RagIndexServer), for indexes named by URL.
+ *
+ * An index served by "CognitivePipelines --rag-serve" is addressed as
+ * `rag://host:port/name` wherever a database path is accepted. The daemon
+ * keeps its indexes loaded (HNSW sidecar, mapped vector file, SQLite
+ * connections and page cache), so concurrent pipelines and processes share
+ * one hot copy instead of each loading their own. Indexes on several hosts
+ * are searched as shards: RagQueryNode sends each its query embeddings and
+ * merges the lists with RagUtils::mergeShardResults().
+ *
+ * Requests go over HttpConnectionPool. indexConfig() is cached per URL for
+ * kConfigTtlMs. Both calls block and throw std::runtime_error when the daemon
+ * cannot be reached or answers with an error.
+ */
+class RagIndexClient
+{
+public:
+    static constexpr const char* kScheme = "rag://";
+    static constexpr int kConfigTtlMs = 30000;
+    static constexpr int kTimeoutMs = 30000;
+
+    struct Address {
+        QString host;
+        int port {0};
+        QString index;
+
+        /// http://host:port, with IPv6 hosts bracketed
+        QString baseUrl() const;
+    };
+
+    /// One batch of k-NN queries against one index; the wire format of POST /search.
+    struct SearchRequest {
+        QString index;
+        std::vector<std::vector<float>> embeddings;
+        /// Query text per embedding, for the lexical modes; may be empty in Vector mode
+        QStringList queryTexts;
+        int limit {5};
+        double minRelevance {0.0};
+        /// options.queryText and options.threads are not sent
+        RagSearchOptions options;
+
+        QJsonObject toJson() const;
+        static bool fromJson(const QJsonObject& json, SearchRequest& request, QString* error = nullptr);
+    };
+
+    static bool isRemote(const QString& path) { return path.startsWith(QLatin1String(kScheme)); }
+    static bool parseAddress(const QString& url, Address& address, QString* error = nullptr);
+
+    /// The index's embedding configuration, as RagUtils::getIndexConfig() reports it on the daemon.
+    static RagUtils::IndexConfig indexConfig(const QString& url);
+
+    /// One result list per embedding, as RagUtils::findMostRelevantChunksBatch() returns them.
+    static std::vector<std::vector<RagUtils::SearchResult>> search(
+        const QString& url, const std::vector<std::vector<float>>& embeddings, const QStringList& queryTexts,
+        int limit, double minRelevance, const RagSearchOptions& options);
+
+    static QJsonObject configToJson(const RagUtils::IndexConfig& config);
+    static RagUtils::IndexConfig configFromJson(const QJsonObject& json);
+    static QJsonArray resultsToJson(const std::vector<std::vector<RagUtils::SearchResult>>& results);
+    static std::vector<std::vector<RagUtils::SearchResult>> resultsFromJson(const QJsonArray& json);
+};
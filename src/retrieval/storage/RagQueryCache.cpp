@@ -0,0 +1,150 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "RagQueryCache.h"
+
+#include "DiskLruStore.h"
+#include "EmbeddingCache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QStringList>
+
+namespace {
+
+QMutex g_generationMutex;
+QHash<QString, qint64> g_generations;
+
+QString generationKey(const QString& dbPath)
+{
+    return QFileInfo(dbPath).absoluteFilePath();
+}
+
+constexpr auto addField = &DiskLruStore::addField;
+
+void addFileSignature(QCryptographicHash& hash, const QString& path)
+{
+    const QFileInfo info(path);
+    if (!info.exists()) {
+        addField(hash, QByteArrayLiteral("-"));
+        return;
+    }
+    addField(hash, QByteArray::number(info.size()) + ':'
+                       + QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+}
+
+} // namespace
+
+RagQueryCache::RagQueryCache(int capacity)
+    : m_entries(capacity)
+{
+}
+
+RagQueryCache& RagQueryCache::shared()
+{
+    static RagQueryCache cache;
+    return cache;
+}
+
+qint64 RagQueryCache::generation(const QString& dbPath)
+{
+    QMutexLocker locker(&g_generationMutex);
+    return g_generations.value(generationKey(dbPath), 0);
+}
+
+void RagQueryCache::bumpGeneration(const QString& dbPath)
+{
+    QMutexLocker locker(&g_generationMutex);
+    ++g_generations[generationKey(dbPath)];
+}
+
+QByteArray RagQueryCache::makeKey(const QString& dbPath,
+                                  const QString& providerId,
+                                  const QString& modelId,
+                                  const QString& queryText,
+                                  int limit,
+                                  double minRelevance,
+                                  const RagSearchOptions& options)
+{
+    const QString path = generationKey(dbPath);
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    addField(hash, path.toUtf8());
+    addField(hash, QByteArray::number(generation(dbPath)));
+    addFileSignature(hash, path);
+    addFileSignature(hash, path + QStringLiteral("-wal"));
+    addField(hash, EmbeddingCache::makeKey(providerId, modelId, queryText));
+    addField(hash, QByteArray::number(limit));
+    addField(hash, QByteArray::number(minRelevance, 'g', 17));
+
+    // The thread count only changes how the scan is split, never its results
+    addField(hash, QByteArray::number(static_cast<int>(options.mode)));
+    addField(hash, QByteArray::number(options.useAnnIndex ? options.ef : 0));
+    addField(hash, QByteArray(options.rescore ? "rescore" : "-"));
+    addField(hash, QByteArray(options.useVectorFile ? "vector_file" : "-"));
+    addField(hash, QByteArray::number(options.coarseDimensions));
+    if (options.mode != RagSearchMode::Vector) {
+        addField(hash, options.queryText.toUtf8());
+    }
+
+    const RagSearchFilter& filter = options.filter;
+    addField(hash, filter.pathPrefix.toUtf8());
+    addField(hash, filter.fileTypes.join(QLatin1Char(',')).toUtf8());
+    addField(hash, filter.tags.join(QLatin1Char(',')).toUtf8());
+    for (auto it = filter.metadata.constBegin(); it != filter.metadata.constEnd(); ++it) {
+        addField(hash, it.key().toUtf8());
+        addField(hash, it.value().toUtf8());
+    }
+    return hash.result();
+}
+
+bool RagQueryCache::lookup(const QByteArray& key, std::vector<RagUtils::SearchResult>& results)
+{
+    QMutexLocker locker(&m_mutex);
+    // QCache::object() also marks the entry as most recently used
+    if (const std::vector<RagUtils::SearchResult>* found = m_entries.object(key)) {
+        results = *found;
+        ++m_hits;
+        return true;
+    }
+    ++m_misses;
+    return false;
+}
+
+void RagQueryCache::insert(const QByteArray& key, std::vector<RagUtils::SearchResult> results)
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.insert(key, new std::vector<RagUtils::SearchResult>(std::move(results)));
+}
+
+void RagQueryCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+}
+
+int RagQueryCache::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return static_cast<int>(m_entries.size());
+}
@@ -0,0 +1,88 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QCache>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+#include <atomic>
+#include <vector>
+
+#include "RagUtils.h"
+
+/**
+ * @brief In-memory LRU cache of RAG search results.
+ *
+ * A key covers everything a search depends on: the database path, its
+ * generation counter and on-disk signature (size and modification time of
+ * the database and its WAL), the embedding provider and model, the
+ * normalised query text, the limit, the minimum relevance, and the ranking
+ * options and filter. A hit therefore skips both the query embedding and
+ * the scan. RagIndexerNode bumps the generation after each commit, so an
+ * index written by this process never serves stale results; the file
+ * signature catches writers in other processes. Entries are evicted least
+ * recently used first once kDefaultCapacity result lists are held. All
+ * access is serialised by an internal mutex.
+ */
+class RagQueryCache
+{
+public:
+    static constexpr int kDefaultCapacity = 256;
+
+    explicit RagQueryCache(int capacity = kDefaultCapacity);
+
+    /// The process-wide cache used by RagQueryNode.
+    static RagQueryCache& shared();
+
+    /// Counter for @p dbPath, starting at 0 and raised by bumpGeneration().
+    static qint64 generation(const QString& dbPath);
+    /// Marks every cached result for @p dbPath as stale; call after committing changes to the index.
+    static void bumpGeneration(const QString& dbPath);
+
+    static QByteArray makeKey(const QString& dbPath,
+                              const QString& providerId,
+                              const QString& modelId,
+                              const QString& queryText,
+                              int limit,
+                              double minRelevance,
+                              const RagSearchOptions& options);
+
+    /// Copies the cached results for @p key into @p results; false on a miss.
+    bool lookup(const QByteArray& key, std::vector<RagUtils::SearchResult>& results);
+    void insert(const QByteArray& key, std::vector<RagUtils::SearchResult> results);
+
+    void clear();
+    int size() const;
+    qint64 hits() const { return m_hits.load(); }
+    qint64 misses() const { return m_misses.load(); }
+
+private:
+    mutable QMutex m_mutex;
+    QCache<QByteArray, std::vector<RagUtils::SearchResult>> m_entries;
+    std::atomic<qint64> m_hits {0};
+    std::atomic<qint64> m_misses {0};
+};
@@ -5,21 +5,70 @@
 //
 
 #include "RagUtils.h"
+#include "CpuWorkerPool.h"
+#include "GpuVectorScorer.h"
+
+#include "HnswIndex.h"
+#include "Logger.h"
+#include "MetricsRegistry.h"
+#include "RagQueryCache.h"
+#include "SqliteConnectionPool.h"
+#include "VectorFile.h"
+#include "VectorKernels.h"
 
 #include <QtSql/QSqlDatabase>
 #include <QtSql/QSqlQuery>
 #include <QtSql/QSqlError>
+#include <QtCore/QDateTime>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QMap>
+#include <QtCore/QMutex>
+#include <QtCore/QRegularExpression>
+#include <QtCore/QSet>
+#include <QtCore/QThreadPool>
 #include <QtCore/QUuid>
+#include <QtCore/QStringList>
 #include <QtCore/QVariant>
+#include <QtCore/QWaitCondition>
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstdio>
+#include <limits>
+#include <memory>
 #include <stdexcept>
+#include <utility>
 
 using namespace std;
 
 namespace {
 
+// Adds the time until it goes out of scope to cp_rag_search_seconds
+class SearchTimer {
+public:
+    explicit SearchTimer(RagSearchMode mode)
+        : m_histogram(MetricsRegistry::instance().histogram(
+              QStringLiteral("cp_rag_search_seconds"), QStringLiteral("RAG index search time, one per call"),
+              {{QStringLiteral("mode"), mode == RagSearchMode::Vector   ? QStringLiteral("vector")
+                                        : mode == RagSearchMode::Hybrid ? QStringLiteral("hybrid")
+                                                                        : QStringLiteral("keyword_prefilter")}}))
+    {
+        m_elapsed.start();
+    }
+    ~SearchTimer() { m_histogram.observe(m_elapsed.nsecsElapsed() / 1e9); }
+
+    SearchTimer(const SearchTimer&) = delete;
+    SearchTimer& operator=(const SearchTimer&) = delete;
+
+private:
+    MetricsRegistry::Histogram& m_histogram;
+    QElapsedTimer m_elapsed;
+};
+
 vector<float> blobToVectorFloat(const QByteArray& blob)
 {
     vector<float> result;
@@ -38,202 +87,2313 @@ vector<float> blobToVectorFloat(const QByteArray& blob)
     return result;
 }
 
-} // namespace
+bool fragmentsHaveLineColumns(QSqlDatabase& db)
+{
+    const QSet<QString> columns = SqliteConnectionPool::columns(db, QStringLiteral("fragments"));
+    return columns.contains(QStringLiteral("start_line")) && columns.contains(QStringLiteral("end_line"));
+}
 
-RagUtils::IndexConfig RagUtils::getIndexConfig(const QString& dbPath)
+bool tableHasColumn(QSqlDatabase& db, const QString& table, const QString& column)
 {
-    const QString connectionName = QStringLiteral("rag_utils_index_%1").arg(QUuid::createUuid().toString(QUuid::Id128));
-    QVector<QPair<QString, QString>> pairs;
-    QString errorMessage;
-    bool hadError = false;
+    return SqliteConnectionPool::hasColumn(db, table, column);
+}
+
+// The index's embedding encoding; databases from before the column existed are float32
+RagEmbeddingFormat storedEmbeddingFormat(QSqlDatabase& db, QSqlQuery& query)
+{
+    if (tableHasColumn(db, QStringLiteral("source_files"), QStringLiteral("embedding_format"))
+        && query.exec(QStringLiteral("SELECT embedding_format FROM source_files ORDER BY id DESC LIMIT 1"))
+        && query.next()) {
+        return RagUtils::embeddingFormatFromName(query.value(0).toString());
+    }
+    return RagEmbeddingFormat::Float32;
+}
+
+// Inverse of RagUtils::embeddingBlobSize(); 0 when the size fits no embedding
+int embeddingDimension(RagEmbeddingFormat format, int blobSize)
+{
+    switch (format) {
+    case RagEmbeddingFormat::Float16:
+        return blobSize % 2 == 0 ? blobSize / 2 : 0;
+    case RagEmbeddingFormat::Int8:
+        return blobSize > static_cast<int>(sizeof(float)) ? blobSize - static_cast<int>(sizeof(float)) : 0;
+    case RagEmbeddingFormat::Float32:
+        break;
+    }
+    return blobSize % static_cast<int>(sizeof(float)) == 0 ? blobSize / static_cast<int>(sizeof(float)) : 0;
+}
+
+// Ranking used for search results: higher score first, then lower fragment id
+struct ScoredFragment {
+    double score {0.0};
+    qint64 id {0};
+};
+
+bool ranksBefore(const ScoredFragment& lhs, const ScoredFragment& rhs)
+{
+    if (lhs.score == rhs.score) {
+        return lhs.id < rhs.id; // stable deterministic ordering
+    }
+    return lhs.score > rhs.score;
+}
+
+// Bounded top-k: a heap whose front is the worst of the fragments kept so far
+class TopFragments {
+public:
+    explicit TopFragments(int limit) : m_limit(static_cast<size_t>(limit)) { m_heap.reserve(m_limit); }
 
+    void offer(const ScoredFragment& candidate)
     {
-        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
-        db.setDatabaseName(dbPath);
-        if (!db.open()) {
-            errorMessage = QStringLiteral("Failed to open RAG database '%1': %2")
-                               .arg(dbPath, db.lastError().text());
-            hadError = true;
-        } else {
-            QSqlQuery query(db);
-            if (!query.exec(QStringLiteral("SELECT DISTINCT provider, model FROM source_files"))) {
-                errorMessage = QStringLiteral("Failed to query source_files for index configuration: %1")
-                                   .arg(query.lastError().text());
-                hadError = true;
-            } else {
-                while (query.next()) {
-                    const QString provider = query.value(0).toString();
-                    const QString model = query.value(1).toString();
-                    pairs.append(qMakePair(provider, model));
-                }
-            }
+        if (m_heap.size() < m_limit) {
+            m_heap.push_back(candidate);
+            std::push_heap(m_heap.begin(), m_heap.end(), ranksBefore);
+        } else if (ranksBefore(candidate, m_heap.front())) {
+            std::pop_heap(m_heap.begin(), m_heap.end(), ranksBefore);
+            m_heap.back() = candidate;
+            std::push_heap(m_heap.begin(), m_heap.end(), ranksBefore);
+        }
+    }
+
+    /// Kept fragments, best first. Leaves the collector empty.
+    vector<ScoredFragment> takeRanked()
+    {
+        std::sort_heap(m_heap.begin(), m_heap.end(), ranksBefore);
+        return std::move(m_heap);
+    }
+
+private:
+    size_t m_limit;
+    vector<ScoredFragment> m_heap;
+};
+
+// The fragments a RagSearchFilter admits, resolved once per query
+struct FragmentFilter {
+    QString fileIds;             // matching source_files ids, comma-separated for IN (...)
+    QString condition;           // SQL over fragments admitting those files' fragments, shared ones included
+    vector<qint64> fragmentIds;  // ascending
 
-            db.close();
+    bool admits(qint64 id) const { return std::binary_search(fragmentIds.begin(), fragmentIds.end(), id); }
+};
+
+// GLOB pattern matching every path that starts with `prefix`; unlike LIKE, GLOB can use the file_path index
+QString globPrefixPattern(const QString& prefix)
+{
+    QString pattern;
+    pattern.reserve(prefix.size() + 4);
+    for (const QChar c : prefix) {
+        if (c == QLatin1Char('*') || c == QLatin1Char('?') || c == QLatin1Char('[')) {
+            pattern += QLatin1Char('[') + c + QLatin1Char(']');
+        } else {
+            pattern += c;
         }
-        // db and query go out of scope here, before removeDatabase is called.
     }
+    return pattern + QLatin1Char('*');
+}
 
-    // Now that all QSqlDatabase and QSqlQuery instances using this connection
-    // have gone out of scope, it is safe to remove the connection.
-    QSqlDatabase::removeDatabase(connectionName);
+// Looks up the files a filter admits, then their fragments through idx_fragments_file_id
+bool resolveFilter(QSqlDatabase& db,
+                   QSqlQuery& query,
+                   const RagSearchFilter& filter,
+                   FragmentFilter& resolved,
+                   QString& errorMessage)
+{
+    // Metadata that is not valid JSON matches no tag or field rather than failing the query
+    static const QString validMetadata = QStringLiteral("CASE WHEN json_valid(metadata) THEN metadata END");
 
-    if (hadError) {
-        throw std::runtime_error(errorMessage.toStdString());
+    QStringList where;
+    QVariantList binds;
+    if (!filter.pathPrefix.isEmpty()) {
+        where.append(QStringLiteral("file_path GLOB ?"));
+        binds.append(globPrefixPattern(filter.pathPrefix));
+    }
+    if (!filter.fileTypes.isEmpty()) {
+        // Databases the indexer has not migrated yet get the same value computed inline
+        const QString column = SqliteConnectionPool::hasColumn(db, QStringLiteral("source_files"), QStringLiteral("file_type"))
+            ? QStringLiteral("file_type")
+            : QStringLiteral("(%1)").arg(QString::fromLatin1(kRagSourceFileTypeExpression));
+        QStringList placeholders;
+        for (const QString& type : filter.fileTypes) {
+            placeholders.append(QStringLiteral("?"));
+            binds.append(type.toLower());
+        }
+        where.append(QStringLiteral("%1 IN (%2)").arg(column, placeholders.join(QLatin1Char(','))));
+    }
+    for (const QString& tag : filter.tags) {
+        where.append(QStringLiteral("EXISTS (SELECT 1 FROM json_each(%1, '$.tags') WHERE value = ?)").arg(validMetadata));
+        binds.append(tag);
+    }
+    for (auto it = filter.metadata.cbegin(); it != filter.metadata.cend(); ++it) {
+        where.append(QStringLiteral("CAST(json_extract(%1, ?) AS TEXT) = ?").arg(validMetadata));
+        binds.append(QStringLiteral("$.\"%1\"").arg(it.key()));
+        binds.append(it.value());
     }
 
-    if (pairs.isEmpty()) {
-        throw std::runtime_error("RAG index is empty; no source_files rows found");
+    query.prepare(QStringLiteral("SELECT id FROM source_files WHERE %1").arg(where.join(QStringLiteral(" AND "))));
+    for (const QVariant& value : binds) {
+        query.addBindValue(value);
+    }
+    if (!query.exec()) {
+        errorMessage = QStringLiteral("Failed to apply the search filter: %1").arg(query.lastError().text());
+        return false;
+    }
+    QStringList fileIds;
+    while (query.next()) {
+        fileIds.append(query.value(0).toString());
+    }
+    resolved.fileIds = fileIds.join(QLatin1Char(','));
+    resolved.fragmentIds.clear();
+    // A deduplicated fragment belongs to every file listed for it in fragment_sources
+    resolved.condition = SqliteConnectionPool::hasColumn(db, QStringLiteral("fragment_sources"), QStringLiteral("fragment_id"))
+        ? QStringLiteral("(file_id IN (%1) OR id IN (SELECT fragment_id FROM fragment_sources WHERE file_id IN (%1)))")
+              .arg(resolved.fileIds)
+        : QStringLiteral("file_id IN (%1)").arg(resolved.fileIds);
+    if (fileIds.isEmpty()) {
+        return true;
     }
 
-    if (pairs.size() > 1) {
-        throw std::runtime_error("Mixed-model RAG is not supported: multiple provider/model pairs found in source_files");
+    if (!query.exec(QStringLiteral("SELECT id FROM fragments WHERE %1").arg(resolved.condition))) {
+        errorMessage = QStringLiteral("Failed to read the fragments of filtered files: %1").arg(query.lastError().text());
+        return false;
+    }
+    while (query.next()) {
+        resolved.fragmentIds.push_back(query.value(0).toLongLong());
     }
+    std::sort(resolved.fragmentIds.begin(), resolved.fragmentIds.end());
+    return true;
+}
 
-    IndexConfig cfg;
-    cfg.providerId = pairs.first().first;
-    cfg.modelId = pairs.first().second;
-    return cfg;
+// resolveFilter() over a pooled connection; throws std::runtime_error on failure
+std::shared_ptr<const FragmentFilter> loadFilter(const QString& dbPath, const RagSearchFilter& filter)
+{
+    auto resolved = std::make_shared<FragmentFilter>();
+    QString errorMessage;
+    {
+        QString openError;
+        QSqlDatabase db = SqliteConnectionPool::connection(dbPath, &openError);
+        if (!db.isOpen()) {
+            errorMessage = QStringLiteral("Failed to open RAG database '%1': %2").arg(dbPath, openError);
+        } else {
+            QSqlQuery query(db);
+            query.setForwardOnly(true);
+            resolveFilter(db, query, filter, *resolved, errorMessage);
+        }
+    }
+    if (!errorMessage.isEmpty()) {
+        throw std::runtime_error(errorMessage.toStdString());
+    }
+    return resolved;
 }
 
-double RagUtils::cosineSimilarity(const vector<float>& a, const vector<float>& b)
+int embeddingsVersion(QSqlQuery& query)
 {
-    if (a.empty() || b.empty() || a.size() != b.size()) {
-        return 0.0;
+    if (query.exec(QStringLiteral("PRAGMA user_version")) && query.next()) {
+        return query.value(0).toInt();
     }
+    return 0;
+}
 
-    double dot = 0.0;
-    double normA = 0.0;
-    double normB = 0.0;
+// Scores stored embedding blobs in place against one query vector. With a positive
+// scoredDimensions below the query's size only that prefix of each full-size blob is
+// read, against the query's prefix rescaled to unit length: a coarse Matryoshka score.
+class EmbeddingScorer {
+public:
+    EmbeddingScorer(const vector<float>& queryEmbedding,
+                    bool storedNormalized,
+                    RagEmbeddingFormat format,
+                    int scoredDimensions = 0)
+        : m_query(queryEmbedding)
+        , m_storedNormalized(storedNormalized)
+        , m_format(format)
+        , m_float32Bytes(RagUtils::embeddingBlobSize(RagEmbeddingFormat::Float32, static_cast<int>(queryEmbedding.size())))
+        , m_quantisedBytes(RagUtils::embeddingBlobSize(format, static_cast<int>(queryEmbedding.size())))
+    {
+        if (scoredDimensions > 0 && static_cast<size_t>(scoredDimensions) < m_query.size()) {
+            m_query.resize(static_cast<size_t>(scoredDimensions));
+        }
+        VectorKernels::normalize(m_query);
+    }
 
-    for (size_t i = 0; i < a.size(); ++i) {
-        const double va = a[i];
-        const double vb = b[i];
-        dot += va * vb;
-        normA += va * va;
-        normB += vb * vb;
+    /// Cosine similarity of a stored embedding; false when the blob does not match the query's dimension.
+    bool score(const QByteArray& blob, double& result) const
+    {
+        return score(blob.constData(), blob.size(), result);
     }
 
-    if (normA == 0.0 || normB == 0.0) {
-        return 0.0;
+    bool score(const char* data, int size, double& result) const
+    {
+        if (size == m_float32Bytes) {
+            const double dot = VectorKernels::dot(m_query.data(), data, m_query.size());
+            if (m_storedNormalized) {
+                result = dot;
+                return true;
+            }
+            // Legacy database: the stored vector still needs its norm
+            const double normSquared = VectorKernels::dot(data, data, m_query.size());
+            result = normSquared > 0.0 ? dot / std::sqrt(normSquared) : 0.0;
+            return true;
+        }
+        if (size != m_quantisedBytes) {
+            return false;
+        }
+        // Quantised vectors were normalised before encoding
+        if (m_format == RagEmbeddingFormat::Float16) {
+            result = VectorKernels::dotHalf(m_query.data(), data, m_query.size());
+            return true;
+        }
+        if (m_format == RagEmbeddingFormat::Int8) {
+            float scale = 0.0f;
+            memcpy(&scale, data, sizeof(scale));
+            result = static_cast<double>(scale) * VectorKernels::dotInt8(m_query.data(), data + sizeof(scale), m_query.size());
+            return true;
+        }
+        return false;
     }
 
-    const double denom = std::sqrt(normA) * std::sqrt(normB);
-    if (denom == 0.0) {
-        return 0.0;
+private:
+    vector<float> m_query;
+    bool m_storedNormalized;
+    RagEmbeddingFormat m_format;
+    int m_float32Bytes;
+    int m_quantisedBytes;
+};
+
+// Queries scored in one pass over the rows. Rows are buffered in blocks of kRowBlock
+// and each query is scored against a whole block while it is still in cache, so a large
+// batch streams the index once instead of once per query. Each query keeps its own
+// top-k heap; call flush() before reading them.
+class QueryBatch {
+public:
+    static constexpr size_t kRowBlock = 64;
+
+    QueryBatch(const vector<vector<float>>& queries,
+               bool storedNormalized,
+               RagEmbeddingFormat format,
+               int candidates,
+               double minRelevance,
+               int scoredDimensions = 0)
+        : m_tops(queries.size(), TopFragments(candidates))
+        , m_candidates(candidates)
+        , m_minRelevance(minRelevance)
+    {
+        m_scorers.reserve(queries.size());
+        for (const vector<float>& query : queries) {
+            m_scorers.emplace_back(query, storedNormalized, format, scoredDimensions);
+        }
     }
 
-    return dot / denom;
-}
+    /// The same queries with empty heaps, for another thread to fill
+    QueryBatch emptyCopy() const { return QueryBatch(m_scorers, m_candidates, m_minRelevance); }
 
-std::vector<RagUtils::SearchResult> RagUtils::findMostRelevantChunks(
-    const QString& dbPath,
-    const std::vector<float>& queryEmbedding,
-    int limit,
-    double minRelevance)
+    size_t size() const { return m_scorers.size(); }
+    int candidates() const { return m_candidates; }
+    const EmbeddingScorer& scorer(size_t index) const { return m_scorers[index]; }
+    TopFragments& top(size_t index) { return m_tops[index]; }
+
+    /// Queues a row for every query; @p data must stay valid until the next flush().
+    void offer(qint64 id, const char* data, int size)
+    {
+        m_block.push_back(Row {id, data, size, {}});
+        if (m_block.size() >= kRowBlock) {
+            flush();
+        }
+    }
+
+    void offer(qint64 id, const QByteArray& blob)
+    {
+        m_block.push_back(Row {id, blob.constData(), static_cast<int>(blob.size()), blob});
+        if (m_block.size() >= kRowBlock) {
+            flush();
+        }
+    }
+
+    /// Scores a row for one query alone, e.g. that query's own ANN candidates.
+    void offerTo(size_t index, qint64 id, const char* data, int size)
+    {
+        double score = 0.0;
+        if (m_scorers[index].score(data, size, score) && score >= m_minRelevance) {
+            m_tops[index].offer(ScoredFragment {score, id});
+        }
+    }
+
+    void flush()
+    {
+        for (size_t i = 0; i < m_scorers.size(); ++i) {
+            for (const Row& row : m_block) {
+                offerTo(i, row.id, row.data, row.size);
+            }
+        }
+        m_block.clear();
+    }
+
+    /// Moves every fragment @p other kept into this batch's heaps.
+    void merge(QueryBatch& other)
+    {
+        other.flush();
+        for (size_t i = 0; i < m_tops.size(); ++i) {
+            for (const ScoredFragment& fragment : other.m_tops[i].takeRanked()) {
+                m_tops[i].offer(fragment);
+            }
+        }
+    }
+
+private:
+    struct Row {
+        qint64 id;
+        const char* data;
+        int size;
+        QByteArray blob; // keeps an SQLite row's data alive until the flush
+    };
+
+    QueryBatch(const vector<EmbeddingScorer>& scorers, int candidates, double minRelevance)
+        : m_scorers(scorers)
+        , m_tops(scorers.size(), TopFragments(candidates))
+        , m_candidates(candidates)
+        , m_minRelevance(minRelevance)
+    {
+    }
+
+    vector<EmbeddingScorer> m_scorers;
+    vector<TopFragments> m_tops;
+    int m_candidates;
+    double m_minRelevance;
+    vector<Row> m_block;
+};
+
+// Scores every (id, embedding) row an executed query returns. Only ids and scores
+// are kept; content is fetched later for the winners alone.
+void scoreRows(QSqlQuery& query, QueryBatch& batch)
 {
-    std::vector<SearchResult> results;
+    while (query.next()) {
+        batch.offer(query.value(0).toLongLong(), query.value(1).toByteArray());
+    }
+    batch.flush();
+}
 
-    if (limit <= 0) {
-        return results;
+// Scores the live rows of a mapped vector file with ids in [first, last], only the admitted ones when filtered
+void scoreSlots(const VectorFile& vectors,
+                qint64 first,
+                qint64 last,
+                QueryBatch& batch,
+                const FragmentFilter* filter = nullptr)
+{
+    auto scoreSlot = [&](qint64 id) {
+        if (const char* row = vectors.row(id)) {
+            batch.offer(id, row, vectors.rowBytes());
+        }
+    };
+    first = std::max<qint64>(first, 1);
+    if (filter) {
+        const auto end = std::upper_bound(filter->fragmentIds.begin(), filter->fragmentIds.end(), last);
+        for (auto it = std::lower_bound(filter->fragmentIds.begin(), end, first); it != end; ++it) {
+            scoreSlot(*it);
+        }
+    } else {
+        for (qint64 id = first; id <= last; ++id) {
+            scoreSlot(id);
+        }
     }
+    batch.flush();
+}
 
-    if (queryEmbedding.empty()) {
-        return results;
+// Exact scan of the ids in (after, last], cut into shards that the calling thread and
+// any helper tasks claim in turn. Rows the vector file covers are scored from the
+// mapping. The rest are read over each participant's own pooled connection, since a
+// QSqlDatabase may only be used by the thread that created it. Helpers that
+// start after the shards have run out return at once, so the caller never waits on a
+// pool thread that has not started.
+class ShardedScan : public std::enable_shared_from_this<ShardedScan> {
+public:
+    ShardedScan(QString dbPath,
+                std::shared_ptr<const VectorFile> vectors,
+                std::shared_ptr<const FragmentFilter> filter,
+                const QueryBatch& queries,
+                qint64 after,
+                qint64 last,
+                qint64 shardCount)
+        : m_dbPath(std::move(dbPath))
+        , m_vectors(std::move(vectors))
+        , m_filter(std::move(filter))
+        , m_queries(queries.emptyCopy())
+        , m_after(after)
+        , m_last(last)
+        , m_shardCount(std::max<qint64>(1, shardCount))
+        , m_shardSize((last - after + m_shardCount - 1) / m_shardCount)
+        , m_merged(queries.emptyCopy())
+    {
     }
 
-    const QString connectionName = QStringLiteral("rag_utils_search_%1").arg(QUuid::createUuid().toString(QUuid::Id128));
-    QString errorMessage;
-    bool hadError = false;
+    /// Scans every shard with up to @p helpers extra tasks on @p pool and merges the winners into @p batch.
+    bool run(QThreadPool* pool, int helpers, QueryBatch& batch, QString& errorMessage)
+    {
+        for (int i = 0; i < helpers; ++i) {
+            pool->start([self = shared_from_this()]() { self->participate(); });
+        }
+        participate();
+
+        QMutexLocker locker(&m_mutex);
+        while (m_active > 0) {
+            m_finished.wait(&m_mutex);
+        }
+        batch.merge(m_merged);
+        errorMessage = m_error;
+        return m_error.isEmpty();
+    }
 
+private:
+    void participate()
     {
-        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
-        db.setDatabaseName(dbPath);
-        if (!db.open()) {
-            errorMessage = QStringLiteral("Failed to open RAG database '%1': %2")
-                               .arg(dbPath, db.lastError().text());
-            hadError = true;
-        } else {
-            QSqlQuery query(db);
-            bool hasLineColumns = false;
-            if (query.exec(QStringLiteral("PRAGMA table_info(fragments)"))) {
-                bool hasStartLine = false;
-                bool hasEndLine = false;
-                while (query.next()) {
-                    const QString name = query.value(1).toString();
-                    hasStartLine = hasStartLine || name == QStringLiteral("start_line");
-                    hasEndLine = hasEndLine || name == QStringLiteral("end_line");
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_nextShard.load() >= m_shardCount) {
+                return;
+            }
+            ++m_active;
+        }
+
+        QueryBatch local = m_queries.emptyCopy();
+        QString error;
+        {
+            QSqlDatabase db;
+            std::unique_ptr<QSqlQuery> query;
+            for (qint64 shard = m_nextShard.fetch_add(1); shard < m_shardCount && error.isEmpty();
+                 shard = m_nextShard.fetch_add(1)) {
+                const qint64 first = m_after + 1 + shard * m_shardSize;
+                const qint64 last = std::min(m_last, first + m_shardSize - 1);
+                qint64 sqlFirst = first;
+                if (m_vectors && first <= m_vectors->maxId()) {
+                    const qint64 mapped = std::min(last, m_vectors->maxId());
+                    scoreSlots(*m_vectors, first, mapped, local, m_filter.get());
+                    sqlFirst = mapped + 1;
+                }
+                if (sqlFirst > last) {
+                    continue;
+                }
+
+                if (!query) {
+                    QString openError;
+                    db = SqliteConnectionPool::connection(m_dbPath, &openError);
+                    if (!db.isOpen()) {
+                        error = QStringLiteral("Failed to open RAG database '%1': %2").arg(m_dbPath, openError);
+                        break;
+                    }
+                    query = std::make_unique<QSqlQuery>(db);
+                    query->setForwardOnly(true);
                 }
-                hasLineColumns = hasStartLine && hasEndLine;
+                query->prepare(m_filter
+                    ? QStringLiteral("SELECT id, embedding FROM fragments WHERE id >= ? AND id <= ? AND %1")
+                          .arg(m_filter->condition)
+                    : QStringLiteral("SELECT id, embedding FROM fragments WHERE id >= ? AND id <= ?"));
+                query->addBindValue(sqlFirst);
+                query->addBindValue(last);
+                if (!query->exec()) {
+                    error = QStringLiteral("Failed to query fragments for similarity search: %1")
+                                .arg(query->lastError().text());
+                    break;
+                }
+                scoreRows(*query, local);
             }
+        }
 
-            const QString selectSql = hasLineColumns
-                ? QStringLiteral(
-                    "SELECT id, file_id, chunk_index, "
-                    "COALESCE(start_line, 0), COALESCE(end_line, 0), "
-                    "content, embedding FROM fragments")
-                : QStringLiteral(
-                    "SELECT id, file_id, chunk_index, "
-                    "0, 0, content, embedding FROM fragments");
+        QMutexLocker locker(&m_mutex);
+        m_merged.merge(local);
+        if (!error.isEmpty() && m_error.isEmpty()) {
+            m_error = error;
+            m_nextShard.store(m_shardCount); // nobody claims further shards
+        }
+        if (--m_active == 0) {
+            m_finished.wakeAll();
+        }
+    }
 
-            if (!query.exec(selectSql)) {
-                errorMessage = QStringLiteral("Failed to query fragments for similarity search: %1")
-                                   .arg(query.lastError().text());
-                hadError = true;
-            } else {
-                while (query.next()) {
-                    const qint64 fragmentId = query.value(0).toLongLong();
-                    const qint64 fileId = query.value(1).toLongLong();
-                    const int chunkIndex = query.value(2).toInt();
-                    const int startLine = query.value(3).toInt();
-                    const int endLine = query.value(4).toInt();
-                    const QString content = query.value(5).toString();
-                    const QByteArray embeddingBlob = query.value(6).toByteArray();
+    const QString m_dbPath;
+    const std::shared_ptr<const VectorFile> m_vectors;
+    const std::shared_ptr<const FragmentFilter> m_filter;
+    const QueryBatch m_queries;
+    const qint64 m_after;
+    const qint64 m_last;
+    const qint64 m_shardCount;
+    const qint64 m_shardSize;
+    std::atomic<qint64> m_nextShard {0};
 
-                    const vector<float> embeddingVec = blobToVectorFloat(embeddingBlob);
-                    if (embeddingVec.empty() || embeddingVec.size() != queryEmbedding.size()) {
-                        continue; // skip malformed or incompatible embeddings
-                    }
+    QMutex m_mutex;
+    QWaitCondition m_finished;
+    int m_active {0};
+    QueryBatch m_merged;
+    QString m_error;
+};
 
-                    const double score = cosineSimilarity(queryEmbedding, embeddingVec);
-                    if (score < minRelevance) {
-                        continue;
-                    }
+// Replaces first-pass scores with exact ones from each fragment's `column` (the float32
+// copies after a quantised pass, the embeddings themselves after a coarse one), keeping the best `limit`
+bool rescoreFragments(QSqlQuery& query,
+                      const QString& column,
+                      const EmbeddingScorer& scorer,
+                      double minRelevance,
+                      int limit,
+                      vector<ScoredFragment>& ranked,
+                      QString& errorMessage)
+{
+    if (ranked.empty()) {
+        return true;
+    }
+
+    QStringList ids;
+    ids.reserve(static_cast<int>(ranked.size()));
+    for (const ScoredFragment& fragment : ranked) {
+        ids.append(QString::number(fragment.id));
+    }
+    if (!query.exec(QStringLiteral("SELECT id, %1 FROM fragments WHERE id IN (%2)")
+                        .arg(column, ids.join(QLatin1Char(','))))) {
+        errorMessage = QStringLiteral("Failed to read embeddings for rescoring: %1")
+                           .arg(query.lastError().text());
+        return false;
+    }
+
+    QHash<qint64, double> exact;
+    exact.reserve(static_cast<int>(ranked.size()));
+    while (query.next()) {
+        double score = 0.0;
+        if (scorer.score(query.value(1).toByteArray(), score)) {
+            exact.insert(query.value(0).toLongLong(), score);
+        }
+    }
+
+    TopFragments top(limit);
+    for (const ScoredFragment& fragment : ranked) {
+        // Fragments without a copy keep their first-pass score
+        const double score = exact.value(fragment.id, fragment.score);
+        if (score >= minRelevance) {
+            top.offer(ScoredFragment {score, fragment.id});
+        }
+    }
+    ranked = top.takeRanked();
+    return true;
+}
+
+// Fetches content, line range and file path for the ranked fragments in one query.
+// The ids travel as one JSON array binding, so the statement text never changes
+// and the pooled connection keeps it prepared.
+bool fetchResults(QSqlDatabase& db,
+                  const vector<ScoredFragment>& ranked,
+                  vector<RagUtils::SearchResult>& results,
+                  QString& errorMessage)
+{
+    if (ranked.empty()) {
+        return true;
+    }
+
+    QByteArray ids;
+    ids.reserve(static_cast<qsizetype>(ranked.size()) * 8 + 2);
+    ids.append('[');
+    for (const ScoredFragment& fragment : ranked) {
+        if (ids.size() > 1) {
+            ids.append(',');
+        }
+        ids.append(QByteArray::number(fragment.id));
+    }
+    ids.append(']');
+
+    static const QString withLines = QStringLiteral(
+        "SELECT f.id, f.file_id, f.chunk_index, COALESCE(f.start_line, 0), COALESCE(f.end_line, 0), "
+        "f.content, s.file_path "
+        "FROM fragments f LEFT JOIN source_files s ON s.id = f.file_id "
+        "WHERE f.id IN (SELECT value FROM json_each(?))");
+    static const QString withoutLines = QStringLiteral(
+        "SELECT f.id, f.file_id, f.chunk_index, 0, 0, f.content, s.file_path "
+        "FROM fragments f LEFT JOIN source_files s ON s.id = f.file_id "
+        "WHERE f.id IN (SELECT value FROM json_each(?))");
+    QSqlQuery query = SqliteConnectionPool::statement(db, fragmentsHaveLineColumns(db) ? withLines : withoutLines);
+    query.addBindValue(QString::fromLatin1(ids));
+    if (!query.exec()) {
+        errorMessage = QStringLiteral("Failed to fetch fragments for similarity search: %1")
+                           .arg(query.lastError().text());
+        return false;
+    }
+
+    QHash<qint64, RagUtils::SearchResult> byId;
+    byId.reserve(static_cast<int>(ranked.size()));
+    while (query.next()) {
+        RagUtils::SearchResult sr;
+        sr.fragmentId = query.value(0).toLongLong();
+        sr.fileId = query.value(1).toLongLong();
+        sr.chunkIndex = query.value(2).toInt();
+        sr.startLine = query.value(3).toInt();
+        sr.endLine = query.value(4).toInt();
+        sr.content = query.value(5).toString();
+        sr.filePath = query.value(6).toString();
+        byId.insert(sr.fragmentId, std::move(sr));
+    }
+    // Releases the read snapshot while the statement stays prepared
+    query.finish();
 
-                    SearchResult sr;
-                    sr.fragmentId = fragmentId;
-                    sr.fileId = fileId;
-                    sr.chunkIndex = chunkIndex;
-                    sr.startLine = startLine;
-                    sr.endLine = endLine;
-                    sr.content = content;
-                    sr.score = score;
-                    results.push_back(std::move(sr));
+    if (SqliteConnectionPool::hasColumn(db, QStringLiteral("fragment_sources"), QStringLiteral("fragment_id"))) {
+        static const QString duplicates = QStringLiteral(
+            "SELECT d.fragment_id, s.file_path FROM fragment_sources d JOIN source_files s ON s.id = d.file_id "
+            "WHERE d.fragment_id IN (SELECT value FROM json_each(?)) ORDER BY d.id");
+        QSqlQuery duplicateQuery = SqliteConnectionPool::statement(db, duplicates);
+        duplicateQuery.addBindValue(QString::fromLatin1(ids));
+        if (duplicateQuery.exec()) {
+            while (duplicateQuery.next()) {
+                const auto it = byId.find(duplicateQuery.value(0).toLongLong());
+                if (it != byId.end()) {
+                    it->duplicatePaths.append(duplicateQuery.value(1).toString());
                 }
             }
+        }
+        duplicateQuery.finish();
+    }
 
-            db.close();
+    results.reserve(ranked.size());
+    for (const ScoredFragment& fragment : ranked) {
+        auto it = byId.find(fragment.id);
+        if (it == byId.end()) {
+            continue; // deleted between the scan and the fetch
         }
-        // db and query go out of scope here, before removeDatabase is called.
+        it->score = fragment.score;
+        results.push_back(std::move(*it));
     }
+    return true;
+}
 
-    // Now that all QSqlDatabase and QSqlQuery instances using this connection
-    // have gone out of scope, it is safe to remove the connection.
-    QSqlDatabase::removeDatabase(connectionName);
+// Loaded sidecar indexes, reused until the file on disk changes
+struct LoadedAnnIndex {
+    std::shared_ptr<const HnswIndex> index;
+    QDateTime modified;
+    qint64 size {0};
+};
 
-    if (hadError) {
-        throw std::runtime_error(errorMessage.toStdString());
+QMutex g_annIndexMutex;
+QHash<QString, LoadedAnnIndex> g_annIndexes;
+
+void rememberAnnIndex(const QString& path, std::shared_ptr<const HnswIndex> index)
+{
+    const QFileInfo info(path);
+    QMutexLocker locker(&g_annIndexMutex);
+    g_annIndexes.insert(path, LoadedAnnIndex {std::move(index), info.lastModified(), info.size()});
+}
+
+std::shared_ptr<const HnswIndex> loadedAnnIndex(const QString& path)
+{
+    const QFileInfo info(path);
+    QMutexLocker locker(&g_annIndexMutex);
+    if (!info.exists()) {
+        g_annIndexes.remove(path);
+        return nullptr;
     }
 
-    std::sort(results.begin(), results.end(), [](const SearchResult& lhs, const SearchResult& rhs) {
-        if (lhs.score == rhs.score) {
-            return lhs.fragmentId < rhs.fragmentId; // stable deterministic ordering
-        }
-        return lhs.score > rhs.score;
-    });
+    const auto it = g_annIndexes.constFind(path);
+    if (it != g_annIndexes.constEnd() && it->modified == info.lastModified() && it->size == info.size()) {
+        return it->index;
+    }
 
-    if (static_cast<int>(results.size()) > limit) {
-        results.resize(limit);
+    QString error;
+    std::shared_ptr<const HnswIndex> index = HnswIndex::load(path, &error);
+    if (!index) {
+        CP_WARN << "RagUtils: ignoring unreadable ANN index" << path << "-" << error;
+        g_annIndexes.remove(path);
+        return nullptr;
     }
+    g_annIndexes.insert(path, LoadedAnnIndex {index, info.lastModified(), info.size()});
+    return index;
+}
 
-    return results;
+// Mapped vector files, likewise reused until the file changes
+struct LoadedVectorFile {
+    std::shared_ptr<const VectorFile> file;
+    QDateTime modified;
+    qint64 size {0};
+};
+
+QMutex g_vectorFileMutex;
+QHash<QString, LoadedVectorFile> g_vectorFiles;
+
+// Vector files copied to the GPU, kept as long as the mapping they were copied from is current.
+// A failed upload is remembered too, so it is not retried until the file changes.
+struct ResidentVectorFile {
+    std::shared_ptr<const VectorFile> file;
+    std::shared_ptr<const GpuVectorScorer> scorer;
+};
+
+QMutex g_gpuMutex;
+QHash<QString, ResidentVectorFile> g_gpuVectorFiles;
+
+// Index configurations, reused until the index's generation or the database or its WAL changes
+struct LoadedIndexConfig {
+    RagUtils::IndexConfig config;
+    QString stamp;
+};
+
+QMutex g_indexConfigMutex;
+QHash<QString, LoadedIndexConfig> g_indexConfigs;
+// Stamp each index was last warmed at, so warming it again before it changes costs nothing
+QHash<QString, QString> g_warmedIndexes;
+
+QString indexConfigStamp(const QString& dbPath)
+{
+    const QFileInfo database(dbPath);
+    const QFileInfo wal(dbPath + QStringLiteral("-wal"));
+    return QStringLiteral("%1:%2:%3:%4:%5")
+        .arg(RagQueryCache::generation(dbPath))
+        .arg(database.size())
+        .arg(database.lastModified().toMSecsSinceEpoch())
+        .arg(wal.exists() ? wal.size() : -1)
+        .arg(wal.exists() ? wal.lastModified().toMSecsSinceEpoch() : 0);
+}
+
+void forgetVectorFile(const QString& path)
+{
+    {
+        QMutexLocker locker(&g_gpuMutex);
+        g_gpuVectorFiles.remove(path);
+    }
+    QMutexLocker locker(&g_vectorFileMutex);
+    g_vectorFiles.remove(path);
+}
+
+std::shared_ptr<const VectorFile> loadedVectorFile(const QString& path)
+{
+    const QFileInfo info(path);
+    QMutexLocker locker(&g_vectorFileMutex);
+    if (!info.exists()) {
+        g_vectorFiles.remove(path);
+        return nullptr;
+    }
+
+    const auto it = g_vectorFiles.constFind(path);
+    if (it != g_vectorFiles.constEnd() && it->modified == info.lastModified() && it->size == info.size()) {
+        return it->file;
+    }
+
+    QString error;
+    std::shared_ptr<const VectorFile> file = VectorFile::open(path, &error);
+    if (!file) {
+        // An update in progress marks the file dirty. It only appends rows and each mapping keeps its
+        // own tombstones, so the generation mapped before stays readable; searches read newer rows from SQLite.
+        if (it != g_vectorFiles.constEnd()) {
+            return it->file;
+        }
+        CP_WARN << "RagUtils: ignoring unreadable vector file" << path << "-" << error;
+        return nullptr;
+    }
+    g_vectorFiles.insert(path, LoadedVectorFile {file, info.lastModified(), info.size()});
+    return file;
+}
+
+// Replaces the mapped generation once an update has committed; searches still holding the old one finish on it
+void publishVectorFile(const QString& path)
+{
+    QString error;
+    std::shared_ptr<const VectorFile> file = VectorFile::open(path, &error);
+    if (!file) {
+        CP_WARN << "RagUtils: cannot map updated vector file" << path << "-" << error;
+        forgetVectorFile(path);
+        return;
+    }
+    const QFileInfo info(path);
+    QMutexLocker locker(&g_vectorFileMutex);
+    g_vectorFiles.insert(path, LoadedVectorFile {std::move(file), info.lastModified(), info.size()});
+}
+
+// Moves a fully written file over @p to. On POSIX the rename is atomic and readers that
+// have the old file open or mapped keep it; elsewhere the old file is removed first.
+bool replaceFile(const QString& from, const QString& to)
+{
+    if (std::rename(QFile::encodeName(from).constData(), QFile::encodeName(to).constData()) == 0) {
+        return true;
+    }
+    return QFile::remove(to) && QFile::rename(from, to);
+}
+
+// Whether an exact scan of @p vectors is big enough to be worth the GPU
+bool suitsGpu(const VectorFile& vectors)
+{
+    return vectors.liveCount() >= RagUtils::kMinGpuFragments && vectors.dimension() <= GpuVectorScorer::kMaxDimension
+           && GpuVectorScorer::isAvailable();
+}
+
+std::shared_ptr<const GpuVectorScorer> residentGpuScorer(const QString& path,
+                                                         const std::shared_ptr<const VectorFile>& vectors)
+{
+    // Held across the upload, so concurrent first searches copy the file once
+    QMutexLocker locker(&g_gpuMutex);
+    const auto it = g_gpuVectorFiles.constFind(path);
+    if (it != g_gpuVectorFiles.constEnd() && it->file == vectors) {
+        return it->scorer;
+    }
+    // Free the old copy before making room for the new one
+    g_gpuVectorFiles.remove(path);
+
+    QString error;
+    std::shared_ptr<const GpuVectorScorer> scorer = GpuVectorScorer::create(*vectors, &error);
+    if (!scorer) {
+        CP_WARN << "RagUtils: scoring" << path << "on the CPU; GPU upload failed -" << error;
+    }
+    g_gpuVectorFiles.insert(path, ResidentVectorFile {vectors, scorer});
+    return scorer;
+}
+
+// Ranks every row of the uploaded vector file on the device and re-scores each query's
+// candidates from the mapping, as the CPU scan would have scored them
+bool scoreOnGpu(const GpuVectorScorer& scorer,
+                const VectorFile& vectors,
+                const vector<vector<float>>& queries,
+                QueryBatch& batch)
+{
+    vector<vector<float>> normalized = queries;
+    for (vector<float>& query : normalized) {
+        VectorKernels::normalize(query);
+    }
+    vector<vector<GpuVectorScorer::Hit>> hits;
+    QString error;
+    if (!scorer.search(normalized, batch.candidates(), hits, &error)) {
+        CP_WARN << "RagUtils: GPU search failed, scanning on the CPU -" << error;
+        return false;
+    }
+    for (size_t i = 0; i < hits.size(); ++i) {
+        for (const GpuVectorScorer::Hit& hit : hits[i]) {
+            if (const char* row = vectors.row(hit.id)) {
+                batch.offerTo(i, hit.id, row, vectors.rowBytes());
+            }
+        }
+    }
+    MetricsRegistry::instance()
+        .counter(QStringLiteral("cp_rag_gpu_searches_total"), QStringLiteral("Exact RAG scans ranked on the GPU"))
+        .increment(static_cast<quint64>(queries.size()));
+    return true;
+}
+
+bool hasFullTextIndex(QSqlQuery& query)
+{
+    return query.exec(QStringLiteral("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'fragments_fts'"))
+        && query.next();
+}
+
+// Fragment ids matching an FTS5 expression, best BM25 rank first
+bool lexicalCandidates(QSqlQuery& query,
+                       const QString& match,
+                       int count,
+                       const FragmentFilter* filter,
+                       vector<qint64>& ids,
+                       QString& errorMessage)
+{
+    query.prepare(filter
+        ? QStringLiteral("SELECT rowid FROM fragments_fts WHERE fragments_fts MATCH ? "
+                         "AND rowid IN (SELECT id FROM fragments WHERE %1) ORDER BY rank LIMIT ?")
+              .arg(filter->condition)
+        : QStringLiteral("SELECT rowid FROM fragments_fts WHERE fragments_fts MATCH ? ORDER BY rank LIMIT ?"));
+    query.addBindValue(match);
+    query.addBindValue(count);
+    if (!query.exec()) {
+        errorMessage = QStringLiteral("Failed to query the full-text index: %1").arg(query.lastError().text());
+        return false;
+    }
+    while (query.next()) {
+        ids.push_back(query.value(0).toLongLong());
+    }
+    return true;
+}
+
+// Scores the embeddings of the given fragments, however low, and fetches them best first
+bool scoreCandidates(QSqlDatabase& db,
+                     QSqlQuery& query,
+                     const vector<float>& queryEmbedding,
+                     const vector<qint64>& ids,
+                     vector<RagUtils::SearchResult>& results,
+                     QString& errorMessage)
+{
+    if (ids.empty()) {
+        return true;
+    }
+    const RagEmbeddingFormat format = storedEmbeddingFormat(db, query);
+    QueryBatch batch({queryEmbedding}, embeddingsVersion(query) >= kRagNormalizedEmbeddingsVersion, format,
+                     static_cast<int>(ids.size()), -std::numeric_limits<double>::infinity());
+
+    QStringList idList;
+    idList.reserve(static_cast<int>(ids.size()));
+    for (const qint64 id : ids) {
+        idList.append(QString::number(id));
+    }
+    if (!query.exec(QStringLiteral("SELECT id, embedding FROM fragments WHERE id IN (%1)")
+                        .arg(idList.join(QLatin1Char(','))))) {
+        errorMessage = QStringLiteral("Failed to query fragments for keyword candidates: %1")
+                           .arg(query.lastError().text());
+        return false;
+    }
+    scoreRows(query, batch);
+    return fetchResults(db, batch.top(0).takeRanked(), results, errorMessage);
+}
+
+// Hybrid and KeywordPrefilter modes: fuse the vector and BM25 rankings by reciprocal rank
+std::vector<RagUtils::SearchResult> lexicalSearch(const QString& dbPath,
+                                                  const vector<float>& queryEmbedding,
+                                                  int limit,
+                                                  double minRelevance,
+                                                  const RagSearchOptions& options)
+{
+    RagSearchOptions vectorOptions = options;
+    vectorOptions.mode = RagSearchMode::Vector;
+    const int candidates = static_cast<int>(std::min<qint64>(static_cast<qint64>(limit) * RagUtils::kHybridCandidateFactor,
+                                                             std::numeric_limits<int>::max()));
+    const QString match = RagUtils::fullTextQuery(options.queryText);
+    if (match.isEmpty()) {
+        return RagUtils::findMostRelevantChunks(dbPath, queryEmbedding, limit, minRelevance, vectorOptions);
+    }
+
+    std::shared_ptr<const FragmentFilter> filter;
+    if (!options.filter.isEmpty()) {
+        filter = loadFilter(dbPath, options.filter);
+        if (filter->fragmentIds.empty()) {
+            return {};
+        }
+    }
+
+    QString errorMessage;
+    bool hadError = false;
+    bool haveIndex = false;
+    vector<qint64> lexical;
+    vector<RagUtils::SearchResult> pool;
+    {
+        QString openError;
+        QSqlDatabase db = SqliteConnectionPool::connection(dbPath, &openError);
+        if (!db.isOpen()) {
+            errorMessage = QStringLiteral("Failed to open RAG database '%1': %2").arg(dbPath, openError);
+            hadError = true;
+        } else {
+            QSqlQuery query(db);
+            query.setForwardOnly(true);
+            haveIndex = hasFullTextIndex(query);
+            if (haveIndex) {
+                hadError = !lexicalCandidates(query, match, candidates, filter.get(), lexical, errorMessage);
+            }
+            if (!hadError && haveIndex && options.mode == RagSearchMode::KeywordPrefilter) {
+                hadError = !scoreCandidates(db, query, queryEmbedding, lexical, pool, errorMessage);
+            }
+        }
+    }
+    if (hadError) {
+        throw std::runtime_error(errorMessage.toStdString());
+    }
+    if (!haveIndex) {
+        CP_WARN << "RagUtils: no full-text index in" << dbPath << "; using vector search alone";
+        return RagUtils::findMostRelevantChunks(dbPath, queryEmbedding, limit, minRelevance, vectorOptions);
+    }
+
+    // The vector ranking: the pool itself when prefiltered, else the usual search
+    QHash<qint64, int> vectorRank;
+    if (options.mode == RagSearchMode::Hybrid) {
+        pool = RagUtils::findMostRelevantChunks(dbPath, queryEmbedding, candidates, minRelevance, vectorOptions);
+    }
+    for (size_t i = 0; i < pool.size(); ++i) {
+        vectorRank.insert(pool[i].fragmentId, static_cast<int>(i) + 1);
+    }
+
+    // Keyword matches the vector search did not return join the pool with their own scores
+    vector<qint64> lexicalOnly;
+    for (const qint64 id : lexical) {
+        if (!vectorRank.contains(id)) {
+            lexicalOnly.push_back(id);
+        }
+    }
+    if (!lexicalOnly.empty()) {
+        vector<RagUtils::SearchResult> extra;
+        {
+            QString openError;
+            QSqlDatabase db = SqliteConnectionPool::connection(dbPath, &openError);
+            if (!db.isOpen()) {
+                throw std::runtime_error(QStringLiteral("Failed to open RAG database '%1': %2")
+                                             .arg(dbPath, openError).toStdString());
+            }
+            QSqlQuery query(db);
+            query.setForwardOnly(true);
+            if (!scoreCandidates(db, query, queryEmbedding, lexicalOnly, extra, errorMessage)) {
+                throw std::runtime_error(errorMessage.toStdString());
+            }
+        }
+        std::move(extra.begin(), extra.end(), std::back_inserter(pool));
+    }
+
+    QHash<qint64, int> lexicalRank;
+    for (size_t i = 0; i < lexical.size(); ++i) {
+        lexicalRank.insert(lexical[i], static_cast<int>(i) + 1);
+    }
+    for (RagUtils::SearchResult& result : pool) {
+        double fused = 0.0;
+        if (const int rank = vectorRank.value(result.fragmentId); rank > 0) {
+            fused += 1.0 / (RagUtils::kReciprocalRankK + rank);
+        }
+        if (const int rank = lexicalRank.value(result.fragmentId); rank > 0) {
+            fused += 1.0 / (RagUtils::kReciprocalRankK + rank);
+        }
+        result.fusedScore = fused;
+    }
+    std::sort(pool.begin(), pool.end(), [](const RagUtils::SearchResult& lhs, const RagUtils::SearchResult& rhs) {
+        if (lhs.fusedScore == rhs.fusedScore) {
+            return lhs.fragmentId < rhs.fragmentId;
+        }
+        return lhs.fusedScore > rhs.fusedScore;
+    });
+    if (pool.size() > static_cast<size_t>(limit)) {
+        pool.resize(static_cast<size_t>(limit));
+    }
+    return pool;
+}
+
+// Vector mode for one or more queries of the same dimension, all scored in the same pass
+vector<vector<RagUtils::SearchResult>> searchVectors(const QString& dbPath,
+                                                     const vector<vector<float>>& queries,
+                                                     int limit,
+                                                     double minRelevance,
+                                                     const RagSearchOptions& options)
+{
+    vector<vector<RagUtils::SearchResult>> results(queries.size());
+    const int dimension = static_cast<int>(queries.front().size());
+
+    std::shared_ptr<const HnswIndex> annIndex;
+    if (options.useAnnIndex && options.ef > 0) {
+        annIndex = loadedAnnIndex(RagUtils::annIndexPath(dbPath));
+        if (annIndex && annIndex->dimension() != dimension) {
+            annIndex.reset();
+        }
+    }
+
+    // Filters are resolved to fragment ids up front; narrow ones are cheaper to scan than to find in the graph
+    std::shared_ptr<const FragmentFilter> filter;
+    if (!options.filter.isEmpty()) {
+        filter = loadFilter(dbPath, options.filter);
+        if (filter->fragmentIds.empty()) {
+            return results;
+        }
+        if (static_cast<qint64>(filter->fragmentIds.size()) <= RagUtils::kMaxFilteredScanFragments) {
+            annIndex.reset();
+        }
+    }
+
+    std::shared_ptr<const VectorFile> vectors;
+    if (options.useVectorFile) {
+        vectors = loadedVectorFile(RagUtils::vectorFilePath(dbPath));
+        if (vectors && vectors->dimension() != dimension) {
+            vectors.reset();
+        }
+    }
+
+    // Parallel scans borrow the run's Cpu pool, so they stay inside its budget
+    QThreadPool* pool = CpuWorkerPool::current() ? CpuWorkerPool::current() : QThreadPool::globalInstance();
+    const int budget = std::max(1, pool->maxThreadCount());
+    const int participants = options.threads > 0 ? std::min(options.threads, budget) : budget;
+
+    QString errorMessage;
+    bool hadError = false;
+    bool staleVectorFile = false;
+
+    {
+        QString openError;
+        QSqlDatabase db = SqliteConnectionPool::connection(dbPath, &openError);
+        if (!db.isOpen()) {
+            errorMessage = QStringLiteral("Failed to open RAG database '%1': %2").arg(dbPath, openError);
+            hadError = true;
+        } else {
+            QSqlQuery query(db);
+            query.setForwardOnly(true);
+            const RagEmbeddingFormat format = storedEmbeddingFormat(db, query);
+            const bool rescore = options.rescore && format != RagEmbeddingFormat::Float32
+                && tableHasColumn(db, QStringLiteral("fragments"), QStringLiteral("embedding_full"));
+            const QString selectSql = filter
+                ? QStringLiteral("SELECT id, embedding FROM fragments WHERE %1").arg(filter->condition)
+                : QStringLiteral("SELECT id, embedding FROM fragments");
+            const QString conjunction = filter ? QStringLiteral(" AND ") : QStringLiteral(" WHERE ");
+            if (vectors && vectors->format() != static_cast<int>(format)) {
+                vectors.reset();
+            }
+            qint64 maxRowId = 0;
+            if (query.exec(QStringLiteral("SELECT COALESCE(MAX(id), 0) FROM fragments")) && query.next()) {
+                maxRowId = query.value(0).toLongLong();
+            }
+            // A file reaching past the newest fragment predates a cleared database
+            if (vectors && maxRowId < vectors->maxId()) {
+                vectors.reset();
+            }
+
+            const bool storedNormalized = embeddingsVersion(query) >= kRagNormalizedEmbeddingsVersion;
+
+            // Large unfiltered exact scans go to the GPU, which ranks full vectors, so they skip any coarse pass.
+            // Legacy unnormalised float32 rows need a norm per row, which the device does not compute.
+            std::shared_ptr<const GpuVectorScorer> gpu;
+            const qint64 gpuCandidates = rescore ? static_cast<qint64>(limit) * RagUtils::kRescoreFactor : limit;
+            if (options.useGpu && !annIndex && !filter && vectors && storedNormalized
+                && gpuCandidates <= GpuVectorScorer::kMaxCandidates && suitsGpu(*vectors)) {
+                gpu = residentGpuScorer(RagUtils::vectorFilePath(dbPath), vectors);
+            }
+
+            // A coarse pass scores only each embedding's leading dimensions; the ANN path reads few rows anyway
+            const bool coarse = !annIndex && !gpu && options.coarseDimensions > 0 && options.coarseDimensions < dimension;
+
+            // Phase one: score vectors only, keeping the best `limit` fragment ids per query
+            // (more when a rescoring pass will pick the final ones)
+            const int candidates = rescore || coarse
+                ? static_cast<int>(std::min<qint64>(static_cast<qint64>(limit) * RagUtils::kRescoreFactor,
+                                                    std::numeric_limits<int>::max()))
+                : limit;
+            QueryBatch batch(queries, storedNormalized, format, candidates, minRelevance,
+                             coarse ? options.coarseDimensions : 0);
+            vector<EmbeddingScorer> fullScorers;
+            if (coarse) {
+                fullScorers.reserve(queries.size());
+                for (const vector<float>& queryEmbedding : queries) {
+                    fullScorers.emplace_back(queryEmbedding, storedNormalized, format);
+                }
+            }
+
+            // Rows up to `scanned` are covered by the mapped file and ANN index; SQLite supplies the rest
+            QStringList statements;
+            qint64 scanned = 0;
+            if (annIndex) {
+                // Re-score each query's candidates from the index exactly, then scan whatever was added
+                // since it was built. Rows not in the vector file are read once for the whole batch.
+                const int k = std::max(options.ef, limit);
+                vector<vector<HnswIndex::Hit>> hits;
+                hits.reserve(queries.size());
+                QSet<qint64> sqlIds;
+                for (const vector<float>& queryEmbedding : queries) {
+                    hits.push_back(filter
+                        ? annIndex->search(queryEmbedding, k, options.ef, [&filter](qint64 id) { return filter->admits(id); })
+                        : annIndex->search(queryEmbedding, k, options.ef));
+                    for (const HnswIndex::Hit& hit : hits.back()) {
+                        if (!vectors || hit.id > vectors->maxId()) {
+                            sqlIds.insert(hit.id);
+                        }
+                    }
+                }
+                QHash<qint64, QByteArray> blobs;
+                if (!sqlIds.isEmpty()) {
+                    QStringList ids;
+                    for (const qint64 id : std::as_const(sqlIds)) {
+                        ids.append(QString::number(id));
+                    }
+                    if (query.exec(QStringLiteral("SELECT id, embedding FROM fragments WHERE id IN (%1)")
+                                       .arg(ids.join(QLatin1Char(','))))) {
+                        while (query.next()) {
+                            blobs.insert(query.value(0).toLongLong(), query.value(1).toByteArray());
+                        }
+                    } else {
+                        errorMessage = QStringLiteral("Failed to query fragments for similarity search: %1")
+                                           .arg(query.lastError().text());
+                        hadError = true;
+                    }
+                }
+                for (size_t i = 0; i < hits.size(); ++i) {
+                    for (const HnswIndex::Hit& hit : hits[i]) {
+                        if (vectors && hit.id <= vectors->maxId()) {
+                            if (const char* row = vectors->row(hit.id)) {
+                                batch.offerTo(i, hit.id, row, vectors->rowBytes());
+                            }
+                        } else if (const auto it = blobs.constFind(hit.id); it != blobs.constEnd()) {
+                            batch.offerTo(i, hit.id, it->constData(), static_cast<int>(it->size()));
+                        }
+                    }
+                }
+                scanned = annIndex->maxId();
+            } else if (gpu && scoreOnGpu(*gpu, *vectors, queries, batch)) {
+                // Rows appended to the file since the upload are scanned below
+                scanned = gpu->maxId();
+            } else if (participants > 1
+                       && (filter ? static_cast<qint64>(filter->fragmentIds.size()) : maxRowId) > RagUtils::kMinShardFragments) {
+                // A few shards per participant even out uneven rows and late-starting helpers
+                const qint64 shards = std::min<qint64>(static_cast<qint64>(participants) * 4,
+                                                       maxRowId / RagUtils::kMinShardFragments);
+                const int helpers = static_cast<int>(std::min<qint64>(participants, shards)) - 1;
+                const auto scan = std::make_shared<ShardedScan>(dbPath, vectors, filter, batch, 0, maxRowId, shards);
+                hadError = !scan->run(pool, helpers, batch, errorMessage);
+                scanned = maxRowId;
+            }
+            if (vectors && vectors->maxId() > scanned) {
+                scoreSlots(*vectors, scanned + 1, vectors->maxId(), batch, filter.get());
+                scanned = vectors->maxId();
+            }
+            statements.append(scanned > 0 ? selectSql + conjunction + QStringLiteral("id > %1").arg(scanned) : selectSql);
+
+            for (const QString& sql : statements) {
+                if (hadError) {
+                    break;
+                }
+                if (!query.exec(sql)) {
+                    errorMessage = QStringLiteral("Failed to query fragments for similarity search: %1")
+                                       .arg(query.lastError().text());
+                    hadError = true;
+                    break;
+                }
+                scoreRows(query, batch);
+            }
+
+            for (size_t i = 0; i < batch.size() && !hadError; ++i) {
+                vector<ScoredFragment> ranked = batch.top(i).takeRanked();
+                if (rescore || coarse) {
+                    hadError = !rescoreFragments(query,
+                                                 rescore ? QStringLiteral("embedding_full") : QStringLiteral("embedding"),
+                                                 coarse ? fullScorers[i] : batch.scorer(i), minRelevance, limit,
+                                                 ranked, errorMessage);
+                }
+
+                // Phase two: read content and source details for the winners
+                if (!hadError) {
+                    hadError = !fetchResults(db, ranked, results[i], errorMessage);
+                    // A winner deleted since the vector file was last updated may have displaced a live fragment
+                    staleVectorFile = staleVectorFile || (!hadError && vectors && results[i].size() < ranked.size());
+                }
+            }
+
+        }
+    }
+
+    if (hadError) {
+        throw std::runtime_error(errorMessage.toStdString());
+    }
+
+    if (staleVectorFile) {
+        CP_WARN << "RagUtils: vector file for" << dbPath << "is behind the database; scanning SQLite instead";
+        RagSearchOptions sqliteOnly = options;
+        sqliteOnly.useVectorFile = false;
+        return searchVectors(dbPath, queries, limit, minRelevance, sqliteOnly);
+    }
+
+    return results;
+}
+
+qint64 existingFileSize(const QString& path)
+{
+    const QFileInfo info(path);
+    return info.exists() ? info.size() : 0;
+}
+
+bool readIndexStatistics(QSqlDatabase& db, const QString& dbPath, RagUtils::IndexStatistics& stats,
+                         QString& errorMessage)
+{
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    auto scalar = [&](const QString& sql, qint64& value) {
+        if (!query.exec(sql) || !query.next()) {
+            errorMessage = QStringLiteral("Failed to read index statistics (%1): %2").arg(sql, query.lastError().text());
+            return false;
+        }
+        value = query.value(0).toLongLong();
+        return true;
+    };
+
+    qint64 autoVacuum = 0;
+    if (!scalar(QStringLiteral("SELECT COUNT(*) FROM source_files"), stats.files)
+        || !scalar(QStringLiteral("SELECT COUNT(*) FROM fragments"), stats.fragments)
+        || !scalar(QStringLiteral("SELECT COUNT(*) FROM fragments WHERE file_id NOT IN (SELECT id FROM source_files)"),
+                   stats.orphanedFragments)
+        || !scalar(QStringLiteral("PRAGMA page_size"), stats.pageSize)
+        || !scalar(QStringLiteral("PRAGMA page_count"), stats.pageCount)
+        || !scalar(QStringLiteral("PRAGMA freelist_count"), stats.freePages)
+        || !scalar(QStringLiteral("PRAGMA auto_vacuum"), autoVacuum)) {
+        return false;
+    }
+    stats.incrementalVacuum = autoVacuum == 2;
+    stats.format = storedEmbeddingFormat(db, query);
+
+    if (!query.exec(QStringLiteral("SELECT LENGTH(embedding), COUNT(*) FROM fragments GROUP BY LENGTH(embedding)"))) {
+        errorMessage = QStringLiteral("Failed to read embedding sizes: %1").arg(query.lastError().text());
+        return false;
+    }
+    stats.dimensions.clear();
+    while (query.next()) {
+        stats.dimensions[embeddingDimension(stats.format, query.value(0).toInt())] += query.value(1).toLongLong();
+    }
+    const QString fullCopy = tableHasColumn(db, QStringLiteral("fragments"), QStringLiteral("embedding_full"))
+        ? QStringLiteral("COALESCE(LENGTH(embedding_full), 0)")
+        : QStringLiteral("0");
+    if (query.exec(QStringLiteral("SELECT AVG(COALESCE(LENGTH(embedding), 0) + %1) FROM fragments").arg(fullCopy))
+        && query.next()) {
+        stats.bytesPerVector = query.value(0).toDouble();
+    }
+
+    stats.databaseBytes = existingFileSize(dbPath) + existingFileSize(dbPath + QStringLiteral("-wal"));
+    stats.sidecarBytes = existingFileSize(RagUtils::annIndexPath(dbPath)) + existingFileSize(RagUtils::vectorFilePath(dbPath));
+    return true;
+}
+
+
+} // namespace
+
+RagUtils::IndexConfig RagUtils::getIndexConfig(const QString& dbPath)
+{
+    const QString configKey = QFileInfo(dbPath).absoluteFilePath();
+    const QString stamp = indexConfigStamp(dbPath);
+    {
+        QMutexLocker locker(&g_indexConfigMutex);
+        const auto it = g_indexConfigs.constFind(configKey);
+        if (it != g_indexConfigs.constEnd() && it->stamp == stamp) {
+            return it->config;
+        }
+    }
+
+    QVector<QPair<QString, QString>> pairs;
+    int dimension = 0;
+    int requestedDimensions = 0;
+    RagEmbeddingFormat format = RagEmbeddingFormat::Float32;
+    bool mixedFormats = false;
+    bool mixedDimensions = false;
+    QString errorMessage;
+    bool hadError = false;
+
+    {
+        QString openError;
+        QSqlDatabase db = SqliteConnectionPool::connection(dbPath, &openError);
+        if (!db.isOpen()) {
+            errorMessage = QStringLiteral("Failed to open RAG database '%1': %2").arg(dbPath, openError);
+            hadError = true;
+        } else {
+            QSqlQuery query(db);
+            if (!query.exec(QStringLiteral("SELECT DISTINCT provider, model FROM source_files"))) {
+                errorMessage = QStringLiteral("Failed to query source_files for index configuration: %1")
+                                   .arg(query.lastError().text());
+                hadError = true;
+            } else {
+                while (query.next()) {
+                    const QString provider = query.value(0).toString();
+                    const QString model = query.value(1).toString();
+                    pairs.append(qMakePair(provider, model));
+                }
+            }
+            if (!hadError && tableHasColumn(db, QStringLiteral("source_files"), QStringLiteral("embedding_format"))
+                && query.exec(QStringLiteral("SELECT COUNT(DISTINCT embedding_format) FROM source_files"))
+                && query.next()) {
+                mixedFormats = query.value(0).toInt() > 1;
+            }
+            if (!hadError && tableHasColumn(db, QStringLiteral("source_files"), QStringLiteral("embedding_dimensions"))
+                && query.exec(QStringLiteral("SELECT MIN(embedding_dimensions), MAX(embedding_dimensions) FROM source_files"))
+                && query.next()) {
+                requestedDimensions = query.value(0).toInt();
+                mixedDimensions = requestedDimensions != query.value(1).toInt();
+            }
+            if (!hadError) {
+                format = storedEmbeddingFormat(db, query);
+            }
+            if (!hadError && query.exec(QStringLiteral("SELECT LENGTH(embedding) FROM fragments LIMIT 1"))
+                && query.next()) {
+                dimension = embeddingDimension(format, query.value(0).toInt());
+            }
+
+        }
+    }
+
+    if (hadError) {
+        throw std::runtime_error(errorMessage.toStdString());
+    }
+
+    if (pairs.isEmpty()) {
+        throw std::runtime_error("RAG index is empty; no source_files rows found");
+    }
+
+    if (pairs.size() > 1) {
+        throw std::runtime_error("Mixed-model RAG is not supported: multiple provider/model pairs found in source_files");
+    }
+
+    if (mixedFormats) {
+        throw std::runtime_error("Mixed embedding formats are not supported: source_files lists more than one embedding_format");
+    }
+
+    if (mixedDimensions) {
+        throw std::runtime_error("Mixed embedding dimensions are not supported: source_files lists more than one embedding_dimensions");
+    }
+
+    IndexConfig cfg;
+    cfg.providerId = pairs.first().first;
+    cfg.modelId = pairs.first().second;
+    cfg.dimension = dimension;
+    cfg.requestedDimensions = requestedDimensions;
+    cfg.format = format;
+    QMutexLocker locker(&g_indexConfigMutex);
+    g_indexConfigs.insert(configKey, LoadedIndexConfig {cfg, stamp});
+    return cfg;
+}
+
+double RagUtils::cosineSimilarity(const vector<float>& a, const vector<float>& b)
+{
+    if (a.empty() || b.empty() || a.size() != b.size()) {
+        return 0.0;
+    }
+
+    double dot = 0.0;
+    double normA = 0.0;
+    double normB = 0.0;
+
+    for (size_t i = 0; i < a.size(); ++i) {
+        const double va = a[i];
+        const double vb = b[i];
+        dot += va * vb;
+        normA += va * va;
+        normB += vb * vb;
+    }
+
+    if (normA == 0.0 || normB == 0.0) {
+        return 0.0;
+    }
+
+    const double denom = std::sqrt(normA) * std::sqrt(normB);
+    if (denom == 0.0) {
+        return 0.0;
+    }
+
+    return dot / denom;
+}
+
+std::vector<RagUtils::SearchResult> RagUtils::findMostRelevantChunks(
+    const QString& dbPath,
+    const std::vector<float>& queryEmbedding,
+    int limit,
+    double minRelevance,
+    const RagSearchOptions& options)
+{
+    if (limit <= 0 || queryEmbedding.empty()) {
+        return {};
+    }
+
+    const SearchTimer timer(options.mode);
+    if (options.mode != RagSearchMode::Vector) {
+        return lexicalSearch(dbPath, queryEmbedding, limit, minRelevance, options);
+    }
+
+    return std::move(searchVectors(dbPath, {queryEmbedding}, limit, minRelevance, options).front());
+}
+
+std::vector<std::vector<RagUtils::SearchResult>> RagUtils::findMostRelevantChunksBatch(
+    const QString& dbPath,
+    const std::vector<std::vector<float>>& queryEmbeddings,
+    int limit,
+    double minRelevance,
+    const RagSearchOptions& options,
+    const QStringList& queryTexts)
+{
+    std::vector<std::vector<SearchResult>> results(queryEmbeddings.size());
+    if (limit <= 0) {
+        return results;
+    }
+
+    // The lexical modes rank each query's own keyword matches, so they run one query at a time
+    if (options.mode != RagSearchMode::Vector) {
+        for (size_t i = 0; i < queryEmbeddings.size(); ++i) {
+            RagSearchOptions single = options;
+            single.queryText = queryTexts.value(static_cast<qsizetype>(i));
+            results[i] = findMostRelevantChunks(dbPath, queryEmbeddings[i], limit, minRelevance, single);
+        }
+        return results;
+    }
+
+    // Queries without an embedding simply get no results
+    vector<vector<float>> queries;
+    vector<size_t> positions;
+    for (size_t i = 0; i < queryEmbeddings.size(); ++i) {
+        if (!queryEmbeddings[i].empty()) {
+            queries.push_back(queryEmbeddings[i]);
+            positions.push_back(i);
+        }
+    }
+    if (queries.empty()) {
+        return results;
+    }
+    const SearchTimer timer(options.mode);
+    vector<vector<SearchResult>> found = searchVectors(dbPath, queries, limit, minRelevance, options);
+    for (size_t i = 0; i < positions.size(); ++i) {
+        results[positions[i]] = std::move(found[i]);
+    }
+    return results;
+}
+
+std::vector<RagUtils::SearchResult> RagUtils::mergeShardResults(
+    std::vector<std::vector<SearchResult>> shardResults,
+    const std::vector<int>& modelGroups,
+    int limit)
+{
+    if (limit <= 0 || shardResults.empty()) {
+        return {};
+    }
+    if (shardResults.size() == 1) {
+        vector<SearchResult> only = std::move(shardResults.front());
+        if (only.size() > static_cast<size_t>(limit)) {
+            only.resize(static_cast<size_t>(limit));
+        }
+        return only;
+    }
+
+    struct Ranked {
+        SearchResult result;
+        size_t shard {0};
+    };
+    auto groupOf = [&modelGroups](size_t shard) {
+        return shard < modelGroups.size() ? modelGroups[shard] : 0;
+    };
+
+    // Within a model group scores are comparable, so the group ranks as one index would
+    QMap<int, vector<Ranked>> groups;
+    QHash<int, bool> groupFused;
+    for (size_t shard = 0; shard < shardResults.size(); ++shard) {
+        const int group = groupOf(shard);
+        const bool fused = std::all_of(shardResults[shard].begin(), shardResults[shard].end(),
+                                       [](const SearchResult& result) { return result.fusedScore > 0.0; });
+        groupFused.insert(group, groupFused.value(group, true) && fused);
+        vector<Ranked>& members = groups[group];
+        for (SearchResult& result : shardResults[shard]) {
+            members.push_back(Ranked{std::move(result), shard});
+        }
+    }
+    for (auto it = groups.begin(); it != groups.end(); ++it) {
+        const bool byFused = groupFused.value(it.key());
+        std::stable_sort(it->begin(), it->end(), [byFused](const Ranked& lhs, const Ranked& rhs) {
+            const double left = byFused ? lhs.result.fusedScore : lhs.result.score;
+            const double right = byFused ? rhs.result.fusedScore : rhs.result.score;
+            if (left != right) {
+                return left > right;
+            }
+            return lhs.shard < rhs.shard;
+        });
+        if (it->size() > static_cast<size_t>(limit)) {
+            it->resize(static_cast<size_t>(limit));
+        }
+    }
+
+    vector<Ranked> merged;
+    if (groups.size() == 1) {
+        merged = std::move(groups.first());
+    } else {
+        // Scores from different models are not comparable, but ranks are
+        for (auto it = groups.begin(); it != groups.end(); ++it) {
+            for (size_t rank = 0; rank < it->size(); ++rank) {
+                Ranked& ranked = (*it)[rank];
+                ranked.result.fusedScore = 1.0 / (kReciprocalRankK + static_cast<double>(rank + 1));
+                merged.push_back(std::move(ranked));
+            }
+        }
+        std::stable_sort(merged.begin(), merged.end(), [](const Ranked& lhs, const Ranked& rhs) {
+            if (lhs.result.fusedScore != rhs.result.fusedScore) {
+                return lhs.result.fusedScore > rhs.result.fusedScore;
+            }
+            return lhs.shard < rhs.shard;
+        });
+    }
+
+    vector<SearchResult> results;
+    results.reserve(std::min(merged.size(), static_cast<size_t>(limit)));
+    for (Ranked& ranked : merged) {
+        if (results.size() == static_cast<size_t>(limit)) {
+            break;
+        }
+        results.push_back(std::move(ranked.result));
+    }
+    return results;
+}
+
+QString RagUtils::annIndexPath(const QString& dbPath)
+{
+    return dbPath + QStringLiteral(".hnsw");
+}
+
+RagUtils::AnnIndexUpdate RagUtils::updateAnnIndex(const QString& dbPath)
+{
+    const QString path = annIndexPath(dbPath);
+    AnnIndexUpdate update;
+
+    QString loadError;
+    std::unique_ptr<HnswIndex> index = QFileInfo::exists(path) ? HnswIndex::load(path, &loadError) : nullptr;
+    if (!loadError.isEmpty()) {
+        CP_WARN << "RagUtils: rebuilding unreadable ANN index" << path << "-" << loadError;
+    }
+
+    QString errorMessage;
+    bool hadError = false;
+    qint64 liveCount = 0;
+
+    {
+        QString openError;
+        QSqlDatabase db = SqliteConnectionPool::connection(dbPath, &openError);
+        if (!db.isOpen()) {
+            errorMessage = QStringLiteral("Failed to open RAG database '%1': %2").arg(dbPath, openError);
+            hadError = true;
+        } else {
+            QSqlQuery query(db);
+            query.setForwardOnly(true);
+            qint64 maxRowId = 0;
+            int dimension = 0;
+            if (!query.exec(QStringLiteral("SELECT COUNT(*), COALESCE(MAX(id), 0) FROM fragments")) || !query.next()) {
+                errorMessage = QStringLiteral("Failed to inspect fragments for the ANN index: %1")
+                                   .arg(query.lastError().text());
+                hadError = true;
+            } else {
+                liveCount = query.value(0).toLongLong();
+                maxRowId = query.value(1).toLongLong();
+            }
+            // The newest fragment decides the dimension; older ones from another model are skipped
+            const RagEmbeddingFormat format = hadError ? RagEmbeddingFormat::Float32 : storedEmbeddingFormat(db, query);
+            if (!hadError && query.exec(QStringLiteral("SELECT LENGTH(embedding) FROM fragments ORDER BY id DESC LIMIT 1"))
+                && query.next()) {
+                dimension = embeddingDimension(format, query.value(0).toInt());
+            }
+
+            if (!hadError && index) {
+                qint64 newRows = 0;
+                query.prepare(QStringLiteral("SELECT COUNT(*) FROM fragments WHERE id > ?"));
+                query.addBindValue(index->maxId());
+                if (query.exec() && query.next()) {
+                    newRows = query.value(0).toLongLong();
+                }
+                const qint64 deleted = std::max<qint64>(0, index->size() - (liveCount - newRows));
+                if (index->maxId() > maxRowId || index->dimension() != dimension || deleted * 4 > index->size()) {
+                    index.reset();
+                }
+            }
+
+            if (!hadError && liveCount > 0) {
+                if (!index) {
+                    index = std::make_unique<HnswIndex>(dimension);
+                    update.rebuilt = true;
+                }
+                query.prepare(QStringLiteral("SELECT id, embedding FROM fragments WHERE id > ? ORDER BY id"));
+                query.addBindValue(index->maxId());
+                if (!query.exec()) {
+                    errorMessage = QStringLiteral("Failed to read fragments for the ANN index: %1")
+                                       .arg(query.lastError().text());
+                    hadError = true;
+                } else {
+                    while (query.next()) {
+                        if (index->add(query.value(0).toLongLong(), decodeEmbedding(query.value(1).toByteArray(), format))) {
+                            ++update.added;
+                        }
+                    }
+                }
+            }
+
+        }
+    }
+
+    if (hadError) {
+        throw std::runtime_error(errorMessage.toStdString());
+    }
+
+    if (liveCount == 0) {
+        removeAnnIndex(dbPath);
+        return update;
+    }
+
+    if (update.added > 0 || update.rebuilt) {
+        QString saveError;
+        if (!index->save(path, &saveError)) {
+            throw std::runtime_error(QStringLiteral("Failed to write ANN index '%1': %2")
+                                         .arg(path, saveError).toStdString());
+        }
+    }
+    update.total = index->size();
+    rememberAnnIndex(path, std::shared_ptr<const HnswIndex>(std::move(index)));
+    return update;
+}
+
+void RagUtils::removeAnnIndex(const QString& dbPath)
+{
+    const QString path = annIndexPath(dbPath);
+    QFile::remove(path);
+    QMutexLocker locker(&g_annIndexMutex);
+    g_annIndexes.remove(path);
+}
+
+QString RagUtils::vectorFilePath(const QString& dbPath)
+{
+    return dbPath + QStringLiteral(".vec");
+}
+
+RagUtils::VectorFileUpdate RagUtils::updateVectorFile(const QString& dbPath)
+{
+    const QString path = vectorFilePath(dbPath);
+    // A rebuild is written here and renamed into place once complete, so searches never see it half built
+    const QString buildPath = path + QStringLiteral(".next");
+    VectorFileUpdate update;
+
+    // The mapped generation stays in use by searches until the update has committed
+    QString openError;
+    std::unique_ptr<VectorFile> file = QFileInfo::exists(path) ? VectorFile::openForUpdate(path, &openError) : nullptr;
+    if (!openError.isEmpty()) {
+        CP_WARN << "RagUtils: rebuilding unreadable vector file" << path << "-" << openError;
+    }
+
+    QString errorMessage;
+    bool hadError = false;
+    qint64 liveCount = 0;
+
+    {
+        QString openError;
+        QSqlDatabase db = SqliteConnectionPool::connection(dbPath, &openError);
+        if (!db.isOpen()) {
+            errorMessage = QStringLiteral("Failed to open RAG database '%1': %2").arg(dbPath, openError);
+            hadError = true;
+        } else {
+            QSqlQuery query(db);
+            query.setForwardOnly(true);
+            qint64 maxRowId = 0;
+            int dimension = 0;
+            if (!query.exec(QStringLiteral("SELECT COUNT(*), COALESCE(MAX(id), 0) FROM fragments")) || !query.next()) {
+                errorMessage = QStringLiteral("Failed to inspect fragments for the vector file: %1")
+                                   .arg(query.lastError().text());
+                hadError = true;
+            } else {
+                liveCount = query.value(0).toLongLong();
+                maxRowId = query.value(1).toLongLong();
+            }
+            // The newest fragment decides the row size; older ones of another size stay tombstoned
+            const RagEmbeddingFormat format = hadError ? RagEmbeddingFormat::Float32 : storedEmbeddingFormat(db, query);
+            if (!hadError && query.exec(QStringLiteral("SELECT LENGTH(embedding) FROM fragments ORDER BY id DESC LIMIT 1"))
+                && query.next()) {
+                dimension = embeddingDimension(format, query.value(0).toInt());
+            }
+            const int rowBytes = embeddingBlobSize(format, dimension);
+
+            if (file && (file->maxId() > maxRowId || file->format() != static_cast<int>(format)
+                         || file->dimension() != dimension || file->rowBytes() != rowBytes)) {
+                file.reset();
+            }
+
+            if (!hadError && liveCount > 0 && dimension > 0) {
+                if (!file) {
+                    QString createError;
+                    file = VectorFile::create(buildPath, static_cast<int>(format), dimension, rowBytes, &createError);
+                    if (!file) {
+                        errorMessage = QStringLiteral("Failed to create vector file '%1': %2").arg(buildPath, createError);
+                        hadError = true;
+                    }
+                    update.rebuilt = true;
+                } else {
+                    // Tombstone every slot whose fragment is gone, e.g. a re-indexed file's old chunks
+                    query.prepare(QStringLiteral("SELECT id FROM fragments WHERE id <= ? ORDER BY id"));
+                    query.addBindValue(file->maxId());
+                    if (!query.exec()) {
+                        errorMessage = QStringLiteral("Failed to read fragment ids for the vector file: %1")
+                                           .arg(query.lastError().text());
+                        hadError = true;
+                    } else {
+                        qint64 expected = 1;
+                        auto tombstoneUpTo = [&](qint64 last) {
+                            for (; expected <= last; ++expected) {
+                                if (!file->isDeleted(expected)) {
+                                    file->markDeleted(expected);
+                                    ++update.deleted;
+                                }
+                            }
+                        };
+                        while (query.next()) {
+                            const qint64 id = query.value(0).toLongLong();
+                            tombstoneUpTo(id - 1);
+                            expected = id + 1;
+                        }
+                        tombstoneUpTo(file->maxId());
+                    }
+                }
+            }
+
+            if (!hadError && file && liveCount > 0) {
+                query.prepare(QStringLiteral("SELECT id, embedding FROM fragments WHERE id > ? ORDER BY id"));
+                query.addBindValue(file->maxId());
+                if (!query.exec()) {
+                    errorMessage = QStringLiteral("Failed to read fragments for the vector file: %1")
+                                       .arg(query.lastError().text());
+                    hadError = true;
+                }
+                while (!hadError && query.next()) {
+                    const QByteArray blob = query.value(1).toByteArray();
+                    if (blob.size() != file->rowBytes()) {
+                        continue; // stays tombstoned; the scorer would skip it anyway
+                    }
+                    QString appendError;
+                    if (!file->append(query.value(0).toLongLong(), blob, &appendError)) {
+                        errorMessage = QStringLiteral("Failed to write vector file '%1': %2").arg(path, appendError);
+                        hadError = true;
+                    }
+                    ++update.added;
+                }
+            }
+
+        }
+    }
+
+    if (hadError) {
+        if (update.rebuilt) {
+            file.reset();
+            QFile::remove(buildPath);
+        }
+        throw std::runtime_error(errorMessage.toStdString());
+    }
+
+    if (!file || liveCount == 0) {
+        file.reset();
+        if (update.rebuilt) {
+            QFile::remove(buildPath);
+        }
+        removeVectorFile(dbPath);
+        return update;
+    }
+
+    QString commitError;
+    if (!file->commit(&commitError)) {
+        file.reset();
+        if (update.rebuilt) {
+            QFile::remove(buildPath);
+        }
+        throw std::runtime_error(QStringLiteral("Failed to write vector file '%1': %2")
+                                     .arg(path, commitError).toStdString());
+    }
+    update.live = file->liveCount();
+    file.reset();
+    if (update.rebuilt && !replaceFile(buildPath, path)) {
+        QFile::remove(buildPath);
+        throw std::runtime_error(QStringLiteral("Failed to replace vector file '%1'").arg(path).toStdString());
+    }
+    publishVectorFile(path);
+    return update;
+}
+
+void RagUtils::removeVectorFile(const QString& dbPath)
+{
+    const QString path = vectorFilePath(dbPath);
+    forgetVectorFile(path);
+    QFile::remove(path);
+}
+
+bool RagUtils::warmIndex(const QString& dbPath)
+{
+    const QFileInfo database(dbPath);
+    if (!database.isFile()) {
+        return false;
+    }
+    const QString warmKey = database.absoluteFilePath();
+    const QString stamp = indexConfigStamp(dbPath);
+    {
+        QMutexLocker locker(&g_indexConfigMutex);
+        if (g_warmedIndexes.value(warmKey) == stamp) {
+            locker.unlock();
+            return loadedAnnIndex(annIndexPath(dbPath)) || loadedVectorFile(vectorFilePath(dbPath));
+        }
+        g_warmedIndexes.insert(warmKey, stamp);
+    }
+    try {
+        getIndexConfig(dbPath);
+    } catch (const std::exception& ex) {
+        CP_WARN << "RagUtils: not warming" << dbPath << "-" << ex.what();
+        return false;
+    }
+
+    const bool annIndex = loadedAnnIndex(annIndexPath(dbPath)) != nullptr;
+    const std::shared_ptr<const VectorFile> vectors = loadedVectorFile(vectorFilePath(dbPath));
+    if (vectors) {
+        if (suitsGpu(*vectors)) {
+            residentGpuScorer(vectorFilePath(dbPath), vectors);
+        }
+        vectors->prefetch();
+    } else if (database.size() <= kMaxWarmedDatabaseBytes) {
+        // Exact scans read every embedding from SQLite, so bring those pages into the OS cache
+        QString openError;
+        QSqlDatabase db = SqliteConnectionPool::connection(dbPath, &openError);
+        if (db.isOpen()) {
+            QSqlQuery query(db);
+            query.setForwardOnly(true);
+            if (query.exec(QStringLiteral("SELECT embedding FROM fragments"))) {
+                while (query.next()) {
+                }
+            }
+        }
+    }
+    return annIndex || vectors;
+}
+
+QString RagUtils::fullTextQuery(const QString& text)
+{
+    static const QRegularExpression word(QStringLiteral("[\\p{L}\\p{N}_]+"));
+    QStringList terms;
+    QSet<QString> seen;
+    for (auto it = word.globalMatch(text); it.hasNext() && terms.size() < kMaxFullTextTerms;) {
+        const QString term = it.next().captured(0);
+        if (!seen.contains(term.toLower())) {
+            seen.insert(term.toLower());
+            // Quoted, so FTS5 operators in the text are matched as words; the tokenizer
+            // still splits an identifier like foo_bar into a phrase
+            terms.append(QLatin1Char('"') + term + QLatin1Char('"'));
+        }
+    }
+    return terms.join(QStringLiteral(" OR "));
+}
+
+bool RagUtils::ensureFullTextIndex(const QString& dbPath)
+{
+    QString openError;
+    QSqlDatabase db = SqliteConnectionPool::connection(dbPath, &openError);
+    if (!db.isOpen()) {
+        throw std::runtime_error(QStringLiteral("Failed to open RAG database '%1': %2")
+                                     .arg(dbPath, openError).toStdString());
+    }
+
+    QSqlQuery query(db);
+    const bool created = !hasFullTextIndex(query);
+    if (!db.transaction()) {
+        throw std::runtime_error(QStringLiteral("Failed to start full-text index transaction: %1")
+                                     .arg(db.lastError().text()).toStdString());
+    }
+    QStringList statements {QString::fromLatin1(kRagSchemaFragmentsFts)};
+    for (const char* trigger : kRagSchemaFragmentsFtsTriggers) {
+        statements.append(QString::fromLatin1(trigger));
+    }
+    if (created) {
+        statements.append(QStringLiteral("INSERT INTO fragments_fts(fragments_fts) VALUES ('rebuild')"));
+    }
+    for (const QString& sql : std::as_const(statements)) {
+        if (!query.exec(sql)) {
+            const QString error = query.lastError().text();
+            db.rollback();
+            throw std::runtime_error(QStringLiteral("Failed to build the full-text index: %1").arg(error).toStdString());
+        }
+    }
+    if (!db.commit()) {
+        const QString error = db.lastError().text();
+        db.rollback();
+        throw std::runtime_error(QStringLiteral("Failed to commit the full-text index: %1").arg(error).toStdString());
+    }
+    return created;
+}
+
+void RagUtils::removeFullTextIndex(const QString& dbPath)
+{
+    QSqlDatabase db = SqliteConnectionPool::connection(dbPath);
+    if (!db.isOpen()) {
+        return;
+    }
+    QSqlQuery query(db);
+    for (const QString& name : {QStringLiteral("fragments_fts_insert"), QStringLiteral("fragments_fts_delete"),
+                                QStringLiteral("fragments_fts_update")}) {
+        query.exec(QStringLiteral("DROP TRIGGER IF EXISTS %1").arg(name));
+    }
+    if (!query.exec(QStringLiteral("DROP TABLE IF EXISTS fragments_fts"))) {
+        CP_WARN << "RagUtils: failed to drop the full-text index of" << dbPath << ":" << query.lastError().text();
+    }
+}
+
+RagSearchFilter RagUtils::parseSearchFilter(const QString& expression)
+{
+    // Split on whitespace outside double quotes; the quotes themselves are dropped
+    QStringList terms;
+    QString term;
+    bool quoted = false;
+    bool pending = false;
+    for (const QChar c : expression) {
+        if (c == QLatin1Char('"')) {
+            quoted = !quoted;
+            pending = true;
+        } else if (c.isSpace() && !quoted) {
+            if (pending) {
+                terms.append(term);
+            }
+            term.clear();
+            pending = false;
+        } else {
+            term += c;
+            pending = true;
+        }
+    }
+    if (quoted) {
+        throw std::runtime_error("Unterminated quote in search filter");
+    }
+    if (pending) {
+        terms.append(term);
+    }
+
+    RagSearchFilter filter;
+    for (const QString& item : terms) {
+        const auto valueAfter = [&item](const QString& prefix) { return item.mid(prefix.size()); };
+        if (item.startsWith(QStringLiteral("path:"), Qt::CaseInsensitive)) {
+            filter.pathPrefix = valueAfter(QStringLiteral("path:"));
+        } else if (item.startsWith(QStringLiteral("type:"), Qt::CaseInsensitive)) {
+            for (QString type : valueAfter(QStringLiteral("type:")).split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+                type = type.trimmed().toLower();
+                if (type.startsWith(QLatin1Char('.'))) {
+                    type.remove(0, 1);
+                }
+                if (!type.isEmpty() && !filter.fileTypes.contains(type)) {
+                    filter.fileTypes.append(type);
+                }
+            }
+        } else if (item.startsWith(QStringLiteral("tag:"), Qt::CaseInsensitive)) {
+            const QString tag = valueAfter(QStringLiteral("tag:"));
+            if (!tag.isEmpty() && !filter.tags.contains(tag)) {
+                filter.tags.append(tag);
+            }
+        } else if (const int equals = item.indexOf(QLatin1Char('=')); equals > 0) {
+            filter.metadata.insert(item.left(equals), item.mid(equals + 1));
+        } else {
+            throw std::runtime_error(QStringLiteral("Unrecognised search filter term '%1'; expected path:, type:, "
+                                                    "tag: or key=value").arg(item).toStdString());
+        }
+    }
+    return filter;
+}
+
+QString RagUtils::embeddingFormatName(RagEmbeddingFormat format)
+{
+    switch (format) {
+    case RagEmbeddingFormat::Float16:
+        return QStringLiteral("float16");
+    case RagEmbeddingFormat::Int8:
+        return QStringLiteral("int8");
+    case RagEmbeddingFormat::Float32:
+        break;
+    }
+    return QStringLiteral("float32");
+}
+
+RagEmbeddingFormat RagUtils::embeddingFormatFromName(const QString& name)
+{
+    const QString normalized = name.trimmed().toLower();
+    if (normalized == QStringLiteral("float16")) {
+        return RagEmbeddingFormat::Float16;
+    }
+    if (normalized == QStringLiteral("int8")) {
+        return RagEmbeddingFormat::Int8;
+    }
+    return RagEmbeddingFormat::Float32;
+}
+
+int RagUtils::embeddingBlobSize(RagEmbeddingFormat format, int dimension)
+{
+    switch (format) {
+    case RagEmbeddingFormat::Float16:
+        return dimension * 2;
+    case RagEmbeddingFormat::Int8:
+        return static_cast<int>(sizeof(float)) + dimension;
+    case RagEmbeddingFormat::Float32:
+        break;
+    }
+    return dimension * static_cast<int>(sizeof(float));
+}
+
+QByteArray RagUtils::encodeEmbedding(const std::vector<float>& embedding, RagEmbeddingFormat format)
+{
+    std::vector<float> normalized = embedding;
+    VectorKernels::normalize(normalized);
+    const int dimension = static_cast<int>(normalized.size());
+    QByteArray blob(embeddingBlobSize(format, dimension), Qt::Uninitialized);
+
+    switch (format) {
+    case RagEmbeddingFormat::Float16:
+        for (int i = 0; i < dimension; ++i) {
+            const quint16 half = VectorKernels::floatToHalf(normalized[static_cast<size_t>(i)]);
+            memcpy(blob.data() + i * 2, &half, sizeof(half));
+        }
+        break;
+    case RagEmbeddingFormat::Int8: {
+        // Symmetric: the largest magnitude maps to +/-127
+        float maxAbs = 0.0f;
+        for (const float value : normalized) {
+            maxAbs = std::max(maxAbs, std::fabs(value));
+        }
+        const float scale = maxAbs > 0.0f ? maxAbs / 127.0f : 0.0f;
+        memcpy(blob.data(), &scale, sizeof(scale));
+        for (int i = 0; i < dimension; ++i) {
+            const long code = scale > 0.0f ? std::lround(normalized[static_cast<size_t>(i)] / scale) : 0;
+            blob[static_cast<int>(sizeof(scale)) + i] = static_cast<char>(std::clamp(code, -127L, 127L));
+        }
+        break;
+    }
+    case RagEmbeddingFormat::Float32:
+        memcpy(blob.data(), normalized.data(), normalized.size() * sizeof(float));
+        break;
+    }
+    return blob;
+}
+
+std::vector<float> RagUtils::decodeEmbedding(const QByteArray& blob, RagEmbeddingFormat format)
+{
+    const int dimension = embeddingDimension(format, blob.size());
+    std::vector<float> result;
+    if (dimension <= 0) {
+        return result;
+    }
+
+    switch (format) {
+    case RagEmbeddingFormat::Float16:
+        result.resize(static_cast<size_t>(dimension));
+        for (int i = 0; i < dimension; ++i) {
+            quint16 half = 0;
+            memcpy(&half, blob.constData() + i * 2, sizeof(half));
+            result[static_cast<size_t>(i)] = VectorKernels::halfToFloat(half);
+        }
+        break;
+    case RagEmbeddingFormat::Int8: {
+        float scale = 0.0f;
+        memcpy(&scale, blob.constData(), sizeof(scale));
+        result.resize(static_cast<size_t>(dimension));
+        const auto* codes = reinterpret_cast<const qint8*>(blob.constData() + sizeof(scale));
+        for (int i = 0; i < dimension; ++i) {
+            result[static_cast<size_t>(i)] = static_cast<float>(codes[i]) * scale;
+        }
+        break;
+    }
+    case RagEmbeddingFormat::Float32:
+        result = blobToVectorFloat(blob);
+        break;
+    }
+    return result;
+}
+
+int RagUtils::normalizeStoredEmbeddings(const QString& dbPath)
+{
+    QString errorMessage;
+    int rewritten = 0;
+
+    {
+        QString openError;
+        QSqlDatabase db = SqliteConnectionPool::connection(dbPath, &openError);
+        if (!db.isOpen()) {
+            errorMessage = QStringLiteral("Failed to open RAG database '%1': %2").arg(dbPath, openError);
+        } else {
+            QSqlQuery query(db);
+            query.setForwardOnly(true);
+            if (embeddingsVersion(query) < kRagNormalizedEmbeddingsVersion) {
+                if (!db.transaction()) {
+                    errorMessage = QStringLiteral("Failed to start embedding migration: %1").arg(db.lastError().text());
+                } else {
+                    QSqlQuery update(db);
+                    update.prepare(QStringLiteral("UPDATE fragments SET embedding = ? WHERE id = ?"));
+                    if (!query.exec(QStringLiteral("SELECT id, embedding FROM fragments WHERE embedding IS NOT NULL"))) {
+                        errorMessage = QStringLiteral("Failed to read fragments for embedding migration: %1")
+                                           .arg(query.lastError().text());
+                    }
+                    while (errorMessage.isEmpty() && query.next()) {
+                        const vector<float> embedding = blobToVectorFloat(query.value(1).toByteArray());
+                        if (embedding.empty()) {
+                            continue;
+                        }
+                        update.addBindValue(encodeEmbedding(embedding));
+                        update.addBindValue(query.value(0).toLongLong());
+                        if (!update.exec()) {
+                            errorMessage = QStringLiteral("Failed to normalise fragment embedding: %1")
+                                               .arg(update.lastError().text());
+                        }
+                        ++rewritten;
+                    }
+                    if (errorMessage.isEmpty()
+                        && !query.exec(QStringLiteral("PRAGMA user_version = %1").arg(kRagNormalizedEmbeddingsVersion))) {
+                        errorMessage = QStringLiteral("Failed to record embedding version: %1")
+                                           .arg(query.lastError().text());
+                    }
+                    if (errorMessage.isEmpty() && !db.commit()) {
+                        errorMessage = QStringLiteral("Failed to commit embedding migration: %1")
+                                           .arg(db.lastError().text());
+                    }
+                    if (!errorMessage.isEmpty()) {
+                        db.rollback();
+                    }
+                }
+            }
+        }
+    }
+
+    if (!errorMessage.isEmpty()) {
+        throw std::runtime_error(errorMessage.toStdString());
+    }
+    if (rewritten > 0) {
+        CP_LOG << "RagUtils: Normalised" << rewritten << "stored embeddings in" << dbPath;
+        removeVectorFile(dbPath);
+    }
+    return rewritten;
+}
+
+RagUtils::IndexStatistics RagUtils::indexStatistics(const QString& dbPath)
+{
+    IndexStatistics stats;
+    QString errorMessage;
+    {
+        QString openError;
+        QSqlDatabase db = SqliteConnectionPool::connection(dbPath, &openError);
+        if (!db.isOpen()) {
+            errorMessage = QStringLiteral("Failed to open RAG database '%1': %2").arg(dbPath, openError);
+        } else {
+            readIndexStatistics(db, dbPath, stats, errorMessage);
+        }
+    }
+    if (!errorMessage.isEmpty()) {
+        throw std::runtime_error(errorMessage.toStdString());
+    }
+    return stats;
+}
+
+RagUtils::IndexCompaction RagUtils::compactIndex(const QString& dbPath)
+{
+    IndexCompaction compaction;
+    QString errorMessage;
+    const bool hadAnnIndex = QFileInfo::exists(annIndexPath(dbPath));
+    const bool hadVectorFile = QFileInfo::exists(vectorFilePath(dbPath));
+
+    // VACUUM fails while the connection has statements of its own, so not a pooled one with cached statements
+    SqliteConnectionPool::close(dbPath);
+    const QString connectionName = QStringLiteral("rag_compact_") + QUuid::createUuid().toString();
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+        db.setDatabaseName(dbPath);
+        db.setConnectOptions(QStringLiteral("QSQLITE_BUSY_TIMEOUT=%1").arg(SqliteConnectionPool::kBusyTimeoutMs));
+        if (!db.open()) {
+            errorMessage = QStringLiteral("Failed to open RAG database '%1': %2").arg(dbPath, db.lastError().text());
+        } else {
+            QSqlQuery query(db);
+            auto run = [&](const QString& sql) {
+                if (!query.exec(sql)) {
+                    errorMessage = QStringLiteral("Failed to compact RAG database (%1): %2").arg(sql, query.lastError().text());
+                    return false;
+                }
+                return true;
+            };
+
+            bool ok = readIndexStatistics(db, dbPath, compaction.before, errorMessage);
+            if (ok && compaction.before.orphanedFragments > 0) {
+                // The fragments_fts triggers drop their rows from the text index too
+                ok = run(QStringLiteral("DELETE FROM fragments WHERE file_id NOT IN (SELECT id FROM source_files)"));
+                compaction.orphansRemoved = ok ? query.numRowsAffected() : 0;
+            }
+            if (ok && SqliteConnectionPool::hasColumn(db, QStringLiteral("fragment_sources"), QStringLiteral("fragment_id"))) {
+                ok = run(QStringLiteral("DELETE FROM fragment_sources WHERE file_id NOT IN (SELECT id FROM source_files) "
+                                        "OR fragment_id NOT IN (SELECT id FROM fragments)"));
+            }
+            if (ok && hasFullTextIndex(query)) {
+                ok = run(QStringLiteral("INSERT INTO fragments_fts(fragments_fts) VALUES ('optimize')"));
+            }
+            if (ok) {
+                const IndexStatistics& before = compaction.before;
+                if (before.incrementalVacuum && before.fragmentation() <= kVacuumFragmentation) {
+                    // Frees a page per step, so step it to the end
+                    ok = run(QStringLiteral("PRAGMA incremental_vacuum"));
+                    while (ok && query.next()) {
+                    }
+                } else {
+                    ok = run(QString::fromLatin1(kRagSchemaAutoVacuum)) && run(QStringLiteral("VACUUM"));
+                    compaction.vacuumed = ok;
+                }
+            }
+            // VACUUM writes the whole database through the WAL
+            if (ok) {
+                ok = run(QStringLiteral("PRAGMA wal_checkpoint(TRUNCATE)"));
+            }
+            query.finish();
+        }
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    if (!errorMessage.isEmpty()) {
+        throw std::runtime_error(errorMessage.toStdString());
+    }
+
+    if (hadAnnIndex) {
+        removeAnnIndex(dbPath);
+        compaction.annIndexRebuilt = updateAnnIndex(dbPath).rebuilt;
+    }
+    if (hadVectorFile) {
+        removeVectorFile(dbPath);
+        compaction.vectorFileRebuilt = updateVectorFile(dbPath).rebuilt;
+    }
+    compaction.after = indexStatistics(dbPath);
+    if (compaction.orphansRemoved > 0 || compaction.vacuumed) {
+        CP_LOG << "RagUtils: Compacted" << dbPath << "from" << compaction.before.databaseBytes << "to"
+               << compaction.after.databaseBytes << "bytes," << compaction.orphansRemoved << "orphaned fragments removed";
+    }
+    return compaction;
 }
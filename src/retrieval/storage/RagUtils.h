@@ -23,9 +23,81 @@
 //
 #pragma once
 
+#include <QByteArray>
+#include <QMap>
 #include <QString>
+#include <QStringList>
 #include <vector>
 
+/**
+ * @brief Encoding of fragments.embedding, chosen per index and recorded in
+ * source_files.embedding_format next to the provider and model.
+ */
+enum class RagEmbeddingFormat {
+    Float32, ///< 4 bytes per dimension
+    Float16, ///< IEEE half precision, 2 bytes per dimension
+    Int8     ///< A float32 scale, then one signed byte per dimension (value = code * scale)
+};
+
+/**
+ * @brief How RagUtils::findMostRelevantChunks() ranks fragments.
+ */
+enum class RagSearchMode {
+    Vector,          ///< Cosine similarity alone
+    Hybrid,          ///< Reciprocal-rank fusion of the vector ranking and BM25 over fragments_fts
+    KeywordPrefilter ///< BM25 picks the candidates; only their vectors are scored, then both ranks are fused
+};
+
+/**
+ * @brief Restricts a search to the fragments of matching source files.
+ *
+ * Every criterion that is set must hold. They are evaluated once per query
+ * against source_files, and only fragments of the matching files are
+ * scored. See RagUtils::parseSearchFilter() for the expression syntax.
+ */
+struct RagSearchFilter {
+    QString pathPrefix;              ///< source_files.file_path starts with this; case-sensitive
+    QStringList fileTypes;           ///< Lower-case extensions without the dot; any of them matches
+    QStringList tags;                ///< Entries of the metadata "tags" array; all of them must be present
+    QMap<QString, QString> metadata; ///< Top-level metadata fields and the values they must equal, as text
+
+    bool isEmpty() const { return pathPrefix.isEmpty() && fileTypes.isEmpty() && tags.isEmpty() && metadata.isEmpty(); }
+};
+
+/**
+ * @brief Tuning for RagUtils::findMostRelevantChunks().
+ */
+struct RagSearchOptions {
+    /// Only fragments of the files this admits are searched; empty searches everything.
+    RagSearchFilter filter;
+    /// Hybrid and KeywordPrefilter fall back to Vector when queryText has no terms or the
+    /// database has no full-text index.
+    RagSearchMode mode {RagSearchMode::Vector};
+    /// Query text matched against fragments_fts; ignored in Vector mode.
+    QString queryText;
+    /// Search the HNSW sidecar (annIndexPath()) when one exists; false always scans every fragment.
+    bool useAnnIndex {true};
+    /// HNSW candidate list size: higher is slower but closer to the exact answer. 0 forces exact search.
+    int ef {128};
+    /// On a quantised index with float32 copies (fragments.embedding_full), re-score the best
+    /// kRescoreFactor * limit candidates from those copies before picking the final results.
+    bool rescore {true};
+    /// Score rows straight from the memory-mapped vector file (vectorFilePath()) when it is current.
+    bool useVectorFile {true};
+    /// Rank an unfiltered exact scan on the GPU when the build has a device path (GpuVectorScorer)
+    /// and the vector file holds at least kMinGpuFragments live rows. The file stays resident in
+    /// device memory across queries; the device's candidates are re-scored on the CPU.
+    bool useGpu {true};
+    /// Score the exact scan on only the first this many dimensions of each embedding, then re-score
+    /// the best kRescoreFactor * limit candidates at full dimension. Meant for Matryoshka models,
+    /// whose leading dimensions carry most of the signal: 256 of 3072 is a twelfth of the work.
+    /// 0, or a size not below the index's, scores full vectors; HNSW searches always do.
+    int coarseDimensions {0};
+    /// Threads an exact scan is split across, the caller included. 0 uses the current run's Cpu budget
+    /// (CpuWorkerPool, or the global pool outside a run); 1 always scans on the calling thread.
+    int threads {0};
+};
+
 /**
  * @brief Helper utilities for working with the RAG SQLite index.
  */
@@ -35,6 +107,11 @@ public:
     struct IndexConfig {
         QString providerId; ///< Embedding provider identifier (e.g. "openai")
         QString modelId;    ///< Embedding model identifier (e.g. "text-embedding-3-small")
+        int dimension {0};  ///< Stored embedding size, or 0 when the index has no fragments
+        /// Size asked of the provider when indexing (source_files.embedding_dimensions); 0 for the
+        /// model's native size. Queries are embedded at `dimension`, which then equals it.
+        int requestedDimensions {0};
+        RagEmbeddingFormat format {RagEmbeddingFormat::Float32};
     };
 
     struct SearchResult {
@@ -44,17 +121,27 @@ public:
         int startLine {0};     ///< 1-based source start line, or 0 when unavailable
         int endLine {0};       ///< 1-based source end line, or 0 when unavailable
         QString content;       ///< fragments.content
+        QString filePath;      ///< source_files.file_path, or empty when the file row is missing
         double score {0.0};    ///< Cosine similarity score in [0,1]
+        double fusedScore {0.0}; ///< Reciprocal-rank fusion score in the lexical modes, else 0
+        QString indexPath;     ///< Database the result came from in a federated search, else empty
+        QStringList duplicatePaths; ///< Other files holding this text, from fragment_sources
+        double rerankScore {-1.0}; ///< Relevance from RAG Accessor's reranking stage in [0,1], or -1 without one
     };
 
     /**
      * @brief Inspect the RAG index and return the unique embedding configuration.
      *
      * Queries the source_files table for distinct (provider, model) pairs.
-     * - If exactly one pair exists, returns it.
+     * - If exactly one pair exists, returns it, along with the dimension of
+     *   the first stored fragment embedding.
      * - If zero rows exist, throws std::runtime_error to signal an empty index.
      * - If more than one distinct pair exists, throws std::runtime_error because
-     *   mixed-model RAG is not supported.
+     *   mixed-model RAG is not supported. The same goes for mixed embedding formats
+     *   and requested dimensions.
+     *
+     * A successful result is cached until RagQueryCache::bumpGeneration() is
+     * called for the path or the database or its WAL changes on disk.
      */
     static IndexConfig getIndexConfig(const QString& dbPath);
 
@@ -68,17 +155,273 @@ public:
     static double cosineSimilarity(const std::vector<float>& a, const std::vector<float>& b);
 
     /**
-     * @brief Brute-force vector similarity search over all fragments.
+     * @brief Vector similarity search over the fragments table.
+     *
+     * With an up-to-date HNSW sidecar next to the database, the index supplies
+     * max(ef, limit) candidates and only those rows, plus any fragments added
+     * after the index was last updated, are read and scored exactly. Without
+     * one (or with options.useAnnIndex false or options.ef 0) every embedding
+     * is scanned. Rows covered by the memory-mapped vector file are scored
+     * from the mapping instead of SQLite; only newer fragments are read from
+     * the database, and should a winner turn out to have been deleted since
+     * the file was last updated the search is repeated against SQLite alone.
+     * A full scan of more than kMinShardFragments ids is split into id-range
+     * shards scored on the Cpu pool (see options.threads), each with its own
+     * top-k heap and connection, and the heaps are merged. An unfiltered
+     * exact scan over a vector file of kMinGpuFragments or more live rows is
+     * ranked on the GPU instead when one is available (options.useGpu): the
+     * device returns each query's candidates, which are re-scored exactly.
+     * Either way the scan reads only ids and embeddings, keeps
+     * the best @p limit scores at or above @p minRelevance, and then fetches
+     * content, line range and file path for those winners in a single query.
+     * Results are sorted by descending cosine score. With options.coarseDimensions
+     * the scan scores only that prefix of each embedding and the best
+     * kRescoreFactor * limit candidates are then re-scored in full.
      *
-     * Loads every embedding from the fragments table, computes cosine similarity
-     * with @p queryEmbedding, filters results below @p minRelevance, sorts them
-     * in descending score order, and returns at most @p limit entries.
+     * In RagSearchMode::Hybrid the vector search above supplies
+     * kHybridCandidateFactor * limit candidates and BM25 over fragments_fts
+     * as many again. Each candidate scores sum(1 / (kReciprocalRankK + rank))
+     * over the rankings it appears in, and results are sorted by that score.
+     * KeywordPrefilter scores vectors for the BM25 candidates alone, which
+     * skips the scan entirely. Keyword matches are kept whatever their cosine
+     * score; @p minRelevance only bounds the vector ranking.
+     *
+     * A non-empty options.filter is resolved to its fragment ids first, and
+     * every ranking above is confined to them. Up to
+     * kMaxFilteredScanFragments matches are scanned directly; larger sets
+     * walk the HNSW sidecar with a filter so only admitted ids fill its
+     * candidate list.
      */
     static std::vector<SearchResult> findMostRelevantChunks(
         const QString& dbPath,
         const std::vector<float>& queryEmbedding,
         int limit,
-        double minRelevance);
+        double minRelevance,
+        const RagSearchOptions& options = {});
+
+    /**
+     * @brief findMostRelevantChunks() for several queries at once.
+     *
+     * Returns one result list per entry of @p queryEmbeddings, each equal to
+     * what findMostRelevantChunks() returns for that embedding alone. The
+     * exact scan makes a single pass: rows are decoded in blocks of 64 and
+     * every block is scored against each query while it is still in cache,
+     * feeding one top-k heap per query. HNSW searches run per query, but a
+     * row reached by several of them is read once. Hybrid and
+     * KeywordPrefilter modes run the queries one after another, each with
+     * its text from @p queryTexts. An empty embedding yields no results.
+     */
+    static std::vector<std::vector<SearchResult>> findMostRelevantChunksBatch(
+        const QString& dbPath,
+        const std::vector<std::vector<float>>& queryEmbeddings,
+        int limit,
+        double minRelevance,
+        const RagSearchOptions& options = {},
+        const QStringList& queryTexts = {});
+
+    /**
+     * @brief Merges one query's results from several indexes into a single top-@p limit list.
+     *
+     * @p modelGroups gives each entry of @p shardResults the embedding model it was
+     * searched with. Indexes sharing a model hold comparable scores, so their lists
+     * are merged by score (fusedScore when every list of the group ranked by it), as
+     * if they were one index. Different models score on different scales: with more
+     * than one group, each result's fusedScore becomes 1 / (kReciprocalRankK + rank)
+     * for its rank within its own group and the groups are interleaved by that,
+     * while score keeps the cosine the index reported. Ties go to the earlier index.
+     */
+    static std::vector<SearchResult> mergeShardResults(
+        std::vector<std::vector<SearchResult>> shardResults,
+        const std::vector<int>& modelGroups,
+        int limit);
+
+    struct AnnIndexUpdate {
+        int added {0};        ///< Fragments inserted into the index by this update
+        int total {0};        ///< Vectors in the index afterwards, deleted fragments included
+        bool rebuilt {false}; ///< The index was rebuilt from scratch
+    };
+
+    /// Sidecar HNSW index file kept next to the RAG database.
+    static QString annIndexPath(const QString& dbPath);
+
+    /**
+     * @brief Brings the HNSW sidecar up to date with the fragments table.
+     *
+     * Fragments newer than the index are added incrementally. The index is
+     * rebuilt when it is missing or unreadable, its dimension no longer
+     * matches, ids have been reused (a cleared database), or more than a
+     * quarter of its vectors belong to deleted fragments. Throws
+     * std::runtime_error when the database cannot be read or the index
+     * cannot be written.
+     */
+    static AnnIndexUpdate updateAnnIndex(const QString& dbPath);
+
+    /// Deletes the sidecar, e.g. after the database has been cleared.
+    static void removeAnnIndex(const QString& dbPath);
+
+    struct VectorFileUpdate {
+        int added {0};        ///< Rows appended by this update
+        int deleted {0};      ///< Rows tombstoned because their fragment is gone
+        qint64 live {0};      ///< Live rows in the file afterwards
+        bool rebuilt {false}; ///< The file was rewritten from scratch
+    };
+
+    /// Memory-mapped vector file kept next to the RAG database.
+    static QString vectorFilePath(const QString& dbPath);
+
+    /**
+     * @brief Brings the vector file up to date with the fragments table.
+     *
+     * Fragments newer than the file are appended; rows whose fragment has
+     * been deleted are tombstoned. The file is rebuilt when it is missing,
+     * unreadable or left dirty by an interrupted update, its format or
+     * dimension no longer matches, or ids have been reused. Throws
+     * std::runtime_error when the database cannot be read or the file
+     * cannot be written.
+     */
+    static VectorFileUpdate updateVectorFile(const QString& dbPath);
+
+    /// Deletes the vector file, e.g. after the database has been cleared.
+    static void removeVectorFile(const QString& dbPath);
+
+    /**
+     * @brief Loads an index into the process-wide caches ahead of its first search.
+     *
+     * Reads the index configuration, loads the HNSW sidecar and maps the
+     * vector file, faulting its pages in. All of them stay cached until their
+     * files or the index's generation change, so a long-lived process pays
+     * for loading them once. A vector file large enough for GPU scoring is
+     * also copied to the device. Without a vector file, the embeddings of a
+     * database up to kMaxWarmedDatabaseBytes are read once so that the first
+     * exact scan finds them in the OS page cache. Returns false when the
+     * database has neither sidecar.
+     */
+    static bool warmIndex(const QString& dbPath);
+    static constexpr qint64 kMaxWarmedDatabaseBytes = qint64(1) << 30;
+
+    /// Candidates each ranking contributes per final result in the lexical search modes.
+    static constexpr int kHybridCandidateFactor = 4;
+
+    /// Rank offset in reciprocal-rank fusion; larger values flatten the advantage of top ranks.
+    static constexpr int kReciprocalRankK = 60;
+
+    /// Most distinct terms of a query that are matched against the full-text index.
+    static constexpr int kMaxFullTextTerms = 32;
+
+    /**
+     * @brief FTS5 MATCH expression for free text: its words and identifiers, quoted and OR-ed.
+     *
+     * Returns an empty string when @p text has no word characters.
+     */
+    static QString fullTextQuery(const QString& text);
+
+    /**
+     * @brief Creates the fragments_fts index and the triggers that keep it in step with fragments.
+     *
+     * A new index is filled from the existing fragments. Returns false when
+     * the index already existed. Throws std::runtime_error on failure, e.g.
+     * when SQLite was built without FTS5.
+     */
+    static bool ensureFullTextIndex(const QString& dbPath);
+
+    /// Drops fragments_fts and its triggers, if present.
+    static void removeFullTextIndex(const QString& dbPath);
+
+    /**
+     * @brief Parses a filter expression such as `path:/src/net type:cpp,h tag:backend owner=alice`.
+     *
+     * Terms are separated by whitespace and a value may be double-quoted to
+     * hold spaces. `path:` sets the path prefix, `type:` adds comma-separated
+     * extensions, `tag:` adds a required tag and `key=value` requires a
+     * metadata field. Throws std::runtime_error on any other term.
+     */
+    static RagSearchFilter parseSearchFilter(const QString& expression);
+
+    /// Matching fragments up to which a filtered search scans them instead of walking the HNSW index.
+    static constexpr qint64 kMaxFilteredScanFragments = 20000;
+
+    /// Candidates re-scored per final result after a quantised or coarse (prefix) pass.
+    static constexpr int kRescoreFactor = 4;
+
+    /// Smallest id range worth a shard of its own in a parallel exact scan.
+    static constexpr qint64 kMinShardFragments = 4096;
+
+    /// Live vector-file rows from which an exact scan is ranked on the GPU; below it the upload and
+    /// launch cost more than the sharded CPU scan.
+    static constexpr qint64 kMinGpuFragments = 500000;
+
+    /// "float32", "float16" or "int8"; unknown names read as Float32.
+    static QString embeddingFormatName(RagEmbeddingFormat format);
+    static RagEmbeddingFormat embeddingFormatFromName(const QString& name);
+
+    /// Bytes one stored embedding of @p dimension takes in @p format.
+    static int embeddingBlobSize(RagEmbeddingFormat format, int dimension);
+
+    /// Serialises an embedding for fragments.embedding, scaled to unit length first.
+    static QByteArray encodeEmbedding(const std::vector<float>& embedding,
+                                      RagEmbeddingFormat format = RagEmbeddingFormat::Float32);
+
+    /// Inverse of encodeEmbedding(); returns an empty vector for a malformed blob.
+    static std::vector<float> decodeEmbedding(const QByteArray& blob, RagEmbeddingFormat format);
+
+    /**
+     * @brief Brings a database's stored embeddings up to kRagNormalizedEmbeddingsVersion.
+     *
+     * Databases written before that version store vectors as the provider
+     * returned them. Each one is rescaled to unit length in place and
+     * PRAGMA user_version is set, all in one transaction. A vector file made
+     * from the old blobs is deleted. Returns the number of fragments
+     * rewritten; throws std::runtime_error on failure.
+     */
+    static int normalizeStoredEmbeddings(const QString& dbPath);
+
+    struct IndexStatistics {
+        qint64 files {0};                 ///< Rows in source_files
+        qint64 fragments {0};             ///< Rows in fragments
+        qint64 orphanedFragments {0};     ///< Fragments whose source_files row is gone
+        RagEmbeddingFormat format {RagEmbeddingFormat::Float32};
+        QMap<int, qint64> dimensions;     ///< Fragments per embedding dimension; 0 for malformed blobs
+        double bytesPerVector {0.0};      ///< Mean stored bytes per fragment, float32 copies included
+        qint64 pageSize {0};
+        qint64 pageCount {0};
+        qint64 freePages {0};             ///< Pages on the freelist, which a scan still reads past
+        bool incrementalVacuum {false};   ///< PRAGMA auto_vacuum is INCREMENTAL
+        qint64 databaseBytes {0};         ///< The database file and its WAL
+        qint64 sidecarBytes {0};          ///< The HNSW and vector files
+
+        /// Share of the database's pages that are free.
+        double fragmentation() const { return pageCount > 0 ? double(freePages) / double(pageCount) : 0.0; }
+    };
+
+    /// Counts and sizes of the index at @p dbPath; throws std::runtime_error when it cannot be read.
+    static IndexStatistics indexStatistics(const QString& dbPath);
+
+    struct IndexCompaction {
+        IndexStatistics before;
+        IndexStatistics after;
+        qint64 orphansRemoved {0};   ///< Orphaned fragments deleted
+        bool vacuumed {false};       ///< A full VACUUM rewrote the database
+        bool annIndexRebuilt {false};
+        bool vectorFileRebuilt {false};
+    };
+
+    /// Free pages above this share of the file make compactIndex() rewrite it with a full VACUUM.
+    static constexpr double kVacuumFragmentation = 0.1;
+
+    /**
+     * @brief Reclaims the space re-indexing leaves behind and reports the index before and after.
+     *
+     * Orphaned fragments are deleted and the full-text index, if any, is
+     * merged into one segment. A database with incremental auto-vacuum whose
+     * free pages are at most kVacuumFragmentation of the file only has them
+     * released with PRAGMA incremental_vacuum. Otherwise a full VACUUM
+     * rewrites every table in rowid order, switching the database to
+     * incremental auto-vacuum on the way, so later runs are cheap. The WAL
+     * is then truncated, and an existing HNSW sidecar and vector file are
+     * rebuilt from scratch in fragments.id order without their deleted
+     * rows. Fragment ids never change. Throws std::runtime_error on failure.
+     */
+    static IndexCompaction compactIndex(const QString& dbPath);
 };
 
 /**
@@ -91,7 +434,7 @@ public:
 /**
  * @brief SQL schema for the RAG database with normalized multi-table design.
  *
- * The schema consists of two tables:
+ * The schema consists of four tables:
  * 
  * 1. `source_files` - Tracks file-level metadata and embedding model information
  *    Columns:
@@ -99,8 +442,14 @@ public:
  *    - file_path: TEXT UNIQUE - The source document path
  *    - provider: TEXT - Embedding provider (e.g., "openai", "google")
  *    - model: TEXT - Embedding model ID (e.g., "text-embedding-3-small")
- *    - last_modified: INTEGER - Timestamp for future incremental updates
+ *    - last_modified: INTEGER - The file's modification time when indexed, in milliseconds since the epoch
  *    - metadata: TEXT - JSON string for tags and additional metadata
+ *    - embedding_format: TEXT - Encoding of the file's fragment embeddings ("float32", "float16" or "int8")
+ *    - file_size: INTEGER - The file's size in bytes when indexed
+ *    - content_hash: TEXT - SHA-256 of the indexed text; NULL until every chunk has been stored
+ *    - chunking: TEXT - Chunking strategy, size and overlap the fragments were cut with
+ *    - embedding_dimensions: INTEGER - Size asked of the provider for the embeddings, 0 for the model's native size
+ *    - file_type: TEXT - Generated: lower-case extension of the file name, '' when it has none
  *
  * 2. `fragments` - Stores text chunks with their embeddings
  *    Columns:
@@ -110,16 +459,48 @@ public:
  *    - start_line: INTEGER - 1-based source start line for the chunk
  *    - end_line: INTEGER - 1-based source end line for the chunk
  *    - content: TEXT - The actual text chunk
- *    - embedding: BLOB - The raw binary representation of the vector (float array)
+ *    - embedding: BLOB - The vector encoded in the index's embedding_format,
+ *      L2-normalised from kRagNormalizedEmbeddingsVersion
+ *    - embedding_full: BLOB - Optional float32 copy of a quantised embedding, for rescoring
+ *    - content_hash: INTEGER - Leading 8 bytes of the content's SHA-256, NULL when deduplication was off
+ *    - simhash: INTEGER - 64-bit SimHash of the content, set only with near-duplicate detection
+ *
+ * 3. `fragment_sources` - Further chunks whose text is stored in a fragment
+ *    Columns:
+ *    - fragment_id: INTEGER - Foreign key to the fragments.id holding the text and embedding
+ *    - file_id, chunk_index, start_line, end_line - The duplicate chunk's own position
+ *
+ * 4. `index_jobs` - One row per indexed directory describing its latest run
+ *    Columns:
+ *    - directory: TEXT UNIQUE - Absolute path of the scanned directory
+ *    - state: TEXT - "running", "completed", "cancelled" or "failed"; a crashed run stays "running"
+ *    - files_total: INTEGER - Files the run had to check
+ *    - files_done: INTEGER - Files written as of the last checkpoint commit
+ *    - updated_at: INTEGER - Milliseconds since the epoch of the last update
  *
  * Foreign keys are enabled to maintain referential integrity.
  * 
  * Note: Since QSqlQuery::exec() cannot execute multiple statements at once,
  * these need to be executed separately. See kRagSchemaPragma, kRagSchemaSourceFiles,
- * and kRagSchemaFragments below.
+ * kRagSchemaFragments, kRagSchemaFragmentSources and kRagSchemaIndexJobs below.
  */
 constexpr const char* kRagSchemaPragma = "PRAGMA foreign_keys = ON";
 
+/// Persistent once set: queries read the last committed state while an indexing transaction is open.
+constexpr const char* kRagSchemaJournalMode = "PRAGMA journal_mode = WAL";
+
+/// Set before the first table is created, so RagUtils::compactIndex() can release free pages incrementally.
+constexpr const char* kRagSchemaAutoVacuum = "PRAGMA auto_vacuum = INCREMENTAL";
+
+/**
+ * @brief PRAGMA user_version from which fragments.embedding holds unit-length vectors.
+ *
+ * Search on such a database scores with a plain dot product; older databases
+ * fall back to full cosine similarity until RagUtils::normalizeStoredEmbeddings()
+ * has migrated them.
+ */
+constexpr int kRagNormalizedEmbeddingsVersion = 1;
+
 constexpr const char* kRagSchemaSourceFiles = R"(
 CREATE TABLE IF NOT EXISTS source_files (
     id INTEGER PRIMARY KEY AUTOINCREMENT,
@@ -127,7 +508,12 @@ CREATE TABLE IF NOT EXISTS source_files (
     provider TEXT NOT NULL,
     model TEXT NOT NULL,
     last_modified INTEGER,
-    metadata TEXT
+    metadata TEXT,
+    embedding_format TEXT NOT NULL DEFAULT 'float32',
+    file_size INTEGER,
+    content_hash TEXT,
+    chunking TEXT,
+    embedding_dimensions INTEGER NOT NULL DEFAULT 0
 )
 )";
 
@@ -140,10 +526,114 @@ CREATE TABLE IF NOT EXISTS fragments (
     end_line INTEGER,
     content TEXT NOT NULL,
     embedding BLOB,
+    embedding_full BLOB,
+    content_hash INTEGER,
+    simhash INTEGER,
+    FOREIGN KEY (file_id) REFERENCES source_files(id) ON DELETE CASCADE
+)
+)";
+
+/**
+ * @brief Further places a deduplicated fragment's text occurs.
+ *
+ * A chunk whose text the index already holds, exactly or within SimHash
+ * distance (DuplicateIndex), gets a row here instead of a fragment and an
+ * embedding of its own. fragments.content_hash and fragments.simhash are
+ * what new chunks are matched against. When the owning file's fragments are
+ * deleted, each shared fragment passes to its oldest remaining source.
+ */
+constexpr const char* kRagSchemaFragmentSources = R"(
+CREATE TABLE IF NOT EXISTS fragment_sources (
+    id INTEGER PRIMARY KEY,
+    fragment_id INTEGER NOT NULL,
+    file_id INTEGER NOT NULL,
+    chunk_index INTEGER NOT NULL,
+    start_line INTEGER,
+    end_line INTEGER,
+    FOREIGN KEY (fragment_id) REFERENCES fragments(id) ON DELETE CASCADE,
     FOREIGN KEY (file_id) REFERENCES source_files(id) ON DELETE CASCADE
 )
 )";
 
+/**
+ * @brief Optional BM25 index over fragments.content for the lexical search modes.
+ *
+ * An external-content FTS5 table: it stores only the inverted index and
+ * reads text from fragments. The triggers below keep it current for every
+ * insert, delete and content update, whichever connection makes them.
+ */
+constexpr const char* kRagSchemaFragmentsFts =
+    "CREATE VIRTUAL TABLE IF NOT EXISTS fragments_fts USING fts5(content, content='fragments', content_rowid='id')";
+
+constexpr const char* kRagSchemaFragmentsFtsTriggers[] = {
+    "CREATE TRIGGER IF NOT EXISTS fragments_fts_insert AFTER INSERT ON fragments BEGIN "
+    "INSERT INTO fragments_fts(rowid, content) VALUES (new.id, new.content); END",
+    "CREATE TRIGGER IF NOT EXISTS fragments_fts_delete AFTER DELETE ON fragments BEGIN "
+    "INSERT INTO fragments_fts(fragments_fts, rowid, content) VALUES ('delete', old.id, old.content); END",
+    "CREATE TRIGGER IF NOT EXISTS fragments_fts_update AFTER UPDATE OF content ON fragments BEGIN "
+    "INSERT INTO fragments_fts(fragments_fts, rowid, content) VALUES ('delete', old.id, old.content); "
+    "INSERT INTO fragments_fts(rowid, content) VALUES (new.id, new.content); END",
+};
+
+/**
+ * @brief Generated column and indexes behind search filters (RagSearchFilter).
+ *
+ * SQLite derives file_type from file_path, so rows written before the
+ * column existed carry it too. It is VIRTUAL, which lets ALTER TABLE add it
+ * to an existing source_files table.
+ */
+constexpr const char* kRagSourceFileTypeExpression =
+    // The name after the last '/', then what follows its last '.'; rtrim() strips
+    // every character except the separator, so it cuts back to that separator
+    "CASE WHEN instr(replace(file_path, rtrim(file_path, replace(file_path, '/', '')), ''), '.') > 0 "
+    "THEN lower(replace(replace(file_path, rtrim(file_path, replace(file_path, '/', '')), ''), "
+    "rtrim(replace(file_path, rtrim(file_path, replace(file_path, '/', '')), ''), "
+    "replace(replace(file_path, rtrim(file_path, replace(file_path, '/', '')), ''), '.', '')), '')) "
+    "ELSE '' END";
+
+constexpr const char* kRagSchemaSourceFileTypeColumn =
+    "ALTER TABLE source_files ADD COLUMN file_type TEXT GENERATED ALWAYS AS (%1) VIRTUAL";
+
+constexpr const char* kRagSchemaSearchFilterIndexes[] = {
+    "CREATE INDEX IF NOT EXISTS idx_source_files_file_type ON source_files(file_type)",
+};
+
+/**
+ * @brief Secondary indexes on fragments, created on every open so older databases gain them.
+ *
+ * Without idx_fragments_file_id, each ON DELETE CASCADE from source_files and
+ * each per-file fragment delete scans the whole fragments table; a search
+ * filter also uses it to find a file's fragments. The others serve the
+ * duplicate lookups and fragment_sources. A bulk load drops the
+ * indexes named in kRagSchemaSecondaryIndexNames and builds them once at
+ * the end.
+ */
+constexpr const char* kRagSchemaFragmentIndexes[] = {
+    "CREATE INDEX IF NOT EXISTS idx_fragments_file_id ON fragments(file_id)",
+    "CREATE INDEX IF NOT EXISTS idx_fragments_content_hash ON fragments(content_hash) WHERE content_hash IS NOT NULL",
+    "CREATE INDEX IF NOT EXISTS idx_fragment_sources_fragment_id ON fragment_sources(fragment_id)",
+    "CREATE INDEX IF NOT EXISTS idx_fragment_sources_file_id ON fragment_sources(file_id)",
+};
+
+constexpr const char* kRagSchemaSecondaryIndexNames[] = {
+    "idx_source_files_file_type",
+    "idx_fragments_file_id",
+    "idx_fragments_content_hash",
+    "idx_fragment_sources_fragment_id",
+    "idx_fragment_sources_file_id",
+};
+
+constexpr const char* kRagSchemaIndexJobs = R"(
+CREATE TABLE IF NOT EXISTS index_jobs (
+    id INTEGER PRIMARY KEY AUTOINCREMENT,
+    directory TEXT UNIQUE NOT NULL,
+    state TEXT NOT NULL,
+    files_total INTEGER,
+    files_done INTEGER,
+    updated_at INTEGER
+)
+)";
+
 // Legacy combined schema (deprecated - kept for reference)
 constexpr const char* kRagSchema = R"(
 PRAGMA foreign_keys = ON;
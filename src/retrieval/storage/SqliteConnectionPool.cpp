@@ -0,0 +1,264 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "SqliteConnectionPool.h"
+
+#include "Logger.h"
+
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QHash>
+#include <QList>
+#include <QSqlError>
+#include <QStringList>
+#include <QUuid>
+#include <QVariant>
+
+#include <utility>
+
+namespace {
+
+struct PooledConnection {
+    QString path;
+    QString name;
+    int schemaVersion {-1};
+    QHash<QString, QSet<QString>> columns; // valid for schemaVersion
+    QHash<QString, QSqlQuery> statements;
+    QStringList statementOrder; // most recently prepared last
+};
+
+// Statements must be gone before their connection is removed
+void closeConnection(PooledConnection connection)
+{
+    connection.statements.clear();
+    const QString name = connection.name;
+    {
+        QSqlDatabase db = QSqlDatabase::database(name, false);
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(name);
+}
+
+// The calling thread's connections, most recently used first
+class ThreadConnections {
+public:
+    ~ThreadConnections()
+    {
+        // At process exit the SQL driver may already be gone; the OS reclaims the handles
+        if (!QCoreApplication::instance()) {
+            return;
+        }
+        for (PooledConnection& connection : m_connections) {
+            closeConnection(std::move(connection));
+        }
+    }
+
+    PooledConnection* find(const QString& path)
+    {
+        for (int i = 0; i < m_connections.size(); ++i) {
+            if (m_connections[i].path == path) {
+                if (i > 0) {
+                    m_connections.move(i, 0);
+                }
+                return &m_connections.first();
+            }
+        }
+        return nullptr;
+    }
+
+    PooledConnection* findByName(const QString& name)
+    {
+        for (PooledConnection& connection : m_connections) {
+            if (connection.name == name) {
+                return &connection;
+            }
+        }
+        return nullptr;
+    }
+
+    PooledConnection& add(const QString& path, const QString& name)
+    {
+        while (m_connections.size() >= SqliteConnectionPool::kMaxConnectionsPerThread) {
+            closeConnection(m_connections.takeLast());
+        }
+        m_connections.prepend(PooledConnection {path, name});
+        return m_connections.first();
+    }
+
+    void remove(const QString& path)
+    {
+        for (int i = 0; i < m_connections.size(); ++i) {
+            if (m_connections[i].path == path) {
+                closeConnection(m_connections.takeAt(i));
+                return;
+            }
+        }
+    }
+
+    void clear()
+    {
+        while (!m_connections.isEmpty()) {
+            closeConnection(m_connections.takeLast());
+        }
+    }
+
+    int size() const { return static_cast<int>(m_connections.size()); }
+
+private:
+    QList<PooledConnection> m_connections;
+};
+
+ThreadConnections& threadConnections()
+{
+    thread_local ThreadConnections connections;
+    return connections;
+}
+
+void tune(QSqlDatabase& db)
+{
+    QSqlQuery query(db);
+    // Best effort: a read-only file or directory keeps its existing journal mode
+    query.exec(QStringLiteral("PRAGMA journal_mode=WAL"));
+    query.exec(QStringLiteral("PRAGMA synchronous=NORMAL"));
+    query.exec(QStringLiteral("PRAGMA mmap_size=%1").arg(SqliteConnectionPool::kMmapSizeBytes));
+    query.exec(QStringLiteral("PRAGMA cache_size=-%1").arg(SqliteConnectionPool::kCacheSizeKiB));
+    query.exec(QStringLiteral("PRAGMA temp_store=MEMORY"));
+}
+
+} // namespace
+
+QSqlDatabase SqliteConnectionPool::connection(const QString& path, QString* error)
+{
+    ThreadConnections& connections = threadConnections();
+    if (PooledConnection* pooled = connections.find(path)) {
+        QSqlDatabase db = QSqlDatabase::database(pooled->name, false);
+        // A deleted file would otherwise stay readable through the old handle
+        if (db.isOpen() && QFileInfo::exists(path)) {
+            return db;
+        }
+        connections.remove(path);
+    }
+
+    const QString name = QStringLiteral("sqlite_pool_%1").arg(QUuid::createUuid().toString(QUuid::Id128));
+    bool opened = false;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), name);
+        db.setDatabaseName(path);
+        db.setConnectOptions(QStringLiteral("QSQLITE_BUSY_TIMEOUT=%1").arg(kBusyTimeoutMs));
+        opened = db.open();
+        if (!opened) {
+            if (error) {
+                *error = db.lastError().text();
+            }
+            CP_WARN << "SqliteConnectionPool: failed to open" << path << ":" << db.lastError().text();
+        } else {
+            tune(db);
+        }
+    }
+    if (!opened) {
+        QSqlDatabase::removeDatabase(name);
+        return QSqlDatabase();
+    }
+
+    connections.add(path, name);
+    return QSqlDatabase::database(name, false);
+}
+
+QSet<QString> SqliteConnectionPool::columns(QSqlDatabase& db, const QString& table)
+{
+    QSqlQuery query(db);
+    int schemaVersion = -1;
+    if (query.exec(QStringLiteral("PRAGMA schema_version")) && query.next()) {
+        schemaVersion = query.value(0).toInt();
+    }
+
+    PooledConnection* pooled = threadConnections().findByName(db.connectionName());
+    const QString key = table.toLower();
+    if (pooled && schemaVersion >= 0) {
+        if (pooled->schemaVersion != schemaVersion) {
+            pooled->columns.clear();
+            pooled->schemaVersion = schemaVersion;
+        }
+        const auto it = pooled->columns.constFind(key);
+        if (it != pooled->columns.constEnd()) {
+            return *it;
+        }
+    }
+
+    QSet<QString> names;
+    // table_xinfo, unlike table_info, also lists generated columns
+    if (query.exec(QStringLiteral("PRAGMA table_xinfo(%1)").arg(table))) {
+        while (query.next()) {
+            names.insert(query.value(1).toString().toLower());
+        }
+    }
+    if (pooled && schemaVersion >= 0) {
+        pooled->columns.insert(key, names);
+    }
+    return names;
+}
+
+bool SqliteConnectionPool::hasColumn(QSqlDatabase& db, const QString& table, const QString& column)
+{
+    return columns(db, table).contains(column.toLower());
+}
+
+QSqlQuery SqliteConnectionPool::statement(QSqlDatabase& db, const QString& sql)
+{
+    PooledConnection* pooled = threadConnections().findByName(db.connectionName());
+    if (pooled) {
+        const auto it = pooled->statements.constFind(sql);
+        if (it != pooled->statements.constEnd()) {
+            QSqlQuery query = *it;
+            query.finish();
+            return query;
+        }
+    }
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if (!query.prepare(sql) || !pooled) {
+        return query;
+    }
+    if (pooled->statementOrder.size() >= kMaxStatementsPerConnection) {
+        pooled->statements.remove(pooled->statementOrder.takeFirst());
+    }
+    pooled->statements.insert(sql, query);
+    pooled->statementOrder.append(sql);
+    return query;
+}
+
+void SqliteConnectionPool::close(const QString& path)
+{
+    threadConnections().remove(path);
+}
+
+void SqliteConnectionPool::closeAll()
+{
+    threadConnections().clear();
+}
+
+int SqliteConnectionPool::openConnections()
+{
+    return threadConnections().size();
+}
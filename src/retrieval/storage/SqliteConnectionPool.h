@@ -0,0 +1,87 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QSet>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+
+/**
+ * @brief Long-lived SQLite connections, one per thread and database path.
+ *
+ * Qt SQL connections may only be used by the thread that created them, so
+ * each thread keeps its own few connections. A connection is opened on first
+ * use and reused by every later call. It is tuned once when it opens: a busy
+ * timeout, journal_mode=WAL (readers no longer block a writer), synchronous=
+ * NORMAL, mmap_size, cache_size and temp_store=MEMORY. Each thread keeps up to
+ * kMaxConnectionsPerThread paths open, dropping the least recently used. A
+ * connection is reopened if its file has disappeared, and a thread's
+ * connections close when the thread exits. Statements prepared through
+ * statement() live as long as their connection.
+ *
+ * Callers borrow the connection. They must not close or remove it, and they
+ * must end any transaction they start before returning.
+ */
+class SqliteConnectionPool
+{
+public:
+    static constexpr int kMaxConnectionsPerThread = 8;
+    static constexpr int kBusyTimeoutMs = 5000;
+    static constexpr qint64 kMmapSizeBytes = 256LL * 1024 * 1024;
+    static constexpr int kCacheSizeKiB = 16 * 1024;
+    static constexpr int kMaxStatementsPerConnection = 32;
+
+    /// The calling thread's open connection to @p path; an invalid database with @p error set on failure.
+    static QSqlDatabase connection(const QString& path, QString* error = nullptr);
+
+    /**
+     * @brief Lower-cased column names of @p table (empty when it does not exist).
+     *
+     * Cached per connection until PRAGMA schema_version changes, so repeated
+     * probes cost one pragma rather than a table_info scan.
+     */
+    static QSet<QString> columns(QSqlDatabase& db, const QString& table);
+    static bool hasColumn(QSqlDatabase& db, const QString& table, const QString& column);
+
+    /**
+     * @brief @p sql prepared on @p db, reused by later calls with the same text.
+     *
+     * The returned query shares the cached statement: bind, exec and read it,
+     * then finish() it to release its read snapshot, before asking for the
+     * same statement again. Keep the SQL text fixed and
+     * pass varying values as bindings, or every call prepares anew. Up to
+     * kMaxStatementsPerConnection statements are kept per connection;
+     * connections not from the pool get a fresh, uncached statement. On a
+     * failed prepare the query is returned anyway, and its lastError() says why.
+     */
+    static QSqlQuery statement(QSqlDatabase& db, const QString& sql);
+
+    /// Closes the calling thread's connection to @p path, e.g. before deleting the file.
+    static void close(const QString& path);
+    /// Closes every connection the calling thread holds.
+    static void closeAll();
+    /// Connections the calling thread holds open.
+    static int openConnections();
+};
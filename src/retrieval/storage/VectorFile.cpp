@@ -0,0 +1,327 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "VectorFile.h"
+
+#include <QDir>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr quint32 kFileMagic = 0x46565043; // "CPVF"
+constexpr quint32 kFileVersion = 1;
+constexpr quint32 kStateDirty = 0;
+constexpr quint32 kStateClean = 1;
+constexpr qint64 kHeaderBytes = VectorFile::kRowAlignment;
+constexpr qint64 kMinCapacity = 1024;
+
+// Native byte order; a foreign file fails the magic check and is rebuilt
+struct FileHeader {
+    quint32 magic;
+    quint32 version;
+    quint32 state;
+    quint32 format;
+    quint32 dimension;
+    quint32 rowBytes;
+    quint32 stride;
+    quint32 reserved;
+    quint64 capacity;
+    quint64 maxId;
+    quint64 liveCount;
+    quint64 padding;
+};
+static_assert(sizeof(FileHeader) == kHeaderBytes, "vector file header must fill one row alignment unit");
+
+qint64 bitmapBytes(qint64 capacity)
+{
+    return (capacity + 7) / 8;
+}
+
+bool setError(QString* error, const QString& message)
+{
+    if (error) {
+        *error = message;
+    }
+    return false;
+}
+
+} // namespace
+
+VectorFile::~VectorFile()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+    }
+}
+
+qint64 VectorFile::strideFor(int rowBytes)
+{
+    return (static_cast<qint64>(rowBytes) + kRowAlignment - 1) / kRowAlignment * kRowAlignment;
+}
+
+qint64 VectorFile::bitmapOffset(qint64 capacity) const
+{
+    return kHeaderBytes + capacity * m_stride;
+}
+
+qint64 VectorFile::fileSizeFor(qint64 capacity) const
+{
+    return bitmapOffset(capacity) + bitmapBytes(capacity);
+}
+
+bool VectorFile::readHeader(QString* error)
+{
+    FileHeader header {};
+    if (m_file.read(reinterpret_cast<char*>(&header), sizeof(header)) != static_cast<qint64>(sizeof(header))) {
+        return setError(error, QStringLiteral("truncated header"));
+    }
+    if (header.magic != kFileMagic || header.version != kFileVersion) {
+        return setError(error, QStringLiteral("not a vector file, or an unsupported version"));
+    }
+    if (header.state != kStateClean) {
+        return setError(error, QStringLiteral("an update did not finish"));
+    }
+    if (header.rowBytes == 0 || header.stride != strideFor(static_cast<int>(header.rowBytes))
+        || header.maxId > header.capacity || header.liveCount > header.maxId) {
+        return setError(error, QStringLiteral("inconsistent header"));
+    }
+
+    m_format = static_cast<int>(header.format);
+    m_dimension = static_cast<int>(header.dimension);
+    m_rowBytes = static_cast<int>(header.rowBytes);
+    m_stride = static_cast<int>(header.stride);
+    m_capacity = static_cast<qint64>(header.capacity);
+    m_maxId = static_cast<qint64>(header.maxId);
+    m_liveCount = static_cast<qint64>(header.liveCount);
+    if (m_file.size() < fileSizeFor(m_capacity)) {
+        return setError(error, QStringLiteral("file is shorter than its header claims"));
+    }
+
+    m_tombstones.resize(static_cast<int>(bitmapBytes(m_capacity)));
+    if (!m_file.seek(bitmapOffset(m_capacity))
+        || m_file.read(m_tombstones.data(), m_tombstones.size()) != m_tombstones.size()) {
+        return setError(error, QStringLiteral("truncated tombstone bitmap"));
+    }
+    return true;
+}
+
+bool VectorFile::writeHeader(bool clean, QString* error)
+{
+    FileHeader header {};
+    header.magic = kFileMagic;
+    header.version = kFileVersion;
+    header.state = clean ? kStateClean : kStateDirty;
+    header.format = static_cast<quint32>(m_format);
+    header.dimension = static_cast<quint32>(m_dimension);
+    header.rowBytes = static_cast<quint32>(m_rowBytes);
+    header.stride = static_cast<quint32>(m_stride);
+    header.capacity = static_cast<quint64>(m_capacity);
+    header.maxId = static_cast<quint64>(m_maxId);
+    header.liveCount = static_cast<quint64>(m_liveCount);
+    if (!m_file.seek(0)
+        || m_file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != static_cast<qint64>(sizeof(header))
+        || !m_file.flush()) {
+        return setError(error, m_file.errorString());
+    }
+    return true;
+}
+
+bool VectorFile::beginUpdate(QString* error)
+{
+    if (!m_writable) {
+        return setError(error, QStringLiteral("vector file is open read-only"));
+    }
+    if (!m_dirty) {
+        if (!writeHeader(false, error)) {
+            return false;
+        }
+        m_dirty = true;
+    }
+    return true;
+}
+
+std::unique_ptr<VectorFile> VectorFile::open(const QString& path, QString* error)
+{
+    std::unique_ptr<VectorFile> file(new VectorFile());
+    file->m_file.setFileName(path);
+    if (!file->m_file.open(QIODevice::ReadOnly)) {
+        setError(error, file->m_file.errorString());
+        return nullptr;
+    }
+    if (!file->readHeader(error)) {
+        return nullptr;
+    }
+    // Only the rows in use are mapped; spare capacity and the bitmap stay on disk
+    if (file->m_maxId > 0) {
+        file->m_map = file->m_file.map(0, kHeaderBytes + file->m_maxId * file->m_stride);
+        if (!file->m_map) {
+            setError(error, file->m_file.errorString());
+            return nullptr;
+        }
+    }
+    return file;
+}
+
+void VectorFile::prefetch() const
+{
+    if (!m_map) {
+        return;
+    }
+    // One read per page is enough for the kernel to fault it in
+    constexpr qint64 kPageBytes = 4096;
+    const qint64 mapped = kHeaderBytes + m_maxId * m_stride;
+    uchar sum = 0;
+    for (qint64 offset = 0; offset < mapped; offset += kPageBytes) {
+        sum ^= static_cast<const volatile uchar*>(m_map)[offset];
+    }
+    Q_UNUSED(sum);
+}
+
+std::unique_ptr<VectorFile> VectorFile::openForUpdate(const QString& path, QString* error)
+{
+    std::unique_ptr<VectorFile> file(new VectorFile());
+    file->m_file.setFileName(path);
+    if (!file->m_file.open(QIODevice::ReadWrite)) {
+        setError(error, file->m_file.errorString());
+        return nullptr;
+    }
+    if (!file->readHeader(error)) {
+        return nullptr;
+    }
+    file->m_writable = true;
+    return file;
+}
+
+std::unique_ptr<VectorFile> VectorFile::create(const QString& path, int format, int dimension, int rowBytes,
+                                               QString* error)
+{
+    if (rowBytes <= 0) {
+        setError(error, QStringLiteral("row size must be positive"));
+        return nullptr;
+    }
+
+    // Unlink rather than truncate, so a reader still mapping the old file keeps its pages
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    if (QFileInfo::exists(path) && !QFile::remove(path)) {
+        setError(error, QStringLiteral("cannot replace existing file"));
+        return nullptr;
+    }
+
+    std::unique_ptr<VectorFile> file(new VectorFile());
+    file->m_file.setFileName(path);
+    if (!file->m_file.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        setError(error, file->m_file.errorString());
+        return nullptr;
+    }
+    file->m_writable = true;
+    file->m_format = format;
+    file->m_dimension = dimension;
+    file->m_rowBytes = rowBytes;
+    file->m_stride = static_cast<int>(strideFor(rowBytes));
+    if (!file->beginUpdate(error)) {
+        return nullptr;
+    }
+    return file;
+}
+
+bool VectorFile::isDeleted(qint64 id) const
+{
+    if (id < 1 || id > m_maxId) {
+        return true;
+    }
+    const qint64 slot = id - 1;
+    return (static_cast<uchar>(m_tombstones.at(static_cast<int>(slot / 8))) >> (slot % 8)) & 1u;
+}
+
+const char* VectorFile::row(qint64 id) const
+{
+    if (!m_map || isDeleted(id)) {
+        return nullptr;
+    }
+    return reinterpret_cast<const char*>(m_map + kHeaderBytes + (id - 1) * m_stride);
+}
+
+bool VectorFile::append(qint64 id, const QByteArray& row, QString* error)
+{
+    if (id <= m_maxId) {
+        return setError(error, QStringLiteral("ids must be appended in ascending order"));
+    }
+    if (row.size() != m_rowBytes) {
+        return setError(error, QStringLiteral("row is %1 bytes, expected %2").arg(row.size()).arg(m_rowBytes));
+    }
+    if (!beginUpdate(error)) {
+        return false;
+    }
+
+    if (id > m_capacity) {
+        // Rows stay where they are; only the bitmap moves to the new end
+        const qint64 capacity = std::max({id, m_capacity * 2, kMinCapacity});
+        if (!m_file.resize(fileSizeFor(capacity))) {
+            return setError(error, m_file.errorString());
+        }
+        const int oldBytes = m_tombstones.size();
+        m_tombstones.resize(static_cast<int>(bitmapBytes(capacity)));
+        std::memset(m_tombstones.data() + oldBytes, 0xFF, static_cast<size_t>(m_tombstones.size() - oldBytes));
+        m_capacity = capacity;
+    }
+
+    if (!m_file.seek(kHeaderBytes + (id - 1) * m_stride) || m_file.write(row) != row.size()) {
+        return setError(error, m_file.errorString());
+    }
+    // Ids skipped between the old maxId and this one keep their tombstones from the fill above
+    const qint64 slot = id - 1;
+    m_tombstones[static_cast<int>(slot / 8)] = static_cast<char>(
+        static_cast<uchar>(m_tombstones.at(static_cast<int>(slot / 8))) & ~(1u << (slot % 8)));
+    m_maxId = id;
+    ++m_liveCount;
+    return true;
+}
+
+void VectorFile::markDeleted(qint64 id)
+{
+    if (isDeleted(id) || !beginUpdate(nullptr)) {
+        return;
+    }
+    const qint64 slot = id - 1;
+    m_tombstones[static_cast<int>(slot / 8)] = static_cast<char>(
+        static_cast<uchar>(m_tombstones.at(static_cast<int>(slot / 8))) | (1u << (slot % 8)));
+    --m_liveCount;
+}
+
+bool VectorFile::commit(QString* error)
+{
+    if (!m_dirty) {
+        return true;
+    }
+    if (!m_file.seek(bitmapOffset(m_capacity)) || m_file.write(m_tombstones) != m_tombstones.size()) {
+        return setError(error, m_file.errorString());
+    }
+    if (!writeHeader(true, error)) {
+        return false;
+    }
+    m_dirty = false;
+    return true;
+}
@@ -0,0 +1,123 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include <cstdint>
+#include <memory>
+
+/**
+ * @brief Contiguous, memory-mapped copy of the fragments.embedding column.
+ *
+ * Slot i holds the embedding of fragments.id == i + 1, so rows line up with
+ * the SQLite ids and can be scored straight from the mapping. The layout is
+ *
+ *   header (64 bytes) | capacity rows of stride() bytes | tombstone bitmap
+ *
+ * with every row starting on a kRowAlignment boundary. A set tombstone bit
+ * marks a deleted fragment or an id that never held a row. Rows are only
+ * ever appended, so a reader's mapping stays valid while a writer adds new
+ * ones; the writer marks the header dirty for the duration of an update so
+ * an interrupted one is detected and rebuilt. SQLite remains the source of
+ * truth: the file holds nothing that cannot be regenerated from it.
+ */
+class VectorFile
+{
+public:
+    static constexpr int kRowAlignment = 64;
+
+    /// Maps an existing file read-only; nullptr (with @p error set) when missing, dirty or malformed.
+    static std::unique_ptr<VectorFile> open(const QString& path, QString* error = nullptr);
+
+    /// Opens an existing file for appends and tombstones; not mapped.
+    static std::unique_ptr<VectorFile> openForUpdate(const QString& path, QString* error = nullptr);
+
+    /// Creates an empty file (replacing any existing one) for rows of @p rowBytes bytes.
+    static std::unique_ptr<VectorFile> create(const QString& path, int format, int dimension, int rowBytes,
+                                              QString* error = nullptr);
+
+    ~VectorFile();
+
+    VectorFile(const VectorFile&) = delete;
+    VectorFile& operator=(const VectorFile&) = delete;
+
+    /// Caller-defined encoding tag (RagEmbeddingFormat for the RAG index).
+    int format() const { return m_format; }
+    int dimension() const { return m_dimension; }
+    int rowBytes() const { return m_rowBytes; }
+    int stride() const { return m_stride; }
+
+    /// Highest id with a slot; ids above it are not in the file.
+    qint64 maxId() const { return m_maxId; }
+    /// Slots that hold a live row.
+    qint64 liveCount() const { return m_liveCount; }
+
+    bool isDeleted(qint64 id) const;
+
+    /// The row for @p id in a mapped file, or nullptr when it is out of range or deleted.
+    const char* row(qint64 id) const;
+
+    /// Touches every page of a mapped file so the first scan does not wait on the disk.
+    void prefetch() const;
+
+    /**
+     * @brief Stores @p row (exactly rowBytes()) for @p id, which must be above maxId().
+     *
+     * Ids skipped over stay tombstoned. Grows the file as needed; the rows
+     * already written never move.
+     */
+    bool append(qint64 id, const QByteArray& row, QString* error = nullptr);
+
+    void markDeleted(qint64 id);
+
+    /// Writes the bitmap and a clean header. Until then the file reads as dirty.
+    bool commit(QString* error = nullptr);
+
+private:
+    VectorFile() = default;
+
+    static qint64 strideFor(int rowBytes);
+    qint64 bitmapOffset(qint64 capacity) const;
+    qint64 fileSizeFor(qint64 capacity) const;
+    bool readHeader(QString* error);
+    bool writeHeader(bool clean, QString* error);
+    bool beginUpdate(QString* error);
+
+    QFile m_file;
+    uchar* m_map {nullptr};
+    bool m_writable {false};
+    bool m_dirty {false};
+    int m_format {0};
+    int m_dimension {0};
+    int m_rowBytes {0};
+    int m_stride {0};
+    qint64 m_capacity {0};
+    qint64 m_maxId {0};
+    qint64 m_liveCount {0};
+    // One bit per slot; copied out of the file so appends can relocate it freely
+    QByteArray m_tombstones;
+};
@@ -0,0 +1,497 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "VectorKernels.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CP_VECTOR_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define CP_VECTOR_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+// MSVC compiles any intrinsic without flags; GCC and Clang need a per-function target
+#if defined(CP_VECTOR_KERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define CP_TARGET(features) __attribute__((target(features)))
+#else
+#define CP_TARGET(features)
+#endif
+
+namespace {
+
+using DotKernel = float (*)(const void*, const void*, std::size_t);
+using QuantisedDotKernel = float (*)(const float*, const void*, std::size_t);
+
+float loadFloat(const void* data, std::size_t index)
+{
+    float value;
+    std::memcpy(&value, static_cast<const char*>(data) + index * sizeof(float), sizeof(float));
+    return value;
+}
+
+std::uint16_t loadHalf(const void* data, std::size_t index)
+{
+    std::uint16_t value;
+    std::memcpy(&value, static_cast<const char*>(data) + index * sizeof(value), sizeof(value));
+    return value;
+}
+
+float loadInt8(const void* data, std::size_t index)
+{
+    return static_cast<float>(static_cast<const std::int8_t*>(data)[index]);
+}
+
+float dotScalar(const void* a, const void* b, std::size_t count)
+{
+    float sum0 = 0.0f;
+    float sum1 = 0.0f;
+    float sum2 = 0.0f;
+    float sum3 = 0.0f;
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        sum0 += loadFloat(a, i) * loadFloat(b, i);
+        sum1 += loadFloat(a, i + 1) * loadFloat(b, i + 1);
+        sum2 += loadFloat(a, i + 2) * loadFloat(b, i + 2);
+        sum3 += loadFloat(a, i + 3) * loadFloat(b, i + 3);
+    }
+    for (; i < count; ++i) {
+        sum0 += loadFloat(a, i) * loadFloat(b, i);
+    }
+    return (sum0 + sum1) + (sum2 + sum3);
+}
+
+float dotHalfScalar(const float* a, const void* b, std::size_t count)
+{
+    float sum0 = 0.0f;
+    float sum1 = 0.0f;
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        sum0 += a[i] * VectorKernels::halfToFloat(loadHalf(b, i));
+        sum1 += a[i + 1] * VectorKernels::halfToFloat(loadHalf(b, i + 1));
+    }
+    for (; i < count; ++i) {
+        sum0 += a[i] * VectorKernels::halfToFloat(loadHalf(b, i));
+    }
+    return sum0 + sum1;
+}
+
+float dotInt8Scalar(const float* a, const void* b, std::size_t count)
+{
+    float sum0 = 0.0f;
+    float sum1 = 0.0f;
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        sum0 += a[i] * loadInt8(b, i);
+        sum1 += a[i + 1] * loadInt8(b, i + 1);
+    }
+    for (; i < count; ++i) {
+        sum0 += a[i] * loadInt8(b, i);
+    }
+    return sum0 + sum1;
+}
+
+#if defined(CP_VECTOR_KERNELS_X86)
+
+CP_TARGET("avx2,fma")
+float horizontalSum(__m256 value)
+{
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(value), _mm256_extractf128_ps(value, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 0x1));
+    return _mm_cvtss_f32(sum);
+}
+
+CP_TARGET("avx512f")
+float horizontalSum512(__m512 value)
+{
+    alignas(64) float lanes[16];
+    _mm512_store_ps(lanes, value);
+    float result = 0.0f;
+    for (const float lane : lanes) {
+        result += lane;
+    }
+    return result;
+}
+
+CP_TARGET("avx2,fma")
+float dotAvx2(const void* a, const void* b, std::size_t count)
+{
+    // Only ever read with unaligned loads
+    const float* af = static_cast<const float*>(a);
+    const float* bf = static_cast<const float*>(b);
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(af + i), _mm256_loadu_ps(bf + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(af + i + 8), _mm256_loadu_ps(bf + i + 8), acc1);
+    }
+    if (i + 8 <= count) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(af + i), _mm256_loadu_ps(bf + i), acc0);
+        i += 8;
+    }
+    float result = horizontalSum(_mm256_add_ps(acc0, acc1));
+    for (; i < count; ++i) {
+        result += loadFloat(a, i) * loadFloat(b, i);
+    }
+    return result;
+}
+
+CP_TARGET("avx2,fma,f16c")
+float dotHalfAvx2(const float* a, const void* b, std::size_t count)
+{
+    const char* bytes = static_cast<const char*>(b);
+    __m256 acc = _mm256_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i halves = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i * 2));
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_cvtph_ps(halves), acc);
+    }
+    float result = horizontalSum(acc);
+    for (; i < count; ++i) {
+        result += a[i] * VectorKernels::halfToFloat(loadHalf(b, i));
+    }
+    return result;
+}
+
+CP_TARGET("avx2,fma")
+float dotInt8Avx2(const float* a, const void* b, std::size_t count)
+{
+    const char* bytes = static_cast<const char*>(b);
+    __m256 acc = _mm256_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i codes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(bytes + i));
+        const __m256 values = _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(codes));
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), values, acc);
+    }
+    float result = horizontalSum(acc);
+    for (; i < count; ++i) {
+        result += a[i] * loadInt8(b, i);
+    }
+    return result;
+}
+
+CP_TARGET("avx512f")
+float dotAvx512(const void* a, const void* b, std::size_t count)
+{
+    // Only ever read with unaligned loads
+    const float* af = static_cast<const float*>(a);
+    const float* bf = static_cast<const float*>(b);
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(af + i), _mm512_loadu_ps(bf + i), acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(af + i + 16), _mm512_loadu_ps(bf + i + 16), acc1);
+    }
+    for (; i + 16 <= count; i += 16) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(af + i), _mm512_loadu_ps(bf + i), acc0);
+    }
+    if (i < count) {
+        // Masked loads read nothing past the end of either buffer
+        const __mmask16 mask = static_cast<__mmask16>((1u << (count - i)) - 1u);
+        acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, af + i), _mm512_maskz_loadu_ps(mask, bf + i), acc1);
+    }
+    return horizontalSum512(_mm512_add_ps(acc0, acc1));
+}
+
+// The zero-masking forms keep GCC from warning about the unmasked ones' undefined inputs
+constexpr __mmask16 kAllLanes = 0xffff;
+
+CP_TARGET("avx512f")
+float dotHalfAvx512(const float* a, const void* b, std::size_t count)
+{
+    const char* bytes = static_cast<const char*>(b);
+    __m512 acc = _mm512_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256i halves = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + i * 2));
+        acc = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_maskz_cvtph_ps(kAllLanes, halves), acc);
+    }
+    float result = horizontalSum512(acc);
+    for (; i < count; ++i) {
+        result += a[i] * VectorKernels::halfToFloat(loadHalf(b, i));
+    }
+    return result;
+}
+
+CP_TARGET("avx512f")
+float dotInt8Avx512(const float* a, const void* b, std::size_t count)
+{
+    const char* bytes = static_cast<const char*>(b);
+    __m512 acc = _mm512_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m128i codes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i));
+        const __m512 values = _mm512_maskz_cvtepi32_ps(kAllLanes, _mm512_maskz_cvtepi8_epi32(kAllLanes, codes));
+        acc = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), values, acc);
+    }
+    float result = horizontalSum512(acc);
+    for (; i < count; ++i) {
+        result += a[i] * loadInt8(b, i);
+    }
+    return result;
+}
+
+struct CpuFeatures {
+    bool avx2 {false}; ///< AVX2 and FMA, with the OS saving YMM state
+    bool f16c {false};
+    bool avx512 {false}; ///< AVX-512F, with the OS saving ZMM state
+};
+
+CpuFeatures detectCpuFeatures()
+{
+    unsigned int leaf1[4] = {0, 0, 0, 0};
+    unsigned int leaf7[4] = {0, 0, 0, 0};
+#if defined(_MSC_VER) && !defined(__clang__)
+    int regs[4];
+    __cpuid(regs, 0);
+    const int maxLeaf = regs[0];
+    __cpuid(regs, 1);
+    std::memcpy(leaf1, regs, sizeof(leaf1));
+    if (maxLeaf >= 7) {
+        __cpuidex(regs, 7, 0);
+        std::memcpy(leaf7, regs, sizeof(leaf7));
+    }
+#else
+    const unsigned int maxLeaf = __get_cpuid_max(0, nullptr);
+    __get_cpuid(1, &leaf1[0], &leaf1[1], &leaf1[2], &leaf1[3]);
+    if (maxLeaf >= 7) {
+        __cpuid_count(7, 0, leaf7[0], leaf7[1], leaf7[2], leaf7[3]);
+    }
+#endif
+
+    CpuFeatures features;
+    const bool osxsave = leaf1[2] & (1u << 27);
+    if (!osxsave) {
+        return features;
+    }
+#if defined(_MSC_VER) && !defined(__clang__)
+    const unsigned long long xcr0 = _xgetbv(0);
+#else
+    unsigned int xcr0Low = 0;
+    unsigned int xcr0High = 0;
+    __asm__("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+    const unsigned long long xcr0 = (static_cast<unsigned long long>(xcr0High) << 32) | xcr0Low;
+#endif
+    const bool osSavesYmm = (xcr0 & 0x6) == 0x6;
+    const bool osSavesZmm = (xcr0 & 0xe6) == 0xe6;
+
+    const bool fma = leaf1[2] & (1u << 12);
+    features.f16c = osSavesYmm && (leaf1[2] & (1u << 29));
+    features.avx2 = osSavesYmm && fma && (leaf7[1] & (1u << 5));
+    features.avx512 = osSavesZmm && (leaf7[1] & (1u << 16));
+    return features;
+}
+
+#elif defined(CP_VECTOR_KERNELS_NEON)
+
+float dotNeon(const void* a, const void* b, std::size_t count)
+{
+    // Byte loads have no alignment requirement
+    const uint8_t* aBytes = static_cast<const uint8_t*>(a);
+    const uint8_t* bBytes = static_cast<const uint8_t*>(b);
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const float32x4_t a0 = vreinterpretq_f32_u8(vld1q_u8(aBytes + i * sizeof(float)));
+        const float32x4_t a1 = vreinterpretq_f32_u8(vld1q_u8(aBytes + (i + 4) * sizeof(float)));
+        const float32x4_t b0 = vreinterpretq_f32_u8(vld1q_u8(bBytes + i * sizeof(float)));
+        const float32x4_t b1 = vreinterpretq_f32_u8(vld1q_u8(bBytes + (i + 4) * sizeof(float)));
+        acc0 = vfmaq_f32(acc0, a0, b0);
+        acc1 = vfmaq_f32(acc1, a1, b1);
+    }
+    float result = vaddvq_f32(vaddq_f32(acc0, acc1));
+    for (; i < count; ++i) {
+        result += loadFloat(a, i) * loadFloat(b, i);
+    }
+    return result;
+}
+
+float dotHalfNeon(const float* a, const void* b, std::size_t count)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(b);
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const uint16x8_t halves = vreinterpretq_u16_u8(vld1q_u8(bytes + i * 2));
+        const float32x4_t b0 = vcvt_f32_f16(vreinterpret_f16_u16(vget_low_u16(halves)));
+        const float32x4_t b1 = vcvt_f32_f16(vreinterpret_f16_u16(vget_high_u16(halves)));
+        acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), b0);
+        acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), b1);
+    }
+    float result = vaddvq_f32(vaddq_f32(acc0, acc1));
+    for (; i < count; ++i) {
+        result += a[i] * VectorKernels::halfToFloat(loadHalf(b, i));
+    }
+    return result;
+}
+
+float dotInt8Neon(const float* a, const void* b, std::size_t count)
+{
+    const int8_t* codes = static_cast<const int8_t*>(b);
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const int16x8_t wide = vmovl_s8(vld1_s8(codes + i));
+        const float32x4_t b0 = vcvtq_f32_s32(vmovl_s16(vget_low_s16(wide)));
+        const float32x4_t b1 = vcvtq_f32_s32(vmovl_s16(vget_high_s16(wide)));
+        acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), b0);
+        acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), b1);
+    }
+    float result = vaddvq_f32(vaddq_f32(acc0, acc1));
+    for (; i < count; ++i) {
+        result += a[i] * loadInt8(b, i);
+    }
+    return result;
+}
+
+#endif
+
+struct Selection {
+    DotKernel dot;
+    QuantisedDotKernel dotHalf;
+    QuantisedDotKernel dotInt8;
+    const char* name;
+};
+
+Selection selectKernel()
+{
+#if defined(CP_VECTOR_KERNELS_X86)
+    const CpuFeatures cpu = detectCpuFeatures();
+    if (cpu.avx512) {
+        return {dotAvx512, dotHalfAvx512, dotInt8Avx512, "avx512"};
+    }
+    if (cpu.avx2) {
+        return {dotAvx2, cpu.f16c ? dotHalfAvx2 : dotHalfScalar, dotInt8Avx2, "avx2"};
+    }
+#elif defined(CP_VECTOR_KERNELS_NEON)
+    return {dotNeon, dotHalfNeon, dotInt8Neon, "neon"};
+#endif
+    return {dotScalar, dotHalfScalar, dotInt8Scalar, "scalar"};
+}
+
+const Selection& selection()
+{
+    static const Selection selected = selectKernel();
+    return selected;
+}
+
+} // namespace
+
+namespace VectorKernels {
+
+float dot(const void* a, const void* b, std::size_t count)
+{
+    return selection().dot(a, b, count);
+}
+
+float dotHalf(const float* a, const void* b, std::size_t count)
+{
+    return selection().dotHalf(a, b, count);
+}
+
+float dotInt8(const float* a, const void* b, std::size_t count)
+{
+    return selection().dotInt8(a, b, count);
+}
+
+const char* activeKernel()
+{
+    return selection().name;
+}
+
+void normalize(std::vector<float>& vector)
+{
+    double norm = 0.0;
+    for (const float value : vector) {
+        norm += static_cast<double>(value) * value;
+    }
+    if (norm <= 0.0) {
+        return;
+    }
+    const double scale = 1.0 / std::sqrt(norm);
+    for (float& value : vector) {
+        value = static_cast<float>(value * scale);
+    }
+}
+
+std::uint16_t floatToHalf(float value)
+{
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const std::uint16_t sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000u);
+    const std::uint32_t magnitude = bits & 0x7fffffffu;
+
+    if (magnitude >= 0x7f800000u) { // infinity or NaN
+        return static_cast<std::uint16_t>(sign | 0x7c00u | (magnitude > 0x7f800000u ? 0x200u : 0u));
+    }
+    if (magnitude >= 0x477ff000u) { // rounds beyond the largest half
+        return static_cast<std::uint16_t>(sign | 0x7c00u);
+    }
+    if (magnitude < 0x38800000u) { // subnormal half, or zero
+        const float absolute = std::fabs(value);
+        return static_cast<std::uint16_t>(sign | static_cast<std::uint16_t>(std::nearbyint(absolute * 16777216.0f)));
+    }
+    // Normal: rebias the exponent and round the mantissa to nearest even
+    const std::uint32_t rebiased = magnitude - 0x38000000u;
+    const std::uint32_t rounded = rebiased + 0xfffu + ((rebiased >> 13) & 1u);
+    return static_cast<std::uint16_t>(sign | (rounded >> 13));
+}
+
+float halfToFloat(std::uint16_t half)
+{
+    const std::uint32_t sign = static_cast<std::uint32_t>(half & 0x8000u) << 16;
+    const std::uint32_t exponent = (half >> 10) & 0x1fu;
+    const std::uint32_t mantissa = half & 0x3ffu;
+
+    std::uint32_t bits;
+    if (exponent == 0) {
+        const float magnitude = static_cast<float>(mantissa) / 16777216.0f; // 2^-24 per step
+        std::memcpy(&bits, &magnitude, sizeof(bits));
+        bits |= sign;
+    } else if (exponent == 0x1f) {
+        bits = sign | 0x7f800000u | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent + 112u) << 23) | (mantissa << 13);
+    }
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+} // namespace VectorKernels
@@ -0,0 +1,59 @@
+//
+// Cognitive Pipeline Application
+//
+// Copyright (c) 2025 Adrian Sutherland
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Dot-product kernels for scoring stored embeddings.
+ *
+ * The implementation is picked once per process from what the CPU supports:
+ * AVX-512 or AVX2/FMA on x86-64, NEON on ARM64, portable scalar code
+ * elsewhere. Operands are raw bytes holding floats, so SQLite BLOB data can
+ * be scored in place whatever its alignment.
+ */
+namespace VectorKernels {
+
+/// Sum of a[i] * b[i] over @p count floats; neither buffer need be float-aligned.
+float dot(const void* a, const void* b, std::size_t count);
+
+/// Dot product of floats @p a with @p count IEEE half-precision values at @p b.
+float dotHalf(const float* a, const void* b, std::size_t count);
+
+/// Dot product of floats @p a with @p count signed bytes at @p b; callers apply any scale.
+float dotInt8(const float* a, const void* b, std::size_t count);
+
+/// The selected implementation: "avx512", "avx2", "neon" or "scalar".
+const char* activeKernel();
+
+/// Scale @p vector to unit length in place. All-zero vectors are left as they are.
+void normalize(std::vector<float>& vector);
+
+/// IEEE half-precision conversion, rounding to nearest even.
+std::uint16_t floatToHalf(float value);
+float halfToFloat(std::uint16_t half);
+
+} // namespace VectorKernels
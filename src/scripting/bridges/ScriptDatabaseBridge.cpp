@@ -29,9 +29,30 @@
 #include <QSqlRecord>
 #include <QJsonArray>
 #include <QJsonObject>
-#include <QUuid>
 #include <QVariant>
 #include "Logger.h"
+#include "retrieval/storage/SqliteConnectionPool.h"
+
+namespace {
+
+QJsonObject errorObject(const QString& message)
+{
+    QJsonObject errorObj;
+    errorObj.insert(QStringLiteral("error"), message);
+    return errorObj;
+}
+
+// Why @p query failed; a statement that never prepared reports the prepare error, not the misuse
+QString failureText(QSqlDatabase& db, const QString& sql, const QSqlQuery& query)
+{
+    QSqlQuery probe(db);
+    if (!probe.prepare(sql)) {
+        return probe.lastError().text();
+    }
+    return query.lastError().text();
+}
+
+} // namespace
 
 ScriptDatabaseBridge::ScriptDatabaseBridge(QObject* parent)
     : QObject(parent)
@@ -40,92 +61,191 @@ ScriptDatabaseBridge::ScriptDatabaseBridge(QObject* parent)
 
 ScriptDatabaseBridge::~ScriptDatabaseBridge()
 {
+    abandonTransaction();
 }
 
 bool ScriptDatabaseBridge::connect(const QString& path)
 {
+    if (path != m_dbPath) {
+        abandonTransaction();
+    }
     m_dbPath = path;
-    return true;
+    return database(nullptr).isOpen();
 }
 
-QJsonValue ScriptDatabaseBridge::exec(const QString& sql, const QVariantList& params)
+QSqlDatabase ScriptDatabaseBridge::database(QString* error) const
 {
     if (m_dbPath.isEmpty()) {
-        QJsonObject errorObj;
-        errorObj.insert(QStringLiteral("error"), QStringLiteral("Database not connected. Call db.connect(path) first."));
-        return errorObj;
+        if (error) {
+            *error = QStringLiteral("Database not connected. Call db.connect(path) first.");
+        }
+        return QSqlDatabase();
+    }
+    return SqliteConnectionPool::connection(m_dbPath, error);
+}
+
+void ScriptDatabaseBridge::abandonTransaction()
+{
+    if (!m_inTransaction) {
+        return;
+    }
+    m_inTransaction = false;
+    QSqlDatabase db = database(nullptr);
+    if (db.isOpen() && !db.rollback()) {
+        CP_WARN << "ScriptDatabaseBridge: failed to roll back an unfinished transaction:" << db.lastError().text();
+    }
+}
+
+QJsonValue ScriptDatabaseBridge::exec(const QString& sql, const QVariantList& params)
+{
+    QString openError;
+    QSqlDatabase db = database(&openError);
+    if (!db.isOpen()) {
+        return errorObject(openError);
+    }
+
+    // Outside begin()/commit(), SQLite's autocommit makes the statement its own transaction
+    QSqlQuery query = SqliteConnectionPool::statement(db, sql);
+    for (const QVariant& param : params) {
+        query.addBindValue(param);
+    }
+    if (!query.exec()) {
+        const QJsonObject error = errorObject(failureText(db, sql, query));
+        query.finish();
+        return error;
     }
 
-    const QString connectionName = QUuid::createUuid().toString(QUuid::WithoutBraces);
     QJsonValue result;
+    if (query.isSelect()) {
+        QJsonArray rows;
+        QSqlRecord record = query.record();
+        int columnCount = record.count();
 
-    {
-        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
-        db.setDatabaseName(m_dbPath);
+        while (query.next()) {
+            QJsonObject row;
+            for (int i = 0; i < columnCount; ++i) {
+                row.insert(record.fieldName(i), QJsonValue::fromVariant(query.value(i)));
+            }
+            rows.append(row);
+        }
+        result = rows;
+    } else {
+        QJsonObject meta;
+        meta.insert(QStringLiteral("rowsAffected"), query.numRowsAffected());
+        QVariant lastId = query.lastInsertId();
+        if (lastId.isValid()) {
+            meta.insert(QStringLiteral("lastInsertId"), QJsonValue::fromVariant(lastId));
+        }
+        result = meta;
+    }
+    // Releases the read snapshot while the statement stays prepared
+    query.finish();
+    return result;
+}
 
-        if (!db.open()) {
-            QJsonObject errorObj;
-            errorObj.insert(QStringLiteral("error"), db.lastError().text());
-            result = errorObj;
+QJsonValue ScriptDatabaseBridge::execMany(const QString& sql, const QVariantList& rows)
+{
+    QString openError;
+    QSqlDatabase db = database(&openError);
+    if (!db.isOpen()) {
+        return errorObject(openError);
+    }
+
+    const bool ownTransaction = !m_inTransaction;
+    if (ownTransaction && !db.transaction()) {
+        return errorObject(QStringLiteral("Failed to start transaction: ") + db.lastError().text());
+    }
+
+    QSqlQuery query = SqliteConnectionPool::statement(db, sql);
+    qint64 rowsAffected = 0;
+    for (qsizetype i = 0; i < rows.size(); ++i) {
+        const QVariant& row = rows.at(i);
+        if (row.typeId() == QMetaType::QVariantMap) {
+            const QVariantMap values = row.toMap();
+            for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+                query.bindValue(QLatin1Char(':') + it.key(), it.value());
+            }
         } else {
-            if (!db.transaction()) {
-                QJsonObject errorObj;
-                errorObj.insert(QStringLiteral("error"), QStringLiteral("Failed to start transaction: ") + db.lastError().text());
-                result = errorObj;
-            } else {
-                QSqlQuery query(db);
-                bool ok = false;
-                if (!params.isEmpty()) {
-                    if (query.prepare(sql)) {
-                        for (const QVariant& param : params) {
-                            query.addBindValue(param);
-                        }
-                        ok = query.exec();
-                    }
-                } else {
-                    ok = query.exec(sql);
-                }
-
-                if (!ok) {
-                    QJsonObject errorObj;
-                    errorObj.insert(QStringLiteral("error"), query.lastError().text());
-                    result = errorObj;
-                    db.rollback();
-                } else {
-                    if (query.isSelect()) {
-                        QJsonArray rows;
-                        QSqlRecord record = query.record();
-                        int columnCount = record.count();
-
-                        while (query.next()) {
-                            QJsonObject row;
-                            for (int i = 0; i < columnCount; ++i) {
-                                row.insert(record.fieldName(i), QJsonValue::fromVariant(query.value(i)));
-                            }
-                            rows.append(row);
-                        }
-                        result = rows;
-                    } else {
-                        QJsonObject meta;
-                        meta.insert(QStringLiteral("rowsAffected"), query.numRowsAffected());
-                        QVariant lastId = query.lastInsertId();
-                        if (lastId.isValid()) {
-                            meta.insert(QStringLiteral("lastInsertId"), QJsonValue::fromVariant(lastId));
-                        }
-                        result = meta;
-                    }
-
-                    if (!db.commit()) {
-                        QJsonObject errorObj;
-                        errorObj.insert(QStringLiteral("error"), QStringLiteral("Failed to commit transaction: ") + db.lastError().text());
-                        result = errorObj;
-                    }
-                }
+            const QVariantList values = row.toList();
+            for (qsizetype column = 0; column < values.size(); ++column) {
+                query.bindValue(static_cast<int>(column), values.at(column));
+            }
+        }
+
+        if (!query.exec()) {
+            QJsonObject error = errorObject(failureText(db, sql, query));
+            error.insert(QStringLiteral("row"), static_cast<qint64>(i));
+            query.finish();
+            if (ownTransaction) {
+                db.rollback();
             }
-            db.close();
+            return error;
         }
+        rowsAffected += qMax(0, query.numRowsAffected());
+        query.finish();
     }
 
-    QSqlDatabase::removeDatabase(connectionName);
-    return result;
+    if (ownTransaction && !db.commit()) {
+        const QJsonObject error = errorObject(QStringLiteral("Failed to commit transaction: ") + db.lastError().text());
+        db.rollback();
+        return error;
+    }
+
+    QJsonObject meta;
+    meta.insert(QStringLiteral("rowsAffected"), rowsAffected);
+    meta.insert(QStringLiteral("rows"), static_cast<qint64>(rows.size()));
+    return meta;
+}
+
+QJsonValue ScriptDatabaseBridge::begin()
+{
+    if (m_inTransaction) {
+        return errorObject(QStringLiteral("A transaction is already open. Call commit() or rollback() first."));
+    }
+    QString openError;
+    QSqlDatabase db = database(&openError);
+    if (!db.isOpen()) {
+        return errorObject(openError);
+    }
+    if (!db.transaction()) {
+        return errorObject(QStringLiteral("Failed to start transaction: ") + db.lastError().text());
+    }
+    m_inTransaction = true;
+    return true;
+}
+
+QJsonValue ScriptDatabaseBridge::commit()
+{
+    if (!m_inTransaction) {
+        return errorObject(QStringLiteral("No transaction is open. Call begin() first."));
+    }
+    QString openError;
+    QSqlDatabase db = database(&openError);
+    if (!db.isOpen()) {
+        m_inTransaction = false;
+        return errorObject(openError);
+    }
+    if (!db.commit()) {
+        // A failed commit leaves the transaction open, so the script may retry or roll back
+        return errorObject(QStringLiteral("Failed to commit transaction: ") + db.lastError().text());
+    }
+    m_inTransaction = false;
+    return true;
+}
+
+QJsonValue ScriptDatabaseBridge::rollback()
+{
+    if (!m_inTransaction) {
+        return errorObject(QStringLiteral("No transaction is open. Call begin() first."));
+    }
+    m_inTransaction = false;
+    QString openError;
+    QSqlDatabase db = database(&openError);
+    if (!db.isOpen()) {
+        return errorObject(openError);
+    }
+    if (!db.rollback()) {
+        return errorObject(QStringLiteral("Failed to roll back transaction: ") + db.lastError().text());
+    }
+    return true;
 }
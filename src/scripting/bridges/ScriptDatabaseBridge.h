@@ -27,11 +27,17 @@
 #include <QObject>
 #include <QString>
 #include <QJsonValue>
+#include <QSqlDatabase>
 
 /**
  * @brief Helper class to bridge JavaScript and SQLite.
  *
  * This class handles database connections and converts SQL results into QJsonValue formats.
+ *
+ * The connection comes from SqliteConnectionPool, so it stays open across
+ * calls and statements are prepared once per SQL text. Outside begin() and
+ * commit() each call is its own transaction; a transaction still open when
+ * the bridge is destroyed is rolled back.
  */
 class ScriptDatabaseBridge : public QObject {
     Q_OBJECT
@@ -43,7 +49,7 @@ public:
     /**
      * @brief Connects to a database at the given path.
      * @param path The path to the SQLite database file.
-     * @return true if the path was set, false otherwise.
+     * @return true if the database opened, false otherwise (exec() then reports why).
      */
     Q_INVOKABLE bool connect(const QString& path);
 
@@ -55,6 +61,31 @@ public:
      */
     Q_INVOKABLE QJsonValue exec(const QString& sql, const QVariantList& params = {});
 
+    /**
+     * @brief Runs one statement for every row, preparing it once.
+     * @param sql The SQL statement, with positional (?) or named (:name) parameters.
+     * @param rows Lists of positional values, or maps of named values.
+     * @return {rowsAffected, rows} on success, or an error object whose "row" is the failing index.
+     *
+     * Outside begin() and commit() the batch is its own transaction, so it
+     * applies all rows or none.
+     */
+    Q_INVOKABLE QJsonValue execMany(const QString& sql, const QVariantList& rows);
+
+    /// Starts a transaction that later calls join; true, or an error object.
+    Q_INVOKABLE QJsonValue begin();
+    /// Commits the transaction begin() started; true, or an error object.
+    Q_INVOKABLE QJsonValue commit();
+    /// Rolls back the transaction begin() started; true, or an error object.
+    Q_INVOKABLE QJsonValue rollback();
+
+    bool inTransaction() const { return m_inTransaction; }
+
 private:
+    QSqlDatabase database(QString* error) const;
+    // Ends an open transaction without reporting, before switching databases or on destruction
+    void abandonTransaction();
+
     QString m_dbPath;
+    bool m_inTransaction = false;
 };
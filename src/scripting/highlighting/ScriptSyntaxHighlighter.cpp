@@ -10,12 +10,16 @@
 #include <QBrush>
 #include <QColor>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFileInfo>
 #include <QFont>
+#include <QPlainTextEdit>
 #include <QProcess>
+#include <QScrollBar>
 #include <QSet>
 #include <QStandardPaths>
 #include <QString>
+#include <QTextBlock>
 #include <QTextDocument>
 
 #include <algorithm>
@@ -41,7 +45,14 @@ extern "C" {
 
 namespace {
 
+// Time an idle slice may spend on blocks a full pass deferred
+constexpr qint64 kSliceBudgetMs = 8;
+// Blocks either side of the viewport that a full pass still highlights at once
+constexpr int kViewportMarginBlocks = 20;
 #if CP_HAS_DSLSH
+// Distinct lines whose fallback rule results are kept
+constexpr int kRuleCacheLimit = 4096;
+
 constexpr const char* kDslshConfig = R"(
 [.rexx]
 keywords=address,arg,by,call,do,else,end,error,exit,expose,for,forever,if,import,interpret,iterate,leave,loop,namespace,options,otherwise,parse,procedure,pull,return,say,select,signal,then,to,until,when,while
@@ -174,7 +185,7 @@ QSet<ScriptSyntaxHighlighter*> g_openHighlighters;
 } // namespace
 
 ScriptSyntaxHighlighter::ScriptSyntaxHighlighter(QTextDocument* document)
-    : QSyntaxHighlighter(document)
+    : QSyntaxHighlighter(static_cast<QObject*>(document))
 {
     initFormats();
     g_openHighlighters.insert(this);
@@ -183,6 +194,20 @@ ScriptSyntaxHighlighter::ScriptSyntaxHighlighter(QTextDocument* document)
     connect(&m_parsePollTimer, &QTimer::timeout, this, [this]() {
         pollPendingExternalParse();
     });
+
+    m_sliceTimer.setInterval(0);
+    connect(&m_sliceTimer, &QTimer::timeout, this, [this]() {
+        highlightDeferredSlice();
+    });
+
+    // Connected before the document is attached, so an edit bumps the content
+    // generation before QSyntaxHighlighter re-highlights the changed blocks
+    if (document) {
+        connect(document, &QTextDocument::contentsChange, this, [this](int position, int charsRemoved, int charsAdded) {
+            onContentsChange(position, charsRemoved, charsAdded);
+        });
+    }
+    setDocument(document);
 }
 
 ScriptSyntaxHighlighter::~ScriptSyntaxHighlighter()
@@ -197,13 +222,33 @@ void ScriptSyntaxHighlighter::setEngineId(const QString& engineId)
         return;
     }
     m_engineId = engineId;
+    m_ruleCache.clear();
+    invalidateConfiguredCommand();
     rehighlight();
 }
 
+void ScriptSyntaxHighlighter::setEditor(QPlainTextEdit* editor)
+{
+    if (m_editor == editor) {
+        return;
+    }
+    if (m_editor) {
+        disconnect(m_editor->verticalScrollBar(), nullptr, this, nullptr);
+    }
+    m_editor = editor;
+    if (m_editor) {
+        connect(m_editor->verticalScrollBar(), &QScrollBar::valueChanged, this, [this]() {
+            highlightVisibleDeferredBlocks();
+        });
+        updateVisibleRange();
+    }
+}
+
 void ScriptSyntaxHighlighter::setExternalCommandOverrideForTesting(const QString& command)
 {
     m_hasCommandOverride = true;
     m_commandOverride = command;
+    invalidateConfiguredCommand();
     clearPendingExternalParse(true);
     m_cachedExternalValid = false;
     m_cachedExternalTokenTypes.clear();
@@ -224,6 +269,7 @@ void ScriptSyntaxHighlighter::rehighlightOpenEditors()
     const QSet<ScriptSyntaxHighlighter*> highlighters = g_openHighlighters;
     for (ScriptSyntaxHighlighter* highlighter : highlighters) {
         if (highlighter) {
+            highlighter->invalidateConfiguredCommand();
             highlighter->rehighlight();
         }
     }
@@ -342,8 +388,14 @@ void ScriptSyntaxHighlighter::highlightBlock(const QString& text)
         return;
     }
 
+    const int lineNumber = currentBlock().blockNumber();
+    if (shouldDefer(lineNumber)) {
+        // Off screen during a full pass: left plain until an idle slice gets to it
+        deferBlock(lineNumber);
+        return;
+    }
+
     if (!configuredCommandForEngine().isEmpty() && ensureExternalParseCache()) {
-        const int lineNumber = currentBlock().blockNumber();
         if (lineNumber >= 0 && lineNumber < m_cachedExternalTokenTypes.size()) {
             applyTokenRuns(m_cachedExternalTokenTypes.at(lineNumber), text.size());
             return;
@@ -359,6 +411,13 @@ void ScriptSyntaxHighlighter::highlightBlock(const QString& text)
 void ScriptSyntaxHighlighter::highlightWithEmergencyRules(const QString& text)
 {
 #if CP_HAS_DSLSH
+    // Repeated lines, and blocks highlighted again by a full pass, reuse the rule results
+    const auto cached = m_ruleCache.constFind(text);
+    if (cached != m_ruleCache.constEnd()) {
+        applyTokenRuns(cached.value(), text.size());
+        return;
+    }
+
     ensureDslshConfig();
     CodeBuffer* cb = createSingleLineBuffer(m_engineId, text);
     if (!cb || cb->line_count == 0 || !cb->lines || !cb->lines[0].characters) {
@@ -378,6 +437,10 @@ void ScriptSyntaxHighlighter::highlightWithEmergencyRules(const QString& text)
     applyTokenRuns(tokenTypes, text.size());
 
     free_code_buffer(cb);
+    if (m_ruleCache.size() >= kRuleCacheLimit) {
+        m_ruleCache.clear();
+    }
+    m_ruleCache.insert(text, std::move(tokenTypes));
 #else
     Q_UNUSED(text);
 #endif
@@ -392,24 +455,23 @@ bool ScriptSyntaxHighlighter::ensureExternalParseCache()
         return false;
     }
 
-    const QString content = document() ? document()->toPlainText() : QString();
     if (m_cachedExternalEngineId == m_engineId
         && m_cachedExternalCommand == command
-        && m_cachedExternalContent == content) {
+        && m_cachedExternalGeneration == m_contentGeneration) {
         return m_cachedExternalValid;
     }
 
     if (m_pendingCodeBuffer) {
         const bool pendingMatches = m_pendingExternalEngineId == m_engineId
             && m_pendingExternalCommand == command
-            && m_pendingExternalContent == content;
+            && m_pendingExternalGeneration == m_contentGeneration;
 
         if (isPendingExternalParseComplete()) {
             if (pendingMatches) {
                 copyTokenTypesFromCodeBuffer(m_pendingCodeBuffer);
                 m_cachedExternalEngineId = m_pendingExternalEngineId;
                 m_cachedExternalCommand = m_pendingExternalCommand;
-                m_cachedExternalContent = m_pendingExternalContent;
+                m_cachedExternalGeneration = m_pendingExternalGeneration;
                 m_cachedExternalValid = !m_cachedExternalTokenTypes.isEmpty();
                 clearPendingExternalParse(false);
                 return m_cachedExternalValid;
@@ -426,10 +488,10 @@ bool ScriptSyntaxHighlighter::ensureExternalParseCache()
 
     m_cachedExternalEngineId = m_engineId;
     m_cachedExternalCommand = command;
-    m_cachedExternalContent = content;
+    m_cachedExternalGeneration = m_contentGeneration;
     m_cachedExternalTokenTypes.clear();
     m_cachedExternalValid = false;
-    startExternalParse(content, command);
+    startExternalParse(document() ? document()->toPlainText() : QString(), command);
     return false;
 #else
     return false;
@@ -476,7 +538,7 @@ bool ScriptSyntaxHighlighter::startExternalParse(const QString& content, const Q
 
     m_pendingExternalEngineId = m_engineId;
     m_pendingExternalCommand = command;
-    m_pendingExternalContent = content;
+    m_pendingExternalGeneration = m_contentGeneration;
     m_pendingCodeBuffer = cb;
     m_pendingCommunication = comm;
     m_parsePollTimer.start();
@@ -511,16 +573,15 @@ void ScriptSyntaxHighlighter::pollPendingExternalParse()
     }
 
     const QString currentCommand = configuredCommandForEngine();
-    const QString currentContent = document() ? document()->toPlainText() : QString();
     const bool pendingStillMatches = m_pendingExternalEngineId == m_engineId
         && m_pendingExternalCommand == currentCommand
-        && m_pendingExternalContent == currentContent;
+        && m_pendingExternalGeneration == m_contentGeneration;
 
     if (pendingStillMatches) {
         copyTokenTypesFromCodeBuffer(m_pendingCodeBuffer);
         m_cachedExternalEngineId = m_pendingExternalEngineId;
         m_cachedExternalCommand = m_pendingExternalCommand;
-        m_cachedExternalContent = m_pendingExternalContent;
+        m_cachedExternalGeneration = m_pendingExternalGeneration;
         m_cachedExternalValid = !m_cachedExternalTokenTypes.isEmpty();
         clearPendingExternalParse(false);
         rehighlight();
@@ -529,7 +590,7 @@ void ScriptSyntaxHighlighter::pollPendingExternalParse()
 
     clearPendingExternalParse(false);
     if (!currentCommand.isEmpty()) {
-        startExternalParse(currentContent, currentCommand);
+        startExternalParse(document() ? document()->toPlainText() : QString(), currentCommand);
     }
 #endif
 }
@@ -559,7 +620,7 @@ void ScriptSyntaxHighlighter::clearPendingExternalParse(bool waitForCompletion)
     m_pendingCommunication = nullptr;
     m_pendingExternalEngineId.clear();
     m_pendingExternalCommand.clear();
-    m_pendingExternalContent.clear();
+    m_pendingExternalGeneration = 0;
     if (!m_pendingCodeBuffer) {
         m_parsePollTimer.stop();
     }
@@ -764,13 +825,99 @@ QString ScriptSyntaxHighlighter::configuredCommandForEngine() const
         return m_commandOverride.trimmed();
     }
 
-    const QString fileType = ScriptHighlighterConfig::fileTypeForEngine(m_engineId);
-    return ScriptHighlighterConfig::loadCommands().value(fileType).trimmed();
+    // Read from QSettings once per engine rather than for every block
+    if (!m_configuredCommandValid) {
+        const QString fileType = ScriptHighlighterConfig::fileTypeForEngine(m_engineId);
+        m_configuredCommand = ScriptHighlighterConfig::loadCommands().value(fileType).trimmed();
+        m_configuredCommandValid = true;
+    }
+    return m_configuredCommand;
 #else
     return QString();
 #endif
 }
 
+void ScriptSyntaxHighlighter::invalidateConfiguredCommand()
+{
+    m_configuredCommandValid = false;
+}
+
+void ScriptSyntaxHighlighter::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(position);
+    if (charsRemoved != 0 || charsAdded != 0) {
+        ++m_contentGeneration;
+    }
+}
+
+void ScriptSyntaxHighlighter::updateVisibleRange()
+{
+    if (!m_editor) {
+        return;
+    }
+    m_visibleFirst = m_editor->cursorForPosition(QPoint(0, 0)).blockNumber();
+    m_visibleLast = m_editor->cursorForPosition(QPoint(0, m_editor->viewport()->height())).blockNumber();
+}
+
+bool ScriptSyntaxHighlighter::shouldDefer(int blockNumber) const
+{
+    if (!m_editor || m_highlightingDirectly) {
+        return false;
+    }
+    if (blockNumber >= m_visibleFirst - kViewportMarginBlocks && blockNumber <= m_visibleLast + kViewportMarginBlocks) {
+        return false;
+    }
+    return blockNumber != m_editor->textCursor().blockNumber();
+}
+
+void ScriptSyntaxHighlighter::deferBlock(int blockNumber)
+{
+    m_deferredFrom = m_deferredFrom < 0 ? blockNumber : std::min(m_deferredFrom, blockNumber);
+    if (!m_sliceTimer.isActive()) {
+        m_sliceTimer.start();
+    }
+}
+
+void ScriptSyntaxHighlighter::highlightVisibleDeferredBlocks()
+{
+    updateVisibleRange();
+    if (m_deferredFrom < 0 || m_visibleLast < m_deferredFrom || !document()) {
+        return;
+    }
+
+    // Blocks scrolled into view go ahead of the idle slices
+    m_highlightingDirectly = true;
+    for (QTextBlock block = document()->findBlockByNumber(std::max(m_visibleFirst, m_deferredFrom));
+         block.isValid() && block.blockNumber() <= m_visibleLast; block = block.next()) {
+        rehighlightBlock(block);
+    }
+    m_highlightingDirectly = false;
+}
+
+void ScriptSyntaxHighlighter::highlightDeferredSlice()
+{
+    if (m_deferredFrom < 0 || !document()) {
+        m_deferredFrom = -1;
+        m_sliceTimer.stop();
+        return;
+    }
+
+    QElapsedTimer budget;
+    budget.start();
+    QTextBlock block = document()->findBlockByNumber(m_deferredFrom);
+    m_highlightingDirectly = true;
+    while (block.isValid() && budget.elapsed() < kSliceBudgetMs) {
+        rehighlightBlock(block);
+        block = block.next();
+    }
+    m_highlightingDirectly = false;
+
+    m_deferredFrom = block.isValid() ? block.blockNumber() : -1;
+    if (m_deferredFrom < 0) {
+        m_sliceTimer.stop();
+    }
+}
+
 QVector<ScriptHighlighterDiagnostic> ScriptSyntaxHighlighter::diagnosticsFromCache() const
 {
     QVector<ScriptHighlighterDiagnostic> diagnostics;
@@ -809,6 +956,15 @@ QTextCharFormat ScriptSyntaxHighlighter::formatForToken(int tokenType) const
 
 QTextCharFormat ScriptSyntaxHighlighter::formatForCell(const ScriptHighlightCell& cell) const
 {
+    // Cells without a message share one format per token type and severity
+    const quint32 key = static_cast<quint32>(cell.tokenType & 0xffff) | (static_cast<quint32>(cell.severity) << 16);
+    if (cell.message.isEmpty()) {
+        const auto cached = m_cellFormats.constFind(key);
+        if (cached != m_cellFormats.constEnd()) {
+            return cached.value();
+        }
+    }
+
     QTextCharFormat format = formatForToken(cell.tokenType);
 
 #if CP_HAS_DSLSH
@@ -825,6 +981,8 @@ QTextCharFormat ScriptSyntaxHighlighter::formatForCell(const ScriptHighlightCell
 
     if (!cell.message.isEmpty()) {
         format.setToolTip(cell.message);
+    } else {
+        m_cellFormats.insert(key, format);
     }
 
     return format;
@@ -838,7 +996,7 @@ void ScriptSyntaxHighlighter::applyTokenRuns(const QVector<ScriptHighlightCell>&
     }
 
     int runStart = 0;
-    ScriptHighlightCell runCell = tokenTypes.at(0);
+    const ScriptHighlightCell* runCell = &tokenTypes.at(0);
 
     auto sameRun = [](const ScriptHighlightCell& left, const ScriptHighlightCell& right) {
         return left.tokenType == right.tokenType
@@ -850,18 +1008,18 @@ void ScriptSyntaxHighlighter::applyTokenRuns(const QVector<ScriptHighlightCell>&
         if (end <= runStart) {
             return;
         }
-        const QTextCharFormat format = formatForCell(runCell);
+        const QTextCharFormat format = formatForCell(*runCell);
         if (format.isValid()) {
             setFormat(runStart, end - runStart, format);
         }
     };
 
     for (int i = 1; i < limit; ++i) {
-        const ScriptHighlightCell cell = tokenTypes.at(i);
-        if (!sameRun(cell, runCell)) {
+        const ScriptHighlightCell& cell = tokenTypes.at(i);
+        if (!sameRun(cell, *runCell)) {
             flushRun(i);
             runStart = i;
-            runCell = cell;
+            runCell = &cell;
         }
     }
     flushRun(limit);
@@ -8,11 +8,13 @@
 
 #include <QHash>
 #include <QMap>
+#include <QPointer>
 #include <QSyntaxHighlighter>
 #include <QTextCharFormat>
 #include <QTimer>
 #include <QVector>
 
+class QPlainTextEdit;
 class QTextDocument;
 
 struct ScriptHighlightCell {
@@ -33,6 +35,10 @@ struct ScriptHighlighterDiagnostic {
  *
  * The class is intentionally safe to instantiate without DSLSH. In that case
  * highlightBlock() is a no-op and the editor remains plain text.
+ *
+ * With an editor set, full passes (engine changes, finished parses, large
+ * pastes) highlight the blocks on screen at once and the rest in short idle
+ * slices, so long scripts stay responsive; edits only redo their own blocks.
  */
 class ScriptSyntaxHighlighter : public QSyntaxHighlighter {
 public:
@@ -40,6 +46,7 @@ public:
     ~ScriptSyntaxHighlighter() override;
 
     void setEngineId(const QString& engineId);
+    void setEditor(QPlainTextEdit* editor);
     void setExternalCommandOverrideForTesting(const QString& command);
     static bool backendAvailable();
     static void rehighlightOpenEditors();
@@ -55,6 +62,13 @@ protected:
 
 private:
     void initFormats();
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void updateVisibleRange();
+    bool shouldDefer(int blockNumber) const;
+    void deferBlock(int blockNumber);
+    void highlightVisibleDeferredBlocks();
+    void highlightDeferredSlice();
+    void invalidateConfiguredCommand();
     void highlightWithEmergencyRules(const QString& text);
     bool ensureExternalParseCache();
     bool startExternalParse(const QString& content, const QString& command);
@@ -75,14 +89,30 @@ private:
     QHash<int, QTextCharFormat> m_formats;
     QString m_cachedExternalEngineId;
     QString m_cachedExternalCommand;
-    QString m_cachedExternalContent;
+    quint64 m_cachedExternalGeneration = 0;
     QVector<QVector<ScriptHighlightCell>> m_cachedExternalTokenTypes;
     bool m_cachedExternalValid = false;
 
     QString m_pendingExternalEngineId;
     QString m_pendingExternalCommand;
-    QString m_pendingExternalContent;
+    quint64 m_pendingExternalGeneration = 0;
     void* m_pendingCodeBuffer = nullptr;
     void* m_pendingCommunication = nullptr;
     QTimer m_parsePollTimer;
+
+    // Bumped on every text edit, so blocks compare against it instead of the whole text
+    quint64 m_contentGeneration = 1;
+    mutable QString m_configuredCommand;
+    mutable bool m_configuredCommandValid = false;
+    // Fallback rule results by line text, for the current engine
+    QHash<QString, QVector<ScriptHighlightCell>> m_ruleCache;
+    mutable QHash<quint32, QTextCharFormat> m_cellFormats;
+
+    QPointer<QPlainTextEdit> m_editor;
+    int m_visibleFirst = 0;
+    int m_visibleLast = -1;
+    bool m_highlightingDirectly = false;
+    // First block a full pass left for the idle slices, or -1
+    int m_deferredFrom = -1;
+    QTimer m_sliceTimer;
 };
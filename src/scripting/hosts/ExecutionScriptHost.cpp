@@ -23,6 +23,7 @@
 //
 
 #include "ExecutionScriptHost.h"
+#include "NodeOutputDir.h"
 #include <QStandardPaths>
 #include <QDir>
 
@@ -31,6 +32,12 @@ ExecutionScriptHost::ExecutionScriptHost(const DataPacket& inputPacket, DataPack
 {
 }
 
+ExecutionScriptHost::ExecutionScriptHost(const DataPacket& inputPacket, const TokenList& incomingTokens,
+                                         DataPacket& outputPacket, QList<QString>& logs)
+    : m_inputPacket(inputPacket), m_outputPacket(outputPacket), m_logs(logs), m_incomingTokens(&incomingTokens)
+{
+}
+
 void ExecutionScriptHost::log(const QString& message)
 {
     m_logs.append(message);
@@ -50,6 +57,18 @@ void ExecutionScriptHost::log(const QString& message)
 
 QVariant ExecutionScriptHost::getInput(const QString& key)
 {
+    if (m_incomingTokens && key == QLatin1String(kTokensKey)) {
+        if (!m_tokenSnapshots) {
+            QVariantList snapshots;
+            for (const ExecutionToken& token : *m_incomingTokens) {
+                if (!token.data.isEmpty()) {
+                    snapshots.append(token.data);
+                }
+            }
+            m_tokenSnapshots = snapshots.isEmpty() ? QVariant() : QVariant(snapshots);
+        }
+        return *m_tokenSnapshots;
+    }
     return m_inputPacket.value(key);
 }
 
@@ -67,9 +86,9 @@ void ExecutionScriptHost::setError(const QString& message)
 
 QString ExecutionScriptHost::getTempDir() const
 {
-    const QString sysKey = QStringLiteral("_sys_node_output_dir");
-    if (m_inputPacket.contains(sysKey)) {
-        return m_inputPacket.value(sysKey).toString();
+    const QString outputDir = NodeOutputDir::materialize(m_inputPacket);
+    if (!outputDir.isEmpty()) {
+        return outputDir;
     }
 
     QString tempDir = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
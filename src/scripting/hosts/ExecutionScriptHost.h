@@ -26,9 +26,12 @@
 
 #include "IScriptHost.h"
 #include "CommonDataTypes.h"
+#include "ExecutionToken.h"
 #include <QList>
 #include <QString>
 
+#include <optional>
+
 /**
  * @brief Concrete implementation of IScriptHost that bridges a script engine to the pipeline's data.
  */
@@ -42,6 +45,15 @@ public:
      */
     ExecutionScriptHost(const DataPacket& inputPacket, DataPacket& outputPacket, QList<QString>& logs);
 
+    /**
+     * @brief Constructs a host that also offers @p incomingTokens, one map each, under "_tokens".
+     * The list is only built if the script reads it.
+     */
+    ExecutionScriptHost(const DataPacket& inputPacket, const TokenList& incomingTokens,
+                        DataPacket& outputPacket, QList<QString>& logs);
+
+    static constexpr const char* kTokensKey = "_tokens";
+
     ~ExecutionScriptHost() override = default;
 
     // IScriptHost interface implementation
@@ -55,4 +67,7 @@ private:
     const DataPacket& m_inputPacket;
     DataPacket& m_outputPacket;
     QList<QString>& m_logs;
+    const TokenList* m_incomingTokens = nullptr;
+    // Built on the first read of kTokensKey; invalid when no token carries data
+    std::optional<QVariant> m_tokenSnapshots;
 };
@@ -7,6 +7,8 @@
 #include "CrexxRuntime.h"
 
 #include "CommonDataTypes.h"
+#include "DiskLruStore.h"
+#include "Logger.h"
 
 extern "C" {
 #include <crexxsaa.h>
@@ -25,14 +27,21 @@ extern "C" {
 #include <QCoreApplication>
 #include <QCryptographicHash>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
 #include <QJsonDocument>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QRegularExpression>
 #include <QStandardPaths>
 #include <QStringList>
 
 #include <memory>
+#include <utility>
+#include <vector>
 
 namespace {
 
@@ -40,6 +49,8 @@ struct PipelineInvocation {
     IScriptHost* host = nullptr;
     QStringList logs;
     QStringList errors;
+    // Set when profiling: time spent in PIPELINE commands, by command word
+    ScriptProfile* commandTimes = nullptr;
 };
 
 struct CrexxThreadState {
@@ -144,18 +155,6 @@ QString cacheDirPath()
     return cacheDir;
 }
 
-QString scriptDirPath(IScriptHost* host)
-{
-    QString baseDir = host ? host->getTempDir() : QString();
-    if (baseDir.trimmed().isEmpty()) {
-        baseDir = QDir::tempPath();
-    }
-
-    const QString dir = QDir(baseDir).absoluteFilePath(QStringLiteral("crexx"));
-    QDir().mkpath(dir);
-    return dir;
-}
-
 QString variantToProtocolString(const QVariant& value)
 {
     if (!value.isValid() || value.isNull()) {
@@ -170,67 +169,208 @@ QString variantToProtocolString(const QVariant& value)
     return value.toString();
 }
 
-bool setAddressVariable(crexxsaa_context* context, const QString& name, const QString& value, QString* error)
+bool setAddressBytes(crexxsaa_context* context, const char* name, const char* data, size_t size, QString* error)
 {
-    const QByteArray nameBytes = toUtf8Bytes(name);
-    const QByteArray valueBytes = toUtf8Bytes(value);
-    const int rc = crexxsaa_address_variable_set(
-        context,
-        nameBytes.constData(),
-        valueBytes.constData(),
-        static_cast<size_t>(valueBytes.size()));
+    const int rc = crexxsaa_address_variable_set(context, name, data, size);
     if (rc == CREXXSAA_VARIABLE_OK) {
         return true;
     }
 
     if (error) {
         *error = QStringLiteral("CREXX variable set failed for %1: %2")
-                     .arg(name, fromUtf8(crexxsaa_last_error(context)));
+                     .arg(fromUtf8(name), fromUtf8(crexxsaa_last_error(context)));
     }
     return false;
 }
 
-bool setStem(crexxsaa_context* context, const QString& stemName, const QStringList& values, QString* error)
+bool setAddressVariable(crexxsaa_context* context, const QString& name, const QString& value, QString* error)
 {
-    if (!setAddressVariable(context, stemName + QStringLiteral(".0"), QString::number(values.size()), error)) {
+    const QByteArray nameBytes = toUtf8Bytes(name);
+    const QByteArray valueBytes = toUtf8Bytes(value);
+    return setAddressBytes(context, nameBytes.constData(), valueBytes.constData(),
+                           static_cast<size_t>(valueBytes.size()), error);
+}
+
+bool getAddressBytes(crexxsaa_context* context, const char* name, QString* value, QString* error)
+{
+    char* raw = nullptr;
+    size_t len = 0;
+    const int rc = crexxsaa_address_variable_get_alloc(context, name, &raw, &len);
+
+    if (rc == CREXXSAA_VARIABLE_NOT_FOUND) {
         return false;
     }
 
-    for (int i = 0; i < values.size(); ++i) {
-        if (!setAddressVariable(context,
-                                QStringLiteral("%1.%2").arg(stemName).arg(i + 1),
-                                values.at(i),
-                                error)) {
-            return false;
+    if (rc != CREXXSAA_VARIABLE_OK) {
+        if (error) {
+            *error = QStringLiteral("CREXX variable get failed for %1: %2")
+                         .arg(fromUtf8(name), fromUtf8(crexxsaa_last_error(context)));
         }
+        return false;
     }
+
+    if (value) {
+        *value = QString::fromUtf8(raw, static_cast<qsizetype>(len));
+    }
+    crexxsaa_free(raw);
     return true;
 }
 
 bool getAddressVariable(crexxsaa_context* context, const QString& name, QString* value, QString* error)
 {
-    char* raw = nullptr;
-    size_t len = 0;
     const QByteArray nameBytes = toUtf8Bytes(name);
-    const int rc = crexxsaa_address_variable_get_alloc(context, nameBytes.constData(), &raw, &len);
+    return getAddressBytes(context, nameBytes.constData(), value, error);
+}
 
-    if (rc == CREXXSAA_VARIABLE_NOT_FOUND) {
+// Element names of one stem, built in place in a single buffer
+class StemNames {
+public:
+    explicit StemNames(const QString& stemName)
+        : m_name(toUtf8Bytes(stemName) + '.')
+        , m_prefixSize(m_name.size())
+    {
+    }
+
+    const char* at(qsizetype index)
+    {
+        m_name.truncate(m_prefixSize);
+        m_name += QByteArray::number(index);
+        return m_name.constData();
+    }
+
+private:
+    QByteArray m_name;
+    qsizetype m_prefixSize;
+};
+
+/**
+ * Sets `stem.0` to the number of @p values and `stem.1` .. `stem.n` to the values.
+ *
+ * The values are encoded once into a single packed buffer. With crexxsaa ABI 4
+ * the whole stem crosses in one crexxsaa_address_stem_set() call; older
+ * runtimes take one set per element, pointing into that buffer.
+ */
+bool setStem(crexxsaa_context* context, const QString& stemName, const QStringList& values, QString* error)
+{
+    QByteArray packed;
+    std::vector<size_t> lengths;
+    lengths.reserve(static_cast<size_t>(values.size()));
+    for (const QString& value : values) {
+        const qsizetype before = packed.size();
+        packed += value.toUtf8();
+        lengths.push_back(static_cast<size_t>(packed.size() - before));
+    }
+
+#if CREXXSAA_ABI_VERSION >= 4
+    const QByteArray stemBytes = toUtf8Bytes(stemName);
+    const int rc = crexxsaa_address_stem_set(context, stemBytes.constData(), packed.constData(),
+                                             lengths.data(), lengths.size());
+    if (rc == CREXXSAA_VARIABLE_OK) {
+        return true;
+    }
+    if (error) {
+        *error = QStringLiteral("CREXX stem set failed for %1: %2")
+                     .arg(stemName, fromUtf8(crexxsaa_last_error(context)));
+    }
+    return false;
+#else
+    StemNames names(stemName);
+    const QByteArray count = QByteArray::number(values.size());
+    if (!setAddressBytes(context, names.at(0), count.constData(), static_cast<size_t>(count.size()), error)) {
+        return false;
+    }
+
+    const char* data = packed.constData();
+    for (qsizetype i = 0; i < values.size(); ++i) {
+        const size_t size = lengths[static_cast<size_t>(i)];
+        if (!setAddressBytes(context, names.at(i + 1), data, size, error)) {
+            return false;
+        }
+        data += size;
+    }
+    return true;
+#endif
+}
+
+/**
+ * Reads `stem.1` .. `stem.n`, where n is the value of `stem.0`. Unset elements
+ * read as empty strings. Returns false with an empty @p error when `stem.0` is
+ * not set.
+ *
+ * With crexxsaa ABI 4 the elements come back from one
+ * crexxsaa_address_variables_get_alloc() call in a single allocation.
+ */
+bool getStem(crexxsaa_context* context, const QString& stemName, QStringList* values, QString* error)
+{
+    StemNames names(stemName);
+    QString countText;
+    if (!getAddressBytes(context, names.at(0), &countText, error)) {
         return false;
     }
 
+    bool ok = false;
+    const qsizetype count = countText.trimmed().toLongLong(&ok);
+    if (!ok || count < 0) {
+        if (error) {
+            *error = QStringLiteral("CREXX stem %1.0 is not a count: %2").arg(stemName, countText);
+        }
+        return false;
+    }
+
+    values->clear();
+    values->reserve(count);
+    if (count == 0) {
+        return true;
+    }
+
+#if CREXXSAA_ABI_VERSION >= 4
+    // All element names in one buffer, NUL separated
+    QByteArray nameBuffer;
+    std::vector<qsizetype> nameOffsets;
+    nameOffsets.reserve(static_cast<size_t>(count));
+    for (qsizetype i = 1; i <= count; ++i) {
+        nameOffsets.push_back(nameBuffer.size());
+        nameBuffer += names.at(i);
+        nameBuffer += '\0';
+    }
+    std::vector<const char*> namePointers;
+    namePointers.reserve(nameOffsets.size());
+    for (const qsizetype offset : nameOffsets) {
+        namePointers.push_back(nameBuffer.constData() + offset);
+    }
+
+    char* raw = nullptr;
+    std::vector<size_t> lengths(static_cast<size_t>(count));
+    std::vector<int> codes(static_cast<size_t>(count));
+    const int rc = crexxsaa_address_variables_get_alloc(context, namePointers.data(), namePointers.size(),
+                                                        &raw, lengths.data(), codes.data());
     if (rc != CREXXSAA_VARIABLE_OK) {
         if (error) {
-            *error = QStringLiteral("CREXX variable get failed for %1: %2")
-                         .arg(name, fromUtf8(crexxsaa_last_error(context)));
+            *error = QStringLiteral("CREXX stem get failed for %1: %2")
+                         .arg(stemName, fromUtf8(crexxsaa_last_error(context)));
         }
         return false;
     }
 
-    if (value) {
-        *value = QString::fromUtf8(raw, static_cast<qsizetype>(len));
+    const char* data = raw;
+    for (size_t i = 0; i < lengths.size(); ++i) {
+        values->append(codes[i] == CREXXSAA_VARIABLE_OK
+                           ? QString::fromUtf8(data, static_cast<qsizetype>(lengths[i]))
+                           : QString());
+        data += lengths[i];
     }
     crexxsaa_free(raw);
     return true;
+#else
+    for (qsizetype i = 1; i <= count; ++i) {
+        QString value;
+        if (!getAddressBytes(context, names.at(i), &value, error) && error && !error->isEmpty()) {
+            return false;
+        }
+        values->append(value);
+    }
+    return true;
+#endif
 }
 
 QString resolveCommandPayload(const crexxsaa_address_request* request, const QString& command)
@@ -272,6 +412,45 @@ QString anchorName(const QString& token)
     return validAnchorName(name) ? name : QString();
 }
 
+// A stem anchor names the stem with a trailing dot, e.g. ":items."
+QString stemAnchorName(const QString& token)
+{
+    const QString trimmed = token.trimmed();
+    if (!trimmed.startsWith(QLatin1Char(':')) || !trimmed.endsWith(QLatin1Char('.'))) {
+        return QString();
+    }
+    return anchorName(trimmed.chopped(1));
+}
+
+// Stem elements for a pin value: list entries, the entries of a JSON array string,
+// or the value itself as the only element
+QStringList stemValues(const QVariant& value)
+{
+    QVariantList items;
+    const int type = value.typeId();
+    if (type == QMetaType::QVariantList || type == QMetaType::QStringList) {
+        items = value.toList();
+    } else if (!value.isValid() || value.isNull()) {
+        return {};
+    } else {
+        const QString text = value.toString();
+        const QJsonDocument document = text.trimmed().startsWith(QLatin1Char('['))
+            ? QJsonDocument::fromJson(text.toUtf8())
+            : QJsonDocument();
+        if (!document.isArray()) {
+            return {text};
+        }
+        items = document.array().toVariantList();
+    }
+
+    QStringList values;
+    values.reserve(items.size());
+    for (const QVariant& item : items) {
+        values.append(variantToProtocolString(item));
+    }
+    return values;
+}
+
 QString commandRest(const QString& command)
 {
     const int firstSpace = command.indexOf(QLatin1Char(' '));
@@ -295,11 +474,33 @@ QString commandWord(QString* rest)
     return trimmed.left(firstSpace);
 }
 
+int handlePipelineCommand(const crexxsaa_address_request* request,
+                          crexxsaa_address_response* response,
+                          CrexxThreadState* state);
+
 int pipelineAddressCallback(const crexxsaa_address_request* request,
                             crexxsaa_address_response* response,
                             void* userdata)
 {
     auto* state = static_cast<CrexxThreadState*>(userdata);
+    ScriptProfile* commandTimes = state && state->invocation ? state->invocation->commandTimes : nullptr;
+    if (!commandTimes) {
+        return handlePipelineCommand(request, response, state);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const int rc = handlePipelineCommand(request, response, state);
+    const QString op = request ? fromUtf8(request->command).trimmed().section(QLatin1Char(' '), 0, 0).toUpper()
+                               : QString();
+    commandTimes->add(QStringLiteral("PIPELINE ") + op, timer.nsecsElapsed() / 1000);
+    return rc;
+}
+
+int handlePipelineCommand(const crexxsaa_address_request* request,
+                          crexxsaa_address_response* response,
+                          CrexxThreadState* state)
+{
     if (!request || !request->context || !response || !state || !state->invocation) {
         return -1;
     }
@@ -333,6 +534,19 @@ int pipelineAddressCallback(const crexxsaa_address_request* request,
             return 0;
         }
 
+        const QVariant value = state->invocation->host
+            ? state->invocation->host->getInput(pinName)
+            : QVariant();
+
+        const QString stemName = stemAnchorName(rest);
+        if (!stemName.isEmpty()) {
+            if (!setStem(request->context, stemName, stemValues(value), &error)) {
+                state->lastError = error;
+                response->rc = 44;
+            }
+            return 0;
+        }
+
         const QString targetName = anchorName(rest);
         if (targetName.isEmpty()) {
             state->lastError = QStringLiteral("PIPELINE GET INTO requires a host variable target");
@@ -340,9 +554,6 @@ int pipelineAddressCallback(const crexxsaa_address_request* request,
             return 0;
         }
 
-        const QVariant value = state->invocation->host
-            ? state->invocation->host->getInput(pinName)
-            : QVariant();
         const QString protocolValue = variantToProtocolString(value);
         if (!setAddressVariable(request->context, targetName, protocolValue, &error)) {
             state->lastError = error;
@@ -360,6 +571,23 @@ int pipelineAddressCallback(const crexxsaa_address_request* request,
             return 0;
         }
 
+        const QString stemName = stemAnchorName(rest);
+        if (!stemName.isEmpty()) {
+            QStringList values;
+            QString error;
+            if (!getStem(request->context, stemName, &values, &error)) {
+                state->lastError = error.isEmpty()
+                    ? QStringLiteral("PIPELINE SET found no stem %1. (%1.0 is not set)").arg(stemName)
+                    : error;
+                response->rc = 51;
+                return 0;
+            }
+            if (state->invocation->host) {
+                state->invocation->host->setOutput(pinName, QVariant(values));
+            }
+            return 0;
+        }
+
         const QString value = resolveCommandPayload(request, QStringLiteral("SET ") + rest);
         if (state->invocation->host) {
             state->invocation->host->setOutput(pinName, value);
@@ -530,31 +758,63 @@ QString wrapScript(const QString& script)
         + QStringLiteral("  return 0\n");
 }
 
-bool writeScriptSource(const QString& wrappedScript, IScriptHost* host, QString* sourcePath, QString* error)
+// Wrapped sources by script hash, so repeat runs skip wrapping and procedure scanning
+QMutex g_sourcesMutex;
+QHash<QByteArray, QString> g_sources;
+
+constexpr qint64 kMaxSourceBytes = 64LL * 1024 * 1024;
+
+// Wrapped sources, and anything CREXX names after them, share one byte budget
+DiskLruStore& sourceStore()
 {
-    const QByteArray scriptBytes = wrappedScript.toUtf8();
-    const QByteArray hash = QCryptographicHash::hash(scriptBytes, QCryptographicHash::Sha256).toHex();
-    const QString path = QDir(scriptDirPath(host)).absoluteFilePath(
-        QStringLiteral("universal-script-%1.rexx").arg(QString::fromLatin1(hash.left(16))));
+    static DiskLruStore store(cacheDirPath(), kMaxSourceBytes, {QStringLiteral("universal-script-*")});
+    return store;
+}
 
-    QFile file(path);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
-        if (error) {
-            *error = QStringLiteral("Unable to write CREXX source %1: %2").arg(path, file.errorString());
-        }
-        return false;
+/**
+ * Path of the wrapped source for @p script, written on first use.
+ *
+ * Sources live in the persistent cache directory under a name made from the
+ * script hash and the crexxsaa ABI version. An unchanged script keeps the
+ * same file, never rewritten, so what CREXX compiled from it last time is
+ * still current, across runs and across sessions. Hits are not touched for
+ * the same reason, so once the sources pass their budget the oldest written
+ * go first; a script that is still in use is written again on its next run.
+ */
+bool preparedSource(const QString& script, QString* sourcePath, QString* error)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(QByteArray::number(CREXXSAA_ABI_VERSION));
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(script.toUtf8());
+    const QByteArray key = hash.result().toHex();
+
+    QMutexLocker locker(&g_sourcesMutex);
+    const auto it = g_sources.constFind(key);
+    if (it != g_sources.constEnd() && QFileInfo::exists(*it)) {
+        *sourcePath = *it;
+        return true;
     }
 
-    if (file.write(scriptBytes) != scriptBytes.size()) {
-        if (error) {
-            *error = QStringLiteral("Unable to write full CREXX source %1").arg(path);
+    DiskLruStore& store = sourceStore();
+    const QString path = QDir(store.directory()).absoluteFilePath(
+        QStringLiteral("universal-script-%1.rexx").arg(QString::fromLatin1(key.left(32))));
+    if (!QFileInfo::exists(path)) {
+        const QByteArray scriptBytes = wrapScript(script).toUtf8();
+        const bool written = store.write(path, [&scriptBytes](QIODevice* file) {
+            file->setTextModeEnabled(true);
+            return file->write(scriptBytes) == scriptBytes.size();
+        });
+        if (!written) {
+            if (error) {
+                *error = QStringLiteral("Unable to write CREXX source %1").arg(path);
+            }
+            return false;
         }
-        return false;
     }
 
-    if (sourcePath) {
-        *sourcePath = path;
-    }
+    g_sources.insert(key, path);
+    *sourcePath = path;
     return true;
 }
 
@@ -565,12 +825,30 @@ QString CrexxRuntime::getEngineId() const
     return QStringLiteral("crexx");
 }
 
+void CrexxRuntime::prewarm(const QString& script)
+{
+    QString sourcePath;
+    QString error;
+    if (!preparedSource(script, &sourcePath, &error)) {
+        CP_WARN << "CrexxRuntime: prewarm failed:" << error;
+    }
+}
+
+ScriptProfile CrexxRuntime::takeProfile()
+{
+    return std::exchange(m_profile, ScriptProfile());
+}
+
 bool CrexxRuntime::execute(const QString& script, IScriptHost* host)
 {
     if (!host) {
         return false;
     }
 
+    QElapsedTimer clock;
+    clock.start();
+    m_profile = ScriptProfile();
+
     if (!t_crexxState) {
         t_crexxState = std::make_unique<CrexxThreadState>();
     }
@@ -582,16 +860,21 @@ bool CrexxRuntime::execute(const QString& script, IScriptHost* host)
         return false;
     }
 
-    const QString wrappedScript = wrapScript(script);
     QString sourcePath;
     QString error;
-    if (!writeScriptSource(wrappedScript, host, &sourcePath, &error)) {
+    if (!preparedSource(script, &sourcePath, &error)) {
         host->setError(error);
         return false;
     }
 
     PipelineInvocation invocation;
     invocation.host = host;
+    ScriptProfile commandTimes;
+    if (m_profiling) {
+        invocation.commandTimes = &commandTimes;
+        m_profile.add(QStringLiteral("(prepare)"), clock.nsecsElapsed() / 1000);
+        clock.restart();
+    }
 
     state->invocation = &invocation;
 
@@ -608,6 +891,14 @@ bool CrexxRuntime::execute(const QString& script, IScriptHost* host)
 
     state->invocation = nullptr;
 
+    if (m_profiling) {
+        // Commands are charged to themselves, the rest of the run to the script
+        for (auto it = commandTimes.stacks.cbegin(); it != commandTimes.stacks.cend(); ++it) {
+            m_profile.add(QStringLiteral("(script);") + it.key(), it.value());
+        }
+        m_profile.add(QStringLiteral("(script)"), qMax<qint64>(0, clock.nsecsElapsed() / 1000 - commandTimes.totalMicros()));
+    }
+
     for (const QString& log : invocation.logs) {
         if (!log.isEmpty()) {
             host->log(log);
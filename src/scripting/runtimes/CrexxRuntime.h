@@ -22,9 +22,24 @@
  * The runtime wraps the script body in a small CREXX module. Scripts may also
  * provide their own produce: procedure, but the pin contract remains the
  * PIPELINE ADDRESS environment.
+ *
+ * Wrapped sources are kept in the cache directory under the script's hash,
+ * so a script that has run before, in this session or an earlier one, reuses
+ * its source file and whatever CREXX compiled from it.
+ *
+ * The crexxsaa API has no call hooks, so profiling times what the host can
+ * see: preparing the run, each PIPELINE command, and the script's own time
+ * between them.
  */
 class CrexxRuntime : public IScriptEngine {
 public:
     bool execute(const QString& script, IScriptHost* host) override;
     QString getEngineId() const override;
+    void prewarm(const QString& script) override;
+    void setProfiling(bool enabled) override { m_profiling = enabled; }
+    ScriptProfile takeProfile() override;
+
+private:
+    bool m_profiling = false;
+    ScriptProfile m_profile;
 };
@@ -23,40 +23,338 @@
 //
 
 #include "QuickJSRuntime.h"
+#include "DiskLruStore.h"
 #include "Logger.h"
 #include "quickjs-libc.h"
 #include "ScriptDatabaseBridge.h"
+#include <QCache>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QHash>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QStandardPaths>
 
-QuickJSRuntime::QuickJSRuntime() {
-    m_rt = JS_NewRuntime();
-    js_std_init_handlers(m_rt);
-    m_ctx = JS_NewContext(m_rt);
+#include <cstring>
+#include <memory>
+#include <utility>
 
-    // Loader for ES6 modules
-    JS_SetModuleLoaderFunc(m_rt, NULL, js_module_loader, NULL);
+namespace {
+
+struct SharedBytes;
+
+// One runtime per thread; QuickJS runtimes must stay on the thread that made them
+struct ThreadRuntime {
+    ThreadRuntime() {
+        rt = JS_NewRuntime();
+        js_std_init_handlers(rt);
+
+        // Loader for ES6 modules
+        JS_SetModuleLoaderFunc(rt, NULL, js_module_loader, NULL);
+    }
+
+    ~ThreadRuntime() {
+        js_std_free_handlers(rt);
+        JS_FreeRuntime(rt);
+    }
+
+    JSRuntime* rt;
+    bool classesRegistered = false;
+    // Uint8Arrays made over pipeline bytes, by their data pointer
+    QHash<const uint8_t*, SharedBytes*> sharedBytes;
+};
+
+// How often a profiled script's stack is sampled
+constexpr qint64 kProfileIntervalNs = 1000 * 1000;
+// Frames kept per sample; QuickJS keeps 10 by default
+constexpr int kProfileStackDepth = 64;
+
+// Heap a script may fill before the first collection; its context goes away whole when it returns
+constexpr size_t kScriptGcThreshold = 8 * 1024 * 1024;
+
+size_t heapInUse(JSRuntime* rt) {
+    JSMemoryUsage usage;
+    JS_ComputeMemoryUsage(rt, &usage);
+    return static_cast<size_t>(usage.malloc_size);
+}
+
+ThreadRuntime& threadState() {
+    static thread_local ThreadRuntime runtime;
+    return runtime;
+}
+
+// The bytes behind a Uint8Array handed to a script, so returning it shares them again
+struct SharedBytes {
+    QByteArray bytes;
+    QHash<const uint8_t*, SharedBytes*>* registry;
+};
+
+void freeSharedBytes(JSRuntime* rt, void* opaque, void* ptr) {
+    Q_UNUSED(rt);
+    auto* shared = static_cast<SharedBytes*>(opaque);
+    shared->registry->remove(static_cast<const uint8_t*>(ptr));
+    delete shared;
+}
+
+JSValue bytesToJs(JSContext* ctx, const QByteArray& bytes) {
+    if (bytes.isEmpty()) {
+        return JS_NewUint8ArrayCopy(ctx, nullptr, 0);
+    }
+    ThreadRuntime& state = threadState();
+    auto* shared = new SharedBytes{bytes, &state.sharedBytes};
+    // data() detaches, so a script writing to the array never changes the caller's bytes
+    uint8_t* data = reinterpret_cast<uint8_t*>(shared->bytes.data());
+    state.sharedBytes.insert(data, shared);
+    return JS_NewUint8Array(ctx, data, static_cast<size_t>(bytes.size()), freeSharedBytes, shared, false);
+}
+
+QVariant bytesToVariant(JSContext* ctx, JSValueConst val) {
+    size_t offset = 0;
+    size_t length = 0;
+    const bool isBuffer = JS_IsArrayBuffer(val);
+    JSValue buffer = isBuffer ? JS_DupValue(ctx, val) : JS_GetTypedArrayBuffer(ctx, val, &offset, &length, nullptr);
+    size_t size = 0;
+    const uint8_t* data = JS_GetArrayBuffer(ctx, &size, buffer);
+    JS_FreeValue(ctx, buffer);
+    if (!data) {
+        // Detached buffers throw; they carry no bytes
+        JS_FreeValue(ctx, JS_GetException(ctx));
+        return QByteArray();
+    }
+    if (isBuffer) {
+        length = size;
+    }
+
+    const SharedBytes* shared = threadState().sharedBytes.value(data);
+    if (shared && offset == 0 && length == size) {
+        return shared->bytes;
+    }
+    return QByteArray(reinterpret_cast<const char*>(data + offset), static_cast<qsizetype>(length));
+}
+
+// Backs a pipeline.inputView() object
+struct VariantView {
+    QVariantMap map;
+    QVariantList list;
+    bool isList = false;
+};
+
+JSClassID g_viewClassId = 0;
+
+// Heuristic: If the script contains "import" or "export", treat it as a module.
+// Otherwise, wrap it in an IIFE (Immediately Invoked Function Expression) to support top-level "return".
+bool isModuleScript(const QString& script) {
+    return script.contains(QStringLiteral("import ")) || script.contains(QStringLiteral("export "));
+}
+
+bool isViewable(const QVariant& value) {
+    const int type = value.typeId();
+    return type == QMetaType::QVariantMap || type == QMetaType::QVariantHash
+        || type == QMetaType::QVariantList || type == QMetaType::QStringList;
+}
+
+JSValue stringToJs(JSContext* ctx, const QString& str) {
+    // QString and QuickJS wide strings are both UTF-16, so this is a plain copy
+    return JS_NewTwoByteString(ctx, reinterpret_cast<const uint16_t*>(str.utf16()), static_cast<size_t>(str.size()));
+}
+
+// Serialised bytecode kept in memory, across threads; the cost of an entry is its size
+constexpr qsizetype kMaxCachedBytecodeBytes = 32 * 1024 * 1024;
+
+QMutex g_bytecodeMutex;
+QCache<QByteArray, QByteArray> g_bytecode(kMaxCachedBytecodeBytes);
+
+// The disk tier, shared like the memory one; null unless CP_QUICKJS_BYTECODE_CACHE is "1"
+// (the default directory) or a directory path, or setBytecodeCacheDirectory() named one
+QMutex g_bytecodeStoreMutex;
+std::shared_ptr<DiskLruStore> g_bytecodeStore;
+bool g_bytecodeStoreConfigured = false;
+
+std::shared_ptr<DiskLruStore> bytecodeStore() {
+    QMutexLocker locker(&g_bytecodeStoreMutex);
+    if (!g_bytecodeStoreConfigured) {
+        g_bytecodeStoreConfigured = true;
+        const QString configured = qEnvironmentVariable("CP_QUICKJS_BYTECODE_CACHE").trimmed();
+        if (!configured.isEmpty() && configured != QStringLiteral("0")) {
+            const QString dir = configured == QStringLiteral("1")
+                ? QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/quickjs_bytecode")
+                : configured;
+            g_bytecodeStore = std::make_shared<DiskLruStore>(dir, QuickJSRuntime::kDefaultBytecodeCacheBytes,
+                                                             QStringList{QStringLiteral("*.qjsbc")});
+        }
+    }
+    return g_bytecodeStore;
+}
+
+// Bytecode is only valid for the QuickJS version that wrote it
+QByteArray bytecodeKey(const QByteArray& source, bool isModule) {
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(QByteArray(JS_GetVersion()));
+    hash.addData(isModule ? QByteArrayLiteral("\0module\0") : QByteArrayLiteral("\0script\0"));
+    hash.addData(source);
+    return hash.result().toHex();
+}
+
+QByteArray lookupBytecode(const QByteArray& key) {
+    {
+        QMutexLocker locker(&g_bytecodeMutex);
+        if (const QByteArray* cached = g_bytecode.object(key)) {
+            return *cached;
+        }
+    }
+    const std::shared_ptr<DiskLruStore> store = bytecodeStore();
+    if (!store) {
+        return QByteArray();
+    }
+    const QString path = store->entryPath(QString::fromLatin1(key), QStringLiteral(".qjsbc"));
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    const QByteArray bytecode = file.readAll();
+    file.close();
+    store->touch(path);
+    if (!bytecode.isEmpty()) {
+        QMutexLocker locker(&g_bytecodeMutex);
+        g_bytecode.insert(key, new QByteArray(bytecode), bytecode.size());
+    }
+    return bytecode;
+}
+
+void storeBytecode(const QByteArray& key, const QByteArray& bytecode) {
+    {
+        QMutexLocker locker(&g_bytecodeMutex);
+        g_bytecode.insert(key, new QByteArray(bytecode), bytecode.size());
+    }
+    if (const std::shared_ptr<DiskLruStore> store = bytecodeStore()) {
+        store->write(store->entryPath(QString::fromLatin1(key), QStringLiteral(".qjsbc")),
+                     [&bytecode](QIODevice* file) { return file->write(bytecode) == bytecode.size(); });
+    }
+}
+
+} // namespace
+
+JSRuntime* QuickJSRuntime::threadRuntime() {
+    ThreadRuntime& state = threadState();
+    if (!state.classesRegistered) {
+        registerViewClass(state.rt);
+        state.classesRegistered = true;
+    }
+    return state.rt;
+}
+
+void QuickJSRuntime::registerViewClass(JSRuntime* rt) {
+    // Class ids are process-wide; every runtime registers the class under the same one
+    static const JSClassID classId = [rt]() {
+        JS_NewClassID(rt, &g_viewClassId);
+        return g_viewClassId;
+    }();
+    static JSClassExoticMethods exotic = []() {
+        JSClassExoticMethods methods{};
+        methods.get_own_property = js_view_get_own_property;
+        methods.get_own_property_names = js_view_get_own_property_names;
+        methods.delete_property = js_view_delete_property;
+        methods.define_own_property = js_view_define_own_property;
+        return methods;
+    }();
+
+    JSClassDef def{};
+    def.class_name = "PipelineView";
+    def.finalizer = js_view_finalizer;
+    def.exotic = &exotic;
+    JS_NewClass(rt, classId, &def);
+}
+
+QuickJSRuntime::QuickJSRuntime()
+    : m_rt(threadRuntime()) {
+}
+
+QuickJSRuntime::~QuickJSRuntime() = default;
+
+JSContext* QuickJSRuntime::newContext() const {
+    JSContext* ctx = JS_NewContext(m_rt);
 
     // Standard modules
-    js_init_module_std(m_ctx, "std");
-    js_init_module_os(m_ctx, "os");
+    js_init_module_std(ctx, "std");
+    js_init_module_os(ctx, "os");
 
     // Standard helpers (console, print, etc.)
-    js_std_add_helpers(m_ctx, 0, nullptr);
+    js_std_add_helpers(ctx, 0, nullptr);
+    return ctx;
+}
 
-    // Initialize database bridge
-    m_dbBridge = std::make_unique<ScriptDatabaseBridge>();
+qsizetype QuickJSRuntime::cachedScriptCount() {
+    QMutexLocker locker(&g_bytecodeMutex);
+    return g_bytecode.count();
 }
 
-QuickJSRuntime::~QuickJSRuntime() {
-    js_std_free_handlers(m_rt);
+void QuickJSRuntime::setBytecodeCacheDirectory(const QString& directory, qint64 maxBytes) {
+    QMutexLocker locker(&g_bytecodeStoreMutex);
+    g_bytecodeStore = directory.isEmpty()
+        ? nullptr
+        : std::make_shared<DiskLruStore>(directory, maxBytes > 0 ? maxBytes : kDefaultBytecodeCacheBytes,
+                                         QStringList{QStringLiteral("*.qjsbc")});
+    g_bytecodeStoreConfigured = true;
+}
+
+JSValue QuickJSRuntime::compile(const QByteArray& source, bool isModule) {
+    const QByteArray key = bytecodeKey(source, isModule);
+    const QByteArray cached = lookupBytecode(key);
+    if (!cached.isEmpty()) {
+        JSValue obj = JS_ReadObject(m_ctx, reinterpret_cast<const uint8_t*>(cached.constData()),
+                                    static_cast<size_t>(cached.size()), JS_READ_OBJ_BYTECODE);
+        if (!JS_IsException(obj) && JS_ResolveModule(m_ctx, obj) == 0) {
+            return obj;
+        }
+        // Unreadable bytecode is compiled again and replaced
+        JS_FreeValue(m_ctx, obj);
+        JS_FreeValue(m_ctx, JS_GetException(m_ctx));
+    }
+
+    JSValue obj;
+    if (isModule) {
+        obj = JS_Eval(m_ctx, source.constData(), static_cast<size_t>(source.size()), "<input>",
+                      JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY);
+    } else {
+        const QByteArray wrapped = QByteArrayLiteral("(function(){\n") + source + QByteArrayLiteral("\n})()");
+        obj = JS_Eval(m_ctx, wrapped.constData(), static_cast<size_t>(wrapped.size()), "<input>",
+                      JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
+    }
+    if (JS_IsException(obj)) {
+        return obj;
+    }
+
+    size_t size = 0;
+    if (uint8_t* bytecode = JS_WriteObject(m_ctx, &size, obj, JS_WRITE_OBJ_BYTECODE)) {
+        storeBytecode(key, QByteArray(reinterpret_cast<const char*>(bytecode), static_cast<qsizetype>(size)));
+        js_free(m_ctx, bytecode);
+    }
+    return obj;
+}
+
+void QuickJSRuntime::prewarm(const QString& script) {
+    // Compiling fills the bytecode cache; nothing runs
+    m_ctx = newContext();
+    JSValue compiled = compile(script.toUtf8(), isModuleScript(script));
+    if (JS_IsException(compiled)) {
+        JS_FreeValue(m_ctx, JS_GetException(m_ctx));
+    } else {
+        JS_FreeValue(m_ctx, compiled);
+    }
     JS_FreeContext(m_ctx);
-    JS_FreeRuntime(m_rt);
+    m_ctx = nullptr;
 }
 
 bool QuickJSRuntime::execute(const QString& script, IScriptHost* host) {
     if (!host) return false;
 
+    // A fresh context and database bridge, so nothing carries over from the last script
+    m_ctx = newContext();
+    m_dbBridge = std::make_unique<ScriptDatabaseBridge>();
+
     // Set host as current and this as opaque data in the context
     m_currentHost = host;
     JS_SetContextOpaque(m_ctx, this);
@@ -64,30 +362,59 @@ bool QuickJSRuntime::execute(const QString& script, IScriptHost* host) {
     // Setup global environment (console, pipeline, sqlite)
     setupGlobalEnv(host);
 
-    std::string scriptStd = script.toStdString();
-    
-    // Heuristic: If the script contains "import" or "export", treat it as a module.
-    // Otherwise, wrap it in an IIFE (Immediately Invoked Function Expression) to support top-level "return".
-    bool isModule = script.contains(QStringLiteral("import ")) || script.contains(QStringLiteral("export "));
-    
-    JSValue val;
-    if (isModule) {
-        val = JS_Eval(m_ctx, scriptStd.c_str(), scriptStd.length(), "<input>", JS_EVAL_TYPE_MODULE);
-    } else {
-        std::string wrapped = "(function(){\n" + scriptStd + "\n})()";
-        val = JS_Eval(m_ctx, wrapped.c_str(), wrapped.length(), "<input>", JS_EVAL_TYPE_GLOBAL);
+    // Budgets; the memory limit counts from what the shared runtime holds now
+    const size_t previousGcThreshold = JS_GetGCThreshold(m_rt);
+    size_t gcThreshold = kScriptGcThreshold;
+    if (m_limits.memoryLimitMb > 0) {
+        const size_t budget = static_cast<size_t>(m_limits.memoryLimitMb) * 1024 * 1024;
+        const size_t baseline = heapInUse(m_rt);
+        JS_SetMemoryLimit(m_rt, baseline + budget);
+        // Collect before the limit is reached, so garbage doesn't count against it
+        gcThreshold = baseline + qMin(kScriptGcThreshold, budget / 2);
+    }
+    JS_SetGCThreshold(m_rt, qMax(previousGcThreshold, gcThreshold));
+    m_deadline = m_limits.timeoutMs > 0 ? QDeadlineTimer(m_limits.timeoutMs) : QDeadlineTimer(QDeadlineTimer::Forever);
+    m_cancellation = CancellationToken::current();
+    m_interruption = Interruption::None;
+    JS_SetInterruptHandler(m_rt, js_interrupt, this);
+
+    const bool isModule = isModuleScript(script);
+    if (m_profiling) {
+        m_profile = ScriptProfile();
+        m_profilingModule = isModule;
+        m_lastStack.clear();
+        JSValue global = JS_GetGlobalObject(m_ctx);
+        JSValue errorCtor = JS_GetPropertyStr(m_ctx, global, "Error");
+        JS_SetPropertyStr(m_ctx, errorCtor, "stackTraceLimit", JS_NewInt32(m_ctx, kProfileStackDepth));
+        JS_FreeValue(m_ctx, errorCtor);
+        JS_FreeValue(m_ctx, global);
+        m_sampleClock.start();
     }
 
+    JSValue compiled = compile(script.toUtf8(), isModule);
+    JSValue val = JS_IsException(compiled) ? compiled : JS_EvalFunction(m_ctx, compiled);
+
+    // Reporting the error must not run into the limit the script hit
+    JS_SetMemoryLimit(m_rt, 0);
+
     bool success = true;
     if (JS_IsException(val)) {
         JSValue exception = JS_GetException(m_ctx);
         const char* msg = JS_ToCString(m_ctx, exception);
-        JSValue stack = JS_GetPropertyStr(m_ctx, exception, "stack");
-        const char* stackTrace = JS_ToCString(m_ctx, stack);
+        JSValue stack = JS_IsObject(exception) ? JS_GetPropertyStr(m_ctx, exception, "stack") : JS_UNDEFINED;
+        const char* stackTrace = JS_IsUndefined(stack) ? nullptr : JS_ToCString(m_ctx, stack);
 
-        QString errorMsg = QString::fromUtf8(msg);
-        if (stackTrace) {
-            errorMsg += "\nStack trace:\n" + QString::fromUtf8(stackTrace);
+        QString errorMsg = interruptionMessage();
+        // QuickJS throws null when it can't even allocate the error
+        const bool outOfMemory = JS_IsNull(exception) || (msg && std::strstr(msg, "out of memory"));
+        if (errorMsg.isEmpty() && m_limits.memoryLimitMb > 0 && outOfMemory) {
+            errorMsg = QStringLiteral("Script exceeded its memory limit of %1 MB").arg(m_limits.memoryLimitMb);
+        }
+        if (errorMsg.isEmpty()) {
+            errorMsg = QString::fromUtf8(msg);
+            if (stackTrace) {
+                errorMsg += "\nStack trace:\n" + QString::fromUtf8(stackTrace);
+            }
         }
 
         host->setError(errorMsg);
@@ -108,10 +435,133 @@ bool QuickJSRuntime::execute(const QString& script, IScriptHost* host) {
     }
 
     JS_FreeValue(m_ctx, val);
+
+    // Promise jobs the script queued run now rather than during a later script
+    JSContext* jobCtx = nullptr;
+    for (int ret; (ret = JS_ExecutePendingJob(m_rt, &jobCtx)) != 0;) {
+        if (ret < 0) {
+            JS_FreeValue(jobCtx, JS_GetException(jobCtx));
+        }
+    }
+
+    if (m_profiling) {
+        // The time since the last sample goes to what was running then
+        m_profile.add(m_lastStack.isEmpty() ? QStringLiteral("(script)") : m_lastStack,
+                      m_sampleClock.nsecsElapsed() / 1000);
+    }
+    JS_SetInterruptHandler(m_rt, nullptr, nullptr);
+    m_cancellation = CancellationToken();
+
+    for (JSValue value : std::as_const(m_inputCache)) {
+        JS_FreeValue(m_ctx, value);
+    }
+    m_inputCache.clear();
+
+    // Timers and handlers the script registered would outlive it on the shared runtime
+    js_std_free_handlers(m_rt);
+    JS_FreeContext(m_ctx);
+    m_ctx = nullptr;
+    m_dbBridge.reset();
     m_currentHost = nullptr;
+
+    // Cycles the script left behind go now rather than pile up across runs
+    JS_RunGC(m_rt);
+    JS_SetGCThreshold(m_rt, previousGcThreshold);
     return success;
 }
 
+QString QuickJSRuntime::interruptionMessage() const {
+    switch (m_interruption) {
+    case Interruption::Timeout:
+        return QStringLiteral("Script exceeded its time limit of %1 ms").arg(m_limits.timeoutMs);
+    case Interruption::Cancelled:
+        return QStringLiteral("Script cancelled");
+    case Interruption::None:
+        break;
+    }
+    return QString();
+}
+
+int QuickJSRuntime::js_interrupt(JSRuntime* rt, void* opaque) {
+    Q_UNUSED(rt);
+    auto* self = static_cast<QuickJSRuntime*>(opaque);
+    if (self->m_cancellation.isCancelled()) {
+        self->m_interruption = Interruption::Cancelled;
+    } else if (self->m_deadline.hasExpired()) {
+        self->m_interruption = Interruption::Timeout;
+    } else if (self->m_profiling && self->m_sampleClock.nsecsElapsed() >= kProfileIntervalNs) {
+        self->sampleStack();
+    }
+    return self->m_interruption != Interruption::None;
+}
+
+void QuickJSRuntime::sampleStack() {
+    const qint64 micros = m_sampleClock.nsecsElapsed() / 1000;
+    m_sampleClock.restart();
+
+    // Time the stack can't be read for goes to what ran last
+    const QString stack = currentStack();
+    if (!stack.isEmpty()) {
+        m_lastStack = stack;
+    }
+    m_profile.add(m_lastStack.isEmpty() ? QStringLiteral("(script)") : m_lastStack, micros);
+}
+
+QString QuickJSRuntime::currentStack() const {
+    // An Error made here carries the backtrace of the code being interrupted
+    JSValue error = JS_NewError(m_ctx);
+    if (JS_IsException(error)) {
+        JS_FreeValue(m_ctx, JS_GetException(m_ctx));
+        return QString();
+    }
+    JSValue stack = JS_GetPropertyStr(m_ctx, error, "stack");
+    const char* text = JS_IsString(stack) ? JS_ToCString(m_ctx, stack) : nullptr;
+    const QString backtrace = QString::fromUtf8(text);
+    JS_FreeCString(m_ctx, text);
+    JS_FreeValue(m_ctx, stack);
+    JS_FreeValue(m_ctx, error);
+
+    // "    at name (<input>:line:column)", innermost first
+    static const QRegularExpression framePattern(QStringLiteral("^\\s*at (.+?) \\((?:.*?:(\\d+):\\d+|[^)]*)\\)$"));
+    struct Frame {
+        QString name;
+        int line;
+    };
+    QList<Frame> frames;
+    for (const QString& line : backtrace.split(QLatin1Char('\n'), Qt::SkipEmptyParts)) {
+        const QRegularExpressionMatch match = framePattern.match(line);
+        if (match.hasMatch()) {
+            frames.append({match.captured(1), match.captured(2).toInt()});
+        }
+    }
+    if (frames.isEmpty()) {
+        return QString();
+    }
+
+    // A plain script runs inside a wrapper function one line down, called from <eval>
+    const int lineOffset = m_profilingModule ? 0 : 1;
+    if (!m_profilingModule && frames.size() > 1 && frames.last().name == QLatin1String("<eval>")) {
+        frames.removeLast();
+    }
+    // The top level is one root for every sample, whichever line it is on
+    const QString outermost = m_profilingModule ? QStringLiteral("<eval>") : QStringLiteral("<anonymous>");
+    if (frames.last().name == outermost) {
+        frames.last() = Frame{QStringLiteral("(script)"), 0};
+    }
+
+    QString folded;
+    for (auto it = frames.crbegin(); it != frames.crend(); ++it) {
+        if (!folded.isEmpty()) {
+            folded += QLatin1Char(';');
+        }
+        folded += it->name;
+        if (it->line > 0) {
+            folded += QStringLiteral(" (line %1)").arg(qMax(1, it->line - lineOffset));
+        }
+    }
+    return folded;
+}
+
 void QuickJSRuntime::setupGlobalEnv(IScriptHost* host) {
     JSValue global_obj = JS_GetGlobalObject(m_ctx);
 
@@ -127,6 +577,7 @@ void QuickJSRuntime::setupGlobalEnv(IScriptHost* host) {
     // pipeline object
     JSValue pipeline = JS_NewObject(m_ctx);
     JS_SetPropertyStr(m_ctx, pipeline, "input", JS_NewCFunction(m_ctx, js_pipeline_get_input, "input", 1));
+    JS_SetPropertyStr(m_ctx, pipeline, "inputView", JS_NewCFunction(m_ctx, js_pipeline_get_input_view, "inputView", 1));
     JS_SetPropertyStr(m_ctx, pipeline, "output", JS_NewCFunction(m_ctx, js_pipeline_set_output, "output", 2));
     JS_SetPropertyStr(m_ctx, pipeline, "error", JS_NewCFunction(m_ctx, js_pipeline_set_error, "error", 1));
     JS_SetPropertyStr(m_ctx, pipeline, "tempDir", JS_NewCFunction(m_ctx, js_pipeline_get_temp_dir, "tempDir", 0));
@@ -136,6 +587,10 @@ void QuickJSRuntime::setupGlobalEnv(IScriptHost* host) {
     JSValue sqlite = JS_NewObject(m_ctx);
     JS_SetPropertyStr(m_ctx, sqlite, "connect", JS_NewCFunction(m_ctx, js_sqlite_connect, "connect", 1));
     JS_SetPropertyStr(m_ctx, sqlite, "exec", JS_NewCFunction(m_ctx, js_sqlite_exec, "exec", 2));
+    JS_SetPropertyStr(m_ctx, sqlite, "execMany", JS_NewCFunction(m_ctx, js_sqlite_exec_many, "execMany", 2));
+    JS_SetPropertyStr(m_ctx, sqlite, "begin", JS_NewCFunctionMagic(m_ctx, js_sqlite_transaction, "begin", 0, JS_CFUNC_generic_magic, kTransactionBegin));
+    JS_SetPropertyStr(m_ctx, sqlite, "commit", JS_NewCFunctionMagic(m_ctx, js_sqlite_transaction, "commit", 0, JS_CFUNC_generic_magic, kTransactionCommit));
+    JS_SetPropertyStr(m_ctx, sqlite, "rollback", JS_NewCFunctionMagic(m_ctx, js_sqlite_transaction, "rollback", 0, JS_CFUNC_generic_magic, kTransactionRollback));
     JS_SetPropertyStr(m_ctx, global_obj, "sqlite", sqlite);
 
     JS_FreeValue(m_ctx, global_obj);
@@ -176,6 +631,29 @@ JSValue QuickJSRuntime::js_console_error(JSContext* ctx, JSValueConst this_val,
 }
 
 JSValue QuickJSRuntime::js_pipeline_get_input(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+    QuickJSRuntime* self = static_cast<QuickJSRuntime*>(JS_GetContextOpaque(ctx));
+    IScriptHost* host = self ? self->m_currentHost : nullptr;
+    if (host && argc > 0) {
+        const char* key = JS_ToCString(ctx, argv[0]);
+        if (key) {
+            const QString name = QString::fromUtf8(key);
+            JS_FreeCString(ctx, key);
+            const auto cached = self->m_inputCache.constFind(name);
+            if (cached != self->m_inputCache.constEnd()) {
+                return JS_DupValue(ctx, *cached);
+            }
+            JSValue value = variantToJs(ctx, host->getInput(name));
+            if (!JS_IsException(value)) {
+                self->m_inputCache.insert(name, JS_DupValue(ctx, value));
+            }
+            return value;
+        }
+    }
+    return JS_UNDEFINED;
+}
+
+JSValue QuickJSRuntime::js_pipeline_get_input_view(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+    Q_UNUSED(this_val);
     QuickJSRuntime* self = static_cast<QuickJSRuntime*>(JS_GetContextOpaque(ctx));
     IScriptHost* host = self ? self->m_currentHost : nullptr;
     if (host && argc > 0) {
@@ -183,7 +661,7 @@ JSValue QuickJSRuntime::js_pipeline_get_input(JSContext* ctx, JSValueConst this_
         if (key) {
             QVariant val = host->getInput(QString::fromUtf8(key));
             JS_FreeCString(ctx, key);
-            return variantToJs(ctx, val);
+            return newView(ctx, val);
         }
     }
     return JS_UNDEFINED;
@@ -269,9 +747,47 @@ JSValue QuickJSRuntime::js_sqlite_exec(JSContext* ctx, JSValueConst this_val, in
     return JS_UNDEFINED;
 }
 
+JSValue QuickJSRuntime::js_sqlite_exec_many(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+    Q_UNUSED(this_val);
+    QuickJSRuntime* self = static_cast<QuickJSRuntime*>(JS_GetContextOpaque(ctx));
+    if (self && self->m_dbBridge && argc > 1) {
+        const char* sql = JS_ToCString(ctx, argv[0]);
+        if (sql) {
+            const QVariantList rows = jsToVariant(ctx, argv[1]).toList();
+            QJsonValue res = self->m_dbBridge->execMany(QString::fromUtf8(sql), rows);
+            JS_FreeCString(ctx, sql);
+            return qJsonToJSValue(ctx, res);
+        }
+    }
+    return JS_UNDEFINED;
+}
+
+JSValue QuickJSRuntime::js_sqlite_transaction(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv, int magic) {
+    Q_UNUSED(this_val);
+    Q_UNUSED(argc);
+    Q_UNUSED(argv);
+    QuickJSRuntime* self = static_cast<QuickJSRuntime*>(JS_GetContextOpaque(ctx));
+    if (!self || !self->m_dbBridge) {
+        return JS_UNDEFINED;
+    }
+    switch (magic) {
+    case kTransactionBegin:
+        return qJsonToJSValue(ctx, self->m_dbBridge->begin());
+    case kTransactionCommit:
+        return qJsonToJSValue(ctx, self->m_dbBridge->commit());
+    default:
+        return qJsonToJSValue(ctx, self->m_dbBridge->rollback());
+    }
+}
+
 QVariant QuickJSRuntime::jsToVariant(JSContext* ctx, JSValueConst val) {
     if (JS_IsNull(val) || JS_IsUndefined(val)) {
         return QVariant();
+    } else if (const auto* view = static_cast<const VariantView*>(JS_GetOpaque(val, g_viewClassId))) {
+        // A view passed back out is the data it was made from
+        return view->isList ? QVariant(view->list) : QVariant(view->map);
+    } else if (JS_IsArrayBuffer(val) || JS_GetTypedArrayType(val) >= 0) {
+        return bytesToVariant(ctx, val);
     } else if (JS_IsBool(val)) {
         return (bool)JS_ToBool(ctx, val);
     } else if (JS_IsNumber(val)) {
@@ -279,8 +795,9 @@ QVariant QuickJSRuntime::jsToVariant(JSContext* ctx, JSValueConst val) {
         JS_ToFloat64(ctx, &d, val);
         return d;
     } else if (JS_IsString(val)) {
-        const char* str = JS_ToCString(ctx, val);
-        QString qstr = QString::fromUtf8(str);
+        size_t len = 0;
+        const char* str = JS_ToCStringLen(ctx, &len, val);
+        QString qstr = QString::fromUtf8(str, static_cast<qsizetype>(len));
         JS_FreeCString(ctx, str);
         return qstr;
     } else if (JS_IsArray(val)) {
@@ -322,7 +839,9 @@ JSValue QuickJSRuntime::variantToJs(JSContext* ctx, const QVariant& var) {
     }
 
     if (var.typeId() == QMetaType::QString) {
-        return JS_NewString(ctx, var.toString().toUtf8().constData());
+        return stringToJs(ctx, var.toString());
+    } else if (var.typeId() == QMetaType::QByteArray) {
+        return bytesToJs(ctx, var.toByteArray());
     } else if (var.typeId() == QMetaType::Double ||
                var.typeId() == QMetaType::Float ||
                var.typeId() == QMetaType::Int ||
@@ -332,16 +851,171 @@ JSValue QuickJSRuntime::variantToJs(JSContext* ctx, const QVariant& var) {
         return JS_NewFloat64(ctx, var.toDouble());
     } else if (var.typeId() == QMetaType::Bool) {
         return JS_NewBool(ctx, var.toBool());
-    } else if (var.typeId() == QMetaType::QVariantMap ||
-               var.typeId() == QMetaType::QVariantList ||
-               var.typeId() == QMetaType::QStringList ||
-               var.canConvert<QVariantList>() ||
+    } else if (var.typeId() == QMetaType::QVariantMap || var.typeId() == QMetaType::QVariantHash) {
+        // Converted directly; going through QJsonValue would copy the whole tree first
+        JSValue jsObj = JS_NewObject(ctx);
+        const QVariantMap map = var.toMap();
+        for (auto it = map.constBegin(); it != map.constEnd(); ++it) {
+            JS_SetPropertyStr(ctx, jsObj, it.key().toUtf8().constData(), elementToJs(ctx, it.value()));
+        }
+        return jsObj;
+    } else if (var.typeId() == QMetaType::QVariantList || var.typeId() == QMetaType::QStringList) {
+        JSValue jsArr = JS_NewArray(ctx);
+        const QVariantList list = var.toList();
+        for (qsizetype i = 0; i < list.size(); ++i) {
+            JS_SetPropertyUint32(ctx, jsArr, static_cast<uint32_t>(i), elementToJs(ctx, list.at(i)));
+        }
+        return jsArr;
+    } else if (var.canConvert<QVariantList>() ||
                var.canConvert<QVariantMap>()) {
         return qJsonToJSValue(ctx, QJsonValue::fromVariant(var));
     }
     return JS_UNDEFINED;
 }
 
+JSValue QuickJSRuntime::elementToJs(JSContext* ctx, const QVariant& var) {
+    // As QJsonValue::fromVariant() did: null entries stay null, other types go through JSON
+    if (!var.isValid() || var.isNull()) {
+        return JS_NULL;
+    }
+    JSValue value = variantToJs(ctx, var);
+    if (JS_IsUndefined(value)) {
+        return qJsonToJSValue(ctx, QJsonValue::fromVariant(var));
+    }
+    return value;
+}
+
+JSValue QuickJSRuntime::newView(JSContext* ctx, const QVariant& value) {
+    if (!isViewable(value)) {
+        return variantToJs(ctx, value);
+    }
+    auto* view = new VariantView;
+    view->isList = value.typeId() == QMetaType::QVariantList || value.typeId() == QMetaType::QStringList;
+    if (view->isList) {
+        view->list = value.toList();
+    } else {
+        view->map = value.toMap();
+    }
+
+    JSValue obj;
+    if (view->isList) {
+        // Array methods are generic, so map(), slice() and for...of work on the view
+        JSValue global = JS_GetGlobalObject(ctx);
+        JSValue arrayCtor = JS_GetPropertyStr(ctx, global, "Array");
+        JSValue arrayProto = JS_GetPropertyStr(ctx, arrayCtor, "prototype");
+        obj = JS_NewObjectProtoClass(ctx, arrayProto, g_viewClassId);
+        JS_FreeValue(ctx, arrayProto);
+        JS_FreeValue(ctx, arrayCtor);
+        JS_FreeValue(ctx, global);
+    } else {
+        obj = JS_NewObjectClass(ctx, g_viewClassId);
+    }
+    if (JS_IsException(obj)) {
+        delete view;
+        return obj;
+    }
+    JS_SetOpaque(obj, view);
+    return obj;
+}
+
+int QuickJSRuntime::js_view_get_own_property(JSContext* ctx, JSPropertyDescriptor* desc, JSValueConst obj, JSAtom prop) {
+    const auto* view = static_cast<const VariantView*>(JS_GetOpaque(obj, g_viewClassId));
+    if (!view) {
+        return false;
+    }
+
+    JSValue key = JS_AtomToValue(ctx, prop);
+    const QVariant* value = nullptr;
+    bool isLength = false;
+    if (view->isList) {
+        int64_t index = -1;
+        if (JS_IsNumber(key) && JS_ToInt64(ctx, &index, key) == 0 && index >= 0 && index < view->list.size()) {
+            value = &view->list.at(static_cast<qsizetype>(index));
+        } else if (JS_IsString(key)) {
+            const char* name = JS_ToCString(ctx, key);
+            isLength = name && qstrcmp(name, "length") == 0;
+            JS_FreeCString(ctx, name);
+        }
+    } else if (!JS_IsSymbol(key)) {
+        size_t len = 0;
+        const char* name = JS_ToCStringLen(ctx, &len, key);
+        if (name) {
+            const auto it = view->map.constFind(QString::fromUtf8(name, static_cast<qsizetype>(len)));
+            if (it != view->map.constEnd()) {
+                value = &it.value();
+            }
+            JS_FreeCString(ctx, name);
+        }
+    }
+    JS_FreeValue(ctx, key);
+
+    if (!value && !isLength) {
+        return false;
+    }
+    if (desc) {
+        // Entries are read-only and enumerable; a list's length is neither
+        desc->flags = isLength ? 0 : JS_PROP_ENUMERABLE;
+        // Nested maps and lists are views too
+        desc->value = isLength ? JS_NewInt64(ctx, view->list.size())
+            : isViewable(*value) ? newView(ctx, *value) : elementToJs(ctx, *value);
+        desc->getter = JS_UNDEFINED;
+        desc->setter = JS_UNDEFINED;
+    }
+    return true;
+}
+
+int QuickJSRuntime::js_view_get_own_property_names(JSContext* ctx, JSPropertyEnum** ptab, uint32_t* plen, JSValueConst obj) {
+    const auto* view = static_cast<const VariantView*>(JS_GetOpaque(obj, g_viewClassId));
+    const qsizetype count = !view ? 0 : view->isList ? view->list.size() + 1 : view->map.size();
+    auto* tab = static_cast<JSPropertyEnum*>(js_malloc(ctx, sizeof(JSPropertyEnum) * static_cast<size_t>(qMax<qsizetype>(count, 1))));
+    if (!tab) {
+        return -1;
+    }
+
+    if (view && view->isList) {
+        for (qsizetype i = 0; i < view->list.size(); ++i) {
+            tab[i].is_enumerable = true;
+            tab[i].atom = JS_NewAtomUInt32(ctx, static_cast<uint32_t>(i));
+        }
+        tab[count - 1].is_enumerable = false;
+        tab[count - 1].atom = JS_NewAtom(ctx, "length");
+    } else if (view) {
+        qsizetype i = 0;
+        for (auto it = view->map.constBegin(); it != view->map.constEnd(); ++it, ++i) {
+            const QByteArray name = it.key().toUtf8();
+            tab[i].is_enumerable = true;
+            tab[i].atom = JS_NewAtomLen(ctx, name.constData(), static_cast<size_t>(name.size()));
+        }
+    }
+    *ptab = tab;
+    *plen = static_cast<uint32_t>(count);
+    return 0;
+}
+
+int QuickJSRuntime::js_view_delete_property(JSContext* ctx, JSValueConst obj, JSAtom prop) {
+    Q_UNUSED(obj);
+    Q_UNUSED(prop);
+    JS_ThrowTypeError(ctx, "pipeline.inputView() values are read-only; use pipeline.input() for a copy");
+    return -1;
+}
+
+int QuickJSRuntime::js_view_define_own_property(JSContext* ctx, JSValueConst this_obj, JSAtom prop, JSValueConst val,
+                                                JSValueConst getter, JSValueConst setter, int flags) {
+    Q_UNUSED(this_obj);
+    Q_UNUSED(prop);
+    Q_UNUSED(val);
+    Q_UNUSED(getter);
+    Q_UNUSED(setter);
+    Q_UNUSED(flags);
+    JS_ThrowTypeError(ctx, "pipeline.inputView() values are read-only; use pipeline.input() for a copy");
+    return -1;
+}
+
+void QuickJSRuntime::js_view_finalizer(JSRuntime* rt, JSValueConst val) {
+    Q_UNUSED(rt);
+    delete static_cast<VariantView*>(JS_GetOpaque(val, g_viewClassId));
+}
+
 JSValue QuickJSRuntime::qJsonToJSValue(JSContext* ctx, const QJsonValue& value) {
     if (value.isObject()) {
         QJsonObject obj = value.toObject();
@@ -358,7 +1032,7 @@ JSValue QuickJSRuntime::qJsonToJSValue(JSContext* ctx, const QJsonValue& value)
         }
         return jsArr;
     } else if (value.isString()) {
-        return JS_NewString(ctx, value.toString().toUtf8().constData());
+        return stringToJs(ctx, value.toString());
     } else if (value.isDouble()) {
         return JS_NewFloat64(ctx, value.toDouble());
     } else if (value.isBool()) {
@@ -24,16 +24,56 @@
 
 #pragma once
 
+#include "CancellationToken.h"
 #include "IScriptHost.h"
 #include "quickjs.h"
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QString>
 #include <QJsonValue>
 #include <memory>
+#include <utility>
 
 class ScriptDatabaseBridge;
 
 /**
  * @brief Implementation of IScriptEngine using the QuickJS engine.
+ *
+ * Engines on one thread share that thread's JSRuntime, which is created on
+ * first use and lives until the thread ends, so constructing an engine per
+ * execution is cheap. Each execute() runs in a fresh JSContext with its own
+ * globals and modules, and the timers, handlers and database connection a
+ * script leaves behind are dropped when it returns, so executions stay as
+ * isolated as they were with a runtime each.
+ *
+ * Scripts are compiled once to bytecode, cached by a hash of the source and
+ * the QuickJS version, and later runs load the bytecode instead of parsing.
+ * The cache is shared by all threads and held in memory; setting
+ * CP_QUICKJS_BYTECODE_CACHE to "1" or a directory also keeps it on disk,
+ * trimmed least recently used first once it passes its byte budget.
+ *
+ * Pipeline data crosses into scripts with as few copies as possible. Strings
+ * are copied straight from UTF-16, and QByteArray values become Uint8Arrays
+ * over the engine's own copy of the bytes; passing such an array back out
+ * shares those bytes instead of copying them. pipeline.inputView() returns a
+ * read-only object over a large map or list that converts entries only when
+ * they are read, and hands back the original data when passed to
+ * pipeline.output(). pipeline.input() converts a pin's value on its first
+ * read and hands the same script value to later reads in that execution, so
+ * inputs a script never touches are never converted and hot loops reading
+ * the same pin pay for the conversion once.
+ *
+ * setLimits() budgets each execution. The time limit and the run's
+ * cancellation are checked from the runtime's interrupt handler, so a
+ * runaway loop is stopped where it runs; the memory limit caps what the
+ * script allocates on top of the shared runtime. While a script runs the GC
+ * threshold is raised, since its context is dropped whole when it returns,
+ * and the runtime is collected afterwards so the next script starts clean.
+ *
+ * With setProfiling(true) the same handler samples the script's stack about
+ * once a millisecond, weighting each stack by the time since the previous
+ * sample, and takeProfile() returns the result.
  */
 class QuickJSRuntime : public IScriptEngine {
 public:
@@ -42,27 +82,88 @@ public:
 
     bool execute(const QString& script, IScriptHost* host) override;
     QString getEngineId() const override { return QStringLiteral("quickjs"); }
+    void prewarm(const QString& script) override;
+    void setLimits(const ScriptLimits& limits) override { m_limits = limits; }
+    void setProfiling(bool enabled) override { m_profiling = enabled; }
+    ScriptProfile takeProfile() override { return std::exchange(m_profile, ScriptProfile()); }
+
+    /// The runtime shared by the engines on the calling thread.
+    static JSRuntime* threadRuntime();
+
+    /// Number of compiled scripts held in memory.
+    static qsizetype cachedScriptCount();
+
+    static constexpr qint64 kDefaultBytecodeCacheBytes = 256LL * 1024 * 1024;
+
+    /// Keeps bytecode under directory from now on, overriding CP_QUICKJS_BYTECODE_CACHE;
+    /// an empty directory keeps it in memory only.
+    static void setBytecodeCacheDirectory(const QString& directory, qint64 maxBytes = kDefaultBytecodeCacheBytes);
 
 private:
+    JSContext* newContext() const;
+    // Bytecode for the script, from the cache or compiled now; JS_EXCEPTION on a syntax error
+    JSValue compile(const QByteArray& source, bool isModule);
     void setupGlobalEnv(IScriptHost* host);
+    // Why the interrupt handler stopped the script, or an empty string
+    QString interruptionMessage() const;
+
+    static int js_interrupt(JSRuntime* rt, void* opaque);
+    // Charges the time since the last sample to the stack running now
+    void sampleStack();
+    // The running script's frames, outermost first and joined by ';'
+    QString currentStack() const;
 
     // Static C callbacks for QuickJS
     static JSValue js_console_log(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv);
     static JSValue js_console_error(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv);
     static JSValue js_pipeline_get_input(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv);
+    static JSValue js_pipeline_get_input_view(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv);
     static JSValue js_pipeline_set_output(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv);
     static JSValue js_pipeline_set_error(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv);
     static JSValue js_pipeline_get_temp_dir(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv);
     static JSValue js_sqlite_connect(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv);
     static JSValue js_sqlite_exec(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv);
+    static JSValue js_sqlite_exec_many(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv);
+    // begin(), commit() and rollback(), told apart by magic
+    enum TransactionCall { kTransactionBegin, kTransactionCommit, kTransactionRollback };
+    static JSValue js_sqlite_transaction(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv, int magic);
+
+    // Read-only objects over a QVariantMap or QVariantList, converting entries as they are read
+    static void registerViewClass(JSRuntime* rt);
+    static JSValue newView(JSContext* ctx, const QVariant& value);
+    static int js_view_get_own_property(JSContext* ctx, JSPropertyDescriptor* desc, JSValueConst obj, JSAtom prop);
+    static int js_view_get_own_property_names(JSContext* ctx, JSPropertyEnum** ptab, uint32_t* plen, JSValueConst obj);
+    static int js_view_delete_property(JSContext* ctx, JSValueConst obj, JSAtom prop);
+    static int js_view_define_own_property(JSContext* ctx, JSValueConst this_obj, JSAtom prop, JSValueConst val,
+                                           JSValueConst getter, JSValueConst setter, int flags);
+    static void js_view_finalizer(JSRuntime* rt, JSValueConst val);
 
     // Conversion helpers
     static QVariant jsToVariant(JSContext* ctx, JSValueConst val);
     static JSValue variantToJs(JSContext* ctx, const QVariant& var);
+    // variantToJs() for a map or list entry
+    static JSValue elementToJs(JSContext* ctx, const QVariant& var);
     static JSValue qJsonToJSValue(JSContext* ctx, const QJsonValue& value);
 
     JSRuntime* m_rt;
-    JSContext* m_ctx;
+    // Only set while execute() runs
+    JSContext* m_ctx = nullptr;
     IScriptHost* m_currentHost = nullptr;
+    // pipeline.input() results by key, released with the context
+    QHash<QString, JSValue> m_inputCache;
     std::unique_ptr<ScriptDatabaseBridge> m_dbBridge;
+
+    ScriptLimits m_limits;
+    // Only meaningful while execute() runs
+    QDeadlineTimer m_deadline;
+    CancellationToken m_cancellation;
+    enum class Interruption { None, Timeout, Cancelled };
+    Interruption m_interruption = Interruption::None;
+
+    bool m_profiling = false;
+    ScriptProfile m_profile;
+    // Only meaningful while a profiled execute() runs
+    bool m_profilingModule = false;
+    QElapsedTimer m_sampleClock;
+    QString m_lastStack;
 };
@@ -99,3 +99,69 @@ TEST(ScriptDatabaseBridgeTest, NotConnectedError) {
     ASSERT_TRUE(result.isObject());
     EXPECT_EQ(result.toObject()["error"].toString(), "Database not connected. Call db.connect(path) first.");
 }
+
+TEST(ScriptDatabaseBridgeTest, ExecManyAppliesAllRowsOrNone) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    ScriptDatabaseBridge bridge;
+    ASSERT_TRUE(bridge.connect(dir.path() + "/test_many.db"));
+    bridge.exec("CREATE TABLE items (name TEXT UNIQUE, qty INTEGER)");
+
+    QVariantList rows;
+    for (int i = 0; i < 500; ++i) {
+        rows.append(QVariant(QVariantList{QStringLiteral("item%1").arg(i), i}));
+    }
+    QJsonObject result = bridge.execMany("INSERT INTO items (name, qty) VALUES (?, ?)", rows).toObject();
+    EXPECT_FALSE(result.contains("error")) << result["error"].toString().toStdString();
+    EXPECT_EQ(result["rowsAffected"].toInt(), 500);
+    EXPECT_EQ(result["rows"].toInt(), 500);
+
+    // Named values, and a duplicate in the third row undoes the whole batch
+    QVariantList named = {
+        QVariantMap{{"name", "a"}, {"qty", 1}},
+        QVariantMap{{"name", "b"}, {"qty", 2}},
+        QVariantMap{{"name", "item3"}, {"qty", 3}},
+    };
+    result = bridge.execMany("INSERT INTO items (name, qty) VALUES (:name, :qty)", named).toObject();
+    EXPECT_TRUE(result.contains("error"));
+    EXPECT_EQ(result["row"].toInt(), 2);
+
+    QJsonValue count = bridge.exec("SELECT count(*) as count FROM items");
+    EXPECT_EQ(count.toArray()[0].toObject()["count"].toInt(), 500);
+}
+
+TEST(ScriptDatabaseBridgeTest, ExplicitTransactions) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString dbPath = dir.path() + "/test_transactions.db";
+    auto countItems = [&dbPath]() {
+        ScriptDatabaseBridge reader;
+        reader.connect(dbPath);
+        return reader.exec("SELECT count(*) as count FROM items").toArray()[0].toObject()["count"].toInt();
+    };
+
+    {
+        ScriptDatabaseBridge bridge;
+        ASSERT_TRUE(bridge.connect(dbPath));
+        bridge.exec("CREATE TABLE items (name TEXT)");
+
+        EXPECT_TRUE(bridge.begin().toBool());
+        EXPECT_TRUE(bridge.inTransaction());
+        EXPECT_TRUE(bridge.begin().toObject().contains("error"));
+        bridge.exec("INSERT INTO items (name) VALUES (?)", {QStringLiteral("rolled back")});
+        EXPECT_TRUE(bridge.rollback().toBool());
+        EXPECT_EQ(countItems(), 0);
+
+        EXPECT_TRUE(bridge.begin().toBool());
+        bridge.execMany("INSERT INTO items (name) VALUES (?)", {QVariantList{"x"}, QVariantList{"y"}});
+        EXPECT_TRUE(bridge.commit().toBool());
+        EXPECT_FALSE(bridge.inTransaction());
+        EXPECT_TRUE(bridge.commit().toObject().contains("error"));
+        EXPECT_EQ(countItems(), 2);
+
+        // Left open when the bridge goes away
+        EXPECT_TRUE(bridge.begin().toBool());
+        bridge.exec("INSERT INTO items (name) VALUES ('abandoned')");
+    }
+    EXPECT_EQ(countItems(), 2);
+}
@@ -1,5 +1,9 @@
 #include <gtest/gtest.h>
 #include <QApplication>
+#include <QDir>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QJsonArray>
 #include <QJsonObject>
@@ -294,3 +298,103 @@ TEST_F(ScriptNodeIntegrationTest, DescriptorReflectsConfiguredNamedPins)
     EXPECT_EQ(desc.inputPinOrder, QStringList({QStringLiteral("topic"), QStringLiteral("context")}));
     EXPECT_EQ(desc.outputPinOrder, QStringList({QStringLiteral("summary"), QStringLiteral("status")}));
 }
+
+TEST_F(ScriptNodeIntegrationTest, TimeLimitFailsRunawayScripts)
+{
+    UniversalScriptNode node;
+
+    QJsonObject state;
+    state.insert(QStringLiteral("scriptCode"), QStringLiteral("while (true) {}"));
+    state.insert(QStringLiteral("engineId"), QStringLiteral("quickjs"));
+    state.insert(QStringLiteral("timeoutMs"), 100);
+    node.loadState(state);
+    EXPECT_EQ(node.saveState().value(QStringLiteral("timeoutMs")).toInt(), 100);
+    EXPECT_EQ(node.memoryLimitMb(), UniversalScriptNode::kDefaultMemoryLimitMb);
+
+    TokenList outTokens = node.execute({});
+
+    ASSERT_EQ(outTokens.size(), 1);
+    EXPECT_EQ(outTokens.front().data.value(QStringLiteral("status")).toString(), QStringLiteral("FAIL"));
+    EXPECT_EQ(outTokens.front().data.value(QStringLiteral("__error")).toString(),
+              QStringLiteral("Script exceeded its time limit of 100 ms"));
+}
+
+TEST_F(ScriptNodeIntegrationTest, MapModeRunsTheScriptPerItemInOrder)
+{
+    UniversalScriptNode node;
+
+    QJsonObject state;
+    state.insert(QStringLiteral("scriptCode"),
+                 QStringLiteral("const n = pipeline.input(\"input\");\n"
+                                "if (n === 13) throw new Error(\"unlucky\");\n"
+                                "pipeline.output(\"output\", n * 2);\n"
+                                "pipeline.output(\"index\", pipeline.input(\"_index\"));"));
+    state.insert(QStringLiteral("engineId"), QStringLiteral("quickjs"));
+    state.insert(QStringLiteral("mapMode"), true);
+    node.loadState(state);
+    EXPECT_TRUE(node.saveState().value(QStringLiteral("mapMode")).toBool());
+
+    QVariantList items;
+    for (int i = 0; i < 1000; ++i) {
+        items << (i == 13 ? 14 : i);
+    }
+    ExecutionToken in;
+    in.data.insert(QStringLiteral("input"), items);
+
+    TokenList outTokens = node.execute(TokenList{in});
+
+    ASSERT_EQ(outTokens.size(), 1);
+    const DataPacket& out = outTokens.front().data;
+    const QVariantList doubled = out.value(QStringLiteral("output")).toList();
+    ASSERT_EQ(doubled.size(), 1000);
+    EXPECT_EQ(doubled.at(0).toInt(), 0);
+    EXPECT_EQ(doubled.at(13).toInt(), 28);
+    EXPECT_EQ(doubled.at(999).toInt(), 1998);
+    EXPECT_EQ(out.value(QStringLiteral("index")).toList().at(500).toInt(), 500);
+    EXPECT_EQ(out.value(QStringLiteral("status")).toString(), QStringLiteral("OK"));
+
+    // A failing item fails the node and leaves a gap in the lists
+    items[13] = 13;
+    in.data.insert(QStringLiteral("input"), items);
+    outTokens = node.execute(TokenList{in});
+    ASSERT_EQ(outTokens.size(), 1);
+    const DataPacket& failed = outTokens.front().data;
+    EXPECT_EQ(failed.value(QStringLiteral("status")).toString(), QStringLiteral("FAIL"));
+    EXPECT_TRUE(failed.value(QStringLiteral("__error")).toString().startsWith(QStringLiteral("1 of 1000 items failed. Item 13:")));
+    const QVariantList partial = failed.value(QStringLiteral("output")).toList();
+    ASSERT_EQ(partial.size(), 1000);
+    EXPECT_FALSE(partial.at(13).isValid());
+    EXPECT_EQ(partial.at(14).toInt(), 28);
+}
+
+TEST_F(ScriptNodeIntegrationTest, ProfiledRunsWriteFoldedStacksToTheOutputDir)
+{
+    UniversalScriptNode node;
+
+    QJsonObject state;
+    state.insert(QStringLiteral("scriptCode"),
+                 QStringLiteral("function spin() { const end = Date.now() + 50; while (Date.now() < end) {} }\n"
+                                "spin();\n"
+                                "pipeline.output(\"output\", \"done\");"));
+    state.insert(QStringLiteral("engineId"), QStringLiteral("quickjs"));
+    state.insert(QStringLiteral("profiling"), true);
+    node.loadState(state);
+    EXPECT_TRUE(node.saveState().value(QStringLiteral("profiling")).toBool());
+
+    QTemporaryDir outputDir;
+    ASSERT_TRUE(outputDir.isValid());
+    ExecutionToken in;
+    in.data.insert(QStringLiteral("_sys_node_output_dir"), outputDir.filePath(QStringLiteral("node")));
+
+    QSignalSpy summaries(&node, &UniversalScriptNode::profileSummaryChanged);
+    const TokenList outTokens = node.execute(TokenList{in});
+
+    ASSERT_EQ(outTokens.size(), 1);
+    EXPECT_EQ(outTokens.front().data.value(QStringLiteral("status")).toString(), QStringLiteral("OK"));
+    QFile folded(QDir(outputDir.filePath(QStringLiteral("node")))
+                     .filePath(QString::fromLatin1(UniversalScriptNode::kProfileFileName)));
+    ASSERT_TRUE(folded.open(QIODevice::ReadOnly));
+    EXPECT_TRUE(QString::fromUtf8(folded.readAll()).contains(QStringLiteral("(script);spin (line 1) ")));
+    ASSERT_EQ(summaries.count(), 1);
+    EXPECT_TRUE(summaries.front().front().toString().startsWith(QStringLiteral("Profiled ")));
+}
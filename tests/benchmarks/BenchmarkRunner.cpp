@@ -0,0 +1,127 @@
+//
+// Cognitive Pipeline Application - shared benchmark harness
+//
+
+#include "BenchmarkRunner.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QHostInfo>
+#include <QThread>
+
+#include <cstdio>
+
+std::atomic<double> g_sink {0.0};
+
+QList<int> parseIntList(const QString& value)
+{
+    QList<int> list;
+    for (const QString& item : value.split(u',', Qt::SkipEmptyParts)) {
+        list.append(item.trimmed().toInt());
+    }
+    return list;
+}
+
+void capList(QList<int>& list, int limit)
+{
+    list.removeIf([limit](int value) { return value > limit; });
+}
+
+void printUsage(const BenchmarkUsage& usage, const BenchmarkOptions& defaults)
+{
+    std::printf(
+        "Usage: %s [options]\n"
+        "  --benchmark_filter=REGEX  run benchmarks whose name matches (e.g. '%s')\n"
+        "  --benchmark_out=FILE      write results as JSON to FILE\n"
+        "  --benchmark_min_time=S    seconds each benchmark runs for at least (default %g)\n"
+        "  --quick                   %s\n"
+        "%s",
+        usage.program, usage.filterExample, defaults.minSeconds, usage.quick, usage.flags);
+}
+
+int parseArguments(const QStringList& arguments, BenchmarkOptions& options, const BenchmarkUsage& usage,
+                   const BenchmarkFlagParser& parseFlag)
+{
+    const BenchmarkOptions defaults = options;
+    for (const QString& argument : arguments) {
+        const qsizetype equals = argument.indexOf(u'=');
+        const QString key = argument.left(equals);
+        const QString value = equals >= 0 ? argument.mid(equals + 1) : QString();
+        if (key == QLatin1String("--benchmark_filter")) {
+            options.filter = QRegularExpression(value);
+        } else if (key == QLatin1String("--benchmark_out")) {
+            options.outputPath = value;
+        } else if (key == QLatin1String("--benchmark_min_time")) {
+            options.minSeconds = value.toDouble();
+        } else if (key == QLatin1String("--quick")) {
+            options.quick = true;
+        } else if (!parseFlag || !parseFlag(key, value)) {
+            printUsage(usage, defaults);
+            return key == QLatin1String("--help") ? 0 : 1;
+        }
+    }
+    if (!options.filter.isValid()) {
+        std::fprintf(stderr, "Invalid --benchmark_filter: %s\n", qPrintable(options.filter.errorString()));
+        return 1;
+    }
+    return -1;
+}
+
+void BenchmarkRunner::report(const QString& name, qint64 iterations, double realNs, double cpuNs,
+                             const QJsonObject& counters)
+{
+    QJsonObject entry;
+    entry.insert(QStringLiteral("name"), name);
+    entry.insert(QStringLiteral("run_name"), name);
+    entry.insert(QStringLiteral("run_type"), QStringLiteral("iteration"));
+    entry.insert(QStringLiteral("iterations"), iterations);
+    entry.insert(QStringLiteral("real_time"), realNs);
+    entry.insert(QStringLiteral("cpu_time"), cpuNs);
+    entry.insert(QStringLiteral("time_unit"), QStringLiteral("ns"));
+    QString line = QStringLiteral("%1 %2 ns %3 it").arg(name, -56).arg(realNs, 14, 'f', 0).arg(iterations, 8);
+    for (auto it = counters.constBegin(); it != counters.constEnd(); ++it) {
+        entry.insert(it.key(), it.value());
+        line += QStringLiteral("  %1=%2").arg(it.key()).arg(it.value().toDouble(), 0, 'g', 4);
+    }
+    m_results.append(entry);
+    std::printf("%s\n", qPrintable(line));
+    std::fflush(stdout);
+}
+
+QJsonDocument BenchmarkRunner::document() const
+{
+    QJsonObject context;
+    context.insert(QStringLiteral("date"), QDateTime::currentDateTime().toString(Qt::ISODate));
+    context.insert(QStringLiteral("host_name"), QHostInfo::localHostName());
+    context.insert(QStringLiteral("executable"), QCoreApplication::applicationFilePath());
+    context.insert(QStringLiteral("num_cpus"), QThread::idealThreadCount());
+    context.insert(QStringLiteral("qt_version"), QString::fromLatin1(qVersion()));
+#ifdef NDEBUG
+    context.insert(QStringLiteral("library_build_type"), QStringLiteral("release"));
+#else
+    context.insert(QStringLiteral("library_build_type"), QStringLiteral("debug"));
+#endif
+    context.insert(QStringLiteral("quick"), m_baseOptions.quick);
+    for (auto it = m_context.constBegin(); it != m_context.constEnd(); ++it) {
+        context.insert(it.key(), it.value());
+    }
+    QJsonObject root;
+    root.insert(QStringLiteral("context"), context);
+    root.insert(QStringLiteral("benchmarks"), m_results);
+    return QJsonDocument(root);
+}
+
+int BenchmarkRunner::finish() const
+{
+    if (m_baseOptions.outputPath.isEmpty()) {
+        return 0;
+    }
+    QFile out(m_baseOptions.outputPath);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        std::fprintf(stderr, "Cannot write %s\n", qPrintable(m_baseOptions.outputPath));
+        return 1;
+    }
+    out.write(document().toJson());
+    return 0;
+}
@@ -0,0 +1,152 @@
+//
+// Cognitive Pipeline Application - shared benchmark harness
+//
+// The options, timing loop, reporting and command line every benchmark binary
+// shares. Results are printed as they come and written as Google Benchmark
+// style JSON, so runs can be compared across releases.
+//
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QList>
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+
+#include <atomic>
+#include <ctime>
+#include <functional>
+
+// Keeps results of timed work observable so it is not optimised away
+extern std::atomic<double> g_sink;
+
+// Flags every binary takes; each extends it with its own
+struct BenchmarkOptions {
+    QRegularExpression filter {QStringLiteral(".*")};
+    QString outputPath;
+    double minSeconds {0.5};
+    bool quick {false};
+};
+
+// What --help prints besides the shared flags
+struct BenchmarkUsage {
+    const char* program;
+    // A filter worth trying, e.g. "^scan/kernel"
+    const char* filterExample;
+    // What --quick leaves out
+    const char* quick;
+    // The binary's own flags, one "  --flag=X  help\n" line each
+    const char* flags;
+};
+
+// Handles one of the binary's own flags; false when the key is not one of them
+using BenchmarkFlagParser = std::function<bool(const QString& key, const QString& value)>;
+
+QList<int> parseIntList(const QString& value);
+
+// Drops the entries above limit, for --quick
+void capList(QList<int>& list, int limit);
+
+void printUsage(const BenchmarkUsage& usage, const BenchmarkOptions& defaults);
+
+// Reads the shared flags into options and hands the rest to parseFlag. Returns the
+// exit code when the binary should stop (--help, an unknown flag or a bad filter),
+// or -1 to run.
+int parseArguments(const QStringList& arguments, BenchmarkOptions& options, const BenchmarkUsage& usage,
+                   const BenchmarkFlagParser& parseFlag);
+
+// Collects results and prints them as they come
+class BenchmarkRunner
+{
+public:
+    explicit BenchmarkRunner(const BenchmarkOptions& options)
+        : m_baseOptions(options)
+    {
+    }
+
+    bool selected(const QString& name) const { return m_baseOptions.filter.match(name).hasMatch(); }
+
+    // Calls fn until minSeconds have passed and returns the wall and process CPU ns per call
+    template <typename Fn>
+    void measure(Fn&& fn, qint64& iterations, double& realNs, double& cpuNs) const
+    {
+        iterations = 0;
+        QElapsedTimer timer;
+        const std::clock_t cpuStart = std::clock();
+        timer.start();
+        do {
+            fn();
+            ++iterations;
+        } while (timer.nsecsElapsed() < static_cast<qint64>(m_baseOptions.minSeconds * 1e9));
+        const double elapsed = static_cast<double>(timer.nsecsElapsed());
+        const double cpu = static_cast<double>(std::clock() - cpuStart) * 1e9 / CLOCKS_PER_SEC;
+        realNs = elapsed / static_cast<double>(iterations);
+        cpuNs = cpu / static_cast<double>(iterations);
+    }
+
+    // Measures fn under name when the filter selects it
+    template <typename Fn>
+    void run(const QString& name, Fn&& fn, const QJsonObject& counters = QJsonObject())
+    {
+        if (!selected(name)) {
+            return;
+        }
+        qint64 iterations = 0;
+        double realNs = 0.0;
+        double cpuNs = 0.0;
+        measure(fn, iterations, realNs, cpuNs);
+        report(name, iterations, realNs, cpuNs, counters);
+    }
+
+    // run() with a bytes_per_second counter for @p bytes moved per call
+    template <typename Fn>
+    void runThroughput(const QString& name, qint64 bytes, Fn&& fn)
+    {
+        if (!selected(name)) {
+            return;
+        }
+        qint64 iterations = 0;
+        double realNs = 0.0;
+        double cpuNs = 0.0;
+        measure(fn, iterations, realNs, cpuNs);
+        report(name, iterations, realNs, cpuNs,
+               QJsonObject{{QStringLiteral("bytes_per_second"), static_cast<double>(bytes) * 1e9 / realNs}});
+    }
+
+    void report(const QString& name, qint64 iterations, double realNs, double cpuNs,
+                const QJsonObject& counters = QJsonObject());
+
+    // Adds a key to the document's context, next to the host, CPU and build details
+    void setContext(const QString& key, const QJsonValue& value) { m_context.insert(key, value); }
+
+    QJsonDocument document() const;
+
+    // Writes document() to --benchmark_out, if given; returns main()'s exit code
+    int finish() const;
+
+private:
+    const BenchmarkOptions& m_baseOptions;
+    QJsonObject m_context;
+    QJsonArray m_results;
+};
+
+// A runner whose options() are the binary's own
+template <typename Options>
+class BenchmarkRunnerFor : public BenchmarkRunner
+{
+public:
+    explicit BenchmarkRunnerFor(const Options& options)
+        : BenchmarkRunner(options)
+        , m_options(options)
+    {
+    }
+
+    const Options& options() const { return m_options; }
+
+private:
+    const Options& m_options;
+};
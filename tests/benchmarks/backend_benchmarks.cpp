@@ -0,0 +1,690 @@
+//
+// Cognitive Pipeline Application - LLM backend throughput benchmarks
+//
+// Starts a local HTTP server that speaks the OpenAI, Anthropic, Google and
+// Ollama wire formats, points each backend at it through its base URL, and
+// drives sendPrompt(), streamPrompt() and getEmbedding() from a growing number
+// of threads. The server answers after a fixed latency, so what a call takes
+// beyond that (and beyond the server's own handling time) is overhead on our
+// side: building and serialising the request, the rate and concurrency
+// limiters, libcurl and parsing the answer. It also reports requests per
+// second, how many requests each TCP connection carried, the cost of large
+// attachments, and throughput when the server answers some requests with 429.
+// Results are written as Google Benchmark style JSON like the other
+// benchmarks. Run with --help for the options.
+//
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "BenchmarkRunner.h"
+#include "ai/backends/AnthropicBackend.h"
+#include "ai/backends/GoogleBackend.h"
+#include "ai/backends/ILLMBackend.h"
+#include "ai/backends/OllamaBackend.h"
+#include "ai/backends/OpenAIBackend.h"
+
+namespace {
+
+struct Options : BenchmarkOptions {
+    // Concurrent loads need longer to settle than single calls
+    Options() { minSeconds = 1.0; }
+
+    double warmupSeconds {0.25};
+    int latencyMs {20};
+    QList<int> concurrency {1, 4, 16, 64};
+    QList<int> attachmentBytes {64 * 1024, 1024 * 1024, 8 * 1024 * 1024};
+    int rateLimitEvery {5};
+    int streamChunks {16};
+    int embeddingDimensions {768};
+};
+
+// ---- Mock provider server ------------------------------------------------
+
+// Counters the server keeps; benchmarks report the difference over their run
+struct ServerStats {
+    qint64 connections {0};
+    qint64 requests {0};
+    qint64 rateLimited {0};
+    qint64 handlingNs {0};
+    qint64 requestBytes {0};
+};
+
+// HTTP/1.1 with keep-alive on its own thread. Each request is answered after the
+// configured latency, or with a 429 when it is the rate-limit stride's turn.
+class MockProviderServer
+{
+public:
+    MockProviderServer(int latencyMs, int streamChunks, int embeddingDimensions)
+        : m_latencyMs(latencyMs)
+        , m_streamChunks(qMax(1, streamChunks))
+    {
+        QByteArray values;
+        for (int i = 0; i < embeddingDimensions; ++i) {
+            if (i > 0) values += ',';
+            values += QByteArray::number(1.0 / (i + 1), 'g', 6);
+        }
+        m_vector = '[' + values + ']';
+    }
+
+    ~MockProviderServer()
+    {
+        if (m_thread) {
+            m_thread->quit();
+            m_thread->wait();
+        }
+    }
+
+    // False when no local port could be bound
+    bool start()
+    {
+        m_thread = std::make_unique<QThread>();
+        auto* server = new QTcpServer();
+        server->moveToThread(m_thread.get());
+        QObject::connect(m_thread.get(), &QThread::finished, server, &QObject::deleteLater);
+        QObject::connect(server, &QTcpServer::newConnection, server, [this, server]() {
+            while (QTcpSocket* socket = server->nextPendingConnection()) {
+                m_connections.fetch_add(1);
+                accept(socket);
+            }
+        });
+        m_thread->start();
+        QMetaObject::invokeMethod(
+            server,
+            [this, server]() {
+                if (server->listen(QHostAddress::LocalHost, 0)) {
+                    m_port = server->serverPort();
+                }
+            },
+            Qt::BlockingQueuedConnection);
+        return m_port != 0;
+    }
+
+    QString baseUrl() const { return QStringLiteral("http://127.0.0.1:%1").arg(m_port); }
+
+    // Every Nth request gets a 429; 0 turns it off
+    void setRateLimitEvery(int every) { m_rateLimitEvery.store(every); }
+
+    ServerStats stats() const
+    {
+        ServerStats stats;
+        stats.connections = m_connections.load();
+        stats.requests = m_requests.load();
+        stats.rateLimited = m_rateLimited.load();
+        stats.handlingNs = m_handlingNs.load();
+        stats.requestBytes = m_requestBytes.load();
+        return stats;
+    }
+
+private:
+    struct Request {
+        QByteArray method;
+        QByteArray path;
+        QByteArray body;
+    };
+
+    struct Response {
+        int status {200};
+        QByteArray contentType {"application/json"};
+        QByteArray body;
+        // Streamed responses go out chunked, one event per chunk
+        QList<QByteArray> events;
+        bool streamed {false};
+    };
+
+    void accept(QTcpSocket* socket)
+    {
+        auto buffer = std::make_shared<QByteArray>();
+        auto continued = std::make_shared<bool>(false);
+        QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        QObject::connect(socket, &QTcpSocket::readyRead, socket, [this, socket, buffer, continued]() {
+            buffer->append(socket->readAll());
+            for (;;) {
+                const qsizetype headerEnd = buffer->indexOf("\r\n\r\n");
+                if (headerEnd < 0) {
+                    return;
+                }
+                const QList<QByteArray> lines = buffer->left(headerEnd).split('\n');
+                const QList<QByteArray> requestLine = lines.value(0).trimmed().split(' ');
+                qsizetype contentLength = 0;
+                bool expectsContinue = false;
+                for (qsizetype i = 1; i < lines.size(); ++i) {
+                    const qsizetype colon = lines[i].indexOf(':');
+                    if (colon < 0) continue;
+                    const QByteArray name = lines[i].left(colon).trimmed().toLower();
+                    const QByteArray value = lines[i].mid(colon + 1).trimmed();
+                    if (name == "content-length") contentLength = value.toLongLong();
+                    if (name == "expect" && value.toLower() == "100-continue") expectsContinue = true;
+                }
+                // libcurl waits for this before sending a large body
+                if (expectsContinue && !*continued && buffer->size() < headerEnd + 4 + contentLength) {
+                    socket->write("HTTP/1.1 100 Continue\r\n\r\n");
+                    *continued = true;
+                }
+                if (buffer->size() < headerEnd + 4 + contentLength) {
+                    return;
+                }
+                Request request;
+                request.method = requestLine.value(0);
+                request.path = requestLine.value(1);
+                request.body = buffer->mid(headerEnd + 4, contentLength);
+                buffer->remove(0, headerEnd + 4 + contentLength);
+                *continued = false;
+                serve(socket, request);
+            }
+        });
+    }
+
+    void serve(QTcpSocket* socket, const Request& request)
+    {
+        QElapsedTimer handling;
+        handling.start();
+        const qint64 sequence = m_requests.fetch_add(1) + 1;
+        m_requestBytes.fetch_add(request.body.size());
+
+        Response response;
+        const int every = m_rateLimitEvery.load();
+        if (request.method == "POST" && every > 0 && sequence % every == 0) {
+            m_rateLimited.fetch_add(1);
+            response.status = 429;
+            response.body = R"({"error":{"type":"rate_limit_error","message":"Rate limited by the mock server"}})";
+        } else {
+            response = route(request);
+        }
+        const QByteArray bytes = encode(response);
+        m_handlingNs.fetch_add(handling.nsecsElapsed());
+
+        QPointer<QTcpSocket> target(socket);
+        QTimer::singleShot(m_latencyMs, socket, [target, bytes]() {
+            if (target) target->write(bytes);
+        });
+    }
+
+    QByteArray encode(const Response& response) const
+    {
+        QByteArray out = "HTTP/1.1 " + QByteArray::number(response.status)
+            + (response.status == 200 ? " OK" : response.status == 429 ? " Too Many Requests" : " Not Found")
+            + "\r\nContent-Type: " + response.contentType + "\r\nConnection: keep-alive\r\n";
+        if (response.status == 429) {
+            out += "Retry-After: 0\r\n";
+        }
+        if (!response.streamed) {
+            out += "Content-Length: " + QByteArray::number(response.body.size()) + "\r\n\r\n" + response.body;
+            return out;
+        }
+        out += "Transfer-Encoding: chunked\r\n\r\n";
+        for (const QByteArray& event : response.events) {
+            out += QByteArray::number(event.size(), 16) + "\r\n" + event + "\r\n";
+        }
+        out += "0\r\n\r\n";
+        return out;
+    }
+
+    static bool wantsStream(const QByteArray& body)
+    {
+        return body.contains("\"stream\":true") || body.contains("\"stream\": true");
+    }
+
+    // Number of texts in an embedding request's input (a string or an array)
+    static int inputCount(const QByteArray& body, const QString& field)
+    {
+        const QJsonValue input = QJsonDocument::fromJson(body).object().value(field);
+        return input.isArray() ? qMax(1, static_cast<int>(input.toArray().size())) : 1;
+    }
+
+    QList<QByteArray> answerWords() const
+    {
+        QList<QByteArray> words;
+        for (int i = 0; i < m_streamChunks; ++i) {
+            words.append("word" + QByteArray::number(i) + ' ');
+        }
+        return words;
+    }
+
+    QByteArray answer() const { return answerWords().join(); }
+
+    QByteArray vectors(int count, const QByteArray& prefix, const QByteArray& suffix) const
+    {
+        QByteArray out;
+        for (int i = 0; i < count; ++i) {
+            if (i > 0) out += ',';
+            out += prefix + m_vector + suffix;
+        }
+        return out;
+    }
+
+    Response route(const Request& request) const
+    {
+        Response response;
+        const QByteArray& path = request.path;
+        const QByteArray usageOpenAI = R"({"prompt_tokens":12,"completion_tokens":)" + QByteArray::number(m_streamChunks)
+            + R"(,"total_tokens":)" + QByteArray::number(12 + m_streamChunks) + "}";
+
+        if (path.startsWith("/v1/chat/completions")) {
+            if (wantsStream(request.body)) {
+                response.streamed = true;
+                response.contentType = "text/event-stream";
+                for (const QByteArray& word : answerWords()) {
+                    response.events.append(R"(data: {"choices":[{"index":0,"delta":{"content":")" + word
+                                           + "\"}}]}\n\n");
+                }
+                response.events.append(R"(data: {"choices":[{"index":0,"delta":{},"finish_reason":"stop"}]})" "\n\n");
+                response.events.append(R"(data: {"choices":[],"usage":)" + usageOpenAI + "}\n\n");
+                response.events.append("data: [DONE]\n\n");
+            } else {
+                response.body = R"({"id":"chatcmpl-bench","object":"chat.completion","choices":[{"index":0,"message":{"role":"assistant","content":")"
+                    + answer() + R"("},"finish_reason":"stop"}],"usage":)" + usageOpenAI + "}";
+            }
+        } else if (path.startsWith("/v1/embeddings")) {
+            const int count = inputCount(request.body, QStringLiteral("input"));
+            QByteArray data;
+            for (int i = 0; i < count; ++i) {
+                if (i > 0) data += ',';
+                data += R"({"object":"embedding","index":)" + QByteArray::number(i) + R"(,"embedding":)" + m_vector + "}";
+            }
+            response.body = R"({"object":"list","data":[)" + data + R"(],"usage":{"prompt_tokens":8,"total_tokens":8}})";
+        } else if (path.startsWith("/v1/messages")) {
+            if (wantsStream(request.body)) {
+                response.streamed = true;
+                response.contentType = "text/event-stream";
+                response.events.append("event: message_start\n"
+                                       R"(data: {"type":"message_start","message":{"id":"msg_bench","usage":{"input_tokens":12,"output_tokens":1}}})"
+                                       "\n\n");
+                for (const QByteArray& word : answerWords()) {
+                    response.events.append("event: content_block_delta\n"
+                                           R"(data: {"type":"content_block_delta","index":0,"delta":{"type":"text_delta","text":")"
+                                           + word + "\"}}\n\n");
+                }
+                response.events.append("event: message_delta\n"
+                                       R"(data: {"type":"message_delta","delta":{"stop_reason":"end_turn"},"usage":{"output_tokens":)"
+                                       + QByteArray::number(m_streamChunks) + "}}\n\n");
+                response.events.append("event: message_stop\n" R"(data: {"type":"message_stop"})" "\n\n");
+            } else {
+                response.body = R"({"id":"msg_bench","type":"message","role":"assistant","content":[{"type":"text","text":")"
+                    + answer() + R"("}],"stop_reason":"end_turn","usage":{"input_tokens":12,"output_tokens":)"
+                    + QByteArray::number(m_streamChunks) + "}}";
+            }
+        } else if (path.contains(":streamGenerateContent")) {
+            response.streamed = true;
+            response.contentType = "text/event-stream";
+            const QList<QByteArray> words = answerWords();
+            for (qsizetype i = 0; i < words.size(); ++i) {
+                QByteArray event = R"(data: {"candidates":[{"content":{"parts":[{"text":")" + words[i]
+                    + R"("}],"role":"model"})";
+                if (i + 1 == words.size()) {
+                    event += R"(,"finishReason":"STOP"}],"usageMetadata":{"promptTokenCount":12,"candidatesTokenCount":)"
+                        + QByteArray::number(m_streamChunks) + R"(,"totalTokenCount":)"
+                        + QByteArray::number(12 + m_streamChunks) + "}}\n\n";
+                } else {
+                    event += "}]}\n\n";
+                }
+                response.events.append(event);
+            }
+        } else if (path.contains(":generateContent")) {
+            response.body = R"({"candidates":[{"content":{"parts":[{"text":")" + answer()
+                + R"("}],"role":"model"},"finishReason":"STOP"}],"usageMetadata":{"promptTokenCount":12,"candidatesTokenCount":)"
+                + QByteArray::number(m_streamChunks) + R"(,"totalTokenCount":)" + QByteArray::number(12 + m_streamChunks) + "}}";
+        } else if (path.contains(":batchEmbedContents")) {
+            const int count = inputCount(request.body, QStringLiteral("requests"));
+            response.body = R"({"embeddings":[)" + vectors(count, R"({"values":)", "}") + "]}";
+        } else if (path.contains(":embedContent")) {
+            response.body = R"({"embedding":{"values":)" + m_vector + "}}";
+        } else if (path.startsWith("/api/chat")) {
+            const QByteArray done = R"({"model":"mock","message":{"role":"assistant","content":")";
+            const QByteArray usage = R"(,"prompt_eval_count":12,"eval_count":)" + QByteArray::number(m_streamChunks) + "}";
+            if (wantsStream(request.body)) {
+                response.streamed = true;
+                response.contentType = "application/x-ndjson";
+                for (const QByteArray& word : answerWords()) {
+                    response.events.append(done + word + R"("},"done":false})" "\n");
+                }
+                response.events.append(done + R"("},"done":true,"done_reason":"stop")" + usage + "\n");
+            } else {
+                response.body = done + answer() + R"("},"done":true,"done_reason":"stop")" + usage;
+            }
+        } else if (path.startsWith("/api/embed")) {
+            const bool legacy = path.startsWith("/api/embeddings");
+            response.body = legacy ? R"({"embedding":)" + m_vector + "}"
+                                   : R"({"model":"mock","embeddings":[)"
+                                         + vectors(inputCount(request.body, QStringLiteral("input")), QByteArray(), QByteArray())
+                                         + R"(],"prompt_eval_count":8})";
+        } else if (path.startsWith("/api/generate")) {
+            response.body = R"({"model":"mock","response":"","done":true})";
+        } else if (request.method == "HEAD" || request.method == "GET") {
+            response.body = "{}";
+        } else {
+            response.status = 404;
+            response.body = R"({"error":{"message":"Unknown mock path"}})";
+        }
+        return response;
+    }
+
+    const int m_latencyMs;
+    const int m_streamChunks;
+    QByteArray m_vector;
+    std::unique_ptr<QThread> m_thread;
+    quint16 m_port {0};
+    std::atomic<int> m_rateLimitEvery {0};
+    std::atomic<qint64> m_connections {0};
+    std::atomic<qint64> m_requests {0};
+    std::atomic<qint64> m_rateLimited {0};
+    std::atomic<qint64> m_handlingNs {0};
+    std::atomic<qint64> m_requestBytes {0};
+};
+
+// ---- Runner --------------------------------------------------------------
+
+// What a batch of concurrent calls measured, with the server's side of it
+struct LoadResult {
+    qint64 calls {0};
+    qint64 failures {0};
+    double elapsedNs {0.0};
+    double cpuNs {0.0};
+    std::vector<qint64> latenciesNs;
+    ServerStats server;
+};
+
+// Collects results and prints them as they come
+class Runner : public BenchmarkRunnerFor<Options>
+{
+public:
+    Runner(const Options& options, MockProviderServer& server)
+        : BenchmarkRunnerFor<Options>(options)
+        , m_server(server)
+    {
+    }
+
+    // Calls fn from @p threads threads until @p seconds have passed; fn returns false on failure
+    LoadResult load(int threads, double seconds, const std::function<bool(int thread, qint64 call)>& fn) const
+    {
+        const ServerStats before = m_server.stats();
+        std::vector<std::vector<qint64>> latencies(static_cast<size_t>(threads));
+        std::atomic<qint64> failures {0};
+        QElapsedTimer timer;
+        const std::clock_t cpuStart = std::clock();
+        timer.start();
+        const qint64 deadlineNs = static_cast<qint64>(seconds * 1e9);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t]() {
+                QElapsedTimer call;
+                for (qint64 i = 0; timer.nsecsElapsed() < deadlineNs; ++i) {
+                    call.start();
+                    if (!fn(t, i)) failures.fetch_add(1);
+                    latencies[static_cast<size_t>(t)].push_back(call.nsecsElapsed());
+                }
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        LoadResult result;
+        result.elapsedNs = static_cast<double>(timer.nsecsElapsed());
+        result.cpuNs = static_cast<double>(std::clock() - cpuStart) * 1e9 / CLOCKS_PER_SEC;
+        result.failures = failures.load();
+        for (const auto& perThread : latencies) {
+            result.latenciesNs.insert(result.latenciesNs.end(), perThread.begin(), perThread.end());
+        }
+        result.calls = static_cast<qint64>(result.latenciesNs.size());
+        const ServerStats after = m_server.stats();
+        result.server.connections = after.connections - before.connections;
+        result.server.requests = after.requests - before.requests;
+        result.server.rateLimited = after.rateLimited - before.rateLimited;
+        result.server.handlingNs = after.handlingNs - before.handlingNs;
+        result.server.requestBytes = after.requestBytes - before.requestBytes;
+        return result;
+    }
+
+    // A warm-up load, so the connection pool and the adaptive concurrency limit settle,
+    // then the measured one
+    void run(const QString& name, int threads, const std::function<bool(int, qint64)>& fn,
+             QJsonObject counters = QJsonObject())
+    {
+        if (!selected(name)) {
+            return;
+        }
+        if (options().warmupSeconds > 0) {
+            load(threads, options().warmupSeconds, fn);
+        }
+        LoadResult result = load(threads, options().minSeconds, fn);
+        if (result.calls == 0) {
+            return;
+        }
+        std::sort(result.latenciesNs.begin(), result.latenciesNs.end());
+        const auto percentile = [&](double p) {
+            const size_t index = qMin(result.latenciesNs.size() - 1,
+                                      static_cast<size_t>(p * static_cast<double>(result.latenciesNs.size())));
+            return static_cast<double>(result.latenciesNs[index]);
+        };
+        double totalNs = 0.0;
+        for (const qint64 ns : result.latenciesNs) totalNs += static_cast<double>(ns);
+        const double meanNs = totalNs / static_cast<double>(result.calls);
+        const qint64 requests = qMax<qint64>(1, result.server.requests);
+        const double serverNs = static_cast<double>(result.server.handlingNs) / static_cast<double>(requests);
+        // Each attempt waits out the server latency; retries after a 429 add theirs
+        const double attemptsPerCall = static_cast<double>(requests) / static_cast<double>(result.calls);
+        const double serverSideNs = attemptsPerCall * (options().latencyMs * 1e6 + serverNs);
+
+        counters.insert(QStringLiteral("requests_per_second"),
+                        static_cast<double>(result.calls) * 1e9 / result.elapsedNs);
+        counters.insert(QStringLiteral("p50_us"), percentile(0.50) / 1e3);
+        counters.insert(QStringLiteral("p95_us"), percentile(0.95) / 1e3);
+        counters.insert(QStringLiteral("overhead_us"), (meanNs - serverSideNs) / 1e3);
+        counters.insert(QStringLiteral("server_us"), serverNs / 1e3);
+        counters.insert(QStringLiteral("http_requests_per_call"), attemptsPerCall);
+        counters.insert(QStringLiteral("requests_per_connection"),
+                        static_cast<double>(requests) / static_cast<double>(qMax<qint64>(1, result.server.connections)));
+        counters.insert(QStringLiteral("new_connections"), static_cast<double>(result.server.connections));
+        counters.insert(QStringLiteral("request_bytes"),
+                        static_cast<double>(result.server.requestBytes) / static_cast<double>(requests));
+        if (result.server.rateLimited > 0) {
+            counters.insert(QStringLiteral("rate_limited"), static_cast<double>(result.server.rateLimited));
+        }
+        if (result.failures > 0) {
+            counters.insert(QStringLiteral("failures"), static_cast<double>(result.failures));
+        }
+        report(name, result.calls, meanNs, result.cpuNs / static_cast<double>(result.calls), counters);
+    }
+
+    MockProviderServer& server() { return m_server; }
+
+private:
+    MockProviderServer& m_server;
+};
+
+// ---- Backends ------------------------------------------------------------
+
+struct BackendCase {
+    QString provider;
+    std::shared_ptr<ILLMBackend> backend;
+    QString chatModel;
+    // Empty for providers without embeddings
+    QString embeddingModel;
+};
+
+QList<BackendCase> backendCases()
+{
+    return {
+        {QStringLiteral("openai"), std::make_shared<OpenAIBackend>(), QStringLiteral("gpt-4o-mini"),
+         QStringLiteral("text-embedding-3-small")},
+        {QStringLiteral("anthropic"), std::make_shared<AnthropicBackend>(), QStringLiteral("claude-3-5-haiku-latest"),
+         QString()},
+        {QStringLiteral("google"), std::make_shared<GoogleBackend>(), QStringLiteral("gemini-2.0-flash"),
+         QStringLiteral("text-embedding-004")},
+        {QStringLiteral("ollama"), std::make_shared<OllamaBackend>(), QStringLiteral("mock"),
+         QStringLiteral("nomic-embed-text")},
+    };
+}
+
+const QString kApiKey = QStringLiteral("bench-key");
+
+// A distinct prompt per call, so nothing is shared between in-flight requests
+QString promptFor(int thread, qint64 call)
+{
+    return QStringLiteral("Benchmark prompt from thread %1, call %2.").arg(thread).arg(call);
+}
+
+bool prompt(ILLMBackend& backend, const QString& model, int thread, qint64 call, const LLMMessage& message = {})
+{
+    const LLMResult result = backend.sendPrompt(kApiKey, model, 0.7, 256, QStringLiteral("You are a benchmark."),
+                                                promptFor(thread, call), message);
+    g_sink = g_sink + result.content.size();
+    return !result.hasError;
+}
+
+void benchmarkPrompts(Runner& runner, const BackendCase& backend)
+{
+    for (const int threads : runner.options().concurrency) {
+        runner.run(QStringLiteral("%1/prompt/c%2").arg(backend.provider).arg(threads), threads,
+                   [&](int thread, qint64 call) { return prompt(*backend.backend, backend.chatModel, thread, call); });
+
+        runner.run(QStringLiteral("%1/stream/c%2").arg(backend.provider).arg(threads), threads,
+                   [&](int thread, qint64 call) {
+                       int deltas = 0;
+                       const LLMResult result = backend.backend->streamPrompt(
+                           kApiKey, backend.chatModel, 0.7, 256, QStringLiteral("You are a benchmark."),
+                           promptFor(thread, call), [&deltas](const QString&) { ++deltas; });
+                       g_sink = g_sink + deltas;
+                       return !result.hasError && deltas > 1;
+                   });
+    }
+}
+
+void benchmarkRateLimited(Runner& runner, const BackendCase& backend)
+{
+    if (runner.options().rateLimitEvery <= 0) {
+        return;
+    }
+    runner.server().setRateLimitEvery(runner.options().rateLimitEvery);
+    for (const int threads : runner.options().concurrency) {
+        runner.run(QStringLiteral("%1/prompt_rate_limited/c%2").arg(backend.provider).arg(threads), threads,
+                   [&](int thread, qint64 call) { return prompt(*backend.backend, backend.chatModel, thread, call); });
+    }
+    runner.server().setRateLimitEvery(0);
+}
+
+// One image of each size on a single thread; overhead_us against prompt/c1 is the
+// cost of encoding the attachment into the request and sending it
+void benchmarkAttachments(Runner& runner, const BackendCase& backend)
+{
+    for (const int bytes : runner.options().attachmentBytes) {
+        const QString name = QStringLiteral("%1/attachment/%2").arg(backend.provider).arg(bytes);
+        if (!runner.selected(name)) {
+            continue;
+        }
+        LLMMessage message;
+        QByteArray data(bytes, '\0');
+        for (int i = 0; i < bytes; ++i) {
+            data[i] = static_cast<char>((i * 2654435761u) >> 24);
+        }
+        message.attachments.append(LLMAttachment{QStringLiteral("image/png"), data});
+        runner.run(name, 1, [&](int thread, qint64 call) {
+            return prompt(*backend.backend, backend.chatModel, thread, call, message);
+        }, QJsonObject{{QStringLiteral("attachment_bytes"), bytes}});
+    }
+}
+
+void benchmarkEmbeddings(Runner& runner, const BackendCase& backend)
+{
+    if (backend.embeddingModel.isEmpty()) {
+        return;
+    }
+    for (const int threads : runner.options().concurrency) {
+        runner.run(QStringLiteral("%1/embedding/c%2").arg(backend.provider).arg(threads), threads,
+                   [&](int thread, qint64 call) {
+                       const EmbeddingResult result =
+                           backend.backend->getEmbedding(kApiKey, backend.embeddingModel, promptFor(thread, call));
+                       g_sink = g_sink + static_cast<double>(result.vector.size());
+                       return !result.hasError && !result.vector.empty();
+                   });
+    }
+}
+
+const BenchmarkUsage kUsage {
+    "backend_benchmarks", "^openai/prompt", "lower concurrency and smaller attachments, for smoke runs",
+    "  --warmup_time=S           unreported seconds before each benchmark (default 0.25)\n"
+    "  --latency_ms=MS           how long the mock server waits before answering (default 20)\n"
+    "  --concurrency=N,...       threads calling the backend at once (default 1,4,16,64)\n"
+    "  --attachment_bytes=B,...  attachment sizes (default 65536,1048576,8388608)\n"
+    "  --rate_limit_every=N      answer every Nth request with 429 in the rate-limited runs\n"
+    "                            (default 5; 0 skips them)\n"
+    "  --stream_chunks=N         deltas per streamed answer (default 16)\n"
+    "  --embedding_dims=N        entries per embedding vector (default 768)\n"};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    Options options;
+    const auto parseFlag = [&options](const QString& key, const QString& value) {
+        if (key == QLatin1String("--warmup_time")) {
+            options.warmupSeconds = qMax(0.0, value.toDouble());
+        } else if (key == QLatin1String("--latency_ms")) {
+            options.latencyMs = qMax(0, value.toInt());
+        } else if (key == QLatin1String("--concurrency")) {
+            options.concurrency = parseIntList(value);
+        } else if (key == QLatin1String("--attachment_bytes")) {
+            options.attachmentBytes = parseIntList(value);
+        } else if (key == QLatin1String("--rate_limit_every")) {
+            options.rateLimitEvery = qMax(0, value.toInt());
+        } else if (key == QLatin1String("--stream_chunks")) {
+            options.streamChunks = qMax(1, value.toInt());
+        } else if (key == QLatin1String("--embedding_dims")) {
+            options.embeddingDimensions = qMax(1, value.toInt());
+        } else {
+            return false;
+        }
+        return true;
+    };
+    const int exitCode = parseArguments(app.arguments().mid(1), options, kUsage, parseFlag);
+    if (exitCode >= 0) {
+        return exitCode;
+    }
+    if (options.quick) {
+        capList(options.concurrency, 16);
+        capList(options.attachmentBytes, 1024 * 1024);
+    }
+    options.concurrency.removeIf([](int value) { return value < 1; });
+
+    MockProviderServer server(options.latencyMs, options.streamChunks, options.embeddingDimensions);
+    if (!server.start()) {
+        std::fprintf(stderr, "Cannot start the mock provider server\n");
+        return 1;
+    }
+    // Every backend talks to the mock server; attachments stay inline
+    const QByteArray baseUrl = server.baseUrl().toUtf8();
+    for (const char* variable : {"OPENAI_BASE_URL", "ANTHROPIC_BASE_URL", "GOOGLE_BASE_URL", "OLLAMA_BASE_URL"}) {
+        qputenv(variable, baseUrl);
+    }
+    qputenv("CP_PROVIDER_FILE_UPLOADS", "0");
+
+    Runner runner(options, server);
+    runner.setContext(QStringLiteral("server_latency_ms"), options.latencyMs);
+    runner.setContext(QStringLiteral("stream_chunks"), options.streamChunks);
+    for (const BackendCase& backend : backendCases()) {
+        benchmarkPrompts(runner, backend);
+        benchmarkEmbeddings(runner, backend);
+        benchmarkAttachments(runner, backend);
+        benchmarkRateLimited(runner, backend);
+    }
+    return runner.finish();
+}
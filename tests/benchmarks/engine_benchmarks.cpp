@@ -0,0 +1,608 @@
+//
+// Cognitive Pipeline Application - execution engine benchmarks
+//
+// Measures the scheduler on synthetic graphs of no-op nodes (per-task overhead,
+// fan-out and fan-in, deep chains, loops), the cost of a scope body pass, input
+// signatures of large payloads, and LLM fan-outs against a mock backend with a
+// fixed latency. Results are written as Google Benchmark style JSON like the
+// RAG benchmarks, so scheduler, hashing and notification changes can be
+// compared on numbers. Run with --help for the options.
+//
+
+#include <QApplication>
+#include <QEventLoop>
+#include <QJsonObject>
+#include <QThread>
+#include <QTimer>
+#include <QtConcurrent>
+
+#include <QtNodes/internal/Definitions.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+
+#include "BenchmarkRunner.h"
+#include "ExecutionEngine.h"
+#include "GetItemNode.h"
+#include "IToolNode.h"
+#include "InputSignature.h"
+#include "IteratorScopeNode.h"
+#include "LoopNode.h"
+#include "NodeGraphModel.h"
+#include "SetItemResultNode.h"
+#include "TextInputNode.h"
+#include "ToolNodeDelegate.h"
+#include "UniversalLLMNode.h"
+#include "ai/backends/ILLMBackend.h"
+#include "ai/registry/LLMProviderRegistry.h"
+
+using namespace QtNodes;
+
+namespace {
+
+struct Options : BenchmarkOptions {
+    QList<int> widths {1, 10, 100, 1000, 10000};
+    QList<int> depths {10, 100, 1000};
+    int loopItems {10000};
+    int scopeItems {1000};
+    QList<int> payloadBytes {1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024};
+    int llmLatencyMs {50};
+    QList<int> llmWidths {1, 16, 64};
+    int runTimeoutSeconds {300};
+};
+
+using Runner = BenchmarkRunnerFor<Options>;
+
+// ---- Synthetic nodes -----------------------------------------------------
+
+PinDefinition textPin(PinDirection direction, const QString& id)
+{
+    PinDefinition pin;
+    pin.direction = direction;
+    pin.id = id;
+    pin.name = id;
+    pin.type = QStringLiteral("text");
+    return pin;
+}
+
+// Does no work: a source emits its payload, a node with inputs forwards the first one.
+// With several inputs it is only ready once all of them have arrived, so it joins a fan-out.
+class NoOpNode : public IToolNode
+{
+public:
+    NoOpNode(QString id, int inputs, QVariant payload = QStringLiteral("x"))
+        : m_id(std::move(id))
+        , m_inputs(inputs)
+        , m_payload(std::move(payload))
+    {
+    }
+
+    NodeDescriptor getDescriptor() const override
+    {
+        NodeDescriptor desc;
+        desc.id = m_id;
+        desc.name = m_id;
+        desc.category = QStringLiteral("Benchmarks");
+        for (int i = 0; i < m_inputs; ++i) {
+            const QString pinId = m_inputs == 1 ? QStringLiteral("in") : QStringLiteral("in%1").arg(i);
+            desc.inputPins.insert(pinId, textPin(PinDirection::Input, pinId));
+            desc.inputPinOrder.append(pinId);
+        }
+        desc.outputPins.insert(QStringLiteral("out"), textPin(PinDirection::Output, QStringLiteral("out")));
+        return desc;
+    }
+    bool supportsConcurrentRuns() const override { return true; }
+    TokenList execute(const TokenList& incomingTokens) override
+    {
+        ExecutionToken token;
+        const QVariantMap inputs = incomingTokens.empty() ? QVariantMap() : incomingTokens.front().data;
+        token.data.insert(QStringLiteral("out"), inputs.isEmpty() ? m_payload : inputs.constBegin().value());
+        return TokenList{std::move(token)};
+    }
+    QJsonObject saveState() const override { return {}; }
+    void loadState(const QJsonObject&) override {}
+
+private:
+    const QString m_id;
+    const int m_inputs;
+    const QVariant m_payload;
+};
+
+const QString kSourceType = QStringLiteral("bench-source");
+const QString kNoOpType = QStringLiteral("bench-noop");
+const QString kJoinType = QStringLiteral("bench-join");
+
+// Registers the source, the forwarding node and a join of @p joinInputs inputs on @p model
+void registerNoOpNodes(NodeGraphModel& model, const QVariant& payload = QStringLiteral("x"), int joinInputs = 2)
+{
+    auto registry = model.dataModelRegistry();
+    registry->registerModel([payload]() {
+        return std::make_unique<ToolNodeDelegate>(std::make_shared<NoOpNode>(kSourceType, 0, payload));
+    }, QStringLiteral("Benchmarks"));
+    registry->registerModel([]() {
+        return std::make_unique<ToolNodeDelegate>(std::make_shared<NoOpNode>(kNoOpType, 1));
+    }, QStringLiteral("Benchmarks"));
+    registry->registerModel([joinInputs]() {
+        return std::make_unique<ToolNodeDelegate>(std::make_shared<NoOpNode>(kJoinType, joinInputs));
+    }, QStringLiteral("Benchmarks"));
+}
+
+PortIndex portIndexFor(NodeGraphModel& model, NodeId nodeId, PortType portType, const QString& pinId)
+{
+    auto* delegate = model.delegateModel<ToolNodeDelegate>(nodeId);
+    if (!delegate) {
+        return InvalidPortIndex;
+    }
+    const unsigned int count = delegate->nPorts(portType);
+    for (PortIndex i = 0; i < count; ++i) {
+        if (delegate->pinIdForIndex(portType, i) == pinId) {
+            return i;
+        }
+    }
+    return InvalidPortIndex;
+}
+
+// ---- Engine runs ---------------------------------------------------------
+
+// Scheduler configurations every engine graph is measured under
+struct EngineVariant {
+    QString name;
+    ExecutionEngine::SchedulerMode scheduler;
+    ExecutionEngine::OutputNotificationMode notification;
+};
+
+const QList<EngineVariant>& engineVariants()
+{
+    static const QList<EngineVariant> variants = {
+        {QStringLiteral("global"), ExecutionEngine::SchedulerMode::GlobalQueue,
+         ExecutionEngine::OutputNotificationMode::Synchronous},
+        {QStringLiteral("global_coalesced"), ExecutionEngine::SchedulerMode::GlobalQueue,
+         ExecutionEngine::OutputNotificationMode::Coalesced},
+        {QStringLiteral("stealing"), ExecutionEngine::SchedulerMode::WorkStealing,
+         ExecutionEngine::OutputNotificationMode::Synchronous},
+    };
+    return variants;
+}
+
+// Runs the whole graph once, pumping the event loop until the engine reports the end
+bool runOnce(ExecutionEngine& engine, int timeoutSeconds)
+{
+    bool finished = false;
+    QEventLoop loop;
+    const QMetaObject::Connection connection =
+        QObject::connect(&engine, &ExecutionEngine::pipelineFinished, &loop, [&](const DataPacket&) {
+            finished = true;
+            loop.quit();
+        });
+    QTimer timeout;
+    timeout.setSingleShot(true);
+    QObject::connect(&timeout, &QTimer::timeout, &loop, &QEventLoop::quit);
+    engine.Run();
+    if (!finished) {
+        timeout.start(timeoutSeconds * 1000);
+        loop.exec();
+    }
+    QObject::disconnect(connection);
+    return finished;
+}
+
+// Measures full runs of @p model under each selected variant; @p tasks is the node executions per run
+void benchmarkGraph(Runner& runner, const QString& base, NodeGraphModel& model, int tasks)
+{
+    for (const EngineVariant& variant : engineVariants()) {
+        const QString name = QStringLiteral("%1/%2").arg(base, variant.name);
+        if (!runner.selected(name)) {
+            continue;
+        }
+        ExecutionEngine engine(&model);
+        engine.setSchedulerMode(variant.scheduler);
+        engine.setOutputNotificationMode(variant.notification);
+        engine.setLogVerbosity(ExecutionEngine::LogVerbosity::Quiet);
+
+        bool failed = false;
+        qint64 iterations = 0;
+        double realNs = 0.0;
+        double cpuNs = 0.0;
+        runner.measure([&]() { failed = !runOnce(engine, runner.options().runTimeoutSeconds) || failed; },
+                       iterations, realNs, cpuNs);
+        if (failed) {
+            std::fprintf(stderr, "%s: a run did not finish within %d s\n", qPrintable(name),
+                         runner.options().runTimeoutSeconds);
+            continue;
+        }
+        runner.report(name, iterations, realNs, cpuNs,
+                      {{QStringLiteral("tasks"), tasks},
+                       {QStringLiteral("ns_per_task"), realNs / tasks},
+                       {QStringLiteral("items_per_second"), tasks * 1e9 / realNs}});
+    }
+}
+
+bool anySelected(const Runner& runner, const QString& base)
+{
+    const QList<EngineVariant>& variants = engineVariants();
+    return std::any_of(variants.begin(), variants.end(), [&](const EngineVariant& variant) {
+        return runner.selected(QStringLiteral("%1/%2").arg(base, variant.name));
+    });
+}
+
+// Unconnected sources: the fixed cost of scheduling, running and retiring a task
+void benchmarkIndependent(Runner& runner)
+{
+    for (const int count : runner.options().widths) {
+        const QString base = QStringLiteral("engine/independent/%1").arg(count);
+        if (!anySelected(runner, base)) {
+            continue;
+        }
+        NodeGraphModel model;
+        registerNoOpNodes(model);
+        for (int i = 0; i < count; ++i) {
+            model.addNode(kSourceType);
+        }
+        benchmarkGraph(runner, base, model, count);
+    }
+}
+
+// One source feeding `width` nodes, optionally joined by one node with `width` inputs
+void benchmarkFanOut(Runner& runner, bool join)
+{
+    for (const int width : runner.options().widths) {
+        const QString base =
+            QStringLiteral("engine/%1/%2").arg(join ? QStringLiteral("fan_in") : QStringLiteral("fan_out")).arg(width);
+        if (!anySelected(runner, base)) {
+            continue;
+        }
+        NodeGraphModel model;
+        registerNoOpNodes(model, QStringLiteral("x"), width);
+        const NodeId source = model.addNode(kSourceType);
+        const NodeId sink = join ? model.addNode(kJoinType) : InvalidNodeId;
+        for (int i = 0; i < width; ++i) {
+            const NodeId branch = model.addNode(kNoOpType);
+            model.addConnection(ConnectionId{source, 0u, branch, 0u});
+            if (join) {
+                model.addConnection(ConnectionId{branch, 0u, sink, static_cast<PortIndex>(i)});
+            }
+        }
+        benchmarkGraph(runner, base, model, width + (join ? 2 : 1));
+    }
+}
+
+// A source followed by `depth` forwarding nodes in a line
+void benchmarkChain(Runner& runner)
+{
+    for (const int depth : runner.options().depths) {
+        const QString base = QStringLiteral("engine/chain/%1").arg(depth);
+        if (!anySelected(runner, base)) {
+            continue;
+        }
+        NodeGraphModel model;
+        registerNoOpNodes(model);
+        NodeId previous = model.addNode(kSourceType);
+        for (int i = 0; i < depth; ++i) {
+            const NodeId next = model.addNode(kNoOpType);
+            model.addConnection(ConnectionId{previous, 0u, next, 0u});
+            previous = next;
+        }
+        benchmarkGraph(runner, base, model, depth + 1);
+    }
+}
+
+// A chain of ten nodes passing one large value: signatures and data lake writes at every hop
+void benchmarkPayloadChain(Runner& runner)
+{
+    constexpr int kDepth = 10;
+    for (const int bytes : runner.options().payloadBytes) {
+        const QString base = QStringLiteral("engine/payload_chain/%1").arg(bytes);
+        if (!anySelected(runner, base)) {
+            continue;
+        }
+        NodeGraphModel model;
+        registerNoOpNodes(model, QString(bytes / 2, u'p'));
+        NodeId previous = model.addNode(kSourceType);
+        for (int i = 0; i < kDepth; ++i) {
+            const NodeId next = model.addNode(kNoOpType);
+            model.addConnection(ConnectionId{previous, 0u, next, 0u});
+            previous = next;
+        }
+        benchmarkGraph(runner, base, model, kDepth + 1);
+    }
+}
+
+// Text Input -> Loop (For Each) -> forwarding node: one body task per item
+void benchmarkLoop(Runner& runner)
+{
+    const int items = runner.options().loopItems;
+    const QString base = QStringLiteral("engine/loop/%1").arg(items);
+    if (!anySelected(runner, base)) {
+        return;
+    }
+    NodeGraphModel model;
+    registerNoOpNodes(model);
+    const NodeId textId = model.addNode(QStringLiteral("text-input"));
+    const NodeId loopId = model.addNode(QStringLiteral("loop-foreach"));
+    const NodeId bodyId = model.addNode(kNoOpType);
+    if (textId == InvalidNodeId || loopId == InvalidNodeId) {
+        std::fprintf(stderr, "%s: the loop nodes are not registered\n", qPrintable(base));
+        return;
+    }
+    QStringList lines;
+    for (int i = 0; i < items; ++i) {
+        lines.append(QStringLiteral("item %1").arg(i));
+    }
+    auto text = std::dynamic_pointer_cast<TextInputNode>(model.delegateModel<ToolNodeDelegate>(textId)->node());
+    text->setText(lines.join(u'\n'));
+    model.addConnection(ConnectionId{textId, 0u, loopId,
+                                     portIndexFor(model, loopId, PortType::In, QString::fromLatin1(LoopNode::kInputListId))});
+    model.addConnection(ConnectionId{loopId, portIndexFor(model, loopId, PortType::Out, QString::fromLatin1(LoopNode::kOutputBodyId)),
+                                     bodyId, 0u});
+    benchmarkGraph(runner, base, model, items + 2);
+}
+
+// ---- Scope bodies --------------------------------------------------------
+
+// Iterator scope over `items` items whose body forwards each item through `bodyNodes` nodes
+void benchmarkScope(Runner& runner)
+{
+    const int items = runner.options().scopeItems;
+    for (const int bodyNodes : {0, 8}) {
+        const QString name = QStringLiteral("scope/iterator/%1/body_nodes%2").arg(items).arg(bodyNodes);
+        if (!runner.selected(name)) {
+            continue;
+        }
+        NodeGraphModel root;
+        const NodeId scopeId = root.addNode(QStringLiteral("iterator-scope"));
+        auto scope = std::dynamic_pointer_cast<IteratorScopeNode>(root.delegateModel<ToolNodeDelegate>(scopeId)->node());
+        NodeGraphModel* body = scope ? root.ensureSubgraph(scope->bodyId(), NodeGraphModel::GraphKind::IteratorBody) : nullptr;
+        if (!body) {
+            std::fprintf(stderr, "%s: no iterator body\n", qPrintable(name));
+            continue;
+        }
+        registerNoOpNodes(*body);
+        const NodeId itemId = body->addNode(QStringLiteral("iterator-get-item"));
+        const NodeId resultId = body->addNode(QStringLiteral("iterator-set-result"));
+        NodeId previous = itemId;
+        PortIndex previousOut = portIndexFor(*body, itemId, PortType::Out, QString::fromLatin1(GetItemNode::kOutputItemId));
+        for (int i = 0; i < bodyNodes; ++i) {
+            const NodeId next = body->addNode(kNoOpType);
+            body->addConnection(ConnectionId{previous, previousOut, next, 0u});
+            previous = next;
+            previousOut = 0u;
+        }
+        body->addConnection(ConnectionId{previous, previousOut, resultId,
+                                         portIndexFor(*body, resultId, PortType::In, QString::fromLatin1(SetItemResultNode::kInputResultId))});
+
+        QVariantList list;
+        for (int i = 0; i < items; ++i) {
+            list.append(QStringLiteral("item %1").arg(i));
+        }
+        ExecutionToken in;
+        in.data.insert(QString::fromLatin1(IteratorScopeNode::kInputItemsId), list);
+
+        bool failed = false;
+        qint64 iterations = 0;
+        double realNs = 0.0;
+        double cpuNs = 0.0;
+        runner.measure([&]() {
+            const TokenList out = scope->execute(TokenList{in});
+            failed = failed || out.empty() || out.front().data.contains(QStringLiteral("__error"));
+        }, iterations, realNs, cpuNs);
+        if (failed) {
+            std::fprintf(stderr, "%s: the scope reported an error\n", qPrintable(name));
+            continue;
+        }
+        runner.report(name, iterations, realNs, cpuNs,
+                      {{QStringLiteral("passes"), items},
+                       {QStringLiteral("ns_per_pass"), realNs / items},
+                       {QStringLiteral("items_per_second"), items * 1e9 / realNs}});
+    }
+}
+
+// ---- Input signatures ----------------------------------------------------
+
+QVariant payloadOfKind(const QString& kind, int bytes)
+{
+    if (kind == QLatin1String("string")) {
+        return QString(bytes / 2, u's');
+    }
+    if (kind == QLatin1String("bytes")) {
+        return QByteArray(bytes, 'b');
+    }
+    // A list of 1 KiB strings, or a map of them at the next level down
+    QVariantList list;
+    for (int i = 0; i < qMax(1, bytes / 1024); ++i) {
+        list.append(QString(512, QChar(u'a' + i % 26)));
+    }
+    if (kind == QLatin1String("list")) {
+        return list;
+    }
+    QVariantMap map;
+    for (int i = 0; i < list.size(); ++i) {
+        map.insert(QStringLiteral("key%1").arg(i), list.at(i));
+    }
+    return map;
+}
+
+// The dedup signature of one large input: warm repeats the same value, which the
+// signature cache short-cuts above its threshold; cold clears the cache every time
+void benchmarkSignatures(Runner& runner)
+{
+    for (const QString kind : {QStringLiteral("string"), QStringLiteral("bytes"), QStringLiteral("list"), QStringLiteral("map")}) {
+        for (const int bytes : runner.options().payloadBytes) {
+            const QString coldName = QStringLiteral("dedup/signature/%1/%2/cold").arg(kind).arg(bytes);
+            const QString warmName = QStringLiteral("dedup/signature/%1/%2/warm").arg(kind).arg(bytes);
+            if (!runner.selected(coldName) && !runner.selected(warmName)) {
+                continue;
+            }
+            QVariantMap payload;
+            payload.insert(QStringLiteral("in"), payloadOfKind(kind, bytes));
+            payload.insert(QStringLiteral("other"), QStringLiteral("small"));
+
+            for (const bool cold : {true, false}) {
+                const QString name = cold ? coldName : warmName;
+                if (!runner.selected(name)) {
+                    continue;
+                }
+                InputSignature::clearCache();
+                qint64 iterations = 0;
+                double realNs = 0.0;
+                double cpuNs = 0.0;
+                runner.measure([&]() {
+                    if (cold) {
+                        InputSignature::clearCache();
+                    }
+                    g_sink = g_sink + InputSignature::compute(payload).size();
+                }, iterations, realNs, cpuNs);
+                runner.report(name, iterations, realNs, cpuNs,
+                              {{QStringLiteral("bytes_per_second"), bytes * 1e9 / realNs}});
+            }
+        }
+    }
+}
+
+// ---- LLM fan-out ---------------------------------------------------------
+
+// Answers every prompt after a fixed delay, standing in for a remote provider
+class MockLLMBackend : public ILLMBackend {
+public:
+    explicit MockLLMBackend(int latencyMs)
+        : m_latencyMs(latencyMs)
+    {
+    }
+
+    QString id() const override { return QStringLiteral("ollama"); }
+    QString name() const override { return QStringLiteral("Mock LLM Backend"); }
+    QStringList availableModels() const override { return {QStringLiteral("mock")}; }
+    QStringList availableEmbeddingModels() const override { return {}; }
+    QFuture<QStringList> fetchModelList() override
+    {
+        return QtConcurrent::run([]() { return QStringList{QStringLiteral("mock")}; });
+    }
+    LLMResult sendPrompt(const QString&, const QString&, double, int, const QString&, const QString& userPrompt,
+                         const LLMMessage& = {}) override
+    {
+        QThread::msleep(static_cast<unsigned long>(m_latencyMs));
+        LLMResult result;
+        result.content = QStringLiteral("echo: ") + userPrompt;
+        result.usage.inputTokens = static_cast<int>(userPrompt.size() / 4);
+        result.usage.outputTokens = 4;
+        result.usage.totalTokens = result.usage.inputTokens + result.usage.outputTokens;
+        return result;
+    }
+    EmbeddingResult getEmbedding(const QString&, const QString&, const QString&) override { return {}; }
+    QFuture<QString> generateImage(const QString&, const QString&, const QString&, const QString&,
+                                   const QString&, const QString&) override
+    {
+        return QFuture<QString>();
+    }
+
+private:
+    const int m_latencyMs;
+};
+
+// One source feeding `width` LLM nodes: how many requests of fixed latency the engine overlaps
+void benchmarkLlmFanOut(Runner& runner)
+{
+    const int latencyMs = runner.options().llmLatencyMs;
+    bool registered = false;
+    for (const int width : runner.options().llmWidths) {
+        const QString base = QStringLiteral("llm/fan_out/%1/latency%2ms").arg(width).arg(latencyMs);
+        if (!anySelected(runner, base)) {
+            continue;
+        }
+        if (!registered) {
+            LLMProviderRegistry::instance().registerBackend(std::make_shared<MockLLMBackend>(latencyMs));
+            registered = true;
+        }
+        NodeGraphModel model;
+        registerNoOpNodes(model, QStringLiteral("Summarise the benchmark."));
+        const NodeId source = model.addNode(kSourceType);
+        for (int i = 0; i < width; ++i) {
+            const NodeId llmId = model.addNode(QStringLiteral("universal-llm"));
+            auto llm = std::dynamic_pointer_cast<UniversalLLMNode>(model.delegateModel<ToolNodeDelegate>(llmId)->node());
+            if (!llm) {
+                break;
+            }
+            QJsonObject state = llm->saveState();
+            state.insert(QStringLiteral("provider"), QStringLiteral("ollama"));
+            state.insert(QStringLiteral("model"), QStringLiteral("mock"));
+            state.insert(QStringLiteral("bypassResponseCache"), true);
+            llm->loadState(state);
+            model.addConnection(ConnectionId{source, 0u, llmId,
+                                             portIndexFor(model, llmId, PortType::In,
+                                                          QString::fromLatin1(UniversalLLMNode::kInputPromptId))});
+        }
+        benchmarkGraph(runner, base, model, width + 1);
+    }
+}
+
+const BenchmarkUsage kUsage {
+    "engine_benchmarks", "^engine/chain", "small graphs only, for smoke runs",
+    "  --widths=N,...            fan-out, fan-in and independent node counts (default 1,10,100,1000,10000)\n"
+    "  --depths=N,...            chain lengths (default 10,100,1000)\n"
+    "  --loop_items=N            items through the loop (default 10000)\n"
+    "  --scope_items=N           items through the iterator scope (default 1000)\n"
+    "  --payload_bytes=B,...     payload sizes of the signature and payload chain benchmarks\n"
+    "                            (default 1024,65536,1048576,16777216)\n"
+    "  --llm_latency_ms=MS       latency of the mock LLM backend (default 50)\n"
+    "  --llm_widths=N,...        LLM nodes behind one source (default 1,16,64)\n"
+    "  --run_timeout=S           seconds one engine run may take before it counts as failed (default 300)\n"};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    // Node delegates belong to a widget application; no window is ever shown
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", QByteArrayLiteral("offscreen"));
+    }
+    QApplication app(argc, argv);
+
+    Options options;
+    const auto parseFlag = [&options](const QString& key, const QString& value) {
+        if (key == QLatin1String("--widths")) {
+            options.widths = parseIntList(value);
+        } else if (key == QLatin1String("--depths")) {
+            options.depths = parseIntList(value);
+        } else if (key == QLatin1String("--loop_items")) {
+            options.loopItems = qMax(1, value.toInt());
+        } else if (key == QLatin1String("--scope_items")) {
+            options.scopeItems = qMax(1, value.toInt());
+        } else if (key == QLatin1String("--payload_bytes")) {
+            options.payloadBytes = parseIntList(value);
+        } else if (key == QLatin1String("--llm_latency_ms")) {
+            options.llmLatencyMs = qMax(0, value.toInt());
+        } else if (key == QLatin1String("--llm_widths")) {
+            options.llmWidths = parseIntList(value);
+        } else if (key == QLatin1String("--run_timeout")) {
+            options.runTimeoutSeconds = qMax(1, value.toInt());
+        } else {
+            return false;
+        }
+        return true;
+    };
+    const int exitCode = parseArguments(app.arguments().mid(1), options, kUsage, parseFlag);
+    if (exitCode >= 0) {
+        return exitCode;
+    }
+    if (options.quick) {
+        capList(options.widths, 1000);
+        capList(options.depths, 100);
+        capList(options.payloadBytes, 1024 * 1024);
+        capList(options.llmWidths, 16);
+        options.loopItems = qMin(options.loopItems, 1000);
+        options.scopeItems = qMin(options.scopeItems, 100);
+    }
+
+    Runner runner(options);
+    runner.setContext(QStringLiteral("llm_latency_ms"), options.llmLatencyMs);
+    benchmarkIndependent(runner);
+    benchmarkFanOut(runner, false);
+    benchmarkFanOut(runner, true);
+    benchmarkChain(runner);
+    benchmarkPayloadChain(runner);
+    benchmarkLoop(runner);
+    benchmarkScope(runner);
+    benchmarkSignatures(runner);
+    benchmarkLlmFanOut(runner);
+    return runner.finish();
+}
@@ -0,0 +1,800 @@
+//
+// Cognitive Pipeline Application - RAG performance benchmarks
+//
+// Measures chunking, embedding scans, search and indexing, and writes the
+// results as Google Benchmark style JSON so runs can be compared across
+// releases. Run with --help for the options.
+//
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonObject>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "BenchmarkRunner.h"
+#include "RagIndexerNode.h"
+#include "ai/backends/ILLMBackend.h"
+#include "ai/registry/LLMProviderRegistry.h"
+#include "retrieval/chunking/ParallelChunker.h"
+#include "retrieval/chunking/TextChunker.h"
+#include "retrieval/documents/DirectoryScanner.h"
+#include "retrieval/documents/DocumentLoader.h"
+#include "retrieval/storage/EmbeddingCache.h"
+#include "retrieval/storage/RagUtils.h"
+#include "retrieval/storage/VectorKernels.h"
+
+namespace {
+
+struct Options : BenchmarkOptions {
+    QString corpusPath;
+    QList<int> scanVectors {100000, 1000000};
+    QList<int> scanDimensions {384, 768, 1536};
+    qint64 maxScanBytes {qint64(4) << 30};
+    int searchVectors {100000};
+    int searchDimension {384};
+    int searchQueries {50};
+    int topK {10};
+    int indexFiles {400};
+    int embeddingDimension {384};
+};
+
+using Runner = BenchmarkRunnerFor<Options>;
+
+// ---- Synthetic corpora ---------------------------------------------------
+
+const QStringList& words()
+{
+    static const QStringList list = QStringLiteral(
+        "index vector query chunk embedding model provider pipeline node graph token result file "
+        "directory search ranking score cache batch thread worker region overlap header section "
+        "parser buffer stream window offset length line column value option setting cluster")
+                                        .split(u' ');
+    return list;
+}
+
+QString sentence(std::mt19937& random, int wordCount)
+{
+    std::uniform_int_distribution<int> pick(0, static_cast<int>(words().size()) - 1);
+    QString text;
+    for (int w = 0; w < wordCount; ++w) {
+        if (w > 0) {
+            text += u' ';
+        }
+        text += words().at(pick(random));
+    }
+    return text;
+}
+
+// About @p length characters of text shaped like @p fileType
+QString syntheticDocument(FileType fileType, qsizetype length, quint32 seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> small(2, 8);
+    QString text;
+    text.reserve(length + 4096);
+    int item = 0;
+    while (text.length() < length) {
+        const QString name = QStringLiteral("%1_%2").arg(words().at(item % words().size())).arg(item);
+        switch (fileType) {
+        case FileType::CodeCpp:
+            text += QStringLiteral("// %1\nint %2(int value)\n{\n").arg(sentence(random, 8), name);
+            for (int i = small(random); i > 0; --i) {
+                text += QStringLiteral("    if (value > %1) {\n        value -= %1; // %2\n    }\n")
+                            .arg(i)
+                            .arg(sentence(random, 4));
+            }
+            text += QStringLiteral("    return value;\n}\n\n");
+            break;
+        case FileType::CodePython:
+            text += QStringLiteral("def %1(value):\n    \"\"\"%2.\"\"\"\n").arg(name, sentence(random, 10));
+            for (int i = small(random); i > 0; --i) {
+                text += QStringLiteral("    if value > %1:\n        value -= %1  # %2\n").arg(i).arg(sentence(random, 4));
+            }
+            text += QStringLiteral("    return value\n\n\n");
+            break;
+        case FileType::CodeMarkdown:
+            text += QStringLiteral("## %1\n\n%2.\n\n").arg(name, sentence(random, 40));
+            for (int i = small(random) / 2; i > 0; --i) {
+                text += QStringLiteral("- %1\n").arg(sentence(random, 8));
+            }
+            text += QStringLiteral("\n```\n%1\n```\n\n").arg(sentence(random, 12));
+            break;
+        default:
+            for (int i = small(random); i > 0; --i) {
+                text += sentence(random, 12) + QStringLiteral(". ");
+            }
+            text += QStringLiteral("\n\n");
+            break;
+        }
+        ++item;
+    }
+    return text;
+}
+
+QString fileTypeName(FileType fileType)
+{
+    switch (fileType) {
+    case FileType::CodeCpp:
+        return QStringLiteral("cpp");
+    case FileType::CodePython:
+        return QStringLiteral("python");
+    case FileType::CodeMarkdown:
+        return QStringLiteral("markdown");
+    default:
+        return QStringLiteral("plain");
+    }
+}
+
+QString fileExtension(FileType fileType)
+{
+    switch (fileType) {
+    case FileType::CodeCpp:
+        return QStringLiteral("cpp");
+    case FileType::CodePython:
+        return QStringLiteral("py");
+    case FileType::CodeMarkdown:
+        return QStringLiteral("md");
+    default:
+        return QStringLiteral("txt");
+    }
+}
+
+const QList<FileType>& syntheticFileTypes()
+{
+    static const QList<FileType> types = {FileType::PlainText, FileType::CodeCpp, FileType::CodePython,
+                                          FileType::CodeMarkdown};
+    return types;
+}
+
+// Unit vectors scattered around a few hundred centres, like embeddings of related chunks
+class VectorGenerator
+{
+public:
+    VectorGenerator(int dimension, int clusters, quint32 seed)
+        : m_dimension(dimension)
+        , m_random(seed)
+    {
+        for (int c = 0; c < clusters; ++c) {
+            m_centres.push_back(gaussian(1.0f));
+        }
+    }
+
+    std::vector<float> next(float spread = 0.35f)
+    {
+        std::uniform_int_distribution<int> pick(0, static_cast<int>(m_centres.size()) - 1);
+        std::vector<float> vector = gaussian(spread);
+        const std::vector<float>& centre = m_centres[static_cast<std::size_t>(pick(m_random))];
+        for (int d = 0; d < m_dimension; ++d) {
+            vector[static_cast<std::size_t>(d)] += centre[static_cast<std::size_t>(d)];
+        }
+        VectorKernels::normalize(vector);
+        return vector;
+    }
+
+private:
+    std::vector<float> gaussian(float sigma)
+    {
+        std::normal_distribution<float> normal(0.0f, sigma);
+        std::vector<float> vector(static_cast<std::size_t>(m_dimension));
+        for (float& value : vector) {
+            value = normal(m_random);
+        }
+        return vector;
+    }
+
+    const int m_dimension;
+    std::mt19937 m_random;
+    std::vector<std::vector<float>> m_centres;
+};
+
+// Cheap uniform unit vectors for the scan buffers, where the values do not matter
+std::vector<float> uniformVector(int dimension, quint64& state)
+{
+    std::vector<float> vector(static_cast<std::size_t>(dimension));
+    for (float& value : vector) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        value = static_cast<float>(state >> 40) / static_cast<float>(1 << 23) - 1.0f;
+    }
+    VectorKernels::normalize(vector);
+    return vector;
+}
+
+// ---- Chunking ------------------------------------------------------------
+
+void benchmarkChunking(Runner& runner)
+{
+    const Options& options = runner.options();
+    const qsizetype length = options.quick ? (qsizetype(256) << 10) : (qsizetype(4) << 20);
+    const int chunkSize = 1000;
+    const int chunkOverlap = 200;
+
+    for (const FileType fileType : syntheticFileTypes()) {
+        const QString base = QStringLiteral("chunking/%1").arg(fileTypeName(fileType));
+        const QString serialName = base + QStringLiteral("/serial");
+        const QString parallelName = base + QStringLiteral("/parallel");
+        if (!runner.selected(serialName) && !runner.selected(parallelName)) {
+            continue;
+        }
+        const QString text = syntheticDocument(fileType, length, 7);
+        const double bytes = static_cast<double>(text.toUtf8().size());
+
+        qint64 iterations = 0;
+        double realNs = 0.0;
+        double cpuNs = 0.0;
+        qsizetype chunks = 0;
+        if (runner.selected(serialName)) {
+            runner.measure([&]() { chunks = TextChunker::splitSpans(text, chunkSize, chunkOverlap, fileType).size(); },
+                           iterations, realNs, cpuNs);
+            runner.report(serialName, iterations, realNs, cpuNs,
+                          {{QStringLiteral("bytes_per_second"), bytes * 1e9 / realNs},
+                           {QStringLiteral("chunks"), static_cast<double>(chunks)}});
+        }
+        if (runner.selected(parallelName)) {
+            // Regions small enough that the synthetic document spans several
+            const qsizetype regionLength = length / 16;
+            runner.measure([&]() {
+                chunks = ParallelChunker::splitSpans(text, chunkSize, chunkOverlap, fileType, nullptr, regionLength)
+                             .size();
+            }, iterations, realNs, cpuNs);
+            runner.report(parallelName, iterations, realNs, cpuNs,
+                          {{QStringLiteral("bytes_per_second"), bytes * 1e9 / realNs},
+                           {QStringLiteral("chunks"), static_cast<double>(chunks)}});
+        }
+    }
+
+    // A recorded corpus: the supported files of a real directory, each chunked by its type
+    if (options.corpusPath.isEmpty()) {
+        return;
+    }
+    const QString serialName = QStringLiteral("chunking/corpus/serial");
+    const QString manyName = QStringLiteral("chunking/corpus/parallel_many");
+    if (!runner.selected(serialName) && !runner.selected(manyName)) {
+        return;
+    }
+    QStringList texts;
+    QList<FileType> fileTypes;
+    double bytes = 0.0;
+    for (const QString& filePath : DirectoryScanner::scan(options.corpusPath)) {
+        QString content = DocumentLoader::readTextFile(filePath);
+        if (content.isEmpty()) {
+            continue;
+        }
+        bytes += static_cast<double>(QFileInfo(filePath).size());
+        texts.append(std::move(content));
+        fileTypes.append(DocumentLoader::getFileTypeFromExtension(filePath));
+    }
+    if (texts.isEmpty()) {
+        std::fprintf(stderr, "No supported files in corpus %s\n", qPrintable(options.corpusPath));
+        return;
+    }
+
+    qint64 iterations = 0;
+    double realNs = 0.0;
+    double cpuNs = 0.0;
+    qsizetype chunks = 0;
+    const QJsonObject corpus {{QStringLiteral("files"), static_cast<double>(texts.size())}};
+    if (runner.selected(serialName)) {
+        runner.measure([&]() {
+            chunks = 0;
+            for (qsizetype i = 0; i < texts.size(); ++i) {
+                chunks += TextChunker::splitSpans(texts.at(i), chunkSize, chunkOverlap, fileTypes.at(i)).size();
+            }
+        }, iterations, realNs, cpuNs);
+        QJsonObject counters = corpus;
+        counters.insert(QStringLiteral("bytes_per_second"), bytes * 1e9 / realNs);
+        counters.insert(QStringLiteral("chunks"), static_cast<double>(chunks));
+        runner.report(serialName, iterations, realNs, cpuNs, counters);
+    }
+    if (runner.selected(manyName)) {
+        runner.measure([&]() {
+            chunks = 0;
+            for (const QList<TextChunkSpan>& spans :
+                 ParallelChunker::splitSpansMany(texts, fileTypes, chunkSize, chunkOverlap)) {
+                chunks += spans.size();
+            }
+        }, iterations, realNs, cpuNs);
+        QJsonObject counters = corpus;
+        counters.insert(QStringLiteral("bytes_per_second"), bytes * 1e9 / realNs);
+        counters.insert(QStringLiteral("chunks"), static_cast<double>(chunks));
+        runner.report(manyName, iterations, realNs, cpuNs, counters);
+    }
+}
+
+// ---- Embedding scans -----------------------------------------------------
+
+// Decoding each row as a search did before the kernels, then scoring it
+double scanDecoded(const QByteArray& rows, int rowBytes, qsizetype count, RagEmbeddingFormat format,
+                   const std::vector<float>& query)
+{
+    double best = -1.0;
+    for (qsizetype i = 0; i < count; ++i) {
+        const QByteArray blob = QByteArray::fromRawData(rows.constData() + i * rowBytes, rowBytes);
+        best = std::max(best, RagUtils::cosineSimilarity(query, RagUtils::decodeEmbedding(blob, format)));
+    }
+    return best;
+}
+
+// Scoring the stored bytes in place, as the search scan does
+double scanKernel(const QByteArray& rows, int rowBytes, qsizetype count, RagEmbeddingFormat format,
+                  const std::vector<float>& query)
+{
+    const std::size_t dimension = query.size();
+    double best = -1.0;
+    for (qsizetype i = 0; i < count; ++i) {
+        const char* row = rows.constData() + i * rowBytes;
+        double score = 0.0;
+        if (format == RagEmbeddingFormat::Float32) {
+            score = VectorKernels::dot(query.data(), row, dimension);
+        } else if (format == RagEmbeddingFormat::Float16) {
+            score = VectorKernels::dotHalf(query.data(), row, dimension);
+        } else {
+            float scale = 0.0f;
+            std::memcpy(&scale, row, sizeof(scale));
+            score = static_cast<double>(scale) * VectorKernels::dotInt8(query.data(), row + sizeof(scale), dimension);
+        }
+        best = std::max(best, score);
+    }
+    return best;
+}
+
+void benchmarkScan(Runner& runner)
+{
+    const Options& options = runner.options();
+    const QList<RagEmbeddingFormat> formats = {RagEmbeddingFormat::Float32, RagEmbeddingFormat::Float16,
+                                               RagEmbeddingFormat::Int8};
+    for (const int configuredCount : options.scanVectors) {
+        const int count = options.quick ? configuredCount / 10 : configuredCount;
+        for (const int dimension : options.scanDimensions) {
+            for (const RagEmbeddingFormat format : formats) {
+                const QString suffix = QStringLiteral("%1/%2/%3")
+                                           .arg(RagUtils::embeddingFormatName(format).toLower())
+                                           .arg(count)
+                                           .arg(dimension);
+                const QString decodedName = QStringLiteral("scan/decode_cosine/") + suffix;
+                const QString kernelName = QStringLiteral("scan/kernel/") + suffix;
+                if (!runner.selected(decodedName) && !runner.selected(kernelName)) {
+                    continue;
+                }
+                const int rowBytes = RagUtils::embeddingBlobSize(format, dimension);
+                const qint64 totalBytes = static_cast<qint64>(rowBytes) * count;
+                if (totalBytes > options.maxScanBytes) {
+                    std::fprintf(stderr, "Skipping %s: %lld bytes is over --max_scan_bytes\n", qPrintable(suffix),
+                                 static_cast<long long>(totalBytes));
+                    continue;
+                }
+
+                QByteArray rows;
+                rows.reserve(totalBytes);
+                quint64 state = 0x9E3779B97F4A7C15ull ^ static_cast<quint64>(dimension);
+                for (int i = 0; i < count; ++i) {
+                    rows.append(RagUtils::encodeEmbedding(uniformVector(dimension, state), format));
+                }
+                const std::vector<float> query = uniformVector(dimension, state);
+
+                qint64 iterations = 0;
+                double realNs = 0.0;
+                double cpuNs = 0.0;
+                const QJsonObject sizes {{QStringLiteral("vectors"), count}, {QStringLiteral("dimension"), dimension}};
+                if (runner.selected(decodedName)) {
+                    runner.measure([&]() { g_sink = scanDecoded(rows, rowBytes, count, format, query); },
+                                   iterations, realNs, cpuNs);
+                    QJsonObject counters = sizes;
+                    counters.insert(QStringLiteral("items_per_second"), count * 1e9 / realNs);
+                    counters.insert(QStringLiteral("bytes_per_second"), static_cast<double>(totalBytes) * 1e9 / realNs);
+                    runner.report(decodedName, iterations, realNs, cpuNs, counters);
+                }
+                if (runner.selected(kernelName)) {
+                    runner.measure([&]() { g_sink = scanKernel(rows, rowBytes, count, format, query); },
+                                   iterations, realNs, cpuNs);
+                    QJsonObject counters = sizes;
+                    counters.insert(QStringLiteral("items_per_second"), count * 1e9 / realNs);
+                    counters.insert(QStringLiteral("bytes_per_second"), static_cast<double>(totalBytes) * 1e9 / realNs);
+                    runner.report(kernelName, iterations, realNs, cpuNs, counters);
+                }
+            }
+        }
+    }
+}
+
+// ---- Search --------------------------------------------------------------
+
+bool buildSearchDatabase(const QString& dbPath, const std::vector<std::vector<float>>& vectors,
+                         RagEmbeddingFormat format)
+{
+    const QString connectionName = QStringLiteral("rag_benchmarks_%1").arg(RagUtils::embeddingFormatName(format));
+    bool ok = true;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+        db.setDatabaseName(dbPath);
+        ok = db.open();
+        QSqlQuery query(db);
+        ok = ok && query.exec(QString::fromUtf8(kRagSchemaPragma)) && query.exec(QString::fromUtf8(kRagSchemaSourceFiles))
+             && query.exec(QString::fromUtf8(kRagSchemaFragments))
+             && query.exec(QStringLiteral("PRAGMA user_version = %1").arg(kRagNormalizedEmbeddingsVersion));
+        if (ok) {
+            query.prepare(QStringLiteral("INSERT INTO source_files (file_path, provider, model, embedding_format) "
+                                         "VALUES ('synthetic.txt', 'benchmark', 'synthetic', ?)"));
+            query.addBindValue(RagUtils::embeddingFormatName(format));
+            ok = query.exec() && db.transaction();
+        }
+        if (ok) {
+            // Quantised indexes keep float32 copies so rescoring can be measured too
+            const bool keepFull = format != RagEmbeddingFormat::Float32;
+            query.prepare(QStringLiteral("INSERT INTO fragments (file_id, chunk_index, content, embedding, embedding_full) "
+                                         "VALUES (1, ?, ?, ?, ?)"));
+            for (std::size_t i = 0; ok && i < vectors.size(); ++i) {
+                query.addBindValue(static_cast<int>(i));
+                query.addBindValue(QStringLiteral("chunk %1").arg(i));
+                query.addBindValue(RagUtils::encodeEmbedding(vectors[i], format));
+                query.addBindValue(keepFull ? QVariant(RagUtils::encodeEmbedding(vectors[i])) : QVariant());
+                ok = query.exec();
+            }
+            ok = db.commit() && ok;
+        }
+        if (!ok) {
+            std::fprintf(stderr, "Failed to build %s: %s\n", qPrintable(dbPath), qPrintable(query.lastError().text()));
+        }
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return ok;
+}
+
+// The exact top-k chunk indexes for each query, from the original float32 vectors
+std::vector<std::vector<int>> exactNeighbours(const std::vector<std::vector<float>>& vectors,
+                                              const std::vector<std::vector<float>>& queries, int k)
+{
+    std::vector<std::vector<int>> result;
+    for (const std::vector<float>& query : queries) {
+        std::vector<std::pair<float, int>> scores(vectors.size());
+        for (std::size_t i = 0; i < vectors.size(); ++i) {
+            scores[i] = {VectorKernels::dot(query.data(), vectors[i].data(), query.size()), static_cast<int>(i)};
+        }
+        const std::size_t keep = std::min<std::size_t>(static_cast<std::size_t>(k), scores.size());
+        std::partial_sort(scores.begin(), scores.begin() + static_cast<std::ptrdiff_t>(keep), scores.end(),
+                          [](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; });
+        std::vector<int> ids;
+        for (std::size_t i = 0; i < keep; ++i) {
+            ids.push_back(scores[i].second);
+        }
+        result.push_back(std::move(ids));
+    }
+    return result;
+}
+
+void runSearch(Runner& runner, const QString& name, const QString& dbPath, const RagSearchOptions& searchOptions,
+               const std::vector<std::vector<float>>& queries, const std::vector<std::vector<int>>& truth)
+{
+    if (!runner.selected(name)) {
+        return;
+    }
+    const int k = runner.options().topK;
+    std::vector<double> latencies;
+    double recall = 0.0;
+    qint64 iterations = 0;
+    double realNs = 0.0;
+    double cpuNs = 0.0;
+    std::size_t next = 0;
+    runner.measure([&]() {
+        const std::size_t q = next++ % queries.size();
+        QElapsedTimer timer;
+        timer.start();
+        const std::vector<RagUtils::SearchResult> results =
+            RagUtils::findMostRelevantChunks(dbPath, queries[q], k, 0.0, searchOptions);
+        latencies.push_back(static_cast<double>(timer.nsecsElapsed()));
+        if (latencies.size() <= queries.size()) {
+            int hits = 0;
+            for (const RagUtils::SearchResult& result : results) {
+                hits += std::count(truth[q].begin(), truth[q].end(), result.chunkIndex) > 0 ? 1 : 0;
+            }
+            recall += static_cast<double>(hits) / static_cast<double>(truth[q].size());
+        }
+    }, iterations, realNs, cpuNs);
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        return latencies[std::min(latencies.size() - 1, static_cast<std::size_t>(p * latencies.size()))] / 1000.0;
+    };
+    const std::size_t recalled = std::min(latencies.size(), queries.size());
+    runner.report(name, iterations, realNs, cpuNs,
+                  {{QStringLiteral("p50_us"), percentile(0.50)},
+                   {QStringLiteral("p95_us"), percentile(0.95)},
+                   {QStringLiteral("recall_at_k"), recall / static_cast<double>(recalled)},
+                   {QStringLiteral("k"), k}});
+}
+
+// The benchmarks run against one index format
+QStringList searchBenchmarkNames(RagEmbeddingFormat format, const QString& sizes)
+{
+    const QString formatName = RagUtils::embeddingFormatName(format).toLower();
+    QStringList names = {QStringLiteral("search/exact_sqlite/%1/%2").arg(formatName, sizes),
+                         QStringLiteral("search/exact_vector_file/%1/%2").arg(formatName, sizes),
+                         QStringLiteral("search/exact_rescored/%1/%2").arg(formatName, sizes),
+                         QStringLiteral("search/ann_build/%1/%2").arg(formatName, sizes)};
+    if (format == RagEmbeddingFormat::Float32) {
+        names.removeAt(2);
+    }
+    for (const int ef : {32, 64, 128, 256}) {
+        names.append(QStringLiteral("search/ann/%1/%2/ef%3").arg(formatName, sizes).arg(ef));
+    }
+    return names;
+}
+
+void benchmarkSearch(Runner& runner)
+{
+    const Options& options = runner.options();
+    const int count = options.quick ? options.searchVectors / 10 : options.searchVectors;
+    const int dimension = options.searchDimension;
+    const int queryCount = options.quick ? qMin(options.searchQueries, 20) : options.searchQueries;
+    const QString sizes = QStringLiteral("%1/%2").arg(count).arg(dimension);
+
+    QList<RagEmbeddingFormat> formats;
+    for (const RagEmbeddingFormat format :
+         {RagEmbeddingFormat::Float32, RagEmbeddingFormat::Float16, RagEmbeddingFormat::Int8}) {
+        const QStringList names = searchBenchmarkNames(format, sizes);
+        if (std::any_of(names.begin(), names.end(), [&](const QString& name) { return runner.selected(name); })) {
+            formats.append(format);
+        }
+    }
+    if (formats.isEmpty() || count <= 0) {
+        return;
+    }
+
+    VectorGenerator generator(dimension, 256, 11);
+    std::vector<std::vector<float>> vectors;
+    vectors.reserve(static_cast<std::size_t>(count));
+    for (int i = 0; i < count; ++i) {
+        vectors.push_back(generator.next());
+    }
+    std::vector<std::vector<float>> queries;
+    for (int q = 0; q < queryCount; ++q) {
+        queries.push_back(generator.next(0.5f));
+    }
+    const std::vector<std::vector<int>> truth = exactNeighbours(vectors, queries, options.topK);
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        std::fprintf(stderr, "No temporary directory for the search benchmarks\n");
+        return;
+    }
+    for (const RagEmbeddingFormat format : std::as_const(formats)) {
+        const QString formatName = RagUtils::embeddingFormatName(format).toLower();
+        const QString dbPath = dir.filePath(QStringLiteral("search_%1.db").arg(formatName));
+        if (!buildSearchDatabase(dbPath, vectors, format)) {
+            continue;
+        }
+
+        RagSearchOptions exactSqlite;
+        exactSqlite.useAnnIndex = false;
+        exactSqlite.useVectorFile = false;
+        exactSqlite.rescore = false;
+        runSearch(runner, QStringLiteral("search/exact_sqlite/%1/%2").arg(formatName, sizes), dbPath, exactSqlite,
+                  queries, truth);
+
+        RagUtils::updateVectorFile(dbPath);
+        RagSearchOptions exactMapped = exactSqlite;
+        exactMapped.useVectorFile = true;
+        runSearch(runner, QStringLiteral("search/exact_vector_file/%1/%2").arg(formatName, sizes), dbPath,
+                  exactMapped, queries, truth);
+        if (format != RagEmbeddingFormat::Float32) {
+            RagSearchOptions rescored = exactMapped;
+            rescored.rescore = true;
+            runSearch(runner, QStringLiteral("search/exact_rescored/%1/%2").arg(formatName, sizes), dbPath, rescored,
+                      queries, truth);
+        }
+
+        QElapsedTimer buildTimer;
+        buildTimer.start();
+        RagUtils::updateAnnIndex(dbPath);
+        const double buildNs = static_cast<double>(buildTimer.nsecsElapsed());
+        const QString buildName = QStringLiteral("search/ann_build/%1/%2").arg(formatName, sizes);
+        if (runner.selected(buildName)) {
+            runner.report(buildName, 1, buildNs, buildNs, {{QStringLiteral("items_per_second"), count * 1e9 / buildNs}});
+        }
+        for (const int ef : {32, 64, 128, 256}) {
+            RagSearchOptions ann;
+            ann.ef = ef;
+            ann.rescore = format != RagEmbeddingFormat::Float32;
+            runSearch(runner, QStringLiteral("search/ann/%1/%2/ef%3").arg(formatName, sizes).arg(ef), dbPath, ann,
+                      queries, truth);
+        }
+    }
+}
+
+// ---- End-to-end indexing -------------------------------------------------
+
+// Stands in for the local provider: deterministic vectors from a hash of the text
+class SyntheticEmbeddingBackend : public ILLMBackend {
+public:
+    explicit SyntheticEmbeddingBackend(int dimension)
+        : m_dimension(dimension)
+    {
+    }
+
+    QString id() const override { return QStringLiteral("ollama"); }
+    QString name() const override { return QStringLiteral("Synthetic Embedding Backend"); }
+    QStringList availableModels() const override { return {}; }
+    QStringList availableEmbeddingModels() const override { return {QStringLiteral("synthetic")}; }
+    QFuture<QStringList> fetchModelList() override
+    {
+        return QtConcurrent::run([]() { return QStringList{}; });
+    }
+    LLMResult sendPrompt(const QString&, const QString&, double, int, const QString&, const QString&,
+                         const LLMMessage& = {}) override
+    {
+        return {};
+    }
+    EmbeddingResult getEmbedding(const QString&, const QString&, const QString& text) override
+    {
+        EmbeddingResult result;
+        result.vector = embed(text);
+        return result;
+    }
+    EmbeddingBatchResult getEmbeddings(const QString&, const QString&, const QStringList& texts) override
+    {
+        EmbeddingBatchResult result;
+        for (const QString& text : texts) {
+            result.vectors.push_back(embed(text));
+        }
+        return result;
+    }
+    QFuture<QString> generateImage(const QString&, const QString&, const QString&, const QString&,
+                                   const QString&, const QString&) override
+    {
+        return QFuture<QString>();
+    }
+
+private:
+    std::vector<float> embed(const QString& text) const
+    {
+        quint64 state = qHash(text) | 1u;
+        return uniformVector(m_dimension, state);
+    }
+
+    const int m_dimension;
+};
+
+void benchmarkIndexing(Runner& runner)
+{
+    const Options& options = runner.options();
+    const QString fullName = QStringLiteral("indexing/full");
+    const QString rerunName = QStringLiteral("indexing/unchanged_rerun");
+    if (!runner.selected(fullName) && !runner.selected(rerunName)) {
+        return;
+    }
+
+    QTemporaryDir corpus;
+    QTemporaryDir dbDir;
+    if (!corpus.isValid() || !dbDir.isValid()) {
+        std::fprintf(stderr, "No temporary directory for the indexing benchmarks\n");
+        return;
+    }
+    const int fileCount = options.quick ? qMin(options.indexFiles, 40) : options.indexFiles;
+    qint64 corpusBytes = 0;
+    for (int f = 0; f < fileCount; ++f) {
+        const FileType fileType = syntheticFileTypes().at(f % syntheticFileTypes().size());
+        const QString dirPath = corpus.filePath(QStringLiteral("dir%1").arg(f % 16));
+        QDir().mkpath(dirPath);
+        QFile file(QStringLiteral("%1/file%2.%3").arg(dirPath).arg(f).arg(fileExtension(fileType)));
+        if (!file.open(QIODevice::WriteOnly)) {
+            continue;
+        }
+        corpusBytes += file.write(syntheticDocument(fileType, 8192, static_cast<quint32>(f)).toUtf8());
+    }
+
+    LLMProviderRegistry::instance().registerBackend(std::make_shared<SyntheticEmbeddingBackend>(options.embeddingDimension));
+    EmbeddingCache::setSharedPath(QString());
+
+    const QString dbPath = dbDir.filePath(QStringLiteral("index.db"));
+    auto runIndexer = [&](bool clear, int& chunks) {
+        RagIndexerNode indexer;
+        indexer.setDirectoryPath(corpus.path());
+        indexer.setDatabasePath(dbPath);
+        indexer.setProviderId(QStringLiteral("ollama"));
+        indexer.setModelId(QStringLiteral("synthetic"));
+        indexer.setChunkSize(1000);
+        indexer.setChunkOverlap(200);
+        indexer.setClearDatabase(clear);
+        indexer.setResumeInterrupted(false);
+        const TokenList tokens = indexer.execute(TokenList{ExecutionToken{}});
+        const DataPacket output = tokens.empty() ? DataPacket() : tokens.front().data;
+        if (output.contains(QStringLiteral("__error"))) {
+            std::fprintf(stderr, "Indexing failed: %s\n", qPrintable(output.value(QStringLiteral("__error")).toString()));
+        }
+        chunks = output.value(QString::fromLatin1(RagIndexerNode::kOutputCount)).toInt();
+    };
+
+    qint64 iterations = 0;
+    double realNs = 0.0;
+    double cpuNs = 0.0;
+    int chunks = 0;
+    runner.measure([&]() { runIndexer(true, chunks); }, iterations, realNs, cpuNs);
+    if (runner.selected(fullName)) {
+        runner.report(fullName, iterations, realNs, cpuNs,
+                      {{QStringLiteral("files"), fileCount},
+                       {QStringLiteral("chunks"), chunks},
+                       {QStringLiteral("items_per_second"), chunks * 1e9 / realNs},
+                       {QStringLiteral("bytes_per_second"), static_cast<double>(corpusBytes) * 1e9 / realNs}});
+    }
+    if (runner.selected(rerunName)) {
+        runner.measure([&]() { runIndexer(false, chunks); }, iterations, realNs, cpuNs);
+        runner.report(rerunName, iterations, realNs, cpuNs,
+                      {{QStringLiteral("files"), fileCount},
+                       {QStringLiteral("files_per_second"), fileCount * 1e9 / realNs}});
+    }
+}
+
+const BenchmarkUsage kUsage {
+    "rag_benchmarks", "^scan/kernel", "a tenth of the data, for smoke runs",
+    "  --corpus=DIR              also chunk the supported files of DIR as a recorded corpus\n"
+    "  --scan_vectors=N,...      vector counts of the scan benchmarks (default 100000,1000000)\n"
+    "  --scan_dimensions=D,...   dimensions of the scan benchmarks (default 384,768,1536)\n"
+    "  --max_scan_bytes=B        skip scans whose rows exceed B bytes (default 4 GiB)\n"
+    "  --search_vectors=N        fragments in the search index (default 100000)\n"
+    "  --search_dimension=D      dimension of the search index (default 384)\n"
+    "  --search_queries=N        distinct queries per search benchmark (default 50)\n"
+    "  --top_k=K                 results per search, and k of recall@k (default 10)\n"
+    "  --index_files=N           files in the indexing corpus (default 400)\n"};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    Options options;
+    const auto parseFlag = [&options](const QString& key, const QString& value) {
+        if (key == QLatin1String("--corpus")) {
+            options.corpusPath = value;
+        } else if (key == QLatin1String("--scan_vectors")) {
+            options.scanVectors = parseIntList(value);
+        } else if (key == QLatin1String("--scan_dimensions")) {
+            options.scanDimensions = parseIntList(value);
+        } else if (key == QLatin1String("--max_scan_bytes")) {
+            options.maxScanBytes = value.toLongLong();
+        } else if (key == QLatin1String("--search_vectors")) {
+            options.searchVectors = value.toInt();
+        } else if (key == QLatin1String("--search_dimension")) {
+            options.searchDimension = value.toInt();
+        } else if (key == QLatin1String("--search_queries")) {
+            options.searchQueries = qMax(1, value.toInt());
+        } else if (key == QLatin1String("--top_k")) {
+            options.topK = qMax(1, value.toInt());
+        } else if (key == QLatin1String("--index_files")) {
+            options.indexFiles = qMax(1, value.toInt());
+        } else {
+            return false;
+        }
+        return true;
+    };
+    const int exitCode = parseArguments(app.arguments().mid(1), options, kUsage, parseFlag);
+    if (exitCode >= 0) {
+        return exitCode;
+    }
+
+    Runner runner(options);
+    runner.setContext(QStringLiteral("vector_kernel"), QString::fromLatin1(VectorKernels::activeKernel()));
+    benchmarkChunking(runner);
+    benchmarkScan(runner);
+    benchmarkSearch(runner);
+    benchmarkIndexing(runner);
+    return runner.finish();
+}
@@ -0,0 +1,388 @@
+//
+// Cognitive Pipeline Application - scripting runtime benchmarks
+//
+// Measures what one script execution costs besides the script itself: QuickJS
+// with a runtime per call, an engine per call on the shared thread runtime, a
+// reused engine and scripts that miss the bytecode cache; CREXX with a cold and
+// a cached compile; the Python Script node spawning a process and using a
+// persistent worker; ScriptDatabaseBridge inserts; and moving pipeline values
+// into and out of QuickJS by payload size. Results are written as Google
+// Benchmark style JSON like the RAG and engine benchmarks. Run with --help for
+// the options.
+//
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <utility>
+
+#include "BenchmarkRunner.h"
+#include "IScriptHost.h"
+#include "PythonScriptNode.h"
+#include "PythonWorkerPool.h"
+#include "QuickJSRuntime.h"
+#include "ScriptDatabaseBridge.h"
+#include "quickjs-libc.h"
+#if defined(CP_HAS_CREXX) && CP_HAS_CREXX
+#include "CrexxRuntime.h"
+#endif
+
+namespace {
+
+struct Options : BenchmarkOptions {
+    QList<int> payloadBytes {1024, 64 * 1024, 1024 * 1024};
+    QList<int> rowCounts {100, 1000, 10000};
+    QString python {QStringLiteral("python3")};
+};
+
+using Runner = BenchmarkRunnerFor<Options>;
+
+// Inputs from a map, outputs and errors dropped after counting
+class BenchmarkHost : public IScriptHost
+{
+public:
+    void log(const QString& message) override { g_sink = g_sink + message.size(); }
+    QVariant getInput(const QString& key) override
+    {
+        const auto it = inputs.find(key);
+        return it == inputs.end() ? QVariant() : it->second;
+    }
+    void setOutput(const QString& key, const QVariant& value) override
+    {
+        Q_UNUSED(key);
+        g_sink = g_sink + (value.isValid() ? 1.0 : 0.0);
+    }
+    void setError(const QString& message) override { lastError = message; }
+    QString getTempDir() const override { return QDir::tempPath(); }
+
+    std::map<QString, QVariant> inputs;
+    QString lastError;
+};
+
+// Fails loudly when a variant would measure an error path instead of the work
+bool checkedRun(bool ok, const BenchmarkHost& host, const QString& name)
+{
+    if (!ok || !host.lastError.isEmpty()) {
+        std::fprintf(stderr, "%s failed: %s\n", qPrintable(name), qPrintable(host.lastError));
+        return false;
+    }
+    return true;
+}
+
+// ---- Payloads ------------------------------------------------------------
+
+const QString kWordCountScript = QStringLiteral(
+    "const text = pipeline.input(\"text\");\n"
+    "const words = text.split(/\\s+/).filter(w => w.length > 0);\n"
+    "pipeline.output(\"count\", words.length);\n");
+
+QString sampleText(int characters)
+{
+    static const QString sentence = QStringLiteral("The quick brown fox jumps over the lazy dog. ");
+    QString text;
+    text.reserve(characters);
+    while (text.size() < characters) {
+        text += sentence;
+    }
+    text.truncate(characters);
+    return text;
+}
+
+// A pipeline value of about @p bytes in each shape scripts commonly receive
+QVariant payload(const QString& kind, int bytes)
+{
+    constexpr int kItemBytes = 64;
+    const int items = qMax(1, bytes / kItemBytes);
+    if (kind == QLatin1String("string")) {
+        return sampleText(bytes / static_cast<int>(sizeof(QChar)));
+    }
+    if (kind == QLatin1String("bytes")) {
+        return QByteArray(bytes, 'x');
+    }
+    const QString item = sampleText(kItemBytes / static_cast<int>(sizeof(QChar)));
+    if (kind == QLatin1String("list")) {
+        QVariantList list;
+        list.reserve(items);
+        for (int i = 0; i < items; ++i) {
+            list.append(item);
+        }
+        return list;
+    }
+    QVariantMap map;
+    for (int i = 0; i < items; ++i) {
+        map.insert(QStringLiteral("key%1").arg(i), item);
+    }
+    return map;
+}
+
+// ---- QuickJS -------------------------------------------------------------
+
+// Construct, evaluate and destroy a runtime of its own, with no pipeline bindings or
+// bytecode cache: what each execution paid before engines shared a thread runtime
+void rawRuntimeExecution(const QByteArray& source)
+{
+    JSRuntime* rt = JS_NewRuntime();
+    JSContext* ctx = JS_NewContext(rt);
+    js_std_add_helpers(ctx, 0, nullptr);
+    JSValue result = JS_Eval(ctx, source.constData(), static_cast<size_t>(source.size()), "<input>",
+                             JS_EVAL_TYPE_GLOBAL);
+    g_sink = g_sink + (JS_IsException(result) ? 0.0 : 1.0);
+    JS_FreeValue(ctx, result);
+    JS_FreeContext(ctx);
+    JS_FreeRuntime(rt);
+}
+
+void benchmarkQuickJSExecution(Runner& runner)
+{
+    BenchmarkHost host;
+    host.inputs[QStringLiteral("text")] = sampleText(256);
+
+    QuickJSRuntime warm;
+    if (!checkedRun(warm.execute(kWordCountScript, &host), host, QStringLiteral("quickjs/execute"))) {
+        return;
+    }
+
+    const QByteArray rawSource = QByteArrayLiteral(
+        "const text = \"") + sampleText(256).toUtf8() + QByteArrayLiteral(
+        "\";\nconst words = text.split(/\\s+/).filter(w => w.length > 0);\nwords.length;\n");
+    runner.run(QStringLiteral("quickjs/execute/runtime_per_call"), [&]() { rawRuntimeExecution(rawSource); });
+
+    runner.run(QStringLiteral("quickjs/execute/engine_per_call"), [&]() {
+        QuickJSRuntime engine;
+        g_sink = g_sink + (engine.execute(kWordCountScript, &host) ? 1.0 : 0.0);
+    });
+
+    QuickJSRuntime reused;
+    runner.run(QStringLiteral("quickjs/execute/reused_engine"), [&]() {
+        g_sink = g_sink + (reused.execute(kWordCountScript, &host) ? 1.0 : 0.0);
+    });
+
+    // A new comment each call changes the source hash, so every run parses and compiles
+    qint64 generation = 0;
+    runner.run(QStringLiteral("quickjs/execute/uncached_bytecode"), [&]() {
+        const QString script = QStringLiteral("// run %1\n").arg(++generation) + kWordCountScript;
+        g_sink = g_sink + (reused.execute(script, &host) ? 1.0 : 0.0);
+    });
+
+    runner.run(QStringLiteral("quickjs/execute/empty_script"), [&]() {
+        g_sink = g_sink + (reused.execute(QStringLiteral(";"), &host) ? 1.0 : 0.0);
+    });
+}
+
+// variantToJs() and jsToVariant() are private; scripts that only read a pin, pass it
+// back, or pass a lazy view back isolate them against the empty script above
+void benchmarkQuickJSConversion(Runner& runner)
+{
+    const QString readScript = QStringLiteral("pipeline.input(\"in\");");
+    const QString roundTripScript = QStringLiteral("pipeline.output(\"out\", pipeline.input(\"in\"));");
+    const QString viewScript = QStringLiteral("pipeline.output(\"out\", pipeline.inputView(\"in\"));");
+
+    QuickJSRuntime engine;
+    for (const QString& kind : {QStringLiteral("string"), QStringLiteral("bytes"), QStringLiteral("list"),
+                                QStringLiteral("map")}) {
+        for (const int bytes : runner.options().payloadBytes) {
+            const QString base = QStringLiteral("quickjs/convert/%1/%2").arg(kind).arg(bytes);
+            if (!runner.selected(base + QStringLiteral("/to_js")) && !runner.selected(base + QStringLiteral("/round_trip"))
+                && !runner.selected(base + QStringLiteral("/view_round_trip"))) {
+                continue;
+            }
+            BenchmarkHost host;
+            host.inputs[QStringLiteral("in")] = payload(kind, bytes);
+            if (!checkedRun(engine.execute(roundTripScript, &host), host, base)) {
+                continue;
+            }
+            runner.runThroughput(base + QStringLiteral("/to_js"), bytes, [&]() {
+                g_sink = g_sink + (engine.execute(readScript, &host) ? 1.0 : 0.0);
+            });
+            runner.runThroughput(base + QStringLiteral("/round_trip"), bytes, [&]() {
+                g_sink = g_sink + (engine.execute(roundTripScript, &host) ? 1.0 : 0.0);
+            });
+            if (kind == QLatin1String("list") || kind == QLatin1String("map")) {
+                runner.runThroughput(base + QStringLiteral("/view_round_trip"), bytes, [&]() {
+                    g_sink = g_sink + (engine.execute(viewScript, &host) ? 1.0 : 0.0);
+                });
+            }
+        }
+    }
+}
+
+// ---- CREXX ---------------------------------------------------------------
+
+void benchmarkCrexx(Runner& runner)
+{
+#if defined(CP_HAS_CREXX) && CP_HAS_CREXX
+    const QString script =
+        QStringLiteral("value = \"\"\n"
+                       "address pipeline \"GET input INTO :value\"\n"
+                       "result = value || \" beta\"\n"
+                       "address pipeline \"SET output :result\"\n");
+    BenchmarkHost host;
+    host.inputs[QStringLiteral("input")] = QStringLiteral("alpha");
+
+    CrexxRuntime runtime;
+    if (!checkedRun(runtime.execute(script, &host), host, QStringLiteral("crexx/execute"))) {
+        return;
+    }
+    runner.run(QStringLiteral("crexx/execute/cached"), [&]() {
+        g_sink = g_sink + (runtime.execute(script, &host) ? 1.0 : 0.0);
+    });
+
+    // A new comment each call misses the wrapped-source cache and compiles again
+    qint64 generation = 0;
+    runner.run(QStringLiteral("crexx/execute/cold"), [&]() {
+        const QString cold = QStringLiteral("/* run %1 %2 */\n")
+                                 .arg(QCoreApplication::applicationPid())
+                                 .arg(++generation)
+            + script;
+        g_sink = g_sink + (runtime.execute(cold, &host) ? 1.0 : 0.0);
+    });
+#else
+    Q_UNUSED(runner);
+#endif
+}
+
+// ---- Python --------------------------------------------------------------
+
+void benchmarkPython(Runner& runner)
+{
+    const QString base = QStringLiteral("python/execute");
+    if (!runner.selected(base + QStringLiteral("/spawn")) && !runner.selected(base + QStringLiteral("/persistent_worker"))) {
+        return;
+    }
+    const QString executable = runner.options().python;
+    if (QStandardPaths::findExecutable(executable).isEmpty() && !QFileInfo::exists(executable)) {
+        std::fprintf(stderr, "Skipping python benchmarks: %s not found\n", qPrintable(executable));
+        return;
+    }
+
+    ExecutionToken token;
+    token.data.insert(QStringLiteral("stdin"), sampleText(256));
+    const TokenList inputs {token};
+
+    for (const bool persistent : {false, true}) {
+        PythonScriptNode node;
+        node.loadState(QJsonObject{
+            {QStringLiteral("executable"), executable + QStringLiteral(" -u")},
+            {QStringLiteral("script"), QStringLiteral("import sys\nprint(len(sys.stdin.read().split()))\n")},
+            {QStringLiteral("persistentWorker"), persistent},
+        });
+        const QString name = base + (persistent ? QStringLiteral("/persistent_worker") : QStringLiteral("/spawn"));
+        const TokenList first = node.execute(inputs);
+        if (first.empty() || first.front().data.contains(QStringLiteral("__error"))) {
+            std::fprintf(stderr, "%s failed: %s\n", qPrintable(name),
+                         first.empty() ? "no output"
+                                       : qPrintable(first.front().data.value(QStringLiteral("__error")).toString()));
+            continue;
+        }
+        runner.run(name, [&]() { g_sink = g_sink + static_cast<double>(node.execute(inputs).size()); });
+    }
+    PythonWorkerPool::shutdown();
+}
+
+// ---- SQLite bridge -------------------------------------------------------
+
+void benchmarkDatabaseBridge(Runner& runner)
+{
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        return;
+    }
+    ScriptDatabaseBridge bridge;
+    if (!bridge.connect(dir.filePath(QStringLiteral("bench.db")))) {
+        std::fprintf(stderr, "Skipping sqlite benchmarks: cannot open a database\n");
+        return;
+    }
+    bridge.exec(QStringLiteral("CREATE TABLE rows (id INTEGER, name TEXT, score REAL)"));
+    const QString insert = QStringLiteral("INSERT INTO rows (id, name, score) VALUES (?, ?, ?)");
+
+    for (const int rows : runner.options().rowCounts) {
+        QVariantList batch;
+        batch.reserve(rows);
+        for (int i = 0; i < rows; ++i) {
+            batch.append(QVariant(QVariantList{i, QStringLiteral("row %1").arg(i), i * 0.5}));
+        }
+        const auto rowsPerSecond = [rows](double realNs) { return static_cast<double>(rows) * 1e9 / realNs; };
+        const auto insertRows = [&](const QString& mode, const std::function<void()>& fn) {
+            const QString name = QStringLiteral("sqlite/insert/%1/%2").arg(mode).arg(rows);
+            if (!runner.selected(name)) {
+                return;
+            }
+            qint64 iterations = 0;
+            double realNs = 0.0;
+            double cpuNs = 0.0;
+            runner.measure([&]() {
+                fn();
+                bridge.exec(QStringLiteral("DELETE FROM rows"));
+            }, iterations, realNs, cpuNs);
+            runner.report(name, iterations, realNs, cpuNs,
+                          QJsonObject{{QStringLiteral("rows_per_second"), rowsPerSecond(realNs)}});
+        };
+
+        insertRows(QStringLiteral("exec_per_row"), [&]() {
+            for (const QVariant& row : std::as_const(batch)) {
+                g_sink = g_sink + (bridge.exec(insert, row.toList()).isObject() ? 1.0 : 0.0);
+            }
+        });
+        insertRows(QStringLiteral("exec_in_transaction"), [&]() {
+            bridge.begin();
+            for (const QVariant& row : std::as_const(batch)) {
+                g_sink = g_sink + (bridge.exec(insert, row.toList()).isObject() ? 1.0 : 0.0);
+            }
+            bridge.commit();
+        });
+        insertRows(QStringLiteral("exec_many"), [&]() {
+            g_sink = g_sink + (bridge.execMany(insert, batch).isObject() ? 1.0 : 0.0);
+        });
+    }
+}
+
+const BenchmarkUsage kUsage {
+    "scripting_benchmarks", "^quickjs/execute", "small payloads and row counts only, for smoke runs",
+    "  --payload_bytes=B,...     payload sizes of the conversion benchmarks (default 1024,65536,1048576)\n"
+    "  --rows=N,...              rows per SQLite insert batch (default 100,1000,10000)\n"
+    "  --python=EXE              interpreter for the Python Script node (default python3)\n"};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    Options options;
+    const auto parseFlag = [&options](const QString& key, const QString& value) {
+        if (key == QLatin1String("--payload_bytes")) {
+            options.payloadBytes = parseIntList(value);
+        } else if (key == QLatin1String("--rows")) {
+            options.rowCounts = parseIntList(value);
+        } else if (key == QLatin1String("--python")) {
+            options.python = value;
+        } else {
+            return false;
+        }
+        return true;
+    };
+    const int exitCode = parseArguments(app.arguments().mid(1), options, kUsage, parseFlag);
+    if (exitCode >= 0) {
+        return exitCode;
+    }
+    if (options.quick) {
+        capList(options.payloadBytes, 64 * 1024);
+        capList(options.rowCounts, 1000);
+    }
+
+    Runner runner(options);
+    runner.setContext(QStringLiteral("quickjs_version"), QString::fromLatin1(JS_GetVersion()));
+    benchmarkQuickJSExecution(runner);
+    benchmarkQuickJSConversion(runner);
+    benchmarkCrexx(runner);
+    benchmarkPython(runner);
+    benchmarkDatabaseBridge(runner);
+    return runner.finish();
+}
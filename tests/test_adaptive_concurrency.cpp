@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <QElapsedTimer>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "ai/registry/AdaptiveConcurrencyLimiter.h"
+
+namespace {
+
+using Outcome = AdaptiveConcurrencyLimiter::Outcome;
+using std::chrono::milliseconds;
+
+const QString kProvider = QStringLiteral("adaptive-test");
+const QString kModel = QStringLiteral("model");
+
+std::vector<AdaptiveConcurrencyLimiter::Slot> fill(AdaptiveConcurrencyLimiter& limiter, int count)
+{
+    std::vector<AdaptiveConcurrencyLimiter::Slot> slots;
+    for (int i = 0; i < count; ++i) {
+        slots.push_back(limiter.acquire(kProvider, kModel));
+    }
+    return slots;
+}
+
+} // namespace
+
+TEST(AdaptiveConcurrencyTest, GrowsWhileSaturatedAndLatencyIsFlat)
+{
+    AdaptiveConcurrencyLimiter limiter;
+    auto slots = fill(limiter, static_cast<int>(AdaptiveConcurrencyLimiter::kInitialLimit));
+    for (int i = 0; i < 20; ++i) {
+        slots.front().record(Outcome::Success, milliseconds(100));
+    }
+    const auto snapshot = limiter.snapshot(kProvider, kModel);
+    EXPECT_GE(snapshot.limit, 6.0);
+    EXPECT_EQ(snapshot.inFlight, 4);
+    EXPECT_EQ(snapshot.p50Ms, 100);
+
+    // The extra room is usable straight away
+    AdaptiveConcurrencyLimiter::Slot extra = limiter.acquire(kProvider, kModel);
+    EXPECT_TRUE(extra);
+}
+
+TEST(AdaptiveConcurrencyTest, IdleCapacityAndLatencySpikesDoNotGrowTheLimit)
+{
+    AdaptiveConcurrencyLimiter limiter;
+    {
+        AdaptiveConcurrencyLimiter::Slot single = limiter.acquire(kProvider, kModel);
+        for (int i = 0; i < 20; ++i) {
+            single.record(Outcome::Success, milliseconds(100));
+        }
+    }
+    EXPECT_DOUBLE_EQ(limiter.snapshot(kProvider, kModel).limit, AdaptiveConcurrencyLimiter::kInitialLimit);
+
+    auto slots = fill(limiter, 4);
+    slots.front().record(Outcome::Success, milliseconds(1000));
+    EXPECT_DOUBLE_EQ(limiter.snapshot(kProvider, kModel).limit, AdaptiveConcurrencyLimiter::kInitialLimit);
+}
+
+TEST(AdaptiveConcurrencyTest, ThrottlingHalvesTheLimitOncePerBurst)
+{
+    AdaptiveConcurrencyLimiter limiter;
+    auto slots = fill(limiter, 4);
+    slots[0].record(Outcome::Throttled, milliseconds(50));
+    slots[1].record(Outcome::Throttled, milliseconds(50));
+    slots[2].record(Outcome::Ignored, milliseconds(50));
+
+    const auto snapshot = limiter.snapshot(kProvider, kModel);
+    EXPECT_DOUBLE_EQ(snapshot.limit, 2.0);
+    EXPECT_EQ(snapshot.throttles, 2u);
+}
+
+TEST(AdaptiveConcurrencyTest, CallersOverTheLimitWaitForASlot)
+{
+    AdaptiveConcurrencyLimiter limiter;
+    auto slots = fill(limiter, 4);
+
+    const CancellationToken cancellation = CancellationToken::create();
+    std::thread canceller([cancellation] {
+        std::this_thread::sleep_for(milliseconds(100));
+        cancellation.cancel();
+    });
+    QElapsedTimer timer;
+    timer.start();
+    EXPECT_FALSE(limiter.acquire(kProvider, kModel, cancellation));
+    EXPECT_LT(timer.elapsed(), 1000);
+    canceller.join();
+
+    // Other models have their own limit
+    EXPECT_TRUE(limiter.acquire(kProvider, QStringLiteral("other")));
+
+    std::thread releaser([&slots] {
+        std::this_thread::sleep_for(milliseconds(100));
+        slots.pop_back();
+    });
+    EXPECT_TRUE(limiter.acquire(kProvider, kModel));
+    releaser.join();
+}
+
+TEST(AdaptiveConcurrencyTest, CeilingCapsEveryModelOfTheProvider)
+{
+    AdaptiveConcurrencyLimiter limiter;
+    auto slots = fill(limiter, 4);
+    limiter.setCeiling(kProvider, 2);
+    EXPECT_DOUBLE_EQ(limiter.snapshot(kProvider, kModel).limit, 2.0);
+
+    // Saturated, flat latency no longer grows the limit past the ceiling
+    for (int i = 0; i < 20; ++i) {
+        slots.front().record(Outcome::Success, milliseconds(100));
+    }
+    EXPECT_DOUBLE_EQ(limiter.snapshot(kProvider, kModel).limit, 2.0);
+
+    // Models seen for the first time start under the ceiling too
+    auto other = limiter.acquire(kProvider, QStringLiteral("other"));
+    EXPECT_DOUBLE_EQ(limiter.snapshot(kProvider, QStringLiteral("other")).limit, 2.0);
+
+    limiter.setCeiling(kProvider, 0);
+    for (int i = 0; i < 20; ++i) {
+        slots.front().record(Outcome::Success, milliseconds(100));
+    }
+    EXPECT_GT(limiter.snapshot(kProvider, kModel).limit, 2.0);
+}
@@ -135,3 +135,41 @@ TEST_F(AnthropicFoundationTest, CredentialPriority_EnvVarShouldWin) {
     // This will likely return empty or the file key depending on current implementation.
     EXPECT_EQ(resultKey, envKey) << "Environment variable should have higher priority than accounts.json";
 }
+
+/**
+ * @test Verify that cached accounts.json keys are replaced when credentials are saved.
+ */
+TEST_F(AnthropicFoundationTest, CredentialCacheFollowsSaves) {
+#if defined(Q_OS_MAC)
+    const QString baseDir = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation);
+#else
+    const QString baseDir = QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation);
+#endif
+    const QString filePath = QDir(baseDir).filePath("CognitivePipelines/accounts.json");
+
+    const bool hadFile = QFile::exists(filePath);
+    const QString backupPath = filePath + ".bak";
+    if (hadFile) {
+        QFile::remove(backupPath);
+        QFile::copy(filePath, backupPath);
+    }
+
+    auto& registry = LLMProviderRegistry::instance();
+    const QString provider = QStringLiteral("cp-cache-test");
+    ASSERT_TRUE(registry.saveCredentials({{provider, QStringLiteral("first-key")}}));
+    const QString first = registry.getCredential(provider);
+    // Served from memory now, and replaced once a save writes the file
+    const QString cached = registry.getCredential(provider);
+    ASSERT_TRUE(registry.saveCredentials({{provider, QStringLiteral("second-key")}}));
+    const QString second = registry.getCredential(provider);
+
+    QFile::remove(filePath);
+    if (hadFile) {
+        QFile::rename(backupPath, filePath);
+    }
+    registry.invalidateCredentials();
+
+    EXPECT_EQ(first, QStringLiteral("first-key"));
+    EXPECT_EQ(cached, QStringLiteral("first-key"));
+    EXPECT_EQ(second, QStringLiteral("second-key"));
+}
@@ -0,0 +1,290 @@
+#include <gtest/gtest.h>
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtConcurrent>
+
+#include <atomic>
+
+#include "ai/backends/AttachmentPreprocessor.h"
+#include "ai/backends/AttachmentStore.h"
+#include "ai/backends/JsonPayload.h"
+#include "ai/backends/JsonReader.h"
+#include "ai/backends/VisionRequestPacker.h"
+
+namespace {
+
+LLMAttachment pdf(const QByteArray& data)
+{
+    return LLMAttachment{QStringLiteral("application/pdf"), data};
+}
+
+QByteArray png(int width, int height)
+{
+    // A gradient with some texture, so PNG can't squeeze it to nothing
+    QImage image(width, height, QImage::Format_RGB32);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            image.setPixel(x, y, qRgb(x % 256, y % 256, (x * y) % 251));
+        }
+    }
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "PNG");
+    return data;
+}
+
+} // namespace
+
+TEST(AttachmentStoreTest, UploadsEachContentOncePerProviderAndKey)
+{
+    AttachmentStore store(4);
+    int calls = 0;
+    const auto upload = [&](const LLMAttachment&) { return QStringLiteral("file_%1").arg(++calls); };
+
+    const LLMAttachment report = pdf(QByteArray("report bytes"));
+    EXPECT_EQ(store.reference(QStringLiteral("anthropic"), QStringLiteral("k1"), report, 0, upload),
+              QStringLiteral("file_1"));
+    EXPECT_EQ(store.reference(QStringLiteral("anthropic"), QStringLiteral("k1"), pdf(QByteArray("report bytes")), 0,
+                              upload),
+              QStringLiteral("file_1"));
+    EXPECT_EQ(calls, 1);
+
+    // Another account or provider cannot see the file; other content is a new upload
+    EXPECT_EQ(store.reference(QStringLiteral("anthropic"), QStringLiteral("k2"), report, 0, upload),
+              QStringLiteral("file_2"));
+    EXPECT_EQ(store.reference(QStringLiteral("google"), QStringLiteral("k1"), report, 0, upload),
+              QStringLiteral("file_3"));
+    EXPECT_EQ(store.reference(QStringLiteral("anthropic"), QStringLiteral("k1"), pdf(QByteArray("other bytes")), 0,
+                              upload),
+              QStringLiteral("file_4"));
+
+    // Small attachments stay inline
+    EXPECT_TRUE(store.reference(QStringLiteral("anthropic"), QStringLiteral("k1"), pdf(QByteArray("abc")), 0,
+                                upload).isEmpty());
+    EXPECT_EQ(calls, 4);
+    EXPECT_EQ(store.uploads(), 4);
+
+    store.forget(QStringLiteral("anthropic"), QStringLiteral("k1"), report);
+    EXPECT_EQ(store.reference(QStringLiteral("anthropic"), QStringLiteral("k1"), report, 0, upload),
+              QStringLiteral("file_5"));
+}
+
+TEST(AttachmentStoreTest, RemembersFailedUploads)
+{
+    AttachmentStore store(1);
+    int calls = 0;
+    const auto failing = [&](const LLMAttachment&) { ++calls; return QString(); };
+
+    const LLMAttachment report = pdf(QByteArray("report bytes"));
+    EXPECT_TRUE(store.reference(QStringLiteral("google"), QStringLiteral("k"), report, 1000, failing).isEmpty());
+    EXPECT_TRUE(store.reference(QStringLiteral("google"), QStringLiteral("k"), report, 1000, failing).isEmpty());
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(store.uploads(), 0);
+
+    AttachmentStore disabled(-1);
+    EXPECT_FALSE(disabled.shouldUpload(report));
+}
+
+TEST(AttachmentStoreTest, ContentKeysShareReferencesWithoutSizeThreshold)
+{
+    AttachmentStore store(1024);
+    int calls = 0;
+    const auto create = [&]() { return QStringLiteral("cachedContents/%1").arg(++calls); };
+    const QByteArray prefix = QCryptographicHash::hash("system prompt", QCryptographicHash::Sha256);
+
+    EXPECT_EQ(store.reference(QStringLiteral("google"), QStringLiteral("k"), prefix, 60000, create),
+              QStringLiteral("cachedContents/1"));
+    EXPECT_EQ(store.reference(QStringLiteral("google"), QStringLiteral("k"), prefix, 60000, create),
+              QStringLiteral("cachedContents/1"));
+    EXPECT_EQ(calls, 1);
+
+    // A cache the provider rejected is made again on the next request
+    store.forget(QStringLiteral("google"), QStringLiteral("k"), prefix);
+    EXPECT_EQ(store.reference(QStringLiteral("google"), QStringLiteral("k"), prefix, 60000, create),
+              QStringLiteral("cachedContents/2"));
+    EXPECT_EQ(store.uploads(), 2);
+
+    AttachmentStore disabled(-1);
+    EXPECT_TRUE(disabled.reference(QStringLiteral("google"), QStringLiteral("k"), prefix, 60000, create).isEmpty());
+    EXPECT_EQ(calls, 2);
+}
+
+TEST(AttachmentPreprocessorTest, ShrinksLargeImagesOnceAndLeavesOthersAlone)
+{
+    AttachmentPreprocessor preprocessor;
+    AttachmentPreprocessor::Options options;
+    options.maxDimension = 512;
+
+    const LLMAttachment page{QStringLiteral("image/png"), png(1600, 1000)};
+    const LLMAttachment prepared = preprocessor.prepare(page, options);
+    EXPECT_EQ(prepared.mimeType, QStringLiteral("image/jpeg"));
+    EXPECT_LT(prepared.data.size(), page.data.size());
+    const QImage decoded = QImage::fromData(prepared.data);
+    EXPECT_EQ(decoded.width(), 512);
+    EXPECT_EQ(decoded.height(), 320);
+    EXPECT_EQ(preprocessor.conversions(), 1);
+
+    // The same content again comes from the cache
+    const LLMAttachment again = preprocessor.prepare(LLMAttachment{QStringLiteral("image/png"), png(1600, 1000)},
+                                                     options);
+    EXPECT_EQ(again.data, prepared.data);
+    EXPECT_EQ(preprocessor.conversions(), 1);
+
+    // Other options are another conversion
+    options.quality = 40;
+    EXPECT_LT(preprocessor.prepare(page, options).data.size(), prepared.data.size());
+    EXPECT_EQ(preprocessor.conversions(), 2);
+
+    // Documents, undecodable data and images that would grow pass through unchanged
+    const LLMAttachment document = pdf(QByteArray("%PDF-1.7 report"));
+    EXPECT_EQ(preprocessor.prepare(document, options).data, document.data);
+    const LLMAttachment broken{QStringLiteral("image/png"), QByteArray("not a png")};
+    EXPECT_EQ(preprocessor.prepare(broken, options).data, broken.data);
+    const LLMAttachment icon{QStringLiteral("image/png"), png(2, 2)};
+    const LLMAttachment keptIcon = preprocessor.prepare(icon, options);
+    EXPECT_EQ(keptIcon.mimeType, icon.mimeType);
+    EXPECT_EQ(keptIcon.data, icon.data);
+}
+
+TEST(VisionRequestPackerTest, ConcurrentPromptsShareOneRequestAndGetTheirOwnSections)
+{
+    VisionRequestPacker packer(5000);
+    VisionRequestPacker::Limits limits;
+    limits.maxImages = 3;
+    std::atomic<int> calls {0};
+    std::atomic<int> packedAttachments {0};
+    // Echoes the prompt, whose item sections hold each caller's own prompt
+    const VisionRequestPacker::Run run = [&](const QString& prompt, const LLMMessage& message, int items) {
+        ++calls;
+        packedAttachments = static_cast<int>(message.attachments.size());
+        LLMResult result;
+        result.content = prompt;
+        result.usage.inputTokens = items * 100;
+        EXPECT_EQ(items, 3);
+        return result;
+    };
+
+    // The group fills at three images, so nobody waits out the window
+    QList<QFuture<std::optional<LLMResult>>> results;
+    for (int i = 1; i <= 3; ++i) {
+        results.append(QtConcurrent::run([&, i]() {
+            LLMMessage message;
+            message.attachments.append(LLMAttachment{QStringLiteral("image/png"), QByteArray::number(i)});
+            return packer.submit(QStringLiteral("Transcribe page %1").arg(i), message, 10, limits, run);
+        }));
+    }
+    for (int i = 0; i < results.size(); ++i) {
+        const std::optional<LLMResult> answer = results[i].result();
+        ASSERT_TRUE(answer.has_value());
+        EXPECT_EQ(answer->content, QStringLiteral("Transcribe page %1").arg(i + 1));
+        EXPECT_EQ(answer->usage.inputTokens, 100);
+    }
+    EXPECT_EQ(calls.load(), 1);
+    EXPECT_EQ(packedAttachments.load(), 3);
+
+    // A prompt alone is left to its caller
+    VisionRequestPacker solo(0);
+    LLMMessage message;
+    message.attachments.append(LLMAttachment{QStringLiteral("image/png"), QByteArray("page")});
+    EXPECT_FALSE(solo.submit(QStringLiteral("Transcribe"), message, 10, limits, run).has_value());
+    EXPECT_EQ(calls.load(), 1);
+}
+
+TEST(VisionRequestPackerTest, SplitsAnswersOnlyWhenEveryMarkerIsInOrder)
+{
+    EXPECT_EQ(VisionRequestPacker::splitSections(
+                  QStringLiteral("Sure.\n=== ITEM 1 ===\nfirst\n\n=== ITEM 2 ===\nsecond\n"), 2),
+              QStringList({QStringLiteral("first"), QStringLiteral("second")}));
+    EXPECT_TRUE(VisionRequestPacker::splitSections(QStringLiteral("=== ITEM 1 ===\nfirst"), 2).isEmpty());
+    EXPECT_TRUE(VisionRequestPacker::splitSections(
+                    QStringLiteral("=== ITEM 2 ===\nsecond\n=== ITEM 1 ===\nfirst"), 2).isEmpty());
+
+    const QString prompt = VisionRequestPacker::packedPrompt({QStringLiteral("a"), QStringLiteral("b")}, {1, 2});
+    EXPECT_TRUE(prompt.contains(QStringLiteral("item 1 is attachment 1, item 2 is attachments 2-3")));
+    EXPECT_EQ(VisionRequestPacker::splitSections(prompt, 2), QStringList({QStringLiteral("a"), QStringLiteral("b")}));
+}
+
+TEST(JsonPayloadTest, SplicesBase64InPlaceOfPlaceholders)
+{
+    QByteArray large(300 * 1024, '\0');
+    for (int i = 0; i < large.size(); ++i) {
+        large[i] = static_cast<char>(i * 31);
+    }
+    const QByteArray small("hi");
+
+    JsonPayload payload;
+    QJsonObject image;
+    image.insert(QStringLiteral("url"), QStringLiteral("data:image/png;base64,") + payload.base64(large));
+    QJsonObject root;
+    root.insert(QStringLiteral("z_small"), payload.base64(small));
+    root.insert(QStringLiteral("a_parts"), QJsonArray{image, QStringLiteral("text")});
+
+    QJsonObject expected;
+    QJsonObject expectedImage;
+    expectedImage.insert(QStringLiteral("url"), QStringLiteral("data:image/png;base64,")
+                                                    + QString::fromLatin1(large.toBase64()));
+    expected.insert(QStringLiteral("z_small"), QString::fromLatin1(small.toBase64()));
+    expected.insert(QStringLiteral("a_parts"), QJsonArray{expectedImage, QStringLiteral("text")});
+
+    const std::string body = payload.serialize(root);
+    EXPECT_EQ(QByteArray::fromStdString(body), QJsonDocument(expected).toJson(QJsonDocument::Compact));
+}
+
+TEST(JsonReaderTest, WalksMembersAndReadsFloatArrays)
+{
+    const QByteArray json(R"({"object": "list", "skip": {"a": [1, {"b": "]}"}], "c": null},
+        "data": [{"index": 1, "embedding": [0.5, -2, 1e-3]}, {"embedding": [], "index": 0}],
+        "text": "line\nquote\" \u00e9\ud83d\ude00", "ok": true})");
+
+    JsonReader reader(json);
+    ASSERT_TRUE(reader.enterObject());
+    QByteArrayView key;
+    QStringList keys;
+    std::vector<float> floats;
+    QList<int> indexes;
+    QString text;
+    while (reader.nextKey(key)) {
+        keys.append(QString::fromUtf8(key));
+        if (key == "data") {
+            ASSERT_TRUE(reader.enterArray());
+            while (reader.nextElement()) {
+                ASSERT_TRUE(reader.enterObject());
+                QByteArrayView field;
+                while (reader.nextKey(field)) {
+                    int index = -1;
+                    if (field == "index") {
+                        ASSERT_TRUE(reader.readInt(index));
+                        indexes.append(index);
+                    } else {
+                        ASSERT_TRUE(reader.readFloats(floats));
+                    }
+                }
+            }
+        } else if (key == "text") {
+            ASSERT_TRUE(reader.readString(text));
+        } else {
+            ASSERT_TRUE(reader.skipValue());
+        }
+    }
+    EXPECT_FALSE(reader.hasError());
+    EXPECT_EQ(keys, QStringList({QStringLiteral("object"), QStringLiteral("skip"), QStringLiteral("data"),
+                                 QStringLiteral("text"), QStringLiteral("ok")}));
+    EXPECT_EQ(indexes, QList<int>({1, 0}));
+    EXPECT_EQ(floats, std::vector<float>({0.5f, -2.0f, 1e-3f}));
+    EXPECT_EQ(text, QStringLiteral("line\nquote\" ") + QChar(0xe9) + QString::fromUtf8("\xf0\x9f\x98\x80"));
+
+    JsonReader truncated(QByteArrayView("{\"data\": [1, 2"));
+    ASSERT_TRUE(truncated.enterObject());
+    ASSERT_TRUE(truncated.nextKey(key));
+    std::vector<float> partial;
+    EXPECT_FALSE(truncated.readFloats(partial));
+    EXPECT_TRUE(truncated.hasError());
+    EXPECT_FALSE(truncated.nextKey(key));
+    EXPECT_FALSE(truncated.errorString().isEmpty());
+}
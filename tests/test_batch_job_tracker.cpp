@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include <QFuture>
+#include <QStringList>
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include "ai/backends/BatchJobTracker.h"
+
+namespace {
+
+// Answers each request with its prompt upper-cased once the job has been polled pollsToFinish times
+class FakeBatchBackend : public ILLMBackend {
+public:
+    QString id() const override { return QStringLiteral("fake-batch"); }
+    QString name() const override { return QStringLiteral("Fake Batch"); }
+    QStringList availableModels() const override { return {}; }
+    QStringList availableEmbeddingModels() const override { return {}; }
+    QFuture<QStringList> fetchModelList() override { return {}; }
+    LLMResult sendPrompt(const QString&, const QString&, double, int, const QString&, const QString&,
+                         const LLMMessage& = {}) override {
+        return {};
+    }
+    EmbeddingResult getEmbedding(const QString&, const QString&, const QString&) override { return {}; }
+    QFuture<QString> generateImage(const QString&, const QString&, const QString&, const QString&,
+                                   const QString&, const QString&) override {
+        return {};
+    }
+
+    bool supportsBatch() const override { return true; }
+
+    LLMBatchStatus submitBatch(const QString&, const QList<LLMBatchRequest>& requests) override {
+        std::lock_guard lock(mutex);
+        LLMBatchStatus status;
+        if (rejectSubmit) {
+            status.hasError = true;
+            status.errorMsg = QStringLiteral("quota exceeded");
+            return status;
+        }
+        status.jobId = QStringLiteral("job-%1").arg(submitted.size());
+        submitted.append(requests);
+        return status;
+    }
+
+    LLMBatchStatus pollBatch(const QString&, const QString& jobId) override {
+        std::lock_guard lock(mutex);
+        LLMBatchStatus status;
+        status.jobId = jobId;
+        if (++polls < pollsToFinish) {
+            return status;
+        }
+        status.finished = true;
+        const int index = jobId.mid(4).toInt();
+        for (const LLMBatchRequest& request : submitted.value(index)) {
+            LLMResult result;
+            result.content = request.userPrompt.toUpper();
+            status.results.insert(request.customId, result);
+        }
+        return status;
+    }
+
+    void cancelBatch(const QString&, const QString& jobId) override {
+        std::lock_guard lock(mutex);
+        cancelled.append(jobId);
+    }
+
+    std::mutex mutex;
+    QList<QList<LLMBatchRequest>> submitted;
+    QStringList cancelled;
+    int polls {0};
+    int pollsToFinish {2};
+    bool rejectSubmit {false};
+};
+
+LLMBatchRequest prompt(const QString& text, const QString& model = QStringLiteral("m"))
+{
+    LLMBatchRequest request;
+    request.modelName = model;
+    request.userPrompt = text;
+    return request;
+}
+
+} // namespace
+
+TEST(BatchJobTrackerTest, GroupsRequestsIntoOneJobPerModelAndDemultiplexes)
+{
+    FakeBatchBackend backend;
+    BatchJobTracker tracker(200, 20);
+
+    QFuture<LLMResult> a = tracker.submit(&backend, QStringLiteral("key"), prompt(QStringLiteral("alpha")), {});
+    QFuture<LLMResult> b = tracker.submit(&backend, QStringLiteral("key"), prompt(QStringLiteral("beta")), {});
+    QFuture<LLMResult> c = tracker.submit(&backend, QStringLiteral("key"),
+                                          prompt(QStringLiteral("gamma"), QStringLiteral("other")), {});
+    EXPECT_EQ(tracker.pendingRequests(), 3);
+
+    EXPECT_FALSE(a.result().hasError);
+    EXPECT_EQ(a.result().content, QStringLiteral("ALPHA"));
+    EXPECT_EQ(b.result().content, QStringLiteral("BETA"));
+    EXPECT_EQ(c.result().content, QStringLiteral("GAMMA"));
+
+    std::lock_guard lock(backend.mutex);
+    ASSERT_EQ(backend.submitted.size(), 2);
+    EXPECT_EQ(backend.submitted[0].size() + backend.submitted[1].size(), 3);
+    EXPECT_EQ(tracker.activeJobs(), 0);
+    EXPECT_EQ(tracker.pendingRequests(), 0);
+}
+
+TEST(BatchJobTrackerTest, RejectedJobFailsEveryRequest)
+{
+    FakeBatchBackend backend;
+    backend.rejectSubmit = true;
+    BatchJobTracker tracker(20, 20);
+
+    QFuture<LLMResult> a = tracker.submit(&backend, QString(), prompt(QStringLiteral("alpha")), {});
+    QFuture<LLMResult> b = tracker.submit(&backend, QString(), prompt(QStringLiteral("beta")), {});
+
+    EXPECT_TRUE(a.result().hasError);
+    EXPECT_EQ(a.result().errorMsg, QStringLiteral("quota exceeded"));
+    EXPECT_TRUE(b.result().hasError);
+}
+
+TEST(BatchJobTrackerTest, CancelledCallerIsAnsweredAndAbandonedJobCancelled)
+{
+    FakeBatchBackend backend;
+    backend.pollsToFinish = 1000000;
+    BatchJobTracker tracker(20, 20);
+    const CancellationToken cancellation = CancellationToken::create();
+
+    QFuture<LLMResult> a = tracker.submit(&backend, QString(), prompt(QStringLiteral("alpha")), cancellation);
+    while (tracker.activeJobs() == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    cancellation.cancel();
+
+    EXPECT_TRUE(a.result().hasError);
+    EXPECT_EQ(tracker.activeJobs(), 0);
+    // The provider is told after the caller has been answered
+    for (int attempt = 0; attempt < 200; ++attempt) {
+        {
+            std::lock_guard lock(backend.mutex);
+            if (!backend.cancelled.isEmpty()) break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    std::lock_guard lock(backend.mutex);
+    EXPECT_EQ(backend.cancelled, QStringList{QStringLiteral("job-0")});
+}
+
+TEST(BatchJobTrackerTest, BackendWithoutBatchSupportFailsImmediately)
+{
+    class PlainBackend : public FakeBatchBackend {
+    public:
+        bool supportsBatch() const override { return false; }
+    } backend;
+    BatchJobTracker tracker(20, 20);
+
+    const LLMResult result = tracker.submit(&backend, QString(), prompt(QStringLiteral("alpha")), {}).result();
+    EXPECT_TRUE(result.hasError);
+    EXPECT_EQ(tracker.pendingRequests(), 0);
+}
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include <QBuffer>
+#include <QDataStream>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QVariant>
+
+#include "BlobHandle.h"
+#include "InputSignature.h"
+
+TEST(BlobHandleTest, ConvertsThroughQVariantLikeText)
+{
+    const BlobHandle blob = BlobHandle::fromText(QStringLiteral("héllo"), QStringLiteral("text/plain"),
+                                                 BlobHandle::Storage::Memory);
+    EXPECT_FALSE(blob.isSpilled());
+    EXPECT_EQ(blob.size(), QStringLiteral("héllo").toUtf8().size());
+
+    const QVariant value = QVariant::fromValue(blob);
+    EXPECT_EQ(value.toString(), QStringLiteral("héllo"));
+    EXPECT_EQ(value.toByteArray(), QStringLiteral("héllo").toUtf8());
+}
+
+TEST(BlobHandleTest, SpilledPayloadIsMappedAndRemovedWithLastHandle)
+{
+    const QByteArray payload(1 << 20, 'x');
+    QString spillPath;
+    {
+        const BlobHandle blob = BlobHandle::fromBytes(payload, QStringLiteral("application/octet-stream"),
+                                                      BlobHandle::Storage::Spill);
+        ASSERT_TRUE(blob.isSpilled());
+        spillPath = blob.filePath();
+        EXPECT_TRUE(QFile::exists(spillPath));
+        const BlobHandle copy = blob;
+        EXPECT_EQ(copy.view(), QByteArrayView(payload));
+        EXPECT_EQ(copy.view().data(), blob.view().data()); // one mapping shared by copies
+        EXPECT_EQ(blob.bytes(), payload);
+    }
+    // Nothing left behind once every handle is gone
+    EXPECT_FALSE(QFile::exists(spillPath));
+}
+
+TEST(BlobHandleTest, FileSnapshotIgnoresLaterEdits)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("doc.md"));
+    {
+        QFile file(path);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write("# Original\n");
+    }
+
+    const BlobHandle blob = BlobHandle::fromFile(path, QStringLiteral("text/markdown"));
+    ASSERT_FALSE(blob.isNull());
+    {
+        QFile file(path);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write("changed");
+    }
+    EXPECT_EQ(blob.text(), QStringLiteral("# Original\n"));
+    EXPECT_EQ(blob.mimeType(), QStringLiteral("text/markdown"));
+}
+
+TEST(BlobHandleTest, FileSnapshotsOfTheSameContentShareOneCopy)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QByteArray payload(256 * 1024, 'd');
+    const auto writeFile = [&](const QString& name, const QByteArray& bytes) {
+        QFile file(dir.filePath(name));
+        return file.open(QIODevice::WriteOnly) && file.write(bytes) == bytes.size() ? file.fileName() : QString();
+    };
+    const QString original = writeFile(QStringLiteral("data.txt"), payload);
+    const QString copy = writeFile(QStringLiteral("copy.txt"), payload);
+    ASSERT_FALSE(original.isEmpty());
+    ASSERT_FALSE(copy.isEmpty());
+
+    QString snapshotPath;
+    {
+        const BlobHandle first = BlobHandle::fromFile(original, QStringLiteral("text/plain"));
+        const BlobHandle again = BlobHandle::fromFile(copy, QStringLiteral("text/plain"));
+        ASSERT_FALSE(first.isNull());
+        snapshotPath = first.filePath();
+        EXPECT_EQ(again.filePath(), snapshotPath) << "known content shares the live snapshot";
+        EXPECT_EQ(again, first);
+
+        // Other content, or the same bytes under another MIME type, gets its own
+        const BlobHandle typed = BlobHandle::fromFile(copy, QStringLiteral("text/csv"));
+        EXPECT_NE(typed.filePath(), snapshotPath);
+        QByteArray changed = payload;
+        changed[10] = 'e';
+        const BlobHandle other = BlobHandle::fromFile(writeFile(QStringLiteral("other.txt"), changed),
+                                                      QStringLiteral("text/plain"));
+        EXPECT_NE(other.filePath(), snapshotPath);
+        EXPECT_NE(other, first);
+
+        // Rewriting the original leaves the snapshot as it was
+        writeFile(QStringLiteral("data.txt"), QByteArray("rewritten"));
+        EXPECT_EQ(again.view(), QByteArrayView(payload));
+    }
+    EXPECT_FALSE(QFile::exists(snapshotPath));
+}
+
+TEST(BlobHandleTest, SignaturesFollowContentNotIdentity)
+{
+    const QByteArray payload(64 * 1024, 'a');
+    const BlobHandle first = BlobHandle::fromBytes(payload, {}, BlobHandle::Storage::Spill);
+    const BlobHandle second = BlobHandle::fromBytes(payload, {}, BlobHandle::Storage::Memory);
+    QByteArray changed = payload;
+    changed[100] = 'b';
+    const BlobHandle third = BlobHandle::fromBytes(changed, {}, BlobHandle::Storage::Memory);
+
+    EXPECT_EQ(first, second);
+    EXPECT_NE(first, third);
+
+    const auto signatureOf = [](const BlobHandle& blob) {
+        return InputSignature::compute(QVariantMap{{QStringLiteral("doc"), QVariant::fromValue(blob)}});
+    };
+    EXPECT_EQ(signatureOf(first), signatureOf(second));
+    EXPECT_NE(signatureOf(first), signatureOf(third));
+}
+
+TEST(BlobHandleTest, RoundTripsThroughDataStream)
+{
+    const BlobHandle blob = BlobHandle::fromBytes(QByteArray("payload"), QStringLiteral("text/plain"));
+    QByteArray buffer;
+    {
+        QDataStream out(&buffer, QIODevice::WriteOnly);
+        out << QVariant::fromValue(blob);
+    }
+    QVariant restored;
+    {
+        QDataStream in(buffer);
+        in >> restored;
+        ASSERT_EQ(in.status(), QDataStream::Ok);
+    }
+    ASSERT_EQ(restored.metaType(), QMetaType::fromType<BlobHandle>());
+    EXPECT_EQ(restored.value<BlobHandle>(), blob);
+    EXPECT_EQ(restored.value<BlobHandle>().mimeType(), QStringLiteral("text/plain"));
+}
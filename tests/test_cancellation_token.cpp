@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+
+#include <QtConcurrent/QtConcurrent>
+
+#include "CancellationToken.h"
+
+TEST(CancellationTokenTest, CopiesShareStateAndDefaultNeverCancels)
+{
+    const CancellationToken never;
+    never.cancel();
+    EXPECT_FALSE(never.isCancelled());
+
+    const CancellationToken token = CancellationToken::create();
+    const CancellationToken copy = token;
+    EXPECT_FALSE(copy.isCancelled());
+    token.cancel();
+    EXPECT_TRUE(copy.isCancelled());
+}
+
+TEST(CancellationTokenTest, ScopesNestAndStayOnTheirThread)
+{
+    const CancellationToken outer = CancellationToken::create();
+    const CancellationToken inner = CancellationToken::create();
+    inner.cancel();
+
+    EXPECT_FALSE(CancellationToken::current().isCancelled());
+    {
+        const CancellationToken::Scope outerScope(outer);
+        {
+            const CancellationToken::Scope innerScope(inner);
+            EXPECT_TRUE(CancellationToken::current().isCancelled());
+            // Other threads only see the token when it is handed over explicitly
+            const bool seenElsewhere = QtConcurrent::run([]() {
+                return CancellationToken::current().isCancelled();
+            }).result();
+            EXPECT_FALSE(seenElsewhere);
+        }
+        EXPECT_FALSE(CancellationToken::current().isCancelled());
+        outer.cancel();
+        EXPECT_TRUE(CancellationToken::current().isCancelled());
+    }
+    EXPECT_FALSE(CancellationToken::current().isCancelled());
+}
+
+TEST(CancellationTokenTest, DueByPrefersTheDeadlineOverTheSlack)
+{
+    const CancellationToken undated;
+    EXPECT_EQ(undated.deadline(), CancellationToken::kNoDeadline);
+    EXPECT_EQ(undated.dueBy(500), 500);
+
+    const CancellationToken batch = CancellationToken::create(CancellationToken::kNoDeadline, 60000);
+    EXPECT_EQ(batch.dueBy(500), 60500);
+    EXPECT_EQ(batch.dueBy(CancellationToken::kNoDeadline - 10), CancellationToken::kNoDeadline);
+
+    const CancellationToken interactive = CancellationToken::create(2000, 60000);
+    EXPECT_EQ(interactive.deadline(), 2000);
+    EXPECT_EQ(interactive.dueBy(500), 2000);
+    EXPECT_EQ(interactive.dueBy(5000), 2000);
+}
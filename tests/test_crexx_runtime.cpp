@@ -120,6 +120,42 @@ TEST(CrexxRuntimeTest, NamedPinGetSerializesStructuredValues)
     EXPECT_EQ(host.outputs[QStringLiteral("json")].toString(), QStringLiteral("[\"one\",\"two\"]"));
 }
 
+TEST(CrexxRuntimeTest, StemAnchorsExchangeWholeLists)
+{
+    CrexxRuntime runtime;
+    CrexxMockScriptHost host;
+    QVariantList items;
+    for (int i = 1; i <= 200; ++i) {
+        items << QStringLiteral("item %1").arg(i);
+    }
+    host.inputs[QStringLiteral("items")] = items;
+
+    const QString script =
+        QStringLiteral("address pipeline \"GET items INTO :items.\"\n"
+                       "address pipeline \"SET count :items.0\"\n"
+                       "address pipeline \"SET echoed :items.\"\n");
+
+    const bool success = runtime.execute(script, &host);
+
+    ASSERT_TRUE(success) << (host.errors.empty() ? "" : host.errors.front().toStdString());
+    EXPECT_EQ(host.outputs[QStringLiteral("count")].toString(), QStringLiteral("200"));
+    const QStringList echoed = host.outputs[QStringLiteral("echoed")].toStringList();
+    ASSERT_EQ(echoed.size(), 200);
+    EXPECT_EQ(echoed.front(), QStringLiteral("item 1"));
+    EXPECT_EQ(echoed.back(), QStringLiteral("item 200"));
+}
+
+TEST(CrexxRuntimeTest, SetFromUnsetStemFails)
+{
+    CrexxRuntime runtime;
+    CrexxMockScriptHost host;
+
+    const bool success = runtime.execute(QStringLiteral("address pipeline \"SET out :missing.\"\n"), &host);
+
+    EXPECT_FALSE(success);
+    EXPECT_EQ(host.outputs.count(QStringLiteral("out")), 0u);
+}
+
 TEST(CrexxRuntimeTest, AddressErrorFailsExecution)
 {
     CrexxRuntime runtime;
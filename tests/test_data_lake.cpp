@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+
+#include <QEventLoop>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QTimer>
+
+#include <atomic>
+
+#include "test_app.h"
+#include <QtNodes/internal/Definitions.hpp>
+#include "DataLake.h"
+#include "ExecutionEngine.h"
+#include "ExecutionIdUtils.h"
+#include "ExecutionPlan.h"
+#include "NodeGraphModel.h"
+#include "TextInputNode.h"
+#include "ToolNodeDelegate.h"
+
+using namespace QtNodes;
+
+namespace {
+
+QVariantMap textBucket(int chars, QChar fill)
+{
+    return QVariantMap{{QStringLiteral("text"), QString(chars, fill)}};
+}
+
+DataPacket runToCompletion(ExecutionEngine& engine)
+{
+    DataPacket output;
+    bool finished = false;
+    QEventLoop loop;
+    auto conn = QObject::connect(&engine, &ExecutionEngine::pipelineFinished, &loop, [&](const DataPacket& packet) {
+        output = packet;
+        finished = true;
+        loop.quit();
+    });
+    QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+    engine.runPipeline();
+    if (!finished) loop.exec();
+    QObject::disconnect(conn);
+    EXPECT_TRUE(finished) << "Engine did not finish within timeout";
+    return output;
+}
+
+} // namespace
+
+TEST(DataLakeTest, SpillsLeastRecentlyWrittenBucketOverBudget)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+
+    DataLake lake({}, 3000);
+    lake.setSpillDirectory(dir.path());
+    const QUuid first = QUuid::createUuid();
+    const QUuid second = QUuid::createUuid();
+
+    lake.merge(first, textBucket(1000, QLatin1Char('a')));
+    EXPECT_EQ(lake.metrics().spilledBuckets, 0);
+    lake.merge(second, textBucket(1000, QLatin1Char('b')));
+
+    const DataLake::Metrics metrics = lake.metrics();
+    EXPECT_EQ(metrics.spilledBuckets, 1);
+    EXPECT_EQ(metrics.residentBuckets, 1);
+    EXPECT_LE(metrics.memoryBytes, 3000);
+    EXPECT_GT(metrics.spilledBytes, 0);
+    EXPECT_GT(metrics.peakMemoryBytes, 3000);
+
+    // The older bucket went to disk and reads back unchanged
+    EXPECT_EQ(lake.bucket(first), textBucket(1000, QLatin1Char('a')));
+    EXPECT_EQ(lake.value(second, QStringLiteral("text")).toString(), QString(1000, QLatin1Char('b')));
+
+    // Writing to a spilled bucket makes it resident again and pushes the other one out
+    lake.merge(first, QVariantMap{{QStringLiteral("extra"), 1}});
+    EXPECT_EQ(lake.bucket(first).value(QStringLiteral("text")).toString(), QString(1000, QLatin1Char('a')));
+    EXPECT_EQ(lake.bucket(first).value(QStringLiteral("extra")).toInt(), 1);
+    EXPECT_EQ(lake.metrics().spilledBuckets, 1);
+    EXPECT_EQ(lake.bucket(second), textBucket(1000, QLatin1Char('b')));
+}
+
+TEST(DataLakeTest, VersionsPinsAndAccountsMergesInPlace)
+{
+    DataLake lake({}, 0);
+    const QUuid node = QUuid::createUuid();
+    EXPECT_EQ(lake.version(node, QStringLiteral("text")), 0u);
+
+    lake.merge(node, QVariantMap{{QStringLiteral("text"), QStringLiteral("one")}, {QStringLiteral("count"), 1}});
+    const quint64 textVersion = lake.version(node, QStringLiteral("text"));
+    const quint64 countVersion = lake.version(node, QStringLiteral("count"));
+    EXPECT_GT(textVersion, 0u);
+    EXPECT_EQ(textVersion, countVersion);
+
+    // Only the written pin moves on
+    lake.merge(node, QVariantMap{{QStringLiteral("text"), QStringLiteral("two, longer")}});
+    quint64 readVersion = 0;
+    EXPECT_EQ(lake.value(node, QStringLiteral("text"), &readVersion).toString(), QStringLiteral("two, longer"));
+    EXPECT_GT(readVersion, textVersion);
+    EXPECT_EQ(lake.version(node, QStringLiteral("count")), countVersion);
+    EXPECT_EQ(lake.metrics().memoryBytes, DataLake::approximateBytes(lake.bucket(node)));
+
+    // A bucket handed out earlier keeps its values
+    const QVariantMap before = lake.bucket(node);
+    lake.merge(node, QVariantMap{{QStringLiteral("count"), 2}});
+    EXPECT_EQ(before.value(QStringLiteral("count")).toInt(), 1);
+    EXPECT_EQ(lake.value(node, QStringLiteral("count")).toInt(), 2);
+
+    lake.replace(node, QVariantMap{{QStringLiteral("other"), true}});
+    EXPECT_EQ(lake.version(node, QStringLiteral("text")), 0u);
+    EXPECT_EQ(lake.metrics().memoryBytes, DataLake::approximateBytes(lake.bucket(node)));
+}
+
+TEST(DataLakeTest, ConcurrentWritersAndReadersSeeConsistentPins)
+{
+    DataLake lake({}, 0);
+    constexpr int kWriters = 8;
+    constexpr int kWrites = 500;
+    QVector<QUuid> nodes;
+    for (int i = 0; i < kWriters; ++i) nodes.push_back(QUuid::createUuid());
+
+    std::atomic<bool> done {false};
+    std::atomic<int> inconsistent {0};
+    QThread* reader = QThread::create([&]() {
+        while (!done.load()) {
+            for (const QUuid& node : std::as_const(nodes)) {
+                // Both pins are written together, so a reader never sees them apart
+                const QVariantMap bucket = lake.bucket(node);
+                if (bucket.value(QStringLiteral("a")) != bucket.value(QStringLiteral("b"))) ++inconsistent;
+            }
+        }
+    });
+    reader->start();
+
+    QVector<QThread*> writers;
+    for (int w = 0; w < kWriters; ++w) {
+        writers.push_back(QThread::create([&lake, node = nodes[w]]() {
+            for (int i = 1; i <= kWrites; ++i) {
+                lake.merge(node, QVariantMap{{QStringLiteral("a"), i}, {QStringLiteral("b"), i}});
+            }
+        }));
+        writers.back()->start();
+    }
+    for (QThread* writer : std::as_const(writers)) {
+        writer->wait();
+        delete writer;
+    }
+    done = true;
+    reader->wait();
+    delete reader;
+
+    EXPECT_EQ(inconsistent.load(), 0);
+    qint64 expectedBytes = 0;
+    for (const QUuid& node : std::as_const(nodes)) {
+        EXPECT_EQ(lake.value(node, QStringLiteral("a")).toInt(), kWrites);
+        expectedBytes += DataLake::approximateBytes(lake.bucket(node));
+    }
+    EXPECT_EQ(lake.metrics().memoryBytes, expectedBytes);
+    EXPECT_EQ(lake.metrics().residentBuckets, kWriters);
+}
+
+TEST(DataLakeTest, ErrorsAreSeenInSpilledBuckets)
+{
+    DataLake lake({}, 1);
+    const QUuid node = QUuid::createUuid();
+    lake.merge(node, QVariantMap{{QStringLiteral("__error"), QStringLiteral("boom")}});
+    EXPECT_EQ(lake.metrics().spilledBuckets, 1);
+    EXPECT_TRUE(lake.hasError());
+    EXPECT_EQ(lake.toHash().value(node).value(QStringLiteral("__error")).toString(), QStringLiteral("boom"));
+}
+
+TEST(DataLakeTest, DropsOnlyBucketsWithoutRemainingConsumers)
+{
+    sharedTestApp();
+
+    NodeGraphModel model;
+    NodeId textNodeId = model.addNode(QStringLiteral("text-input"));
+    NodeId promptNodeId = model.addNode(QStringLiteral("prompt-builder"));
+    ASSERT_NE(promptNodeId, InvalidNodeId);
+    model.addConnection(ConnectionId{ textNodeId, 0u, promptNodeId, 0u });
+    const auto plan = ExecutionPlan::compile(&model);
+    const int textIndex = plan->indexOf(textNodeId);
+    const int promptIndex = plan->indexOf(promptNodeId);
+    const QUuid textUuid = plan->node(textIndex).uuid;
+    const QUuid promptUuid = plan->node(promptIndex).uuid;
+
+    DataLake lake(plan, 1);
+    lake.setDropsAllowed(true);
+
+    // The prompt may still run, so the text output is spilled rather than dropped
+    lake.taskScheduled(promptIndex);
+    lake.merge(textUuid, textBucket(100, QLatin1Char('t')));
+    EXPECT_TRUE(lake.contains(textUuid));
+    EXPECT_EQ(lake.metrics().droppedBuckets, 0);
+    lake.taskFinished(promptIndex);
+
+    // Once the prompt is done nothing reads the text output again
+    lake.merge(textUuid, textBucket(100, QLatin1Char('u')));
+    EXPECT_FALSE(lake.contains(textUuid));
+    EXPECT_EQ(lake.metrics().droppedBuckets, 1);
+
+    // Sinks form the final packet and are only ever spilled
+    lake.merge(promptUuid, textBucket(100, QLatin1Char('p')));
+    EXPECT_EQ(lake.bucket(promptUuid), textBucket(100, QLatin1Char('p')));
+}
+
+TEST(DataLakeTest, EngineRunOverBudgetKeepsOutputs)
+{
+    sharedTestApp();
+
+    NodeGraphModel model;
+    NodeId textNodeId = model.addNode(QStringLiteral("text-input"));
+    NodeId promptNodeId = model.addNode(QStringLiteral("prompt-builder"));
+    ASSERT_NE(promptNodeId, InvalidNodeId);
+    model.addConnection(ConnectionId{ textNodeId, 0u, promptNodeId, 0u });
+    auto* textTool = dynamic_cast<TextInputNode*>(model.delegateModel<ToolNodeDelegate>(textNodeId)->node().get());
+    ASSERT_NE(textTool, nullptr);
+    textTool->setText(QStringLiteral("Bob"));
+
+    ExecutionEngine engine(&model);
+    engine.setDataLakeBudget(0);
+    const DataPacket unbounded = runToCompletion(engine);
+    EXPECT_EQ(engine.dataLakeMetrics().spilledBuckets, 0);
+
+    engine.setDataLakeBudget(1);
+    const DataPacket bounded = runToCompletion(engine);
+    EXPECT_EQ(bounded, unbounded);
+
+    const DataLake::Metrics metrics = engine.dataLakeMetrics();
+    EXPECT_EQ(metrics.spilledBuckets, 2);
+    EXPECT_EQ(metrics.memoryBytes, 0);
+    EXPECT_EQ(engine.nodeOutput(textNodeId).value(QStringLiteral("text")).toString(), QStringLiteral("Bob"));
+}
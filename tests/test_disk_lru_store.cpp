@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QIODevice>
+#include <QTemporaryDir>
+
+#include "DiskLruStore.h"
+
+namespace {
+
+bool writeFile(const QString& path, const QByteArray& bytes)
+{
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.write(bytes) == bytes.size();
+}
+
+QByteArray readFile(const QString& path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+} // namespace
+
+TEST(DiskLruStoreTest, StoresFetchesAndReplaces)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    DiskLruStore store(dir.filePath(QStringLiteral("cache")), 1024 * 1024);
+
+    const QString source = dir.filePath(QStringLiteral("source.jpg"));
+    ASSERT_TRUE(writeFile(source, QByteArray("first")));
+    const QString jpg = store.entryPath(QStringLiteral("abcd"), QStringLiteral(".jpg"));
+    EXPECT_EQ(jpg, dir.filePath(QStringLiteral("cache/ab/abcd.jpg")));
+    ASSERT_TRUE(store.store(jpg, source));
+    EXPECT_EQ(store.sizeBytes(), 5);
+
+    const QString out = dir.filePath(QStringLiteral("out.jpg"));
+    ASSERT_TRUE(store.fetch(jpg, out));
+    EXPECT_EQ(readFile(out), QByteArray("first"));
+    EXPECT_FALSE(store.fetch(store.entryPath(QStringLiteral("ffff"), QStringLiteral(".jpg")), out));
+
+    // A new entry under the same key drops the old one, whatever its suffix
+    const QString png = store.entryPath(QStringLiteral("abcd"), QStringLiteral(".png"));
+    ASSERT_TRUE(writeFile(dir.filePath(QStringLiteral("source.png")), QByteArray("second!")));
+    ASSERT_TRUE(store.store(png, dir.filePath(QStringLiteral("source.png")), store.entriesFor(QStringLiteral("abcd"))));
+    EXPECT_EQ(store.entriesFor(QStringLiteral("abcd")), QStringList{png});
+    EXPECT_EQ(store.sizeBytes(), 7);
+
+    store.clear();
+    EXPECT_EQ(store.sizeBytes(), 0);
+    EXPECT_FALSE(QFile::exists(png));
+}
+
+TEST(DiskLruStoreTest, FailedWriteKeepsPreviousEntry)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    DiskLruStore store(dir.path(), 1024 * 1024, {QStringLiteral("*.bin")});
+    const QString path = store.entryPath(QStringLiteral("0011"), QStringLiteral(".bin"));
+
+    ASSERT_TRUE(store.write(path, [](QIODevice* file) { return file->write("kept") == 4; }));
+    EXPECT_FALSE(store.write(path, [](QIODevice* file) {
+        file->write("partial");
+        return false;
+    }));
+    EXPECT_EQ(readFile(path), QByteArray("kept"));
+    EXPECT_EQ(store.sizeBytes(), 4);
+}
+
+TEST(DiskLruStoreTest, PrunesLeastRecentlyUsedMatchingEntries)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    // Files outside the name filter are neither counted nor removed
+    ASSERT_TRUE(writeFile(dir.filePath(QStringLiteral("notes.txt")), QByteArray(4096, 'n')));
+    DiskLruStore store(dir.path(), 1000, {QStringLiteral("*.bin")});
+
+    const QByteArray body(300, 'x');
+    const QDateTime base = QDateTime::currentDateTime().addSecs(-100);
+    for (int i = 0; i < 3; ++i) {
+        const QString path = store.entryPath(QStringLiteral("k%1").arg(i), QStringLiteral(".bin"));
+        ASSERT_TRUE(store.write(path, [&body](QIODevice* file) { return file->write(body) == body.size(); }));
+        QFile entry(path);
+        ASSERT_TRUE(entry.open(QIODevice::ReadWrite));
+        entry.setFileTime(base.addSecs(i), QFileDevice::FileModificationTime);
+    }
+    // A hit makes the oldest entry the youngest
+    ASSERT_TRUE(store.touch(store.entryPath(QStringLiteral("k0"), QStringLiteral(".bin"))));
+
+    const QString last = store.entryPath(QStringLiteral("k3"), QStringLiteral(".bin"));
+    ASSERT_TRUE(store.write(last, [&body](QIODevice* file) { return file->write(body) == body.size(); }));
+
+    EXPECT_EQ(store.sizeBytes(), 900);
+    EXPECT_TRUE(QFile::exists(store.entryPath(QStringLiteral("k0"), QStringLiteral(".bin"))));
+    EXPECT_FALSE(QFile::exists(store.entryPath(QStringLiteral("k1"), QStringLiteral(".bin"))));
+    EXPECT_TRUE(QFile::exists(last));
+    EXPECT_TRUE(QFile::exists(dir.filePath(QStringLiteral("notes.txt"))));
+}
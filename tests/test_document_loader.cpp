@@ -4,6 +4,7 @@
 #include <QDir>
 #include <QTextStream>
 #include <QSet>
+#include "retrieval/documents/DirectoryScanner.h"
 #include "retrieval/documents/DocumentLoader.h"
 
 /**
@@ -176,6 +177,48 @@ TEST_F(DocumentLoaderTest, ReadTextFile_NonExistentFile_ReturnsEmptyString) {
     EXPECT_TRUE(result.isEmpty()) << "Should return empty string for non-existent file";
 }
 
+/**
+ * Test 3b: Streaming a Text File
+ * Decodes the file in windows a few bytes long, so multi-byte characters and
+ * CRLF pairs straddle window boundaries, and checks the windows add up to
+ * readTextFile's result.
+ */
+TEST_F(DocumentLoaderTest, StreamTextFile_WindowsConcatenateToReadTextFile) {
+    QByteArray bytes("\xEF\xBB\xBF"); // byte order mark
+    for (int i = 0; i < 50; ++i) {
+        bytes += QStringLiteral("line %1: café 😀 你好\r\n").arg(i).toUtf8();
+    }
+    bytes += "lone\rcarriage return\r";
+    const QString fullPath = tempDir.path() + "/stream.txt";
+    QFile file(fullPath);
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    file.write(bytes);
+    file.close();
+
+    const QString whole = DocumentLoader::readTextFile(fullPath);
+    EXPECT_TRUE(whole.startsWith(QStringLiteral("line 0: café 😀 你好\nline 1")));
+    EXPECT_FALSE(whole.contains(QStringLiteral("\r\n")));
+    EXPECT_TRUE(whole.endsWith(QStringLiteral("lone\rcarriage return\r")));
+
+    for (const qint64 windowBytes : {1, 3, 7, 64}) {
+        QString streamed;
+        int windows = 0;
+        ASSERT_TRUE(DocumentLoader::streamTextFile(fullPath, [&](QStringView window) {
+            streamed += window;
+            ++windows;
+            return true;
+        }, windowBytes));
+        EXPECT_EQ(streamed, whole) << "window of " << windowBytes << " bytes";
+        EXPECT_GT(windows, 1);
+    }
+
+    // The consumer can stop early
+    int calls = 0;
+    EXPECT_TRUE(DocumentLoader::streamTextFile(fullPath, [&calls](QStringView) { return ++calls < 2; }, 16));
+    EXPECT_EQ(calls, 2);
+    EXPECT_FALSE(DocumentLoader::streamTextFile(tempDir.path() + "/missing.txt", [](QStringView) { return true; }));
+}
+
 /**
  * Test 4: Case-insensitive Extension Matching
  * Verifies that file extensions are matched case-insensitively
@@ -215,3 +258,75 @@ TEST_F(DocumentLoaderTest, ScanDirectory_EmptyDirectory_ReturnsEmptyList) {
     
     EXPECT_TRUE(result.isEmpty()) << "Should return empty list for empty directory";
 }
+
+/**
+ * Test 6: Ignore Files and Pruned Directories
+ * Verifies that DirectoryScanner honours .gitignore/.ragignore patterns
+ * along the tree and never descends into node_modules.
+ */
+TEST_F(DocumentLoaderTest, DirectoryScanner_HonoursIgnoreFilesAndPrunes) {
+    ASSERT_TRUE(createFile(".gitignore", "# build output\nbuild/\n*.log.txt\n/generated.h\ndocs/**/draft*.md\n"));
+    ASSERT_TRUE(createFile(".ragignore", "*.json\n!keep.json\n"));
+    ASSERT_TRUE(createFile("main.cpp", "int main() {}"));
+    ASSERT_TRUE(createFile("keep.json", "{}"));
+    ASSERT_TRUE(createFile("drop.json", "{}"));
+    ASSERT_TRUE(createFile("generated.h", "// anchored to the root"));
+    ASSERT_TRUE(createFile("src/generated.h", "// not anchored here"));
+    ASSERT_TRUE(createFile("src/trace.log.txt", "log"));
+    ASSERT_TRUE(createFile("build/out.cpp", "// build output"));
+    ASSERT_TRUE(createFile("src/build/nested.cpp", "// any build directory"));
+    ASSERT_TRUE(createFile("node_modules/pkg/index.js", "module.exports = {}"));
+    ASSERT_TRUE(createFile("docs/guide.md", "# Guide"));
+    ASSERT_TRUE(createFile("docs/a/b/draft-1.md", "# Draft"));
+    ASSERT_TRUE(createFile("lib/.gitignore", "*.c\n"));
+    ASSERT_TRUE(createFile("lib/util.c", "void util() {}"));
+    ASSERT_TRUE(createFile("lib/util.h", "void util();"));
+    ASSERT_TRUE(createFile("other.c", "// outside lib"));
+
+    const QStringList result = DirectoryScanner::scan(tempDir.path());
+
+    QSet<QString> found;
+    for (const QString& path : result) {
+        found.insert(QDir(tempDir.path()).relativeFilePath(path));
+    }
+    const QSet<QString> expected = {
+        "main.cpp", "keep.json", "src/generated.h", "docs/guide.md", "lib/util.h", "other.c"
+    };
+    EXPECT_EQ(found, expected);
+    EXPECT_EQ(result.size(), expected.size());
+
+    // Without ignore files only the pruned directories are skipped
+    const QStringList unfiltered = DirectoryScanner::scan(tempDir.path(), QStringList(), false);
+    EXPECT_EQ(unfiltered.size(), 13);
+    for (const QString& path : unfiltered) {
+        EXPECT_FALSE(path.contains("node_modules")) << path.toStdString();
+    }
+}
+
+/**
+ * Test 7: Streaming Scan
+ * Verifies that files taken from a running DirectoryScanner add up to
+ * what scanDirectory finds, with name filters applied the same way.
+ */
+TEST_F(DocumentLoaderTest, DirectoryScanner_StreamedFilesMatchScanDirectory) {
+    for (int d = 0; d < 8; ++d) {
+        for (int f = 0; f < 6; ++f) {
+            ASSERT_TRUE(createFile(QString("dir%1/sub%2/file%3.cpp").arg(d).arg(f % 3).arg(f), "// code"));
+            ASSERT_TRUE(createFile(QString("dir%1/sub%2/notes%3.txt").arg(d).arg(f % 3).arg(f), "notes"));
+        }
+    }
+
+    const QStringList filters = {"*.cpp"};
+    DirectoryScanner scanner(tempDir.path(), filters, true, 4);
+    scanner.start();
+    QStringList streamed;
+    while (scanner.takeFiles(streamed, 50)) {
+    }
+    EXPECT_TRUE(scanner.isFinished());
+
+    QStringList serial = DocumentLoader::scanDirectory(tempDir.path(), filters);
+    streamed.sort();
+    serial.sort();
+    EXPECT_EQ(streamed.size(), 48);
+    EXPECT_EQ(streamed, serial);
+}
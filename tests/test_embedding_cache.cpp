@@ -0,0 +1,294 @@
+#include <gtest/gtest.h>
+
+#include <QFuture>
+#include <QList>
+#include <QSemaphore>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "ai/backends/EmbeddingBatcher.h"
+#include "ai/backends/WordPieceTokenizer.h"
+#include "retrieval/storage/EmbeddingCache.h"
+
+namespace {
+
+// Embeds each text as {length, call number} and records what it was asked for
+class RecordingEmbeddingBackend : public ILLMBackend {
+public:
+    QString id() const override { return QStringLiteral("recording"); }
+    QString name() const override { return QStringLiteral("Recording"); }
+    QStringList availableModels() const override { return {}; }
+    QStringList availableEmbeddingModels() const override { return {}; }
+    QFuture<QStringList> fetchModelList() override { return {}; }
+    LLMResult sendPrompt(const QString&, const QString&, double, int, const QString&, const QString&,
+                         const LLMMessage& = {}) override {
+        return {};
+    }
+    EmbeddingResult getEmbedding(const QString&, const QString&, const QString&) override { return {}; }
+    EmbeddingBatchResult getEmbeddings(const QString&, const QString&, const QStringList& texts) override {
+        ++calls;
+        requested << texts;
+        EmbeddingBatchResult result;
+        for (const QString& text : texts) {
+            result.vectors.push_back({static_cast<float>(text.size()), static_cast<float>(calls)});
+        }
+        result.usage.inputTokens = texts.size();
+        return result;
+    }
+    QFuture<QString> generateImage(const QString&, const QString&, const QString&, const QString&,
+                                   const QString&, const QString&) override {
+        return {};
+    }
+
+    int calls {0};
+    QStringList requested;
+};
+
+// Holds every request until released, so callers can pile up behind the first
+class GatedEmbeddingBackend : public RecordingEmbeddingBackend {
+public:
+    EmbeddingBatchResult getEmbeddings(const QString& apiKey, const QString& modelId,
+                                       const QStringList& texts) override {
+        entered.release();
+        gate.acquire();
+        ++gatedCalls;
+        return RecordingEmbeddingBackend::getEmbeddings(apiKey, modelId, texts);
+    }
+
+    QSemaphore entered;
+    QSemaphore gate;
+    std::atomic<int> gatedCalls {0};
+};
+
+} // namespace
+
+TEST(EmbeddingCacheTest, OnlyMissesReachTheBackend)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    EmbeddingCache cache(dir.filePath(QStringLiteral("cache.sqlite")));
+    RecordingEmbeddingBackend backend;
+
+    EmbeddingCache::Counters first;
+    const EmbeddingBatchResult cold = cache.embed(backend, QStringLiteral("p"), QString(), QStringLiteral("m"),
+                                                  {QStringLiteral("alpha"), QStringLiteral("beta")}, 0, &first);
+    ASSERT_FALSE(cold.hasError);
+    EXPECT_EQ(first.hits.load(), 0);
+    EXPECT_EQ(first.misses.load(), 2);
+
+    // Whitespace and line-ending changes still hit; only "gamma" is new
+    EmbeddingCache::Counters second;
+    const EmbeddingBatchResult warm = cache.embed(backend, QStringLiteral("p"), QString(), QStringLiteral("m"),
+                                                  {QStringLiteral("  alpha\r\n"), QStringLiteral("gamma"),
+                                                   QStringLiteral("beta")},
+                                                  0, &second);
+    ASSERT_FALSE(warm.hasError);
+    ASSERT_EQ(warm.vectors.size(), 3u);
+    EXPECT_EQ(second.hits.load(), 2);
+    EXPECT_EQ(second.misses.load(), 1);
+    EXPECT_EQ(backend.calls, 2);
+    EXPECT_EQ(backend.requested.last(), QStringLiteral("gamma"));
+    EXPECT_EQ(warm.vectors[0], cold.vectors[0]);
+    EXPECT_EQ(warm.vectors[1], (std::vector<float>{5.0f, 2.0f}));
+    EXPECT_EQ(warm.vectors[2], cold.vectors[1]);
+    EXPECT_EQ(warm.usage.inputTokens, 1);
+    EXPECT_EQ(cache.hits(), 2);
+    EXPECT_EQ(cache.misses(), 3);
+
+    // A different model or dimension is a different entry
+    EXPECT_TRUE(cache.lookup(QStringLiteral("p"), QStringLiteral("other"), {QStringLiteral("alpha")})[0].empty());
+    EXPECT_TRUE(cache.lookup(QStringLiteral("p"), QStringLiteral("m"), {QStringLiteral("alpha")}, 3)[0].empty());
+    EXPECT_FALSE(cache.lookup(QStringLiteral("p"), QStringLiteral("m"), {QStringLiteral("alpha")}, 2)[0].empty());
+}
+
+TEST(EmbeddingCacheTest, EvictsLeastRecentlyUsedEntriesOverBudget)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const std::vector<float> vector(64, 1.0f); // 256 bytes each
+    EmbeddingCache cache(dir.filePath(QStringLiteral("cache.sqlite")), 1024);
+
+    cache.store(QStringLiteral("p"), QStringLiteral("m"), {QStringLiteral("a"), QStringLiteral("b")}, {vector, vector});
+    cache.store(QStringLiteral("p"), QStringLiteral("m"), {QStringLiteral("c"), QStringLiteral("d")}, {vector, vector});
+    EXPECT_EQ(cache.sizeBytes(), 1024);
+
+    cache.store(QStringLiteral("p"), QStringLiteral("m"), {QStringLiteral("e")}, {vector});
+    EXPECT_LE(cache.sizeBytes(), 1024 - 1024 / 10);
+
+    const auto found = cache.lookup(QStringLiteral("p"), QStringLiteral("m"),
+                                    {QStringLiteral("a"), QStringLiteral("b"), QStringLiteral("e")});
+    EXPECT_TRUE(found[0].empty());
+    EXPECT_TRUE(found[1].empty());
+    EXPECT_FALSE(found[2].empty());
+}
+
+TEST(EmbeddingCacheTest, IdenticalRequestsInFlightShareOneCall)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    EmbeddingCache cache(dir.filePath(QStringLiteral("cache.sqlite")));
+    GatedEmbeddingBackend backend;
+    const QStringList texts {QStringLiteral("alpha"), QStringLiteral("beta")};
+    const auto embed = [&]() {
+        return cache.embed(backend, QStringLiteral("p"), QString(), QStringLiteral("m"), texts);
+    };
+
+    QList<QFuture<EmbeddingBatchResult>> results;
+    results.append(QtConcurrent::run(embed));
+    ASSERT_TRUE(backend.entered.tryAcquire(1, 5000));
+    for (int i = 0; i < 3; ++i) {
+        results.append(QtConcurrent::run(embed));
+    }
+    // Let the others reach the request in flight before it answers
+    QThread::msleep(200);
+    backend.gate.release(4);
+
+    int inputTokens = 0;
+    for (auto& result : results) {
+        const EmbeddingBatchResult embedded = result.result();
+        ASSERT_FALSE(embedded.hasError);
+        EXPECT_EQ(embedded.vectors, results.first().result().vectors);
+        inputTokens += embedded.usage.inputTokens;
+    }
+    EXPECT_EQ(backend.gatedCalls.load(), 1);
+    // Only the request that went out is billed
+    EXPECT_EQ(inputTokens, 2);
+}
+
+TEST(EmbeddingBatcherTest, CallersQueuedBehindARunningBatchShareTheNext)
+{
+    EmbeddingBatcher batcher(8, 0);
+    QSemaphore entered;
+    QSemaphore gate;
+    std::mutex sizesMutex;
+    std::vector<qsizetype> sizes;
+    const EmbeddingBatcher::Run run = [&](const QStringList& texts) {
+        {
+            std::lock_guard<std::mutex> lock(sizesMutex);
+            sizes.push_back(texts.size());
+        }
+        entered.release();
+        gate.acquire();
+        EmbeddingBatchResult result;
+        for (const QString& text : texts) {
+            result.vectors.push_back({static_cast<float>(text.toInt())});
+        }
+        result.usage.inputTokens = static_cast<int>(texts.size()) * 10;
+        return result;
+    };
+
+    QList<QFuture<EmbeddingBatchResult>> results;
+    results.append(QtConcurrent::run([&]() { return batcher.embed({QStringLiteral("0")}, run); }));
+    ASSERT_TRUE(entered.tryAcquire(1, 5000));
+    for (int i = 1; i <= 3; ++i) {
+        results.append(QtConcurrent::run([&, i]() { return batcher.embed({QString::number(i)}, run); }));
+    }
+    for (int i = 0; i < 500 && batcher.queuedTexts() < 3; ++i) {
+        QThread::msleep(10);
+    }
+    ASSERT_EQ(batcher.queuedTexts(), 3);
+    gate.release(2);
+
+    for (int i = 0; i < results.size(); ++i) {
+        const EmbeddingBatchResult embedded = results[i].result();
+        ASSERT_FALSE(embedded.hasError);
+        ASSERT_EQ(embedded.vectors.size(), 1u);
+        EXPECT_EQ(embedded.vectors.front().front(), static_cast<float>(i));
+        EXPECT_EQ(embedded.usage.inputTokens, 10);
+    }
+    EXPECT_EQ(sizes, (std::vector<qsizetype> {1, 3}));
+}
+
+TEST(EmbeddingBatcherTest, OverlappingBatcherSendsTheNextBatchWhileOneIsOut)
+{
+    // Full batches never wait out the window
+    EmbeddingBatcher batcher(2, 60000, true);
+    QSemaphore entered;
+    QSemaphore gate;
+    std::mutex sizesMutex;
+    std::vector<qsizetype> sizes;
+    const EmbeddingBatcher::Run run = [&](const QStringList& texts) {
+        {
+            std::lock_guard<std::mutex> lock(sizesMutex);
+            sizes.push_back(texts.size());
+        }
+        entered.release();
+        gate.acquire();
+        EmbeddingBatchResult result;
+        for (const QString& text : texts) {
+            result.vectors.push_back({static_cast<float>(text.toInt())});
+        }
+        return result;
+    };
+
+    QList<QFuture<EmbeddingBatchResult>> results;
+    for (int i = 0; i < 2; ++i) {
+        results.append(QtConcurrent::run([&, i]() { return batcher.embed({QString::number(i)}, run); }));
+    }
+    ASSERT_TRUE(entered.tryAcquire(1, 5000));
+    for (int i = 2; i < 4; ++i) {
+        results.append(QtConcurrent::run([&, i]() { return batcher.embed({QString::number(i)}, run); }));
+    }
+    // The second batch starts before the first one returns
+    ASSERT_TRUE(entered.tryAcquire(1, 5000));
+    gate.release(2);
+
+    for (int i = 0; i < results.size(); ++i) {
+        const EmbeddingBatchResult embedded = results[i].result();
+        ASSERT_FALSE(embedded.hasError);
+        ASSERT_EQ(embedded.vectors.size(), 1u);
+        EXPECT_EQ(embedded.vectors.front().front(), static_cast<float>(i));
+    }
+    EXPECT_EQ(sizes, (std::vector<qsizetype> {2, 2}));
+}
+
+TEST(EmbeddingBatcherTest, CoalescePassesLargeCallsStraightThrough)
+{
+    std::atomic<int> calls {0};
+    const EmbeddingBatcher::Run run = [&](const QStringList& texts) {
+        ++calls;
+        EmbeddingBatchResult result;
+        result.vectors.resize(static_cast<size_t>(texts.size()));
+        return result;
+    };
+    QStringList texts;
+    for (int i = 0; i < EmbeddingBatcher::kCoalesceBelowTexts; ++i) {
+        texts.append(QString::number(i));
+    }
+    const QString key = EmbeddingBatcher::coalesceKey(QStringLiteral("test"), QStringLiteral("model"), 0, {});
+    EXPECT_EQ(EmbeddingBatcher::coalesce(key, texts, 8, run).vectors.size(), static_cast<size_t>(texts.size()));
+    EXPECT_EQ(EmbeddingBatcher::coalesce(key, {QStringLiteral("one")}, 8, run).vectors.size(), 1u);
+    EXPECT_EQ(calls.load(), 2);
+}
+
+TEST(WordPieceTokenizerTest, SplitsWordsIntoLongestVocabularyPieces)
+{
+    WordPieceTokenizer tokenizer;
+    tokenizer.setVocabulary({QStringLiteral("[PAD]"), QStringLiteral("[UNK]"), QStringLiteral("[CLS]"),
+                             QStringLiteral("[SEP]"), QStringLiteral("un"), QStringLiteral("##aff"),
+                             QStringLiteral("##able"), QStringLiteral("cafe"), QStringLiteral(","),
+                             QStringLiteral("!")});
+
+    EXPECT_EQ(tokenizer.tokenize(QStringLiteral("Unaffable, CAFÉ!")),
+              (QStringList {QStringLiteral("un"), QStringLiteral("##aff"), QStringLiteral("##able"),
+                            QStringLiteral(","), QStringLiteral("cafe"), QStringLiteral("!")}));
+    EXPECT_EQ(tokenizer.tokenize(QStringLiteral("unknown")), QStringList {QStringLiteral("[UNK]")});
+    EXPECT_EQ(tokenizer.encode(QStringLiteral("unaffable cafe"), 4), (std::vector<qint64> {2, 4, 5, 3}));
+    EXPECT_EQ(tokenizer.padId(), 0);
+}
+
+TEST(WordPieceTokenizerTest, DuplicateVocabularyLinesKeepTheLastId)
+{
+    WordPieceTokenizer tokenizer;
+    tokenizer.setVocabulary({QStringLiteral("[PAD]"), QStringLiteral("[UNK]"), QStringLiteral("[CLS]"),
+                             QStringLiteral("[SEP]"), QStringLiteral("cafe"), QStringLiteral("tea"),
+                             QStringLiteral("cafe")});
+
+    EXPECT_EQ(tokenizer.encode(QStringLiteral("cafe tea"), 4), (std::vector<qint64> {2, 6, 5, 3}));
+}
@@ -1,20 +1,43 @@
 #include <gtest/gtest.h>
 
 #include <QApplication>
+#include <QDeadlineTimer>
 #include <QEventLoop>
 #include <QTimer>
 #include <QElapsedTimer>
 #include <QVariant>
 #include <QMutexLocker>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QThreadPool>
+#include <QGraphicsProxyWidget>
+#include <QGraphicsScene>
+#include <QGraphicsView>
+#include <QLabel>
+
+#include <atomic>
+#include <memory>
 
 #include "test_app.h"
 #include <QtNodes/internal/Definitions.hpp>
 
 #include "NodeGraphModel.h"
+#include "ExecutionAwarePainters.h"
 #include "ExecutionEngine.h"
+#include "ExecutionIdUtils.h"
+#include "ExecutionPlan.h"
+#include "ExecutionStateModel.h"
+#include "InputSignature.h"
+#include "NodeOutputDir.h"
 #include "ToolNodeDelegate.h"
 #include "TextInputNode.h"
 #include "PromptBuilderNode.h"
+#include "ResourceBudgets.h"
+#include "RetryPolicy.h"
+#include "ThreadQos.h"
+#include "WorkStealingScheduler.h"
+#include "IToolNode.h"
 
 using namespace QtNodes;
 
@@ -34,18 +57,20 @@ public:
     static void setLastSignature(ExecutionEngine& engine, const QUuid& nodeUuid, const QByteArray& sig)
     {
         QMutexLocker locker(&engine.m_queueMutex);
-        engine.m_lastInputSignature.insert(nodeUuid, sig);
+        engine.m_run->lastInputSignature.insert(nodeUuid, sig);
     }
 
     static QByteArray lastSignature(const ExecutionEngine& engine, const QUuid& nodeUuid)
     {
         QMutexLocker locker(&engine.m_queueMutex);
-        return engine.m_lastInputSignature.value(nodeUuid);
+        return engine.m_run->lastInputSignature.value(nodeUuid);
     }
 
     static void setCurrentRunId(ExecutionEngine& engine, const QUuid& runId)
     {
-        engine.m_currentRunId = runId;
+        auto run = std::make_shared<ExecutionEngine::RunContext>();
+        run->id = runId;
+        engine.m_run = run;
     }
 
     static void invokeHandle(ExecutionEngine& engine,
@@ -54,7 +79,9 @@ public:
                              const TokenList& outputs,
                              const QUuid& runId)
     {
-        engine.handleTaskCompleted(nodeId, nodeUuid, outputs, runId);
+        if (engine.m_run && engine.m_run->id == runId) {
+            engine.handleTaskCompleted(engine.m_run, nodeId, nodeUuid, outputs);
+        }
     }
 
     static QString truncateAndEscape(const QVariant& v)
@@ -164,6 +191,1059 @@ TEST(ExecutionEngineTest, ClearsDedupSignatureWhenNodeEmitsNoOutput)
     EXPECT_TRUE(ExecutionEngineSignatureFriend::lastSignature(engine, nodeUuid).isEmpty());
 }
 
+TEST(ExecutionEngineTest, InputSignatureIsStructural)
+{
+    ensureApp();
+
+    NodeGraphModel model;
+    ExecutionEngine engine(&model);
+
+    QVariantMap a;
+    a.insert(QStringLiteral("input"), QStringLiteral("hello"));
+    a.insert(QStringLiteral("count"), 3);
+    a.insert(QStringLiteral("items"), QVariantList{1, QStringLiteral("two"), true});
+
+    QVariantMap b = a;
+    const QByteArray sigA = ExecutionEngineSignatureFriend::compute(engine, a);
+    EXPECT_EQ(sigA.size(), 16);
+    EXPECT_EQ(sigA, ExecutionEngineSignatureFriend::compute(engine, b));
+
+    // Both halves are independent 64-bit digests, and both change with the input
+    EXPECT_NE(sigA.left(8), sigA.mid(8));
+    b.insert(QStringLiteral("count"), 4);
+    const QByteArray sigB = ExecutionEngineSignatureFriend::compute(engine, b);
+    EXPECT_NE(sigA.left(8), sigB.left(8));
+    EXPECT_NE(sigA.mid(8), sigB.mid(8));
+
+    // Moving a value to a different key is a different input
+    QVariantMap c;
+    c.insert(QStringLiteral("x"), QStringLiteral("ab"));
+    QVariantMap d;
+    d.insert(QStringLiteral("xa"), QStringLiteral("b"));
+    EXPECT_NE(ExecutionEngineSignatureFriend::compute(engine, c),
+              ExecutionEngineSignatureFriend::compute(engine, d));
+}
+
+TEST(ExecutionEngineTest, InputSignatureLargeValuesMatchAcrossCopies)
+{
+    ensureApp();
+
+    NodeGraphModel model;
+    ExecutionEngine engine(&model);
+
+    const QString large(InputSignature::kCacheThresholdBytes, QLatin1Char('x'));
+    QVariantMap shared;
+    shared.insert(QStringLiteral("text"), large);
+
+    // A deep copy has different storage but the same content
+    QString deep = QString::fromUtf16(large.utf16(), large.size());
+    QVariantMap copied;
+    copied.insert(QStringLiteral("text"), deep);
+
+    const QByteArray first = ExecutionEngineSignatureFriend::compute(engine, shared);
+    EXPECT_EQ(first, ExecutionEngineSignatureFriend::compute(engine, shared));
+    EXPECT_EQ(first, ExecutionEngineSignatureFriend::compute(engine, copied));
+
+    deep[0] = QLatin1Char('y');
+    copied.insert(QStringLiteral("text"), deep);
+    EXPECT_NE(first, ExecutionEngineSignatureFriend::compute(engine, copied));
+
+    InputSignature::clearCache();
+    EXPECT_EQ(first, ExecutionEngineSignatureFriend::compute(engine, shared));
+}
+
+TEST(ExecutionEngineTest, ExecutionPlanResolvesEdgesAndPins)
+{
+    ensureApp();
+
+    NodeGraphModel model;
+    NodeId textNodeId = model.addNode(QStringLiteral("text-input"));
+    NodeId promptNodeId = model.addNode(QStringLiteral("prompt-builder"));
+    ASSERT_NE(textNodeId, InvalidNodeId);
+    ASSERT_NE(promptNodeId, InvalidNodeId);
+
+    ConnectionId conn{ textNodeId, 0u, promptNodeId, 0u };
+    model.addConnection(conn);
+
+    const auto plan = ExecutionPlan::compile(&model);
+    ASSERT_TRUE(plan);
+    ASSERT_EQ(plan->nodes().size(), 2);
+    ASSERT_EQ(plan->edges().size(), 1);
+
+    const int textIndex = plan->indexOf(textNodeId);
+    const int promptIndex = plan->indexOf(promptNodeId);
+    ASSERT_GE(textIndex, 0);
+    ASSERT_GE(promptIndex, 0);
+    EXPECT_EQ(plan->indexOf(ExecIds::nodeUuid(promptNodeId)), promptIndex);
+
+    const auto& text = plan->node(textIndex);
+    const auto& prompt = plan->node(promptIndex);
+    EXPECT_FALSE(text.hasIncoming);
+    EXPECT_TRUE(text.hasOutgoing);
+    EXPECT_TRUE(prompt.hasIncoming);
+    EXPECT_FALSE(prompt.hasOutgoing);
+    EXPECT_EQ(text.name, QStringLiteral("Text Input"));
+    ASSERT_TRUE(text.node);
+
+    const auto& edge = plan->edge(text.outEdges.value(0));
+    EXPECT_EQ(edge.sourceIndex, textIndex);
+    EXPECT_EQ(edge.targetIndex, promptIndex);
+    EXPECT_EQ(edge.sourcePinId, QStringLiteral("text"));
+    EXPECT_EQ(edge.targetPinId, QStringLiteral("input"));
+    EXPECT_EQ(edge.connectionUuid, ExecIds::connectionUuid(conn));
+    ASSERT_EQ(prompt.inEdges.size(), 1);
+    ASSERT_EQ(prompt.incomingConnectionUuids.size(), 1);
+    EXPECT_EQ(prompt.incomingConnectionUuids.first(), edge.connectionUuid);
+    // Two synchronous CPU nodes joined by their only edge form a fused chain
+    EXPECT_EQ(text.fusedSuccessor, promptIndex);
+    EXPECT_EQ(prompt.fusedSuccessor, -1);
+
+    // The plan is a snapshot: later graph edits do not alter it
+    model.deleteConnection(conn);
+    EXPECT_EQ(plan->edges().size(), 1);
+}
+
+namespace {
+
+// Tracks how many executions of a node overlap
+struct OverlapCounter {
+    std::atomic<int> active {0};
+    std::atomic<int> peak {0};
+
+    void enter()
+    {
+        const int now = ++active;
+        int seen = peak.load();
+        while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+        }
+    }
+    void leave() { --active; }
+};
+
+NodeDescriptor mockDescriptor(const QString& typeId, const QString& inPin, const QString& outPin)
+{
+    NodeDescriptor desc;
+    desc.id = typeId;
+    desc.name = typeId;
+    if (!inPin.isEmpty()) {
+        PinDefinition in;
+        in.direction = PinDirection::Input;
+        in.id = inPin;
+        in.name = inPin;
+        in.type = QStringLiteral("text");
+        desc.inputPins.insert(in.id, in);
+    }
+    if (!outPin.isEmpty()) {
+        PinDefinition out;
+        out.direction = PinDirection::Output;
+        out.id = outPin;
+        out.name = outPin;
+        out.type = QStringLiteral("text");
+        desc.outputPins.insert(out.id, out);
+    }
+    return desc;
+}
+
+// Emits one token per item, like a loop feeding its body
+class ItemSourceNode : public QObject, public IToolNode {
+    Q_OBJECT
+    Q_INTERFACES(IToolNode)
+
+public:
+    explicit ItemSourceNode(int count) : m_count(count) {}
+
+    NodeDescriptor getDescriptor() const override
+    {
+        return mockDescriptor(QStringLiteral("item-source"), QString(), QStringLiteral("item"));
+    }
+    TokenList execute(const TokenList&) override
+    {
+        TokenList tokens;
+        for (int i = 0; i < m_count; ++i) {
+            ExecutionToken token;
+            token.data.insert(QStringLiteral("item"), QString::number(i));
+            tokens.push_back(std::move(token));
+        }
+        return tokens;
+    }
+    QJsonObject saveState() const override { return {}; }
+    void loadState(const QJsonObject&) override {}
+
+private:
+    int m_count;
+};
+
+// Reentrant echo whose early items take longest, so they finish in reverse order
+class SlowEchoNode : public QObject, public IToolNode {
+    Q_OBJECT
+    Q_INTERFACES(IToolNode)
+
+public:
+    SlowEchoNode(std::shared_ptr<OverlapCounter> overlap, int count)
+        : m_overlap(std::move(overlap)), m_count(count)
+    {
+    }
+
+    NodeDescriptor getDescriptor() const override
+    {
+        return mockDescriptor(QStringLiteral("slow-echo"), QStringLiteral("in"), QStringLiteral("out"));
+    }
+    bool supportsConcurrentRuns() const override { return true; }
+    TokenList execute(const TokenList& incomingTokens) override
+    {
+        m_overlap->enter();
+        const QString item = incomingTokens.isEmpty() ? QString()
+                                                      : incomingTokens.front().data.value(QStringLiteral("in")).toString();
+        QThread::msleep(static_cast<unsigned long>(10 * (m_count - item.toInt())));
+        m_overlap->leave();
+        ExecutionToken token;
+        token.data.insert(QStringLiteral("out"), item);
+        return TokenList{token};
+    }
+    QJsonObject saveState() const override { return {}; }
+    void loadState(const QJsonObject&) override {}
+
+private:
+    std::shared_ptr<OverlapCounter> m_overlap;
+    int m_count;
+};
+
+// Not reentrant: records what it receives, in order
+class CollectorNode : public QObject, public IToolNode {
+    Q_OBJECT
+    Q_INTERFACES(IToolNode)
+
+public:
+    CollectorNode(std::shared_ptr<QStringList> received, std::shared_ptr<OverlapCounter> overlap)
+        : m_received(std::move(received)), m_overlap(std::move(overlap))
+    {
+    }
+
+    NodeDescriptor getDescriptor() const override
+    {
+        return mockDescriptor(QStringLiteral("collector"), QStringLiteral("in"), QString());
+    }
+    TokenList execute(const TokenList& incomingTokens) override
+    {
+        m_overlap->enter();
+        for (const auto& token : incomingTokens) m_received->append(token.data.value(QStringLiteral("in")).toString());
+        QThread::msleep(2);
+        m_overlap->leave();
+        return {};
+    }
+    QJsonObject saveState() const override { return {}; }
+    void loadState(const QJsonObject&) override {}
+
+private:
+    std::shared_ptr<QStringList> m_received;
+    std::shared_ptr<OverlapCounter> m_overlap;
+};
+
+// Echo that records the worker thread of each execution
+class ThreadRecorderNode : public QObject, public IToolNode {
+    Q_OBJECT
+    Q_INTERFACES(IToolNode)
+
+public:
+    ThreadRecorderNode(std::shared_ptr<QList<QThread*>> threads, std::shared_ptr<QMutex> mutex)
+        : m_threads(std::move(threads)), m_mutex(std::move(mutex))
+    {
+    }
+
+    NodeDescriptor getDescriptor() const override
+    {
+        return mockDescriptor(QStringLiteral("thread-recorder"), QStringLiteral("in"), QStringLiteral("out"));
+    }
+    TokenList execute(const TokenList& incomingTokens) override
+    {
+        {
+            QMutexLocker locker(m_mutex.get());
+            m_threads->append(QThread::currentThread());
+        }
+        ExecutionToken token;
+        if (!incomingTokens.isEmpty()) {
+            token.data.insert(QStringLiteral("out"), incomingTokens.front().data.value(QStringLiteral("in")));
+        }
+        return TokenList{token};
+    }
+    QJsonObject saveState() const override { return {}; }
+    void loadState(const QJsonObject&) override {}
+
+private:
+    std::shared_ptr<QList<QThread*>> m_threads;
+    std::shared_ptr<QMutex> m_mutex;
+};
+
+// Records the scheduling level of the worker executing it
+class QosRecorderNode : public QObject, public IToolNode {
+    Q_OBJECT
+    Q_INTERFACES(IToolNode)
+
+public:
+    explicit QosRecorderNode(std::shared_ptr<std::atomic<int>> level) : m_level(std::move(level)) {}
+
+    NodeDescriptor getDescriptor() const override
+    {
+        return mockDescriptor(QStringLiteral("qos-recorder"), QStringLiteral("in"), QString());
+    }
+    TokenList execute(const TokenList&) override
+    {
+        m_level->store(static_cast<int>(ThreadQos::current()));
+        return {};
+    }
+    bool supportsConcurrentRuns() const override { return true; }
+    QJsonObject saveState() const override { return {}; }
+    void loadState(const QJsonObject&) override {}
+
+private:
+    std::shared_ptr<std::atomic<int>> m_level;
+};
+
+// Source that fails transiently a set number of times, then succeeds. Records whether
+// each attempt ran under an engine retry.
+class FlakySourceNode : public QObject, public IToolNode {
+    Q_OBJECT
+    Q_INTERFACES(IToolNode)
+
+public:
+    FlakySourceNode(int failures, int retryAfterMs, std::shared_ptr<QList<bool>> attempts)
+        : m_failures(failures), m_retryAfterMs(retryAfterMs), m_attempts(std::move(attempts))
+    {
+    }
+
+    NodeDescriptor getDescriptor() const override
+    {
+        return mockDescriptor(QStringLiteral("flaky-source"), QString(), QStringLiteral("out"));
+    }
+    TokenList execute(const TokenList&) override
+    {
+        m_attempts->append(RetryPolicy::current());
+        ExecutionToken token;
+        if (m_attempts->size() <= m_failures) {
+            token.data.insert(QStringLiteral("__error"), QStringLiteral("HTTP 503"));
+            token.data.insert(QString::fromLatin1(RetryPolicy::kRetryAfterKey), m_retryAfterMs);
+        } else {
+            token.data.insert(QStringLiteral("out"), QStringLiteral("ok"));
+        }
+        return TokenList{token};
+    }
+    QJsonObject saveState() const override { return {}; }
+    void loadState(const QJsonObject&) override {}
+
+private:
+    int m_failures;
+    int m_retryAfterMs;
+    std::shared_ptr<QList<bool>> m_attempts;
+};
+
+} // namespace
+
+TEST(ExecutionEngineTest, BatchRunsExecuteOnLowerQosWorkers)
+{
+    ensureApp();
+    if (!ThreadQos::isSupported()) GTEST_SKIP() << "Thread levels are not supported on this platform";
+
+    EXPECT_EQ(ExecutionEngine::threadQosOf(true, ExecutionEngine::TaskPriority::Low), ThreadQos::Level::UserInitiated);
+    EXPECT_EQ(ExecutionEngine::threadQosOf(false, ExecutionEngine::TaskPriority::High),
+              ThreadQos::Level::UserInitiated);
+
+    const auto level = std::make_shared<std::atomic<int>>(-1);
+    NodeGraphModel model;
+    model.dataModelRegistry()->registerModel([]() {
+        return std::make_unique<ToolNodeDelegate>(std::make_shared<ItemSourceNode>(1));
+    }, QStringLiteral("Mocks"));
+    model.dataModelRegistry()->registerModel([level]() {
+        return std::make_unique<ToolNodeDelegate>(std::make_shared<QosRecorderNode>(level));
+    }, QStringLiteral("Mocks"));
+    const NodeId sourceId = model.addNode(QStringLiteral("item-source"));
+    const NodeId recorderId = model.addNode(QStringLiteral("qos-recorder"));
+    model.addConnection(ConnectionId{ sourceId, 0u, recorderId, 0u });
+
+    ExecutionEngine engine(&model);
+    engine.setThreadQosEnabled(true);
+
+    // The foreground run stays interactive
+    {
+        bool finished = false;
+        QEventLoop loop;
+        QObject::connect(&engine, &ExecutionEngine::pipelineFinished, &loop, [&](const DataPacket&) {
+            finished = true;
+            loop.quit();
+        });
+        QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+        engine.Run();
+        if (!finished) loop.exec();
+        ASSERT_TRUE(finished);
+        EXPECT_EQ(level->load(), static_cast<int>(ThreadQos::Level::UserInitiated));
+    }
+
+    const QList<QPair<ExecutionEngine::TaskPriority, ThreadQos::Level>> cases{
+        {ExecutionEngine::TaskPriority::High, ThreadQos::Level::UserInitiated},
+        {ExecutionEngine::TaskPriority::Normal, ThreadQos::Level::Utility},
+        {ExecutionEngine::TaskPriority::Low, ThreadQos::Level::Background},
+    };
+    for (const auto& [priority, expected] : cases) {
+        level->store(-1);
+        bool finished = false;
+        QEventLoop loop;
+        const auto connection = QObject::connect(&engine, &ExecutionEngine::runFinished, &loop,
+                                                 [&](const QUuid&, const DataPacket&, bool succeeded) {
+            EXPECT_TRUE(succeeded);
+            finished = true;
+            loop.quit();
+        });
+        QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+        engine.startIndependentRun({}, priority);
+        if (!finished) loop.exec();
+        QObject::disconnect(connection);
+        ASSERT_TRUE(finished);
+        EXPECT_EQ(level->load(), static_cast<int>(expected)) << ThreadQos::name(expected).toStdString();
+    }
+}
+
+TEST(ExecutionEngineTest, FusedChainRunsOnOneWorkerAndReportsStatus)
+{
+    ensureApp();
+
+    const auto threads = std::make_shared<QList<QThread*>>();
+    const auto threadsMutex = std::make_shared<QMutex>();
+    const auto received = std::make_shared<QStringList>();
+    const auto collectorOverlap = std::make_shared<OverlapCounter>();
+
+    NodeGraphModel model;
+    model.dataModelRegistry()->registerModel([]() {
+        return std::make_unique<ToolNodeDelegate>(std::make_shared<ItemSourceNode>(1));
+    }, QStringLiteral("Mocks"));
+    model.dataModelRegistry()->registerModel([threads, threadsMutex]() {
+        return std::make_unique<ToolNodeDelegate>(std::make_shared<ThreadRecorderNode>(threads, threadsMutex));
+    }, QStringLiteral("Mocks"));
+    model.dataModelRegistry()->registerModel([received, collectorOverlap]() {
+        return std::make_unique<ToolNodeDelegate>(std::make_shared<CollectorNode>(received, collectorOverlap));
+    }, QStringLiteral("Mocks"));
+
+    const NodeId sourceId = model.addNode(QStringLiteral("item-source"));
+    const NodeId firstId = model.addNode(QStringLiteral("thread-recorder"));
+    const NodeId secondId = model.addNode(QStringLiteral("thread-recorder"));
+    const NodeId collectorId = model.addNode(QStringLiteral("collector"));
+    model.addConnection(ConnectionId{ sourceId, 0u, firstId, 0u });
+    model.addConnection(ConnectionId{ firstId, 0u, secondId, 0u });
+    model.addConnection(ConnectionId{ secondId, 0u, collectorId, 0u });
+
+    const auto plan = ExecutionPlan::compile(&model);
+    EXPECT_EQ(plan->node(plan->indexOf(sourceId)).fusedSuccessor, plan->indexOf(firstId));
+    EXPECT_EQ(plan->node(plan->indexOf(firstId)).fusedSuccessor, plan->indexOf(secondId));
+    EXPECT_EQ(plan->node(plan->indexOf(secondId)).fusedSuccessor, plan->indexOf(collectorId));
+
+    for (const auto mode : {ExecutionEngine::SchedulerMode::GlobalQueue, ExecutionEngine::SchedulerMode::WorkStealing}) {
+        threads->clear();
+        received->clear();
+
+        ExecutionEngine engine(&model);
+        engine.setSchedulerMode(mode);
+        QMutex statusMutex;
+        QHash<QUuid, QList<int>> statuses;
+        QObject::connect(&engine, &ExecutionEngine::nodeStatusChanged, &engine, [&](const QUuid& uuid, int state) {
+            QMutexLocker locker(&statusMutex);
+            statuses[uuid].append(state);
+        }, Qt::DirectConnection);
+        bool finished = false;
+        QEventLoop loop;
+        QObject::connect(&engine, &ExecutionEngine::pipelineFinished, &loop, [&](const DataPacket&) {
+            finished = true;
+            loop.quit();
+        });
+        QTimer::singleShot(10000, &loop, &QEventLoop::quit);
+        engine.Run();
+        if (!finished) loop.exec();
+
+        ASSERT_TRUE(finished) << "Engine did not finish within timeout";
+        ASSERT_EQ(threads->size(), 2);
+        EXPECT_EQ(threads->at(0), threads->at(1));
+        EXPECT_EQ(*received, QStringList{QStringLiteral("0")});
+
+        // Fused links still report Running then Finished for highlighting
+        const QList<int> expected{static_cast<int>(ExecutionState::Idle), static_cast<int>(ExecutionState::Running),
+                                  static_cast<int>(ExecutionState::Finished)};
+        QMutexLocker locker(&statusMutex);
+        for (const NodeId nodeId : {firstId, secondId, collectorId}) {
+            EXPECT_EQ(statuses.value(ExecIds::nodeUuid(model.executionScopeKey(), nodeId)), expected);
+        }
+    }
+}
+
+TEST(ExecutionEngineTest, RunFinishesOnceWhenOutstandingWorkReachesZero)
+{
+    ensureApp();
+
+    // Nothing to execute: the seeding hold is the only work, so Run() finishes inline
+    {
+        NodeGraphModel empty;
+        ExecutionEngine engine(&empty);
+        int finishedCount = 0;
+        QObject::connect(&engine, &ExecutionEngine::pipelineFinished, &engine,
+                         [&](const DataPacket&) { ++finishedCount; });
+        engine.Run();
+        EXPECT_EQ(finishedCount, 1);
+    }
+
+    const auto received = std::make_shared<QStringList>();
+    const auto collectorOverlap = std::make_shared<OverlapCounter>();
+    NodeGraphModel model;
+    model.dataModelRegistry()->registerModel([]() {
+        return std::make_unique<ToolNodeDelegate>(std::make_shared<ItemSourceNode>(5));
+    }, QStringLiteral("Mocks"));
+    model.dataModelRegistry()->registerModel([received, collectorOverlap]() {
+        return std::make_unique<ToolNodeDelegate>(std::make_shared<CollectorNode>(received, collectorOverlap));
+    }, QStringLiteral("Mocks"));
+    const NodeId sourceId = model.addNode(QStringLiteral("item-source"));
+    const NodeId collectorId = model.addNode(QStringLiteral("collector"));
+    model.addConnection(ConnectionId{ sourceId, 0u, collectorId, 0u });
+
+    for (const auto mode : {ExecutionEngine::SchedulerMode::GlobalQueue, ExecutionEngine::SchedulerMode::WorkStealing}) {
+        received->clear();
+        ExecutionEngine engine(&model);
+        engine.setSchedulerMode(mode);
+        std::atomic<int> finishedCount {0};
+        QEventLoop loop;
+        QObject::connect(&engine, &ExecutionEngine::pipelineFinished, &loop, [&](const DataPacket&) {
+            // Every task is done by the time the run reports
+            EXPECT_EQ(received->size(), 5);
+            EXPECT_EQ(engine.activeTaskCount(), 0);
+            EXPECT_EQ(engine.queuedTaskCount(), 0);
+            ++finishedCount;
+            loop.quit();
+        });
+        QTimer::singleShot(10000, &loop, &QEventLoop::quit);
+        engine.Run();
+        if (finishedCount.load() == 0) loop.exec();
+        // Late completions don't report the run a second time
+        QCoreApplication::processEvents();
+        EXPECT_EQ(finishedCount.load(), 1);
+    }
+}
+
+TEST(ExecutionEngineTest, TokenIdsAreRunScopedSerials)
+{
+    const QUuid run = QUuid::createUuid();
+    const QUuid other = QUuid::createUuid();
+    const QUuid first = ExecIds::tokenUuid(run, 1);
+    const QUuid second = ExecIds::tokenUuid(run, 2);
+
+    EXPECT_FALSE(first.isNull());
+    EXPECT_NE(first, second);
+    EXPECT_EQ(first, ExecIds::tokenUuid(run, 1));
+    EXPECT_NE(first, ExecIds::tokenUuid(other, 1));
+    // Same run prefix, serial in the low bytes
+    EXPECT_EQ(first.data1, run.data1);
+    EXPECT_EQ(second.data4[7], 2);
+    EXPECT_EQ(ExecIds::tokenUuid(run, quint64(1) << 56).data4[0], 1);
+
+    // Token lists share their storage until one of them changes
+    TokenList tokens{ExecutionToken{}};
+    const TokenList copy = tokens;
+    EXPECT_EQ(copy.constData(), tokens.constData());
+    tokens.push_back(ExecutionToken{});
+    EXPECT_EQ(copy.size(), 1);
+}
+
+TEST(ExecutionEngineTest, WorkStealingModeRunsPipeline)
+{
+    ensureApp();
+
+    NodeGraphModel model;
+    NodeId textNodeId = model.addNode(QStringLiteral("text-input"));
+    NodeId promptNodeId = model.addNode(QStringLiteral("prompt-builder"));
+    ASSERT_NE(textNodeId, InvalidNodeId);
+    ASSERT_NE(promptNodeId, InvalidNodeId);
+    model.addConnection(ConnectionId{ textNodeId, 0u, promptNodeId, 0u });
+
+    auto* textTool = dynamic_cast<TextInputNode*>(model.delegateModel<ToolNodeDelegate>(textNodeId)->node().get());
+    ASSERT_NE(textTool, nullptr);
+    textTool->setText(QStringLiteral("Bob"));
+    auto* promptTool = dynamic_cast<PromptBuilderNode*>(model.delegateModel<ToolNodeDelegate>(promptNodeId)->node().get());
+    ASSERT_NE(promptTool, nullptr);
+    promptTool->setTemplateText(QStringLiteral("Hello {input}!"));
+
+    ExecutionEngine engine(&model);
+    engine.setSchedulerMode(ExecutionEngine::SchedulerMode::WorkStealing);
+
+    bool finished = false;
+    DataPacket finalOut;
+    QObject::connect(&engine, &ExecutionEngine::pipelineFinished, &engine, [&](const DataPacket& out) {
+        finished = true;
+        finalOut = out;
+    });
+
+    engine.Run();
+
+    QEventLoop loop;
+    QTimer timeout;
+    timeout.setSingleShot(true);
+    QObject::connect(&timeout, &QTimer::timeout, &loop, &QEventLoop::quit);
+    QObject::connect(&engine, &ExecutionEngine::pipelineFinished, &loop, &QEventLoop::quit);
+    timeout.start(5000);
+    if (!finished) loop.exec();
+
+    ASSERT_TRUE(finished) << "Engine did not finish within timeout";
+    EXPECT_EQ(finalOut.value(QStringLiteral("prompt")).toString(), QStringLiteral("Hello Bob!"));
+}
+
+TEST(ExecutionEngineTest, WorkStealingSchedulerFollowsLaneCountChanges)
+{
+    QThreadPool pool;
+    pool.setMaxThreadCount(4);
+    std::atomic<int> done {0};
+    {
+        WorkStealingScheduler scheduler(&pool);
+        EXPECT_EQ(scheduler.laneCount(), 4);
+
+        QMutex gate;
+        gate.lock();
+        for (int i = 0; i < 64; ++i) {
+            scheduler.post(i % 3 * 100, [&]() {
+                QMutexLocker locker(&gate);
+                ++done;
+            });
+        }
+        // Jobs still queued on retired lanes must move to the remaining one
+        pool.setMaxThreadCount(1);
+        scheduler.setLaneCount(1);
+        EXPECT_EQ(scheduler.laneCount(), 1);
+        gate.unlock();
+
+        pool.setMaxThreadCount(8);
+        scheduler.setLaneCount(8);
+        for (int i = 0; i < 64; ++i) scheduler.post(0, [&]() { ++done; });
+        QDeadlineTimer deadline(5000);
+        while (done.load() < 128 && !deadline.hasExpired()) QThread::msleep(5);
+        EXPECT_EQ(scheduler.laneCount(), 8);
+    }
+    EXPECT_EQ(done.load(), 128);
+}
+
+TEST(ExecutionEngineTest, ReentrantNodesRunConcurrentlyAndKeepOutputOrder)
+{
+    ensureApp();
+
+    const int items = 8;
+    const auto echoOverlap = std::make_shared<OverlapCounter>();
+    const auto collectorOverlap = std::make_shared<OverlapCounter>();
+    const auto received = std::make_shared<QStringList>();
+
+    NodeGraphModel model;
+    model.dataModelRegistry()->registerModel([items]() {
+        return std::make_unique<ToolNodeDelegate>(std::make_shared<ItemSourceNode>(items));
+    }, QStringLiteral("Mocks"));
+    model.dataModelRegistry()->registerModel([echoOverlap, items]() {
+        return std::make_unique<ToolNodeDelegate>(std::make_shared<SlowEchoNode>(echoOverlap, items));
+    }, QStringLiteral("Mocks"));
+    model.dataModelRegistry()->registerModel([received, collectorOverlap]() {
+        return std::make_unique<ToolNodeDelegate>(std::make_shared<CollectorNode>(received, collectorOverlap));
+    }, QStringLiteral("Mocks"));
+    const NodeId sourceId = model.addNode(QStringLiteral("item-source"));
+    const NodeId echoId = model.addNode(QStringLiteral("slow-echo"));
+    const NodeId collectorId = model.addNode(QStringLiteral("collector"));
+    ASSERT_NE(sourceId, InvalidNodeId);
+    ASSERT_NE(echoId, InvalidNodeId);
+    ASSERT_NE(collectorId, InvalidNodeId);
+    model.addConnection(ConnectionId{ sourceId, 0u, echoId, 0u });
+    model.addConnection(ConnectionId{ echoId, 0u, collectorId, 0u });
+
+    auto* echoDelegate = model.delegateModel<ToolNodeDelegate>(echoId);
+    echoDelegate->setMaxConcurrentExecutions(4);
+    // Not reentrant, so the setting is ignored
+    model.delegateModel<ToolNodeDelegate>(collectorId)->setMaxConcurrentExecutions(4);
+
+    QStringList expected;
+    for (int i = 0; i < items; ++i) expected.append(QString::number(i));
+
+    for (const auto mode : {ExecutionEngine::SchedulerMode::GlobalQueue, ExecutionEngine::SchedulerMode::WorkStealing}) {
+        received->clear();
+        echoOverlap->peak = 0;
+        collectorOverlap->peak = 0;
+
+        ExecutionEngine engine(&model);
+        engine.setSchedulerMode(mode);
+        ResourceBudgets budgets;
+        budgets.setLimit(ResourceClass::Cpu, 8);
+        engine.setResourceBudgets(budgets);
+        bool finished = false;
+        QEventLoop loop;
+        QObject::connect(&engine, &ExecutionEngine::pipelineFinished, &loop, [&](const DataPacket&) {
+            finished = true;
+            loop.quit();
+        });
+        QTimer::singleShot(10000, &loop, &QEventLoop::quit);
+        engine.Run();
+        if (!finished) loop.exec();
+
+        ASSERT_TRUE(finished) << "Engine did not finish within timeout";
+        EXPECT_GT(echoOverlap->peak.load(), 1);
+        EXPECT_LE(echoOverlap->peak.load(), 4);
+        EXPECT_EQ(collectorOverlap->peak.load(), 1);
+        // Later items finished first, but reach the collector in input order
+        EXPECT_EQ(*received, expected);
+    }
+
+    // The setting is saved with the node
+    QJsonObject saved = echoDelegate->save();
+    EXPECT_EQ(saved.value(QStringLiteral("max-concurrent-executions")).toInt(), 4);
+    echoDelegate->setPreservesOutputOrder(false);
+    ToolNodeDelegate restored(std::make_shared<SlowEchoNode>(echoOverlap, items));
+    restored.load(echoDelegate->save());
+    EXPECT_EQ(restored.maxConcurrentExecutions(), 4);
+    EXPECT_FALSE(restored.preservesOutputOrder());
+}
+
+TEST(ExecutionEngineTest, TransientFailuresAreRetriedAfterTheirBackoff)
+{
+    ensureApp();
+
+    const auto attempts = std::make_shared<QList<bool>>();
+    int failures = 2;
+    NodeGraphModel model;
+    model.dataModelRegistry()->registerModel([&failures, attempts]() {
+        return std::make_unique<ToolNodeDelegate>(std::make_shared<FlakySourceNode>(failures, 20, attempts));
+    }, QStringLiteral("Mocks"));
+    const NodeId flakyId = model.addNode(QStringLiteral("flaky-source"));
+    ASSERT_NE(flakyId, InvalidNodeId);
+    auto* delegate = model.delegateModel<ToolNodeDelegate>(flakyId);
+    RetryPolicy policy;
+    policy.maxAttempts = 3;
+    policy.baseDelayMs = 5;
+    delegate->setRetryPolicy(policy);
+
+    const auto run = [&](ExecutionEngine::SchedulerMode mode, DataPacket& output) {
+        ExecutionEngine engine(&model);
+        engine.setSchedulerMode(mode);
+        bool finished = false;
+        QEventLoop loop;
+        QObject::connect(&engine, &ExecutionEngine::pipelineFinished, &loop, [&](const DataPacket&) {
+            finished = true;
+            loop.quit();
+        });
+        QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+        engine.Run();
+        if (!finished) loop.exec();
+        output = engine.nodeOutput(flakyId);
+        return finished;
+    };
+
+    for (const auto mode : {ExecutionEngine::SchedulerMode::GlobalQueue, ExecutionEngine::SchedulerMode::WorkStealing}) {
+        attempts->clear();
+        DataPacket output;
+        QElapsedTimer elapsed;
+        elapsed.start();
+        ASSERT_TRUE(run(mode, output)) << "Engine did not finish within timeout";
+        // Two failures, each followed by at least its 20 ms Retry-After
+        EXPECT_GE(elapsed.elapsed(), 40);
+        EXPECT_EQ(*attempts, (QList<bool>{true, true, false}));
+        EXPECT_EQ(output.value(QStringLiteral("out")).toString(), QStringLiteral("ok"));
+        EXPECT_FALSE(output.contains(QStringLiteral("__error")));
+    }
+
+    // Once the attempts are used up the last failure goes out as it is
+    failures = 5;
+    model.deleteNode(flakyId);
+    const NodeId exhaustedId = model.addNode(QStringLiteral("flaky-source"));
+    ASSERT_NE(exhaustedId, InvalidNodeId);
+    policy.maxAttempts = 2;
+    model.delegateModel<ToolNodeDelegate>(exhaustedId)->setRetryPolicy(policy);
+    attempts->clear();
+    {
+        ExecutionEngine engine(&model);
+        bool finished = false;
+        QEventLoop loop;
+        QObject::connect(&engine, &ExecutionEngine::pipelineFinished, &loop, [&](const DataPacket&) {
+            finished = true;
+            loop.quit();
+        });
+        QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+        engine.Run();
+        if (!finished) loop.exec();
+        ASSERT_TRUE(finished) << "Engine did not finish within timeout";
+        EXPECT_EQ(attempts->size(), 2);
+        EXPECT_EQ(engine.nodeOutput(exhaustedId).value(QStringLiteral("__error")).toString(), QStringLiteral("HTTP 503"));
+    }
+
+    // The policy is saved with the node
+    ToolNodeDelegate restored(std::make_shared<FlakySourceNode>(0, 0, attempts));
+    restored.load(model.delegateModel<ToolNodeDelegate>(exhaustedId)->save());
+    EXPECT_EQ(restored.retryPolicy().maxAttempts, 2);
+    EXPECT_EQ(restored.retryPolicy().baseDelayMs, 5);
+    EXPECT_FALSE(ToolNodeDelegate(std::make_shared<FlakySourceNode>(0, 0, attempts)).save()
+                     .contains(QStringLiteral("retry-attempts")));
+}
+
+TEST(ExecutionEngineTest, DefaultExecuteAsyncWrapsExecute)
+{
+    ensureApp();
+
+    TextInputNode node;
+    node.setText(QStringLiteral("Bob"));
+    EXPECT_FALSE(node.supportsAsyncExecution());
+
+    QFuture<TokenList> future = node.executeAsync(TokenList{});
+    ASSERT_TRUE(future.isFinished());
+    const TokenList tokens = future.result();
+    ASSERT_EQ(tokens.size(), 1u);
+    EXPECT_EQ(tokens.front().data.value(QStringLiteral("text")).toString(), QStringLiteral("Bob"));
+}
+
+TEST(ExecutionEngineTest, IndependentRunsKeepSeparateDataLakes)
+{
+    ensureApp();
+
+    NodeGraphModel model;
+    NodeId textNodeId = model.addNode(QStringLiteral("text-input"));
+    NodeId promptNodeId = model.addNode(QStringLiteral("prompt-builder"));
+    ASSERT_NE(textNodeId, InvalidNodeId);
+    ASSERT_NE(promptNodeId, InvalidNodeId);
+    model.addConnection(ConnectionId{ textNodeId, 0u, promptNodeId, 0u });
+
+    auto* promptTool = dynamic_cast<PromptBuilderNode*>(model.delegateModel<ToolNodeDelegate>(promptNodeId)->node().get());
+    ASSERT_NE(promptTool, nullptr);
+    promptTool->setTemplateText(QStringLiteral("Hello {input}!"));
+
+    ExecutionEngine engine(&model);
+    const QUuid textUuid = ExecIds::nodeUuid(model.executionScopeKey(), textNodeId);
+
+    QHash<QUuid, QString> prompts;
+    QEventLoop loop;
+    QObject::connect(&engine, &ExecutionEngine::runFinished, &loop,
+                     [&](const QUuid& runId, const DataPacket& out, bool succeeded) {
+        EXPECT_TRUE(succeeded);
+        prompts.insert(runId, out.value(QStringLiteral("prompt")).toString());
+        if (prompts.size() == 3) loop.quit();
+    });
+    bool foregroundFinished = false;
+    QObject::connect(&engine, &ExecutionEngine::pipelineFinished, &engine, [&](const DataPacket&) {
+        foregroundFinished = true;
+    });
+
+    QHash<QUuid, QString> expected;
+    for (const QString& name : {QStringLiteral("Ann"), QStringLiteral("Ben"), QStringLiteral("Cy")}) {
+        QHash<QUuid, QVariantMap> preset;
+        preset.insert(textUuid, QVariantMap{{QStringLiteral("text"), name}});
+        expected.insert(engine.startIndependentRun(preset), QStringLiteral("Hello %1!").arg(name));
+    }
+
+    QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+    if (prompts.size() < 3) loop.exec();
+
+    EXPECT_EQ(prompts, expected);
+    EXPECT_FALSE(foregroundFinished);
+}
+
+TEST(ExecutionEngineTest, RunsWithADeadlineOvertakeQueuedBatchRuns)
+{
+    ensureApp();
+
+    NodeGraphModel model;
+    NodeId textNodeId = model.addNode(QStringLiteral("text-input"));
+    NodeId promptNodeId = model.addNode(QStringLiteral("prompt-builder"));
+    ASSERT_NE(textNodeId, InvalidNodeId);
+    ASSERT_NE(promptNodeId, InvalidNodeId);
+    model.addConnection(ConnectionId{ textNodeId, 0u, promptNodeId, 0u });
+
+    auto* promptTool = dynamic_cast<PromptBuilderNode*>(model.delegateModel<ToolNodeDelegate>(promptNodeId)->node().get());
+    ASSERT_NE(promptTool, nullptr);
+    promptTool->setTemplateText(QStringLiteral("Hello {input}!"));
+
+    // One task at a time, so the queue order decides the finishing order
+    ExecutionEngine engine(&model);
+    ResourceBudgets budgets;
+    budgets.setLimit(ResourceClass::Cpu, 1);
+    engine.setResourceBudgets(budgets);
+    const QUuid textUuid = ExecIds::nodeUuid(model.executionScopeKey(), textNodeId);
+
+    QList<QUuid> finished;
+    QEventLoop loop;
+    QObject::connect(&engine, &ExecutionEngine::runFinished, &loop,
+                     [&](const QUuid& runId, const DataPacket&, bool succeeded) {
+        EXPECT_TRUE(succeeded);
+        finished.append(runId);
+        if (finished.size() == 5) loop.quit();
+    });
+
+    const auto presetFor = [&](const QString& name) {
+        QHash<QUuid, QVariantMap> preset;
+        preset.insert(textUuid, QVariantMap{{QStringLiteral("text"), name}});
+        return preset;
+    };
+    QList<QUuid> batch;
+    for (int i = 0; i < 4; ++i) {
+        batch.append(engine.startIndependentRun(presetFor(QStringLiteral("batch %1").arg(i)),
+                                                ExecutionEngine::TaskPriority::Low));
+    }
+    const QUuid interactive = engine.startIndependentRun(presetFor(QStringLiteral("interactive")),
+                                                         ExecutionEngine::TaskPriority::Normal, QDeadlineTimer(10000));
+
+    QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+    if (finished.size() < 5) loop.exec();
+
+    ASSERT_EQ(finished.size(), 5);
+    // At most the batch run already executing when it arrived finishes first
+    EXPECT_LE(finished.indexOf(interactive), 1);
+    EXPECT_EQ(finished.last(), batch.last());
+}
+
+TEST(ExecutionEngineTest, CoalescedOutputNotificationsArriveBeforeFinish)
+{
+    ensureApp();
+
+    NodeGraphModel model;
+    NodeId textNodeId = model.addNode(QStringLiteral("text-input"));
+    NodeId promptNodeId = model.addNode(QStringLiteral("prompt-builder"));
+    ASSERT_NE(textNodeId, InvalidNodeId);
+    ASSERT_NE(promptNodeId, InvalidNodeId);
+    model.addConnection(ConnectionId{ textNodeId, 0u, promptNodeId, 0u });
+
+    auto* textTool = dynamic_cast<TextInputNode*>(model.delegateModel<ToolNodeDelegate>(textNodeId)->node().get());
+    ASSERT_NE(textTool, nullptr);
+    textTool->setText(QStringLiteral("Bob"));
+
+    ExecutionEngine engine(&model);
+    engine.setOutputNotificationMode(ExecutionEngine::OutputNotificationMode::Coalesced);
+
+    QHash<NodeId, int> notifications;
+    QObject::connect(&engine, &ExecutionEngine::nodeOutputChanged, &engine, [&](NodeId nodeId) {
+        notifications[nodeId] += 1;
+    });
+
+    bool finished = false;
+    QHash<NodeId, int> seenAtFinish;
+    QObject::connect(&engine, &ExecutionEngine::pipelineFinished, &engine, [&](const DataPacket&) {
+        finished = true;
+        seenAtFinish = notifications;
+    });
+
+    engine.Run();
+
+    QEventLoop loop;
+    QTimer timeout;
+    timeout.setSingleShot(true);
+    QObject::connect(&timeout, &QTimer::timeout, &loop, &QEventLoop::quit);
+    QObject::connect(&engine, &ExecutionEngine::pipelineFinished, &loop, &QEventLoop::quit);
+    timeout.start(5000);
+    if (!finished) loop.exec();
+
+    ASSERT_TRUE(finished) << "Engine did not finish within timeout";
+    EXPECT_EQ(seenAtFinish.value(textNodeId), 1);
+    EXPECT_EQ(seenAtFinish.value(promptNodeId), 1);
+}
+
+TEST(ExecutionEngineTest, IncrementalRunExecutesOnlyDirtyCone)
+{
+    ensureApp();
+
+    NodeGraphModel model;
+    NodeId textNodeId = model.addNode(QStringLiteral("text-input"));
+    NodeId promptNodeId = model.addNode(QStringLiteral("prompt-builder"));
+    ASSERT_NE(textNodeId, InvalidNodeId);
+    ASSERT_NE(promptNodeId, InvalidNodeId);
+    model.addConnection(ConnectionId{ textNodeId, 0u, promptNodeId, 0u });
+
+    auto* textTool = dynamic_cast<TextInputNode*>(model.delegateModel<ToolNodeDelegate>(textNodeId)->node().get());
+    ASSERT_NE(textTool, nullptr);
+    textTool->setText(QStringLiteral("Bob"));
+    auto* promptTool = dynamic_cast<PromptBuilderNode*>(model.delegateModel<ToolNodeDelegate>(promptNodeId)->node().get());
+    ASSERT_NE(promptTool, nullptr);
+    promptTool->setTemplateText(QStringLiteral("Hello {input}!"));
+
+    ExecutionEngine engine(&model);
+
+    QStringList executed;
+    QObject::connect(&engine, &ExecutionEngine::nodeLog, &engine, [&executed](const QString& msg) {
+        if (msg.startsWith(QLatin1String("Executing Node:"))) executed << msg;
+    });
+
+    DataPacket finalOut;
+    auto runAndWait = [&](ExecutionEngine::RunMode mode) {
+        bool finished = false;
+        QEventLoop loop;
+        auto conn = QObject::connect(&engine, &ExecutionEngine::pipelineFinished, &loop, [&](const DataPacket& out) {
+            finished = true;
+            finalOut = out;
+            loop.quit();
+        });
+        QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+        executed.clear();
+        engine.runPipeline({}, ExecutionEngine::TaskPriority::Normal, mode);
+        if (!finished) loop.exec();
+        QObject::disconnect(conn);
+        return finished;
+    };
+
+    // Without a baseline an incremental run executes everything
+    ASSERT_TRUE(runAndWait(ExecutionEngine::RunMode::Incremental));
+    EXPECT_EQ(executed.size(), 2);
+    EXPECT_EQ(finalOut.value(QStringLiteral("prompt")).toString(), QStringLiteral("Hello Bob!"));
+
+    // Only the edited downstream node re-runs; the text input value comes from the last run
+    promptTool->setTemplateText(QStringLiteral("Bye {input}!"));
+    ASSERT_TRUE(runAndWait(ExecutionEngine::RunMode::Incremental));
+    ASSERT_EQ(executed.size(), 1);
+    EXPECT_NE(executed.first().indexOf(QLatin1String("Prompt Builder")), -1);
+    EXPECT_EQ(finalOut.value(QStringLiteral("prompt")).toString(), QStringLiteral("Bye Bob!"));
+
+    // Nothing changed: nothing executes and the previous outputs are reported
+    ASSERT_TRUE(runAndWait(ExecutionEngine::RunMode::Incremental));
+    EXPECT_TRUE(executed.isEmpty());
+    EXPECT_EQ(finalOut.value(QStringLiteral("prompt")).toString(), QStringLiteral("Bye Bob!"));
+}
+
+TEST(ExecutionEngineTest, QuietLogVerbositySkipsPerTaskLines)
+{
+    ensureApp();
+
+    NodeGraphModel model;
+    NodeId textNodeId = model.addNode(QStringLiteral("text-input"));
+    ASSERT_NE(textNodeId, InvalidNodeId);
+
+    ExecutionEngine engine(&model);
+    engine.setLogVerbosity(ExecutionEngine::LogVerbosity::Quiet);
+
+    QStringList messages;
+    QObject::connect(&engine, &ExecutionEngine::nodeLog, &engine, [&messages](const QString& msg) {
+        messages << msg;
+    });
+
+    bool finished = false;
+    QObject::connect(&engine, &ExecutionEngine::pipelineFinished, &engine, [&](const DataPacket&) {
+        finished = true;
+    });
+
+    engine.Run();
+
+    QEventLoop loop;
+    QTimer timeout;
+    timeout.setSingleShot(true);
+    QObject::connect(&timeout, &QTimer::timeout, &loop, &QEventLoop::quit);
+    QObject::connect(&engine, &ExecutionEngine::pipelineFinished, &loop, &QEventLoop::quit);
+    timeout.start(5000);
+    if (!finished) loop.exec();
+
+    ASSERT_TRUE(finished) << "Engine did not finish within timeout";
+    EXPECT_FALSE(messages.join(QLatin1Char('\n')).contains(QLatin1String("Executing Node:")));
+    EXPECT_TRUE(messages.contains(QStringLiteral("ExecutionEngine: Chain finished.")));
+}
+
+TEST(ExecutionEngineTest, NodeOutputDirIsCreatedOnFirstUse)
+{
+    QTemporaryDir root;
+    ASSERT_TRUE(root.isValid());
+    const QString dir = root.filePath(QStringLiteral("Node_1/Run_0"));
+
+    QVariantMap inputs;
+    EXPECT_TRUE(NodeOutputDir::materialize(inputs).isEmpty());
+
+    inputs.insert(NodeOutputDir::inputKey(), dir);
+    EXPECT_FALSE(QFileInfo::exists(dir));
+    EXPECT_EQ(NodeOutputDir::materialize(inputs), dir);
+    EXPECT_TRUE(QFileInfo(dir).isDir());
+}
+
 TEST(ExecutionEngineTest, LogsComplexTypesAsJson)
 {
     QVariantList list;
@@ -246,3 +1326,101 @@ TEST(ExecutionEngineTest, SlowMotionDelaysFirstDownstreamDispatch)
     EXPECT_GE(observedMs, 150);
     EXPECT_LT(observedMs, 1000);
 }
+
+TEST(ExecutionStateModelTest, CoalescesStateChangesIntoOneFlushPerFrame)
+{
+    ensureApp();
+
+    ExecutionStateModel model;
+    QList<QList<QUuid>> flushes;
+    QObject::connect(&model, &ExecutionStateModel::itemsChanged, &model,
+                     [&](const QList<QUuid>& ids) { flushes.append(ids); });
+
+    // A loop's worth of Running/Finished pairs for one node and its incoming connection
+    const QUuid node = QUuid::createUuid();
+    const QUuid connection = QUuid::createUuid();
+    for (int i = 0; i < 1000; ++i) {
+        model.onNodeStatusChanged(node, static_cast<int>(ExecutionState::Running));
+        model.onConnectionStatusChanged(connection, static_cast<int>(ExecutionState::Running));
+        model.onNodeStatusChanged(node, static_cast<int>(ExecutionState::Finished));
+        model.onConnectionStatusChanged(connection, static_cast<int>(ExecutionState::Finished));
+    }
+    EXPECT_TRUE(flushes.isEmpty());
+    EXPECT_EQ(model.stateFor(node), ExecutionState::Finished);
+
+    QElapsedTimer timer;
+    timer.start();
+    while (flushes.isEmpty() && timer.elapsed() < 2000) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 20);
+    }
+    ASSERT_EQ(flushes.size(), 1);
+    EXPECT_EQ(QSet<QUuid>(flushes.first().cbegin(), flushes.first().cend()), (QSet<QUuid>{node, connection}));
+
+    // An open batch holds the flush back, even when asked for one
+    {
+        ExecutionStateModel::Batch batch(model);
+        model.onNodeStatusChanged(node, static_cast<int>(ExecutionState::Idle));
+        model.flush();
+        EXPECT_EQ(flushes.size(), 1);
+    }
+    model.flush();
+    ASSERT_EQ(flushes.size(), 2);
+    EXPECT_EQ(flushes.last(), QList<QUuid>{node});
+
+    // Changes from a worker thread are flushed on the model's thread
+    const QUuid other = QUuid::createUuid();
+    QThread* worker = QThread::create([&]() {
+        model.onNodeStatusChanged(other, static_cast<int>(ExecutionState::Running));
+    });
+    worker->start();
+    worker->wait();
+    delete worker;
+    timer.restart();
+    while (flushes.size() < 3 && timer.elapsed() < 2000) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 20);
+    }
+    ASSERT_EQ(flushes.size(), 3);
+    EXPECT_EQ(flushes.last(), QList<QUuid>{other});
+    EXPECT_EQ(model.flushCount(), 3u);
+}
+
+TEST(CanvasDetailControllerTest, HidesEmbeddedWidgetsOffScreenAndWhenZoomedOut)
+{
+    ensureApp();
+
+    QGraphicsScene scene;
+    scene.setSceneRect(-5000, -5000, 10000, 10000);
+    auto* nearNode = scene.addRect(0, 0, 100, 60);
+    auto* farNode = scene.addRect(4000, 4000, 100, 60);
+    auto* nearProxy = new QGraphicsProxyWidget(nearNode);
+    nearProxy->setWidget(new QLabel(QStringLiteral("near")));
+    auto* farProxy = new QGraphicsProxyWidget(farNode);
+    farProxy->setWidget(new QLabel(QStringLiteral("far")));
+    // Hidden by someone else: left alone
+    auto* ownHidden = new QGraphicsProxyWidget(nearNode);
+    ownHidden->setWidget(new QLabel(QStringLiteral("hidden")));
+    ownHidden->setVisible(false);
+
+    QGraphicsView view(&scene);
+    view.resize(400, 300);
+    view.show();
+    view.centerOn(nearNode);
+    CanvasDetailController controller(&view);
+
+    controller.refresh();
+    EXPECT_TRUE(nearProxy->isVisible());
+    EXPECT_FALSE(farProxy->isVisible());
+
+    view.scale(0.2, 0.2);
+    controller.refresh();
+    EXPECT_FALSE(nearProxy->isVisible());
+
+    view.resetTransform();
+    view.centerOn(farNode);
+    controller.refresh();
+    EXPECT_FALSE(nearProxy->isVisible());
+    EXPECT_TRUE(farProxy->isVisible());
+    EXPECT_FALSE(ownHidden->isVisible());
+}
+
+#include "test_execution_engine.moc"
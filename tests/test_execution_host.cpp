@@ -67,3 +67,29 @@ TEST(ExecutionScriptHostTest, ErrorSetting) {
     
     EXPECT_TRUE(logs.contains("Error: Something went wrong") || logs.size() > 0);
 }
+
+TEST(ExecutionScriptHostTest, TokenSnapshotsAreBuiltOnDemand) {
+    ExecutionToken first;
+    first.data.insert(QStringLiteral("a"), 1);
+    ExecutionToken empty;
+    ExecutionToken second;
+    second.data.insert(QStringLiteral("a"), 2);
+    const TokenList tokens{first, empty, second};
+
+    DataPacket in;
+    in.insert(QStringLiteral("a"), 2);
+    DataPacket out;
+    QList<QString> logs;
+    ExecutionScriptHost host(in, tokens, out, logs);
+
+    EXPECT_EQ(host.getInput(QStringLiteral("a")).toInt(), 2);
+    const QVariantList snapshots = host.getInput(QStringLiteral("_tokens")).toList();
+    ASSERT_EQ(snapshots.size(), 2);
+    EXPECT_EQ(snapshots.at(0).toMap().value(QStringLiteral("a")).toInt(), 1);
+    EXPECT_EQ(snapshots.at(1).toMap().value(QStringLiteral("a")).toInt(), 2);
+
+    // Without tokens carrying data there is no list, as before
+    const TokenList blank{empty};
+    ExecutionScriptHost bare(in, blank, out, logs);
+    EXPECT_FALSE(bare.getInput(QStringLiteral("_tokens")).isValid());
+}
@@ -0,0 +1,533 @@
+#include <gtest/gtest.h>
+
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTimer>
+
+#include <functional>
+
+#include "test_app.h"
+#include "BlobHandle.h"
+#include <QtNodes/internal/Definitions.hpp>
+#include "ExecutionEngine.h"
+#include "ExecutionIdUtils.h"
+#include "ExecutionPlan.h"
+#include "ExecutionTrace.h"
+#include "NodeGraphModel.h"
+#include "RunAnalysis.h"
+#include "RunCheckpoint.h"
+#include "RunHistory.h"
+#include "RunRecording.h"
+#include "RunUsageReport.h"
+#include "TextInputNode.h"
+#include "ToolNodeDelegate.h"
+
+using namespace QtNodes;
+
+namespace {
+
+QJsonArray eventsWithPhase(const QJsonArray& events, const QString& phase)
+{
+    QJsonArray matching;
+    for (const auto& value : events) {
+        if (value.toObject().value(QStringLiteral("ph")).toString() == phase) matching.append(value);
+    }
+    return matching;
+}
+
+ExecutionTrace::Span taskSpan(NodeId nodeId, qint64 queuedUs, qint64 startUs, qint64 endUs, quintptr thread)
+{
+    ExecutionTrace::Span span;
+    span.name = QStringLiteral("node %1").arg(nodeId);
+    span.category = QStringLiteral("node");
+    span.nodeId = QString::number(nodeId);
+    span.queuedUs = queuedUs;
+    span.startUs = startUs;
+    span.endUs = endUs;
+    span.threadId = thread;
+    return span;
+}
+
+} // namespace
+
+TEST(ExecutionTraceTest, ExportsCompleteEventsWithQueueWait)
+{
+    ExecutionTrace trace(QUuid::createUuid());
+    ExecutionTrace::Span span;
+    span.name = QStringLiteral("Prompt");
+    span.category = QStringLiteral("node");
+    span.nodeId = QStringLiteral("7");
+    span.nodeType = QStringLiteral("Prompt Builder");
+    span.queuedUs = 100;
+    span.startUs = 250;
+    span.endUs = 1250;
+    span.threadId = 42;
+    span.inputBytes = 10;
+    span.outputBytes = 20;
+    trace.record(span);
+
+    const QJsonObject root = QJsonDocument::fromJson(trace.toChromeTraceJson()).object();
+    const QJsonArray events = root.value(QStringLiteral("traceEvents")).toArray();
+
+    const QJsonArray complete = eventsWithPhase(events, QStringLiteral("X"));
+    ASSERT_EQ(complete.size(), 1);
+    const QJsonObject event = complete.first().toObject();
+    EXPECT_EQ(event.value(QStringLiteral("name")).toString(), QStringLiteral("Prompt"));
+    EXPECT_EQ(event.value(QStringLiteral("ts")).toInteger(), 250);
+    EXPECT_EQ(event.value(QStringLiteral("dur")).toInteger(), 1000);
+    const QJsonObject args = event.value(QStringLiteral("args")).toObject();
+    EXPECT_EQ(args.value(QStringLiteral("node_id")).toString(), QStringLiteral("7"));
+    EXPECT_EQ(args.value(QStringLiteral("queue_wait_us")).toInteger(), 150);
+    EXPECT_EQ(args.value(QStringLiteral("output_bytes")).toInteger(), 20);
+    EXPECT_EQ(args.value(QStringLiteral("run_id")).toString(), trace.runId().toString(QUuid::WithoutBraces));
+
+    EXPECT_EQ(eventsWithPhase(events, QStringLiteral("b")).size(), 1);
+    EXPECT_EQ(eventsWithPhase(events, QStringLiteral("e")).size(), 1);
+}
+
+TEST(ExecutionTraceTest, CountsSharedBlobsOnceAndExportsCounters)
+{
+    const BlobHandle blob = BlobHandle::fromBytes(QByteArray(4096, 'x'));
+    ExecutionToken first;
+    first.data.insert(QStringLiteral("image"), QVariant::fromValue(blob));
+    ExecutionToken second;
+    second.data.insert(QStringLiteral("pages"), QVariantList{QVariant::fromValue(blob), QVariant::fromValue(blob)});
+    const qint64 keyBytes = (QStringLiteral("image").size() + QStringLiteral("pages").size()) * qint64(sizeof(QChar));
+    EXPECT_EQ(ExecutionTrace::approximateSize(TokenList{first, second}), 4096 + keyBytes);
+
+    ExecutionTrace trace(QUuid::createUuid());
+    trace.recordCounter(QStringLiteral("Data lake"),
+                        {{QStringLiteral("memory_bytes"), 2048}, {QStringLiteral("spilled_bytes"), 512}});
+    const QJsonObject root = QJsonDocument::fromJson(trace.toChromeTraceJson()).object();
+    const QJsonArray counters = eventsWithPhase(root.value(QStringLiteral("traceEvents")).toArray(), QStringLiteral("C"));
+    ASSERT_EQ(counters.size(), 1);
+    const QJsonObject event = counters.first().toObject();
+    EXPECT_EQ(event.value(QStringLiteral("name")).toString(), QStringLiteral("Data lake"));
+    const QJsonObject args = event.value(QStringLiteral("args")).toObject();
+    EXPECT_EQ(args.value(QStringLiteral("memory_bytes")).toInteger(), 2048);
+    EXPECT_EQ(args.value(QStringLiteral("spilled_bytes")).toInteger(), 512);
+
+    if (ExecutionTrace::residentMemoryBytes() >= 0) {
+        EXPECT_GT(ExecutionTrace::residentMemoryBytes(), 0);
+    }
+}
+
+TEST(ExecutionTraceTest, EngineWritesOneSpanPerTask)
+{
+    sharedTestApp();
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+
+    NodeGraphModel model;
+    NodeId textNodeId = model.addNode(QStringLiteral("text-input"));
+    NodeId promptNodeId = model.addNode(QStringLiteral("prompt-builder"));
+    ASSERT_NE(textNodeId, InvalidNodeId);
+    ASSERT_NE(promptNodeId, InvalidNodeId);
+    model.addConnection(ConnectionId{ textNodeId, 0u, promptNodeId, 0u });
+    auto* textTool = dynamic_cast<TextInputNode*>(model.delegateModel<ToolNodeDelegate>(textNodeId)->node().get());
+    ASSERT_NE(textTool, nullptr);
+    textTool->setText(QStringLiteral("Bob"));
+
+    ExecutionEngine engine(&model);
+    engine.setTraceEnabled(true, dir.path());
+
+    QString tracePath;
+    QEventLoop loop;
+    QObject::connect(&engine, &ExecutionEngine::traceWritten, &loop, [&](const QUuid&, const QString& path) {
+        tracePath = path;
+        loop.quit();
+    });
+    QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+    engine.runPipeline();
+    loop.exec();
+
+    ASSERT_FALSE(tracePath.isEmpty());
+    EXPECT_TRUE(tracePath.startsWith(dir.path()));
+    QFile file(tracePath);
+    ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+    const QJsonArray events = QJsonDocument::fromJson(file.readAll()).object()
+                                  .value(QStringLiteral("traceEvents")).toArray();
+
+    const QJsonArray complete = eventsWithPhase(events, QStringLiteral("X"));
+    ASSERT_EQ(complete.size(), 2);
+    QStringList nodeIds;
+    for (const auto& value : complete) {
+        const QJsonObject args = value.toObject().value(QStringLiteral("args")).toObject();
+        nodeIds << args.value(QStringLiteral("node_id")).toString();
+        EXPECT_GE(args.value(QStringLiteral("output_bytes")).toInteger(), 0);
+    }
+    nodeIds.sort();
+    QStringList expected {QString::number(textNodeId), QString::number(promptNodeId)};
+    expected.sort();
+    EXPECT_EQ(nodeIds, expected);
+}
+
+TEST(ExecutionTraceTest, RecordedRunReplaysWithoutExecutingNodes)
+{
+    sharedTestApp();
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+
+    NodeGraphModel model;
+    NodeId textNodeId = model.addNode(QStringLiteral("text-input"));
+    NodeId promptNodeId = model.addNode(QStringLiteral("prompt-builder"));
+    ASSERT_NE(promptNodeId, InvalidNodeId);
+    model.addConnection(ConnectionId{ textNodeId, 0u, promptNodeId, 0u });
+    auto* textTool = dynamic_cast<TextInputNode*>(model.delegateModel<ToolNodeDelegate>(textNodeId)->node().get());
+    ASSERT_NE(textTool, nullptr);
+    textTool->setText(QStringLiteral("Bob"));
+
+    ExecutionEngine engine(&model);
+    engine.setRecordingEnabled(true, dir.path());
+
+    const auto runOnce = [&engine]() {
+        DataPacket output;
+        QEventLoop loop;
+        const auto connection = QObject::connect(&engine, &ExecutionEngine::pipelineFinished, &loop,
+                                                 [&](const DataPacket& finalOutput) {
+            output = finalOutput;
+            loop.quit();
+        });
+        QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+        engine.runPipeline();
+        loop.exec();
+        QObject::disconnect(connection);
+        return output;
+    };
+
+    QString recordingPath;
+    QObject::connect(&engine, &ExecutionEngine::recordingWritten, &engine,
+                     [&](const QUuid&, const QString& path) { recordingPath = path; }, Qt::DirectConnection);
+    const DataPacket recordedOutput = runOnce();
+    ASSERT_FALSE(recordedOutput.isEmpty());
+    ASSERT_FALSE(recordingPath.isEmpty());
+    EXPECT_TRUE(recordingPath.startsWith(dir.path()));
+
+    QString error;
+    const auto recording = RunRecording::load(dir.path(), &error);
+    ASSERT_TRUE(recording) << error.toStdString();
+    const QList<RunRecording::Execution> executions = recording->executions();
+    ASSERT_EQ(executions.size(), 2);
+    for (const auto& execution : executions) {
+        EXPECT_FALSE(execution.outputs.isEmpty());
+        EXPECT_GE(execution.durationUs, 0);
+    }
+
+    // Replayed nodes answer from the recording, so the new text never reaches the prompt
+    textTool->setText(QStringLiteral("Alice"));
+    engine.setRecordingEnabled(false);
+    engine.setReplay(recording, 0.0);
+    EXPECT_EQ(runOnce(), recordedOutput);
+
+    EXPECT_FALSE(RunRecording::fromBundle(QByteArray("not a bundle"), &error));
+    EXPECT_FALSE(error.isEmpty());
+}
+
+TEST(ExecutionTraceTest, ResumedRunSkipsCheckpointedWork)
+{
+    sharedTestApp();
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+
+    NodeGraphModel model;
+    NodeId textNodeId = model.addNode(QStringLiteral("text-input"));
+    NodeId promptNodeId = model.addNode(QStringLiteral("prompt-builder"));
+    ASSERT_NE(promptNodeId, InvalidNodeId);
+    model.addConnection(ConnectionId{ textNodeId, 0u, promptNodeId, 0u });
+    auto* textTool = dynamic_cast<TextInputNode*>(model.delegateModel<ToolNodeDelegate>(textNodeId)->node().get());
+    ASSERT_NE(textTool, nullptr);
+    textTool->setText(QStringLiteral("Bob"));
+
+    ExecutionEngine engine(&model);
+    engine.setRecordingEnabled(true, dir.filePath(QStringLiteral("recordings")));
+    engine.setCheckpointEnabled(true, 0, dir.filePath(QStringLiteral("checkpoints")));
+
+    const auto runOnce = [&engine](const std::function<void()>& start) {
+        DataPacket output;
+        QEventLoop loop;
+        const auto connection = QObject::connect(&engine, &ExecutionEngine::pipelineFinished, &loop,
+                                                 [&](const DataPacket& finalOutput) {
+            output = finalOutput;
+            loop.quit();
+        });
+        QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+        start();
+        loop.exec();
+        QObject::disconnect(connection);
+        return output;
+    };
+
+    const DataPacket firstOutput = runOnce([&engine]() { engine.runPipeline(); });
+    ASSERT_FALSE(firstOutput.isEmpty());
+    // A run that got all the way through leaves nothing to resume
+    EXPECT_FALSE(engine.hasCheckpoint());
+    engine.setRecordingEnabled(false);
+
+    QString error;
+    const auto recording = RunRecording::load(dir.filePath(QStringLiteral("recordings")), &error);
+    ASSERT_TRUE(recording) << error.toStdString();
+    QHash<QUuid, QByteArray> signatures;
+    for (const auto& entry : ExecutionPlan::compile(&model)->nodes()) {
+        signatures.insert(entry.uuid, RunCheckpoint::configSignature(entry.typeId, entry.node->saveState()));
+    }
+
+    // Stands in for a run that stopped after both nodes; the saved prompt is marked so
+    // a resumed run shows whether it was reused
+    const QString marker = QStringLiteral("from checkpoint");
+    QStringList promptKeys;
+    const auto writeCheckpoint = [&]() {
+        RunCheckpoint checkpoint(engine.checkpointPath(), signatures, 0);
+        for (RunRecording::Execution execution : recording->executions()) {
+            if (execution.nodeType == QStringLiteral("prompt-builder")) {
+                for (auto& token : execution.outputs) {
+                    for (auto it = token.data.begin(); it != token.data.end(); ++it) {
+                        it.value() = marker;
+                        promptKeys << it.key();
+                    }
+                }
+            }
+            checkpoint.record(std::move(execution));
+        }
+        RunRecording::Execution failed;
+        failed.nodeUuid = QUuid::createUuid();
+        failed.failure = QStringLiteral("provider outage");
+        checkpoint.record(std::move(failed));
+        EXPECT_EQ(checkpoint.size(), 2);
+        EXPECT_TRUE(checkpoint.close(true));
+    };
+
+    writeCheckpoint();
+    ASSERT_TRUE(engine.hasCheckpoint());
+    ASSERT_FALSE(promptKeys.isEmpty());
+    const DataPacket resumed = runOnce([&engine]() { engine.resumePipeline(); });
+    for (const QString& key : std::as_const(promptKeys)) {
+        EXPECT_EQ(resumed.value(key).toString(), marker) << key.toStdString();
+    }
+    EXPECT_FALSE(engine.hasCheckpoint());
+
+    // Editing the text input drops its saved work and, through new inputs, the prompt's
+    writeCheckpoint();
+    textTool->setText(QStringLiteral("Alice"));
+    const DataPacket edited = runOnce([&engine]() { engine.resumePipeline(); });
+    ASSERT_FALSE(edited.isEmpty());
+    for (const QString& key : std::as_const(promptKeys)) {
+        EXPECT_NE(edited.value(key).toString(), marker) << key.toStdString();
+    }
+}
+
+TEST(ExecutionTraceTest, AnalysisFindsCriticalPathAndSerialTime)
+{
+    sharedTestApp();
+
+    NodeGraphModel model;
+    NodeId textA = model.addNode(QStringLiteral("text-input"));
+    NodeId textB = model.addNode(QStringLiteral("text-input"));
+    NodeId prompt = model.addNode(QStringLiteral("prompt-builder"));
+    ASSERT_NE(prompt, InvalidNodeId);
+    const ConnectionId link{ textA, 0u, prompt, 0u };
+    model.addConnection(link);
+    const auto plan = ExecutionPlan::compile(&model);
+
+    // A and B start together; B ends first, A feeds the prompt, which waits 500 us
+    // in the queue and then runs alone
+    const QList<ExecutionTrace::Span> spans {
+        taskSpan(textA, 0, 0, 1000, 1),
+        taskSpan(textB, 0, 0, 500, 2),
+        taskSpan(prompt, 1000, 1500, 4000, 1),
+    };
+    const RunAnalysis analysis = RunAnalysis::analyse(QUuid::createUuid(), spans, *plan);
+
+    ASSERT_TRUE(analysis.isValid());
+    EXPECT_EQ(analysis.wallUs, 4000);
+    EXPECT_EQ(analysis.busyUs, 4000);
+    EXPECT_EQ(analysis.workerCount, 2);
+    EXPECT_EQ(analysis.peakConcurrency, 2);
+    EXPECT_EQ(analysis.serialUs, 3000);
+    EXPECT_EQ(analysis.idleUs, 500);
+
+    const QString scope = model.executionScopeKey();
+    EXPECT_EQ(analysis.criticalNodes,
+              (QList<QUuid>{ExecIds::nodeUuid(scope, textA), ExecIds::nodeUuid(scope, prompt)}));
+    EXPECT_EQ(analysis.criticalConnections, QList<QUuid>{ExecIds::connectionUuid(scope, link)});
+    EXPECT_EQ(analysis.criticalExecutingUs, 3500);
+    EXPECT_EQ(analysis.criticalQueuedUs, 500);
+
+    ASSERT_FALSE(analysis.nodes.isEmpty());
+    EXPECT_EQ(analysis.nodes.first().nodeId, QString::number(prompt));
+    EXPECT_EQ(analysis.nodes.first().soloUs, 2500);
+    EXPECT_TRUE(analysis.summary().contains(QStringLiteral("Parallelism collapsed")));
+}
+
+TEST(RunUsageReportTest, AggregatesProviderCallsPerNodeAndModel)
+{
+    const auto llmOutput = [](const QString& model, int input, int output, bool cacheHit, int attempts) {
+        ExecutionToken token;
+        token.data.insert(QStringLiteral("_provider"), QStringLiteral("openai"));
+        token.data.insert(QStringLiteral("_model"), model);
+        token.data.insert(QStringLiteral("_usage.input_tokens"), input);
+        token.data.insert(QStringLiteral("_usage.output_tokens"), output);
+        token.data.insert(QStringLiteral("_usage.total_tokens"), input + output);
+        token.data.insert(QStringLiteral("_cache_hit"), cacheHit);
+        if (attempts > 0) token.data.insert(QStringLiteral("_route_attempts"), attempts);
+        return TokenList{token};
+    };
+
+    const QUuid summarizer = QUuid::createUuid();
+    const QUuid formatter = QUuid::createUuid();
+    RunUsageCollector collector(QUuid::createUuid());
+    collector.recordExecution(summarizer, QStringLiteral("1"), QStringLiteral("Summarize"),
+                              llmOutput(QStringLiteral("big"), 100, 50, false, 3), 1000);
+    collector.recordExecution(summarizer, QStringLiteral("1"), QStringLiteral("Summarize"),
+                              llmOutput(QStringLiteral("big"), 100, 50, false, 0), 3000);
+    collector.recordExecution(summarizer, QStringLiteral("1"), QStringLiteral("Summarize"),
+                              llmOutput(QStringLiteral("big"), 100, 50, true, 0), 10);
+    // Replayed from the result cache: a hit, not more tokens
+    collector.recordExecution(summarizer, QStringLiteral("1"), QStringLiteral("Summarize"),
+                              llmOutput(QStringLiteral("big"), 100, 50, false, 0), 0, false, true);
+    ExecutionToken plain;
+    plain.data.insert(QStringLiteral("text"), QStringLiteral("x"));
+    plain.data.insert(QStringLiteral("__error"), QStringLiteral("bad input"));
+    collector.recordExecution(formatter, QStringLiteral("2"), QStringLiteral("Format"), TokenList{plain}, 500);
+
+    const RunUsageReport report = collector.report();
+    ASSERT_TRUE(report.isValid());
+    EXPECT_EQ(report.total.executions, 5);
+    EXPECT_EQ(report.total.failures, 1);
+    EXPECT_EQ(report.total.calls, 4);
+    EXPECT_EQ(report.total.cacheHits, 2);
+    EXPECT_EQ(report.total.retries, 2);
+    EXPECT_EQ(report.total.inputTokens, 200);
+    EXPECT_EQ(report.total.totalTokens, 300);
+
+    ASSERT_EQ(report.nodes.size(), 2);
+    EXPECT_EQ(report.nodes.first().nodeUuid, summarizer);
+    EXPECT_EQ(report.nodes.first().executions, 4);
+    EXPECT_EQ(report.nodes.first().maxUs, 3000);
+    EXPECT_EQ(report.nodes.last().calls, 0);
+
+    ASSERT_EQ(report.models.size(), 1);
+    const RunUsageReport::ModelUsage& model = report.models.first();
+    EXPECT_EQ(model.model, QStringLiteral("big"));
+    EXPECT_EQ(model.calls, 4);
+    // Only the two requests that went out are timed
+    EXPECT_EQ(model.executions, 2);
+    EXPECT_EQ(model.p50Us, 1000);
+    EXPECT_EQ(model.p95Us, 3000);
+
+    const QJsonObject json = report.toJson();
+    EXPECT_EQ(json.value(QStringLiteral("models")).toArray().size(), 1);
+    EXPECT_EQ(json.value(QStringLiteral("total")).toObject().value(QStringLiteral("output_tokens")).toInteger(), 100);
+    EXPECT_TRUE(report.summary().contains(QStringLiteral("openai/big")));
+}
+
+TEST(RunUsageReportTest, CountsEachCascadeTierAgainstItsOwnModel)
+{
+    const auto tier = [](const QString& model, int tokens, qint64 latencyUs) {
+        QVariantMap call;
+        call.insert(QStringLiteral("_provider"), QStringLiteral("openai"));
+        call.insert(QStringLiteral("_model"), model);
+        call.insert(QStringLiteral("_usage.total_tokens"), tokens);
+        call.insert(QStringLiteral("latency_us"), latencyUs);
+        return call;
+    };
+    ExecutionToken escalated;
+    escalated.data.insert(QStringLiteral("_provider"), QStringLiteral("openai"));
+    escalated.data.insert(QStringLiteral("_model"), QStringLiteral("big"));
+    escalated.data.insert(QStringLiteral("_usage.total_tokens"), 90);
+    escalated.data.insert(QStringLiteral("_cascade_tiers"),
+                          QVariantList{tier(QStringLiteral("small"), 10, 200), tier(QStringLiteral("big"), 90, 1800)});
+
+    const QUuid classifier = QUuid::createUuid();
+    RunUsageCollector collector(QUuid::createUuid());
+    collector.recordExecution(classifier, QStringLiteral("1"), QStringLiteral("Classify"), TokenList{escalated}, 2000);
+
+    const RunUsageReport report = collector.report();
+    EXPECT_EQ(report.total.calls, 2);
+    EXPECT_EQ(report.total.totalTokens, 100);
+    EXPECT_EQ(report.nodes.first().maxUs, 2000);
+    ASSERT_EQ(report.models.size(), 2);
+    EXPECT_EQ(report.models.first().model, QStringLiteral("big"));
+    EXPECT_EQ(report.models.first().maxUs, 1800);
+    EXPECT_EQ(report.models.last().maxUs, 200);
+}
+
+TEST(RunHistoryTest, StoresRunsAndFlagsRegressionsAgainstTheirMedian)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    RunHistory history(dir.filePath(QStringLiteral("history.sqlite")), 4);
+
+    const QUuid summarizer = QUuid::createUuid();
+    const auto makeEntry = [&](qint64 wallUs, qint64 nodeP50Us, qint64 tokens, int retries, bool succeeded) {
+        RunHistory::Entry entry;
+        entry.project = QStringLiteral("demo");
+        entry.graphHash = QStringLiteral("graph");
+        entry.configHash = QStringLiteral("config");
+        entry.succeeded = succeeded;
+        entry.report.runId = QUuid::createUuid();
+        entry.report.wallUs = wallUs;
+        entry.report.total.executions = 1;
+        entry.report.total.totalTokens = tokens;
+        entry.report.total.retries = retries;
+        entry.report.total.queueWaitUs = 2000;
+        RunUsageReport::NodeUsage node;
+        node.nodeUuid = summarizer;
+        node.nodeId = QStringLiteral("1");
+        node.name = QStringLiteral("Summarize");
+        node.executions = 1;
+        node.p50Us = nodeP50Us;
+        node.totalTokens = tokens;
+        node.retries = retries;
+        node.inputBytes = 4096;
+        entry.report.nodes.append(node);
+        return entry;
+    };
+
+    // A failed outlier among steady runs; one run of another graph
+    for (const qint64 wallUs : {1000000, 1100000, 5000000, 1050000}) {
+        RunHistory::Entry entry = makeEntry(wallUs, 400000, 1000, 0, wallUs != 5000000);
+        ASSERT_TRUE(history.record(entry));
+        EXPECT_GT(entry.id, 0);
+    }
+    RunHistory::Entry other = makeEntry(1000000, 400000, 1000, 0, true);
+    other.graphHash = QStringLiteral("other graph");
+    ASSERT_TRUE(history.record(other));
+
+    RunHistory::Entry slow = makeEntry(2000000, 900000, 1010, 2, true);
+    ASSERT_TRUE(history.record(slow));
+
+    // Only the newest four runs of the graph are kept
+    const QList<RunHistory::Entry> runs = history.runs(QStringLiteral("demo"), QStringLiteral("graph"));
+    ASSERT_EQ(runs.size(), 4);
+    EXPECT_EQ(runs.first().report.runId, slow.report.runId);
+    EXPECT_EQ(runs.first().report.total.retries, 2);
+    ASSERT_EQ(runs.first().report.nodes.size(), 1);
+    EXPECT_EQ(runs.first().report.nodes.first().p50Us, 900000);
+    EXPECT_EQ(runs.first().report.nodes.first().inputBytes, 4096);
+    EXPECT_FALSE(runs.at(2).succeeded);
+
+    const RunHistory::Entry baseline = RunHistory::baseline(runs.mid(1));
+    ASSERT_TRUE(baseline.report.isValid());
+    EXPECT_EQ(baseline.report.wallUs, 1100000);
+
+    const RunHistory::Comparison comparison = RunHistory::compare(baseline, runs.first());
+    EXPECT_FALSE(comparison.configChanged);
+    QStringList flagged;
+    for (const auto& regression : comparison.regressions) {
+        flagged << regression.subject + QLatin1Char('/') + regression.metric;
+    }
+    flagged.sort();
+    EXPECT_EQ(flagged, QStringList({QStringLiteral("Run/retries"), QStringLiteral("Run/wall time"),
+                                    QStringLiteral("Summarize [1]/p50 latency"),
+                                    QStringLiteral("Summarize [1]/retries")}));
+    EXPECT_TRUE(comparison.summary().contains(QStringLiteral("wall time 1100.0 ms -> 2000.0 ms (+82%)")));
+
+    EXPECT_TRUE(RunHistory::compare(baseline, baseline).regressions.isEmpty());
+}
@@ -0,0 +1,352 @@
+#include <gtest/gtest.h>
+
+#include <QBuffer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QTimer>
+
+#include "test_app.h"
+#include <QtNodes/internal/Definitions.hpp>
+
+#include "ExecutionEngine.h"
+#include "ExecutionIdUtils.h"
+#include "HeadlessRunner.h"
+#include "HttpServerSupport.h"
+#include "HumanInputNode.h"
+#include "HumanInputQueue.h"
+#include "NodeGraphModel.h"
+#include "PipelineServer.h"
+#include "PromptBuilderNode.h"
+#include "TextInputNode.h"
+#include "ToolNodeDelegate.h"
+
+using namespace QtNodes;
+
+namespace {
+
+// Sends one request and returns everything the server wrote before closing
+QByteArray exchange(quint16 port, const QByteArray& request)
+{
+    QTcpSocket client;
+    QEventLoop loop;
+    QByteArray response;
+    QObject::connect(&client, &QTcpSocket::connected, &loop, [&]() { client.write(request); });
+    QObject::connect(&client, &QTcpSocket::readyRead, &loop, [&]() { response += client.readAll(); });
+    QObject::connect(&client, &QTcpSocket::disconnected, &loop, &QEventLoop::quit);
+    QTimer::singleShot(10000, &loop, &QEventLoop::quit);
+    client.connectToHost(QHostAddress::LocalHost, port);
+    loop.exec();
+    return response + client.readAll();
+}
+
+QByteArray postRun(const QByteArray& target, const QByteArray& body)
+{
+    return "POST " + target + " HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/json\r\n"
+           "Content-Length: " + QByteArray::number(body.size()) + "\r\n\r\n" + body;
+}
+
+QJsonObject responseJson(const QByteArray& response)
+{
+    return QJsonDocument::fromJson(response.mid(response.indexOf("\r\n\r\n") + 4)).object();
+}
+
+} // namespace
+
+TEST(HeadlessRunnerTest, ParsesRunInputsAndBatch)
+{
+    HeadlessRunner::Options options;
+    const QString error = HeadlessRunner::parseArguments(
+        {QStringLiteral("--run"), QStringLiteral("flow.json"),
+         QStringLiteral("--input"), QStringLiteral("Text Input.text=a=b"),
+         QStringLiteral("--batch"), QStringLiteral("-"), QStringLiteral("-d")},
+        options);
+
+    EXPECT_TRUE(error.isEmpty()) << error.toStdString();
+    EXPECT_EQ(options.pipelinePath, QStringLiteral("flow.json"));
+    EXPECT_EQ(options.inputs.value(QStringLiteral("Text Input.text")).toString(), QStringLiteral("a=b"));
+    EXPECT_EQ(options.batchPath, QStringLiteral("-"));
+    EXPECT_TRUE(options.verbose);
+
+    HeadlessRunner::Options rejected;
+    EXPECT_FALSE(HeadlessRunner::parseArguments({QStringLiteral("--input"), QStringLiteral("novalue")},
+                                                rejected).isEmpty());
+    EXPECT_FALSE(HeadlessRunner::parseArguments({QStringLiteral("--bogus")}, rejected).isEmpty());
+
+    HeadlessRunner::Options replay;
+    EXPECT_TRUE(HeadlessRunner::parseArguments(
+        {QStringLiteral("--run"), QStringLiteral("flow.json"), QStringLiteral("--replay"), QStringLiteral("runs"),
+         QStringLiteral("--replay-speed"), QStringLiteral("4")},
+        replay).isEmpty());
+    EXPECT_EQ(replay.replayPath, QStringLiteral("runs"));
+    EXPECT_DOUBLE_EQ(replay.replaySpeed, 4.0);
+    EXPECT_FALSE(HeadlessRunner::parseArguments(
+        {QStringLiteral("--run"), QStringLiteral("flow.json"), QStringLiteral("--record"), QStringLiteral("runs"),
+         QStringLiteral("--replay"), QStringLiteral("runs")},
+        rejected).isEmpty());
+}
+
+TEST(HeadlessRunnerTest, ParsesServeOptions)
+{
+    HeadlessRunner::Options options;
+    const QString error = HeadlessRunner::parseArguments(
+        {QStringLiteral("--run"), QStringLiteral("flow.json"), QStringLiteral("--serve"), QStringLiteral("0.0.0.0:9090"),
+         QStringLiteral("--max-runs"), QStringLiteral("3"), QStringLiteral("--max-queue"), QStringLiteral("10"),
+         QStringLiteral("--deadline-ms"), QStringLiteral("2500")},
+        options);
+
+    EXPECT_TRUE(error.isEmpty()) << error.toStdString();
+    EXPECT_TRUE(options.serve);
+    EXPECT_EQ(options.server.port, 9090);
+    EXPECT_EQ(options.server.address, QHostAddress(QStringLiteral("0.0.0.0")));
+    EXPECT_EQ(options.server.maxConcurrentRuns, 3);
+    EXPECT_EQ(options.server.maxQueuedRequests, 10);
+    EXPECT_EQ(options.server.deadlineMs, 2500);
+
+    HeadlessRunner::Options portOnly;
+    EXPECT_TRUE(HeadlessRunner::parseArguments(
+        {QStringLiteral("--run"), QStringLiteral("flow.json"), QStringLiteral("--serve"), QStringLiteral("8081")},
+        portOnly).isEmpty());
+    EXPECT_EQ(portOnly.server.port, 8081);
+    EXPECT_EQ(portOnly.server.address, QHostAddress(QHostAddress::LocalHost));
+
+    HeadlessRunner::Options rejected;
+    EXPECT_FALSE(HeadlessRunner::parseArguments(
+        {QStringLiteral("--run"), QStringLiteral("flow.json"), QStringLiteral("--serve"), QStringLiteral("host:x")},
+        rejected).isEmpty());
+    EXPECT_FALSE(HeadlessRunner::parseArguments(
+        {QStringLiteral("--run"), QStringLiteral("flow.json"), QStringLiteral("--serve"), QStringLiteral("8080"),
+         QStringLiteral("--batch"), QStringLiteral("-")},
+        rejected).isEmpty());
+    EXPECT_FALSE(HeadlessRunner::parseArguments(
+        {QStringLiteral("--run"), QStringLiteral("flow.json"), QStringLiteral("--max-runs"), QStringLiteral("0")},
+        rejected).isEmpty());
+}
+
+TEST(PipelineServerTest, ParsesRequests)
+{
+    PipelineServer::Request request;
+    const QByteArray post = "POST /run?deadline_ms=500&stream=1&note=a+b%21 HTTP/1.1\r\n"
+                            "Accept: Text/Event-Stream\r\nContent-Length: 7\r\n\r\n{\"a\":1}";
+    EXPECT_EQ(PipelineServer::parseRequest(post.left(post.size() - 2), request),
+              PipelineServer::ParseResult::Incomplete);
+    ASSERT_EQ(PipelineServer::parseRequest(post, request), PipelineServer::ParseResult::Complete);
+    EXPECT_EQ(request.method, QByteArray("POST"));
+    EXPECT_EQ(request.path, QByteArray("/run"));
+    EXPECT_EQ(request.query.value("deadline_ms"), QByteArray("500"));
+    EXPECT_EQ(request.query.value("note"), QByteArray("a b!"));
+    EXPECT_EQ(request.headers.value("accept"), QByteArray("Text/Event-Stream"));
+    EXPECT_EQ(request.body, QByteArray("{\"a\":1}"));
+
+    EXPECT_EQ(PipelineServer::parseRequest("GET /health\r\n\r\n", request), PipelineServer::ParseResult::Malformed);
+    EXPECT_EQ(PipelineServer::parseRequest("POST /run HTTP/1.1\r\nContent-Length: nope\r\n\r\n", request),
+              PipelineServer::ParseResult::Malformed);
+    EXPECT_EQ(PipelineServer::parseRequest("POST /run HTTP/1.1\r\nContent-Length: 100\r\n\r\n", request, 64),
+              PipelineServer::ParseResult::TooLarge);
+    // Adding this to the header size would wrap around to a small total
+    EXPECT_EQ(PipelineServer::parseRequest("POST /run HTTP/1.1\r\nContent-Length: 9223372036854775800\r\n\r\n",
+                                           request),
+              PipelineServer::ParseResult::TooLarge);
+}
+
+TEST(PipelineServerTest, SharedResponsesCarryStatusHeadersAndLength)
+{
+    const QByteArray error = HttpServerSupport::jsonResponse(405, HttpServerSupport::errorBody(QStringLiteral("no")),
+                                                             "Allow: POST\r\n");
+    EXPECT_TRUE(error.startsWith("HTTP/1.1 405 Method Not Allowed\r\n"));
+    EXPECT_TRUE(error.contains("Content-Type: application/json\r\n"));
+    EXPECT_TRUE(error.contains("Allow: POST\r\nConnection: close\r\n\r\n"));
+    EXPECT_TRUE(error.endsWith("{\"error\":\"no\",\"succeeded\":false}"));
+
+    // HEAD answers keep the length of the body they leave out
+    const QByteArray head = HttpServerSupport::response(200, "text/plain", "hello", {}, false);
+    EXPECT_TRUE(head.contains("Content-Length: 5\r\n"));
+    EXPECT_TRUE(head.endsWith("\r\n\r\n"));
+}
+
+TEST(PipelineServerTest, AnswersRunsOverHttp)
+{
+    sharedTestApp();
+
+    NodeGraphModel model;
+    const NodeId textNodeId = model.addNode(QStringLiteral("text-input"));
+    const NodeId promptNodeId = model.addNode(QStringLiteral("prompt-builder"));
+    ASSERT_NE(textNodeId, InvalidNodeId);
+    ASSERT_NE(promptNodeId, InvalidNodeId);
+    model.addConnection(ConnectionId{ textNodeId, 0u, promptNodeId, 0u });
+    auto* promptTool = dynamic_cast<PromptBuilderNode*>(model.delegateModel<ToolNodeDelegate>(promptNodeId)->node().get());
+    ASSERT_NE(promptTool, nullptr);
+    promptTool->setTemplateText(QStringLiteral("Hello {input}!"));
+
+    ExecutionEngine engine(&model);
+    const QUuid textUuid = ExecIds::nodeUuid(model.executionScopeKey(), textNodeId);
+    const auto resolve = [&](const QVariantMap& inputs, QHash<QUuid, QVariantMap>& presets, QString& error) {
+        if (!inputs.contains(QStringLiteral("name"))) {
+            error = QStringLiteral("name is required");
+            return false;
+        }
+        presets[textUuid].insert(QString::fromLatin1(TextInputNode::kOutputId), inputs.value(QStringLiteral("name")));
+        return true;
+    };
+    PipelineServer::Config config;
+    config.port = 0;
+    config.maxConcurrentRuns = 2;
+    PipelineServer server(&engine, resolve, config);
+    ASSERT_TRUE(server.start());
+    ASSERT_NE(server.serverPort(), 0);
+
+    const QByteArray answered = exchange(server.serverPort(), postRun("/run", R"({"name": "Ann"})"));
+    ASSERT_TRUE(answered.startsWith("HTTP/1.1 200")) << answered.toStdString();
+    const QJsonObject result = responseJson(answered);
+    EXPECT_TRUE(result.value(QStringLiteral("succeeded")).toBool());
+    EXPECT_EQ(result.value(QStringLiteral("output")).toObject().value(QStringLiteral("prompt")).toString(),
+              QStringLiteral("Hello Ann!"));
+
+    const QByteArray streamed = exchange(server.serverPort(), postRun("/run?stream=1", R"({"name": "Ben"})"));
+    ASSERT_TRUE(streamed.startsWith("HTTP/1.1 200")) << streamed.toStdString();
+    EXPECT_TRUE(streamed.contains("Content-Type: text/event-stream"));
+    const qsizetype resultEvent = streamed.indexOf("event: result\ndata: ");
+    ASSERT_GE(resultEvent, 0);
+    const QJsonObject event = QJsonDocument::fromJson(
+        streamed.mid(resultEvent + 20, streamed.indexOf("\n\n", resultEvent) - resultEvent - 20)).object();
+    EXPECT_EQ(event.value(QStringLiteral("status")).toInt(), 200);
+    EXPECT_EQ(event.value(QStringLiteral("output")).toObject().value(QStringLiteral("prompt")).toString(),
+              QStringLiteral("Hello Ben!"));
+
+    // A priority class and deadline only change the queue order
+    const QByteArray urgent = exchange(server.serverPort(), postRun("/run?priority=high&deadline_ms=5000", R"({"name": "Cy"})"));
+    ASSERT_TRUE(urgent.startsWith("HTTP/1.1 200")) << urgent.toStdString();
+    EXPECT_EQ(responseJson(urgent).value(QStringLiteral("output")).toObject().value(QStringLiteral("prompt")).toString(),
+              QStringLiteral("Hello Cy!"));
+    EXPECT_TRUE(exchange(server.serverPort(), postRun("/run?priority=low", R"({"name": "Di"})")).startsWith("HTTP/1.1 200"));
+    EXPECT_TRUE(exchange(server.serverPort(), postRun("/run?priority=urgent", R"({"name": "Ed"})")).startsWith("HTTP/1.1 400"));
+
+    EXPECT_TRUE(exchange(server.serverPort(), postRun("/run", "{}")).startsWith("HTTP/1.1 400"));
+    EXPECT_TRUE(exchange(server.serverPort(), postRun("/run", "not json")).startsWith("HTTP/1.1 400"));
+    EXPECT_TRUE(exchange(server.serverPort(), "GET /run HTTP/1.1\r\n\r\n").startsWith("HTTP/1.1 405"));
+    EXPECT_TRUE(exchange(server.serverPort(), "GET /nowhere HTTP/1.1\r\n\r\n").startsWith("HTTP/1.1 404"));
+
+    const QByteArray health = exchange(server.serverPort(), "GET /health HTTP/1.1\r\n\r\n");
+    ASSERT_TRUE(health.startsWith("HTTP/1.1 200"));
+    EXPECT_EQ(responseJson(health).value(QStringLiteral("running")).toInt(), 0);
+    EXPECT_EQ(responseJson(health).value(QStringLiteral("maxConcurrentRuns")).toInt(), 2);
+}
+
+TEST(PipelineServerTest, AnswersHumanInputPromptsOverHttp)
+{
+    sharedTestApp();
+
+    HumanInputNode node;
+    ExecutionToken token;
+    token.data.insert(QString::fromLatin1(HumanInputNode::kInputId), QStringLiteral("Approve?"));
+
+    // With no front end attached the prompt fails at once, as it did without a main window
+    {
+        QFuture<TokenList> unanswered = node.executeAsync(TokenList{token});
+        ASSERT_TRUE(unanswered.isFinished());
+        EXPECT_FALSE(unanswered.result().front().data.value(QStringLiteral("__error")).toString().isEmpty());
+    }
+
+    NodeGraphModel model;
+    ExecutionEngine engine(&model);
+    PipelineServer::Config config;
+    config.port = 0;
+    PipelineServer server(&engine, [](const QVariantMap&, QHash<QUuid, QVariantMap>&, QString&) { return true; },
+                          config);
+    ASSERT_TRUE(server.start());
+
+    // The future is returned while the prompt waits; nothing blocks on it
+    QFuture<TokenList> answered = node.executeAsync(TokenList{token});
+    EXPECT_FALSE(answered.isFinished());
+
+    const QByteArray listed = exchange(server.serverPort(), "GET /input HTTP/1.1\r\n\r\n");
+    ASSERT_TRUE(listed.startsWith("HTTP/1.1 200")) << listed.toStdString();
+    const QJsonArray prompts = responseJson(listed).value(QStringLiteral("prompts")).toArray();
+    ASSERT_EQ(prompts.size(), 1);
+    EXPECT_EQ(prompts.at(0).toObject().value(QStringLiteral("prompt")).toString(), QStringLiteral("Approve?"));
+    const QByteArray id = prompts.at(0).toObject().value(QStringLiteral("id")).toString().toUtf8();
+
+    const QByteArray reply = exchange(server.serverPort(), postRun("/input/" + id, R"({"text": "yes"})"));
+    ASSERT_TRUE(reply.startsWith("HTTP/1.1 200")) << reply.toStdString();
+    ASSERT_TRUE(answered.isFinished());
+    EXPECT_EQ(answered.result().front().data.value(QString::fromLatin1(HumanInputNode::kOutputId)).toString(),
+              QStringLiteral("yes"));
+    EXPECT_TRUE(HumanInputQueue::instance().pending().isEmpty());
+
+    // A prompt can be answered only once
+    EXPECT_TRUE(exchange(server.serverPort(), postRun("/input/" + id, R"({"text": "again"})")).startsWith("HTTP/1.1 404"));
+
+    // Cancelling the run withdraws its prompt
+    const CancellationToken cancellation = CancellationToken::create();
+    QFuture<HumanInputQueue::Answer> withdrawn = HumanInputQueue::instance().ask(QStringLiteral("Still there?"), cancellation);
+    cancellation.cancel();
+    QEventLoop loop;
+    QTimer::singleShot(HumanInputQueue::kCancellationPollMs * 4, &loop, &QEventLoop::quit);
+    loop.exec();
+    ASSERT_TRUE(withdrawn.isFinished());
+    EXPECT_FALSE(withdrawn.result().accepted);
+}
+
+TEST(HeadlessRunnerTest, BatchWritesOneOrderedResultPerLine)
+{
+    sharedTestApp();
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+
+    NodeId textNodeId = InvalidNodeId;
+    {
+        NodeGraphModel model;
+        textNodeId = model.addNode(QStringLiteral("text-input"));
+        NodeId promptNodeId = model.addNode(QStringLiteral("prompt-builder"));
+        ASSERT_NE(textNodeId, InvalidNodeId);
+        ASSERT_NE(promptNodeId, InvalidNodeId);
+        model.addConnection(ConnectionId{ textNodeId, 0u, promptNodeId, 0u });
+        auto* promptTool = dynamic_cast<PromptBuilderNode*>(model.delegateModel<ToolNodeDelegate>(promptNodeId)->node().get());
+        ASSERT_NE(promptTool, nullptr);
+        promptTool->setTemplateText(QStringLiteral("Hello {input}!"));
+
+        QFile pipeline(dir.filePath(QStringLiteral("greet.json")));
+        ASSERT_TRUE(pipeline.open(QIODevice::WriteOnly));
+        pipeline.write(QJsonDocument(model.save()).toJson());
+    }
+
+    const QString textKey = QString::number(textNodeId);
+    QFile batch(dir.filePath(QStringLiteral("inputs.jsonl")));
+    ASSERT_TRUE(batch.open(QIODevice::WriteOnly));
+    batch.write(QStringLiteral("{\"%1\": \"Ann\"}\n\n{\"%1\": \"Ben\"}\n{\"missing\": 1}\n{\"%1\": \"Cy\"}\n")
+                    .arg(textKey).toUtf8());
+    batch.close();
+
+    HeadlessRunner::Options options;
+    options.pipelinePath = dir.filePath(QStringLiteral("greet.json"));
+    options.batchPath = batch.fileName();
+    HeadlessRunner runner(options);
+    QBuffer output;
+    ASSERT_TRUE(output.open(QIODevice::WriteOnly));
+    runner.setOutput(&output);
+
+    // The unresolvable input line fails on its own; the other runs still complete
+    EXPECT_EQ(runner.exec(), HeadlessRunner::kExitRunFailed);
+
+    const QList<QByteArray> lines = output.data().trimmed().split('\n');
+    ASSERT_EQ(lines.size(), 4);
+    const QStringList expected {QStringLiteral("Hello Ann!"), QStringLiteral("Hello Ben!"), QString(),
+                                QStringLiteral("Hello Cy!")};
+    for (int i = 0; i < lines.size(); ++i) {
+        const QJsonObject result = QJsonDocument::fromJson(lines.at(i)).object();
+        EXPECT_EQ(result.value(QStringLiteral("index")).toInt(), i);
+        if (expected.at(i).isEmpty()) {
+            EXPECT_FALSE(result.value(QStringLiteral("succeeded")).toBool());
+            EXPECT_FALSE(result.value(QStringLiteral("error")).toString().isEmpty());
+        } else {
+            EXPECT_TRUE(result.value(QStringLiteral("succeeded")).toBool());
+            EXPECT_EQ(result.value(QStringLiteral("output")).toObject().value(QStringLiteral("prompt")).toString(),
+                      expected.at(i));
+        }
+    }
+}
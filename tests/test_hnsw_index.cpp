@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "retrieval/storage/HnswIndex.h"
+
+namespace {
+
+std::vector<std::vector<float>> randomVectors(int count, int dimension, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> normal;
+    std::vector<std::vector<float>> vectors(count, std::vector<float>(dimension));
+    for (auto& vector : vectors) {
+        for (float& value : vector) {
+            value = normal(rng);
+        }
+    }
+    return vectors;
+}
+
+std::set<qint64> exactTopK(const std::vector<std::vector<float>>& vectors, const std::vector<float>& query, int k)
+{
+    std::vector<std::pair<double, qint64>> scored;
+    for (std::size_t i = 0; i < vectors.size(); ++i) {
+        double dot = 0.0;
+        double norm = 0.0;
+        for (std::size_t j = 0; j < query.size(); ++j) {
+            dot += query[j] * vectors[i][j];
+            norm += vectors[i][j] * vectors[i][j];
+        }
+        scored.push_back({-dot / std::sqrt(norm), static_cast<qint64>(i) + 1});
+    }
+    std::sort(scored.begin(), scored.end());
+    std::set<qint64> ids;
+    for (int i = 0; i < k; ++i) {
+        ids.insert(scored[static_cast<std::size_t>(i)].second);
+    }
+    return ids;
+}
+
+} // namespace
+
+TEST(HnswIndexTest, FindsMostTrueNeighboursAndRecallGrowsWithEf)
+{
+    const auto vectors = randomVectors(3000, 32, 7);
+    HnswIndex index;
+    for (std::size_t i = 0; i < vectors.size(); ++i) {
+        ASSERT_TRUE(index.add(static_cast<qint64>(i) + 1, vectors[i]));
+    }
+    EXPECT_EQ(index.size(), 3000);
+    EXPECT_EQ(index.dimension(), 32);
+    EXPECT_EQ(index.maxId(), 3000);
+
+    const auto queries = randomVectors(50, 32, 11);
+    auto recall = [&](int ef) {
+        int found = 0;
+        for (const auto& query : queries) {
+            const std::set<qint64> truth = exactTopK(vectors, query, 10);
+            for (const HnswIndex::Hit& hit : index.search(query, 10, ef)) {
+                found += truth.count(hit.id) ? 1 : 0;
+            }
+        }
+        return found / (10.0 * queries.size());
+    };
+
+    const double narrow = recall(10);
+    const double wide = recall(200);
+    EXPECT_GE(wide, 0.9);
+    EXPECT_GE(wide, narrow);
+}
+
+TEST(HnswIndexTest, FilteredSearchReturnsOnlyAcceptedIds)
+{
+    const auto vectors = randomVectors(3000, 32, 7);
+    HnswIndex index;
+    for (std::size_t i = 0; i < vectors.size(); ++i) {
+        ASSERT_TRUE(index.add(static_cast<qint64>(i) + 1, vectors[i]));
+    }
+
+    // One id in ten: the walk passes through rejected nodes but never returns them
+    const auto accept = [](qint64 id) { return id % 10 == 0; };
+    std::vector<std::vector<float>> accepted;
+    for (std::size_t i = 9; i < vectors.size(); i += 10) {
+        accepted.push_back(vectors[i]);
+    }
+
+    int found = 0;
+    const auto queries = randomVectors(20, 32, 11);
+    for (const auto& query : queries) {
+        std::set<qint64> truth;
+        for (const qint64 position : exactTopK(accepted, query, 10)) {
+            truth.insert(position * 10);
+        }
+        const auto hits = index.search(query, 10, 200, accept);
+        EXPECT_EQ(hits.size(), 10u);
+        for (const HnswIndex::Hit& hit : hits) {
+            EXPECT_TRUE(accept(hit.id));
+            found += truth.count(hit.id) ? 1 : 0;
+        }
+    }
+    EXPECT_GE(found / (10.0 * queries.size()), 0.9);
+
+    EXPECT_TRUE(index.search(queries.front(), 10, 50, [](qint64) { return false; }).empty());
+}
+
+TEST(HnswIndexTest, RejectsUnusableVectorsButRemembersTheirIds)
+{
+    HnswIndex index(3);
+    EXPECT_FALSE(index.add(4, {0.0f, 0.0f, 0.0f}));
+    EXPECT_FALSE(index.add(9, {1.0f, 2.0f}));
+    EXPECT_EQ(index.size(), 0);
+    EXPECT_EQ(index.maxId(), 9);
+    EXPECT_TRUE(index.search({1.0f, 0.0f, 0.0f}, 5).empty());
+
+    EXPECT_TRUE(index.add(10, {1.0f, 0.0f, 0.0f}));
+    const auto hits = index.search({2.0f, 0.0f, 0.0f}, 5);
+    ASSERT_EQ(hits.size(), 1u);
+    EXPECT_EQ(hits.front().id, 10);
+    EXPECT_NEAR(hits.front().score, 1.0f, 0.02f);
+}
+
+TEST(HnswIndexTest, SaveAndLoadRoundTrip)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("index.hnsw"));
+
+    const auto vectors = randomVectors(500, 16, 3);
+    HnswIndex index;
+    for (std::size_t i = 0; i < vectors.size(); ++i) {
+        index.add(static_cast<qint64>(i) * 2 + 1, vectors[i]);
+    }
+    ASSERT_TRUE(index.save(path));
+
+    QString error;
+    const auto loaded = HnswIndex::load(path, &error);
+    ASSERT_TRUE(loaded) << error.toStdString();
+    EXPECT_EQ(loaded->size(), index.size());
+    EXPECT_EQ(loaded->maxId(), index.maxId());
+
+    const auto query = randomVectors(1, 16, 5).front();
+    const auto before = index.search(query, 10);
+    const auto after = loaded->search(query, 10);
+    ASSERT_EQ(before.size(), after.size());
+    for (std::size_t i = 0; i < before.size(); ++i) {
+        EXPECT_EQ(before[i].id, after[i].id);
+    }
+
+    QFile file(path);
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write("not an index");
+    file.close();
+    EXPECT_FALSE(HnswIndex::load(path, &error));
+    EXPECT_FALSE(error.isEmpty());
+}
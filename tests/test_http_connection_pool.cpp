@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+
+#include <curl/curl.h>
+
+#include <memory>
+
+#include "ai/backends/HttpConnectionPool.h"
+
+namespace {
+
+// HTTP/1.1 with keep-alive on its own thread, so the blocking pool calls can run on
+// the test's. Records which connection each request arrived on and what it held;
+// requests for /hang are never answered.
+class RecordingServer
+{
+public:
+    struct Request {
+        int connection {0};
+        QByteArray method;
+        QByteArray path;
+        QHash<QByteArray, QByteArray> headers;
+        QByteArray body;
+    };
+
+    RecordingServer()
+    {
+        m_thread = std::make_unique<QThread>();
+        auto* server = new QTcpServer();
+        server->moveToThread(m_thread.get());
+        QObject::connect(m_thread.get(), &QThread::finished, server, &QObject::deleteLater);
+        QObject::connect(server, &QTcpServer::newConnection, server, [this, server]() {
+            while (QTcpSocket* socket = server->nextPendingConnection()) {
+                QMutexLocker locker(&m_mutex);
+                accept(socket, ++m_connections);
+            }
+        });
+        m_thread->start();
+        QMetaObject::invokeMethod(
+            server,
+            [this, server]() {
+                if (server->listen(QHostAddress::LocalHost, 0)) {
+                    m_port = server->serverPort();
+                }
+            },
+            Qt::BlockingQueuedConnection);
+    }
+
+    ~RecordingServer()
+    {
+        m_thread->quit();
+        m_thread->wait();
+    }
+
+    bool isListening() const { return m_port != 0; }
+    std::string url(const char* path) const
+    {
+        return QStringLiteral("http://127.0.0.1:%1%2").arg(m_port).arg(QLatin1String(path)).toStdString();
+    }
+
+    int connections() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_connections;
+    }
+
+    QList<Request> requests() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_requests;
+    }
+
+private:
+    void accept(QTcpSocket* socket, int connection)
+    {
+        auto buffer = std::make_shared<QByteArray>();
+        QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        QObject::connect(socket, &QTcpSocket::readyRead, socket, [this, socket, buffer, connection]() {
+            buffer->append(socket->readAll());
+            for (;;) {
+                const qsizetype headerEnd = buffer->indexOf("\r\n\r\n");
+                if (headerEnd < 0) {
+                    return;
+                }
+                const QList<QByteArray> lines = buffer->left(headerEnd).split('\n');
+                const QList<QByteArray> requestLine = lines.value(0).trimmed().split(' ');
+                Request request;
+                request.connection = connection;
+                request.method = requestLine.value(0);
+                request.path = requestLine.value(1);
+                for (qsizetype i = 1; i < lines.size(); ++i) {
+                    const qsizetype colon = lines[i].indexOf(':');
+                    if (colon < 0) continue;
+                    request.headers.insert(lines[i].left(colon).trimmed().toLower(), lines[i].mid(colon + 1).trimmed());
+                }
+                const qsizetype contentLength = request.headers.value("content-length").toLongLong();
+                if (buffer->size() < headerEnd + 4 + contentLength) {
+                    return;
+                }
+                request.body = buffer->mid(headerEnd + 4, contentLength);
+                buffer->remove(0, headerEnd + 4 + contentLength);
+                {
+                    QMutexLocker locker(&m_mutex);
+                    m_requests.append(request);
+                }
+                if (request.path != "/hang") {
+                    socket->write("HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 2\r\n\r\nok");
+                }
+            }
+        });
+    }
+
+    std::unique_ptr<QThread> m_thread;
+    quint16 m_port {0};
+    mutable QMutex m_mutex;
+    int m_connections {0};
+    QList<Request> m_requests;
+};
+
+} // namespace
+
+TEST(HttpConnectionPoolTest, SequentialRequestsReuseOneConnection)
+{
+#if LIBCURL_VERSION_NUM < 0x073900
+    GTEST_SKIP() << "libcurl before 7.57 cannot share its connection cache";
+#endif
+    RecordingServer server;
+    ASSERT_TRUE(server.isListening());
+
+    const cpr::Response first = HttpConnectionPool::post(cpr::Url{server.url("/first")}, cpr::Body{"one"});
+    ASSERT_FALSE(first.error) << first.error.message;
+    EXPECT_EQ(first.status_code, 200);
+    EXPECT_EQ(first.text, "ok");
+    const cpr::Response second = HttpConnectionPool::get(cpr::Url{server.url("/second")});
+    ASSERT_FALSE(second.error) << second.error.message;
+    EXPECT_EQ(second.status_code, 200);
+
+    // Each call builds its own session; the shared cache hands the second the first's connection
+    const QList<RecordingServer::Request> requests = server.requests();
+    ASSERT_EQ(requests.size(), 2);
+    EXPECT_EQ(requests[0].connection, requests[1].connection);
+    EXPECT_EQ(server.connections(), 1);
+}
+
+TEST(HttpConnectionPoolTest, ForwardsRequestOptions)
+{
+    RecordingServer server;
+    ASSERT_TRUE(server.isListening());
+
+    const cpr::Response posted = HttpConnectionPool::post(
+        cpr::Url{server.url("/post")}, cpr::Header{{"Content-Type", "application/json"}, {"X-Api-Key", "secret"}},
+        cpr::Body{"{\"a\":1}"}, cpr::Timeout{5000});
+    ASSERT_FALSE(posted.error) << posted.error.message;
+    const cpr::Response fetched = HttpConnectionPool::get(cpr::Url{server.url("/get")},
+                                                          cpr::Parameters{{"model", "m1"}},
+                                                          cpr::Header{{"Authorization", "Bearer t"}});
+    ASSERT_FALSE(fetched.error) << fetched.error.message;
+
+    const QList<RecordingServer::Request> requests = server.requests();
+    ASSERT_EQ(requests.size(), 2);
+    EXPECT_EQ(requests[0].method, "POST");
+    EXPECT_EQ(requests[0].path, "/post");
+    EXPECT_EQ(requests[0].headers.value("content-type"), "application/json");
+    EXPECT_EQ(requests[0].headers.value("x-api-key"), "secret");
+    EXPECT_EQ(requests[0].body, "{\"a\":1}");
+    EXPECT_EQ(requests[1].method, "GET");
+    EXPECT_EQ(requests[1].path, "/get?model=m1");
+    EXPECT_EQ(requests[1].headers.value("authorization"), "Bearer t");
+}
+
+TEST(HttpConnectionPoolTest, ForwardsTimeout)
+{
+    RecordingServer server;
+    ASSERT_TRUE(server.isListening());
+
+    QElapsedTimer timer;
+    timer.start();
+    const cpr::Response response = HttpConnectionPool::get(cpr::Url{server.url("/hang")}, cpr::Timeout{300});
+    EXPECT_EQ(response.error.code, cpr::ErrorCode::OPERATION_TIMEDOUT);
+    EXPECT_EQ(response.status_code, 0);
+    EXPECT_LT(timer.elapsed(), 5000);
+    EXPECT_EQ(server.requests().size(), 1);
+}
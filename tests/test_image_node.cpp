@@ -1,12 +1,19 @@
 #include <gtest/gtest.h>
 
 #include <QApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QImage>
+#include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QtNodes/internal/Definitions.hpp>
 
 #include "test_app.h"
 #include "NodeGraphModel.h"
 #include "ImageNode.h"
+#include "ImageThumbnailService.h"
 #include "ToolNodeDelegate.h"
 
 using namespace QtNodes;
@@ -112,3 +119,54 @@ TEST(ImageNodeTest, PassThroughModeExecution)
     ASSERT_TRUE(output.contains(pinId));
     EXPECT_EQ(output.value(pinId).toString(), upstreamPath);
 }
+
+TEST(ImageNodeTest, ThumbnailsAreDownscaledAndCachedOnDisk)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+    const QString imagePath = tempDir.filePath(QStringLiteral("render.png"));
+    QImage source(2000, 1000, QImage::Format_RGB32);
+    source.fill(Qt::darkCyan);
+    ASSERT_TRUE(source.save(imagePath));
+
+    const QString cacheDir = tempDir.filePath(QStringLiteral("thumbnails"));
+    auto countEntries = [&cacheDir]() {
+        int count = 0;
+        QDirIterator it(cacheDir, {QStringLiteral("*.png")}, QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            it.next();
+            ++count;
+        }
+        return count;
+    };
+
+    {
+        ImageThumbnailService service(cacheDir);
+        const QImage thumbnail = service.thumbnail(imagePath, QSize(256, 256)).result();
+        EXPECT_EQ(thumbnail.size(), QSize(256, 128));
+        EXPECT_EQ(countEntries(), 1);
+        EXPECT_EQ(service.diskHits(), 0);
+
+        // Images already inside the box are not written out
+        EXPECT_EQ(service.load(imagePath, QSize(4096, 4096)).size(), QSize(2000, 1000));
+        EXPECT_EQ(countEntries(), 1);
+    }
+
+    // A new process, modelled by a fresh service, reads the stored thumbnail back
+    ImageThumbnailService service(cacheDir);
+    EXPECT_EQ(service.load(imagePath, QSize(256, 256)).size(), QSize(256, 128));
+    EXPECT_EQ(service.diskHits(), 1);
+
+    // A rewritten file has a new key
+    QImage replacement(1000, 2000, QImage::Format_RGB32);
+    replacement.fill(Qt::darkRed);
+    ASSERT_TRUE(replacement.save(imagePath));
+    QFile touched(imagePath);
+    ASSERT_TRUE(touched.open(QIODevice::ReadWrite));
+    touched.setFileTime(QDateTime::currentDateTime().addSecs(60), QFileDevice::FileModificationTime);
+    touched.close();
+    EXPECT_EQ(service.load(imagePath, QSize(256, 256)).size(), QSize(128, 256));
+    EXPECT_EQ(countEntries(), 2);
+
+    EXPECT_TRUE(service.load(tempDir.filePath(QStringLiteral("missing.png")), QSize(256, 256)).isNull());
+}
@@ -19,8 +19,10 @@
 #endif
 
 #include "MainWindow.h"
+#include "MermaidRenderService.h"
 #include "NodeGraphModel.h"
 #include "ExecutionEngine.h"
+#include "NodeWidgetFactory.h"
 #include "ToolNodeDelegate.h"
 #include "TextInputNode.h"
 #include "PromptBuilderNode.h"
@@ -242,6 +244,9 @@ int main(int argc, char** argv)
     QLoggingCategory::setFilterRules(QStringLiteral("cp.*.debug=false"));
 
     QApplication app(argc, argv);
+    // As the editor's main() does
+    NodeWidgetFactory::install();
+    MermaidRenderService::install();
     int exitCode = 0;
 
     IntegrationTests tc;
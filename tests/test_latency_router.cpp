@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <QElapsedTimer>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "ai/registry/LatencyRouter.h"
+
+namespace {
+
+using ModelCapsTypes::ModelRoute;
+using std::chrono::milliseconds;
+
+const ModelRoute kFirst {QStringLiteral("provider-a"), QStringLiteral("model-a")};
+const ModelRoute kSecond {QStringLiteral("provider-b"), QStringLiteral("model-b")};
+
+void recordLatency(AdaptiveConcurrencyLimiter& limiter, const ModelRoute& route, int latencyMs)
+{
+    AdaptiveConcurrencyLimiter::Slot slot = limiter.acquire(route.provider, route.model);
+    for (int i = 0; i < 20; ++i) {
+        slot.record(AdaptiveConcurrencyLimiter::Outcome::Success, milliseconds(latencyMs));
+    }
+}
+
+LLMResult answer(const QString& content)
+{
+    LLMResult result;
+    result.content = content;
+    return result;
+}
+
+} // namespace
+
+TEST(LatencyRouterTest, RanksUnmeasuredRoutesFirstThenByMedianLatency)
+{
+    AdaptiveConcurrencyLimiter limiter;
+    const LatencyRouter router(limiter);
+    const ModelRoute third {QStringLiteral("provider-c"), QStringLiteral("model-c")};
+
+    EXPECT_EQ(router.rank({kFirst, kSecond}), (QList<ModelRoute>{kFirst, kSecond}));
+
+    recordLatency(limiter, kFirst, 900);
+    recordLatency(limiter, kSecond, 300);
+    EXPECT_EQ(router.rank({kFirst, kSecond, third}), (QList<ModelRoute>{third, kSecond, kFirst}));
+    EXPECT_EQ(router.hedgeDelayMs(kSecond), 300);
+    EXPECT_EQ(router.hedgeDelayMs(third), LatencyRouter::kDefaultHedgeDelayMs);
+}
+
+TEST(LatencyRouterTest, HedgesASlowRouteAndCancelsTheLoser)
+{
+    AdaptiveConcurrencyLimiter limiter;
+    const LatencyRouter router(limiter, 100);
+    std::atomic<bool> slowCancelled {false};
+
+    QElapsedTimer timer;
+    timer.start();
+    const LatencyRouter::Outcome outcome = router.run({kFirst, kSecond}, [&slowCancelled](const ModelRoute& route) {
+        if (route == kFirst) {
+            // Stuck until the race is over
+            const CancellationToken token = CancellationToken::current();
+            while (!token.isCancelled()) {
+                std::this_thread::sleep_for(milliseconds(5));
+            }
+            slowCancelled = true;
+            LLMResult cancelled;
+            cancelled.hasError = true;
+            return cancelled;
+        }
+        return answer(QStringLiteral("fast"));
+    });
+
+    EXPECT_FALSE(outcome.result.hasError);
+    EXPECT_EQ(outcome.result.content, QStringLiteral("fast"));
+    EXPECT_EQ(outcome.route, kSecond);
+    EXPECT_TRUE(outcome.hedged);
+    EXPECT_EQ(outcome.attempts, 2);
+    EXPECT_LT(timer.elapsed(), 2000);
+    for (int i = 0; i < 200 && !slowCancelled; ++i) {
+        std::this_thread::sleep_for(milliseconds(5));
+    }
+    EXPECT_TRUE(slowCancelled);
+}
+
+TEST(LatencyRouterTest, FailsOverWithoutWaitingAndReportsTheLastFailure)
+{
+    AdaptiveConcurrencyLimiter limiter;
+    const LatencyRouter router(limiter, 60000);
+
+    QElapsedTimer timer;
+    timer.start();
+    const LatencyRouter::Outcome recovered = router.run({kFirst, kSecond}, [](const ModelRoute& route) {
+        if (route == kFirst) {
+            LLMResult failed;
+            failed.hasError = true;
+            failed.errorMsg = QStringLiteral("HTTP 503");
+            return failed;
+        }
+        return answer(QStringLiteral("second"));
+    });
+    EXPECT_EQ(recovered.result.content, QStringLiteral("second"));
+    EXPECT_FALSE(recovered.hedged);
+    EXPECT_LT(timer.elapsed(), 2000);
+
+    const LatencyRouter::Outcome failed = router.run({kFirst, kSecond}, [](const ModelRoute& route) {
+        LLMResult result;
+        result.hasError = true;
+        result.errorMsg = route.provider;
+        return result;
+    });
+    EXPECT_TRUE(failed.result.hasError);
+    EXPECT_EQ(failed.result.errorMsg, kSecond.provider);
+    EXPECT_EQ(failed.attempts, 2);
+}
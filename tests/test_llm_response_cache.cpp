@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include "ai/backends/LLMResponseCache.h"
+
+namespace {
+
+LLMResult answer(const QString& text)
+{
+    LLMResult result;
+    result.content = text;
+    result.rawResponse = QStringLiteral("{\"raw\":true}");
+    result.usage.inputTokens = 3;
+    result.usage.outputTokens = 4;
+    result.usage.totalTokens = 7;
+    return result;
+}
+
+} // namespace
+
+TEST(LLMResponseCacheTest, KeyCoversPromptsParametersAndAttachments)
+{
+    const LLMMessage none;
+    const QString base = LLMResponseCache::makeKey(QStringLiteral("openai"), QStringLiteral("gpt"), 0.0, 100,
+                                                   QStringLiteral("sys"), QStringLiteral("user"), none);
+    EXPECT_EQ(base, LLMResponseCache::makeKey(QStringLiteral("OpenAI"), QStringLiteral("gpt"), 0.0, 100,
+                                              QStringLiteral("sys"), QStringLiteral("user"), none));
+    EXPECT_NE(base, LLMResponseCache::makeKey(QStringLiteral("openai"), QStringLiteral("gpt"), 0.0, 200,
+                                              QStringLiteral("sys"), QStringLiteral("user"), none));
+    // The separator keeps "sy"+"suser" apart from "sys"+"user"
+    EXPECT_NE(base, LLMResponseCache::makeKey(QStringLiteral("openai"), QStringLiteral("gpt"), 0.0, 100,
+                                              QStringLiteral("sy"), QStringLiteral("suser"), none));
+
+    LLMMessage withImage;
+    withImage.attachments.append(LLMAttachment{QStringLiteral("image/png"), QByteArray("png-bytes")});
+    LLMMessage otherImage;
+    otherImage.attachments.append(LLMAttachment{QStringLiteral("image/png"), QByteArray("other-bytes")});
+    const QString imageKey = LLMResponseCache::makeKey(QStringLiteral("openai"), QStringLiteral("gpt"), 0.0, 100,
+                                                       QStringLiteral("sys"), QStringLiteral("user"), withImage);
+    EXPECT_NE(base, imageKey);
+    EXPECT_NE(imageKey, LLMResponseCache::makeKey(QStringLiteral("openai"), QStringLiteral("gpt"), 0.0, 100,
+                                                  QStringLiteral("sys"), QStringLiteral("user"), otherImage));
+
+    EXPECT_TRUE(LLMResponseCache::isDeterministicRequest(0.0));
+    EXPECT_FALSE(LLMResponseCache::isDeterministicRequest(0.2));
+}
+
+TEST(LLMResponseCacheTest, RoundTripsResultsAndSkipsErrors)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    LLMResponseCache cache(dir.path());
+
+    ASSERT_TRUE(cache.store(QStringLiteral("aa11"), answer(QStringLiteral("cached"))));
+    const auto hit = cache.lookup(QStringLiteral("aa11"));
+    ASSERT_TRUE(hit.has_value());
+    EXPECT_EQ(hit->content, QStringLiteral("cached"));
+    EXPECT_EQ(hit->rawResponse, QStringLiteral("{\"raw\":true}"));
+    EXPECT_EQ(hit->usage.totalTokens, 7);
+    EXPECT_FALSE(hit->hasError);
+
+    LLMResult failed = answer(QStringLiteral("partial"));
+    failed.hasError = true;
+    EXPECT_FALSE(cache.store(QStringLiteral("bb22"), failed));
+    EXPECT_FALSE(cache.lookup(QStringLiteral("bb22")).has_value());
+}
+
+TEST(LLMResponseCacheTest, ExpiresEntriesAfterTtl)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    LLMResponseCache cache(dir.path(), 1);
+
+    ASSERT_TRUE(cache.store(QStringLiteral("cc33"), answer(QStringLiteral("soon stale"))));
+    EXPECT_TRUE(cache.lookup(QStringLiteral("cc33")).has_value());
+    QThread::msleep(1100);
+    EXPECT_FALSE(cache.lookup(QStringLiteral("cc33")).has_value());
+    EXPECT_FALSE(QFile::exists(dir.path() + QStringLiteral("/cc/cc33.bin")));
+}
+
+TEST(LLMResponseCacheTest, PrunesOldestEntriesOverBudget)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString body(200, QLatin1Char('x'));
+    LLMResponseCache cache(dir.path(), LLMResponseCache::kDefaultTtlSeconds, 2048);
+
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(cache.store(QStringLiteral("k%1").arg(i), answer(body)));
+    }
+    EXPECT_LE(cache.sizeBytes(), 2048);
+    EXPECT_TRUE(cache.lookup(QStringLiteral("k9")).has_value());
+}
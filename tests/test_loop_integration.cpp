@@ -8,6 +8,8 @@
 #include <QApplication>
 #include <QElapsedTimer>
 #include <QEventLoop>
+#include <QFile>
+#include <QTemporaryDir>
 #include <QTimer>
 
 #include "test_app.h"
@@ -145,3 +147,119 @@ TEST(LoopIntegrationTest, ConcurrencyTwoSourcesFinishInParallel)
     EXPECT_GE(elapsed, 350);
     EXPECT_LT(elapsed, 900);
 }
+
+TEST(LoopIntegrationTest, BackpressuredFanOutKeepsEveryIterationInOrder)
+{
+    ensureApp_loop_integration();
+
+    NodeGraphModel model;
+
+    NodeId textId = model.addNode(QStringLiteral("text-input"));
+    NodeId loopId = model.addNode(QStringLiteral("loop-foreach"));
+    NodeId promptId = model.addNode(QStringLiteral("prompt-builder"));
+    ASSERT_NE(textId, InvalidNodeId);
+    ASSERT_NE(loopId, InvalidNodeId);
+    ASSERT_NE(promptId, InvalidNodeId);
+    model.addConnection(ConnectionId{ textId, 0u, loopId, 0u });
+    model.addConnection(ConnectionId{ loopId, 0u, promptId, 0u });
+
+    const int items = 500;
+    QStringList values;
+    for (int i = 0; i < items; ++i) {
+        values << QStringLiteral("\"item-%1\"").arg(i);
+    }
+    auto* textTool = dynamic_cast<TextInputNode*>(model.delegateModel<ToolNodeDelegate>(textId)->node().get());
+    ASSERT_NE(textTool, nullptr);
+    textTool->setText(QLatin1Char('[') + values.join(QLatin1Char(',')) + QLatin1Char(']'));
+    auto* promptTool = dynamic_cast<PromptBuilderNode*>(model.delegateModel<ToolNodeDelegate>(promptId)->node().get());
+    ASSERT_NE(promptTool, nullptr);
+    promptTool->setTemplateText(QStringLiteral("{input}"));
+
+    ExecutionEngine engine(&model);
+    // Far below the fan-out width, so the loop's expansion parks and resumes repeatedly
+    engine.setInputQueueCapacity(4);
+    EXPECT_EQ(engine.inputQueueCapacity(), 4);
+
+    QStringList seen;
+    QObject::connect(&engine, &ExecutionEngine::nodeOutputChanged, &engine, [&](NodeId nodeId) {
+        if (nodeId != promptId) return;
+        const QString s = engine.nodeOutput(nodeId).value(QStringLiteral("prompt")).toString();
+        if (!s.isEmpty()) seen << s;
+    });
+
+    bool finished = false;
+    QEventLoop loop;
+    QObject::connect(&engine, &ExecutionEngine::pipelineFinished, &loop, [&](const DataPacket&) {
+        finished = true;
+        loop.quit();
+    });
+    QTimer::singleShot(15000, &loop, &QEventLoop::quit);
+    engine.Run();
+    if (!finished) loop.exec();
+
+    ASSERT_TRUE(finished) << "Engine stalled with parked fan-out";
+    ASSERT_EQ(seen.size(), items);
+    EXPECT_EQ(seen.first(), QStringLiteral("item-0"));
+    EXPECT_EQ(seen.last(), QStringLiteral("item-%1").arg(items - 1));
+}
+
+TEST(LoopIntegrationTest, StreamedJsonlSourceWaitsForTheConsumer)
+{
+    ensureApp_loop_integration();
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("items.jsonl"));
+    const int items = 300;
+    {
+        QFile file(path);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        for (int i = 0; i < items; ++i) {
+            file.write(QStringLiteral("\"item-%1\"\n").arg(i).toUtf8());
+        }
+    }
+
+    NodeGraphModel model;
+    NodeId textId = model.addNode(QStringLiteral("text-input"));
+    NodeId loopId = model.addNode(QStringLiteral("loop-foreach"));
+    NodeId promptId = model.addNode(QStringLiteral("prompt-builder"));
+    ASSERT_NE(textId, InvalidNodeId);
+    ASSERT_NE(loopId, InvalidNodeId);
+    ASSERT_NE(promptId, InvalidNodeId);
+    model.addConnection(ConnectionId{ textId, 0u, loopId, 0u });
+    model.addConnection(ConnectionId{ loopId, 0u, promptId, 0u });
+
+    auto* textTool = dynamic_cast<TextInputNode*>(model.delegateModel<ToolNodeDelegate>(textId)->node().get());
+    ASSERT_NE(textTool, nullptr);
+    textTool->setText(path);
+    auto* loopTool = dynamic_cast<LoopNode*>(model.delegateModel<ToolNodeDelegate>(loopId)->node().get());
+    ASSERT_NE(loopTool, nullptr);
+    loopTool->setSource(QString::fromLatin1(LoopNode::kSourceJsonl));
+    auto* promptTool = dynamic_cast<PromptBuilderNode*>(model.delegateModel<ToolNodeDelegate>(promptId)->node().get());
+    ASSERT_NE(promptTool, nullptr);
+    promptTool->setTemplateText(QStringLiteral("{input}"));
+
+    ExecutionEngine engine(&model);
+    engine.setInputQueueCapacity(4);
+
+    QStringList seen;
+    QObject::connect(&engine, &ExecutionEngine::nodeOutputChanged, &engine, [&](NodeId nodeId) {
+        if (nodeId != promptId) return;
+        const QString s = engine.nodeOutput(nodeId).value(QStringLiteral("prompt")).toString();
+        if (!s.isEmpty() && (seen.isEmpty() || seen.last() != s)) seen << s;
+    });
+
+    bool finished = false;
+    QEventLoop loop;
+    QObject::connect(&engine, &ExecutionEngine::pipelineFinished, &loop, [&](const DataPacket&) {
+        finished = true;
+        loop.quit();
+    });
+    QTimer::singleShot(15000, &loop, &QEventLoop::quit);
+    engine.Run();
+    if (!finished) loop.exec();
+
+    ASSERT_TRUE(finished) << "Engine stalled with a streaming loop source";
+    ASSERT_FALSE(seen.isEmpty());
+    EXPECT_EQ(seen.last(), QStringLiteral("item-%1").arg(items - 1));
+}
@@ -5,9 +5,14 @@
 #include <gtest/gtest.h>
 
 #include <QApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
 
 #include "test_app.h"
 #include "LoopNode.h"
+#include "PartialOutputSink.h"
 
 static QApplication* ensureAppForLoopNode()
 {
@@ -196,3 +201,116 @@ TEST_F(LoopNodeTest, MultipleInputTokensProcessedSequentially)
     }
     EXPECT_EQ(passthroughCount, 2);
 }
+
+TEST_F(LoopNodeTest, BatchSizeGroupsItemsIntoJsonSlices)
+{
+    LoopNode node;
+    node.setBatchSize(2);
+
+    DataPacket in;
+    in.insert(QString::fromLatin1(LoopNode::kInputListId), QStringLiteral("[\"A\",\"B\",\"C\",\"D\",\"E\"]"));
+    ExecutionToken t; t.data = in;
+
+    const TokenList outputs = node.execute(TokenList{t});
+    ASSERT_EQ(outputs.size(), 4u); // 3 batches + 1 passthrough
+
+    const QString bodyKey = QString::fromLatin1(LoopNode::kOutputBodyId);
+    QStringList bodies;
+    for (const auto& tok : outputs) {
+        if (tok.data.contains(bodyKey)) bodies << tok.data.value(bodyKey).toString();
+    }
+    ASSERT_EQ(bodies.size(), 3);
+    EXPECT_EQ(bodies.at(0), QStringLiteral("[\"A\",\"B\"]"));
+    EXPECT_EQ(bodies.at(1), QStringLiteral("[\"C\",\"D\"]"));
+    EXPECT_EQ(bodies.at(2), QStringLiteral("[\"E\"]"));
+
+    LoopNode restored;
+    restored.loadState(node.saveState());
+    EXPECT_EQ(restored.batchSize(), 2);
+}
+
+TEST_F(LoopNodeTest, JsonlSourcePublishesEachLineAsItIsRead)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("items.jsonl"));
+    {
+        QFile file(path);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write("\"first\"\n{\"id\":2}\n\n\"third\"\n");
+    }
+
+    LoopNode node;
+    node.setSource(QString::fromLatin1(LoopNode::kSourceJsonl));
+    EXPECT_EQ(node.source(), QString::fromLatin1(LoopNode::kSourceJsonl));
+
+    QStringList published;
+    int awaited = 0;
+    const QString bodyKey = QString::fromLatin1(LoopNode::kOutputBodyId);
+    const PartialOutputSink::Scope sinkScope(PartialOutputSink(
+        [&](const TokenList& tokens) {
+            for (const auto& tok : tokens) {
+                EXPECT_TRUE(tok.forceExecution);
+                published << tok.data.value(bodyKey).toString();
+            }
+        },
+        [&]() { ++awaited; }));
+
+    ExecutionToken t;
+    t.data.insert(QString::fromLatin1(LoopNode::kInputListId), path);
+    const TokenList outputs = node.execute(TokenList{t});
+
+    EXPECT_EQ(published, (QStringList{QStringLiteral("first"), QStringLiteral("{\"id\":2}"), QStringLiteral("third")}));
+    // Backpressure is consulted after every publish
+    EXPECT_EQ(awaited, 3);
+    // Only the passthrough is returned; it echoes the path, not the file contents
+    ASSERT_EQ(outputs.size(), 1u);
+    EXPECT_EQ(outputs.front().data.value(QString::fromLatin1(LoopNode::kOutputPassthroughId)).toString(), path);
+
+    LoopNode restored;
+    restored.loadState(node.saveState());
+    EXPECT_EQ(restored.source(), QString::fromLatin1(LoopNode::kSourceJsonl));
+}
+
+TEST_F(LoopNodeTest, CsvSourceYieldsRowsKeyedByTheHeader)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("rows.csv"));
+    {
+        QFile file(path);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write("name,note\nann,\"plain\"\nbob,\"has, comma and \"\"quotes\"\"\nand a newline\"\n");
+    }
+
+    LoopNode node;
+    node.setSource(QString::fromLatin1(LoopNode::kSourceCsv));
+    node.setBatchSize(1);
+
+    // Without an active sink the items come back as the execute() result
+    ExecutionToken t;
+    t.data.insert(QString::fromLatin1(LoopNode::kInputListId), path);
+    const TokenList outputs = node.execute(TokenList{t});
+    ASSERT_EQ(outputs.size(), 3u); // 2 rows + 1 passthrough
+
+    const QString bodyKey = QString::fromLatin1(LoopNode::kOutputBodyId);
+    const QJsonObject first = QJsonDocument::fromJson(outputs.at(0).data.value(bodyKey).toString().toUtf8()).object();
+    const QJsonObject second = QJsonDocument::fromJson(outputs.at(1).data.value(bodyKey).toString().toUtf8()).object();
+    EXPECT_EQ(first.value(QStringLiteral("name")).toString(), QStringLiteral("ann"));
+    EXPECT_EQ(first.value(QStringLiteral("note")).toString(), QStringLiteral("plain"));
+    EXPECT_EQ(second.value(QStringLiteral("name")).toString(), QStringLiteral("bob"));
+    EXPECT_EQ(second.value(QStringLiteral("note")).toString(),
+              QStringLiteral("has, comma and \"quotes\"\nand a newline"));
+}
+
+TEST_F(LoopNodeTest, MissingStreamSourceReportsAnError)
+{
+    LoopNode node;
+    node.setSource(QString::fromLatin1(LoopNode::kSourceJsonl));
+
+    ExecutionToken t;
+    t.data.insert(QString::fromLatin1(LoopNode::kInputListId), QStringLiteral("/nonexistent/items.jsonl"));
+    const TokenList outputs = node.execute(TokenList{t});
+    ASSERT_EQ(outputs.size(), 1u);
+    EXPECT_FALSE(outputs.front().data.value(QStringLiteral("__error")).toString().isEmpty());
+}
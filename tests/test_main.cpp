@@ -7,6 +7,8 @@
 #include <QLibraryInfo>
 #include <QString>
 #include "Logger.h"
+#include "MermaidRenderService.h"
+#include "NodeWidgetFactory.h"
 
 namespace {
 
@@ -56,6 +58,9 @@ int main(int argc, char** argv)
     AppLogHelper::setGlobalDebugEnabled(debugEnabled);
 
     QApplication app(argc, argv);
+    // The node widgets and the WebEngine renderer, as the editor installs them
+    NodeWidgetFactory::install();
+    MermaidRenderService::install();
 
     ::testing::InitGoogleTest(&argc, argv);
     int result = RUN_ALL_TESTS();
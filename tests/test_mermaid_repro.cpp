@@ -3,6 +3,9 @@
 #include <QApplication>
 #include <QColor>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFuture>
 #include <QImage>
 #include <QTemporaryDir>
 #include <QTest>
@@ -11,6 +14,9 @@
 #include "test_app.h"
 #include "MermaidRenderService.h"
 
+#include <algorithm>
+#include <vector>
+
 static QApplication* ensureAppForMermaid()
 {
     return sharedTestApp();
@@ -86,4 +92,85 @@ TEST(MermaidRenderServiceRepro, WideDiagramTruncation)
     EXPECT_EQ(qtResult, 0);
 }
 
+TEST(MermaidRenderServiceRepro, WarmPagesRenderSuccessiveDiagramsAndCacheRepeats)
+{
+    ensureAppForMermaid();
+    MermaidRenderService& service = MermaidRenderService::instance();
+    service.clearRenderCache();
+
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+    const QString first = tempDir.filePath(QStringLiteral("first.png"));
+    const QString second = tempDir.filePath(QStringLiteral("second.png"));
+    const QString repeat = tempDir.filePath(QStringLiteral("repeat.png"));
+
+    const auto one = service.renderMermaid(QStringLiteral("graph TD; A-->B"), first, 1.0);
+    ASSERT_TRUE(one.ok) << one.error.toStdString();
+    EXPECT_FALSE(one.cached);
+
+    // A different diagram on the page the first render left warm
+    const auto two = service.renderMermaid(QStringLiteral("graph LR; C-->D; D-->E"), second, 1.0);
+    ASSERT_TRUE(two.ok) << two.error.toStdString();
+    EXPECT_FALSE(two.cached);
+    EXPECT_NE(QImage(first).size(), QImage(second).size()) << "the second page shows its own diagram";
+
+    const auto again = service.renderMermaid(QStringLiteral("graph TD; A-->B"), repeat, 1.0);
+    ASSERT_TRUE(again.ok) << again.error.toStdString();
+    EXPECT_TRUE(again.cached);
+    EXPECT_EQ(QImage(repeat), QImage(first));
+}
+
+TEST(MermaidRenderServiceRepro, AsyncRendersCompleteWhileTheGuiThreadKeepsRunning)
+{
+    ensureAppForMermaid();
+    MermaidRenderService& service = MermaidRenderService::instance();
+    service.clearRenderCache();
+
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    // More than run at once, so some wait in the queue
+    std::vector<QFuture<MermaidRenderService::RenderResult>> futures;
+    for (int i = 0; i < MermaidRenderService::kMaxConcurrentRenders + 2; ++i) {
+        const QString code = QStringLiteral("graph TD; A%1-->B%1").arg(i);
+        futures.push_back(service.renderMermaidAsync(code, tempDir.filePath(QStringLiteral("async_%1.png").arg(i)), 1.0));
+        EXPECT_FALSE(futures.back().isFinished()) << "the request returns before any rendering";
+    }
+
+    QElapsedTimer clock;
+    clock.start();
+    const auto allFinished = [&futures]() {
+        return std::all_of(futures.begin(), futures.end(), [](const auto& future) { return future.isFinished(); });
+    };
+    while (!allFinished() && clock.elapsed() < 120000) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 50);
+    }
+    ASSERT_TRUE(allFinished());
+
+    for (int i = 0; i < static_cast<int>(futures.size()); ++i) {
+        const MermaidRenderService::RenderResult result = futures[i].result();
+        EXPECT_TRUE(result.ok) << result.error.toStdString();
+        EXPECT_FALSE(QImage(tempDir.filePath(QStringLiteral("async_%1.png").arg(i))).isNull());
+    }
+}
+
+TEST(MermaidRenderServiceRepro, SvgOutputSkipsTheScreenGrab)
+{
+    ensureAppForMermaid();
+
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+    const QString outputPath = tempDir.filePath(QStringLiteral("diagram.svg"));
+
+    const auto result = MermaidRenderService::instance().renderMermaid(QStringLiteral("graph LR; X-->Y"), outputPath, 2.0);
+    ASSERT_TRUE(result.ok) << result.error.toStdString();
+    EXPECT_DOUBLE_EQ(result.devicePixelRatio, 1.0);
+
+    QFile file(outputPath);
+    ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+    const QByteArray markup = file.readAll();
+    EXPECT_TRUE(markup.startsWith("<svg"));
+    EXPECT_TRUE(markup.contains("xmlns=\"http://www.w3.org/2000/svg\""));
+}
+
 #include "test_mermaid_repro.moc"
@@ -25,11 +25,16 @@
 
 #include <QJsonArray>
 #include <QJsonDocument>
+#include <QFile>
 #include <QJsonObject>
+#include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QTest>
 
 #include "ModelCapsRegistry.h"
+#include "RequestCompression.h"
+
+#include <zlib.h>
 
 class TestModelCaps : public QObject {
     Q_OBJECT
@@ -42,6 +47,10 @@ private slots:
     void testVirtualModelAliasing();
     void testDriverProfilesAndProviderSettings();
     void testRequiresBackendSkipsAmbiguousResolution();
+    void testResolutionCacheIsClearedOnReload();
+    void testLookupsWaitForBackgroundLoad();
+    void testCatalogSnapshotIsReusedUntilInputsChange();
+    void testRequestCompressionFollowsProviderSettings();
 };
 
 namespace {
@@ -62,6 +71,27 @@ bool writeRulesToTempFile(QTemporaryFile& file, const QJsonArray& rules)
     return written == payload.size();
 }
 
+std::string gunzip(const std::string& data)
+{
+    z_stream stream {};
+    if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+        return {};
+    }
+    std::string out;
+    char buffer[16384];
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    int status = Z_OK;
+    while (status == Z_OK) {
+        stream.next_out = reinterpret_cast<Bytef*>(buffer);
+        stream.avail_out = sizeof(buffer);
+        status = inflate(&stream, Z_NO_FLUSH);
+        out.append(buffer, sizeof(buffer) - stream.avail_out);
+    }
+    inflateEnd(&stream);
+    return status == Z_STREAM_END ? out : std::string();
+}
+
 bool writeRootToTempFile(QTemporaryFile& file, const QJsonObject& root)
 {
     if (!file.open()) {
@@ -239,7 +269,10 @@ void TestModelCaps::testDriverProfilesAndProviderSettings()
             { QStringLiteral("name"), QStringLiteral("Local Ollama") },
             { QStringLiteral("enabled"), true },
             { QStringLiteral("requiresCredential"), false },
-            { QStringLiteral("base_url"), QStringLiteral("http://localhost:11434") }
+            { QStringLiteral("base_url"), QStringLiteral("http://localhost:11434") },
+            { QStringLiteral("keep_alive"), -1 },
+            { QStringLiteral("options"), QJsonObject{ { QStringLiteral("num_ctx"), 8192 } } },
+            { QStringLiteral("parallel"), 2 }
         }
     });
     root.insert(QStringLiteral("driver_profiles"), QJsonArray{
@@ -274,6 +307,9 @@ void TestModelCaps::testDriverProfilesAndProviderSettings()
     QCOMPARE(provider->name, QStringLiteral("Local Ollama"));
     QCOMPARE(provider->requiresCredential, false);
     QCOMPARE(provider->baseUrl, QStringLiteral("http://localhost:11434"));
+    QCOMPARE(provider->keepAlive, QStringLiteral("-1"));
+    QCOMPARE(provider->options.value(QStringLiteral("num_ctx")).toInt(), 8192);
+    QCOMPARE(provider->parallel, 2);
 }
 
 void TestModelCaps::testRequiresBackendSkipsAmbiguousResolution()
@@ -297,6 +333,175 @@ void TestModelCaps::testRequiresBackendSkipsAmbiguousResolution()
              "Broad local rule should match when backend is explicit");
 }
 
+void TestModelCaps::testResolutionCacheIsClearedOnReload()
+{
+    QTemporaryFile first;
+    QVERIFY2(writeRulesToTempFile(first, QJsonArray{QJsonObject{
+                 { QStringLiteral("id"), QStringLiteral("first") },
+                 { QStringLiteral("pattern"), QStringLiteral("^cached-model$") }
+             }}),
+             "Unable to write temporary rules file (first)");
+    QVERIFY2(ModelCapsRegistry::instance().loadFromFile(first.fileName()), "Registry failed to load rules (first)");
+
+    // Repeated lookups, hits and misses alike, are answered from the memo
+    for (int i = 0; i < 3; ++i) {
+        const auto hit = ModelCapsRegistry::instance().resolveWithRule(QStringLiteral("cached-model"));
+        QVERIFY(hit.has_value());
+        QCOMPARE(hit->ruleId, QStringLiteral("first"));
+        QVERIFY(!ModelCapsRegistry::instance().isSupported(QString(), QStringLiteral("other-model")));
+    }
+
+    QTemporaryFile second;
+    QVERIFY2(writeRulesToTempFile(second, QJsonArray{QJsonObject{
+                 { QStringLiteral("id"), QStringLiteral("second") },
+                 { QStringLiteral("pattern"), QStringLiteral("^(cached|other)-model$") }
+             }}),
+             "Unable to write temporary rules file (second)");
+    QVERIFY2(ModelCapsRegistry::instance().loadFromFile(second.fileName()), "Registry failed to load rules (second)");
+
+    const auto reloaded = ModelCapsRegistry::instance().resolveWithRule(QStringLiteral("cached-model"));
+    QVERIFY(reloaded.has_value());
+    QCOMPARE(reloaded->ruleId, QStringLiteral("second"));
+    QVERIFY(ModelCapsRegistry::instance().isSupported(QString(), QStringLiteral("other-model")));
+}
+
+void TestModelCaps::testLookupsWaitForBackgroundLoad()
+{
+    QTemporaryFile file;
+    QVERIFY2(writeRulesToTempFile(file, QJsonArray{QJsonObject{
+                 { QStringLiteral("id"), QStringLiteral("background") },
+                 { QStringLiteral("pattern"), QStringLiteral("^background-model$") }
+             }}),
+             "Unable to write temporary rules file");
+
+    // The first lookup after queueing sees the new catalog, however far parsing got
+    ModelCapsRegistry::instance().loadInBackground(file.fileName());
+    const auto resolved = ModelCapsRegistry::instance().resolveWithRule(QStringLiteral("background-model"));
+    QVERIFY(resolved.has_value());
+    QCOMPARE(resolved->ruleId, QStringLiteral("background"));
+    QVERIFY(ModelCapsRegistry::instance().waitForBackgroundLoad());
+
+    ModelCapsRegistry::instance().loadInBackground(QStringLiteral("/nonexistent/model_caps.json"));
+    QVERIFY(!ModelCapsRegistry::instance().waitForBackgroundLoad());
+    QCOMPARE(ModelCapsRegistry::instance().resolveWithRule(QStringLiteral("background-model"))->ruleId,
+             QStringLiteral("background"));
+}
+
+void TestModelCaps::testCatalogSnapshotIsReusedUntilInputsChange()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString snapshotPath = dir.filePath(QStringLiteral("model_caps.snapshot"));
+    qputenv("CP_MODEL_CAPS_SNAPSHOT", snapshotPath.toUtf8());
+    auto& registry = ModelCapsRegistry::instance();
+    QCOMPARE(registry.snapshotPath(), snapshotPath);
+
+    const auto catalog = [](const QString& pattern) {
+        return QJsonObject{
+            { QStringLiteral("rules"), QJsonArray{QJsonObject{
+                { QStringLiteral("id"), QStringLiteral("snap") },
+                { QStringLiteral("pattern"), pattern },
+                { QStringLiteral("backend"), QStringLiteral("openai") },
+                { QStringLiteral("capabilities"), QJsonArray{QStringLiteral("chat"), QStringLiteral("vision")} },
+                { QStringLiteral("constraints"), QJsonObject{
+                    { QStringLiteral("maxOutputTokens"), 4096 },
+                    { QStringLiteral("temperature"), QJsonObject{{ QStringLiteral("max"), 1.5 }} }
+                } },
+                { QStringLiteral("headers"), QJsonObject{{ QStringLiteral("X-Snap"), QStringLiteral("1") }} }
+            }} },
+            { QStringLiteral("providers"), QJsonArray{QJsonObject{
+                { QStringLiteral("id"), QStringLiteral("openai") },
+                { QStringLiteral("baseUrl"), QStringLiteral("https://proxy.example") },
+                { QStringLiteral("rateLimits"), QJsonObject{{ QStringLiteral("requestsPerMinute"), 60 }} }
+            }} },
+            { QStringLiteral("virtual_models"), QJsonArray{QJsonObject{
+                { QStringLiteral("id"), QStringLiteral("snap-alias") },
+                { QStringLiteral("target"), QStringLiteral("snap-model") },
+                { QStringLiteral("name"), QStringLiteral("Snap") }
+            }} }
+        };
+    };
+    const auto readSnapshot = [&snapshotPath]() {
+        QFile file(snapshotPath);
+        return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    };
+
+    QTemporaryFile file;
+    QVERIFY(writeRootToTempFile(file, catalog(QStringLiteral("^snap-(?!mini)"))));
+    QVERIFY(registry.loadFromFileWithUserOverrides(file.fileName()));
+    const QByteArray written = readSnapshot();
+    QVERIFY(!written.isEmpty());
+
+    // Load something else, then the same inputs again: the snapshot answers and is left as it was
+    QTemporaryFile other;
+    QVERIFY(writeRulesToTempFile(other, QJsonArray{QJsonObject{{ QStringLiteral("pattern"), QStringLiteral("^x$") }}}));
+    QVERIFY(registry.loadFromFile(other.fileName()));
+    QVERIFY(registry.loadFromFileWithUserOverrides(file.fileName()));
+    QCOMPARE(readSnapshot(), written);
+
+    const auto resolved = registry.resolveWithRule(QStringLiteral("snap-alias"), QStringLiteral("openai"));
+    QVERIFY(resolved.has_value());
+    QCOMPARE(resolved->ruleId, QStringLiteral("snap"));
+    QVERIFY(resolved->caps.hasCapability(ModelCapsTypes::Capability::Vision));
+    QCOMPARE(resolved->caps.constraints.maxOutputTokens.value_or(0), 4096);
+    QCOMPARE(resolved->caps.constraints.temperature->max.value_or(0.0), 1.5);
+    QVERIFY(!resolved->caps.constraints.temperature->min.has_value());
+    QCOMPARE(resolved->caps.customHeaders.value(QStringLiteral("X-Snap")), QStringLiteral("1"));
+    QVERIFY(!registry.isSupported(QStringLiteral("openai"), QStringLiteral("snap-mini")));
+    QCOMPARE(registry.providerSettings(QStringLiteral("openai"))->baseUrl, QStringLiteral("https://proxy.example"));
+    QCOMPARE(registry.providerSettings(QStringLiteral("openai"))->rateLimit.requestsPerMinute, 60);
+
+    // Editing the catalog rebuilds it
+    QTemporaryFile changed;
+    QVERIFY(writeRootToTempFile(changed, catalog(QStringLiteral("^snap-"))));
+    QVERIFY(registry.loadFromFileWithUserOverrides(changed.fileName()));
+    QVERIFY(readSnapshot() != written);
+    QVERIFY(registry.isSupported(QStringLiteral("openai"), QStringLiteral("snap-mini")));
+
+    qunsetenv("CP_MODEL_CAPS_SNAPSHOT");
+}
+
+void TestModelCaps::testRequestCompressionFollowsProviderSettings()
+{
+    QJsonObject root;
+    root.insert(QStringLiteral("providers"), QJsonArray{
+        QJsonObject{
+            { QStringLiteral("id"), QStringLiteral("ollama") },
+            { QStringLiteral("content_encoding"), QStringLiteral("GZIP") },
+            { QStringLiteral("compress_min_bytes"), 1024 }
+        }
+    });
+    QTemporaryFile file;
+    QVERIFY2(writeRootToTempFile(file, root), "Unable to write temporary catalog file");
+    QVERIFY2(ModelCapsRegistry::instance().loadFromFile(file.fileName()), "Registry failed to load catalog");
+
+    const auto provider = ModelCapsRegistry::instance().providerSettings(QStringLiteral("ollama"));
+    QVERIFY(provider.has_value());
+    QCOMPARE(provider->contentEncoding, QStringLiteral("gzip"));
+    QCOMPARE(provider->compressMinBytes, 1024);
+
+    // Below the threshold the body goes out as it is
+    cpr::Header headers;
+    const std::string small(512, 'a');
+    QVERIFY(RequestCompression::encodeBody(QStringLiteral("ollama"), small, headers) == small);
+    QVERIFY(headers.find("Content-Encoding") == headers.end());
+
+    // Large bodies are gzipped and decode back to the original
+    std::string large;
+    for (int i = 0; i < 4000; ++i) {
+        large += "{\"role\":\"user\",\"content\":\"chunk " + std::to_string(i) + "\"},";
+    }
+    const std::string encoded = RequestCompression::encodeBody(QStringLiteral("ollama"), large, headers);
+    QVERIFY(headers["Content-Encoding"] == "gzip");
+    QVERIFY(encoded.size() < large.size() / 4);
+    QVERIFY(gunzip(encoded) == large);
+
+    // Providers that don't opt in never compress
+    cpr::Header openaiHeaders;
+    QVERIFY(RequestCompression::encodeBody(QStringLiteral("openai"), large, openaiHeaders) == large);
+    QVERIFY(openaiHeaders.find("Content-Encoding") == openaiHeaders.end());
+}
+
 TEST(ModelCapsRegistryTests, QtHarness)
 {
     TestModelCaps testCase;
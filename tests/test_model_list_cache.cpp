@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSemaphore>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
+
+#include <atomic>
+#include <memory>
+
+#include "ai/backends/ILLMBackend.h"
+#include "ai/catalog/ModelCatalogService.h"
+#include "ai/catalog/ModelListCache.h"
+#include "ai/registry/LLMProviderRegistry.h"
+
+namespace {
+
+// Holds its model list request until released, like a provider that is slow to answer
+class SlowListingBackend : public ILLMBackend {
+public:
+    QString id() const override { return QStringLiteral("slowlist"); }
+    QString name() const override { return QStringLiteral("Slow Listing"); }
+    QStringList availableModels() const override { return {QStringLiteral("static-model")}; }
+    QStringList availableEmbeddingModels() const override { return {}; }
+    QFuture<QStringList> fetchModelList() override
+    {
+        ++fetches;
+        return QtConcurrent::run([this]() {
+            gate.acquire();
+            return QStringList{QStringLiteral("listed-a"), QStringLiteral("listed-b")};
+        });
+    }
+    LLMResult sendPrompt(const QString&, const QString&, double, int, const QString&, const QString&,
+                         const LLMMessage& = {}) override {
+        return {};
+    }
+    EmbeddingResult getEmbedding(const QString&, const QString&, const QString&) override { return {}; }
+    QFuture<QString> generateImage(const QString&, const QString&, const QString&, const QString&,
+                                   const QString&, const QString&) override {
+        return {};
+    }
+
+    std::atomic<int> fetches {0};
+    QSemaphore gate;
+};
+
+} // namespace
+
+TEST(ModelListCacheTest, PersistsListsPerProviderAcrossInstances)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("nested/model_lists.json"));
+    const QString key = ModelListCache::credentialFingerprint(QStringLiteral("sk-one"));
+
+    {
+        ModelListCache cache(path);
+        EXPECT_FALSE(cache.lookup(QStringLiteral("openai"), key).has_value());
+        cache.store(QStringLiteral("openai"), key, {QStringLiteral("gpt-a"), QStringLiteral("gpt-b")});
+        cache.store(QStringLiteral("ollama"), QString(), {QStringLiteral("llama3")});
+        cache.store(QStringLiteral("google"), key, {}); // empty lists are never cached
+    }
+    ASSERT_TRUE(QFile::exists(path));
+
+    ModelListCache reloaded(path);
+    const auto openai = reloaded.lookup(QStringLiteral("OpenAI"), key);
+    ASSERT_TRUE(openai.has_value());
+    EXPECT_EQ(openai->models, (QStringList{QStringLiteral("gpt-a"), QStringLiteral("gpt-b")}));
+    EXPECT_FALSE(openai->stale);
+    EXPECT_TRUE(reloaded.lookup(QStringLiteral("ollama"), QString()).has_value());
+    EXPECT_FALSE(reloaded.lookup(QStringLiteral("google"), key).has_value());
+
+    // A different credential sees nothing; invalidation is persisted
+    EXPECT_FALSE(reloaded.lookup(QStringLiteral("openai"),
+                                 ModelListCache::credentialFingerprint(QStringLiteral("sk-two"))).has_value());
+    reloaded.invalidate(QStringLiteral("openai"));
+    EXPECT_FALSE(ModelListCache(path).lookup(QStringLiteral("openai"), key).has_value());
+}
+
+TEST(ModelListCacheTest, EntriesPastTheTtlAreServedAsStale)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    ModelListCache cache(dir.filePath(QStringLiteral("model_lists.json")), 1);
+
+    cache.store(QStringLiteral("anthropic"), QString(), {QStringLiteral("claude-x")});
+    QThread::msleep(1100);
+
+    const auto entry = cache.lookup(QStringLiteral("anthropic"), QString());
+    ASSERT_TRUE(entry.has_value());
+    EXPECT_TRUE(entry->stale);
+    EXPECT_EQ(entry->models, QStringList{QStringLiteral("claude-x")});
+}
+
+TEST(ModelListCacheTest, OnlyOneBackgroundRefreshPerProvider)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    ModelListCache cache(dir.filePath(QStringLiteral("model_lists.json")));
+
+    EXPECT_TRUE(cache.beginRefresh(QStringLiteral("openai")));
+    EXPECT_FALSE(cache.beginRefresh(QStringLiteral("openai")));
+    EXPECT_TRUE(cache.beginRefresh(QStringLiteral("google")));
+    cache.endRefresh(QStringLiteral("openai"));
+    EXPECT_TRUE(cache.beginRefresh(QStringLiteral("openai")));
+}
+
+TEST(ModelListCacheTest, CorruptFileIsIgnoredAndRewritten)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("model_lists.json"));
+    {
+        QFile file(path);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write("{ not json");
+    }
+
+    ModelListCache cache(path);
+    EXPECT_FALSE(cache.lookup(QStringLiteral("openai"), QString()).has_value());
+    cache.store(QStringLiteral("openai"), QString(), {QStringLiteral("gpt-a")});
+    EXPECT_TRUE(ModelListCache(path).lookup(QStringLiteral("openai"), QString()).has_value());
+}
+
+TEST(ModelListCacheTest, SlowProviderIsAnsweredAtTheDeadlineAndCachedWhenItReplies)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const auto previousCache = ModelListCache::shared();
+    const auto cache = std::make_shared<ModelListCache>(dir.filePath(QStringLiteral("model_lists.json")));
+    ModelListCache::setShared(cache);
+    auto backend = std::make_shared<SlowListingBackend>();
+    LLMProviderRegistry::instance().registerBackend(backend);
+    ModelCatalogService& catalog = ModelCatalogService::instance();
+    catalog.setDiscoveryDeadlineMs(100);
+
+    // Both callers give up at the deadline with the static list, sharing one request
+    QElapsedTimer timer;
+    timer.start();
+    QFuture<QList<ModelCatalogEntry>> first = catalog.fetchModels(QStringLiteral("slowlist"), ModelCatalogKind::Chat, true);
+    QFuture<QList<ModelCatalogEntry>> second = catalog.fetchModels(QStringLiteral("slowlist"), ModelCatalogKind::Chat, true);
+    first.waitForFinished();
+    second.waitForFinished();
+    EXPECT_LT(timer.elapsed(), 2000);
+    EXPECT_EQ(catalog.modelIds(first.result(), true), QStringList{QStringLiteral("static-model")});
+    EXPECT_EQ(catalog.modelIds(second.result(), true), QStringList{QStringLiteral("static-model")});
+    EXPECT_EQ(backend->fetches.load(), 1);
+
+    // The late answer still lands in the cache, where the next caller finds it at once
+    backend->gate.release();
+    const QString fingerprint =
+        ModelListCache::credentialFingerprint(LLMProviderRegistry::instance().getCredential(QStringLiteral("slowlist")));
+    for (int i = 0; i < 100 && !cache->lookup(QStringLiteral("slowlist"), fingerprint); ++i) {
+        QThread::msleep(20);
+    }
+    const auto cached = cache->lookup(QStringLiteral("slowlist"), fingerprint);
+    ASSERT_TRUE(cached.has_value());
+    EXPECT_EQ(cached->models, (QStringList{QStringLiteral("listed-a"), QStringLiteral("listed-b")}));
+
+    QFuture<QList<ModelCatalogEntry>> third = catalog.fetchModels(QStringLiteral("slowlist"));
+    third.waitForFinished();
+    const QStringList ids = catalog.modelIds(third.result(), true);
+    EXPECT_TRUE(ids.contains(QStringLiteral("listed-a")));
+    EXPECT_TRUE(ids.contains(QStringLiteral("static-model")));
+    EXPECT_EQ(backend->fetches.load(), 1);
+
+    catalog.setDiscoveryDeadlineMs(ModelCatalogService::kDefaultDiscoveryDeadlineMs);
+    ModelListCache::setShared(previousCache);
+}
@@ -25,6 +25,7 @@
 #include "TextInputNode.h"
 #include "ai/registry/LLMProviderRegistry.h"
 #include "ai/backends/ILLMBackend.h"
+#include "ai/backends/OpenAIBackend.h"
 #include "ModelCapsRegistry.h"
 #include "ModelCaps.h"
 
@@ -349,3 +350,52 @@ TEST(ModelSelectionIntegrationTest, BackendURLRouting_CompletionEndpointShouldUs
         << "Routing should use /v1/completions for endpoint=completion, but backend used: "
         << capturing->captured_url.toStdString();
 }
+
+class ProbeCountingOpenAI final : public OpenAIBackend {
+public:
+    int probes = 0;
+    long status = 200;
+
+protected:
+    cpr::Response assistantProbeRequest(const cpr::Header&, const CancellationToken&) override {
+        ++probes;
+        cpr::Response response;
+        response.status_code = status;
+        response.text = status == 200 ? "{\"data\":[]}" : "{\"error\":{\"message\":\"Invalid API key\"}}";
+        return response;
+    }
+};
+
+TEST(ModelSelectionIntegrationTest, AssistantProbeIsCachedPerApiKey)
+{
+    ensureApp();
+
+    QJsonArray rules;
+    rules.append(QJsonObject{
+        { QStringLiteral("id"), QStringLiteral("openai-assistant-probe") },
+        { QStringLiteral("pattern"), QStringLiteral("^gpt-5\\.2-pro$") },
+        { QStringLiteral("backend"), QStringLiteral("openai") },
+        { QStringLiteral("endpoint"), QStringLiteral("assistant") },
+        { QStringLiteral("priority"), 100 }
+    });
+    QTemporaryFile file;
+    ASSERT_TRUE(writeRulesToTempFile(file, rules));
+    ASSERT_TRUE(ModelCapsRegistry::instance().loadFromFile(file.fileName()));
+
+    ProbeCountingOpenAI backend;
+    const QString model = QStringLiteral("gpt-5.2-pro");
+    const LLMResult first = backend.sendPrompt(QStringLiteral("key-a"), model, 0.0, 16, QString(), QStringLiteral("ping"));
+    const LLMResult second = backend.sendPrompt(QStringLiteral("key-a"), model, 0.0, 16, QString(), QStringLiteral("ping"));
+    EXPECT_FALSE(first.hasError);
+    EXPECT_FALSE(second.hasError);
+    EXPECT_EQ(second.content, first.content);
+    EXPECT_EQ(backend.probes, 1);
+
+    // Another key is probed separately, and failed probes are not remembered
+    backend.status = 401;
+    EXPECT_TRUE(backend.sendPrompt(QStringLiteral("key-b"), model, 0.0, 16, QString(), QStringLiteral("ping")).hasError);
+    EXPECT_TRUE(backend.sendPrompt(QStringLiteral("key-b"), model, 0.0, 16, QString(), QStringLiteral("ping")).hasError);
+    EXPECT_EQ(backend.probes, 3);
+
+    ModelCapsRegistry::instance().loadFromFile(QStringLiteral(":/resources/model_caps.json"));
+}
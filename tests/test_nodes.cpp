@@ -6,24 +6,53 @@
 #include <QDebug>
 #include <QtGlobal>
 #include <cstdio>
+#include <mutex>
+#include <thread>
 #include "test_app.h"
 
 #include "TextInputNode.h"
 #include "TextInputPropertiesWidget.h"
 #include "PromptBuilderNode.h"
 #include "PromptBuilderPropertiesWidget.h"
+#include "PromptTemplate.h"
+#include "TokenEstimator.h"
 #include "PythonScriptNode.h"
 #include "PythonScriptPropertiesWidget.h"
+#include "BlobHandle.h"
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QLineEdit>
+#include <QStandardPaths>
 #include <QTextEdit>
+#include <QTemporaryDir>
+#include <QTcpSocket>
 #include <QTemporaryFile>
 #include <QTest>
 
+#include "AsyncLogSink.h"
+#include "DebugLogModel.h"
+#include "LargeTextView.h"
+#include "Logger.h"
+#include "MetricsExporter.h"
+#include "MetricsRegistry.h"
+#include "Tracer.h"
+#include "RotatingLogFile.h"
 #include "TextOutputNode.h"
 #include "TextOutputPropertiesWidget.h"
 
 #include "DatabaseNode.h"
 #include "DatabasePropertiesWidget.h"
+#include "ImageGenCache.h"
+#include "ImageGenNode.h"
+#include "NodeOutputDir.h"
+#include "ai/backends/ILLMBackend.h"
+#include "ai/registry/LLMProviderRegistry.h"
+#include "PartialOutputSink.h"
 
 // Install a Qt message handler to force all Qt logs to stderr (helps Windows CI capture qInfo/qWarning output)
 static void qtTestMessageHandler(QtMsgType type, const QMessageLogContext& ctx, const QString& msg)
@@ -129,6 +158,94 @@ TEST(PromptBuilderNodeTest, FormatsTemplateWithInput)
     delete w;
 }
 
+TEST(PromptTemplateTest, CompilesSlotsOnceAndRendersBatches)
+{
+    const PromptTemplate tpl(QStringLiteral("{a} and { b }, {} {{a}} {a}"));
+    EXPECT_EQ(tpl.variables(), (QStringList{QStringLiteral("a"), QStringLiteral("b")}));
+    EXPECT_EQ(tpl.uses(0), 3);
+    EXPECT_EQ(tpl.uses(1), 1);
+    EXPECT_EQ(tpl.literalText(), QStringLiteral(" and , {} {} "));
+
+    // Values are inserted as is, never rescanned for placeholders
+    QVariantMap values;
+    values.insert(QStringLiteral("a"), QStringLiteral("{b}"));
+    values.insert(QStringLiteral("b"), QStringLiteral("B"));
+    EXPECT_EQ(tpl.render(values), QStringLiteral("{b} and B, {} {{b}} {b}"));
+
+    QVariantMap second;
+    second.insert(QStringLiteral("a"), QStringLiteral("x"));
+    EXPECT_EQ(tpl.renderBatch({values, second}),
+              (QStringList{QStringLiteral("{b} and B, {} {{b}} {b}"), QStringLiteral("x and , {} {x} x")}));
+
+    PromptBuilderNode node;
+    node.setTemplateText(QStringLiteral("Hi {name}!"));
+    DataPacket alice;
+    alice.insert(QStringLiteral("name"), QStringLiteral("Alice"));
+    DataPacket bob;
+    bob.insert(QStringLiteral("name"), QStringLiteral("Bob"));
+    EXPECT_EQ(node.renderBatch({alice, bob}), (QStringList{QStringLiteral("Hi Alice!"), QStringLiteral("Hi Bob!")}));
+}
+
+TEST(TokenEstimatorTest, CountsAndDropsTheLowestRankedChunks)
+{
+    const TokenEstimator generic;
+    EXPECT_EQ(generic.count(u"abcdefgh"), 2);
+    EXPECT_EQ(generic.count(u""), 0);
+
+    // Words, digit groups and punctuation each cost about a token
+    const TokenEstimator openai(TokenEstimator::Family::OpenAI);
+    EXPECT_EQ(openai.count(u"Hello world"), 2);
+    EXPECT_EQ(openai.count(u"1234567"), 3);
+    EXPECT_LE(openai.count(openai.truncated(QStringLiteral("one two three four five"), 3)), 3);
+
+    const QString filler(80, u'x');
+    const QString context = QStringLiteral("[Reference: a.txt]\n%1\n\n[Reference: b.txt]\n%1\n\n[Reference: c.txt]\n%1")
+                                .arg(filler);
+    int dropped = 0;
+    const QString fitted = generic.fittedContext(context, 60, &dropped);
+    EXPECT_EQ(dropped, 1);
+    EXPECT_TRUE(fitted.contains(QStringLiteral("b.txt")));
+    EXPECT_FALSE(fitted.contains(QStringLiteral("c.txt")));
+    EXPECT_LE(generic.count(fitted), 60);
+
+    // Plain text is cut instead
+    EXPECT_LE(generic.count(generic.fittedContext(QString(400, u'y'), 10, &dropped)), 10);
+    EXPECT_EQ(dropped, 0);
+}
+
+TEST(PromptBuilderNodeTest, TokenBudgetDropsRetrievedChunks)
+{
+    ensureApp();
+
+    PromptBuilderNode node;
+    node.setTemplateText(QStringLiteral("Answer from the context.\n{input}"));
+    node.setTokenBudget(70);
+
+    const QString filler(80, u'x');
+    DataPacket in;
+    in.insert(QString::fromLatin1(PromptBuilderNode::kInputId),
+              QStringLiteral("[Reference: a.txt]\n%1\n\n[Reference: b.txt]\n%1\n\n[Reference: c.txt]\n%1").arg(filler));
+
+    ExecutionToken token;
+    token.data = in;
+    const TokenList outTokens = node.execute(TokenList{token});
+    ASSERT_FALSE(outTokens.empty());
+    const DataPacket& out = outTokens.front().data;
+    const QString prompt = out.value(QString::fromLatin1(PromptBuilderNode::kOutputId)).toString();
+    EXPECT_TRUE(prompt.contains(QStringLiteral("a.txt")));
+    EXPECT_FALSE(prompt.contains(QStringLiteral("c.txt")));
+    EXPECT_TRUE(out.value(QStringLiteral("_prompt_truncated")).toBool());
+    EXPECT_GE(out.value(QStringLiteral("_dropped_chunks")).toInt(), 1);
+    EXPECT_LE(out.value(QStringLiteral("_prompt_tokens")).toInt(), 70);
+
+    // Budget and tokenizer survive a save/load round trip
+    PromptBuilderNode restored;
+    node.setTokenizer(QStringLiteral("Anthropic"));
+    restored.loadState(node.saveState());
+    EXPECT_EQ(restored.tokenBudget(), 70);
+    EXPECT_EQ(restored.tokenizer(), QStringLiteral("anthropic"));
+}
+
 TEST(TextOutputNodeTest, UpdatesWidgetOnExecute)
 {
     ensureApp();
@@ -203,6 +320,412 @@ TEST(TextOutputNodeTest, FormatsComplexDataAsJson)
 }
 
 
+TEST(TextOutputNodeTest, PagesLargeTextAndSavesItInTheBackground)
+{
+    ensureApp();
+
+    TextOutputNode node;
+    QWidget* w = node.createConfigurationWidget(nullptr);
+    ASSERT_NE(w, nullptr);
+
+    QString text;
+    for (int i = 0; i < 40000; ++i) {
+        text += QStringLiteral("line %1 of a very large output\n").arg(i);
+    }
+    ASSERT_GT(text.size(), LargeTextView::kPagedThreshold);
+
+    DataPacket in;
+    in.insert(QString::fromLatin1(TextOutputNode::kInputId), text);
+    ExecutionToken token;
+    token.data = in;
+    TokenList tokens;
+    tokens.push_back(std::move(token));
+    (void)node.execute(tokens);
+    QTest::qWait(100);
+
+    auto* view = w->findChild<LargeTextView*>();
+    ASSERT_NE(view, nullptr);
+    ASSERT_TRUE(view->isPaged());
+    EXPECT_GT(view->pageCount(), 1);
+    EXPECT_EQ(view->toPlainText(), text);
+
+    // Only the current page is laid out, and pages end on line breaks
+    auto* edit = view->findChild<QTextEdit*>();
+    ASSERT_NE(edit, nullptr);
+    EXPECT_LE(edit->toPlainText().size(), LargeTextView::kPageLength);
+    EXPECT_TRUE(edit->toPlainText().startsWith(QStringLiteral("line 0 of")));
+    view->setCurrentPage(1);
+    EXPECT_EQ(view->currentPage(), 1);
+    EXPECT_TRUE(edit->toPlainText().startsWith(QStringLiteral("line ")));
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("output.txt"));
+    EXPECT_TRUE(LargeTextView::saveTextAsync(view->toPlainText(), path).result().isEmpty());
+    QFile saved(path);
+    ASSERT_TRUE(saved.open(QIODevice::ReadOnly | QIODevice::Text));
+    EXPECT_EQ(QString::fromUtf8(saved.readAll()), text);
+
+    delete w;
+}
+
+TEST(DebugLogModelTest, KeepsABoundedRingFiltersOffThreadAndRotatesTheFile)
+{
+    ensureApp();
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString logPath = dir.filePath(QStringLiteral("logs/debug.log"));
+
+    DebugLogModel model(1000);
+    model.setLogFile(logPath);
+    for (int i = 0; i < 2500; ++i) {
+        model.append(QStringLiteral("%1 line %2").arg(i % 10 == 0 ? QStringLiteral("Warning:") : QStringLiteral("info"))
+                         .arg(i));
+    }
+    // Lines are queued until the next flush
+    EXPECT_EQ(model.rowCount(), 0);
+    model.flush();
+
+    // Only the newest lines are held
+    EXPECT_EQ(model.rowCount(), 1000);
+    EXPECT_EQ(model.droppedLines(), 1500);
+    EXPECT_EQ(model.index(0).data().toString(), QStringLiteral("Warning: line 1500"));
+    EXPECT_EQ(model.index(999).data().toString(), QStringLiteral("info line 2499"));
+
+    model.setFilter(QStringLiteral("warning:"));
+    model.waitForFilter();
+    EXPECT_EQ(model.rowCount(), 100);
+    EXPECT_EQ(model.index(0).data().toString(), QStringLiteral("Warning: line 1500"));
+
+    // New lines are matched as they arrive, and old matches fall out with their lines
+    for (int i = 2500; i < 2600; ++i) {
+        model.append(QStringLiteral("%1 line %2").arg(i % 10 == 0 ? QStringLiteral("Warning:") : QStringLiteral("info"))
+                         .arg(i));
+    }
+    model.flush();
+    EXPECT_EQ(model.rowCount(), 100);
+    EXPECT_EQ(model.index(0).data().toString(), QStringLiteral("Warning: line 1600"));
+    EXPECT_EQ(model.index(99).data().toString(), QStringLiteral("Warning: line 2590"));
+
+    model.setFilter(QString());
+    EXPECT_EQ(model.rowCount(), 1000);
+
+    // The file keeps every line, not only those still in the ring
+    model.waitForLogFile();
+    QFile file(logPath);
+    ASSERT_TRUE(file.open(QIODevice::ReadOnly | QIODevice::Text));
+    const QStringList written = QString::fromUtf8(file.readAll()).split(QLatin1Char('\n'), Qt::SkipEmptyParts);
+    ASSERT_EQ(written.size(), 2600);
+    EXPECT_EQ(written.first(), QStringLiteral("Warning: line 0"));
+
+    // Past its size limit the file moves to .1 and a new one starts
+    const QString rotatingPath = dir.filePath(QStringLiteral("rotating.log"));
+    RotatingLogFile rotating(rotatingPath, 100, 2);
+    for (int i = 0; i < 30; ++i) {
+        ASSERT_TRUE(rotating.append({QStringLiteral("0123456789012345678")}));
+    }
+    EXPECT_LE(QFileInfo(rotatingPath).size(), 100);
+    EXPECT_TRUE(QFile::exists(RotatingLogFile::rotatedPath(rotatingPath, 1)));
+    EXPECT_TRUE(QFile::exists(RotatingLogFile::rotatedPath(rotatingPath, 2)));
+    EXPECT_FALSE(QFile::exists(RotatingLogFile::rotatedPath(rotatingPath, 3)));
+}
+
+TEST(AsyncLogSinkTest, RateLimitsOffTheCallingThreadAndWritesJsonLines)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString jsonPath = dir.filePath(QStringLiteral("logs/app.jsonl"));
+
+    AsyncLogSink::Config config;
+    config.jsonPath = jsonPath;
+    config.rateLimitPerSecond = 100;
+    config.sampling.insert(QStringLiteral("sampled"), 10);
+
+    std::mutex mutex;
+    QStringList shown;
+    bool shownOnCaller = false;
+    const std::thread::id caller = std::this_thread::get_id();
+    {
+        AsyncLogSink sink(config, [&](const QList<AsyncLogSink::Record>& records) {
+            std::lock_guard<std::mutex> lock(mutex);
+            shownOnCaller = shownOnCaller || std::this_thread::get_id() == caller;
+            for (const AsyncLogSink::Record& record : records) {
+                shown.append(AsyncLogSink::formatLine(record));
+            }
+        });
+
+        std::vector<std::thread> producers;
+        for (int t = 0; t < 4; ++t) {
+            producers.emplace_back([&sink, t]() {
+                for (int i = 0; i < 100; ++i) {
+                    sink.post(AsyncLogSink::Level::Info, QStringLiteral("noisy"),
+                              QStringLiteral("thread %1 line %2").arg(t).arg(i));
+                }
+            });
+        }
+        for (std::thread& producer : producers) {
+            producer.join();
+        }
+        for (int i = 0; i < 50; ++i) {
+            sink.post(AsyncLogSink::Level::Warning, QString(), QStringLiteral("warning %1").arg(i));
+        }
+        for (int i = 0; i < 100; ++i) {
+            sink.post(AsyncLogSink::Level::Info, QStringLiteral("sampled"), QStringLiteral("sample %1").arg(i));
+        }
+        sink.flush();
+
+        // A category gets its limit per second, sampling keeps one in ten, warnings all pass
+        std::lock_guard<std::mutex> lock(mutex);
+        EXPECT_FALSE(shownOnCaller);
+        EXPECT_EQ(shown.filter(QStringLiteral("[noisy] thread")).size(), 100);
+        EXPECT_EQ(shown.filter(QStringLiteral("Warning: warning")).size(), 50);
+        EXPECT_EQ(shown.filter(QStringLiteral("[sampled] sample")).size(), 10);
+        EXPECT_TRUE(shown.contains(QStringLiteral("[sampled] sample 0")));
+        EXPECT_EQ(sink.droppedRecords(), 390u);
+    }
+
+    // Stopping writes the summary of what the limit dropped
+    ASSERT_EQ(shown.size(), 161);
+    EXPECT_EQ(shown.last(), QStringLiteral("[noisy] 300 records dropped by the rate limit of 100 per second"));
+
+    QFile file(jsonPath);
+    ASSERT_TRUE(file.open(QIODevice::ReadOnly | QIODevice::Text));
+    const QList<QByteArray> lines = file.readAll().split('\n');
+    ASSERT_EQ(lines.size(), 162);
+    EXPECT_TRUE(lines.last().isEmpty());
+    QJsonParseError error;
+    const QJsonObject first = QJsonDocument::fromJson(lines.first(), &error).object();
+    ASSERT_EQ(error.error, QJsonParseError::NoError);
+    EXPECT_EQ(first.value(QStringLiteral("level")).toString(), QStringLiteral("info"));
+    EXPECT_EQ(first.value(QStringLiteral("category")).toString(), QStringLiteral("noisy"));
+    EXPECT_TRUE(first.value(QStringLiteral("message")).toString().startsWith(QStringLiteral("thread ")));
+    EXPECT_TRUE(QDateTime::fromString(first.value(QStringLiteral("ts")).toString(), Qt::ISODateWithMs).isValid());
+    EXPECT_FALSE(first.value(QStringLiteral("thread")).toString().isEmpty());
+}
+
+TEST(AsyncLogSinkTest, DisabledDebugLinesAreNotBuilt)
+{
+    const bool wasEnabled = AppLogHelper::isGlobalDebugEnabled();
+    AppLogHelper::setGlobalDebugEnabled(false);
+    if (AppLogHelper::isEnabled(false)) {
+        AppLogHelper::setGlobalDebugEnabled(wasEnabled);
+        GTEST_SKIP() << "A main window or CP_LOG_JSON keeps debug lines enabled";
+    }
+    int evaluated = 0;
+    CP_LOG << "built " << ++evaluated;
+    CP_CLOG(test) << "built " << ++evaluated;
+    EXPECT_EQ(evaluated, 0);
+
+    AppLogHelper::setGlobalDebugEnabled(true);
+    CP_CLOG(test) << "built " << ++evaluated;
+    AppLogHelper::flush();
+    EXPECT_EQ(evaluated, 1);
+    AppLogHelper::setGlobalDebugEnabled(wasEnabled);
+}
+
+TEST(MetricsRegistryTest, ExportsTextFormatsAndJson)
+{
+    MetricsRegistry registry;
+    const MetricsRegistry::Labels labels = {{QStringLiteral("host"), QStringLiteral("api\"1")}};
+    registry.counter(QStringLiteral("cp_requests"), QStringLiteral("Requests sent"), labels).increment(3);
+    registry.gauge(QStringLiteral("cp_depth"), QStringLiteral("Queue depth")).set(-2);
+    auto& histogram = registry.histogram(QStringLiteral("cp_seconds"), QStringLiteral("Latency"),
+                                         MetricsRegistry::Labels(), {0.1, 1.0});
+    histogram.observe(0.05);
+    histogram.observe(0.5);
+    histogram.observe(5.0);
+    // The same name and labels give back the same series
+    registry.counter(QStringLiteral("cp_requests"), QString(), labels).increment();
+
+    const QString text = QString::fromUtf8(registry.exposition());
+    EXPECT_TRUE(text.contains(QStringLiteral("# TYPE cp_requests_total counter\n")));
+    EXPECT_TRUE(text.contains(QStringLiteral("cp_requests_total{host=\"api\\\"1\"} 4\n")));
+    EXPECT_TRUE(text.contains(QStringLiteral("cp_depth -2\n")));
+    EXPECT_TRUE(text.contains(QStringLiteral("cp_seconds_bucket{le=\"0.1\"} 1\n")));
+    EXPECT_TRUE(text.contains(QStringLiteral("cp_seconds_bucket{le=\"1\"} 2\n")));
+    EXPECT_TRUE(text.contains(QStringLiteral("cp_seconds_bucket{le=\"+Inf\"} 3\n")));
+    EXPECT_TRUE(text.contains(QStringLiteral("cp_seconds_sum 5.55\n")));
+    EXPECT_TRUE(text.contains(QStringLiteral("cp_seconds_count 3\n")));
+    EXPECT_FALSE(text.contains(QStringLiteral("# EOF")));
+
+    const QString openMetrics = QString::fromUtf8(registry.exposition(MetricsRegistry::TextFormat::OpenMetrics));
+    EXPECT_TRUE(openMetrics.contains(QStringLiteral("# TYPE cp_requests counter\n")));
+    EXPECT_TRUE(openMetrics.endsWith(QStringLiteral("# EOF\n")));
+
+    // A name taken by another type is refused rather than exported twice
+    registry.gauge(QStringLiteral("cp_requests"), QString()).set(99);
+    EXPECT_FALSE(QString::fromUtf8(registry.exposition()).contains(QStringLiteral(" 99\n")));
+
+    const QJsonArray metrics = registry.toJson().value(QStringLiteral("metrics")).toArray();
+    ASSERT_EQ(metrics.size(), 3);
+    for (const QJsonValue& metric : metrics) {
+        const QJsonObject object = metric.toObject();
+        const QJsonObject sample = object.value(QStringLiteral("samples")).toArray().first().toObject();
+        if (object.value(QStringLiteral("name")).toString() == QLatin1String("cp_seconds")) {
+            EXPECT_EQ(object.value(QStringLiteral("type")).toString(), QStringLiteral("histogram"));
+            EXPECT_EQ(sample.value(QStringLiteral("count")).toInteger(), 3);
+            EXPECT_EQ(sample.value(QStringLiteral("buckets")).toObject().value(QStringLiteral("1")).toInteger(), 2);
+        } else if (object.value(QStringLiteral("name")).toString() == QLatin1String("cp_requests")) {
+            EXPECT_EQ(sample.value(QStringLiteral("labels")).toObject().value(QStringLiteral("host")).toString(),
+                      QStringLiteral("api\"1"));
+            EXPECT_EQ(sample.value(QStringLiteral("value")).toDouble(), 4.0);
+        }
+    }
+}
+
+TEST(MetricsRegistryTest, CallbackGaugesAreReadAtExportUntilReleased)
+{
+    MetricsRegistry registry;
+    int reads = 0;
+    MetricsRegistry::CallbackHandle handle = registry.addGaugeCallback(
+        QStringLiteral("cp_live"), QStringLiteral("Read on export"), MetricsRegistry::Labels(), [&reads]() {
+            ++reads;
+            return 7.0;
+        });
+    EXPECT_EQ(reads, 0);
+    EXPECT_TRUE(QString::fromUtf8(registry.exposition()).contains(QStringLiteral("cp_live 7\n")));
+    EXPECT_EQ(reads, 1);
+
+    handle.reset();
+    EXPECT_TRUE(QString::fromUtf8(registry.exposition()).contains(QStringLiteral("cp_live 0\n")));
+    EXPECT_EQ(reads, 1);
+}
+
+TEST(MetricsExporterTest, ServesScrapesOverHttp)
+{
+    ensureApp();
+    MetricsRegistry registry;
+    registry.counter(QStringLiteral("cp_scraped"), QStringLiteral("Test counter")).increment(2);
+
+    const QByteArray notFound = MetricsExporter::respond("GET /other HTTP/1.1\r\n\r\n", registry);
+    EXPECT_TRUE(notFound.startsWith("HTTP/1.1 404"));
+    EXPECT_TRUE(MetricsExporter::respond("POST /metrics HTTP/1.1\r\n\r\n", registry).startsWith("HTTP/1.1 405"));
+    const QByteArray openMetrics = MetricsExporter::respond(
+        "GET /metrics HTTP/1.1\r\nAccept: application/openmetrics-text; version=1.0.0\r\n\r\n", registry);
+    EXPECT_TRUE(openMetrics.contains("application/openmetrics-text"));
+    EXPECT_TRUE(openMetrics.endsWith("# EOF\n"));
+    const QByteArray json = MetricsExporter::respond("GET /metrics.json HTTP/1.1\r\n\r\n", registry);
+    EXPECT_TRUE(json.contains("application/json"));
+    EXPECT_TRUE(json.contains("\"cp_scraped\""));
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    MetricsExporter::Config config;
+    config.port = 0;
+    config.jsonPath = dir.filePath(QStringLiteral("metrics.json"));
+    MetricsExporter exporter(config, &registry);
+    QString error;
+    ASSERT_TRUE(exporter.start(&error)) << error.toStdString();
+    ASSERT_NE(exporter.serverPort(), 0);
+
+    QTcpSocket socket;
+    socket.connectToHost(QHostAddress::LocalHost, exporter.serverPort());
+    ASSERT_TRUE(socket.waitForConnected(5000));
+    socket.write("GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    QByteArray response;
+    while (socket.state() == QAbstractSocket::ConnectedState && socket.waitForReadyRead(5000)) {
+        response += socket.readAll();
+    }
+    response += socket.readAll();
+    EXPECT_TRUE(response.startsWith("HTTP/1.1 200"));
+    EXPECT_TRUE(response.contains("text/plain; version=0.0.4"));
+    EXPECT_TRUE(response.contains("cp_scraped_total 2\n"));
+
+    ASSERT_TRUE(exporter.writeJson());
+    QFile file(config.jsonPath);
+    ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+    EXPECT_FALSE(QJsonDocument::fromJson(file.readAll()).object().value(QStringLiteral("metrics")).toArray().isEmpty());
+}
+
+TEST(TracerTest, ParsesAndFormatsTraceparent)
+{
+    const QByteArray header = "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01";
+    const Tracer::Context context = Tracer::Context::fromTraceparent(header);
+    ASSERT_TRUE(context.isValid());
+    EXPECT_EQ(context.traceId, QByteArray("4bf92f3577b34da6a3ce929d0e0e4736"));
+    EXPECT_EQ(context.spanId, QByteArray("00f067aa0ba902b7"));
+    EXPECT_TRUE(context.sampled);
+    EXPECT_EQ(context.traceparent(), header);
+
+    EXPECT_FALSE(Tracer::Context::fromTraceparent("00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-00").sampled);
+    EXPECT_FALSE(Tracer::Context::fromTraceparent("00-00000000000000000000000000000000-00f067aa0ba902b7-01").isValid());
+    EXPECT_FALSE(Tracer::Context::fromTraceparent("00-4BF92F3577B34DA6A3CE929D0E0E4736-00f067aa0ba902b7-01").isValid());
+    EXPECT_FALSE(Tracer::Context::fromTraceparent("garbage").isValid());
+}
+
+TEST(TracerTest, ExportsNestedSpansAsOtlpJson)
+{
+    Tracer disabled{Tracer::Config()};
+    EXPECT_FALSE(disabled.isEnabled());
+    EXPECT_FALSE(disabled.startSpan(QStringLiteral("ignored")).isRecording());
+
+    std::mutex mutex;
+    QList<QByteArray> bodies;
+    Tracer::Config config;
+    config.serviceName = QStringLiteral("tracer-test");
+    Tracer tracer(config, [&](const QByteArray& body) {
+        std::lock_guard<std::mutex> lock(mutex);
+        bodies.append(body);
+        return true;
+    });
+    ASSERT_TRUE(tracer.isEnabled());
+
+    Tracer::Context rootContext;
+    {
+        Tracer::Span root = tracer.startSpan(QStringLiteral("pipeline run"));
+        ASSERT_TRUE(root.isRecording());
+        rootContext = root.context();
+        const Tracer::Scope scope(root);
+        EXPECT_EQ(Tracer::current().spanId, rootContext.spanId);
+        EXPECT_EQ(Tracer::currentSpan(), &root);
+
+        // Work moved to another thread keeps its parent through the captured context
+        std::thread([&tracer, context = Tracer::current()]() {
+            const Tracer::Scope threadScope(context);
+            Tracer::Span child = tracer.startSpan(QStringLiteral("POST"), Tracer::Kind::Client);
+            child.setAttribute(QStringLiteral("http.response.status_code"), 503);
+            child.setError(QStringLiteral("503"));
+        }).join();
+        root.setAttribute(QStringLiteral("cp.run.foreground"), true);
+    }
+    EXPECT_FALSE(Tracer::current().isValid());
+    tracer.flush();
+
+    QJsonArray spans;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const QByteArray& body : std::as_const(bodies)) {
+            const QJsonObject resourceSpans =
+                QJsonDocument::fromJson(body).object().value(QStringLiteral("resourceSpans")).toArray().first().toObject();
+            const QJsonObject serviceName = resourceSpans.value(QStringLiteral("resource")).toObject()
+                                                .value(QStringLiteral("attributes")).toArray().first().toObject();
+            EXPECT_EQ(serviceName.value(QStringLiteral("value")).toObject().value(QStringLiteral("stringValue")).toString(),
+                      QStringLiteral("tracer-test"));
+            const QJsonArray batch = resourceSpans.value(QStringLiteral("scopeSpans")).toArray().first().toObject()
+                                         .value(QStringLiteral("spans")).toArray();
+            for (const QJsonValue& span : batch) spans.append(span);
+        }
+    }
+    ASSERT_EQ(spans.size(), 2);
+    // The child ends first
+    const QJsonObject child = spans.at(0).toObject();
+    const QJsonObject root = spans.at(1).toObject();
+    EXPECT_EQ(root.value(QStringLiteral("name")).toString(), QStringLiteral("pipeline run"));
+    EXPECT_FALSE(root.contains(QStringLiteral("parentSpanId")));
+    EXPECT_EQ(child.value(QStringLiteral("traceId")).toString(), QString::fromLatin1(rootContext.traceId));
+    EXPECT_EQ(child.value(QStringLiteral("parentSpanId")).toString(), QString::fromLatin1(rootContext.spanId));
+    EXPECT_EQ(child.value(QStringLiteral("kind")).toInt(), 3);
+    EXPECT_EQ(child.value(QStringLiteral("status")).toObject().value(QStringLiteral("code")).toInt(), 2);
+    const QJsonObject status = child.value(QStringLiteral("attributes")).toArray().first().toObject();
+    EXPECT_EQ(status.value(QStringLiteral("key")).toString(), QStringLiteral("http.response.status_code"));
+    EXPECT_EQ(status.value(QStringLiteral("value")).toObject().value(QStringLiteral("intValue")).toString(),
+              QStringLiteral("503"));
+    EXPECT_LE(root.value(QStringLiteral("startTimeUnixNano")).toString().toLongLong(),
+              child.value(QStringLiteral("startTimeUnixNano")).toString().toLongLong());
+    EXPECT_EQ(tracer.droppedSpans(), 0u);
+}
+
 TEST(PythonScriptNodeTest, ExecutesScriptAndHandlesIO)
 {
     ensureApp();
@@ -286,6 +809,222 @@ TEST(PythonScriptNodeTest, ExecutesScriptAndHandlesIO)
 }
 
 
+TEST(PythonScriptNodeTest, PersistentWorkerReusesInterpreterAndRecycles)
+{
+    ensureApp();
+
+    QString python = QStandardPaths::findExecutable(QStringLiteral("python3"));
+    if (python.isEmpty()) {
+        python = QStandardPaths::findExecutable(QStringLiteral("python"));
+    }
+    if (python.isEmpty()) {
+        GTEST_SKIP() << "No Python interpreter on PATH";
+    }
+
+    const auto runScript = [](PythonScriptNode& node, const QString& stdinText) {
+        ExecutionToken token;
+        token.data.insert(QStringLiteral("stdin"), stdinText);
+        TokenList tokens;
+        tokens.push_back(std::move(token));
+        const TokenList out = node.execute(tokens);
+        return out.empty() ? DataPacket() : out.front().data;
+    };
+
+    // Prints the worker's pid, proves the namespace is fresh and echoes stdin
+    const QString script = QString::fromLatin1(
+        "import os, sys\n"
+        "print(os.getpid())\n"
+        "print('leftover' in globals())\n"
+        "leftover = 1\n"
+        "print(sys.stdin.read())\n");
+
+    PythonScriptNode node;
+    node.loadState(QJsonObject{{QStringLiteral("executable"), python + QStringLiteral(" -u")},
+                               {QStringLiteral("script"), script},
+                               {QStringLiteral("persistentWorker"), true},
+                               {QStringLiteral("workerMaxJobs"), 2}});
+
+    const DataPacket first = runScript(node, QStringLiteral("one"));
+    const DataPacket second = runScript(node, QStringLiteral("two"));
+    const DataPacket third = runScript(node, QStringLiteral("three"));
+    ASSERT_FALSE(first.contains(QStringLiteral("__error"))) << first.value(QStringLiteral("__error")).toString().toStdString();
+
+    const QStringList firstLines = first.value(QStringLiteral("stdout")).toString().split(u'\n');
+    const QStringList secondLines = second.value(QStringLiteral("stdout")).toString().split(u'\n');
+    const QStringList thirdLines = third.value(QStringLiteral("stdout")).toString().split(u'\n');
+    ASSERT_GE(firstLines.size(), 3);
+    ASSERT_GE(secondLines.size(), 3);
+    ASSERT_GE(thirdLines.size(), 3);
+
+    EXPECT_EQ(firstLines.at(0), secondLines.at(0));
+    EXPECT_NE(secondLines.at(0), thirdLines.at(0)) << "the worker is recycled after two jobs";
+    EXPECT_EQ(secondLines.at(1), QStringLiteral("False"));
+    EXPECT_EQ(firstLines.at(2), QStringLiteral("one"));
+    EXPECT_EQ(secondLines.at(2), QStringLiteral("two"));
+
+    // A failing script reports like a failing process and leaves the worker usable
+    node.loadState(QJsonObject{{QStringLiteral("script"), QStringLiteral("import sys\nsys.exit(3)\n")}});
+    const DataPacket failed = runScript(node, QString());
+    EXPECT_EQ(failed.value(QStringLiteral("_exit_code")).toInt(), 3);
+    EXPECT_TRUE(failed.contains(QStringLiteral("__error")));
+
+    PythonWorkerPool::shutdown();
+}
+
+TEST(PythonScriptNodeTest, DataPinsExchangeThroughMappedFiles)
+{
+    ensureApp();
+
+    QString python = QStandardPaths::findExecutable(QStringLiteral("python3"));
+    if (python.isEmpty()) {
+        python = QStandardPaths::findExecutable(QStringLiteral("python"));
+    }
+    if (python.isEmpty()) {
+        GTEST_SKIP() << "No Python interpreter on PATH";
+    }
+
+    // Rows arrive as JSON Lines; the sum goes back as JSON, the raw input as bytes
+    const QString script = QString::fromLatin1(
+        "import cp_data\n"
+        "rows = cp_data.read()\n"
+        "print(cp_data.mime_type())\n"
+        "if rows[0].get('raw'):\n"
+        "    cp_data.write(bytes(cp_data.buffer()))\n"
+        "else:\n"
+        "    cp_data.write({'total': sum(row['n'] for row in rows)})\n");
+    const QVariantList rows{QVariantMap{{QStringLiteral("n"), 2}}, QVariantMap{{QStringLiteral("n"), 5}}};
+
+    for (const bool persistent : {false, true}) {
+        PythonScriptNode node;
+        node.loadState(QJsonObject{{QStringLiteral("executable"), python + QStringLiteral(" -u")},
+                                   {QStringLiteral("script"), script},
+                                   {QStringLiteral("persistentWorker"), persistent}});
+
+        ExecutionToken token;
+        token.data.insert(QString::fromLatin1(PythonScriptNode::kDataPinId), rows);
+        TokenList tokens;
+        tokens.push_back(std::move(token));
+        const TokenList out = node.execute(tokens);
+        ASSERT_EQ(out.size(), 1u);
+        const DataPacket packet = out.front().data;
+        ASSERT_FALSE(packet.contains(QStringLiteral("__error"))) << packet.value(QStringLiteral("__error")).toString().toStdString();
+        EXPECT_EQ(packet.value(QStringLiteral("stdout")).toString().trimmed(), QStringLiteral("application/x-ndjson"));
+        EXPECT_EQ(packet.value(QString::fromLatin1(PythonScriptNode::kDataPinId)).toMap().value(QStringLiteral("total")).toInt(), 7);
+
+        // Bytes come back as a file-backed blob
+        ExecutionToken raw;
+        raw.data.insert(QString::fromLatin1(PythonScriptNode::kDataPinId),
+                        QVariantList{QVariantMap{{QStringLiteral("raw"), true}}});
+        TokenList rawTokens;
+        rawTokens.push_back(std::move(raw));
+        const TokenList rawOut = node.execute(rawTokens);
+        ASSERT_EQ(rawOut.size(), 1u);
+        const QVariant blobValue = rawOut.front().data.value(QString::fromLatin1(PythonScriptNode::kDataPinId));
+        ASSERT_EQ(blobValue.metaType(), QMetaType::fromType<BlobHandle>());
+        const BlobHandle blob = blobValue.value<BlobHandle>();
+        EXPECT_EQ(blob.mimeType(), QStringLiteral("application/octet-stream"));
+        EXPECT_EQ(blob.bytes(), QByteArray("{\"raw\":true}\n"));
+    }
+
+    PythonWorkerPool::shutdown();
+}
+
+namespace {
+
+// Writes the request number into each image, so a linked cache entry shows the number
+// of the request that produced it
+class CountingImageBackend final : public ILLMBackend {
+public:
+    QString id() const override { return QStringLiteral("image-cache-test"); }
+    QString name() const override { return QStringLiteral("Counting Image Backend"); }
+    QStringList availableModels() const override { return {QStringLiteral("painter")}; }
+    QStringList availableEmbeddingModels() const override { return {}; }
+    QFuture<QStringList> fetchModelList() override {
+        return QtConcurrent::run([]() { return QStringList{QStringLiteral("painter")}; });
+    }
+    LLMResult sendPrompt(const QString&, const QString&, double, int, const QString&, const QString&,
+                         const LLMMessage& = {}) override {
+        return {};
+    }
+    EmbeddingResult getEmbedding(const QString&, const QString&, const QString&) override { return {}; }
+    QFuture<QString> generateImage(const QString&, const QString&, const QString&, const QString&,
+                                   const QString&, const QString& targetDir) override {
+        const int request = ++calls;
+        return QtConcurrent::run([targetDir, request]() {
+            const QString path = QDir(targetDir).filePath(QStringLiteral("generated_image.png"));
+            QFile file(path);
+            if (!file.open(QIODevice::WriteOnly)) return QString();
+            file.write(QByteArray("image ") + QByteArray::number(request));
+            return path;
+        });
+    }
+
+    std::atomic<int> calls {0};
+};
+
+QByteArray readAll(const QString& path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+} // namespace
+
+TEST(ImageGenNodeTest, RepeatedRequestsAreLinkedFromTheImageCache)
+{
+    ensureApp();
+
+    QTemporaryDir cacheDir;
+    QTemporaryDir runsDir;
+    ASSERT_TRUE(cacheDir.isValid());
+    ASSERT_TRUE(runsDir.isValid());
+    ImageGenCache::setShared(std::make_shared<ImageGenCache>(cacheDir.path()));
+    auto backend = std::make_shared<CountingImageBackend>();
+    LLMProviderRegistry::instance().registerBackend(backend);
+
+    ImageGenNode node;
+    node.loadState(QJsonObject{{QStringLiteral("provider"), backend->id()},
+                               {QStringLiteral("model"), QStringLiteral("painter")}});
+
+    int run = 0;
+    const auto generate = [&](const QString& prompt) {
+        ExecutionToken token;
+        token.data.insert(QString::fromLatin1(ImageGenNode::kInputPromptPinId), prompt);
+        token.data.insert(NodeOutputDir::inputKey(), runsDir.filePath(QStringLiteral("run_%1").arg(++run)));
+        const TokenList out = node.execute(TokenList{token});
+        return out.empty() ? DataPacket() : out.front().data;
+    };
+
+    const DataPacket first = generate(QStringLiteral("a lighthouse"));
+    ASSERT_FALSE(first.contains(QStringLiteral("__error"))) << first.value(QStringLiteral("__error")).toString().toStdString();
+    EXPECT_EQ(backend->calls.load(), 1);
+    EXPECT_EQ(first.value(QStringLiteral("_image_cache_hits")).toInt(), 0);
+
+    // Same prompt and settings: linked into the new run's directory without a request
+    const DataPacket second = generate(QStringLiteral("a lighthouse"));
+    const QString secondPath = second.value(QString::fromLatin1(ImageGenNode::kOutputImagePathPinId)).toString();
+    EXPECT_EQ(backend->calls.load(), 1);
+    EXPECT_EQ(second.value(QStringLiteral("_image_cache_hits")).toInt(), 1);
+    EXPECT_TRUE(secondPath.startsWith(runsDir.filePath(QStringLiteral("run_2")))) << secondPath.toStdString();
+    EXPECT_EQ(readAll(secondPath), QByteArray("image 1"));
+
+    // Another prompt misses; always regenerating asks again and refreshes the entry
+    generate(QStringLiteral("a lighthouse at night"));
+    EXPECT_EQ(backend->calls.load(), 2);
+    node.loadState(QJsonObject{{QStringLiteral("always_regenerate"), true}});
+    const DataPacket forced = generate(QStringLiteral("a lighthouse"));
+    EXPECT_EQ(backend->calls.load(), 3);
+    EXPECT_EQ(forced.value(QStringLiteral("_image_cache_hits")).toInt(), 0);
+
+    node.loadState(QJsonObject{{QStringLiteral("always_regenerate"), false}});
+    const DataPacket refreshed = generate(QStringLiteral("a lighthouse"));
+    EXPECT_EQ(backend->calls.load(), 3);
+    EXPECT_EQ(readAll(refreshed.value(QString::fromLatin1(ImageGenNode::kOutputImagePathPinId)).toString()),
+              QByteArray("image 3"));
+
+    ImageGenCache::setShared(nullptr);
+}
+
 TEST(DatabaseNodeTest, ExecutesQueries)
 {
     ensureApp();
@@ -362,3 +1101,75 @@ TEST(DatabaseNodeTest, ExecutesQueries)
 
     delete w;
 }
+
+TEST(DatabaseNodeTest, RowsModePagesTheCursorIntoJsonTokens)
+{
+    ensureApp();
+
+    QTemporaryFile tempFile;
+    ASSERT_TRUE(tempFile.open());
+    const QString dbPath = tempFile.fileName();
+    tempFile.close();
+
+    DatabaseNode node;
+    QWidget* w = node.createConfigurationWidget(nullptr);
+    auto* props = dynamic_cast<DatabasePropertiesWidget*>(w);
+    ASSERT_NE(props, nullptr);
+    props->setDatabasePath(dbPath);
+    props->setResultFormat(QString::fromLatin1(DatabaseNode::kResultRows));
+    props->setPageSize(2);
+    EXPECT_EQ(node.resultFormat(), QString::fromLatin1(DatabaseNode::kResultRows));
+    EXPECT_EQ(node.pageSize(), 2);
+
+    auto run = [&node](const QString& sql) {
+        ExecutionToken token;
+        token.data.insert(QStringLiteral("sql"), sql);
+        return node.execute(TokenList{token});
+    };
+    run(QStringLiteral("CREATE TABLE t (id INTEGER PRIMARY KEY, name TEXT, payload BLOB);"
+                       "INSERT INTO t VALUES (1, 'a', NULL);"
+                       "INSERT INTO t VALUES (2, 'b', X'0102');"
+                       "INSERT INTO t VALUES (3, NULL, NULL);"
+                       "INSERT INTO t VALUES (4, 'd', NULL);"
+                       "INSERT INTO t VALUES (5, 'e', NULL);"));
+
+    // Without a sink the pages come back ahead of the summary token
+    const TokenList outputs = run(QStringLiteral("SELECT id, name, payload FROM t ORDER BY id"));
+    ASSERT_EQ(outputs.size(), 4u);
+    QJsonArray rows;
+    for (size_t i = 0; i + 1 < outputs.size(); ++i) {
+        const QJsonArray page =
+            QJsonDocument::fromJson(outputs.at(i).data.value(QStringLiteral("rows")).toString().toUtf8()).array();
+        EXPECT_LE(page.size(), 2);
+        for (const QJsonValue& row : page) rows.append(row);
+    }
+    ASSERT_EQ(rows.size(), 5);
+    EXPECT_EQ(rows.at(0).toObject().value(QStringLiteral("name")).toString(), QStringLiteral("a"));
+    EXPECT_EQ(rows.at(1).toObject().value(QStringLiteral("payload")).toString(), QStringLiteral("AQI="));
+    EXPECT_TRUE(rows.at(2).toObject().value(QStringLiteral("name")).isNull());
+    EXPECT_EQ(rows.at(4).toObject().value(QStringLiteral("id")).toInt(), 5);
+    const DataPacket& summary = outputs.back().data;
+    EXPECT_TRUE(summary.value(QStringLiteral("stderr")).toString().isEmpty());
+    EXPECT_TRUE(summary.value(QStringLiteral("stdout")).toString().contains(QStringLiteral("5")));
+
+    // With a sink each page is published as it fills
+    int published = 0;
+    {
+        const PartialOutputSink::Scope sinkScope(PartialOutputSink([&published](const TokenList& tokens) {
+            for (const auto& token : tokens) {
+                EXPECT_TRUE(token.forceExecution);
+                ++published;
+            }
+        }));
+        const TokenList streamed = run(QStringLiteral("SELECT id FROM t"));
+        EXPECT_EQ(streamed.size(), 1u);
+    }
+    EXPECT_EQ(published, 3);
+
+    DatabaseNode restored;
+    restored.loadState(node.saveState());
+    EXPECT_EQ(restored.resultFormat(), QString::fromLatin1(DatabaseNode::kResultRows));
+    EXPECT_EQ(restored.pageSize(), 2);
+
+    delete w;
+}
@@ -1,9 +1,16 @@
 #include <gtest/gtest.h>
 #include <QApplication>
+#include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QFileInfo>
 #include <QDir>
 #include <QTextStream>
+#include <QMutex>
+#include <QColor>
+#include <QImage>
+#include <QJsonObject>
+#include "PartialOutputSink.h"
+#include "PdfRenderCache.h"
 #include "PdfToImageNode.h"
 #include "test_app.h"
 
@@ -76,3 +83,281 @@ TEST(PdfToImageNodeTest, PathHandling)
     EXPECT_FALSE(imagePath.isEmpty());
     EXPECT_TRUE(QFileInfo::exists(imagePath));
 }
+
+// 100x100 pt pages, one content stream each, with a correct cross-reference table
+static bool writePdf(QTemporaryFile& file, const QList<QByteArray>& pageContents)
+{
+    const qsizetype pages = pageContents.size();
+    QByteArray kids;
+    for (qsizetype page = 0; page < pages; ++page) {
+        kids += QByteArray::number(3 + page) + " 0 R ";
+    }
+    QList<QByteArray> objects = {
+        "<< /Type /Catalog /Pages 2 0 R >>",
+        "<< /Type /Pages /Kids [" + kids + "] /Count " + QByteArray::number(pages) + " >>",
+    };
+    for (qsizetype page = 0; page < pages; ++page) {
+        objects << "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 100 100] /Resources << /Font << /F1 << /Type /Font "
+                   "/Subtype /Type1 /BaseFont /Helvetica >> >> >> /Contents "
+                       + QByteArray::number(3 + pages + page) + " 0 R >>";
+    }
+    for (const QByteArray& contents : pageContents) {
+        objects << "<< /Length " + QByteArray::number(contents.size()) + " >> stream\n" + contents + "\nendstream";
+    }
+
+    QByteArray pdf = "%PDF-1.1\n";
+    QList<qsizetype> offsets;
+    for (qsizetype i = 0; i < objects.size(); ++i) {
+        offsets << pdf.size();
+        pdf += QByteArray::number(i + 1) + " 0 obj " + objects.at(i) + " endobj\n";
+    }
+    const qsizetype xref = pdf.size();
+    pdf += "xref\n0 " + QByteArray::number(objects.size() + 1) + "\n0000000000 65535 f \n";
+    for (const qsizetype offset : offsets) {
+        pdf += QByteArray::number(offset).rightJustified(10, '0') + " 00000 n \n";
+    }
+    pdf += "trailer << /Size " + QByteArray::number(objects.size() + 1) + " /Root 1 0 R >>\n"
+        + "startxref\n" + QByteArray::number(xref) + "\n%%EOF";
+    return file.write(pdf) == pdf.size() && file.flush();
+}
+
+static bool writeBlankPdf(QTemporaryFile& file, int pages)
+{
+    QList<QByteArray> contents;
+    for (int page = 0; page < pages; ++page) {
+        contents << "q Q";
+    }
+    return writePdf(file, contents);
+}
+
+TEST(PdfToImageNodeTest, SplitPagesStreamEachPageAsItIsWritten)
+{
+    ensureApp();
+
+    QTemporaryFile tempPdf;
+    tempPdf.setFileTemplate(QDir::tempPath() + "/test_XXXXXX.pdf");
+    ASSERT_TRUE(tempPdf.open());
+    ASSERT_TRUE(writeBlankPdf(tempPdf, 3));
+    const QString pdfPath = tempPdf.fileName();
+    tempPdf.close();
+
+    PdfToImageNode node;
+    node.loadState(QJsonObject{{QStringLiteral("split_pages"), true}});
+
+    ExecutionToken inToken;
+    inToken.data.insert(QString::fromLatin1(PdfToImageNode::kPdfPathPinId), pdfPath);
+
+    QMutex publishedMutex;
+    QStringList published;
+    TokenList outTokens;
+    {
+        const PartialOutputSink::Scope sinkScope(PartialOutputSink([&](const TokenList& tokens) {
+            QMutexLocker locker(&publishedMutex);
+            for (const ExecutionToken& token : tokens) {
+                const QString path = token.data.value(QString::fromLatin1(PdfToImageNode::kImagePathPinId)).toString();
+                EXPECT_TRUE(QFileInfo::exists(path)) << "a page is published once its file is written";
+                published.append(path);
+            }
+        }));
+        outTokens = node.execute(TokenList{inToken});
+    }
+
+    ASSERT_FALSE(outTokens.empty());
+    const DataPacket output = outTokens.front().data;
+    ASSERT_FALSE(output.contains(QStringLiteral("__error"))) << output.value(QStringLiteral("__error")).toString().toStdString();
+    EXPECT_EQ(output.value(QString::fromLatin1(PdfToImageNode::kPageCountPinId)).toInt(), 3);
+
+    const QStringList paths = output.value(QString::fromLatin1(PdfToImageNode::kImagePathsPinId)).toStringList();
+    ASSERT_EQ(paths.size(), 3);
+    for (int page = 0; page < paths.size(); ++page) {
+        EXPECT_TRUE(paths.at(page).endsWith(QStringLiteral("_p%1.png").arg(page + 1))) << "paths stay in page order";
+    }
+    QStringList sortedPublished = published;
+    sortedPublished.sort();
+    QStringList sortedPaths = paths;
+    sortedPaths.sort();
+    EXPECT_EQ(sortedPublished, sortedPaths);
+    EXPECT_FALSE(output.contains(QString::fromLatin1(PdfToImageNode::kImagePathPinId)))
+        << "the first page is not sent a second time";
+
+    for (const QString& path : paths) {
+        QFile::remove(path);
+    }
+}
+
+TEST(PdfToImageNodeTest, TextLayerPagesSkipRendering)
+{
+    ensureApp();
+
+    QTemporaryFile tempPdf;
+    tempPdf.setFileTemplate(QDir::tempPath() + "/test_XXXXXX.pdf");
+    ASSERT_TRUE(tempPdf.open());
+    ASSERT_TRUE(writePdf(tempPdf, {"BT /F1 4 Tf 2 50 Td (Quarterly revenue rose in every region we track) Tj ET",
+                                   "q Q",
+                                   "BT /F1 4 Tf 2 50 Td (!!) Tj ET"}));
+    const QString pdfPath = tempPdf.fileName();
+    tempPdf.close();
+
+    PdfToImageNode node;
+    node.loadState(QJsonObject{{QStringLiteral("split_pages"), true},
+                               {QStringLiteral("text_layer"), true},
+                               {QStringLiteral("min_text_chars"), 20},
+                               {QStringLiteral("render_cache"), false}});
+
+    QMutex mutex;
+    QStringList streamedTexts;
+    QStringList streamedImages;
+    const PartialOutputSink sink([&](const TokenList& tokens) {
+        QMutexLocker locker(&mutex);
+        for (const ExecutionToken& token : tokens) {
+            if (token.data.contains(QString::fromLatin1(PdfToImageNode::kPageTextPinId))) {
+                streamedTexts << token.data.value(QString::fromLatin1(PdfToImageNode::kPageTextPinId)).toString();
+            }
+            if (token.data.contains(QString::fromLatin1(PdfToImageNode::kImagePathPinId))) {
+                streamedImages << token.data.value(QString::fromLatin1(PdfToImageNode::kImagePathPinId)).toString();
+            }
+        }
+    });
+
+    ExecutionToken inToken;
+    inToken.data.insert(QString::fromLatin1(PdfToImageNode::kPdfPathPinId), pdfPath);
+    TokenList outTokens;
+    {
+        const PartialOutputSink::Scope scope(sink);
+        outTokens = node.execute(TokenList{inToken});
+    }
+    ASSERT_FALSE(outTokens.empty());
+    const DataPacket output = outTokens.front().data;
+    ASSERT_FALSE(output.contains(QStringLiteral("__error"))) << output.value(QStringLiteral("__error")).toString().toStdString();
+
+    // The text page goes out as text; the blank page and the one with too little text are rendered
+    const QStringList texts = output.value(QString::fromLatin1(PdfToImageNode::kPageTextsPinId)).toStringList();
+    ASSERT_EQ(texts.size(), 1);
+    EXPECT_TRUE(texts.first().contains(QStringLiteral("Quarterly revenue")));
+    EXPECT_EQ(output.value(QStringLiteral("_text_pages")).toList(), QVariantList({1}));
+    EXPECT_EQ(streamedTexts, texts);
+
+    const QStringList paths = output.value(QString::fromLatin1(PdfToImageNode::kImagePathsPinId)).toStringList();
+    ASSERT_EQ(paths.size(), 2);
+    EXPECT_TRUE(paths.at(0).endsWith(QStringLiteral("_p2.png")));
+    EXPECT_TRUE(paths.at(1).endsWith(QStringLiteral("_p3.png")));
+    EXPECT_EQ(streamedImages.size(), 2);
+    EXPECT_EQ(output.value(QString::fromLatin1(PdfToImageNode::kPageCountPinId)).toInt(), 3);
+
+    for (const QString& path : paths) {
+        QFile::remove(path);
+    }
+}
+
+TEST(PdfToImageNodeTest, RenderCacheReusesPagesOfTheSameDocument)
+{
+    ensureApp();
+
+    QTemporaryDir cacheDir;
+    ASSERT_TRUE(cacheDir.isValid());
+    PdfRenderCache::setShared(std::make_shared<PdfRenderCache>(cacheDir.path()));
+
+    QTemporaryFile tempPdf;
+    tempPdf.setFileTemplate(QDir::tempPath() + "/test_XXXXXX.pdf");
+    ASSERT_TRUE(tempPdf.open());
+    ASSERT_TRUE(writeBlankPdf(tempPdf, 3));
+    tempPdf.close();
+    // The same bytes under another name share the cached renders
+    const QString copiedPdf = tempPdf.fileName() + QStringLiteral(".copy.pdf");
+    QFile::remove(copiedPdf);
+    ASSERT_TRUE(QFile::copy(tempPdf.fileName(), copiedPdf));
+
+    PdfToImageNode node;
+    node.loadState(QJsonObject{{QStringLiteral("split_pages"), true}});
+    const auto run = [&node](const QString& pdfPath) {
+        ExecutionToken inToken;
+        inToken.data.insert(QString::fromLatin1(PdfToImageNode::kPdfPathPinId), pdfPath);
+        const TokenList outTokens = node.execute(TokenList{inToken});
+        return outTokens.empty() ? DataPacket() : outTokens.front().data;
+    };
+
+    const DataPacket first = run(tempPdf.fileName());
+    ASSERT_FALSE(first.contains(QStringLiteral("__error"))) << first.value(QStringLiteral("__error")).toString().toStdString();
+    EXPECT_EQ(first.value(QStringLiteral("_render_cache_hits")).toInt(), 0);
+
+    const DataPacket second = run(copiedPdf);
+    ASSERT_FALSE(second.contains(QStringLiteral("__error"))) << second.value(QStringLiteral("__error")).toString().toStdString();
+    EXPECT_EQ(second.value(QStringLiteral("_render_cache_hits")).toInt(), 3);
+    const QStringList paths = second.value(QString::fromLatin1(PdfToImageNode::kImagePathsPinId)).toStringList();
+    ASSERT_EQ(paths.size(), 3);
+    for (const QString& path : paths) {
+        const QImage page(path);
+        EXPECT_EQ(page.size(), QSize(200, 200)) << "a cached page reads like a fresh render";
+    }
+
+    for (const QString& path : first.value(QString::fromLatin1(PdfToImageNode::kImagePathsPinId)).toStringList() + paths) {
+        QFile::remove(path);
+    }
+    QFile::remove(copiedPdf);
+    PdfRenderCache::setShared(nullptr);
+}
+
+TEST(PdfToImageNodeTest, StripStitchWritesOnePngInBands)
+{
+    ensureApp();
+
+    QTemporaryFile tempPdf;
+    tempPdf.setFileTemplate(QDir::tempPath() + "/test_XXXXXX.pdf");
+    ASSERT_TRUE(tempPdf.open());
+    ASSERT_TRUE(writeBlankPdf(tempPdf, 3));
+    tempPdf.close();
+
+    PdfToImageNode node;
+    node.loadState(QJsonObject{{QStringLiteral("stitch_mode"), QString::fromLatin1(PdfToImageNode::kStitchStrip)},
+                               {QStringLiteral("png_compression"), 1}});
+
+    ExecutionToken inToken;
+    inToken.data.insert(QString::fromLatin1(PdfToImageNode::kPdfPathPinId), tempPdf.fileName());
+    const TokenList outTokens = node.execute(TokenList{inToken});
+    ASSERT_FALSE(outTokens.empty());
+    const DataPacket output = outTokens.front().data;
+    ASSERT_FALSE(output.contains(QStringLiteral("__error"))) << output.value(QStringLiteral("__error")).toString().toStdString();
+
+    const QString imagePath = output.value(QString::fromLatin1(PdfToImageNode::kImagePathPinId)).toString();
+    const QImage image(imagePath);
+    ASSERT_FALSE(image.isNull()) << "the banded encoder writes a PNG Qt can read";
+    EXPECT_EQ(image.width(), 200);
+    EXPECT_EQ(image.height(), 600);
+    EXPECT_EQ(image.pixelColor(100, 599), QColor(Qt::white));
+    QFile::remove(imagePath);
+}
+
+TEST(PdfToImageNodeTest, TiledStitchSplitsAcrossPages)
+{
+    ensureApp();
+
+    QTemporaryFile tempPdf;
+    tempPdf.setFileTemplate(QDir::tempPath() + "/test_XXXXXX.pdf");
+    ASSERT_TRUE(tempPdf.open());
+    ASSERT_TRUE(writeBlankPdf(tempPdf, 3));
+    tempPdf.close();
+
+    PdfToImageNode node;
+    node.loadState(QJsonObject{{QStringLiteral("stitch_mode"), QString::fromLatin1(PdfToImageNode::kStitchTiles)},
+                               {QStringLiteral("tile_height"), 250},
+                               {QStringLiteral("image_format"), QStringLiteral("jpg")}});
+
+    ExecutionToken inToken;
+    inToken.data.insert(QString::fromLatin1(PdfToImageNode::kPdfPathPinId), tempPdf.fileName());
+    const TokenList outTokens = node.execute(TokenList{inToken});
+    ASSERT_FALSE(outTokens.empty());
+    const DataPacket output = outTokens.front().data;
+    ASSERT_FALSE(output.contains(QStringLiteral("__error"))) << output.value(QStringLiteral("__error")).toString().toStdString();
+
+    // 600 rows of pages in tiles of 250: two full tiles and the rest
+    const QStringList tiles = output.value(QString::fromLatin1(PdfToImageNode::kImagePathsPinId)).toStringList();
+    ASSERT_EQ(tiles.size(), 3);
+    const QList<int> heights = {250, 250, 100};
+    for (int i = 0; i < tiles.size(); ++i) {
+        EXPECT_TRUE(tiles.at(i).endsWith(QStringLiteral("_t%1.jpg").arg(i + 1)));
+        const QImage tile(tiles.at(i));
+        EXPECT_EQ(tile.width(), 200);
+        EXPECT_EQ(tile.height(), heights.at(i));
+        QFile::remove(tiles.at(i));
+    }
+}
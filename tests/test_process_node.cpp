@@ -4,8 +4,15 @@
 #include <QFuture>
 #include <QtConcurrent/QtConcurrent>
 #include <QLineEdit>
+#include <QElapsedTimer>
+#include <QJsonObject>
+
+#include <chrono>
+#include <thread>
 
 #include "test_app.h"
+#include "CancellationToken.h"
+#include "PartialOutputSink.h"
 #include "ProcessNode.h"
 #include "ProcessPropertiesWidget.h"
 
@@ -80,3 +87,110 @@ TEST(ProcessNodeTest, ExecutesCommandAndHandlesIO)
 
     delete w;
 }
+
+TEST(ProcessNodeTest, CancelledRunKillsChildProcess)
+{
+    ensureApp();
+
+    ProcessNode node;
+    QWidget* w = node.createConfigurationWidget(nullptr);
+    auto* props = dynamic_cast<ProcessPropertiesWidget*>(w);
+    ASSERT_NE(props, nullptr);
+    props->setCommand(QStringLiteral("python3 -c \"import time; time.sleep(30)\""));
+    QApplication::processEvents();
+
+    const CancellationToken cancellation = CancellationToken::create();
+    std::thread canceller([cancellation]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        cancellation.cancel();
+    });
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    TokenList outTokens;
+    {
+        const CancellationToken::Scope scope(cancellation);
+        outTokens = node.execute(TokenList{ExecutionToken{}});
+    }
+    canceller.join();
+
+    ASSERT_FALSE(outTokens.empty());
+    const DataPacket out = outTokens.front().data;
+    const QString error = out.value(QStringLiteral("__error")).toString();
+    if (error.startsWith(QStringLiteral("Failed to start process"))) {
+        delete w;
+        GTEST_SKIP() << "python3 not available";
+    }
+    EXPECT_EQ(error, QStringLiteral("Process cancelled"));
+    EXPECT_LT(elapsed.elapsed(), 10000);
+
+    delete w;
+}
+
+TEST(ProcessNodeTest, StreamingPublishesStdoutLines)
+{
+    ensureApp();
+
+    ProcessNode node;
+    node.loadState(QJsonObject{
+        {QStringLiteral("command"), QStringLiteral("python3 -u -c \"import sys; [print(l.strip().upper()) for l in sys.stdin]\"")},
+        {QStringLiteral("streamOutput"), true}});
+
+    ExecutionToken token;
+    token.data.insert(QString::fromLatin1(ProcessNode::kInStdin), QStringList{QStringLiteral("a"), QStringLiteral("b"), QStringLiteral("b")});
+
+    QStringList lines;
+    TokenList outTokens;
+    {
+        const PartialOutputSink::Scope sinkScope(PartialOutputSink([&](const TokenList& tokens) {
+            for (const ExecutionToken& published : tokens) {
+                EXPECT_TRUE(published.forceExecution);
+                lines.append(published.data.value(QString::fromLatin1(ProcessNode::kOutLine)).toString());
+            }
+        }));
+        outTokens = node.execute(TokenList{token});
+    }
+
+    ASSERT_FALSE(outTokens.empty());
+    const DataPacket out = outTokens.front().data;
+    if (out.value(QStringLiteral("__error")).toString().startsWith(QStringLiteral("Failed to start process"))) {
+        GTEST_SKIP() << "python3 not available";
+    }
+    EXPECT_EQ(lines, (QStringList{QStringLiteral("A"), QStringLiteral("B"), QStringLiteral("B")}));
+    EXPECT_EQ(out.value(QStringLiteral("_line_count")).toInt(), 3);
+    EXPECT_FALSE(out.contains(QString::fromLatin1(ProcessNode::kOutStdout))) << "streamed stdout is not buffered";
+}
+
+TEST(ProcessNodeTest, PersistentProcessServesEveryItem)
+{
+    ensureApp();
+
+    ProcessNode node;
+    node.loadState(QJsonObject{
+        {QStringLiteral("command"),
+         QStringLiteral("python3 -u -c \"import os, sys; [print(os.getpid(), l.strip().upper(), flush=True) for l in iter(sys.stdin.readline, '')]\"")},
+        {QStringLiteral("persistent"), true}});
+
+    const auto runItem = [&node](const QString& stdinText) {
+        ExecutionToken token;
+        token.data.insert(QString::fromLatin1(ProcessNode::kInStdin), stdinText);
+        const TokenList out = node.execute(TokenList{token});
+        return out.empty() ? DataPacket() : out.front().data;
+    };
+
+    const DataPacket first = runItem(QStringLiteral("a\nb\n"));
+    if (first.value(QStringLiteral("__error")).toString().startsWith(QStringLiteral("Failed to start process"))) {
+        GTEST_SKIP() << "python3 not available";
+    }
+    const DataPacket second = runItem(QStringLiteral("c"));
+    ASSERT_FALSE(first.contains(QStringLiteral("__error")));
+    ASSERT_FALSE(second.contains(QStringLiteral("__error")));
+
+    const QStringList firstLines = first.value(QString::fromLatin1(ProcessNode::kOutStdout)).toString().split(u'\n');
+    const QString secondLine = second.value(QString::fromLatin1(ProcessNode::kOutStdout)).toString();
+    ASSERT_EQ(firstLines.size(), 2);
+    const QString pid = firstLines.at(0).section(u' ', 0, 0);
+    EXPECT_EQ(firstLines.at(0), pid + QStringLiteral(" A"));
+    EXPECT_EQ(firstLines.at(1), pid + QStringLiteral(" B"));
+    EXPECT_EQ(secondLine, pid + QStringLiteral(" C")) << "the same filter serves the next item";
+}
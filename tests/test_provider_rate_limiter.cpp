@@ -0,0 +1,247 @@
+#include <gtest/gtest.h>
+
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include <mutex>
+#include <thread>
+
+#include "ModelCapsRegistry.h"
+#include "ai/backends/MockBackend.h"
+#include "ai/registry/LLMProviderRegistry.h"
+#include "ai/registry/ProviderRateLimiter.h"
+
+namespace {
+
+const QString kProvider = QStringLiteral("rate-test");
+
+ModelCapsTypes::RateLimit tokensPerMinute(int tokens)
+{
+    ModelCapsTypes::RateLimit limit;
+    limit.tokensPerMinute = tokens;
+    return limit;
+}
+
+} // namespace
+
+TEST(ProviderRateLimiterTest, WaitsForTokensToRefill)
+{
+    ProviderRateLimiter limiter;
+    limiter.setLimitOverride(kProvider, QString(), tokensPerMinute(600)); // 10 tokens per second
+
+    QElapsedTimer timer;
+    timer.start();
+    ASSERT_TRUE(limiter.acquire(kProvider, QString(), 600));
+    EXPECT_LT(timer.elapsed(), 100);
+
+    ASSERT_TRUE(limiter.acquire(kProvider, QString(), 5));
+    EXPECT_GE(timer.elapsed(), 400);
+}
+
+TEST(ProviderRateLimiterTest, SettleReturnsUnusedTokens)
+{
+    ProviderRateLimiter limiter;
+    limiter.setLimitOverride(kProvider, QString(), tokensPerMinute(600));
+
+    ProviderRateLimiter::Permit permit = limiter.acquire(kProvider, QString(), 600);
+    ASSERT_TRUE(permit);
+    permit.settle(100);
+
+    QElapsedTimer timer;
+    timer.start();
+    ASSERT_TRUE(limiter.acquire(kProvider, QString(), 400));
+    EXPECT_LT(timer.elapsed(), 100);
+}
+
+TEST(ProviderRateLimiterTest, ServesWaitingCallersInArrivalOrder)
+{
+    ProviderRateLimiter limiter;
+    limiter.setLimitOverride(kProvider, QString(), tokensPerMinute(600));
+    ASSERT_TRUE(limiter.acquire(kProvider, QString(), 600));
+
+    std::mutex orderMutex;
+    QStringList order;
+    // The large request arrives first; the small one must not overtake it
+    std::thread large([&] {
+        ASSERT_TRUE(limiter.acquire(kProvider, QString(), 5));
+        std::lock_guard<std::mutex> lock(orderMutex);
+        order << QStringLiteral("large");
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    std::thread small([&] {
+        ASSERT_TRUE(limiter.acquire(kProvider, QString(), 1));
+        std::lock_guard<std::mutex> lock(orderMutex);
+        order << QStringLiteral("small");
+    });
+    large.join();
+    small.join();
+
+    EXPECT_EQ(order, (QStringList{QStringLiteral("large"), QStringLiteral("small")}));
+}
+
+TEST(ProviderRateLimiterTest, ServesCallersDueSoonerFirst)
+{
+    ProviderRateLimiter limiter;
+    limiter.setLimitOverride(kProvider, QString(), tokensPerMinute(600));
+    ASSERT_TRUE(limiter.acquire(kProvider, QString(), 600));
+
+    std::mutex orderMutex;
+    QStringList order;
+    // A batch request waits first; an interactive one with a deadline arrives later and goes ahead
+    const CancellationToken batch = CancellationToken::create(CancellationToken::kNoDeadline, 60000);
+    std::thread waiting([&] {
+        ASSERT_TRUE(limiter.acquire(kProvider, QString(), 5, batch));
+        std::lock_guard<std::mutex> lock(orderMutex);
+        order << QStringLiteral("batch");
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const CancellationToken interactive = CancellationToken::create(QDeadlineTimer(1000).deadline());
+    std::thread urgent([&] {
+        ASSERT_TRUE(limiter.acquire(kProvider, QString(), 5, interactive));
+        std::lock_guard<std::mutex> lock(orderMutex);
+        order << QStringLiteral("interactive");
+    });
+    waiting.join();
+    urgent.join();
+
+    EXPECT_EQ(order, (QStringList{QStringLiteral("interactive"), QStringLiteral("batch")}));
+}
+
+TEST(ProviderRateLimiterTest, ModelBudgetsApplyOnTopOfProviderBudget)
+{
+    ProviderRateLimiter limiter;
+    ModelCapsTypes::RateLimit oneRequest;
+    oneRequest.requestsPerMinute = 1;
+    limiter.setLimitOverride(kProvider, QStringLiteral("slow-model"), oneRequest);
+
+    ASSERT_TRUE(limiter.acquire(kProvider, QStringLiteral("slow-model"), 1));
+
+    // Other models are unaffected; the second slow-model request waits until cancelled
+    QElapsedTimer timer;
+    timer.start();
+    ASSERT_TRUE(limiter.acquire(kProvider, QStringLiteral("fast-model"), 1));
+    EXPECT_LT(timer.elapsed(), 100);
+
+    const CancellationToken cancellation = CancellationToken::create();
+    std::thread canceller([cancellation] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        cancellation.cancel();
+    });
+    EXPECT_FALSE(limiter.acquire(kProvider, QStringLiteral("slow-model"), 1, cancellation));
+    canceller.join();
+    EXPECT_LT(timer.elapsed(), 1000);
+}
+
+TEST(ProviderRateLimiterTest, PauseHoldsTheProviderQueue)
+{
+    ProviderRateLimiter limiter;
+    limiter.pause(kProvider, 300);
+
+    QElapsedTimer timer;
+    timer.start();
+    ASSERT_TRUE(limiter.acquire(kProvider, QString(), 1));
+    EXPECT_GE(timer.elapsed(), 250);
+}
+
+TEST(ProviderRateLimiterTest, ReadsLimitsFromTheCatalog)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    QFile file(dir.filePath(QStringLiteral("caps.json")));
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    file.write(R"({
+        "version": 3,
+        "providers": [
+            {
+                "id": "openai",
+                "rateLimits": {
+                    "requestsPerMinute": 500,
+                    "tokens_per_minute": 30000,
+                    "models": { "gpt-4o-mini": { "tokensPerMinute": 200000 } }
+                }
+            }
+        ],
+        "rules": []
+    })");
+    file.close();
+    ASSERT_TRUE(ModelCapsRegistry::instance().loadFromFile(file.fileName()));
+
+    const ProviderRateLimiter& limiter = LLMProviderRegistry::instance().rateLimiter();
+    const auto providerLimit = limiter.limitFor(QStringLiteral("openai"), QString());
+    EXPECT_EQ(providerLimit.requestsPerMinute, 500);
+    EXPECT_EQ(providerLimit.tokensPerMinute, 30000);
+    EXPECT_EQ(limiter.limitFor(QStringLiteral("openai"), QStringLiteral("gpt-4o-mini")).tokensPerMinute, 200000);
+    EXPECT_TRUE(limiter.limitFor(QStringLiteral("openai"), QStringLiteral("gpt-4o")).isUnlimited());
+    EXPECT_TRUE(limiter.limitFor(QStringLiteral("google"), QString()).isUnlimited());
+
+    ModelCapsRegistry::instance().loadFromFile(QStringLiteral(":/resources/model_caps.json"));
+}
+
+TEST(ProviderRateLimiterTest, MockProviderSimulatesLatencyAndFailures)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    QFile file(dir.filePath(QStringLiteral("caps.json")));
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    file.write(R"({
+        "version": 3,
+        "providers": [
+            {
+                "id": "mock",
+                "enabled": true,
+                "options": {
+                    "first_token_ms": 100,
+                    "latency_distribution": "fixed",
+                    "tokens_per_second": 200,
+                    "output_tokens": 20,
+                    "embedding_dimensions": 16,
+                    "embedding_latency_ms": 0,
+                    "models": { "mock-busy": { "rate_limit_rate": 1, "retry_after_ms": 10 } }
+                }
+            }
+        ],
+        "rules": []
+    })");
+    file.close();
+    ASSERT_TRUE(ModelCapsRegistry::instance().loadFromFile(file.fileName()));
+
+    MockBackend backend;
+    EXPECT_TRUE(backend.availableModels().contains(QStringLiteral("mock-busy")));
+
+    QElapsedTimer timer;
+    timer.start();
+    const LLMResult answer = backend.sendPrompt(QString(), QStringLiteral("mock-chat"), 0.0, 8,
+                                                QString(), QStringLiteral("hello"));
+    EXPECT_GE(timer.elapsed(), 100);
+    ASSERT_FALSE(answer.hasError) << answer.errorMsg.toStdString();
+    EXPECT_EQ(answer.content.split(u' ').size(), 8);
+    EXPECT_EQ(answer.usage.outputTokens, 8);
+
+    QStringList deltas;
+    const LLMResult streamed = backend.streamPrompt(QString(), QStringLiteral("mock-chat"), 0.0, 0, QString(),
+                                                    QStringLiteral("hello"),
+                                                    [&](const QString& delta) { deltas.append(delta); });
+    ASSERT_FALSE(streamed.hasError);
+    EXPECT_GT(deltas.size(), 1);
+    EXPECT_EQ(deltas.join(QString()), streamed.content);
+    EXPECT_EQ(streamed.usage.outputTokens, 20);
+
+    const EmbeddingBatchResult embeddings = backend.getEmbeddings(
+        QString(), QStringLiteral("mock-embed"), {QStringLiteral("a"), QStringLiteral("b"), QStringLiteral("a")});
+    ASSERT_FALSE(embeddings.hasError);
+    ASSERT_EQ(embeddings.vectors.size(), 3u);
+    EXPECT_EQ(embeddings.vectors[0].size(), 16u);
+    EXPECT_EQ(embeddings.vectors[0], embeddings.vectors[2]);
+    EXPECT_NE(embeddings.vectors[0], embeddings.vectors[1]);
+
+    // Every attempt is rejected, so the retries run out
+    const LLMResult busy = backend.sendPrompt(QString(), QStringLiteral("mock-busy"), 0.0, 8, QString(),
+                                              QStringLiteral("hello"));
+    EXPECT_TRUE(busy.hasError);
+    EXPECT_TRUE(busy.errorMsg.contains(QStringLiteral("429")));
+
+    ModelCapsRegistry::instance().loadFromFile(QStringLiteral(":/resources/model_caps.json"));
+}
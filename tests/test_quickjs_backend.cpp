@@ -3,7 +3,12 @@
 #include <QVariant>
 #include <QDateTime>
 #include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QThread>
 #include <map>
+#include <thread>
 #include <vector>
 #include "IScriptHost.h"
 
@@ -191,3 +196,314 @@ TEST(QuickJSBackendTest, SqliteFullWorkflow) {
     EXPECT_EQ(host.outputs["val"].toString(), "hello");
     EXPECT_EQ(host.outputs["num"].toInt(), 42);
 }
+
+TEST(QuickJSBackendTest, EnginesOnAThreadShareOneRuntime) {
+    QuickJSRuntime first;
+    QuickJSRuntime second;
+    JSRuntime* shared = QuickJSRuntime::threadRuntime();
+    EXPECT_NE(shared, nullptr);
+    EXPECT_EQ(QuickJSRuntime::threadRuntime(), shared);
+
+    JSRuntime* other = nullptr;
+    std::thread worker([&other]() { other = QuickJSRuntime::threadRuntime(); });
+    worker.join();
+    EXPECT_NE(other, nullptr);
+    EXPECT_NE(other, shared);
+}
+
+TEST(QuickJSBackendTest, ExecutionsDoNotShareGlobals) {
+    QuickJSRuntime runtime;
+    MockScriptHost host;
+    ASSERT_TRUE(runtime.execute("globalThis.leaked = 1; pipeline.output = null;", &host));
+
+    // Same engine, then a new engine on the same runtime
+    for (int i = 0; i < 2; ++i) {
+        QuickJSRuntime other;
+        IScriptEngine& engine = i == 0 ? static_cast<IScriptEngine&>(runtime) : other;
+        MockScriptHost next;
+        ASSERT_TRUE(engine.execute("pipeline.output(\"seen\", typeof leaked);", &next));
+        EXPECT_EQ(next.outputs["seen"].toString(), "undefined");
+    }
+}
+
+TEST(QuickJSBackendTest, RepeatedRunsReuseCompiledBytecode) {
+    const QString marker = QString::number(QDateTime::currentMSecsSinceEpoch());
+    const QString script = "// " + marker + "\n"
+                           "return pipeline.input(\"n\") * 2;";
+    const QString module = "// " + marker + "\n"
+                           "import * as std from 'std';\n"
+                           "pipeline.output(\"gc\", typeof std.gc);";
+    const qsizetype before = QuickJSRuntime::cachedScriptCount();
+
+    for (int i = 1; i <= 3; ++i) {
+        QuickJSRuntime runtime;
+        MockScriptHost host;
+        host.inputs["n"] = i;
+        ASSERT_TRUE(runtime.execute(script, &host));
+        EXPECT_EQ(host.outputs["output"].toInt(), 2 * i);
+
+        MockScriptHost moduleHost;
+        ASSERT_TRUE(runtime.execute(module, &moduleHost));
+        EXPECT_EQ(moduleHost.outputs["gc"].toString(), "function");
+    }
+    EXPECT_EQ(QuickJSRuntime::cachedScriptCount(), before + 2);
+
+    // Scripts that fail to compile are not cached
+    QuickJSRuntime runtime;
+    MockScriptHost host;
+    EXPECT_FALSE(runtime.execute("var x = ; // " + marker, &host));
+    EXPECT_FALSE(host.errors.empty());
+    EXPECT_EQ(QuickJSRuntime::cachedScriptCount(), before + 2);
+}
+
+TEST(QuickJSBackendTest, DiskBytecodeCacheEvictsOldestScriptsOverBudget) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const qint64 budget = 16 * 1024;
+    QuickJSRuntime::setBytecodeCacheDirectory(dir.path(), budget);
+
+    // Each script carries a 4 KB string constant, so a handful fill the budget
+    const QString marker = QString::number(QDateTime::currentMSecsSinceEpoch());
+    const QString padding(4096, QLatin1Char('p'));
+    const int scripts = 12;
+    for (int i = 0; i < scripts; ++i) {
+        QuickJSRuntime runtime;
+        MockScriptHost host;
+        const QString script = QStringLiteral("return \"entry-%1-%2-%3\".length;").arg(i).arg(marker, padding);
+        ASSERT_TRUE(runtime.execute(script, &host));
+        // Keeps modification times, and so the eviction order, distinct
+        QThread::msleep(5);
+    }
+    QuickJSRuntime::setBytecodeCacheDirectory(QString());
+
+    qint64 total = 0;
+    int files = 0;
+    QByteArray contents;
+    QDirIterator it(dir.path(), {QStringLiteral("*.qjsbc")}, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        QFile file(it.next());
+        ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+        const QByteArray bytes = file.readAll();
+        total += bytes.size();
+        contents += bytes;
+        ++files;
+    }
+    EXPECT_GT(files, 0);
+    EXPECT_LT(files, scripts);
+    EXPECT_LE(total, budget);
+    EXPECT_FALSE(contents.contains(QStringLiteral("entry-0-%1").arg(marker).toLatin1()));
+    EXPECT_TRUE(contents.contains(QStringLiteral("entry-%1-%2").arg(scripts - 1).arg(marker).toLatin1()));
+}
+
+TEST(QuickJSBackendTest, BytesCrossAsUint8ArraysAndComeBackShared) {
+    QuickJSRuntime runtime;
+    MockScriptHost host;
+    host.inputs["bytes"] = QByteArray("\x01\x02\x03", 3);
+
+    QString script =
+        "var b = pipeline.input(\"bytes\");\n"
+        "pipeline.output(\"typed\", b instanceof Uint8Array);\n"
+        "pipeline.output(\"sum\", b[0] + b[1] + b[2]);\n"
+        "b[0] = 9;\n"
+        "pipeline.output(\"same\", b);\n"
+        "pipeline.output(\"again\", b);\n"
+        "pipeline.output(\"tail\", b.subarray(1));";
+    ASSERT_TRUE(runtime.execute(script, &host));
+
+    EXPECT_TRUE(host.outputs["typed"].toBool());
+    EXPECT_EQ(host.outputs["sum"].toInt(), 6);
+    // The script wrote to its own copy, and both outputs share it
+    EXPECT_EQ(host.inputs["bytes"].toByteArray(), QByteArray("\x01\x02\x03", 3));
+    const QByteArray same = host.outputs["same"].toByteArray();
+    EXPECT_EQ(same, QByteArray("\x09\x02\x03", 3));
+    EXPECT_EQ(host.outputs["again"].toByteArray().constData(), same.constData());
+    EXPECT_EQ(host.outputs["tail"].toByteArray(), QByteArray("\x02\x03", 2));
+}
+
+TEST(QuickJSBackendTest, StringsKeepEmbeddedNulsAndNonAscii) {
+    QuickJSRuntime runtime;
+    MockScriptHost host;
+    const QString text = QStringLiteral("café ") + QChar(0) + QStringLiteral(" \U0001F600");
+    host.inputs["text"] = text;
+
+    ASSERT_TRUE(runtime.execute("var s = pipeline.input(\"text\");\n"
+                                "pipeline.output(\"length\", s.length);\n"
+                                "pipeline.output(\"text\", s);", &host));
+    EXPECT_EQ(host.outputs["length"].toInt(), text.size());
+    EXPECT_EQ(host.outputs["text"].toString(), text);
+}
+
+TEST(QuickJSBackendTest, InputViewsReadLazilyAndPassThrough) {
+    QuickJSRuntime runtime;
+    MockScriptHost host;
+    QVariantList rows;
+    for (int i = 0; i < 1000; ++i) {
+        rows.append(QVariantMap{{"id", i}, {"name", QStringLiteral("row %1").arg(i)}});
+    }
+    host.inputs["rows"] = rows;
+
+    QString script =
+        "var rows = pipeline.inputView(\"rows\");\n"
+        "pipeline.output(\"count\", rows.length);\n"
+        "pipeline.output(\"name\", rows[2].name);\n"
+        "pipeline.output(\"ids\", rows.slice(0, 3).map(function(r) { return r.id; }));\n"
+        "pipeline.output(\"keys\", Object.keys(rows[0]).join(\",\"));\n"
+        "try { rows.push(1); } catch (e) { pipeline.output(\"readOnly\", true); }\n"
+        "pipeline.output(\"rows\", rows);";
+    ASSERT_TRUE(runtime.execute(script, &host));
+    ASSERT_TRUE(host.errors.empty());
+
+    EXPECT_EQ(host.outputs["count"].toInt(), 1000);
+    EXPECT_EQ(host.outputs["name"].toString(), "row 2");
+    EXPECT_EQ(host.outputs["ids"].toList(), (QVariantList{0.0, 1.0, 2.0}));
+    EXPECT_EQ(host.outputs["keys"].toString(), "id,name");
+    EXPECT_TRUE(host.outputs["readOnly"].toBool());
+    // Passed back out, the view is the input list itself
+    EXPECT_EQ(host.outputs["rows"].toList().constData(), rows.constData());
+}
+
+TEST(QuickJSBackendTest, SqliteBatchesAndTransactions) {
+    QuickJSRuntime runtime;
+    MockScriptHost host;
+    const QString tableName = "js_batch_" + QString::number(QDateTime::currentMSecsSinceEpoch());
+
+    QString script =
+        "sqlite.connect(pipeline.tempDir() + '/test_batches.db');\n"
+        "sqlite.exec(\"CREATE TABLE " + tableName + " (n INTEGER)\");\n"
+        "var rows = [];\n"
+        "for (var i = 0; i < 1000; i++) rows.push([i]);\n"
+        "pipeline.output(\"many\", sqlite.execMany(\"INSERT INTO " + tableName + " (n) VALUES (?)\", rows).rowsAffected);\n"
+        "sqlite.begin();\n"
+        "sqlite.exec(\"DELETE FROM " + tableName + "\");\n"
+        "sqlite.rollback();\n"
+        "sqlite.begin();\n"
+        "for (var j = 0; j < 10; j++) sqlite.exec(\"INSERT INTO " + tableName + " (n) VALUES (?)\", [j]);\n"
+        "pipeline.output(\"committed\", sqlite.commit());\n"
+        "pipeline.output(\"count\", sqlite.exec(\"SELECT count(*) AS c FROM " + tableName + "\")[0].c);";
+    ASSERT_TRUE(runtime.execute(script, &host));
+
+    EXPECT_EQ(host.outputs["many"].toInt(), 1000);
+    EXPECT_TRUE(host.outputs["committed"].toBool());
+    EXPECT_EQ(host.outputs["count"].toInt(), 1010);
+}
+
+TEST(QuickJSBackendTest, PrewarmCompilesWithoutRunning) {
+    QuickJSRuntime runtime;
+    const QString script = "// prewarm " + QString::number(QDateTime::currentMSecsSinceEpoch()) + "\n"
+                           "pipeline.output(\"ran\", true);";
+    const qsizetype before = QuickJSRuntime::cachedScriptCount();
+
+    runtime.prewarm(script);
+    EXPECT_EQ(QuickJSRuntime::cachedScriptCount(), before + 1);
+
+    MockScriptHost host;
+    ASSERT_TRUE(runtime.execute(script, &host));
+    EXPECT_TRUE(host.outputs["ran"].toBool());
+    EXPECT_EQ(QuickJSRuntime::cachedScriptCount(), before + 1);
+}
+
+TEST(QuickJSBackendTest, TimeLimitInterruptsRunawayLoops) {
+    QuickJSRuntime runtime;
+    runtime.setLimits(ScriptLimits{200, 0});
+    MockScriptHost host;
+
+    // The interrupt can't be caught by the script
+    EXPECT_FALSE(runtime.execute("for (;;) { try { for (;;) {} } catch (e) {} }", &host));
+    ASSERT_FALSE(host.errors.empty());
+    EXPECT_EQ(host.errors.front(), "Script exceeded its time limit of 200 ms");
+
+    // The shared runtime is still usable afterwards
+    MockScriptHost next;
+    ASSERT_TRUE(runtime.execute("pipeline.output(\"ok\", 1 + 1);", &next));
+    EXPECT_EQ(next.outputs["ok"].toInt(), 2);
+}
+
+TEST(QuickJSBackendTest, CancelledRunsStopTheScript) {
+    QuickJSRuntime runtime;
+    CancellationToken token = CancellationToken::create();
+    token.cancel();
+    CancellationToken::Scope scope(token);
+    MockScriptHost host;
+
+    EXPECT_FALSE(runtime.execute("for (;;) {}", &host));
+    ASSERT_FALSE(host.errors.empty());
+    EXPECT_EQ(host.errors.front(), "Script cancelled");
+}
+
+TEST(QuickJSBackendTest, MemoryLimitStopsRunawayAllocation) {
+    QuickJSRuntime runtime;
+    runtime.setLimits(ScriptLimits{0, 8});
+    MockScriptHost host;
+
+    EXPECT_FALSE(runtime.execute("const hoard = []; for (;;) hoard.push({ pad: [1, 2, 3, 4] });", &host));
+    ASSERT_FALSE(host.errors.empty());
+    EXPECT_EQ(host.errors.front(), "Script exceeded its memory limit of 8 MB");
+
+    // Garbage is collected before it counts against the limit
+    MockScriptHost churn;
+    EXPECT_TRUE(runtime.execute("for (let i = 0; i < 200000; ++i) { const tmp = { pad: [i, i, i, i] }; }", &churn))
+        << (churn.errors.empty() ? "" : churn.errors.front().toStdString());
+}
+
+TEST(QuickJSBackendTest, InputsConvertOnceOnFirstRead) {
+    class CountingHost : public MockScriptHost {
+    public:
+        QVariant getInput(const QString& key) override {
+            ++reads[key];
+            return MockScriptHost::getInput(key);
+        }
+        std::map<QString, int> reads;
+    };
+
+    QuickJSRuntime runtime;
+    CountingHost host;
+    host.inputs["route"] = "left";
+    host.inputs["document"] = QString(100000, QLatin1Char('x'));
+
+    const bool success = runtime.execute(
+        "let hits = 0;\n"
+        "for (let i = 0; i < 1000; ++i) { if (pipeline.input(\"route\") === \"left\") ++hits; }\n"
+        "pipeline.input(\"route\").length;\n"
+        "pipeline.output(\"hits\", hits);", &host);
+
+    ASSERT_TRUE(success) << (host.errors.empty() ? "" : host.errors.front().toStdString());
+    EXPECT_EQ(host.outputs["hits"].toInt(), 1000);
+    EXPECT_EQ(host.reads["route"], 1);
+    EXPECT_EQ(host.reads.count("document"), 0u);
+
+    // A new execution reads the pin again
+    ASSERT_TRUE(runtime.execute("pipeline.output(\"again\", pipeline.input(\"route\"));", &host));
+    EXPECT_EQ(host.reads["route"], 2);
+}
+
+TEST(QuickJSBackendTest, ProfilingSamplesScriptFunctions) {
+    QuickJSRuntime runtime;
+    runtime.setProfiling(true);
+    MockScriptHost host;
+
+    const bool success = runtime.execute(
+        "function busy() {\n"
+        "  const end = Date.now() + 100;\n"
+        "  while (Date.now() < end) {}\n"
+        "}\n"
+        "busy();", &host);
+
+    ASSERT_TRUE(success) << (host.errors.empty() ? "" : host.errors.front().toStdString());
+    const ScriptProfile profile = runtime.takeProfile();
+    EXPECT_GE(profile.totalMicros(), 50000);
+
+    qint64 busyMicros = 0;
+    for (auto it = profile.stacks.cbegin(); it != profile.stacks.cend(); ++it) {
+        if (it.key().startsWith(QStringLiteral("(script);busy (line "))) {
+            busyMicros += it.value();
+        }
+    }
+    EXPECT_GT(busyMicros, profile.totalMicros() / 2);
+    EXPECT_TRUE(profile.folded().startsWith(QStringLiteral("(script);busy (line ")));
+
+    // The profile is handed over once, and unprofiled runs leave none
+    EXPECT_TRUE(runtime.takeProfile().isEmpty());
+    runtime.setProfiling(false);
+    ASSERT_TRUE(runtime.execute("busy = 1;", &host));
+    EXPECT_TRUE(runtime.takeProfile().isEmpty());
+}
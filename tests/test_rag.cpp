@@ -5,20 +5,37 @@
 #include <gtest/gtest.h>
 
 #include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QTemporaryDir>
 #include <QTemporaryFile>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentRun>
 #include <QtSql/QSqlDatabase>
 #include <QtSql/QSqlQuery>
 #include <QtSql/QSqlError>
 
+#include <algorithm>
+#include <cmath>
+
+#include "CpuWorkerPool.h"
+#include "RagIndexServer.h"
 #include "RagQueryNode.h"
 #include "ai/registry/LLMProviderRegistry.h"
 #include "test_app.h"
 
+#include "retrieval/storage/DuplicateIndex.h"
+#include "retrieval/storage/RagIndexClient.h"
+#include "retrieval/storage/RagQueryCache.h"
 #include "retrieval/storage/RagUtils.h"
+#include "retrieval/storage/VectorFile.h"
+#include "retrieval/storage/VectorKernels.h"
 
 namespace {
 
@@ -64,6 +81,9 @@ TEST(RagQueryNodeTest, SavesAndLoadsState)
     RagQueryNode node;
     node.setDatabasePath(QStringLiteral("stored_db.sqlite"));
     node.setQueryText(QStringLiteral("stored query"));
+    node.setSearchEf(0);
+    node.setSearchMode(QStringLiteral("hybrid"));
+    node.setFilterExpression(QStringLiteral("type:cpp tag:backend"));
 
     const QJsonObject state = node.saveState();
 
@@ -72,6 +92,13 @@ TEST(RagQueryNodeTest, SavesAndLoadsState)
 
     EXPECT_EQ(node2.databasePath(), QStringLiteral("stored_db.sqlite"));
     EXPECT_EQ(node2.queryText(), QStringLiteral("stored query"));
+    EXPECT_EQ(node2.searchEf(), 0);
+    EXPECT_EQ(node2.searchMode(), QStringLiteral("hybrid"));
+    EXPECT_EQ(node2.filterExpression(), QStringLiteral("type:cpp tag:backend"));
+
+    // Unknown modes fall back to plain vector search
+    node2.setSearchMode(QStringLiteral("fuzzy"));
+    EXPECT_EQ(node2.searchMode(), QStringLiteral("vector"));
 }
 
 TEST(RagQueryNodeTest, DescriptorUsesPropertyDatabasePath)
@@ -84,6 +111,8 @@ TEST(RagQueryNodeTest, DescriptorUsesPropertyDatabasePath)
     EXPECT_FALSE(desc.inputPins.contains(QString::fromLatin1(RagQueryNode::kInputDbPath)));
     EXPECT_TRUE(desc.outputPins.contains(QString::fromLatin1(RagQueryNode::kOutputContext)));
     EXPECT_TRUE(desc.outputPins.contains(QString::fromLatin1(RagQueryNode::kOutputResults)));
+    EXPECT_TRUE(desc.inputPins.contains(QString::fromLatin1(RagQueryNode::kInputQueries)));
+    EXPECT_TRUE(desc.outputPins.contains(QString::fromLatin1(RagQueryNode::kOutputContexts)));
 }
 
 TEST(RagQueryNodeTest, PinOverridesProperty)
@@ -224,6 +253,50 @@ TEST(RagUtilsTest, GetIndexConfigSingleModel)
     EXPECT_EQ(cfg.modelId, QStringLiteral("text-embedding-3-small"));
 }
 
+TEST(RagUtilsTest, WarmIndexCachesTheConfigurationUntilTheIndexChanges)
+{
+    ensureCoreApp();
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString missingPath = dir.path() + QStringLiteral("/missing.db");
+    EXPECT_FALSE(RagUtils::warmIndex(missingPath));
+    EXPECT_FALSE(QFileInfo::exists(missingPath));
+
+    const QString dbPath = dir.path() + QStringLiteral("/rag_warm.db");
+    const QString connectionName = QStringLiteral("rag_utils_test_warm");
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+        db.setDatabaseName(dbPath);
+        ASSERT_TRUE(db.open()) << "Failed to open temp db: " << db.lastError().text().toStdString();
+        createBasicRagSchema(db);
+        QSqlQuery insert(db);
+        ASSERT_TRUE(insert.exec(QStringLiteral(
+            "INSERT INTO source_files (file_path, provider, model) VALUES ('a.txt', 'openai', 'text-embedding-3-small')")));
+        insert = QSqlQuery();
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+
+    // Neither sidecar exists, but the configuration is loaded all the same
+    EXPECT_FALSE(RagUtils::warmIndex(dbPath));
+    EXPECT_FALSE(RagUtils::warmIndex(dbPath));
+    EXPECT_EQ(RagUtils::getIndexConfig(dbPath).modelId, QStringLiteral("text-embedding-3-small"));
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+        db.setDatabaseName(dbPath);
+        ASSERT_TRUE(db.open());
+        QSqlQuery update(db);
+        ASSERT_TRUE(update.exec(QStringLiteral("UPDATE source_files SET model = 'text-embedding-3-large'")));
+        update = QSqlQuery();
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    RagQueryCache::bumpGeneration(dbPath);
+    EXPECT_EQ(RagUtils::getIndexConfig(dbPath).modelId, QStringLiteral("text-embedding-3-large"));
+}
+
 TEST(RagUtilsTest, GetIndexConfigMixedModelsThrows)
 {
     ensureCoreApp();
@@ -341,5 +414,1144 @@ TEST(RagUtilsTest, FindMostRelevantChunksSimple)
     EXPECT_EQ(results.front().chunkIndex, 0);
     EXPECT_EQ(results.front().startLine, 3);
     EXPECT_EQ(results.front().endLine, 5);
+    EXPECT_EQ(results.front().content, QStringLiteral("chunk A"));
+    EXPECT_EQ(results.front().filePath, QStringLiteral("doc.txt"));
     EXPECT_GE(results.front().score, results.back().score);
+
+    // Equal scores keep the lower fragment id; only the winners are returned
+    const std::vector<float> diagonal{1.0f, 1.0f};
+    const auto tied = RagUtils::findMostRelevantChunks(dbPath, diagonal, /*limit*/ 1, /*minRelevance*/ 0.0);
+    ASSERT_EQ(tied.size(), 1u);
+    EXPECT_EQ(tied.front().chunkIndex, 0);
+    EXPECT_EQ(tied.front().content, QStringLiteral("chunk A"));
+
+    EXPECT_TRUE(RagUtils::findMostRelevantChunks(dbPath, query, 5, /*minRelevance*/ 1.5).empty());
+}
+
+TEST(RagUtilsTest, LegacyEmbeddingsAreNormalisedOnceWithTheSameRanking)
+{
+    ensureCoreApp();
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString dbPath = dir.path() + QStringLiteral("/rag_legacy.db");
+    const QString connectionName = QStringLiteral("rag_utils_test_legacy");
+
+    auto blobOf = [](const std::vector<float>& embedding) {
+        return QByteArray(reinterpret_cast<const char*>(embedding.data()),
+                          static_cast<int>(embedding.size() * sizeof(float)));
+    };
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+        db.setDatabaseName(dbPath);
+        ASSERT_TRUE(db.open());
+        createBasicRagSchema(db);
+        QSqlQuery query(db);
+        ASSERT_TRUE(query.exec(QStringLiteral(
+            "INSERT INTO source_files (file_path, provider, model) VALUES ('doc.txt', 'openai', 'm')")));
+        query.prepare(QStringLiteral(
+            "INSERT INTO fragments (file_id, chunk_index, content, embedding) VALUES (1, ?, ?, ?)"));
+        const std::vector<std::vector<float>> embeddings {{2.0f, 0.0f, 0.0f}, {3.0f, 4.0f, 0.0f}, {0.0f, 0.0f, 5.0f}};
+        for (int i = 0; i < static_cast<int>(embeddings.size()); ++i) {
+            query.addBindValue(i);
+            query.addBindValue(QStringLiteral("chunk %1").arg(i));
+            query.addBindValue(blobOf(embeddings[static_cast<std::size_t>(i)]));
+            ASSERT_TRUE(query.exec()) << query.lastError().text().toStdString();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+
+    const std::vector<float> query {1.0f, 1.0f, 0.0f};
+    const auto before = RagUtils::findMostRelevantChunks(dbPath, query, 3, 0.0);
+
+    EXPECT_EQ(RagUtils::normalizeStoredEmbeddings(dbPath), 3);
+    EXPECT_EQ(RagUtils::normalizeStoredEmbeddings(dbPath), 0);
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+        db.setDatabaseName(dbPath);
+        ASSERT_TRUE(db.open());
+        QSqlQuery version(db);
+        ASSERT_TRUE(version.exec(QStringLiteral("PRAGMA user_version")) && version.next());
+        EXPECT_EQ(version.value(0).toInt(), kRagNormalizedEmbeddingsVersion);
+        QSqlQuery stored(db);
+        ASSERT_TRUE(stored.exec(QStringLiteral("SELECT embedding FROM fragments WHERE chunk_index = 1")) && stored.next());
+        EXPECT_EQ(stored.value(0).toByteArray(), RagUtils::normalizedEmbeddingBlob({3.0f, 4.0f, 0.0f}));
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+
+    const auto after = RagUtils::findMostRelevantChunks(dbPath, query, 3, 0.0);
+    ASSERT_EQ(before.size(), 3u);
+    ASSERT_EQ(after.size(), before.size());
+    for (std::size_t i = 0; i < before.size(); ++i) {
+        EXPECT_EQ(after[i].chunkIndex, before[i].chunkIndex);
+        EXPECT_NEAR(after[i].score, before[i].score, 1e-6);
+    }
+    EXPECT_EQ(after.front().chunkIndex, 1);
+    EXPECT_NEAR(after.front().score, 7.0 / (5.0 * std::sqrt(2.0)), 1e-6);
+}
+
+TEST(RagUtilsTest, QuantisedIndexesRankLikeFloat32AndRescoreExactly)
+{
+    ensureCoreApp();
+
+    const int count = 300;
+    const int dimension = 24;
+    std::vector<std::vector<float>> embeddings;
+    for (int i = 0; i < count; ++i) {
+        std::vector<float> embedding(static_cast<std::size_t>(dimension));
+        for (int d = 0; d < dimension; ++d) {
+            embedding[static_cast<std::size_t>(d)] = std::sin(static_cast<float>(i * dimension + d) * 0.61f) * (1.0f + i % 3);
+        }
+        embeddings.push_back(embedding);
+    }
+    std::vector<float> query(static_cast<std::size_t>(dimension));
+    for (int d = 0; d < dimension; ++d) {
+        query[static_cast<std::size_t>(d)] = std::cos(static_cast<float>(d) * 0.3f);
+    }
+
+    // Exact ranking from the original vectors
+    std::vector<std::pair<double, int>> exact;
+    for (int i = 0; i < count; ++i) {
+        exact.emplace_back(RagUtils::cosineSimilarity(query, embeddings[static_cast<std::size_t>(i)]), i);
+    }
+    std::sort(exact.begin(), exact.end(), [](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; });
+
+    for (const RagEmbeddingFormat format : {RagEmbeddingFormat::Float16, RagEmbeddingFormat::Int8}) {
+        SCOPED_TRACE(RagUtils::embeddingFormatName(format).toStdString());
+        QTemporaryDir dir;
+        ASSERT_TRUE(dir.isValid());
+        const QString dbPath = dir.path() + QStringLiteral("/rag_quantised.db");
+        const QString connectionName = QStringLiteral("rag_utils_test_quantised");
+        {
+            QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+            db.setDatabaseName(dbPath);
+            ASSERT_TRUE(db.open());
+            createBasicRagSchema(db);
+            QSqlQuery insert(db);
+            ASSERT_TRUE(insert.exec(QStringLiteral("PRAGMA user_version = %1").arg(kRagNormalizedEmbeddingsVersion)));
+            insert.prepare(QStringLiteral(
+                "INSERT INTO source_files (file_path, provider, model, embedding_format) VALUES ('doc.txt', 'p', 'm', ?)"));
+            insert.addBindValue(RagUtils::embeddingFormatName(format));
+            ASSERT_TRUE(insert.exec()) << insert.lastError().text().toStdString();
+            ASSERT_TRUE(db.transaction());
+            insert.prepare(QStringLiteral(
+                "INSERT INTO fragments (file_id, chunk_index, content, embedding, embedding_full) VALUES (1, ?, ?, ?, ?)"));
+            for (int i = 0; i < count; ++i) {
+                const std::vector<float>& embedding = embeddings[static_cast<std::size_t>(i)];
+                insert.addBindValue(i);
+                insert.addBindValue(QStringLiteral("chunk %1").arg(i));
+                insert.addBindValue(RagUtils::encodeEmbedding(embedding, format));
+                insert.addBindValue(RagUtils::encodeEmbedding(embedding));
+                ASSERT_TRUE(insert.exec()) << insert.lastError().text().toStdString();
+            }
+            ASSERT_TRUE(db.commit());
+        }
+        QSqlDatabase::removeDatabase(connectionName);
+
+        const RagUtils::IndexConfig config = RagUtils::getIndexConfig(dbPath);
+        EXPECT_EQ(config.format, format);
+        EXPECT_EQ(config.dimension, dimension);
+
+        RagSearchOptions scanOnly;
+        scanOnly.rescore = false;
+        const auto approximate = RagUtils::findMostRelevantChunks(dbPath, query, 5, 0.0, scanOnly);
+        ASSERT_EQ(approximate.size(), 5u);
+        for (std::size_t i = 0; i < approximate.size(); ++i) {
+            EXPECT_NEAR(approximate[i].score, exact[i].first, 0.02);
+        }
+
+        const auto rescored = RagUtils::findMostRelevantChunks(dbPath, query, 5, 0.0);
+        ASSERT_EQ(rescored.size(), 5u);
+        for (std::size_t i = 0; i < rescored.size(); ++i) {
+            EXPECT_EQ(rescored[i].chunkIndex, exact[i].second);
+            EXPECT_NEAR(rescored[i].score, exact[i].first, 1e-5);
+        }
+
+        const std::vector<float> decoded = RagUtils::decodeEmbedding(RagUtils::encodeEmbedding(embeddings[0], format), format);
+        ASSERT_EQ(decoded.size(), static_cast<std::size_t>(dimension));
+        EXPECT_GT(RagUtils::cosineSimilarity(decoded, embeddings[0]), 0.999);
+    }
+}
+
+TEST(RagUtilsTest, AnnIndexAgreesWithExactSearchAndCoversNewFragments)
+{
+    ensureCoreApp();
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString dbPath = dir.path() + QStringLiteral("/rag_ann.db");
+    const QString connectionName = QStringLiteral("rag_utils_test_ann");
+
+    auto insertFragments = [&](int count, int firstChunk, const std::vector<float>* fixed) {
+        QSqlDatabase db = QSqlDatabase::database(connectionName);
+        QSqlQuery insert(db);
+        insert.prepare(QStringLiteral(
+            "INSERT INTO fragments (file_id, chunk_index, content, embedding) VALUES (1, ?, ?, ?)"));
+        for (int i = 0; i < count; ++i) {
+            const int chunk = firstChunk + i;
+            std::vector<float> embedding(8);
+            for (int d = 0; d < 8; ++d) {
+                embedding[static_cast<std::size_t>(d)] = std::sin(static_cast<float>(chunk * 8 + d) * 0.7f);
+            }
+            if (fixed) {
+                embedding = *fixed;
+            }
+            insert.addBindValue(chunk);
+            insert.addBindValue(QStringLiteral("chunk %1").arg(chunk));
+            insert.addBindValue(QByteArray(reinterpret_cast<const char*>(embedding.data()),
+                                           static_cast<int>(embedding.size() * sizeof(float))));
+            ASSERT_TRUE(insert.exec()) << insert.lastError().text().toStdString();
+        }
+    };
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+        db.setDatabaseName(dbPath);
+        ASSERT_TRUE(db.open());
+        createBasicRagSchema(db);
+        QSqlQuery query(db);
+        ASSERT_TRUE(query.exec(QStringLiteral(
+            "INSERT INTO source_files (file_path, provider, model) VALUES ('doc.txt', 'openai', 'm')")));
+        insertFragments(400, 0, nullptr);
+    }
+
+    const RagUtils::AnnIndexUpdate built = RagUtils::updateAnnIndex(dbPath);
+    EXPECT_TRUE(built.rebuilt);
+    EXPECT_EQ(built.added, 400);
+    EXPECT_TRUE(QFile::exists(RagUtils::annIndexPath(dbPath)));
+
+    const std::vector<float> query {0.3f, -0.2f, 0.9f, 0.1f, -0.5f, 0.4f, 0.0f, 0.2f};
+    RagSearchOptions exact;
+    exact.ef = 0;
+    const auto expected = RagUtils::findMostRelevantChunks(dbPath, query, 5, 0.0, exact);
+    const auto approximate = RagUtils::findMostRelevantChunks(dbPath, query, 5, 0.0);
+    ASSERT_EQ(expected.size(), 5u);
+    for (std::size_t i = 1; i < expected.size(); ++i) {
+        EXPECT_GE(expected[i - 1].score, expected[i].score);
+    }
+    ASSERT_EQ(approximate.size(), expected.size());
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(approximate[i].fragmentId, expected[i].fragmentId);
+        EXPECT_DOUBLE_EQ(approximate[i].score, expected[i].score);
+    }
+
+    // A fragment written after the index is still found, then folded in incrementally
+    insertFragments(1, 400, &query);
+    const auto withNew = RagUtils::findMostRelevantChunks(dbPath, query, 1, 0.0);
+    ASSERT_EQ(withNew.size(), 1u);
+    EXPECT_EQ(withNew.front().chunkIndex, 400);
+
+    const RagUtils::AnnIndexUpdate incremental = RagUtils::updateAnnIndex(dbPath);
+    EXPECT_FALSE(incremental.rebuilt);
+    EXPECT_EQ(incremental.added, 1);
+    EXPECT_EQ(incremental.total, 401);
+
+    // Mostly-deleted indexes are rebuilt; an empty database drops the sidecar
+    {
+        QSqlQuery query(QSqlDatabase::database(connectionName));
+        ASSERT_TRUE(query.exec(QStringLiteral("DELETE FROM fragments WHERE chunk_index < 300")));
+    }
+    const RagUtils::AnnIndexUpdate compacted = RagUtils::updateAnnIndex(dbPath);
+    EXPECT_TRUE(compacted.rebuilt);
+    EXPECT_EQ(compacted.total, 101);
+    {
+        QSqlQuery query(QSqlDatabase::database(connectionName));
+        ASSERT_TRUE(query.exec(QStringLiteral("DELETE FROM fragments")));
+    }
+    RagUtils::updateAnnIndex(dbPath);
+    EXPECT_FALSE(QFile::exists(RagUtils::annIndexPath(dbPath)));
+
+    QSqlDatabase::database(connectionName).close();
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+TEST(RagUtilsTest, VectorFileMatchesSqliteScanAndTracksDeletions)
+{
+    ensureCoreApp();
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString dbPath = dir.path() + QStringLiteral("/rag_vec.db");
+    const QString connectionName = QStringLiteral("rag_utils_test_vec");
+
+    auto insertFragments = [&](int count, int firstChunk) {
+        QSqlQuery insert(QSqlDatabase::database(connectionName));
+        insert.prepare(QStringLiteral(
+            "INSERT INTO fragments (file_id, chunk_index, content, embedding) VALUES (1, ?, ?, ?)"));
+        for (int i = 0; i < count; ++i) {
+            const int chunk = firstChunk + i;
+            std::vector<float> embedding(8);
+            for (int d = 0; d < 8; ++d) {
+                embedding[static_cast<std::size_t>(d)] = std::cos(static_cast<float>(chunk * 8 + d) * 0.3f);
+            }
+            insert.addBindValue(chunk);
+            insert.addBindValue(QStringLiteral("chunk %1").arg(chunk));
+            insert.addBindValue(RagUtils::encodeEmbedding(embedding));
+            ASSERT_TRUE(insert.exec()) << insert.lastError().text().toStdString();
+        }
+    };
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+        db.setDatabaseName(dbPath);
+        ASSERT_TRUE(db.open());
+        createBasicRagSchema(db);
+        QSqlQuery query(db);
+        ASSERT_TRUE(query.exec(QStringLiteral(
+            "INSERT INTO source_files (file_path, provider, model) VALUES ('doc.txt', 'openai', 'm')")));
+        ASSERT_TRUE(query.exec(QStringLiteral("PRAGMA user_version = %1").arg(kRagNormalizedEmbeddingsVersion)));
+        insertFragments(300, 0);
+    }
+
+    const RagUtils::VectorFileUpdate built = RagUtils::updateVectorFile(dbPath);
+    EXPECT_TRUE(built.rebuilt);
+    EXPECT_EQ(built.added, 300);
+    EXPECT_EQ(built.live, 300);
+    EXPECT_TRUE(QFile::exists(RagUtils::vectorFilePath(dbPath)));
+
+    const std::vector<float> query {0.3f, -0.2f, 0.9f, 0.1f, -0.5f, 0.4f, 0.0f, 0.2f};
+    RagSearchOptions sqliteOnly;
+    sqliteOnly.useVectorFile = false;
+    auto expectSameAsSqlite = [&](int limit) {
+        const auto expected = RagUtils::findMostRelevantChunks(dbPath, query, limit, 0.0, sqliteOnly);
+        const auto mapped = RagUtils::findMostRelevantChunks(dbPath, query, limit, 0.0);
+        ASSERT_EQ(mapped.size(), expected.size());
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_EQ(mapped[i].fragmentId, expected[i].fragmentId);
+            EXPECT_EQ(mapped[i].content, expected[i].content);
+            EXPECT_DOUBLE_EQ(mapped[i].score, expected[i].score);
+        }
+    };
+    expectSameAsSqlite(10);
+
+    // Deleted fragments disappear once the file is updated; new ones are seen before then
+    const qint64 best = RagUtils::findMostRelevantChunks(dbPath, query, 1, 0.0).front().fragmentId;
+    {
+        QSqlQuery del(QSqlDatabase::database(connectionName));
+        ASSERT_TRUE(del.exec(QStringLiteral("DELETE FROM fragments WHERE id = %1").arg(best)));
+    }
+    insertFragments(20, 300);
+    expectSameAsSqlite(10);
+
+    const RagUtils::VectorFileUpdate incremental = RagUtils::updateVectorFile(dbPath);
+    EXPECT_FALSE(incremental.rebuilt);
+    EXPECT_EQ(incremental.added, 20);
+    EXPECT_EQ(incremental.deleted, 1);
+    EXPECT_EQ(incremental.live, 319);
+    expectSameAsSqlite(10);
+    for (const auto& result : RagUtils::findMostRelevantChunks(dbPath, query, 319, -1.0)) {
+        EXPECT_NE(result.fragmentId, best);
+    }
+
+    // A cleared database drops the file
+    {
+        QSqlQuery clear(QSqlDatabase::database(connectionName));
+        ASSERT_TRUE(clear.exec(QStringLiteral("DELETE FROM fragments")));
+    }
+    RagUtils::updateVectorFile(dbPath);
+    EXPECT_FALSE(QFile::exists(RagUtils::vectorFilePath(dbPath)));
+
+    QSqlDatabase::database(connectionName).close();
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+TEST(RagUtilsTest, VectorFileRebuildLeavesMappedGenerationReadable)
+{
+    ensureCoreApp();
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString dbPath = dir.path() + QStringLiteral("/rag_vec_swap.db");
+    const QString connectionName = QStringLiteral("rag_utils_test_vec_swap");
+
+    auto insertFragments = [&](int count, int dimension) {
+        QSqlQuery insert(QSqlDatabase::database(connectionName));
+        insert.prepare(QStringLiteral(
+            "INSERT INTO fragments (file_id, chunk_index, content, embedding) VALUES (1, ?, ?, ?)"));
+        for (int i = 0; i < count; ++i) {
+            std::vector<float> embedding(static_cast<std::size_t>(dimension));
+            for (int d = 0; d < dimension; ++d) {
+                embedding[static_cast<std::size_t>(d)] = std::sin(static_cast<float>(i * dimension + d) * 0.7f);
+            }
+            insert.addBindValue(i);
+            insert.addBindValue(QStringLiteral("chunk %1").arg(i));
+            insert.addBindValue(RagUtils::encodeEmbedding(embedding));
+            ASSERT_TRUE(insert.exec()) << insert.lastError().text().toStdString();
+        }
+    };
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+        db.setDatabaseName(dbPath);
+        ASSERT_TRUE(db.open());
+        createBasicRagSchema(db);
+        QSqlQuery query(db);
+        ASSERT_TRUE(query.exec(QStringLiteral(
+            "INSERT INTO source_files (file_path, provider, model) VALUES ('doc.txt', 'openai', 'm')")));
+        ASSERT_TRUE(query.exec(QStringLiteral("PRAGMA user_version = %1").arg(kRagNormalizedEmbeddingsVersion)));
+        insertFragments(50, 8);
+    }
+    const QString path = RagUtils::vectorFilePath(dbPath);
+    ASSERT_TRUE(RagUtils::updateVectorFile(dbPath).rebuilt);
+
+    // A search still scoring the old generation when a rebuild lands keeps its rows.
+    std::unique_ptr<VectorFile> reader = VectorFile::open(path);
+    ASSERT_NE(reader, nullptr);
+    const QByteArray firstRow(reader->row(1), reader->rowBytes());
+
+    // Eight-dimensional rows are superseded by a model with another size
+    insertFragments(10, 4);
+    const RagUtils::VectorFileUpdate rebuilt = RagUtils::updateVectorFile(dbPath);
+    EXPECT_TRUE(rebuilt.rebuilt);
+    EXPECT_FALSE(QFile::exists(path + QStringLiteral(".next")));
+    EXPECT_EQ(QByteArray(reader->row(1), reader->rowBytes()), firstRow);
+    EXPECT_EQ(reader->dimension(), 8);
+
+    const std::unique_ptr<VectorFile> current = VectorFile::open(path);
+    ASSERT_NE(current, nullptr);
+    EXPECT_EQ(current->dimension(), 4);
+    EXPECT_EQ(current->liveCount(), 10);
+
+    QSqlDatabase::database(connectionName).close();
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+TEST(RagUtilsTest, CompactIndexRemovesOrphansAndKeepsResults)
+{
+    ensureCoreApp();
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString dbPath = dir.path() + QStringLiteral("/rag_compact.db");
+    const QString connectionName = QStringLiteral("rag_utils_test_compact");
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+        db.setDatabaseName(dbPath);
+        ASSERT_TRUE(db.open());
+        createBasicRagSchema(db);
+        QSqlQuery query(db);
+        ASSERT_TRUE(query.exec(QStringLiteral(
+            "INSERT INTO source_files (file_path, provider, model) VALUES ('doc.txt', 'openai', 'm')")));
+        ASSERT_TRUE(query.exec(QStringLiteral("PRAGMA user_version = %1").arg(kRagNormalizedEmbeddingsVersion)));
+        // Lets fragments point at a file that was never recorded
+        ASSERT_TRUE(query.exec(QStringLiteral("PRAGMA foreign_keys = OFF")));
+        QSqlQuery insert(db);
+        insert.prepare(QStringLiteral(
+            "INSERT INTO fragments (file_id, chunk_index, content, embedding) VALUES (?, ?, ?, ?)"));
+        for (int chunk = 0; chunk < 2000; ++chunk) {
+            std::vector<float> embedding(16);
+            for (int d = 0; d < 16; ++d) {
+                embedding[static_cast<std::size_t>(d)] = std::sin(static_cast<float>(chunk * 16 + d) * 0.23f);
+            }
+            insert.addBindValue(chunk >= 1990 ? 99 : 1);
+            insert.addBindValue(chunk);
+            insert.addBindValue(QStringLiteral("chunk %1 %2").arg(chunk).arg(QString(200, u'x')));
+            insert.addBindValue(RagUtils::encodeEmbedding(embedding));
+            ASSERT_TRUE(insert.exec()) << insert.lastError().text().toStdString();
+        }
+        // Leaves 40 live fragments, 10 orphans and mostly free pages
+        ASSERT_TRUE(query.exec(QStringLiteral("DELETE FROM fragments WHERE file_id = 1 AND chunk_index % 50 != 0")));
+    }
+    QSqlDatabase::database(connectionName).close();
+    QSqlDatabase::removeDatabase(connectionName);
+    RagUtils::updateVectorFile(dbPath);
+
+    const RagUtils::IndexStatistics before = RagUtils::indexStatistics(dbPath);
+    EXPECT_EQ(before.files, 1);
+    EXPECT_EQ(before.fragments, 50);
+    EXPECT_EQ(before.orphanedFragments, 10);
+    ASSERT_EQ(before.dimensions.size(), 1);
+    EXPECT_EQ(before.dimensions.value(16), 50);
+    EXPECT_DOUBLE_EQ(before.bytesPerVector, 16.0 * sizeof(float));
+    EXPECT_GT(before.fragmentation(), RagUtils::kVacuumFragmentation);
+
+    const std::vector<float> query {0.3f, -0.2f, 0.9f, 0.1f, -0.5f, 0.4f, 0.0f, 0.2f,
+                                    0.1f, 0.1f, -0.3f, 0.6f, 0.2f, -0.1f, 0.0f, 0.5f};
+    RagSearchOptions sqliteOnly;
+    sqliteOnly.useVectorFile = false;
+    const auto expected = RagUtils::findMostRelevantChunks(dbPath, query, 40, -1.0, sqliteOnly);
+
+    const RagUtils::IndexCompaction compaction = RagUtils::compactIndex(dbPath);
+    EXPECT_EQ(compaction.orphansRemoved, 10);
+    EXPECT_TRUE(compaction.vacuumed);
+    EXPECT_TRUE(compaction.vectorFileRebuilt);
+    EXPECT_FALSE(compaction.annIndexRebuilt);
+    EXPECT_EQ(compaction.after.fragments, 40);
+    EXPECT_EQ(compaction.after.orphanedFragments, 0);
+    EXPECT_EQ(compaction.after.freePages, 0);
+    EXPECT_TRUE(compaction.after.incrementalVacuum);
+    EXPECT_LT(compaction.after.databaseBytes, compaction.before.databaseBytes);
+
+    // Fragment ids are kept, so rankings and any stored references are unchanged
+    for (const RagSearchOptions& options : {sqliteOnly, RagSearchOptions()}) {
+        const auto compacted = RagUtils::findMostRelevantChunks(dbPath, query, 40, -1.0, options);
+        ASSERT_EQ(compacted.size(), expected.size());
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_EQ(compacted[i].fragmentId, expected[i].fragmentId);
+            EXPECT_DOUBLE_EQ(compacted[i].score, expected[i].score);
+        }
+    }
+
+    // A clean incrementally vacuumed database is not rewritten again
+    EXPECT_FALSE(RagUtils::compactIndex(dbPath).vacuumed);
+}
+
+TEST(RagUtilsTest, ShardedExactScanMatchesSerialScan)
+{
+    ensureCoreApp();
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString dbPath = dir.path() + QStringLiteral("/rag_sharded.db");
+    const QString connectionName = QStringLiteral("rag_utils_test_sharded");
+    const int fragmentCount = static_cast<int>(RagUtils::kMinShardFragments) * 3 + 123;
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+        db.setDatabaseName(dbPath);
+        ASSERT_TRUE(db.open());
+        createBasicRagSchema(db);
+        QSqlQuery query(db);
+        ASSERT_TRUE(query.exec(QStringLiteral(
+            "INSERT INTO source_files (file_path, provider, model) VALUES ('doc.txt', 'openai', 'm')")));
+        ASSERT_TRUE(query.exec(QStringLiteral("PRAGMA user_version = %1").arg(kRagNormalizedEmbeddingsVersion)));
+        ASSERT_TRUE(db.transaction());
+        QSqlQuery insert(db);
+        insert.prepare(QStringLiteral(
+            "INSERT INTO fragments (file_id, chunk_index, content, embedding) VALUES (1, ?, ?, ?)"));
+        for (int chunk = 0; chunk < fragmentCount; ++chunk) {
+            std::vector<float> embedding(8);
+            for (int d = 0; d < 8; ++d) {
+                embedding[static_cast<std::size_t>(d)] = std::sin(static_cast<float>(chunk * 8 + d) * 0.37f);
+            }
+            insert.addBindValue(chunk);
+            insert.addBindValue(QStringLiteral("chunk %1").arg(chunk));
+            insert.addBindValue(RagUtils::encodeEmbedding(embedding));
+            ASSERT_TRUE(insert.exec()) << insert.lastError().text().toStdString();
+        }
+        ASSERT_TRUE(db.commit());
+    }
+
+    const std::vector<float> query {0.3f, -0.2f, 0.9f, 0.1f, -0.5f, 0.4f, 0.0f, 0.2f};
+    RagSearchOptions serial;
+    serial.ef = 0;
+    serial.threads = 1;
+    const auto expected = RagUtils::findMostRelevantChunks(dbPath, query, 25, 0.2, serial);
+    ASSERT_EQ(expected.size(), 25u);
+
+    auto expectSameAsSerial = [&](const RagSearchOptions& options) {
+        const auto sharded = RagUtils::findMostRelevantChunks(dbPath, query, 25, 0.2, options);
+        ASSERT_EQ(sharded.size(), expected.size());
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_EQ(sharded[i].fragmentId, expected[i].fragmentId);
+            EXPECT_EQ(sharded[i].content, expected[i].content);
+            EXPECT_DOUBLE_EQ(sharded[i].score, expected[i].score);
+        }
+    };
+
+    // Helpers come from the current run's Cpu pool, capped by its size
+    QThreadPool cpuPool;
+    cpuPool.setMaxThreadCount(3);
+    RagSearchOptions parallel = serial;
+    parallel.threads = 8;
+    {
+        const CpuWorkerPool::Scope scope(&cpuPool);
+        expectSameAsSerial(parallel);
+
+        // The same shards, scored from the vector file instead
+        RagUtils::updateVectorFile(dbPath);
+        expectSameAsSerial(parallel);
+    }
+
+    // A pool with every thread busy cannot stall the scan: the caller works through the shards itself
+    QThreadPool busyPool;
+    busyPool.setMaxThreadCount(2);
+    QMutex gate;
+    gate.lock();
+    for (int i = 0; i < 2; ++i) {
+        busyPool.start([&gate]() {
+            QMutexLocker locker(&gate);
+        });
+    }
+    {
+        const CpuWorkerPool::Scope scope(&busyPool);
+        expectSameAsSerial(parallel);
+    }
+    gate.unlock();
+    busyPool.waitForDone();
+
+    QSqlDatabase::database(connectionName).close();
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+TEST(RagUtilsTest, CoarsePrefixSearchRescoresToTheFullRanking)
+{
+    ensureCoreApp();
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString dbPath = dir.path() + QStringLiteral("/rag_coarse.db");
+    const QString connectionName = QStringLiteral("rag_utils_test_coarse");
+
+    // Like a Matryoshka model, the leading dimensions carry most of each vector's weight
+    const int dimension = 64;
+    auto embeddingFor = [&](int seed) {
+        std::vector<float> embedding(static_cast<std::size_t>(dimension));
+        for (int d = 0; d < dimension; ++d) {
+            embedding[static_cast<std::size_t>(d)] = std::sin(static_cast<float>(seed * dimension + d) * 0.41f)
+                * std::exp(-static_cast<float>(d) / 4.0f);
+        }
+        VectorKernels::normalize(embedding);
+        return embedding;
+    };
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+        db.setDatabaseName(dbPath);
+        ASSERT_TRUE(db.open());
+        createBasicRagSchema(db);
+        QSqlQuery query(db);
+        ASSERT_TRUE(query.exec(QStringLiteral(
+            "INSERT INTO source_files (file_path, provider, model) VALUES ('doc.txt', 'openai', 'm')")));
+        ASSERT_TRUE(query.exec(QStringLiteral("PRAGMA user_version = %1").arg(kRagNormalizedEmbeddingsVersion)));
+        QSqlQuery insert(db);
+        insert.prepare(QStringLiteral(
+            "INSERT INTO fragments (file_id, chunk_index, content, embedding) VALUES (1, ?, ?, ?)"));
+        for (int chunk = 0; chunk < 600; ++chunk) {
+            insert.addBindValue(chunk);
+            insert.addBindValue(QStringLiteral("chunk %1").arg(chunk));
+            insert.addBindValue(RagUtils::encodeEmbedding(embeddingFor(chunk)));
+            ASSERT_TRUE(insert.exec()) << insert.lastError().text().toStdString();
+        }
+    }
+    QSqlDatabase::database(connectionName).close();
+    QSqlDatabase::removeDatabase(connectionName);
+
+    RagSearchOptions full;
+    full.threads = 1;
+    RagSearchOptions coarse = full;
+    coarse.coarseDimensions = 16;
+    for (const int seed : {1001, 1002, 1003}) {
+        const std::vector<float> query = embeddingFor(seed);
+        const auto expected = RagUtils::findMostRelevantChunks(dbPath, query, 5, -1.0, full);
+        const auto found = RagUtils::findMostRelevantChunks(dbPath, query, 5, -1.0, coarse);
+        ASSERT_EQ(found.size(), expected.size());
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_EQ(found[i].fragmentId, expected[i].fragmentId);
+            // Winners are re-scored with every dimension
+            EXPECT_DOUBLE_EQ(found[i].score, expected[i].score);
+        }
+    }
+
+    // At or above the stored size the option is ignored
+    RagSearchOptions oversized = full;
+    oversized.coarseDimensions = dimension;
+    const std::vector<float> query = embeddingFor(7);
+    const auto expected = RagUtils::findMostRelevantChunks(dbPath, query, 5, -1.0, full);
+    const auto found = RagUtils::findMostRelevantChunks(dbPath, query, 5, -1.0, oversized);
+    ASSERT_EQ(found.size(), expected.size());
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(found[i].fragmentId, expected[i].fragmentId);
+    }
+}
+
+TEST(RagUtilsTest, MergeShardResultsRanksByScoreWithinAModelAndByRankAcross)
+{
+    auto result = [](qint64 fragmentId, double score) {
+        RagUtils::SearchResult r;
+        r.fragmentId = fragmentId;
+        r.score = score;
+        return r;
+    };
+
+    // Two shards of one model merge as one index would
+    const std::vector<RagUtils::SearchResult> merged = RagUtils::mergeShardResults(
+        {{result(1, 0.9), result(2, 0.5)}, {result(3, 0.7), result(4, 0.6)}}, {0, 0}, 3);
+    ASSERT_EQ(merged.size(), 3u);
+    EXPECT_EQ(merged[0].fragmentId, 1);
+    EXPECT_EQ(merged[1].fragmentId, 3);
+    EXPECT_EQ(merged[2].fragmentId, 4);
+    EXPECT_DOUBLE_EQ(merged[1].fusedScore, 0.0);
+
+    // A second model's scores run lower, but its best match still ranks second overall
+    const std::vector<RagUtils::SearchResult> fused = RagUtils::mergeShardResults(
+        {{result(1, 0.9), result(2, 0.8)}, {result(3, 0.85)}, {result(10, 0.3), result(11, 0.2)}}, {0, 0, 1}, 4);
+    ASSERT_EQ(fused.size(), 4u);
+    EXPECT_EQ(fused[0].fragmentId, 1);
+    EXPECT_EQ(fused[1].fragmentId, 10);
+    EXPECT_EQ(fused[2].fragmentId, 3);
+    EXPECT_EQ(fused[3].fragmentId, 11);
+    EXPECT_DOUBLE_EQ(fused[1].score, 0.3);
+    EXPECT_DOUBLE_EQ(fused[1].fusedScore, 1.0 / (RagUtils::kReciprocalRankK + 1));
+
+    // One list passes through, cut to the limit
+    const std::vector<RagUtils::SearchResult> single =
+        RagUtils::mergeShardResults({{result(5, 0.4), result(6, 0.3)}}, {0}, 1);
+    ASSERT_EQ(single.size(), 1u);
+    EXPECT_EQ(single[0].fragmentId, 5);
+}
+
+TEST(RagUtilsTest, BatchSearchMatchesOneSearchPerQuery)
+{
+    ensureCoreApp();
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString dbPath = dir.path() + QStringLiteral("/rag_batch.db");
+    const QString connectionName = QStringLiteral("rag_utils_test_batch");
+    const int fragmentCount = static_cast<int>(RagUtils::kMinShardFragments) * 2 + 77;
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+        db.setDatabaseName(dbPath);
+        ASSERT_TRUE(db.open());
+        createBasicRagSchema(db);
+        QSqlQuery query(db);
+        ASSERT_TRUE(query.exec(QStringLiteral(
+            "INSERT INTO source_files (file_path, provider, model) VALUES ('doc.txt', 'openai', 'm')")));
+        ASSERT_TRUE(query.exec(QStringLiteral("PRAGMA user_version = %1").arg(kRagNormalizedEmbeddingsVersion)));
+        ASSERT_TRUE(db.transaction());
+        QSqlQuery insert(db);
+        insert.prepare(QStringLiteral(
+            "INSERT INTO fragments (file_id, chunk_index, content, embedding) VALUES (1, ?, ?, ?)"));
+        for (int chunk = 0; chunk < fragmentCount; ++chunk) {
+            std::vector<float> embedding(8);
+            for (int d = 0; d < 8; ++d) {
+                embedding[static_cast<std::size_t>(d)] = std::cos(static_cast<float>(chunk * 8 + d) * 0.53f);
+            }
+            insert.addBindValue(chunk);
+            insert.addBindValue(QStringLiteral("chunk %1").arg(chunk));
+            insert.addBindValue(RagUtils::encodeEmbedding(embedding));
+            ASSERT_TRUE(insert.exec()) << insert.lastError().text().toStdString();
+        }
+        ASSERT_TRUE(db.commit());
+    }
+
+    const std::vector<std::vector<float>> queries {
+        {0.3f, -0.2f, 0.9f, 0.1f, -0.5f, 0.4f, 0.0f, 0.2f},
+        {},
+        {-0.7f, 0.1f, 0.2f, 0.8f, 0.0f, -0.3f, 0.5f, 0.1f},
+        {0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f},
+    };
+
+    auto expectSameAsSingle = [&](const RagSearchOptions& options) {
+        const auto batch = RagUtils::findMostRelevantChunksBatch(dbPath, queries, 15, 0.1, options);
+        ASSERT_EQ(batch.size(), queries.size());
+        for (std::size_t q = 0; q < queries.size(); ++q) {
+            const auto single = RagUtils::findMostRelevantChunks(dbPath, queries[q], 15, 0.1, options);
+            ASSERT_EQ(batch[q].size(), single.size()) << "query " << q;
+            for (std::size_t i = 0; i < single.size(); ++i) {
+                EXPECT_EQ(batch[q][i].fragmentId, single[i].fragmentId);
+                EXPECT_EQ(batch[q][i].content, single[i].content);
+                EXPECT_DOUBLE_EQ(batch[q][i].score, single[i].score);
+            }
+        }
+        EXPECT_TRUE(batch[1].empty());
+        EXPECT_FALSE(batch[0].empty());
+    };
+
+    RagSearchOptions serial;
+    serial.ef = 0;
+    serial.threads = 1;
+    expectSameAsSingle(serial);
+
+    QThreadPool cpuPool;
+    cpuPool.setMaxThreadCount(3);
+    RagSearchOptions parallel = serial;
+    parallel.threads = 4;
+    {
+        const CpuWorkerPool::Scope scope(&cpuPool);
+        expectSameAsSingle(parallel);
+
+        RagUtils::updateVectorFile(dbPath);
+        expectSameAsSingle(parallel);
+    }
+
+    // Approximate search runs per query over the HNSW sidecar
+    RagUtils::updateAnnIndex(dbPath);
+    expectSameAsSingle(RagSearchOptions {});
+
+    EXPECT_TRUE(RagUtils::findMostRelevantChunksBatch(dbPath, {}, 15, 0.1).empty());
+
+    QSqlDatabase::database(connectionName).close();
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+TEST(RagUtilsTest, FullTextQueryQuotesAndDeduplicatesTerms)
+{
+    EXPECT_EQ(RagUtils::fullTextQuery(QStringLiteral("Where is parse_config? parse_config OR NOT \"x\"")),
+              QStringLiteral("\"Where\" OR \"is\" OR \"parse_config\" OR \"OR\" OR \"NOT\" OR \"x\""));
+    EXPECT_EQ(RagUtils::fullTextQuery(QStringLiteral("Error error ERROR")), QStringLiteral("\"Error\""));
+    EXPECT_TRUE(RagUtils::fullTextQuery(QStringLiteral("  ?! -- ")).isEmpty());
+}
+
+TEST(RagUtilsTest, HybridSearchFindsExactIdentifiersTheVectorRankingMisses)
+{
+    ensureCoreApp();
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString dbPath = dir.path() + QStringLiteral("/rag_hybrid.db");
+    const QString connectionName = QStringLiteral("rag_utils_test_hybrid");
+
+    QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+    db.setDatabaseName(dbPath);
+    ASSERT_TRUE(db.open());
+    createBasicRagSchema(db);
+    QSqlQuery query(db);
+    ASSERT_TRUE(query.exec(QStringLiteral(
+        "INSERT INTO source_files (file_path, provider, model) VALUES ('doc.txt', 'openai', 'm')")));
+    ASSERT_TRUE(query.exec(QStringLiteral("PRAGMA user_version = %1").arg(kRagNormalizedEmbeddingsVersion)));
+    QSqlQuery insert(db);
+    insert.prepare(QStringLiteral(
+        "INSERT INTO fragments (file_id, chunk_index, content, embedding) VALUES (1, ?, ?, ?)"));
+    auto addFragment = [&insert](int chunk, const QString& content, const std::vector<float>& embedding) {
+        insert.addBindValue(chunk);
+        insert.addBindValue(content);
+        insert.addBindValue(RagUtils::encodeEmbedding(embedding));
+        return insert.exec();
+    };
+    // The identifier's chunk is the furthest from the query embedding
+    ASSERT_TRUE(addFragment(0, QStringLiteral("general notes about configuration"), {1.0f, 0.0f}));
+    ASSERT_TRUE(addFragment(1, QStringLiteral("loading settings from disk"), {0.8f, 0.6f}));
+    ASSERT_TRUE(addFragment(2, QStringLiteral("unrelated prose"), {0.6f, 0.8f}));
+    ASSERT_TRUE(addFragment(3, QStringLiteral("int parseConfigValue(const char*)"), {0.0f, 1.0f}));
+
+    const std::vector<float> embedding {1.0f, 0.0f};
+    RagSearchOptions hybrid;
+    hybrid.ef = 0;
+    hybrid.mode = RagSearchMode::Hybrid;
+    hybrid.queryText = QStringLiteral("what does parseConfigValue do");
+
+    // Without an index the lexical modes are plain vector search
+    const auto fallback = RagUtils::findMostRelevantChunks(dbPath, embedding, 1, 0.0, hybrid);
+    ASSERT_EQ(fallback.size(), 1u);
+    EXPECT_EQ(fallback.front().chunkIndex, 0);
+
+    // Created once, over the fragments already stored
+    EXPECT_TRUE(RagUtils::ensureFullTextIndex(dbPath));
+    EXPECT_FALSE(RagUtils::ensureFullTextIndex(dbPath));
+
+    const auto fused = RagUtils::findMostRelevantChunks(dbPath, embedding, 1, 0.0, hybrid);
+    ASSERT_EQ(fused.size(), 1u);
+    EXPECT_EQ(fused.front().chunkIndex, 3);
+    EXPECT_GT(fused.front().fusedScore, 0.0);
+    EXPECT_NEAR(fused.front().score, 0.0, 1e-6);
+
+    // Prefiltering scores only the keyword matches
+    RagSearchOptions prefilter = hybrid;
+    prefilter.mode = RagSearchMode::KeywordPrefilter;
+    prefilter.queryText = QStringLiteral("settings parseConfigValue");
+    const auto filtered = RagUtils::findMostRelevantChunks(dbPath, embedding, 5, 0.0, prefilter);
+    ASSERT_EQ(filtered.size(), 2u);
+    EXPECT_EQ(filtered.front().chunkIndex, 1);
+    EXPECT_EQ(filtered.back().chunkIndex, 3);
+
+    // Triggers keep the index in step with later writes
+    ASSERT_TRUE(addFragment(4, QStringLiteral("parseConfigValue returns zero on error"), {0.0f, 1.0f}));
+    ASSERT_TRUE(query.exec(QStringLiteral("DELETE FROM fragments WHERE chunk_index = 3")));
+    const auto updated = RagUtils::findMostRelevantChunks(dbPath, embedding, 5, 0.0, prefilter);
+    ASSERT_EQ(updated.size(), 2u);
+    EXPECT_EQ(updated.front().chunkIndex, 1);
+    EXPECT_EQ(updated.back().chunkIndex, 4);
+
+    RagUtils::removeFullTextIndex(dbPath);
+    ASSERT_TRUE(query.exec(QStringLiteral("SELECT COUNT(*) FROM sqlite_master WHERE name LIKE 'fragments_fts%'")));
+    ASSERT_TRUE(query.next());
+    EXPECT_EQ(query.value(0).toInt(), 0);
+
+    query = QSqlQuery();
+    insert = QSqlQuery();
+    db.close();
+    db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+TEST(RagUtilsTest, ParsesSearchFilterExpressions)
+{
+    const RagSearchFilter filter = RagUtils::parseSearchFilter(
+        QStringLiteral("path:\"/repo/my docs/\" type:CPP,.h,cpp tag:backend owner=alice tag:backend"));
+    EXPECT_EQ(filter.pathPrefix, QStringLiteral("/repo/my docs/"));
+    EXPECT_EQ(filter.fileTypes, (QStringList{QStringLiteral("cpp"), QStringLiteral("h")}));
+    EXPECT_EQ(filter.tags, QStringList{QStringLiteral("backend")});
+    EXPECT_EQ(filter.metadata.value(QStringLiteral("owner")), QStringLiteral("alice"));
+
+    EXPECT_TRUE(RagUtils::parseSearchFilter(QStringLiteral("   ")).isEmpty());
+    EXPECT_THROW(RagUtils::parseSearchFilter(QStringLiteral("backend")), std::runtime_error);
+    EXPECT_THROW(RagUtils::parseSearchFilter(QStringLiteral("path:\"/open")), std::runtime_error);
+}
+
+TEST(RagUtilsTest, FilteredSearchScoresOnlyMatchingFiles)
+{
+    ensureCoreApp();
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString dbPath = dir.path() + QStringLiteral("/rag_filtered.db");
+    const QString connectionName = QStringLiteral("rag_utils_test_filtered");
+
+    QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+    db.setDatabaseName(dbPath);
+    ASSERT_TRUE(db.open());
+    createBasicRagSchema(db);
+    QSqlQuery query(db);
+    ASSERT_TRUE(query.exec(QStringLiteral("PRAGMA user_version = %1").arg(kRagNormalizedEmbeddingsVersion)));
+    QSqlQuery insertFile(db);
+    insertFile.prepare(QStringLiteral(
+        "INSERT INTO source_files (file_path, provider, model, metadata) VALUES (?, 'openai', 'm', ?)"));
+    const QList<QPair<QString, QString>> files {
+        {QStringLiteral("/repo/src/net/Socket.cpp"), QStringLiteral(R"({"tags":["backend","io"],"owner":"alice"})")},
+        {QStringLiteral("/repo/src/net/Socket.h"), QStringLiteral(R"({"tags":["backend"],"owner":"bob"})")},
+        {QStringLiteral("/repo/src/ui/Window.cpp"), QStringLiteral(R"({"tags":["frontend"]})")},
+        {QStringLiteral("/repo/docs/net.md"), QStringLiteral("not json")},
+    };
+    QSqlQuery insertFragment(db);
+    insertFragment.prepare(QStringLiteral(
+        "INSERT INTO fragments (file_id, chunk_index, content, embedding) VALUES (?, ?, ?, ?)"));
+    for (int file = 0; file < files.size(); ++file) {
+        insertFile.addBindValue(files[file].first);
+        insertFile.addBindValue(files[file].second);
+        ASSERT_TRUE(insertFile.exec()) << insertFile.lastError().text().toStdString();
+        for (int chunk = 0; chunk < 3; ++chunk) {
+            // Later files score higher, so an unfiltered search prefers the docs
+            const float angle = static_cast<float>(file * 3 + chunk) * 0.1f;
+            insertFragment.addBindValue(file + 1);
+            insertFragment.addBindValue(chunk);
+            insertFragment.addBindValue(QStringLiteral("%1 #%2").arg(files[file].first).arg(chunk));
+            insertFragment.addBindValue(RagUtils::encodeEmbedding({std::sin(angle), std::cos(angle)}));
+            ASSERT_TRUE(insertFragment.exec()) << insertFragment.lastError().text().toStdString();
+        }
+    }
+
+    const std::vector<float> embedding {1.0f, 0.0f};
+    auto search = [&](const QString& expression) {
+        RagSearchOptions options;
+        options.ef = 0;
+        options.filter = RagUtils::parseSearchFilter(expression);
+        QStringList paths;
+        for (const RagUtils::SearchResult& result : RagUtils::findMostRelevantChunks(dbPath, embedding, 20, 0.0, options)) {
+            if (!paths.contains(result.filePath)) {
+                paths.append(result.filePath);
+            }
+        }
+        return paths;
+    };
+    auto expectFilters = [&]() {
+        EXPECT_EQ(search(QString()).size(), 4);
+        EXPECT_EQ(search(QStringLiteral("path:/repo/src/net/")),
+                  (QStringList{QStringLiteral("/repo/src/net/Socket.h"), QStringLiteral("/repo/src/net/Socket.cpp")}));
+        EXPECT_EQ(search(QStringLiteral("type:cpp")),
+                  (QStringList{QStringLiteral("/repo/src/ui/Window.cpp"), QStringLiteral("/repo/src/net/Socket.cpp")}));
+        EXPECT_EQ(search(QStringLiteral("tag:backend type:h")), QStringList{QStringLiteral("/repo/src/net/Socket.h")});
+        EXPECT_EQ(search(QStringLiteral("owner=alice")), QStringList{QStringLiteral("/repo/src/net/Socket.cpp")});
+        EXPECT_TRUE(search(QStringLiteral("path:/repo/src/ tag:io owner=bob")).isEmpty());
+    };
+
+    // Unmigrated databases compute the file type inline; the generated column gives the same answers
+    expectFilters();
+    ASSERT_TRUE(query.exec(QString::fromLatin1(kRagSchemaSourceFileTypeColumn)
+                               .arg(QString::fromLatin1(kRagSourceFileTypeExpression))))
+        << query.lastError().text().toStdString();
+    for (const char* statement : kRagSchemaSearchFilterIndexes) {
+        ASSERT_TRUE(query.exec(QString::fromLatin1(statement))) << query.lastError().text().toStdString();
+    }
+    ASSERT_TRUE(query.exec(QStringLiteral("SELECT file_type FROM source_files ORDER BY id")));
+    QStringList types;
+    while (query.next()) {
+        types.append(query.value(0).toString());
+    }
+    EXPECT_EQ(types, (QStringList{QStringLiteral("cpp"), QStringLiteral("h"), QStringLiteral("cpp"), QStringLiteral("md")}));
+    expectFilters();
+
+    // The vector file is narrowed to the same fragments
+    RagUtils::updateVectorFile(dbPath);
+    expectFilters();
+
+    query = QSqlQuery();
+    insertFile = QSqlQuery();
+    insertFragment = QSqlQuery();
+    db.close();
+    db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+namespace {
+
+// Two 2-D fragments, [1,0] "chunk A" and [0,1] "chunk B"
+void writeTwoChunkIndex(const QString& dbPath, const QString& connectionName)
+{
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+        db.setDatabaseName(dbPath);
+        ASSERT_TRUE(db.open()) << db.lastError().text().toStdString();
+        createBasicRagSchema(db);
+        QSqlQuery query(db);
+        ASSERT_TRUE(query.exec(QStringLiteral("INSERT INTO source_files (file_path, provider, model) "
+                                              "VALUES ('doc.txt', 'openai', 'text-embedding-3-small');")))
+            << query.lastError().text().toStdString();
+        const qint64 fileId = query.lastInsertId().toLongLong();
+        const std::vector<std::vector<float>> embeddings{{1.0f, 0.0f}, {0.0f, 1.0f}};
+        for (int i = 0; i < 2; ++i) {
+            query.prepare(QStringLiteral("INSERT INTO fragments (file_id, chunk_index, start_line, end_line, content, embedding) "
+                                         "VALUES (?, ?, 1, 2, ?, ?)"));
+            query.addBindValue(fileId);
+            query.addBindValue(i);
+            query.addBindValue(i == 0 ? QStringLiteral("chunk A") : QStringLiteral("chunk B"));
+            query.addBindValue(QByteArray(reinterpret_cast<const char*>(embeddings[i].data()),
+                                          static_cast<int>(embeddings[i].size() * sizeof(float))));
+            ASSERT_TRUE(query.exec()) << query.lastError().text().toStdString();
+        }
+        query = QSqlQuery();
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+TEST(RagUtilsTest, DuplicateIndexMatchesCopiesAndSkipsTheExcludedFile)
+{
+    const QString text = QStringLiteral("The indexer links repeated chunks to the fragment that already holds them, "
+                                        "so licence headers and vendored files are embedded once.");
+    const QString respaced = QStringLiteral("the indexer links repeated   chunks to the fragment that already holds them\n"
+                                            "so LICENCE headers and vendored files are embedded once");
+    const QString other = QStringLiteral("Queries rank the stored fragments by cosine similarity and return the best "
+                                         "few with their file paths and line ranges.");
+
+    EXPECT_EQ(DuplicateIndex::contentHash(text), DuplicateIndex::contentHash(QString(text)));
+    EXPECT_NE(DuplicateIndex::contentHash(text), DuplicateIndex::contentHash(respaced));
+    // Case, spacing and punctuation are not part of the fingerprint
+    EXPECT_EQ(DuplicateIndex::simHash(text), DuplicateIndex::simHash(respaced));
+    EXPECT_GT(DuplicateIndex::distance(DuplicateIndex::simHash(text), DuplicateIndex::simHash(other)),
+              DuplicateIndex::kMaxNearDistance);
+    EXPECT_EQ(DuplicateIndex::simHash(QStringLiteral("too short to fingerprint")), 0u);
+
+    DuplicateIndex index;
+    index.addExact(DuplicateIndex::contentHash(text), 11, 1);
+    index.addExact(DuplicateIndex::contentHash(text), 12, 2);
+    index.addNear(DuplicateIndex::simHash(text), 11, 1);
+    EXPECT_EQ(index.findExact(DuplicateIndex::contentHash(text), 0), 11);
+    EXPECT_EQ(index.findExact(DuplicateIndex::contentHash(text), 1), 0);
+    EXPECT_EQ(index.findExact(DuplicateIndex::contentHash(other), 0), 0);
+    EXPECT_EQ(index.findNear(DuplicateIndex::simHash(respaced), 2), 11);
+    EXPECT_EQ(index.findNear(DuplicateIndex::simHash(respaced), 1), 0);
+    EXPECT_EQ(index.findNear(DuplicateIndex::simHash(other), 0), 0);
+    // A fingerprint a bit or two away still lands in one of the shared bands
+    EXPECT_EQ(index.findNear(DuplicateIndex::simHash(text) ^ 0x8001u, 0), 11);
+}
+
+// Spins the event loop for the server while the client blocks on a pool thread
+template <typename T>
+T waitSpinning(QFuture<T> future)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!future.isFinished() && timer.elapsed() < 10000) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    }
+    return future.result();
+}
+
+} // namespace
+
+TEST(RagIndexClientTest, ParsesAddressesAndRequests)
+{
+    RagIndexClient::Address address;
+    ASSERT_TRUE(RagIndexClient::parseAddress(QStringLiteral("rag://10.0.0.7:7341/docs"), address));
+    EXPECT_EQ(address.host, QStringLiteral("10.0.0.7"));
+    EXPECT_EQ(address.port, 7341);
+    EXPECT_EQ(address.index, QStringLiteral("docs"));
+    EXPECT_EQ(address.baseUrl(), QStringLiteral("http://10.0.0.7:7341"));
+    EXPECT_FALSE(RagIndexClient::parseAddress(QStringLiteral("rag://10.0.0.7/docs"), address));
+    EXPECT_FALSE(RagIndexClient::parseAddress(QStringLiteral("rag://10.0.0.7:7341"), address));
+    EXPECT_FALSE(RagIndexClient::isRemote(QStringLiteral("/data/docs.db")));
+
+    RagIndexClient::SearchRequest request;
+    request.index = QStringLiteral("docs");
+    request.embeddings = {{0.25f, -1.5f}, {}};
+    request.queryTexts = {QStringLiteral("first"), QString()};
+    request.limit = 7;
+    request.minRelevance = 0.5;
+    request.options.mode = RagSearchMode::Hybrid;
+    request.options.filter.pathPrefix = QStringLiteral("/repo/src/");
+    request.options.filter.tags = {QStringLiteral("io")};
+
+    RagIndexClient::SearchRequest parsed;
+    ASSERT_TRUE(RagIndexClient::SearchRequest::fromJson(request.toJson(), parsed));
+    EXPECT_EQ(parsed.index, request.index);
+    EXPECT_EQ(parsed.embeddings, request.embeddings);
+    EXPECT_EQ(parsed.queryTexts, request.queryTexts);
+    EXPECT_EQ(parsed.limit, 7);
+    EXPECT_DOUBLE_EQ(parsed.minRelevance, 0.5);
+    EXPECT_EQ(parsed.options.mode, RagSearchMode::Hybrid);
+    EXPECT_EQ(parsed.options.filter.pathPrefix, request.options.filter.pathPrefix);
+    EXPECT_EQ(parsed.options.filter.tags, request.options.filter.tags);
+}
+
+TEST(RagIndexServerTest, AnswersSearchesLikeTheLocalIndex)
+{
+    ensureCoreApp();
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString dbPath = dir.path() + QStringLiteral("/daemon.db");
+    writeTwoChunkIndex(dbPath, QStringLiteral("rag_daemon_test"));
+
+    RagIndexServer::Config config;
+    config.port = 0;
+    config.indexes.insert(QStringLiteral("docs"), dbPath);
+    config.batchWindowMs = 20;
+    RagIndexServer server(config);
+    QString error;
+    ASSERT_TRUE(server.start(&error)) << error.toStdString();
+    const QString url = QStringLiteral("rag://127.0.0.1:%1/docs").arg(server.serverPort());
+
+    const RagUtils::IndexConfig indexConfig =
+        waitSpinning(QtConcurrent::run([url]() { return RagIndexClient::indexConfig(url); }));
+    EXPECT_EQ(indexConfig.providerId, QStringLiteral("openai"));
+    EXPECT_EQ(indexConfig.modelId, QStringLiteral("text-embedding-3-small"));
+    EXPECT_EQ(indexConfig.dimension, 2);
+
+    // Two clients inside one batch window share a pass and still get their own answers
+    const std::vector<float> nearA{0.9f, 0.1f};
+    const std::vector<float> nearB{0.1f, 0.9f};
+    const auto remoteSearch = [url](const std::vector<float>& embedding) {
+        return QtConcurrent::run([url, embedding]() {
+            return RagIndexClient::search(url, {embedding}, {QString()}, 2, 0.0, RagSearchOptions());
+        });
+    };
+    QFuture<std::vector<std::vector<RagUtils::SearchResult>>> first = remoteSearch(nearA);
+    QFuture<std::vector<std::vector<RagUtils::SearchResult>>> second = remoteSearch(nearB);
+    const auto firstResults = waitSpinning(first);
+    const auto secondResults = waitSpinning(second);
+    EXPECT_EQ(server.pendingQueries(), 0);
+
+    const auto expectLocal = [&dbPath](const std::vector<std::vector<RagUtils::SearchResult>>& remote,
+                                       const std::vector<float>& embedding) {
+        const auto local = RagUtils::findMostRelevantChunks(dbPath, embedding, 2, 0.0);
+        ASSERT_EQ(remote.size(), 1u);
+        ASSERT_EQ(remote.front().size(), local.size());
+        for (std::size_t i = 0; i < local.size(); ++i) {
+            EXPECT_EQ(remote.front()[i].fragmentId, local[i].fragmentId);
+            EXPECT_EQ(remote.front()[i].content, local[i].content);
+            EXPECT_NEAR(remote.front()[i].score, local[i].score, 1e-6);
+        }
+    };
+    expectLocal(firstResults, nearA);
+    expectLocal(secondResults, nearB);
+    EXPECT_EQ(firstResults.front().front().content, QStringLiteral("chunk A"));
+    EXPECT_EQ(secondResults.front().front().content, QStringLiteral("chunk B"));
+
+    // An unknown index is refused
+    const QString missing = QStringLiteral("rag://127.0.0.1:%1/other").arg(server.serverPort());
+    const bool refused = waitSpinning(QtConcurrent::run([missing]() {
+        try {
+            RagIndexClient::search(missing, {{1.0f, 0.0f}}, {QString()}, 2, 0.0, RagSearchOptions());
+        } catch (const std::exception&) {
+            return true;
+        }
+        return false;
+    }));
+    EXPECT_TRUE(refused);
 }
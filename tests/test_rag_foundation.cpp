@@ -11,6 +11,9 @@
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QString>
+#include <QStringList>
+
+#include <cmath>
 
 #include "retrieval/storage/RagUtils.h"
 #include "ai/backends/OpenAIBackend.h"
@@ -187,3 +190,65 @@ TEST(RagFoundationTest, OpenAIEmbeddingsAPI)
     }
     EXPECT_TRUE(hasNonZeroValue) << "Embedding vector should contain non-zero values";
 }
+
+TEST(RagFoundationTest, EmbeddingBatchesSplitByCountAndTokenBudget)
+{
+    const QStringList texts{
+        QStringLiteral("a"), QStringLiteral("b"), QStringLiteral("c"),
+        QStringLiteral("d"), QStringLiteral("e")
+    };
+
+    const QList<QStringList> byCount = ILLMBackend::splitEmbeddingBatches(texts, 2, 0);
+    ASSERT_EQ(byCount.size(), 3);
+    EXPECT_EQ(byCount.at(0), (QStringList{QStringLiteral("a"), QStringLiteral("b")}));
+    EXPECT_EQ(byCount.at(2), QStringList{QStringLiteral("e")});
+
+    // ~100 tokens each against a 250-token budget: two per batch, and an
+    // oversized text still goes out on its own.
+    const QString medium(400, QLatin1Char('x'));
+    const QString huge(4000, QLatin1Char('y'));
+    const QList<QStringList> byTokens =
+        ILLMBackend::splitEmbeddingBatches(QStringList{medium, medium, medium, huge, medium}, 0, 250);
+    ASSERT_EQ(byTokens.size(), 4);
+    EXPECT_EQ(byTokens.at(0).size(), 2);
+    EXPECT_EQ(byTokens.at(1).size(), 1);
+    EXPECT_EQ(byTokens.at(2), QStringList{huge});
+    EXPECT_EQ(byTokens.at(3).size(), 1);
+
+    EXPECT_TRUE(ILLMBackend::splitEmbeddingBatches(QStringList{}, 10, 10).isEmpty());
+}
+
+TEST(RagFoundationTest, OpenAIBatchEmbeddingsKeepInputOrder)
+{
+    ensureCoreApp();
+
+    QString apiKey = qEnvironmentVariable("OPENAI_API_KEY");
+    if (apiKey.isEmpty()) {
+        apiKey = LLMProviderRegistry::instance().getCredential(QStringLiteral("openai"));
+    }
+    if (apiKey.isEmpty()) {
+        GTEST_SKIP() << "No OpenAI API key provided. Set OPENAI_API_KEY environment variable or add to accounts.json.";
+    }
+
+    OpenAIBackend backend;
+    const QStringList texts{QStringLiteral("Hello World"), QStringLiteral("Goodbye"), QStringLiteral("Hello World")};
+    const EmbeddingBatchResult result =
+        backend.getEmbeddings(apiKey, QStringLiteral("text-embedding-3-small"), texts);
+
+    if (result.hasError) {
+        if (isTemporaryError(result.errorMsg)) {
+            GTEST_SKIP() << "Temporary LLM error during embedding: " << result.errorMsg.toStdString();
+        }
+        FAIL() << "Batch embedding request failed with error: " << result.errorMsg.toStdString();
+    }
+
+    ASSERT_EQ(result.vectors.size(), 3u);
+    EXPECT_EQ(result.vectors[0].size(), 1536u);
+    EXPECT_GT(result.usage.inputTokens, 0);
+    // Identical inputs embed to (nearly) identical vectors in the same slots
+    float diff = 0.0f;
+    for (size_t i = 0; i < result.vectors[0].size(); ++i) {
+        diff += std::abs(result.vectors[0][i] - result.vectors[2][i]);
+    }
+    EXPECT_LT(diff, 0.5f);
+}
@@ -6,7 +6,9 @@
 #include <gtest/gtest.h>
 #include <QCoreApplication>
 #include <QTemporaryDir>
+#include <QDateTime>
 #include <QFile>
+#include <QFileInfo>
 #include <QTextStream>
 #include <QSqlDatabase>
 #include <QSqlQuery>
@@ -15,14 +17,29 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QDebug>
+#include <QRegularExpression>
+#include <QSemaphore>
+#include <QThread>
+#include <QtConcurrent>
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <vector>
 
 #include "RagIndexerNode.h"
+#include "RagQueryNode.h"
+#include "CancellationToken.h"
 #include "ModelCapsRegistry.h"
 #include "ai/backends/GoogleBackend.h"
+#include "ai/backends/OllamaBackend.h"
+#include "ai/registry/LLMProviderRegistry.h"
 #include "ai/catalog/ModelCatalogService.h"
 #include "retrieval/documents/DocumentLoader.h"
 #include "retrieval/chunking/TextChunker.h"
+#include "retrieval/ranking/Reranker.h"
 #include "retrieval/storage/RagUtils.h"
+#include "retrieval/storage/EmbeddingCache.h"
 
 /**
  * @brief Test suite for RagIndexerNode
@@ -55,6 +72,8 @@ TEST_F(RagIndexerNodeTest, DescriptorUsesPropertyDatabasePath)
     const NodeDescriptor desc = indexer.getDescriptor();
 
     EXPECT_TRUE(desc.inputPins.contains(QString::fromLatin1(RagIndexerNode::kInputDirectoryPath)));
+    EXPECT_TRUE(desc.inputPins.contains(QString::fromLatin1(RagIndexerNode::kInputFilePath)));
+    EXPECT_TRUE(desc.inputPins.contains(QString::fromLatin1(RagIndexerNode::kInputText)));
     EXPECT_FALSE(desc.inputPins.contains(QString::fromLatin1(RagIndexerNode::kInputMetadata)));
     EXPECT_FALSE(desc.inputPins.contains(QString::fromLatin1(RagIndexerNode::kInputDatabasePath)));
     EXPECT_FALSE(desc.outputPins.contains(QString::fromLatin1(RagIndexerNode::kOutputDatabasePath)));
@@ -224,6 +243,17 @@ TEST_F(RagIndexerNodeTest, IndexesSingleTextFile) {
     int vectorSize = embedding.size() / sizeof(float);
     EXPECT_GT(vectorSize, 0) << "Embedding vector should have elements";
 
+    // Stored vectors are unit length, and the database says so
+    std::vector<float> vector(static_cast<std::size_t>(vectorSize));
+    std::memcpy(vector.data(), embedding.constData(), embedding.size());
+    double normSquared = 0.0;
+    for (float value : vector) {
+        normSquared += static_cast<double>(value) * value;
+    }
+    EXPECT_NEAR(normSquared, 1.0, 1e-4);
+    ASSERT_TRUE(query.exec(QStringLiteral("PRAGMA user_version")) && query.next());
+    EXPECT_EQ(query.value(0).toInt(), kRagNormalizedEmbeddingsVersion);
+
     db.close();
 }
 
@@ -270,6 +300,14 @@ TEST_F(RagIndexerNodeTest, SavesAndLoadsState) {
     node.setModelId(QStringLiteral("text-embedding-3-large"));
     node.setChunkSize(2000);
     node.setChunkOverlap(300);
+    node.setEmbeddingConcurrency(6);
+    node.setEmbeddingFormat(QStringLiteral("int8"));
+    node.setKeepFullPrecision(true);
+    node.setEmbeddingDimensions(256);
+    node.setBuildVectorFile(true);
+    node.setCheckpointFiles(10);
+    node.setCheckpointSeconds(0);
+    node.setResumeInterrupted(false);
 
     QJsonObject state = node.saveState();
 
@@ -283,6 +321,17 @@ TEST_F(RagIndexerNodeTest, SavesAndLoadsState) {
     EXPECT_EQ(node2.modelId(), QStringLiteral("text-embedding-3-large"));
     EXPECT_EQ(node2.chunkSize(), 2000);
     EXPECT_EQ(node2.chunkOverlap(), 300);
+    EXPECT_EQ(node2.embeddingConcurrency(), 6);
+    EXPECT_EQ(node2.embeddingFormat(), QStringLiteral("int8"));
+    EXPECT_TRUE(node2.keepFullPrecision());
+    EXPECT_EQ(node2.embeddingDimensions(), 256);
+    EXPECT_TRUE(node2.buildVectorFile());
+    EXPECT_EQ(node2.checkpointFiles(), 10);
+    EXPECT_EQ(node2.checkpointSeconds(), 0);
+    EXPECT_FALSE(node2.resumeInterrupted());
+
+    node2.setEmbeddingFormat(QStringLiteral("bogus"));
+    EXPECT_EQ(node2.embeddingFormat(), QStringLiteral("float32"));
 }
 
 /**
@@ -372,3 +421,955 @@ TEST_F(RagIndexerNodeTest, FileFilterExcludesNonMatchingFiles) {
     db.close();
     QSqlDatabase::removeDatabase(QStringLiteral("test_filter_db"));
 }
+
+namespace {
+
+// Stands in for the local provider so no credential is needed. Each batch
+// sleeps to look like a round trip and records how many overlap; vector[0]
+// carries the chunk length so rows can be matched back to their content.
+class PipelineEmbeddingBackend : public ILLMBackend {
+public:
+    QString id() const override { return QStringLiteral("ollama"); }
+    QString name() const override { return QStringLiteral("Pipeline Embedding Backend"); }
+    QStringList availableModels() const override { return {}; }
+    QStringList availableEmbeddingModels() const override { return {QStringLiteral("embed")}; }
+    QFuture<QStringList> fetchModelList() override {
+        return QtConcurrent::run([]() { return QStringList{}; });
+    }
+    LLMResult sendPrompt(const QString&, const QString&, double, int, const QString&, const QString&,
+                         const LLMMessage& = {}) override {
+        return {};
+    }
+    EmbeddingResult getEmbedding(const QString&, const QString&, const QString& text) override {
+        EmbeddingResult r;
+        r.vector = {static_cast<float>(text.size()), 1.0f};
+        return r;
+    }
+    EmbeddingBatchResult getEmbeddings(const QString&, const QString&, const QStringList& texts) override {
+        const int now = ++inFlight;
+        int seen = maxInFlight.load();
+        while (now > seen && !maxInFlight.compare_exchange_weak(seen, now)) {
+        }
+        QThread::msleep(60);
+        EmbeddingBatchResult result;
+        for (const QString& text : texts) {
+            result.vectors.push_back({static_cast<float>(text.size()), 1.0f});
+        }
+        ++batches;
+        embeddedTexts += static_cast<int>(texts.size());
+        --inFlight;
+        return result;
+    }
+    QFuture<QString> generateImage(const QString&, const QString&, const QString&, const QString&,
+                                   const QString&, const QString&) override {
+        return QFuture<QString>();
+    }
+    void warmUp(const QString&, const QString& modelName) override {
+        warmedModel = modelName;
+        warmed.release();
+    }
+
+    std::atomic<int> inFlight {0};
+    std::atomic<int> maxInFlight {0};
+    std::atomic<int> batches {0};
+    std::atomic<int> embeddedTexts {0};
+    QString warmedModel;
+    QSemaphore warmed;
+};
+
+} // namespace
+
+/**
+ * @brief Run start prepares the embedding backend without holding up the engine
+ */
+TEST_F(RagIndexerNodeTest, WarmUpPreparesTheEmbeddingBackend) {
+    auto backend = std::make_shared<PipelineEmbeddingBackend>();
+    LLMProviderRegistry::instance().registerBackend(backend);
+
+    RagIndexerNode indexer;
+    indexer.setProviderId(QStringLiteral("ollama"));
+    indexer.setModelId(QStringLiteral("embed"));
+    indexer.warmUp();
+    ASSERT_TRUE(backend->warmed.tryAcquire(1, 5000));
+    EXPECT_EQ(backend->warmedModel, QStringLiteral("embed"));
+
+    LLMProviderRegistry::instance().registerBackend(std::make_shared<OllamaBackend>());
+}
+
+/**
+ * @brief Embedding batches from several files overlap, bounded by the concurrency setting
+ */
+TEST_F(RagIndexerNodeTest, PipelinesEmbeddingAcrossFiles) {
+    auto backend = std::make_shared<PipelineEmbeddingBackend>();
+    LLMProviderRegistry::instance().registerBackend(backend);
+    EmbeddingCache::setSharedPath(QString());
+
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+    const int fileCount = 8;
+    for (int f = 0; f < fileCount; ++f) {
+        QFile file(tempDir.path() + QStringLiteral("/doc%1.txt").arg(f));
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Text));
+        QTextStream out(&file);
+        for (int line = 0; line < 12; ++line) {
+            out << "File " << f << " line " << line << " has some words to index.\n";
+        }
+    }
+
+    QTemporaryDir dbDir;
+    ASSERT_TRUE(dbDir.isValid());
+    const QString dbPath = dbDir.path() + QStringLiteral("/pipeline.db");
+
+    RagIndexerNode indexer;
+    indexer.setDirectoryPath(tempDir.path());
+    indexer.setDatabasePath(dbPath);
+    indexer.setProviderId(QStringLiteral("ollama"));
+    indexer.setModelId(QStringLiteral("embed"));
+    indexer.setChunkSize(100);
+    indexer.setChunkOverlap(0);
+    indexer.setEmbeddingConcurrency(3);
+
+    const TokenList outTokens = indexer.execute(TokenList{ExecutionToken{}});
+    ASSERT_FALSE(outTokens.empty());
+    const DataPacket output = outTokens.front().data;
+    EXPECT_FALSE(output.contains(QStringLiteral("__error")))
+        << output.value(QStringLiteral("__error")).toString().toStdString();
+    const int chunkCount = output.value(QString::fromLatin1(RagIndexerNode::kOutputCount)).toInt();
+    EXPECT_GT(chunkCount, fileCount);
+    EXPECT_EQ(backend->batches.load(), fileCount);
+    EXPECT_GE(backend->maxInFlight.load(), 2);
+    EXPECT_LE(backend->maxInFlight.load(), 3);
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), QStringLiteral("test_rag_db"));
+        db.setDatabaseName(dbPath);
+        ASSERT_TRUE(db.open());
+        QSqlQuery query(db);
+        ASSERT_TRUE(query.exec(QStringLiteral("SELECT COUNT(*) FROM source_files")));
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(query.value(0).toInt(), fileCount);
+
+        ASSERT_TRUE(query.exec(QStringLiteral("SELECT content, embedding FROM fragments")));
+        int rows = 0;
+        while (query.next()) {
+            const QByteArray blob = query.value(1).toByteArray();
+            ASSERT_EQ(blob.size(), static_cast<int>(2 * sizeof(float)));
+            // Stored unit length, so {length, 1} keeps its ratio
+            float vector[2];
+            std::memcpy(vector, blob.constData(), sizeof(vector));
+            EXPECT_EQ(static_cast<int>(std::lround(vector[0] / vector[1])), query.value(0).toString().size());
+            ++rows;
+        }
+        EXPECT_EQ(rows, chunkCount);
+        db.close();
+    }
+
+    LLMProviderRegistry::instance().registerBackend(std::make_shared<OllamaBackend>());
+    EmbeddingCache::setSharedPath(EmbeddingCache::defaultPath());
+}
+
+/**
+ * @brief Re-indexing unchanged files is served from the embedding cache
+ */
+TEST_F(RagIndexerNodeTest, ReindexingUnchangedFilesHitsEmbeddingCache) {
+    auto backend = std::make_shared<PipelineEmbeddingBackend>();
+    LLMProviderRegistry::instance().registerBackend(backend);
+    QTemporaryDir cacheDir;
+    ASSERT_TRUE(cacheDir.isValid());
+    EmbeddingCache::setSharedPath(cacheDir.filePath(QStringLiteral("embeddings.sqlite")));
+
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+    QFile file(tempDir.path() + QStringLiteral("/doc.txt"));
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Text));
+    QTextStream(&file) << "Cached embeddings survive between runs.\nThe second run should not call the backend.\n";
+    file.close();
+
+    QTemporaryDir dbDir;
+    ASSERT_TRUE(dbDir.isValid());
+
+    RagIndexerNode indexer;
+    indexer.setDirectoryPath(tempDir.path());
+    indexer.setDatabasePath(dbDir.filePath(QStringLiteral("cache.db")));
+    indexer.setProviderId(QStringLiteral("ollama"));
+    indexer.setModelId(QStringLiteral("embed"));
+    indexer.setChunkSize(100);
+    indexer.setChunkOverlap(0);
+    indexer.setClearDatabase(true);
+
+    const DataPacket first = indexer.execute(TokenList{ExecutionToken{}}).front().data;
+    const int chunkCount = first.value(QString::fromLatin1(RagIndexerNode::kOutputCount)).toInt();
+    ASSERT_GT(chunkCount, 0);
+    EXPECT_EQ(first.value(QStringLiteral("embedding_cache_hits")).toInt(), 0);
+    EXPECT_EQ(first.value(QStringLiteral("embedding_cache_misses")).toInt(), chunkCount);
+    const int batchesAfterFirst = backend->batches.load();
+
+    const DataPacket second = indexer.execute(TokenList{ExecutionToken{}}).front().data;
+    EXPECT_EQ(second.value(QString::fromLatin1(RagIndexerNode::kOutputCount)).toInt(), chunkCount);
+    EXPECT_EQ(second.value(QStringLiteral("embedding_cache_hits")).toInt(), chunkCount);
+    EXPECT_EQ(second.value(QStringLiteral("embedding_cache_misses")).toInt(), 0);
+    EXPECT_EQ(backend->batches.load(), batchesAfterFirst);
+
+    LLMProviderRegistry::instance().registerBackend(std::make_shared<OllamaBackend>());
+    EmbeddingCache::setSharedPath(EmbeddingCache::defaultPath());
+}
+
+/**
+ * @brief Quantised indexes store compact vectors, optional float32 copies, and refuse a format change
+ */
+TEST_F(RagIndexerNodeTest, StoresQuantisedEmbeddingsInTheChosenFormat) {
+    auto backend = std::make_shared<PipelineEmbeddingBackend>();
+    LLMProviderRegistry::instance().registerBackend(backend);
+    EmbeddingCache::setSharedPath(QString());
+
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+    QFile file(tempDir.path() + QStringLiteral("/doc.txt"));
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Text));
+    QTextStream(&file) << "Quantised vectors take a quarter of the space.\nThe float32 copy is for rescoring.\n";
+    file.close();
+
+    QTemporaryDir dbDir;
+    ASSERT_TRUE(dbDir.isValid());
+    const QString dbPath = dbDir.filePath(QStringLiteral("int8.db"));
+
+    RagIndexerNode indexer;
+    indexer.setDirectoryPath(tempDir.path());
+    indexer.setDatabasePath(dbPath);
+    indexer.setProviderId(QStringLiteral("ollama"));
+    indexer.setModelId(QStringLiteral("embed"));
+    indexer.setChunkSize(100);
+    indexer.setChunkOverlap(0);
+    indexer.setEmbeddingFormat(QStringLiteral("int8"));
+    indexer.setKeepFullPrecision(true);
+
+    const DataPacket output = indexer.execute(TokenList{ExecutionToken{}}).front().data;
+    ASSERT_FALSE(output.contains(QStringLiteral("__error")))
+        << output.value(QStringLiteral("__error")).toString().toStdString();
+    EXPECT_EQ(output.value(QStringLiteral("embedding_format")).toString(), QStringLiteral("int8"));
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), QStringLiteral("test_rag_int8_db"));
+        db.setDatabaseName(dbPath);
+        ASSERT_TRUE(db.open());
+        QSqlQuery query(db);
+        ASSERT_TRUE(query.exec(QStringLiteral("SELECT embedding_format FROM source_files")));
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(query.value(0).toString(), QStringLiteral("int8"));
+        ASSERT_TRUE(query.exec(QStringLiteral("SELECT LENGTH(embedding), LENGTH(embedding_full) FROM fragments")));
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(query.value(0).toInt(), RagUtils::embeddingBlobSize(RagEmbeddingFormat::Int8, 2));
+        EXPECT_EQ(query.value(1).toInt(), RagUtils::embeddingBlobSize(RagEmbeddingFormat::Float32, 2));
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(QStringLiteral("test_rag_int8_db"));
+
+    const RagUtils::IndexConfig config = RagUtils::getIndexConfig(dbPath);
+    EXPECT_EQ(config.format, RagEmbeddingFormat::Int8);
+    EXPECT_EQ(config.dimension, 2);
+
+    // Appending float32 vectors to an int8 index is refused until it is cleared
+    indexer.setEmbeddingFormat(QStringLiteral("float32"));
+    const DataPacket refused = indexer.execute(TokenList{ExecutionToken{}}).front().data;
+    EXPECT_TRUE(refused.contains(QStringLiteral("__error")));
+
+    indexer.setClearDatabase(true);
+    const DataPacket reindexed = indexer.execute(TokenList{ExecutionToken{}}).front().data;
+    EXPECT_FALSE(reindexed.contains(QStringLiteral("__error")))
+        << reindexed.value(QStringLiteral("__error")).toString().toStdString();
+    EXPECT_EQ(RagUtils::getIndexConfig(dbPath).format, RagEmbeddingFormat::Float32);
+
+    LLMProviderRegistry::instance().registerBackend(std::make_shared<OllamaBackend>());
+    EmbeddingCache::setSharedPath(EmbeddingCache::defaultPath());
+}
+
+/**
+ * @brief A reduced embedding size is requested, recorded in the index config, and re-embeds files when changed
+ */
+TEST_F(RagIndexerNodeTest, ReducedEmbeddingDimensionsAreRecordedAndReembedded) {
+    auto backend = std::make_shared<PipelineEmbeddingBackend>();
+    LLMProviderRegistry::instance().registerBackend(backend);
+    EmbeddingCache::setSharedPath(QString());
+
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+    QFile file(tempDir.path() + QStringLiteral("/doc.txt"));
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Text));
+    QTextStream(&file) << "Matryoshka embeddings keep most of their meaning in the leading dimensions.\n";
+    file.close();
+
+    QTemporaryDir dbDir;
+    ASSERT_TRUE(dbDir.isValid());
+    const QString dbPath = dbDir.filePath(QStringLiteral("reduced.db"));
+
+    RagIndexerNode indexer;
+    indexer.setDirectoryPath(tempDir.path());
+    indexer.setDatabasePath(dbPath);
+    indexer.setProviderId(QStringLiteral("ollama"));
+    indexer.setModelId(QStringLiteral("embed"));
+    indexer.setChunkSize(200);
+    indexer.setChunkOverlap(0);
+    indexer.setEmbeddingDimensions(1);
+
+    // The test backend has no dimension parameter, so its 2-d vectors are cut to 1 locally
+    const DataPacket reduced = indexer.execute(TokenList{ExecutionToken{}}).front().data;
+    ASSERT_FALSE(reduced.contains(QStringLiteral("__error")))
+        << reduced.value(QStringLiteral("__error")).toString().toStdString();
+    RagUtils::IndexConfig config = RagUtils::getIndexConfig(dbPath);
+    EXPECT_EQ(config.dimension, 1);
+    EXPECT_EQ(config.requestedDimensions, 1);
+    const std::vector<RagUtils::SearchResult> hits = RagUtils::findMostRelevantChunks(dbPath, {1.0f}, 1, 0.0);
+    ASSERT_EQ(hits.size(), 1u);
+    EXPECT_NEAR(hits.front().score, 1.0, 1e-6);
+
+    // Going back to the model's own size re-embeds the unchanged file
+    indexer.setEmbeddingDimensions(0);
+    const DataPacket full = indexer.execute(TokenList{ExecutionToken{}}).front().data;
+    ASSERT_FALSE(full.contains(QStringLiteral("__error")))
+        << full.value(QStringLiteral("__error")).toString().toStdString();
+    EXPECT_EQ(full.value(QStringLiteral("files_updated")).toInt(), 1);
+    config = RagUtils::getIndexConfig(dbPath);
+    EXPECT_EQ(config.dimension, 2);
+    EXPECT_EQ(config.requestedDimensions, 0);
+
+    LLMProviderRegistry::instance().registerBackend(std::make_shared<OllamaBackend>());
+    EmbeddingCache::setSharedPath(EmbeddingCache::defaultPath());
+}
+
+/**
+ * @brief One query node searches several indexes of the same model with a single embedding
+ */
+TEST_F(RagIndexerNodeTest, QueryNodeMergesResultsFromSeveralIndexes) {
+    auto backend = std::make_shared<PipelineEmbeddingBackend>();
+    LLMProviderRegistry::instance().registerBackend(backend);
+    EmbeddingCache::setSharedPath(QString());
+
+    QTemporaryDir dbDir;
+    ASSERT_TRUE(dbDir.isValid());
+    QStringList dbPaths;
+    const QStringList documents = {
+        QStringLiteral("Short note."),
+        QStringLiteral("A much longer paragraph about the build system and how shards are laid out."),
+    };
+    for (qsizetype shard = 0; shard < documents.size(); ++shard) {
+        QTemporaryDir sourceDir;
+        ASSERT_TRUE(sourceDir.isValid());
+        QFile file(sourceDir.filePath(QStringLiteral("doc.txt")));
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Text));
+        QTextStream(&file) << documents[shard] << "\n";
+        file.close();
+
+        dbPaths.append(dbDir.filePath(QStringLiteral("shard%1.db").arg(shard)));
+        RagIndexerNode indexer;
+        indexer.setDirectoryPath(sourceDir.path());
+        indexer.setDatabasePath(dbPaths.back());
+        indexer.setProviderId(QStringLiteral("ollama"));
+        indexer.setModelId(QStringLiteral("embed"));
+        indexer.setChunkSize(200);
+        indexer.setChunkOverlap(0);
+        const DataPacket indexed = indexer.execute(TokenList{ExecutionToken{}}).front().data;
+        ASSERT_FALSE(indexed.contains(QStringLiteral("__error")))
+            << indexed.value(QStringLiteral("__error")).toString().toStdString();
+    }
+
+    RagQueryNode node;
+    node.setDatabasePath(dbPaths.front());
+    node.setAdditionalDatabasePaths({dbPaths.back(), QStringLiteral("  ")});
+    node.setMaxResults(5);
+    node.setMinRelevance(0.0);
+    EXPECT_EQ(node.additionalDatabasePaths(), QStringList{dbPaths.back()});
+
+    // The query's {length, 1} vector lies closest to the longer document
+    const int batchesBefore = backend->batches.load();
+    node.setQueryText(QStringLiteral("Which document talks about the shards of the build system at length?"));
+    const DataPacket out = node.execute(TokenList{ExecutionToken{}}).front().data;
+    ASSERT_FALSE(out.contains(QStringLiteral("__error")))
+        << out.value(QStringLiteral("__error")).toString().toStdString();
+    EXPECT_EQ(backend->batches.load() - batchesBefore, 1);
+    EXPECT_EQ(out.value(QStringLiteral("indexes_searched")).toInt(), 2);
+    EXPECT_EQ(out.value(QStringLiteral("embedding_models")).toInt(), 1);
+
+    const QVariantList results = out.value(QString::fromLatin1(RagQueryNode::kOutputResults)).toList();
+    ASSERT_EQ(results.size(), 2);
+    EXPECT_EQ(results[0].toMap().value(QStringLiteral("index")).toString(), dbPaths.back());
+    EXPECT_EQ(results[1].toMap().value(QStringLiteral("index")).toString(), dbPaths.front());
+    EXPECT_GE(results[0].toMap().value(QStringLiteral("score")).toDouble(),
+              results[1].toMap().value(QStringLiteral("score")).toDouble());
+
+    // The state round-trips, and a path list on the database input replaces both paths
+    RagQueryNode restored;
+    restored.loadState(node.saveState());
+    EXPECT_EQ(restored.additionalDatabasePaths(), QStringList{dbPaths.back()});
+
+    DataPacket inputs;
+    inputs.insert(QString::fromLatin1(RagQueryNode::kInputDbPath), QStringList{dbPaths.front()});
+    ExecutionToken token;
+    token.data = inputs;
+    const DataPacket single = node.execute(TokenList{token}).front().data;
+    ASSERT_FALSE(single.contains(QStringLiteral("__error")))
+        << single.value(QStringLiteral("__error")).toString().toStdString();
+    EXPECT_FALSE(single.contains(QStringLiteral("indexes_searched")));
+    EXPECT_EQ(single.value(QString::fromLatin1(RagQueryNode::kOutputResults)).toList().size(), 1);
+
+    LLMProviderRegistry::instance().registerBackend(std::make_shared<OllamaBackend>());
+    EmbeddingCache::setSharedPath(EmbeddingCache::defaultPath());
+}
+
+TEST(RerankerTest, ParsesOneGradePerPassage) {
+    const std::vector<double> scores = Reranker::parseScores(QStringLiteral("Grades: [7, 0, 10.0]\n"), 3);
+    ASSERT_EQ(scores.size(), 3u);
+    EXPECT_DOUBLE_EQ(scores[0], 0.7);
+    EXPECT_DOUBLE_EQ(scores[1], 0.0);
+    EXPECT_DOUBLE_EQ(scores[2], 1.0);
+    EXPECT_DOUBLE_EQ(Reranker::parseScores(QStringLiteral("[12, -1]"), 2).front(), 1.0);
+    EXPECT_TRUE(Reranker::parseScores(QStringLiteral("[7, 0]"), 3).empty());
+    EXPECT_TRUE(Reranker::parseScores(QStringLiteral("no list here"), 1).empty());
+
+    const QString prompt = Reranker::buildPrompt(QStringLiteral("q"), {QStringLiteral("a"), QString(2000, u'x')});
+    EXPECT_TRUE(prompt.contains(QStringLiteral("Passage 2:")));
+    EXPECT_FALSE(prompt.contains(QString(Reranker::kMaxDocumentChars + 1, u'x')));
+}
+
+/**
+ * @brief The reranking stage grades a wider candidate list and keeps the best matches in its order
+ */
+TEST_F(RagIndexerNodeTest, QueryNodeReranksCandidatesWithAChatModel) {
+    // Grades passages that mention the answer 10 and everything else 1, one prompt per call
+    class GradingBackend : public PipelineEmbeddingBackend {
+    public:
+        LLMResult sendPrompt(const QString&, const QString&, double, int, const QString&,
+                             const QString& userPrompt, const LLMMessage& = {}) override {
+            ++prompts;
+            QStringList grades;
+            static const QRegularExpression passage(QStringLiteral("Passage \\d+:\\n([^\\n]*)"));
+            auto it = passage.globalMatch(userPrompt);
+            while (it.hasNext()) {
+                grades.append(it.next().captured(1).contains(QStringLiteral("answer")) ? QStringLiteral("10")
+                                                                                        : QStringLiteral("1"));
+            }
+            LLMResult result;
+            result.content = QStringLiteral("[%1]").arg(grades.join(QStringLiteral(", ")));
+            return result;
+        }
+        std::atomic<int> prompts {0};
+    };
+    auto backend = std::make_shared<GradingBackend>();
+    LLMProviderRegistry::instance().registerBackend(backend);
+    EmbeddingCache::setSharedPath(QString());
+
+    QTemporaryDir sourceDir;
+    ASSERT_TRUE(sourceDir.isValid());
+    const QStringList documents = {
+        QStringLiteral("Here is the answer."),
+        QStringLiteral("A long paragraph that sits close to the query in embedding space but says nothing useful."),
+        QStringLiteral("Another fairly long paragraph that is also close to the query without helping at all."),
+    };
+    for (qsizetype i = 0; i < documents.size(); ++i) {
+        QFile file(sourceDir.filePath(QStringLiteral("doc%1.txt").arg(i)));
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Text));
+        QTextStream(&file) << documents[i] << "\n";
+    }
+
+    QTemporaryDir dbDir;
+    ASSERT_TRUE(dbDir.isValid());
+    const QString dbPath = dbDir.filePath(QStringLiteral("rerank.db"));
+    RagIndexerNode indexer;
+    indexer.setDirectoryPath(sourceDir.path());
+    indexer.setDatabasePath(dbPath);
+    indexer.setProviderId(QStringLiteral("ollama"));
+    indexer.setModelId(QStringLiteral("embed"));
+    indexer.setChunkSize(200);
+    indexer.setChunkOverlap(0);
+    const DataPacket indexed = indexer.execute(TokenList{ExecutionToken{}}).front().data;
+    ASSERT_FALSE(indexed.contains(QStringLiteral("__error")))
+        << indexed.value(QStringLiteral("__error")).toString().toStdString();
+
+    RagQueryNode node;
+    node.setDatabasePath(dbPath);
+    node.setMaxResults(1);
+    node.setMinRelevance(0.0);
+    node.setQueryText(QStringLiteral("Which of these passages gives the answer to the question I am asking?"));
+
+    // On its own the vector ranking prefers a long paragraph
+    const DataPacket plain = node.execute(TokenList{ExecutionToken{}}).front().data;
+    ASSERT_FALSE(plain.contains(QStringLiteral("__error")))
+        << plain.value(QStringLiteral("__error")).toString().toStdString();
+    const QVariantList plainResults = plain.value(QString::fromLatin1(RagQueryNode::kOutputResults)).toList();
+    ASSERT_EQ(plainResults.size(), 1);
+    EXPECT_FALSE(plainResults.front().toMap().value(QStringLiteral("text")).toString().contains(QStringLiteral("answer")));
+    EXPECT_EQ(backend->prompts.load(), 0);
+
+    node.setRerankProvider(QStringLiteral("ollama"));
+    node.setRerankModel(QStringLiteral("grader"));
+    node.setRerankCandidates(3);
+    const DataPacket out = node.execute(TokenList{ExecutionToken{}}).front().data;
+    ASSERT_FALSE(out.contains(QStringLiteral("__error")))
+        << out.value(QStringLiteral("__error")).toString().toStdString();
+    EXPECT_EQ(backend->prompts.load(), 1);
+    EXPECT_EQ(out.value(QStringLiteral("reranked_candidates")).toInt(), 3);
+    const QVariantList results = out.value(QString::fromLatin1(RagQueryNode::kOutputResults)).toList();
+    ASSERT_EQ(results.size(), 1);
+    const QVariantMap best = results.front().toMap();
+    EXPECT_TRUE(best.value(QStringLiteral("text")).toString().contains(QStringLiteral("answer")));
+    EXPECT_DOUBLE_EQ(best.value(QStringLiteral("rerank_score")).toDouble(), 1.0);
+    EXPECT_TRUE(out.value(QString::fromLatin1(RagQueryNode::kOutputContext)).toString().contains(QStringLiteral("Rerank: 1.00")));
+
+    RagQueryNode restored;
+    restored.loadState(node.saveState());
+    EXPECT_EQ(restored.rerankProvider(), QStringLiteral("ollama"));
+    EXPECT_EQ(restored.rerankModel(), QStringLiteral("grader"));
+    EXPECT_EQ(restored.rerankCandidates(), 3);
+
+    LLMProviderRegistry::instance().registerBackend(std::make_shared<OllamaBackend>());
+    EmbeddingCache::setSharedPath(EmbeddingCache::defaultPath());
+}
+
+/**
+ * @brief A second run embeds only changed files and drops files that disappeared
+ */
+TEST_F(RagIndexerNodeTest, ReindexesOnlyChangedFilesAndRemovesDeletedOnes) {
+    auto backend = std::make_shared<PipelineEmbeddingBackend>();
+    LLMProviderRegistry::instance().registerBackend(backend);
+    EmbeddingCache::setSharedPath(QString());
+
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+    auto writeFile = [&tempDir](const QString& name, const QString& text) {
+        QFile file(tempDir.filePath(name));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            return false;
+        }
+        QTextStream(&file) << text;
+        return true;
+    };
+    ASSERT_TRUE(writeFile(QStringLiteral("alpha.txt"), QStringLiteral("Alpha is going to be deleted.\n")));
+    ASSERT_TRUE(writeFile(QStringLiteral("beta.txt"), QStringLiteral("Beta will be edited.\n")));
+    ASSERT_TRUE(writeFile(QStringLiteral("gamma.txt"), QStringLiteral("Gamma is only touched.\n")));
+
+    QTemporaryDir dbDir;
+    ASSERT_TRUE(dbDir.isValid());
+    const QString dbPath = dbDir.filePath(QStringLiteral("incremental.db"));
+
+    RagIndexerNode indexer;
+    indexer.setDirectoryPath(tempDir.path());
+    indexer.setDatabasePath(dbPath);
+    indexer.setProviderId(QStringLiteral("ollama"));
+    indexer.setModelId(QStringLiteral("embed"));
+    indexer.setChunkSize(100);
+    indexer.setChunkOverlap(0);
+
+    const DataPacket first = indexer.execute(TokenList{ExecutionToken{}}).front().data;
+    ASSERT_FALSE(first.contains(QStringLiteral("__error")))
+        << first.value(QStringLiteral("__error")).toString().toStdString();
+    EXPECT_EQ(first.value(QStringLiteral("files_added")).toInt(), 3);
+    EXPECT_EQ(backend->batches.load(), 3);
+
+    const DataPacket second = indexer.execute(TokenList{ExecutionToken{}}).front().data;
+    EXPECT_EQ(second.value(QString::fromLatin1(RagIndexerNode::kOutputCount)).toInt(), 0);
+    EXPECT_EQ(second.value(QStringLiteral("files_unchanged")).toInt(), 3);
+    EXPECT_EQ(backend->batches.load(), 3);
+
+    ASSERT_TRUE(QFile::remove(tempDir.filePath(QStringLiteral("alpha.txt"))));
+    ASSERT_TRUE(writeFile(QStringLiteral("beta.txt"), QStringLiteral("Beta has been edited since the last run.\n")));
+    {
+        QFile gamma(tempDir.filePath(QStringLiteral("gamma.txt")));
+        ASSERT_TRUE(gamma.open(QIODevice::ReadWrite));
+        ASSERT_TRUE(gamma.setFileTime(QDateTime::currentDateTime().addSecs(60), QFileDevice::FileModificationTime));
+    }
+
+    const DataPacket third = indexer.execute(TokenList{ExecutionToken{}}).front().data;
+    ASSERT_FALSE(third.contains(QStringLiteral("__error")))
+        << third.value(QStringLiteral("__error")).toString().toStdString();
+    EXPECT_EQ(third.value(QStringLiteral("files_added")).toInt(), 0);
+    EXPECT_EQ(third.value(QStringLiteral("files_updated")).toInt(), 1);
+    EXPECT_EQ(third.value(QStringLiteral("files_unchanged")).toInt(), 1);
+    EXPECT_EQ(third.value(QStringLiteral("files_removed")).toInt(), 1);
+    EXPECT_EQ(backend->batches.load(), 4);
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), QStringLiteral("test_rag_incremental_db"));
+        db.setDatabaseName(dbPath);
+        ASSERT_TRUE(db.open());
+        QSqlQuery query(db);
+        ASSERT_TRUE(query.exec(QStringLiteral(
+            "SELECT s.file_path, s.last_modified, f.content FROM fragments f "
+            "JOIN source_files s ON s.id = f.file_id ORDER BY s.file_path")));
+        QStringList contents;
+        while (query.next()) {
+            const QFileInfo info(query.value(0).toString());
+            EXPECT_EQ(query.value(1).toLongLong(), info.lastModified().toMSecsSinceEpoch());
+            contents << query.value(2).toString().trimmed();
+        }
+        EXPECT_EQ(contents, (QStringList{QStringLiteral("Beta has been edited since the last run."),
+                                         QStringLiteral("Gamma is only touched.")}));
+        ASSERT_TRUE(query.exec(QStringLiteral("SELECT COUNT(*) FROM source_files")));
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(query.value(0).toInt(), 2);
+        // Queries read committed checkpoints while a later run writes
+        ASSERT_TRUE(query.exec(QStringLiteral("PRAGMA journal_mode")));
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(query.value(0).toString(), QStringLiteral("wal"));
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(QStringLiteral("test_rag_incremental_db"));
+
+    LLMProviderRegistry::instance().registerBackend(std::make_shared<OllamaBackend>());
+    EmbeddingCache::setSharedPath(EmbeddingCache::defaultPath());
+}
+
+/**
+ * @brief Paths and text arriving as tokens are indexed into the existing index one execution at a time
+ */
+TEST_F(RagIndexerNodeTest, IngestsDocumentsFromUpstreamTokens) {
+    auto backend = std::make_shared<PipelineEmbeddingBackend>();
+    LLMProviderRegistry::instance().registerBackend(backend);
+    EmbeddingCache::setSharedPath(QString());
+
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+    for (const QString& name : {QStringLiteral("first.txt"), QStringLiteral("second.txt"), QStringLiteral("skip.md")}) {
+        QFile file(tempDir.filePath(name));
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Text));
+        QTextStream(&file) << "Contents of " << name << "\n";
+    }
+
+    QTemporaryDir dbDir;
+    ASSERT_TRUE(dbDir.isValid());
+    const QString dbPath = dbDir.filePath(QStringLiteral("ingest.db"));
+
+    RagIndexerNode indexer;
+    indexer.setDatabasePath(dbPath);
+    indexer.setProviderId(QStringLiteral("ollama"));
+    indexer.setModelId(QStringLiteral("embed"));
+    indexer.setFileFilter(QStringLiteral("*.txt"));
+    indexer.setChunkSize(100);
+    indexer.setChunkOverlap(0);
+    indexer.setClearDatabase(true);
+
+    auto ingest = [&indexer](const QString& pin, const QVariant& value) {
+        ExecutionToken token;
+        token.data.insert(pin, value);
+        return indexer.execute(TokenList{token}).front().data;
+    };
+    auto indexedPaths = [&dbPath]() {
+        QStringList paths;
+        {
+            QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), QStringLiteral("test_rag_ingest_db"));
+            db.setDatabaseName(dbPath);
+            if (db.open()) {
+                QSqlQuery query(db);
+                if (query.exec(QStringLiteral("SELECT file_path FROM source_files ORDER BY id"))) {
+                    while (query.next()) {
+                        paths << query.value(0).toString();
+                    }
+                }
+                db.close();
+            }
+        }
+        QSqlDatabase::removeDatabase(QStringLiteral("test_rag_ingest_db"));
+        return paths;
+    };
+
+    // No directory is set: the first token alone is indexed and committed
+    const QString first = tempDir.filePath(QStringLiteral("first.txt"));
+    const DataPacket one = ingest(QString::fromLatin1(RagIndexerNode::kInputFilePath), first);
+    ASSERT_FALSE(one.contains(QStringLiteral("__error")))
+        << one.value(QStringLiteral("__error")).toString().toStdString();
+    EXPECT_EQ(one.value(QStringLiteral("files_added")).toInt(), 1);
+    EXPECT_FALSE(one.value(QStringLiteral("bulk_load")).toBool());
+    EXPECT_EQ(indexedPaths(), QStringList{first});
+
+    // A later list adds to it, through the file filter, and the clear setting is not applied per token
+    const DataPacket two = ingest(QString::fromLatin1(RagIndexerNode::kInputFilePath),
+                                  QStringList{first, tempDir.filePath(QStringLiteral("second.txt")),
+                                              tempDir.filePath(QStringLiteral("skip.md"))});
+    ASSERT_FALSE(two.contains(QStringLiteral("__error")));
+    EXPECT_EQ(two.value(QStringLiteral("files_added")).toInt(), 1);
+    EXPECT_EQ(two.value(QStringLiteral("files_unchanged")).toInt(), 1);
+    EXPECT_EQ(two.value(QStringLiteral("files_removed")).toInt(), 0);
+    EXPECT_EQ(backend->batches.load(), 2);
+
+    // Text without a path is named by its content, so sending it again embeds nothing
+    const QString ocr = QStringLiteral("Text recognised on a scanned page.");
+    const DataPacket three = ingest(QString::fromLatin1(RagIndexerNode::kInputText), ocr);
+    ASSERT_FALSE(three.contains(QStringLiteral("__error")));
+    EXPECT_EQ(three.value(QStringLiteral("files_added")).toInt(), 1);
+    const DataPacket again = ingest(QString::fromLatin1(RagIndexerNode::kInputText), ocr);
+    EXPECT_EQ(again.value(QStringLiteral("files_unchanged")).toInt(), 1);
+    EXPECT_EQ(backend->batches.load(), 3);
+
+    // A token with both names its text, and a new version replaces the old one
+    ExecutionToken named;
+    named.data.insert(QString::fromLatin1(RagIndexerNode::kInputFilePath), tempDir.filePath(QStringLiteral("page1.png")));
+    named.data.insert(QString::fromLatin1(RagIndexerNode::kInputText), QStringLiteral("First reading."));
+    EXPECT_EQ(indexer.execute(TokenList{named}).front().data.value(QStringLiteral("files_added")).toInt(), 1);
+    named.data.insert(QString::fromLatin1(RagIndexerNode::kInputText), QStringLiteral("Corrected reading."));
+    EXPECT_EQ(indexer.execute(TokenList{named}).front().data.value(QStringLiteral("files_updated")).toInt(), 1);
+
+    const QStringList paths = indexedPaths();
+    ASSERT_EQ(paths.size(), 4);
+    EXPECT_TRUE(paths.at(2).startsWith(QStringLiteral("text:")));
+    EXPECT_EQ(paths.at(3), QFileInfo(tempDir.filePath(QStringLiteral("page1.png"))).absoluteFilePath());
+
+    LLMProviderRegistry::instance().registerBackend(std::make_shared<OllamaBackend>());
+    EmbeddingCache::setSharedPath(EmbeddingCache::defaultPath());
+}
+
+/**
+ * @brief An empty database is bulk loaded, multi-row inserts included, and ends up with its indexes
+ */
+TEST_F(RagIndexerNodeTest, BulkLoadsAnEmptyIndexAndRebuildsItsIndexes) {
+    auto backend = std::make_shared<PipelineEmbeddingBackend>();
+    LLMProviderRegistry::instance().registerBackend(backend);
+    EmbeddingCache::setSharedPath(QString());
+
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+    {
+        QFile file(tempDir.filePath(QStringLiteral("long.txt")));
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Text));
+        QTextStream stream(&file);
+        for (int line = 0; line < 40; ++line) {
+            stream << "Line " << line << " of a file long enough for several chunks.\n";
+        }
+    }
+
+    QTemporaryDir dbDir;
+    ASSERT_TRUE(dbDir.isValid());
+    const QString dbPath = dbDir.filePath(QStringLiteral("bulk.db"));
+
+    RagIndexerNode indexer;
+    indexer.setDirectoryPath(tempDir.path());
+    indexer.setDatabasePath(dbPath);
+    indexer.setProviderId(QStringLiteral("ollama"));
+    indexer.setModelId(QStringLiteral("embed"));
+    indexer.setChunkSize(200);
+    indexer.setChunkOverlap(0);
+
+    const DataPacket first = indexer.execute(TokenList{ExecutionToken{}}).front().data;
+    ASSERT_FALSE(first.contains(QStringLiteral("__error")))
+        << first.value(QStringLiteral("__error")).toString().toStdString();
+    EXPECT_TRUE(first.value(QStringLiteral("bulk_load")).toBool());
+    const int chunks = first.value(QString::fromLatin1(RagIndexerNode::kOutputCount)).toInt();
+    EXPECT_GT(chunks, 1);
+    EXPECT_EQ(first.value(QStringLiteral("database_insert_failures")).toInt(), 0);
+
+    const DataPacket second = indexer.execute(TokenList{ExecutionToken{}}).front().data;
+    EXPECT_FALSE(second.value(QStringLiteral("bulk_load")).toBool());
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), QStringLiteral("test_rag_bulk_db"));
+        db.setDatabaseName(dbPath);
+        ASSERT_TRUE(db.open());
+        QSqlQuery query(db);
+        ASSERT_TRUE(query.exec(QStringLiteral("SELECT chunk_index FROM fragments ORDER BY id")));
+        int expected = 0;
+        while (query.next()) {
+            EXPECT_EQ(query.value(0).toInt(), expected++);
+        }
+        EXPECT_EQ(expected, chunks);
+        for (const char* name : kRagSchemaSecondaryIndexNames) {
+            query.prepare(QStringLiteral("SELECT 1 FROM sqlite_master WHERE type = 'index' AND name = ?"));
+            query.addBindValue(QString::fromLatin1(name));
+            ASSERT_TRUE(query.exec());
+            EXPECT_TRUE(query.next()) << name;
+        }
+        ASSERT_TRUE(query.exec(QStringLiteral("SELECT COUNT(*) FROM fragments_fts WHERE fragments_fts MATCH 'chunks'")));
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(query.value(0).toInt(), chunks);
+        query = QSqlQuery();
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(QStringLiteral("test_rag_bulk_db"));
+
+    LLMProviderRegistry::instance().registerBackend(std::make_shared<OllamaBackend>());
+    EmbeddingCache::setSharedPath(EmbeddingCache::defaultPath());
+}
+
+/**
+ * @brief Chunks repeated across files are embedded once, and survive the removal of the file that owns them
+ */
+TEST_F(RagIndexerNodeTest, RepeatedChunksShareOneFragment) {
+    auto backend = std::make_shared<PipelineEmbeddingBackend>();
+    LLMProviderRegistry::instance().registerBackend(backend);
+    EmbeddingCache::setSharedPath(QString());
+
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+    auto writeFile = [&tempDir](const QString& name, const QString& text) {
+        QFile file(tempDir.filePath(name));
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Text));
+        file.write(text.toUtf8());
+    };
+    QString licence;
+    for (int line = 0; line < 12; ++line) {
+        licence += QStringLiteral("Licence line %1 that every vendored copy repeats word for word.\n").arg(line);
+    }
+    writeFile(QStringLiteral("first.txt"), licence);
+    writeFile(QStringLiteral("second.txt"), licence);
+    writeFile(QStringLiteral("own.txt"), QStringLiteral("Text that only this file has, in one short chunk.\n"));
+
+    QTemporaryDir dbDir;
+    ASSERT_TRUE(dbDir.isValid());
+    const QString dbPath = dbDir.filePath(QStringLiteral("dedup.db"));
+
+    RagIndexerNode indexer;
+    EXPECT_EQ(indexer.deduplication(), QString::fromLatin1(RagIndexerNode::kDeduplicationExact));
+    indexer.setDirectoryPath(tempDir.path());
+    indexer.setDatabasePath(dbPath);
+    indexer.setProviderId(QStringLiteral("ollama"));
+    indexer.setModelId(QStringLiteral("embed"));
+    indexer.setChunkSize(200);
+    indexer.setChunkOverlap(0);
+
+    const DataPacket first = indexer.execute(TokenList{ExecutionToken{}}).front().data;
+    ASSERT_FALSE(first.contains(QStringLiteral("__error")))
+        << first.value(QStringLiteral("__error")).toString().toStdString();
+    EXPECT_EQ(first.value(QStringLiteral("database_insert_failures")).toInt(), 0);
+    const int duplicates = first.value(QStringLiteral("duplicate_chunks")).toInt();
+    EXPECT_GT(duplicates, 1);
+    EXPECT_EQ(first.value(QString::fromLatin1(RagIndexerNode::kOutputCount)).toInt(), duplicates + 1);
+    EXPECT_EQ(backend->embeddedTexts.load(), duplicates + 1);
+
+    const QString connectionName = QStringLiteral("test_rag_dedup_db");
+    QString ownerPath;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+        db.setDatabaseName(dbPath);
+        ASSERT_TRUE(db.open());
+        QSqlQuery query(db);
+        ASSERT_TRUE(query.exec(QStringLiteral("SELECT COUNT(*) FROM fragment_sources")));
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(query.value(0).toInt(), duplicates);
+        ASSERT_TRUE(query.exec(QStringLiteral(
+            "SELECT DISTINCT s.file_path FROM fragments f JOIN source_files s ON s.id = f.file_id "
+            "WHERE f.content LIKE '%vendored copy%'")));
+        ASSERT_TRUE(query.next());
+        ownerPath = query.value(0).toString();
+        EXPECT_FALSE(query.next());
+        query = QSqlQuery();
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+
+    // The other copy takes over the fragments without embedding anything again
+    ASSERT_TRUE(QFile::remove(ownerPath));
+    const DataPacket second = indexer.execute(TokenList{ExecutionToken{}}).front().data;
+    EXPECT_EQ(second.value(QStringLiteral("files_removed")).toInt(), 1);
+    EXPECT_EQ(backend->embeddedTexts.load(), duplicates + 1);
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+        db.setDatabaseName(dbPath);
+        ASSERT_TRUE(db.open());
+        QSqlQuery query(db);
+        ASSERT_TRUE(query.exec(QStringLiteral("SELECT COUNT(*) FROM fragment_sources")));
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(query.value(0).toInt(), 0);
+        ASSERT_TRUE(query.exec(QStringLiteral(
+            "SELECT COUNT(*), MIN(s.file_path) FROM fragments f JOIN source_files s ON s.id = f.file_id "
+            "WHERE f.content LIKE '%vendored copy%'")));
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(query.value(0).toInt(), duplicates);
+        EXPECT_NE(query.value(1).toString(), ownerPath);
+        query = QSqlQuery();
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+
+    LLMProviderRegistry::instance().registerBackend(std::make_shared<OllamaBackend>());
+    EmbeddingCache::setSharedPath(EmbeddingCache::defaultPath());
+}
+
+/**
+ * @brief A stopped run keeps its checkpoints, and the next run resumes instead of clearing
+ */
+TEST_F(RagIndexerNodeTest, CheckpointedRunResumesAfterCancellation) {
+    // Cancels the run once a few batches have been embedded
+    class CancellingBackend : public PipelineEmbeddingBackend {
+    public:
+        EmbeddingBatchResult getEmbeddings(const QString& key, const QString& model, const QStringList& texts) override {
+            EmbeddingBatchResult result = PipelineEmbeddingBackend::getEmbeddings(key, model, texts);
+            if (cancelAfter > 0 && batches.load() >= cancelAfter) {
+                token.cancel();
+            }
+            return result;
+        }
+        CancellationToken token;
+        int cancelAfter {0};
+    };
+    auto backend = std::make_shared<CancellingBackend>();
+    LLMProviderRegistry::instance().registerBackend(backend);
+    EmbeddingCache::setSharedPath(QString());
+
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+    const int fileCount = 8;
+    for (int f = 0; f < fileCount; ++f) {
+        QFile file(tempDir.path() + QStringLiteral("/doc%1.txt").arg(f));
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Text));
+        QTextStream(&file) << "Document " << f << " survives a stopped run once it is checkpointed.\n";
+    }
+
+    QTemporaryDir dbDir;
+    ASSERT_TRUE(dbDir.isValid());
+    const QString dbPath = dbDir.filePath(QStringLiteral("resume.db"));
+
+    RagIndexerNode indexer;
+    indexer.setDirectoryPath(tempDir.path());
+    indexer.setDatabasePath(dbPath);
+    indexer.setProviderId(QStringLiteral("ollama"));
+    indexer.setModelId(QStringLiteral("embed"));
+    indexer.setChunkSize(100);
+    indexer.setChunkOverlap(0);
+    indexer.setEmbeddingConcurrency(1);
+    indexer.setCheckpointFiles(1);
+    indexer.setClearDatabase(true);
+
+    backend->token = CancellationToken::create();
+    backend->cancelAfter = 3;
+    DataPacket stopped;
+    {
+        const CancellationToken::Scope scope(backend->token);
+        stopped = indexer.execute(TokenList{ExecutionToken{}}).front().data;
+    }
+    EXPECT_TRUE(stopped.contains(QStringLiteral("__error")));
+    EXPECT_FALSE(stopped.value(QStringLiteral("resumed")).toBool());
+    const int checkpointed = stopped.value(QStringLiteral("files_added")).toInt();
+    EXPECT_GE(checkpointed, 1);
+    EXPECT_LT(checkpointed, fileCount);
+    EXPECT_GE(stopped.value(QStringLiteral("checkpoints")).toInt(), 1);
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), QStringLiteral("test_rag_resume_db"));
+        db.setDatabaseName(dbPath);
+        ASSERT_TRUE(db.open());
+        QSqlQuery query(db);
+        ASSERT_TRUE(query.exec(QStringLiteral("SELECT COUNT(*) FROM source_files WHERE content_hash IS NOT NULL")));
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(query.value(0).toInt(), checkpointed);
+        ASSERT_TRUE(query.exec(QStringLiteral("SELECT state FROM index_jobs")));
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(query.value(0).toString(), QStringLiteral("cancelled"));
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(QStringLiteral("test_rag_resume_db"));
+
+    // Clearing is still ticked, but the interrupted run is picked up instead
+    backend->cancelAfter = 0;
+    const int batchesBefore = backend->batches.load();
+    const DataPacket resumed = indexer.execute(TokenList{ExecutionToken{}}).front().data;
+    ASSERT_FALSE(resumed.contains(QStringLiteral("__error")))
+        << resumed.value(QStringLiteral("__error")).toString().toStdString();
+    EXPECT_TRUE(resumed.value(QStringLiteral("resumed")).toBool());
+    EXPECT_EQ(resumed.value(QStringLiteral("files_unchanged")).toInt(), checkpointed);
+    EXPECT_EQ(resumed.value(QStringLiteral("files_added")).toInt(), fileCount - checkpointed);
+    EXPECT_EQ(backend->batches.load() - batchesBefore, fileCount - checkpointed);
+
+    // The finished run no longer counts as interrupted, so this one clears
+    const DataPacket cleared = indexer.execute(TokenList{ExecutionToken{}}).front().data;
+    EXPECT_FALSE(cleared.value(QStringLiteral("resumed")).toBool());
+    EXPECT_EQ(cleared.value(QStringLiteral("files_added")).toInt(), fileCount);
+
+    LLMProviderRegistry::instance().registerBackend(std::make_shared<OllamaBackend>());
+    EmbeddingCache::setSharedPath(EmbeddingCache::defaultPath());
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "retrieval/storage/RagQueryCache.h"
+
+namespace {
+
+std::vector<RagUtils::SearchResult> resultsFor(const QString& content)
+{
+    RagUtils::SearchResult result;
+    result.fragmentId = 1;
+    result.content = content;
+    result.score = 0.9;
+    return {result};
+}
+
+QByteArray keyFor(const QString& dbPath, const QString& query, const RagSearchOptions& options = {})
+{
+    return RagQueryCache::makeKey(dbPath, QStringLiteral("openai"), QStringLiteral("m"), query, 5, 0.2, options);
+}
+
+} // namespace
+
+TEST(RagQueryCacheTest, KeysCoverEverythingASearchDependsOn)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString dbPath = dir.filePath(QStringLiteral("rag.db"));
+
+    const QByteArray key = keyFor(dbPath, QStringLiteral("what is rag?"));
+    EXPECT_EQ(keyFor(dbPath, QStringLiteral("  what is rag?\n")), key);
+    EXPECT_NE(keyFor(dbPath, QStringLiteral("what is hnsw?")), key);
+    EXPECT_NE(RagQueryCache::makeKey(dbPath, QStringLiteral("openai"), QStringLiteral("other"),
+                                     QStringLiteral("what is rag?"), 5, 0.2, {}),
+              key);
+    EXPECT_NE(RagQueryCache::makeKey(dbPath, QStringLiteral("openai"), QStringLiteral("m"),
+                                     QStringLiteral("what is rag?"), 6, 0.2, {}),
+              key);
+
+    RagSearchOptions filtered;
+    filtered.filter = RagUtils::parseSearchFilter(QStringLiteral("type:cpp"));
+    EXPECT_NE(keyFor(dbPath, QStringLiteral("what is rag?"), filtered), key);
+    RagSearchOptions hybrid;
+    hybrid.mode = RagSearchMode::Hybrid;
+    EXPECT_NE(keyFor(dbPath, QStringLiteral("what is rag?"), hybrid), key);
+    RagSearchOptions moreThreads;
+    moreThreads.threads = 8;
+    EXPECT_EQ(keyFor(dbPath, QStringLiteral("what is rag?"), moreThreads), key);
+
+    // A commit by the indexer, or a write by anyone else, changes the key
+    RagQueryCache::bumpGeneration(dbPath);
+    const QByteArray bumped = keyFor(dbPath, QStringLiteral("what is rag?"));
+    EXPECT_NE(bumped, key);
+    QFile file(dbPath);
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    file.write("changed");
+    file.close();
+    EXPECT_NE(keyFor(dbPath, QStringLiteral("what is rag?")), bumped);
+}
+
+TEST(RagQueryCacheTest, EvictsLeastRecentlyUsedResults)
+{
+    RagQueryCache cache(2);
+    std::vector<RagUtils::SearchResult> found;
+    EXPECT_FALSE(cache.lookup(QByteArrayLiteral("a"), found));
+
+    cache.insert(QByteArrayLiteral("a"), resultsFor(QStringLiteral("alpha")));
+    cache.insert(QByteArrayLiteral("b"), resultsFor(QStringLiteral("beta")));
+    ASSERT_TRUE(cache.lookup(QByteArrayLiteral("a"), found));
+    ASSERT_EQ(found.size(), 1u);
+    EXPECT_EQ(found.front().content, QStringLiteral("alpha"));
+
+    // "b" is now the least recently used entry
+    cache.insert(QByteArrayLiteral("c"), resultsFor(QStringLiteral("gamma")));
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_FALSE(cache.lookup(QByteArrayLiteral("b"), found));
+    EXPECT_TRUE(cache.lookup(QByteArrayLiteral("c"), found));
+    EXPECT_EQ(cache.hits(), 2);
+    EXPECT_EQ(cache.misses(), 2);
+
+    cache.clear();
+    EXPECT_EQ(cache.size(), 0);
+}
@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+
+#include <QDir>
+#include <QEventLoop>
+#include <QTemporaryDir>
+#include <QTimer>
+
+#include "test_app.h"
+#include <QtNodes/internal/Definitions.hpp>
+
+#include "BlobHandle.h"
+#include "ExecutionEngine.h"
+#include "ExecutionIdUtils.h"
+#include "MetricsRegistry.h"
+#include "NodeGraphModel.h"
+#include "PromptBuilderNode.h"
+#include "RemoteProtocol.h"
+#include "RemoteWorkerPool.h"
+#include "RemoteWorkerServer.h"
+#include "SharedBlobStore.h"
+#include "TextInputNode.h"
+#include "ToolNodeDelegate.h"
+
+using namespace QtNodes;
+
+TEST(RemoteProtocolTest, RoundTripsFramesAndRejectsMalformedOnes)
+{
+    RemoteProtocol::Message execute;
+    execute.type = RemoteProtocol::MessageType::Execute;
+    execute.callId = 42;
+    execute.nodeType = QStringLiteral("prompt-builder");
+    execute.state = R"({"template":"Hi {input}"})";
+    ExecutionToken token;
+    token.connectionId = QUuid::createUuid();
+    token.triggeringPinId = QStringLiteral("input");
+    token.data.insert(QStringLiteral("input"), QStringLiteral("Ann"));
+    token.forceExecution = true;
+    execute.tokens.push_back(token);
+
+    RemoteProtocol::Message hello;
+    hello.type = RemoteProtocol::MessageType::Hello;
+    hello.capacity = 3;
+    hello.nodeTypes = {QStringLiteral("universal-llm")};
+
+    const QByteArray frames = RemoteProtocol::encode(execute) + RemoteProtocol::encode(hello);
+    QByteArray buffer = frames.left(5);
+    RemoteProtocol::Message decoded;
+    EXPECT_EQ(RemoteProtocol::takeFrame(buffer, decoded), RemoteProtocol::DecodeResult::Incomplete);
+
+    buffer = frames;
+    ASSERT_EQ(RemoteProtocol::takeFrame(buffer, decoded), RemoteProtocol::DecodeResult::Decoded);
+    EXPECT_EQ(decoded.type, RemoteProtocol::MessageType::Execute);
+    EXPECT_EQ(decoded.callId, 42u);
+    EXPECT_EQ(decoded.nodeType, execute.nodeType);
+    EXPECT_EQ(decoded.state, execute.state);
+    ASSERT_EQ(decoded.tokens.size(), 1u);
+    EXPECT_EQ(decoded.tokens.front().connectionId, token.connectionId);
+    EXPECT_EQ(decoded.tokens.front().triggeringPinId, token.triggeringPinId);
+    EXPECT_EQ(decoded.tokens.front().data.value(QStringLiteral("input")).toString(), QStringLiteral("Ann"));
+    EXPECT_TRUE(decoded.tokens.front().forceExecution);
+
+    ASSERT_EQ(RemoteProtocol::takeFrame(buffer, decoded), RemoteProtocol::DecodeResult::Decoded);
+    EXPECT_EQ(decoded.type, RemoteProtocol::MessageType::Hello);
+    EXPECT_EQ(decoded.capacity, 3);
+    EXPECT_EQ(decoded.nodeTypes, hello.nodeTypes);
+    EXPECT_TRUE(buffer.isEmpty());
+
+    QByteArray garbage = QByteArray::fromHex("0000000800000000deadbeef");
+    EXPECT_EQ(RemoteProtocol::takeFrame(garbage, decoded), RemoteProtocol::DecodeResult::Malformed);
+    QByteArray oversized = QByteArray::fromHex("7fffffff");
+    EXPECT_EQ(RemoteProtocol::takeFrame(oversized, decoded), RemoteProtocol::DecodeResult::Malformed);
+}
+
+TEST(SharedBlobStoreTest, OffloadsLargeBlobsOnceAndRestoresThem)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const SharedBlobStore store(dir.path(), 8);
+
+    const BlobHandle large = BlobHandle::fromBytes(QByteArray(64, 'x'), QStringLiteral("image/png"));
+    QVariantMap packet;
+    packet.insert(QStringLiteral("image"), QVariant::fromValue(large));
+    packet.insert(QStringLiteral("pages"), QVariantList{QVariant::fromValue(large)});
+    packet.insert(QStringLiteral("small"), QVariant::fromValue(BlobHandle::fromBytes("tiny")));
+
+    const QVariantMap offloaded = store.offload(packet);
+    const QVariantMap reference = offloaded.value(QStringLiteral("image")).toMap();
+    EXPECT_TRUE(reference.contains(QString::fromLatin1(SharedBlobStore::kReferenceKey)));
+    EXPECT_TRUE(offloaded.value(QStringLiteral("small")).canConvert<BlobHandle>());
+    EXPECT_EQ(QDir(dir.path()).entryList(QDir::Files).size(), 1);
+
+    const QVariantMap restored = store.restore(offloaded);
+    const BlobHandle image = restored.value(QStringLiteral("image")).value<BlobHandle>();
+    EXPECT_EQ(image, large);
+    EXPECT_EQ(image.mimeType(), QStringLiteral("image/png"));
+    EXPECT_EQ(restored.value(QStringLiteral("pages")).toList().value(0).value<BlobHandle>(), large);
+
+    // References may not leave the store directory
+    QVariantMap escaping;
+    escaping.insert(QStringLiteral("image"),
+                    QVariantMap{{QString::fromLatin1(SharedBlobStore::kReferenceKey), QStringLiteral("../secret")}});
+    EXPECT_FALSE(store.restore(escaping).value(QStringLiteral("image")).canConvert<BlobHandle>());
+}
+
+TEST(RemoteWorkersTest, ParsesWorkerOptionsAndEndpoints)
+{
+    RemoteWorkerServer::Options options;
+    EXPECT_TRUE(RemoteWorkerServer::parseArguments(
+        {QStringLiteral("--worker"), QStringLiteral("0.0.0.0:7000"), QStringLiteral("--capacity"), QStringLiteral("4"),
+         QStringLiteral("--node-types"), QStringLiteral("universal-llm, python-script")},
+        options).isEmpty());
+    EXPECT_EQ(options.port, 7000);
+    EXPECT_EQ(options.address, QHostAddress(QStringLiteral("0.0.0.0")));
+    EXPECT_EQ(options.capacity, 4);
+    EXPECT_EQ(options.nodeTypes, (QStringList{QStringLiteral("universal-llm"), QStringLiteral("python-script")}));
+
+    RemoteWorkerServer::Options rejected;
+    EXPECT_FALSE(RemoteWorkerServer::parseArguments({QStringLiteral("--capacity"), QStringLiteral("2")},
+                                                    rejected).isEmpty());
+    EXPECT_FALSE(RemoteWorkerServer::parseArguments(
+        {QStringLiteral("--worker"), QStringLiteral("7000"), QStringLiteral("--capacity"), QStringLiteral("0")},
+        rejected).isEmpty());
+
+    QList<RemoteWorkerPool::Endpoint> endpoints;
+    ASSERT_TRUE(RemoteWorkerPool::Config::parseEndpoints(QStringLiteral("gpu-1:7000, [::1]:7001"), endpoints));
+    ASSERT_EQ(endpoints.size(), 2);
+    EXPECT_EQ(endpoints.at(0).host, QStringLiteral("gpu-1"));
+    EXPECT_EQ(endpoints.at(1).host, QStringLiteral("::1"));
+    EXPECT_EQ(endpoints.at(1).port, 7001);
+    endpoints.clear();
+    EXPECT_FALSE(RemoteWorkerPool::Config::parseEndpoints(QStringLiteral("gpu-1"), endpoints));
+}
+
+TEST(RemoteWorkersTest, RunsDesignatedNodesOnAWorker)
+{
+    sharedTestApp();
+
+    RemoteWorkerServer::Options workerOptions;
+    workerOptions.capacity = 2;
+    workerOptions.nodeTypes = {QStringLiteral("prompt-builder")};
+    RemoteWorkerServer worker(workerOptions);
+    ASSERT_TRUE(worker.start());
+    ASSERT_NE(worker.serverPort(), 0);
+
+    RemoteWorkerPool::Config config;
+    config.workers = {RemoteWorkerPool::Endpoint{QStringLiteral("127.0.0.1"), worker.serverPort()}};
+    config.nodeTypes = {QStringLiteral("prompt-builder")};
+    auto pool = std::make_shared<RemoteWorkerPool>(config);
+    pool->start();
+
+    // The worker answers from this thread's event loop
+    QEventLoop greeting;
+    QObject::connect(pool.get(), &RemoteWorkerPool::capacityChanged, &greeting, &QEventLoop::quit,
+                     Qt::QueuedConnection);
+    QTimer::singleShot(5000, &greeting, &QEventLoop::quit);
+    if (!pool->handles(QStringLiteral("prompt-builder"))) greeting.exec();
+    ASSERT_TRUE(pool->handles(QStringLiteral("prompt-builder")));
+    EXPECT_FALSE(pool->handles(QStringLiteral("text-input")));
+    EXPECT_EQ(pool->capacity(), 2);
+
+    NodeGraphModel model;
+    const NodeId textNodeId = model.addNode(QStringLiteral("text-input"));
+    const NodeId promptNodeId = model.addNode(QStringLiteral("prompt-builder"));
+    model.addConnection(ConnectionId{ textNodeId, 0u, promptNodeId, 0u });
+    auto* promptTool = dynamic_cast<PromptBuilderNode*>(model.delegateModel<ToolNodeDelegate>(promptNodeId)->node().get());
+    ASSERT_NE(promptTool, nullptr);
+    promptTool->setTemplateText(QStringLiteral("Hello {input}!"));
+
+    ExecutionEngine engine(&model);
+    engine.setRemoteWorkers(pool);
+    const QUuid textUuid = ExecIds::nodeUuid(model.executionScopeKey(), textNodeId);
+    QHash<QUuid, QVariantMap> presets;
+    presets[textUuid].insert(QString::fromLatin1(TextInputNode::kOutputId), QStringLiteral("Ann"));
+
+    QEventLoop loop;
+    DataPacket output;
+    bool succeeded = false;
+    QObject::connect(&engine, &ExecutionEngine::runFinished, &loop,
+                     [&](const QUuid&, const DataPacket& packet, bool ok) {
+                         output = packet;
+                         succeeded = ok;
+                         loop.quit();
+                     });
+    QTimer::singleShot(10000, &loop, &QEventLoop::quit);
+    engine.startIndependentRun(presets);
+    loop.exec();
+
+    EXPECT_TRUE(succeeded);
+    EXPECT_EQ(output.value(QStringLiteral("prompt")).toString(), QStringLiteral("Hello Ann!"));
+    const auto& remoteCalls =
+        MetricsRegistry::instance().counter(QStringLiteral("cp_remote_calls"), QString(),
+                                            {{QStringLiteral("worker"), config.workers.first().toString()},
+                                             {QStringLiteral("outcome"), QStringLiteral("ok")}});
+    EXPECT_EQ(remoteCalls.value(), 1u);
+}
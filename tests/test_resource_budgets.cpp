@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include <QEventLoop>
+#include <QJsonObject>
+#include <QTimer>
+
+#include "test_app.h"
+#include <QtNodes/internal/Definitions.hpp>
+#include "ExecutionEngine.h"
+#include "NodeGraphModel.h"
+#include "ResourceBudgets.h"
+#include "ToolNodeDelegate.h"
+
+using namespace QtNodes;
+
+TEST(ResourceBudgetsTest, MissingOrInvalidKeysKeepDefaults)
+{
+    QJsonObject json;
+    json.insert(QStringLiteral("network"), 128);
+    json.insert(QStringLiteral("cpu"), 0);
+    json.insert(QStringLiteral("process"), QStringLiteral("many"));
+
+    const ResourceBudgets budgets = ResourceBudgets::fromJson(json);
+    EXPECT_EQ(budgets.limit(ResourceClass::Network), 128);
+    EXPECT_EQ(budgets.limit(ResourceClass::Cpu), ResourceBudgets::defaultLimit(ResourceClass::Cpu));
+    EXPECT_EQ(budgets.limit(ResourceClass::Process), ResourceBudgets::defaultLimit(ResourceClass::Process));
+    EXPECT_EQ(budgets.limit(ResourceClass::GuiAffine), 1);
+}
+
+TEST(ResourceBudgetsTest, JsonRoundTripWritesOnlyOverrides)
+{
+    ResourceBudgets budgets;
+    EXPECT_TRUE(budgets.toJson().isEmpty());
+
+    budgets.setLimit(ResourceClass::Cpu, 2);
+    budgets.setLimit(ResourceClass::Network, 100000);
+    const QJsonObject json = budgets.toJson();
+    EXPECT_EQ(json.value(QStringLiteral("cpu")).toInt(), 2);
+    EXPECT_EQ(json.value(QStringLiteral("network")).toInt(), 1024); // clamped
+    EXPECT_FALSE(json.contains(QStringLiteral("gui")));
+
+    EXPECT_EQ(ResourceBudgets::fromJson(json), budgets);
+}
+
+TEST(ResourceBudgetsTest, ProjectBudgetsPersistAndApplyOnRun)
+{
+    sharedTestApp();
+
+    NodeGraphModel model;
+    NodeId textNodeId = model.addNode(QStringLiteral("text-input"));
+    ASSERT_NE(textNodeId, InvalidNodeId);
+
+    QJsonObject overrides;
+    overrides.insert(QStringLiteral("cpu"), 1);
+    overrides.insert(QStringLiteral("network"), 64);
+    model.setResourceBudgets(overrides);
+
+    NodeGraphModel reloaded;
+    reloaded.load(model.save());
+    EXPECT_EQ(reloaded.resourceBudgets(), overrides);
+
+    ExecutionEngine engine(&reloaded);
+    bool finished = false;
+    QEventLoop loop;
+    QObject::connect(&engine, &ExecutionEngine::pipelineFinished, &loop, [&](const DataPacket&) {
+        finished = true;
+        loop.quit();
+    });
+    QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+    engine.Run();
+    if (!finished) loop.exec();
+
+    ASSERT_TRUE(finished) << "Engine did not finish within timeout";
+    EXPECT_EQ(engine.resourceBudgets().limit(ResourceClass::Cpu), 1);
+    EXPECT_EQ(engine.resourceBudgets().limit(ResourceClass::Network), 64);
+}
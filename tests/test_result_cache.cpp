@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+
+#include <QDateTime>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTimer>
+
+#include "test_app.h"
+#include <QtNodes/internal/Definitions.hpp>
+#include "ExecutionEngine.h"
+#include "NodeGraphModel.h"
+#include "ResultCache.h"
+#include "TextInputNode.h"
+#include "ToolNodeDelegate.h"
+
+using namespace QtNodes;
+
+namespace {
+
+TokenList tokensWith(const QString& key, const QVariant& value)
+{
+    ExecutionToken token;
+    token.data.insert(key, value);
+    return TokenList{token};
+}
+
+QStringList runAndCollectLogs(ExecutionEngine& engine)
+{
+    QStringList messages;
+    auto logConn = QObject::connect(&engine, &ExecutionEngine::nodeLog, &engine, [&messages](const QString& msg) {
+        messages << msg;
+    });
+
+    bool finished = false;
+    QEventLoop loop;
+    auto doneConn = QObject::connect(&engine, &ExecutionEngine::pipelineFinished, &loop, [&](const DataPacket&) {
+        finished = true;
+        loop.quit();
+    });
+    QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+
+    engine.Run();
+    if (!finished) loop.exec();
+
+    QObject::disconnect(logConn);
+    QObject::disconnect(doneConn);
+    EXPECT_TRUE(finished) << "Engine did not finish within timeout";
+    return messages;
+}
+
+} // namespace
+
+TEST(ResultCacheTest, StoresAndReplaysTokens)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    ResultCache cache(dir.path());
+
+    QJsonObject config;
+    config.insert(QStringLiteral("chunk_size"), 100);
+    const QString key = ResultCache::makeKey(QStringLiteral("text-chunker"), config,
+                                             tokensWith(QStringLiteral("text"), QStringLiteral("abc")));
+    ASSERT_FALSE(key.isEmpty());
+    EXPECT_FALSE(cache.lookup(key).has_value());
+
+    TokenList outputs = tokensWith(QStringLiteral("chunks"), QStringList{QStringLiteral("a"), QStringLiteral("b")});
+    outputs.front().data.insert(QStringLiteral("count"), 2);
+    ASSERT_TRUE(cache.store(key, outputs));
+
+    const auto replayed = cache.lookup(key);
+    ASSERT_TRUE(replayed.has_value());
+    ASSERT_EQ(replayed->size(), 1u);
+    EXPECT_EQ(replayed->front().data, outputs.front().data);
+}
+
+TEST(ResultCacheTest, KeyCoversTypeConfigAndInputs)
+{
+    QJsonObject config;
+    config.insert(QStringLiteral("chunk_size"), 100);
+    const TokenList inputs = tokensWith(QStringLiteral("text"), QStringLiteral("abc"));
+    const QString key = ResultCache::makeKey(QStringLiteral("text-chunker"), config, inputs);
+
+    EXPECT_NE(key, ResultCache::makeKey(QStringLiteral("prompt-builder"), config, inputs));
+
+    QJsonObject otherConfig = config;
+    otherConfig.insert(QStringLiteral("chunk_size"), 200);
+    EXPECT_NE(key, ResultCache::makeKey(QStringLiteral("text-chunker"), otherConfig, inputs));
+
+    EXPECT_NE(key, ResultCache::makeKey(QStringLiteral("text-chunker"), config,
+                                        tokensWith(QStringLiteral("text"), QStringLiteral("abd"))));
+
+    // Run-specific system keys don't change the key
+    TokenList withSys = inputs;
+    withSys.push_back(ExecutionToken{});
+    withSys.back().data.insert(QStringLiteral("_sys_node_output_dir"), QStringLiteral("/tmp/Run_7"));
+    EXPECT_EQ(key, ResultCache::makeKey(QStringLiteral("text-chunker"), config, withSys));
+}
+
+TEST(ResultCacheTest, PrunesLeastRecentlyUsedEntriesOverBudget)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    ResultCache cache(dir.path(), 4096);
+    const TokenList outputs = tokensWith(QStringLiteral("text"), QString(500, QLatin1Char('x')));
+
+    QStringList keys;
+    const QDateTime base = QDateTime::currentDateTime().addSecs(-100);
+    for (int i = 0; i < 3; ++i) {
+        keys << ResultCache::makeKey(QStringLiteral("text-chunker"), QJsonObject{},
+                                     tokensWith(QStringLiteral("text"), QString::number(i)));
+        ASSERT_TRUE(cache.store(keys.last(), outputs));
+        QFile entry(dir.path() + QLatin1Char('/') + keys.last().left(2) + QLatin1Char('/') + keys.last()
+                    + QStringLiteral(".bin"));
+        ASSERT_TRUE(entry.open(QIODevice::ReadWrite));
+        entry.setFileTime(base.addSecs(i), QFileDevice::FileModificationTime);
+    }
+    // A hit makes the oldest entry the most recently used
+    ASSERT_TRUE(cache.lookup(keys[0]).has_value());
+
+    keys << ResultCache::makeKey(QStringLiteral("text-chunker"), QJsonObject{},
+                                 tokensWith(QStringLiteral("text"), QStringLiteral("3")));
+    ASSERT_TRUE(cache.store(keys.last(), outputs));
+
+    EXPECT_LE(cache.sizeBytes(), 4096);
+    EXPECT_TRUE(cache.lookup(keys[0]).has_value());
+    EXPECT_FALSE(cache.lookup(keys[1]).has_value());
+    EXPECT_TRUE(cache.lookup(keys[3]).has_value());
+}
+
+TEST(ResultCacheTest, ErrorResultsAreNotStored)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    ResultCache cache(dir.path());
+
+    const QString key = ResultCache::makeKey(QStringLiteral("universal-llm"), QJsonObject{},
+                                             tokensWith(QStringLiteral("prompt"), QStringLiteral("hi")));
+    EXPECT_FALSE(cache.store(key, tokensWith(QStringLiteral("__error"), QStringLiteral("HTTP 503"))));
+    EXPECT_FALSE(cache.lookup(key).has_value());
+}
+
+TEST(ResultCacheTest, EngineReplaysCacheableNodeOnSecondRun)
+{
+    sharedTestApp();
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+
+    NodeGraphModel model;
+    NodeId textNodeId = model.addNode(QStringLiteral("text-input"));
+    NodeId chunkerNodeId = model.addNode(QStringLiteral("text-chunker"));
+    ASSERT_NE(textNodeId, InvalidNodeId);
+    ASSERT_NE(chunkerNodeId, InvalidNodeId);
+    model.addConnection(ConnectionId{ textNodeId, 0u, chunkerNodeId, 0u });
+
+    auto* textTool = dynamic_cast<TextInputNode*>(model.delegateModel<ToolNodeDelegate>(textNodeId)->node().get());
+    ASSERT_NE(textTool, nullptr);
+    textTool->setText(QStringLiteral("Some text to split into chunks."));
+
+    ExecutionEngine engine(&model);
+    engine.setResultCacheEnabled(true, dir.path());
+
+    const QStringList first = runAndCollectLogs(engine);
+    EXPECT_FALSE(first.join(QLatin1Char('\n')).contains(QLatin1String("Node Cached:")));
+
+    const QStringList second = runAndCollectLogs(engine);
+    EXPECT_TRUE(second.join(QLatin1Char('\n')).contains(QLatin1String("Node Cached:")));
+}
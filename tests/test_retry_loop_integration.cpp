@@ -40,7 +40,6 @@ public:
         return desc;
     }
 
-    QWidget* createConfigurationWidget(QWidget*) override { return nullptr; }
 
     TokenList execute(const TokenList& incomingTokens) override {
         // We increment execution count only when we actually process an input
@@ -132,3 +132,23 @@ TEST_F(RetryLoopNodeTest, IsReadyLogic) {
     inputs[QString::fromLatin1(RetryLoopNode::kInputWorkerFeedbackId)] = "result";
     EXPECT_TRUE(node.isReady(inputs, 2));
 }
+
+TEST_F(RetryLoopNodeTest, RetriesShareTheTaskConversation) {
+    const QString conversationKey = QString::fromLatin1(RetryLoopNode::kOutputConversationId);
+    const auto send = [this](const char* pin, const QString& value) {
+        ExecutionToken t;
+        t.triggeringPinId = QString::fromLatin1(pin);
+        t.data[QString::fromLatin1(pin)] = value;
+        return node.execute(TokenList{t});
+    };
+
+    const QString first = send(RetryLoopNode::kInputTaskId, QStringLiteral("Task")).front().data.value(conversationKey).toString();
+    EXPECT_FALSE(first.isEmpty());
+    const TokenList retry = send(RetryLoopNode::kInputWorkerFeedbackId, QStringLiteral("FAIL"));
+    EXPECT_EQ(retry.front().data.value(conversationKey).toString(), first);
+    send(RetryLoopNode::kInputWorkerFeedbackId, QStringLiteral("done"));
+
+    const QString next = send(RetryLoopNode::kInputTaskId, QStringLiteral("Next")).front().data.value(conversationKey).toString();
+    EXPECT_FALSE(next.isEmpty());
+    EXPECT_NE(next, first);
+}
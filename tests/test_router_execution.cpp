@@ -9,10 +9,14 @@
 #include <gtest/gtest.h>
 
 #include <QApplication>
+#include <QDeadlineTimer>
 #include <QEventLoop>
+#include <QThread>
 #include <QTimer>
 #include <QtTest/QTest>
 
+#include <atomic>
+
 #include <QtNodes/internal/Definitions.hpp>
 
 #include "test_app.h"
@@ -22,11 +26,129 @@
 #include "TextInputNode.h"
 #include "TextOutputNode.h"
 #include "ConditionalRouterNode.h"
+#include "IToolNode.h"
+#include "MetricsRegistry.h"
+#include "ResourceBudgets.h"
 
 using namespace QtNodes;
 
 namespace {
 
+// Cacheable branch node that counts its executions, on its own and across branches,
+// and prefixes its input
+class CountingBranchNode : public QObject, public IToolNode {
+    Q_OBJECT
+    Q_INTERFACES(IToolNode)
+
+public:
+    CountingBranchNode(QString typeId, QString prefix, std::shared_ptr<std::atomic<int>> executions,
+                       std::shared_ptr<std::atomic<int>> allBranches)
+        : m_typeId(std::move(typeId))
+        , m_prefix(std::move(prefix))
+        , m_executions(std::move(executions))
+        , m_allBranches(std::move(allBranches))
+    {
+    }
+
+    NodeDescriptor getDescriptor() const override
+    {
+        NodeDescriptor desc;
+        desc.id = m_typeId;
+        desc.name = m_typeId;
+        PinDefinition in;
+        in.direction = PinDirection::Input;
+        in.id = QStringLiteral("in");
+        in.name = QStringLiteral("In");
+        in.type = QStringLiteral("text");
+        desc.inputPins.insert(in.id, in);
+        PinDefinition out;
+        out.direction = PinDirection::Output;
+        out.id = QStringLiteral("out");
+        out.name = QStringLiteral("Out");
+        out.type = QStringLiteral("text");
+        desc.outputPins.insert(out.id, out);
+        return desc;
+    }
+
+    bool isCacheable() const override { return true; }
+
+    TokenList execute(const TokenList& incomingTokens) override
+    {
+        QString input;
+        for (const auto& token : incomingTokens) {
+            if (token.data.contains(QStringLiteral("in"))) input = token.data.value(QStringLiteral("in")).toString();
+        }
+        ExecutionToken token;
+        token.data.insert(QStringLiteral("out"), m_prefix + input);
+        m_executions->fetch_add(1);
+        m_allBranches->fetch_add(1);
+        return TokenList{token};
+    }
+
+    QJsonObject saveState() const override { return {}; }
+    void loadState(const QJsonObject&) override {}
+
+private:
+    QString m_typeId;
+    QString m_prefix;
+    std::shared_ptr<std::atomic<int>> m_executions;
+    std::shared_ptr<std::atomic<int>> m_allBranches;
+};
+
+// Condition source that answers only once the branches have run, or after a timeout
+class LateConditionNode : public QObject, public IToolNode {
+    Q_OBJECT
+    Q_INTERFACES(IToolNode)
+
+public:
+    LateConditionNode(std::shared_ptr<std::atomic<int>> branchExecutions, int waitFor)
+        : m_branchExecutions(std::move(branchExecutions)), m_waitFor(waitFor)
+    {
+    }
+
+    NodeDescriptor getDescriptor() const override
+    {
+        NodeDescriptor desc;
+        desc.id = QStringLiteral("late-condition");
+        desc.name = QStringLiteral("Late Condition");
+        PinDefinition out;
+        out.direction = PinDirection::Output;
+        out.id = QStringLiteral("out");
+        out.name = QStringLiteral("Out");
+        out.type = QStringLiteral("text");
+        desc.outputPins.insert(out.id, out);
+        return desc;
+    }
+
+
+    TokenList execute(const TokenList&) override
+    {
+        const QDeadlineTimer timeout(3000);
+        while (m_branchExecutions->load() < m_waitFor && !timeout.hasExpired()) {
+            QThread::msleep(5);
+        }
+        ExecutionToken token;
+        token.data.insert(QStringLiteral("out"), QStringLiteral("false"));
+        return TokenList{token};
+    }
+
+    QJsonObject saveState() const override { return {}; }
+    void loadState(const QJsonObject&) override {}
+
+private:
+    std::shared_ptr<std::atomic<int>> m_branchExecutions;
+    int m_waitFor;
+};
+
+quint64 speculativeTasks(const QString& outcome)
+{
+    return MetricsRegistry::instance()
+        .counter(QStringLiteral("cp_speculative_tasks"),
+                 QStringLiteral("Branch nodes started before their router decided, by outcome"),
+                 {{QStringLiteral("outcome"), outcome}})
+        .value();
+}
+
 static QApplication* ensureApp_RouterExecution()
 {
     return sharedTestApp();
@@ -292,3 +414,116 @@ TEST(RouterExecutionTest, testFalseBranch)
     EXPECT_EQ(trueExecCount, 0);
     EXPECT_EQ(falseExecCount, 1);
 }
+
+TEST(RouterExecutionTest, speculativeBranchesCommitOnlyTheChosenOne)
+{
+    ensureApp_RouterExecution();
+
+    NodeGraphModel model;
+    const auto trueExecutions = std::make_shared<std::atomic<int>>(0);
+    const auto falseExecutions = std::make_shared<std::atomic<int>>(0);
+    const auto branchExecutions = std::make_shared<std::atomic<int>>(0);
+    model.dataModelRegistry()->registerModel([trueExecutions, branchExecutions]() {
+        return std::make_unique<ToolNodeDelegate>(std::make_shared<CountingBranchNode>(
+            QStringLiteral("branch-true"), QStringLiteral("yes: "), trueExecutions, branchExecutions));
+    }, QStringLiteral("Mocks"));
+    model.dataModelRegistry()->registerModel([falseExecutions, branchExecutions]() {
+        return std::make_unique<ToolNodeDelegate>(std::make_shared<CountingBranchNode>(
+            QStringLiteral("branch-false"), QStringLiteral("no: "), falseExecutions, branchExecutions));
+    }, QStringLiteral("Mocks"));
+    model.dataModelRegistry()->registerModel([branchExecutions]() {
+        // Waits for both branches, so the router decides only after they ran
+        return std::make_unique<ToolNodeDelegate>(std::make_shared<LateConditionNode>(branchExecutions, 2));
+    }, QStringLiteral("Mocks"));
+
+    // The waiting condition holds one worker while the branches need others
+    ResourceBudgets budgets;
+    budgets.setLimit(ResourceClass::Cpu, 4);
+    model.setResourceBudgets(budgets.toJson());
+
+    const NodeId dataNodeId = model.addNode(QStringLiteral("text-input"));
+    const NodeId condNodeId = model.addNode(QStringLiteral("late-condition"));
+    const NodeId routerNodeId = model.addNode(QStringLiteral("conditional-router"));
+    const NodeId trueNodeId = model.addNode(QStringLiteral("branch-true"));
+    const NodeId falseNodeId = model.addNode(QStringLiteral("branch-false"));
+    ASSERT_NE(condNodeId, InvalidNodeId);
+    ASSERT_NE(trueNodeId, InvalidNodeId);
+    ASSERT_NE(falseNodeId, InvalidNodeId);
+
+    auto* routerDel = model.delegateModel<ToolNodeDelegate>(routerNodeId);
+    ASSERT_NE(routerDel, nullptr);
+    const auto portOf = [routerDel](QtNodes::PortType type, const char* pinId) {
+        for (unsigned int i = 0; i < routerDel->nPorts(type); ++i) {
+            if (routerDel->pinIdForIndex(type, i) == QString::fromLatin1(pinId)) {
+                return static_cast<QtNodes::PortIndex>(i);
+            }
+        }
+        return QtNodes::InvalidPortIndex;
+    };
+    model.addConnection(ConnectionId{ dataNodeId, 0u, routerNodeId,
+                                      portOf(QtNodes::PortType::In, ConditionalRouterNode::kInputDataId) });
+    model.addConnection(ConnectionId{ condNodeId, 0u, routerNodeId,
+                                      portOf(QtNodes::PortType::In, ConditionalRouterNode::kInputConditionId) });
+    model.addConnection(ConnectionId{ routerNodeId, portOf(QtNodes::PortType::Out, ConditionalRouterNode::kOutputTrueId),
+                                      trueNodeId, 0u });
+    model.addConnection(ConnectionId{ routerNodeId, portOf(QtNodes::PortType::Out, ConditionalRouterNode::kOutputFalseId),
+                                      falseNodeId, 0u });
+
+    auto* dataTool = dynamic_cast<TextInputNode*>(model.delegateModel<ToolNodeDelegate>(dataNodeId)->node().get());
+    ASSERT_NE(dataTool, nullptr);
+    dataTool->setText(QStringLiteral("payload"));
+    auto* routerTool = dynamic_cast<ConditionalRouterNode*>(routerDel->node().get());
+    ASSERT_NE(routerTool, nullptr);
+    routerTool->setSpeculative(true);
+
+    ExecutionEngine engine(&model);
+    int trueOutputs = 0;
+    int falseOutputs = 0;
+    QObject::connect(&engine, &ExecutionEngine::nodeOutputChanged, &engine, [&](NodeId nid) {
+        if (nid == trueNodeId) ++trueOutputs;
+        if (nid == falseNodeId) ++falseOutputs;
+    });
+    DataPacket finalOut;
+    QObject::connect(&engine, &ExecutionEngine::pipelineFinished, &engine, [&](const DataPacket& out) {
+        finalOut = out;
+    });
+
+    const quint64 committedBefore = speculativeTasks(QStringLiteral("committed"));
+    const quint64 discardedBefore = speculativeTasks(QStringLiteral("discarded"));
+    ASSERT_TRUE(runEngineAndWait(engine));
+
+    // Both branches ran early, once; only the false branch's result was kept
+    EXPECT_EQ(trueExecutions->load(), 1);
+    EXPECT_EQ(falseExecutions->load(), 1);
+    EXPECT_EQ(trueOutputs, 0);
+    EXPECT_EQ(falseOutputs, 1);
+    EXPECT_EQ(finalOut.value(QStringLiteral("out")).toString(), QStringLiteral("no: payload"));
+    EXPECT_EQ(speculativeTasks(QStringLiteral("committed")), committedBefore + 1);
+    EXPECT_EQ(speculativeTasks(QStringLiteral("discarded")), discardedBefore + 1);
+}
+
+TEST(RouterExecutionTest, speculativeModeIsSavedAndOffersBothBranches)
+{
+    ConditionalRouterNode router;
+    const QVariantMap pending{{QString::fromLatin1(ConditionalRouterNode::kInputDataId), QStringLiteral("payload")}};
+    EXPECT_TRUE(router.speculativeOutputs(pending).isEmpty());
+
+    router.setSpeculative(true);
+    const QList<DataPacket> candidates = router.speculativeOutputs(pending);
+    ASSERT_EQ(candidates.size(), 2);
+    EXPECT_EQ(candidates.at(0).value(QString::fromLatin1(ConditionalRouterNode::kOutputTrueId)).toString(),
+              QStringLiteral("payload"));
+    EXPECT_EQ(candidates.at(1).value(QString::fromLatin1(ConditionalRouterNode::kOutputFalseId)).toString(),
+              QStringLiteral("payload"));
+
+    // Once the condition is known there is nothing to guess
+    QVariantMap decided = pending;
+    decided.insert(QString::fromLatin1(ConditionalRouterNode::kInputConditionId), QStringLiteral("true"));
+    EXPECT_TRUE(router.speculativeOutputs(decided).isEmpty());
+
+    ConditionalRouterNode restored;
+    restored.loadState(router.saveState());
+    EXPECT_TRUE(restored.isSpeculative());
+}
+
+#include "test_router_execution.moc"
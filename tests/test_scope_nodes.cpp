@@ -2,8 +2,12 @@
 
 #include <QApplication>
 #include <QJsonObject>
+#include <QSet>
 #include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QThread>
 
+#include <atomic>
 #include <memory>
 
 #include "ExecutionIdUtils.h"
@@ -12,7 +16,10 @@
 #include "GetItemNode.h"
 #include "IteratorScopeNode.h"
 #include "NodeGraphModel.h"
+#include "PartialOutputSink.h"
+#include "PipelineFormat.h"
 #include "PromptBuilderNode.h"
+#include "ResultCache.h"
 #include "SetItemResultNode.h"
 #include "SetOutputNode.h"
 #include "TextChunkerNode.h"
@@ -42,6 +49,109 @@ PortIndex portIndexFor(NodeGraphModel& model, NodeId nodeId, PortType portType,
     }
     return InvalidPortIndex;
 }
+
+// Body node that holds its worker for a while and records how many run at once
+class SlowBranchNode : public IToolNode {
+public:
+    explicit SlowBranchNode(std::shared_ptr<std::atomic<int>> running, std::shared_ptr<std::atomic<int>> peak)
+        : m_running(std::move(running))
+        , m_peak(std::move(peak))
+    {
+    }
+
+    NodeDescriptor getDescriptor() const override
+    {
+        NodeDescriptor desc;
+        desc.id = QStringLiteral("test-slow-branch");
+        desc.name = QStringLiteral("Slow Branch");
+        PinDefinition in;
+        in.direction = PinDirection::Input;
+        in.id = QStringLiteral("in");
+        in.name = QStringLiteral("In");
+        in.type = QStringLiteral("text");
+        desc.inputPins.insert(in.id, in);
+        PinDefinition out;
+        out.direction = PinDirection::Output;
+        out.id = QStringLiteral("out");
+        out.name = QStringLiteral("Out");
+        out.type = QStringLiteral("text");
+        desc.outputPins.insert(out.id, out);
+        return desc;
+    }
+    bool supportsConcurrentRuns() const override { return true; }
+    TokenList execute(const TokenList& incomingTokens) override
+    {
+        const int now = ++*m_running;
+        int expected = m_peak->load();
+        while (now > expected && !m_peak->compare_exchange_weak(expected, now)) {
+        }
+        QThread::msleep(150);
+        --*m_running;
+        ExecutionToken token;
+        token.data.insert(QStringLiteral("out"), incomingTokens.front().data.value(QStringLiteral("in")));
+        return TokenList{std::move(token)};
+    }
+    QJsonObject saveState() const override { return {}; }
+    void loadState(const QJsonObject&) override {}
+
+private:
+    std::shared_ptr<std::atomic<int>> m_running;
+    std::shared_ptr<std::atomic<int>> m_peak;
+};
+
+// Body node that passes "in" through to "out" and counts its executions. The judge
+// variant also reports "accepted" once it has run acceptAfter times.
+class CountingBodyNode : public IToolNode {
+public:
+    CountingBodyNode(QString id, bool deterministic, std::shared_ptr<std::atomic<int>> calls, int acceptAfter = 0)
+        : m_id(std::move(id))
+        , m_deterministic(deterministic)
+        , m_calls(std::move(calls))
+        , m_acceptAfter(acceptAfter)
+    {
+    }
+
+    NodeDescriptor getDescriptor() const override
+    {
+        NodeDescriptor desc;
+        desc.id = m_id;
+        desc.name = m_id;
+        for (const QString& pinId : {QStringLiteral("in")}) {
+            PinDefinition pin;
+            pin.direction = PinDirection::Input;
+            pin.id = pinId;
+            pin.name = pinId;
+            pin.type = QStringLiteral("text");
+            desc.inputPins.insert(pin.id, pin);
+        }
+        for (const QString& pinId : {QStringLiteral("accepted"), QStringLiteral("out")}) {
+            PinDefinition pin;
+            pin.direction = PinDirection::Output;
+            pin.id = pinId;
+            pin.name = pinId;
+            pin.type = QStringLiteral("text");
+            desc.outputPins.insert(pin.id, pin);
+        }
+        return desc;
+    }
+    bool isDeterministic() const override { return m_deterministic; }
+    TokenList execute(const TokenList& incomingTokens) override
+    {
+        const int calls = ++*m_calls;
+        ExecutionToken token;
+        token.data.insert(QStringLiteral("out"), incomingTokens.front().data.value(QStringLiteral("in")));
+        token.data.insert(QStringLiteral("accepted"), calls >= m_acceptAfter);
+        return TokenList{std::move(token)};
+    }
+    QJsonObject saveState() const override { return {}; }
+    void loadState(const QJsonObject&) override {}
+
+private:
+    QString m_id;
+    bool m_deterministic;
+    std::shared_ptr<std::atomic<int>> m_calls;
+    int m_acceptAfter;
+};
 }
 
 TEST(ScopeNodesTest, GetInputEmitsTransformFrame)
@@ -54,6 +164,7 @@ TEST(ScopeNodesTest, GetInputEmitsTransformFrame)
     in.data.insert(QStringLiteral("_transform_attempt"), 2);
     in.data.insert(QStringLiteral("_transform_previous_output"), QStringLiteral("draft"));
     in.data.insert(QStringLiteral("_scope_context"), QVariantMap{{QStringLiteral("topic"), QStringLiteral("demo")}});
+    in.data.insert(QStringLiteral("_scope_conversation"), QStringLiteral("conv-1"));
 
     const TokenList out = node.execute(TokenList{in});
     ASSERT_EQ(out.size(), 1u);
@@ -64,6 +175,7 @@ TEST(ScopeNodesTest, GetInputEmitsTransformFrame)
     EXPECT_EQ(packet.value(QString::fromLatin1(GetInputNode::kOutputPreviousOutputId)).toString(), QStringLiteral("draft"));
     EXPECT_EQ(packet.value(QString::fromLatin1(GetInputNode::kOutputContextId)).toMap().value(QStringLiteral("topic")).toString(),
               QStringLiteral("demo"));
+    EXPECT_EQ(packet.value(QString::fromLatin1(GetInputNode::kOutputConversationId)).toString(), QStringLiteral("conv-1"));
 }
 
 TEST(ScopeNodesTest, SetOutputDefaultsAccepted)
@@ -147,6 +259,47 @@ TEST(ScopeNodesTest, TransformScopeRetriesUntilAccepted)
               QStringLiteral("accepted"));
 }
 
+TEST(ScopeNodesTest, TransformScopeRetriesFromInputWithOneConversation)
+{
+    ensureScopeApp();
+
+    TransformScopeNode scope;
+    scope.setMode(QStringLiteral("retry_from_input"));
+    EXPECT_EQ(scope.mode(), QStringLiteral("retry_from_input"));
+    scope.setMaxAttempts(4);
+
+    QStringList inputs;
+    QSet<QString> conversations;
+    scope.setBodyRunner([&](const QString&, ScopeBodyKind, const ScopeFrame& frame, const DataPacket&) {
+        inputs << frame.input.toString();
+        conversations.insert(frame.conversationId);
+        EXPECT_EQ(frame.count, 4);
+        ScopeBodyResult result;
+        result.ok = true;
+        result.accepted = false;
+        result.output = QStringLiteral("candidate-%1").arg(frame.attempt);
+        result.nextInput = QStringLiteral("ignored");
+        return result;
+    });
+
+    ExecutionToken in;
+    in.data.insert(QString::fromLatin1(TransformScopeNode::kInputInputId), QStringLiteral("seed"));
+
+    const TokenList out = scope.execute(TokenList{in});
+    ASSERT_EQ(out.size(), 1u);
+    EXPECT_EQ(inputs, QStringList(4, QStringLiteral("seed")));
+    ASSERT_EQ(conversations.size(), 1);
+    EXPECT_FALSE(conversations.begin()->isEmpty());
+    EXPECT_EQ(out.front().data.value(QString::fromLatin1(TransformScopeNode::kOutputStatusId)).toString(),
+              QStringLiteral("exhausted"));
+    EXPECT_EQ(out.front().data.value(QString::fromLatin1(TransformScopeNode::kOutputOutputId)).toString(),
+              QStringLiteral("candidate-3"));
+
+    // A later execution is a new conversation
+    scope.execute(TokenList{in});
+    EXPECT_EQ(conversations.size(), 2);
+}
+
 TEST(ScopeNodesTest, IteratorScopeMapsList)
 {
     ensureScopeApp();
@@ -175,6 +328,214 @@ TEST(ScopeNodesTest, IteratorScopeMapsList)
     EXPECT_EQ(results.at(1).toString(), QStringLiteral("out-1-b"));
 }
 
+TEST(ScopeNodesTest, IteratorScopeRunsPassesConcurrentlyInInputOrder)
+{
+    ensureScopeApp();
+
+    IteratorScopeNode scope;
+    scope.setMaxParallelism(4);
+    std::atomic<int> running {0};
+    std::atomic<int> peak {0};
+    scope.setBodyRunner([&](const QString&, ScopeBodyKind, const ScopeFrame& frame, const DataPacket&) {
+        EXPECT_TRUE(frame.serializer);
+        EXPECT_TRUE(frame.history.isEmpty());
+        const int now = ++running;
+        int expected = peak.load();
+        while (now > expected && !peak.compare_exchange_weak(expected, now)) {
+        }
+        // Later items finish first so completion order differs from input order
+        QThread::msleep(static_cast<unsigned long>(10 * (8 - frame.index)));
+        --running;
+        ScopeBodyResult result;
+        result.ok = true;
+        result.output = QStringLiteral("out-%1").arg(frame.index);
+        return result;
+    });
+
+    QVariantList items;
+    for (int i = 0; i < 8; ++i) {
+        items << QStringLiteral("item-%1").arg(i);
+    }
+    ExecutionToken in;
+    in.data.insert(QString::fromLatin1(IteratorScopeNode::kInputItemsId), items);
+
+    const TokenList out = scope.execute(TokenList{in});
+    ASSERT_EQ(out.size(), 1u);
+    EXPECT_GT(peak.load(), 1);
+    EXPECT_LE(peak.load(), 4);
+    const QVariantList results = out.front().data.value(QString::fromLatin1(IteratorScopeNode::kOutputResultsId)).toList();
+    ASSERT_EQ(results.size(), 8);
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_EQ(results.at(i).toString(), QStringLiteral("out-%1").arg(i));
+    }
+
+    scope.setResultOrder(QStringLiteral("completion"));
+    const TokenList unordered = scope.execute(TokenList{in});
+    const QVariantList streamed = unordered.front().data.value(QString::fromLatin1(IteratorScopeNode::kOutputResultsId)).toList();
+    ASSERT_EQ(streamed.size(), 8);
+    EXPECT_NE(streamed.first().toString(), QStringLiteral("out-0"));
+
+    IteratorScopeNode restored;
+    restored.loadState(scope.saveState());
+    EXPECT_EQ(restored.maxParallelism(), 4);
+    EXPECT_EQ(restored.resultOrder(), QStringLiteral("completion"));
+}
+
+TEST(ScopeNodesTest, IteratorScopeBatchesItemsPerPass)
+{
+    ensureScopeApp();
+
+    IteratorScopeNode scope;
+    scope.setBatchSize(3);
+    QList<int> starts;
+    scope.setBodyRunner([&](const QString&, ScopeBodyKind, const ScopeFrame& frame, const DataPacket&) {
+        starts << frame.index;
+        EXPECT_EQ(frame.count, 7);
+        const QVariantList slice = frame.item.toList();
+        EXPECT_EQ(frame.batchSize, slice.size());
+        QVariantList doubled;
+        for (const QVariant& v : slice) {
+            doubled << v.toInt() * 2;
+        }
+        ScopeBodyResult result;
+        result.ok = true;
+        result.output = doubled;
+        return result;
+    });
+
+    ExecutionToken in;
+    in.data.insert(QString::fromLatin1(IteratorScopeNode::kInputItemsId), QVariantList{1, 2, 3, 4, 5, 6, 7});
+    const TokenList out = scope.execute(TokenList{in});
+    ASSERT_EQ(out.size(), 1u);
+    EXPECT_EQ(starts, (QList<int>{0, 3, 6}));
+    const QVariantList results = out.front().data.value(QString::fromLatin1(IteratorScopeNode::kOutputResultsId)).toList();
+    ASSERT_EQ(results.size(), 7);
+    EXPECT_EQ(results.at(0).toInt(), 2);
+    EXPECT_EQ(results.at(6).toInt(), 14);
+
+    IteratorScopeNode restored;
+    restored.loadState(scope.saveState());
+    EXPECT_EQ(restored.batchSize(), 3);
+}
+
+TEST(ScopeNodesTest, IteratorScopeReplaysCachedItemsAndRunsOnlyNewOnes)
+{
+    ensureScopeApp();
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const ResultCache cache(dir.path());
+    const ResultCache::Scope cacheScope(&cache);
+
+    IteratorScopeNode scope;
+    scope.setCacheItemResults(true);
+    QByteArray bodyHash("body-v1");
+    scope.setBodyFingerprint([&](const QString&) { return bodyHash; });
+    QStringList ran;
+    scope.setBodyRunner([&](const QString&, ScopeBodyKind, const ScopeFrame& frame, const DataPacket&) {
+        ran << frame.item.toString();
+        ScopeBodyResult result;
+        result.ok = true;
+        result.output = frame.item.toString().toUpper();
+        return result;
+    });
+
+    const auto runWith = [&](const QVariantList& items) {
+        ExecutionToken in;
+        in.data.insert(QString::fromLatin1(IteratorScopeNode::kInputItemsId), items);
+        const TokenList out = scope.execute(TokenList{in});
+        EXPECT_EQ(out.size(), 1u);
+        return out.empty() ? DataPacket() : out.front().data;
+    };
+
+    runWith({QStringLiteral("a"), QStringLiteral("b")});
+    EXPECT_EQ(ran, (QStringList{QStringLiteral("a"), QStringLiteral("b")}));
+
+    // Appending an item runs only that item; the others replay in place
+    ran.clear();
+    const DataPacket out = runWith({QStringLiteral("a"), QStringLiteral("b"), QStringLiteral("c")});
+    EXPECT_EQ(ran, QStringList{QStringLiteral("c")});
+    EXPECT_EQ(out.value(QString::fromLatin1(IteratorScopeNode::kOutputResultsId)).toList(),
+              (QVariantList{QStringLiteral("A"), QStringLiteral("B"), QStringLiteral("C")}));
+    EXPECT_EQ(out.value(QString::fromLatin1(IteratorScopeNode::kOutputSummaryId)).toMap()
+                  .value(QStringLiteral("cached_passes")).toInt(), 2);
+
+    // Editing the body invalidates every item
+    ran.clear();
+    bodyHash = "body-v2";
+    runWith({QStringLiteral("a")});
+    EXPECT_EQ(ran, QStringList{QStringLiteral("a")});
+
+    // Off by default, and round-trips through saved state
+    IteratorScopeNode restored;
+    EXPECT_FALSE(restored.cacheItemResults());
+    restored.loadState(scope.saveState());
+    EXPECT_TRUE(restored.cacheItemResults());
+}
+
+TEST(ScopeNodesTest, IteratorScopeStreamsEachResultBeforeReturning)
+{
+    ensureScopeApp();
+
+    IteratorScopeNode scope;
+    int passesRun = 0;
+    scope.setBodyRunner([&](const QString&, ScopeBodyKind, const ScopeFrame& frame, const DataPacket&) {
+        ++passesRun;
+        ScopeBodyResult result;
+        result.ok = true;
+        result.skip = frame.index == 1;
+        result.output = QStringLiteral("same");
+        return result;
+    });
+
+    QStringList streamed;
+    QList<int> passesAtPublish;
+    TokenList out;
+    {
+        const PartialOutputSink::Scope sinkScope(PartialOutputSink([&](const TokenList& tokens) {
+            for (const auto& token : tokens) {
+                EXPECT_TRUE(token.forceExecution);
+                streamed << token.data.value(QString::fromLatin1(IteratorScopeNode::kOutputStreamId)).toString();
+                passesAtPublish << passesRun;
+            }
+        }));
+        ExecutionToken in;
+        in.data.insert(QString::fromLatin1(IteratorScopeNode::kInputItemsId), QVariantList{1, 2, 3});
+        out = scope.execute(TokenList{in});
+    }
+
+    // Skipped passes stream nothing; the others stream as they finish, not at the end
+    EXPECT_EQ(streamed, (QStringList{QStringLiteral("same"), QStringLiteral("same")}));
+    EXPECT_EQ(passesAtPublish, (QList<int>{1, 3}));
+    ASSERT_EQ(out.size(), 1u);
+    EXPECT_FALSE(out.front().data.contains(QString::fromLatin1(IteratorScopeNode::kOutputStreamId)));
+    EXPECT_EQ(out.front().data.value(QString::fromLatin1(IteratorScopeNode::kOutputResultsId)).toList().size(), 2);
+}
+
+TEST(ScopeNodesTest, ParallelIteratorStopsAtLowestFailedIndex)
+{
+    ensureScopeApp();
+
+    IteratorScopeNode scope;
+    scope.setMaxParallelism(3);
+    scope.setBodyRunner([&](const QString&, ScopeBodyKind, const ScopeFrame& frame, const DataPacket&) {
+        ScopeBodyResult result;
+        result.ok = frame.index != 2 && frame.index != 4;
+        if (!result.ok) {
+            result.error = QStringLiteral("bad %1").arg(frame.index);
+        }
+        result.output = frame.item;
+        return result;
+    });
+
+    ExecutionToken in;
+    in.data.insert(QString::fromLatin1(IteratorScopeNode::kInputItemsId),
+                   QVariantList{1, 2, 3, 4, 5, 6});
+    const TokenList out = scope.execute(TokenList{in});
+    ASSERT_EQ(out.size(), 1u);
+    EXPECT_EQ(out.front().data.value(QStringLiteral("__error")).toString(), QStringLiteral("bad 2"));
+}
+
 TEST(ScopeNodesTest, TextChunkerNodeProducesListForIteratorInput)
 {
     ensureScopeApp();
@@ -194,6 +555,42 @@ TEST(ScopeNodesTest, TextChunkerNodeProducesListForIteratorInput)
     EXPECT_EQ(out.front().data.value(QString::fromLatin1(TextChunkerNode::kOutputCountId)).toInt(), chunks.size());
 }
 
+TEST(ScopeNodesTest, TextChunkerNodeStreamsEachChunkAsItsOwnToken)
+{
+    ensureScopeApp();
+
+    TextChunkerNode node;
+    node.setChunkSize(12);
+    node.setChunkOverlap(0);
+    ExecutionToken in;
+    in.data.insert(QString::fromLatin1(TextChunkerNode::kInputTextId),
+                   QStringLiteral("alpha beta gamma delta epsilon zeta eta theta"));
+    const QVariantList listed =
+        node.execute(TokenList{in}).front().data.value(QString::fromLatin1(TextChunkerNode::kOutputChunksId)).toList();
+
+    node.setStreamChunks(true);
+    EXPECT_FALSE(node.isCacheable());
+    QVariantList streamed;
+    TokenList out;
+    {
+        const PartialOutputSink::Scope sinkScope(PartialOutputSink([&](const TokenList& tokens) {
+            for (const ExecutionToken& published : tokens) {
+                EXPECT_TRUE(published.forceExecution);
+                streamed.append(published.data.value(QString::fromLatin1(TextChunkerNode::kOutputChunkId)));
+            }
+        }));
+        out = node.execute(TokenList{in});
+    }
+    ASSERT_EQ(out.size(), 1u);
+    EXPECT_EQ(streamed, listed);
+    EXPECT_EQ(out.front().data.value(QString::fromLatin1(TextChunkerNode::kOutputCountId)).toInt(), listed.size());
+    EXPECT_FALSE(out.front().data.contains(QString::fromLatin1(TextChunkerNode::kOutputChunksId)));
+
+    TextChunkerNode restored;
+    restored.loadState(node.saveState());
+    EXPECT_TRUE(restored.streamChunks());
+}
+
 TEST(ScopeNodesTest, TransformBodySubgraphExecutesPromptBuilder)
 {
     ensureScopeApp();
@@ -358,6 +755,179 @@ TEST(ScopeNodesTest, IteratorBodySubgraphExecutesPromptBuilder)
     EXPECT_EQ(results.at(1).toString(), QStringLiteral("done b"));
 }
 
+TEST(ScopeNodesTest, IteratorBodyPlanIsCachedAndHiddenPassesAreSampled)
+{
+    ensureScopeApp();
+
+    NodeGraphModel root;
+    const NodeId scopeId = root.addNode(QStringLiteral("iterator-scope"));
+    ASSERT_NE(scopeId, InvalidNodeId);
+    auto scope = std::dynamic_pointer_cast<IteratorScopeNode>(root.delegateModel<ToolNodeDelegate>(scopeId)->node());
+    ASSERT_TRUE(scope);
+
+    NodeGraphModel* body = root.ensureSubgraph(scope->bodyId(), NodeGraphModel::GraphKind::IteratorBody);
+    ASSERT_NE(body, nullptr);
+    const NodeId itemId = body->addNode(QStringLiteral("iterator-get-item"));
+    const NodeId resultId = body->addNode(QStringLiteral("iterator-set-result"));
+    const PortIndex itemOut = portIndexFor(*body, itemId, PortType::Out, QString::fromLatin1(GetItemNode::kOutputItemId));
+    const PortIndex resultIn = portIndexFor(*body, resultId, PortType::In, QString::fromLatin1(SetItemResultNode::kInputResultId));
+    ASSERT_NE(itemOut, InvalidPortIndex);
+    ASSERT_NE(resultIn, InvalidPortIndex);
+    body->addConnection(ConnectionId{itemId, itemOut, resultId, resultIn});
+
+    const auto plan = body->executionPlan();
+    EXPECT_EQ(body->executionPlan(), plan);
+
+    QVariantList items;
+    for (int i = 0; i < 201; ++i) {
+        items << i;
+    }
+    ExecutionToken in;
+    in.data.insert(QString::fromLatin1(IteratorScopeNode::kInputItemsId), items);
+
+    const QUuid itemUuid = ExecIds::nodeUuid(body->executionScopeKey(), itemId);
+    const auto finishedReports = [&](QSignalSpy& spy) {
+        int count = 0;
+        for (const QList<QVariant>& args : spy) {
+            if (args.at(0).toUuid() == itemUuid && args.at(1).toInt() == static_cast<int>(ExecutionState::Finished)) {
+                ++count;
+            }
+        }
+        return count;
+    };
+
+    {
+        QSignalSpy spy(body, &NodeGraphModel::executionNodeStatusChanged);
+        const TokenList out = scope->execute(TokenList{in});
+        ASSERT_EQ(out.size(), 1u);
+        EXPECT_EQ(out.front().data.value(QString::fromLatin1(IteratorScopeNode::kOutputResultsId)).toList().size(), 201);
+        // Passes 0, 100 and 200 only
+        EXPECT_EQ(finishedReports(spy), 3);
+    }
+    EXPECT_EQ(body->executionPlan(), plan);
+
+    body->setExecutionObserved(true);
+    {
+        QSignalSpy spy(body, &NodeGraphModel::executionNodeStatusChanged);
+        scope->execute(TokenList{in});
+        EXPECT_EQ(finishedReports(spy), 201);
+    }
+
+    // Editing the body recompiles the plan on the next pass
+    body->addNode(QStringLiteral("prompt-builder"));
+    EXPECT_NE(body->executionPlan(), plan);
+    EXPECT_EQ(body->executionPlan()->nodes().size(), 3);
+}
+
+TEST(ScopeNodesTest, ScopeBodyRunsIndependentBranchesInParallel)
+{
+    ensureScopeApp();
+
+    NodeGraphModel root;
+    const NodeId scopeId = root.addNode(QStringLiteral("iterator-scope"));
+    auto scope = std::dynamic_pointer_cast<IteratorScopeNode>(root.delegateModel<ToolNodeDelegate>(scopeId)->node());
+    ASSERT_TRUE(scope);
+    NodeGraphModel* body = root.ensureSubgraph(scope->bodyId(), NodeGraphModel::GraphKind::IteratorBody);
+    ASSERT_NE(body, nullptr);
+
+    auto running = std::make_shared<std::atomic<int>>(0);
+    auto peak = std::make_shared<std::atomic<int>>(0);
+    body->dataModelRegistry()->registerModel([running, peak]() {
+        return std::make_unique<ToolNodeDelegate>(std::make_shared<SlowBranchNode>(running, peak));
+    }, QStringLiteral("Tests"));
+
+    // Get Item fans out to two slow branches; only the second one reaches Set Item Result
+    const NodeId itemId = body->addNode(QStringLiteral("iterator-get-item"));
+    const NodeId slowA = body->addNode(QStringLiteral("test-slow-branch"));
+    const NodeId slowB = body->addNode(QStringLiteral("test-slow-branch"));
+    const NodeId resultId = body->addNode(QStringLiteral("iterator-set-result"));
+    ASSERT_NE(slowA, InvalidNodeId);
+    ASSERT_NE(slowB, InvalidNodeId);
+    const PortIndex itemOut = portIndexFor(*body, itemId, PortType::Out, QString::fromLatin1(GetItemNode::kOutputItemId));
+    const PortIndex resultIn = portIndexFor(*body, resultId, PortType::In, QString::fromLatin1(SetItemResultNode::kInputResultId));
+    body->addConnection(ConnectionId{itemId, itemOut, slowA, 0u});
+    body->addConnection(ConnectionId{itemId, itemOut, slowB, 0u});
+    body->addConnection(ConnectionId{slowB, 0u, resultId, resultIn});
+
+    ExecutionToken in;
+    in.data.insert(QString::fromLatin1(IteratorScopeNode::kInputItemsId), QVariantList{QStringLiteral("x")});
+    const TokenList out = scope->execute(TokenList{in});
+    ASSERT_EQ(out.size(), 1u);
+    EXPECT_FALSE(out.front().data.contains(QStringLiteral("__error")))
+        << out.front().data.value(QStringLiteral("__error")).toString().toStdString();
+    EXPECT_EQ(peak->load(), 2);
+    EXPECT_EQ(running->load(), 0);
+
+    // The step budget replaces the fixed ceiling and fails the pass when exceeded
+    scope->setMaxSteps(2);
+    const TokenList limited = scope->execute(TokenList{in});
+    ASSERT_EQ(limited.size(), 1u);
+    EXPECT_TRUE(limited.front().data.value(QStringLiteral("__error")).toString().contains(QStringLiteral("step budget")));
+
+    IteratorScopeNode restored;
+    restored.loadState(scope->saveState());
+    EXPECT_EQ(restored.budget().maxSteps, 2);
+    EXPECT_EQ(restored.budget().timeLimitSeconds, 0);
+}
+
+TEST(ScopeNodesTest, TransformRetriesReplayUnchangedDeterministicNodes)
+{
+    ensureScopeApp();
+
+    NodeGraphModel root;
+    const NodeId scopeId = root.addNode(QStringLiteral("transform-scope"));
+    auto scope = std::dynamic_pointer_cast<TransformScopeNode>(root.delegateModel<ToolNodeDelegate>(scopeId)->node());
+    ASSERT_TRUE(scope);
+    scope->setMode(QStringLiteral("retry_until_accepted"));
+    scope->setMaxAttempts(5);
+    NodeGraphModel* body = root.ensureSubgraph(scope->bodyId(), NodeGraphModel::GraphKind::TransformBody);
+    ASSERT_NE(body, nullptr);
+
+    auto parseCalls = std::make_shared<std::atomic<int>>(0);
+    auto judgeCalls = std::make_shared<std::atomic<int>>(0);
+    body->dataModelRegistry()->registerModel([parseCalls]() {
+        return std::make_unique<ToolNodeDelegate>(
+            std::make_shared<CountingBodyNode>(QStringLiteral("test-parse"), true, parseCalls));
+    }, QStringLiteral("Tests"));
+    body->dataModelRegistry()->registerModel([judgeCalls]() {
+        return std::make_unique<ToolNodeDelegate>(
+            std::make_shared<CountingBodyNode>(QStringLiteral("test-judge"), false, judgeCalls, 3));
+    }, QStringLiteral("Tests"));
+
+    // Get Input -> deterministic parse -> non-deterministic judge -> Set Output
+    const NodeId inputId = body->addNode(QStringLiteral("scope-get-input"));
+    const NodeId parseId = body->addNode(QStringLiteral("test-parse"));
+    const NodeId judgeId = body->addNode(QStringLiteral("test-judge"));
+    const NodeId outputId = body->addNode(QStringLiteral("scope-set-output"));
+    ASSERT_NE(parseId, InvalidNodeId);
+    ASSERT_NE(judgeId, InvalidNodeId);
+    const auto pin = [&](NodeId id, PortType type, const QString& pinId) {
+        return portIndexFor(*body, id, type, pinId);
+    };
+    body->addConnection(ConnectionId{inputId, pin(inputId, PortType::Out, QString::fromLatin1(GetInputNode::kOutputInputId)),
+                                     parseId, pin(parseId, PortType::In, QStringLiteral("in"))});
+    body->addConnection(ConnectionId{parseId, pin(parseId, PortType::Out, QStringLiteral("out")),
+                                     judgeId, pin(judgeId, PortType::In, QStringLiteral("in"))});
+    body->addConnection(ConnectionId{judgeId, pin(judgeId, PortType::Out, QStringLiteral("out")),
+                                     outputId, pin(outputId, PortType::In, QString::fromLatin1(SetOutputNode::kInputOutputId))});
+    body->addConnection(ConnectionId{judgeId, pin(judgeId, PortType::Out, QStringLiteral("accepted")),
+                                     outputId, pin(outputId, PortType::In, QString::fromLatin1(SetOutputNode::kInputAcceptedId))});
+
+    ExecutionToken in;
+    in.data.insert(QString::fromLatin1(TransformScopeNode::kInputInputId), QStringLiteral("seed"));
+    const TokenList out = scope->execute(TokenList{in});
+    ASSERT_EQ(out.size(), 1u);
+    EXPECT_FALSE(out.front().data.contains(QStringLiteral("__error")))
+        << out.front().data.value(QStringLiteral("__error")).toString().toStdString();
+    EXPECT_EQ(out.front().data.value(QString::fromLatin1(TransformScopeNode::kOutputStatusId)).toString(),
+              QStringLiteral("accepted"));
+    EXPECT_EQ(judgeCalls->load(), 3);
+    EXPECT_EQ(parseCalls->load(), 1);
+    const QVariantMap scopeInfo = out.front().data.value(QString::fromLatin1(TransformScopeNode::kOutputContextId))
+                                      .toMap().value(QStringLiteral("_scope")).toMap();
+    EXPECT_EQ(scopeInfo.value(QStringLiteral("replayed_nodes")).toInt(), 2);
+}
+
 TEST(ScopeNodesTest, BodyOnlyNodesArePaletteRegisteredInMatchingBodies)
 {
     ensureScopeApp();
@@ -463,6 +1033,90 @@ TEST(ScopeNodesTest, LoadedTransformScopeUsesSavedBodyGraph)
               QStringLiteral("saved seed"));
 }
 
+TEST(ScopeNodesTest, SavedBodiesAreBuiltOnFirstUse)
+{
+    ensureScopeApp();
+
+    NodeGraphModel root;
+    NodeGraphModel* body = root.ensureSubgraph(QStringLiteral("body-lazy"), NodeGraphModel::GraphKind::TransformBody);
+    ASSERT_NE(body, nullptr);
+    ASSERT_NE(body->addNode(QStringLiteral("scope-get-input")), InvalidNodeId);
+    ASSERT_NE(root.ensureSubgraph(QStringLiteral("body-worker"), NodeGraphModel::GraphKind::IteratorBody), nullptr);
+    const QJsonObject saved = root.save();
+
+    NodeGraphModel loaded;
+    loaded.load(saved);
+    EXPECT_FALSE(loaded.isSubgraphLoaded(QStringLiteral("body-lazy")));
+    EXPECT_TRUE(loaded.subgraphModels().isEmpty());
+
+    // An unopened body is saved back unchanged
+    EXPECT_EQ(loaded.save().value(QStringLiteral("subgraphs")).toObject(),
+              saved.value(QStringLiteral("subgraphs")).toObject());
+
+    // The saved kind wins over the one asked for
+    NodeGraphModel* restored = loaded.ensureSubgraph(QStringLiteral("body-lazy"), NodeGraphModel::GraphKind::IteratorBody);
+    ASSERT_NE(restored, nullptr);
+    EXPECT_TRUE(loaded.isSubgraphLoaded(QStringLiteral("body-lazy")));
+    EXPECT_EQ(restored->graphKind(), NodeGraphModel::GraphKind::TransformBody);
+    EXPECT_EQ(restored->allNodeIds().size(), 1u);
+    EXPECT_EQ(loaded.subgraph(QStringLiteral("body-lazy")), restored);
+
+    // A body first needed by a worker ends up on the model's thread
+    NodeGraphModel* fromWorker = nullptr;
+    std::unique_ptr<QThread> worker(QThread::create([&loaded, &fromWorker]() {
+        fromWorker = loaded.subgraph(QStringLiteral("body-worker"));
+    }));
+    worker->start();
+    ASSERT_TRUE(worker->wait(5000));
+    ASSERT_NE(fromWorker, nullptr);
+    EXPECT_EQ(fromWorker->thread(), loaded.thread());
+    EXPECT_EQ(fromWorker->graphKind(), NodeGraphModel::GraphKind::IteratorBody);
+}
+
+TEST(ScopeNodesTest, CompactFormatRoundTripsAndKeepsBodiesEncoded)
+{
+    ensureScopeApp();
+
+    NodeGraphModel root;
+    ASSERT_NE(root.addNode(QStringLiteral("text-input")), InvalidNodeId);
+    NodeGraphModel* outer = root.ensureSubgraph(QStringLiteral("body-outer"), NodeGraphModel::GraphKind::TransformBody);
+    ASSERT_NE(outer, nullptr);
+    ASSERT_NE(outer->addNode(QStringLiteral("scope-set-output")), InvalidNodeId);
+    NodeGraphModel* inner = outer->ensureSubgraph(QStringLiteral("body-inner"), NodeGraphModel::GraphKind::IteratorBody);
+    ASSERT_NE(inner, nullptr);
+    ASSERT_NE(inner->addNode(QStringLiteral("iterator-get-item")), InvalidNodeId);
+    const QJsonObject json = root.save();
+
+    const QByteArray compact = root.saveCompact();
+    ASSERT_TRUE(PipelineFormat::isCompact(compact));
+    EXPECT_FALSE(PipelineFormat::isCompact(QByteArrayLiteral("{\"nodes\": []}")));
+    EXPECT_EQ(PipelineFormat::toJson(compact), json);
+    EXPECT_EQ(PipelineFormat::toJson(PipelineFormat::fromJson(json)), json);
+
+    NodeGraphModel loaded;
+    QString error;
+    ASSERT_TRUE(loaded.loadCompact(compact, &error)) << error.toStdString();
+    EXPECT_EQ(loaded.allNodeIds().size(), 1u);
+    EXPECT_FALSE(loaded.isSubgraphLoaded(QStringLiteral("body-outer")));
+
+    // Unopened bodies convert to JSON on demand and go back out encoded as they came
+    EXPECT_EQ(loaded.save(), json);
+    EXPECT_EQ(PipelineFormat::toJson(loaded.saveCompact()), json);
+
+    NodeGraphModel* loadedOuter = loaded.subgraph(QStringLiteral("body-outer"));
+    ASSERT_NE(loadedOuter, nullptr);
+    EXPECT_EQ(loadedOuter->graphKind(), NodeGraphModel::GraphKind::TransformBody);
+    EXPECT_EQ(loadedOuter->allNodeIds().size(), 1u);
+    EXPECT_FALSE(loadedOuter->isSubgraphLoaded(QStringLiteral("body-inner")));
+    NodeGraphModel* loadedInner = loadedOuter->subgraph(QStringLiteral("body-inner"));
+    ASSERT_NE(loadedInner, nullptr);
+    EXPECT_EQ(loadedInner->graphKind(), NodeGraphModel::GraphKind::IteratorBody);
+    EXPECT_EQ(loaded.save(), json);
+
+    EXPECT_FALSE(loaded.loadCompact(QByteArrayLiteral("\xd9\xd9\xf7\xa0"), &error));
+    EXPECT_FALSE(error.isEmpty());
+}
+
 TEST(ScopeNodesTest, DeletingScopeRemovesOwnedBodyGraph)
 {
     ensureScopeApp();
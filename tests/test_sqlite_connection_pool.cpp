@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include <QFile>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QVariant>
+
+#include <thread>
+
+#include "retrieval/storage/SqliteConnectionPool.h"
+
+namespace {
+
+QVariant pragma(QSqlDatabase& db, const QString& name)
+{
+    QSqlQuery query(db);
+    if (!query.exec(QStringLiteral("PRAGMA %1").arg(name)) || !query.next()) {
+        return {};
+    }
+    return query.value(0);
+}
+
+} // namespace
+
+TEST(SqliteConnectionPoolTest, ReusesOneTunedConnectionPerThreadAndPath)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("pool.sqlite"));
+
+    QSqlDatabase db = SqliteConnectionPool::connection(path);
+    ASSERT_TRUE(db.isOpen());
+    EXPECT_EQ(SqliteConnectionPool::connection(path).connectionName(), db.connectionName());
+    EXPECT_EQ(pragma(db, QStringLiteral("journal_mode")).toString(), QStringLiteral("wal"));
+    EXPECT_EQ(pragma(db, QStringLiteral("cache_size")).toInt(), -SqliteConnectionPool::kCacheSizeKiB);
+    EXPECT_EQ(pragma(db, QStringLiteral("temp_store")).toInt(), 2); // MEMORY
+
+    // Another thread gets a connection of its own
+    QString otherName;
+    std::thread([&]() {
+        otherName = SqliteConnectionPool::connection(path).connectionName();
+        SqliteConnectionPool::closeAll();
+    }).join();
+    EXPECT_FALSE(otherName.isEmpty());
+    EXPECT_NE(otherName, db.connectionName());
+
+    // A deleted file is not served from the stale handle
+    const QString staleName = db.connectionName();
+    db = QSqlDatabase();
+    ASSERT_TRUE(QFile::remove(path));
+    EXPECT_NE(SqliteConnectionPool::connection(path).connectionName(), staleName);
+    EXPECT_TRUE(QFile::exists(path));
+    EXPECT_EQ(SqliteConnectionPool::openConnections(), 1);
+    SqliteConnectionPool::close(path);
+    EXPECT_EQ(SqliteConnectionPool::openConnections(), 0);
+
+    // Least recently used paths are closed beyond the per-thread limit
+    for (int i = 0; i <= SqliteConnectionPool::kMaxConnectionsPerThread; ++i) {
+        SqliteConnectionPool::connection(dir.filePath(QStringLiteral("extra%1.sqlite").arg(i)));
+    }
+    EXPECT_EQ(SqliteConnectionPool::openConnections(), SqliteConnectionPool::kMaxConnectionsPerThread);
+    SqliteConnectionPool::closeAll();
+    EXPECT_EQ(SqliteConnectionPool::openConnections(), 0);
+}
+
+TEST(SqliteConnectionPoolTest, ColumnCacheFollowsSchemaChanges)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("schema.sqlite"));
+
+    {
+        QSqlDatabase db = SqliteConnectionPool::connection(path);
+        QSqlQuery query(db);
+        ASSERT_TRUE(query.exec(QStringLiteral("CREATE TABLE items (id INTEGER PRIMARY KEY, Name TEXT)")));
+        EXPECT_EQ(SqliteConnectionPool::columns(db, QStringLiteral("items")),
+                  (QSet<QString> {QStringLiteral("id"), QStringLiteral("name")}));
+        EXPECT_TRUE(SqliteConnectionPool::hasColumn(db, QStringLiteral("ITEMS"), QStringLiteral("name")));
+        EXPECT_FALSE(SqliteConnectionPool::hasColumn(db, QStringLiteral("items"), QStringLiteral("score")));
+        EXPECT_TRUE(SqliteConnectionPool::columns(db, QStringLiteral("missing")).isEmpty());
+
+        ASSERT_TRUE(query.exec(QStringLiteral("ALTER TABLE items ADD COLUMN score REAL")));
+        EXPECT_TRUE(SqliteConnectionPool::hasColumn(db, QStringLiteral("items"), QStringLiteral("score")));
+    }
+    SqliteConnectionPool::closeAll();
+}
+
+TEST(SqliteConnectionPoolTest, ReusesPreparedStatementsUntilTheConnectionCloses)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("statements.sqlite"));
+
+    {
+        QSqlDatabase db = SqliteConnectionPool::connection(path);
+        QSqlQuery setup(db);
+        ASSERT_TRUE(setup.exec(QStringLiteral("CREATE TABLE items (id INTEGER PRIMARY KEY, name TEXT)")));
+        ASSERT_TRUE(setup.exec(QStringLiteral("INSERT INTO items (name) VALUES ('a'), ('b'), ('c')")));
+
+        const QString sql = QStringLiteral("SELECT name FROM items WHERE id IN (SELECT value FROM json_each(?))");
+        QSqlQuery first = SqliteConnectionPool::statement(db, sql);
+        first.addBindValue(QStringLiteral("[1,3]"));
+        ASSERT_TRUE(first.exec());
+        ASSERT_TRUE(first.next());
+        EXPECT_EQ(first.value(0).toString(), QStringLiteral("a"));
+
+        // Asking again hands back the same prepared statement, reset for new bindings
+        QSqlQuery second = SqliteConnectionPool::statement(db, sql);
+        EXPECT_EQ(second.result(), first.result());
+        second.addBindValue(QStringLiteral("[2]"));
+        ASSERT_TRUE(second.exec());
+        ASSERT_TRUE(second.next());
+        EXPECT_EQ(second.value(0).toString(), QStringLiteral("b"));
+        EXPECT_FALSE(second.next());
+
+        QSqlQuery broken = SqliteConnectionPool::statement(db, QStringLiteral("SELECT nope FROM missing"));
+        EXPECT_TRUE(broken.lastError().isValid());
+    }
+    SqliteConnectionPool::closeAll();
+    EXPECT_EQ(SqliteConnectionPool::openConnections(), 0);
+}
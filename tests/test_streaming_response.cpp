@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include "ai/backends/Base64FileDownload.h"
+#include "ai/backends/StreamingResponse.h"
+
+TEST(StreamingResponseTest, SplitsServerSentEventsAcrossChunks)
+{
+    QStringList texts;
+    StreamingResponse stream(StreamingResponse::Framing::ServerSentEvents, [&](const QJsonObject& event) {
+        texts << event.value(QStringLiteral("t")).toString();
+    });
+
+    // Events split mid-line, CRLF endings, comments, event lines and the OpenAI terminator
+    stream.feed(": keep-alive\r\nevent: delta\r\ndata: {\"t\":");
+    stream.feed("\"a\"}\r\n\r\ndata: {\"t\":\"b\"}\n");
+    stream.feed("\ndata: [DONE]\n\n");
+    stream.feed("data: {\"t\":\"c\"}");
+    stream.finish();
+
+    EXPECT_EQ(texts, (QStringList{QStringLiteral("a"), QStringLiteral("b"), QStringLiteral("c")}));
+    EXPECT_NE(stream.raw().find("keep-alive"), std::string::npos);
+}
+
+TEST(StreamingResponseTest, ParsesJsonLines)
+{
+    QStringList texts;
+    bool done = false;
+    StreamingResponse stream(StreamingResponse::Framing::JsonLines, [&](const QJsonObject& event) {
+        texts << event.value(QStringLiteral("t")).toString();
+        done = event.value(QStringLiteral("done")).toBool();
+    });
+
+    stream.feed("{\"t\":\"x\"}\n{\"t\":");
+    stream.feed("\"y\"}\n\nnot json\n{\"t\":\"z\",\"done\":true}");
+    stream.finish();
+
+    EXPECT_EQ(texts, (QStringList{QStringLiteral("x"), QStringLiteral("y"), QStringLiteral("z")}));
+    EXPECT_TRUE(done);
+}
+
+TEST(StreamingResponseTest, DecodesBase64FieldStraightToFile)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+
+    QByteArray image;
+    for (int i = 0; i < 300000; ++i) {
+        image.append(static_cast<char>(i * 7 % 251));
+    }
+    // A JSON encoder may escape '/' in the value
+    const QByteArray encoded = image.toBase64().replace("/", "\\/");
+    const std::string body = "{\"created\":1,\"data\":[{\"b64_json\" : \"" + encoded.toStdString()
+        + "\",\"revised_prompt\":\"a cat\"}]}";
+
+    const QString path = dir.filePath(QStringLiteral("nested/image.png"));
+    Base64FileDownload download(path);
+    // Odd chunk sizes split the field name, escapes and base64 quartets
+    for (std::size_t offset = 0; offset < body.size(); offset += 4093) {
+        ASSERT_TRUE(download.feed(std::string_view(body).substr(offset, 4093)));
+    }
+    ASSERT_TRUE(download.finish()) << download.errorString().toStdString();
+
+    EXPECT_TRUE(download.foundField());
+    EXPECT_EQ(download.bytesWritten(), image.size());
+    QFile file(path);
+    ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+    EXPECT_EQ(file.readAll(), image);
+
+    // The rest of the body is kept, and still parses, without the image
+    const QJsonObject rest = QJsonDocument::fromJson(QByteArray::fromStdString(download.raw())).object();
+    EXPECT_EQ(rest.value(QStringLiteral("created")).toInt(), 1);
+    EXPECT_LT(download.raw().size(), 100u);
+
+    // An error body leaves no file behind
+    const QString errorPath = dir.filePath(QStringLiteral("error.png"));
+    Base64FileDownload failed(errorPath);
+    failed.feed("{\"error\":{\"message\":\"Billing limit reached\"}}");
+    EXPECT_FALSE(failed.finish());
+    EXPECT_FALSE(failed.foundField());
+    EXPECT_TRUE(failed.errorString().isEmpty());
+    EXPECT_FALSE(QFile::exists(errorPath));
+    EXPECT_NE(failed.raw().find("Billing limit"), std::string::npos);
+}
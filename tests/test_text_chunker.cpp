@@ -1,8 +1,14 @@
 #include <gtest/gtest.h>
+#include "retrieval/chunking/ParallelChunker.h"
+#include "retrieval/chunking/StreamingChunker.h"
 #include "retrieval/chunking/TextChunker.h"
+#include <QElapsedTimer>
 #include <QString>
 #include <QStringList>
 
+#include <algorithm>
+#include <vector>
+
 // Test 1 (Basic): Text shorter than chunkSize returns 1 chunk
 TEST(TextChunkerTest, TextShorterThanChunkSize) {
     QString text = "This is a short text.";
@@ -797,3 +803,217 @@ TEST(TextChunkerTest, MarkdownTableHandling) {
 
     EXPECT_TRUE(sawTable) << "Markdown table should appear in at least one chunk";
 }
+
+// Edge Case: unbreakable runs are cut into overlapping windows without losing characters
+TEST(TextChunkerTest, UnbreakableRunKeepsEveryCharacter) {
+    const QString text = QString(25, QLatin1Char('a')) + QString(12, QLatin1Char('b'));
+    const int chunkSize = 10;
+    const int chunkOverlap = 3;
+
+    QStringList chunks = TextChunker::split(text, chunkSize, chunkOverlap, FileType::CodeCpp);
+
+    ASSERT_GT(chunks.size(), 1);
+    QString rebuilt = chunks[0];
+    for (int i = 1; i < chunks.size(); ++i) {
+        EXPECT_LE(chunks[i].length(), chunkSize);
+        EXPECT_TRUE(chunks[i].startsWith(chunks[i - 1].right(chunkOverlap)));
+        rebuilt += chunks[i].mid(chunkOverlap);
+    }
+    EXPECT_EQ(rebuilt, text);
+}
+
+// BENCHMARK: minified single-line input used to be merged one character at a time
+TEST(TextChunkerTest, MinifiedSingleLineChunksInLinearTime) {
+    QString json;
+    json.reserve(4 * 1024 * 1024);
+    json += QLatin1Char('[');
+    for (int i = 0; json.length() < 4 * 1000 * 1000; ++i) {
+        json += QStringLiteral("{\"id\":%1,\"name\":\"item%1\",\"tags\":[\"x\",\"y\"]},").arg(i);
+    }
+    json += QLatin1Char(']');
+    const int chunkSize = 1000;
+    const int chunkOverlap = 100;
+
+    QElapsedTimer timer;
+    timer.start();
+    const QStringList chunks = TextChunker::split(json, chunkSize, chunkOverlap, FileType::CodeCpp);
+    const qint64 elapsedMs = timer.elapsed();
+
+    ASSERT_GT(chunks.size(), json.length() / chunkSize);
+    for (const QString& chunk : chunks) {
+        ASSERT_LE(chunk.length(), chunkSize);
+    }
+    EXPECT_TRUE(json.startsWith(chunks.first()));
+    EXPECT_TRUE(json.endsWith(chunks.last()));
+    EXPECT_LT(elapsedMs, 5000) << "chunking 4M characters took " << elapsedMs << " ms";
+}
+
+
+// Spans are the chunks as ranges of the source, with the lines they cover
+TEST(TextChunkerTest, SpansMatchChunksAndLineRanges) {
+    // Identical functions: re-finding a chunk by its text would land on the first copy
+    QString code;
+    for (int i = 0; i < 40; ++i) {
+        code += QStringLiteral("// Repeated helper\nint helper() {\n    return 0;\n}\n\n");
+    }
+    const QString markdown = QStringLiteral("# Title\n\nSome text.\n\n## Section\n\n") + code;
+
+    const struct {
+        QString text;
+        FileType type;
+    } samples[] = {{code, FileType::CodeCpp}, {markdown, FileType::CodeMarkdown}, {code, FileType::PlainText}};
+
+    for (const auto& sample : samples) {
+        const QStringList chunks = TextChunker::split(sample.text, 120, 20, sample.type);
+        const QList<TextChunkSpan> spans = TextChunker::splitSpans(sample.text, 120, 20, sample.type);
+        ASSERT_EQ(spans.size(), chunks.size());
+        ASSERT_GT(spans.size(), 10);
+
+        qsizetype previousOffset = -1;
+        for (qsizetype i = 0; i < spans.size(); ++i) {
+            const TextChunkSpan& span = spans[i];
+            EXPECT_EQ(sample.text.mid(span.offset, span.length), chunks[i]);
+            EXPECT_GT(span.offset, previousOffset);
+            previousOffset = span.offset;
+            EXPECT_EQ(span.startLine, sample.text.left(span.offset).count(QLatin1Char('\n')) + 1);
+            EXPECT_EQ(span.endLine, sample.text.left(span.offset + span.length - 1).count(QLatin1Char('\n')) + 1);
+        }
+    }
+}
+
+// Regions cut at Markdown headers chunk exactly as the whole document does
+TEST(TextChunkerTest, ParallelSplitOfMarkdownMatchesSerialAtHeaders) {
+    QString markdown;
+    for (int section = 0; section < 60; ++section) {
+        markdown += QStringLiteral("## Section %1\n\n").arg(section);
+        for (int paragraph = 0; paragraph < 1 + section % 4; ++paragraph) {
+            markdown += QStringLiteral("Paragraph %1 of section %2 says something ").arg(paragraph).arg(section)
+                            .repeated(1 + (section + paragraph) % 5)
+                      + QStringLiteral("\n\n");
+        }
+    }
+
+    const QList<TextChunkSpan> serial = TextChunker::splitSpans(markdown, 300, 50, FileType::CodeMarkdown);
+    const QList<TextChunkSpan> parallel =
+        ParallelChunker::splitSpans(markdown, 300, 50, FileType::CodeMarkdown, nullptr, 2000);
+
+    ASSERT_EQ(parallel.size(), serial.size());
+    for (qsizetype i = 0; i < serial.size(); ++i) {
+        EXPECT_EQ(parallel[i].offset, serial[i].offset) << "chunk " << i;
+        EXPECT_EQ(parallel[i].length, serial[i].length) << "chunk " << i;
+        EXPECT_EQ(parallel[i].startLine, serial[i].startLine) << "chunk " << i;
+        EXPECT_EQ(parallel[i].endLine, serial[i].endLine) << "chunk " << i;
+    }
+}
+
+// Code is cut at blank lines before top-level declarations and stitched back with overlap
+TEST(TextChunkerTest, ParallelSplitOfCodeCoversEveryLineWithOverlap) {
+    QString code;
+    for (int i = 0; i < 300; ++i) {
+        code += QStringLiteral("int function%1(int value)\n{\n    int result = value * %1;\n"
+                               "    result += helper(result);\n    return result;\n}\n\n").arg(i);
+    }
+    code.chop(2); // the chunkers drop a separator that ends the text
+    const int chunkSize = 200;
+    const int chunkOverlap = 40;
+
+    const QList<TextChunkSpan> spans =
+        ParallelChunker::splitSpans(code, chunkSize, chunkOverlap, FileType::CodeCpp, nullptr, 1000);
+    ASSERT_GT(spans.size(), 20);
+
+    std::vector<bool> covered(static_cast<std::size_t>(code.length()), false);
+    qsizetype previousOffset = -1;
+    for (const TextChunkSpan& span : spans) {
+        EXPECT_GT(span.offset, previousOffset);
+        EXPECT_LE(span.length, chunkSize);
+        previousOffset = span.offset;
+        EXPECT_EQ(span.startLine, code.left(span.offset).count(QLatin1Char('\n')) + 1);
+        EXPECT_EQ(span.endLine, code.left(span.offset + span.length - 1).count(QLatin1Char('\n')) + 1);
+        std::fill(covered.begin() + span.offset, covered.begin() + span.offset + span.length, true);
+    }
+    for (qsizetype i = 0; i < code.length(); ++i) {
+        if (!covered[static_cast<std::size_t>(i)]) {
+            ASSERT_TRUE(code[i].isSpace()) << "character " << i << " is in no chunk";
+        }
+    }
+
+    // Consecutive chunks share text across region cuts as well as within regions
+    for (qsizetype i = 1; i < spans.size(); ++i) {
+        EXPECT_LT(spans[i].offset, spans[i - 1].offset + spans[i - 1].length) << "chunk " << i;
+    }
+
+    // Several documents at once give each document's own spans
+    const QList<QList<TextChunkSpan>> many = ParallelChunker::splitSpansMany(
+        {code, QStringLiteral("short text")}, {FileType::CodeCpp, FileType::PlainText}, chunkSize, chunkOverlap,
+        nullptr, 1000);
+    ASSERT_EQ(many.size(), 2);
+    EXPECT_EQ(many[0].size(), spans.size());
+    ASSERT_EQ(many[1].size(), 1);
+    EXPECT_EQ(many[1][0].length, 10);
+}
+
+// Text fed in small windows chunks exactly as the whole text does in regions
+TEST(TextChunkerTest, StreamingChunkerMatchesParallelSplit) {
+    QString code;
+    for (int i = 0; i < 200; ++i) {
+        code += QStringLiteral("def function_%1(value):\n    result = value * %1\n    return result\n\n").arg(i);
+    }
+    QString markdown;
+    for (int section = 0; section < 40; ++section) {
+        markdown += QStringLiteral("# Part %1\n\n").arg(section)
+                  + QStringLiteral("Some words about part %1. ").arg(section).repeated(8) + QStringLiteral("\n\n");
+    }
+
+    const struct {
+        QString text;
+        FileType type;
+    } samples[] = {{code, FileType::CodePython}, {markdown, FileType::CodeMarkdown}};
+
+    for (const auto& sample : samples) {
+        const qsizetype regionLength = 700;
+        const QList<TextChunkSpan> expected =
+            ParallelChunker::splitSpans(sample.text, 150, 30, sample.type, nullptr, regionLength);
+
+        QStringList chunks;
+        QList<TextChunkSpan> spans;
+        StreamingChunker chunker(150, 30, sample.type, [&](const QString& chunk, const TextChunkSpan& span) {
+            chunks.append(chunk);
+            spans.append(span);
+        }, regionLength);
+        for (qsizetype pos = 0; pos < sample.text.length(); pos += 97) {
+            chunker.append(QStringView(sample.text).sliced(pos, qMin<qsizetype>(97, sample.text.length() - pos)));
+        }
+        chunker.finish();
+
+        ASSERT_EQ(spans.size(), expected.size());
+        for (qsizetype i = 0; i < spans.size(); ++i) {
+            EXPECT_EQ(spans[i].offset, expected[i].offset) << "chunk " << i;
+            EXPECT_EQ(spans[i].length, expected[i].length) << "chunk " << i;
+            EXPECT_EQ(spans[i].startLine, expected[i].startLine) << "chunk " << i;
+            EXPECT_EQ(spans[i].endLine, expected[i].endLine) << "chunk " << i;
+            EXPECT_EQ(chunks[i], sample.text.mid(spans[i].offset, spans[i].length)) << "chunk " << i;
+        }
+    }
+}
+
+// Without any boundary the buffer is still cut, so memory stays bounded
+TEST(TextChunkerTest, StreamingChunkerCutsTextWithoutBoundaries) {
+    const QString text = QStringLiteral("word ").repeated(2000);
+    qsizetype covered = 0;
+    int chunks = 0;
+    StreamingChunker chunker(100, 0, FileType::PlainText, [&](const QString& chunk, const TextChunkSpan& span) {
+        EXPECT_EQ(chunk, text.mid(span.offset, span.length));
+        // Chunks follow each other, skipping at most the space between two words
+        EXPECT_GE(span.offset, covered);
+        EXPECT_LE(span.offset, covered + 1);
+        covered = span.offset + span.length;
+        ++chunks;
+    }, 500);
+    for (qsizetype pos = 0; pos < text.length(); pos += 50) {
+        chunker.append(QStringView(text).sliced(pos, 50));
+        // Nothing is held back beyond a few regions
+        EXPECT_GE(covered, pos + 50 - 4 * 500 - 1);
+    }
+    chunker.finish();
+    EXPECT_GT(chunks, 90);
+}
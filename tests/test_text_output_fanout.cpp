@@ -10,6 +10,7 @@
 
 #include <QApplication>
 #include <QEventLoop>
+#include <QTextEdit>
 #include <QTimer>
 
 #include "test_app.h"
@@ -13,6 +13,7 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QTextEdit>
 
 #include "test_app.h"
 #include "NodeGraphModel.h"
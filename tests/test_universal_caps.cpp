@@ -29,6 +29,7 @@
 
 #include "UniversalLLMNode.h"
 #include "ModelCapsRegistry.h"
+#include "ToolNodeDelegate.h"
 
 class TestUniversalCaps : public QObject {
     Q_OBJECT
@@ -38,6 +39,7 @@ private slots:
     void testReasoningConstraint();
     void testExcludeNonChatVariant();
     void testCurrentGoogleFlashModel();
+    void testDelegateDescriptorCacheFollowsPinToggle();
 };
 
 void TestUniversalCaps::initTestCase()
@@ -108,6 +110,37 @@ void TestUniversalCaps::testCurrentGoogleFlashModel()
              QStringLiteral("gemini-3.5-flash"));
 }
 
+void TestUniversalCaps::testDelegateDescriptorCacheFollowsPinToggle()
+{
+    auto node = std::make_shared<UniversalLLMNode>();
+    ToolNodeDelegate delegate(node);
+    const QString attachmentId = QString::fromLatin1(UniversalLLMNode::kInputAttachmentId);
+
+    const auto noVisionCaps = ModelCapsRegistry::instance().resolve(QStringLiteral("o1-preview"));
+    QVERIFY(noVisionCaps.has_value());
+    node->updateCapabilities(*noVisionCaps);
+    QCOMPARE(delegate.portIndexForPinId(QtNodes::PortType::In, attachmentId), -1);
+
+    // Queries between layout changes are served from the cache, not fresh descriptors
+    const quint64 version = delegate.descriptorVersion();
+    const NodeDescriptor* cached = &delegate.descriptor();
+    (void)delegate.nPorts(QtNodes::PortType::In);
+    (void)delegate.dataType(QtNodes::PortType::In, 0);
+    QCOMPARE(&delegate.descriptor(), cached);
+    QCOMPARE(delegate.descriptorVersion(), version);
+
+    const auto visionCaps = ModelCapsRegistry::instance().resolve(QStringLiteral("gpt-4o"));
+    QVERIFY(visionCaps.has_value());
+    node->updateCapabilities(*visionCaps);
+
+    QVERIFY(delegate.descriptorVersion() > version);
+    const int index = delegate.portIndexForPinId(QtNodes::PortType::In, attachmentId);
+    QVERIFY(index >= 0);
+    QCOMPARE(delegate.pinIdForIndex(QtNodes::PortType::In, static_cast<QtNodes::PortIndex>(index)), attachmentId);
+    QCOMPARE(delegate.dataType(QtNodes::PortType::In, static_cast<QtNodes::PortIndex>(index)).name,
+             delegate.descriptor().inputPins.value(attachmentId).name);
+}
+
 TEST(UniversalCapsTests, QtHarness)
 {
     TestUniversalCaps testCase;
@@ -13,11 +13,15 @@
 #include <QTemporaryFile>
 #include <QDir>
 #include <QFile>
+#include <QTemporaryDir>
 
 #include "test_app.h"
 #include "UniversalLLMNode.h"
 #include "ai/registry/LLMProviderRegistry.h"
 #include "ai/backends/ILLMBackend.h"
+#include "ai/backends/LLMResponseCache.h"
+#include "ModelCapsRegistry.h"
+#include "PartialOutputSink.h"
 #include <QtConcurrent>
 
 // Minimal app helper in case QObject machinery needs it
@@ -524,3 +528,336 @@ TEST(UniversalLLMNodeTest, FallbackSaveLoadPersistence) {
     EXPECT_TRUE(node2.getEnableFallback());
     EXPECT_EQ(node2.getFallbackString(), QStringLiteral("CUSTOM_FAIL"));
 }
+
+class MockStreamingBackend : public MockErrorBackend {
+public:
+    QString id() const override { return QStringLiteral("anthropic"); }
+    LLMResult streamPrompt(const QString&, const QString&, double, int, const QString&, const QString&,
+                           const LLMStreamCallback& onDelta, const LLMMessage& = {}) override {
+        for (const QString& delta : {QStringLiteral("Hel"), QStringLiteral("lo "), QStringLiteral("world")}) {
+            onDelta(delta);
+        }
+        LLMResult res;
+        res.content = QStringLiteral("Hello world");
+        return res;
+    }
+};
+
+TEST(UniversalLLMNodeTest, StreamingPublishesTextBeforeReturning) {
+    LLMProviderRegistry::instance().registerBackend(std::make_shared<MockStreamingBackend>());
+    LLMProviderRegistry::instance().setAnthropicKey(QStringLiteral("dummy_key"));
+
+    UniversalLLMNode node;
+    node.onProviderChanged(QStringLiteral("anthropic"));
+    node.onModelChanged(QStringLiteral("model1"));
+    node.setStreamResponse(true);
+
+    TokenList inputs;
+    ExecutionToken token;
+    token.data.insert(QStringLiteral("prompt"), QStringLiteral("Hello"));
+    inputs.push_back(token);
+
+    QStringList published;
+    TokenList outputs;
+    {
+        const PartialOutputSink::Scope sinkScope(PartialOutputSink([&](const TokenList& tokens) {
+            for (const auto& partial : tokens) {
+                EXPECT_FALSE(partial.data.contains(QString::fromLatin1(UniversalLLMNode::kOutputResponseId)));
+                published << partial.data.value(QString::fromLatin1(UniversalLLMNode::kOutputStreamId)).toString();
+            }
+        }));
+        outputs = node.execute(inputs);
+    }
+
+    // Deltas arriving within the publish interval are coalesced into the next update
+    ASSERT_FALSE(published.isEmpty());
+    EXPECT_EQ(published.first(), QStringLiteral("Hel"));
+    ASSERT_EQ(outputs.size(), 1);
+    EXPECT_EQ(outputs.front().data.value(QString::fromLatin1(UniversalLLMNode::kOutputResponseId)).toString(),
+              QStringLiteral("Hello world"));
+    EXPECT_EQ(outputs.front().data.value(QString::fromLatin1(UniversalLLMNode::kOutputStreamId)).toString(),
+              QStringLiteral("Hello world"));
+
+    UniversalLLMNode restored;
+    restored.loadState(node.saveState());
+    EXPECT_TRUE(restored.getStreamResponse());
+
+    LLMProviderRegistry::instance().setAnthropicKey(QString());
+}
+
+class CountingPromptBackend : public MockErrorBackend {
+public:
+    QString id() const override { return QStringLiteral("anthropic"); }
+    LLMResult sendPrompt(const QString&, const QString&, double, int, const QString&, const QString& user,
+                         const LLMMessage& = {}) override {
+        ++calls;
+        LLMResult res;
+        res.content = QStringLiteral("answer %1 to %2").arg(calls).arg(user);
+        res.usage.totalTokens = 7;
+        return res;
+    }
+    int calls = 0;
+};
+
+TEST(UniversalLLMNodeTest, ResponseCacheAnswersRepeatedDeterministicPrompts) {
+    auto backend = std::make_shared<CountingPromptBackend>();
+    LLMProviderRegistry::instance().registerBackend(backend);
+    LLMProviderRegistry::instance().setAnthropicKey(QStringLiteral("dummy_key"));
+    QTemporaryDir cacheDir;
+    ASSERT_TRUE(cacheDir.isValid());
+    LLMResponseCache::setShared(std::make_shared<LLMResponseCache>(cacheDir.path()));
+
+    UniversalLLMNode node;
+    node.onProviderChanged(QStringLiteral("anthropic"));
+    node.onModelChanged(QStringLiteral("model1"));
+    node.onTemperatureChanged(0.0);
+
+    TokenList inputs;
+    ExecutionToken token;
+    token.data.insert(QStringLiteral("prompt"), QStringLiteral("Hello"));
+    inputs.push_back(token);
+
+    const DataPacket first = node.execute(inputs).front().data;
+    EXPECT_FALSE(first.value(QStringLiteral("_cache_hit")).toBool());
+    const DataPacket second = node.execute(inputs).front().data;
+    EXPECT_TRUE(second.value(QStringLiteral("_cache_hit")).toBool());
+    EXPECT_EQ(second.value(QString::fromLatin1(UniversalLLMNode::kOutputResponseId)).toString(),
+              QStringLiteral("answer 1 to Hello"));
+    EXPECT_EQ(second.value(QStringLiteral("_usage.total_tokens")).toInt(), 7);
+    EXPECT_EQ(backend->calls, 1);
+
+    // Per-node bypass and non-zero temperatures always reach the provider
+    node.setBypassResponseCache(true);
+    const DataPacket bypassed = node.execute(inputs).front().data;
+    EXPECT_FALSE(bypassed.contains(QStringLiteral("_cache_hit")));
+    EXPECT_EQ(backend->calls, 2);
+
+    node.setBypassResponseCache(false);
+    node.onTemperatureChanged(0.7);
+    node.execute(inputs);
+    EXPECT_EQ(backend->calls, 3);
+
+    UniversalLLMNode restored;
+    node.setBypassResponseCache(true);
+    restored.loadState(node.saveState());
+    EXPECT_TRUE(restored.getBypassResponseCache());
+
+    LLMResponseCache::setShared(nullptr);
+    LLMProviderRegistry::instance().setAnthropicKey(QString());
+}
+
+class CacheFlagRecordingBackend : public MockErrorBackend {
+public:
+    QString id() const override { return QStringLiteral("anthropic"); }
+    LLMResult sendPrompt(const QString&, const QString&, double, int, const QString&, const QString&,
+                         const LLMMessage& message = {}) override {
+        lastMessage = message;
+        LLMResult res;
+        res.content = QStringLiteral("ok");
+        res.usage.inputTokens = 1200;
+        res.usage.cacheReadTokens = 1100;
+        return res;
+    }
+    LLMMessage lastMessage;
+};
+
+TEST(UniversalLLMNodeTest, PromptCachingMarksSystemPromptAndAttachments) {
+    ASSERT_TRUE(ModelCapsRegistry::instance().loadFromFile(QStringLiteral(":/resources/model_caps.json")));
+    auto backend = std::make_shared<CacheFlagRecordingBackend>();
+    LLMProviderRegistry::instance().registerBackend(backend);
+    LLMProviderRegistry::instance().setAnthropicKey(QStringLiteral("dummy_key"));
+
+    QTemporaryFile image(QDir::tempPath() + QStringLiteral("/cp_cache_XXXXXX.png"));
+    ASSERT_TRUE(image.open());
+    image.write(QByteArray("\x89PNG\r\n\x1a\n", 8));
+    image.close();
+
+    UniversalLLMNode node;
+    node.onProviderChanged(QStringLiteral("anthropic"));
+    node.onModelChanged(QStringLiteral("claude-sonnet-4-5"));
+    node.onSystemPromptChanged(QStringLiteral("You are a long, shared system prompt."));
+
+    TokenList inputs;
+    ExecutionToken token;
+    token.data.insert(QStringLiteral("prompt"), QStringLiteral("Hello"));
+    token.data.insert(QString::fromLatin1(UniversalLLMNode::kInputAttachmentId), image.fileName());
+    inputs.push_back(token);
+
+    const DataPacket output = node.execute(inputs).front().data;
+    EXPECT_TRUE(backend->lastMessage.cacheSystemPrompt);
+    EXPECT_FALSE(backend->lastMessage.cacheAttachments);
+    EXPECT_EQ(output.value(QStringLiteral("_usage.cache_read_tokens")).toInt(), 1100);
+    EXPECT_EQ(output.value(QStringLiteral("_usage.cache_write_tokens")).toInt(), 0);
+
+    node.setCacheAttachments(true);
+    node.execute(inputs);
+    EXPECT_TRUE(backend->lastMessage.cacheAttachments);
+
+    // Models without the capability are sent unmarked
+    node.onModelChanged(QStringLiteral("claude-2.1"));
+    node.execute(inputs);
+    EXPECT_FALSE(backend->lastMessage.cacheSystemPrompt);
+    EXPECT_FALSE(backend->lastMessage.cacheAttachments);
+
+    UniversalLLMNode restored;
+    restored.loadState(node.saveState());
+    EXPECT_TRUE(restored.getCacheAttachments());
+
+    LLMProviderRegistry::instance().setAnthropicKey(QString());
+}
+
+class ConversationRecordingBackend : public MockErrorBackend {
+public:
+    QString id() const override { return QStringLiteral("anthropic"); }
+    bool supportsStoredConversations() const override { return stored; }
+    LLMResult sendPrompt(const QString&, const QString&, double, int, const QString&, const QString& userPrompt,
+                         const LLMMessage& message = {}) override {
+        messages.append(message);
+        LLMResult res;
+        res.content = QStringLiteral("answer to %1").arg(userPrompt);
+        if (message.storeResponse) {
+            res.responseId = QStringLiteral("resp_%1").arg(messages.size());
+        }
+        return res;
+    }
+    bool stored = false;
+    QList<LLMMessage> messages;
+};
+
+TEST(UniversalLLMNodeTest, ContinuedConversationsResendOrReferenceEarlierTurns) {
+    ASSERT_TRUE(ModelCapsRegistry::instance().loadFromFile(QStringLiteral(":/resources/model_caps.json")));
+    auto backend = std::make_shared<ConversationRecordingBackend>();
+    LLMProviderRegistry::instance().registerBackend(backend);
+    LLMProviderRegistry::instance().setAnthropicKey(QStringLiteral("dummy_key"));
+
+    UniversalLLMNode node;
+    node.onProviderChanged(QStringLiteral("anthropic"));
+    node.onModelChanged(QStringLiteral("claude-sonnet-4-5"));
+    node.onTemperatureChanged(0.0);
+    const QString conversationPin = QString::fromLatin1(UniversalLLMNode::kInputConversationId);
+    EXPECT_FALSE(node.getDescriptor().inputPins.contains(conversationPin));
+    node.setContinueConversation(true);
+    EXPECT_TRUE(node.getDescriptor().inputPins.contains(conversationPin));
+
+    const auto ask = [&](const QString& prompt, const QString& conversation) {
+        ExecutionToken token;
+        token.data.insert(QStringLiteral("prompt"), prompt);
+        token.data.insert(conversationPin, conversation);
+        return node.execute(TokenList{token}).front().data;
+    };
+
+    ask(QStringLiteral("first"), QStringLiteral("loop-1"));
+    const DataPacket second = ask(QStringLiteral("second"), QStringLiteral("loop-1"));
+    ASSERT_EQ(backend->messages.size(), 2);
+    EXPECT_TRUE(backend->messages.at(0).history.isEmpty());
+    ASSERT_EQ(backend->messages.at(1).history.size(), 1);
+    EXPECT_EQ(backend->messages.at(1).history.first().prompt, QStringLiteral("first"));
+    EXPECT_EQ(backend->messages.at(1).history.first().response, QStringLiteral("answer to first"));
+    EXPECT_FALSE(backend->messages.at(1).storeResponse);
+    EXPECT_EQ(second.value(QStringLiteral("_conversation_turn")).toInt(), 2);
+
+    // Another loop run starts its own conversation, and the identical prompt isn't coalesced or cached
+    ask(QStringLiteral("second"), QStringLiteral("loop-2"));
+    ASSERT_EQ(backend->messages.size(), 3);
+    EXPECT_TRUE(backend->messages.at(2).history.isEmpty());
+
+    // Providers that keep conversations get the previous response id instead
+    backend->stored = true;
+    ask(QStringLiteral("one"), QStringLiteral("loop-3"));
+    ask(QStringLiteral("two"), QStringLiteral("loop-3"));
+    ASSERT_EQ(backend->messages.size(), 5);
+    EXPECT_TRUE(backend->messages.at(3).storeResponse);
+    EXPECT_TRUE(backend->messages.at(3).previousResponseId.isEmpty());
+    EXPECT_EQ(backend->messages.at(4).previousResponseId, QStringLiteral("resp_4"));
+
+    UniversalLLMNode restored;
+    restored.loadState(node.saveState());
+    EXPECT_TRUE(restored.getContinueConversation());
+    EXPECT_TRUE(restored.getDescriptor().inputPins.contains(conversationPin));
+
+    LLMProviderRegistry::instance().setAnthropicKey(QString());
+}
+
+class CascadeModelBackend : public MockErrorBackend {
+public:
+    QString id() const override { return QStringLiteral("anthropic"); }
+    LLMResult sendPrompt(const QString&, const QString& model, double, int, const QString&, const QString& user,
+                         const LLMMessage& = {}) override {
+        models.append(model);
+        LLMResult res;
+        // The fast model only manages the easy prompts
+        if (model == QLatin1String("fast") && !user.contains(QLatin1String("easy"))) {
+            res.content = QStringLiteral("It is probably spam.");
+        } else {
+            res.content = QStringLiteral("```json\n{\"label\": \"%1\"}\n```").arg(model);
+        }
+        res.usage.totalTokens = model == QLatin1String("fast") ? 3 : 30;
+        return res;
+    }
+    QStringList models;
+};
+
+TEST(UniversalLLMNodeTest, CascadeEscalatesOnlyWhenTheFirstTierFailsItsCheck) {
+    auto backend = std::make_shared<CascadeModelBackend>();
+    LLMProviderRegistry::instance().registerBackend(backend);
+    LLMProviderRegistry::instance().setAnthropicKey(QStringLiteral("dummy_key"));
+
+    UniversalLLMNode node;
+    node.onProviderChanged(QStringLiteral("anthropic"));
+    node.onModelChanged(QStringLiteral("model1"));
+    node.setCascadeEnabled(true);
+    node.setCascadeModel(QStringLiteral("fast"));
+    node.setCascadeCheck(QString::fromLatin1(CascadeCheck::kJson));
+
+    const auto ask = [&](const QString& prompt) {
+        ExecutionToken token;
+        token.data.insert(QStringLiteral("prompt"), prompt);
+        return node.execute(TokenList{token}).front().data;
+    };
+
+    const DataPacket easy = ask(QStringLiteral("an easy one"));
+    EXPECT_EQ(backend->models, QStringList{QStringLiteral("fast")});
+    EXPECT_EQ(easy.value(QStringLiteral("_cascade_tier")).toInt(), 1);
+    EXPECT_EQ(easy.value(QStringLiteral("_model")).toString(), QStringLiteral("fast"));
+    ASSERT_EQ(easy.value(QStringLiteral("_cascade_tiers")).toList().size(), 1);
+
+    const DataPacket hard = ask(QStringLiteral("a hard one"));
+    EXPECT_EQ(backend->models, (QStringList{QStringLiteral("fast"), QStringLiteral("fast"), QStringLiteral("model1")}));
+    EXPECT_EQ(hard.value(QStringLiteral("_cascade_tier")).toInt(), 2);
+    EXPECT_EQ(hard.value(QStringLiteral("_model")).toString(), QStringLiteral("model1"));
+    EXPECT_TRUE(hard.value(QStringLiteral("_cascade_escalation")).toString().startsWith(QStringLiteral("not JSON")));
+    const QVariantList tiers = hard.value(QStringLiteral("_cascade_tiers")).toList();
+    ASSERT_EQ(tiers.size(), 2);
+    EXPECT_EQ(tiers.at(0).toMap().value(QStringLiteral("_model")).toString(), QStringLiteral("fast"));
+    EXPECT_FALSE(tiers.at(0).toMap().value(QStringLiteral("passed")).toBool());
+    EXPECT_EQ(tiers.at(0).toMap().value(QStringLiteral("_usage.total_tokens")).toInt(), 3);
+    EXPECT_EQ(tiers.at(1).toMap().value(QStringLiteral("_usage.total_tokens")).toInt(), 30);
+    EXPECT_TRUE(tiers.at(1).toMap().contains(QStringLiteral("latency_us")));
+
+    // A schema rejects the fast model's label even though it is valid JSON
+    node.setCascadeCheck(QString::fromLatin1(CascadeCheck::kJsonSchema));
+    node.setCascadeCheckSpec(QStringLiteral(R"({"type": "object", "required": ["label"],
+        "properties": {"label": {"enum": ["spam", "model1"]}}})"));
+    EXPECT_EQ(ask(QStringLiteral("an easy one")).value(QStringLiteral("_cascade_tier")).toInt(), 2);
+    node.setCascadeCheck(QString::fromLatin1(CascadeCheck::kRegex));
+    node.setCascadeCheckSpec(QStringLiteral("\"label\":\\s*\"fast\""));
+    EXPECT_EQ(ask(QStringLiteral("an easy one")).value(QStringLiteral("_cascade_tier")).toInt(), 1);
+
+    QString reason;
+    EXPECT_TRUE(CascadeCheck::passes(QString::fromLatin1(CascadeCheck::kJsonSchema),
+                                     QStringLiteral(R"({"type": "array", "items": {"type": "integer"}, "maxItems": 3})"),
+                                     QStringLiteral("[1, 2, 3]")));
+    EXPECT_FALSE(CascadeCheck::passes(QString::fromLatin1(CascadeCheck::kJsonSchema),
+                                      QStringLiteral(R"({"type": "array", "items": {"type": "integer"}})"),
+                                      QStringLiteral("[1, 2.5]"), &reason));
+    EXPECT_EQ(reason, QStringLiteral("$[1] is number, not integer"));
+
+    UniversalLLMNode restored;
+    restored.loadState(node.saveState());
+    EXPECT_TRUE(restored.getCascadeEnabled());
+    EXPECT_EQ(restored.getCascadeModel(), QStringLiteral("fast"));
+    EXPECT_EQ(restored.getCascadeCheck(), QString::fromLatin1(CascadeCheck::kRegex));
+    EXPECT_EQ(restored.getCascadeCheckSpec(), node.getCascadeCheckSpec());
+
+    LLMProviderRegistry::instance().setAnthropicKey(QString());
+}
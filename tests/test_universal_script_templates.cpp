@@ -7,6 +7,7 @@
 #include <QCoreApplication>
 #include <QElapsedTimer>
 #include <QEventLoop>
+#include <QPlainTextEdit>
 #include <QThread>
 #include <QTextBlock>
 #include <QTextDocument>
@@ -69,6 +70,34 @@ TEST(UniversalScriptTemplatesTest, ProvidesHighlighterCommandRows)
     EXPECT_TRUE(commands.contains(QStringLiteral(".rexx")));
 }
 
+#if defined(CP_HAS_DSLSH) && CP_HAS_DSLSH
+TEST(UniversalScriptTemplatesTest, LargeScriptsHighlightTheViewportFirst)
+{
+    QStringList lines;
+    for (int i = 0; i < 5000; ++i) {
+        lines << QStringLiteral("const value%1 = %1; // line %1").arg(i);
+    }
+    QPlainTextEdit editor;
+    editor.resize(400, 300);
+    editor.setPlainText(lines.join(QLatin1Char('\n')));
+
+    ScriptSyntaxHighlighter highlighter(editor.document());
+    highlighter.setEditor(&editor);
+    highlighter.setEngineId(QStringLiteral("quickjs"));
+    highlighter.setExternalCommandOverrideForTesting(QString());
+
+    auto painted = [&](int blockNumber) {
+        const QTextBlock block = editor.document()->findBlockByNumber(blockNumber);
+        return block.isValid() && block.layout() && !block.layout()->formats().isEmpty();
+    };
+
+    // The blocks on screen are done at once, the rest once the event loop runs
+    EXPECT_TRUE(painted(0));
+    EXPECT_FALSE(painted(4999));
+    EXPECT_TRUE(waitUntil([&]() { return painted(4999); }, 10000));
+}
+#endif
+
 #if defined(CP_HAS_DSLSH) && CP_HAS_DSLSH && defined(CP_HAS_CREXX) && CP_HAS_CREXX
 TEST(UniversalScriptTemplatesTest, ConfiguredCrexxHighlighterSmoke)
 {
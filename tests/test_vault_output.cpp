@@ -15,6 +15,7 @@
 #include "NodeGraphModel.h"
 #include "ToolNodeDelegate.h"
 #include "VaultOutputNode.h"
+#include "VaultWriter.h"
 #include "ai/backends/ILLMBackend.h"
 #include "ai/registry/LLMProviderRegistry.h"
 
@@ -157,6 +158,7 @@ TEST(VaultOutputNodeTest, WritesMarkdownToModelSelectedLocation)
 
     const TokenList outTokens = node.execute(tokens);
     ASSERT_FALSE(outTokens.empty());
+    VaultWriter::shared().flush();
 
     const DataPacket& output = outTokens.front().data;
     ASSERT_FALSE(output.contains(QStringLiteral("__error")))
@@ -177,3 +179,47 @@ TEST(VaultOutputNodeTest, WritesMarkdownToModelSelectedLocation)
     EXPECT_EQ(decision.value(QStringLiteral("provider")).toString(), QStringLiteral("mockvault"));
     EXPECT_EQ(decision.value(QStringLiteral("model")).toString(), QStringLiteral("router-1"));
 }
+
+TEST(VaultOutputNodeTest, WriterAllocatesCollidingNamesWithoutOverwriting)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+    const QString folder = tempDir.path();
+    ASSERT_TRUE(writeTextFile(QDir(folder).filePath(QStringLiteral("note.md")), QStringLiteral("existing")));
+
+    VaultWriter writer;
+    QStringList paths;
+    QList<QFuture<QString>> saved;
+    for (int i = 0; i < 50; ++i) {
+        const QString path = writer.reservePath(folder, QStringLiteral("note"));
+        paths << path;
+        saved << writer.write(path, QByteArray::number(i));
+    }
+    writer.flush();
+    EXPECT_EQ(writer.pendingWrites(), 0);
+
+    EXPECT_EQ(QFileInfo(paths.first()).fileName(), QStringLiteral("note-2.md"));
+    EXPECT_EQ(QFileInfo(paths.last()).fileName(), QStringLiteral("note-51.md"));
+    for (int i = 0; i < paths.size(); ++i) {
+        EXPECT_EQ(saved.at(i).result(), paths.at(i));
+        QFile file(paths.at(i));
+        ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+        EXPECT_EQ(file.readAll(), QByteArray::number(i));
+    }
+
+    QFile existing(QDir(folder).filePath(QStringLiteral("note.md")));
+    ASSERT_TRUE(existing.open(QIODevice::ReadOnly));
+    EXPECT_EQ(existing.readAll(), QByteArray("existing"));
+
+    // Taken by someone else after the reservation: saved under the next free name instead
+    const QString reserved = writer.reservePath(folder, QStringLiteral("late"));
+    ASSERT_TRUE(writeTextFile(reserved, QStringLiteral("external")));
+    const QString savedPath = writer.write(reserved, QByteArrayLiteral("ours")).result();
+    EXPECT_EQ(QFileInfo(savedPath).fileName(), QStringLiteral("late-2.md"));
+    QFile external(reserved);
+    ASSERT_TRUE(external.open(QIODevice::ReadOnly));
+    EXPECT_EQ(external.readAll(), QByteArray("external"));
+
+    const QStringList leftovers = QDir(folder).entryList({QStringLiteral("*.tmp")}, QDir::Files | QDir::Hidden);
+    EXPECT_TRUE(leftovers.isEmpty());
+}
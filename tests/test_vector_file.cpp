@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+
+#include <QByteArray>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "retrieval/storage/GpuVectorScorer.h"
+#include "retrieval/storage/VectorFile.h"
+#include "retrieval/storage/VectorKernels.h"
+
+namespace {
+
+QByteArray rowFor(qint64 id, int bytes)
+{
+    QByteArray row(bytes, '\0');
+    for (int i = 0; i < bytes; ++i) {
+        row[i] = static_cast<char>((id * 31 + i) & 0x7f);
+    }
+    return row;
+}
+
+} // namespace
+
+TEST(VectorFileTest, AppendsAlignedRowsAndTombstonesGaps)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("index.vec"));
+
+    QString error;
+    std::unique_ptr<VectorFile> writer = VectorFile::create(path, 1, 12, 24, &error);
+    ASSERT_TRUE(writer) << error.toStdString();
+    EXPECT_EQ(writer->stride(), VectorFile::kRowAlignment);
+    for (const qint64 id : {1, 2, 5, 1500}) {
+        ASSERT_TRUE(writer->append(id, rowFor(id, 24), &error)) << error.toStdString();
+    }
+    EXPECT_FALSE(writer->append(3, rowFor(3, 24)));
+    EXPECT_FALSE(writer->append(1501, rowFor(1501, 23)));
+    ASSERT_TRUE(writer->commit(&error)) << error.toStdString();
+    writer.reset();
+
+    std::unique_ptr<VectorFile> reader = VectorFile::open(path, &error);
+    ASSERT_TRUE(reader) << error.toStdString();
+    EXPECT_EQ(reader->format(), 1);
+    EXPECT_EQ(reader->dimension(), 12);
+    EXPECT_EQ(reader->maxId(), 1500);
+    EXPECT_EQ(reader->liveCount(), 4);
+    for (const qint64 id : {1, 2, 5, 1500}) {
+        const char* row = reader->row(id);
+        ASSERT_NE(row, nullptr) << id;
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(row) % VectorFile::kRowAlignment, 0u);
+        EXPECT_EQ(QByteArray(row, 24), rowFor(id, 24));
+    }
+    for (const qint64 id : {0, 3, 4, 1499, 1501}) {
+        EXPECT_TRUE(reader->isDeleted(id)) << id;
+        EXPECT_EQ(reader->row(id), nullptr) << id;
+    }
+}
+
+TEST(VectorFileTest, UpdatesKeepReadersValidAndInterruptedOnesAreRejected)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("index.vec"));
+
+    std::unique_ptr<VectorFile> writer = VectorFile::create(path, 0, 4, 16);
+    ASSERT_TRUE(writer);
+    ASSERT_TRUE(writer->append(1, rowFor(1, 16)));
+    ASSERT_TRUE(writer->append(2, rowFor(2, 16)));
+    ASSERT_TRUE(writer->commit());
+    writer.reset();
+
+    std::unique_ptr<VectorFile> reader = VectorFile::open(path);
+    ASSERT_TRUE(reader);
+
+    // Growing past the first capacity moves the bitmap, never the rows
+    std::unique_ptr<VectorFile> updater = VectorFile::openForUpdate(path);
+    ASSERT_TRUE(updater);
+    updater->markDeleted(1);
+    ASSERT_TRUE(updater->append(5000, rowFor(5000, 16)));
+    EXPECT_EQ(updater->liveCount(), 2);
+
+    // Mid-update the file reads as dirty
+    QString error;
+    EXPECT_FALSE(VectorFile::open(path, &error));
+    EXPECT_FALSE(error.isEmpty());
+    ASSERT_TRUE(updater->commit());
+    updater.reset();
+
+    EXPECT_EQ(QByteArray(reader->row(1), 16), rowFor(1, 16));
+    EXPECT_EQ(reader->maxId(), 2);
+
+    std::unique_ptr<VectorFile> updated = VectorFile::open(path);
+    ASSERT_TRUE(updated);
+    EXPECT_TRUE(updated->isDeleted(1));
+    EXPECT_EQ(QByteArray(updated->row(2), 16), rowFor(2, 16));
+    EXPECT_EQ(QByteArray(updated->row(5000), 16), rowFor(5000, 16));
+    EXPECT_EQ(updated->maxId(), 5000);
+
+    // Garbage is not a vector file
+    QFile junk(dir.filePath(QStringLiteral("junk.vec")));
+    ASSERT_TRUE(junk.open(QIODevice::WriteOnly));
+    junk.write(QByteArray(256, 'x'));
+    junk.close();
+    EXPECT_FALSE(VectorFile::open(junk.fileName()));
+}
+
+TEST(GpuVectorScorerTest, RanksLiveRowsLikeAnExactScan)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("index.vec"));
+    constexpr int kDimension = 24;
+    constexpr qint64 kRows = 5000;
+
+    // Float32 rows, every seventh id left as a gap
+    std::unique_ptr<VectorFile> writer = VectorFile::create(path, 0, kDimension, kDimension * 4);
+    ASSERT_TRUE(writer);
+    for (qint64 id = 1; id <= kRows; ++id) {
+        if (id % 7 == 0) {
+            continue;
+        }
+        std::vector<float> row(kDimension);
+        for (int d = 0; d < kDimension; ++d) {
+            row[static_cast<size_t>(d)] = static_cast<float>(std::sin(static_cast<double>(id * 13 + d * 7)));
+        }
+        VectorKernels::normalize(row);
+        ASSERT_TRUE(writer->append(id, QByteArray(reinterpret_cast<const char*>(row.data()), kDimension * 4)));
+    }
+    ASSERT_TRUE(writer->commit());
+    writer.reset();
+    std::unique_ptr<VectorFile> vectors = VectorFile::open(path);
+    ASSERT_TRUE(vectors);
+
+    QString error;
+    std::unique_ptr<GpuVectorScorer> scorer = GpuVectorScorer::create(*vectors, &error);
+    if (!GpuVectorScorer::isAvailable()) {
+        EXPECT_FALSE(scorer);
+        EXPECT_FALSE(error.isEmpty());
+        GTEST_SKIP() << "No GPU scoring device";
+    }
+    ASSERT_TRUE(scorer) << error.toStdString();
+    EXPECT_EQ(scorer->maxId(), kRows);
+
+    std::vector<float> query(kDimension);
+    for (int d = 0; d < kDimension; ++d) {
+        query[static_cast<size_t>(d)] = static_cast<float>(std::cos(d * 0.5));
+    }
+    VectorKernels::normalize(query);
+
+    std::vector<qint64> expected;
+    for (qint64 id = 1; id <= kRows; ++id) {
+        if (vectors->row(id)) {
+            expected.push_back(id);
+        }
+    }
+    const auto score = [&](qint64 id) { return VectorKernels::dot(query.data(), vectors->row(id), kDimension); };
+    std::stable_sort(expected.begin(), expected.end(), [&](qint64 a, qint64 b) { return score(a) > score(b); });
+    expected.resize(20);
+
+    std::vector<std::vector<GpuVectorScorer::Hit>> hits;
+    ASSERT_TRUE(scorer->search({query}, 20, hits, &error)) << error.toStdString();
+    ASSERT_EQ(hits.size(), 1u);
+    ASSERT_EQ(hits.front().size(), 20u);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(hits.front()[i].id, expected[i]) << i;
+        EXPECT_NEAR(hits.front()[i].score, score(expected[i]), 1e-4);
+    }
+}
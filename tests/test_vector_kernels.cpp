@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "retrieval/storage/VectorKernels.h"
+
+TEST(VectorKernelsTest, DotMatchesReferenceForAnyLengthAndAlignment)
+{
+    const std::string kernel = VectorKernels::activeKernel();
+    EXPECT_TRUE(kernel == "avx512" || kernel == "avx2" || kernel == "neon" || kernel == "scalar") << kernel;
+
+    for (std::size_t count = 0; count <= 70; ++count) {
+        std::vector<float> a(count);
+        std::vector<float> b(count);
+        double expected = 0.0;
+        for (std::size_t i = 0; i < count; ++i) {
+            a[i] = std::sin(static_cast<float>(i) * 0.37f);
+            b[i] = std::cos(static_cast<float>(i) * 0.91f);
+            expected += static_cast<double>(a[i]) * b[i];
+        }
+
+        // Stored BLOBs carry no alignment guarantee
+        for (std::size_t offset = 0; offset < sizeof(float); ++offset) {
+            std::vector<char> bytes(count * sizeof(float) + sizeof(float));
+            if (count > 0) {
+                std::memcpy(bytes.data() + offset, b.data(), count * sizeof(float));
+            }
+            EXPECT_NEAR(VectorKernels::dot(a.data(), bytes.data() + offset, count), expected, 1e-4)
+                << "count " << count << " offset " << offset;
+        }
+    }
+}
+
+TEST(VectorKernelsTest, NormalizeScalesToUnitLength)
+{
+    std::vector<float> vector {3.0f, 0.0f, 4.0f};
+    VectorKernels::normalize(vector);
+    EXPECT_FLOAT_EQ(vector[0], 0.6f);
+    EXPECT_FLOAT_EQ(vector[2], 0.8f);
+    EXPECT_NEAR(VectorKernels::dot(vector.data(), vector.data(), vector.size()), 1.0, 1e-6);
+
+    std::vector<float> zero(4, 0.0f);
+    VectorKernels::normalize(zero);
+    EXPECT_EQ(zero, std::vector<float>(4, 0.0f));
+}
+
+TEST(VectorKernelsTest, QuantisedDotsMatchTheirDecodedValues)
+{
+    for (std::size_t count : {std::size_t {0}, std::size_t {7}, std::size_t {16}, std::size_t {37}, std::size_t {1536}}) {
+        std::vector<float> a(count);
+        std::vector<char> halves(count * 2 + 1);
+        std::vector<char> codes(count + 1);
+        double expectedHalf = 0.0;
+        double expectedInt8 = 0.0;
+        for (std::size_t i = 0; i < count; ++i) {
+            a[i] = std::sin(static_cast<float>(i) * 0.37f);
+            const float value = std::cos(static_cast<float>(i) * 0.91f);
+            const std::uint16_t half = VectorKernels::floatToHalf(value);
+            std::memcpy(halves.data() + 1 + i * 2, &half, sizeof(half)); // deliberately misaligned
+            expectedHalf += static_cast<double>(a[i]) * VectorKernels::halfToFloat(half);
+            const auto code = static_cast<std::int8_t>(std::lround(value * 127.0f));
+            codes[1 + i] = static_cast<char>(code);
+            expectedInt8 += static_cast<double>(a[i]) * code;
+        }
+        EXPECT_NEAR(VectorKernels::dotHalf(a.data(), halves.data() + 1, count), expectedHalf, 1e-3) << count;
+        EXPECT_NEAR(VectorKernels::dotInt8(a.data(), codes.data() + 1, count), expectedInt8, 1e-1) << count;
+    }
+}
+
+TEST(VectorKernelsTest, HalfConversionRoundsToNearest)
+{
+    EXPECT_EQ(VectorKernels::floatToHalf(1.0f), 0x3c00);
+    EXPECT_EQ(VectorKernels::floatToHalf(-2.0f), 0xc000);
+    EXPECT_EQ(VectorKernels::floatToHalf(65504.0f), 0x7bff);
+    EXPECT_EQ(VectorKernels::floatToHalf(1e6f), 0x7c00);          // overflow saturates to infinity
+    EXPECT_EQ(VectorKernels::floatToHalf(1.0f + 1.0f / 4096.0f), 0x3c00); // ties round to even
+    EXPECT_FLOAT_EQ(VectorKernels::halfToFloat(0x3555), 0.33325195f);
+    EXPECT_FLOAT_EQ(VectorKernels::halfToFloat(0x0001), 5.9604645e-8f); // smallest subnormal
+    EXPECT_EQ(VectorKernels::floatToHalf(VectorKernels::halfToFloat(0x0001)), 0x0001);
+}